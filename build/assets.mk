@@ -0,0 +1,23 @@
+# Packs the files in ASSETS_DIR into a read-only asset image and links it into the module.
+# The assets can be accessed via particle::AssetImage (see services/inc/asset_image.h).
+
+ifneq (,$(ASSETS_DIR))
+ASSETS_IMAGE = $(BUILD_PATH)/assets/asset_image.bin
+ASSETS_OBJ = $(BUILD_PATH)/assets/asset_image.o
+ASSETS_FILES = $(call rwildcard,$(ASSETS_DIR)/,*)
+
+ALLOBJ += $(ASSETS_OBJ)
+
+$(ASSETS_IMAGE): $(ASSETS_FILES) $(PACK_ASSETS)
+	$(call echo,'Packing assets: $(ASSETS_DIR)')
+	$(VERBOSE)$(MKDIR) $(dir $@)
+	$(VERBOSE)$(PACK_ASSETS) -o $@ $(ASSETS_DIR)
+	$(call echo,)
+
+# The image is placed in its own section so that it's kept in flash along with the rest of .rodata
+$(ASSETS_OBJ): $(ASSETS_IMAGE)
+	$(call echo,'Building asset image: $@')
+	$(VERBOSE)printf '.section .rodata.particle_asset_image,"a"\n.balign 8\n.global particle_asset_image\n.type particle_asset_image, %%object\nparticle_asset_image:\n.incbin "%s"\n.size particle_asset_image, . - particle_asset_image\n.section .note.GNU-stack,"",%%progbits\n' '$(abspath $<)' | \
+		$(CCACHE) $(CC) $(ASFLAGS) -c -o $@ -
+	$(call echo,)
+endif
@@ -20,6 +20,7 @@ CURL = curl
 CRC = crc32
 XXD = xxd
 SERIAL_SWITCHER = $(COMMON_BUILD)/serial_switcher.py
+PACK_ASSETS = $(COMMON_BUILD)/pack_assets.py
 
 crc32_path := $(shell which $(CRC))
 ifeq ("$(crc32_path)", "")
@@ -0,0 +1,265 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License as published by the Free Software Foundation, either
+# version 3 of the License, or (at your option) any later version.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, see <http://www.gnu.org/licenses/>.
+#
+
+"""
+Decodes log output of firmware built with LOG_DEFERRED_FORMAT=1 (see services/inc/logging.h).
+
+The format strings are read from the .log_fmt section of the ELF files of the firmware modules.
+Text output is passed through as is.
+
+Examples:
+    decode_log.py -p /dev/ttyACM0 system-part1.elf user-part.elf
+    decode_log.py -i log.bin tinker.elf
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+FRAME_START = 0x00
+
+ARG_INT32 = 1
+ARG_INT64 = 2
+ARG_DOUBLE = 3
+ARG_POINTER = 4
+ARG_STRING = 5
+
+LEVEL_NAMES = [
+    (60, 'PANIC'),
+    (50, 'ERROR'),
+    (40, 'WARN'),
+    (30, 'INFO'),
+    (1, 'TRACE')
+]
+
+FORMAT_SPEC = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|j|z|t|L)?([diouxXeEfFgGaAcspn%])')
+
+class ElfFile:
+    """Minimal ELF reader."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF':
+            raise ValueError('%s is not an ELF file' % path)
+        self.is64 = self.data[4] == 2
+        if self.data[5] != 1:
+            raise ValueError('%s is not a little-endian ELF file' % path)
+        if self.is64:
+            shoff, = struct.unpack_from('<Q', self.data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from('<HHH', self.data, 0x3a)
+        else:
+            shoff, = struct.unpack_from('<I', self.data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from('<HHH', self.data, 0x2e)
+        self.sections = []
+        for i in range(shnum):
+            offs = shoff + i * shentsize
+            if self.is64:
+                name, _, _, _, sh_offset, sh_size = struct.unpack_from('<IIQQQQ', self.data, offs)
+            else:
+                name, _, _, _, sh_offset, sh_size = struct.unpack_from('<IIIIII', self.data, offs)
+            self.sections.append((name, sh_offset, sh_size))
+        _, strtab_offs, strtab_size = self.sections[shstrndx]
+        strtab = self.data[strtab_offs:strtab_offs + strtab_size]
+        self.sections = {self._str(strtab, name): (offs, size) for name, offs, size in self.sections}
+
+    def section(self, name):
+        if name not in self.sections:
+            return None
+        offs, size = self.sections[name]
+        return self.data[offs:offs + size]
+
+    @staticmethod
+    def _str(strtab, offs):
+        return strtab[offs:strtab.index(b'\0', offs)].decode('ascii')
+
+class Module:
+    def __init__(self, path):
+        elf = ElfFile(path)
+        self.path = path
+        self.formats = elf.section('.log_fmt')
+        if self.formats is None:
+            raise ValueError('%s has no .log_fmt section' % path)
+        # See module_info_t in dynalib/inc/module_info.h
+        info = elf.section('.module_info')
+        self.id = ((info[14] << 4) | info[15]) if info and len(info) >= 16 else None
+
+    def format_string(self, offs):
+        if offs >= len(self.formats):
+            return None
+        end = self.formats.find(b'\0', offs)
+        return self.formats[offs:end if end >= 0 else len(self.formats)].decode('utf-8', 'replace')
+
+class Decoder:
+    def __init__(self, modules, out):
+        self.modules = modules
+        self.out = out
+
+    def decode(self, stream):
+        while True:
+            b = stream.read(1)
+            if not b:
+                break
+            if b[0] != FRAME_START:
+                self.out.write(b.decode('utf-8', 'replace'))
+                self.out.flush()
+                continue
+            size = stream.read(1)
+            if not size:
+                break
+            frame = stream.read(size[0])
+            if len(frame) < size[0]:
+                break
+            try:
+                self.out.write(self.decode_frame(frame) + '\r\n')
+            except Exception as e:
+                self.out.write('<invalid frame: %s>\r\n' % e)
+            self.out.flush()
+
+    def decode_frame(self, frame):
+        level, time, fmt_id, cat_len = struct.unpack_from('<BIIB', frame, 0)
+        offs = 10
+        category = frame[offs:offs + cat_len].decode('utf-8', 'replace')
+        offs += cat_len
+        args = self.decode_args(frame[offs:])
+        fmt = self.format_string(fmt_id)
+        if fmt is None:
+            msg = '<unknown format 0x%08x> %s' % (fmt_id, ' '.join(repr(a[1]) for a in args))
+        else:
+            msg = self.format(fmt, args)
+        s = '%010u ' % time
+        if category:
+            s += '[%s] ' % category
+        return s + '%s: %s' % (level_name(level), msg)
+
+    def format_string(self, fmt_id):
+        module_id = fmt_id >> 24
+        offs = fmt_id & 0x00ffffff
+        candidates = [m for m in self.modules if m.id == module_id]
+        if not candidates and len(self.modules) == 1:
+            candidates = self.modules
+        for m in candidates:
+            fmt = m.format_string(offs)
+            if fmt is not None:
+                return fmt
+        return None
+
+    @staticmethod
+    def decode_args(data):
+        args = []
+        try:
+            Decoder._decode_args(data, args)
+        except (struct.error, IndexError):
+            pass # Truncated argument
+        return args
+
+    @staticmethod
+    def _decode_args(data, args):
+        offs = 0
+        while offs < len(data):
+            tag = data[offs]
+            offs += 1
+            if tag == ARG_INT32:
+                args.append((tag, struct.unpack_from('<i', data, offs)[0]))
+                offs += 4
+            elif tag == ARG_INT64:
+                args.append((tag, struct.unpack_from('<q', data, offs)[0]))
+                offs += 8
+            elif tag == ARG_DOUBLE:
+                args.append((tag, struct.unpack_from('<d', data, offs)[0]))
+                offs += 8
+            elif tag == ARG_POINTER:
+                # Pointers are 32-bit on all supported devices
+                args.append((tag, struct.unpack_from('<I', data, offs)[0]))
+                offs += 4
+            elif tag == ARG_STRING:
+                n = data[offs]
+                offs += 1
+                args.append((tag, data[offs:offs + n].decode('utf-8', 'replace')))
+                offs += n
+            else:
+                break # Unknown tag
+
+    @staticmethod
+    def format(fmt, args):
+        args = list(args)
+        def next_arg():
+            return args.pop(0) if args else (None, None)
+        def replace(m):
+            flags, width, prec, length, conv = m.groups()
+            if conv == '%':
+                return '%'
+            if width == '*':
+                width = str(next_arg()[1])
+            if prec == '*':
+                prec = str(next_arg()[1])
+            tag, val = next_arg()
+            if val is None:
+                return '<?>'
+            spec = '%' + flags + (width or '') + ('.' + prec if prec is not None else '')
+            if conv == 'p':
+                return '0x%x' % val
+            if conv == 's':
+                return (spec + 's') % val
+            if conv == 'n':
+                return ''
+            if isinstance(val, str):
+                return val # Type mismatch
+            if conv in 'ouxX' and val < 0:
+                val += (1 << 64) if tag == ARG_INT64 else (1 << 32)
+            if conv in 'aA':
+                conv = 'e' if conv == 'a' else 'E'
+            try:
+                return (spec + conv) % val
+            except (TypeError, ValueError, OverflowError):
+                return str(val)
+        return FORMAT_SPEC.sub(replace, fmt)
+
+def level_name(level):
+    for l, name in LEVEL_NAMES:
+        if level >= l:
+            return name
+    return str(level)
+
+def main():
+    parser = argparse.ArgumentParser(description='Decodes deferred log output.', epilog=__doc__,
+            formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('elf', nargs='+', help='ELF files of the firmware modules')
+    parser.add_argument('-i', '--input', help='input file (default: standard input)')
+    parser.add_argument('-p', '--port', help='serial port (requires pyserial)')
+    parser.add_argument('-b', '--baud', type=int, default=115200, help='baud rate (default: 115200)')
+    args = parser.parse_args()
+    modules = [Module(path) for path in args.elf]
+    decoder = Decoder(modules, sys.stdout)
+    if args.port:
+        import serial
+        stream = serial.Serial(args.port, args.baud)
+    elif args.input:
+        stream = open(args.input, 'rb')
+    else:
+        stream = sys.stdin.buffer
+    try:
+        decoder.decode(stream)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        stream.close()
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License as published by the Free Software Foundation, either
+# version 3 of the License, or (at your option) any later version.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, see <http://www.gnu.org/licenses/>.
+#
+
+"""
+Packs files into a read-only asset image (see services/inc/asset_image.h).
+
+Every file is stored under its path relative to the directory it was found in, using '/' as
+the separator. The image is linked into the module's read-only data by build/assets.mk.
+
+Examples:
+    pack_assets.py -o asset_image.bin assets/
+    pack_assets.py -o asset_image.bin certs/ tables/sine.bin
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = 0x54455341 # 'ASET'
+VERSION = 1
+
+HEADER_FORMAT = '<IHHII'
+ENTRY_FORMAT = '<IIII'
+DATA_ALIGNMENT = 8
+MAX_ENTRY_COUNT = 0xffff
+
+def align(n, alignment):
+    return (n + alignment - 1) & ~(alignment - 1)
+
+def collect(paths):
+    assets = {}
+    for path in paths:
+        if os.path.isdir(path):
+            for root, dirs, files in os.walk(path):
+                dirs.sort()
+                for f in files:
+                    if f.startswith('.'):
+                        continue # Skip hidden files
+                    full = os.path.join(root, f)
+                    name = os.path.relpath(full, path).replace(os.sep, '/')
+                    add(assets, name, full)
+        else:
+            add(assets, os.path.basename(path), path)
+    return assets
+
+def add(assets, name, path):
+    if name in assets:
+        raise ValueError('Duplicate asset name: %s' % name)
+    assets[name] = path
+
+def pack(assets):
+    # Entries are sorted by name so that the firmware can use a binary search
+    names = sorted(assets.keys(), key=lambda n: n.encode('utf-8'))
+    if len(names) > MAX_ENTRY_COUNT:
+        raise ValueError('Too many assets')
+    header_size = struct.calcsize(HEADER_FORMAT)
+    entry_size = struct.calcsize(ENTRY_FORMAT)
+    names_offs = header_size + len(names) * entry_size
+    strings = b''
+    name_offsets = []
+    for name in names:
+        name_offsets.append(names_offs + len(strings))
+        strings += name.encode('utf-8') + b'\0'
+    data = b''
+    data_offs = align(names_offs + len(strings), DATA_ALIGNMENT)
+    entries = b''
+    for name, name_offs in zip(names, name_offsets):
+        with open(assets[name], 'rb') as f:
+            content = f.read()
+        data += b'\0' * (align(len(data), DATA_ALIGNMENT) - len(data))
+        entries += struct.pack(ENTRY_FORMAT, name_offs, data_offs + len(data), len(content), 0)
+        data += content
+    padding = b'\0' * (data_offs - names_offs - len(strings))
+    size = data_offs + len(data)
+    header = struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(names), size, 0)
+    return header + entries + strings + padding + data
+
+def main():
+    parser = argparse.ArgumentParser(description='Packs files into a read-only asset image.', epilog=__doc__,
+            formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('path', nargs='+', help='files or directories to pack')
+    parser.add_argument('-o', '--output', required=True, help='output file')
+    args = parser.parse_args()
+    try:
+        image = pack(collect(args.path))
+    except (ValueError, IOError) as e:
+        sys.stderr.write('pack_assets.py: %s\n' % e)
+        sys.exit(1)
+    with open(args.output, 'wb') as f:
+        f.write(image)
+
+if __name__ == '__main__':
+    main()
@@ -54,6 +54,7 @@ namespace CoAPMessageType {
     PING,
     ERROR,					// 15
     NONE,
+    BULK_ACK,
   };
 }
 
@@ -110,12 +111,36 @@ namespace CoAPCode {
 namespace CoAPOption {
 	enum Enum {
 		NONE = 0,
+		OBSERVE = 6,
 		LOCATION_PATH = 8,
 		URI_PATH = 11,
-		URI_QUERY = 15
+		URI_QUERY = 15,
+		BLOCK2 = 23,
+		BLOCK1 = 27,
+		SIZE2 = 28
 	};
 }
 
+/**
+ * Value of the Block1 and Block2 options (RFC 7959).
+ */
+struct CoAPBlock {
+	unsigned num; // Block number
+	unsigned szx; // Block size exponent, the block size is 2^(szx + 4) bytes
+	bool more; // More blocks follow
+
+	static const unsigned MAX_SZX = 6;
+	static const unsigned MAX_NUM = 0xfffff;
+
+	size_t size() const {
+		return (size_t)16 << szx;
+	}
+
+	size_t offset() const {
+		return num * size();
+	}
+};
+
 namespace CoAPType {
   enum Enum {
     CON,
@@ -191,6 +216,36 @@ public:
     static size_t token(const unsigned char* message, token_t* token);
     static size_t option_decode(unsigned char **option);
 
+    /**
+     * Finds an option in a CoAP message.
+     *
+     * @param message Message data.
+     * @param length Message size.
+     * @param option Option number.
+     * @param option_length Receives the size of the option value.
+     * @return Pointer to the option value, or `nullptr` if the option is not found or the message
+     *         is malformed.
+     */
+    static const uint8_t* find_option(const uint8_t* message, size_t length, CoAPOption::Enum option,
+    		size_t* option_length);
+
+    /**
+     * Decodes the value of a Block1 or Block2 option.
+     *
+     * @return `true` on success, or `false` if the value is invalid.
+     */
+    static bool decode_block(const uint8_t* value, size_t length, CoAPBlock* block);
+
+    /**
+     * Adds a Block1 or Block2 option to the buffer.
+     *
+     * At most `MAX_BLOCK_OPTION_SIZE` bytes are written.
+     */
+    static size_t block_option(uint8_t* buf, CoAPOption::Enum previous, CoAPOption::Enum current,
+    		const CoAPBlock& block);
+
+    static const size_t MAX_BLOCK_OPTION_SIZE = 5;
+
     /**
      * Computes the length indicator for a value encoded in CoAP.
      * Values less than 13 are encoded directly. Values between 13 and 268 (inclusive) are encoded as 13 (and later as a single byte extended option)
@@ -246,6 +301,96 @@ public:
     static CoAPCode::Enum codeForProtocolError(ProtocolError error);
 };
 
+/**
+ * Read-only view of a CoAP message.
+ *
+ * The header, token, options and payload are located in a single pass over the message, so that
+ * the message doesn't need to be parsed again every time one of its fields is accessed. Option
+ * values and the payload point into the message buffer, which must outlive the view.
+ */
+class CoAPMessageView
+{
+public:
+	/**
+	 * Iterates over the options of a message.
+	 */
+	class OptionIterator
+	{
+	public:
+		OptionIterator(const uint8_t* begin, const uint8_t* end);
+
+		/**
+		 * Moves to the next option.
+		 *
+		 * @return `false` if there are no more options or the option is malformed.
+		 */
+		bool next();
+
+		unsigned number() const { return number_; }
+		const uint8_t* data() const { return data_; }
+		size_t size() const { return size_; }
+
+	private:
+		const uint8_t* p_;
+		const uint8_t* end_;
+		const uint8_t* data_;
+		size_t size_;
+		unsigned number_;
+		bool error_;
+
+		friend class CoAPMessageView;
+	};
+
+	CoAPMessageView();
+
+	/**
+	 * Parses a message.
+	 *
+	 * @return `false` if the message is malformed.
+	 */
+	bool parse(const uint8_t* buf, size_t size);
+
+	bool is_valid() const { return valid_; }
+
+	CoAPType::Enum type() const { return type_; }
+	CoAPCode::Enum code() const { return code_; }
+	message_id_t id() const { return id_; }
+
+	const uint8_t* token() const { return buf_ + 4; }
+	size_t token_size() const { return token_size_; }
+
+	OptionIterator options() const { return OptionIterator(options_, options_end_); }
+
+	/**
+	 * Finds an option by its number.
+	 *
+	 * @return Pointer to the option value, or `nullptr` if the option is not found.
+	 */
+	const uint8_t* find_option(CoAPOption::Enum option, size_t* size) const;
+
+	/**
+	 * Returns the value of the first option of the message, whichever it is.
+	 */
+	const uint8_t* first_option(size_t* size) const;
+
+	const uint8_t* payload() const { return payload_; }
+	size_t payload_size() const { return payload_size_; }
+
+private:
+	const uint8_t* buf_;
+	const uint8_t* options_;
+	const uint8_t* options_end_;
+	const uint8_t* first_option_;
+	size_t first_option_size_;
+	const uint8_t* payload_;
+	size_t payload_size_;
+	size_t token_size_;
+	CoAPType::Enum type_;
+	CoAPCode::Enum code_;
+	message_id_t id_;
+	bool valid_;
+};
+
 // this uses version 0 to maintain compatiblity with the original comms lib codes
 #define COAP_MSG_HEADER(type, tokenlen) \
 	((CoAP::VERSION)<<6 | (type)<<4 | ((tokenlen) & 0xF))
@@ -84,6 +84,11 @@ DYNALIB_FN(BASE_IDX3 + 0, communication, spark_protocol_get_describe_data, int(P
 DYNALIB_FN(BASE_IDX3 + 1, communication, spark_protocol_post_description, int(ProtocolFacade*, int, void*))
 DYNALIB_FN(BASE_IDX3 + 2, communication, spark_protocol_to_system_error, int(int))
 DYNALIB_FN(BASE_IDX3 + 3, communication, spark_protocol_get_status, int(ProtocolFacade*, protocol_status*, void*))
+DYNALIB_FN(BASE_IDX3 + 4, communication, spark_protocol_send_events, bool(ProtocolFacade*, const EventBatchEntry*, size_t, int, uint32_t, void*))
+DYNALIB_FN(BASE_IDX3 + 5, communication, spark_protocol_add_filtered_event_handler, bool(ProtocolFacade*, const char*, EventHandler, SubscriptionScope::Enum, const char*, void*, const spark_protocol_event_filter*, void*))
+DYNALIB_FN(BASE_IDX3 + 6, communication, spark_protocol_send_bulk, int(ProtocolFacade*, const char*, size_t, spark_protocol_bulk_read_fn, void*, void*))
+DYNALIB_FN(BASE_IDX3 + 7, communication, spark_protocol_add_time_source, int(ProtocolFacade*, spark_protocol_time_source_fn, void*, void*))
+DYNALIB_FN(BASE_IDX3 + 8, communication, spark_protocol_sync_time_local, int(ProtocolFacade*, void*))
 
 DYNALIB_END(communication)
 
@@ -0,0 +1,113 @@
+/**
+ ******************************************************************************
+  Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation, either
+  version 3 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see <http://www.gnu.org/licenses/>.
+  ******************************************************************************
+  */
+
+#pragma once
+
+#include "events.h"
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace particle {
+
+/**
+ * Index over the filters of an array of event handlers.
+ *
+ * The index needs to be rebuilt every time the handlers change. An event is matched by hashing
+ * the prefixes of its name in a single pass, and only the handlers whose filter has the same
+ * length and hash as a prefix are compared byte-by-byte.
+ *
+ * @tparam N Number of handlers.
+ */
+template<size_t N>
+class EventFilterIndex {
+public:
+    /**
+     * Bit mask of the handlers, where bit `i` stands for the handler at index `i`.
+     */
+    typedef typename std::conditional<(N <= 8), uint8_t, uint32_t>::type Mask;
+
+    static_assert(N <= 32, "Too many handlers");
+
+    static const size_t MAX_FILTER_LENGTH = sizeof(FilteringEventHandler::filter);
+
+    EventFilterIndex() {
+        clear();
+    }
+
+    /**
+     * Rebuilds the index. Handlers with a `NULL` callback are skipped.
+     */
+    void update(const FilteringEventHandler* handlers) {
+        clear();
+        for (size_t i = 0; i < N; ++i) {
+            if (!handlers[i].handler) {
+                continue;
+            }
+            const size_t len = strnlen(handlers[i].filter, MAX_FILTER_LENGTH);
+            uint32_t hash = HASH_BASIS;
+            for (size_t j = 0; j < len; ++j) {
+                hash = hashStep(hash, handlers[i].filter[j]);
+            }
+            hash_[i] = hash;
+            withLength_[len] |= (Mask)(1u << i);
+        }
+    }
+
+    /**
+     * Returns a bit mask of the handlers whose filter is a prefix of the given event name.
+     */
+    Mask match(const FilteringEventHandler* handlers, const char* name, size_t nameLen) const {
+        Mask mask = 0;
+        uint32_t hash = HASH_BASIS;
+        const size_t maxLen = (nameLen < MAX_FILTER_LENGTH) ? nameLen : MAX_FILTER_LENGTH;
+        for (size_t len = 0;; ++len) {
+            for (Mask candidates = withLength_[len]; candidates; candidates &= candidates - 1) {
+                const unsigned i = __builtin_ctz(candidates);
+                if (hash_[i] == hash && !memcmp(handlers[i].filter, name, len)) {
+                    mask |= (Mask)(1u << i);
+                }
+            }
+            if (len == maxLen) {
+                break;
+            }
+            hash = hashStep(hash, name[len]);
+        }
+        return mask;
+    }
+
+private:
+    static const uint32_t HASH_BASIS = 2166136261u; // FNV-1a
+    static const uint32_t HASH_PRIME = 16777619u;
+
+    uint32_t hash_[N];
+    Mask withLength_[MAX_FILTER_LENGTH + 1]; // Handlers by the length of their filter
+
+    void clear() {
+        memset(hash_, 0, sizeof(hash_));
+        memset(withLength_, 0, sizeof(withLength_));
+    }
+
+    static uint32_t hashStep(uint32_t hash, uint8_t c) {
+        return (hash ^ c) * HASH_PRIME;
+    }
+};
+
+} // namespace particle
@@ -74,9 +74,57 @@ namespace SubscriptionScope {
   };
 }
 
+/**
+ * Content format of the event data. The values are those registered for the CoAP Content-Format option.
+ */
+namespace ContentType {
+  enum Enum {
+    TEXT = 0,                   // text/plain; charset=utf-8
+    BINARY = 42,                // application/octet-stream
+    JSON = 50,                  // application/json
+    CBOR = 60                   // application/cbor
+  };
+}
+
+/**
+ * Priority of an event waiting in the deferral queue of the protocol layer.
+ *
+ * Queued events are sent in the order of their priority, then their deadline. An event of a
+ * higher priority can displace a lower priority event from a full queue.
+ */
+namespace EventPriority {
+  enum Enum {
+    BACKGROUND = -1,            // Dropped once its deadline has passed
+    NORMAL = 0,                 // Default priority. Dropped once its deadline has passed
+    CRITICAL = 1                // Sent even if its deadline has passed
+  };
+}
+
 typedef void (*EventHandler)(const char *event_name, const char *data);
 typedef void (*EventHandlerWithData)(void *handler_data, const char *event_name, const char *data);
 
+/**
+ * Handler receiving the event data as a buffer rather than a null-terminated string. The data is
+ * still followed by a null terminator, which is not included in `data_size`.
+ */
+typedef void (*BinaryEventHandler)(void *handler_data, const char *event_name, const char *data,
+    size_t data_size, int content_type);
+
+/**
+ * Flags of a registered event handler.
+ *
+ * The matching flags are sent to the cloud along with the subscription, so that the events that
+ * don't match are filtered out before they are sent to the device. They are also checked locally.
+ */
+enum EventHandlerFlag {
+  EVENT_HANDLER_FLAG_BINARY = 0x01,         // The handler is a `BinaryEventHandler`
+  EVENT_HANDLER_FLAG_EXACT_NAME = 0x02,     // The event name must be equal to the filter, not just start with it
+  EVENT_HANDLER_FLAG_DATA_PREFIX = 0x04,    // The event data must start with `data_filter`
+  EVENT_HANDLER_FLAG_DATA_CONTAINS = 0x08,  // The event data must contain `data_filter`
+  EVENT_HANDLER_MATCH_FLAGS = EVENT_HANDLER_FLAG_EXACT_NAME | EVENT_HANDLER_FLAG_DATA_PREFIX |
+      EVENT_HANDLER_FLAG_DATA_CONTAINS
+};
+
 /**
  *  This is used in a callback so only change by adding fields to the end
  */
@@ -87,6 +135,28 @@ struct FilteringEventHandler
   void *handler_data;
   SubscriptionScope::Enum scope;
   char device_id[13];
+  uint8_t flags;                // EventHandlerFlag
+  char data_filter[32];         // Used with EVENT_HANDLER_FLAG_DATA_PREFIX and EVENT_HANDLER_FLAG_DATA_CONTAINS
+};
+
+/**
+ * Payload information of a received event, passed to `SparkDescriptor::call_event_handler()` via its
+ * `reserved` argument.
+ */
+struct ReceivedEventInfo
+{
+  size_t size;                  // Size of this structure
+  size_t data_size;             // Size of the event data, not including the null terminator
+  int content_type;             // ContentType::Enum
+};
+
+/**
+ * An event entry of a batched event message.
+ */
+struct EventBatchEntry
+{
+  const char* name;
+  const char* data; // Can be NULL
 };
 
 
@@ -96,6 +166,11 @@ size_t subscription(uint8_t buf[], uint16_t message_id,
 size_t subscription(uint8_t buf[], uint16_t message_id,
                     const char *event_name, SubscriptionScope::Enum scope);
 
+/**
+ * Encodes a subscription message with the matching criteria of the given handler.
+ */
+size_t subscription(uint8_t buf[], uint16_t message_id, const FilteringEventHandler& handler);
+
 size_t event_name_uri_path(uint8_t buf[], const char *name, size_t name_len);
 
 #endif // __EVENTS_H
@@ -5,6 +5,7 @@
 #include "protocol_defs.h"
 #include "ping.h"
 #include "chunked_transfer.h"
+#include "bulk_transfer.h"
 #include "spark_descriptor.h"
 #include "spark_protocol_functions.h"
 #include "functions.h"
@@ -38,6 +39,16 @@ class Protocol
 	 */
 	system_tick_t last_message_millis;
 
+	/**
+	 * The tick time when the last message sent over the channel was noticed.
+	 */
+	system_tick_t last_sent_millis;
+
+	/**
+	 * The channel's count of sent messages as of `last_sent_millis`.
+	 */
+	unsigned last_sent_count;
+
 	/**
 	 * The product_id represented by this device. set_product_id()
 	 */
@@ -86,6 +97,11 @@ class Protocol
 
 	} chunkedTransferCallbacks;
 
+	/**
+	 * Streams bulk data to the cloud.
+	 */
+	BulkTransfer bulkTransfer;
+
 	/**
 	 * Manages device-hosted variables.
 	 */
@@ -120,6 +136,32 @@ class Protocol
 	 */
 	system_tick_t last_ack_handlers_update;
 
+	/**
+	 * The tick time at which the current session was resumed.
+	 */
+	system_tick_t session_resumed_millis;
+
+	/**
+	 * Set when a resumed session has not been verified by sending a confirmable message yet.
+	 */
+	bool resume_ping_pending;
+
+	/**
+	 * ID of the last binary metrics message posted in the current session.
+	 */
+	message_id_t metrics_msg_id;
+
+	/**
+	 * Set while the last binary metrics message awaits acknowledgement.
+	 */
+	bool metrics_ack_pending;
+
+	/**
+	 * Set when the server acknowledged the last binary metrics message, so that the next
+	 * metrics can be sent as a delta.
+	 */
+	bool metrics_acked;
+
 	/**
 	 * The token ID for the next request made.
 	 * If we have a bone-fide CoAP layer this will eventually disappear into that layer, just like message-id has.
@@ -158,6 +200,17 @@ protected:
 	 */
 	Pinger pinger;
 
+	/**
+	 * Fills in the keepalive fields of the protocol status, if the structure has them.
+	 */
+	void get_keepalive_status(protocol_status* status) const
+	{
+		if (offsetof(protocol_status, keepalive_bounds) + sizeof(protocol_status::keepalive_bounds) <= status->size)
+		{
+			status->keepalive_bounds = pinger.is_adaptive() ? pinger.adaptive_bounds() : 0;
+		}
+	}
+
 	/**
 	 * Completion handlers for messages with confirmable delivery.
 	 */
@@ -179,6 +232,19 @@ protected:
 
 	ProtocolError handle_key_change(Message& message);
 
+	/**
+	 * Called when an event has been sent. The acknowledgement of a confirmable event verifies
+	 * a resumed session, so a separate ping is not needed.
+	 */
+	void event_sent(int flags)
+	{
+		if (resume_ping_pending && !(flags & EventType::NO_ACK) &&
+				(channel.is_unreliable() || (flags & EventType::WITH_ACK)))
+		{
+			resume_ping_pending = false;
+		}
+	}
+
 	/**
 	 * Send the hello message over the channel.
 	 * @param was_ota_upgrade_successful {@code true} if the previous OTA update was successful.
@@ -222,8 +288,32 @@ protected:
 		}
 		else
 		{
-			ProtocolError error = pinger.process(
-					callbacks.millis() - last_message_millis, [this]
+			ProtocolError error = publisher.process(channel, callbacks.millis());
+			if (error)
+				return error;
+			error = bulkTransfer.process(channel, callbacks.millis());
+			if (error)
+				return error;
+			error = variables.process(callbacks.millis());
+			if (error)
+				return error;
+			if (resume_ping_pending &&
+					callbacks.millis() - session_resumed_millis >= PROTOCOL_RESUME_PING_DELAY)
+			{
+				resume_ping_pending = false;
+				error = ping(true);
+				if (error)
+					return error;
+			}
+			const unsigned sent_count = channel.sent_message_count();
+			if (sent_count != last_sent_count)
+			{
+				last_sent_count = sent_count;
+				last_sent_millis = callbacks.millis();
+			}
+			error = pinger.process(
+					callbacks.millis() - last_message_millis,
+					callbacks.millis() - last_sent_millis, [this]
 					{	return ping();});
 			if (error)
 				return error;
@@ -255,11 +345,29 @@ protected:
 	ProtocolError generate_and_send_description(MessageChannel& channel, Message& message,
 												size_t header_size, int desc_flags);
 
+	/**
+	 * Sends a describe message that has been generated in the message buffer and updates
+	 * the describe checksums once the whole describe has been sent.
+	 *
+	 * @param complete `false` if more blocks of the describe message follow
+	 */
+	ProtocolError send_description_message(MessageChannel& channel, Message& message,
+												int desc_flags, bool complete);
+
 	/**
 	 * Produces and transmits (PIGGYBACK) a describe message.
 	 * @param desc_flags Flags describing the information to provide. A combination of {@code DESCRIBE_APPLICATION) and {@code DESCRIBE_SYSTEM) flags.
+	 * @param block The requested block of the describe message (RFC 7959), or `nullptr` if the
+	 *        describe message is requested as a whole.
 	 */
-	ProtocolError send_description(token_t token, message_id_t msg_id, int desc_flags);
+	ProtocolError send_description(token_t token, message_id_t msg_id, int desc_flags,
+								   const CoAPBlock* block = nullptr);
+
+	/**
+	 * Transmits (PIGGYBACK) a single block of a describe message.
+	 */
+	ProtocolError send_description_block(token_t token, message_id_t msg_id, int desc_flags,
+										 CoAPBlock block);
 
 	/**
 	 * Decodes and dispatches a received message to its handler.
@@ -299,11 +407,18 @@ protected:
 public:
 	Protocol(MessageChannel& channel) :
 			channel(channel),
+			last_sent_millis(0),
+			last_sent_count(0),
 			product_id(PRODUCT_ID),
 			product_firmware_version(PRODUCT_FIRMWARE_VERSION),
 			variables(this),
 			publisher(this),
 			last_ack_handlers_update(0),
+			session_resumed_millis(0),
+			resume_ping_pending(false),
+			metrics_msg_id(0),
+			metrics_ack_pending(false),
+			metrics_acked(false),
 			initialized(false)
 	{
 	}
@@ -323,11 +438,28 @@ public:
 		pinger.set_interval(interval, source);
 	}
 
+	void set_adaptive_keepalive(unsigned bounds)
+	{
+		if (bounds == ADAPTIVE_PING_DISABLED)
+		{
+			pinger.set_adaptive(false);
+		}
+		else
+		{
+			pinger.set_adaptive(true, bounds);
+		}
+	}
+
 	void set_fast_ota(unsigned data)
 	{
 		chunkedTransfer.set_fast_ota(data);
 	}
 
+	void set_event_rate_limit(uint16_t burst, system_tick_t interval)
+	{
+		publisher.set_rate_limit(burst, interval);
+	}
+
 	void set_handlers(CommunicationsHandlers& handlers)
 	{
 		copy_and_init(&this->handlers, sizeof(this->handlers), &handlers, handlers.size);
@@ -396,22 +528,82 @@ public:
 	// Returns true on success, false on sending timeout or rate-limiting failure
 	bool send_event(const char *event_name, const char *data, int ttl,
 			EventType::Enum event_type, int flags, CompletionHandler handler)
+	{
+		return send_event(event_name, data, data ? strnlen(data, MAX_EVENT_DATA_LENGTH) : 0,
+				ContentType::TEXT, ttl, event_type, flags, std::move(handler));
+	}
+
+	/**
+	 * Sends an event with the data of the given size and content format.
+	 *
+	 * @see Publisher::send_event()
+	 */
+	bool send_event(const char *event_name, const char *data, size_t data_size, int content_type,
+			int ttl, EventType::Enum event_type, int flags, CompletionHandler handler,
+			int priority = EventPriority::NORMAL, system_tick_t timeout = 0)
+	{
+		if (chunkedTransfer.is_updating())
+		{
+			handler.setError(SYSTEM_ERROR_BUSY);
+			return false;
+		}
+		const ProtocolError error = publisher.send_event(channel, event_name, data, data_size, content_type,
+				ttl, event_type, flags, callbacks.millis(), std::move(handler), priority, timeout);
+		if (error != NO_ERROR)
+		{
+			handler.setError(toSystemError(error));
+			return false;
+		}
+		event_sent(flags);
+		return true;
+	}
+
+	// Returns true on success, false on sending timeout, rate-limiting failure or if the events don't fit into a single message
+	bool send_events(const EventBatchEntry* events, size_t count, int ttl,
+			EventType::Enum event_type, int flags, CompletionHandler handler)
 	{
 		if (chunkedTransfer.is_updating())
 		{
 			handler.setError(SYSTEM_ERROR_BUSY);
 			return false;
 		}
-		const ProtocolError error = publisher.send_event(channel, event_name, data, ttl, event_type, flags,
+		const ProtocolError error = publisher.send_events(channel, events, count, ttl, event_type, flags,
 				callbacks.millis(), std::move(handler));
 		if (error != NO_ERROR)
 		{
 			handler.setError(toSystemError(error));
 			return false;
 		}
+		event_sent(flags);
 		return true;
 	}
 
+	/**
+	 * Start a bulk transfer of `size` bytes to the cloud.
+	 *
+	 * @return 0 if the transfer has been requested, or a negative result code in case of an error.
+	 *         The handler is invoked when the transfer completes or fails.
+	 */
+	int send_bulk(const char* name, size_t size, bulk_transfer_read_fn read, void* data, CompletionHandler handler)
+	{
+		if (chunkedTransfer.is_updating() || bulkTransfer.is_active())
+		{
+			handler.setError(SYSTEM_ERROR_BUSY);
+			return SYSTEM_ERROR_BUSY;
+		}
+		const ProtocolError error = bulkTransfer.begin(channel, next_token(), name, size, read, data,
+				std::move(handler), callbacks.millis());
+		return (error != NO_ERROR) ? toSystemError(error) : 0;
+	}
+
+	/**
+	 * Cancel the active bulk transfer.
+	 */
+	void cancel_bulk()
+	{
+		bulkTransfer.cancel(SYSTEM_ERROR_CANCELLED, &channel);
+	}
+
 	inline bool send_subscription(const char *event_name, const char *device_id)
 	{
 		bool success = !subscriptions.send_subscription(channel, event_name, device_id);
@@ -439,10 +631,10 @@ public:
 
 	inline bool add_event_handler(const char *event_name, EventHandler handler,
 			void *handler_data, SubscriptionScope::Enum scope,
-			const char* device_id)
+			const char* device_id, uint8_t flags = 0, const char* data_filter = nullptr)
 	{
 		return !subscriptions.add_event_handler(event_name, handler,
-				handler_data, scope, device_id);
+				handler_data, scope, device_id, flags, data_filter);
 	}
 
 	inline bool send_subscriptions()
@@ -486,6 +678,11 @@ public:
 			return false;
 		}
 
+		if (timesync_.sync_local(callbacks.millis(), callbacks.set_time))
+		{
+			return true;
+		}
+
 		return timesync_.send_request(callbacks.millis(), [&]() {
 			uint8_t token = next_token();
 			Message message;
@@ -496,6 +693,20 @@ public:
 		});
 	}
 
+	/**
+	 * Register a local time source. Sources are queried in the order of registration before
+	 * the time is requested from the cloud.
+	 */
+	int add_time_source(time_source_fn fn, void* data)
+	{
+		return timesync_.add_source(fn, data);
+	}
+
+	bool sync_time_local()
+	{
+		return timesync_.sync_local(callbacks.millis(), callbacks.set_time);
+	}
+
 	bool time_request_pending() const { return timesync_.is_request_pending(); }
 	system_tick_t time_last_synced(time_t* tm) const { return timesync_.last_sync(*tm); }
 
@@ -1,6 +1,7 @@
 	#pragma once
 
 #include <functional>
+#include <cstddef>
 #include "system_tick_hal.h"
 
 #include "system_error.h"
@@ -18,7 +19,9 @@ namespace particle { namespace protocol {
 #define PRODUCT_FIRMWARE_VERSION (0xffff)
 #endif
 
+#ifndef MAX_SUBSCRIPTIONS
 #define MAX_SUBSCRIPTIONS (6)       // 2 system and 4 application
+#endif
 
 enum ProtocolError
 {
@@ -77,6 +80,9 @@ const size_t MAX_VARIABLE_KEY_LENGTH = 64;
 const size_t MAX_EVENT_NAME_LENGTH   = 64;
 const size_t MAX_EVENT_DATA_LENGTH   = 622;
 
+// Version of the bulk transfer messages
+const uint8_t BULK_TRANSFER_VERSION  = 1;
+
 // Timeout in milliseconds given to receive an acknowledgement for a published event
 const unsigned SEND_EVENT_ACK_TIMEOUT = 20000;
 
@@ -84,6 +90,41 @@ const unsigned SEND_EVENT_ACK_TIMEOUT = 20000;
     #define PROTOCOL_BUFFER_SIZE 800
 #endif
 
+// Size of the buffer collecting consecutive firmware chunks before they are written to storage.
+// Set to 0 to write every chunk as soon as it is received
+#ifndef PROTOCOL_CHUNK_WRITE_BUFFER_SIZE
+    #define PROTOCOL_CHUNK_WRITE_BUFFER_SIZE 2048
+#endif
+
+// Maximum number of confirmable messages sent by the device that can await acknowledgement at the
+// same time (NSTART). Further confirmable messages are queued until an acknowledgement is received
+#ifndef PROTOCOL_COAP_NSTART
+    #define PROTOCOL_COAP_NSTART 4
+#endif
+
+// Time to wait for the first application message after resuming a session before the session is
+// verified with a ping. A confirmable message sent in the meantime verifies the session instead
+#ifndef PROTOCOL_RESUME_PING_DELAY
+    #define PROTOCOL_RESUME_PING_DELAY 1000
+#endif
+
+// Maximum number of rate-limited application events that can be deferred
+#ifndef PROTOCOL_DEFERRED_EVENT_COUNT
+    #define PROTOCOL_DEFERRED_EVENT_COUNT 4
+#endif
+
+// Size of the buffer storing names and data of the deferred events
+#ifndef PROTOCOL_DEFERRED_EVENT_BUFFER_SIZE
+    #define PROTOCOL_DEFERRED_EVENT_BUFFER_SIZE 512
+#endif
+
+// Default rate limits for published events: a burst of 4 application events, refilled at 1 event
+// per second, and a burst of 255 system events, refilled at 255 events per 65536 milliseconds
+const uint16_t APPLICATION_EVENT_BURST = 4;
+const system_tick_t APPLICATION_EVENT_INTERVAL = 1000;
+const uint16_t SYSTEM_EVENT_BURST = 255;
+const system_tick_t SYSTEM_EVENT_INTERVAL = 257;
+
 
 namespace ChunkReceivedCode {
   enum Enum {
@@ -97,7 +138,8 @@ enum DescriptionType {
     DESCRIBE_APPLICATION = 1<<1,       	// functions and variables
 	DESCRIBE_METRICS = 1<<2,				// metrics/diagnostics
     DESCRIBE_DEFAULT = DESCRIBE_SYSTEM | DESCRIBE_APPLICATION,
-	DESCRIBE_MAX = (1<<3)-1
+	DESCRIBE_MAX = (1<<3)-1,
+	DESCRIBE_METRICS_DELTA = 1<<3		// only metrics that changed since the last acknowledged metrics (used with DESCRIBE_METRICS)
 };
 
 namespace Connection
@@ -105,10 +147,25 @@ namespace Connection
 enum Enum
 {
     PING = 0,
-    FAST_OTA = 1
+    FAST_OTA = 1,
+    /**
+     * Application event rate limit. The burst size is encoded in the upper 16 bits of the
+     * property value, and the refill interval in milliseconds in the lower 16 bits.
+     */
+    EVENT_RATE_LIMIT = 2,
+    /**
+     * Enables the adaptive keepalive mode. The property value is the NAT binding lifetime
+     * bounds learned previously for the current network (see `protocol_status::keepalive_bounds`),
+     * or 0 if nothing is known about the network. Setting the property to
+     * `ADAPTIVE_PING_DISABLED` disables the mode, and so does setting the keepalive interval
+     * with `KeepAliveSource::USER`.
+     */
+    ADAPTIVE_PING = 3
 };
 }
 
+const unsigned ADAPTIVE_PING_DISABLED = 0xffffffff;
+
 typedef std::function<system_tick_t()> millis_callback;
 typedef std::function<int()> callback;
 
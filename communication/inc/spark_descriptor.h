@@ -122,6 +122,16 @@ struct SparkDescriptor
      * @param context Context of the variable request. This argument needs to be passed to the completion callback.
      */
     void (*get_variable_async)(const char* key, GetVariableCallback callback, void* context);
+
+    /**
+     * Get the change notification options of an observable variable.
+     *
+     * @param key Variable name.
+     * @param interval[out] Minimum interval between notifications in milliseconds.
+     * @param threshold[out] Minimum change of a numeric value that triggers a notification.
+     * @return `true` if the variable is observable, or `false` otherwise.
+     */
+    bool (*get_variable_observe_options)(const char* key, uint32_t* interval, double* threshold);
 };
 
-PARTICLE_STATIC_ASSERT(SparkDescriptor_size, sizeof(SparkDescriptor)==60 || sizeof(void*)!=4);
+PARTICLE_STATIC_ASSERT(SparkDescriptor_size, sizeof(SparkDescriptor)==64 || sizeof(void*)!=4);
@@ -174,13 +174,113 @@ typedef struct {
     void* handler_data;
 } completion_handler_data;
 
-typedef completion_handler_data spark_protocol_send_event_data;
+// Additional parameters for spark_protocol_send_event() and spark_protocol_send_events()
+typedef struct {
+    size_t size;
+    completion_callback handler_callback;
+    void* handler_data;
+    // The fields below are ignored by spark_protocol_send_events()
+    size_t data_size; // Size of the event data, which doesn't need to be null-terminated. If 0, the data is a null-terminated string
+    int content_type; // ContentType::Enum
+    int priority; // EventPriority::Enum
+    system_tick_t timeout; // Time in milliseconds after which a deferred event is dropped. If 0, the event has no deadline
+} spark_protocol_send_event_data;
 
 bool spark_protocol_send_event(ProtocolFacade* protocol, const char *event_name, const char *data,
                 int ttl, uint32_t flags, void* reserved);
+/**
+ * Send several events in a single message.
+ *
+ * @param protocol Protocol instance.
+ * @param events Events to send.
+ * @param count Number of events.
+ * @param ttl Time to live (shared by all events of the batch).
+ * @param flags Event type and flags (shared by all events of the batch).
+ * @param reserved Optional `spark_protocol_send_event_data` with a completion handler invoked once for the whole batch.
+ * @return `true` on success, or `false` if the events couldn't be sent.
+ */
+bool spark_protocol_send_events(ProtocolFacade* protocol, const EventBatchEntry* events, size_t count,
+                int ttl, uint32_t flags, void* reserved);
 bool spark_protocol_send_subscription_device(ProtocolFacade* protocol, const char *event_name, const char *device_id, void* reserved=NULL);
 bool spark_protocol_send_subscription_scope(ProtocolFacade* protocol, const char *event_name, SubscriptionScope::Enum scope, void* reserved=NULL);
 bool spark_protocol_add_event_handler(ProtocolFacade* protocol, const char *event_name, EventHandler handler, SubscriptionScope::Enum scope, const char* id, void* handler_data=NULL);
+// Additional parameters for spark_protocol_add_filtered_event_handler()
+typedef struct {
+    size_t size;
+    uint32_t flags; // A combination of flags defined by the `EventHandlerFlag` enum
+    const char* data_filter; // Used with EVENT_HANDLER_FLAG_DATA_PREFIX and EVENT_HANDLER_FLAG_DATA_CONTAINS
+} spark_protocol_event_filter;
+
+/**
+ * Add an event handler with additional matching criteria, or a handler receiving the event data as
+ * a buffer along with its size and content format (`EVENT_HANDLER_FLAG_BINARY`). The matching
+ * criteria are sent to the cloud with the subscription.
+ */
+bool spark_protocol_add_filtered_event_handler(ProtocolFacade* protocol, const char *event_name, EventHandler handler,
+                SubscriptionScope::Enum scope, const char* id, void* handler_data, const spark_protocol_event_filter* filter,
+                void* reserved);
+/**
+ * Callback reading the data of a bulk transfer.
+ *
+ * @return Number of bytes read, or a negative result code in case of an error.
+ */
+typedef int (*spark_protocol_bulk_read_fn)(size_t offset, uint8_t* buf, size_t size, void* data);
+/**
+ * Send a large block of data to the cloud without blocking other messages for the duration of
+ * the transfer.
+ *
+ * The data is streamed over the current session with a sliding window of segments, after the
+ * cloud has accepted the transfer. The read callback is invoked on the system thread and may be
+ * asked to read the same range more than once.
+ *
+ * @param protocol Protocol instance.
+ * @param name Name of the transfer.
+ * @param size Size of the data.
+ * @param read Callback reading the data.
+ * @param data User data passed to the callback.
+ * @param reserved Optional `completion_handler_data` with a handler invoked when the cloud has
+ *        received all data or the transfer fails. `SYSTEM_ERROR_NOT_SUPPORTED` is reported if
+ *        the cloud doesn't support bulk transfers.
+ * @return 0 if the transfer has been requested, or a negative result code in case of an error.
+ */
+int spark_protocol_send_bulk(ProtocolFacade* protocol, const char* name, size_t size, spark_protocol_bulk_read_fn read,
+                void* data, void* reserved);
+/**
+ * Callback providing the current time from a source other than the cloud.
+ *
+ * @return 0 on success, or a negative result code if the source cannot provide the time.
+ */
+typedef int (*spark_protocol_time_source_fn)(time_t* time, void* data);
+/**
+ * Register a local time source.
+ *
+ * Sources are queried in the order of registration, so the most accurate ones should be
+ * registered first. When the time is set from a local source, the `param` argument of the
+ * `set_time` callback is the 1-based index of the source, or 0 if the time was received from
+ * the cloud.
+ *
+ * @param protocol Protocol instance.
+ * @param fn Callback providing the time. The callback is invoked on the system thread.
+ * @param data User data passed to the callback.
+ * @param reserved Reserved argument. Must be set to `NULL`.
+ * @return 0 on success, or a negative result code in case of an error.
+ */
+int spark_protocol_add_time_source(ProtocolFacade* protocol, spark_protocol_time_source_fn fn, void* data,
+                void* reserved);
+/**
+ * Set the time from the first local time source that can provide it, without involving the
+ * cloud. This function can be called before the cloud connection is established.
+ *
+ * @return 0 if the time has been set, or `SYSTEM_ERROR_NOT_FOUND` if none of the local sources
+ *         could provide it.
+ */
+int spark_protocol_sync_time_local(ProtocolFacade* protocol, void* reserved);
+/**
+ * Request the current time.
+ *
+ * The registered local time sources are queried first, and the time is only requested from the
+ * cloud if none of them can provide it.
+ */
 bool spark_protocol_send_time_request(ProtocolFacade* protocol, void* reserved=NULL);
 void spark_protocol_send_subscriptions(ProtocolFacade* protocol, void* reserved=NULL);
 void spark_protocol_remove_event_handlers(ProtocolFacade* protocol, const char *event_name, void* reserved=NULL);
@@ -214,6 +314,7 @@ int spark_protocol_get_describe_data(ProtocolFacade* protocol, spark_protocol_de
  * @param desc_flags The information description flags (default value: \p DESCRIBE_METRICS)
  * @arg \p DESCRIBE_APPLICATION
  * @arg \p DESCRIBE_METRICS
+ * @arg \p DESCRIBE_METRICS_DELTA (with \p DESCRIBE_METRICS)
  * @arg \p DESCRIBE_SYSTEM
  * @param[in,out] reserved Reserved for future use (default value: \p NULL).
  *
@@ -341,6 +442,12 @@ typedef enum protocol_status_flag {
 typedef struct protocol_status {
     uint16_t size; ///< Size of this structure.
     uint32_t flags; ///< Status flags (see `protocol_status_flag`).
+    /**
+     * NAT binding lifetime bounds learned in the adaptive keepalive mode. The lower 16 bits are
+     * the longest idle period, in seconds, after which a ping has been acknowledged, and the
+     * upper 16 bits are the shortest idle period after which a ping has timed out, or 0.
+     */
+    uint32_t keepalive_bounds;
 } protocol_status;
 
 /**
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "logging.h"
+LOG_SOURCE_CATEGORY("comm.bulk")
+
+#include "bulk_transfer.h"
+#include "messages.h"
+
+#include <algorithm>
+
+namespace particle { namespace protocol {
+
+namespace {
+
+// Bulk segment header: 4 bytes CoAP header, 1 byte token, 2 bytes Uri-Path, payload marker
+// and 4 bytes offset
+const size_t SEGMENT_HEADER_SIZE = 12;
+
+uint32_t decode_uint32(const uint8_t* p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+} // namespace
+
+const unsigned BulkTransfer::DEFAULT_WINDOW;
+const unsigned BulkTransfer::MAX_WINDOW;
+const size_t BulkTransfer::DEFAULT_SEGMENT_SIZE;
+const system_tick_t BulkTransfer::OPEN_TIMEOUT;
+const system_tick_t BulkTransfer::ACK_TIMEOUT;
+const unsigned BulkTransfer::MAX_RETRIES;
+const unsigned BulkTransfer::SEGMENTS_PER_ITERATION;
+
+BulkTransfer::BulkTransfer() :
+		read(nullptr),
+		read_data(nullptr),
+		size(0),
+		acked(0),
+		next(0),
+		segment_size(DEFAULT_SEGMENT_SIZE),
+		timer(0),
+		window(DEFAULT_WINDOW),
+		retries(0),
+		open_id(0),
+		token(0),
+		state(IDLE)
+{
+}
+
+BulkTransfer::~BulkTransfer()
+{
+	cancel(SYSTEM_ERROR_CANCELLED);
+}
+
+ProtocolError BulkTransfer::begin(MessageChannel& channel, token_t token, const char* name, size_t size,
+		bulk_transfer_read_fn read, void* data, CompletionHandler handler, system_tick_t millis)
+{
+	if (state != IDLE) {
+		handler.setError(SYSTEM_ERROR_BUSY);
+		return ProtocolError::INVALID_STATE;
+	}
+	if (!read || !size) {
+		handler.setError(SYSTEM_ERROR_INVALID_ARGUMENT);
+		return ProtocolError::UNKNOWN;
+	}
+	Message message;
+	ProtocolError error = channel.create(message);
+	if (error == NO_ERROR) {
+		message.set_length(Messages::bulk_open(message.buf(), 0, token, size, name));
+		error = channel.send(message);
+	}
+	if (error != NO_ERROR) {
+		handler.setError(toSystemError(error));
+		return error;
+	}
+	this->handler = std::move(handler);
+	this->read = read;
+	this->read_data = data;
+	this->size = size;
+	this->token = token;
+	acked = 0;
+	next = 0;
+	retries = 0;
+	window = DEFAULT_WINDOW;
+	segment_size = DEFAULT_SEGMENT_SIZE;
+	open_id = message.get_id();
+	timer = millis;
+	state = OPENING;
+	LOG(INFO, "Opening bulk transfer, size: %u", (unsigned)size);
+	return NO_ERROR;
+}
+
+bool BulkTransfer::handle_reply(const CoAPMessageView& msg, system_tick_t millis)
+{
+	if (state != OPENING || msg.id() != open_id || msg.code() == CoAPCode::EMPTY) {
+		return false;
+	}
+	if (!CoAPCode::is_success(msg.code())) {
+		LOG(WARN, "Bulk transfer rejected, code: %d.%02d", (int)msg.code() >> 5, (int)msg.code() & 0x1f);
+		complete((((int)msg.code() >> 5) == 4) ? SYSTEM_ERROR_NOT_SUPPORTED : SYSTEM_ERROR_COAP_5XX);
+		return true;
+	}
+	// Window size and maximum segment size. The defaults are used if the server doesn't specify them
+	const uint8_t* p = msg.payload();
+	if (msg.payload_size() >= 1 && p[0]) {
+		window = std::min<unsigned>(p[0], MAX_WINDOW);
+	}
+	if (msg.payload_size() >= 3) {
+		const size_t n = ((size_t)p[1] << 8) | p[2];
+		if (n) {
+			segment_size = std::min(n, DEFAULT_SEGMENT_SIZE);
+		}
+	}
+	LOG(INFO, "Bulk transfer opened, window: %u, segment size: %u", window, (unsigned)segment_size);
+	timer = millis;
+	state = SENDING;
+	return true;
+}
+
+ProtocolError BulkTransfer::handle_ack(Message& message, MessageChannel& channel, system_tick_t millis)
+{
+	CoAPMessageView msg;
+	msg.parse(message.buf(), message.length());
+	if (msg.type() == CoAPType::CON) {
+		Message response;
+		channel.create(response);
+		response.set_length(Messages::empty_ack(response.buf(), message.buf()[2], message.buf()[3]));
+		const ProtocolError error = channel.send(response);
+		if (error != NO_ERROR) {
+			return error;
+		}
+	}
+	if (state != SENDING || msg.token_size() != sizeof(token_t) || *msg.token() != token ||
+			msg.payload_size() < 4) {
+		return NO_ERROR;
+	}
+	const size_t offset = decode_uint32(msg.payload());
+	if (msg.payload_size() >= 5 && msg.payload()[4]) {
+		window = std::min<unsigned>(msg.payload()[4], MAX_WINDOW);
+	}
+	if (offset > acked && offset <= next) {
+		acked = offset;
+		retries = 0;
+		timer = millis;
+		if (acked == size) {
+			LOG(INFO, "Bulk transfer completed");
+			complete(0);
+		}
+	}
+	return NO_ERROR;
+}
+
+ProtocolError BulkTransfer::process(MessageChannel& channel, system_tick_t millis)
+{
+	if (state == OPENING) {
+		if (millis - timer >= OPEN_TIMEOUT) {
+			complete(SYSTEM_ERROR_TIMEOUT);
+		}
+		return NO_ERROR;
+	}
+	if (state != SENDING) {
+		return NO_ERROR;
+	}
+	if (next > acked && millis - timer >= ACK_TIMEOUT) {
+		if (++retries > MAX_RETRIES) {
+			LOG(ERROR, "Bulk transfer timed out");
+			cancel(SYSTEM_ERROR_TIMEOUT, &channel);
+			return NO_ERROR;
+		}
+		// Go back to the first unacknowledged segment
+		LOG(TRACE, "Resending bulk transfer data from offset %u", (unsigned)acked);
+		next = acked;
+		timer = millis;
+	}
+	for (unsigned i = 0; i < SEGMENTS_PER_ITERATION && state == SENDING && next < size &&
+			next - acked < window * segment_size; ++i) {
+		const ProtocolError error = send_segment(channel, millis);
+		if (error != NO_ERROR) {
+			return error;
+		}
+	}
+	return NO_ERROR;
+}
+
+ProtocolError BulkTransfer::send_segment(MessageChannel& channel, system_tick_t millis)
+{
+	Message message;
+	ProtocolError error = channel.create(message);
+	if (error != NO_ERROR) {
+		return error;
+	}
+	if (message.capacity() <= SEGMENT_HEADER_SIZE) {
+		return ProtocolError::INSUFFICIENT_STORAGE;
+	}
+	size_t n = std::min(size - next, segment_size);
+	n = std::min(n, message.capacity() - SEGMENT_HEADER_SIZE);
+	const size_t header_size = Messages::bulk_segment_header(message.buf(), 0, token, next);
+	const int r = read(next, message.buf() + header_size, n, read_data);
+	if (r <= 0) {
+		LOG(ERROR, "Unable to read bulk transfer data: %d", r);
+		cancel((r < 0) ? r : SYSTEM_ERROR_END_OF_STREAM, &channel);
+		return NO_ERROR;
+	}
+	n = std::min((size_t)r, n);
+	message.set_length(header_size + n);
+	error = channel.send(message);
+	if (error != NO_ERROR) {
+		return error;
+	}
+	if (next == acked) {
+		// Nothing was in flight, start waiting for an acknowledgement now
+		timer = millis;
+	}
+	next += n;
+	return NO_ERROR;
+}
+
+void BulkTransfer::cancel(int error, MessageChannel* channel)
+{
+	if (state == IDLE) {
+		return;
+	}
+	if (channel) {
+		Message message;
+		if (channel->create(message) == NO_ERROR) {
+			message.set_length(Messages::bulk_cancel(message.buf(), 0, token));
+			channel->send(message);
+		}
+	}
+	complete(error);
+}
+
+void BulkTransfer::complete(int error)
+{
+	state = IDLE;
+	read = nullptr;
+	read_data = nullptr;
+	if (error < 0) {
+		handler.setError(error);
+	} else {
+		handler.setResult();
+	}
+}
+
+}} // namespace particle::protocol
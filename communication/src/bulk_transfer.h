@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "protocol_defs.h"
+#include "message_channel.h"
+#include "completion_handler.h"
+#include "coap.h"
+
+namespace particle { namespace protocol {
+
+/**
+ * Reads the data of a bulk transfer.
+ *
+ * @param offset Offset in the data.
+ * @param buf Destination buffer.
+ * @param size Maximum number of bytes to read.
+ * @param data User data.
+ * @return Number of bytes read, or a negative result code in case of an error.
+ */
+typedef int (*bulk_transfer_read_fn)(size_t offset, uint8_t* buf, size_t size, void* data);
+
+/**
+ * Sends a large block of data to the cloud as a stream multiplexed with the CoAP traffic of the
+ * session.
+ *
+ * The transfer is negotiated with a confirmable `POST /B` request carrying the data size. The
+ * server answers with the number of segments it accepts in flight and the maximum segment size,
+ * or with an error if it doesn't support bulk transfers. The data is then sent in non-confirmable
+ * segments without waiting for each of them to be acknowledged: the server periodically reports
+ * the offset up to which it has received the data (`POST /b`), which slides the window. If the
+ * reported offset doesn't advance in time, the segments following it are sent again.
+ *
+ * Segments are only sent while the protocol is idle, a few at a time, so other messages don't
+ * have to wait for the transfer to complete. Only one transfer can be active at a time.
+ */
+class BulkTransfer
+{
+public:
+	static const unsigned DEFAULT_WINDOW = 4;
+	static const unsigned MAX_WINDOW = 32;
+	static const size_t DEFAULT_SEGMENT_SIZE = 512;
+	static const system_tick_t OPEN_TIMEOUT = 30000;
+	static const system_tick_t ACK_TIMEOUT = 3000;
+	static const unsigned MAX_RETRIES = 5;
+	static const unsigned SEGMENTS_PER_ITERATION = 2;
+
+	BulkTransfer();
+	~BulkTransfer();
+
+	/**
+	 * Start a transfer.
+	 *
+	 * @param channel Message channel.
+	 * @param token Token identifying the transfer.
+	 * @param name Name of the transfer.
+	 * @param size Size of the data.
+	 * @param read Callback reading the data. The same range may be read more than once.
+	 * @param data User data passed to the callback.
+	 * @param handler Handler invoked when the server has received all data, or the transfer fails.
+	 * @param millis Current time.
+	 */
+	ProtocolError begin(MessageChannel& channel, token_t token, const char* name, size_t size,
+			bulk_transfer_read_fn read, void* data, CompletionHandler handler, system_tick_t millis);
+
+	/**
+	 * Send the next segments and check the timeouts.
+	 */
+	ProtocolError process(MessageChannel& channel, system_tick_t millis);
+
+	/**
+	 * Handle a reply received from the server.
+	 *
+	 * @return `true` if the reply is the response to the request opening the transfer.
+	 */
+	bool handle_reply(const CoAPMessageView& msg, system_tick_t millis);
+
+	/**
+	 * Handle a `POST /b` request reporting the progress of the transfer.
+	 */
+	ProtocolError handle_ack(Message& message, MessageChannel& channel, system_tick_t millis);
+
+	/**
+	 * Cancel the active transfer.
+	 *
+	 * @param error Result code passed to the completion handler.
+	 * @param channel If not `nullptr`, the server is notified that the transfer is cancelled.
+	 */
+	void cancel(int error, MessageChannel* channel = nullptr);
+
+	bool is_active() const
+	{
+		return state != IDLE;
+	}
+
+	/**
+	 * Number of bytes acknowledged by the server.
+	 */
+	size_t acknowledged() const
+	{
+		return acked;
+	}
+
+private:
+	enum State {
+		IDLE,
+		OPENING,
+		SENDING
+	};
+
+	CompletionHandler handler;
+	bulk_transfer_read_fn read;
+	void* read_data;
+	size_t size;
+	size_t acked; // Offset up to which the data has been acknowledged
+	size_t next; // Offset of the next segment to send
+	size_t segment_size;
+	system_tick_t timer; // Time of the open request or the last progress
+	unsigned window;
+	unsigned retries;
+	message_id_t open_id;
+	token_t token;
+	State state;
+
+	ProtocolError send_segment(MessageChannel& channel, system_tick_t millis);
+	void complete(int error);
+};
+
+}} // namespace particle::protocol
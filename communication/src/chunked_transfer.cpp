@@ -29,6 +29,7 @@ ProtocolError ChunkedTransfer::handle_update_begin(
 {
     uint8_t flags = 0;
     chunk_count = 0;
+    buffered_size = 0;
     int actual_len = message.length();
     uint8_t* queue = message.buf();
     message_id_t msg_id = CoAP::message_id(queue);
@@ -170,27 +171,27 @@ ProtocolError ChunkedTransfer::handle_chunk(token_t token, Message& message,
     {
         payload++;
         const uint8_t* chunk = queue + payload;
-        file.chunk_size = message.length() - payload;
-        file.chunk_address = file.file_address + (chunk_index * chunk_size);
+        const size_t size = message.length() - payload;
         if (chunk_index >= MAX_CHUNKS)
         {
             WARN("invalid chunk index %d", chunk_index);
             return NO_ERROR;
         }
-        uint32_t crc = callbacks->calculate_crc(chunk, file.chunk_size);
+        uint32_t crc = callbacks->calculate_crc(chunk, size);
         uint16_t response_size = 0;
         bool crc_valid = (crc == given_crc);
         DEBUG("chunk idx=%d crc=%d fast=%d updating=%d", chunk_index,
                 crc_valid, fast_ota, updating);
         if (crc_valid)
         {
-            callbacks->save_firmware_chunk(file, chunk, NULL);
+            // the chunk is flagged as received first, since a failed write flags it as missing again
+            flag_chunk_received(chunk_index);
+            save_chunk(chunk, chunk_index, size);
             if (!fast_ota)
             {
                 // message is confirmable for regular OTA or when
                 response_size = Messages::chunk_received(response.buf(), 0, token, ChunkReceivedCode::OK, channel.is_unreliable());
             }
-            flag_chunk_received(chunk_index);
             chunk_index++;
         }
         else
@@ -253,6 +254,10 @@ ProtocolError ChunkedTransfer::handle_update_done(token_t token, Message& messag
     Message response;
 
     DEBUG("update done received");
+    if (is_updating())
+    {
+        flush_chunks();
+    }
     chunk_index_t index = next_chunk_missing(0);
     bool missing = index != NO_CHUNKS_MISSING;
     uint8_t* queue = message.buf();
@@ -336,12 +341,65 @@ ProtocolError ChunkedTransfer::send_missing_chunks(MessageChannel& channel,
 ProtocolError ChunkedTransfer::idle(MessageChannel& channel)
 {
     /* Timeout to resend missing chunks removed.
-     * Leaving idle() here in case we need to add something in the future. */
+     * Buffered chunks are written while there are no more chunks to receive. */
+    flush_chunks();
     return NO_ERROR;
 }
 
+int ChunkedTransfer::save_chunk(const uint8_t* chunk, chunk_index_t index, size_t size)
+{
+    if (buffered_size && (buffered_size % chunk_size ||
+            index != buffered_chunk_index + buffered_size / chunk_size ||
+            buffered_size + size > write_buffer.size()))
+    {
+        flush_chunks();
+    }
+    if (!chunk_size || size > write_buffer.size())
+    {
+        file.chunk_size = size;
+        file.chunk_address = file.file_address + (index * chunk_size);
+        const int result = callbacks->save_firmware_chunk(file, chunk, NULL);
+        if (result)
+        {
+            clear_chunk_received(index);
+        }
+        return result;
+    }
+    if (!buffered_size)
+    {
+        buffered_chunk_index = index;
+    }
+    memcpy(write_buffer.data() + buffered_size, chunk, size);
+    buffered_size += size;
+    return 0;
+}
+
+int ChunkedTransfer::flush_chunks()
+{
+    if (!buffered_size)
+    {
+        return 0;
+    }
+    file.chunk_size = buffered_size;
+    file.chunk_address = file.file_address + (buffered_chunk_index * chunk_size);
+    buffered_size = 0;
+    const int result = callbacks->save_firmware_chunk(file, write_buffer.data(), NULL);
+    if (result)
+    {
+        WARN("failed to save chunks %d-%d", buffered_chunk_index,
+                buffered_chunk_index + (file.chunk_size - 1) / chunk_size);
+        const chunk_index_t end = buffered_chunk_index + (file.chunk_size + chunk_size - 1) / chunk_size;
+        for (chunk_index_t idx = buffered_chunk_index; idx < end; idx++)
+        {
+            clear_chunk_received(idx);
+        }
+    }
+    return result;
+}
+
 void ChunkedTransfer::cancel()
 {
+    buffered_size = 0;
     if (is_updating())
     {
         // was updating but had an error, inform the client
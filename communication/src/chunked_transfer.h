@@ -24,6 +24,7 @@
 #include "message_channel.h"
 #include "system_tick_hal.h"
 #include "messages.h"
+#include <array>
 
 namespace particle
 {
@@ -85,6 +86,15 @@ private:
 
 	uint8_t* bitmap;
 
+	/**
+	 * Received chunks that are not yet written to storage. The buffer holds a run of consecutive
+	 * chunks, which is written in a single operation once the run is broken, the buffer is full,
+	 * or the channel is idle.
+	 */
+	std::array<uint8_t, PROTOCOL_CHUNK_WRITE_BUFFER_SIZE> write_buffer;
+	chunk_index_t buffered_chunk_index;
+	size_t buffered_size;
+
 	Callbacks* callbacks;
 
 	bool fast_ota_override;
@@ -113,12 +123,30 @@ protected:
 		return (chunk_bitmap()[idx >> 3] & uint8_t(1 << (idx & 7)));
 	}
 
+	inline void clear_chunk_received(chunk_index_t idx)
+	{
+		chunk_bitmap()[idx >> 3] &= ~uint8_t(1 << (idx & 7));
+	}
+
+	/**
+	 * Saves a chunk to storage, or adds it to the write buffer.
+	 * @return 0 on success
+	 */
+	int save_chunk(const uint8_t* chunk, chunk_index_t index, size_t size);
+
+	/**
+	 * Writes the buffered chunks to storage. If the write fails, the chunks are flagged as missing.
+	 * @return 0 on success
+	 */
+	int flush_chunks();
+
 	chunk_index_t next_chunk_missing(chunk_index_t start);
 	void set_chunks_received(uint8_t value);
 public:
 
 	ChunkedTransfer() :
-			updating(false), callbacks(nullptr), fast_ota_override(false), fast_ota_value(true)
+			updating(false), bitmap(nullptr), buffered_chunk_index(0), buffered_size(0), callbacks(nullptr),
+			fast_ota_override(false), fast_ota_value(true)
 	{
 	}
 
@@ -131,6 +159,7 @@ public:
 	{
 		reset_updating();
 		bitmap = nullptr;
+		buffered_size = 0;
 		last_chunk_millis = 0;
 	}
 
@@ -103,6 +103,61 @@ size_t CoAP::option_decode(unsigned char **option) {
     return option_length;
 }
 
+const uint8_t* CoAP::find_option(const uint8_t* message, size_t length, CoAPOption::Enum option,
+        size_t* option_length) {
+    if (length < 4) {
+        return nullptr;
+    }
+    CoAPMessageView::OptionIterator it(message + 4 + (message[0] & 0x0f), message + length);
+    while (it.next()) {
+        if (it.number() == (unsigned)option) {
+            if (option_length) {
+                *option_length = it.size();
+            }
+            return it.data();
+        }
+        if (it.number() > (unsigned)option) {
+            break; // Options are sorted by their numbers
+        }
+    }
+    return nullptr;
+}
+
+bool CoAP::decode_block(const uint8_t* value, size_t length, CoAPBlock* block) {
+    if (length > 3) {
+        return false;
+    }
+    uint32_t v = 0;
+    for (size_t i = 0; i < length; ++i) {
+        v = (v << 8) | value[i];
+    }
+    const unsigned szx = v & 0x07;
+    if (szx > CoAPBlock::MAX_SZX) {
+        return false; // Reserved
+    }
+    block->num = v >> 4;
+    block->szx = szx;
+    block->more = v & 0x08;
+    return true;
+}
+
+size_t CoAP::block_option(uint8_t* buf, CoAPOption::Enum previous, CoAPOption::Enum current,
+        const CoAPBlock& block) {
+    const uint32_t v = ((block.num & CoAPBlock::MAX_NUM) << 4) | (block.more ? 0x08 : 0) | (block.szx & 0x07);
+    uint8_t data[3];
+    size_t n = 0;
+    if (v > 0xffff) {
+        data[n++] = v >> 16;
+    }
+    if (v > 0xff) {
+        data[n++] = (v >> 8) & 0xff;
+    }
+    if (v > 0) {
+        data[n++] = v & 0xff;
+    }
+    return add_option(buf, previous, current, data, n);
+}
+
 CoAPCode::Enum CoAP::codeForProtocolError(ProtocolError error) {
     switch (error) {
     case ProtocolError::NO_ERROR:
@@ -119,5 +174,131 @@ CoAPCode::Enum CoAP::codeForProtocolError(ProtocolError error) {
     }
 }
 
+CoAPMessageView::OptionIterator::OptionIterator(const uint8_t* begin, const uint8_t* end) :
+        p_(std::min(begin, end)),
+        end_(end),
+        data_(nullptr),
+        size_(0),
+        number_(0),
+        error_(false) {
+}
+
+bool CoAPMessageView::OptionIterator::next() {
+    if (error_ || p_ >= end_ || *p_ == 0xff) {
+        return false;
+    }
+    const unsigned delta_nibble = *p_ >> 4;
+    const unsigned length_nibble = *p_ & 0x0f;
+    const uint8_t* p = p_ + 1;
+    size_t values[2] = { delta_nibble, length_nibble };
+    for (size_t& v: values) {
+        if (v == 13) {
+            if (end_ - p < 1) {
+                error_ = true;
+                return false;
+            }
+            v = *p++ + 13;
+        } else if (v == 14) {
+            if (end_ - p < 2) {
+                error_ = true;
+                return false;
+            }
+            v = ((p[0] << 8) | p[1]) + 269;
+            p += 2;
+        } else if (v == 15) {
+            error_ = true; // Reserved
+            return false;
+        }
+    }
+    if ((size_t)(end_ - p) < values[1]) {
+        error_ = true;
+        return false;
+    }
+    number_ += values[0];
+    data_ = p;
+    size_ = values[1];
+    p_ = p + values[1];
+    return true;
+}
+
+CoAPMessageView::CoAPMessageView() :
+        buf_(nullptr),
+        options_(nullptr),
+        options_end_(nullptr),
+        first_option_(nullptr),
+        first_option_size_(0),
+        payload_(nullptr),
+        payload_size_(0),
+        token_size_(0),
+        type_(CoAPType::ERROR),
+        code_(CoAPCode::ERROR),
+        id_(0),
+        valid_(false) {
+}
+
+bool CoAPMessageView::parse(const uint8_t* buf, size_t size) {
+    *this = CoAPMessageView();
+    buf_ = buf;
+    if (size < 4) {
+        return false;
+    }
+    type_ = CoAP::type(buf);
+    code_ = CoAP::code(buf);
+    id_ = CoAP::message_id((uint8_t*)buf);
+    const size_t token_size = buf[0] & 0x0f;
+    if (token_size > 8) {
+        return false; // Lengths 9-15 are reserved
+    }
+    if (size < 4 + token_size) {
+        // Some legacy empty messages have a non-zero token length but no token
+        valid_ = true;
+        return true;
+    }
+    token_size_ = token_size;
+    const uint8_t* const end = buf + size;
+    OptionIterator it(buf + 4 + token_size, end);
+    options_ = it.p_;
+    while (it.next()) {
+        if (!first_option_) {
+            first_option_ = it.data();
+            first_option_size_ = it.size();
+        }
+    }
+    if (it.error_) {
+        return false;
+    }
+    options_end_ = it.p_;
+    if (options_end_ < end) {
+        // Skip the payload marker
+        payload_ = options_end_ + 1;
+        payload_size_ = end - payload_;
+    }
+    valid_ = true;
+    return true;
+}
+
+const uint8_t* CoAPMessageView::find_option(CoAPOption::Enum option, size_t* size) const {
+    auto it = options();
+    while (it.next()) {
+        if (it.number() == (unsigned)option) {
+            if (size) {
+                *size = it.size();
+            }
+            return it.data();
+        }
+        if (it.number() > (unsigned)option) {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+const uint8_t* CoAPMessageView::first_option(size_t* size) const {
+    if (size) {
+        *size = first_option_size_;
+    }
+    return first_option_;
+}
+
 }
 }
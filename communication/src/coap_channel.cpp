@@ -26,6 +26,9 @@ namespace particle { namespace protocol {
 
 uint16_t CoAPMessage::message_count = 0;
 
+const system_tick_t RoundTripEstimator::MIN_ACK_TIMEOUT;
+const system_tick_t RoundTripEstimator::MAX_ACK_TIMEOUT;
+
 bool is_ack_or_reset(const uint8_t* buf, size_t len)
 {
 	if (len<1)
@@ -46,7 +49,7 @@ ProtocolError CoAPMessageStore::send_message(CoAPMessage* msg, Channel& channel)
  */
 bool CoAPMessageStore::retransmit(CoAPMessage* msg, Channel& channel, system_tick_t now)
 {
-	bool retransmit = (msg->prepare_retransmit(now));
+	bool retransmit = (msg->prepare_retransmit(now, rtt.ack_timeout()));
 	if (retransmit)
 	{
 		send_message(msg, channel);
@@ -72,7 +75,7 @@ void CoAPMessageStore::process(system_tick_t time, Channel& channel)
 	CoAPMessage* prev = nullptr;
 	while (msg!=nullptr)
 	{
-		if (time_has_passed(time, msg->get_timeout()) && !retransmit(msg, channel, time))
+		if (!msg->is_queued() && time_has_passed(time, msg->get_timeout()) && !retransmit(msg, channel, time))
 		{
 			remove(msg, prev);
 			message_timeout(*msg, channel);
@@ -85,14 +88,49 @@ void CoAPMessageStore::process(system_tick_t time, Channel& channel)
 			msg = msg->get_next();
 		}
 	}
+	send_queued(time, channel);
 }
 
 
+unsigned CoAPMessageStore::in_flight() const
+{
+	unsigned count = 0;
+	for (const CoAPMessage* msg = head; msg != nullptr; msg = msg->get_next()) {
+		if (msg->is_in_flight())
+			count++;
+	}
+	return count;
+}
+
+void CoAPMessageStore::send_queued(system_tick_t time, Channel& channel)
+{
+	unsigned count = in_flight();
+	while (count < nstart)
+	{
+		// messages are stored most recent first, so the last queued message is the oldest one
+		CoAPMessage* next = nullptr;
+		for (CoAPMessage* msg = head; msg != nullptr; msg = msg->get_next()) {
+			if (msg->is_queued())
+				next = msg;
+		}
+		if (!next)
+			break;
+		next->prepare_retransmit(time, rtt.ack_timeout());
+		send_message(next, channel);
+		count++;
+	}
+}
+
 /**
  * Registers that this message has been sent from the application.
  * Confirmable messages, and ack/reset responses are cached.
  */
 ProtocolError CoAPMessageStore::send(Message& msg, system_tick_t time)
+{
+	return send(msg, time, nullptr, 0);
+}
+
+ProtocolError CoAPMessageStore::send(Message& msg, system_tick_t time, const MessageSegment* segments, size_t count)
 {
 	if (!msg.has_id())
 		return MISSING_MESSAGE_ID;
@@ -102,11 +140,15 @@ ProtocolError CoAPMessageStore::send(Message& msg, system_tick_t time)
 	if (coapType==CoAPType::CON || coapType==CoAPType::ACK || coapType==CoAPType::RESET)
 	{
 		// confirmable message, create a CoAPMessage for this
-		CoAPMessage* coapmsg = CoAPMessage::create(msg);
+		CoAPMessage* coapmsg = count ? CoAPMessage::create(msg, segments, count) : CoAPMessage::create(msg);
 		if (coapmsg==nullptr)
 			return INSUFFICIENT_STORAGE;
 		if (coapType==CoAPType::CON)
-			coapmsg->prepare_retransmit(time);
+		{
+			// synchronous messages are never queued since the caller waits for the acknowledgement
+			if (msg.get_confirm_received() || in_flight() < nstart)
+				coapmsg->prepare_retransmit(time, rtt.ack_timeout());
+		}
 		else
 			coapmsg->set_expiration(time+CoAPMessage::MAX_TRANSMIT_SPAN);
 		add(*coapmsg);
@@ -135,6 +177,15 @@ ProtocolError CoAPMessageStore::receive(Message& msg, Channel& channel, system_t
 			channel.command(Channel::DISCARD_SESSION, nullptr);
 		}
 		DEBUG("recieved ACK for message id=%x", id);
+		if (msgtype==CoAPType::ACK) {
+			// only messages that were not retransmitted give an unambiguous round-trip time (Karn's algorithm)
+			const CoAPMessage* sent = from_id(id);
+			if (sent && sent->get_type()==CoAPType::CON && sent->get_transmit_count()==1) {
+				const system_tick_t t = time - sent->get_transmit_time();
+				rtt.sample(t);
+				g_coapRoundTripTimeHistogram.add(t);
+			}
+		}
 		if (!clear_message(id)) {		// message didn't exist, means it's already been acknoweldged or is unknown.
 			msg.set_length(0);
 		}
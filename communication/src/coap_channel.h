@@ -23,6 +23,7 @@
 #include "timer_hal.h"
 #include "stdlib.h"
 #include "service_debug.h"
+#include "trace.h"
 
 namespace particle
 {
@@ -39,6 +40,7 @@ template <typename T>
 class CoAPChannel : public T
 {
 	message_id_t message_id;
+	unsigned sent_count;
 	using base = T;
 
 protected:
@@ -49,7 +51,7 @@ protected:
 	}
 
 public:
-	CoAPChannel(message_id_t msg_seed=0) : message_id(msg_seed)
+	CoAPChannel(message_id_t msg_seed=0) : message_id(msg_seed), sent_count(0)
 	{
 	}
 
@@ -79,8 +81,37 @@ public:
 			buf[2] = id >> 8;
 			buf[3] = id & 0xFF;
 			msg.decode_id();
+			PARTICLE_TRACE(TRACE_EVENT_COAP_SEND, id);
 		}
-		return base::send(msg);
+		const ProtocolError error = base::send(msg);
+		if (error == NO_ERROR)
+		{
+			++sent_count;
+		}
+		return error;
+	}
+
+	ProtocolError send_segments(Message& msg, const MessageSegment* segments, size_t count) override
+	{
+		if (msg.length()>=4)
+		{
+			const message_id_t id = msg.has_id() ? msg.get_id() : next_message_id();
+			uint8_t* buf = msg.buf();
+			buf[2] = id >> 8;
+			buf[3] = id & 0xFF;
+			msg.decode_id();
+		}
+		const ProtocolError error = base::send_segments(msg, segments, count);
+		if (error == NO_ERROR)
+		{
+			++sent_count;
+		}
+		return error;
+	}
+
+	unsigned sent_message_count() const override
+	{
+		return sent_count;
 	}
 };
 
@@ -112,6 +143,11 @@ private:
 	 */
 	system_tick_t timeout;
 
+	/**
+	 * The time when this message was first transmitted.
+	 */
+	system_tick_t transmit_time;
+
 	/**
 	 * The unique 16-bit ID for this message.
 	 */
@@ -159,12 +195,12 @@ public:
 
 
 	/**
-	 * The number of outstanding messages allowed.
+	 * The default number of outstanding messages allowed.
 	 */
-	static const uint8_t NSTART = 1;
+	static const uint8_t NSTART = PROTOCOL_COAP_NSTART;
 
 
-	CoAPMessage(message_id_t id_) : next(nullptr), timeout(0), id(id_), transmit_count(0), delivered(nullptr), data_len(0) {
+	CoAPMessage(message_id_t id_) : next(nullptr), timeout(0), transmit_time(0), id(id_), transmit_count(0), delivered(nullptr), data_len(0) {
 		message_count++;
 	}
 
@@ -185,6 +221,25 @@ public:
 		return nullptr;
 	}
 
+	/**
+	 * Create a new CoAPMessage from the given Message instance, followed by the data of the given segments.
+	 */
+	static CoAPMessage* create(Message& msg, const MessageSegment* segments, size_t count)
+	{
+		const size_t len = msg.length() + message_segments_size(segments, count);
+		if (len>1500)
+			return nullptr;
+		uint8_t* memory = new uint8_t[sizeof(CoAPMessage)+len];
+		if (memory) {
+			CoAPMessage* coapmsg = new (memory)CoAPMessage(msg.get_id());		// in-place new
+			memcpy(coapmsg->data, msg.buf(), msg.length());
+			copy_message_segments(coapmsg->data + msg.length(), segments, count);
+			coapmsg->data_len = len;
+			return coapmsg;
+		}
+		return nullptr;
+	}
+
 	~CoAPMessage()
 	{
 		message_count--;
@@ -198,6 +253,21 @@ public:
 	inline message_id_t get_id() const { return id; }
 	inline void removed() { next = nullptr; }
 	inline system_tick_t get_timeout() const { return timeout; }
+	inline system_tick_t get_transmit_time() const { return transmit_time; }
+	inline uint8_t get_transmit_count() const { return transmit_count; }
+
+	/**
+	 * Returns true if this is a confirmable message that is waiting to be transmitted for the first time.
+	 */
+	inline bool is_queued() const { return transmit_count==0 && get_type()==CoAPType::CON; }
+
+	/**
+	 * Returns true if this is a confirmable message that has been transmitted and is awaiting acknowledgement.
+	 */
+	inline bool is_in_flight() const
+	{
+		return transmit_count>0 && transmit_count<=MAX_RETRANSMIT+1 && get_type()==CoAPType::CON;
+	}
 
 	inline void set_delivered_handler(std::function<void(Delivery)>* handler) { this->delivered = handler; }
 
@@ -215,13 +285,16 @@ public:
 
 	/**
 	 * Prepares to retransmit this message after a timeout.
+	 * @param ack_timeout The initial acknowledgement timeout.
 	 * @return false if the message cannot be retransmitted.
 	 */
-	bool prepare_retransmit(system_tick_t now)
+	bool prepare_retransmit(system_tick_t now, system_tick_t ack_timeout = ACK_TIMEOUT)
 	{
 		CoAPType::Enum coapType = CoAP::type(get_data());
 		if (coapType==CoAPType::CON) {
-			timeout = now + transmit_timeout(transmit_count);
+			if (!transmit_count)
+				transmit_time = now;
+			timeout = now + transmit_timeout(transmit_count, ack_timeout);
 			transmit_count++;
 			return transmit_count <= MAX_RETRANSMIT+1;
 		}
@@ -232,9 +305,9 @@ public:
 	/**
 	 * Determines the transmit timeout for the given transmission count.
 	 */
-	static inline system_tick_t transmit_timeout(uint8_t transmit_count)
+	static inline system_tick_t transmit_timeout(uint8_t transmit_count, system_tick_t ack_timeout = ACK_TIMEOUT)
 	{
-		system_tick_t timeout = (ACK_TIMEOUT << transmit_count);
+		system_tick_t timeout = (ack_timeout << transmit_count);
 		timeout += ((timeout * (rand()%256))>>9);
 		return timeout;
 	}
@@ -296,6 +369,64 @@ inline bool time_has_passed(system_tick_t now, system_tick_t tick)
 /**
  * A mix-in class that provides message resending for reliable delivery of messages.
  */
+/**
+ * Estimates the round-trip time of a channel as described in RFC 6298, and derives the initial
+ * acknowledgement timeout for confirmable messages from it.
+ */
+class RoundTripEstimator
+{
+	system_tick_t srtt;
+	system_tick_t rttvar;
+	system_tick_t ack_timeout_;
+
+public:
+	static const system_tick_t MIN_ACK_TIMEOUT = 1000;
+	static const system_tick_t MAX_ACK_TIMEOUT = 8000;
+
+	RoundTripEstimator()
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		srtt = 0;
+		rttvar = 0;
+		ack_timeout_ = CoAPMessage::ACK_TIMEOUT;
+	}
+
+	/**
+	 * Updates the estimate with a round-trip time measured for a message that was not retransmitted.
+	 */
+	void sample(system_tick_t rtt)
+	{
+		if (!srtt)
+		{
+			srtt = rtt ? rtt : 1;
+			rttvar = rtt / 2;
+		}
+		else
+		{
+			const system_tick_t delta = (srtt > rtt) ? srtt - rtt : rtt - srtt;
+			rttvar = (3 * rttvar + delta) / 4;
+			srtt = (7 * srtt + rtt) / 8;
+		}
+		system_tick_t timeout = srtt + 4 * rttvar;
+		if (timeout < MIN_ACK_TIMEOUT)
+			timeout = MIN_ACK_TIMEOUT;
+		else if (timeout > MAX_ACK_TIMEOUT)
+			timeout = MAX_ACK_TIMEOUT;
+		ack_timeout_ = timeout;
+	}
+
+	/**
+	 * Returns the smoothed round-trip time, or 0 if no round-trip time has been measured.
+	 */
+	system_tick_t smoothed_rtt() const { return srtt; }
+
+	system_tick_t ack_timeout() const { return ack_timeout_; }
+};
+
 class CoAPMessageStore
 {
 	LOG_CATEGORY("comm.coap");
@@ -305,6 +436,16 @@ class CoAPMessageStore
 	 */
 	CoAPMessage* head;
 
+	/**
+	 * The round-trip time estimate used to determine the retransmission timeouts.
+	 */
+	RoundTripEstimator rtt;
+
+	/**
+	 * The maximum number of confirmable messages in flight.
+	 */
+	uint8_t nstart;
+
 	/**
 	 * Retrieves the message with the given ID and the previous message.
 	 * If no message exists with the given id, nullptr is returned.
@@ -339,7 +480,7 @@ class CoAPMessageStore
 
 public:
 
-	CoAPMessageStore() : head(nullptr) {}
+	CoAPMessageStore() : head(nullptr), nstart(CoAPMessage::NSTART) {}
 
 	~CoAPMessageStore() {
 		clear();
@@ -423,15 +564,59 @@ public:
 
 	/**
 	 * Registers that this message has been sent from the application.
-	 * Confirmable messages, and ack/reset responses are cached.
+	 * Confirmable messages, and ack/reset responses are cached. A confirmable message is queued
+	 * rather than transmitted if NSTART messages are already in flight, unless it is sent synchronously.
+	 * Use is_queued() to determine if the message should be passed to the channel.
 	 */
 	ProtocolError send(Message& msg, system_tick_t time);
 
+	/**
+	 * Registers that this message, followed by the given segments, has been sent from the application.
+	 */
+	ProtocolError send(Message& msg, system_tick_t time, const MessageSegment* segments, size_t count);
+
 	/**
 	 * Notifies the message store that a message has been received.
 	 */
 	ProtocolError receive(Message& msg, Channel& channel, system_tick_t time);
 
+	const RoundTripEstimator& round_trip() const
+	{
+		return rtt;
+	}
+
+	/**
+	 * Sets the maximum number of confirmable messages that can await acknowledgement at the same time.
+	 */
+	void set_nstart(uint8_t nstart)
+	{
+		this->nstart = nstart ? nstart : 1;
+	}
+
+	uint8_t get_nstart() const
+	{
+		return nstart;
+	}
+
+	/**
+	 * Returns the number of confirmable messages awaiting acknowledgement.
+	 */
+	unsigned in_flight() const;
+
+	/**
+	 * Returns true if the message with the given ID is waiting for a free slot in the in-flight window.
+	 */
+	bool is_queued(message_id_t id) const
+	{
+		const CoAPMessage* msg = from_id(id);
+		return msg && msg->is_queued();
+	}
+
+	/**
+	 * Transmits queued messages while the number of messages in flight is less than NSTART.
+	 */
+	void send_queued(system_tick_t time, Channel& channel);
+
 	bool clear_message(message_id_t id)
 	{
 		CoAPMessage* msg = remove(id);
@@ -537,6 +722,14 @@ public:
 		return server;
 	}
 
+	/**
+	 * Sets the maximum number of confirmable messages that can await acknowledgement at the same time.
+	 */
+	void set_nstart(uint8_t nstart) {
+		client.set_nstart(nstart);
+		server.set_nstart(nstart);
+	}
+
 	/**
 	 * Clear the message stores when the channel is initially established.
 	 */
@@ -563,11 +756,31 @@ public:
 		// determine the type of message.
 		CoAPMessageStore& store = msg.is_request() ? client : server;
 		ProtocolError error = store.send(msg, millis());
-		if (!error)
+		if (!error && !store.is_queued(msg.get_id()))
 			error = channel::send(msg);
 		return error;
 	}
 
+	/**
+	 * Sends the message followed by the given segments. Cached messages are stored with
+	 * their segments so that they can be retransmitted.
+	 */
+	ProtocolError send_segments(Message& msg, const MessageSegment* segments, size_t count) override
+	{
+		if (msg.send_direct() || (msg.is_request() && msg.get_confirm_received()))
+		{
+			if (!msg.append(segments, count))
+				return INSUFFICIENT_STORAGE;
+			return CoAPReliableChannel::send(msg);
+		}
+
+		CoAPMessageStore& store = msg.is_request() ? client : server;
+		ProtocolError error = store.send(msg, millis(), segments, count);
+		if (!error && !store.is_queued(msg.get_id()))
+			error = channel::send_segments(msg, segments, count);
+		return error;
+	}
+
 	/**
 	 * Receives a message from the channel and passes it to the message store for processing before
 	 * passing on to the application.
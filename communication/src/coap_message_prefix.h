@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "coap.h"
+
+#include <cstring>
+
+namespace particle { namespace protocol {
+
+namespace detail {
+
+template<size_t N>
+struct CoAPPrefixData {
+	uint8_t data[N];
+};
+
+constexpr size_t coap_prefix_size(size_t token_size, size_t path_size, bool payload_marker)
+{
+	return 4 + token_size + (path_size ? 1 + path_size : 0) + (payload_marker ? 1 : 0);
+}
+
+template<CoAPType::Enum TYPE, CoAPCode::Enum CODE, size_t TOKEN_SIZE, bool PAYLOAD_MARKER, char... PATH>
+constexpr CoAPPrefixData<coap_prefix_size(TOKEN_SIZE, sizeof...(PATH), PAYLOAD_MARKER)> make_coap_prefix()
+{
+	CoAPPrefixData<coap_prefix_size(TOKEN_SIZE, sizeof...(PATH), PAYLOAD_MARKER)> d = {};
+	const char path[] = { PATH..., '\0' };
+	size_t n = 0;
+	d.data[n++] = (CoAP::VERSION << 6) | (TYPE << 4) | TOKEN_SIZE;
+	d.data[n++] = CODE;
+	n += 2 + TOKEN_SIZE; // Message ID and token
+	if (sizeof...(PATH)) {
+		d.data[n++] = (CoAPOption::URI_PATH << 4) | sizeof...(PATH);
+		for (size_t i = 0; i < sizeof...(PATH); ++i) {
+			d.data[n++] = path[i];
+		}
+	}
+	if (PAYLOAD_MARKER) {
+		d.data[n++] = 0xff;
+	}
+	return d;
+}
+
+} // namespace detail
+
+/**
+ * Constant leading part of a CoAP message, encoded at compile time.
+ *
+ * The prefix consists of the header, a placeholder for a token of `TOKEN_SIZE` bytes (0 or 1),
+ * an optional Uri-Path option with the characters in `PATH`, and an optional payload marker.
+ * Encoding a message copies the prefix and patches the message ID and token.
+ */
+template<CoAPType::Enum TYPE, CoAPCode::Enum CODE, size_t TOKEN_SIZE, bool PAYLOAD_MARKER, char... PATH>
+class CoAPMessagePrefix
+{
+public:
+	static_assert(TOKEN_SIZE <= sizeof(token_t), "Unsupported token size");
+	static_assert(sizeof...(PATH) <= 12, "Uri-Path is too long");
+
+	static constexpr size_t SIZE = detail::coap_prefix_size(TOKEN_SIZE, sizeof...(PATH), PAYLOAD_MARKER);
+
+	static size_t encode(uint8_t* buf, message_id_t id, token_t token = 0)
+	{
+		memcpy(buf, PREFIX.data, SIZE);
+		buf[2] = id >> 8;
+		buf[3] = id & 0xff;
+		if (TOKEN_SIZE) {
+			buf[4] = token;
+		}
+		return SIZE;
+	}
+
+	static const uint8_t* data()
+	{
+		return PREFIX.data;
+	}
+
+private:
+	static constexpr detail::CoAPPrefixData<SIZE> PREFIX =
+			detail::make_coap_prefix<TYPE, CODE, TOKEN_SIZE, PAYLOAD_MARKER, PATH...>();
+};
+
+template<CoAPType::Enum TYPE, CoAPCode::Enum CODE, size_t TOKEN_SIZE, bool PAYLOAD_MARKER, char... PATH>
+constexpr detail::CoAPPrefixData<CoAPMessagePrefix<TYPE, CODE, TOKEN_SIZE, PAYLOAD_MARKER, PATH...>::SIZE>
+		CoAPMessagePrefix<TYPE, CODE, TOKEN_SIZE, PAYLOAD_MARKER, PATH...>::PREFIX;
+
+template<CoAPType::Enum TYPE, CoAPCode::Enum CODE, size_t TOKEN_SIZE, bool PAYLOAD_MARKER, char... PATH>
+constexpr size_t CoAPMessagePrefix<TYPE, CODE, TOKEN_SIZE, PAYLOAD_MARKER, PATH...>::SIZE;
+
+/**
+ * Encodes the confirmable or non-confirmable variant of a message prefix.
+ */
+template<template<CoAPType::Enum> class PrefixT>
+inline size_t encode_prefix(uint8_t* buf, bool confirmable, message_id_t id, token_t token = 0)
+{
+	return confirmable ? PrefixT<CoAPType::CON>::encode(buf, id, token) :
+			PrefixT<CoAPType::NON>::encode(buf, id, token);
+}
+
+}} // namespace particle::protocol
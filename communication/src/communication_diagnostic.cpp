@@ -1,4 +1,54 @@
 #include "communication_diagnostic.h"
 
-particle::SimpleIntegerDiagnosticData g_rateLimitedEventsCounter(DIAG_ID_CLOUD_RATE_LIMITED_EVENTS, DIAG_NAME_CLOUD_RATE_LIMITED_EVENTS);
-particle::SimpleIntegerDiagnosticData g_unacknowledgedMessageCounter(DIAG_ID_CLOUD_UNACKNOWLEDGED_MESSAGES, DIAG_NAME_CLOUD_UNACKNOWLEDGED_MESSAGES);
+#include "protocol_defs.h"
+
+particle::CounterDiagnosticData g_rateLimitedEventsCounter(DIAG_ID_CLOUD_RATE_LIMITED_EVENTS, DIAG_NAME_CLOUD_RATE_LIMITED_EVENTS);
+particle::CounterDiagnosticData g_unacknowledgedMessageCounter(DIAG_ID_CLOUD_UNACKNOWLEDGED_MESSAGES, DIAG_NAME_CLOUD_UNACKNOWLEDGED_MESSAGES);
+particle::SimpleIntegerDiagnosticData g_eventTokensCounter(DIAG_ID_CLOUD_EVENT_TOKENS, DIAG_NAME_CLOUD_EVENT_TOKENS, particle::protocol::APPLICATION_EVENT_BURST);
+particle::SimpleIntegerDiagnosticData g_deferredEventsCounter(DIAG_ID_CLOUD_DEFERRED_EVENTS, DIAG_NAME_CLOUD_DEFERRED_EVENTS);
+particle::CounterDiagnosticData g_expiredEventsCounter(DIAG_ID_CLOUD_EXPIRED_EVENTS, DIAG_NAME_CLOUD_EXPIRED_EVENTS);
+particle::CounterDiagnosticData g_resumedSessionsCounter(DIAG_ID_CLOUD_RESUMED_SESSIONS, DIAG_NAME_CLOUD_RESUMED_SESSIONS);
+particle::CounterDiagnosticData g_fullHandshakesCounter(DIAG_ID_CLOUD_FULL_HANDSHAKES, DIAG_NAME_CLOUD_FULL_HANDSHAKES);
+particle::SimpleHistogramDiagnosticData g_coapRoundTripTimeHistogram(DIAG_ID_CLOUD_COAP_ROUND_TRIP_TIME, DIAG_NAME_CLOUD_COAP_ROUND_TRIP_TIME);
+particle::SimpleHistogramDiagnosticData g_handshakeTimeHistogram(DIAG_ID_CLOUD_HANDSHAKE_TIME, DIAG_NAME_CLOUD_HANDSHAKE_TIME);
+particle::SimpleHistogramDiagnosticData g_publishTimeHistogram(DIAG_ID_CLOUD_PUBLISH_TIME, DIAG_NAME_CLOUD_PUBLISH_TIME);
+particle::CounterDiagnosticData g_cloudBytesSentCounter(DIAG_ID_CLOUD_BYTES_SENT, DIAG_NAME_CLOUD_BYTES_SENT);
+particle::CounterDiagnosticData g_cloudBytesReceivedCounter(DIAG_ID_CLOUD_BYTES_RECEIVED, DIAG_NAME_CLOUD_BYTES_RECEIVED);
+particle::CounterDiagnosticData g_cloudEventBytesSentCounter(DIAG_ID_CLOUD_EVENT_BYTES_SENT, DIAG_NAME_CLOUD_EVENT_BYTES_SENT);
+particle::CounterDiagnosticData g_cloudFunctionBytesSentCounter(DIAG_ID_CLOUD_FUNCTION_BYTES_SENT, DIAG_NAME_CLOUD_FUNCTION_BYTES_SENT);
+particle::CounterDiagnosticData g_cloudVariableBytesSentCounter(DIAG_ID_CLOUD_VARIABLE_BYTES_SENT, DIAG_NAME_CLOUD_VARIABLE_BYTES_SENT);
+particle::CounterDiagnosticData g_cloudDescribeBytesSentCounter(DIAG_ID_CLOUD_DESCRIBE_BYTES_SENT, DIAG_NAME_CLOUD_DESCRIBE_BYTES_SENT);
+particle::CounterDiagnosticData g_cloudPingBytesSentCounter(DIAG_ID_CLOUD_PING_BYTES_SENT, DIAG_NAME_CLOUD_PING_BYTES_SENT);
+particle::CounterDiagnosticData g_cloudOtaBytesSentCounter(DIAG_ID_CLOUD_OTA_BYTES_SENT, DIAG_NAME_CLOUD_OTA_BYTES_SENT);
+particle::CounterDiagnosticData g_cloudHandshakeBytesSentCounter(DIAG_ID_CLOUD_HANDSHAKE_BYTES_SENT, DIAG_NAME_CLOUD_HANDSHAKE_BYTES_SENT);
+particle::CounterDiagnosticData g_cloudOtherBytesSentCounter(DIAG_ID_CLOUD_OTHER_BYTES_SENT, DIAG_NAME_CLOUD_OTHER_BYTES_SENT);
+particle::CounterDiagnosticData g_cloudEventBytesReceivedCounter(DIAG_ID_CLOUD_EVENT_BYTES_RECEIVED, DIAG_NAME_CLOUD_EVENT_BYTES_RECEIVED);
+particle::CounterDiagnosticData g_cloudFunctionBytesReceivedCounter(DIAG_ID_CLOUD_FUNCTION_BYTES_RECEIVED, DIAG_NAME_CLOUD_FUNCTION_BYTES_RECEIVED);
+particle::CounterDiagnosticData g_cloudVariableBytesReceivedCounter(DIAG_ID_CLOUD_VARIABLE_BYTES_RECEIVED, DIAG_NAME_CLOUD_VARIABLE_BYTES_RECEIVED);
+particle::CounterDiagnosticData g_cloudDescribeBytesReceivedCounter(DIAG_ID_CLOUD_DESCRIBE_BYTES_RECEIVED, DIAG_NAME_CLOUD_DESCRIBE_BYTES_RECEIVED);
+particle::CounterDiagnosticData g_cloudPingBytesReceivedCounter(DIAG_ID_CLOUD_PING_BYTES_RECEIVED, DIAG_NAME_CLOUD_PING_BYTES_RECEIVED);
+particle::CounterDiagnosticData g_cloudOtaBytesReceivedCounter(DIAG_ID_CLOUD_OTA_BYTES_RECEIVED, DIAG_NAME_CLOUD_OTA_BYTES_RECEIVED);
+particle::CounterDiagnosticData g_cloudHandshakeBytesReceivedCounter(DIAG_ID_CLOUD_HANDSHAKE_BYTES_RECEIVED, DIAG_NAME_CLOUD_HANDSHAKE_BYTES_RECEIVED);
+particle::CounterDiagnosticData g_cloudOtherBytesReceivedCounter(DIAG_ID_CLOUD_OTHER_BYTES_RECEIVED, DIAG_NAME_CLOUD_OTHER_BYTES_RECEIVED);
+
+particle::CounterDiagnosticData* const g_cloudBytesSentByClass[particle::protocol::TrafficClass::COUNT] = {
+	&g_cloudEventBytesSentCounter,
+	&g_cloudFunctionBytesSentCounter,
+	&g_cloudVariableBytesSentCounter,
+	&g_cloudDescribeBytesSentCounter,
+	&g_cloudPingBytesSentCounter,
+	&g_cloudOtaBytesSentCounter,
+	&g_cloudHandshakeBytesSentCounter,
+	&g_cloudOtherBytesSentCounter
+};
+
+particle::CounterDiagnosticData* const g_cloudBytesReceivedByClass[particle::protocol::TrafficClass::COUNT] = {
+	&g_cloudEventBytesReceivedCounter,
+	&g_cloudFunctionBytesReceivedCounter,
+	&g_cloudVariableBytesReceivedCounter,
+	&g_cloudDescribeBytesReceivedCounter,
+	&g_cloudPingBytesReceivedCounter,
+	&g_cloudOtaBytesReceivedCounter,
+	&g_cloudHandshakeBytesReceivedCounter,
+	&g_cloudOtherBytesReceivedCounter
+};
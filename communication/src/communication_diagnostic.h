@@ -1,4 +1,18 @@
 #include "spark_wiring_diagnostics.h"
+#include "traffic_accounting.h"
 
-extern particle::SimpleIntegerDiagnosticData g_rateLimitedEventsCounter;
-extern particle::SimpleIntegerDiagnosticData g_unacknowledgedMessageCounter;
+extern particle::CounterDiagnosticData g_rateLimitedEventsCounter;
+extern particle::CounterDiagnosticData g_unacknowledgedMessageCounter;
+extern particle::SimpleIntegerDiagnosticData g_eventTokensCounter;
+extern particle::SimpleIntegerDiagnosticData g_deferredEventsCounter;
+extern particle::CounterDiagnosticData g_expiredEventsCounter; // Deferred events dropped because of their deadline
+extern particle::CounterDiagnosticData g_resumedSessionsCounter;
+extern particle::CounterDiagnosticData g_fullHandshakesCounter;
+extern particle::SimpleHistogramDiagnosticData g_coapRoundTripTimeHistogram; // Milliseconds
+extern particle::SimpleHistogramDiagnosticData g_handshakeTimeHistogram; // Milliseconds
+extern particle::SimpleHistogramDiagnosticData g_publishTimeHistogram; // Milliseconds
+extern particle::CounterDiagnosticData g_cloudBytesSentCounter; // Including the TLS/DTLS record overhead
+extern particle::CounterDiagnosticData g_cloudBytesReceivedCounter; // Including the TLS/DTLS record overhead
+// Bytes sent and received for each class of messages, indexed by particle::protocol::TrafficClass
+extern particle::CounterDiagnosticData* const g_cloudBytesSentByClass[particle::protocol::TrafficClass::COUNT];
+extern particle::CounterDiagnosticData* const g_cloudBytesReceivedByClass[particle::protocol::TrafficClass::COUNT];
@@ -25,12 +25,14 @@ LOG_SOURCE_CATEGORY("comm.dtls")
 #if HAL_PLATFORM_CLOUD_UDP
 
 #include "protocol.h"
+#include "communication_diagnostic.h"
 #include "rng_hal.h"
 #include "mbedtls/error.h"
 #include "mbedtls/ssl_internal.h"
 #include "mbedtls_util.h"
 #include "mbedtls/version.h"
 #include "timer_hal.h"
+#include "trace.h"
 #include <stdio.h>
 #include <string.h>
 #include "dtls_session_persist.h"
@@ -274,6 +276,8 @@ int DTLSMessageChannel::send_(void *ctx, const unsigned char *buf, size_t len )
 	int count = channel->send(buf, len);
 	if (count == 0)
 		return MBEDTLS_ERR_SSL_WANT_WRITE;
+	if (count > 0)
+		g_cloudBytesSentCounter += count;
 
 	return count;
 }
@@ -286,6 +290,8 @@ int DTLSMessageChannel::recv_( void *ctx, unsigned char *buf, size_t len ) {
 		// 0 means no more data available yet
 		return MBEDTLS_ERR_SSL_WANT_READ;
 	}
+	if (count > 0)
+		g_cloudBytesReceivedCounter += count;
 	return count;
 }
 
@@ -371,6 +377,7 @@ ProtocolError DTLSMessageChannel::establish(uint32_t& flags, uint32_t app_state_
 			flags |= Protocol::SKIP_SESSION_RESUME_HELLO;
 		}
 		LOG(INFO,"restored session from persisted session data. next_msg_id=%d", *coap_state);
+		g_resumedSessionsCounter++;
 		return SESSION_RESUMED;
 	}
 	else if (restoreStatus==SessionPersist::RENEGOTIATE)
@@ -384,6 +391,10 @@ ProtocolError DTLSMessageChannel::establish(uint32_t& flags, uint32_t app_state_
 		if (error)
 			return error;
 	}
+	g_fullHandshakesCounter++;
+	const system_tick_t handshake_start = callbacks.millis();
+	const unsigned handshake_bytes_sent = g_cloudBytesSentCounter;
+	const unsigned handshake_bytes_received = g_cloudBytesReceivedCounter;
 	uint8_t random[64];
 
 	do
@@ -406,6 +417,9 @@ ProtocolError DTLSMessageChannel::establish(uint32_t& flags, uint32_t app_state_
 	while(ret == MBEDTLS_ERR_SSL_WANT_READ ||
 	      ret == MBEDTLS_ERR_SSL_WANT_WRITE);
 
+	traffic.reset();
+	traffic.handshake(g_cloudBytesSentCounter - handshake_bytes_sent,
+			g_cloudBytesReceivedCounter - handshake_bytes_received);
 	if (ret)
 	{
 		LOG(ERROR,"handshake failed -%x", -ret);
@@ -413,6 +427,7 @@ ProtocolError DTLSMessageChannel::establish(uint32_t& flags, uint32_t app_state_
 	}
 	else
 	{
+		g_handshakeTimeHistogram.add(callbacks.millis() - handshake_start);
 		sessionPersist.prepare_save(random, keys_checksum, &ssl_context, 0);
 	}
 	return ret==0 ? NO_ERROR : IO_ERROR_GENERIC_ESTABLISH;
@@ -435,7 +450,13 @@ ProtocolError DTLSMessageChannel::receive(Message& message)
 	size_t len = message.capacity();
 
 	conf.read_timeout = 0;
+	const unsigned bytes_received = g_cloudBytesReceivedCounter;
+	PARTICLE_TRACE(TRACE_EVENT_DTLS_RECEIVE_BEGIN, len);
 	int ret = mbedtls_ssl_read(&ssl_context, buf, len);
+	PARTICLE_TRACE(TRACE_EVENT_DTLS_RECEIVE_END, ret);
+	const unsigned record_size = (unsigned)g_cloudBytesReceivedCounter - bytes_received;
+	if (record_size)
+		traffic.received(buf, ret > 0 ? ret : 0, record_size);
 	if (ret<0) {
 		switch (ret) {
 		case MBEDTLS_ERR_SSL_WANT_READ:
@@ -509,7 +530,11 @@ ProtocolError DTLSMessageChannel::send(Message& message)
       LOG_PRINT(TRACE, "\r\n");
 #endif
 
+  const unsigned bytes_sent = g_cloudBytesSentCounter;
+  PARTICLE_TRACE(TRACE_EVENT_DTLS_SEND_BEGIN, message.length());
   int ret = mbedtls_ssl_write(&ssl_context, message.buf(), message.length());
+  PARTICLE_TRACE(TRACE_EVENT_DTLS_SEND_END, ret);
+  traffic.sent(message.buf(), message.length(), g_cloudBytesSentCounter - bytes_sent);
   if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
   {
 	  LOG(WARN, "mbedtls_ssl_write returned %x", ret);
@@ -520,6 +545,50 @@ ProtocolError DTLSMessageChannel::send(Message& message)
   return NO_ERROR;
 }
 
+ProtocolError DTLSMessageChannel::send_segments(Message& message, const MessageSegment* segments, size_t count)
+{
+  if (ssl_context.state != MBEDTLS_SSL_HANDSHAKE_OVER)
+    return INVALID_STATE;
+
+#ifdef MBEDTLS_SSL_OUT_CONTENT_LEN
+  const size_t max_len = MBEDTLS_SSL_OUT_CONTENT_LEN;
+#else
+  const size_t max_len = MBEDTLS_SSL_MAX_CONTENT_LEN;
+#endif
+  const size_t len = message.length() + message_segments_size(segments, count);
+#if !defined(MBEDTLS_SSL_RENEGOTIATION) && !defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+  // mbedtls_ssl_write() copies the plaintext to the record buffer and encrypts it in place;
+  // do the same here, but gather the segments without flattening them into the message first
+  if (!message.send_direct() && ssl_context.out_left == 0 && len <= max_len)
+  {
+	  uint8_t* out = ssl_context.out_msg;
+	  memcpy(out, message.buf(), message.length());
+	  copy_message_segments(out + message.length(), segments, count);
+	  ssl_context.out_msglen = len;
+	  ssl_context.out_msgtype = MBEDTLS_SSL_MSG_APPLICATION_DATA;
+	  const unsigned bytes_sent = g_cloudBytesSentCounter;
+#if MBEDTLS_VERSION_NUMBER >= 0x020D0000
+	  int ret = mbedtls_ssl_write_record(&ssl_context, 1 /* force flush */);
+#else
+	  int ret = mbedtls_ssl_write_record(&ssl_context);
+#endif
+	  traffic.sent(message.buf(), message.length(), g_cloudBytesSentCounter - bytes_sent);
+	  if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+	  {
+		  LOG(WARN, "mbedtls_ssl_write_record returned %x", ret);
+		  reset_session();
+		  return IO_ERROR_GENERIC_MBEDTLS_SSL_WRITE;
+	  }
+	  sessionPersist.update(&ssl_context, callbacks.save, coap_state ? *coap_state : 0);
+	  return NO_ERROR;
+  }
+#else
+  (void)max_len;
+  (void)len;
+#endif
+  return MessageChannel::send_segments(message, segments, count);
+}
+
 bool DTLSMessageChannel::is_unreliable()
 {
 	return true;
@@ -26,6 +26,7 @@
 #include "device_keys.h"
 #include "message_channel.h"
 #include "buffer_message_channel.h"
+#include "traffic_accounting.h"
 
 #include "mbedtls/ssl.h"
 #include "mbedtls/ssl_internal.h"
@@ -102,6 +103,7 @@ private:
 	message_id_t* coap_state;
 	bool move_session;
 	const uint8_t* device_id;
+	TrafficAccounting traffic;
 
     void init();
     void dispose();
@@ -146,6 +148,12 @@ private:
 	 */
 	virtual ProtocolError send(Message& message) override;
 
+	/**
+	 * Sends the given message followed by the given segments. The segments are gathered
+	 * directly into the record buffer of the SSL context rather than the message buffer.
+	 */
+	virtual ProtocolError send_segments(Message& message, const MessageSegment* segments, size_t count) override;
+
 
 	virtual ProtocolError notify_established() override;
 
@@ -111,6 +111,7 @@ public:
 		if (channel.has_unacknowledged_client_requests()) {
 			status->flags |= PROTOCOL_STATUS_HAS_PENDING_CLIENT_MESSAGES;
 		}
+		get_keepalive_status(status);
 		return NO_ERROR;
 	}
 
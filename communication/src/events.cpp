@@ -86,6 +86,66 @@ size_t subscription(uint8_t buf[], uint16_t message_id,
   return p - buf;
 }
 
+size_t subscription(uint8_t buf[], uint16_t message_id, const FilteringEventHandler& handler)
+{
+  const char *device_id = handler.device_id[0] ? handler.device_id : NULL;
+  if (NULL == device_id && SubscriptionScope::FIREHOSE == handler.scope && 0 == handler.filter[0])
+  {
+    // unfiltered firehose is not allowed
+    return -1;
+  }
+
+  uint8_t *p = subscription_prelude(buf, message_id, handler.filter);
+
+  // option delta of the first Uri-Query option
+  uint8_t delta = 0x40;
+  if (NULL == device_id && SubscriptionScope::MY_DEVICES == handler.scope)
+  {
+    *p++ = 0x41; // one-byte Uri-Query option
+    *p++ = 'u';
+    delta = 0x00;
+  }
+
+  if (handler.flags & EVENT_HANDLER_FLAG_EXACT_NAME)
+  {
+    *p++ = delta | 0x01;
+    *p++ = 'x';
+    delta = 0x00;
+  }
+
+  if (handler.flags & (EVENT_HANDLER_FLAG_DATA_PREFIX | EVENT_HANDLER_FLAG_DATA_CONTAINS))
+  {
+    // dp=<prefix> or dc=<substring>
+    const size_t filter_len = strnlen(handler.data_filter, sizeof(handler.data_filter) - 1);
+    const size_t len = filter_len + 3;
+    if (len < 13)
+    {
+      *p++ = delta | len;
+    }
+    else
+    {
+      *p++ = delta | 0x0d;
+      *p++ = len - 13;
+    }
+    *p++ = 'd';
+    *p++ = (handler.flags & EVENT_HANDLER_FLAG_DATA_PREFIX) ? 'p' : 'c';
+    *p++ = '=';
+    memcpy(p, handler.data_filter, filter_len);
+    p += filter_len;
+  }
+
+  if (NULL != device_id)
+  {
+    size_t len = strnlen(device_id, 63);
+
+    *p++ = 0xff;
+    memcpy(p, device_id, len);
+    p += len;
+  }
+
+  return p - buf;
+}
+
 size_t event_name_uri_path(uint8_t buf[], const char *name, size_t name_len)
 {
   if (0 == name_len)
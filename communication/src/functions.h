@@ -34,12 +34,22 @@ namespace protocol
 class Functions
 {
     char function_arg[MAX_FUNCTION_ARG_LENGTH+1]; // add one for null terminator
+    unsigned call_count = 0; // Incremented for every function call
+    unsigned ack_call = 0; // Call whose request hasn't been acknowledged yet, 0 if none
+    message_id_t ack_id = 0; // ID of that request
 
-    ProtocolError function_result(MessageChannel& channel, const void* result, SparkReturnType::Enum, token_t token)
+    ProtocolError function_result(MessageChannel& channel, const void* result, SparkReturnType::Enum, token_t token, unsigned call)
     {
         Message message;
         channel.create(message, Messages::function_return_size);
         size_t length = Messages::function_return(message.buf(), 0, token, long(result), channel.is_unreliable());
+        if (call && call == ack_call)
+        {
+            // The function has returned before the request was acknowledged, send the result in the ACK
+            ack_call = 0;
+            Messages::piggyback_response(message.buf());
+            message.set_id(ack_id);
+        }
         message.set_length(length);
         return channel.send(message);
     }
@@ -101,23 +111,46 @@ public:
         memcpy(function_arg, queue + q_index + 1, function_arg_length);
         function_arg[function_arg_length] = 0; // null terminate string
 
-        Message response;
-        channel.response(message, response, 16);
-        // send ACK
-        size_t response_length = Messages::coded_ack(response.buf(), has_function ? 0x00 : RESPONSE_CODE(4,00), 0, 0);
-        response.set_id(message_id);
-        response.set_length(response_length);
-        ProtocolError error = channel.send(response);
-        if (error) {
-            return error;
+        if (!has_function)
+        {
+            ProtocolError error = send_ack(message, message_id, channel, RESPONSE_CODE(4,00));
+            if (error) {
+                return error;
+            }
         }
 
-        // call the given user function
+        // call the given user function. If it returns synchronously, the result is sent
+        // in the ACK, otherwise the request is acknowledged once the call has been scheduled
+        unsigned call = 0;
+        if (has_function) {
+            if (!++call_count) {
+                call_count = 1; // 0 is reserved
+            }
+            call = call_count;
+        }
+        ack_call = call;
+        ack_id = message_id;
         auto callback = [=,&channel] (const void* result, SparkReturnType::Enum resultType )
-            { return this->function_result(channel, result, resultType, token); };
+            { return this->function_result(channel, result, resultType, token, call); };
         call_function(function_key, function_arg, callback, NULL);
+        if (call && call == ack_call)
+        {
+            ack_call = 0;
+            return send_ack(message, message_id, channel, 0x00);
+        }
         return NO_ERROR;
     }
+
+private:
+    ProtocolError send_ack(Message& message, message_id_t message_id, MessageChannel& channel, uint8_t code)
+    {
+        Message response;
+        channel.response(message, response, 16);
+        size_t response_length = Messages::coded_ack(response.buf(), code, 0, 0);
+        response.set_id(message_id);
+        response.set_length(response_length);
+        return channel.send(response);
+    }
 };
 
 
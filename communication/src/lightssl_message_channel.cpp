@@ -13,6 +13,7 @@ LOG_SOURCE_CATEGORY("comm.lightssl")
 
 #include "mbedtls/rsa.h"
 #include "mbedtls_util.h"
+#include "communication_diagnostic.h"
 
 namespace particle
 {
@@ -50,7 +51,11 @@ namespace protocol
 
 		uint8_t* buf = message.buf()-2;
 		size_t to_write = wrap(buf, message.length());
-		return blocking_send(buf, to_write)<0 ? IO_ERROR_LIGHTSSL_BLOCKING_SEND : NO_ERROR;
+		const int bytes_sent = blocking_send(buf, to_write);
+		if (bytes_sent<0)
+			return IO_ERROR_LIGHTSSL_BLOCKING_SEND;
+		traffic.sent(message.buf(), message.length(), bytes_sent);
+		return NO_ERROR;
 	}
 
 	ProtocolError LightSSLMessageChannel::receive(Message& message)
@@ -60,6 +65,7 @@ namespace protocol
 		int bytes_received = callbacks.receive(queue, 2, nullptr);
 		if (2 == bytes_received)
 		{
+			g_cloudBytesReceivedCounter += bytes_received;
 			size_t packet_size = queue[0] << 8 | queue[1];
 			error = create(message, packet_size);
 			if (!error)
@@ -75,6 +81,7 @@ namespace protocol
 					mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_DECRYPT, packet_size, iv_receive, buf, buf);
 					memcpy(iv_receive, next_iv, 16);
 					message.set_length(packet_size-buf[packet_size-1]);
+					traffic.received(buf, message.length(), 2 + packet_size);
 				}
 			}
 		}
@@ -149,6 +156,16 @@ namespace protocol
 	}
 
 	ProtocolError LightSSLMessageChannel::handshake()
+	{
+		const unsigned bytes_sent = g_cloudBytesSentCounter;
+		const unsigned bytes_received = g_cloudBytesReceivedCounter;
+		const ProtocolError error = do_handshake();
+		traffic.reset();
+		traffic.handshake(g_cloudBytesSentCounter - bytes_sent, g_cloudBytesReceivedCounter - bytes_received);
+		return error;
+	}
+
+	ProtocolError LightSSLMessageChannel::do_handshake()
 	{
 		LOG_CATEGORY("comm.lightssl.handshake");
 		LOG(INFO,"Started, receive nonce");
@@ -218,6 +235,7 @@ namespace protocol
 			else if (0 < bytes_or_error)
 			{
 				byte_count += bytes_or_error;
+				g_cloudBytesSentCounter += bytes_or_error;
 			}
 			else
 			{
@@ -253,6 +271,7 @@ namespace protocol
 			else if (0 < bytes_or_error)
 			{
 				byte_count += bytes_or_error;
+				g_cloudBytesReceivedCounter += bytes_or_error;
 			}
 			else
 			{
@@ -27,6 +27,7 @@
 #include "device_keys.h"
 #include "message_channel.h"
 #include "buffer_message_channel.h"
+#include "traffic_accounting.h"
 #include "mbedtls/aes.h"
 
 namespace particle
@@ -66,6 +67,7 @@ private:
 
 	Callbacks callbacks;
 	message_id_t* counter;
+	TrafficAccounting traffic;
 
 public:
 
@@ -120,6 +122,7 @@ protected:
 	void encrypt(unsigned char *buf, int length);
 
 	ProtocolError handshake();
+	ProtocolError do_handshake();
 
 	// Returns bytes sent or -1 on error
 	int blocking_send(const unsigned char *buf, int length);
@@ -83,6 +83,7 @@ public:
 	{
 		SPARK_ASSERT(status);
 		status->flags = 0;
+		get_keepalive_status(status);
 		return 0;
 	}
 
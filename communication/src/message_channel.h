@@ -20,6 +20,7 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
 #include "protocol_defs.h"
 #include "coap.h"
 
@@ -29,6 +30,41 @@ namespace protocol
 {
 
 
+/**
+ * A segment of message data stored outside of the message buffer.
+ */
+struct MessageSegment
+{
+	const uint8_t* data;
+	size_t size;
+};
+
+inline size_t message_segments_size(const MessageSegment* segments, size_t count)
+{
+	size_t size = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		size += segments[i].size;
+	}
+	return size;
+}
+
+/**
+ * Copies the given segments to the destination buffer.
+ */
+inline uint8_t* copy_message_segments(uint8_t* dest, const MessageSegment* segments, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (segments[i].size)
+		{
+			memcpy(dest, segments[i].data, segments[i].size);
+			dest += segments[i].size;
+		}
+	}
+	return dest;
+}
+
 class Message
 {
 	static const unsigned MINIMUM_COAP_MESSAGE_LENGTH = 4;
@@ -128,6 +164,21 @@ public:
 		return len;
 	}
 
+	/**
+	 * Appends the given segments to the contents of this message.
+	 *
+	 * @return `false` if the segments don't fit into the message buffer.
+	 */
+	bool append(const MessageSegment* segments, size_t count)
+	{
+		const size_t size = message_segments_size(segments, count);
+		if (size > buffer_available())
+			return false;
+		copy_message_segments(buffer + message_length, segments, count);
+		message_length += size;
+		return true;
+	}
+
 	bool content_equals(Message& msg)
 	{
 		return msg.length()==this->length() &&
@@ -242,6 +293,30 @@ struct MessageChannel : public Channel
 	 * Notify the upper layer that all client messages have been processed.
 	 */
 	virtual void notify_client_messages_processed()=0;
+
+	/**
+	 * Sends a message whose contents is the message data followed by the given segments.
+	 *
+	 * Channels that can encode the segments directly from their memory override this method.
+	 * The default implementation copies the segments into the message buffer.
+	 */
+	virtual ProtocolError send_segments(Message& msg, const MessageSegment* segments, size_t count)
+	{
+		if (!msg.append(segments, count))
+			return INSUFFICIENT_STORAGE;
+		return send(msg);
+	}
+
+	/**
+	 * Returns the number of messages sent over this channel, not counting retransmissions.
+	 *
+	 * The counter is only compared for changes. Channels that don't count the messages
+	 * return 0.
+	 */
+	virtual unsigned sent_message_count() const
+	{
+		return 0;
+	}
 };
 
 class AbstractMessageChannel : public MessageChannel
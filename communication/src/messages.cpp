@@ -18,23 +18,46 @@
  */
 
 #include "messages.h"
+#include "coap_message_prefix.h"
 
 namespace particle { namespace protocol {
 
+namespace {
+
+template<CoAPType::Enum TYPE> using HelloPrefix = CoAPMessagePrefix<TYPE, CoAPCode::POST, 0, true, 'h'>;
+template<CoAPType::Enum TYPE> using UpdateDonePrefix = CoAPMessagePrefix<TYPE, CoAPCode::PUT, 0, false, 'u'>;
+template<CoAPType::Enum TYPE> using FunctionReturnPrefix = CoAPMessagePrefix<TYPE, CoAPCode::CHANGED, 1, true>;
+typedef CoAPMessagePrefix<CoAPType::CON, CoAPCode::GET, 1, false, 't'> TimeRequestPrefix;
+typedef CoAPMessagePrefix<CoAPType::CON, CoAPCode::GET, 0, true, 'c'> ChunkMissedPrefix;
+typedef CoAPMessagePrefix<CoAPType::ACK, CoAPCode::CONTENT, 1, true> ContentPrefix;
+typedef CoAPMessagePrefix<CoAPType::CON, CoAPCode::EMPTY, 0, false> PingPrefix;
+typedef CoAPMessagePrefix<CoAPType::CON, CoAPCode::POST, 0, false, 'd'> DescribePrefix;
+typedef CoAPMessagePrefix<CoAPType::CON, CoAPCode::POST, 1, true, 'B'> BulkOpenPrefix;
+typedef CoAPMessagePrefix<CoAPType::NON, CoAPCode::POST, 1, true, 'B'> BulkSegmentPrefix;
+typedef CoAPMessagePrefix<CoAPType::NON, CoAPCode::DELETE, 1, false, 'B'> BulkCancelPrefix;
+
+} // namespace
+
 CoAPMessageType::Enum Messages::decodeType(const uint8_t* buf, size_t length)
 {
-    if (length<4)
-        return CoAPMessageType::ERROR;
-
-    char path = 0;
-    // 4 bytes for CoAP header
-    // 1 byte for the option length
-    // plus length of token
-	size_t path_idx = 5 + (buf[0] & 0x0F);
-    if (path_idx<length)
-		 path = buf[path_idx];
-
-	switch (CoAP::code(buf))
+	CoAPMessageView msg;
+	msg.parse(buf, length);
+	return decodeType(msg);
+}
+
+CoAPMessageType::Enum Messages::decodeType(const CoAPMessageView& msg)
+{
+	if (!msg.is_valid())
+		return CoAPMessageType::ERROR;
+
+	// The request is identified by the first character of its first option (Uri-Path)
+	char path = 0;
+	size_t path_size = 0;
+	const uint8_t* const path_opt = msg.first_option(&path_size);
+	if (path_opt && path_size)
+		path = path_opt[0];
+
+	switch (msg.code())
 	{
 	case CoAPCode::GET:
 		switch (path)
@@ -63,6 +86,8 @@ CoAPMessageType::Enum Messages::decodeType(const uint8_t* buf, size_t length)
 			return CoAPMessageType::UPDATE_BEGIN;
 		case 'c':
 			return CoAPMessageType::CHUNK;
+		case 'b':
+			return CoAPMessageType::BULK_ACK;
 		default:
 			break;
 		}
@@ -76,7 +101,7 @@ CoAPMessageType::Enum Messages::decodeType(const uint8_t* buf, size_t length)
 			return CoAPMessageType::UPDATE_DONE;
 		case 's':
 			// todo - use a single message SIGNAL and decode the rest of the message to determine desired state
-			if (buf[8])
+			if (msg.payload_size() && msg.payload()[0])
 				return CoAPMessageType::SIGNAL_START;
 			else
 				return CoAPMessageType::SIGNAL_STOP;
@@ -85,7 +110,7 @@ CoAPMessageType::Enum Messages::decodeType(const uint8_t* buf, size_t length)
 		}
 		break;
 	case CoAPCode::EMPTY:
-		switch (CoAP::type(buf))
+		switch (msg.type())
 		{
 		case CoAPType::CON:
 			return CoAPMessageType::PING;
@@ -107,13 +132,7 @@ size_t Messages::hello(uint8_t* buf, message_id_t message_id, uint8_t flags,
 		uint16_t product_firmware_version, bool confirmable, const uint8_t* device_id, uint16_t device_id_len)
 {
 	// TODO: why no token? because the response is not sent separately. But really we should use a token for all messages that expect a response.
-	buf[0] = COAP_MSG_HEADER(confirmable ? CoAPType::CON : CoAPType::NON, 0);
-	buf[1] = 0x02; // POST
-	buf[2] = message_id >> 8;
-	buf[3] = message_id & 0xff;
-	buf[4] = 0xb1; // Uri-Path option of length 1
-	buf[5] = 'h';
-	buf[6] = 0xff; // payload marker
+	encode_prefix<HelloPrefix>(buf, confirmable, message_id);
 	buf[7] = product_id >> 8;
 	buf[8] = product_id & 0xff;
 	buf[9] = product_firmware_version >> 8;
@@ -137,13 +156,7 @@ size_t Messages::hello(uint8_t* buf, message_id_t message_id, uint8_t flags,
 size_t Messages::update_done(uint8_t* buf, message_id_t message_id, const uint8_t* result, size_t result_len, bool confirmable)
 {
 	// why not with a token? this is sent in response to the server's UpdateDone message.
-	size_t sz = 6;
-	buf[0] = confirmable ? 0x40 : 0x50; // confirmable/non-confirmable, no token
-	buf[1] = 0x03; // PUT
-	buf[2] = message_id >> 8;
-	buf[3] = message_id & 0xff;
-	buf[4] = 0xb1; // Uri-Path option of length 1
-	buf[5] = 'u';
+	size_t sz = encode_prefix<UpdateDonePrefix>(buf, confirmable, message_id);
 	if (result && result_len) {
 		buf[sz++] = 0xff; // payload marker
 		memcpy(buf + sz, result, result_len);
@@ -159,12 +172,7 @@ size_t Messages::update_done(uint8_t* buf, message_id_t message_id, bool confirm
 
 size_t Messages::function_return(unsigned char *buf, message_id_t message_id, token_t token, int return_value, bool confirmable)
 {
-	buf[0] = confirmable ? 0x41 : 0x51; // non-confirmable, one-byte token
-	buf[1] = 0x44; // response code 2.04 CHANGED
-	buf[2] = message_id >> 8;
-	buf[3] = message_id & 0xff;
-	buf[4] = token;
-	buf[5] = 0xff; // payload marker
+	encode_prefix<FunctionReturnPrefix>(buf, confirmable, message_id, token);
 	buf[6] = return_value >> 24;
 	buf[7] = return_value >> 16 & 0xff;
 	buf[8] = return_value >> 8 & 0xff;
@@ -174,44 +182,51 @@ size_t Messages::function_return(unsigned char *buf, message_id_t message_id, to
 
 size_t Messages::time_request(uint8_t* buf, uint16_t message_id, uint8_t token)
 {
-	unsigned char *p = buf;
-
-	*p++ = 0x41; // Confirmable, one-byte token
-	*p++ = 0x01; // GET request
-
-	*p++ = message_id >> 8;
-	*p++ = message_id & 0xff;
-
-	*p++ = token;
-	*p++ = 0xb1; // One-byte, Uri-Path option
-	*p++ = 't';
-
-	return p - buf;
+	return TimeRequestPrefix::encode(buf, message_id, token);
 }
 
 size_t Messages::chunk_missed(uint8_t* buf, uint16_t message_id, chunk_index_t chunk_index)
 {
-	buf[0] = 0x40; // confirmable, no token
-	buf[1] = 0x01; // code 0.01 GET
-	buf[2] = message_id >> 8;
-	buf[3] = message_id & 0xff;
-	buf[4] = 0xb1; // one-byte Uri-Path option
-	buf[5] = 'c';
-	buf[6] = 0xff; // payload marker
+	ChunkMissedPrefix::encode(buf, message_id);
 	buf[7] = chunk_index >> 8;
 	buf[8] = chunk_index & 0xff;
 	return 9;
 }
 
+size_t Messages::bulk_open(uint8_t* buf, uint16_t message_id, uint8_t token, uint32_t size, const char* name)
+{
+	size_t len = BulkOpenPrefix::encode(buf, message_id, token);
+	buf[len++] = BULK_TRANSFER_VERSION;
+	buf[len++] = size >> 24;
+	buf[len++] = (size >> 16) & 0xff;
+	buf[len++] = (size >> 8) & 0xff;
+	buf[len++] = size & 0xff;
+	if (name) {
+		const size_t name_len = strnlen(name, MAX_EVENT_NAME_LENGTH);
+		memcpy(buf + len, name, name_len);
+		len += name_len;
+	}
+	return len;
+}
+
+size_t Messages::bulk_segment_header(uint8_t* buf, uint16_t message_id, uint8_t token, uint32_t offset)
+{
+	size_t len = BulkSegmentPrefix::encode(buf, message_id, token);
+	buf[len++] = offset >> 24;
+	buf[len++] = (offset >> 16) & 0xff;
+	buf[len++] = (offset >> 8) & 0xff;
+	buf[len++] = offset & 0xff;
+	return len;
+}
+
+size_t Messages::bulk_cancel(uint8_t* buf, uint16_t message_id, uint8_t token)
+{
+	return BulkCancelPrefix::encode(buf, message_id, token);
+}
+
 size_t Messages::content(uint8_t* buf, uint16_t message_id, uint8_t token)
 {
-	buf[0] = 0x61; // acknowledgment, one-byte token
-	buf[1] = 0x45; // response code 2.05 CONTENT
-	buf[2] = message_id >> 8;
-	buf[3] = message_id & 0xff;
-	buf[4] = token;
-	buf[5] = 0xff; // payload marker
-	return 6;
+	return ContentPrefix::encode(buf, message_id, token);
 }
 
 
@@ -223,22 +238,12 @@ size_t Messages::keep_alive(uint8_t* buf)
 
 size_t Messages::ping(uint8_t* buf, uint16_t message_id)
 {
-	buf[0] = 0x40; // Confirmable, no token
-	buf[1] = 0x00; // code signifying empty message
-	buf[2] = message_id >> 8;
-	buf[3] = message_id & 0xff;
-	return 4;
+	return PingPrefix::encode(buf, message_id);
 }
 
 size_t Messages::presence_announcement(unsigned char *buf, const char *id)
 {
-	buf[0] = 0x50; // Non-Confirmable, no token
-	buf[1] = 0x02; // Code POST
-	buf[2] = 0x00; // message id ignorable in this context
-	buf[3] = 0x00;
-	buf[4] = 0xb1; // Uri-Path option of length 1
-	buf[5] = 'h';
-	buf[6] = 0xff; // payload marker
+	HelloPrefix<CoAPType::NON>::encode(buf, 0); // message id ignorable in this context
 	memcpy(buf + 7, id, 12);
 	return 19;
 }
@@ -252,12 +257,7 @@ size_t Messages::describe_post_header(uint8_t buf[], size_t buffer_size, uint16_
 	if ( buffer_size < header_size ) {
 		bytes_written = 0;
 	} else {
-		buf[0] = 0x40; // Confirmable, no token
-		buf[1] = 0x02; // Type POST
-		buf[2] = message_id >> 8;
-		buf[3] = message_id & 0xff;
-		buf[4] = 0xb1; // Uri-Path option of length 1
-		buf[5] = 'd';
+		DescribePrefix::encode(buf, message_id);
 		buf[6] = 0x41; // Uri-Query option of length 1
 		buf[7] = desc_flags;
 		buf[8] = 0xff; // payload marker
@@ -289,6 +289,21 @@ size_t Messages::separate_response_with_payload(unsigned char *buf, uint16_t mes
 
 size_t Messages::event(uint8_t buf[], uint16_t message_id, const char *event_name,
              const char *data, int ttl, EventType::Enum event_type, bool confirmable)
+{
+  uint8_t *p = buf + event_header(buf, message_id, event_name, NULL != data, ttl, event_type, confirmable);
+
+  if (NULL != data)
+  {
+    const size_t data_len = strnlen(data, MAX_EVENT_DATA_LENGTH);
+    memcpy(p, data, data_len);
+    p += data_len;
+  }
+
+  return p - buf;
+}
+
+size_t Messages::event_header(uint8_t buf[], uint16_t message_id, const char *event_name,
+             bool has_data, int ttl, EventType::Enum event_type, bool confirmable, int content_type)
 {
   uint8_t *p = buf;
   *p++ = confirmable ? 0x40 : 0x50; // non-confirmable /confirmable, no token
@@ -298,24 +313,99 @@ size_t Messages::event(uint8_t buf[], uint16_t message_id, const char *event_nam
   *p++ = 0xb1; // one-byte Uri-Path option
   *p++ = event_type;
 
-  size_t name_data_len = strnlen(event_name, MAX_EVENT_NAME_LENGTH);
-  p += event_name_uri_path(p, event_name, name_data_len);
+  const size_t name_len = strnlen(event_name, MAX_EVENT_NAME_LENGTH);
+  p += event_name_uri_path(p, event_name, name_len);
+
+  uint8_t max_age_delta = 0x30;
+  if (ContentType::TEXT != content_type)
+  {
+    // Content-Format option
+    if (content_type <= 0xff)
+    {
+      *p++ = 0x11;
+    }
+    else
+    {
+      *p++ = 0x12;
+      *p++ = (content_type >> 8) & 0xff;
+    }
+    *p++ = content_type & 0xff;
+    max_age_delta = 0x20;
+  }
 
   if (60 != ttl)
   {
-    *p++ = 0x33;
+    *p++ = max_age_delta | 0x03;
     *p++ = (ttl >> 16) & 0xff;
     *p++ = (ttl >> 8) & 0xff;
     *p++ = ttl & 0xff;
   }
 
-  if (NULL != data)
+  if (has_data)
   {
-    name_data_len = strnlen(data, MAX_EVENT_DATA_LENGTH);
-
     *p++ = 0xff;
-    memcpy(p, data, name_data_len);
-    p += name_data_len;
+  }
+
+  return p - buf;
+}
+
+size_t Messages::events(uint8_t buf[], size_t buf_size, uint16_t message_id, const EventBatchEntry* events,
+             size_t count, int ttl, EventType::Enum event_type, bool confirmable)
+{
+  // CoAP header, Uri-Path, Max-Age and Uri-Query options, payload marker
+  const size_t header_size = 13;
+  if (!count || buf_size < header_size)
+  {
+    return 0;
+  }
+
+  uint8_t *p = buf;
+  *p++ = confirmable ? 0x40 : 0x50; // non-confirmable /confirmable, no token
+  *p++ = 0x02; // code 0.02 POST request
+  *p++ = message_id >> 8;
+  *p++ = message_id & 0xff;
+  *p++ = 0xb1; // one-byte Uri-Path option
+  *p++ = event_type;
+
+  if (60 != ttl)
+  {
+    *p++ = 0x33;
+    *p++ = (ttl >> 16) & 0xff;
+    *p++ = (ttl >> 8) & 0xff;
+    *p++ = ttl & 0xff;
+    *p++ = 0x11; // one-byte Uri-Query option
+  }
+  else
+  {
+    *p++ = 0x41; // one-byte Uri-Query option
+  }
+  *p++ = 'b';
+  *p++ = 0xff;
+
+  const uint8_t* const end = buf + buf_size;
+  for (size_t i = 0; i < count; ++i)
+  {
+    const EventBatchEntry& e = events[i];
+    const size_t name_len = e.name ? strnlen(e.name, MAX_EVENT_NAME_LENGTH) : 0;
+    if (0 == name_len)
+    {
+      return 0;
+    }
+    const size_t data_len = e.data ? strnlen(e.data, MAX_EVENT_DATA_LENGTH) : 0;
+    if ((size_t)(end - p) < name_len + data_len + 3)
+    {
+      return 0;
+    }
+    *p++ = name_len;
+    memcpy(p, e.name, name_len);
+    p += name_len;
+    *p++ = data_len >> 8;
+    *p++ = data_len & 0xff;
+    if (data_len)
+    {
+      memcpy(p, e.data, data_len);
+      p += data_len;
+    }
   }
 
   return p - buf;
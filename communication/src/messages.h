@@ -47,6 +47,7 @@ class Messages
 {
 public:
 	static CoAPMessageType::Enum decodeType(const uint8_t* buf, size_t length);
+	static CoAPMessageType::Enum decodeType(const CoAPMessageView& msg);
 	static size_t describe_post_header(uint8_t buf[], size_t buffer_size, uint16_t message_id, uint8_t desc_flags);
 	static size_t hello(uint8_t* buf, message_id_t message_id, uint8_t flags,
 			uint16_t platform_id, uint16_t product_id,
@@ -63,6 +64,18 @@ public:
 
 	static size_t chunk_missed(uint8_t* buf, uint16_t message_id, chunk_index_t chunk_index);
 
+	/**
+	 * Encodes a request opening a bulk transfer of `size` bytes. The name is truncated to
+	 * `MAX_EVENT_NAME_LENGTH` characters.
+	 */
+	static size_t bulk_open(uint8_t* buf, uint16_t message_id, uint8_t token, uint32_t size, const char* name);
+	/**
+	 * Encodes the header of a bulk transfer segment. The segment data is expected to follow
+	 * the returned size.
+	 */
+	static size_t bulk_segment_header(uint8_t* buf, uint16_t message_id, uint8_t token, uint32_t offset);
+	static size_t bulk_cancel(uint8_t* buf, uint16_t message_id, uint8_t token);
+
 	static size_t content(uint8_t* buf, uint16_t message_id, uint8_t token);
 
 	static size_t ping(uint8_t* buf, uint16_t message_id);
@@ -77,6 +90,29 @@ public:
 	static size_t event(uint8_t buf[], uint16_t message_id, const char *event_name,
 	             const char *data, int ttl, EventType::Enum event_type, bool confirmable);
 
+	/**
+	 * Encodes the header and options of an event message. If `has_data` is set, the payload
+	 * marker is appended as well and the event data is expected to follow the returned size.
+	 * The Content-Format option is omitted for `ContentType::TEXT`.
+	 */
+	static size_t event_header(uint8_t buf[], uint16_t message_id, const char *event_name,
+	             bool has_data, int ttl, EventType::Enum event_type, bool confirmable,
+	             int content_type = ContentType::TEXT);
+
+	/**
+	 * Encodes several events into a single POST request.
+	 *
+	 * The request has the same options as a regular event message, except that the event name is
+	 * not encoded in the URI path. Instead, a Uri-Query option with the value `b` is added, and the
+	 * payload contains the events, one after another, in the following format:
+	 *
+	 * `name_length` (1 byte), `name`, `data_length` (2 bytes, big-endian), `data`
+	 *
+	 * @return Message size, or 0 if the events don't fit into the buffer.
+	 */
+	static size_t events(uint8_t buf[], size_t buf_size, uint16_t message_id, const EventBatchEntry* events,
+	             size_t count, int ttl, EventType::Enum event_type, bool confirmable);
+
 
     static inline size_t empty_ack(unsigned char *buf,
                           unsigned char message_id_msb,
@@ -147,6 +183,15 @@ public:
         return separate_response_with_payload(buf, message_id, token, code, NULL, 0, confirmable);
     }
 
+    /**
+     * Turns a separate response into a response piggybacked on the acknowledgment of the request.
+     * The ID of the message needs to be set to the ID of the request.
+     */
+    static inline void piggyback_response(unsigned char *buf)
+    {
+        buf[0] = (buf[0] & 0xcf) | (CoAPType::ACK << 4);
+    }
+
     static inline size_t description(unsigned char *buf, message_id_t message_id, token_t token)
     {
         return content(buf, message_id, token);
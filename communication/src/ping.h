@@ -4,6 +4,17 @@
 
 namespace particle { namespace protocol {
 
+/**
+ * Sends pings to the server after a period of inactivity.
+ *
+ * In the adaptive mode, the ping interval is derived from the lifetime of the NAT binding
+ * of the connection, which is learned by probing: a ping that is acknowledged after an idle
+ * period proves that the binding outlives that period, and a ping that times out suggests
+ * it doesn't. The probed interval is doubled until a ping times out, and then bisected
+ * between the longest acknowledged and the shortest failed interval. Once the two are close
+ * enough, pings are sent at the longest interval known to work. If a ping sent at that interval
+ * times out, the lifetime is learned again.
+ */
 class Pinger
 {
 	bool expecting_ping_ack;
@@ -11,8 +22,32 @@ class Pinger
 	system_tick_t ping_timeout;
 	keepalive_source_t keepalive_source;
 
+	bool adaptive;
+	system_tick_t binding_min; // Longest idle period after which a ping was acknowledged
+	system_tick_t binding_max; // Shortest idle period after which a ping timed out, 0 if unknown
+	system_tick_t probe_interval; // Idle period after which the pending ping was sent
+
 public:
-	Pinger() : expecting_ping_ack(false), ping_interval(0), ping_timeout(10000), keepalive_source(KeepAliveSource::SYSTEM) {}
+	/**
+	 * Interval of the first probe in the adaptive mode.
+	 */
+	static const system_tick_t ADAPTIVE_MIN_INTERVAL = 15000;
+	/**
+	 * Maximum interval in the adaptive mode.
+	 */
+	static const system_tick_t ADAPTIVE_MAX_INTERVAL = 30 * 60 * 1000;
+	/**
+	 * The learning stops when the lifetime is known with this precision.
+	 */
+	static const system_tick_t ADAPTIVE_RESOLUTION = 5000;
+	/**
+	 * A ping is sent if nothing has been received for this many ping intervals, even if
+	 * messages have been sent in the meantime.
+	 */
+	static const unsigned LIVENESS_FACTOR = 4;
+
+	Pinger() : expecting_ping_ack(false), ping_interval(0), ping_timeout(10000), keepalive_source(KeepAliveSource::SYSTEM),
+			adaptive(false), binding_min(0), binding_max(0), probe_interval(0) {}
 
 	/**
 	 * Sets the ping interval that the client will send pings to the server, and the expected maximum response time.
@@ -39,11 +74,77 @@ public:
 			this->ping_interval = interval;
 			this->keepalive_source = source;
 		}
+		if (source == KeepAliveSource::USER)
+		{
+			// An interval set by the application takes precedence
+			adaptive = false;
+		}
+	}
+
+	/**
+	 * Enables or disables the adaptive mode.
+	 *
+	 * @param bounds Previously learned bounds of the NAT binding lifetime, as returned by
+	 *        `adaptive_bounds()`, or 0 if nothing is known about the current network.
+	 */
+	void set_adaptive(bool enabled, uint32_t bounds = 0)
+	{
+		adaptive = enabled;
+		binding_min = (bounds & 0xffff) * 1000;
+		binding_max = (bounds >> 16) * 1000;
+		if (binding_max && binding_max <= binding_min)
+		{
+			binding_max = 0;
+		}
+	}
+
+	bool is_adaptive() const { return adaptive; }
+
+	/**
+	 * Returns the learned bounds of the NAT binding lifetime: the lower 16 bits are the longest
+	 * acknowledged interval and the upper 16 bits are the shortest failed interval, in seconds.
+	 */
+	uint32_t adaptive_bounds() const
+	{
+		return ((binding_max / 1000) << 16) | ((binding_min / 1000) & 0xffff);
+	}
+
+	/**
+	 * Returns the interval after which the next ping is sent.
+	 */
+	system_tick_t interval() const
+	{
+		if (!adaptive)
+		{
+			return ping_interval;
+		}
+		if (binding_max)
+		{
+			if (binding_max - binding_min <= resolution())
+			{
+				return binding_min ? binding_min : binding_max / 2;
+			}
+			return binding_min + (binding_max - binding_min) / 2;
+		}
+		if (binding_min < ADAPTIVE_MIN_INTERVAL)
+		{
+			return ADAPTIVE_MIN_INTERVAL;
+		}
+		return (binding_min < ADAPTIVE_MAX_INTERVAL / 2) ? binding_min * 2 : ADAPTIVE_MAX_INTERVAL;
+	}
+
+	/**
+	 * Returns `true` if the NAT binding lifetime is known with enough precision.
+	 */
+	bool is_adaptive_settled() const
+	{
+		return binding_max ? (binding_max - binding_min <= resolution()) : (binding_min >= ADAPTIVE_MAX_INTERVAL);
 	}
 
 	void reset()
 	{
 		expecting_ping_ack = false;
+		probe_interval = 0;
 	}
 
 	/**
@@ -54,11 +155,46 @@ public:
 	 */
 	template <typename Callback> ProtocolError process(system_tick_t millis_since_last_message, Callback ping)
 	{
+		return process(millis_since_last_message, millis_since_last_message, ping);
+	}
+
+	/**
+	 * Handle ping messages, taking the outbound traffic into account.
+	 *
+	 * A message sent to the server refreshes the NAT binding just like a ping does, so the ping
+	 * interval is counted from the last message sent or received, whichever is more recent.
+	 * Outbound traffic doesn't prove that the server is reachable though, so a ping is still sent
+	 * if nothing has been received for `LIVENESS_FACTOR` ping intervals.
+	 *
+	 * @param millis_since_last_received Elapsed number of milliseconds since the last message was received.
+	 * @param millis_since_last_sent Elapsed number of milliseconds since the last message was sent.
+	 * @param callback a no-arg callable that is used to perform a ping to the cloud.
+	 */
+	template <typename Callback> ProtocolError process(system_tick_t millis_since_last_received,
+			system_tick_t millis_since_last_sent, Callback ping)
+	{
+		const system_tick_t millis_since_last_message = (millis_since_last_sent < millis_since_last_received) ?
+				millis_since_last_sent : millis_since_last_received;
 		if (expecting_ping_ack)
 		{
-			if (ping_timeout < millis_since_last_message)
+			if (ping_timeout < millis_since_last_received)
 			{
 				// timed out, disconnect
+				if (adaptive && probe_interval)
+				{
+					const bool settled = is_adaptive_settled();
+					if (!binding_max || probe_interval < binding_max)
+					{
+						binding_max = probe_interval;
+					}
+					if (settled || binding_min >= binding_max)
+					{
+						// The interval that used to work doesn't anymore, the binding lifetime
+						// has become shorter and needs to be learned again
+						binding_min = 0;
+					}
+				}
+				probe_interval = 0;
 				return PING_TIMEOUT;
 			}
 		}
@@ -66,9 +202,19 @@ public:
 		{
 			// ping interval set, so check if we need to send a ping
 			// The ping is sent based on the elapsed time since the last message
-			if (ping_interval && ping_interval < millis_since_last_message)
+			const system_tick_t interval = this->interval();
+			if (interval && interval < millis_since_last_message)
 			{
 				expecting_ping_ack = true;
+				probe_interval = millis_since_last_message;
+				return ping();
+			}
+			if (interval && interval * LIVENESS_FACTOR < millis_since_last_received)
+			{
+				// The binding is kept alive by the outbound traffic, so the outcome of this
+				// ping says nothing about its lifetime
+				expecting_ping_ack = true;
+				probe_interval = 0;
 				return ping();
 			}
 		}
@@ -82,7 +228,29 @@ public:
 	 * and that there is presently no need to resend a ping
 	 * until the ping interval has elapsed.
 	 */
-	void message_received() { expecting_ping_ack = false; }
+	void message_received()
+	{
+		if (expecting_ping_ack && adaptive && probe_interval)
+		{
+			if (probe_interval > binding_min)
+			{
+				binding_min = (probe_interval < ADAPTIVE_MAX_INTERVAL) ? probe_interval : ADAPTIVE_MAX_INTERVAL;
+			}
+			if (binding_max && binding_max <= binding_min)
+			{
+				// The binding lifetime has become longer
+				binding_max = 0;
+			}
+		}
+		probe_interval = 0;
+		expecting_ping_ack = false;
+	}
+
+private:
+	system_tick_t resolution() const
+	{
+		return (binding_min / 8 > ADAPTIVE_RESOLUTION) ? binding_min / 8 : ADAPTIVE_RESOLUTION;
+	}
 };
 
 
@@ -25,8 +25,47 @@ LOG_SOURCE_CATEGORY("comm.protocol")
 #include "subscriptions.h"
 #include "functions.h"
 
+#include <algorithm>
+
 namespace particle { namespace protocol {
 
+namespace {
+
+/**
+ * Appender that stores only a range of the appended data and counts the total size.
+ */
+class BlockAppender: public Appender {
+public:
+    BlockAppender(uint8_t* buf, size_t size, size_t offset) :
+            buf_(buf),
+            size_(size),
+            offs_(offset),
+            dataSize_(0) {
+    }
+
+    bool append(const uint8_t* data, size_t size) override {
+        const size_t begin = std::max(dataSize_, offs_);
+        const size_t end = std::min(dataSize_ + size, offs_ + size_);
+        if (begin < end) {
+            memcpy(buf_ + (begin - offs_), data + (begin - dataSize_), end - begin);
+        }
+        dataSize_ += size;
+        return true;
+    }
+
+    size_t dataSize() const {
+        return dataSize_;
+    }
+
+private:
+    uint8_t* const buf_;
+    const size_t size_;
+    const size_t offs_;
+    size_t dataSize_;
+};
+
+} // namespace
+
 /**
  * Sends an empty acknowledgement for the given message
  */
@@ -46,18 +85,23 @@ ProtocolError Protocol::handle_received_message(Message& message,
 	last_message_millis = callbacks.millis();
 	pinger.message_received();
 	uint8_t* queue = message.buf();
-	message_type = Messages::decodeType(queue, message.length());
+	CoAPMessageView msg;
+	msg.parse(queue, message.length());
+	message_type = Messages::decodeType(msg);
 	// todo - not all requests/responses have tokens. These device requests do not use tokens:
 	// Update Done, ChunkMissed, event, ping, hello
 	token_t token = 0;
-	size_t token_len = CoAP::token(queue, &token);
+	size_t token_len = msg.token_size();
+	if (token_len > 0) {
+		memcpy(&token, msg.token(), std::min(sizeof(token_t), token_len));
+	}
 	if (token_len > 0 && token_len != sizeof(token_t)) {
 		LOG(ERROR, "Unsupported token length: %u", (unsigned)token_len);
 		token_len = 0;
 	}
-	message_id_t msg_id = CoAP::message_id(queue);
-	CoAPCode::Enum code = CoAP::code(queue);
-	CoAPType::Enum type = CoAP::type(queue);
+	message_id_t msg_id = msg.id();
+	CoAPCode::Enum code = msg.code();
+	CoAPType::Enum type = msg.type();
 	if (CoAPType::is_reply(type)) {
 		LOG(TRACE, "Reply recieved: type=%d, code=%d", type, code);
 		// todo - this is a little too simple in the case of an empty ACK for a separate response
@@ -66,6 +110,7 @@ ProtocolError Protocol::handle_received_message(Message& message,
 			LOG(TRACE, "Reset received, setting error code to internal server error.");
 			code = CoAPCode::INTERNAL_SERVER_ERROR;
 		}
+		bulkTransfer.handle_reply(msg, callbacks.millis());
 		notify_message_complete(msg_id, code);
 	}
 
@@ -78,13 +123,22 @@ ProtocolError Protocol::handle_received_message(Message& message,
 	{
 		// 4 bytes header, 1 byte token, 2 bytes Uri-Path
 		// 2 bytes optional single character Uri-Query for describe flags
+		// optional Block2 option if the server requests the describe block-wise
 		int descriptor_type = DESCRIBE_DEFAULT;
-		if (message.length()>8 && queue[8] <= DESCRIBE_MAX) {
-			descriptor_type = queue[8];
-		} else if (message.length() > 8) {
-			LOG(WARN, "Invalid DESCRIBE flags %02x", queue[8]);
+		size_t opt_len = 0;
+		const uint8_t* opt = msg.find_option(CoAPOption::URI_QUERY, &opt_len);
+		if (opt && opt_len > 0 && opt[0] <= DESCRIBE_MAX) {
+			descriptor_type = opt[0];
+		} else if (opt && opt_len > 0) {
+			LOG(WARN, "Invalid DESCRIBE flags %02x", opt[0]);
+		}
+		CoAPBlock block = {};
+		opt = msg.find_option(CoAPOption::BLOCK2, &opt_len);
+		if (opt && !CoAP::decode_block(opt, opt_len, &block)) {
+			LOG(WARN, "Invalid Block2 option");
+			opt = nullptr;
 		}
-		error = send_description(token, msg_id, descriptor_type);
+		error = send_description(token, msg_id, descriptor_type, opt ? &block : nullptr);
 		break;
 	}
 
@@ -119,6 +173,9 @@ ProtocolError Protocol::handle_received_message(Message& message,
 	case CoAPMessageType::EVENT:
 		return subscriptions.handle_event(message, descriptor.call_event_handler, channel);
 
+	case CoAPMessageType::BULK_ACK:
+		return bulkTransfer.handle_ack(message, channel, callbacks.millis());
+
 	case CoAPMessageType::KEY_CHANGE:
 		return handle_key_change(message);
 
@@ -166,6 +223,11 @@ void Protocol::notify_message_complete(message_id_t msg_id, CoAPCode::Enum respo
 	const auto codeClass = (int)responseCode >> 5;
 	const auto codeDetail = (int)responseCode & 0x1f;
 	LOG(INFO, "message id %d complete with code %d.%02d", msg_id, codeClass, codeDetail);
+	publisher.message_complete(msg_id, CoAPCode::is_success(responseCode), callbacks.millis());
+	if (metrics_ack_pending && msg_id == metrics_msg_id) {
+		metrics_ack_pending = false;
+		metrics_acked = CoAPCode::is_success(responseCode);
+	}
 	if (CoAPCode::is_success(responseCode)) {
 		ack_handlers.setResult(msg_id);
 	} else {
@@ -296,8 +358,15 @@ int Protocol::begin()
 	LOG_CATEGORY("comm.protocol.handshake");
 	LOG(INFO,"Establish secure connection");
 	chunkedTransfer.reset();
+	bulkTransfer.cancel(SYSTEM_ERROR_CANCELLED);
 	pinger.reset();
 	timesync_.reset();
+	publisher.reset();
+	variables.reset();
+	resume_ping_pending = false;
+	// The first metrics of every session are sent in full
+	metrics_ack_pending = false;
+	metrics_acked = false;
 
 	// FIXME: Pending completion handlers should be cancelled at the end of a previous session
 	ack_handlers.clear();
@@ -324,10 +393,10 @@ int Protocol::begin()
 	if (session_resumed && channel.is_unreliable() && (flags & SKIP_SESSION_RESUME_HELLO))
 	{
 		LOG(INFO,"resumed session - not sending HELLO message");
-		const auto r = ping(true);
-		if (r != NO_ERROR) {
-			error = r;
-		}
+		// The session still needs to be verified, but the first application message sent shortly
+		// after resuming the session can do that in the same flight; a ping is sent otherwise
+		session_resumed_millis = callbacks.millis();
+		resume_ping_pending = true;
 		// Note: Make sure SESSION_RESUMED gets returned to the calling code
 		return error;
 	}
@@ -447,6 +516,8 @@ ProtocolError Protocol::event_loop(CoAPMessageType::Enum& message_type)
 	{
 		// bail if and only if there was an error
 		chunkedTransfer.cancel();
+		bulkTransfer.cancel(toSystemError(error));
+		publisher.reset();
 		LOG(ERROR,"Event loop error %d", error);
 		return error;
 	}
@@ -456,12 +527,12 @@ ProtocolError Protocol::event_loop(CoAPMessageType::Enum& message_type)
 void Protocol::build_describe_message(Appender& appender, int desc_flags)
 {
 	// diagnostics must be requested in isolation to be a binary packet
-	if (descriptor.append_metrics && (desc_flags == DESCRIBE_METRICS))
+	if (descriptor.append_metrics && ((desc_flags & ~DESCRIBE_METRICS_DELTA) == DESCRIBE_METRICS))
 	{
 		appender.append(char(0));	// null byte means binary data
-		appender.append(char(DESCRIBE_METRICS)); 									// uint16 describes the type of binary packet
+		appender.append(char(desc_flags)); 									// uint16 describes the type of binary packet
 		appender.append(char(0));	//
-		const int flags = 1;		// binary
+		const int flags = (desc_flags & DESCRIBE_METRICS_DELTA) ? 3 : 1;		// binary, delta
 		const int page = 0;
 		descriptor.append_metrics(append_instance, &appender, flags, page, nullptr);
 	}
@@ -534,8 +605,6 @@ void Protocol::build_describe_message(Appender& appender, int desc_flags)
 ProtocolError Protocol::generate_and_send_description(MessageChannel& channel, Message& message,
                                                       size_t header_size, int desc_flags)
 {
-    ProtocolError error;
-
     BufferAppender appender((message.buf() + header_size), (message.capacity() - header_size));
     build_describe_message(appender, desc_flags);
 
@@ -552,12 +621,29 @@ ProtocolError Protocol::generate_and_send_description(MessageChannel& channel, M
         SPARK_ASSERT(!appender.overflowed());
     }
 
-    LOG(INFO, "Posting '%s%s%s' describe message", desc_flags & DESCRIBE_SYSTEM ? "S" : "",
-        desc_flags & DESCRIBE_APPLICATION ? "A" : "", desc_flags & DESCRIBE_METRICS ? "M" : "");
+    LOG(INFO, "Posting '%s%s%s%s' describe message", desc_flags & DESCRIBE_SYSTEM ? "S" : "",
+        desc_flags & DESCRIBE_APPLICATION ? "A" : "", desc_flags & DESCRIBE_METRICS ? "M" : "",
+        desc_flags & DESCRIBE_METRICS_DELTA ? "D" : "");
 
-    error = channel.send(message);
+    return send_description_message(channel, message, desc_flags, true);
+}
 
-    if (error == NO_ERROR && descriptor.app_state_selector_info &&
+ProtocolError Protocol::send_description_message(MessageChannel& channel, Message& message,
+                                                 int desc_flags, bool complete)
+{
+    ProtocolError error = channel.send(message);
+
+    if (descriptor.append_metrics && ((desc_flags & ~DESCRIBE_METRICS_DELTA) == DESCRIBE_METRICS))
+    {
+        // The metrics baseline has been updated; only an acknowledgement of this message
+        // allows the next metrics to be sent as a delta
+        metrics_acked = false;
+        metrics_ack_pending = (error == NO_ERROR && message.has_id() &&
+                               message.get_type() == CoAPType::CON);
+        metrics_msg_id = message.get_id();
+    }
+
+    if (error == NO_ERROR && complete && descriptor.app_state_selector_info &&
         (desc_flags & DESCRIBE_APPLICATION || desc_flags & DESCRIBE_SYSTEM))
     {
         this->channel.command(Channel::SAVE_SESSION);
@@ -588,6 +674,11 @@ ProtocolError Protocol::generate_and_send_description(MessageChannel& channel, M
 
 ProtocolError Protocol::post_description(int desc_flags)
 {
+    if ((desc_flags & DESCRIBE_METRICS_DELTA) && !metrics_acked)
+    {
+        // The server may not have the values a delta would be based on
+        desc_flags &= ~DESCRIBE_METRICS_DELTA;
+    }
     Message message;
     channel.create(message);
     const size_t header_size =
@@ -601,8 +692,14 @@ ProtocolError Protocol::post_description(int desc_flags)
  * @param desc_flags Flags describing the information to provide. A combination of {@code
  * DESCRIBE_APPLICATION) and {@code DESCRIBE_SYSTEM) flags.
  */
-ProtocolError Protocol::send_description(token_t token, message_id_t msg_id, int desc_flags)
+ProtocolError Protocol::send_description(token_t token, message_id_t msg_id, int desc_flags,
+                                         const CoAPBlock* block)
 {
+    // The metrics change every time they're generated, so their blocks wouldn't add up
+    if (block && !(descriptor.append_metrics && ((desc_flags & ~DESCRIBE_METRICS_DELTA) == DESCRIBE_METRICS)))
+    {
+        return send_description_block(token, msg_id, desc_flags, *block);
+    }
     Message message;
     channel.create(message);
     uint8_t* buf = message.buf();
@@ -612,6 +709,61 @@ ProtocolError Protocol::send_description(token_t token, message_id_t msg_id, int
     return generate_and_send_description(channel, message, desc, desc_flags);
 }
 
+/**
+ * Produces the describe message and transmits (PIGGYBACK) the requested block of it.
+ *
+ * The describe message is generated anew for every block, only the data of the requested
+ * block is kept in the message buffer.
+ */
+ProtocolError Protocol::send_description_block(token_t token, message_id_t msg_id, int desc_flags,
+                                               CoAPBlock block)
+{
+    Message message;
+    channel.create(message);
+    uint8_t* buf = message.buf();
+    message.set_id(msg_id);
+    const size_t header_size = CoAP::header(buf, CoAPType::ACK, CoAPCode::CONTENT, sizeof(token), &token, msg_id);
+    // Leave room for the Block2 option and the payload marker, the option is encoded once the
+    // total size of the describe message is known
+    const size_t payload_offs = header_size + CoAP::MAX_BLOCK_OPTION_SIZE + 1;
+    // Use a smaller block size if the requested one doesn't fit in the message buffer
+    while (block.szx > 0 && payload_offs + block.size() > message.capacity())
+    {
+        --block.szx;
+        block.num <<= 1;
+    }
+    if (payload_offs + block.size() > message.capacity() || block.num > CoAPBlock::MAX_NUM)
+    {
+        return INSUFFICIENT_STORAGE;
+    }
+
+    BlockAppender appender(buf + payload_offs, block.size(), block.offset());
+    build_describe_message(appender, desc_flags);
+
+    size_t size = 0;
+    if (block.offset() < appender.dataSize())
+    {
+        size = std::min(appender.dataSize() - block.offset(), block.size());
+    }
+    else if (block.num > 0)
+    {
+        LOG(WARN, "Describe block %u is out of range", block.num);
+        message.set_length(Messages::coded_ack(buf, token, CoAPCode::BAD_OPTION, msg_id >> 8, msg_id & 0xff));
+        return channel.send(message);
+    }
+    block.more = (block.offset() + size < appender.dataSize());
+    size_t offs = header_size + CoAP::block_option(buf + header_size, CoAPOption::NONE, CoAPOption::BLOCK2, block);
+    buf[offs++] = 0xff; // payload marker
+    memmove(buf + offs, buf + payload_offs, size);
+    message.set_length(offs + size);
+
+    LOG(INFO, "Posting '%s%s' describe message, block %u (%u/%u bytes)", desc_flags & DESCRIBE_SYSTEM ? "S" : "",
+        desc_flags & DESCRIBE_APPLICATION ? "A" : "", block.num, (unsigned)(block.offset() + size),
+        (unsigned)appender.dataSize());
+
+    return send_description_message(channel, message, desc_flags, !block.more);
+}
+
 int Protocol::ChunkedTransferCallbacks::prepare_for_firmware_update(FileTransfer::Descriptor& data, uint32_t flags, void* reserved)
 {
 	return callbacks->prepare_for_firmware_update(data, flags, reserved);
@@ -19,6 +19,254 @@
 
 #include "protocol.h"
 
-void particle::protocol::Publisher::add_ack_handler(message_id_t msg_id, CompletionHandler handler) {
+namespace particle { namespace protocol {
+
+ProtocolError Publisher::send_event(MessageChannel& channel, const char* event_name,
+		const char* data, size_t data_size, int content_type, int ttl, EventType::Enum event_type,
+		int flags, system_tick_t time, CompletionHandler handler, int priority, system_tick_t timeout)
+{
+	if (data_size > MAX_EVENT_DATA_LENGTH) {
+		handler.setError(toSystemError(INSUFFICIENT_STORAGE));
+		return INSUFFICIENT_STORAGE;
+	}
+	const bool is_system_event = is_system(event_name);
+	// Application events are not allowed to overtake the deferred ones, unless they have a higher
+	// priority than any of them
+	if ((!is_system_event && deferred_count && priority <= deferred[next_deferred_event()].priority) ||
+			is_rate_limited(is_system_event, time)) {
+		if (is_system_event || !defer_event(event_name, data, data_size, content_type, ttl, event_type,
+				flags, time, handler, priority, timeout)) {
+			g_rateLimitedEventsCounter++;
+			handler.setError(toSystemError(BANDWIDTH_EXCEEDED));
+			return BANDWIDTH_EXCEEDED;
+		}
+		return NO_ERROR;
+	}
+	return send_now(channel, event_name, data, data_size, content_type, ttl, event_type, flags, time,
+			std::move(handler));
+}
+
+ProtocolError Publisher::process(MessageChannel& channel, system_tick_t millis)
+{
+	drop_expired_events(millis);
+	while (deferred_count && app_bucket.take(millis)) {
+		const size_t index = next_deferred_event();
+		DeferredEvent& e = deferred[index];
+		const char* name = deferred_data.data() + deferred_data_offset(index);
+		const char* data = e.has_data ? name + e.name_size + 1 : nullptr;
+		const ProtocolError error = send_now(channel, name, data, e.data_size, e.content_type, e.ttl,
+				e.event_type, e.flags, e.time, std::move(e.handler));
+		remove_deferred_event(index);
+		if (error != NO_ERROR) {
+			return error;
+		}
+	}
+	update_diagnostics();
+	return NO_ERROR;
+}
+
+void Publisher::reset()
+{
+	while (deferred_count) {
+		deferred[0].handler.setError(SYSTEM_ERROR_CANCELLED);
+		remove_deferred_event(0);
+	}
+	for (PendingAck& p: pending_acks) {
+		p.active = false;
+	}
+	update_diagnostics();
+}
+
+void Publisher::message_complete(message_id_t msg_id, bool success, system_tick_t millis)
+{
+	for (PendingAck& p: pending_acks) {
+		if (p.active && p.id == msg_id) {
+			p.active = false;
+			if (success) {
+				g_publishTimeHistogram.add(millis - p.time);
+			}
+			break;
+		}
+	}
+}
+
+void Publisher::track_ack(Message& message, system_tick_t time)
+{
+	if (message.get_type() != CoAPType::CON || !message.has_id()) {
+		return;
+	}
+	PendingAck& p = pending_acks[pending_ack_next];
+	p.time = time;
+	p.id = message.get_id();
+	p.active = true;
+	pending_ack_next = (pending_ack_next + 1) % pending_acks.size();
+}
+
+ProtocolError Publisher::send_now(MessageChannel& channel, const char* event_name,
+		const char* data, size_t data_size, int content_type, int ttl, EventType::Enum event_type,
+		int flags, system_tick_t time, CompletionHandler handler)
+{
+	Message message;
+	channel.create(message);
+	bool confirmable = channel.is_unreliable();
+	if (flags & EventType::NO_ACK) {
+		confirmable = false;
+	} else if (flags & EventType::WITH_ACK) {
+		confirmable = true;
+	}
+	// The event data is passed to the channel as a separate segment so that it doesn't
+	// have to be copied to the message buffer first
+	size_t msglen = Messages::event_header(message.buf(), 0, event_name, data != nullptr, ttl,
+			event_type, confirmable, content_type);
+	message.set_length(msglen);
+	const MessageSegment segment = { (const uint8_t*)data, data ? data_size : 0 };
+	const ProtocolError result = channel.send_segments(message, &segment, data ? 1 : 0);
+	if (result == NO_ERROR) {
+		track_ack(message, time);
+		// Register completion handler only if acknowledgement was requested explicitly
+		if ((flags & EventType::WITH_ACK) && message.has_id()) {
+		    add_ack_handler(message.get_id(), std::move(handler));
+		} else {
+		    handler.setResult();
+		}
+	} else {
+		handler.setError(toSystemError(result));
+	}
+	return result;
+}
+
+bool Publisher::defer_event(const char* event_name, const char* data, size_t data_size, int content_type,
+		int ttl, EventType::Enum event_type, int flags, system_tick_t time, CompletionHandler& handler,
+		int priority, system_tick_t timeout)
+{
+	const size_t name_size = strnlen(event_name, MAX_EVENT_NAME_LENGTH);
+	if (!data) {
+		data_size = 0;
+	}
+	const size_t size = name_size + 1 + (data ? data_size + 1 : 0);
+	if (size > deferred_data.size()) {
+		return false;
+	}
+	// Make room for the event by displacing the deferred events of a lower priority
+	while (deferred_count >= deferred.size() || deferred_data_size + size > deferred_data.size()) {
+		const size_t index = displaceable_deferred_event(priority);
+		if (index == deferred_count) {
+			return false;
+		}
+		g_rateLimitedEventsCounter++;
+		deferred[index].handler.setError(toSystemError(BANDWIDTH_EXCEEDED));
+		remove_deferred_event(index);
+	}
+	char* p = deferred_data.data() + deferred_data_size;
+	memcpy(p, event_name, name_size);
+	p[name_size] = '\0';
+	if (data) {
+		p += name_size + 1;
+		memcpy(p, data, data_size);
+		p[data_size] = '\0';
+	}
+	deferred_data_size += size;
+
+	DeferredEvent& e = deferred[deferred_count];
+	e.handler = std::move(handler);
+	e.time = time;
+	e.deadline = time + timeout;
+	e.ttl = ttl;
+	e.name_size = name_size;
+	e.data_size = data_size;
+	e.content_type = content_type;
+	e.event_type = event_type;
+	e.flags = flags;
+	e.priority = priority;
+	e.has_data = (data != nullptr);
+	e.has_deadline = (timeout != 0);
+	++deferred_count;
+	update_diagnostics();
+	return true;
+}
+
+bool Publisher::is_sent_before(const DeferredEvent& a, const DeferredEvent& b)
+{
+	if (a.priority != b.priority) {
+		return a.priority > b.priority;
+	}
+	if (a.has_deadline && b.has_deadline) {
+		return (int32_t)(a.deadline - b.deadline) <= 0;
+	}
+	// An event with a deadline is sent before an event without one
+	return a.has_deadline || !b.has_deadline;
+}
+
+size_t Publisher::next_deferred_event() const
+{
+	size_t next = 0;
+	for (size_t i = 1; i < deferred_count; ++i) {
+		if (!is_sent_before(deferred[next], deferred[i])) {
+			next = i;
+		}
+	}
+	return next;
+}
+
+size_t Publisher::displaceable_deferred_event(int priority) const
+{
+	// Displace the lower priority event that would be sent last
+	size_t index = deferred_count;
+	for (size_t i = 0; i < deferred_count; ++i) {
+		if (deferred[i].priority < priority && (index == deferred_count ||
+				is_sent_before(deferred[index], deferred[i]))) {
+			index = i;
+		}
+	}
+	return index;
+}
+
+void Publisher::drop_expired_events(system_tick_t millis)
+{
+	size_t i = 0;
+	while (i < deferred_count) {
+		const DeferredEvent& e = deferred[i];
+		if (e.has_deadline && e.priority < EventPriority::CRITICAL && (int32_t)(millis - e.deadline) >= 0) {
+			g_expiredEventsCounter++;
+			deferred[i].handler.setError(SYSTEM_ERROR_TIMEOUT);
+			remove_deferred_event(i);
+		} else {
+			++i;
+		}
+	}
+}
+
+size_t Publisher::deferred_data_offset(size_t index) const
+{
+	size_t offset = 0;
+	for (size_t i = 0; i < index; ++i) {
+		const DeferredEvent& e = deferred[i];
+		offset += e.name_size + 1 + (e.has_data ? e.data_size + 1 : 0);
+	}
+	return offset;
+}
+
+void Publisher::remove_deferred_event(size_t index)
+{
+	const DeferredEvent& e = deferred[index];
+	const size_t offset = deferred_data_offset(index);
+	const size_t size = e.name_size + 1 + (e.has_data ? e.data_size + 1 : 0);
+	deferred_data_size -= size;
+	memmove(deferred_data.data() + offset, deferred_data.data() + offset + size, deferred_data_size - offset);
+	for (size_t i = index + 1; i < deferred_count; ++i) {
+		deferred[i - 1] = std::move(deferred[i]);
+	}
+	--deferred_count;
+}
+
+void Publisher::update_diagnostics()
+{
+	g_eventTokensCounter = app_bucket.tokens();
+	g_deferredEventsCounter = deferred_count;
+}
+
+void Publisher::add_ack_handler(message_id_t msg_id, CompletionHandler handler) {
     protocol->add_ack_handler(msg_id, std::move(handler), SEND_EVENT_ACK_TIMEOUT);
 }
+
+}} // namespace particle::protocol
@@ -19,10 +19,13 @@
 
 #pragma once
 
+#include <array>
+
 #include "protocol_defs.h"
 #include "events.h"
 #include "message_channel.h"
 #include "messages.h"
+#include "token_bucket.h"
 
 #include "completion_handler.h"
 #include "communication_diagnostic.h"
@@ -38,7 +41,13 @@ class Publisher
 {
 public:
 	explicit Publisher(Protocol* protocol) :
-			protocol(protocol)
+			protocol(protocol),
+			app_bucket(APPLICATION_EVENT_BURST, APPLICATION_EVENT_INTERVAL),
+			system_bucket(SYSTEM_EVENT_BURST, SYSTEM_EVENT_INTERVAL),
+			deferred_count(0),
+			deferred_data_size(0),
+			pending_acks(),
+			pending_ack_next(0)
 	{
 	}
 
@@ -47,53 +56,85 @@ public:
 		return !strncmp(event_name, "spark", 5) || !strncmp(event_name, "particle", 8);
 	}
 
+	/**
+	 * Takes a token from the rate limiter of the respective event class.
+	 *
+	 * @return `true` if the event should be rate limited.
+	 */
 	bool is_rate_limited(bool is_system_event, system_tick_t millis)
 	{
-		if (is_system_event)
-		{
-			static uint16_t lastMinute = 0;
-			static uint8_t eventsThisMinute = 0;
-
-			uint16_t currentMinute = uint16_t(millis >> 16);
-			if (currentMinute == lastMinute)
-			{      // == handles millis() overflow
-				if (eventsThisMinute == 255)
-					return true;
-			}
-			else
-			{
-				lastMinute = currentMinute;
-				eventsThisMinute = 0;
-			}
-			eventsThisMinute++;
-		}
-		else
-		{
-			static system_tick_t recent_event_ticks[5] =
-			{ (system_tick_t) -1000, (system_tick_t) -1000,
-					(system_tick_t) -1000, (system_tick_t) -1000,
-					(system_tick_t) -1000 };
-			static int evt_tick_idx = 0;
-
-			system_tick_t now = recent_event_ticks[evt_tick_idx] = millis;
-			evt_tick_idx++;
-			evt_tick_idx %= 5;
-			if (now - recent_event_ticks[evt_tick_idx] < 1000)
-			{
-				// exceeded allowable burst of 4 events per second
-				return true;
-			}
-		}
-		return false;
+		TokenBucket& bucket = is_system_event ? system_bucket : app_bucket;
+		const bool limited = !bucket.take(millis);
+		update_diagnostics();
+		return limited;
 	}
 
+	/**
+	 * Sets the rate limit for application events.
+	 *
+	 * @param burst Maximum number of events that can be sent in a burst.
+	 * @param interval Interval in milliseconds at which the burst allowance is replenished by one event.
+	 */
+	void set_rate_limit(uint16_t burst, system_tick_t interval)
+	{
+		app_bucket.configure(burst, interval);
+		update_diagnostics();
+	}
+
+	/**
+	 * Sends an event.
+	 *
+	 * A rate-limited application event is stored in the deferral queue and sent by `process()` as
+	 * soon as the rate limiter allows. In this case the completion handler is invoked after the
+	 * event is actually sent. `BANDWIDTH_EXCEEDED` is returned if the queue is full and none of the
+	 * queued events has a lower priority than the new event.
+	 */
 	ProtocolError send_event(MessageChannel& channel, const char* event_name,
 			const char* data, int ttl, EventType::Enum event_type, int flags,
 			system_tick_t time, CompletionHandler handler)
 	{
-		bool is_system_event = is_system(event_name);
-		bool rate_limited = is_rate_limited(is_system_event, time);
-		if (rate_limited) {
+		return send_event(channel, event_name, data, data ? strnlen(data, MAX_EVENT_DATA_LENGTH) : 0,
+				ContentType::TEXT, ttl, event_type, flags, time, std::move(handler));
+	}
+
+	/**
+	 * Sends an event with the data of the given size and content format.
+	 *
+	 * The data doesn't need to be null-terminated. A Content-Format option is added to the message
+	 * unless the content format is `ContentType::TEXT`. `INSUFFICIENT_STORAGE` is returned if the
+	 * data is larger than `MAX_EVENT_DATA_LENGTH`.
+	 *
+	 * `priority` and `timeout` only matter if the event gets deferred. An application event with a
+	 * higher priority than all deferred events is sent immediately if the rate limiter allows. A
+	 * deferred event that has been waiting for more than `timeout` milliseconds is dropped with
+	 * `SYSTEM_ERROR_TIMEOUT`, unless it's an `EventPriority::CRITICAL` event. If `timeout` is 0,
+	 * the event has no deadline.
+	 */
+	ProtocolError send_event(MessageChannel& channel, const char* event_name,
+			const char* data, size_t data_size, int content_type, int ttl, EventType::Enum event_type,
+			int flags, system_tick_t time, CompletionHandler handler, int priority = EventPriority::NORMAL,
+			system_tick_t timeout = 0);
+
+	/**
+	 * Sends several events in a single message.
+	 *
+	 * The batch is accounted as a single event by the rate limiter. A batch is considered to be
+	 * a system batch only if all of its events are system events. Rate-limited batches are not deferred.
+	 */
+	ProtocolError send_events(MessageChannel& channel, const EventBatchEntry* events, size_t count,
+			int ttl, EventType::Enum event_type, int flags, system_tick_t time, CompletionHandler handler)
+	{
+		if (!events || !count) {
+			return INVALID_STATE;
+		}
+		bool is_system_event = true;
+		for (size_t i = 0; i < count; ++i) {
+			if (!events[i].name || !is_system(events[i].name)) {
+				is_system_event = false;
+				break;
+			}
+		}
+		if ((!is_system_event && deferred_count) || is_rate_limited(is_system_event, time)) {
 			g_rateLimitedEventsCounter++;
 			return BANDWIDTH_EXCEEDED;
 		}
@@ -106,12 +147,15 @@ public:
 		} else if (flags & EventType::WITH_ACK) {
 			confirmable = true;
 		}
-		size_t msglen = Messages::event(message.buf(), 0, event_name, data, ttl,
+		size_t msglen = Messages::events(message.buf(), message.capacity(), 0, events, count, ttl,
 				event_type, confirmable);
+		if (!msglen) {
+			return INSUFFICIENT_STORAGE;
+		}
 		message.set_length(msglen);
 		const ProtocolError result = channel.send(message);
 		if (result == NO_ERROR) {
-			// Register completion handler only if acknowledgement was requested explicitly
+			track_ack(message, time);
 			if ((flags & EventType::WITH_ACK) && message.has_id()) {
 			    add_ack_handler(message.get_id(), std::move(handler));
 			} else {
@@ -121,8 +165,100 @@ public:
 		return result;
 	}
 
+	/**
+	 * Drops the expired deferred events and sends the remaining ones for which the rate limiter
+	 * has tokens available, in the order of their priority, then their deadline.
+	 */
+	ProtocolError process(MessageChannel& channel, system_tick_t millis);
+
+	/**
+	 * Cancels all deferred events.
+	 */
+	void reset();
+
+	/**
+	 * Notifies the publisher that a confirmable message has been acknowledged or rejected.
+	 * The time it took to deliver an event, from the moment it was published, is recorded
+	 * in the `pub:time` diagnostics.
+	 */
+	void message_complete(message_id_t msg_id, bool success, system_tick_t millis);
+
+	size_t deferred_events() const { return deferred_count; }
+
 private:
+	struct DeferredEvent
+	{
+		CompletionHandler handler;
+		system_tick_t time;
+		system_tick_t deadline;
+		int ttl;
+		uint16_t name_size;
+		uint16_t data_size;
+		uint16_t content_type;
+		EventType::Enum event_type;
+		uint8_t flags;
+		int8_t priority;
+		bool has_data;
+		bool has_deadline;
+	};
+
 	Protocol* protocol;
+	TokenBucket app_bucket;
+	TokenBucket system_bucket;
+
+	// Deferred events are stored in FIFO order. Their names and data are stored one after
+	// another in deferred_data, each followed by a null terminator
+	std::array<DeferredEvent, PROTOCOL_DEFERRED_EVENT_COUNT> deferred;
+	std::array<char, PROTOCOL_DEFERRED_EVENT_BUFFER_SIZE> deferred_data;
+	size_t deferred_count;
+	size_t deferred_data_size;
+
+	// Confirmable events that await acknowledgement. If there are more events in flight than
+	// there are entries, the oldest ones are not measured
+	struct PendingAck
+	{
+		system_tick_t time;
+		message_id_t id;
+		bool active;
+	};
+
+	std::array<PendingAck, 4> pending_acks;
+	size_t pending_ack_next;
+
+	ProtocolError send_now(MessageChannel& channel, const char* event_name,
+			const char* data, size_t data_size, int content_type, int ttl, EventType::Enum event_type,
+			int flags, system_tick_t time, CompletionHandler handler);
+
+	bool defer_event(const char* event_name, const char* data, size_t data_size, int content_type,
+			int ttl, EventType::Enum event_type, int flags, system_tick_t time, CompletionHandler& handler,
+			int priority, system_tick_t timeout);
+
+	void track_ack(Message& message, system_tick_t time);
+
+	/**
+	 * Returns the index of the deferred event that should be sent next.
+	 */
+	size_t next_deferred_event() const;
+
+	/**
+	 * Returns the index of the deferred event that can be displaced by an event of the given
+	 * priority, or `deferred_count` if there's no such event.
+	 */
+	size_t displaceable_deferred_event(int priority) const;
+
+	/**
+	 * Returns `true` if the deferred event `a` should be sent before the deferred event `b`.
+	 * The events are expected to be stored in this order.
+	 */
+	static bool is_sent_before(const DeferredEvent& a, const DeferredEvent& b);
+
+	void drop_expired_events(system_tick_t millis);
+
+	size_t deferred_data_offset(size_t index) const;
+
+	void remove_deferred_event(size_t index);
+
+	void update_diagnostics();
 
 	void add_ack_handler(message_id_t msg_id, CompletionHandler handler);
 };
@@ -23,6 +23,7 @@
 #include "handshake.h"
 #include "debug.h"
 #include <stdlib.h>
+#include <stddef.h>
 
 using particle::CompletionHandler;
 
@@ -129,6 +130,34 @@ int spark_protocol_post_description(ProtocolFacade* protocol, int desc_flags, vo
 
 bool spark_protocol_send_event(ProtocolFacade* protocol, const char *event_name, const char *data,
                 int ttl, uint32_t flags, void* reserved) {
+    ASSERT_ON_SYSTEM_THREAD();
+	CompletionHandler handler;
+	size_t data_size = 0;
+	int content_type = ContentType::TEXT;
+	int priority = EventPriority::NORMAL;
+	system_tick_t timeout = 0;
+	if (reserved) {
+		auto r = static_cast<const spark_protocol_send_event_data*>(reserved);
+		handler = CompletionHandler(r->handler_callback, r->handler_data);
+		if (r->size >= offsetof(spark_protocol_send_event_data, content_type) + sizeof(r->content_type)) {
+			data_size = r->data_size;
+			content_type = r->content_type;
+		}
+		if (r->size >= offsetof(spark_protocol_send_event_data, timeout) + sizeof(r->timeout)) {
+			priority = r->priority;
+			timeout = r->timeout;
+		}
+	}
+	if (!data_size && data) {
+		data_size = strnlen(data, particle::protocol::MAX_EVENT_DATA_LENGTH);
+	}
+	EventType::Enum event_type = EventType::extract_event_type(flags);
+	return protocol->send_event(event_name, data, data_size, content_type, ttl, event_type, flags,
+			std::move(handler), priority, timeout);
+}
+
+bool spark_protocol_send_events(ProtocolFacade* protocol, const EventBatchEntry* events, size_t count,
+                int ttl, uint32_t flags, void* reserved) {
     ASSERT_ON_SYSTEM_THREAD();
 	CompletionHandler handler;
 	if (reserved) {
@@ -136,7 +165,7 @@ bool spark_protocol_send_event(ProtocolFacade* protocol, const char *event_name,
 		handler = CompletionHandler(r->handler_callback, r->handler_data);
 	}
 	EventType::Enum event_type = EventType::extract_event_type(flags);
-	return protocol->send_event(event_name, data, ttl, event_type, flags, std::move(handler));
+	return protocol->send_events(events, count, ttl, event_type, flags, std::move(handler));
 }
 
 bool spark_protocol_send_subscription_device(ProtocolFacade* protocol, const char *event_name, const char *device_id, void*) {
@@ -155,6 +184,44 @@ bool spark_protocol_add_event_handler(ProtocolFacade* protocol, const char *even
     return protocol->add_event_handler(event_name, handler, handler_data, scope, device_id);
 }
 
+bool spark_protocol_add_filtered_event_handler(ProtocolFacade* protocol, const char *event_name,
+    EventHandler handler, SubscriptionScope::Enum scope, const char* device_id, void* handler_data,
+    const spark_protocol_event_filter* filter, void* reserved) {
+    ASSERT_ON_SYSTEM_OR_MAIN_THREAD();
+    (void)reserved;
+    uint8_t flags = 0;
+    const char* data_filter = nullptr;
+    if (filter) {
+        flags = filter->flags;
+        if (filter->size >= offsetof(spark_protocol_event_filter, data_filter) + sizeof(filter->data_filter)) {
+            data_filter = filter->data_filter;
+        }
+    }
+    return protocol->add_event_handler(event_name, handler, handler_data, scope, device_id, flags, data_filter);
+}
+
+int spark_protocol_send_bulk(ProtocolFacade* protocol, const char* name, size_t size, spark_protocol_bulk_read_fn read,
+                void* data, void* reserved) {
+    ASSERT_ON_SYSTEM_THREAD();
+    CompletionHandler handler;
+    if (reserved) {
+        auto r = static_cast<const completion_handler_data*>(reserved);
+        handler = CompletionHandler(r->handler_callback, r->handler_data);
+    }
+    return protocol->send_bulk(name, size, read, data, std::move(handler));
+}
+
+int spark_protocol_add_time_source(ProtocolFacade* protocol, spark_protocol_time_source_fn fn, void* data,
+                void* reserved) {
+    ASSERT_ON_SYSTEM_THREAD();
+    return protocol->add_time_source(fn, data);
+}
+
+int spark_protocol_sync_time_local(ProtocolFacade* protocol, void* reserved) {
+    ASSERT_ON_SYSTEM_THREAD();
+    return protocol->sync_time_local() ? 0 : SYSTEM_ERROR_NOT_FOUND;
+}
+
 bool spark_protocol_send_time_request(ProtocolFacade* protocol, void* reserved) {
     ASSERT_ON_SYSTEM_THREAD();
     (void)reserved;
@@ -199,6 +266,12 @@ int spark_protocol_set_connection_property(ProtocolFacade* protocol, unsigned pr
     } else if (property_id == particle::protocol::Connection::FAST_OTA)
     {
         protocol->set_fast_ota(data);
+    } else if (property_id == particle::protocol::Connection::EVENT_RATE_LIMIT)
+    {
+        protocol->set_event_rate_limit(data >> 16, data & 0xffff);
+    } else if (property_id == particle::protocol::Connection::ADAPTIVE_PING)
+    {
+        protocol->set_adaptive_keepalive(data);
     }
     return 0;
 }
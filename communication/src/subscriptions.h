@@ -19,15 +19,18 @@
 
 #pragma once
 
-namespace particle
-{
-namespace protocol
-{
-
 #include "protocol_defs.h"
 #include "events.h"
+#include "event_filter_index.h"
 #include "message_channel.h"
+#include "messages.h"
 #include <stdint.h>
+#include <string.h>
+
+namespace particle
+{
+namespace protocol
+{
 
 class Subscriptions
 {
@@ -37,6 +40,20 @@ public:
 private:
 	FilteringEventHandler event_handlers[MAX_SUBSCRIPTIONS];
 
+	typedef EventFilterIndex<MAX_SUBSCRIPTIONS>::Mask handler_mask_t;
+
+	EventFilterIndex<MAX_SUBSCRIPTIONS> filter_index;
+
+	// Checksum of the handlers, computed on demand and kept until the handlers change
+	uint32_t handlers_checksum = 0;
+	bool handlers_checksum_valid = false;
+
+	void update_index()
+	{
+		filter_index.update(event_handlers);
+		handlers_checksum_valid = false;
+	}
+
 protected:
 
 	ProtocolError send_subscription(MessageChannel& channel, const char* filter, const char* device_id, SubscriptionScope::Enum scope)
@@ -55,7 +72,45 @@ protected:
 
 	inline ProtocolError send_subscription(MessageChannel& channel, const FilteringEventHandler& handler)
 	{
-		return send_subscription(channel, handler.filter, handler.device_id[0] ? handler.device_id : nullptr, handler.scope);
+		Message message;
+		channel.create(message);
+		message.set_length(subscription(message.buf(), 0, handler));
+		return channel.send(message);
+	}
+
+	/**
+	 * Checks the matching criteria of a handler for which the event name has already been
+	 * matched against the filter prefix.
+	 */
+	static bool matches(const FilteringEventHandler& handler, size_t event_name_length, const char* data,
+			size_t data_size)
+	{
+		if ((handler.flags & EVENT_HANDLER_FLAG_EXACT_NAME) &&
+				strnlen(handler.filter, sizeof(handler.filter)) != event_name_length)
+		{
+			return false;
+		}
+		if (handler.flags & (EVENT_HANDLER_FLAG_DATA_PREFIX | EVENT_HANDLER_FLAG_DATA_CONTAINS))
+		{
+			const size_t filter_len = strnlen(handler.data_filter, sizeof(handler.data_filter));
+			if (!data || data_size < filter_len)
+			{
+				return false;
+			}
+			if (handler.flags & EVENT_HANDLER_FLAG_DATA_PREFIX)
+			{
+				return !memcmp(data, handler.data_filter, filter_len);
+			}
+			for (size_t i = 0; i + filter_len <= data_size; ++i)
+			{
+				if (!memcmp(data + i, handler.data_filter, filter_len))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+		return true;
 	}
 
 public:
@@ -63,10 +118,15 @@ public:
 	Subscriptions()
 	{
 		memset(&event_handlers, 0, sizeof(event_handlers));
+		update_index();
 	}
 
 	uint32_t compute_subscriptions_checksum(calculate_crc_fn calculate_crc)
 	{
+		if (handlers_checksum_valid)
+		{
+			return handlers_checksum;
+		}
 		uint32_t checksum = 0;
 		for_each([&checksum, calculate_crc](FilteringEventHandler& handler){
 			uint32_t chk[4];
@@ -75,8 +135,21 @@ public:
 			chk[2] = calculate_crc((const uint8_t*)handler.filter, sizeof(handler.filter));
 			chk[3] = calculate_crc((const uint8_t*)&handler.scope, sizeof(handler.scope));
 			checksum = calculate_crc((const uint8_t*)chk, sizeof(chk));
+			if (handler.flags & EVENT_HANDLER_MATCH_FLAGS)
+			{
+				// The checksum of the handlers without matching criteria is the same as before
+				// they were introduced
+				const uint8_t flags = handler.flags & EVENT_HANDLER_MATCH_FLAGS;
+				chk[0] = checksum;
+				chk[1] = flags;
+				chk[2] = calculate_crc((const uint8_t*)handler.data_filter, sizeof(handler.data_filter));
+				chk[3] = 0;
+				checksum = calculate_crc((const uint8_t*)chk, sizeof(chk));
+			}
 			return NO_ERROR;
 		});
+		handlers_checksum = checksum;
+		handlers_checksum_valid = true;
 		return checksum;
 	}
 
@@ -132,7 +205,21 @@ public:
 		}
 		event_name_length = next_dst - event_name;
 
-		if (next_src < end && 0x30 == (*next_src & 0xf0))
+		int content_type = ContentType::TEXT;
+		unsigned char max_age_delta = 0x30;
+		if (next_src < end && 0x10 == (*next_src & 0xf0))
+		{
+			// Content-Format option is next
+			size_t option_len = CoAP::option_decode(&next_src);
+			content_type = 0;
+			for (size_t i = 0; i < option_len && next_src < end; ++i)
+			{
+				content_type = (content_type << 8) | *next_src++;
+			}
+			max_age_delta = 0x20;
+		}
+
+		if (next_src < end && max_age_delta == (*next_src & 0xf0))
 		{
 			// Max-Age option is next, which we ignore
 			size_t next_len = CoAP::option_decode(&next_src);
@@ -140,62 +227,57 @@ public:
 		}
 
 		unsigned char *data = NULL;
+		size_t data_size = 0;
 		if (next_src < end && 0xff == *next_src)
 		{
 			// payload is next
 			data = next_src + 1;
+			data_size = end - data;
 			// null terminate data string
 			*end = 0;
 		}
 		// null terminate event name string
 		event_name[event_name_length] = 0;
 
-		const int NUM_HANDLERS = sizeof(event_handlers)
-				/ sizeof(FilteringEventHandler);
-		for (int i = 0; i < NUM_HANDLERS; i++)
+		// handlers are invoked in the order of their registration
+		const handler_mask_t matched = filter_index.match(event_handlers, (const char*)event_name, event_name_length);
+		for (handler_mask_t m = matched; m; m &= m - 1)
 		{
-			if (NULL == event_handlers[i].handler)
-			{
-				break;
-			}
-			const size_t MAX_FILTER_LENGTH = sizeof(event_handlers[i].filter);
-			const size_t filter_length = strnlen(event_handlers[i].filter,
-					MAX_FILTER_LENGTH);
-
-			if (event_name_length < filter_length)
+			const unsigned i = __builtin_ctz(m);
+			if (!matches(event_handlers[i], event_name_length, (const char*)data, data_size))
 			{
-				// does not match this filter, try the next event handler
 				continue;
 			}
-
-			const int cmp = memcmp(event_handlers[i].filter, event_name,
-					filter_length);
-			if (0 == cmp)
+			// don't call the handler directly, use a callback for it.
+			if (!call_event_handler)
 			{
-				// don't call the handler directly, use a callback for it.
-				if (!call_event_handler)
+				if (event_handlers[i].flags & EVENT_HANDLER_FLAG_BINARY)
 				{
-					if (event_handlers[i].handler_data)
-					{
-						EventHandlerWithData handler =
-								(EventHandlerWithData) event_handlers[i].handler;
-						handler(event_handlers[i].handler_data,
-								(char *) event_name, (char *) data);
-					}
-					else
-					{
-						event_handlers[i].handler((char *) event_name,
-								(char *) data);
-					}
+					BinaryEventHandler handler =
+							(BinaryEventHandler) event_handlers[i].handler;
+					handler(event_handlers[i].handler_data, (char *) event_name,
+							(char *) data, data_size, content_type);
+				}
+				else if (event_handlers[i].handler_data)
+				{
+					EventHandlerWithData handler =
+							(EventHandlerWithData) event_handlers[i].handler;
+					handler(event_handlers[i].handler_data,
+							(char *) event_name, (char *) data);
 				}
 				else
 				{
-					call_event_handler(sizeof(FilteringEventHandler),
-							&event_handlers[i], (const char*) event_name,
-							(const char*) data, NULL);
+					event_handlers[i].handler((char *) event_name,
+							(char *) data);
 				}
 			}
-			// else continue the for loop to try the next handler
+			else
+			{
+				ReceivedEventInfo info = { sizeof(ReceivedEventInfo), data_size, content_type };
+				call_event_handler(sizeof(FilteringEventHandler),
+						&event_handlers[i], (const char*) event_name,
+						(const char*) data, &info);
+			}
 		}
 		return NO_ERROR;
 	}
@@ -247,13 +329,15 @@ public:
 				}
 			}
 		}
+		update_index();
 	}
 
 	/**
 	 * Determines if the given handler exists.
 	 */
 	bool event_handler_exists(const char *event_name, EventHandler handler,
-			void *handler_data, SubscriptionScope::Enum scope, const char* id)
+			void *handler_data, SubscriptionScope::Enum scope, const char* id,
+			uint8_t flags = 0, const char* data_filter = nullptr)
 	{
 		const int NUM_HANDLERS = sizeof(event_handlers)
 				/ sizeof(FilteringEventHandler);
@@ -261,7 +345,10 @@ public:
 		{
 			if (event_handlers[i].handler == handler
 					&& event_handlers[i].handler_data == handler_data
-					&& event_handlers[i].scope == scope)
+					&& event_handlers[i].scope == scope
+					&& event_handlers[i].flags == flags
+					&& !strncmp(event_handlers[i].data_filter, data_filter ? data_filter : "",
+							sizeof(event_handlers[i].data_filter) - 1))
 			{
 				const size_t MAX_FILTER_LEN = sizeof(event_handlers[i].filter);
 				const size_t FILTER_LEN = strnlen(event_name, MAX_FILTER_LEN);
@@ -281,12 +368,16 @@ public:
 	}
 
 	/**
-	 * Adds the given handler.
+	 * Adds the given handler. `flags` is a combination of `EventHandlerFlag` values. `data_filter`
+	 * is used with the flags matching the event data and is truncated to 31 characters.
 	 */
 	ProtocolError add_event_handler(const char *event_name, EventHandler handler,
-			void *handler_data, SubscriptionScope::Enum scope, const char* id)
+			void *handler_data, SubscriptionScope::Enum scope, const char* id, uint8_t flags = 0,
+			const char* data_filter = nullptr)
 	{
-		if (event_handler_exists(event_name, handler, handler_data, scope, id))
+		if (!data_filter)
+			flags &= ~(EVENT_HANDLER_FLAG_DATA_PREFIX | EVENT_HANDLER_FLAG_DATA_CONTAINS);
+		if (event_handler_exists(event_name, handler, handler_data, scope, id, flags, data_filter))
 			return NO_ERROR;
 
 		const int NUM_HANDLERS = sizeof(event_handlers) / sizeof(FilteringEventHandler);
@@ -306,6 +397,13 @@ public:
 				memcpy(event_handlers[i].device_id, id, id_len);
 				event_handlers[i].device_id[id_len] = 0;
 				event_handlers[i].scope = scope;
+				event_handlers[i].flags = flags;
+				const size_t MAX_DATA_FILTER_LEN = sizeof(event_handlers[i].data_filter) - 1;
+				const size_t data_filter_len = data_filter ? strnlen(data_filter, MAX_DATA_FILTER_LEN) : 0;
+				memcpy(event_handlers[i].data_filter, data_filter, data_filter_len);
+				memset(event_handlers[i].data_filter + data_filter_len, 0,
+						sizeof(event_handlers[i].data_filter) - data_filter_len);
+				update_index();
 				return NO_ERROR;
 			}
 		}
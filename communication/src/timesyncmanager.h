@@ -2,20 +2,78 @@
 
 #include "protocol_defs.h"
 #include "service_debug.h"
+#include "system_error.h"
+
+#include <ctime>
 
 namespace particle { namespace protocol {
 
+/**
+ * Callback providing the current time from a source other than the cloud.
+ *
+ * @return 0 on success, or a negative result code if the source cannot provide the time.
+ */
+typedef int (*time_source_fn)(time_t* time, void* data);
+
+/**
+ * Keeps track of the time synchronization with the cloud.
+ *
+ * Local time sources, such as the network time of a cellular modem, can be registered in order
+ * of preference. These are queried first, and the cloud is only asked for the time if none of
+ * them can provide it.
+ */
 class TimeSyncManager
 {
 public:
+    static const unsigned MAX_TIME_SOURCES = 4;
+
     TimeSyncManager()
         : lastSyncMillis_{0},
           requestSentMillis_{0},
           lastSyncTime_{0},
+          sourceCount_{0},
           expectingResponse_{false}
     {
     }
 
+    int add_source(time_source_fn fn, void* data)
+    {
+        if (!fn) {
+            return SYSTEM_ERROR_INVALID_ARGUMENT;
+        }
+        if (sourceCount_ >= MAX_TIME_SOURCES) {
+            return SYSTEM_ERROR_TOO_LARGE;
+        }
+        sources_[sourceCount_].fn = fn;
+        sources_[sourceCount_].data = data;
+        ++sourceCount_;
+        return 0;
+    }
+
+    /**
+     * Set the time from the first local source that can provide it.
+     *
+     * The `param` argument of the callback is the 1-based index of the source.
+     *
+     * @return `true` if the time has been set.
+     */
+    template <typename Callback>
+    bool sync_local(system_tick_t mil, Callback set_time) {
+        for (unsigned i = 0; i < sourceCount_; ++i) {
+            time_t tm = 0;
+            const int r = sources_[i].fn(&tm, sources_[i].data);
+            if (r < 0 || tm <= 0) {
+                continue;
+            }
+            LOG(INFO, "Time obtained from local source %u: %lu", i + 1, (unsigned long)tm);
+            set_time(tm, i + 1, nullptr);
+            lastSyncTime_ = tm;
+            lastSyncMillis_ = mil;
+            return true;
+        }
+        return false;
+    }
+
     void reset()
     {
         expectingResponse_ = false;
@@ -55,9 +113,16 @@ public:
 
 
 private:
+    struct Source {
+        time_source_fn fn;
+        void* data;
+    };
+
+    Source sources_[MAX_TIME_SOURCES];
     system_tick_t lastSyncMillis_;
     system_tick_t requestSentMillis_;
     time_t lastSyncTime_;
+    unsigned sourceCount_;
     bool expectingResponse_;
 };
 
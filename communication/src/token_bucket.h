@@ -0,0 +1,105 @@
+#pragma once
+
+#include "protocol_defs.h"
+
+namespace particle { namespace protocol {
+
+/**
+ * A token bucket rate limiter.
+ *
+ * The bucket holds up to `capacity` tokens and is refilled with one token every `interval`
+ * milliseconds. Each rate-limited operation takes a single token from the bucket.
+ */
+class TokenBucket
+{
+	uint16_t capacity_;
+	uint16_t tokens_;
+	system_tick_t interval_;
+	system_tick_t last_refill_;
+	bool started_;
+
+public:
+	TokenBucket(uint16_t capacity, system_tick_t interval) :
+			capacity_(capacity),
+			tokens_(capacity),
+			interval_(interval),
+			last_refill_(0),
+			started_(false)
+	{
+	}
+
+	/**
+	 * Reconfigures the bucket. The bucket is refilled to its new capacity.
+	 */
+	void configure(uint16_t capacity, system_tick_t interval)
+	{
+		capacity_ = capacity;
+		interval_ = interval;
+		reset();
+	}
+
+	void reset()
+	{
+		tokens_ = capacity_;
+		started_ = false;
+	}
+
+	/**
+	 * Takes a token from the bucket.
+	 *
+	 * @return `true` if a token was available, or `false` if the operation should be rate limited.
+	 */
+	bool take(system_tick_t millis)
+	{
+		if (!available(millis))
+		{
+			return false;
+		}
+		--tokens_;
+		return true;
+	}
+
+	/**
+	 * Returns `true` if the bucket has at least one token.
+	 */
+	bool available(system_tick_t millis)
+	{
+		refill(millis);
+		return tokens_ > 0;
+	}
+
+	/**
+	 * Returns the number of tokens in the bucket, as of the last refill.
+	 */
+	uint16_t tokens() const { return tokens_; }
+
+	uint16_t capacity() const { return capacity_; }
+
+	system_tick_t interval() const { return interval_; }
+
+private:
+	void refill(system_tick_t millis)
+	{
+		if (!started_ || tokens_ >= capacity_)
+		{
+			// The refill period starts when the first token is taken from a full bucket
+			last_refill_ = millis;
+			started_ = true;
+			return;
+		}
+		if (!interval_)
+		{
+			tokens_ = capacity_;
+			return;
+		}
+		const system_tick_t elapsed = millis - last_refill_; // handles millis() overflow
+		const system_tick_t count = elapsed / interval_;
+		if (count)
+		{
+			tokens_ = (count >= system_tick_t(capacity_ - tokens_)) ? capacity_ : tokens_ + count;
+			last_refill_ += count * interval_;
+		}
+	}
+};
+
+}}
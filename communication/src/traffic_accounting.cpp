@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "traffic_accounting.h"
+
+#include "communication_diagnostic.h"
+#include "messages.h"
+
+namespace particle { namespace protocol {
+
+namespace {
+
+bool is_response(const CoAPMessageView& msg)
+{
+	return CoAPType::is_reply(msg.type()) || (msg.code() >> 5) >= 2;
+}
+
+} // namespace
+
+TrafficAccounting::TrafficAccounting()
+{
+	reset();
+}
+
+void TrafficAccounting::sent(const uint8_t* buf, size_t size, size_t bytes)
+{
+	*g_cloudBytesSentByClass[classify(buf, size, true)] += bytes;
+}
+
+void TrafficAccounting::received(const uint8_t* buf, size_t size, size_t bytes)
+{
+	*g_cloudBytesReceivedByClass[classify(buf, size, false)] += bytes;
+}
+
+void TrafficAccounting::handshake(size_t bytes_sent, size_t bytes_received)
+{
+	*g_cloudBytesSentByClass[TrafficClass::HANDSHAKE] += bytes_sent;
+	*g_cloudBytesReceivedByClass[TrafficClass::HANDSHAKE] += bytes_received;
+}
+
+void TrafficAccounting::reset()
+{
+	request_count = 0;
+	next_request = 0;
+}
+
+TrafficClass::Enum TrafficAccounting::request_class(const CoAPMessageView& msg)
+{
+	switch (Messages::decodeType(msg))
+	{
+	case CoAPMessageType::EVENT:
+		return TrafficClass::EVENT;
+	case CoAPMessageType::FUNCTION_CALL:
+		return TrafficClass::FUNCTION;
+	case CoAPMessageType::VARIABLE_REQUEST:
+		return TrafficClass::VARIABLE;
+	case CoAPMessageType::DESCRIBE:
+		return TrafficClass::DESCRIBE;
+	case CoAPMessageType::PING:
+		return TrafficClass::PING;
+	case CoAPMessageType::SAVE_BEGIN:
+	case CoAPMessageType::UPDATE_BEGIN:
+	case CoAPMessageType::UPDATE_DONE:
+	case CoAPMessageType::CHUNK:
+		return TrafficClass::OTA;
+	default:
+		break;
+	}
+	// The describe messages sent by the device are POST requests
+	size_t size = 0;
+	const uint8_t* const path = msg.first_option(&size);
+	if (msg.code() == CoAPCode::POST && path && size && path[0] == 'd')
+		return TrafficClass::DESCRIBE;
+	return TrafficClass::OTHER;
+}
+
+TrafficClass::Enum TrafficAccounting::classify(const uint8_t* buf, size_t size, bool outgoing)
+{
+	CoAPMessageView msg;
+	if (!msg.parse(buf, size))
+		return TrafficClass::OTHER;
+
+	if (!is_response(msg))
+	{
+		Request& req = requests[next_request];
+		req.id = msg.id();
+		req.token_size = msg.token_size();
+		req.token = req.token_size ? msg.token()[0] : 0;
+		req.outgoing = outgoing;
+		req.traffic_class = request_class(msg);
+		next_request = (next_request + 1) % MAX_REQUESTS;
+		if (request_count < MAX_REQUESTS)
+			++request_count;
+		return TrafficClass::Enum(req.traffic_class);
+	}
+
+	// Acknowledgements carry the ID of the request, separate responses carry its token
+	const bool match_id = CoAPType::is_reply(msg.type());
+	for (size_t i = 0; i < request_count; ++i)
+	{
+		// Check the most recent requests first
+		const Request& req = requests[(next_request + MAX_REQUESTS - 1 - i) % MAX_REQUESTS];
+		if (req.outgoing == outgoing)
+			continue;
+		if (match_id ? (req.id == msg.id()) :
+				(req.token_size && msg.token_size() && req.token == msg.token()[0]))
+			return TrafficClass::Enum(req.traffic_class);
+	}
+	return TrafficClass::OTHER;
+}
+
+}} // namespace particle::protocol
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "coap.h"
+
+namespace particle { namespace protocol {
+
+/**
+ * Classes of the cloud traffic tracked by the per-class byte counters.
+ */
+namespace TrafficClass {
+  enum Enum {
+    EVENT,
+    FUNCTION,
+    VARIABLE,
+    DESCRIBE,
+    PING,
+    OTA,        // Update, save and chunk messages
+    HANDSHAKE,  // TLS/DTLS handshake
+    OTHER,
+    COUNT
+  };
+}
+
+/**
+ * Attributes the bytes exchanged by a secure message channel to the class of the CoAP messages
+ * they carry. The byte counts include the TLS/DTLS record overhead.
+ *
+ * Requests are classified by their Uri-Path. Responses and acknowledgements are attributed to the
+ * class of the request they answer, which is looked up among the recently exchanged requests by
+ * the message ID or token.
+ */
+class TrafficAccounting
+{
+public:
+	TrafficAccounting();
+
+	/**
+	 * Account for a message sent to the cloud.
+	 *
+	 * @param buf CoAP message. Only the header and options are inspected.
+	 * @param size Size of the CoAP message.
+	 * @param bytes Number of bytes sent over the network.
+	 */
+	void sent(const uint8_t* buf, size_t size, size_t bytes);
+	/**
+	 * Account for a message received from the cloud.
+	 */
+	void received(const uint8_t* buf, size_t size, size_t bytes);
+	/**
+	 * Account for the bytes exchanged during a handshake.
+	 */
+	void handshake(size_t bytes_sent, size_t bytes_received);
+
+	void reset();
+
+	static TrafficClass::Enum request_class(const CoAPMessageView& msg);
+
+private:
+	struct Request
+	{
+		message_id_t id;
+		token_t token;
+		uint8_t token_size;
+		uint8_t traffic_class;
+		bool outgoing;
+	};
+
+	static const size_t MAX_REQUESTS = 8;
+
+	Request requests[MAX_REQUESTS];
+	size_t request_count;
+	size_t next_request;
+
+	TrafficClass::Enum classify(const uint8_t* buf, size_t size, bool outgoing);
+};
+
+}} // namespace particle::protocol
@@ -22,13 +22,94 @@
 
 #include "endian_util.h"
 
+#include <algorithm>
 #include <memory>
 #include <cstring>
+#include <cmath>
 
 namespace particle {
 
 namespace protocol {
 
+namespace {
+
+// Minimum interval at which the values of observed variables are checked for changes
+const system_tick_t MIN_OBSERVE_CHECK_INTERVAL = 1000;
+
+// Decodes the delta or length field of a CoAP option
+bool decode_option_field(unsigned* val, const uint8_t** p, const uint8_t* end) {
+    if (*val == 13) {
+        if (end - *p < 1) {
+            return false;
+        }
+        *val = 13 + (*p)[0];
+        *p += 1;
+    } else if (*val == 14) {
+        if (end - *p < 2) {
+            return false;
+        }
+        *val = 269 + (((*p)[0] << 8) | (*p)[1]);
+        *p += 2;
+    } else if (*val == 15) {
+        return false;
+    }
+    return true;
+}
+
+// Parses the CoAP option at `p`. Returns a pointer to the next option, or `nullptr` if the option
+// is malformed or there are no more options
+const uint8_t* parse_option(const uint8_t* p, const uint8_t* end, unsigned* number, const uint8_t** data, size_t* size) {
+    if (p >= end || *p == 0xff) { // Payload marker
+        return nullptr;
+    }
+    unsigned delta = *p >> 4;
+    unsigned length = *p & 0x0f;
+    ++p;
+    if (!decode_option_field(&delta, &p, end) || !decode_option_field(&length, &p, end) ||
+            length > (size_t)(end - p)) {
+        return nullptr;
+    }
+    *number += delta;
+    *data = p;
+    *size = length;
+    return p + length;
+}
+
+// Returns the size of a variable value returned by the deprecated `get_variable` callback
+bool compat_value_size(const void* value, SparkReturnType::Enum type, size_t* size) {
+    switch (type) {
+    case SparkReturnType::BOOLEAN: {
+        *size = sizeof(bool);
+        return true;
+    }
+    case SparkReturnType::INT: {
+        *size = sizeof(uint32_t);
+        return true;
+    }
+    case SparkReturnType::DOUBLE: {
+        *size = sizeof(double);
+        return true;
+    }
+    case SparkReturnType::STRING: {
+        *size = strlen((const char*)value);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+// FNV-1a hash of a string value
+uint32_t value_hash(const void* data, size_t size) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        h = (h ^ ((const uint8_t*)data)[i]) * 16777619u;
+    }
+    return h;
+}
+
+} // namespace
+
 struct Variables::Context {
     Context(Variables* self, token_t token) :
             self(self),
@@ -39,12 +120,109 @@ struct Variables::Context {
     token_t token;
 };
 
+struct Variables::BulkContext {
+    BulkContext(Variables* self, token_t token) :
+            self(self),
+            token(token),
+            names_end(nullptr),
+            name(nullptr),
+            buf_size(0),
+            data_size(0),
+            overflow(false) {
+    }
+
+    bool append(const char* key, int type, const void* value, size_t value_size) {
+        uint32_t v = 0;
+        switch (type) {
+        case SparkReturnType::BOOLEAN: {
+            if (value_size < sizeof(bool)) {
+                return append(key, 0, nullptr, 0);
+            }
+            v = *(const bool*)value ? 1 : 0;
+            value = &v;
+            value_size = 1;
+            break;
+        }
+        case SparkReturnType::INT: {
+            if (value_size < sizeof(uint32_t)) {
+                return append(key, 0, nullptr, 0);
+            }
+            v = nativeToBigEndian(*(const uint32_t*)value);
+            value = &v;
+            value_size = sizeof(v);
+            break;
+        }
+        case SparkReturnType::DOUBLE: {
+            if (value_size < sizeof(double)) {
+                return append(key, 0, nullptr, 0);
+            }
+            value_size = sizeof(double);
+            break;
+        }
+        case SparkReturnType::STRING: {
+            break;
+        }
+        default:
+            type = 0;
+            value_size = 0;
+            break;
+        }
+        const size_t key_size = strlen(key);
+        if (overflow || value_size > 0xffff || 1 + key_size + 3 + value_size > buf_size - data_size) {
+            overflow = true;
+            return false;
+        }
+        uint8_t* p = (uint8_t*)buf.get() + data_size;
+        *p++ = key_size;
+        memcpy(p, key, key_size);
+        p += key_size;
+        *p++ = type;
+        *p++ = value_size >> 8;
+        *p++ = value_size & 0xff;
+        memcpy(p, value, value_size);
+        data_size += 1 + key_size + 3 + value_size;
+        return true;
+    }
+
+    Variables* self;
+    token_t token;
+    std::unique_ptr<char[]> names; // Null-terminated names of the variables to read
+    const char* names_end;
+    const char* name; // Name of the variable that is being read
+    std::unique_ptr<char[]> buf; // Response payload
+    size_t buf_size;
+    size_t data_size;
+    bool overflow;
+};
+
+struct Variables::ObserveContext {
+    ObserveContext(Variables* self, size_t index) :
+            self(self),
+            index(index),
+            generation(self->generation_) {
+    }
+
+    Variables* self;
+    size_t index;
+    unsigned generation;
+};
+
 ProtocolError Variables::handle_request(Message& message, token_t token, message_id_t id) {
+    if (is_bulk_request(message)) {
+        return handle_bulk_request(message, token, id);
+    }
     char key[MAX_VARIABLE_KEY_LENGTH + 1];
     auto result = decode_request(message, key);
     if (result != ProtocolError::NO_ERROR) {
         return send_error_ack(message, token, id, CoAPCode::BAD_REQUEST);
     }
+    const int observe = decode_observe_request(message);
+    if (observe == 0) {
+        remove_observer(key);
+    } else if (observe == 1 && add_observer(key, token)) {
+        // The first notification is sent by process() as a separate response
+        return send_empty_ack(message, id);
+    }
     if (protocol_->getDescriptor().get_variable_async) {
         result = handle_request(message, token, id, key);
     } else {
@@ -60,15 +238,13 @@ ProtocolError Variables::handle_request(Message& message, token_t token, message
     if (!ctx) {
         return send_error_ack(message, token, id, CoAPCode::INTERNAL_SERVER_ERROR);
     }
-    // Acknowledge the request
-    const auto result = send_empty_ack(message, id);
-    if (result != ProtocolError::NO_ERROR) {
-        return result;
-    }
-    // Get the value asynchronously
+    // Get the value asynchronously. The request is acknowledged once the callback has been
+    // scheduled, unless the value has been sent in the ACK already
+    ack_context_ = ctx.get();
+    ack_id_ = id;
     const auto& descriptor = protocol_->getDescriptor();
     descriptor.get_variable_async(key, get_variable_callback, ctx.release()); // Transfer the ownership over the context object
-    return ProtocolError::NO_ERROR;
+    return end_request(message, id);
 }
 
 ProtocolError Variables::handle_request_compat(Message& message, token_t token, message_id_t id, const char* key) {
@@ -79,34 +255,272 @@ ProtocolError Variables::handle_request_compat(Message& message, token_t token,
     }
     const auto value_type = descriptor.variable_type(key);
     size_t value_size = 0;
-    switch (value_type) {
-    case SparkReturnType::BOOLEAN: {
-        value_size = sizeof(bool);
-        break;
+    if (!compat_value_size(value, value_type, &value_size)) {
+        // Unsupported variable type
+        return send_error_ack(message, token, id, CoAPCode::INTERNAL_SERVER_ERROR);
     }
-    case SparkReturnType::INT: {
-        value_size = sizeof(uint32_t);
-        break;
+    // Send the value in the ACK
+    piggyback_ = true;
+    ack_id_ = id;
+    const auto result = send_response(token, value, value_size, value_type);
+    piggyback_ = false;
+    return result;
+}
+
+ProtocolError Variables::handle_bulk_request(Message& message, token_t token, message_id_t id) {
+    std::unique_ptr<BulkContext> ctx(new(std::nothrow) BulkContext(this, token));
+    if (!ctx) {
+        return send_error_ack(message, token, id, CoAPCode::INTERNAL_SERVER_ERROR);
+    }
+    // Collect the names of the requested variables
+    const auto& descriptor = protocol_->getDescriptor();
+    const uint8_t* const end = message.buf() + message.length();
+    const uint8_t* p = message.buf() + 4 /* header */ + (message.buf()[0] & 0x0f) /* token */;
+    unsigned num = 0;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t names_size = 0;
+    while ((p = parse_option(p, end, &num, &data, &size))) {
+        if (num == CoAPOption::URI_QUERY) {
+            if (size == 0 || size > MAX_VARIABLE_KEY_LENGTH) {
+                return send_error_ack(message, token, id, CoAPCode::BAD_REQUEST);
+            }
+            names_size += size + 1;
+        }
+    }
+    const bool all = (names_size == 0);
+    if (all) {
+        const int count = descriptor.num_variables();
+        for (int i = 0; i < count; ++i) {
+            names_size += strlen(descriptor.get_variable_key(i)) + 1;
+        }
+    }
+    ctx->names.reset(new(std::nothrow) char[names_size + 1]);
+    // The response is sent in a single message that has the same capacity as the request message
+    ctx->buf_size = message.capacity() - Messages::response_size(0, true /* has_token */);
+    ctx->buf.reset(new(std::nothrow) char[ctx->buf_size]);
+    if (!ctx->names || !ctx->buf) {
+        return send_error_ack(message, token, id, CoAPCode::INTERNAL_SERVER_ERROR);
+    }
+    char* name = ctx->names.get();
+    if (all) {
+        const int count = descriptor.num_variables();
+        for (int i = 0; i < count; ++i) {
+            const char* key = descriptor.get_variable_key(i);
+            const size_t n = strlen(key) + 1;
+            memcpy(name, key, n);
+            name += n;
+        }
+    } else {
+        p = message.buf() + 4 + (message.buf()[0] & 0x0f);
+        num = 0;
+        while ((p = parse_option(p, end, &num, &data, &size))) {
+            if (num == CoAPOption::URI_QUERY) {
+                memcpy(name, data, size);
+                name[size] = '\0';
+                name += size + 1;
+            }
+        }
     }
+    ctx->name = ctx->names.get();
+    ctx->names_end = name;
+    if (!descriptor.get_variable_async) {
+        // Use the compatibility callback
+        for (; ctx->name != ctx->names_end; ctx->name += strlen(ctx->name) + 1) {
+            const auto value = descriptor.get_variable(ctx->name);
+            const auto value_type = descriptor.variable_type(ctx->name);
+            size_t value_size = 0;
+            if (!value || !compat_value_size(value, value_type, &value_size)) {
+                ctx->append(ctx->name, 0 /* type */, nullptr /* value */, 0 /* value_size */);
+            } else if (!ctx->append(ctx->name, value_type, value, value_size)) {
+                break;
+            }
+        }
+        if (ctx->overflow) {
+            return send_error_ack(message, token, id, CoAPCode::REQUEST_ENTITY_TOO_LARGE);
+        }
+    }
+    ack_context_ = ctx.get();
+    ack_id_ = id;
+    get_next_bulk_variable(ctx.release()); // Transfer the ownership over the context object
+    return end_request(message, id);
+}
+
+void Variables::get_next_bulk_variable(BulkContext* ctx) {
+    if (ctx->name == ctx->names_end || ctx->overflow) {
+        begin_response(ctx);
+        send_bulk_response(ctx);
+        piggyback_ = false;
+        return;
+    }
+    const auto& descriptor = protocol_->getDescriptor();
+    descriptor.get_variable_async(ctx->name, get_bulk_variable_callback, ctx);
+}
+
+void Variables::send_bulk_response(BulkContext* ctx) {
+    std::unique_ptr<BulkContext> guard(ctx);
+    if (ctx->overflow) {
+        send_error_response(ctx->token, CoAPCode::REQUEST_ENTITY_TOO_LARGE);
+        return;
+    }
+    Message msg;
+    auto& channel = protocol_->getChannel();
+    if (channel.create(msg) != ProtocolError::NO_ERROR) {
+        return;
+    }
+    if (Messages::response_size(ctx->data_size, true /* has_token */) > msg.capacity()) {
+        send_error_response(msg, ctx->token, CoAPCode::REQUEST_ENTITY_TOO_LARGE);
+        return;
+    }
+    const size_t size = encode_response(msg.buf(), ctx->token, ctx->buf.get(), ctx->data_size);
+    msg.set_length(size);
+    send_response_message(msg);
+}
+
+ProtocolError Variables::process(system_tick_t millis) {
+    const auto& descriptor = protocol_->getDescriptor();
+    for (size_t i = 0; i < MAX_OBSERVERS; ++i) {
+        Observer& obs = observers_[i];
+        if (!obs.active || obs.pending || (!obs.notify &&
+                millis - obs.last_check < std::max(obs.interval, MIN_OBSERVE_CHECK_INTERVAL))) {
+            continue;
+        }
+        obs.last_check = millis;
+        if (descriptor.get_variable_async) {
+            const auto ctx = new(std::nothrow) ObserveContext(this, i);
+            if (!ctx) {
+                continue; // Try again later
+            }
+            obs.pending = true;
+            descriptor.get_variable_async(obs.key, get_observed_variable_callback, ctx); // Transfer the ownership over the context object
+        } else {
+            // Use the compatibility callback
+            const auto value = descriptor.get_variable(obs.key);
+            const auto value_type = descriptor.variable_type(obs.key);
+            size_t value_size = 0;
+            if (!value || !compat_value_size(value, value_type, &value_size)) {
+                obs.active = false;
+                const auto result = send_error_response(obs.token, CoAPCode::NOT_FOUND);
+                if (result != ProtocolError::NO_ERROR) {
+                    return result;
+                }
+                continue;
+            }
+            const auto result = notify_observer(obs, value, value_size, value_type);
+            if (result != ProtocolError::NO_ERROR) {
+                return result;
+            }
+        }
+    }
+    return ProtocolError::NO_ERROR;
+}
+
+void Variables::reset() {
+    for (Observer& obs: observers_) {
+        obs.active = false;
+        obs.pending = false;
+    }
+    ++generation_; // Ignore the values of pending requests
+}
+
+bool Variables::add_observer(const char* key, token_t token) {
+    const auto& descriptor = protocol_->getDescriptor();
+    uint32_t interval = 0;
+    double threshold = 0;
+    if (!descriptor.get_variable_observe_options ||
+            !descriptor.get_variable_observe_options(key, &interval, &threshold)) {
+        return false; // Not an observable variable
+    }
+    Observer* obs = nullptr;
+    for (Observer& o: observers_) {
+        if (o.active && strcmp(o.key, key) == 0) {
+            obs = &o; // Replace the existing observation
+            break;
+        }
+        if (!o.active && !o.pending && !obs) {
+            obs = &o;
+        }
+    }
+    if (!obs) {
+        return false;
+    }
+    if (!obs->active) {
+        memcpy(obs->key, key, sizeof(obs->key));
+        obs->seq = 0;
+    }
+    obs->token = token;
+    obs->interval = interval;
+    obs->threshold = threshold;
+    obs->active = true;
+    obs->notify = true;
+    return true;
+}
+
+void Variables::remove_observer(const char* key) {
+    for (Observer& obs: observers_) {
+        if (obs.active && strcmp(obs.key, key) == 0) {
+            obs.active = false;
+        }
+    }
+}
+
+ProtocolError Variables::notify_observer(Observer& obs, const void* value, size_t value_size,
+        SparkReturnType::Enum value_type) {
+    bool changed = obs.notify;
+    switch (value_type) {
+    case SparkReturnType::BOOLEAN:
+    case SparkReturnType::INT:
     case SparkReturnType::DOUBLE: {
-        value_size = sizeof(double);
+        double v = 0;
+        if (value_type == SparkReturnType::BOOLEAN) {
+            v = *(const bool*)value ? 1 : 0;
+        } else if (value_type == SparkReturnType::INT) {
+            v = *(const int32_t*)value;
+        } else {
+            v = *(const double*)value;
+        }
+        if (v != obs.number && std::fabs(v - obs.number) >= obs.threshold) {
+            changed = true;
+        }
+        if (changed) {
+            obs.number = v;
+        }
         break;
     }
-    case SparkReturnType::STRING: {
-        value_size = strlen((const char*)value);
+    default: {
+        const uint32_t h = value_hash(value, value_size);
+        if (h != obs.hash) {
+            changed = true;
+        }
+        obs.hash = h;
         break;
     }
-    default:
-        // Unsupported variable type
-        return send_error_ack(message, token, id, CoAPCode::INTERNAL_SERVER_ERROR);
     }
-    // Acknowledge the request
-    const auto result = send_empty_ack(message, id);
-    if (result != ProtocolError::NO_ERROR) {
-        return result;
+    if (!changed) {
+        return ProtocolError::NO_ERROR;
     }
-    // Send a separate response
-    return send_response(token, value, value_size, value_type);
+    obs.notify = false;
+    obs.seq = (obs.seq + 1) & 0x00ffffff; // Observe option values are 24-bit
+    return send_response(obs.token, value, value_size, value_type, obs.seq);
+}
+
+int Variables::decode_observe_request(const Message& message) {
+    const uint8_t* const end = message.buf() + message.length();
+    const uint8_t* p = message.buf() + 4 /* header */ + (message.buf()[0] & 0x0f) /* token */;
+    unsigned num = 0;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    while ((p = parse_option(p, end, &num, &data, &size))) {
+        if (num == CoAPOption::URI_QUERY && size == 3) {
+            if (memcmp(data, "o=1", 3) == 0) {
+                return 1;
+            }
+            if (memcmp(data, "o=0", 3) == 0) {
+                return 0;
+            }
+        }
+    }
+    return -1;
 }
 
 ProtocolError Variables::decode_request(Message& message, char* key) {
@@ -128,9 +542,31 @@ ProtocolError Variables::decode_request(Message& message, char* key) {
     return ProtocolError::NO_ERROR;
 }
 
+bool Variables::is_bulk_request(const Message& message) {
+    // A bulk request has a single Uri-Path option
+    const uint8_t* const end = message.buf() + message.length();
+    const uint8_t* p = message.buf() + 4 /* header */ + (message.buf()[0] & 0x0f) /* token */;
+    if (p > end) {
+        return false;
+    }
+    unsigned num = 0;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    unsigned path_count = 0;
+    while ((p = parse_option(p, end, &num, &data, &size))) {
+        if (num == CoAPOption::URI_PATH) {
+            ++path_count;
+        }
+    }
+    return path_count == 1;
+}
+
 ProtocolError Variables::encode_response(Message& message, token_t token, const void* value, size_t value_size,
-        SparkReturnType::Enum value_type) {
+        SparkReturnType::Enum value_type, int observe) {
     size_t msg_size = Messages::response_size(value_size, true /* has_token */);
+    if (observe >= 0) {
+        msg_size += 4; // Observe option
+    }
     if (msg_size > message.capacity()) {
         // Truncate the value data accordingly
         const size_t d = msg_size - message.capacity();
@@ -146,7 +582,7 @@ ProtocolError Variables::encode_response(Message& message, token_t token, const
             return ProtocolError::INSUFFICIENT_STORAGE;
         }
         const uint8_t v = *(const bool*)value ? 1 : 0;
-        msg_size = encode_response(message.buf(), token, &v, sizeof(v));
+        msg_size = encode_response(message.buf(), token, &v, sizeof(v), observe);
         break;
     }
     case SparkReturnType::INT: {
@@ -154,18 +590,18 @@ ProtocolError Variables::encode_response(Message& message, token_t token, const
             return ProtocolError::INSUFFICIENT_STORAGE;
         }
         const uint32_t v = nativeToBigEndian(*(const uint32_t*)value);
-        msg_size = encode_response(message.buf(), token, &v, sizeof(v));
+        msg_size = encode_response(message.buf(), token, &v, sizeof(v), observe);
         break;
     }
     case SparkReturnType::DOUBLE: {
         if (value_size < sizeof(double)) {
             return ProtocolError::INSUFFICIENT_STORAGE;
         }
-        msg_size = encode_response(message.buf(), token, value, sizeof(double));
+        msg_size = encode_response(message.buf(), token, value, sizeof(double), observe);
         break;
     }
     case SparkReturnType::STRING: {
-        msg_size = encode_response(message.buf(), token, value, value_size);
+        msg_size = encode_response(message.buf(), token, value, value_size, observe);
         break;
     }
     default:
@@ -175,24 +611,41 @@ ProtocolError Variables::encode_response(Message& message, token_t token, const
     return ProtocolError::NO_ERROR;
 }
 
-size_t Variables::encode_response(uint8_t* buffer, token_t token, const void* value, size_t value_size) {
+size_t Variables::encode_response(uint8_t* buffer, token_t token, const void* value, size_t value_size, int observe) {
     auto& channel = protocol_->getChannel();
-    return Messages::separate_response_with_payload(buffer, 0 /* message_id */, token, CoAPCode::CONTENT,
-            (const uint8_t*)value, value_size, channel.is_unreliable());
+    if (observe < 0) {
+        return Messages::separate_response_with_payload(buffer, 0 /* message_id */, token, CoAPCode::CONTENT,
+                (const uint8_t*)value, value_size, channel.is_unreliable());
+    }
+    // Separate response with an Observe option
+    size_t size = Messages::separate_response(buffer, 0 /* message_id */, token, CoAPCode::CONTENT,
+            channel.is_unreliable());
+    uint8_t seq[3];
+    seq[0] = (observe >> 16) & 0xff;
+    seq[1] = (observe >> 8) & 0xff;
+    seq[2] = observe & 0xff;
+    size += CoAP::add_option(buffer + size, CoAPOption::NONE, CoAPOption::OBSERVE, seq, sizeof(seq));
+    if (value_size) {
+        buffer[size++] = 0xff; // Payload marker
+        memcpy(buffer + size, value, value_size);
+        size += value_size;
+    }
+    return size;
 }
 
-ProtocolError Variables::send_response(token_t token, const void* value, size_t value_size, SparkReturnType::Enum value_type) {
+ProtocolError Variables::send_response(token_t token, const void* value, size_t value_size, SparkReturnType::Enum value_type,
+        int observe) {
     Message msg;
     auto& channel = protocol_->getChannel();
     ProtocolError result = channel.create(msg);
     if (result != ProtocolError::NO_ERROR) {
         return result;
     }
-    result = encode_response(msg, token, value, value_size, value_type);
+    result = encode_response(msg, token, value, value_size, value_type, observe);
     if (result != ProtocolError::NO_ERROR) {
         return send_error_response(msg, token, CoAPCode::INTERNAL_SERVER_ERROR);
     }
-    return channel.send(msg);
+    return send_response_message(msg);
 }
 
 ProtocolError Variables::send_error_response(token_t token, uint8_t code) {
@@ -209,7 +662,32 @@ ProtocolError Variables::send_error_response(Message& message, token_t token, ui
     auto& channel = protocol_->getChannel();
     const size_t size = Messages::separate_response(message.buf(), 0 /* message_id */, token, code, channel.is_unreliable());
     message.set_length(size);
-    return channel.send(message);
+    return send_response_message(message);
+}
+
+ProtocolError Variables::send_response_message(Message& message) {
+    if (piggyback_) {
+        piggyback_ = false;
+        Messages::piggyback_response(message.buf());
+        message.set_id(ack_id_);
+    }
+    return protocol_->getChannel().send(message);
+}
+
+void Variables::begin_response(const void* ctx) {
+    if (ctx == ack_context_) {
+        // The request hasn't been acknowledged yet, send the response in the ACK
+        ack_context_ = nullptr;
+        piggyback_ = true;
+    }
+}
+
+ProtocolError Variables::end_request(Message& message, message_id_t id) {
+    if (!ack_context_) {
+        return ProtocolError::NO_ERROR; // The response has been sent in the ACK
+    }
+    ack_context_ = nullptr;
+    return send_empty_ack(message, id);
 }
 
 ProtocolError Variables::send_empty_ack(Message& message, message_id_t id) {
@@ -230,16 +708,49 @@ ProtocolError Variables::send_error_ack(Message& message, token_t token, message
 
 void Variables::get_variable_callback(int result, int type, void* data, size_t size, void* context) {
     const auto p = (Context*)context;
+    p->self->begin_response(p);
     if (result != ProtocolError::NO_ERROR) {
         const auto code = CoAP::codeForProtocolError((ProtocolError)result);
         p->self->send_error_response(p->token, code);
     } else {
         p->self->send_response(p->token, data, size, (SparkReturnType::Enum)type);
     }
+    p->self->piggyback_ = false;
     free(data);
     delete p;
 }
 
+void Variables::get_bulk_variable_callback(int result, int type, void* data, size_t size, void* context) {
+    const auto ctx = (BulkContext*)context;
+    if (result != ProtocolError::NO_ERROR) {
+        type = 0;
+        size = 0;
+    }
+    ctx->append(ctx->name, type, data, size);
+    free(data);
+    ctx->name += strlen(ctx->name) + 1;
+    ctx->self->get_next_bulk_variable(ctx);
+}
+
+void Variables::get_observed_variable_callback(int result, int type, void* data, size_t size, void* context) {
+    const std::unique_ptr<ObserveContext> ctx((ObserveContext*)context);
+    Variables* const self = ctx->self;
+    if (ctx->generation == self->generation_) {
+        Observer& obs = self->observers_[ctx->index];
+        obs.pending = false;
+        if (obs.active) {
+            if (result != ProtocolError::NO_ERROR) {
+                // An error response ends the observation
+                obs.active = false;
+                self->send_error_response(obs.token, CoAP::codeForProtocolError((ProtocolError)result));
+            } else {
+                self->notify_observer(obs, data, size, (SparkReturnType::Enum)type);
+            }
+        }
+    }
+    free(data);
+}
+
 } // namespace protocol
 
 } // namespace particle
@@ -32,6 +32,39 @@ namespace protocol {
 class Protocol;
 class Message;
 
+/**
+ * Handler of variable requests.
+ *
+ * A request for a single variable is a GET request with the URI path `v/<name>`. The response
+ * payload contains the value of the variable.
+ *
+ * A bulk request is a GET request with the URI path `v` and no further path segments. The request
+ * may contain any number of Uri-Query options, each of which is the name of a variable to read;
+ * if there are no such options, all registered variables are read. The response payload is a
+ * sequence of entries, one per variable, encoded as follows:
+ *
+ * - Length of the variable name (1 byte)
+ * - Variable name
+ * - Variable type as defined by the `SparkReturnType::Enum` enum (1 byte), or 0 if the variable
+ *   could not be read
+ * - Length of the value data (2 bytes, big-endian)
+ * - Value data, encoded in the same way as in a response to a single variable request
+ *
+ * If the entries don't fit in one message, the request fails with a 4.13 error and the server is
+ * expected to request a smaller set of variables.
+ *
+ * A single variable request with the Uri-Query option `o=1` registers the server as an observer of
+ * the variable, provided that the application has made the variable observable. The response to
+ * such a request, and every change notification sent afterwards with the same token, carries an
+ * Observe option with the notification's sequence number. A notification is sent when the value
+ * has changed by at least the variable's threshold, but not more often than the variable's minimum
+ * interval. The request option `o=0` cancels the observation. Observations don't survive a
+ * reconnect; the server needs to register again in every session.
+ *
+ * If the value of a variable is available before the request has been acknowledged, which is the
+ * case when the variable is read synchronously, the response is sent in the ACK. Otherwise the
+ * request is acknowledged with an empty ACK and the value is sent in a separate response.
+ */
 class Variables
 {
 public:
@@ -39,30 +72,86 @@ public:
 
     ProtocolError handle_request(Message& message, token_t token, message_id_t id);
 
+    /**
+     * Sends change notifications to the observers of variables.
+     */
+    ProtocolError process(system_tick_t millis);
+
+    /**
+     * Cancels all observations.
+     */
+    void reset();
+
 private:
     struct Context;
+    struct BulkContext;
+    struct ObserveContext;
+
+    struct Observer {
+        char key[MAX_VARIABLE_KEY_LENGTH + 1];
+        double threshold; // Minimum change of a numeric value
+        double number; // Last notified numeric value
+        uint32_t hash; // Hash of the last notified string value
+        uint32_t seq; // Sequence number of the last notification
+        system_tick_t interval; // Minimum interval between notifications
+        system_tick_t last_check; // Time when the value was last checked
+        token_t token;
+        bool active; // The observer slot is in use
+        bool pending; // The value is being retrieved
+        bool notify; // The next notification needs to be sent regardless of the value
+    };
+
+    static const size_t MAX_OBSERVERS = 4;
 
     Protocol* protocol_;
+    Observer observers_[MAX_OBSERVERS];
+    unsigned generation_; // Incremented every time the observations are cancelled
+    const void* ack_context_; // Context of the request that hasn't been acknowledged yet
+    message_id_t ack_id_; // ID of that request
+    bool piggyback_; // The next response is to be sent in the ACK
 
     ProtocolError handle_request(Message& message, token_t token, message_id_t id, const char* key);
     ProtocolError handle_request_compat(Message& message, token_t token, message_id_t id, const char* key);
 
-    ProtocolError decode_request(Message& message, char* key);
-    ProtocolError encode_response(Message& message, token_t token, const void* value, size_t value_size, SparkReturnType::Enum value_type);
-    size_t encode_response(uint8_t* buffer, token_t token, const void* value, size_t value_size);
+    ProtocolError handle_bulk_request(Message& message, token_t token, message_id_t id);
+    void get_next_bulk_variable(BulkContext* ctx);
+    void send_bulk_response(BulkContext* ctx);
+
+    bool add_observer(const char* key, token_t token);
+    void remove_observer(const char* key);
+    ProtocolError notify_observer(Observer& obs, const void* value, size_t value_size, SparkReturnType::Enum value_type);
 
-    ProtocolError send_response(token_t token, const void* value, size_t value_size, SparkReturnType::Enum value_type);
+    ProtocolError decode_request(Message& message, char* key);
+    int decode_observe_request(const Message& message);
+    bool is_bulk_request(const Message& message);
+    ProtocolError encode_response(Message& message, token_t token, const void* value, size_t value_size, SparkReturnType::Enum value_type,
+            int observe = -1);
+    size_t encode_response(uint8_t* buffer, token_t token, const void* value, size_t value_size, int observe = -1);
+
+    ProtocolError send_response(token_t token, const void* value, size_t value_size, SparkReturnType::Enum value_type,
+            int observe = -1);
     ProtocolError send_error_response(token_t token, uint8_t code);
     ProtocolError send_error_response(Message& message, token_t token, uint8_t code);
 
+    ProtocolError send_response_message(Message& message);
+    void begin_response(const void* ctx);
+    ProtocolError end_request(Message& message, message_id_t id);
+
     ProtocolError send_empty_ack(Message& message, message_id_t id);
     ProtocolError send_error_ack(Message& message, token_t token, message_id_t id, uint8_t code);
 
     static void get_variable_callback(int result, int type, void* data, size_t size, void* context); // SparkDescriptor::GetVariableCallback
+    static void get_bulk_variable_callback(int result, int type, void* data, size_t size, void* context); // ditto
+    static void get_observed_variable_callback(int result, int type, void* data, size_t size, void* context); // ditto
 };
 
 inline Variables::Variables(Protocol* protocol) :
-        protocol_(protocol) {
+        protocol_(protocol),
+        observers_(),
+        generation_(0),
+        ack_context_(nullptr),
+        ack_id_(0),
+        piggyback_(false) {
 }
 
 } // namespace protocol
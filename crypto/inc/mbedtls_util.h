@@ -47,6 +47,11 @@ int mbedtls_x509_crt_pem_to_der(const char* pem_crt, size_t pem_len, uint8_t** d
 int mbedtls_pk_pem_to_der(const char* pem_key, size_t pem_len, uint8_t** der_key, size_t* der_len);
 int mbedtls_x509_read_length(const uint8_t* der, size_t len, int concatenated);
 
+// Generates an ephemeral EC keypair in advance to speed up subsequent ECDHE handshakes. This
+// function is meant to be called periodically when the system is idle; it does nothing on
+// platforms that don't support precomputed keys or if enough keys have been generated already
+int mbedtls_ecp_precompute_keypair(void* reserved);
+
 #ifdef  __cplusplus
 }
 #endif
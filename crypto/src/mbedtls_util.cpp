@@ -56,6 +56,11 @@ __attribute__((weak)) mbedtls_callbacks_t* mbedtls_get_callbacks(void* reserved)
 }
 #endif // defined(CRYPTO_PART1_SIZE_OPTIMIZATIONS)
 
+__attribute__((weak)) int mbedtls_ecp_precompute_keypair(void* reserved)
+{
+    return 0;
+}
+
 #if PLATFORM_ID!=3
 unsigned long mbedtls_timing_hardclock()
 {
@@ -30,8 +30,33 @@
 /* Includes ------------------------------------------------------------------*/
 #include "pinmap_hal.h"
 
+#include <stddef.h>
+
 /* Exported types ------------------------------------------------------------*/
 
+/**
+ * Called when one half of the sample buffer has been filled. Runs in an ISR context.
+ *
+ * @param samples Filled half of the buffer.
+ * @param count Number of samples.
+ * @param context User context.
+ */
+typedef void (*hal_adc_continuous_callback_t)(const int16_t* samples, size_t count, void* context);
+
+typedef struct hal_adc_continuous_config {
+    uint16_t size; // Size of this structure
+    uint16_t version;
+    const pin_t* pins; // Pins to sample. Samples of every scan are stored in this order
+    uint8_t pin_count;
+    uint8_t oversample; // Each result is an average of 2^oversample samples (0 to 8)
+    uint16_t reserved;
+    uint32_t sample_rate; // Number of scans per second
+    int16_t* buffer; // Sample buffer
+    size_t buffer_size; // Number of samples in the buffer, a multiple of 2 * pin_count
+    hal_adc_continuous_callback_t callback;
+    void* context;
+} hal_adc_continuous_config;
+
 /* Exported constants --------------------------------------------------------*/
 
 /* Exported macros -----------------------------------------------------------*/
@@ -46,6 +71,16 @@ void HAL_ADC_Set_Sample_Time(uint8_t ADC_SampleTime);
 int32_t HAL_ADC_Read(pin_t pin);
 void HAL_ADC_DMA_Init();
 
+/**
+ * Start sampling the pins continuously.
+ *
+ * Conversions are triggered by a hardware timer and stored to the buffer via DMA. While one half
+ * of the buffer is being filled, the other half is passed to the callback. `HAL_ADC_Read()` cannot
+ * be used while continuous sampling is running.
+ */
+int HAL_ADC_Start_Continuous(const hal_adc_continuous_config* config, void* reserved);
+int HAL_ADC_Stop_Continuous(void* reserved);
+
 #ifdef __cplusplus
 }
 #endif
@@ -100,6 +100,11 @@ typedef enum hal_ble_scan_fp_t {
                                                                    address is a resolvable private address that cannot be resolved. */
 } hal_ble_scan_fp_t;
 
+typedef enum hal_ble_scan_filter_flag_t {
+    BLE_SCAN_FILTER_FLAG_PAYLOAD                = 0x01   /**< Take the advertising data into account when filtering out duplicate reports,
+                                                                   so that a device is reported again whenever its advertising data changes. */
+} hal_ble_scan_filter_flag_t;
+
 typedef enum hal_ble_service_type_t {
     BLE_SERVICE_TYPE_INVALID   = 0,
     BLE_SERVICE_TYPE_PRIMARY   = 1,
@@ -168,6 +173,10 @@ typedef struct hal_ble_scan_params_t {
     uint16_t timeout;                   /**< Scan timeout in 10 ms units. */
     uint8_t active;
     hal_ble_scan_fp_t filter_policy;
+    int8_t rssi_threshold;              /**< Advertising reports with a lower RSSI are ignored (dBm). 0 to disable the filtering. */
+    uint8_t dup_filter_flags;           /**< Duplicate filtering options. See hal_ble_scan_filter_flag_t. */
+    uint16_t dup_filter_period;         /**< Period after which a duplicate report is no longer filtered out, in 10 ms units.
+                                             0 to filter out duplicates until scanning is stopped. */
 } hal_ble_scan_params_t;
 
 /* BLE connection parameters */
@@ -323,6 +332,7 @@ typedef void (*hal_ble_on_scan_result_cb_t)(const hal_ble_scan_result_evt_t* res
 typedef void (*hal_ble_on_disc_service_cb_t)(const hal_ble_svc_discovered_evt_t* event, void* context);
 typedef void (*hal_ble_on_disc_char_cb_t)(const hal_ble_char_discovered_evt_t* event, void* context);
 typedef void (*hal_ble_on_char_evt_cb_t)(const hal_ble_char_evt_t* event, void* context);
+typedef void (*hal_ble_on_tx_complete_cb_t)(hal_ble_conn_handle_t conn_handle, size_t count, void* context);
 
 typedef struct hal_ble_conn_cfg_t {
     uint16_t version;
@@ -346,6 +356,19 @@ typedef struct hal_ble_char_init_t {
     void* context;
 } hal_ble_char_init_t;
 
+typedef struct hal_ble_notify_value_t {
+    const uint8_t* data;
+    size_t len;
+} hal_ble_notify_value_t;
+
+typedef struct hal_ble_gatt_read_t {
+    hal_ble_conn_handle_t conn_handle;  /**< BLE connection handle. */
+    hal_ble_attr_handle_t value_handle; /**< The peer device's Characteristic value handle. */
+    uint8_t* buf;                       /**< Buffer to be filled. */
+    size_t len;                         /**< Size of the buffer. Set to the length of the read data on success. */
+    int result;                         /**< 0 on success, system_error_t on error. */
+} hal_ble_gatt_read_t;
+
 typedef struct hal_ble_cccd_config_t {
     uint16_t version;
     uint16_t size;
@@ -762,6 +785,23 @@ int hal_ble_gap_disconnect(hal_ble_conn_handle_t conn_handle, void* reserved);
  */
 int hal_ble_gap_update_connection_params(hal_ble_conn_handle_t conn_handle, const hal_ble_conn_params_t* conn_params, void* reserved);
 
+/**
+ * Set the throughput requested for a link in the central role.
+ *
+ * The connection events of all the links in the central role are scheduled so that each of them
+ * gets the same share of radio time in the shortest interval that fits all the links. A link that
+ * needs less throughput is given a power-of-two multiple of that interval, so that the events of
+ * different links don't collide. The links are rescheduled whenever a link is connected or
+ * disconnected.
+ *
+ * @param[in]   conn_handle BLE connection handle.
+ * @param[in]   throughput  Requested throughput in bytes per second. 0 to keep the connection
+ *                          parameters of the link as they are.
+ *
+ * @returns     0 on success, system_error_t on error.
+ */
+int hal_ble_gap_set_link_throughput(hal_ble_conn_handle_t conn_handle, uint32_t throughput, void* reserved);
+
 /**
  * Get given connection detail information.
  *
@@ -838,6 +878,36 @@ ssize_t hal_ble_gatt_server_set_characteristic_value(hal_ble_attr_handle_t value
  */
 ssize_t hal_ble_gatt_server_notify_characteristic_value(hal_ble_attr_handle_t value_handle, const uint8_t* buf, size_t len, void* reserved);
 
+/**
+ * Queue several Characteristic values for notification without acknowledgment.
+ *
+ * The values are queued in the BLE stack without waiting for them to be sent, so that all the
+ * available TX buffers can be filled in a single connection event. The function doesn't block:
+ * if the TX buffers are full, it returns the number of values that have been queued so far, and
+ * the caller should retry once the callback set via hal_ble_gatt_server_set_callback_on_tx_complete()
+ * is invoked.
+ *
+ * @param[in]   value_handle    Characteristic value handle.
+ * @param[in]   values          Array of values to be notified.
+ * @param[in]   count           Number of values in the array.
+ *
+ * @returns     Number of values that have been queued, or system_error_t on error.
+ */
+ssize_t hal_ble_gatt_server_notify_characteristic_values(hal_ble_attr_handle_t value_handle, const hal_ble_notify_value_t* values, size_t count, void* reserved);
+
+/**
+ * Set the callback function that is invoked when queued notifications have been sent and the
+ * TX buffers are available again.
+ *
+ * @note The callback is invoked from the BLE event thread.
+ *
+ * @param[in]   callback    Callback function, or NULL to clear the callback.
+ * @param[in]   context     Context of the callback function.
+ *
+ * @returns     0 on success, system_error_t on error.
+ */
+int hal_ble_gatt_server_set_callback_on_tx_complete(hal_ble_on_tx_complete_cb_t callback, void* context, void* reserved);
+
 /**
  * Set Characteristic value and notify it to subscribers with acknowledgment.
  *
@@ -969,6 +1039,21 @@ ssize_t hal_ble_gatt_client_write_without_response(hal_ble_conn_handle_t conn_ha
  */
 ssize_t hal_ble_gatt_client_read(hal_ble_conn_handle_t conn_handle, hal_ble_attr_handle_t attr_handle, uint8_t* buf, size_t len, void* reserved);
 
+/**
+ * Read several Characteristic values, possibly from different peer devices.
+ *
+ * A read request is sent on every link at the same time, so that the reads from different peer
+ * devices complete within the same connection events instead of one after another. The reads
+ * from the same peer device are performed in order.
+ *
+ * @param[in,out]   reads   Array of read operations. The length and the result of each operation
+ *                          are updated when the function returns.
+ * @param[in]       count   Number of operations in the array.
+ *
+ * @returns     Number of successful read operations, or system_error_t on error.
+ */
+ssize_t hal_ble_gatt_client_read_values(hal_ble_gatt_read_t* reads, size_t count, void* reserved);
+
 
 #define HAL_PLATFORM_BLE_BETA_COMPAT 1
 
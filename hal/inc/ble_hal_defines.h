@@ -105,6 +105,7 @@ typedef enum ble_sig_uuid_t {
     BLE_SIG_UUID_RECONNECTION_ADDRESS_CHAR                  = 0x2A03, /**< Reconnection Address Characteristic UUID. It shall be included in the Generic Access Service. */
     BLE_SIG_UUID_PPCP_CHAR                                  = 0x2A04, /**< Peripheral Preferred Connection Parameters Characteristic UUID. It shall be included in the Generic Access Service. */
     BLE_SIG_UUID_SERVICE_CHANGED_CHAR                       = 0x2A05, /**< Service Changed Characteristic UUID. It shall be included in the Generic Attribute Service. */
+    BLE_SIG_UUID_DATABASE_HASH_CHAR                         = 0x2B2A, /**< Database Hash Characteristic UUID. It may be included in the Generic Attribute Service. */
     // Found at https://www.bluetooth.com/specifications/gatt/descriptors
     BLE_SIG_UUID_CHAR_EXTENDED_PROPERTIES_DESC              = 0x2900, /**< Characteristic Extended Properties Descriptor UUID. */
     BLE_SIG_UUID_CHAR_USER_DESCRIPTION_DESC                 = 0x2901, /**< Characteristic User Description Descriptor UUID. */
@@ -73,6 +73,11 @@ typedef enum HAL_CAN_Filters {
   CAN_FILTER_EXTENDED
 } HAL_CAN_Filters;
 
+typedef enum HAL_CAN_Filter_Mode {
+  CAN_FILTER_MODE_MASK, // Accept the IDs that match id in the bits set in mask
+  CAN_FILTER_MODE_LIST  // Accept exactly id and id2
+} HAL_CAN_Filter_Mode;
+
 /* Exported types ------------------------------------------------------------*/
 
 struct CANMessage
@@ -97,6 +102,24 @@ struct CANMessage
 #endif
 };
 
+struct HAL_CAN_Filter
+{
+   uint16_t size;
+   uint8_t  type;  // HAL_CAN_Filters
+   uint8_t  mode;  // HAL_CAN_Filter_Mode
+   uint32_t id;
+   uint32_t mask;  // Used in the mask mode
+   uint32_t id2;   // Used in the list mode
+};
+
+struct HAL_CAN_Stats
+{
+   uint16_t size;
+   uint16_t reserved;
+   uint32_t rx_queue_overflows; // Messages dropped because the receive queue was full
+   uint32_t rx_fifo_overruns;   // Times a hardware FIFO was full and dropped at least one message
+};
+
 /* Exported constants --------------------------------------------------------*/
 
 /* Exported macros -----------------------------------------------------------*/
@@ -134,6 +157,12 @@ void HAL_CAN_Clear_Filters(HAL_CAN_Channel channel,
                            void *reserved);
 bool HAL_CAN_Is_Enabled(HAL_CAN_Channel channel);
 HAL_CAN_Errors HAL_CAN_Error_Status(HAL_CAN_Channel channel);
+bool HAL_CAN_Add_Filter_Ext(HAL_CAN_Channel channel,
+                            const struct HAL_CAN_Filter *filter,
+                            void *reserved);
+int HAL_CAN_Get_Stats(HAL_CAN_Channel channel,
+                      struct HAL_CAN_Stats *stats,
+                      void *reserved);
 
 
 #ifdef __cplusplus
@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include "net_hal.h"
 #include "inet_hal.h"
 #include "system_tick_hal.h"
@@ -41,6 +42,25 @@ typedef enum SimType {
     EXTERNAL_SIM = 2
 } SimType;
 
+/**
+ * Power saving flags.
+ */
+typedef enum cellular_power_saving_flag {
+    CELLULAR_POWER_SAVING_FLAG_PSM = 0x01, ///< Power Saving Mode (PSM).
+    CELLULAR_POWER_SAVING_FLAG_EDRX = 0x02 ///< Extended Discontinuous Reception (eDRX).
+} cellular_power_saving_flag;
+
+/**
+ * Power saving settings.
+ */
+typedef struct cellular_power_saving_config {
+    uint16_t size; ///< Size of this structure.
+    uint16_t flags; ///< Power saving flags (a combination of `cellular_power_saving_flag` values).
+    uint32_t active_time; ///< Active time (T3324) in seconds.
+    uint32_t periodic_tau; ///< Periodic tracking area update interval (T3412) in seconds.
+    uint32_t edrx_cycle; ///< eDRX cycle length in milliseconds.
+} cellular_power_saving_config;
+
 /**
  * Power on and initialize the cellular module,
  * if USART3 not initialized, will be done on first call.
@@ -145,6 +165,45 @@ bool cellular_sim_ready(void* reserved);
  */
 cellular_result_t cellular_registration_timeout_set(system_tick_t timeout, void* reserved);
 
+/**
+ * Set the power saving settings requested from the network.
+ *
+ * With PSM, the modem stays registered on the network while it's not reachable, and doesn't need
+ * to re-register when the device wakes up. With eDRX, the modem listens for paging less often
+ * while it's idle. The timer values are rounded to the nearest values supported by 3GPP, and the
+ * network may grant different values.
+ *
+ * The settings are applied immediately if the modem is on, and every time the modem is initialized.
+ *
+ * @param conf Power saving settings, or `NULL` to disable power saving.
+ * @param reserved Reserved argument. Must be set to `NULL`.
+ *
+ * @returns `SYSTEM_ERROR_NONE` or an error code.
+ * @retval SYSTEM_ERROR_NOT_SUPPORTED The modem doesn't support power saving.
+ */
+int cellular_power_saving_set(const cellular_power_saving_config* conf, void* reserved);
+
+/**
+ * Get the power saving settings granted by the network.
+ *
+ * @param[out] conf Power saving settings. The `size` field has to be set by the caller.
+ * @param reserved Reserved argument. Must be set to `NULL`.
+ *
+ * @returns `SYSTEM_ERROR_NONE` or an error code.
+ */
+int cellular_power_saving_get(cellular_power_saving_config* conf, void* reserved);
+
+/**
+ * Get the time the modem's clock has received from the network (NITZ).
+ *
+ * @param[out] time UTC time.
+ * @param reserved Reserved argument. Must be set to `NULL`.
+ *
+ * @returns `SYSTEM_ERROR_NONE` or an error code.
+ * @retval SYSTEM_ERROR_NOT_FOUND The network hasn't provided the time.
+ */
+int cellular_network_time(time_t* time, void* reserved);
+
 /**
  * Attempts to stop/resume the cellular modem from performing AT operations.
  * Called from another thread or ISR context.
@@ -148,6 +148,32 @@ os_result_t os_thread_yield(void);
  */
 os_result_t os_thread_delay_until(system_tick_t *previousWakeTime, system_tick_t timeIncrement);
 
+#define OS_THREAD_STATS_NAME_MAX_LENGTH 16
+
+/**
+ * Runtime statistics of a thread.
+ */
+typedef struct os_thread_stats {
+    uint16_t size; ///< Size of this structure.
+    os_thread_prio_t priority; ///< Current priority.
+    os_thread_t thread; ///< Thread handle.
+    char name[OS_THREAD_STATS_NAME_MAX_LENGTH]; ///< Thread name (null-terminated).
+    uint32_t cpu_time; ///< CPU time consumed by the thread, in microseconds. Wraps around.
+    uint32_t stack_free_min; ///< Minimum amount of unused stack space, in bytes (stack high-water mark).
+} os_thread_stats_t;
+
+/**
+ * Gets the runtime statistics of all threads.
+ *
+ * If `stats` is NULL, this function returns the current number of threads.
+ *
+ * @param stats Array of structures to fill in. The `size` field of every element needs to be initialized.
+ * @param count Number of elements in the array.
+ * @param total_time Receives the total CPU time, in microseconds, since the scheduler was started. Can be NULL.
+ * @return Number of threads, or a negative result code.
+ */
+int os_thread_get_stats(os_thread_stats_t* stats, size_t count, uint32_t* total_time, void* reserved);
+
 int os_condition_variable_create(condition_variable_t* var);
 void os_condition_variable_destroy(condition_variable_t var);
 
@@ -223,6 +249,28 @@ typedef enum {
  */
 os_scheduler_state_t os_scheduler_get_state(void* reserved);
 
+/**
+ * Statistics of the periods during which context switching was disabled with `os_thread_scheduling()`.
+ */
+typedef struct os_scheduler_stats {
+    uint16_t size; ///< Size of this structure.
+    uint32_t count; ///< Number of times context switching was disabled.
+    uint32_t total_time; ///< Total time during which context switching was disabled, in microseconds. Wraps around.
+    uint32_t max_time; ///< Longest period during which context switching was disabled, in microseconds.
+    const void* max_caller; ///< Return address of the call that started the longest period.
+} os_scheduler_stats_t;
+
+/**
+ * Gets the statistics of the periods during which context switching was disabled.
+ *
+ * Nested calls to `os_thread_scheduling()` are accounted as a single period.
+ *
+ * @param stats Statistics. The `size` field needs to be initialized.
+ * @param reset Reset the statistics after they are retrieved.
+ * @return 0 on success, or a negative result code.
+ */
+int os_scheduler_get_stats(os_scheduler_stats_t* stats, bool reset, void* reserved);
+
 /**
  * Create a new timer. Returns 0 on success.
  */
@@ -195,6 +195,8 @@ typedef struct runtime_info_t {
     uint32_t max_used_heap; // The "highwater mark" for allocated space—that is, the maximum amount of space that was ever allocated.
     uint32_t user_static_ram;
     uint32_t largest_free_block_heap;
+    uint32_t free_blocks_heap;  /* Number of free blocks in the heap. */
+    uint32_t user_heap;         /* Amount of heap memory allocated by the user module. */
 } runtime_info_t;
 
 uint32_t HAL_Core_Runtime_Info(runtime_info_t* info, void* reserved);
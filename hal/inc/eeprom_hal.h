@@ -54,6 +54,26 @@ void HAL_EEPROM_Clear();
 bool HAL_EEPROM_Has_Pending_Erase();
 void HAL_EEPROM_Perform_Pending_Erase();
 
+/**
+ * Enables or disables write-back caching of the EEPROM contents.
+ *
+ * @param flush_delay Maximum time in milliseconds for which changes can be kept in RAM before
+ *        they're written to flash, or 0 to write all changes immediately (default).
+ * @return 0 on success, or a negative result code in case of an error.
+ */
+int HAL_EEPROM_Set_Write_Back(uint32_t flush_delay, void* reserved);
+/**
+ * Writes all pending changes to flash.
+ *
+ * @return 0 on success, or a negative result code in case of an error.
+ */
+int HAL_EEPROM_Flush(void* reserved);
+/**
+ * Writes pending changes to flash if they have been kept in RAM for longer than the flush delay.
+ * This function is called periodically by the system.
+ */
+void HAL_EEPROM_Process(void* reserved);
+
 #ifdef __cplusplus
 }
 #endif
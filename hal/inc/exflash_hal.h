@@ -45,6 +45,34 @@ int hal_exflash_erase_block(uintptr_t addr, size_t num_blocks);
 int hal_exflash_read(uintptr_t addr, uint8_t* data_buf, size_t data_size);
 int hal_exflash_copy_sector(uintptr_t src_addr, size_t dest_addr, size_t data_size);
 
+/**
+ * Completion callback of an asynchronous operation.
+ *
+ * @param result 0 on success, or a non-zero error code.
+ * @param context User context.
+ */
+typedef void (*hal_exflash_async_callback_t)(int result, void* context);
+
+/**
+ * Asynchronous versions of `hal_exflash_write()`, `hal_exflash_erase_sector()` and `hal_exflash_erase_block()`.
+ *
+ * The operation is queued and performed by a background thread, which invokes the callback (if
+ * any) once the operation completes. Queued operations are performed in order. The caller must
+ * keep the data buffer valid, and must not read or write the affected range synchronously, until
+ * the callback is invoked. The callback should return quickly, as it blocks the queue.
+ *
+ * If the scheduler is not running, the operation is performed synchronously and the callback is
+ * invoked before the function returns.
+ *
+ * @return 0 if the operation has been queued, or a non-zero error code.
+ */
+int hal_exflash_write_async(uintptr_t addr, const uint8_t* data_buf, size_t data_size,
+        hal_exflash_async_callback_t callback, void* context);
+int hal_exflash_erase_sector_async(uintptr_t addr, size_t num_sectors, hal_exflash_async_callback_t callback,
+        void* context);
+int hal_exflash_erase_block_async(uintptr_t addr, size_t num_blocks, hal_exflash_async_callback_t callback,
+        void* context);
+
 int hal_exflash_read_special(hal_exflash_special_sector_t sp, uintptr_t addr, uint8_t* data_buf, size_t data_size);
 int hal_exflash_write_special(hal_exflash_special_sector_t sp, uintptr_t addr, const uint8_t* data_buf, size_t data_size);
 int hal_exflash_erase_special(hal_exflash_special_sector_t sp, uintptr_t addr, size_t size);
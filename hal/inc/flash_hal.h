@@ -31,6 +31,14 @@ int hal_flash_read(uintptr_t addr, uint8_t* data_buf, size_t data_size);
 int hal_flash_erase_sector(uintptr_t addr, size_t num_sectors);
 int hal_flash_copy_sector(uintptr_t src_addr, uintptr_t dest_addr, size_t data_size);
 
+/**
+ * Returns the write generation of the internal flash.
+ *
+ * The generation changes every time the internal flash is written or erased by the system
+ * firmware. It is kept in retained memory and thus persists across warm resets.
+ */
+uint32_t hal_flash_write_generation(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif /* __cplusplus */
@@ -96,6 +96,10 @@ DYNALIB_FN(62, hal_ble, hal_ble_set_callback_on_adv_events, int(hal_ble_on_adv_e
 DYNALIB_FN(63, hal_ble, hal_ble_cancel_callback_on_adv_events, int(hal_ble_on_adv_evt_cb_t, void*, void*))
 DYNALIB_FN(64, hal_ble, hal_ble_gatt_server_notify_characteristic_value, ssize_t(hal_ble_attr_handle_t, const uint8_t*, size_t, void*))
 DYNALIB_FN(65, hal_ble, hal_ble_gatt_server_indicate_characteristic_value, ssize_t(hal_ble_attr_handle_t, const uint8_t*, size_t, void*))
+DYNALIB_FN(66, hal_ble, hal_ble_gatt_server_notify_characteristic_values, ssize_t(hal_ble_attr_handle_t, const hal_ble_notify_value_t*, size_t, void*))
+DYNALIB_FN(67, hal_ble, hal_ble_gatt_server_set_callback_on_tx_complete, int(hal_ble_on_tx_complete_cb_t, void*, void*))
+DYNALIB_FN(68, hal_ble, hal_ble_gap_set_link_throughput, int(hal_ble_conn_handle_t, uint32_t, void*))
+DYNALIB_FN(69, hal_ble, hal_ble_gatt_client_read_values, ssize_t(hal_ble_gatt_read_t*, size_t, void*))
 
 DYNALIB_END(hal_ble)
 
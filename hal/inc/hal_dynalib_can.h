@@ -45,6 +45,8 @@ DYNALIB_FN(6, hal_can, HAL_CAN_Add_Filter, bool(HAL_CAN_Channel, uint32_t, uint3
 DYNALIB_FN(7, hal_can, HAL_CAN_Clear_Filters, void(HAL_CAN_Channel, void*))
 DYNALIB_FN(8, hal_can, HAL_CAN_Is_Enabled, bool(HAL_CAN_Channel))
 DYNALIB_FN(9, hal_can, HAL_CAN_Error_Status, HAL_CAN_Errors(HAL_CAN_Channel))
+DYNALIB_FN(10, hal_can, HAL_CAN_Add_Filter_Ext, bool(HAL_CAN_Channel, const HAL_CAN_Filter*, void*))
+DYNALIB_FN(11, hal_can, HAL_CAN_Get_Stats, int(HAL_CAN_Channel, HAL_CAN_Stats*, void*))
 
 DYNALIB_END(hal_can)
 
@@ -25,6 +25,7 @@
 #define	HAL_DYNALIB_GPIO_H
 
 #include "dynalib.h"
+#include "hal_platform.h"
 
 #ifdef DYNALIB_EXPORT
 #include "gpio_hal.h"
@@ -87,7 +88,33 @@ DYNALIB_FN(34, hal_gpio, HAL_PWM_Get_Max_Frequency, uint32_t(uint16_t))
 DYNALIB_FN(35, hal_gpio, HAL_Interrupts_Detach_Ext, int(uint16_t, uint8_t, void*))
 DYNALIB_FN(36, hal_gpio, HAL_Set_Direct_Interrupt_Handler, int(IRQn_Type irqn, HAL_Direct_Interrupt_Handler handler, uint32_t flags, void* reserved))
 
+#if HAL_PLATFORM_ADC_CONTINUOUS
+DYNALIB_FN(37, hal_gpio, HAL_ADC_Start_Continuous, int(const hal_adc_continuous_config*, void*))
+DYNALIB_FN(38, hal_gpio, HAL_ADC_Stop_Continuous, int(void*))
+#define BASE_IDX 39
+#else
+#define BASE_IDX 37
+#endif // HAL_PLATFORM_ADC_CONTINUOUS
+
+#if HAL_PLATFORM_INTERRUPTS_CAPTURE
+DYNALIB_FN(BASE_IDX + 0, hal_gpio, hal_interrupts_capture_start, int(uint16_t, const hal_interrupts_capture_config*, void*))
+DYNALIB_FN(BASE_IDX + 1, hal_gpio, hal_interrupts_capture_read, int(uint16_t, hal_interrupts_capture_data*, void*))
+DYNALIB_FN(BASE_IDX + 2, hal_gpio, hal_interrupts_capture_stop, int(uint16_t, void*))
+#define BASE_IDX1 (BASE_IDX + 3)
+#else
+#define BASE_IDX1 BASE_IDX
+#endif // HAL_PLATFORM_INTERRUPTS_CAPTURE
+
+#if HAL_PLATFORM_PWM_SEQUENCE
+DYNALIB_FN(BASE_IDX1 + 0, hal_gpio, hal_pwm_sequence_start, int(const uint16_t*, size_t, const hal_pwm_sequence_config*, void*))
+DYNALIB_FN(BASE_IDX1 + 1, hal_gpio, hal_pwm_sequence_update, int(uint16_t, int, const uint16_t*, size_t, void*))
+DYNALIB_FN(BASE_IDX1 + 2, hal_gpio, hal_pwm_sequence_stop, int(uint16_t, void*))
+#endif // HAL_PLATFORM_PWM_SEQUENCE
+
 DYNALIB_END(hal_gpio)
 
+#undef BASE_IDX
+#undef BASE_IDX1
+
 #endif	/* HAL_DYNALIB_GPIO_H */
 
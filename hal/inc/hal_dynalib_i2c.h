@@ -27,6 +27,7 @@
 #include "dynalib.h"
 
 #include "platforms.h"
+#include "hal_platform.h"
 
 #ifdef DYNALIB_EXPORT
 #include "i2c_hal.h"
@@ -86,6 +87,9 @@ DYNALIB_FN(BASE_IDX + 17, hal_i2c, HAL_I2C_Reset, uint8_t(HAL_I2C_Interface, uin
 DYNALIB_FN(BASE_IDX + 18, hal_i2c, HAL_I2C_Acquire, int32_t(HAL_I2C_Interface, void*))
 DYNALIB_FN(BASE_IDX + 19, hal_i2c, HAL_I2C_Release, int32_t(HAL_I2C_Interface, void*))
 DYNALIB_FN(BASE_IDX + 20, hal_i2c, HAL_I2C_Request_Data_Ex, int32_t(HAL_I2C_Interface, const HAL_I2C_Transmission_Config*, void*))
+#if HAL_PLATFORM_I2C_TRANSACTION_QUEUE
+DYNALIB_FN(BASE_IDX + 21, hal_i2c, hal_i2c_queue_transaction, int(HAL_I2C_Interface, hal_i2c_transaction*, void*))
+#endif
 
 DYNALIB_END(hal_i2c)
 
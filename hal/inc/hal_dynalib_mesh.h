@@ -26,5 +26,8 @@
 DYNALIB_BEGIN(hal_mesh)
 
 DYNALIB_FN(0, hal_mesh, mesh_select_antenna, int(int, void*))
+DYNALIB_FN(1, hal_mesh, mesh_set_sleepy_config, int(const mesh_sleepy_config*, void*))
+DYNALIB_FN(2, hal_mesh, mesh_get_sleepy_config, int(mesh_sleepy_config*, void*))
+DYNALIB_FN(3, hal_mesh, mesh_poll_parent, int(void*))
 
 DYNALIB_END(hal_mesh)
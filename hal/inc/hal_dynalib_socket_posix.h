@@ -52,6 +52,10 @@ DYNALIB_FN(16, hal_socket, sock_poll, int(struct pollfd*, nfds_t, int))
 DYNALIB_FN(17, hal_socket, sock_select, int(int, fd_set*, fd_set*, fd_set*, struct timeval*))
 DYNALIB_FN(18, hal_socket, sock_recvmsg, int(int, struct msghdr*, int))
 DYNALIB_FN(19, hal_socket, sock_sendmsg, int(int, const struct msghdr*, int))
+DYNALIB_FN(20, hal_socket, sock_recvmmsg, int(int, struct mmsghdr*, unsigned int, int))
+DYNALIB_FN(21, hal_socket, sock_sendmmsg, int(int, struct mmsghdr*, unsigned int, int))
+DYNALIB_FN(22, hal_socket, sock_set_event_callback, int(int, sock_event_callback_t, void*, void*))
+DYNALIB_FN(23, hal_socket, sock_sendfile, ssize_t(int, const char*, off_t*, size_t, int))
 
 DYNALIB_END(hal_socket)
 
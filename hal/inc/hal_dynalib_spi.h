@@ -63,9 +63,21 @@ DYNALIB_FN(17, hal_spi, HAL_SPI_Release, int32_t(HAL_SPI_Interface, void*))
 #else
 #define BASE_IDX 16
 #endif
+#if HAL_PLATFORM_SPI_TRANSACTION_QUEUE
+DYNALIB_FN(BASE_IDX + 0, hal_spi, hal_spi_queue_transaction, int(HAL_SPI_Interface, hal_spi_transaction*, void*))
+#define BASE_IDX2 (BASE_IDX + 1)
+#else
+#define BASE_IDX2 BASE_IDX
+#endif
+#if HAL_PLATFORM_SPI_SLAVE_RING
+DYNALIB_FN(BASE_IDX2 + 0, hal_spi, hal_spi_slave_ring_start, int(HAL_SPI_Interface, const hal_spi_slave_ring_config*, void*))
+DYNALIB_FN(BASE_IDX2 + 1, hal_spi, hal_spi_slave_ring_release, int(HAL_SPI_Interface, void*))
+DYNALIB_FN(BASE_IDX2 + 2, hal_spi, hal_spi_slave_ring_stop, int(HAL_SPI_Interface, void*))
+#endif
 DYNALIB_END(hal_spi)
 
 #undef BASE_IDX
+#undef BASE_IDX2
 
 #endif	/* HAL_DYNALIB_SPI_H */
 
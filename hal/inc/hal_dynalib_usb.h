@@ -22,6 +22,7 @@
 #define HAL_DYNALIB_USB_H
 
 #include "dynalib.h"
+#include "hal_platform.h"
 #include "usb_config_hal.h"
 #include "platform_config.h"
 
@@ -100,6 +101,13 @@ DYNALIB_FN(BASE_IDX4 + 1, hal_usb, HAL_USB_HID_Set_State, uint8_t(uint8_t, uint8
 
 #ifdef USB_VENDOR_REQUEST_ENABLE
 DYNALIB_FN(BASE_IDX5 + 0, hal_usb, HAL_USB_Set_Vendor_Request_State_Callback, void(HAL_USB_Vendor_Request_State_Callback, void*))
+# define BASE_IDX6 (BASE_IDX5 + 1)
+#else
+# define BASE_IDX6 BASE_IDX5
+#endif
+
+#if defined(USB_CDC_ENABLE) && HAL_PLATFORM_USB_CDC_HIGH_THROUGHPUT
+DYNALIB_FN(BASE_IDX6 + 0, hal_usb, HAL_USB_USART_Send_Buffer, int32_t(HAL_USB_USART_Serial, const uint8_t*, size_t, void*))
 #endif
 
 DYNALIB_END(hal_usb)
@@ -110,5 +118,6 @@ DYNALIB_END(hal_usb)
 #undef BASE_IDX3
 #undef BASE_IDX4
 #undef BASE_IDX5
+#undef BASE_IDX6
 
 #endif  /* HAL_DYNALIB_USB_H */
@@ -81,6 +81,7 @@ DYNALIB_FN(29, hal_wlan, wlan_connected_info, int(void*, wlan_connected_info_t*,
 DYNALIB_FN(30, hal_wlan, wlan_get_antenna, WLanSelectAntenna_TypeDef(void*))
 DYNALIB_FN(31, hal_wlan, wlan_get_ipaddress, int(IPConfig*, void*))
 DYNALIB_FN(32, hal_wlan, wlan_get_ipaddress_source, IPAddressSource(void*))
+DYNALIB_FN(33, hal_wlan, wlan_scan_stream, int(wlan_scan_stream_callback_t, void*, void*))
 DYNALIB_END(hal_wlan)
 
 #endif // HAL_PLATFORM_WIFI
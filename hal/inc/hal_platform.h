@@ -125,6 +125,10 @@
 #define HAL_PLATFORM_NCP_UPDATABLE (0)
 #endif /* HAL_PLATFORM_NCP_UPDATABLE */
 
+#ifndef HAL_PLATFORM_NCP_EARLY_POWER_ON
+#define HAL_PLATFORM_NCP_EARLY_POWER_ON (0)
+#endif /* HAL_PLATFORM_NCP_EARLY_POWER_ON */
+
 #ifndef HAL_PLATFORM_MCU_ANY
 #define HAL_PLATFORM_MCU_ANY (0xFF)
 #endif // HAL_PLATFORM_MCU_ANY
@@ -301,4 +305,44 @@
 #define HAL_PLATFORM_MAY_LEAK_SOCKETS (0)
 #endif // HAL_PLATFORM_MAY_LEAK_SOCKETS
 
+#ifndef HAL_PLATFORM_ADC_CONTINUOUS
+#define HAL_PLATFORM_ADC_CONTINUOUS (0)
+#endif // HAL_PLATFORM_ADC_CONTINUOUS
+
+#ifndef HAL_PLATFORM_SPI_TRANSACTION_QUEUE
+#define HAL_PLATFORM_SPI_TRANSACTION_QUEUE (0)
+#endif // HAL_PLATFORM_SPI_TRANSACTION_QUEUE
+
+#ifndef HAL_PLATFORM_SPI_SLAVE_RING
+#define HAL_PLATFORM_SPI_SLAVE_RING (0)
+#endif // HAL_PLATFORM_SPI_SLAVE_RING
+
+#ifndef HAL_PLATFORM_I2C_TRANSACTION_QUEUE
+#define HAL_PLATFORM_I2C_TRANSACTION_QUEUE (0)
+#endif // HAL_PLATFORM_I2C_TRANSACTION_QUEUE
+
+#ifndef HAL_PLATFORM_USB_CDC_HIGH_THROUGHPUT
+#define HAL_PLATFORM_USB_CDC_HIGH_THROUGHPUT (0)
+#endif // HAL_PLATFORM_USB_CDC_HIGH_THROUGHPUT
+
+#ifndef HAL_PLATFORM_USB_VENDOR_BULK
+#define HAL_PLATFORM_USB_VENDOR_BULK (0)
+#endif // HAL_PLATFORM_USB_VENDOR_BULK
+
+#ifndef HAL_PLATFORM_INTERRUPTS_CAPTURE
+#define HAL_PLATFORM_INTERRUPTS_CAPTURE (0)
+#endif // HAL_PLATFORM_INTERRUPTS_CAPTURE
+
+#ifndef HAL_PLATFORM_PWM_SEQUENCE
+#define HAL_PLATFORM_PWM_SEQUENCE (0)
+#endif // HAL_PLATFORM_PWM_SEQUENCE
+
+#ifndef HAL_PLATFORM_HEAP_ARENA
+#define HAL_PLATFORM_HEAP_ARENA (0)
+#endif // HAL_PLATFORM_HEAP_ARENA
+
+#ifndef HAL_PLATFORM_HEAP_ARENA_SIZE
+#define HAL_PLATFORM_HEAP_ARENA_SIZE (8192)
+#endif // HAL_PLATFORM_HEAP_ARENA_SIZE
+
 #endif /* HAL_PLATFORM_H */
@@ -32,6 +32,7 @@
 #include "pinmap_hal.h"
 #include "platforms.h"
 #include "system_tick_hal.h"
+#include "hal_platform.h"
 
 /* Exported types ------------------------------------------------------------*/
 typedef enum
@@ -77,6 +78,39 @@ typedef struct HAL_I2C_Transmission_Config {
     uint32_t flags;
 } HAL_I2C_Transmission_Config;
 
+typedef enum hal_i2c_transaction_type {
+    HAL_I2C_TRANSACTION_WRITE = 0,
+    HAL_I2C_TRANSACTION_READ = 1,
+    HAL_I2C_TRANSACTION_WRITE_READ = 2 // Write followed by a read after a repeated start condition
+} hal_i2c_transaction_type;
+
+struct hal_i2c_transaction;
+
+typedef void (*hal_i2c_transaction_callback_t)(struct hal_i2c_transaction* transaction, int result);
+
+/**
+ * Asynchronous I2C transaction.
+ *
+ * The structure is owned by the caller and must remain valid until the completion callback is
+ * invoked. The callback runs in the I2C interrupt context and can queue further transactions.
+ */
+typedef struct hal_i2c_transaction {
+    uint16_t size;
+    uint16_t version;
+
+    struct hal_i2c_transaction* next; // Used internally by the HAL
+    uint8_t address; // 7-bit slave address
+    uint8_t type; // One of the hal_i2c_transaction_type values
+    uint8_t flags; // HAL_I2C_TRANSMISSION_FLAG_STOP to end a write with a stop condition
+    uint8_t reserved;
+    const uint8_t* tx_buffer;
+    size_t tx_length;
+    uint8_t* rx_buffer;
+    size_t rx_length;
+    hal_i2c_transaction_callback_t callback;
+    void* context;
+} hal_i2c_transaction;
+
 /* Exported constants --------------------------------------------------------*/
 
 /* Exported macros -----------------------------------------------------------*/
@@ -113,6 +147,11 @@ uint8_t HAL_I2C_Reset(HAL_I2C_Interface i2c, uint32_t reserved, void* reserve1);
 
 int32_t HAL_I2C_Acquire(HAL_I2C_Interface i2c, void* reserved);
 int32_t HAL_I2C_Release(HAL_I2C_Interface i2c, void* reserved);
+#if HAL_PLATFORM_I2C_TRANSACTION_QUEUE
+// Queues a transaction on an interface running in master mode. Queued transactions are executed
+// back to back from the I2C interrupt
+int hal_i2c_queue_transaction(HAL_I2C_Interface i2c, hal_i2c_transaction* transaction, void* reserved);
+#endif
 
 void HAL_I2C_Set_Speed_v1(uint32_t speed);
 void HAL_I2C_Enable_DMA_Mode_v1(bool enable);
@@ -38,6 +38,7 @@ typedef int32_t hal_irq_t;
 #endif // SPARK_NO_PLATFORM
 #include "pinmap_hal.h"
 #include "hal_irq_flag.h"
+#include "hal_platform.h"
 
 /* Exported types ------------------------------------------------------------*/
 typedef enum InterruptMode {
@@ -85,6 +86,29 @@ typedef struct HAL_InterruptExtraConfiguration {
   };
 } HAL_InterruptExtraConfiguration;
 
+typedef enum hal_interrupts_capture_mode {
+  HAL_INTERRUPTS_CAPTURE_MODE_COUNT = 0, // Count edges
+  HAL_INTERRUPTS_CAPTURE_MODE_PERIOD = 1 // Measure the time between two consecutive edges
+} hal_interrupts_capture_mode;
+
+// Resolution of the time values reported in the period mode
+#define HAL_INTERRUPTS_CAPTURE_TICKS_PER_SECOND 16000000
+
+typedef struct hal_interrupts_capture_config {
+  uint16_t size;
+  uint16_t version;
+  uint8_t mode; // One of the hal_interrupts_capture_mode values
+  uint8_t edge; // One of the InterruptMode values
+  uint16_t reserved;
+} hal_interrupts_capture_config;
+
+typedef struct hal_interrupts_capture_data {
+  uint16_t size;
+  uint16_t version;
+  uint32_t value; // Number of edges since the capture was started, or the time between the two last edges
+  uint32_t elapsed; // Time since the last edge (period mode only)
+} hal_interrupts_capture_data;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -109,6 +133,14 @@ void HAL_System_Interrupt_Trigger(hal_irq_t irq, void* reserved);
 
 int HAL_Set_Direct_Interrupt_Handler(IRQn_Type irqn, HAL_Direct_Interrupt_Handler handler, uint32_t flags, void* reserved);
 
+#if HAL_PLATFORM_INTERRUPTS_CAPTURE
+// Edges on the pin are counted or timed by a hardware timer, without running an interrupt handler
+// for every edge. Only one pin can be captured at a time
+int hal_interrupts_capture_start(uint16_t pin, const hal_interrupts_capture_config* config, void* reserved);
+int hal_interrupts_capture_read(uint16_t pin, hal_interrupts_capture_data* data, void* reserved);
+int hal_interrupts_capture_stop(uint16_t pin, void* reserved);
+#endif // HAL_PLATFORM_INTERRUPTS_CAPTURE
+
 #ifdef USE_STDPERIPH_DRIVER
 #if defined(STM32F10X_MD) || defined(STM32F10X_HD)
 #include "stm32f10x.h"
@@ -19,6 +19,8 @@
 
 #include "radio_hal.h"
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -30,8 +32,47 @@ extern "C" {
  *
  * @return `0` on success or a negative result code in case of an error.
  */
+/**
+ * Sleepy End Device configuration.
+ */
+typedef struct mesh_sleepy_config {
+    uint16_t size; ///< Size of this structure.
+    uint16_t reserved;
+    uint32_t poll_period; ///< Period of the data polls in milliseconds, or 0 if the mode is disabled.
+    uint32_t child_timeout; ///< Child timeout in seconds, or 0 to use the default timeout.
+} mesh_sleepy_config;
+
 int mesh_select_antenna(int antenna, void* reserved);
 
+/**
+ * Configures the device as a Sleepy End Device.
+ *
+ * A Sleepy End Device keeps its radio off between the data polls of its parent. The configuration
+ * is persistent.
+ *
+ * @param conf Configuration.
+ * @param reserved Reserved argument. Should be set to `NULL`.
+ * @return 0 on success, or a negative result code in case of an error.
+ */
+int mesh_set_sleepy_config(const mesh_sleepy_config* conf, void* reserved);
+
+/**
+ * Retrieves the Sleepy End Device configuration.
+ *
+ * @param conf Configuration.
+ * @param reserved Reserved argument. Should be set to `NULL`.
+ * @return 0 on success, or a negative result code in case of an error.
+ */
+int mesh_get_sleepy_config(mesh_sleepy_config* conf, void* reserved);
+
+/**
+ * Polls the parent for the frames buffered for this device, if it's a Sleepy End Device.
+ *
+ * @param reserved Reserved argument. Should be set to `NULL`.
+ * @return 0 on success, or a negative result code in case of an error.
+ */
+int mesh_poll_parent(void* reserved);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
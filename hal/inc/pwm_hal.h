@@ -29,9 +29,47 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "pinmap_hal.h"
+#include "hal_platform.h"
+#include <stddef.h>
 
 /* Exported types ------------------------------------------------------------*/
 
+/* How the values of a sequence are distributed between the pins */
+typedef enum hal_pwm_sequence_load_mode {
+	HAL_PWM_SEQUENCE_LOAD_COMMON = 0,       /* One value per step, shared by all pins */
+	HAL_PWM_SEQUENCE_LOAD_GROUPED = 1,      /* Two values per step: pins 0 and 1, pins 2 and 3 */
+	HAL_PWM_SEQUENCE_LOAD_INDIVIDUAL = 2,   /* Four values per step, one per pin */
+	HAL_PWM_SEQUENCE_LOAD_WAVEFORM = 3      /* Four values per step: pins 0 to 2 and the counter top value */
+} hal_pwm_sequence_load_mode;
+
+typedef enum hal_pwm_sequence_event {
+	HAL_PWM_SEQUENCE_EVENT_BUFFER_END = 0,  /* A buffer has been played and can be refilled */
+	HAL_PWM_SEQUENCE_EVENT_FINISHED = 1     /* The playback has completed */
+} hal_pwm_sequence_event;
+
+typedef enum hal_pwm_sequence_flag {
+	HAL_PWM_SEQUENCE_FLAG_NOTIFY_BUFFER_END = 0x01  /* Invoke the callback after each played buffer */
+} hal_pwm_sequence_flag;
+
+/* Called from an ISR. buffer is the index of the buffer that has been played */
+typedef void (*hal_pwm_sequence_callback)(int event, int buffer, void* context);
+
+typedef struct hal_pwm_sequence_config {
+	uint16_t size;
+	uint16_t version;
+	uint8_t load_mode;                      /* One of the hal_pwm_sequence_load_mode values */
+	uint8_t prescaler;                      /* Counter clock is HAL_PWM_SEQUENCE_BASE_CLOCK >> prescaler (0 to 7) */
+	uint16_t top;                           /* Counter top value, ignored in the waveform mode */
+	uint16_t repeats;                       /* Number of additional PWM periods each step is held for */
+	uint16_t flags;                         /* A combination of the hal_pwm_sequence_flag values */
+	const uint16_t* buffers[2];             /* Values, must be located in RAM. The second buffer is optional */
+	uint16_t lengths[2];                    /* Number of values in each buffer */
+	uint16_t playback_count;                /* Number of times the buffers are played, 0 to loop until stopped */
+	uint16_t reserved;
+	hal_pwm_sequence_callback callback;
+	void* context;
+} hal_pwm_sequence_config;
+
 /* Exported constants --------------------------------------------------------*/
 
 /* This perhaps should be moved in a different place. */
@@ -42,6 +80,16 @@ typedef enum
 
 }user_property_t;
 
+#if HAL_PLATFORM_PWM_SEQUENCE
+#define HAL_PWM_SEQUENCE_BASE_CLOCK         16000000
+#define HAL_PWM_SEQUENCE_MAX_TOP            0x7FFF
+#define HAL_PWM_SEQUENCE_MAX_LENGTH         0x7FFF
+
+/* By default the output of a pin is low until the counter reaches the value and high for the rest
+ * of the period. With this bit set the output is high until the counter reaches the value */
+#define HAL_PWM_SEQUENCE_VALUE_INVERT       0x8000
+#endif // HAL_PLATFORM_PWM_SEQUENCE
+
 /* Exported macros -----------------------------------------------------------*/
 
 /* Exported functions --------------------------------------------------------*/
@@ -65,6 +113,16 @@ uint8_t HAL_PWM_Get_Resolution(uint16_t pin);
 void HAL_PWM_Set_Resolution(uint16_t pin, uint8_t resolution);
 void HAL_PWM_Reset_Pin(uint16_t pin);
 
+#if HAL_PLATFORM_PWM_SEQUENCE
+/* The values are fetched from RAM by the PWM peripheral, without involving the CPU. All pins must
+ * belong to the same PWM instance, which is used exclusively by the sequence until it is stopped.
+ * Changing the function of any of the pins stops the playback */
+int hal_pwm_sequence_start(const uint16_t* pins, size_t pin_count, const hal_pwm_sequence_config* config, void* reserved);
+/* Replaces a buffer of a running sequence. Takes effect the next time the buffer is played */
+int hal_pwm_sequence_update(uint16_t pin, int buffer, const uint16_t* values, size_t length, void* reserved);
+int hal_pwm_sequence_stop(uint16_t pin, void* reserved);
+#endif // HAL_PLATFORM_PWM_SEQUENCE
+
 #ifdef __cplusplus
 }
 #endif
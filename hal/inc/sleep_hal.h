@@ -82,6 +82,7 @@ typedef enum hal_wakeup_source_type_t {
 typedef enum hal_sleep_flags_t {
     HAL_SLEEP_FLAG_NONE = 0,
     HAL_SLEEP_FLAG_WAIT_CLOUD = 0x01,
+    HAL_SLEEP_FLAG_REPORT_CYCLE = 0x02,
     HAL_SLEEP_FLAG_MAX = 0x7FFFFFFF
 } hal_sleep_flags_t;
 
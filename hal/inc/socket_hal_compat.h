@@ -56,6 +56,17 @@ typedef int32_t sock_result_t;
 typedef sockaddr_t sockaddr;
 #endif /* !HAL_USE_SOCKET_HAL_POSIX && !HAL_SOCKET_HAL_COMPAT_NO_SOCKADDR */
 
+/**
+ * Flags for socket_send_ex().
+ */
+typedef enum socket_send_flag_t {
+    /**
+     * More data follows: the data may be held back and sent together with the data of the next
+     * call. Platforms that don't coalesce writes ignore this flag.
+     */
+    SOCKET_SEND_FLAG_MORE = 0x01
+} socket_send_flag_t;
+
 static const uint8_t SOCKET_STATUS_INACTIVE = 1;
 static const uint8_t SOCKET_STATUS_ACTIVE = 0;
 
@@ -49,6 +49,22 @@ typedef int sock_result_t;
 /** Compatibility SOCKET_WAIT_FOREVER definition */
 #define SOCKET_WAIT_FOREVER (0xffffffff)
 
+/** Socket readiness flags passed to sock_event_callback_t */
+typedef enum sock_event_flag_t {
+    SOCK_EVENT_READABLE = 0x01, ///< There is data to read or a connection to accept
+    SOCK_EVENT_WRITABLE = 0x02, ///< Data can be sent
+    SOCK_EVENT_ERROR = 0x04 ///< An error occurred on the socket
+} sock_event_flag_t;
+
+/**
+ * Socket readiness callback.
+ *
+ * @param[in]  s        socket
+ * @param[in]  events   current readiness state of the socket (a combination of sock_event_flag_t flags)
+ * @param[in]  context  user context
+ */
+typedef void (*sock_event_callback_t)(int s, int events, void* context);
+
 /**
  * Accept a connection on a socket.
  *
@@ -310,6 +326,78 @@ ssize_t sock_recvmsg(int s, struct msghdr *message, int flags);
  *             accordingly.
  */
 ssize_t sock_sendmsg(int s, const struct msghdr *message, int flags);
+
+/**
+ * Receive multiple messages from the socket.
+ *
+ * Only receiving of the first message may block, the remaining messages are received
+ * only if they are immediately available.
+ *
+ * @param[in]  s        a socket that has been created with sock_socket()
+ * @param      msgvec   messages to receive, msg_len of each received message is set
+ *                      to the number of bytes received
+ * @param[in]  vlen     number of messages in msgvec
+ * @param[in]  flags    a combination of MSG_DONTWAIT, MSG_PEEK and MSG_TRUNC
+ *
+ * @return     The number of messages received or -1 on error, with errno set
+ *             accordingly.
+ */
+int sock_recvmmsg(int s, struct mmsghdr* msgvec, unsigned int vlen, int flags);
+
+/**
+ * Send multiple messages through the socket.
+ *
+ * Only sending of the first message may block, the remaining messages are sent
+ * only if that can be done immediately.
+ *
+ * @param[in]  s        a socket that has been created with sock_socket()
+ * @param      msgvec   messages to send, msg_len of each sent message is set
+ *                      to the number of bytes sent
+ * @param[in]  vlen     number of messages in msgvec
+ * @param[in]  flags    a combination of MSG_MORE and MSG_DONTWAIT
+ *
+ * @return     The number of messages sent or -1 on error, with errno set
+ *             accordingly.
+ */
+int sock_sendmmsg(int s, struct mmsghdr* msgvec, unsigned int vlen, int flags);
+
+/**
+ * Set a callback notifying about the readiness state changes of the socket.
+ *
+ * The callback is invoked by the network stack with its core lock held, and is also invoked
+ * once from this function if the socket is already readable, writable or has an error. It
+ * should not block or call socket functions: the typical use is posting an event to a queue.
+ * The callback is unregistered when the socket is closed.
+ *
+ * @param[in]  s         a socket that has been created with sock_socket()
+ * @param[in]  callback  callback, or NULL to unregister the current one
+ * @param[in]  context   user context passed to the callback
+ * @param      reserved  reserved for future use, should be NULL
+ *
+ * @return     0 on success or -1 on error, with errno set accordingly.
+ */
+int sock_set_event_callback(int s, sock_event_callback_t callback, void* context, void* reserved);
+
+/**
+ * Send the contents of a file through the socket.
+ *
+ * The file is read in small chunks, so the amount of RAM used doesn't depend on
+ * the size of the file.
+ *
+ * @param[in]    s       a socket that has been created with sock_socket()
+ * @param[in]    path    path to the file in the filesystem
+ * @param[inout] offset  the offset in the file to start reading from, on return it will
+ *                       contain the offset following the last byte sent. If NULL, the file
+ *                       is sent from the beginning
+ * @param[in]    count   the maximum number of bytes to send
+ * @param[in]    flags   a combination of MSG_MORE and MSG_DONTWAIT
+ *
+ * @return     The number of bytes sent, which is less than count if the end of the
+ *             file has been reached or the send timeout has expired, or -1 on error,
+ *             with errno set accordingly.
+ */
+ssize_t sock_sendfile(int s, const char* path, off_t* offset, size_t count, int flags);
+
 /**
  * @}
  *
@@ -30,6 +30,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "pinmap_hal.h"
 #include "system_tick_hal.h"
+#include <stddef.h>
 
 /* Exported types ------------------------------------------------------------*/
 typedef enum HAL_SPI_Interface {
@@ -113,6 +114,52 @@ typedef struct HAL_SPI_AcquireConfig {
     system_tick_t timeout;
 } HAL_SPI_AcquireConfig;
 
+struct hal_spi_transaction;
+
+typedef void (*hal_spi_transaction_callback_t)(struct hal_spi_transaction* transaction, int result);
+
+/**
+ * Asynchronous SPI transaction.
+ *
+ * The structure is owned by the caller and must remain valid until the completion callback is
+ * invoked. The callback runs in the SPI interrupt context and can queue further transactions.
+ */
+typedef struct hal_spi_transaction {
+    uint16_t size;
+    uint16_t version;
+
+    struct hal_spi_transaction* next; // Used internally by the HAL
+    pin_t cs_pin; // Chip select pin (active low), or PIN_INVALID
+    uint8_t clock_div; // One of the SPI_CLOCK_DIVx values
+    uint8_t bit_order; // MSBFIRST or LSBFIRST
+    uint8_t data_mode; // One of the SPI_MODEx values
+    const void* tx_buffer; // Data to send, or NULL to send 0xff
+    void* rx_buffer; // Buffer for the received data, or NULL
+    uint32_t length;
+    hal_spi_transaction_callback_t callback;
+    void* context;
+} hal_spi_transaction;
+
+/**
+ * Callback invoked when the master has written a block in the slave ring.
+ *
+ * @param data Received data. The block remains owned by the application until it is released
+ *        with `hal_spi_slave_ring_release()`.
+ * @param length Number of bytes written by the master.
+ * @param context User context.
+ */
+typedef void (*hal_spi_slave_ring_callback_t)(const uint8_t* data, size_t length, void* context);
+
+typedef struct hal_spi_slave_ring_config {
+    uint16_t size; // Size of this structure
+    uint16_t version;
+    uint8_t* buffer; // Receive buffer of `block_count * block_size` bytes, located in RAM
+    uint16_t block_size; // Maximum length of a master transaction
+    uint16_t block_count; // Number of blocks in the ring, at least 2
+    hal_spi_slave_ring_callback_t callback;
+    void* context;
+} hal_spi_slave_ring_config;
+
 void HAL_SPI_Init(HAL_SPI_Interface spi);
 void HAL_SPI_Begin(HAL_SPI_Interface spi, uint16_t pin);
 void HAL_SPI_Begin_Ext(HAL_SPI_Interface spi, SPI_Mode mode, uint16_t pin, void* reserved);
@@ -135,6 +182,35 @@ int32_t HAL_SPI_Set_Settings(HAL_SPI_Interface spi, uint8_t set_default, uint8_t
 int32_t HAL_SPI_Acquire(HAL_SPI_Interface spi, const HAL_SPI_AcquireConfig* conf);
 int32_t HAL_SPI_Release(HAL_SPI_Interface spi, void* reserved);
 #endif
+#if HAL_PLATFORM_SPI_TRANSACTION_QUEUE
+// Queues a transaction on an interface running in master mode. Queued transactions are executed
+// back to back from the SPI interrupt, with their own settings and chip select pin
+int hal_spi_queue_transaction(HAL_SPI_Interface spi, hal_spi_transaction* transaction, void* reserved);
+#endif
+#if HAL_PLATFORM_SPI_SLAVE_RING
+/**
+ * Start receiving master transactions into a ring of blocks on an interface running in slave mode.
+ *
+ * Each master transaction (chip select asserted until deasserted) is written to the next free
+ * block, and the next block is armed from the interrupt handler before the callback is invoked,
+ * so back-to-back transactions are captured without waiting for the application. Transactions
+ * received while all blocks are held by the application are discarded. The slave sends 0xff
+ * while the ring is running. `HAL_SPI_DMA_Transfer()` cannot be used until the ring is stopped.
+ * Changing the settings of the interface or ending it stops the ring.
+ */
+int hal_spi_slave_ring_start(HAL_SPI_Interface spi, const hal_spi_slave_ring_config* config, void* reserved);
+/**
+ * Release the oldest block passed to the callback.
+ */
+int hal_spi_slave_ring_release(HAL_SPI_Interface spi, void* reserved);
+/**
+ * Stop the ring.
+ *
+ * @return Number of transactions discarded because no block was free, or a negative result code
+ *         in case of an error.
+ */
+int hal_spi_slave_ring_stop(HAL_SPI_Interface spi, void* reserved);
+#endif
 
 #ifdef __cplusplus
 }
@@ -30,6 +30,8 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "hal_platform.h"
 /* Exported types ------------------------------------------------------------*/
 
 /* Exported constants --------------------------------------------------------*/
@@ -95,6 +97,22 @@ typedef enum {
 
 typedef uint8_t (*HAL_USB_Vendor_Request_Callback)(HAL_USB_SetupRequest* req, void* p);
 typedef uint8_t (*HAL_USB_Vendor_Request_State_Callback)(HAL_USB_VendorRequestState state, void* p);
+
+#if HAL_PLATFORM_USB_VENDOR_BULK
+typedef enum HAL_USB_Vendor_Bulk_Event {
+  /* Data has been received from the host. The `size` argument of the callback contains the number
+   * of received bytes, which can be smaller than the size of the buffer if the host has sent
+   * a short packet.
+   */
+  HAL_USB_VENDOR_BULK_EVENT_RX_COMPLETED = 1,
+  /* All data has been sent to the host */
+  HAL_USB_VENDOR_BULK_EVENT_TX_COMPLETED = 2,
+  /* A transfer has failed or has been aborted by the USB stack */
+  HAL_USB_VENDOR_BULK_EVENT_ERROR = 3
+} HAL_USB_Vendor_Bulk_Event;
+
+typedef void (*HAL_USB_Vendor_Bulk_Callback)(HAL_USB_Vendor_Bulk_Event event, size_t size, void* p);
+#endif // HAL_PLATFORM_USB_VENDOR_BULK
 #endif // USB_VENDOR_REQUEST_ENABLE
 
     /* USB Config : IMR_MSK */
@@ -174,6 +192,20 @@ void USB_HID_Send_Report(void *pHIDReport, uint16_t reportSize);
 #ifdef USB_VENDOR_REQUEST_ENABLE
 void HAL_USB_Set_Vendor_Request_Callback(HAL_USB_Vendor_Request_Callback cb, void* p);
 void HAL_USB_Set_Vendor_Request_State_Callback(HAL_USB_Vendor_Request_State_Callback cb, void* p);
+
+#if HAL_PLATFORM_USB_VENDOR_BULK
+/*
+ * Bulk endpoints of the vendor-specific control interface. Each direction supports one transfer
+ * at a time, and the buffer passed to HAL_USB_Vendor_Bulk_Receive() or HAL_USB_Vendor_Bulk_Send()
+ * must stay valid until the bulk callback is invoked or the transfer is cancelled.
+ *
+ * NOTE: The bulk callback is called from an ISR.
+ */
+void HAL_USB_Set_Vendor_Bulk_Callback(HAL_USB_Vendor_Bulk_Callback cb, void* p);
+int HAL_USB_Vendor_Bulk_Receive(uint8_t* data, size_t size, void* reserved);
+int HAL_USB_Vendor_Bulk_Send(const uint8_t* data, size_t size, void* reserved);
+void HAL_USB_Vendor_Bulk_Cancel(void* reserved);
+#endif // HAL_PLATFORM_USB_VENDOR_BULK
 #endif
 
 #if defined(USB_CDC_ENABLE) || defined(USB_HID_ENABLE)
@@ -192,12 +224,20 @@ typedef enum HAL_USB_USART_Serial {
   HAL_USB_USART_SERIAL_COUNT
 } HAL_USB_USART_Serial;
 
+typedef enum HAL_USB_USART_Config_Flag {
+  // Send data in multi-packet transfers straight from the TX buffer, terminate transfers that end
+  // on a packet boundary with a zero-length packet, and send large buffers passed to
+  // HAL_USB_USART_Send_Buffer() without copying them
+  HAL_USB_USART_CONFIG_FLAG_HIGH_THROUGHPUT = 0x01
+} HAL_USB_USART_Config_Flag;
+
 typedef struct HAL_USB_USART_Config {
   uint16_t size;
   uint8_t* rx_buffer;
   uint16_t rx_buffer_size;
   uint8_t* tx_buffer;
   uint16_t tx_buffer_size;
+  uint32_t flags; // Ignored unless size covers this field
 } HAL_USB_USART_Config;
 
 void HAL_USB_USART_Init(HAL_USB_USART_Serial serial, const HAL_USB_USART_Config* config);
@@ -212,6 +252,9 @@ void HAL_USB_USART_Flush_Data(HAL_USB_USART_Serial serial);
 bool HAL_USB_USART_Is_Enabled(HAL_USB_USART_Serial serial);
 bool HAL_USB_USART_Is_Connected(HAL_USB_USART_Serial serial);
 int32_t HAL_USB_USART_LineCoding_BitRate_Handler(void (*handler)(uint32_t bitRate), void* reserved);
+#if HAL_PLATFORM_USB_CDC_HIGH_THROUGHPUT
+int32_t HAL_USB_USART_Send_Buffer(HAL_USB_USART_Serial serial, const uint8_t* data, size_t size, void* reserved);
+#endif
 #endif
 
 #ifdef USB_HID_ENABLE
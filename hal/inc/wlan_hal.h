@@ -392,6 +392,23 @@ typedef void (*wlan_scan_result_t)(WiFiAccessPoint* ap, void* cookie);
  */
 int wlan_scan(wlan_scan_result_t callback, void* cookie);
 
+/**
+ * Callback invoked by `wlan_scan_stream()` for each scanned AP.
+ *
+ * @return 0 to continue receiving results, or a non-zero value to stop.
+ */
+typedef int (*wlan_scan_stream_callback_t)(WiFiAccessPoint* ap, void* cookie);
+
+/**
+ * Performs a network scan, reporting each AP to the callback as soon as it is discovered.
+ *
+ * @param callback  The callback that receives each scanned AP
+ * @param cookie    An opaque handle that is passed to the callback.
+ * @param reserved  This argument should be set to NULL.
+ * @return number of reported APs, negative on error.
+ */
+int wlan_scan_stream(wlan_scan_stream_callback_t callback, void* cookie, void* reserved);
+
 /**
  * Lists all WLAN credentials currently stored on the device
  * @param callback  The callback that receives each stored AP
@@ -98,8 +98,10 @@ if_t PppNcpNetif::interface() {
 void PppNcpNetif::loop(void* arg) {
     PppNcpNetif* self = static_cast<PppNcpNetif*>(arg);
     unsigned int timeout = 100;
-    // Off by default
-    self->celMan_->ncpClient()->off();
+    // Off by default, unless the modem session from before a warm reset can be resumed
+    if (!self->celMan_->ncpClient()->isSessionResumable()) {
+        self->celMan_->ncpClient()->off();
+    }
     while(!self->exit_) {
         self->celMan_->ncpClient()->enable(); // Make sure the client is enabled
         NetifEvent ev;
@@ -182,6 +184,9 @@ int PppNcpNetif::upImpl() {
     downImpl();
     // Restore up flag
     up_ = true;
+    // u-blox modems terminate PPP locally and respond immediately, Nak'ing stale pre-seeded values
+    const auto ncpId = celMan_->ncpClient()->ncpId();
+    client_.setFastNegotiation(ncpId == PLATFORM_NCP_SARA_U201 || ncpId == PLATFORM_NCP_SARA_R410);
     client_.setOutputCallback([](const uint8_t* data, size_t size, void* ctx) -> int {
         auto c = (CellularNcpClient*)ctx;
         int r = c->dataChannelWrite(0, data, size);
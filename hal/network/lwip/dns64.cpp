@@ -24,9 +24,12 @@
 
 #include "lwiplock.h"
 #include "lwip_util.h"
+#include "timer_hal.h"
 
 #include "lwip/dns.h"
 
+#include <strings.h>
+
 LOG_SOURCE_CATEGORY("net.dns64")
 
 #ifndef DEBUG_DNS64
@@ -134,6 +137,21 @@ const uint32_t DEFAULT_TTL = 0; // Do not cache (RFC 1035, 4.1.3)
 // Timeout for select() in milliseconds
 const unsigned SOCKET_RECV_TIMEOUT = 1000;
 
+// Synthesized answers are cached so that mesh nodes resolving the same name (e.g. the cloud endpoint
+// after a network reset) don't cause a failing upstream AAAA lookup followed by an A lookup each time.
+// LwIP doesn't expose the TTL of a resolved record, so answers are kept for a short fixed period
+// which is expected to be well below the TTL of the upstream records
+const size_t ANSWER_CACHE_SIZE = 4;
+const size_t ANSWER_CACHE_MAX_NAME_LENGTH = 63;
+const system_tick_t ANSWER_CACHE_TTL = 30000;
+
+struct CachedAnswer {
+    char name[ANSWER_CACHE_MAX_NAME_LENGTH + 1]; // Empty if the entry is not used
+    ip_addr_t addr;
+    system_tick_t time;
+    uint16_t qtype;
+};
+
 ssize_t readHeader(const char* data, size_t size, Header* h) {
     if (size < sizeof(Header)) {
         LOG_DEBUG(ERROR, "Unexpected end of message");
@@ -303,9 +321,51 @@ uint16_t systemToDnsError(int error) {
 struct Dns64::Context {
     ip6_addr_t prefix;
     int sock;
+    // Accessed with the LwIP core lock held
+    CachedAnswer cache[ANSWER_CACHE_SIZE];
 
     Context() :
-            sock(-1) {
+            sock(-1),
+            cache() {
+    }
+
+    bool lookupAnswer(const char* name, uint16_t qtype, ip_addr_t* addr) {
+        const system_tick_t now = HAL_Timer_Get_Milli_Seconds();
+        for (auto& e: cache) {
+            if (e.name[0] && e.qtype == qtype && strcasecmp(e.name, name) == 0) {
+                if (now - e.time < ANSWER_CACHE_TTL) {
+                    ip_addr_copy(*addr, e.addr);
+                    return true;
+                }
+                e.name[0] = '\0';
+            }
+        }
+        return false;
+    }
+
+    void cacheAnswer(const char* name, uint16_t qtype, const ip_addr_t& addr) {
+        if (strlen(name) > ANSWER_CACHE_MAX_NAME_LENGTH) {
+            return;
+        }
+        const system_tick_t now = HAL_Timer_Get_Milli_Seconds();
+        // Replace an expired or unused entry, or the oldest one. A valid entry for the same
+        // name is left as is so that its lifetime is not extended by cached responses
+        CachedAnswer* entry = &cache[0];
+        for (auto& e: cache) {
+            const bool expired = !e.name[0] || now - e.time >= ANSWER_CACHE_TTL;
+            if (!expired && e.qtype == qtype && strcasecmp(e.name, name) == 0) {
+                return;
+            }
+            if (expired) {
+                entry = &e;
+            } else if (entry->name[0] && now - e.time > now - entry->time) {
+                entry = &e;
+            }
+        }
+        strcpy(entry->name, name);
+        ip_addr_copy(entry->addr, addr);
+        entry->time = now;
+        entry->qtype = qtype;
     }
 
     ~Context() {
@@ -409,9 +469,17 @@ int Dns64::processQuery(char* data, size_t size, const sockaddr_in6& srcAddr) {
     const char* name = nullptr;
     int ret = parseQuery(data, size, q.get(), &name);
     if (ret == 0) {
+        ip_addr_t addr = {};
+        if (ctx_->lookupAnswer(name, q->q.qtype, &addr)) {
+            DEBUG("Using cached answer: %s", IPADDR_NTOA(&addr));
+            ret = sendResponse(addr, name, *q, ctx_.get());
+            if (ret < 0) {
+                LOG_DEBUG(ERROR, "Unable to send response: %d", ret);
+            }
+            return ret;
+        }
         // Perform a DNS lookup
         q->type = q->q.qtype; // Try getting an address of the requested type first
-        ip_addr_t addr = {};
         ret = getHostByName(name, &addr, q.get());
         if (ret == GetHostByNameResult::DONE) {
             ret = sendResponse(addr, name, *q, ctx_.get());
@@ -474,6 +542,7 @@ int Dns64::sendResponse(const ip_addr_t& addr, const char* name, const Query& q,
     } else {
         ip_addr_copy(raddr, addr);
     }
+    ctx->cacheAnswer(name, q.q.qtype, raddr);
     const size_t addrSize = IPADDR_SIZE(&raddr); // Size of the serialized IP address
     // Allocate a buffer for response data
     const size_t qnameSize = strlen(name) + 2; // Including the length and term. null bytes
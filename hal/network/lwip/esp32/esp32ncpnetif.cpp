@@ -36,6 +36,7 @@ LOG_SOURCE_CATEGORY("net.esp32ncp")
 #include <lwip/dhcp.h>
 #include <lwip/dns.h>
 #include <algorithm>
+#include <new>
 #include "lwiplock.h"
 #include "network/ncp/wifi/wifi_ncp_client.h"
 #include "concurrent_hal.h"
@@ -260,24 +261,14 @@ void Esp32NcpNetif::ncpEventHandlerCb(const NcpEvent& ev, void* ctx) {
 
 void Esp32NcpNetif::ncpDataHandlerCb(int id, const uint8_t* data, size_t size, void* ctx) {
     Esp32NcpNetif* self = static_cast<Esp32NcpNetif*>(ctx);
-    size_t pktSize = size;
-#if ETH_PAD_SIZE
-        /* allow room for Ethernet padding */
-    pktSize += ETH_PAD_SIZE;
-#endif /* ETH_PAD_SIZE */
-
-    pbuf* p = pbuf_alloc(PBUF_RAW, pktSize, PBUF_POOL);
+    // The frame is copied from the muxer's receive buffer straight into pool buffers. Frames
+    // larger than PBUF_POOL_BUFSIZE end up in a chain of them
+    pbuf* p = pbuf_alloc(PBUF_RAW, size + ETH_PAD_SIZE, PBUF_POOL);
     if (p != nullptr) {
-#if ETH_PAD_SIZE
-        /* drop the padding word */
-        pbuf_remove_header(p, ETH_PAD_SIZE);
-#endif /* ETH_PAD_SIZE */
-        memcpy(p->payload, data, size);
-#if ETH_PAD_SIZE
-        /* reclaim the padding word */
-        pbuf_add_header(p, ETH_PAD_SIZE);
-#endif /* ETH_PAD_SIZE */
-
+        if (pbuf_take_at(p, data, size, ETH_PAD_SIZE) != ERR_OK) {
+            pbuf_free(p);
+            return;
+        }
         LwipTcpIpCoreLock lk;
         if (self->interface()->input(p, self->interface()) != ERR_OK) {
             LOG(ERROR, "Error inputing packet");
@@ -305,14 +296,22 @@ err_t Esp32NcpNetif::linkOutput(pbuf* p) {
     pbuf_remove_header(p, ETH_PAD_SIZE); /* drop the padding word */
 #endif
 
+    err_t err = ERR_OK;
     if (p->len == p->tot_len) {
         // non-queue packet
         wifiMan_->ncpClient()->dataChannelWrite(0, (const uint8_t*)p->payload, p->tot_len);
     } else {
-        pbuf* q = pbuf_clone(PBUF_LINK, PBUF_RAM, p);
-        if (q) {
-            wifiMan_->ncpClient()->dataChannelWrite(0, (const uint8_t*)q->payload, q->tot_len);
-            pbuf_free(q);
+        // The muxer takes a contiguous frame. Instead of cloning the chain into a new heap
+        // buffer for every packet, it's gathered into a buffer that is kept for the lifetime
+        // of the interface. This function is always called with the lwIP core lock held
+        if (!txBuf_) {
+            txBuf_.reset(new(std::nothrow) uint8_t[TX_BUFFER_SIZE]);
+        }
+        if (txBuf_ && p->tot_len <= TX_BUFFER_SIZE) {
+            const size_t n = pbuf_copy_partial(p, txBuf_.get(), p->tot_len, 0);
+            wifiMan_->ncpClient()->dataChannelWrite(0, txBuf_.get(), n);
+        } else {
+            err = ERR_MEM;
         }
     }
 
@@ -320,7 +319,7 @@ err_t Esp32NcpNetif::linkOutput(pbuf* p) {
     pbuf_add_header(p, ETH_PAD_SIZE); /* reclaim the padding word */
 #endif
 
-    return ERR_OK;
+    return err;
 }
 
 err_t Esp32NcpNetif::linkOutputCb(netif* netif, pbuf* p) {
@@ -69,12 +69,16 @@ private:
     err_t linkOutput(pbuf* p);
 
 private:
+    // Ethernet header and MTU
+    static const size_t TX_BUFFER_SIZE = 14 + 1500;
+
     os_thread_t thread_ = nullptr;
     os_queue_t queue_ = nullptr;
     std::atomic_bool exit_;
     bool up_ = false;
     particle::WifiNetworkManager* wifiMan_ = nullptr;
     std::unique_ptr<char[]> hostname_;
+    std::unique_ptr<uint8_t[]> txBuf_;
 };
 
 } } // namespace particle::net
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <lwip/opt.h>
+
+#if LWIP_STATS && MEMP_STATS
+
+#include <lwip/memp.h>
+#include <lwip/stats.h>
+
+#include "spark_wiring_diagnostics.h"
+
+namespace {
+
+using namespace particle;
+
+// Maximum number of buffers in the pbuf pool that have been in use at the same time. This
+// shows how close the application gets to the PBUF_POOL_SIZE of the selected memory profile
+class PbufPoolMaxUsedDiagnosticData: public AbstractIntegerDiagnosticData {
+public:
+    PbufPoolMaxUsedDiagnosticData() :
+            AbstractIntegerDiagnosticData(DIAG_ID_NETWORK_LWIP_PBUF_POOL_MAX_USED, DIAG_NAME_NETWORK_LWIP_PBUF_POOL_MAX_USED) {
+    }
+
+    int get(IntType& val) override {
+        const auto stats = lwip_stats.memp[MEMP_PBUF_POOL];
+        if (!stats) {
+            return SYSTEM_ERROR_NOT_SUPPORTED;
+        }
+        val = stats->max;
+        return 0;
+    }
+};
+
+// Total number of failed allocations from all lwIP memory pools
+class PoolErrorsDiagnosticData: public AbstractIntegerDiagnosticData {
+public:
+    PoolErrorsDiagnosticData() :
+            AbstractIntegerDiagnosticData(DIAG_ID_NETWORK_LWIP_POOL_ERRORS, DIAG_NAME_NETWORK_LWIP_POOL_ERRORS) {
+    }
+
+    int get(IntType& val) override {
+        IntType errors = 0;
+        for (unsigned i = 0; i < MEMP_MAX; ++i) {
+            const auto stats = lwip_stats.memp[i];
+            if (stats) {
+                errors += stats->err;
+            }
+        }
+        val = errors;
+        return 0;
+    }
+};
+
+PbufPoolMaxUsedDiagnosticData g_pbufPoolMaxUsedDiagData;
+PoolErrorsDiagnosticData g_poolErrorsDiagData;
+
+} // unnamed
+
+#endif // LWIP_STATS && MEMP_STATS
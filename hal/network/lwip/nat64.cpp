@@ -59,6 +59,54 @@ uint16_t ip6HeaderLen(uint8_t v) {
     return (8 * (1 + v));
 }
 
+/* Return value of natInput() indicating that the packet has been forwarded in place */
+const int NAT_INPUT_FORWARDED = 2;
+
+/* Incremental update of an Internet checksum (RFC 1624) after replacing some of the covered
+ * fields. The fields are expected to be 16-bit aligned and in network byte order */
+class ChecksumUpdate {
+public:
+    explicit ChecksumUpdate(uint16_t chksum)
+            : sum_((uint16_t)~chksum) {
+    }
+
+    void remove(const void* data, size_t size) {
+        add(data, size, 0xffff);
+    }
+
+    void insert(const void* data, size_t size) {
+        add(data, size, 0x0000);
+    }
+
+    uint16_t udpChecksum() const {
+        uint32_t sum = sum_;
+        while (sum >> 16) {
+            sum = (sum & 0xffff) + (sum >> 16);
+        }
+        const uint16_t chksum = ~sum;
+        /* Zero means no checksum, transmit it as all ones instead */
+        return chksum ? chksum : 0xffff;
+    }
+
+private:
+    uint32_t sum_;
+
+    void add(const void* data, size_t size, uint16_t mask) {
+        auto d = (const uint8_t*)data;
+        for (size_t i = 0; i + 1 < size; i += 2) {
+            uint16_t w;
+            memcpy(&w, d + i, sizeof(w));
+            sum_ += (uint16_t)(w ^ mask);
+        }
+    }
+};
+
+bool canRewriteInPlace(const pbuf* p) {
+    /* The headers can only be rewritten in an exclusively owned RAM or pool buffer */
+    return p->ref == 1 && (p->type_internal == (uint8_t)PBUF_RAM || p->type_internal == (uint8_t)PBUF_POOL) &&
+            p->len >= UDP_HLEN;
+}
+
 uint16_t nextBoundId(uint16_t id, uint16_t min, uint16_t max) {
     ++id;
     if (id > max) {
@@ -85,7 +133,7 @@ const uint16_t DEFAULT_ICMP_NAT_MAX_ID = 65535;
 const size_t DEFAULT_POOL_SIZE = 6 * 1024;
 const size_t DEFAULT_MAX_TRANSLATION_ENTRIES = DEFAULT_POOL_SIZE / NAT64_ENTRY_SIZE;
 
-const size_t DEFAULT_SESSION_CLEANUP_TIMEOUT = 1000;
+const size_t DEFAULT_SESSION_CLEANUP_TIMEOUT = NAT64_TIMER_WHEEL_TICK;
 
 static_assert(MEMP_NUM_SYS_TIMEOUT > LWIP_NUM_SYS_TIMEOUT_INTERNAL, "An extra timeout should be allocated for NAT64 service. Increase MEMP_NUM_SYS_TIMEOUT");
 
@@ -134,6 +182,7 @@ bool Nat64::disable(netif* any) {
         delete rule_;
         rule_ = nullptr;
     }
+    ip4Egress_ = nullptr;
 
     return true;
 }
@@ -154,6 +203,10 @@ int Nat64::ip4Input(pbuf* p, ip_hdr* header, netif* in) {
         const uint16_t hlen = IPH_HL_BYTES(header);
         pbuf_remove_header(p, hlen);
         r = natInput(ip_current_src_addr(), ip_current_dest_addr(), proto, p, in, header);
+        if (r == NAT_INPUT_FORWARDED) {
+            /* The packet now belongs to the egress interface, leave it as is */
+            return 1;
+        }
         pbuf_add_header_force(p, hlen);
     }
 
@@ -219,6 +272,10 @@ int Nat64::ip6Input(pbuf* p, ip6_hdr* header, netif* in) {
     proto = ipProtoToL4Protocol(*nexth);
     if (proto != L4_PROTO_NONE) {
         r = natInput(ip_current_src_addr(), ip_current_dest_addr(), proto, p, in, header);
+        if (r == NAT_INPUT_FORWARDED) {
+            /* The packet now belongs to the egress interface, leave it as is */
+            return 1;
+        }
     }
 
 cleanup:
@@ -278,6 +335,10 @@ int Nat64::natInput(const ip_addr_t* src, const ip_addr_t* dst, L4Protocol proto
             /* Attempt to create a new session */
             LOG_DEBUG(TRACE, "No matching session found, trying to create one");
             session = bib->addSession(dstAddr, protoLifetime, *pool_);
+            if (session) {
+                auto& timers = proto == L4_PROTO_UDP ? udpSessionTimers_ : icmpSessionTimers_;
+                timers.schedule(session);
+            }
         } else if (!session && dstAddr.isV4()) {
             LOG_DEBUG(WARN, "Not creating a new session, full-cone NAT is not enabled");
         }
@@ -300,6 +361,14 @@ int Nat64::natInput(const ip_addr_t* src, const ip_addr_t* dst, L4Protocol proto
         return 0;
     }
 
+    if (proto == L4_PROTO_UDP) {
+        const bool forwarded = srcAddr.isV6() ? forwardToIp4(p, (ip6_hdr*)ipheader, session) :
+                forwardToIp6(p, (ip_hdr*)ipheader, session, in);
+        if (forwarded) {
+            return NAT_INPUT_FORWARDED;
+        }
+    }
+
     /* Copy UDP packet */
     pbuf* q = pbuf_clone(PBUF_IP, PBUF_RAM, p);
     if (!q) {
@@ -378,6 +447,140 @@ int Nat64::natInput(const ip_addr_t* src, const ip_addr_t* dst, L4Protocol proto
     return 1;
 }
 
+bool Nat64::forwardToIp4(pbuf* p, ip6_hdr* ip6hdr, SessionEntry* session) {
+    udp_hdr* udphdr = (udp_hdr*)p->payload;
+    const uint8_t hl = IP6H_HOPLIM(ip6hdr);
+    /* Packets that are about to expire are left to the regular path */
+    if (!canRewriteInPlace(p) || udphdr->chksum == 0 || hl <= 1) {
+        return false;
+    }
+
+    const ip4_addr_t src = session->src4().address();
+    const Ip4TransportAddress dst4 = session->dst4();
+    netif* out = routeIp4(src, dst4.address());
+    if (!out || (out->mtu && p->tot_len + IP_HLEN > out->mtu)) {
+        return false;
+    }
+
+    const uint16_t srcPort = lwip_htons(session->src4().port());
+    const uint16_t dstPort = lwip_htons(dst4.port());
+    const uint8_t tos = IP6H_TC(ip6hdr);
+
+    /* Only the pseudo header and the ports change, no need to go through the payload */
+    ChecksumUpdate chksum(udphdr->chksum);
+    chksum.remove(&ip6hdr->src, sizeof(ip6hdr->src));
+    chksum.remove(&ip6hdr->dest, sizeof(ip6hdr->dest));
+    chksum.remove(&udphdr->src, sizeof(udphdr->src));
+    chksum.remove(&udphdr->dest, sizeof(udphdr->dest));
+    chksum.insert(&src, sizeof(src));
+    chksum.insert(&dst4.address(), sizeof(ip4_addr_t));
+    chksum.insert(&srcPort, sizeof(srcPort));
+    chksum.insert(&dstPort, sizeof(dstPort));
+
+    /* The IPv4 header is shorter and fits into the space occupied by the IPv6 header */
+    if (pbuf_add_header(p, IP_HLEN)) {
+        return false;
+    }
+    udphdr->src = srcPort;
+    udphdr->dest = dstPort;
+    udphdr->chksum = chksum.udpChecksum();
+
+    ip_hdr* iphdr = (ip_hdr*)p->payload;
+    IPH_VHL_SET(iphdr, 4, IP_HLEN / 4);
+    IPH_TOS_SET(iphdr, tos);
+    IPH_LEN_SET(iphdr, lwip_htons(p->tot_len));
+    IPH_ID_SET(iphdr, lwip_htons(ip4Id_));
+    ++ip4Id_;
+    IPH_OFFSET_SET(iphdr, 0);
+    IPH_TTL_SET(iphdr, hl - 1);
+    IPH_PROTO_SET(iphdr, IP_PROTO_UDP);
+    ip4_addr_copy(iphdr->src, src);
+    ip4_addr_copy(iphdr->dest, dst4.address());
+    IPH_CHKSUM_SET(iphdr, 0);
+#if CHECKSUM_GEN_IP
+    IF__NETIF_CHECKSUM_ENABLED(out, NETIF_CHECKSUM_GEN_IP) {
+        IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, IP_HLEN));
+    }
+#endif /* CHECKSUM_GEN_IP */
+
+    LOG_DEBUG(TRACE, "Forwarded IPv4 pkt in place");
+    out->output(out, p, &dst4.address());
+    return true;
+}
+
+bool Nat64::forwardToIp6(pbuf* p, ip_hdr* iphdr, SessionEntry* session, netif* in) {
+    udp_hdr* udphdr = (udp_hdr*)p->payload;
+    const uint8_t ttl = IPH_TTL(iphdr);
+    /* Packets without a UDP checksum need a full one computed for IPv6 */
+    if (!canRewriteInPlace(p) || udphdr->chksum == 0 || ttl <= 1) {
+        return false;
+    }
+
+    netif* out = rule_->inside();
+    if (!out || out == in || !netif_is_up(out) || !netif_is_link_up(out) ||
+            p->tot_len + IP6_HLEN > netif_mtu6(out)) {
+        return false;
+    }
+
+    /* FIXME: zones should be cleared before being stored in the session */
+    ip6_addr_t src = session->dst6().address();
+    ip6_addr_t dst = session->src6().address();
+    ip6_addr_clear_zone(&src);
+    ip6_addr_clear_zone(&dst);
+    const uint16_t srcPort = lwip_htons(session->dst6().port());
+    const uint16_t dstPort = lwip_htons(session->src6().port());
+    const uint8_t tos = IPH_TOS(iphdr);
+
+    ChecksumUpdate chksum(udphdr->chksum);
+    chksum.remove(&iphdr->src, sizeof(iphdr->src));
+    chksum.remove(&iphdr->dest, sizeof(iphdr->dest));
+    chksum.remove(&udphdr->src, sizeof(udphdr->src));
+    chksum.remove(&udphdr->dest, sizeof(udphdr->dest));
+    chksum.insert(src.addr, sizeof(src.addr));
+    chksum.insert(dst.addr, sizeof(dst.addr));
+    chksum.insert(&srcPort, sizeof(srcPort));
+    chksum.insert(&dstPort, sizeof(dstPort));
+
+    /* Fails if the input interface didn't reserve enough space in front of the IPv4 header */
+    if (pbuf_add_header(p, IP6_HLEN)) {
+        return false;
+    }
+    udphdr->src = srcPort;
+    udphdr->dest = dstPort;
+    udphdr->chksum = chksum.udpChecksum();
+
+    ip6_hdr* ip6hdr = (ip6_hdr*)p->payload;
+    IP6H_VTCFL_SET(ip6hdr, 6, tos, 0);
+    IP6H_PLEN_SET(ip6hdr, p->tot_len - IP6_HLEN);
+    IP6H_NEXTH_SET(ip6hdr, IP6_NEXTH_UDP);
+    IP6H_HOPLIM_SET(ip6hdr, ttl - 1);
+    ip6_addr_copy_to_packed(ip6hdr->src, src);
+    ip6_addr_copy_to_packed(ip6hdr->dest, dst);
+
+    LOG_DEBUG(TRACE, "Forwarded IPv6 pkt in place");
+    out->output_ip6(out, p, &dst);
+    return true;
+}
+
+netif* Nat64::routeIp4(const ip4_addr_t& src, const ip4_addr_t& dst) {
+    netif* out = rule_->outside();
+    if (!out) {
+        /* The BIB binds the sessions to the address of the interface they were created on,
+         * so the last used interface is still the right one as long as its address matches */
+        out = ip4Egress_;
+        if (!out || !ip4_addr_cmp(netif_ip4_addr(out), &src)) {
+            out = ip4_route_src(&src, &dst);
+            ip4Egress_ = out;
+        }
+    }
+
+    if (!out || !netif_is_up(out) || !netif_is_link_up(out) || !ip4_addr_cmp(netif_ip4_addr(out), &src)) {
+        return nullptr;
+    }
+
+    return out;
+}
+
 bool Nat64::filter(const IpTransportAddress& src, const IpTransportAddress& dst, netif* in) const {
     if (!rule_ || !pool_) {
         return true;
@@ -412,14 +615,8 @@ bool Nat64::filter(const IpTransportAddress& src, const IpTransportAddress& dst,
 }
 
 BibEntry* Nat64::lookupBib(const IpTransportAddress& src, const IpTransportAddress& dst, L4Protocol proto) {
-    BibTable& tbl = proto == L4_PROTO_UDP ? udpBibTable_ : icmpBibTable_;
-    const IpTransportAddress& addr = src.isV6() ? src : dst;
-    for (auto entry = tbl.front(); entry != nullptr; entry = entry->next) {
-        if (entry->matches(addr)) {
-            return entry;
-        }
-    }
-    return nullptr;
+    const BibTable& tbl = proto == L4_PROTO_UDP ? udpBibTable_ : icmpBibTable_;
+    return tbl.lookup(src.isV6() ? src : dst);
 }
 
 BibEntry* Nat64::addBib(const IpTransportAddress& src, const IpTransportAddress& dst, L4Protocol proto) {
@@ -448,7 +645,7 @@ BibEntry* Nat64::addBib(const IpTransportAddress& src, const IpTransportAddress&
                         BibEntry* bib = static_cast<BibEntry*>(pool_->alloc(NAT64_ENTRY_SIZE));
                         if (bib) {
                             new (bib) BibEntry(src, src4);
-                            tbl.pushFront(bib);
+                            tbl.insert(bib);
                             return bib;
                         }
                     }
@@ -503,40 +700,45 @@ bool Nat64::findNextIcmpId(Ip4TransportAddress& src) {
     return false;
 }
 
-void Nat64::timeout(uint32_t dt) {
-    for (auto bib = udpBibTable_.front(), p = static_cast<BibEntry*>(nullptr); bib != nullptr;) {
-        if (bib->timeout(dt, *pool_)) {
-            LOG_DEBUG(TRACE, "UDP BIB %s#%u <-> %s#%u timed out",
-                      IP6ADDR_NTOA(&bib->src6().address()), bib->src6().l4Id(),
-                      IP4ADDR_NTOA(&bib->dst4().address()), bib->dst4().l4Id());
-
-            auto popped = udpBibTable_.pop(bib, p);
-            bib = popped->next;
-            pool_->free(popped);
-        } else {
-            p = bib;
-            bib = bib->next;
-        }
-    }
-
-    for (auto bib = icmpBibTable_.front(), p = static_cast<BibEntry*>(nullptr); bib != nullptr;) {
-        if (bib->timeout(dt, *pool_)) {
-            LOG_DEBUG(TRACE, "ICMP BIB %s#%u <-> %s#%u timed out",
-                      IP6ADDR_NTOA(&bib->src6().address()), bib->src6().l4Id(),
-                      IP4ADDR_NTOA(&bib->dst4().address()), bib->dst4().l4Id());
+void Nat64::timeout(uint32_t now) {
+    expireSessions(udpBibTable_, udpSessionTimers_, now);
+    expireSessions(icmpBibTable_, icmpSessionTimers_, now);
+}
 
-            auto popped = udpBibTable_.pop(bib, p);
-            bib = popped->next;
-            pool_->free(popped);
-        } else {
-            p = bib;
-            bib = bib->next;
+void Nat64::expireSessions(BibTable& tbl, SessionTimerWheel& timers, uint32_t now) {
+    SessionEntry* s = nullptr;
+    while (timers.advance(now, s)) {
+        while (s) {
+            auto next = SessionTimerWheel::next(s);
+            if (!s->expired(now)) {
+                /* Lifetime has been refreshed since the session was scheduled */
+                timers.schedule(s);
+            } else {
+                LOG_DEBUG(TRACE, "Session timed out %s#%u <-> %s#%u, %s#%u <-> %s#%u",
+                          IP6ADDR_NTOA(&s->src6().address()), s->src6().l4Id(),
+                          IP6ADDR_NTOA(&s->dst6().address()), s->dst6().l4Id(),
+                          IP4ADDR_NTOA(&s->src4().address()), s->src4().l4Id(),
+                          IP4ADDR_NTOA(&s->dst4().address()), s->dst4().l4Id());
+                auto bib = s->bib();
+                bib->removeSession(s, *pool_);
+                if (bib->empty()) {
+                    LOG_DEBUG(TRACE, "%s BIB %s#%u <-> %s#%u timed out", &tbl == &udpBibTable_ ? "UDP" : "ICMP",
+                              IP6ADDR_NTOA(&bib->src6().address()), bib->src6().l4Id(),
+                              IP4ADDR_NTOA(&bib->dst4().address()), bib->dst4().l4Id());
+                    tbl.remove(bib);
+                    pool_->free(bib);
+                }
+            }
+            s = next;
         }
     }
 }
 
 void Nat64::enableSessionTimer() {
     LwipTcpIpCoreLock lock;
+    const uint32_t now = sys_now();
+    udpSessionTimers_.reset(now);
+    icmpSessionTimers_.reset(now);
     timeoutHandlerCb(this);
 }
 
@@ -547,6 +749,6 @@ void Nat64::disableSessionTimer() {
 
 void Nat64::timeoutHandlerCb(void* arg) {
     auto self = static_cast<Nat64*>(arg);
-    self->timeout(DEFAULT_SESSION_CLEANUP_TIMEOUT);
+    self->timeout(sys_now());
     sys_timeout(DEFAULT_SESSION_CLEANUP_TIMEOUT, &timeoutHandlerCb, self);
 }
@@ -24,6 +24,7 @@
 #include <lwip/ip6.h>
 #include <lwip/netif.h>
 #include <lwip/pbuf.h>
+#include <lwip/sys.h>
 #include <memory>
 #include <cstring>
 #include "intrusive_list.h"
@@ -143,7 +144,6 @@ class BibEntry;
 class SessionEntry;
 class RuleEntry;
 
-using BibTable = particle::IntrusiveList<BibEntry>;
 using SessionTable = particle::IntrusiveList<SessionEntry>;
 using RuleTable = particle::IntrusiveList<RuleEntry>;
 
@@ -165,14 +165,18 @@ public:
 
     SessionEntry* lookupSession(const IpTransportAddress& src, const IpTransportAddress& dst);
     SessionEntry* addSession(const Ip6TransportAddress& dst, uint32_t lifetime, particle::SimpleAllocator& allocator);
-
-    bool timeout(uint32_t dt, particle::SimpleAllocator& allocator);
+    void removeSession(SessionEntry* session, particle::SimpleAllocator& allocator);
 
 private:
+    friend class BibTable;
+
     Ip6TransportAddress src6_;
     Ip4TransportAddress dst4_;
 
     SessionTable sessions_;
+
+    /* Next entry in the IPv4 index bucket, ListNode::next links the IPv6 index bucket */
+    BibEntry* next4_;
 };
 
 class SessionEntry : public ListNode<SessionEntry> {
@@ -191,17 +195,76 @@ public:
     uint32_t setLifetime(uint32_t lifetime);
     uint32_t lifetime() const;
 
-    bool timeout(uint32_t dt);
+    uint32_t expiry() const;
+    bool expired(uint32_t now) const;
 
 private:
+    friend class SessionTimerWheel;
+
     BibEntry* bib_;
     Ip6TransportAddress dst6_;
 
-    uint32_t lifetime_;
+    /* Absolute expiration time (sys_now()) */
+    uint32_t expiry_;
+
+    /* Next session in the same timer wheel slot */
+    SessionEntry* nextTimer_;
 };
 
 static const size_t NAT64_ENTRY_SIZE = std::max(sizeof(BibEntry), sizeof(SessionEntry));
 
+/* Number of buckets in each of the BIB indices, should be a power of two */
+static const size_t NAT64_BIB_HASH_SIZE = 16;
+
+/*
+ * BIB table indexed both by the IPv6 transport address (packets coming from the inside)
+ * and by the IPv4 transport address (packets coming from the outside and port allocation).
+ */
+class BibTable {
+public:
+    BibTable();
+
+    BibEntry* lookup(const IpTransportAddress& addr) const;
+    void insert(BibEntry* bib);
+    void remove(BibEntry* bib);
+
+private:
+    static size_t hash(const Ip6TransportAddress& addr);
+    static size_t hash(const Ip4TransportAddress& addr);
+    static size_t fold(uint32_t h);
+
+    BibEntry* index6_[NAT64_BIB_HASH_SIZE];
+    BibEntry* index4_[NAT64_BIB_HASH_SIZE];
+};
+
+/* Number of slots in the session timer wheel, should be a power of two */
+static const size_t NAT64_TIMER_WHEEL_SIZE = 32;
+/* Timer wheel resolution in milliseconds */
+static const uint32_t NAT64_TIMER_WHEEL_TICK = 1000;
+
+/*
+ * Hashed timer wheel for session expiration. Sessions are only checked when their slot comes up,
+ * instead of walking every session on every timer tick. Refreshing a session lifetime doesn't move
+ * it between slots: a session that is found to be still alive is simply rescheduled.
+ */
+class SessionTimerWheel {
+public:
+    SessionTimerWheel();
+
+    void reset(uint32_t now);
+    void schedule(SessionEntry* session);
+
+    /* Detaches the sessions of the next slot if its tick has elapsed by now */
+    bool advance(uint32_t now, SessionEntry*& sessions);
+    static SessionEntry* next(const SessionEntry* session);
+
+private:
+    SessionEntry* slots_[NAT64_TIMER_WHEEL_SIZE];
+    /* Start time of the current slot */
+    uint32_t base_;
+    size_t current_;
+};
+
 class Nat64 {
 public:
     Nat64();
@@ -220,6 +283,12 @@ protected:
     int natInput(const ip_addr_t* src, const ip_addr_t* dst, L4Protocol proto, pbuf* p, netif* in, void* ipheader);
     bool filter(const IpTransportAddress& src, const IpTransportAddress& dst, netif* in) const;
 
+    /* Fast path for established sessions: rewrites the headers in place and outputs the packet
+     * directly on the egress interface, bypassing the IP routing and the packet copy */
+    bool forwardToIp4(pbuf* p, ip6_hdr* header, SessionEntry* session);
+    bool forwardToIp6(pbuf* p, ip_hdr* header, SessionEntry* session, netif* in);
+    netif* routeIp4(const ip4_addr_t& src, const ip4_addr_t& dst);
+
     BibEntry* lookupBib(const IpTransportAddress& src, const IpTransportAddress& dst, L4Protocol proto);
     BibEntry* addBib(const IpTransportAddress& src, const IpTransportAddress& dst, L4Protocol proto);
 
@@ -227,7 +296,8 @@ protected:
     bool findNextUdpPort(Ip4TransportAddress& src);
     bool findNextIcmpId(Ip4TransportAddress& src);
 
-    void timeout(uint32_t dt);
+    void timeout(uint32_t now);
+    void expireSessions(BibTable& tbl, SessionTimerWheel& timers, uint32_t now);
 
     void enableSessionTimer();
     void disableSessionTimer();
@@ -244,10 +314,17 @@ private:
     ip6_addr_t pref64_;
 
     BibTable udpBibTable_;
+    SessionTimerWheel udpSessionTimers_;
     uint16_t udpNextPort_;
     BibTable icmpBibTable_;
+    SessionTimerWheel icmpSessionTimers_;
     uint16_t icmpNextId_;
 
+    /* Last used IPv4 egress interface */
+    netif* ip4Egress_ = nullptr;
+    /* Identification of the IPv4 packets produced by the fast path */
+    uint16_t ip4Id_ = 0;
+
     std::unique_ptr<SimpleAllocedPool> pool_;
 };
 
@@ -410,7 +487,8 @@ inline netif* Rule::outside() const {
 /* BibEntry */
 inline BibEntry::BibEntry(const Ip6TransportAddress& src6, const Ip4TransportAddress& dst4)
         : src6_(src6),
-          dst4_(dst4) {
+          dst4_(dst4),
+          next4_(nullptr) {
 }
 
 inline const Ip6TransportAddress& BibEntry::src6() const {
@@ -459,32 +537,18 @@ inline SessionEntry* BibEntry::addSession(const Ip6TransportAddress& dst, uint32
     return nullptr;
 }
 
-inline bool BibEntry::timeout(uint32_t dt, particle::SimpleAllocator& allocator) {
-    using namespace particle::net;
-    for (auto s = sessions_.front(), p = static_cast<SessionEntry*>(nullptr); s != nullptr;) {
-        if (s->timeout(dt)) {
-            LOG_DEBUG(TRACE, "Session timed out %s#%u <-> %s#%u, %s#%u <-> %s#%u",
-                      IP6ADDR_NTOA(&s->src6().address()), s->src6().l4Id(),
-                      IP6ADDR_NTOA(&s->dst6().address()), s->dst6().l4Id(),
-                      IP4ADDR_NTOA(&s->src4().address()), s->src4().l4Id(),
-                      IP4ADDR_NTOA(&s->dst4().address()), s->dst4().l4Id());
-            auto popped = sessions_.pop(s, p);
-            s = popped->next;
-            allocator.free(popped);
-        } else {
-            p = s;
-            s = s->next;
-        }
+inline void BibEntry::removeSession(SessionEntry* session, particle::SimpleAllocator& allocator) {
+    if (sessions_.pop(session)) {
+        allocator.free(session);
     }
-
-    return empty();
 }
 
 /* SessionEntry */
 inline SessionEntry::SessionEntry(BibEntry* bib, const Ip6TransportAddress& dst6)
         : bib_(bib),
           dst6_(dst6),
-          lifetime_(0) {
+          expiry_(sys_now()),
+          nextTimer_(nullptr) {
 }
 
 inline BibEntry* SessionEntry::bib() {
@@ -521,21 +585,129 @@ inline bool SessionEntry::matches(const IpTransportAddress& src, const IpTranspo
 }
 
 inline uint32_t SessionEntry::setLifetime(uint32_t lifetime) {
-    std::swap(lifetime_, lifetime);
-    return lifetime;
+    const uint32_t remaining = this->lifetime();
+    expiry_ = sys_now() + lifetime;
+    return remaining;
 }
 
 inline uint32_t SessionEntry::lifetime() const {
-    return lifetime_;
+    const uint32_t now = sys_now();
+    return expired(now) ? 0 : expiry_ - now;
+}
+
+inline uint32_t SessionEntry::expiry() const {
+    return expiry_;
+}
+
+inline bool SessionEntry::expired(uint32_t now) const {
+    return (int32_t)(now - expiry_) >= 0;
+}
+
+/* BibTable */
+inline BibTable::BibTable()
+        : index6_(),
+          index4_() {
 }
 
-inline bool SessionEntry::timeout(uint32_t dt) {
-    if (lifetime() <= dt) {
-        setLifetime(0);
-        return true;
+inline BibEntry* BibTable::lookup(const IpTransportAddress& addr) const {
+    if (addr.isV6()) {
+        const Ip6TransportAddress addr6(addr);
+        for (auto entry = index6_[hash(addr6)]; entry != nullptr; entry = entry->next) {
+            if (entry->src6() == addr6) {
+                return entry;
+            }
+        }
+    } else if (addr.isV4()) {
+        const Ip4TransportAddress addr4(addr);
+        for (auto entry = index4_[hash(addr4)]; entry != nullptr; entry = entry->next4_) {
+            if (entry->dst4() == addr4) {
+                return entry;
+            }
+        }
     }
-    setLifetime(lifetime() - dt);
-    return false;
+
+    return nullptr;
+}
+
+inline void BibTable::insert(BibEntry* bib) {
+    auto& bucket6 = index6_[hash(bib->src6())];
+    bib->next = bucket6;
+    bucket6 = bib;
+    auto& bucket4 = index4_[hash(bib->dst4())];
+    bib->next4_ = bucket4;
+    bucket4 = bib;
+}
+
+inline void BibTable::remove(BibEntry* bib) {
+    for (auto p = &index6_[hash(bib->src6())]; *p != nullptr; p = &(*p)->next) {
+        if (*p == bib) {
+            *p = bib->next;
+            break;
+        }
+    }
+    for (auto p = &index4_[hash(bib->dst4())]; *p != nullptr; p = &(*p)->next4_) {
+        if (*p == bib) {
+            *p = bib->next4_;
+            break;
+        }
+    }
+}
+
+inline size_t BibTable::hash(const Ip6TransportAddress& addr) {
+    const auto& a = addr.address();
+    return fold(a.addr[0] ^ a.addr[1] ^ a.addr[2] ^ a.addr[3] ^ addr.l4Id());
+}
+
+inline size_t BibTable::hash(const Ip4TransportAddress& addr) {
+    return fold(addr.address().addr ^ addr.l4Id());
+}
+
+inline size_t BibTable::fold(uint32_t h) {
+    h ^= h >> 16;
+    h ^= h >> 8;
+    return h & (NAT64_BIB_HASH_SIZE - 1);
+}
+
+/* SessionTimerWheel */
+inline SessionTimerWheel::SessionTimerWheel()
+        : slots_(),
+          base_(0),
+          current_(0) {
+}
+
+inline void SessionTimerWheel::reset(uint32_t now) {
+    base_ = now;
+}
+
+inline void SessionTimerWheel::schedule(SessionEntry* session) {
+    /* Number of ticks until the session expires, rounded up */
+    int32_t ticks = ((int32_t)(session->expiry() - base_) + (int32_t)NAT64_TIMER_WHEEL_TICK - 1) / (int32_t)NAT64_TIMER_WHEEL_TICK;
+    if (ticks < 1) {
+        ticks = 1;
+    }
+    /* Sessions that expire more than one revolution ahead are rescheduled when their slot comes up */
+    auto& slot = slots_[(current_ + ticks) & (NAT64_TIMER_WHEEL_SIZE - 1)];
+    session->nextTimer_ = slot;
+    slot = session;
+}
+
+inline bool SessionTimerWheel::advance(uint32_t now, SessionEntry*& sessions) {
+    if ((int32_t)(now - base_) < (int32_t)NAT64_TIMER_WHEEL_TICK) {
+        return false;
+    }
+    if (now - base_ > NAT64_TIMER_WHEEL_SIZE * NAT64_TIMER_WHEEL_TICK) {
+        /* Don't spin over the same slots more than once if the timer has been stalled */
+        base_ = now - NAT64_TIMER_WHEEL_SIZE * NAT64_TIMER_WHEEL_TICK;
+    }
+    base_ += NAT64_TIMER_WHEEL_TICK;
+    current_ = (current_ + 1) & (NAT64_TIMER_WHEEL_SIZE - 1);
+    sessions = slots_[current_];
+    slots_[current_] = nullptr;
+    return true;
+}
+
+inline SessionEntry* SessionTimerWheel::next(const SessionEntry* session) {
+    return session->nextTimer_;
 }
 
 } } } /* particle::net::nat */
@@ -23,9 +23,86 @@
 
 /* netdb_hal_impl.h should get included from netdb_hal.h automagically */
 #include "netdb_hal.h"
+#include "lwiplock.h"
+#include "timer_hal.h"
 #include <lwip/sockets.h>
 #include <errno.h>
 #include <algorithm>
+#include <cctype>
+
+using namespace particle::net;
+
+namespace {
+
+/* Successful lookups are cached by LwIP's DNS table according to their TTL. Failed lookups
+ * are not, and every getaddrinfo() with AF_UNSPEC would repeat the AAAA query for a host that
+ * only has an IPv4 address */
+const size_t NETDB_NEGATIVE_CACHE_SIZE = 4;
+const system_tick_t NETDB_NEGATIVE_CACHE_TTL = 30000;
+
+struct NegativeCacheEntry {
+    uint32_t hash;
+    int family;
+    system_tick_t time;
+};
+
+NegativeCacheEntry s_negativeCache[NETDB_NEGATIVE_CACHE_SIZE] = {};
+
+uint32_t hostnameHash(const char* hostname) {
+    /* FNV-1a, host names are case-insensitive */
+    uint32_t h = 2166136261u;
+    for (; *hostname; ++hostname) {
+        h = (h ^ (uint8_t)tolower((unsigned char)*hostname)) * 16777619u;
+    }
+    return h ? h : 1;
+}
+
+bool isCacheable(const char* hostname, const struct addrinfo* hints) {
+    return hostname && !(hints && (hints->ai_flags & AI_NUMERICHOST));
+}
+
+bool isNegativelyCached(uint32_t hash, int family) {
+    LwipTcpIpCoreLock lk;
+    const system_tick_t now = HAL_Timer_Get_Milli_Seconds();
+    for (auto& e: s_negativeCache) {
+        if (e.hash == hash && e.family == family) {
+            if (now - e.time < NETDB_NEGATIVE_CACHE_TTL) {
+                return true;
+            }
+            e.hash = 0;
+        }
+    }
+    return false;
+}
+
+void addNegativeCacheEntry(uint32_t hash, int family) {
+    LwipTcpIpCoreLock lk;
+    const system_tick_t now = HAL_Timer_Get_Milli_Seconds();
+    /* Replace an existing or expired entry, or the oldest one */
+    NegativeCacheEntry* entry = &s_negativeCache[0];
+    for (auto& e: s_negativeCache) {
+        if ((e.hash == hash && e.family == family) || !e.hash || now - e.time >= NETDB_NEGATIVE_CACHE_TTL) {
+            entry = &e;
+            break;
+        }
+        if (now - e.time > now - entry->time) {
+            entry = &e;
+        }
+    }
+    entry->hash = hash;
+    entry->family = family;
+    entry->time = now;
+}
+
+int getaddrinfoCached(const char* hostname, const char* servname, const struct addrinfo* hints,
+        struct addrinfo** res) {
+    if (isCacheable(hostname, hints) && isNegativelyCached(hostnameHash(hostname), hints->ai_family)) {
+        return EAI_FAIL;
+    }
+    return lwip_getaddrinfo(hostname, servname, hints, res);
+}
+
+} // anonymous
 
 struct hostent* netdb_gethostbyname(const char *name) {
     return lwip_gethostbyname(name);
@@ -48,14 +125,19 @@ int netdb_getaddrinfo(const char* hostname, const char* servname,
 
         /* First perform a lookup with AF_INET6 */
         h.ai_family = AF_INET6;
-        int rinet6 = lwip_getaddrinfo(hostname, servname, &h, res);
+        int rinet6 = getaddrinfoCached(hostname, servname, &h, res);
 
         /* Next perform a lookup with AF_INET */
         h.ai_family = AF_INET;
         /* FIXME: expects that there is either 1 or 0 results from the previous call */
-        int rinet = lwip_getaddrinfo(hostname, servname, &h, rinet6 == 0 && *res ? &((*res)->ai_next) : res);
+        int rinet = getaddrinfoCached(hostname, servname, &h, rinet6 == 0 && *res ? &((*res)->ai_next) : res);
 
         if (rinet6 == 0 || rinet == 0) {
+            /* LwIP doesn't tell a timeout from a missing record, but a successful lookup for
+             * the other family shows that the DNS server is reachable */
+            if (isCacheable(hostname, hints) && (rinet6 == EAI_FAIL || rinet == EAI_FAIL)) {
+                addNegativeCacheEntry(hostnameHash(hostname), rinet6 == EAI_FAIL ? AF_INET6 : AF_INET);
+            }
             return 0;
         }
 
@@ -64,6 +146,13 @@ int netdb_getaddrinfo(const char* hostname, const char* servname,
     return lwip_getaddrinfo(hostname, servname, hints, res);
 }
 
+void netdb_clear_negative_cache() {
+    LwipTcpIpCoreLock lk;
+    for (auto& e: s_negativeCache) {
+        e.hash = 0;
+    }
+}
+
 int netdb_getnameinfo(const struct sockaddr* sa, socklen_t salen, char* host,
                       socklen_t hostlen, char* serv, socklen_t servlen, int flags) {
 
@@ -40,6 +40,13 @@ extern "C" {
  *
  */
 
+/**
+ * Discards the cached results of the failed host name lookups.
+ *
+ * This function is called when the list of DNS servers changes.
+ */
+void netdb_clear_negative_cache(void);
+
 /**
  * @}
  *
@@ -40,6 +40,7 @@ LOG_SOURCE_CATEGORY("net.th")
 #include "hal_platform.h"
 
 #include "random.h"
+#include "timer_hal.h"
 
 // FIXME:
 #include "system_threading.h"
@@ -49,6 +50,12 @@ using namespace particle::net;
 
 namespace {
 
+/* RLOC16 of a device that has never attached to a Thread network */
+const uint16_t INVALID_RLOC16 = 0xfffe;
+
+/* Time given to the device to resume its previous attachment before falling back to the full attach procedure */
+const unsigned FAST_REJOIN_TIMEOUT = 2000;
+
 void updateIp6CloudKeepalive(unsigned int value) {
     struct Task: public ISRTaskQueue::Task {
         unsigned int value;
@@ -225,6 +232,9 @@ OpenThreadNetif::OpenThreadNetif(otInstance* ot)
 }
 
 OpenThreadNetif::~OpenThreadNetif() {
+    if (rejoinTimer_) {
+        os_timer_destroy(rejoinTimer_, nullptr);
+    }
     {
         ot::ThreadLock lk;
         /* Unregister OpenThread state changed and receive callbacks */
@@ -368,6 +378,7 @@ void OpenThreadNetif::stateChanged(uint32_t flags) {
                 break;
             }
             default: {
+                stopRejoin(true);
                 netif_set_link_up(interface());
                 refreshIpAddresses();
 
@@ -765,6 +776,8 @@ int OpenThreadNetif::up() {
     LOG(INFO, "Network name: %s", otThreadGetNetworkName(ot_));
     LOG(INFO, "802.15.4 channel: %d", (int)otLinkGetChannel(ot_));
     LOG(INFO, "802.15.4 PAN ID: 0x%04x", (unsigned)otLinkGetPanId(ot_));
+    /* The network info restored from the settings is only valid if the device has been attached before */
+    const uint16_t rloc16 = otThreadGetRloc16(ot_);
     int r = 0;
     if ((r = otIp6SetEnabled(ot_, true)) != OT_ERROR_NONE) {
         return r;
@@ -772,6 +785,12 @@ int OpenThreadNetif::up() {
     if ((r = otThreadSetEnabled(ot_, true)) != OT_ERROR_NONE) {
         return r;
     }
+    if (rloc16 != INVALID_RLOC16 && otThreadGetDeviceRole(ot_) == OT_DEVICE_ROLE_DETACHED) {
+        /* OpenThread resumes the previous attachment by sending a Child Update Request to the
+         * last parent, or a Link Request to the neighboring routers if the device was a router */
+        LOG(INFO, "Resuming previous attachment, RLOC16: 0x%04x", (unsigned)rloc16);
+        startRejoin();
+    }
 
     return r;
 }
@@ -781,6 +800,7 @@ int OpenThreadNetif::down() {
     {
         ot::ThreadLock lk;
         LOG(INFO, "Bringing OpenThreadNetif down");
+        stopRejoin(false);
 
         if ((r = otThreadSetEnabled(ot_, false)) != OT_ERROR_NONE) {
             return r;
@@ -797,6 +817,43 @@ int OpenThreadNetif::down() {
     return r;
 }
 
+void OpenThreadNetif::startRejoin() {
+    if (!rejoinTimer_ && os_timer_create(&rejoinTimer_, FAST_REJOIN_TIMEOUT, rejoinTimeoutCb, this, true, nullptr)) {
+        rejoinTimer_ = nullptr;
+        return;
+    }
+    rejoinStart_ = HAL_Timer_Get_Milli_Seconds();
+    rejoining_ = true;
+    os_timer_change(rejoinTimer_, OS_TIMER_CHANGE_START, false, 0, 0, nullptr);
+}
+
+void OpenThreadNetif::stopRejoin(bool attached) {
+    if (!rejoining_) {
+        return;
+    }
+    rejoining_ = false;
+    os_timer_change(rejoinTimer_, OS_TIMER_CHANGE_STOP, false, 0, 0, nullptr);
+    if (attached) {
+        LOG(INFO, "Rejoined in %u ms", (unsigned)(HAL_Timer_Get_Milli_Seconds() - rejoinStart_));
+    }
+}
+
+void OpenThreadNetif::rejoinTimeoutCb(os_timer_t timer) {
+    OpenThreadNetif* self = nullptr;
+    os_timer_get_id(timer, (void**)&self);
+    ot::ThreadLock lk;
+    if (!self->rejoining_) {
+        return;
+    }
+    self->rejoining_ = false;
+    if (otThreadGetDeviceRole(self->ot_) == OT_DEVICE_ROLE_DETACHED) {
+        /* The previous parent or neighbors didn't respond: look for any parent in the partition instead
+         * of waiting for OpenThread to exhaust its retransmissions */
+        LOG(WARN, "Unable to resume previous attachment, attaching to a new parent");
+        otThreadBecomeChild(self->ot_);
+    }
+}
+
 int OpenThreadNetif::powerUp() {
     return 0;
 }
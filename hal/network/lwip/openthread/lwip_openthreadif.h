@@ -25,6 +25,7 @@
 #include <openthread/ip6.h>
 #include <openthread/netdata.h>
 #include "basenetif.h"
+#include "concurrent_hal.h"
 
 #ifdef __cplusplus
 
@@ -57,6 +58,8 @@ private:
     static void otReceiveCb(otMessage* msg, void* ctx);
     /* OpenThread state changed callback */
     static void otStateChangedCb(uint32_t flags, void* ctx);
+    /* Fast rejoin timeout callback */
+    static void rejoinTimeoutCb(os_timer_t timer);
 
     void input(otMessage* message);
     void stateChanged(uint32_t flags);
@@ -67,12 +70,18 @@ private:
     int up();
     int down();
 
+    void startRejoin();
+    void stopRejoin(bool attached);
+
     void setDns(const ip6_addr_t* addr);
 
 private:
     otInstance* ot_ = nullptr;
     otNetifAddress addresses_[OPENTHREAD_CONFIG_MAX_EXT_IP_ADDRS] = {};
     otBorderRouterConfig abr_ = {};
+    os_timer_t rejoinTimer_ = nullptr;
+    system_tick_t rejoinStart_ = 0;
+    volatile bool rejoining_ = false;
 };
 
 } } // namespace particle::net
@@ -45,5 +45,7 @@
 #define select(nfds, readfds, writefds, exceptfds, timeout) sock_select(nfds, readfds, writefds, exceptfds, timeout)
 #define recvmsg(s, message,flags) sock_recvmsg(s, message, flags)
 #define sendmsg(s, message,flags) sock_sendmsg(s, message, flags)
+#define recvmmsg(s, msgvec, vlen, flags) sock_recvmmsg(s, msgvec, vlen, flags)
+#define sendmmsg(s, msgvec, vlen, flags) sock_sendmmsg(s, msgvec, vlen, flags)
 
 #endif /* SYS_SOCKET_H */
@@ -22,10 +22,15 @@
 #include "service_debug.h"
 extern "C" {
 #include <netif/ppp/pppos.h>
+#include <netif/ppp/ppp_impl.h>
 }
 #include <lwip/netifapi.h>
+#include <lwip/memp.h>
+#include <lwip/tcpip.h>
 #include <netif/ppp/pppapi.h>
 #include <mutex>
+#include <algorithm>
+#include <cstring>
 #include "socket_hal.h"
 #include "inet_hal.h"
 #include "system_error.h"
@@ -37,6 +42,150 @@ LOG_SOURCE_CATEGORY("net.ppp.client");
 
 using namespace particle::net::ppp;
 
+#if LWIP_SUPPORT_CUSTOM_PBUF && !PPP_INPROC_IRQ_SAFE && !PPP_CLIENT_FAST_RX
+
+// Incoming data is passed to the TCP/IP thread in pbufs allocated from a dedicated pool, so that
+// PPP traffic neither competes for PBUF_POOL with other interfaces nor has to be split into
+// PBUF_POOL_BUFSIZE chunks
+#ifndef PPP_CLIENT_RX_PBUF_COUNT
+#define PPP_CLIENT_RX_PBUF_COUNT 8
+#endif
+
+#ifndef PPP_CLIENT_RX_PBUF_SIZE
+#define PPP_CLIENT_RX_PBUF_SIZE 256
+#endif
+
+namespace {
+
+struct RxPbuf {
+  struct pbuf_custom p;
+  uint8_t data[PPP_CLIENT_RX_PBUF_SIZE];
+};
+
+LWIP_MEMPOOL_DECLARE(PPP_CLIENT_RX, PPP_CLIENT_RX_PBUF_COUNT, sizeof(RxPbuf), "PPP client RX");
+
+void freeRxPbuf(struct pbuf* p) {
+  LWIP_MEMPOOL_FREE(PPP_CLIENT_RX, p);
+}
+
+struct pbuf* allocRxPbufs(const uint8_t* data, size_t size) {
+  struct pbuf* head = nullptr;
+  while (size > 0) {
+    auto rx = (RxPbuf*)LWIP_MEMPOOL_ALLOC(PPP_CLIENT_RX);
+    if (!rx) {
+      if (head) {
+        pbuf_free(head);
+      }
+      return nullptr;
+    }
+    const size_t n = std::min(size, sizeof(rx->data));
+    memcpy(rx->data, data, n);
+    rx->p.custom_free_function = freeRxPbuf;
+    auto p = pbuf_alloced_custom(PBUF_RAW, n, PBUF_REF, &rx->p, rx->data, sizeof(rx->data));
+    if (head) {
+      pbuf_cat(head, p);
+    } else {
+      head = p;
+    }
+    data += n;
+    size -= n;
+  }
+  return head;
+}
+
+} // unnamed
+
+#endif // LWIP_SUPPORT_CUSTOM_PBUF && !PPP_INPROC_IRQ_SAFE && !PPP_CLIENT_FAST_RX
+
+#if PPP_CLIENT_FAST_RX
+
+namespace {
+
+const uint8_t HDLC_FLAG = 0x7e;
+const uint8_t HDLC_ESCAPE = 0x7d;
+const uint8_t HDLC_TRANS = 0x20;
+
+const uint16_t HDLC_INIT_FCS = 0xffff;
+const uint16_t HDLC_GOOD_FCS = 0xf0b8;
+
+// Address, control, protocol and FCS fields and the information field of the maximum size
+const size_t RX_FRAME_CAPACITY = PPP_MRU + 6;
+
+// RFC 1662, C.2
+const uint16_t FCS_TABLE[256] = {
+  0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
+  0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
+  0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
+  0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
+  0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
+  0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
+  0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
+  0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
+  0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
+  0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
+  0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
+  0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
+  0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
+  0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
+  0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
+  0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
+  0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
+  0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
+  0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
+  0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
+  0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
+  0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
+  0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
+  0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
+  0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
+  0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
+  0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
+  0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
+  0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
+  0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
+  0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
+  0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78
+};
+
+inline uint16_t updateFcs(uint16_t fcs, const uint8_t* data, size_t size) {
+  while (size-- > 0) {
+    fcs = (fcs >> 8) ^ FCS_TABLE[(fcs ^ *data++) & 0xff];
+  }
+  return fcs;
+}
+
+inline uint32_t hasZeroByte(uint32_t v) {
+  return (v - 0x01010101u) & ~v & 0x80808080u;
+}
+
+inline uint32_t hasByteLessThan(uint32_t v, uint8_t n) {
+  return (v - 0x01010101u * n) & ~v & 0x80808080u;
+}
+
+inline bool isSpecialChar(uint8_t c, bool ctrl) {
+  return c == HDLC_FLAG || c == HDLC_ESCAPE || (ctrl && c < HDLC_TRANS);
+}
+
+// Returns the number of leading bytes that don't need unescaping. The data is scanned a word at a time
+size_t plainRunLength(const uint8_t* data, size_t size, bool ctrl) {
+  size_t n = 0;
+  for (; n + sizeof(uint32_t) <= size; n += sizeof(uint32_t)) {
+    uint32_t w;
+    memcpy(&w, data + n, sizeof(w));
+    if (hasZeroByte(w ^ 0x7e7e7e7eu) || hasZeroByte(w ^ 0x7d7d7d7du) || (ctrl && hasByteLessThan(w, HDLC_TRANS))) {
+      break;
+    }
+  }
+  while (n < size && !isSpecialChar(data[n], ctrl)) {
+    ++n;
+  }
+  return n;
+}
+
+} // unnamed
+
+#endif // PPP_CLIENT_FAST_RX
+
 std::once_flag Client::once_;
 netif_ext_callback_t Client::netifCb_ = {};
 int Client::netifClientDataIdx_ = -1;
@@ -45,6 +194,9 @@ constexpr const char* Client::stateNames_[];
 
 Client::Client() {
   std::call_once(once_, []() {
+#if LWIP_SUPPORT_CUSTOM_PBUF && !PPP_INPROC_IRQ_SAFE && !PPP_CLIENT_FAST_RX
+    LWIP_MEMPOOL_INIT(PPP_CLIENT_RX);
+#endif // LWIP_SUPPORT_CUSTOM_PBUF && !PPP_INPROC_IRQ_SAFE && !PPP_CLIENT_FAST_RX
     LOCK_TCPIP_CORE();
     netifClientDataIdx_ = netif_alloc_client_data_id();
     SPARK_ASSERT(netifClientDataIdx_ > 0);
@@ -56,6 +208,7 @@ Client::Client() {
 
   exit_ = false;
   running_ = false;
+  fastNegotiation_ = false;
 }
 
 Client::~Client() {
@@ -110,11 +263,25 @@ void Client::deinit() {
       pppapi_free(pcb_);
       pcb_ = nullptr;
     }
+#if PPP_CLIENT_FAST_RX
+    if (rxFrame_) {
+      pbuf_free(rxFrame_);
+      rxFrame_ = nullptr;
+    }
+#endif // PPP_CLIENT_FAST_RX
     inited_ = false;
   }
 }
 
 bool Client::prepareConnect() {
+  const bool fast = fastNegotiation_;
+  LOCK_TCPIP_CORE();
+  // Both LCP and IPCP state machines use these
+  pcb_->settings.fsm_timeout_time = fast ? PPP_CLIENT_FAST_FSM_TIMEOUT : FSM_DEFTIMEOUT;
+  pcb_->settings.fsm_max_conf_req_transmits = fast ? PPP_CLIENT_FAST_FSM_MAX_CONF_REQS : FSM_DEFMAXCONFREQS;
+  ipcp_->setPreseedOptions(fast);
+  UNLOCK_TCPIP_CORE();
+
   ipcp_->init();
   ipcp_->disable();
   ipcp_->enable();
@@ -175,11 +342,28 @@ int Client::input(const uint8_t* data, size_t size) {
       case STATE_DISCONNECTING:
       case STATE_CONNECTED: {
         LOG(TRACE, "RX: %lu", size);
+#if PPP_CLIENT_FAST_RX
+        return inputFrames(data, size);
+#else
+#if LWIP_SUPPORT_CUSTOM_PBUF && !PPP_INPROC_IRQ_SAFE && !PPP_CLIENT_FAST_RX
+        auto p = allocRxPbufs(data, size);
+        if (p) {
+          // A single message is posted to the TCP/IP thread, however many pbufs the data takes
+          const err_t err = tcpip_inpkt(p, ppp_netif(pcb_), pppos_input_sys);
+          if (err) {
+            pbuf_free(p);
+            return SYSTEM_ERROR_INTERNAL;
+          }
+          return 0;
+        }
+        // The dedicated pool is exhausted, fall back to PBUF_POOL
+#endif // LWIP_SUPPORT_CUSTOM_PBUF && !PPP_INPROC_IRQ_SAFE && !PPP_CLIENT_FAST_RX
         err_t err = pppos_input_tcpip(pcb_, (u8_t*)data, size);
         if (err) {
           return SYSTEM_ERROR_INTERNAL;
         }
         return 0;
+#endif // PPP_CLIENT_FAST_RX
       }
     }
   }
@@ -217,6 +401,10 @@ void Client::setAuth(const char* user, const char* password) {
   }
 }
 
+void Client::setFastNegotiation(bool enable) {
+  fastNegotiation_ = enable;
+}
+
 netif* Client::getIf() {
   return &if_;
 }
@@ -352,6 +540,127 @@ void Client::loop() {
   running_ = false;
 }
 
+#if PPP_CLIENT_FAST_RX
+
+int Client::inputFrames(const uint8_t* data, size_t size) {
+  // Control characters that should be discarded, as negotiated with the peer
+  const auto pppos = (pppos_pcb*)pcb_->link_ctx_cb;
+  uint8_t accm[4] = {};
+  memcpy(accm, pppos->in_accm, sizeof(accm));
+  const bool ctrl = accm[0] || accm[1] || accm[2] || accm[3];
+  const auto end = data + size;
+  while (data < end) {
+    if (!rxEscaped_) {
+      const size_t n = plainRunLength(data, end - data, ctrl);
+      if (n > 0) {
+        appendRx(data, n);
+        data += n;
+        continue;
+      }
+    }
+    uint8_t c = *data++;
+    if (c == HDLC_FLAG) {
+      endRxFrame();
+    } else if (c == HDLC_ESCAPE) {
+      rxEscaped_ = true;
+    } else if (!(ctrl && c < HDLC_TRANS && (accm[c >> 3] & (1 << (c & 0x07))))) {
+      if (rxEscaped_) {
+        c ^= HDLC_TRANS;
+        rxEscaped_ = false;
+      }
+      appendRx(&c, 1);
+    }
+  }
+  return 0;
+}
+
+void Client::appendRx(const uint8_t* data, size_t size) {
+  if (rxDiscard_) {
+    return;
+  }
+  if (!rxFrame_) {
+    rxFrame_ = pbuf_alloc(PBUF_LINK, RX_FRAME_CAPACITY, PBUF_POOL);
+    if (!rxFrame_) {
+      LOG_DEBUG(WARN, "Failed to allocate RX frame");
+      rxDiscard_ = true;
+      return;
+    }
+    rxPos_ = rxFrame_;
+    rxOffset_ = 0;
+    rxLen_ = 0;
+    rxFcs_ = HDLC_INIT_FCS;
+  }
+  if (rxLen_ + size > RX_FRAME_CAPACITY) {
+    LOG_DEBUG(WARN, "RX frame is too long");
+    pbuf_free(rxFrame_);
+    rxFrame_ = nullptr;
+    rxDiscard_ = true;
+    return;
+  }
+  rxFcs_ = updateFcs(rxFcs_, data, size);
+  rxLen_ += size;
+  while (size > 0) {
+    if (rxOffset_ == rxPos_->len) {
+      rxPos_ = rxPos_->next;
+      rxOffset_ = 0;
+    }
+    const size_t n = std::min(size, (size_t)(rxPos_->len - rxOffset_));
+    memcpy((uint8_t*)rxPos_->payload + rxOffset_, data, n);
+    rxOffset_ += n;
+    data += n;
+    size -= n;
+  }
+}
+
+void Client::endRxFrame() {
+  auto p = rxFrame_;
+  const bool valid = p && !rxDiscard_ && !rxEscaped_ && rxLen_ >= 3 && rxFcs_ == HDLC_GOOD_FCS;
+  rxFrame_ = nullptr;
+  rxDiscard_ = false;
+  rxEscaped_ = false;
+  if (!valid) {
+    if (p) {
+      LOG_DEBUG(TRACE, "Dropping invalid RX frame");
+      pbuf_free(p);
+    }
+    return;
+  }
+  // Strip the FCS field
+  pbuf_realloc(p, rxLen_ - 2);
+  // Strip the address and control fields unless they are compressed
+  if (p->tot_len >= 2 && pbuf_get_at(p, 0) == PPP_ALLSTATIONS && pbuf_get_at(p, 1) == PPP_UI) {
+    pbuf_remove_header(p, 2);
+  }
+  if (p->tot_len < 1) {
+    pbuf_free(p);
+    return;
+  }
+  // ppp_input() expects an uncompressed protocol field
+  if (pbuf_get_at(p, 0) & 0x01) {
+    if (pbuf_add_header(p, 1)) {
+      pbuf_free(p);
+      return;
+    }
+    pbuf_put_at(p, 0, 0);
+  }
+  if (tcpip_inpkt(p, ppp_netif(pcb_), &Client::inputFrameSys) != ERR_OK) {
+    pbuf_free(p);
+  }
+}
+
+err_t Client::inputFrameSys(pbuf* p, netif* inp) {
+  const auto pcb = (ppp_pcb*)inp->state;
+  const auto pppos = (pppos_pcb*)pcb->link_ctx_cb;
+  if (!pppos->open) {
+    pbuf_free(p);
+    return ERR_OK;
+  }
+  ppp_input(pcb, p);
+  return ERR_OK;
+}
+
+#endif // PPP_CLIENT_FAST_RX
+
 uint32_t Client::outputCb(ppp_pcb* pcb, uint8_t* data, uint32_t len, void* ctx) {
   Client* self = static_cast<Client*>(ctx);
   if (self) {
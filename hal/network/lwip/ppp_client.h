@@ -33,6 +33,21 @@ extern "C" {
 #include <atomic>
 #include "stream.h"
 
+/* Decode HDLC framing of the incoming data in the client instead of passing it to lwIP's PPPoS byte by byte */
+#ifndef PPP_CLIENT_FAST_RX
+#define PPP_CLIENT_FAST_RX (!PPP_INPROC_IRQ_SAFE)
+#endif // PPP_CLIENT_FAST_RX
+
+/* Restart timer (seconds) and Configure-Request limit used by the fast negotiation profile.
+ * The overall time before giving up stays close to the lwIP defaults */
+#ifndef PPP_CLIENT_FAST_FSM_TIMEOUT
+#define PPP_CLIENT_FAST_FSM_TIMEOUT 1
+#endif // PPP_CLIENT_FAST_FSM_TIMEOUT
+
+#ifndef PPP_CLIENT_FAST_FSM_MAX_CONF_REQS
+#define PPP_CLIENT_FAST_FSM_MAX_CONF_REQS 30
+#endif // PPP_CLIENT_FAST_FSM_MAX_CONF_REQS
+
 #ifdef __cplusplus
 
 namespace particle { namespace net { namespace ppp {
@@ -88,6 +103,10 @@ public:
 
   void setAuth(const char* user, const char* password);
 
+  /* Use short restart timers and pre-seed IPCP options with the values from the previous session.
+   * Only meant for peers known to answer the first Configure-Request promptly. Applied on the next connect */
+  void setFastNegotiation(bool enable);
+
   netif* getIf();
 
 private:
@@ -138,6 +157,13 @@ private:
 
   void transition(State newState);
 
+#if PPP_CLIENT_FAST_RX
+  int inputFrames(const uint8_t* data, size_t size);
+  void appendRx(const uint8_t* data, size_t size);
+  void endRxFrame();
+  static err_t inputFrameSys(pbuf* p, netif* inp);
+#endif // PPP_CLIENT_FAST_RX
+
 private:
   netif if_ = {};
   ppp_pcb* pcb_ = nullptr;
@@ -167,6 +193,20 @@ private:
   bool inited_ = false;
   std::atomic_bool running_;
   std::atomic_bool exit_;
+  std::atomic_bool fastNegotiation_;
+
+#if PPP_CLIENT_FAST_RX
+  /* Frame being decoded */
+  pbuf* rxFrame_ = nullptr;
+  /* pbuf in rxFrame_ the next byte is written to and the offset in it */
+  pbuf* rxPos_ = nullptr;
+  uint16_t rxOffset_ = 0;
+  uint16_t rxLen_ = 0;
+  uint16_t rxFcs_ = 0;
+  bool rxEscaped_ = false;
+  /* Set if the frame being decoded is dropped */
+  bool rxDiscard_ = false;
+#endif // PPP_CLIENT_FAST_RX
 
   static std::once_flag once_;
   static netif_ext_callback_t netifCb_;
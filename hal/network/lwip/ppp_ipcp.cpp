@@ -35,9 +35,32 @@ const char detail::ipProtocolName[] = "IP";
 
 const struct protent ipcp_protent = Ipcp::generateProtent();
 
+namespace {
+
+/* The values negotiated in the previous session are also kept in retained memory, so that
+ * the first session after a warm reset can be preseeded as well */
+const uint32_t RETAINED_IPCP_MAGIC = 0x49504331;
+
+struct RetainedIpcpConfiguration {
+  uint32_t magic;
+  ip4_addr_t localAddress;
+  ip4_addr_t primaryDns;
+  ip4_addr_t secondaryDns;
+};
+
+__attribute__((section(".retained_system"))) RetainedIpcpConfiguration g_retainedIpcp;
+
+} /* anonymous */
+
 Ipcp::Ipcp(ppp_pcb* pcb)
     : IpcpBase(pcb) {
 
+  if (g_retainedIpcp.magic == RETAINED_IPCP_MAGIC) {
+    ip4_addr_copy(last_.localAddress, g_retainedIpcp.localAddress);
+    ip4_addr_copy(last_.primaryDns, g_retainedIpcp.primaryDns);
+    ip4_addr_copy(last_.secondaryDns, g_retainedIpcp.secondaryDns);
+  }
+
   /* Register supported options */
   registerOption(new ipcp::IpAddressConfigurationOption());
   registerOption(new ipcp::IpNetmaskConfigurationOption());
@@ -73,6 +96,10 @@ void Ipcp::setDnsEntryIndex(int idx) {
   dnsIndex_ = idx;
 }
 
+void Ipcp::setPreseedOptions(bool enable) {
+  preseed_ = enable;
+}
+
 void Ipcp::init() {
   LOG(TRACE, "init");
 
@@ -126,8 +153,9 @@ void Ipcp::resetConfigurationInformation() {
   LOG(TRACE, "resetting CI");
 
   const auto& conf = config_;
+  const IpcpConfiguration* last = preseed_ ? &last_ : nullptr;
 
-  forEachOption([&conf](auto opt) {
+  forEachOption([&conf, last](auto opt) {
     opt->reset();
 
     switch (opt->id) {
@@ -139,16 +167,25 @@ void Ipcp::resetConfigurationInformation() {
         auto o = static_cast<ipcp::CommonConfigurationOptionIpAddress*>(opt);
         o->setLocalAddress(conf.localAddress);
         o->setPeerAddress(conf.peerAddress);
+        if (last && ip4_addr_isany_val(conf.localAddress)) {
+          o->setLocalAddress(last->localAddress);
+        }
         break;
       }
       case ipcp::CONFIGURATION_OPTION_PRIMARY_DNS_SERVER: {
         auto o = static_cast<ipcp::CommonConfigurationOptionIpAddress*>(opt);
         o->setPeerAddress(conf.primaryDns);
+        if (last) {
+          o->setLocalAddress(last->primaryDns);
+        }
         break;
       }
       case ipcp::CONFIGURATION_OPTION_SECONDARY_DNS_SERVER: {
         auto o = static_cast<ipcp::CommonConfigurationOptionIpAddress*>(opt);
         o->setPeerAddress(conf.secondaryDns);
+        if (last) {
+          o->setLocalAddress(last->secondaryDns);
+        }
         break;
       }
       case ipcp::CONFIGURATION_OPTION_IP_NETMASK: {
@@ -356,6 +393,14 @@ void Ipcp::up() {
 
   sifup(pcb_);
 
+  ip4_addr_copy(last_.localAddress, ip);
+  ip4_addr_copy(last_.primaryDns, pdns);
+  ip4_addr_copy(last_.secondaryDns, sdns);
+  g_retainedIpcp.magic = RETAINED_IPCP_MAGIC;
+  ip4_addr_copy(g_retainedIpcp.localAddress, ip);
+  ip4_addr_copy(g_retainedIpcp.primaryDns, pdns);
+  ip4_addr_copy(g_retainedIpcp.secondaryDns, sdns);
+
   auto mask = getNegotiatedNetmask();
   netif_set_addr(pcb_->netif, &ip, &mask, &peer);
 
@@ -47,6 +47,10 @@ public:
 
   void setDnsEntryIndex(int idx);
 
+  /* Request the address and DNS servers negotiated in the previous session instead of
+   * 0.0.0.0, saving a Configure-Nak round with peers that hand out the same values again */
+  void setPreseedOptions(bool enable);
+
   void setLocalAddress(const ip4_addr_t& addr);
   void setPeerAddress(const ip4_addr_t& addr);
   void setNetmask(const ip4_addr_t& netmask);
@@ -113,6 +117,7 @@ private:
   bool admState_ = false;
   bool state_ = false;
   int dnsIndex_ = 0;
+  bool preseed_ = false;
 
   struct IpcpConfiguration {
     ip4_addr_t localAddress;
@@ -128,6 +133,8 @@ private:
   };
 
   IpcpConfiguration config_ = {};
+  /* Values negotiated in the previous session */
+  IpcpConfiguration last_ = {};
 };
 
 #if PRINTPKT_SUPPORT
@@ -23,7 +23,100 @@
 
 /* socket_hal_posix_impl.h should get included from socket_hal.h automagically */
 #include "socket_hal.h"
+#include "trace.h"
+#include "lwiplock.h"
+#include <lwip/priv/sockets_priv.h>
 #include <cstdarg>
+#include <algorithm>
+#if HAL_PLATFORM_FILESYSTEM
+#include "filesystem.h"
+#endif /* HAL_PLATFORM_FILESYSTEM */
+
+namespace {
+
+struct SocketEventHandler {
+  sock_event_callback_t callback;
+  void* context;
+};
+
+/* Indexed by socket number. Accessed with the core lock held */
+SocketEventHandler s_eventHandlers[MEMP_NUM_NETCONN] = {};
+/* Netconn callback installed by the socket layer, it's the same for all sockets */
+netconn_callback s_socketNetconnCallback = nullptr;
+
+SocketEventHandler* eventHandler(int s) {
+  const int index = s - LWIP_SOCKET_OFFSET;
+  if (index < 0 || index >= MEMP_NUM_NETCONN) {
+    return nullptr;
+  }
+  return &s_eventHandlers[index];
+}
+
+int socketEvents(const struct lwip_sock* sock) {
+  int events = 0;
+  if (sock->rcvevent > 0 || sock->lastdata.pbuf) {
+    events |= SOCK_EVENT_READABLE;
+  }
+  if (sock->sendevent) {
+    events |= SOCK_EVENT_WRITABLE;
+  }
+  if (sock->errevent) {
+    events |= SOCK_EVENT_ERROR;
+  }
+  return events;
+}
+
+void notifyEventHandler(int s, const struct lwip_sock* sock) {
+  const auto h = eventHandler(s);
+  if (h && h->callback) {
+    h->callback(s, socketEvents(sock), h->context);
+  }
+}
+
+void netconnEventCallback(struct netconn* conn, enum netconn_evt evt, u16_t len) {
+  /* Let the socket layer update the socket state first */
+  s_socketNetconnCallback(conn, evt, len);
+  const int s = conn->socket;
+  if (s < 0) {
+    return;
+  }
+  const auto sock = lwip_socket_dbg_get_socket(s);
+  if (sock && sock->conn == conn) {
+    notifyEventHandler(s, sock);
+  }
+}
+
+#if HAL_PLATFORM_FILESYSTEM
+
+/* Size of the file chunks sent by sock_sendfile(). The chunks are staged on the stack */
+const size_t SENDFILE_CHUNK_SIZE = 512;
+
+/* Returns the number of bytes read or -1 on error, with errno set accordingly */
+ssize_t readFileChunk(filesystem_t* fs, const char* path, off_t pos, void* buf, size_t size) {
+  /* The filesystem can only have one file open at a time, so the file is not kept open
+     while the socket is blocked */
+  particle::fs::FsLock lk(fs);
+  lfs_file_t file = {};
+  int r = lfs_file_open(&fs->instance, &file, path, LFS_O_RDONLY);
+  if (r < 0) {
+    errno = (r == LFS_ERR_NOENT) ? ENOENT : EIO;
+    return -1;
+  }
+  r = lfs_file_seek(&fs->instance, &file, pos, LFS_SEEK_SET);
+  if (r >= 0) {
+    r = lfs_file_read(&fs->instance, &file, buf, size);
+  }
+  lfs_file_close(&fs->instance, &file);
+  if (r < 0) {
+    errno = EIO;
+    return -1;
+  }
+  return r;
+}
+
+#endif /* HAL_PLATFORM_FILESYSTEM */
+
+} // anonymous
 
 int sock_accept(int s, struct sockaddr* addr, socklen_t* addrlen) {
   return lwip_accept(s, addr, addrlen);
@@ -54,6 +147,14 @@ int sock_setsockopt(int s, int level, int optname, const void* optval, socklen_t
 }
 
 int sock_close(int s) {
+  {
+    particle::net::LwipTcpIpCoreLock lk;
+    const auto h = eventHandler(s);
+    if (h) {
+      h->callback = nullptr;
+      h->context = nullptr;
+    }
+  }
   return lwip_close(s);
 }
 
@@ -66,21 +167,33 @@ int sock_listen(int s, int backlog) {
 }
 
 ssize_t sock_recv(int s, void* mem, size_t len, int flags) {
-  return lwip_recv(s, mem, len, flags);
+  PARTICLE_TRACE(TRACE_EVENT_SOCK_RECV_BEGIN, len);
+  const ssize_t ret = lwip_recv(s, mem, len, flags);
+  PARTICLE_TRACE(TRACE_EVENT_SOCK_RECV_END, ret);
+  return ret;
 }
 
 ssize_t sock_recvfrom(int s, void* mem, size_t len, int flags,
                       struct sockaddr* from, socklen_t* fromlen) {
-  return lwip_recvfrom(s, mem, len, flags, from, fromlen);
+  PARTICLE_TRACE(TRACE_EVENT_SOCK_RECV_BEGIN, len);
+  const ssize_t ret = lwip_recvfrom(s, mem, len, flags, from, fromlen);
+  PARTICLE_TRACE(TRACE_EVENT_SOCK_RECV_END, ret);
+  return ret;
 }
 
 ssize_t sock_send(int s, const void* dataptr, size_t size, int flags) {
-  return lwip_send(s, dataptr, size, flags);
+  PARTICLE_TRACE(TRACE_EVENT_SOCK_SEND_BEGIN, size);
+  const ssize_t ret = lwip_send(s, dataptr, size, flags);
+  PARTICLE_TRACE(TRACE_EVENT_SOCK_SEND_END, ret);
+  return ret;
 }
 
 ssize_t sock_sendto(int s, const void* dataptr, size_t size, int flags,
                     const struct sockaddr* to, socklen_t tolen) {
-  return lwip_sendto(s, dataptr, size, flags, to, tolen);
+  PARTICLE_TRACE(TRACE_EVENT_SOCK_SEND_BEGIN, size);
+  const ssize_t ret = lwip_sendto(s, dataptr, size, flags, to, tolen);
+  PARTICLE_TRACE(TRACE_EVENT_SOCK_SEND_END, ret);
+  return ret;
 }
 
 int sock_socket(int domain, int type, int protocol) {
@@ -111,3 +224,127 @@ ssize_t sock_recvmsg(int s, struct msghdr *message, int flags) {
 ssize_t sock_sendmsg(int s, const struct msghdr *message, int flags) {
   return lwip_sendmsg(s, message, flags);
 }
+
+int sock_recvmmsg(int s, struct mmsghdr* msgvec, unsigned int vlen, int flags) {
+  if (!vlen) {
+    return 0;
+  }
+  const ssize_t ret = lwip_recvmsg(s, &msgvec[0].msg_hdr, flags);
+  if (ret < 0) {
+    return -1;
+  }
+  msgvec[0].msg_len = ret;
+  /* Receive the rest of the batch without releasing the core lock in between */
+  particle::net::LwipTcpIpCoreLock lk;
+  unsigned int i = 1;
+  for (; i < vlen; ++i) {
+    const ssize_t r = lwip_recvmsg(s, &msgvec[i].msg_hdr, flags | MSG_DONTWAIT);
+    if (r < 0) {
+      break;
+    }
+    msgvec[i].msg_len = r;
+  }
+  return i;
+}
+
+int sock_sendmmsg(int s, struct mmsghdr* msgvec, unsigned int vlen, int flags) {
+  if (!vlen) {
+    return 0;
+  }
+  const ssize_t ret = lwip_sendmsg(s, &msgvec[0].msg_hdr, flags);
+  if (ret < 0) {
+    return -1;
+  }
+  msgvec[0].msg_len = ret;
+  /* Send the rest of the batch without releasing the core lock in between */
+  particle::net::LwipTcpIpCoreLock lk;
+  unsigned int i = 1;
+  for (; i < vlen; ++i) {
+    const ssize_t r = lwip_sendmsg(s, &msgvec[i].msg_hdr, flags | MSG_DONTWAIT);
+    if (r < 0) {
+      break;
+    }
+    msgvec[i].msg_len = r;
+  }
+  return i;
+}
+
+int sock_set_event_callback(int s, sock_event_callback_t callback, void* context, void* reserved) {
+  particle::net::LwipTcpIpCoreLock lk;
+  const auto sock = lwip_socket_dbg_get_socket(s);
+  const auto h = eventHandler(s);
+  if (!sock || !sock->conn || !h) {
+    errno = EBADF;
+    return -1;
+  }
+  if (sock->conn->callback != netconnEventCallback) {
+    if (!sock->conn->callback) {
+      errno = EINVAL;
+      return -1;
+    }
+    if (!s_socketNetconnCallback) {
+      s_socketNetconnCallback = sock->conn->callback;
+    }
+    sock->conn->callback = netconnEventCallback;
+  }
+  h->callback = callback;
+  h->context = context;
+  if (callback && socketEvents(sock)) {
+    notifyEventHandler(s, sock);
+  }
+  return 0;
+}
+
+ssize_t sock_sendfile(int s, const char* path, off_t* offset, size_t count, int flags) {
+#if HAL_PLATFORM_FILESYSTEM
+  const auto fs = filesystem_get_instance(nullptr);
+  off_t pos = offset ? *offset : 0;
+  if (!fs || !path || pos < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  {
+    particle::fs::FsLock lk(fs);
+    if (filesystem_mount(fs) != 0) {
+      errno = EIO;
+      return -1;
+    }
+  }
+  char buf[SENDFILE_CHUNK_SIZE];
+  size_t total = 0;
+  int error = 0;
+  while (total < count) {
+    const ssize_t n = readFileChunk(fs, path, pos, buf, std::min(sizeof(buf), count - total));
+    if (n <= 0) {
+      if (n < 0) {
+        error = errno;
+      }
+      break;
+    }
+    /* Let the stack coalesce the chunks into full segments */
+    const bool more = (size_t)n == sizeof(buf) && total + n < count;
+    const ssize_t r = lwip_send(s, buf, n, more ? (flags | MSG_MORE) : flags);
+    if (r < 0) {
+      error = errno;
+      break;
+    }
+    total += r;
+    pos += r;
+    if (r < n) {
+      /* Timed out or would block */
+      break;
+    }
+  }
+  if (offset) {
+    *offset = pos;
+  }
+  if (!total && error) {
+    errno = error;
+    return -1;
+  }
+  return total;
+#else
+  errno = ENOSYS;
+  return -1;
+#endif /* HAL_PLATFORM_FILESYSTEM */
+}
@@ -56,6 +56,12 @@ struct sockaddr_ll {
     u8_t sll_addr[8];
 };
 
+/* Message descriptor for sock_sendmmsg() and sock_recvmmsg() */
+struct mmsghdr {
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+};
+
 /**
  * @}
  *
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <lwip/opt.h>
+#include <lwip/tcp.h>
+#include <lwip/ip.h>
+#include <lwip/netif.h>
+#include "lwiphooks.h"
+
+#if LWIP_TCP && defined(LWIP_HOOK_TCP_INPACKET_PCB) && defined(TCP_WND_LOW_BW) && LWIP_TCP_PCB_NUM_EXT_ARGS > 0
+
+static_assert(TCP_WND_LOW_BW <= TCP_WND, "TCP_WND_LOW_BW should not exceed TCP_WND");
+static_assert(TCP_SND_BUF_LOW_BW <= TCP_SND_BUF, "TCP_SND_BUF_LOW_BW should not exceed TCP_SND_BUF");
+
+namespace {
+
+const uint8_t INVALID_EXT_ARG_ID = 0xff;
+
+uint8_t g_extArgId = INVALID_EXT_ARG_ID;
+
+bool isLowBandwidthNetif(const struct netif* netif) {
+    // Cellular (PPP) and mesh (Thread) interfaces
+    return (netif->name[0] == 'p' && netif->name[1] == 'p') ||
+            (netif->name[0] == 't' && netif->name[1] == 'h');
+}
+
+} // anonymous
+
+extern "C" err_t lwip_hook_tcp_inpacket_pcb(struct tcp_pcb* pcb, struct tcp_hdr* hdr, u16_t optlen, u16_t opt1len,
+        u8_t* opt2, struct pbuf* p) {
+    // The SYN segments have to advertise the full TCP_WND (see tcp_parseopt()), so the limits
+    // are applied once the connection is established
+    if (pcb->state != ESTABLISHED) {
+        return ERR_OK;
+    }
+    if (g_extArgId == INVALID_EXT_ARG_ID) {
+        g_extArgId = tcp_ext_arg_alloc_id();
+    }
+    if (tcp_ext_arg_get(pcb, g_extArgId)) {
+        // Already handled
+        return ERR_OK;
+    }
+    tcp_ext_arg_set(pcb, g_extArgId, pcb);
+    const auto netif = ip_current_input_netif();
+    if (!netif || !isLowBandwidthNetif(netif)) {
+        return ERR_OK;
+    }
+    // lwIP keeps rcv_wnd plus the data not yet read by the application at TCP_WND, and snd_buf
+    // plus the unacknowledged data at TCP_SND_BUF, so taking the difference away once limits
+    // the connection for its entire lifetime
+    pcb->rcv_wnd -= LWIP_MIN(pcb->rcv_wnd, (tcpwnd_size_t)(TCP_WND - TCP_WND_LOW_BW));
+    pcb->snd_buf -= LWIP_MIN(pcb->snd_buf, (tcpwnd_size_t)(TCP_SND_BUF - TCP_SND_BUF_LOW_BW));
+    return ERR_OK;
+}
+
+#endif // LWIP_TCP && defined(LWIP_HOOK_TCP_INPACKET_PCB) && defined(TCP_WND_LOW_BW) && LWIP_TCP_PCB_NUM_EXT_ARGS > 0
@@ -192,14 +192,10 @@ WizNetif::WizNetif(HAL_SPI_Interface spi, pin_t cs, pin_t reset, pin_t interrupt
 
     reg_wizchip_cris_cbfunc(
         [](void) -> void {
-            auto self = instance();
-            HAL_SPI_Acquire(self->spi_, nullptr);
-            self->spi_info_cache_ = spiConfigure(self->spi_, &WIZNET_DEFAULT_CONFIG);
+            instance()->spiEnter();
         },
         [](void) -> void {
-            auto self = instance();
-            spiConfigure(self->spi_, &self->spi_info_cache_);
-            HAL_SPI_Release(self->spi_, nullptr);
+            instance()->spiExit();
         }
     );
     reg_wizchip_cs_cbfunc(
@@ -224,34 +220,10 @@ WizNetif::WizNetif(HAL_SPI_Interface spi, pin_t cs, pin_t reset, pin_t interrupt
     );
     reg_wizchip_spiburst_cbfunc(
         [](uint8_t* pBuf, uint16_t len) -> void {
-            auto self = instance();
-            size_t r = 0;
-            while (r < len) {
-                /* FIXME: maximum DMA transfer size should be correctly handled by HAL */
-                size_t t = std::min((len - r), (size_t)65535);
-                HAL_SPI_DMA_Transfer(self->spi_, nullptr, pBuf + r, t, [](void) -> void {
-                    auto self = instance();
-                    os_semaphore_give(self->spiSem_, true);
-                });
-                auto self = instance();
-                os_semaphore_take(self->spiSem_, WIZNET_DEFAULT_TIMEOUT, true);
-                r += t;
-            }
+            instance()->spiTransfer(nullptr, pBuf, len);
         },
         [](uint8_t* pBuf, uint16_t len) -> void {
-            auto self = instance();
-            size_t r = 0;
-            while (r < len) {
-                /* FIXME: maximum DMA transfer size should be correctly handled by HAL */
-                size_t t = std::min((len - r), (size_t)65535);
-                HAL_SPI_DMA_Transfer(self->spi_, pBuf + r, nullptr, t, [](void) -> void {
-                    auto self = instance();
-                    os_semaphore_give(self->spiSem_, true);
-                });
-                auto self = instance();
-                os_semaphore_take(self->spiSem_, WIZNET_DEFAULT_TIMEOUT, true);
-                r += t;
-            }
+            instance()->spiTransfer(pBuf, nullptr, len);
         }
     );
 
@@ -260,6 +232,7 @@ WizNetif::WizNetif(HAL_SPI_Interface spi, pin_t cs, pin_t reset, pin_t interrupt
 
     exit_ = false;
     down_ = true;
+    stateReq_ = StateRequest::NONE;
     if (!netifapi_netif_add(interface(), nullptr, nullptr, nullptr, this, initCb, ethernet_input)) {
         SPARK_ASSERT(os_queue_create(&queue_, sizeof(void*), 256, nullptr) == 0);
         registerHandlers();
@@ -344,6 +317,84 @@ bool WizNetif::isPresent() {
     return true;
 }
 
+void WizNetif::spiEnter() {
+    HAL_SPI_Acquire(spi_, nullptr);
+    spi_info_cache_ = spiConfigure(spi_, &WIZNET_DEFAULT_CONFIG);
+}
+
+void WizNetif::spiExit() {
+    spiConfigure(spi_, &spi_info_cache_);
+    HAL_SPI_Release(spi_, nullptr);
+}
+
+void WizNetif::spiTransfer(const uint8_t* tx, uint8_t* rx, size_t len) {
+    size_t r = 0;
+    while (r < len) {
+        /* FIXME: maximum DMA transfer size should be correctly handled by HAL */
+        size_t t = std::min((len - r), (size_t)65535);
+        HAL_SPI_DMA_Transfer(spi_, tx ? (void*)(tx + r) : nullptr, rx ? rx + r : nullptr, t, [](void) -> void {
+            auto self = instance();
+            os_semaphore_give(self->spiSem_, true);
+        });
+        os_semaphore_take(spiSem_, WIZNET_DEFAULT_TIMEOUT, true);
+        r += t;
+    }
+}
+
+void WizNetif::beginBufferAccess(uint16_t ptr, uint8_t block, bool write) {
+    /* Variable length data mode: 16-bit offset followed by the control phase */
+    const uint32_t addr = ((uint32_t)ptr << 8) + (block << 3) + (write ? _W5500_SPI_WRITE_ : _W5500_SPI_READ_) +
+            _W5500_SPI_VDM_OP_;
+    spiEnter();
+    HAL_GPIO_Write(cs_, 0);
+    HAL_SPI_Send_Receive_Data(spi_, (addr >> 16) & 0xff);
+    HAL_SPI_Send_Receive_Data(spi_, (addr >> 8) & 0xff);
+    HAL_SPI_Send_Receive_Data(spi_, addr & 0xff);
+}
+
+void WizNetif::endBufferAccess() {
+    HAL_GPIO_Write(cs_, 1);
+    spiExit();
+}
+
+pbuf* WizNetif::readFrame(uint16_t ptr, uint16_t* frameSize) {
+    /* The frame is read in a single transaction: the 2-byte length header and the frame data
+     * are transferred directly into the pbuf chain. The socket buffer offset wraps around
+     * in the chip */
+    pbuf* p = nullptr;
+    beginBufferAccess(ptr, WIZCHIP_RXBUF_BLOCK(0), false /* write */);
+    uint8_t hdr[2] = {};
+    spiTransfer(nullptr, hdr, sizeof(hdr));
+    const uint16_t size = (hdr[0] << 8 | hdr[1]) - 2;
+    if (size < 1514) {
+        p = pbuf_alloc(PBUF_RAW, size + ETH_PAD_SIZE, PBUF_POOL);
+        if (p) {
+#if ETH_PAD_SIZE
+            /* drop the padding word */
+            pbuf_remove_header(p, ETH_PAD_SIZE);
+#endif /* ETH_PAD_SIZE */
+            for (pbuf* q = p; q != nullptr; q = q->next) {
+                spiTransfer(nullptr, (uint8_t*)q->payload, q->len);
+            }
+#if ETH_PAD_SIZE
+            /* reclaim the padding word */
+            pbuf_add_header(p, ETH_PAD_SIZE);
+#endif /* ETH_PAD_SIZE */
+        }
+    }
+    endBufferAccess();
+    *frameSize = size;
+    return p;
+}
+
+void WizNetif::writeFrame(uint16_t ptr, pbuf* p) {
+    beginBufferAccess(ptr, WIZCHIP_TXBUF_BLOCK(0), true /* write */);
+    for (pbuf* q = p; q != nullptr; q = q->next) {
+        spiTransfer((const uint8_t*)q->payload, nullptr, q->len);
+    }
+    endBufferAccess();
+}
+
 void WizNetif::interruptCb(void* arg) {
     WizNetif* self = static_cast<WizNetif*>(arg);
     if (self && !self->inRecv_) {
@@ -360,6 +411,12 @@ void WizNetif::loop(void* arg) {
         pbuf* p = nullptr;
         os_queue_take(self->queue_, (void*)&p, timeout, nullptr);
         timeout = WIZNET_DEFAULT_TIMEOUT;
+        const auto req = self->stateReq_.exchange(StateRequest::NONE);
+        if (req == StateRequest::UP) {
+            self->up();
+        } else if (req == StateRequest::DOWN) {
+            self->down();
+        }
         if (p) {
             self->output(p);
         }
@@ -377,6 +434,15 @@ void WizNetif::loop(void* arg) {
     os_thread_exit(nullptr);
 }
 
+void WizNetif::requestState(StateRequest req) {
+    /* Initializing the chip takes a while, do it in the interface thread so that the other
+     * interfaces can be brought up at the same time */
+    stateReq_ = req;
+    /* The request is also picked up when the thread wakes up on a timeout */
+    const void* dummy = nullptr;
+    os_queue_put(queue_, &dummy, 0, nullptr);
+}
+
 int WizNetif::up() {
     LwipTcpIpCoreLock lk;
 
@@ -452,6 +518,7 @@ int WizNetif::closeRaw() {
     WAIT_TIMED(WIZNET_DEFAULT_TIMEOUT, getSn_CR(0));
     /* Clear interrupts */
     setSn_IR(0, 0xff);
+    txPending_ = false;
     /* Disable all interrupts */
     setSIMR(0x00);
     /* Waiting for it to get closed */
@@ -501,14 +568,9 @@ int WizNetif::input() {
     int r = 0;
 
     while ((size = getSn_RX_RSR(0)) > 0 && size != 0xffff && count < WIZNET_DEFAULT_RX_FRAMES_PER_ITERATION) {
+        const uint16_t ptr = getSn_RX_RD(0);
         uint16_t pktSize = 0;
-        {
-            uint8_t tmp[2] = {};
-            wiz_recv_data(0, tmp, sizeof(tmp));
-            setSn_CR(0, Sn_CR_RECV);
-            WAIT_TIMED(WIZNET_DEFAULT_TIMEOUT, getSn_CR(0));
-            pktSize = (tmp[0] << 8 | tmp[1]) - 2;
-        }
+        pbuf* p = readFrame(ptr, &pktSize);
 
         // LOG_DEBUG(TRACE, "Received packet, %d bytes", pktSize);
 
@@ -518,27 +580,12 @@ int WizNetif::input() {
             return r;
         }
 
-#if ETH_PAD_SIZE
-        /* allow room for Ethernet padding */
-        pktSize += ETH_PAD_SIZE;
-#endif /* ETH_PAD_SIZE */
+        /* Release the frame in the socket buffer, whether it has been read or dropped */
+        setSn_RX_RD(0, ptr + 2 + pktSize);
+        setSn_CR(0, Sn_CR_RECV);
+        WAIT_TIMED(WIZNET_DEFAULT_TIMEOUT, getSn_CR(0));
 
-        pbuf* p = pbuf_alloc(PBUF_RAW, pktSize, PBUF_POOL);
         if (p != nullptr) {
-#if ETH_PAD_SIZE
-            /* drop the padding word */
-            pbuf_remove_header(p, ETH_PAD_SIZE);
-#endif /* ETH_PAD_SIZE */
-            for (pbuf* q = p; q != nullptr; q = q->next) {
-                wiz_recv_data(0, (uint8_t*)q->payload, q->len);
-                setSn_CR(0, Sn_CR_RECV);
-                WAIT_TIMED(WIZNET_DEFAULT_TIMEOUT, getSn_CR(0));
-            }
-#if ETH_PAD_SIZE
-            /* reclaim the padding word */
-            pbuf_add_header(p, ETH_PAD_SIZE);
-#endif /* ETH_PAD_SIZE */
-
             LwipTcpIpCoreLock lk;
             if (netif_.input(p, &netif_) != ERR_OK) {
                 LOG(ERROR, "Error inputing packet");
@@ -546,14 +593,6 @@ int WizNetif::input() {
             }
         } else {
             LOG(ERROR, "Failed to allocate pbuf");
-#if ETH_PAD_SIZE
-            pktSize -= ETH_PAD_SIZE;
-#endif /* ETH_PAD_SIZE */
-            /* Dropping packet */
-            wiz_recv_ignore(0, pktSize);
-            setSn_CR(0, Sn_CR_RECV);
-            WAIT_TIMED(WIZNET_DEFAULT_TIMEOUT, getSn_CR(0));
-
             /* Giving a chance to free up some pbufs */
             r = 1;
             break;
@@ -597,6 +636,14 @@ void WizNetif::output(pbuf* p) {
     pbuf_remove_header(p, ETH_PAD_SIZE); /* drop the padding word */
 #endif
 
+    /* The previous frame is sent while this one is being written to the TX buffer, but a new
+     * SEND command can only be issued once it has completed */
+    if (txPending_) {
+        WAIT_TIMED(WIZNET_DEFAULT_TIMEOUT, ((getSn_IR(0) & (Sn_IR_SENDOK | Sn_IR_TIMEOUT)) == 0));
+        setSn_IR(0, (Sn_IR_SENDOK | Sn_IR_TIMEOUT));
+        txPending_ = false;
+    }
+
     WAIT_TIMED(WIZNET_DEFAULT_TIMEOUT, (((txAvailable = getSn_TX_FSR(0)) < p->tot_len) && txAvailable != 0xffff));
 
     if (p->tot_len > txAvailable || txAvailable == 0xffff) {
@@ -630,19 +677,15 @@ void WizNetif::output(pbuf* p) {
 
     ptr = getSn_TX_WR(0);
 
-    for (pbuf* q = p; q != nullptr; q = q->next) {
-        uint32_t addr = ((uint32_t)ptr << 8) + (WIZCHIP_TXBUF_BLOCK(0) << 3);
-        WIZCHIP_WRITE_BUF(addr, (uint8_t*)q->payload, q->len);
-        ptr += q->len;
-    }
+    /* The whole pbuf chain is written in a single transaction */
+    writeFrame(ptr, p);
 
-    setSn_TX_WR(0, ptr);
+    setSn_TX_WR(0, ptr + p->tot_len);
 
     setSn_CR(0, Sn_CR_SEND);
     /* After W5500 accepts the command, the Sn_CR register is automatically cleared to 0x00. */
     WAIT_TIMED(WIZNET_DEFAULT_TIMEOUT, getSn_CR(0));
-    WAIT_TIMED(WIZNET_DEFAULT_TIMEOUT, ((getSn_IR(0) & (Sn_IR_SENDOK | Sn_IR_TIMEOUT)) == 0));
-    setSn_IR(0, (Sn_IR_SENDOK | Sn_IR_TIMEOUT));
+    txPending_ = true;
 
 #if ETH_PAD_SIZE
     pbuf_add_header(p, ETH_PAD_SIZE); /* reclaim the padding word */
@@ -661,9 +704,9 @@ err_t WizNetif::linkOutputCb(netif* netif, pbuf* p) {
 void WizNetif::ifEventHandler(const if_event* ev) {
     if (ev->ev_type == IF_EVENT_STATE) {
         if (ev->ev_if_state->state) {
-            up();
+            requestState(StateRequest::UP);
         } else {
-            down();
+            requestState(StateRequest::DOWN);
         }
     }
 }
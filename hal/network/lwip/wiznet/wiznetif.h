@@ -59,12 +59,21 @@ private:
     static void interruptCb(void* arg);
     static void loop(void* arg);
 
+    void requestState(StateRequest req);
     int up();
     int down();
 
     int openRaw();
     int closeRaw();
 
+    void spiEnter();
+    void spiExit();
+    void spiTransfer(const uint8_t* tx, uint8_t* rx, size_t len);
+    void beginBufferAccess(uint16_t ptr, uint8_t block, bool write);
+    void endBufferAccess();
+    pbuf* readFrame(uint16_t ptr, uint16_t* frameSize);
+    void writeFrame(uint16_t ptr, pbuf* p);
+
     void pollState();
     int input();
     void output(pbuf* p);
@@ -82,11 +91,19 @@ private:
     os_queue_t queue_ = nullptr;
     os_semaphore_t spiSem_ = nullptr;
 
+    enum class StateRequest {
+        NONE,
+        UP,
+        DOWN
+    };
+
     std::atomic_bool exit_;
     std::atomic_bool inRecv_;
     std::atomic_bool down_;
+    std::atomic<StateRequest> stateReq_;
 
     system_tick_t lastStatePoll_ = 0;
+    bool txPending_ = false;
 
     /* FIXME: Wiznet callbacks do not have any kind of state arguments :( */
     static WizNetif* instance_;
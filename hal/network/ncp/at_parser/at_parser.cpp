@@ -22,12 +22,20 @@
 
 #include "check.h"
 
+#include <cstring>
 #include <cstdarg>
 
 namespace particle {
 
 using detail::AtParserImpl;
 
+namespace {
+
+// Maximum length of a line of the information response to a command of a batch
+const size_t BATCH_RESP_LINE_SIZE = 128;
+
+} // unnamed
+
 AtParser::AtParser() {
 }
 
@@ -99,6 +107,52 @@ int AtParser::execCommand(unsigned timeout, const char* fmt, ...) {
     return cmd.exec();
 }
 
+int AtParser::execBatch(const BatchCommand* cmds, size_t count, unsigned timeout) {
+    CHECK_TRUE(cmds && count > 0, SYSTEM_ERROR_INVALID_ARGUMENT);
+    AtCommand cmd = command();
+    if (timeout > 0) {
+        cmd.timeout(timeout);
+    }
+    cmd.print("AT");
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) {
+            cmd.print(";");
+        }
+        cmd.print(cmds[i].command);
+    }
+    auto resp = cmd.send();
+    // Index of the first command that is not yet known to be completed
+    size_t next = 0;
+    char line[BATCH_RESP_LINE_SIZE];
+    while (next < count && resp.hasNextLine()) {
+        const int n = resp.readLine(line, sizeof(line));
+        if (n < 0) {
+            return n;
+        }
+        size_t i = next;
+        for (; i < count; ++i) {
+            const char* const prefix = cmds[i].prefix;
+            if (prefix && strncmp(line, prefix, strlen(prefix)) == 0) {
+                next = i;
+                break;
+            }
+        }
+        if (i == count) {
+            // The line doesn't have a known prefix
+            for (i = next; i < count; ++i) {
+                if (!cmds[i].prefix && cmds[i].handler) {
+                    next = i + 1;
+                    break;
+                }
+            }
+        }
+        if (i < count && cmds[i].handler) {
+            CHECK(cmds[i].handler(line, cmds[i].data));
+        }
+    }
+    return resp.readResult();
+}
+
 int AtParser::addUrcHandler(const char* prefix, UrcHandler handler, void* data) {
     CHECK_TRUE(p_, SYSTEM_ERROR_INVALID_STATE);
     return p_->addUrcHandler(prefix, handler, data);
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <memory>
+#include <cstddef>
 
 namespace particle {
 
@@ -203,6 +204,30 @@ public:
      * @see `addUrcHandler()`
      */
     typedef int(*UrcHandler)(AtResponseReader* reader, const char* prefix, void* data);
+    /**
+     * The signature of a function invoked by the parser to process a line of the information
+     * response to a command of a batch.
+     *
+     * @param line Response line.
+     * @param data User data.
+     *
+     * @return `0` on success, or a negative result code in case of an error.
+     *
+     * @see `execBatch()`
+     */
+    typedef int(*ResponseHandler)(const char* line, void* data);
+
+    /**
+     * A command of a batch.
+     *
+     * @see `execBatch()`
+     */
+    struct BatchCommand {
+        const char* command; ///< Command string without the "AT" prefix, e.g. "+CCID".
+        const char* prefix; ///< Prefix of the information response, e.g. "+CCID:", or `nullptr`.
+        ResponseHandler handler; ///< Response handler, or `nullptr`.
+        void* data; ///< User data.
+    };
 
     /**
      * Constructs a parser object.
@@ -316,6 +341,35 @@ public:
      * @see `AtParserConfig::commandTimeout()`
      */
     int execCommand(unsigned timeout, const char* fmt, ...);
+    /**
+     * Sends a batch of AT commands in a single command line and waits for a final result code.
+     *
+     * The commands are concatenated as described in ITU-T V.250, e.g. "AT+CPIN?;+CCID", so that
+     * the DCE processes all of them without waiting for the DTE between the commands. The lines
+     * of the information response are passed to the handlers of the commands in order:
+     *
+     * - A line starting with the prefix of one of the remaining commands is passed to the handler
+     *   of that command. All commands preceding it in the batch are considered completed.
+     * - Any other line is passed to the handler of the next remaining command that has a handler
+     *   but no prefix. Such a command consumes exactly one line.
+     *
+     * Lines that are processed by the registered URC handlers are not passed to the command
+     * handlers. Lines that don't match any of the remaining commands are ignored.
+     *
+     * The DCE stops processing the command line at the first failed command, and the final result
+     * code of that command is the result of the whole batch.
+     *
+     * @param cmds Commands.
+     * @param count Number of commands.
+     * @param timeout Timeout in milliseconds. If this argument is set to `0` the default command
+     *        timeout is used.
+     * @return One of the values defined by `AtResponse::Result`, or a negative result code in
+     *         case of an error.
+     *
+     * @see `execCommand()`
+     * @see `AtParserConfig::commandTimeout()`
+     */
+    int execBatch(const BatchCommand* cmds, size_t count, unsigned timeout = 0);
     /**
      * Registers an URC handler.
      *
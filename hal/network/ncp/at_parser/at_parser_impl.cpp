@@ -24,6 +24,7 @@
 #include "scope_guard.h"
 #include "check.h"
 #include "debug.h"
+#include "spark_wiring_diagnostics.h"
 
 #include <algorithm>
 #include <cstdlib>
@@ -106,11 +107,17 @@ inline system_tick_t millis() {
     return HAL_Timer_Get_Milli_Seconds();
 }
 
+// Time between sending a command and receiving its final result code. Parsers of different NCPs
+// can run in different threads
+AtomicHistogramDiagnosticData g_atCommandTimeDiagData(DIAG_ID_NETWORK_NCP_AT_COMMAND_TIME,
+        DIAG_NAME_NETWORK_NCP_AT_COMMAND_TIME);
+
 } // unnamed
 
 AtParserImpl::AtParserImpl(AtParserConfig conf) :
         cmdTerm_(cmdTermStr(conf.commandTerminator())),
         cmdTermSize_(strlen(cmdTerm_)),
+        urcFirstChars_(),
         conf_(std::move(conf)) {
     reset();
 }
@@ -146,6 +153,7 @@ int AtParserImpl::sendCommand() {
     clearStatus(StatusFlag::WRITE_CMD);
     setStatus(StatusFlag::FLUSH_CMD);
     cmdTermOffs_ = 0;
+    cmdTime_ = millis();
     PARSER_CHECK(flushCommand(&cmdTimeout_));
     return 0;
 }
@@ -199,6 +207,9 @@ int AtParserImpl::readResult(int* errorCode) {
             }
             PARSER_CHECK(nextLine(&cmdTimeout_));
         }
+        if (!checkStatus(StatusFlag::WRITE_CMD)) {
+            g_atCommandTimeDiagData.add(millis() - cmdTime_);
+        }
     }
     if (errorCode) {
         *errorCode = errorCode_;
@@ -288,16 +299,26 @@ int AtParserImpl::addUrcHandler(const char* prefix, AtParser::UrcHandler handler
     h.prefixSize = prefixSize;
     h.callback = handler;
     h.data = data;
-    if (!urcHandlers_.append(std::move(h))) {
+    // Keep the handlers with the same first character of the prefix next to each other
+    int i = findUrcHandlers(prefix[0]);
+    while (i < urcHandlers_.size() && urcHandlers_.at(i).prefix[0] == prefix[0]) {
+        ++i;
+    }
+    if (!urcHandlers_.insert(i, std::move(h))) {
         return SYSTEM_ERROR_NO_MEMORY;
     }
+    updateUrcFirstChars();
     return 0;
 }
 
 void AtParserImpl::removeUrcHandler(const char* prefix) {
-    for (int i = 0; i < urcHandlers_.size(); ++i) {
+    for (int i = findUrcHandlers(prefix[0]); i < urcHandlers_.size(); ++i) {
+        if (urcHandlers_.at(i).prefix[0] != prefix[0]) {
+            break;
+        }
         if (strcmp(urcHandlers_.at(i).prefix, prefix) == 0) {
             urcHandlers_.removeAt(i);
+            updateUrcFirstChars();
             break;
         }
     }
@@ -326,6 +347,7 @@ void AtParserImpl::reset() {
     bufPos_ = 0;
     cmdSize_ = 0;
     cmdTimeout_ = 0;
+    cmdTime_ = 0;
     cmdTermOffs_ = 0;
     respSize_ = 0;
     errorCode_ = 0;
@@ -492,11 +514,19 @@ int AtParserImpl::parseUrc(const UrcHandler** handler) {
     if (bufPos_ == 0) {
         return ParseResult::READ_MORE;
     }
+    // Most of the lines received during a data transfer are not URCs
+    const uint8_t c = buf_[0];
+    if (!(urcFirstChars_[c / 32] & ((uint32_t)1 << (c % 32)))) {
+        return ParseResult::NO_MATCH;
+    }
     // Look for an URC prefix that matches the buffer contents
     const UrcHandler* h = nullptr;
     size_t maxSize = 0;
-    for (size_t i = 0; i < (size_t)urcHandlers_.size(); ++i) {
+    for (int i = findUrcHandlers(c); i < urcHandlers_.size(); ++i) {
         const UrcHandler& h2 = urcHandlers_.at(i);
+        if (h2.prefix[0] != (char)c) {
+            break;
+        }
         const size_t n = std::min(bufPos_, h2.prefixSize);
         if (memcmp(buf_, h2.prefix, n) == 0 && n > maxSize) {
             h = &h2;
@@ -513,6 +543,22 @@ int AtParserImpl::parseUrc(const UrcHandler** handler) {
     return ParseResult::PARSED_URC;
 }
 
+int AtParserImpl::findUrcHandlers(char c) const {
+    // Returns the index of the first handler whose prefix starts with the given character, or
+    // the index at which such a handler would be inserted
+    int begin = 0;
+    int end = urcHandlers_.size();
+    while (begin < end) {
+        const int i = begin + (end - begin) / 2;
+        if ((uint8_t)urcHandlers_.at(i).prefix[0] < (uint8_t)c) {
+            begin = i + 1;
+        } else {
+            end = i;
+        }
+    }
+    return begin;
+}
+
 int AtParserImpl::parseEcho() {
     if (bufPos_ == 0) {
         return ParseResult::READ_MORE;
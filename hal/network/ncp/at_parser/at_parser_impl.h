@@ -127,9 +127,11 @@ private:
     int errorCode_; // Error code reported via "+CME ERROR" or "+CMS ERROR"
     size_t cmdTermOffs_; // Number of characters of the command terminator written to the stream
     unsigned cmdTimeout_; // Command timeout
+    system_tick_t cmdTime_; // Time when the command was sent
     unsigned status_; // Status flags
 
-    Vector<UrcHandler> urcHandlers_; // URC handlers
+    Vector<UrcHandler> urcHandlers_; // URC handlers sorted by the first character of the prefix
+    uint32_t urcFirstChars_[256 / 32]; // Bitmap of the first characters of the registered prefixes
     AtParserConfig conf_; // Parser settings
 
     int readRespLine(char* data, size_t size);
@@ -138,6 +140,8 @@ private:
     int parseLine(unsigned flags, unsigned* timeout);
     int parseResult();
     int parseUrc(const UrcHandler** handler);
+    int findUrcHandlers(char c) const;
+    void updateUrcFirstChars();
     int parseEcho();
 
     int readLine(char* data, size_t size, unsigned* timeout);
@@ -162,6 +166,16 @@ inline bool AtParserImpl::atLineEnd() const {
     return checkStatus(StatusFlag::LINE_END);
 }
 
+inline void AtParserImpl::updateUrcFirstChars() {
+    for (size_t i = 0; i < sizeof(urcFirstChars_) / sizeof(urcFirstChars_[0]); ++i) {
+        urcFirstChars_[i] = 0;
+    }
+    for (int i = 0; i < urcHandlers_.size(); ++i) {
+        const uint8_t c = urcHandlers_.at(i).prefix[0];
+        urcFirstChars_[c / 32] |= (uint32_t)1 << (c % 32);
+    }
+}
+
 inline void AtParserImpl::echoEnabled(bool enabled) {
     conf_.echoEnabled(enabled);
 }
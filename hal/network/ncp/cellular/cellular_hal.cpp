@@ -292,6 +292,42 @@ cellular_result_t cellular_registration_timeout_set(system_tick_t timeout, void*
     return SYSTEM_ERROR_NONE;
 }
 
+int cellular_power_saving_set(const cellular_power_saving_config* conf, void* reserved) {
+    const auto mgr = cellularNetworkManager();
+    CHECK_TRUE(mgr, SYSTEM_ERROR_UNKNOWN);
+    const auto client = mgr->ncpClient();
+    CHECK_TRUE(client, SYSTEM_ERROR_UNKNOWN);
+    cellular_power_saving_config c = {};
+    c.size = sizeof(c);
+    if (conf) {
+        CHECK_TRUE(conf->size >= sizeof(c), SYSTEM_ERROR_INVALID_ARGUMENT);
+        c = *conf;
+        c.size = sizeof(c);
+    }
+    CHECK(client->setPowerSaving(c));
+    return 0;
+}
+
+int cellular_power_saving_get(cellular_power_saving_config* conf, void* reserved) {
+    CHECK_TRUE(conf && conf->size >= sizeof(cellular_power_saving_config), SYSTEM_ERROR_INVALID_ARGUMENT);
+    const auto mgr = cellularNetworkManager();
+    CHECK_TRUE(mgr, SYSTEM_ERROR_UNKNOWN);
+    const auto client = mgr->ncpClient();
+    CHECK_TRUE(client, SYSTEM_ERROR_UNKNOWN);
+    CHECK(client->getPowerSaving(conf));
+    return 0;
+}
+
+int cellular_network_time(time_t* time, void* reserved) {
+    CHECK_TRUE(time, SYSTEM_ERROR_INVALID_ARGUMENT);
+    const auto mgr = cellularNetworkManager();
+    CHECK_TRUE(mgr, SYSTEM_ERROR_UNKNOWN);
+    const auto client = mgr->ncpClient();
+    CHECK_TRUE(client, SYSTEM_ERROR_UNKNOWN);
+    CHECK(client->getNetworkTime(time));
+    return 0;
+}
+
 bool cellular_sim_ready(void* reserved) {
     return false;
 }
@@ -20,6 +20,7 @@
 #include "ncp_client.h"
 #include "cellular_network_manager.h"
 #include "cellular_hal_cellular_global_identity.h"
+#include "cellular_hal.h"
 
 namespace particle {
 
@@ -36,6 +37,13 @@ struct CellularNcpAuthEvent: CellularNcpEvent {
 
 class CellularNcpClientConfig: public NcpClientConfig {
 public:
+    /**
+     * Default maximum age of the cached signal quality and operator information in milliseconds.
+     *
+     * @see `networkInfoMaxAge()`
+     */
+    static const unsigned DEFAULT_NETWORK_INFO_MAX_AGE = 10000;
+
     CellularNcpClientConfig();
 
     CellularNcpClientConfig& simType(SimType type);
@@ -44,9 +52,19 @@ public:
     CellularNcpClientConfig& ncpIdentifier(PlatformNCPIdentifier ident);
     PlatformNCPIdentifier ncpIdentifier() const;
 
+    /**
+     * Sets the maximum age of the cached signal quality and operator information.
+     *
+     * The cached information is also discarded when the modem reports a change of the
+     * registration state or the serving cell. Setting the age to `0` disables the caching.
+     */
+    CellularNcpClientConfig& networkInfoMaxAge(unsigned age);
+    unsigned networkInfoMaxAge() const;
+
 private:
     SimType simType_;
     PlatformNCPIdentifier ident_;
+    unsigned netInfoMaxAge_;
 };
 
 enum class UbloxSaraUmnoprof {
@@ -127,11 +145,30 @@ public:
     virtual int getImei(char* buf, size_t size) = 0;
     virtual int getSignalQuality(CellularSignalQuality* qual) = 0;
     virtual int setRegistrationTimeout(unsigned timeout) = 0;
+    virtual int setPowerSaving(const cellular_power_saving_config& conf) = 0;
+    virtual int getPowerSaving(cellular_power_saving_config* conf) = 0;
+    /**
+     * Returns the time the modem's clock has received from the network (NITZ), in UTC.
+     *
+     * @return `SYSTEM_ERROR_NOT_FOUND` if the network hasn't provided the time.
+     */
+    virtual int getNetworkTime(time_t* time) = 0;
+
+    /**
+     * Returns `true` if the modem is still running the session it had before the last reset,
+     * and the session can be resumed without power cycling the modem.
+     */
+    virtual bool isSessionResumable();
 };
 
+inline bool CellularNcpClient::isSessionResumable() {
+    return false;
+}
+
 inline CellularNcpClientConfig::CellularNcpClientConfig() :
         simType_(SimType::INTERNAL),
-        ident_(PLATFORM_NCP_UNKNOWN) {
+        ident_(PLATFORM_NCP_UNKNOWN),
+        netInfoMaxAge_(DEFAULT_NETWORK_INFO_MAX_AGE) {
 }
 
 inline CellularNcpClientConfig& CellularNcpClientConfig::simType(SimType type) {
@@ -153,6 +190,15 @@ inline PlatformNCPIdentifier CellularNcpClientConfig::ncpIdentifier() const {
     return ident_;
 }
 
+inline CellularNcpClientConfig& CellularNcpClientConfig::networkInfoMaxAge(unsigned age) {
+    netInfoMaxAge_ = age;
+    return *this;
+}
+
+inline unsigned CellularNcpClientConfig::networkInfoMaxAge() const {
+    return netInfoMaxAge_;
+}
+
 // CellularSignalQuality
 
 inline CellularSignalQuality& CellularSignalQuality::accessTechnology(const CellularAccessTechnology& act) {
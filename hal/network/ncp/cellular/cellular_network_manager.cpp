@@ -23,6 +23,8 @@
 #include "scope_guard.h"
 #include "check.h"
 
+#include <cstring>
+
 // FIXME: Move nanopb utilities to a common header file
 #include "../../../../system/src/control/common.h"
 
@@ -39,6 +41,15 @@ namespace {
 using namespace control::common;
 
 const auto CONFIG_FILE = "/sys/cellular_config.bin";
+const auto OPERATOR_FILE = "/sys/cellular_oper.bin";
+
+// Operator of the last successful registration
+struct LastOperatorData {
+    uint16_t size; // Size of this structure
+    uint8_t sim; // SIM card type
+    int8_t act; // Access technology
+    char oper[8]; // Numeric operator code, null-terminated
+};
 
 struct CellularConfig {
     CellularNetworkConfig intSimConf;
@@ -167,6 +178,43 @@ int saveConfig(const CellularConfig& conf) {
     return 0;
 }
 
+int loadLastOperator(LastOperatorData* data) {
+    const auto fs = filesystem_get_instance(nullptr);
+    CHECK_TRUE(fs, SYSTEM_ERROR_FILE);
+    fs::FsLock lock(fs);
+    CHECK(filesystem_mount(fs));
+    lfs_file_t file = {};
+    CHECK(openFile(&file, OPERATOR_FILE, LFS_O_RDONLY));
+    SCOPE_GUARD({
+        lfs_file_close(&fs->instance, &file);
+    });
+    *data = {};
+    const int r = lfs_file_read(&fs->instance, &file, data, sizeof(LastOperatorData));
+    if (r != (int)sizeof(LastOperatorData) || data->size != sizeof(LastOperatorData) ||
+            !memchr(data->oper, '\0', sizeof(data->oper))) {
+        return SYSTEM_ERROR_NOT_FOUND; // The file is empty or was written by an incompatible version
+    }
+    return 0;
+}
+
+int saveLastOperator(const LastOperatorData& data) {
+    const auto fs = filesystem_get_instance(nullptr);
+    CHECK_TRUE(fs, SYSTEM_ERROR_FILE);
+    fs::FsLock lock(fs);
+    CHECK(filesystem_mount(fs));
+    lfs_file_t file = {};
+    CHECK(openFile(&file, OPERATOR_FILE, LFS_O_WRONLY));
+    SCOPE_GUARD({
+        lfs_file_close(&fs->instance, &file);
+    });
+    int r = lfs_file_truncate(&fs->instance, &file, 0);
+    CHECK_TRUE(r == LFS_ERR_OK, SYSTEM_ERROR_FILE);
+    r = lfs_file_write(&fs->instance, &file, &data, sizeof(data));
+    CHECK_TRUE(r == (int)sizeof(data), SYSTEM_ERROR_FILE);
+    LOG(TRACE, "Updated file: %s", OPERATOR_FILE);
+    return 0;
+}
+
 } // unnamed
 
 CellularNetworkManager::CellularNetworkManager(CellularNcpClient* client) :
@@ -179,10 +227,16 @@ CellularNetworkManager::~CellularNetworkManager() {
 int CellularNetworkManager::connect() {
     CellularConfig c;
     CHECK(loadConfig(&c));
-    const CellularNetworkConfig* conf = &c.intSimConf;
+    CellularNetworkConfig* conf = &c.intSimConf;
     if (c.activeSim == SimType::EXTERNAL) {
         conf = &c.extSimConf;
     }
+    // Let the client try the operator it was registered with last time, so that the modem
+    // doesn't have to scan all bands on every power-up
+    LastOperatorData oper = {};
+    if (loadLastOperator(&oper) == 0 && oper.sim == (uint8_t)c.activeSim) {
+        conf->lastOperator(oper.oper, oper.act);
+    }
     CHECK(client_->connect(*conf));
     return 0;
 }
@@ -261,4 +315,20 @@ int CellularNetworkManager::getActiveSim(SimType* sim) {
     return 0;
 }
 
+int CellularNetworkManager::setLastOperator(SimType sim, const char* oper, int act) {
+    CHECK_TRUE(oper && strlen(oper) < sizeof(LastOperatorData::oper), SYSTEM_ERROR_INVALID_ARGUMENT);
+    LastOperatorData data = {};
+    if (loadLastOperator(&data) == 0 && data.sim == (uint8_t)sim && data.act == act &&
+            strcmp(data.oper, oper) == 0) {
+        return 0; // Avoid wearing out the flash
+    }
+    data = {};
+    data.size = sizeof(data);
+    data.sim = (uint8_t)sim;
+    data.act = act;
+    strcpy(data.oper, oper);
+    CHECK(saveLastOperator(data));
+    return 0;
+}
+
 } // particle
@@ -47,10 +47,26 @@ public:
 
     bool isValid() const;
 
+    /**
+     * Sets the operator the device was last registered with.
+     *
+     * The NCP client tries to register with this operator first, before falling back to the
+     * automatic operator selection.
+     *
+     * @param oper Numeric operator code (MCC and MNC).
+     * @param act Access technology as defined for `AT+COPS`, or -1 if unknown.
+     */
+    CellularNetworkConfig& lastOperator(const char* oper, int act = -1);
+    const char* lastOperator() const;
+    int lastOperatorAct() const;
+    bool hasLastOperator() const;
+
 private:
     CString apn_;
     CString user_;
     CString pwd_;
+    CString oper_;
+    int operAct_;
 };
 
 class CellularNetworkManager {
@@ -70,11 +86,21 @@ public:
     static int setActiveSim(SimType sim);
     static int getActiveSim(SimType* sim);
 
+    /**
+     * Stores the operator the device has registered with using the specified SIM card.
+     *
+     * The file is only rewritten if the operator has changed.
+     *
+     * @see `CellularNetworkConfig::lastOperator()`
+     */
+    static int setLastOperator(SimType sim, const char* oper, int act);
+
 private:
     CellularNcpClient* client_;
 };
 
-inline CellularNetworkConfig::CellularNetworkConfig() {
+inline CellularNetworkConfig::CellularNetworkConfig() :
+        operAct_(-1) {
 }
 
 inline CellularNetworkConfig& CellularNetworkConfig::apn(const char* apn) {
@@ -120,6 +146,24 @@ inline bool CellularNetworkConfig::isValid() const {
     return (apn_ && user_ && pwd_);
 }
 
+inline CellularNetworkConfig& CellularNetworkConfig::lastOperator(const char* oper, int act) {
+    oper_ = oper;
+    operAct_ = act;
+    return *this;
+}
+
+inline const char* CellularNetworkConfig::lastOperator() const {
+    return oper_;
+}
+
+inline int CellularNetworkConfig::lastOperatorAct() const {
+    return operAct_;
+}
+
+inline bool CellularNetworkConfig::hasLastOperator() const {
+    return oper_ && *oper_;
+}
+
 inline CellularNcpClient* CellularNetworkManager::ncpClient() const {
     return client_;
 }
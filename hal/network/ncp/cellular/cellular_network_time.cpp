@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cellular_network_time.h"
+
+#include <cstdio>
+
+namespace particle {
+
+namespace {
+
+// Until the network time is received, the modems report their default time, which is years
+// in the past
+const int MIN_YEAR = 2020;
+const int MAX_YEAR = 2079;
+
+// Number of days since 1970-01-01 for a date in the proleptic Gregorian calendar
+long daysFromCivil(int y, unsigned m, unsigned d) {
+    y -= (m <= 2);
+    const long era = y / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (long)doe - 719468;
+}
+
+} // unnamed
+
+bool parseNetworkTime(const char* str, time_t* time) {
+    int year = 0, month = 0, day = 0, hour = 0, min = 0, sec = 0, zone = 0;
+    char sign = 0;
+    int n = 0;
+    if (sscanf(str, "%2d/%2d/%2d,%2d:%2d:%2d%c%2d%n", &year, &month, &day, &hour, &min, &sec, &sign, &zone, &n) != 8 ||
+            str[n] != '\0' || (sign != '+' && sign != '-')) {
+        return false;
+    }
+    year += 2000;
+    if (year < MIN_YEAR || year > MAX_YEAR || month < 1 || month > 12 || day < 1 || day > 31 ||
+            hour > 23 || min > 59 || sec > 59 || zone > 14 * 4) {
+        return false;
+    }
+    if (sign == '-') {
+        zone = -zone;
+    }
+    const long days = daysFromCivil(year, month, day);
+    *time = (time_t)days * 86400 + hour * 3600 + min * 60 + sec - zone * 15 * 60;
+    return true;
+}
+
+} // particle
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <ctime>
+
+namespace particle {
+
+/**
+ * Parses the network time reported by the `+CCLK` command in the "yy/MM/dd,hh:mm:ss±zz" format,
+ * where the time is local and `zz` is the time zone offset in quarters of an hour.
+ *
+ * @param str Time string without the quotes.
+ * @param[out] time UTC time.
+ * @return `false` if the string is malformed or the modem's clock hasn't been set from the
+ *         network yet.
+ */
+bool parseNetworkTime(const char* str, time_t* time);
+
+} // particle
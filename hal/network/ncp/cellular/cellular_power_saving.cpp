@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cellular_power_saving.h"
+
+#include <cstring>
+
+namespace particle {
+
+namespace {
+
+struct TimerUnit {
+    uint8_t code; // Value of the 3 most significant bits
+    uint32_t seconds;
+};
+
+// Timer units, in ascending order
+const TimerUnit GPRS_TIMER_3_UNITS[] = {
+    { 0x03, 2 }, // 2 seconds
+    { 0x04, 30 }, // 30 seconds
+    { 0x05, 60 }, // 1 minute
+    { 0x00, 600 }, // 10 minutes
+    { 0x01, 3600 }, // 1 hour
+    { 0x02, 36000 }, // 10 hours
+    { 0x06, 1152000 } // 320 hours
+};
+
+const TimerUnit GPRS_TIMER_2_UNITS[] = {
+    { 0x00, 2 }, // 2 seconds
+    { 0x01, 60 }, // 1 minute
+    { 0x02, 360 } // 1 decihour
+};
+
+const uint8_t TIMER_DEACTIVATED = 0x07;
+const uint32_t TIMER_MAX_VALUE = 0x1f;
+
+// eDRX cycle lengths for LTE in milliseconds
+const uint32_t EDRX_CYCLES[] = { 5120, 10240, 20480, 40960, 61440, 81920, 102400, 122880, 143360, 163840,
+        327680, 655360, 1310720, 2621440, 5242880, 10485760 };
+
+template<size_t N>
+uint8_t encodeTimer(const TimerUnit (&units)[N], uint32_t seconds) {
+    // Use the smallest unit that can represent the value, so that the rounding error is minimal
+    for (size_t i = 0; i < N; ++i) {
+        const uint32_t val = ((uint64_t)seconds + units[i].seconds / 2) / units[i].seconds;
+        if (val <= TIMER_MAX_VALUE) {
+            return (units[i].code << 5) | val;
+        }
+    }
+    return (units[N - 1].code << 5) | TIMER_MAX_VALUE;
+}
+
+template<size_t N>
+bool decodeTimer(const TimerUnit (&units)[N], uint8_t value, uint32_t* seconds) {
+    const uint8_t code = value >> 5;
+    for (size_t i = 0; i < N; ++i) {
+        if (units[i].code == code) {
+            *seconds = (value & TIMER_MAX_VALUE) * units[i].seconds;
+            return true;
+        }
+    }
+    return false; // Deactivated or unknown unit
+}
+
+} // unnamed
+
+uint8_t encodePeriodicTau(uint32_t seconds) {
+    return encodeTimer(GPRS_TIMER_3_UNITS, seconds);
+}
+
+bool decodePeriodicTau(uint8_t value, uint32_t* seconds) {
+    return decodeTimer(GPRS_TIMER_3_UNITS, value, seconds);
+}
+
+uint8_t encodeActiveTime(uint32_t seconds) {
+    return encodeTimer(GPRS_TIMER_2_UNITS, seconds);
+}
+
+bool decodeActiveTime(uint8_t value, uint32_t* seconds) {
+    if ((value >> 5) == TIMER_DEACTIVATED) {
+        return false;
+    }
+    // Other unit values are interpreted as 1 minute
+    if (!decodeTimer(GPRS_TIMER_2_UNITS, value, seconds)) {
+        *seconds = (value & TIMER_MAX_VALUE) * 60;
+    }
+    return true;
+}
+
+uint8_t encodeEdrxCycle(uint32_t ms) {
+    const size_t n = sizeof(EDRX_CYCLES) / sizeof(EDRX_CYCLES[0]);
+    for (size_t i = 0; i + 1 < n; ++i) {
+        // Round to the nearest cycle length
+        if (ms < EDRX_CYCLES[i] + (EDRX_CYCLES[i + 1] - EDRX_CYCLES[i]) / 2) {
+            return i;
+        }
+    }
+    return n - 1;
+}
+
+uint32_t decodeEdrxCycle(uint8_t value) {
+    return EDRX_CYCLES[value & 0x0f];
+}
+
+void formatTimerBits(uint8_t value, unsigned bits, char* buf) {
+    for (unsigned i = 0; i < bits; ++i) {
+        buf[i] = (value & (1 << (bits - i - 1))) ? '1' : '0';
+    }
+    buf[bits] = '\0';
+}
+
+bool parseTimerBits(const char* str, unsigned bits, uint8_t* value) {
+    uint8_t v = 0;
+    for (unsigned i = 0; i < bits; ++i) {
+        if (str[i] != '0' && str[i] != '1') {
+            return false;
+        }
+        v = (v << 1) | (str[i] - '0');
+    }
+    if (str[bits] != '\0') {
+        return false;
+    }
+    *value = v;
+    return true;
+}
+
+bool parseCeregTimers(const char* line, uint8_t* activeTime, uint8_t* periodicTau) {
+    // +CEREG: [<n>,]<stat>[,[<tac>],[<ci>],[<AcT>][,[<cause_type>],[<reject_cause>][,[<Active_Time>],[<Periodic_TAU>]]]]
+    const size_t MIN_FIELD_COUNT = 8;
+    const size_t TIMER_FIELD_SIZE = 10; // 8 bits in quotes
+    const char* fields[2] = {}; // Last two fields
+    size_t count = 1;
+    for (const char* p = line; (p = strchr(p, ',')); ++count) {
+        ++p;
+        fields[0] = fields[1];
+        fields[1] = p;
+    }
+    if (count < MIN_FIELD_COUNT) {
+        return false;
+    }
+    uint8_t val[2] = {};
+    for (unsigned i = 0; i < 2; ++i) {
+        const char* f = fields[i];
+        const size_t size = strcspn(f, ",\r\n");
+        if (size != TIMER_FIELD_SIZE || f[0] != '"' || f[size - 1] != '"') {
+            return false;
+        }
+        char bits[9] = {};
+        memcpy(bits, f + 1, 8);
+        if (!parseTimerBits(bits, 8, &val[i])) {
+            return false;
+        }
+    }
+    *activeTime = val[0];
+    *periodicTau = val[1];
+    return true;
+}
+
+} // particle
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace particle {
+
+// Encoding of the PSM and eDRX timers as defined in 3GPP TS 24.008
+
+/**
+ * Encodes the periodic TAU timer (T3412) as a GPRS Timer 3 value.
+ *
+ * @param seconds Timer value in seconds. The value is rounded to the nearest value that can be
+ *        encoded.
+ */
+uint8_t encodePeriodicTau(uint32_t seconds);
+
+/**
+ * Decodes a GPRS Timer 3 value.
+ *
+ * @return `false` if the timer is deactivated.
+ */
+bool decodePeriodicTau(uint8_t value, uint32_t* seconds);
+
+/**
+ * Encodes the active timer (T3324) as a GPRS Timer 2 value.
+ *
+ * @param seconds Timer value in seconds. The value is rounded to the nearest value that can be
+ *        encoded.
+ */
+uint8_t encodeActiveTime(uint32_t seconds);
+
+/**
+ * Decodes a GPRS Timer 2 value.
+ *
+ * @return `false` if the timer is deactivated.
+ */
+bool decodeActiveTime(uint8_t value, uint32_t* seconds);
+
+/**
+ * Encodes the eDRX cycle length for LTE.
+ *
+ * @param ms Cycle length in milliseconds. The value is rounded to the nearest supported value.
+ * @return 4-bit value.
+ */
+uint8_t encodeEdrxCycle(uint32_t ms);
+
+/**
+ * Decodes a 4-bit eDRX cycle length for LTE.
+ *
+ * @return Cycle length in milliseconds.
+ */
+uint32_t decodeEdrxCycle(uint8_t value);
+
+/**
+ * Formats a value as a string of bits, as used by the `+CPSMS` and `+CEDRXS` commands.
+ *
+ * @param value Value.
+ * @param bits Number of bits.
+ * @param buf Destination buffer. The buffer needs to be at least `bits + 1` bytes long.
+ */
+void formatTimerBits(uint8_t value, unsigned bits, char* buf);
+
+/**
+ * Parses a string of bits.
+ *
+ * @return `false` if the string is not a valid string of `bits` bits.
+ */
+bool parseTimerBits(const char* str, unsigned bits, uint8_t* value);
+
+/**
+ * Parses the timers granted by the network from a `+CEREG` response or URC reported in mode 4.
+ *
+ * @param line Response line.
+ * @param[out] activeTime Active timer (T3324) as a GPRS Timer 2 value.
+ * @param[out] periodicTau Periodic TAU timer (T3412) as a GPRS Timer 3 value.
+ * @return `false` if the line doesn't contain the timers.
+ */
+bool parseCeregTimers(const char* line, uint8_t* activeTime, uint8_t* periodicTau);
+
+} // particle
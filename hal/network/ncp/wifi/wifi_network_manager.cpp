@@ -19,6 +19,8 @@
 
 #include "wifi_ncp_client.h"
 
+#include "timer_hal.h"
+
 #include "file_util.h"
 #include "logging.h"
 #include "scope_guard.h"
@@ -48,6 +50,12 @@ namespace {
 using namespace control::common;
 using spark::Vector;
 
+// Maximum age of the scan results that can be used to connect to a network without scanning again
+const system_tick_t SCAN_CACHE_TTL = 15000;
+
+// Maximum number of access points kept in the scan cache
+const int MAX_SCAN_CACHE_SIZE = 16;
+
 template<typename T>
 void bssidToPb(const MacAddress& bssid, T* pbBssid) {
     if (bssid != INVALID_MAC_ADDRESS) {
@@ -170,22 +178,60 @@ int networkIndexForSsid(const char* ssid, const Vector<WifiNetworkConfig>& netwo
     return -1;
 }
 
-void sortByRssi(Vector<WifiScanResult>* scanResults) {
-    std::sort(scanResults->begin(), scanResults->end(), [](const WifiScanResult& ap1, const WifiScanResult& ap2) {
-        return (ap1.rssi() > ap2.rssi()); // In descending order
-    });
+// Adds an access point to a list sorted by RSSI in descending order, keeping only the strongest ones
+void addScanResult(Vector<WifiScanResult>* scanResults, WifiScanResult result) {
+    int i = 0;
+    while (i < scanResults->size() && scanResults->at(i).rssi() >= result.rssi()) {
+        ++i;
+    }
+    if (i == MAX_SCAN_CACHE_SIZE) {
+        return;
+    }
+    if (scanResults->size() == MAX_SCAN_CACHE_SIZE) {
+        scanResults->removeAt(MAX_SCAN_CACHE_SIZE - 1);
+    }
+    scanResults->insert(i, std::move(result));
+}
+
+// Tries to connect to any known network among the discovered ones
+int connectToKnownNetwork(WifiNcpClient* client, const char* ssid, const Vector<WifiScanResult>& scanResults,
+        Vector<WifiNetworkConfig>* networks, int* index, MacAddress* bssid) {
+    for (const auto& ap: scanResults) {
+        int i = 0;
+        if (!ssid) {
+            i = networkIndexForSsid(ap.ssid(), *networks);
+            if (i < 0) {
+                continue;
+            }
+        } else if (strcmp(ssid, ap.ssid()) != 0) {
+            continue;
+        } else {
+            i = *index;
+        }
+        const auto& network = networks->at(i);
+        const int r = client->connect(network.ssid(), ap.bssid(), network.security(), network.credentials());
+        if (r == 0) {
+            *index = i;
+            *bssid = ap.bssid();
+            return 0;
+        }
+    }
+    return SYSTEM_ERROR_NOT_FOUND;
 }
 
 } // unnamed
 
 WifiNetworkManager::WifiNetworkManager(WifiNcpClient* client) :
-        client_(client) {
+        client_(client),
+        scanCacheTime_(0),
+        lastBssid_(INVALID_MAC_ADDRESS) {
 }
 
 WifiNetworkManager::~WifiNetworkManager() {
 }
 
 int WifiNetworkManager::connect(const char* ssid) {
+    const NcpClientLock lock(client_);
     // Get known networks
     Vector<WifiNetworkConfig> networks;
     CHECK(loadConfig(&networks));
@@ -201,65 +247,44 @@ int WifiNetworkManager::connect(const char* ssid) {
     if (index == networks.size()) {
         return SYSTEM_ERROR_NOT_FOUND;
     }
-    // Connect to the network
-    bool updateConfig = false;
-    auto network = &networks.at(index);
-    // Always perform a network scan for now, because ESP32 doesn't support 802.11v/k/r
-#if 0
-    int r = client_->connect(network->ssid(), network->bssid(), network->security(), network->credentials());
-#else
-    int r = SYSTEM_ERROR_INTERNAL;
-#endif
-    if (r < 0) {
-        // Perform network scan
-        Vector<WifiScanResult> scanResults;
-        CHECK_TRUE(scanResults.reserve(10), SYSTEM_ERROR_NO_MEMORY);
-        CHECK(client_->scan([](WifiScanResult result, void* data) -> int {
-            auto scanResults = (Vector<WifiScanResult>*)data;
-            CHECK_TRUE(scanResults->append(std::move(result)), SYSTEM_ERROR_NO_MEMORY);
-            return 0;
-        }, &scanResults));
-        // Sort discovered networks by RSSI
-        sortByRssi(&scanResults);
-        // Try to connect to any known network among the discovered ones
-        bool connected = false;
-        for (const auto& ap: scanResults) {
-            if (!ssid) {
-                index = 0;
-                for (; index < networks.size(); ++index) {
-                    network = &networks.at(index);
-                    if (strcmp(network->ssid(), ap.ssid()) == 0) {
-                        break;
-                    }
-                }
-                if (index == networks.size()) {
-                    continue;
-                }
-            } else if (strcmp(ssid, ap.ssid()) != 0) {
-                continue;
-            }
-            r = client_->connect(network->ssid(), ap.bssid(), network->security(), network->credentials());
+    // Connect to the network. Always perform a network scan if the device hasn't been connected
+    // to an access point of a known network recently, because ESP32 doesn't support 802.11v/k/r
+    int r = SYSTEM_ERROR_NOT_FOUND;
+    MacAddress bssid = INVALID_MAC_ADDRESS;
+    if (lastBssid_ != INVALID_MAC_ADDRESS) {
+        const int i = networkIndexForSsid(lastSsid_, networks);
+        if (i >= 0 && (!ssid || i == index)) {
+            // Try the last access point first
+            const auto& network = networks.at(i);
+            r = client_->connect(network.ssid(), lastBssid_, network.security(), network.credentials());
             if (r == 0) {
-                if (network->bssid() != ap.bssid()) {
-                    // Update BSSID
-                    network->bssid(ap.bssid());
-                    updateConfig = true;
-                }
-                connected = true;
-                break;
+                index = i;
+                bssid = lastBssid_;
+            } else {
+                LOG(TRACE, "Unable to reconnect to the last access point: %d", r);
+                lastBssid_ = INVALID_MAC_ADDRESS;
             }
         }
-        if (!connected) {
+    }
+    if (r < 0 && isScanCacheValid()) {
+        // Use the results of a recent network scan
+        r = connectToKnownNetwork(client_, ssid, scanCache_, &networks, &index, &bssid);
+    }
+    if (r < 0) {
+        // Perform network scan
+        CHECK(scan(nullptr, nullptr, networks));
+        r = connectToKnownNetwork(client_, ssid, scanCache_, &networks, &index, &bssid);
+        if (r < 0) {
             return SYSTEM_ERROR_NOT_FOUND;
         }
-    } else if (network->bssid() == INVALID_MAC_ADDRESS) {
+    }
+    lastSsid_ = networks.at(index).ssid();
+    lastBssid_ = bssid;
+    bool updateConfig = false;
+    if (networks.at(index).bssid() != bssid) {
         // Update BSSID
-        WifiNetworkInfo info;
-        r = client_->getNetworkInfo(&info);
-        if (r == 0) {
-            network->bssid(info.bssid());
-            updateConfig = true;
-        }
+        networks.at(index).bssid(bssid);
+        updateConfig = true;
     }
     if (index != 0) {
         // Move the network to the beginning of the list
@@ -273,6 +298,54 @@ int WifiNetworkManager::connect(const char* ssid) {
     return 0;
 }
 
+int WifiNetworkManager::scan(WifiScanCallback callback, void* data) {
+    const NcpClientLock lock(client_);
+    Vector<WifiNetworkConfig> networks;
+    if (loadConfig(&networks) < 0) {
+        networks.clear();
+    }
+    return scan(callback, data, networks);
+}
+
+int WifiNetworkManager::scan(WifiScanCallback callback, void* data, const Vector<WifiNetworkConfig>& networks) {
+    struct ScanData {
+        Vector<WifiScanResult> scanResults;
+        const Vector<WifiNetworkConfig>* networks;
+        WifiScanCallback callback;
+        void* data;
+        int error;
+    };
+    ScanData d = {};
+    d.networks = &networks;
+    d.callback = callback;
+    d.data = data;
+    CHECK_TRUE(d.scanResults.reserve(MAX_SCAN_CACHE_SIZE), SYSTEM_ERROR_NO_MEMORY);
+    scanCache_.clear();
+    // Keep reading the results after the callback has cancelled the scan, so that the NCP
+    // response is consumed entirely and the scan cache is complete
+    CHECK(client_->scan([](WifiScanResult result, void* data) -> int {
+        const auto d = (ScanData*)data;
+        if (d->callback) {
+            const int r = d->callback(result, d->data);
+            if (r != 0) {
+                d->callback = nullptr;
+                d->error = (r < 0) ? r : 0;
+            }
+        }
+        if (result.ssid() && networkIndexForSsid(result.ssid(), *d->networks) >= 0) {
+            addScanResult(&d->scanResults, std::move(result));
+        }
+        return 0;
+    }, &d));
+    scanCache_ = std::move(d.scanResults);
+    scanCacheTime_ = HAL_Timer_Get_Milli_Seconds();
+    return d.error;
+}
+
+bool WifiNetworkManager::isScanCacheValid() const {
+    return !scanCache_.isEmpty() && HAL_Timer_Get_Milli_Seconds() - scanCacheTime_ < SCAN_CACHE_TTL;
+}
+
 int WifiNetworkManager::setNetworkConfig(WifiNetworkConfig conf) {
     CHECK_TRUE(conf.ssid(), SYSTEM_ERROR_INVALID_ARGUMENT);
     Vector<WifiNetworkConfig> networks;
@@ -19,6 +19,9 @@
 
 #include "addr_util.h"
 #include "c_string.h"
+#include "system_tick_hal.h"
+
+#include "spark_wiring_vector.h"
 
 #include <cstdint>
 
@@ -148,6 +151,12 @@ public:
     int connect(const char* ssid);
     int connect();
 
+    // Performs a network scan. The results are reported as they arrive. If the callback returns
+    // a non-zero value, no more results are reported; a negative value is also returned by this
+    // method once the scan completes. The strongest access points of the known networks are kept
+    // for a short time to speed up subsequent connection attempts
+    int scan(WifiScanCallback callback, void* data);
+
     static int setNetworkConfig(WifiNetworkConfig conf);
     static int getNetworkConfig(const char* ssid, WifiNetworkConfig* conf);
     static int getNetworkConfig(GetNetworkConfigCallback callback, void* data);
@@ -159,6 +168,13 @@ public:
 
 private:
     WifiNcpClient* client_;
+    spark::Vector<WifiScanResult> scanCache_; // Results of the last network scan
+    system_tick_t scanCacheTime_; // Time when the last network scan was performed
+    CString lastSsid_; // SSID of the last network the device was connected to
+    MacAddress lastBssid_; // BSSID of the last access point the device was connected to
+
+    int scan(WifiScanCallback callback, void* data, const spark::Vector<WifiNetworkConfig>& networks);
+    bool isScanCacheValid() const;
 };
 
 inline WifiCredentials::WifiCredentials() :
@@ -21,6 +21,7 @@ LOG_SOURCE_CATEGORY("ot.api");
 #include "ot_api.h"
 #include <openthread-core-config.h>
 #include <openthread/thread.h>
+#include <openthread/link.h>
 #include <openthread/commissioner.h>
 #include <openthread/joiner.h>
 #include <openthread/instance.h>
@@ -43,6 +44,16 @@ namespace {
 const uint16_t KEY_NETWORK_ID = 0x4000;
 // Border router prefixes
 const uint16_t KEY_BORDER_ROUTER_PREFIX_BASE = 0x4100;
+// Sleepy End Device configuration
+const uint16_t KEY_SLEEPY_END_DEVICE = 0x4200;
+
+struct __attribute__((packed)) SleepyEndDeviceSettings {
+    uint32_t pollPeriod;
+    uint32_t childTimeout;
+};
+
+// Default child timeout of OpenThread
+const uint32_t DEFAULT_CHILD_TIMEOUT = 240;
 
 otInstance* s_threadInstance = nullptr;
 StaticRecursiveMutex s_threadMutex;
@@ -78,6 +89,41 @@ void ot_process(void* arg) {
     os_thread_exit(nullptr);
 }
 
+int loadSleepyEndDeviceSettings(otInstance* ot, SleepyEndDeviceSettings* settings) {
+    uint16_t size = sizeof(SleepyEndDeviceSettings);
+    const auto ret = otPlatSettingsGet(ot, KEY_SLEEPY_END_DEVICE, 0, (uint8_t*)settings, &size);
+    if (ret == OT_ERROR_NOT_FOUND) {
+        *settings = {};
+        return 0;
+    }
+    CHECK_THREAD(ret);
+    CHECK_TRUE(size == sizeof(SleepyEndDeviceSettings), SYSTEM_ERROR_BAD_DATA);
+    return 0;
+}
+
+int applyLinkMode(otInstance* ot) {
+    SleepyEndDeviceSettings settings = {};
+    const int ret = loadSleepyEndDeviceSettings(ot, &settings);
+    if (ret < 0) {
+        LOG(WARN, "Unable to load Sleepy End Device settings: %d", ret);
+        settings = {};
+    }
+    const bool sleepy = settings.pollPeriod > 0;
+    otLinkModeConfig mode = {};
+    // A Sleepy End Device is a Minimal Thread Device that only needs the stable network data
+    mode.mRxOnWhenIdle = !sleepy;
+    mode.mSecureDataRequests = true;
+    mode.mDeviceType = !sleepy;
+    mode.mNetworkData = !sleepy;
+    CHECK_THREAD(otThreadSetLinkMode(ot, mode));
+    otLinkSetPollPeriod(ot, settings.pollPeriod);
+    otThreadSetChildTimeout(ot, settings.childTimeout ? settings.childTimeout : DEFAULT_CHILD_TIMEOUT);
+    if (sleepy) {
+        LOG(INFO, "Sleepy End Device, poll period: %u ms", (unsigned)settings.pollPeriod);
+    }
+    return 0;
+}
+
 } /* anonymous */
 
 void otTaskletsSignalPending(otInstance* instance)
@@ -119,13 +165,7 @@ int ot_init(int (*onInit)(otInstance*), void* reserved) {
 
     s_threadInstance = thread;
 
-    otLinkModeConfig mode = {};
-    mode.mRxOnWhenIdle = true;
-    mode.mSecureDataRequests = true;
-    mode.mDeviceType = true;
-    mode.mNetworkData = true;
-    // FIXME: CHECK_THREAD()
-    CHECK_TRUE(otThreadSetLinkMode(thread, mode) == OT_ERROR_NONE, SYSTEM_ERROR_UNKNOWN);
+    CHECK(applyLinkMode(thread));
     CHECK_TRUE(otPlatRadioSetTransmitPower(thread, (int8_t)HAL_PLATFORM_OPENTHREAD_MAX_TX_POWER) == OT_ERROR_NONE,
             SYSTEM_ERROR_UNKNOWN);
 
@@ -213,3 +253,41 @@ int ot_set_network_id(otInstance* ot, const char* buf, size_t buflen) {
     auto result = otPlatSettingsSet(ot, KEY_NETWORK_ID, (const uint8_t*)buf, buflen);
     return ot_system_error(result);
 }
+
+int ot_set_sleepy_end_device(otInstance* ot, uint32_t pollPeriod, uint32_t childTimeout) {
+    ThreadLock lk;
+    SleepyEndDeviceSettings settings = {};
+    settings.pollPeriod = pollPeriod;
+    settings.childTimeout = childTimeout;
+    if (pollPeriod > 0) {
+        CHECK_THREAD(otPlatSettingsSet(ot, KEY_SLEEPY_END_DEVICE, (const uint8_t*)&settings, sizeof(settings)));
+    } else {
+        const auto ret = otPlatSettingsDelete(ot, KEY_SLEEPY_END_DEVICE, -1);
+        if (ret != OT_ERROR_NOT_FOUND) {
+            CHECK_THREAD(ret);
+        }
+    }
+    return applyLinkMode(ot);
+}
+
+int ot_get_sleepy_end_device(otInstance* ot, uint32_t* pollPeriod, uint32_t* childTimeout) {
+    ThreadLock lk;
+    SleepyEndDeviceSettings settings = {};
+    CHECK(loadSleepyEndDeviceSettings(ot, &settings));
+    if (pollPeriod) {
+        *pollPeriod = settings.pollPeriod;
+    }
+    if (childTimeout) {
+        *childTimeout = settings.childTimeout ? settings.childTimeout : DEFAULT_CHILD_TIMEOUT;
+    }
+    return 0;
+}
+
+int ot_poll_parent(otInstance* ot) {
+    ThreadLock lk;
+    if (otThreadGetLinkMode(ot).mRxOnWhenIdle) {
+        return 0;
+    }
+    CHECK_THREAD(otLinkSendDataRequest(ot));
+    return 0;
+}
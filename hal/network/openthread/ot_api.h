@@ -158,6 +158,44 @@ int ot_get_network_id(otInstance* ot, char* buf, size_t* buflen);
  */
 int ot_set_network_id(otInstance* ot, const char* buf, size_t buflen);
 
+/**
+ * Configures the device as a Sleepy End Device, or as a router-eligible device.
+ *
+ * A Sleepy End Device keeps its radio off when idle and periodically polls its parent for
+ * the frames buffered for it. The configuration is stored in persistent storage and takes effect
+ * immediately.
+ *
+ * @param      ot             OpenThread instance object
+ * @param[in]  pollPeriod     Period of the data polls in milliseconds, or 0 to disable the
+ *                            Sleepy End Device mode
+ * @param[in]  childTimeout   Time in seconds after which the parent forgets a child that hasn't
+ *                            polled it, or 0 to use the default timeout
+ *
+ * @returns    0 on success, system_error_t on error.
+ */
+int ot_set_sleepy_end_device(otInstance* ot, uint32_t pollPeriod, uint32_t childTimeout);
+
+/**
+ * Retrieves the Sleepy End Device configuration.
+ *
+ * @param      ot             OpenThread instance object
+ * @param[out] pollPeriod     Period of the data polls in milliseconds, or 0 if the Sleepy End
+ *                            Device mode is disabled
+ * @param[out] childTimeout   Child timeout in seconds
+ *
+ * @returns    0 on success, system_error_t on error.
+ */
+int ot_get_sleepy_end_device(otInstance* ot, uint32_t* pollPeriod, uint32_t* childTimeout);
+
+/**
+ * Polls the parent for the frames buffered for this device, if it's a Sleepy End Device.
+ *
+ * @param      ot      OpenThread instance object
+ *
+ * @returns    0 on success, system_error_t on error.
+ */
+int ot_poll_parent(otInstance* ot);
+
 #ifdef __cplusplus
 }
 
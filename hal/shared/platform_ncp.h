@@ -73,3 +73,16 @@ int platform_ncp_fetch_module_info(hal_system_info_t* sys_info, bool create);
 
 #endif
 
+#if HAL_PLATFORM_NCP_EARLY_POWER_ON
+#ifdef __cplusplus
+extern "C" {
+#endif
+/**
+ * Starts powering on the NCP so that its boot overlaps with the rest of the system initialization.
+ * Called from HAL_Core_Config(), after the DCT is available. Does not wait for the NCP to become ready.
+ */
+int platform_ncp_early_power_on(void);
+#ifdef __cplusplus
+}
+#endif
+#endif // HAL_PLATFORM_NCP_EARLY_POWER_ON
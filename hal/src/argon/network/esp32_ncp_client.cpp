@@ -79,6 +79,9 @@ const auto ESP32_NCP_AP_CHANNEL = 3;
 
 const auto ESP32_NCP_MIN_MVER_WITH_CMUX = 4;
 
+// Maximum number of XMODEM packets sent ahead of their acknowledgements during a firmware update
+const auto ESP32_NCP_XMODEM_WINDOW_SIZE = 4;
+
 } // unnamed
 
 Esp32NcpClient::Esp32NcpClient() :
@@ -267,7 +270,7 @@ int Esp32NcpClient::updateFirmware(InputStream* file, size_t size) {
     const auto strm = parser_.config().stream();
     CHECK(skipWhitespace(strm, 1000));
     XmodemSender sender;
-    CHECK(sender.init(strm, file, size));
+    CHECK(sender.init(strm, file, size, ESP32_NCP_XMODEM_WINDOW_SIZE));
     bool ok = false;
     for (;;) {
         const int r = sender.run();
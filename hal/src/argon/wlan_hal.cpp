@@ -80,6 +80,29 @@ WLanSecurityType fromWifiSecurity(WifiSecurity sec) {
     }
 }
 
+void toWiFiAccessPoint(const WifiScanResult& result, WiFiAccessPoint* ap) {
+    if (result.ssid()) {
+        ap->ssidLength = strlen(result.ssid());
+        if (ap->ssidLength >= sizeof(ap->ssid)) {
+            ap->ssidLength = sizeof(ap->ssid) - 1;
+        }
+        memcpy(ap->ssid, result.ssid(), ap->ssidLength);
+        ap->ssid[ap->ssidLength] = '\0';
+    }
+    static_assert(sizeof(ap->bssid) == MAC_ADDRESS_SIZE, "");
+    memcpy(ap->bssid, &result.bssid(), MAC_ADDRESS_SIZE);
+    ap->security = fromWifiSecurity(result.security());
+    // FIXME: As the ESP32 doesn't return the cipher type of an AP, we manually set it here.
+    if (ap->security == WLAN_SEC_WPA || ap->security == WLAN_SEC_WPA2) {
+        ap->cipher = WLAN_CIPHER_AES_TKIP;
+    }
+    else {
+        ap->cipher = WLAN_CIPHER_NOT_SET;
+    }
+    ap->channel = result.channel();
+    ap->rssi = result.rssi();
+}
+
 } // unnamed
 
 int wlan_connect_init() {
@@ -302,31 +325,9 @@ int wlan_scan(wlan_scan_result_t callback, void* cookie) {
     };
     const auto mgr = wifiNetworkManager();
     CHECK_TRUE(mgr, SYSTEM_ERROR_UNKNOWN);
-    const auto client = mgr->ncpClient();
-    CHECK_TRUE(client, SYSTEM_ERROR_UNKNOWN);
-    CHECK(client->scan([](WifiScanResult result, void* data) {
-        WiFiAccessPoint ap = {};
-        ap.size = sizeof(WiFiAccessPoint);
-        if (result.ssid()) {
-            ap.ssidLength = strlen(result.ssid());
-            if (ap.ssidLength >= sizeof(ap.ssid)) {
-                ap.ssidLength = sizeof(ap.ssid) - 1;
-            }
-            memcpy(ap.ssid, result.ssid(), ap.ssidLength);
-            ap.ssid[ap.ssidLength] = '\0';
-        }
-        static_assert(sizeof(ap.bssid) == MAC_ADDRESS_SIZE, "");
-        memcpy(ap.bssid, &result.bssid(), MAC_ADDRESS_SIZE);
-        ap.security = fromWifiSecurity(result.security());
-        // FIXME: As the ESP32 doesn't return the cipher type of an AP, we manually set it here.
-        if (ap.security == WLAN_SEC_WPA || ap.security == WLAN_SEC_WPA2) {
-            ap.cipher = WLAN_CIPHER_AES_TKIP;
-        }
-        else {
-            ap.cipher = WLAN_CIPHER_NOT_SET;
-        }
-        ap.channel = result.channel();
-        ap.rssi = result.rssi();
+    CHECK(mgr->scan([](WifiScanResult result, void* data) {
+        WiFiAccessPoint ap;
+        toWiFiAccessPoint(result, &ap);
         const auto d = (Data*)data;
         d->callback(&ap, d->data);
         ++d->count;
@@ -335,6 +336,29 @@ int wlan_scan(wlan_scan_result_t callback, void* cookie) {
     return d.count;
 }
 
+int wlan_scan_stream(wlan_scan_stream_callback_t callback, void* cookie, void* reserved) {
+    struct Data {
+        wlan_scan_stream_callback_t callback;
+        void* data;
+        size_t count;
+    };
+    Data d = {
+        .callback = callback,
+        .data = cookie,
+        .count = 0
+    };
+    const auto mgr = wifiNetworkManager();
+    CHECK_TRUE(mgr, SYSTEM_ERROR_UNKNOWN);
+    CHECK(mgr->scan([](WifiScanResult result, void* data) {
+        WiFiAccessPoint ap;
+        toWiFiAccessPoint(result, &ap);
+        const auto d = (Data*)data;
+        ++d->count;
+        return (d->callback(&ap, d->data) != 0) ? 1 : 0;
+    }, &d));
+    return d.count;
+}
+
 int wlan_get_credentials(wlan_scan_result_t callback, void* callback_data) {
     struct Data {
         wlan_scan_result_t callback;
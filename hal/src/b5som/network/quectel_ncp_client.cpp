@@ -21,6 +21,7 @@
 #include "at_command.h"
 #include "at_response.h"
 #include "network/ncp/cellular/network_config_db.h"
+#include "network/ncp/cellular/cellular_network_time.h"
 
 #include "serial_stream.h"
 #include "check.h"
@@ -201,6 +202,7 @@ int QuectelNcpClient::initParser(Stream* stream) {
         // Cellular Global Identity (partial)
         self->cgi_.location_area_code = r >= 2 ? static_cast<LacType>(val[1]) : std::numeric_limits<LacType>::max();
         self->cgi_.cell_id = r >= 3 ? static_cast<CidType>(val[2]) : std::numeric_limits<CidType>::max();
+        self->invalidateNetworkInfo();
         return SYSTEM_ERROR_NONE;
     }, this));
     //+CGREG: <n>,<stat>[,<lac>,<ci>[,<Act>]]
@@ -229,6 +231,7 @@ int QuectelNcpClient::initParser(Stream* stream) {
         // Cellular Global Identity (partial)
         self->cgi_.location_area_code = r >= 2 ? static_cast<LacType>(val[1]) : std::numeric_limits<LacType>::max();
         self->cgi_.cell_id = r >= 3 ? static_cast<CidType>(val[2]) : std::numeric_limits<CidType>::max();
+        self->invalidateNetworkInfo();
         return SYSTEM_ERROR_NONE;
     }, this));
     //+CEREG: <n>,<stat>[,<tac>,<ci>[,<Act>]]
@@ -257,6 +260,7 @@ int QuectelNcpClient::initParser(Stream* stream) {
         // Cellular Global Identity (partial)
         self->cgi_.location_area_code = r >= 2 ? static_cast<LacType>(val[1]) : std::numeric_limits<LacType>::max();
         self->cgi_.cell_id = r >= 3 ? static_cast<CidType>(val[2]) : std::numeric_limits<CidType>::max();
+        self->invalidateNetworkInfo();
         return SYSTEM_ERROR_NONE;
     }, this));
     return SYSTEM_ERROR_NONE;
@@ -415,6 +419,18 @@ int QuectelNcpClient::getIccid(char* buf, size_t size) {
     return n;
 }
 
+int QuectelNcpClient::getNetworkTime(time_t* time) {
+    const NcpClientLock lock(this);
+    CHECK(checkParser());
+    auto resp = parser_.sendCommand("AT+CCLK?");
+    char str[32] = {};
+    int r = CHECK_PARSER(resp.scanf("+CCLK: \"%31[^\"]\"", str));
+    CHECK_TRUE(r == 1, SYSTEM_ERROR_AT_RESPONSE_UNEXPECTED);
+    CHECK_PARSER_OK(resp.readResult());
+    CHECK_TRUE(parseNetworkTime(str, time), SYSTEM_ERROR_NOT_FOUND);
+    return 0;
+}
+
 int QuectelNcpClient::getImei(char* buf, size_t size) {
     const NcpClientLock lock(this);
     CHECK(checkParser());
@@ -475,16 +491,29 @@ int QuectelNcpClient::queryAndParseAtCops(CellularSignalQuality* qual) {
     if (qual) {
         qual->accessTechnology(static_cast<CellularAccessTechnology>(act));
     }
+    copsTime_ = millis();
+    copsValid_ = true;
 
     return SYSTEM_ERROR_NONE;
 }
 
+bool QuectelNcpClient::isNetworkInfoValid(bool valid, system_tick_t time) const {
+    return valid && millis() - time < conf_.networkInfoMaxAge();
+}
+
+void QuectelNcpClient::invalidateNetworkInfo() {
+    sigQualValid_ = false;
+    copsValid_ = false;
+}
+
 int QuectelNcpClient::getCellularGlobalIdentity(CellularGlobalIdentity* cgi) {
     const NcpClientLock lock(this);
     CHECK_TRUE(connState_ != NcpConnectionState::DISCONNECTED, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(cgi, SYSTEM_ERROR_INVALID_ARGUMENT);
-    CHECK(checkParser());
-    CHECK(queryAndParseAtCops(nullptr));
+    if (!isNetworkInfoValid(copsValid_, copsTime_)) {
+        CHECK(checkParser());
+        CHECK(queryAndParseAtCops(nullptr));
+    }
 
     *cgi = cgi_;
 
@@ -495,6 +524,10 @@ int QuectelNcpClient::getSignalQuality(CellularSignalQuality* qual) {
     const NcpClientLock lock(this);
     CHECK_TRUE(connState_ != NcpConnectionState::DISCONNECTED, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(qual, SYSTEM_ERROR_INVALID_ARGUMENT);
+    if (isNetworkInfoValid(sigQualValid_, sigQualTime_)) {
+        *qual = sigQual_;
+        return SYSTEM_ERROR_NONE;
+    }
     CHECK(checkParser());
 
     {
@@ -578,6 +611,10 @@ int QuectelNcpClient::getSignalQuality(CellularSignalQuality* qual) {
         }
     }
 
+    sigQual_ = *qual;
+    sigQualTime_ = millis();
+    sigQualValid_ = true;
+
     return SYSTEM_ERROR_NONE;
 }
 
@@ -586,6 +623,14 @@ int QuectelNcpClient::setRegistrationTimeout(unsigned timeout) {
     return 0;
 }
 
+int QuectelNcpClient::setPowerSaving(const cellular_power_saving_config& conf) {
+    return SYSTEM_ERROR_NOT_SUPPORTED;
+}
+
+int QuectelNcpClient::getPowerSaving(cellular_power_saving_config* conf) {
+    return SYSTEM_ERROR_NOT_SUPPORTED;
+}
+
 int QuectelNcpClient::checkParser() {
     if (ncpState_ != NcpState::ON) {
         return SYSTEM_ERROR_INVALID_STATE;
@@ -692,6 +737,9 @@ int QuectelNcpClient::initReady() {
     int r = CHECK_PARSER(parser_.execCommand("AT+COPS=2"));
     // CHECK_TRUE(r == AtResponse::OK, SYSTEM_ERROR_UNKNOWN);
 
+    // Let the network update the modem's clock (NITZ)
+    CHECK_PARSER(parser_.execCommand("AT+CTZU=1"));
+
     if (ncpId() == PLATFORM_NCP_QUECTEL_BG96) {
         // FIXME: Force Cat M1-only mode, do we need to do it on Quectel NCP?
         // Scan LTE only, take effect immediately
@@ -891,6 +939,7 @@ void QuectelNcpClient::connectionState(NcpConnectionState state) {
     }
     LOG(TRACE, "NCP connection state changed: %d", (int)state);
     connState_ = state;
+    invalidateNetworkInfo();
 
     if (connState_ == NcpConnectionState::CONNECTED) {
         // Open data channel
@@ -64,6 +64,9 @@ public:
     virtual int getImei(char* buf, size_t size) override;
     virtual int getSignalQuality(CellularSignalQuality* qual) override;
     virtual int setRegistrationTimeout(unsigned timeout) override;
+    virtual int setPowerSaving(const cellular_power_saving_config& conf) override;
+    virtual int getPowerSaving(cellular_power_saving_config* conf) override;
+    virtual int getNetworkTime(time_t* time) override;
 
 private:
     AtParser parser_;
@@ -91,8 +94,15 @@ private:
     system_tick_t regStartTime_;
     system_tick_t regCheckTime_;
     unsigned registrationTimeout_;
+    CellularSignalQuality sigQual_;
+    system_tick_t sigQualTime_ = 0;
+    system_tick_t copsTime_ = 0;
+    bool sigQualValid_ = false;
+    bool copsValid_ = false;
 
     int queryAndParseAtCops(CellularSignalQuality* qual);
+    bool isNetworkInfoValid(bool valid, system_tick_t time) const;
+    void invalidateNetworkInfo();
     int initParser(Stream* stream);
     int checkParser();
     int waitReady();
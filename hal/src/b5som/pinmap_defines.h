@@ -94,4 +94,45 @@
 
 #define LOW_BAT_UC A6
 
+// nRF52840 GPIO of each pin, in the order of the pin map. Used to resolve the pins at compile time
+#define PLATFORM_NRF_PIN_MAP \
+    NRF_GPIO_PIN_MAP(0, 26), /* D0 */ \
+    NRF_GPIO_PIN_MAP(0, 27), /* D1 */ \
+    NRF_GPIO_PIN_MAP(1, 2), /* D2 */ \
+    NRF_GPIO_PIN_MAP(1, 10), /* D3 */ \
+    NRF_GPIO_PIN_MAP(0, 12), /* D4 */ \
+    NRF_GPIO_PIN_MAP(0, 24), /* D5 */ \
+    NRF_GPIO_PIN_MAP(1, 4), /* D6 */ \
+    NRF_GPIO_PIN_MAP(0, 13), /* D7 */ \
+    NRF_GPIO_PIN_MAP(0, 7), /* D8 */ \
+    NRF_GPIO_PIN_MAP(0, 6), /* D9 */ \
+    NRF_GPIO_PIN_MAP(0, 8), /* D10 */ \
+    NRF_GPIO_PIN_MAP(1, 8), /* D11 */ \
+    NRF_GPIO_PIN_MAP(1, 9), /* D12 */ \
+    NRF_GPIO_PIN_MAP(0, 11), /* D13 */ \
+    NRF_GPIO_PIN_MAP(0, 31), /* A5 */ \
+    NRF_GPIO_PIN_MAP(0, 30), /* A4 */ \
+    NRF_GPIO_PIN_MAP(0, 29), /* A3 */ \
+    NRF_GPIO_PIN_MAP(0, 28), /* A2 */ \
+    NRF_GPIO_PIN_MAP(0, 4), /* A1 */ \
+    NRF_GPIO_PIN_MAP(0, 3), /* A0 */ \
+    NRF_GPIO_PIN_MAP(0, 2), /* A7 */ \
+    NRF_GPIO_PIN_MAP(0, 5), /* A6 */ \
+    NRF_GPIO_PIN_MAP(1, 1), /* D22 */ \
+    NRF_GPIO_PIN_MAP(1, 3), /* D23 */ \
+    NRF_GPIO_PIN_MAP(0, 25), /* MODE BUTTON */ \
+    NRF_GPIO_PIN_MAP(0, 16), /* RGBR */ \
+    NRF_GPIO_PIN_MAP(0, 15), /* RGBG */ \
+    NRF_GPIO_PIN_MAP(0, 14), /* RGBB */ \
+    NRF_GPIO_PIN_MAP(1, 15), /* TX1 */ \
+    NRF_GPIO_PIN_MAP(1, 14), /* RX1 */ \
+    NRF_GPIO_PIN_MAP(1, 12), /* CTS1 */ \
+    NRF_GPIO_PIN_MAP(1, 13), /* RTS1 */ \
+    NRF_GPIO_PIN_MAP(1, 6), /* BGPWR */ \
+    NRF_GPIO_PIN_MAP(1, 7), /* BGRST */ \
+    NRF_GPIO_PIN_MAP(1, 11), /* BGVINT */ \
+    NRF_GPIO_PIN_MAP(1, 5), /* BGDTR */ \
+    NRF_GPIO_PIN_MAP(0, 9), /* NFC1 */ \
+    NRF_GPIO_PIN_MAP(0, 10), /* NFC2 */
+
 #endif // PLATFORM_ID == PLATFORM_B5SOM
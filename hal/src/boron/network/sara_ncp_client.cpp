@@ -21,6 +21,8 @@
 #include "at_command.h"
 #include "at_response.h"
 #include "network/ncp/cellular/network_config_db.h"
+#include "network/ncp/cellular/cellular_power_saving.h"
+#include "network/ncp/cellular/cellular_network_time.h"
 
 #include "serial_stream.h"
 #include "check.h"
@@ -31,6 +33,7 @@
 #include "timer_hal.h"
 #include "delay_hal.h"
 #include "core_hal.h"
+#include "ota_module.h"
 
 #include "stream_util.h"
 
@@ -39,6 +42,7 @@
 
 #include <algorithm>
 #include <limits>
+#include <cstdio>
 
 #undef LOG_COMPILE_TIME_LEVEL
 #define LOG_COMPILE_TIME_LEVEL LOG_LEVEL_ALL
@@ -96,11 +100,53 @@ const auto UBLOX_NCP_AT_CHANNEL_RX_BUFFER_SIZE = 4096;
 const auto UBLOX_NCP_AT_CHANNEL = 1;
 const auto UBLOX_NCP_PPP_CHANNEL = 2;
 
+// Frames per scheduling round. An AT command never waits for more than one PPP frame
+const auto UBLOX_NCP_AT_CHANNEL_TX_WEIGHT = 2;
+const auto UBLOX_NCP_PPP_CHANNEL_TX_WEIGHT = 1;
+
 const auto UBLOX_NCP_SIM_SELECT_PIN = 23;
 
 const unsigned REGISTRATION_CHECK_INTERVAL = 15 * 1000;
 const unsigned REGISTRATION_TIMEOUT = 5 * 60 * 1000;
 
+// The modem is not reset together with the MCU and stays in the multiplexing mode, registered to
+// the network. Its runtime state is kept in retained memory, so that the session can be resumed
+// after a warm reset instead of power cycling the modem and registering from scratch
+const uint32_t MODEM_STATE_MAGIC = 0x4d445331;
+
+struct ModemState {
+    uint32_t magic;
+    uint32_t baudRate;
+    int ncpId;
+    int simType;
+    bool memoryIssuePresent;
+};
+
+__attribute__((section(".retained_system"))) ModemState g_modemState;
+
+bool g_modemStateChecked = false;
+
+void saveModemState(unsigned baudRate, int ncpId, SimType simType, bool memoryIssuePresent) {
+    g_modemState.magic = MODEM_STATE_MAGIC;
+    g_modemState.baudRate = baudRate;
+    g_modemState.ncpId = ncpId;
+    g_modemState.simType = (int)simType;
+    g_modemState.memoryIssuePresent = memoryIssuePresent;
+}
+
+void invalidateModemState() {
+    g_modemState.magic = 0;
+}
+
+// Returns the state saved before a warm reset, or nullptr if the modem session can't be resumed
+const ModemState* savedModemState(int ncpId, SimType simType) {
+    if (g_modemStateChecked || g_modemState.magic != MODEM_STATE_MAGIC || !is_warm_reset() ||
+            g_modemState.ncpId != ncpId || g_modemState.simType != (int)simType) {
+        return nullptr;
+    }
+    return &g_modemState;
+}
+
 } // anonymous
 
 SaraNcpClient::SaraNcpClient() {
@@ -125,7 +171,10 @@ int SaraNcpClient::init(const NcpClientConfig& conf) {
             UBLOX_NCP_DEFAULT_SERIAL_BAUDRATE, sconf));
     CHECK_TRUE(serial, SYSTEM_ERROR_NO_MEMORY);
     // Initialize muxed channel stream
-    decltype(muxerAtStream_) muxStrm(new(std::nothrow) decltype(muxerAtStream_)::element_type(&muxer_, UBLOX_NCP_AT_CHANNEL));
+    CHECK(muxerTx_.init());
+    muxerTx_.setWeight(UBLOX_NCP_AT_CHANNEL, UBLOX_NCP_AT_CHANNEL_TX_WEIGHT);
+    muxerTx_.setWeight(UBLOX_NCP_PPP_CHANNEL, UBLOX_NCP_PPP_CHANNEL_TX_WEIGHT);
+    decltype(muxerAtStream_) muxStrm(new(std::nothrow) decltype(muxerAtStream_)::element_type(&muxerTx_, UBLOX_NCP_AT_CHANNEL));
     CHECK_TRUE(muxStrm, SYSTEM_ERROR_NO_MEMORY);
     CHECK(muxStrm->init(UBLOX_NCP_AT_CHANNEL_RX_BUFFER_SIZE));
     CHECK(initParser(serial.get()));
@@ -195,6 +244,7 @@ int SaraNcpClient::initParser(Stream* stream) {
         // Cellular Global Identity (partial)
         self->cgi_.location_area_code = r >= 2 ? static_cast<LacType>(val[1]) : std::numeric_limits<LacType>::max();
         self->cgi_.cell_id = r >= 3 ? static_cast<CidType>(val[2]) : std::numeric_limits<CidType>::max();
+        self->invalidateNetworkInfo();
         return 0;
     }, this));
     // n={0,1} +CGREG: <stat>
@@ -223,13 +273,14 @@ int SaraNcpClient::initParser(Stream* stream) {
         // Cellular Global Identity (partial)
         self->cgi_.location_area_code = r >= 2 ? static_cast<LacType>(val[1]) : std::numeric_limits<LacType>::max();
         self->cgi_.cell_id = r >= 3 ? static_cast<CidType>(val[2]) : std::numeric_limits<CidType>::max();
+        self->invalidateNetworkInfo();
         return 0;
     }, this));
     // +CEREG: <stat>[,[<tac>],[<ci>],[<AcT>][,<cause_type>,<reject_cause>[,[<Active_Time>],[<Periodic_TAU>]]]]
     CHECK(parser_.addUrcHandler("+CEREG", [](AtResponseReader* reader, const char* prefix, void* data) -> int {
         const auto self = (SaraNcpClient*)data;
         unsigned int val[4] = {};
-        char atResponse[64] = {};
+        char atResponse[96] = {};
         // Take a copy of AT response for multi-pass scanning
         CHECK_PARSER_URC(reader->readLine(atResponse, sizeof(atResponse)));
         // Parse response ignoring mode (replicate URC response)
@@ -246,10 +297,55 @@ int SaraNcpClient::initParser(Stream* stream) {
         } else {
             self->cereg_ = RegistrationState::NotRegistered;
         }
+        // PSM timers granted by the network
+        uint8_t activeTime = 0, periodicTau = 0;
+        if (parseCeregTimers(atResponse, &activeTime, &periodicTau)) {
+            auto& granted = self->powerSavingGranted_;
+            if (decodeActiveTime(activeTime, &granted.active_time) &&
+                    decodePeriodicTau(periodicTau, &granted.periodic_tau)) {
+                granted.flags |= CELLULAR_POWER_SAVING_FLAG_PSM;
+            } else {
+                granted.flags &= ~CELLULAR_POWER_SAVING_FLAG_PSM;
+            }
+        }
         self->checkRegistrationState();
         // Cellular Global Identity (partial)
         self->cgi_.location_area_code = r >= 2 ? static_cast<LacType>(val[1]) : std::numeric_limits<LacType>::max();
         self->cgi_.cell_id = r >= 3 ? static_cast<CidType>(val[2]) : std::numeric_limits<CidType>::max();
+        self->invalidateNetworkInfo();
+        return 0;
+    }, this));
+    // +CEDRXP: <AcT-type>[,<Requested_eDRX_value>[,<NW-provided_eDRX_value>[,<Paging_time_window>]]]
+    CHECK(parser_.addUrcHandler("+CEDRXP", [](AtResponseReader* reader, const char* prefix, void* data) -> int {
+        const auto self = (SaraNcpClient*)data;
+        char requested[5] = {};
+        char provided[5] = {};
+        unsigned act = 0;
+        const int r = CHECK_PARSER_URC(reader->scanf("+CEDRXP: %u,\"%4[01]\",\"%4[01]\"", &act, requested, provided));
+        auto& granted = self->powerSavingGranted_;
+        uint8_t val = 0;
+        if (r == 3 && parseTimerBits(provided, 4, &val)) {
+            granted.edrx_cycle = decodeEdrxCycle(val);
+            granted.flags |= CELLULAR_POWER_SAVING_FLAG_EDRX;
+        } else {
+            granted.flags &= ~CELLULAR_POWER_SAVING_FLAG_EDRX;
+        }
+        return 0;
+    }, this));
+    // +UUPSMR: <state>[,<param1>]
+    CHECK(parser_.addUrcHandler("+UUPSMR", [](AtResponseReader* reader, const char* prefix, void* data) -> int {
+        const auto self = (SaraNcpClient*)data;
+        unsigned state = 0;
+        const int r = CHECK_PARSER_URC(reader->scanf("+UUPSMR: %u", &state));
+        CHECK_TRUE(r == 1, SYSTEM_ERROR_AT_RESPONSE_UNEXPECTED);
+        // 0: the module is awake, 1: the module is entering PSM, 2: PSM is blocked
+        const bool active = (state == 1);
+        if (active != self->psmActive_) {
+            LOG(TRACE, "PSM state: %u", state);
+            self->psmActive_ = active;
+            // The modem doesn't respond to the multiplexer's keep-alive requests while in PSM
+            self->muxer_.setKeepAlivePeriod(active ? 0 : UBLOX_NCP_KEEPALIVE_PERIOD * 2);
+        }
         return 0;
     }, this));
     return 0;
@@ -274,6 +370,7 @@ int SaraNcpClient::off() {
     if (ncpState_ == NcpState::DISABLED) {
         return SYSTEM_ERROR_INVALID_STATE;
     }
+    invalidateModemState();
     muxer_.stop();
     // Disable voltage translator
     modemSetUartState(false);
@@ -355,7 +452,17 @@ int SaraNcpClient::updateFirmware(InputStream* file, size_t size) {
 }
 
 int SaraNcpClient::dataChannelWrite(int id, const uint8_t* data, size_t size) {
-    int err = muxer_.writeChannel(UBLOX_NCP_PPP_CHANNEL, data, size);
+    if (psmActive_) {
+        // Wake the modem up from PSM. The registration and the PDP context are retained
+        modemPowerOn();
+    }
+    int err = muxerTx_.writeChannel(UBLOX_NCP_PPP_CHANNEL, data, size);
+
+    if (err == gsm0710::GSM0710_ERROR_FLOW_CONTROL) {
+        // The modem has asked us to stop sending on this channel (MSC FC bit), drop the packet
+        // and let the upper layers retransmit it once the channel is resumed
+        return err;
+    }
 
     if (err) {
         // Make sure we are going into an error state if muxer for some reason fails
@@ -371,6 +478,10 @@ void SaraNcpClient::processEvents() {
     processEventsImpl();
 }
 
+bool SaraNcpClient::isSessionResumable() {
+    return savedModemState(ncpId(), conf_.simType()) && modemPowerState();
+}
+
 int SaraNcpClient::ncpId() const {
     return conf_.ncpIdentifier();
 }
@@ -381,6 +492,9 @@ int SaraNcpClient::connect(const CellularNetworkConfig& conf) {
     CHECK(checkParser());
 
     resetRegistrationState();
+    lastOper_ = conf.lastOperator();
+    lastOperAct_ = conf.lastOperatorAct();
+    operSaved_ = false;
     CHECK(configureApn(conf));
     CHECK(registerNet());
 
@@ -409,6 +523,18 @@ int SaraNcpClient::getIccid(char* buf, size_t size) {
     return n;
 }
 
+int SaraNcpClient::getNetworkTime(time_t* time) {
+    const NcpClientLock lock(this);
+    CHECK(checkParser());
+    auto resp = parser_.sendCommand("AT+CCLK?");
+    char str[32] = {};
+    int r = CHECK_PARSER(resp.scanf("+CCLK: \"%31[^\"]\"", str));
+    CHECK_TRUE(r == 1, SYSTEM_ERROR_AT_RESPONSE_UNEXPECTED);
+    CHECK_PARSER_OK(resp.readResult());
+    CHECK_TRUE(parseNetworkTime(str, time), SYSTEM_ERROR_NOT_FOUND);
+    return 0;
+}
+
 int SaraNcpClient::getImei(char* buf, size_t size) {
     const NcpClientLock lock(this);
     CHECK(checkParser());
@@ -469,16 +595,29 @@ int SaraNcpClient::queryAndParseAtCops(CellularSignalQuality* qual) {
     if (qual) {
         qual->accessTechnology(static_cast<CellularAccessTechnology>(act));
     }
+    copsTime_ = millis();
+    copsValid_ = true;
 
     return SYSTEM_ERROR_NONE;
 }
 
+bool SaraNcpClient::isNetworkInfoValid(bool valid, system_tick_t time) const {
+    return valid && millis() - time < conf_.networkInfoMaxAge();
+}
+
+void SaraNcpClient::invalidateNetworkInfo() {
+    sigQualValid_ = false;
+    copsValid_ = false;
+}
+
 int SaraNcpClient::getCellularGlobalIdentity(CellularGlobalIdentity* cgi) {
     const NcpClientLock lock(this);
     CHECK_TRUE(connState_ != NcpConnectionState::DISCONNECTED, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(cgi, SYSTEM_ERROR_INVALID_ARGUMENT);
-    CHECK(checkParser());
-    CHECK(queryAndParseAtCops(nullptr));
+    if (!isNetworkInfoValid(copsValid_, copsTime_)) {
+        CHECK(checkParser());
+        CHECK(queryAndParseAtCops(nullptr));
+    }
 
     switch (cgi->version)
     {
@@ -502,6 +641,10 @@ int SaraNcpClient::getSignalQuality(CellularSignalQuality* qual) {
     const NcpClientLock lock(this);
     CHECK_TRUE(connState_ != NcpConnectionState::DISCONNECTED, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(qual, SYSTEM_ERROR_INVALID_ARGUMENT);
+    if (isNetworkInfoValid(sigQualValid_, sigQualTime_)) {
+        *qual = sigQual_;
+        return 0;
+    }
     CHECK(checkParser());
     CHECK(queryAndParseAtCops(qual));
 
@@ -615,6 +758,10 @@ int SaraNcpClient::getSignalQuality(CellularSignalQuality* qual) {
         }
     }
 
+    sigQual_ = *qual;
+    sigQualTime_ = millis();
+    sigQualValid_ = true;
+
     return 0;
 }
 
@@ -656,6 +803,11 @@ int SaraNcpClient::waitReady() {
     if (ready_) {
         return 0;
     }
+    if (resumeSession() == 0) {
+        ready_ = true;
+        return 0;
+    }
+    invalidateModemState();
     muxer_.stop();
     CHECK(serial_->setBaudRate(UBLOX_NCP_DEFAULT_SERIAL_BAUDRATE));
     CHECK(initParser(serial_.get()));
@@ -678,6 +830,9 @@ int SaraNcpClient::waitReady() {
         if (r != SYSTEM_ERROR_NONE) {
             LOG(ERROR, "Failed to perform early initialization");
             ready_ = false;
+        } else {
+            saveModemState((ncpId() != PLATFORM_NCP_SARA_R410) ? UBLOX_NCP_RUNTIME_SERIAL_BAUDRATE_U2 :
+                    UBLOX_NCP_DEFAULT_SERIAL_BAUDRATE, ncpId(), conf_.simType(), memoryIssuePresent_);
         }
     } else {
         LOG(ERROR, "No response from NCP");
@@ -807,6 +962,8 @@ int SaraNcpClient::changeBaudRate(unsigned int baud) {
 }
 
 int SaraNcpClient::initReady() {
+    psmActive_ = false;
+
     // Select either internal or external SIM card slot depending on the configuration
     CHECK(selectSimCard());
 
@@ -814,6 +971,9 @@ int SaraNcpClient::initReady() {
     // (allows the capture of `mcc` and `mnc`)
     int r = CHECK_PARSER(parser_.execCommand("AT+COPS=3,2"));
 
+    // Let the network update the modem's clock (NITZ)
+    CHECK_PARSER(parser_.execCommand("AT+CTZU=1"));
+
     if (conf_.ncpIdentifier() != PLATFORM_NCP_SARA_R410) {
         // Change the baudrate to 921600
         CHECK(changeBaudRate(UBLOX_NCP_RUNTIME_SERIAL_BAUDRATE_U2));
@@ -883,33 +1043,7 @@ int SaraNcpClient::initReady() {
             }
         }
 
-        // Force eDRX mode to be disabled. AT+CEDRXS=0 doesn't seem disable eDRX completely, so
-        // so we're disabling it for each reported RAT individually
-        Vector<unsigned> acts;
-        resp = parser_.sendCommand("AT+CEDRXS?");
-        while (resp.hasNextLine()) {
-            unsigned act = 0;
-            r = resp.scanf("+CEDRXS: %u", &act);
-            if (r == 1) { // Ignore scanf() errors
-                CHECK_TRUE(acts.append(act), SYSTEM_ERROR_NO_MEMORY);
-            }
-        }
-        CHECK_PARSER_OK(resp.readResult());
-        int lastError = AtResponse::OK;
-        for (unsigned act: acts) {
-            // This command may fail for unknown reason. eDRX mode is a persistent setting and, eventually,
-            // it will get applied for each RAT during subsequent re-initialization attempts
-            r = CHECK_PARSER(parser_.execCommand("AT+CEDRXS=3,%u", act)); // 3: Disable the use of eDRX
-            if (r != AtResponse::OK) {
-                lastError = r;
-            }
-        }
-        CHECK_PARSER_OK(lastError);
-        // Force Power Saving mode to be disabled
-        //
-        // TODO: if we enable this feature in the future add logic to CHECK_PARSER macro(s)
-        // to wait longer for device to become active (see MDMParser::_atOk)
-        CHECK_PARSER_OK(parser_.execCommand("AT+CPSMS=0"));
+        CHECK(configurePowerSaving());
     } else {
         // Force Power Saving mode to be disabled
         //
@@ -922,6 +1056,10 @@ int SaraNcpClient::initReady() {
     r = CHECK_PARSER(parser_.execCommand("AT+CMUX=0,0,,1509,,,,,"));
     CHECK_TRUE(r == AtResponse::OK, SYSTEM_ERROR_AT_NOT_OK);
 
+    return startMuxer();
+}
+
+int SaraNcpClient::startMuxer() {
     // Initialize muxer
     muxer_.setStream(serial_.get());
     muxer_.setMaxFrameSize(UBLOX_NCP_MAX_MUXER_FRAME_SIZE);
@@ -974,18 +1112,55 @@ int SaraNcpClient::initReady() {
     return 0;
 }
 
+int SaraNcpClient::resumeSession() {
+    if (!isSessionResumable()) {
+        g_modemStateChecked = true;
+        return SYSTEM_ERROR_NOT_FOUND;
+    }
+    // Only the first attempt to bring up the modem after a reset may resume the session
+    const ModemState state = g_modemState;
+    g_modemStateChecked = true;
+    invalidateModemState();
+    LOG(TRACE, "Resuming modem session");
+    memoryIssuePresent_ = state.memoryIssuePresent;
+    const auto baudRate = state.baudRate;
+    CHECK(serial_->setBaudRate(baudRate));
+    // Enable voltage translator
+    CHECK(modemSetUartState(true));
+    skipAll(serial_.get(), 100);
+    parser_.reset();
+    // The modem is still expected to be in the multiplexing mode. If it's not, the muxer fails to
+    // start and the modem is initialized as usual
+    NAMED_SCOPE_GUARD(sg, {
+        LOG(WARN, "Unable to resume modem session");
+        modemSetUartState(false);
+    });
+    CHECK(startMuxer());
+    sg.dismiss();
+    powerOnTime_ = millis();
+    registeredTime_ = 0;
+    parserError_ = 0;
+    psmActive_ = false;
+    saveModemState(baudRate, ncpId(), conf_.simType(), memoryIssuePresent_);
+    LOG(INFO, "Resumed modem session");
+    return 0;
+}
+
 int SaraNcpClient::checkSimCard() {
-    auto resp = parser_.sendCommand("AT+CPIN?");
+    // Query the SIM state and read the ICCID in a single command line
     char code[33] = {};
-    int r = CHECK_PARSER(resp.scanf("+CPIN: %32[^\n]", code));
-    CHECK_TRUE(r == 1, SYSTEM_ERROR_AT_RESPONSE_UNEXPECTED);
-    r = CHECK_PARSER(resp.readResult());
+    const AtParser::BatchCommand cmds[] = {
+        { "+CPIN?", "+CPIN:", [](const char* line, void* data) {
+            return (::sscanf(line, "+CPIN: %32[^\n]", (char*)data) == 1) ? 0 : SYSTEM_ERROR_AT_RESPONSE_UNEXPECTED;
+        }, code },
+        { "+CCID", "+CCID:", nullptr, nullptr }
+    };
+    const int r = CHECK_PARSER(parser_.execBatch(cmds, sizeof(cmds) / sizeof(cmds[0])));
     CHECK_TRUE(r == AtResponse::OK, SYSTEM_ERROR_AT_NOT_OK);
     if (!strcmp(code, "READY")) {
-        r = parser_.execCommand("AT+CCID");
-        CHECK_TRUE(r == AtResponse::OK, SYSTEM_ERROR_AT_NOT_OK);
         return 0;
     }
+    CHECK_TRUE(code[0] != '\0', SYSTEM_ERROR_AT_RESPONSE_UNEXPECTED);
     return SYSTEM_ERROR_UNKNOWN;
 }
 
@@ -1014,15 +1189,91 @@ int SaraNcpClient::setRegistrationTimeout(unsigned timeout) {
     return 0;
 }
 
+int SaraNcpClient::configurePowerSaving() {
+    if (powerSaving_.flags & CELLULAR_POWER_SAVING_FLAG_EDRX) {
+        char cycle[5] = {};
+        formatTimerBits(encodeEdrxCycle(powerSaving_.edrx_cycle), 4, cycle);
+        // 2: Enable the use of eDRX and the +CEDRXP URC, 4: E-UTRAN
+        CHECK_PARSER_OK(parser_.execCommand("AT+CEDRXS=2,4,\"%s\"", cycle));
+    } else {
+        // Force eDRX mode to be disabled. AT+CEDRXS=0 doesn't seem disable eDRX completely, so
+        // so we're disabling it for each reported RAT individually
+        Vector<unsigned> acts;
+        auto resp = parser_.sendCommand("AT+CEDRXS?");
+        while (resp.hasNextLine()) {
+            unsigned act = 0;
+            const int r = resp.scanf("+CEDRXS: %u", &act);
+            if (r == 1) { // Ignore scanf() errors
+                CHECK_TRUE(acts.append(act), SYSTEM_ERROR_NO_MEMORY);
+            }
+        }
+        CHECK_PARSER_OK(resp.readResult());
+        int lastError = AtResponse::OK;
+        for (unsigned act: acts) {
+            // This command may fail for unknown reason. eDRX mode is a persistent setting and, eventually,
+            // it will get applied for each RAT during subsequent re-initialization attempts
+            const int r = CHECK_PARSER(parser_.execCommand("AT+CEDRXS=3,%u", act)); // 3: Disable the use of eDRX
+            if (r != AtResponse::OK) {
+                lastError = r;
+            }
+        }
+        CHECK_PARSER_OK(lastError);
+        powerSavingGranted_.flags &= ~CELLULAR_POWER_SAVING_FLAG_EDRX;
+    }
+    if (powerSaving_.flags & CELLULAR_POWER_SAVING_FLAG_PSM) {
+        char tau[9] = {};
+        char activeTime[9] = {};
+        formatTimerBits(encodePeriodicTau(powerSaving_.periodic_tau), 8, tau);
+        formatTimerBits(encodeActiveTime(powerSaving_.active_time), 8, activeTime);
+        CHECK_PARSER_OK(parser_.execCommand("AT+CPSMS=1,,,\"%s\",\"%s\"", tau, activeTime));
+        // Enable the +UUPSMR URC. Older firmware versions don't support this command
+        CHECK_PARSER(parser_.execCommand("AT+UPSMR=1"));
+    } else {
+        // Force Power Saving mode to be disabled
+        CHECK_PARSER_OK(parser_.execCommand("AT+CPSMS=0"));
+        powerSavingGranted_.flags &= ~CELLULAR_POWER_SAVING_FLAG_PSM;
+    }
+    return 0;
+}
+
+int SaraNcpClient::setPowerSaving(const cellular_power_saving_config& conf) {
+    const NcpClientLock lock(this);
+    CHECK_TRUE(conf_.ncpIdentifier() == PLATFORM_NCP_SARA_R410, SYSTEM_ERROR_NOT_SUPPORTED);
+    powerSaving_ = conf;
+    if (ncpState_ == NcpState::ON) {
+        CHECK(checkParser());
+        CHECK(configurePowerSaving());
+        if (connState_ != NcpConnectionState::DISCONNECTED) {
+            // Report the granted timers
+            const auto mode = (powerSaving_.flags & CELLULAR_POWER_SAVING_FLAG_PSM) ? 4 : 2;
+            CHECK_PARSER_OK(parser_.execCommand("AT+CEREG=%d", mode));
+        }
+    }
+    return 0;
+}
+
+int SaraNcpClient::getPowerSaving(cellular_power_saving_config* conf) {
+    const NcpClientLock lock(this);
+    CHECK_TRUE(conf_.ncpIdentifier() == PLATFORM_NCP_SARA_R410, SYSTEM_ERROR_NOT_SUPPORTED);
+    const auto size = conf->size;
+    *conf = powerSavingGranted_;
+    conf->size = size;
+    return 0;
+}
+
 int SaraNcpClient::registerNet() {
     int r = 0;
     if (conf_.ncpIdentifier() != PLATFORM_NCP_SARA_R410) {
-        r = CHECK_PARSER(parser_.execCommand("AT+CREG=2"));
-        CHECK_TRUE(r == AtResponse::OK, SYSTEM_ERROR_AT_NOT_OK);
-        r = CHECK_PARSER(parser_.execCommand("AT+CGREG=2"));
+        const AtParser::BatchCommand cmds[] = {
+            { "+CREG=2", nullptr, nullptr, nullptr },
+            { "+CGREG=2", nullptr, nullptr, nullptr }
+        };
+        r = CHECK_PARSER(parser_.execBatch(cmds, sizeof(cmds) / sizeof(cmds[0])));
         CHECK_TRUE(r == AtResponse::OK, SYSTEM_ERROR_AT_NOT_OK);
     } else {
-        r = CHECK_PARSER(parser_.execCommand("AT+CEREG=2"));
+        // Mode 4 also reports the PSM timers granted by the network
+        const auto mode = (powerSaving_.flags & CELLULAR_POWER_SAVING_FLAG_PSM) ? 4 : 2;
+        r = CHECK_PARSER(parser_.execCommand("AT+CEREG=%d", mode));
         CHECK_TRUE(r == AtResponse::OK, SYSTEM_ERROR_AT_NOT_OK);
     }
 
@@ -1031,14 +1282,30 @@ int SaraNcpClient::registerNet() {
 
     // NOTE: up to 3 mins (FIXME: there seems to be a bug where this timeout of 3 minutes
     //       is not being respected by u-blox modems.  Setting to 5 for now.)
-    r = CHECK_PARSER(parser_.execCommand(5 * 60 * 1000, "AT+COPS=0,2"));
-    // Ignore response code here
-    // CHECK_TRUE(r == AtResponse::OK, SYSTEM_ERROR_AT_NOT_OK);
+    const unsigned copsTimeout = 5 * 60 * 1000;
+    r = AtResponse::ERROR;
+    if (lastOper_ && *lastOper_) {
+        // Try the operator the device was registered with last time, which spares the modem a scan
+        // of all bands. In mode 4, the modem falls back to the automatic selection by itself if
+        // the operator is not available
+        if (lastOperAct_ >= 0) {
+            r = CHECK_PARSER(parser_.execCommand(copsTimeout, "AT+COPS=4,2,\"%s\",%d", (const char*)lastOper_,
+                    lastOperAct_));
+        } else {
+            r = CHECK_PARSER(parser_.execCommand(copsTimeout, "AT+COPS=4,2,\"%s\"", (const char*)lastOper_));
+        }
+        if (r != AtResponse::OK) {
+            LOG(TRACE, "Unable to select operator %s", (const char*)lastOper_);
+        }
+    }
+    if (r != AtResponse::OK) {
+        r = CHECK_PARSER(parser_.execCommand(copsTimeout, "AT+COPS=0,2"));
+        // Ignore response code here
+        // CHECK_TRUE(r == AtResponse::OK, SYSTEM_ERROR_AT_NOT_OK);
+    }
 
     if (conf_.ncpIdentifier() != PLATFORM_NCP_SARA_R410) {
-        r = CHECK_PARSER(parser_.execCommand("AT+CREG?"));
-        CHECK_TRUE(r == AtResponse::OK, SYSTEM_ERROR_AT_NOT_OK);
-        r = CHECK_PARSER(parser_.execCommand("AT+CGREG?"));
+        r = CHECK_PARSER(queryRegistrationState());
         CHECK_TRUE(r == AtResponse::OK, SYSTEM_ERROR_AT_NOT_OK);
     } else {
         r = CHECK_PARSER(parser_.execCommand("AT+CEREG?"));
@@ -1051,6 +1318,25 @@ int SaraNcpClient::registerNet() {
     return 0;
 }
 
+int SaraNcpClient::saveOperator() {
+    CellularSignalQuality qual;
+    CHECK(queryAndParseAtCops(&qual));
+    char oper[8] = {};
+    snprintf(oper, sizeof(oper), (cgi_.cgi_flags & CGI_FLAG_TWO_DIGIT_MNC) ? "%03u%02u" : "%03u%03u",
+            (unsigned)cgi_.mobile_country_code, (unsigned)cgi_.mobile_network_code);
+    CHECK(CellularNetworkManager::setLastOperator(conf_.simType(), oper, (int)qual.accessTechnology()));
+    return 0;
+}
+
+int SaraNcpClient::queryRegistrationState() {
+    // The responses are processed by the URC handlers
+    const AtParser::BatchCommand cmds[] = {
+        { "+CREG?", "+CREG:", nullptr, nullptr },
+        { "+CGREG?", "+CGREG:", nullptr, nullptr }
+    };
+    return parser_.execBatch(cmds, sizeof(cmds) / sizeof(cmds[0]));
+}
+
 void SaraNcpClient::ncpState(NcpState state) {
     if (ncpState_ == NcpState::DISABLED) {
         return;
@@ -1084,6 +1370,7 @@ void SaraNcpClient::connectionState(NcpConnectionState state) {
     }
     LOG(TRACE, "NCP connection state changed: %d", (int)state);
     connState_ = state;
+    invalidateNetworkInfo();
 
     if (connState_ == NcpConnectionState::CONNECTED) {
         // Open data channel
@@ -1179,6 +1466,20 @@ int SaraNcpClient::processEventsImpl() {
     CHECK_TRUE(ncpState_ == NcpState::ON, SYSTEM_ERROR_INVALID_STATE);
     parser_.processUrc(); // Ignore errors
     checkRegistrationState();
+    if (psmActive_) {
+        // The modem can't be queried while in PSM
+        regCheckTime_ = millis();
+        regStartTime_ = regCheckTime_;
+        return 0;
+    }
+    if (connState_ == NcpConnectionState::CONNECTED && !operSaved_) {
+        // Remember the operator for the next power-up
+        operSaved_ = true;
+        const int r = saveOperator();
+        if (r < 0) {
+            LOG(WARN, "Unable to save operator: %d", r);
+        }
+    }
     if (connState_ != NcpConnectionState::CONNECTING ||
             millis() - regCheckTime_ < REGISTRATION_CHECK_INTERVAL) {
         return 0;
@@ -1187,8 +1488,7 @@ int SaraNcpClient::processEventsImpl() {
         regCheckTime_ = millis();
     });
     if (conf_.ncpIdentifier() != PLATFORM_NCP_SARA_R410) {
-        CHECK_PARSER_OK(parser_.execCommand("AT+CREG?"));
-        CHECK_PARSER_OK(parser_.execCommand("AT+CGREG?"));
+        CHECK_PARSER_OK(queryRegistrationState());
     } else {
         CHECK_PARSER_OK(parser_.execCommand("AT+CEREG?"));
     }
@@ -1291,6 +1591,7 @@ int SaraNcpClient::modemPowerOff() {
         }
     });
 
+    invalidateModemState();
     if (modemPowerState()) {
         LOG(TRACE, "Powering modem off");
         // Important! We need to disable voltage translator here
@@ -1340,6 +1641,7 @@ int SaraNcpClient::modemPowerOff() {
 }
 
 int SaraNcpClient::modemHardReset(bool powerOff) {
+    invalidateModemState();
     const auto pwrState = modemPowerState();
     // We can only reset the modem in the powered state
     if (!pwrState) {
@@ -26,6 +26,7 @@
 
 #include "spark_wiring_thread.h"
 #include "gsm0710muxer/channel_stream.h"
+#include "gsm0710muxer/tx_scheduler.h"
 #include "static_recursive_mutex.h"
 
 namespace particle {
@@ -64,6 +65,10 @@ public:
     virtual int getImei(char* buf, size_t size) override;
     virtual int getSignalQuality(CellularSignalQuality* qual) override;
     virtual int setRegistrationTimeout(unsigned timeout) override;
+    virtual int setPowerSaving(const cellular_power_saving_config& conf) override;
+    virtual int getPowerSaving(cellular_power_saving_config* conf) override;
+    virtual int getNetworkTime(time_t* time) override;
+    virtual bool isSessionResumable() override;
 
 private:
     AtParser parser_;
@@ -76,9 +81,13 @@ private:
     int parserError_ = 0;
     bool ready_ = false;
     gsm0710::Muxer<particle::Stream, StaticRecursiveMutex> muxer_;
-    std::unique_ptr<particle::MuxerChannelStream<decltype(muxer_)> > muxerAtStream_;
+    particle::MuxerTxScheduler<decltype(muxer_)> muxerTx_{&muxer_};
+    std::unique_ptr<particle::MuxerChannelStream<decltype(muxerTx_)> > muxerAtStream_;
     CellularNetworkConfig netConf_;
     CellularGlobalIdentity cgi_ = {};
+    CString lastOper_; // Operator of the last successful registration
+    int lastOperAct_ = -1;
+    bool operSaved_ = false;
 
     enum class RegistrationState {
         NotRegistered = 0,
@@ -94,17 +103,32 @@ private:
     system_tick_t powerOnTime_;
     bool memoryIssuePresent_ = false;
     unsigned registrationTimeout_;
+    CellularSignalQuality sigQual_;
+    system_tick_t sigQualTime_ = 0;
+    system_tick_t copsTime_ = 0;
+    bool sigQualValid_ = false;
+    bool copsValid_ = false;
+    cellular_power_saving_config powerSaving_ = {}; // Requested settings
+    cellular_power_saving_config powerSavingGranted_ = {}; // Settings granted by the network
+    volatile bool psmActive_ = false;
 
     int queryAndParseAtCops(CellularSignalQuality* qual);
+    bool isNetworkInfoValid(bool valid, system_tick_t time) const;
+    void invalidateNetworkInfo();
     int initParser(Stream* stream);
     int checkParser();
     int waitReady();
     int initReady();
+    int startMuxer();
+    int resumeSession();
     int waitAtResponse(unsigned int timeout, unsigned int period = 1000);
     int selectSimCard();
     int checkSimCard();
     int configureApn(const CellularNetworkConfig& conf);
     int registerNet();
+    int saveOperator();
+    int configurePowerSaving();
+    int queryRegistrationState();
     int changeBaudRate(unsigned int baud);
     static int muxChannelStateCb(uint8_t channel, decltype(muxer_)::ChannelState oldState,
             decltype(muxer_)::ChannelState newState, void* ctx);
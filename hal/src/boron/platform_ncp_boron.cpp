@@ -18,6 +18,10 @@
 #include "platform_ncp.h"
 
 #include "exflash_hal.h"
+#include "pinmap_hal.h"
+#include "gpio_hal.h"
+#include "delay_hal.h"
+#include "hal_irq_flag.h"
 
 #include "dct.h"
 
@@ -51,3 +55,49 @@ PlatformNCPIdentifier platform_current_ncp_identifier() {
     }
     return (PlatformNCPIdentifier)ncpId;
 }
+
+#if HAL_PLATFORM_NCP_EARLY_POWER_ON
+
+int platform_ncp_early_power_on(void) {
+    const auto ncpId = platform_current_ncp_identifier();
+    if (ncpId == PLATFORM_NCP_UNKNOWN) {
+        return -1;
+    }
+    hal_gpio_config_t conf = {
+        .size = sizeof(conf),
+        .version = 0,
+        .mode = OUTPUT,
+        .set_value = true,
+        .value = 1
+    };
+    // Same pin configuration as in SaraNcpClient::modemInit(), the voltage translator is kept disabled
+    HAL_Pin_Configure(UBPWR, &conf);
+    HAL_Pin_Configure(UBRST, &conf);
+    HAL_Pin_Configure(BUFEN, &conf);
+    conf.mode = INPUT;
+    HAL_Pin_Configure(UBVINT, &conf);
+    if (HAL_GPIO_Read(UBVINT)) {
+        // Already on
+        return 0;
+    }
+    // Same power-on sequence as in SaraNcpClient::modemPowerOn(). SaraNcpClient::on() then
+    // finds the modem powered and only waits for it to become ready
+    if (ncpId != PLATFORM_NCP_SARA_R410) {
+        // U201
+        // Low pulse 50-80us
+        int32_t state = HAL_disable_irq();
+        HAL_GPIO_Write(UBPWR, 0);
+        HAL_Delay_Microseconds(50);
+        HAL_GPIO_Write(UBPWR, 1);
+        HAL_enable_irq(state);
+    } else {
+        // R410
+        // Low pulse 150-3200ms. The scheduler is not running yet, so busy-wait here
+        HAL_GPIO_Write(UBPWR, 0);
+        HAL_Delay_Microseconds(150000);
+        HAL_GPIO_Write(UBPWR, 1);
+    }
+    return 0;
+}
+
+#endif // HAL_PLATFORM_NCP_EARLY_POWER_ON
@@ -387,6 +387,18 @@ cellular_result_t cellular_registration_timeout_set(system_tick_t timeout, void*
     return SYSTEM_ERROR_NOT_SUPPORTED;
 }
 
+int cellular_power_saving_set(const cellular_power_saving_config* conf, void* reserved) {
+    return SYSTEM_ERROR_NOT_SUPPORTED;
+}
+
+int cellular_power_saving_get(cellular_power_saving_config* conf, void* reserved) {
+    return SYSTEM_ERROR_NOT_SUPPORTED;
+}
+
+int cellular_network_time(time_t* time, void* reserved) {
+    return SYSTEM_ERROR_NOT_SUPPORTED;
+}
+
 cellular_result_t cellular_sms_received_handler_set(_CELLULAR_SMS_CB_MDM cb, void* data,
                                                     void* reserved)
 {
@@ -68,7 +68,7 @@ IDX[x] = added IRQ handler
 15 [x] SysTick_Handler
                                          // External Interrupts ----------------
 16 [ ] WWDG_IRQHandler                   // Window WatchDog
-17 [ ] PVD_IRQHandler                    // PVD through EXTI Line detection
+17 [x] PVD_IRQHandler                    // PVD through EXTI Line detection
 18 [ ] TAMP_STAMP_IRQHandler             // Tamper and TimeStamps through the EXTI line
 19 [ ] RTC_WKUP_IRQHandler               // RTC Wakeup through the EXTI line
 20 [ ] FLASH_IRQHandler                  // FLASH
@@ -78,13 +78,13 @@ IDX[x] = added IRQ handler
 24 [x] EXTI2_IRQHandler                  // EXTI Line2
 25 [x] EXTI3_IRQHandler                  // EXTI Line3
 26 [x] EXTI4_IRQHandler                  // EXTI Line4
-27 [ ] DMA1_Stream0_IRQHandler           // DMA1 Stream 0
+27 [x] DMA1_Stream0_IRQHandler           // DMA1 Stream 0
 28 [ ] DMA1_Stream1_IRQHandler           // DMA1 Stream 1
 29 [x] DMA1_Stream2_IRQHandler           // DMA1 Stream 2
 30 [ ] DMA1_Stream3_IRQHandler           // DMA1 Stream 3
-31 [ ] DMA1_Stream4_IRQHandler           // DMA1 Stream 4
-32 [ ] DMA1_Stream5_IRQHandler           // DMA1 Stream 5
-33 [ ] DMA1_Stream6_IRQHandler           // DMA1 Stream 6
+31 [x] DMA1_Stream4_IRQHandler           // DMA1 Stream 4
+32 [x] DMA1_Stream5_IRQHandler           // DMA1 Stream 5
+33 [x] DMA1_Stream6_IRQHandler           // DMA1 Stream 6
 34 [x] ADC_IRQHandler                    // ADC1, ADC2 and ADC3s
 35 [x] CAN1_TX_IRQHandler                // CAN1 TX
 36 [x] CAN1_RX0_IRQHandler               // CAN1 RX0
@@ -137,7 +137,7 @@ IDX[x] = added IRQ handler
 83 [x] OTG_FS_IRQHandler                 // USB OTG FS
 84 [x] DMA2_Stream5_IRQHandler           // DMA2 Stream 5
 85 [ ] DMA2_Stream6_IRQHandler           // DMA2 Stream 6
-86 [ ] DMA2_Stream7_IRQHandler           // DMA2 Stream 7
+86 [x] DMA2_Stream7_IRQHandler           // DMA2 Stream 7
 87 [ ] USART6_IRQHandler                 // USART6
 88 [x] I2C3_EV_IRQHandler                // I2C3 event
 89 [x] I2C3_ER_IRQHandler                // I2C3 error
@@ -488,18 +488,17 @@ void EXTI15_10_IRQHandler(void)
  * which interrupt we are not currently handling.
  */
 void WWDG_IRQHandler(void)          {__ASM("bkpt 0");}
-void PVD_IRQHandler(void)           {__ASM("bkpt 0");}
 void TAMP_STAMP_IRQHandler(void)    {__ASM("bkpt 0");}
 void RTC_WKUP_IRQHandler(void)      {__ASM("bkpt 0");}
 void FLASH_IRQHandler(void)         {__ASM("bkpt 0");}
 void RCC_IRQHandler(void)           {__ASM("bkpt 0");}
-void DMA1_Stream0_IRQHandler(void)  {__ASM("bkpt 0");}
+//void DMA1_Stream0_IRQHandler(void)  {__ASM("bkpt 0");}
 void DMA1_Stream1_IRQHandler(void)  {__ASM("bkpt 0");}
 //void DMA1_Stream2_IRQHandler(void)  {__ASM("bkpt 0");}
 void DMA1_Stream3_IRQHandler(void)  {__ASM("bkpt 0");}
-void DMA1_Stream4_IRQHandler(void)  {__ASM("bkpt 0");}
-void DMA1_Stream5_IRQHandler(void)  {__ASM("bkpt 0");}
-void DMA1_Stream6_IRQHandler(void)  {__ASM("bkpt 0");}
+//void DMA1_Stream4_IRQHandler(void)  {__ASM("bkpt 0");}
+//void DMA1_Stream5_IRQHandler(void)  {__ASM("bkpt 0");}
+//void DMA1_Stream6_IRQHandler(void)  {__ASM("bkpt 0");}
 void I2C2_EV_IRQHandler(void)       {__ASM("bkpt 0");}
 void I2C2_ER_IRQHandler(void)       {__ASM("bkpt 0");}
 void SPI1_IRQHandler(void)          {__ASM("bkpt 0");}
@@ -516,7 +515,7 @@ void DMA2_Stream4_IRQHandler(void)  {__ASM("bkpt 0");}
 void ETH_IRQHandler(void)           {__ASM("bkpt 0");}
 void ETH_WKUP_IRQHandler(void)      {__ASM("bkpt 0");}
 void DMA2_Stream6_IRQHandler(void)  {__ASM("bkpt 0");}
-void DMA2_Stream7_IRQHandler(void)  {__ASM("bkpt 0");}
+//void DMA2_Stream7_IRQHandler(void)  {__ASM("bkpt 0");}
 void USART6_IRQHandler(void)        {__ASM("bkpt 0");}
 void DCMI_IRQHandler(void)          {__ASM("bkpt 0");}
 void CRYP_IRQHandler(void)          {__ASM("bkpt 0");}
@@ -55,6 +55,20 @@ int dct_write_app_data(const void* data, uint32_t offset, uint32_t size) {
     return result;
 }
 
+int dct_begin_transaction() {
+    dct_lock(1);
+    dcd().begin();
+    dct_unlock(1);
+    return 0;
+}
+
+int dct_commit_transaction() {
+    dct_lock(1);
+    const int result = dcd().commit();
+    dct_unlock(1);
+    return result;
+}
+
 void dcd_migrate_data() {
     dct_lock(1);
     dcd().migrate();
@@ -156,6 +156,26 @@ AcT toCellularAccessTechnology(int rat) {
     }
 }
 
+// Parses "<prefix><socket>,<length>" without sscanf(). Returns a pointer to the character
+// following the length, or nullptr if the string doesn't match
+const char* parseSocketLength(const char* str, const char* prefix, int* socket, int* length) {
+    const size_t n = strlen(prefix);
+    if (strncmp(str, prefix, n) != 0) {
+        return nullptr;
+    }
+    char* end = nullptr;
+    *socket = strtol(str + n, &end, 10);
+    if (end == str + n || *end != ',') {
+        return nullptr;
+    }
+    str = end + 1;
+    *length = strtol(str, &end, 10);
+    if (end == str) {
+        return nullptr;
+    }
+    return end;
+}
+
 } // anonymous
 
 #ifdef MDM_DEBUG
@@ -257,6 +277,13 @@ MDMParser::MDMParser(void)
     memset(_sockets, 0, sizeof(_sockets));
     for (int socket = 0; socket < NUMSOCKETS; socket ++)
         _sockets[socket].handle = MDM_SOCKET_ERROR;
+    _rxAheadBuf = nullptr;
+    _rxAheadSocket = MDM_SOCKET_ERROR;
+    _rxAheadOffs = 0;
+    _rxAheadLen = 0;
+    _txBuf = nullptr;
+    _txSocket = MDM_SOCKET_ERROR;
+    _txLen = 0;
 #ifdef MDM_DEBUG
     _debugLevel = 3;
     _debugTime = HAL_Timer_Get_Milli_Seconds();
@@ -406,6 +433,7 @@ int MDMParser::waitFinalResp(_CALLBACKPTR cb /* = NULL*/,
             // handle unsolicited commands here
             if (type == TYPE_PLUS) {
                 const char* cmd = buf+3; // assume all TYPE_PLUS commands have \r\n+ and skip
+                const char* end = nullptr;
                 int a, b, c, d, r;
                 char s[32];
 
@@ -427,13 +455,15 @@ int MDMParser::waitFinalResp(_CALLBACKPTR cb /* = NULL*/,
                     }
                 // Socket Specific Command ---------------------------------
                 // +USORD: <socket>,<length>
-                } else if ((sscanf(cmd, "USORD: %d,%d", &a, &b) == 2)) {
+                // Note: A response carrying the data is followed by ,"<data>" and doesn't
+                // report the amount of pending data
+                } else if ((end = parseSocketLength(cmd, "USORD: ", &a, &b)) && *end != ',') {
                     int socket = _findSocket(a);
                     MDM_PRINTF("Socket %d: handle %d has %d bytes pending\r\n", socket, a, b);
                     if (socket != MDM_SOCKET_ERROR)
                         _sockets[socket].pending = b;
                 // +UUSORD: <socket>,<length>
-                } else if ((sscanf(cmd, "UUSORD: %d,%d", &a, &b) == 2)) {
+                } else if (parseSocketLength(cmd, "UUSORD: ", &a, &b)) {
                     int socket = _findSocket(a);
                     MDM_PRINTF("Socket %d: handle %d has %d bytes pending\r\n", socket, a, b);
                     if (socket != MDM_SOCKET_ERROR)
@@ -445,7 +475,7 @@ int MDMParser::waitFinalResp(_CALLBACKPTR cb /* = NULL*/,
                     if (socket != MDM_SOCKET_ERROR)
                         _sockets[socket].pending = b;
                 // +UUSORF: <socket>,<length>
-                } else if ((sscanf(cmd, "UUSORF: %d,%d", &a, &b) == 2)) {
+                } else if (parseSocketLength(cmd, "UUSORF: ", &a, &b)) {
                     int socket = _findSocket(a);
                     MDM_PRINTF("Socket %d: handle %d has %d bytes pending\r\n", socket, a, b);
                     if (socket != MDM_SOCKET_ERROR)
@@ -1042,6 +1072,8 @@ void MDMParser::_incModemStateChangeCount(void) {
     for (int socket = 0; socket < NUMSOCKETS; socket ++) {
         _sockets[socket].handle = MDM_SOCKET_ERROR;
     }
+    _rxAheadLen = 0;
+    _txLen = 0;
     UNLOCK();
 }
 
@@ -2540,6 +2572,9 @@ bool MDMParser::socketClose(int socket)
     if (ISSOCKET(socket)
         && (_sockets[socket].connected || _sockets[socket].open))
     {
+        if (_txSocket == socket) {
+            _socketFlushTx();
+        }
         // Check socket type, and use an appropriate timeout. When closing a TCP socket,
         // if the timeout is not respected the AT interface will block further commands.
         int socket_type = _socketCheckType(_sockets[socket].handle);
@@ -2581,6 +2616,12 @@ bool MDMParser::_socketFree(int socket)
             _sockets[socket].connected  = false;
             _sockets[socket].pending    = 0;
             _sockets[socket].open       = false;
+            if (_rxAheadSocket == socket) {
+                _rxAheadLen = 0;
+            }
+            if (_txSocket == socket) {
+                _txLen = 0;
+            }
         }
         ok = true;
     }
@@ -2595,7 +2636,62 @@ bool MDMParser::socketFree(int socket)
     return _socketFree(socket);
 }
 
-int MDMParser::socketSend(int socket, const char * buf, int len)
+int MDMParser::socketSend(int socket, const char * buf, int len, bool more)
+{
+    LOCK();
+    if (_txLen > 0 && _txSocket != socket) {
+        // Write the data of another socket first
+        _socketFlushTx();
+    }
+    if (!more && _txLen == 0) {
+        UNLOCK();
+        return _socketSend(socket, buf, len);
+    }
+    if (!_txBuf) {
+        _txBuf = (char*)malloc(USO_MAX_WRITE);
+        if (!_txBuf) {
+            UNLOCK();
+            return _socketSend(socket, buf, len);
+        }
+    }
+    _txSocket = socket;
+    int cnt = len;
+    while (cnt > 0) {
+        int blk = USO_MAX_WRITE - _txLen;
+        if (cnt < blk) {
+            blk = cnt;
+        }
+        memcpy(_txBuf + _txLen, buf, blk);
+        _txLen += blk;
+        buf += blk;
+        cnt -= blk;
+        if (_txLen == USO_MAX_WRITE && !_socketFlushTx()) {
+            UNLOCK();
+            return MDM_SOCKET_ERROR;
+        }
+    }
+    if (!more && !_socketFlushTx()) {
+        UNLOCK();
+        return MDM_SOCKET_ERROR;
+    }
+    UNLOCK();
+    return len;
+}
+
+bool MDMParser::_socketFlushTx(void)
+{
+    bool ok = true;
+    LOCK();
+    if (_txLen > 0) {
+        const int len = _txLen;
+        _txLen = 0;
+        ok = (_socketSend(_txSocket, _txBuf, len) == len);
+    }
+    UNLOCK();
+    return ok;
+}
+
+int MDMParser::_socketSend(int socket, const char * buf, int len)
 {
     //MDM_PRINTF("socketSend(%d,,%d)\r\n", socket,len);
 #ifndef SOCKET_HEX_MODE
@@ -2642,12 +2738,6 @@ int MDMParser::socketSend(int socket, const char * buf, int len)
         buf += blk;
         cnt -= blk;
     }
-    LOCK();
-    if (ISSOCKET(socket) && (_sockets[socket].pending == 0) && _atOk()) {
-        sendFormated("AT+USORD=%d,0\r\n", _sockets[socket].handle); // TCP
-        waitFinalResp(nullptr, nullptr, USORD_TIMEOUT);
-    }
-    UNLOCK();
     return (len - cnt);
 #else
     int bytesLeft = len;
@@ -2752,12 +2842,6 @@ int MDMParser::socketSendTo(int socket, MDM_IP ip, int port, const char * buf, i
         buf += blk;
         cnt -= blk;
     }
-    LOCK();
-    if (ISSOCKET(socket) && (_sockets[socket].pending == 0) && _atOk()) {
-        sendFormated("AT+USORF=%d,0\r\n", _sockets[socket].handle); // UDP
-        waitFinalResp(nullptr, nullptr, USORF_TIMEOUT);
-    }
-    UNLOCK();
     return (len - cnt);
 #else
     int bytesLeft = len;
@@ -2825,9 +2909,17 @@ int MDMParser::socketReadable(int socket)
         // Allow to receive unsolicited commands.
         // Set to 10ms timeout to mimic previous response when waitFinalResp()
         // contained 10ms busy wait and we used a 0ms timeout value below.
+        if (_txSocket == socket && _txLen > 0 && !_socketFlushTx()) {
+            UNLOCK();
+            return MDM_SOCKET_ERROR;
+        }
         waitFinalResp(nullptr, nullptr, 10);
-        if (_sockets[socket].connected)
+        if (_sockets[socket].connected) {
            pending = _sockets[socket].pending;
+           if (_rxAheadSocket == socket) {
+               pending += _rxAheadLen;
+           }
+        }
     }
     UNLOCK();
     return pending;
@@ -2838,7 +2930,8 @@ int MDMParser::_cbUSORD(int type, const char* buf, int len, USORDparam* param)
 #ifndef SOCKET_HEX_MODE
     if ((type == TYPE_PLUS) && param) {
         int sz, sk;
-        if ((sscanf(buf, "\r\n+USORD: %d,%d,", &sk, &sz) == 2) &&
+        const char* end = (len > 3) ? parseSocketLength(buf + 3 /* \r\n+ */, "USORD: ", &sk, &sz) : nullptr;
+        if (end && *end == ',' && sz >= 0 && sz <= param->size && sz <= len - 2 &&
             (buf[len-sz-2] == '\"') && (buf[len-1] == '\"')) {
             memcpy(param->buf, &buf[len-1-sz], sz);
             param->len = sz;
@@ -2850,8 +2943,8 @@ int MDMParser::_cbUSORD(int type, const char* buf, int len, USORDparam* param)
 #else
     if ((type == TYPE_UNKNOWN || type == TYPE_PLUS) && param) {
         int socket, size;
-        if (sscanf(buf, "+USORD: %d,%d,", &socket, &size) == 2 &&
-                buf[len - size * 2 - 2] == '\"' && buf[len - 1] == '\"') {
+        if (sscanf(buf, "+USORD: %d,%d,", &socket, &size) == 2 && size >= 0 && size <= param->size &&
+                size * 2 + 2 <= len && buf[len - size * 2 - 2] == '\"' && buf[len - 1] == '\"') {
             particle::hexToBytes(buf + len - size * 2 - 1, param->buf, size);
             param->len = size;
         } else {
@@ -2865,6 +2958,7 @@ int MDMParser::_cbUSORD(int type, const char* buf, int len, USORDparam* param)
 int MDMParser::socketRecv(int socket, char* buf, int len)
 {
     int cnt = 0;
+    bool readModem = false;
 /*
     MDM_PRINTF("socketRecv(%d,%d)\r\n", socket, len);
 #ifdef MDM_DEBUG
@@ -2879,12 +2973,22 @@ int MDMParser::socketRecv(int socket, char* buf, int len)
 #else
         int blk = MAX_SIZE / 4;
 #endif
-        if (len < blk) blk = len;
         bool ok = false;
         {
             LOCK();
             if (ISSOCKET(socket)) {
-                if (_sockets[socket].connected) {
+                if (_rxAheadSocket == socket && _rxAheadLen > 0) {
+                    // Serve the data that has been read ahead without a round trip to the modem
+                    if (blk > _rxAheadLen) blk = _rxAheadLen;
+                    if (blk > len) blk = len;
+                    memcpy(buf, _rxAheadBuf + _rxAheadOffs, blk);
+                    _rxAheadOffs += blk;
+                    _rxAheadLen -= blk;
+                    len -= blk;
+                    cnt += blk;
+                    buf += blk;
+                    ok = true;
+                } else if (_sockets[socket].connected) {
                     int available = socketReadable(socket);
                     if (available<0)  {
                         // MDM_PRINTF("socketRecv: SOCKET CLOSED or NO AVAIL DATA\r\n");
@@ -2898,17 +3002,40 @@ int MDMParser::socketRecv(int socket, char* buf, int len)
                     {
                         if (blk > available)    // only read up to the amount available. When 0,
                             blk = available;// skip reading and check timeout.
+                        if (blk > len && !_rxAheadBuf) {
+                            _rxAheadBuf = (char*)malloc(MAX_SIZE);
+                        }
+                        // Read more than requested into the read-ahead buffer, unless another
+                        // socket's data is still buffered there
+                        bool ahead = false;
+                        if (blk > len) {
+                            if (_rxAheadBuf && (_rxAheadSocket == socket || _rxAheadLen == 0)) {
+                                ahead = true;
+                            } else {
+                                blk = len;
+                            }
+                        }
                         if (blk > 0) {
                             // MDM_PRINTF("socketRecv: _cbUSORD\r\n");
                             sendFormated("AT+USORD=%d,%d\r\n",_sockets[socket].handle, blk);
                             USORDparam param;
-                            param.buf = buf;
+                            param.buf = ahead ? _rxAheadBuf : buf;
+                            param.size = blk;
+                            param.len = 0;
+                            readModem = true;
                             if (RESP_OK == waitFinalResp(_cbUSORD, &param)) {
                                 blk = param.len;
                                 _sockets[socket].pending -= blk;
-                                len -= blk;
-                                cnt += blk;
-                                buf += blk;
+                                if (ahead) {
+                                    _rxAheadSocket = socket;
+                                    _rxAheadOffs = 0;
+                                    _rxAheadLen = blk;
+                                    // The data is copied to the caller's buffer in the next iteration
+                                } else {
+                                    len -= blk;
+                                    cnt += blk;
+                                    buf += blk;
+                                }
                                 ok = true;
                             }
                         } else if (!TIMEOUT(start, _sockets[socket].timeout_ms)) {
@@ -2934,7 +3061,8 @@ int MDMParser::socketRecv(int socket, char* buf, int len)
         }
     }
     LOCK();
-    if (ISSOCKET(socket) && (_sockets[socket].pending == 0 && _atOk())) {
+    // Confirm that there's no more data pending, unless all data was served from the read-ahead buffer
+    if (readModem && ISSOCKET(socket) && (_sockets[socket].pending == 0 && _atOk())) {
         sendFormated("AT+USORD=%d,0\r\n", _sockets[socket].handle); // TCP
         waitFinalResp(NULL, NULL, USORD_TIMEOUT);
     }
@@ -239,9 +239,11 @@ public:
         \param socket the socket handle
         \param buf the buffer to write
         \param len the size of the buffer to write
+        \param more true if more data follows: the data may then be held back and
+               written to the modem together with the data of the next call
         \return the size written or SOCKET_ERROR on failure
     */
-    int socketSend(int socket, const char * buf, int len);
+    int socketSend(int socket, const char * buf, int len, bool more = false);
 
     /** Write socket data to a IP
         \param socket the socket handle
@@ -578,7 +580,7 @@ protected:
         }
     };
     static int _cbUSOCTL(int type, const char* buf, int len, Usoctl* usoctl);
-    typedef struct { char* buf; int len; } USORDparam;
+    typedef struct { char* buf; int size; int len; } USORDparam;
     static int _cbUSORD(int type, const char* buf, int len, USORDparam* param);
     typedef struct { char* buf; MDM_IP ip; int port; int len; } USORFparam;
     static int _cbUSORF(int type, const char* buf, int len, USORFparam* param);
@@ -615,6 +617,19 @@ protected:
     // LISA-C has 6 TCP and 6 UDP sockets
     // LISA-U and SARA-G have 7 sockets
     SockCtrl _sockets[7];
+    // Read-ahead buffer for TCP socket data. It is allocated on first use and holds the data
+    // of one socket at a time
+    char* _rxAheadBuf;
+    int _rxAheadSocket;
+    int _rxAheadOffs;
+    int _rxAheadLen;
+    // Buffer coalescing the TCP socket data written with the `more` flag, see socketSend().
+    // It is allocated on first use and holds the data of one socket at a time
+    char* _txBuf;
+    int _txSocket;
+    int _txLen;
+    int _socketSend(int socket, const char * buf, int len);
+    bool _socketFlushTx(void);
     int _findSocket(int handle = MDM_SOCKET_ERROR/* = CREATE*/);
     int _socketCleanupUnusedHandles(void);
     int _socketCloseHandleIfOpen(int socket);
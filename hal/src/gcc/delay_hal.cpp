@@ -18,17 +18,26 @@
 
 #include "delay_hal.h"
 #include "timer_hal.h"
+#include "virtual_time.h"
 
 #include "boost_posix_time_wrap.h"
 #include "boost_thread_wrap.h"
 
 void HAL_Delay_Milliseconds(uint32_t millis)
 {
+    if (virtual_time_enabled()) {
+        virtual_time_advance((uint64_t)millis * 1000);
+        return;
+    }
     boost::this_thread::sleep(boost::posix_time::milliseconds(millis));
 }
 
 void HAL_Delay_Microseconds(uint32_t micros)
 {
+    if (virtual_time_enabled()) {
+        virtual_time_advance(micros);
+        return;
+    }
     boost::this_thread::sleep(boost::posix_time::milliseconds(1));
 }
 
@@ -19,10 +19,19 @@
 #include "device_config.h"
 #include "core_msg.h"
 #include "filesystem.h"
+#include "virtual_time.h"
+#include <algorithm>
 #include <cstdlib>
 #include <fstream>
 #include <istream>
 #include <iostream>
+#include <vector>
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #include "boost_program_options_wrap.h"
 #include <boost/format.hpp>
@@ -85,6 +94,8 @@ public:
         program_options.add_options()
             ("help,h", po::value<string>(&command)->implicit_value(CMD_HELP), "display the available options")
             ("version", po::value<string>(&command)->implicit_value(CMD_VERSION), "display the program version")
+            ("fleet", po::value<string>(&config.fleet_directory), "run one device per subdirectory of the given directory")
+            ("fleet_interval", po::value<unsigned>(&config.fleet_interval)->default_value(100), "delay between starting the fleet devices, in milliseconds")
         ;
 
         static_assert(NO_LOG_LEVEL==70, "need to update the range below.");
@@ -95,6 +106,12 @@ public:
             ("server_key,sk", po::value<string>(&config.server_key)->default_value("server_key.der"), "the filename containing the server public key")
             ("state,s", po::value<string>(&config.periph_directory)->default_value("state"), "the directory where device state and peripherals is stored")
 			("protocol,p", po::value<ProtocolFactory>(&config.protocol)->default_value(PROTOCOL_LIGHTSSL), "the cloud communication protocol to use")
+			("net_rtt", po::value<unsigned>(&config.network.rtt)->default_value(0), "round-trip time of the emulated network link, in milliseconds")
+			("net_jitter", po::value<unsigned>(&config.network.jitter)->default_value(0), "maximum deviation of the one-way delay, in milliseconds")
+			("net_loss", po::value<double>(&config.network.loss)->default_value(0), "percentage of UDP datagrams dropped in either direction")
+			("net_bandwidth", po::value<unsigned>(&config.network.bandwidth)->default_value(0), "bandwidth of the emulated network link, in bytes per second (0 - unlimited)")
+			("net_seed", po::value<unsigned>(&config.network.seed)->default_value(0), "seed of the random number generator used for the jitter and loss")
+			("virtual_time", po::bool_switch(&config.virtual_time), "advance the clock on delays instead of sleeping")
 			;
 
         command_line_options.add(program_options).add(device_options);
@@ -166,6 +183,69 @@ size_t DeviceConfig::hex2bin(const std::string& hex, uint8_t* dest, size_t destL
 }
 
 
+#ifndef _WIN32
+
+/**
+ * Starts a device process for each subdirectory of the fleet directory.
+ *
+ * Every device runs in its own process, since the HAL and system state is global. The device
+ * process changes to its directory, so the device ID and keys are read from the `vdev.conf`
+ * file and the key files in that directory, and the EEPROM image is also kept there. The output
+ * of the device is written to `vdev.log` in the same directory.
+ *
+ * @return `true` in the device process, or `false` in the launching process once all devices
+ *         have exited.
+ */
+bool run_fleet(const string& dir_name, unsigned interval)
+{
+    vector<string> dirs;
+    DIR* dir = opendir(dir_name.c_str());
+    if (!dir) {
+        throw std::invalid_argument("can't open fleet directory: " + dir_name);
+    }
+    while (dirent* entry = readdir(dir)) {
+        const string name = entry->d_name;
+        struct stat st;
+        if (name[0] != '.' && stat((dir_name + "/" + name).c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            dirs.push_back(dir_name + "/" + name);
+        }
+    }
+    closedir(dir);
+    std::sort(dirs.begin(), dirs.end());
+
+    unsigned running = 0;
+    for (const auto& d: dirs) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            if (chdir(d.c_str()) != 0 || !freopen("vdev.log", "a", stdout) || !freopen("vdev.log", "a", stderr)) {
+                _exit(1);
+            }
+            return true;
+        }
+        if (pid < 0) {
+            cerr << "can't start device in " << d << endl;
+            break;
+        }
+        ++running;
+        cout << boost::format("started device %d in %s (pid %d)") % running % d % pid << endl;
+        if (interval) {
+            usleep(interval * 1000);
+        }
+    }
+    while (running) {
+        int status = 0;
+        const pid_t pid = wait(&status);
+        if (pid < 0) {
+            break;
+        }
+        --running;
+        cout << boost::format("device process %d exited with status %d") % pid % status << endl;
+    }
+    return false;
+}
+
+#endif // !defined(_WIN32)
+
 bool read_device_config(int argc, char* argv[])
 {
     ConfigParser parser;
@@ -173,6 +253,20 @@ bool read_device_config(int argc, char* argv[])
     po::options_description options;
     string command = parser.parse_options(argc, argv, options);
 
+    if (!parser.config.fleet_directory.empty() && command.empty()) {
+#ifndef _WIN32
+        if (!run_fleet(parser.config.fleet_directory, parser.config.fleet_interval)) {
+            return false;
+        }
+        // Read the configuration of this device from its directory
+        parser = ConfigParser();
+        po::options_description device_options;
+        command = parser.parse_options(argc, argv, device_options);
+#else
+        throw std::invalid_argument("fleet mode is not supported on this host");
+#endif
+    }
+
     if (command==CMD_HELP) {
         cout << options << endl;
         return false;
@@ -201,5 +295,8 @@ void DeviceConfig::read(Configuration& configuration)
     setLoggerLevel(LoggerOutputLevel(NO_LOG_LEVEL-configuration.log_level));
 
     this->protocol = configuration.protocol;
+
+    networkImpairment.configure(configuration.network);
+    virtual_time_enable(configuration.virtual_time);
 }
 
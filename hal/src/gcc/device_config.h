@@ -23,6 +23,7 @@
 #include <cstring>
 #include "filesystem.h"
 #include "spark_protocol_functions.h"
+#include "network_impairment.h"
 
 extern const char* DEVICE_ID;
 extern const char* DEVICE_PRIVATE_KEY;
@@ -53,6 +54,10 @@ struct Configuration
     std::string periph_directory;
     uint16_t log_level = 0;
     ProtocolFactory protocol = PROTOCOL_LIGHTSSL;
+    NetworkImpairmentConfig network;
+    bool virtual_time = false;
+    std::string fleet_directory;
+    unsigned fleet_interval = 100;
 };
 
 
@@ -20,6 +20,7 @@
 #include "eeprom_hal.h"
 #include "eeprom_file.h"
 #include "filesystem.h"
+#include "system_error.h"
 #include <string.h>
 #include <string>
 
@@ -98,6 +99,20 @@ void HAL_EEPROM_Perform_Pending_Erase()
 {
 }
 
+int HAL_EEPROM_Set_Write_Back(uint32_t flush_delay, void* reserved)
+{
+	return (flush_delay == 0) ? 0 : SYSTEM_ERROR_NOT_SUPPORTED;
+}
+
+int HAL_EEPROM_Flush(void* reserved)
+{
+	return 0;
+}
+
+void HAL_EEPROM_Process(void* reserved)
+{
+}
+
 void GCC_EEPROM_Load(const char* filename)
 {
 	read_file(filename, eeprom, sizeof(eeprom));
@@ -0,0 +1,53 @@
+/**
+  Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation, either
+  version 3 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************
+ */
+
+#include "network_impairment.h"
+#include <algorithm>
+
+NetworkImpairment networkImpairment;
+
+void NetworkImpairment::configure(const NetworkImpairmentConfig& config)
+{
+    config_ = config;
+    rand_.seed(config.seed);
+    std::fill(linkFree_, linkFree_ + 2, 0);
+}
+
+bool NetworkImpairment::schedule(Direction dir, size_t size, bool reliable, uint64_t now, uint64_t* time)
+{
+    if (!reliable && config_.loss > 0) {
+        std::uniform_real_distribution<double> dist(0, 100);
+        if (dist(rand_) < config_.loss) {
+            return false;
+        }
+    }
+    // The packet occupies the link for the time it takes to transmit it
+    uint64_t t = std::max(now, linkFree_[dir]);
+    if (config_.bandwidth) {
+        t += (uint64_t)size * 1000000 / config_.bandwidth;
+    }
+    linkFree_[dir] = t;
+    // Half of the round-trip time is spent in each direction
+    int64_t delay = (int64_t)config_.rtt * 1000 / 2;
+    if (config_.jitter) {
+        std::uniform_int_distribution<int64_t> dist(-(int64_t)config_.jitter * 1000, (int64_t)config_.jitter * 1000);
+        delay = std::max<int64_t>(delay + dist(rand_), 0);
+    }
+    *time = t + delay;
+    return true;
+}
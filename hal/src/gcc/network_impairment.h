@@ -0,0 +1,84 @@
+/**
+  Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation, either
+  version 3 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <random>
+
+/**
+ * Parameters of the emulated network link.
+ */
+struct NetworkImpairmentConfig
+{
+    unsigned rtt = 0; // Round-trip time, in milliseconds
+    unsigned jitter = 0; // Maximum deviation of the one-way delay, in milliseconds
+    double loss = 0; // Probability of a datagram being dropped in either direction, in percent
+    unsigned bandwidth = 0; // Capacity of the link in either direction, in bytes per second (0 means unlimited)
+    unsigned seed = 0; // Seed of the random number generator
+
+    bool enabled() const
+    {
+        return rtt || jitter || loss > 0 || bandwidth;
+    }
+};
+
+/**
+ * Emulates the timing of a slow and lossy link, such as a cellular connection.
+ *
+ * The socket HAL keeps the traffic in per-socket queues and asks this class when each packet
+ * is to be delivered. Both directions of the link are shared by all sockets, so the bandwidth
+ * cap applies to the total traffic of the device. The random number generator is seeded from
+ * the configuration, so a run with the same traffic and the virtual clock enabled is repeatable.
+ */
+class NetworkImpairment
+{
+public:
+    enum Direction
+    {
+        UPLINK = 0,
+        DOWNLINK = 1
+    };
+
+    void configure(const NetworkImpairmentConfig& config);
+
+    bool enabled() const
+    {
+        return config_.enabled();
+    }
+
+    /**
+     * Schedules a packet for transmission over the link.
+     *
+     * @param dir Direction of the link.
+     * @param size Size of the packet in bytes.
+     * @param reliable `true` if the packet belongs to a stream that must not be dropped (TCP).
+     * @param now Current time, in microseconds.
+     * @param[out] time Time at which the packet is to be delivered, in microseconds.
+     * @return `false` if the packet is lost.
+     */
+    bool schedule(Direction dir, size_t size, bool reliable, uint64_t now, uint64_t* time);
+
+private:
+    NetworkImpairmentConfig config_;
+    std::mt19937 rand_;
+    uint64_t linkFree_[2] = {}; // Time at which each direction of the link becomes idle
+};
+
+extern NetworkImpairment networkImpairment;
@@ -29,6 +29,11 @@
 #include "socket_hal.h"
 #include "inet_hal.h"
 #include "core_msg.h"
+#include "network_impairment.h"
+#include "timer_hal.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
 #include <vector>
 
 #pragma GCC diagnostic ignored "-Wunused-variable"
@@ -139,6 +144,165 @@ bool is_valid(ip::udp::socket& handle) {
     return &handle!=&invalid_udp();
 }
 
+void endpoint_to_sockaddr(const ip::udp::endpoint& endpoint, sockaddr_t* addr, socklen_t* addrsize)
+{
+	if (addr && addrsize && *addrsize>=6u) {
+		uint16_t port = endpoint.port();
+		addr->sa_data[0] = port >> 8;
+		addr->sa_data[1] = port & 0xFF;
+		uint32_t ip = endpoint.address().to_v4().to_ulong();
+		addr->sa_data[2] = (ip >> 24) & 0xFF;
+		addr->sa_data[3] = (ip >> 16) & 0xFF;
+		addr->sa_data[4] = (ip >> 8) & 0xFF;
+		addr->sa_data[5] = (ip >> 0) & 0xFF;
+	}
+}
+
+/**
+ * Network impairment.
+ *
+ * When the emulated link is enabled, the data sent by the application and the data received
+ * from the host sockets are held in per-socket queues until the time at which the link
+ * would have delivered them. The queues are serviced whenever the application calls into
+ * the socket HAL, which it does continuously while it is connected.
+ */
+struct DelayedPacket
+{
+	uint64_t time; // Delivery time, in microseconds
+	std::vector<uint8_t> data;
+	ip::udp::endpoint endpoint;
+};
+
+struct DelayedQueue
+{
+	std::deque<DelayedPacket> rx;
+	std::deque<DelayedPacket> tx;
+	size_t rxOffset = 0; // Number of bytes of the first TCP segment consumed by the application
+	int rxError = 0; // Error reported once all received data has been consumed
+};
+
+boost::array<DelayedQueue, SOCKET_MAX> delayed_queues;
+
+void enqueue(std::deque<DelayedPacket>& queue, DelayedPacket&& packet, bool reliable)
+{
+	if (reliable && !queue.empty()) {
+		// Jitter must not reorder the data of a stream
+		packet.time = std::max(packet.time, queue.back().time);
+	}
+	auto it = std::upper_bound(queue.begin(), queue.end(), packet.time,
+			[](uint64_t t, const DelayedPacket& p) { return t < p.time; });
+	queue.insert(it, std::move(packet));
+}
+
+void schedule(NetworkImpairment::Direction dir, std::deque<DelayedPacket>& queue, const void* data, size_t size,
+		bool reliable, const ip::udp::endpoint& endpoint = ip::udp::endpoint())
+{
+	DelayedPacket packet;
+	if (networkImpairment.schedule(dir, size, reliable, hal_timer_micros(nullptr), &packet.time)) {
+		packet.data.assign((const uint8_t*)data, (const uint8_t*)data + size);
+		packet.endpoint = endpoint;
+		enqueue(queue, std::move(packet), reliable);
+	}
+}
+
+void pump_tcp(sock_handle_t sd, bool flush)
+{
+	auto& socket = tcp_from(sd);
+	auto& q = delayed_queues[sd];
+	const uint64_t now = hal_timer_micros(nullptr);
+	while (!q.tx.empty() && (flush || q.tx.front().time <= now)) {
+		const auto& p = q.tx.front();
+		boost::asio::write(socket, boost::asio::buffer(p.data), ec);
+		q.tx.pop_front();
+	}
+	while (!q.rxError) {
+		boost::asio::socket_base::bytes_readable command(true);
+		socket.io_control(command, ec);
+		std::vector<uint8_t> buf(std::max<size_t>(command.get(), 1));
+		const size_t n = socket.read_some(boost::asio::buffer(buf), ec);
+		if (ec.value()) {
+			if (ec.value() != boost::system::errc::resource_deadlock_would_occur &&
+					ec.value() != boost::system::errc::resource_unavailable_try_again) {
+				q.rxError = -abs(ec.value());
+			}
+			break;
+		}
+		schedule(NetworkImpairment::DOWNLINK, q.rx, buf.data(), n, true /* reliable */);
+	}
+}
+
+void pump_udp(sock_handle_t sd, bool flush)
+{
+	static std::vector<uint8_t> buf(65536);
+	auto& socket = udp_from(sd);
+	auto& q = delayed_queues[sd];
+	const uint64_t now = hal_timer_micros(nullptr);
+	while (!q.tx.empty() && (flush || q.tx.front().time <= now)) {
+		const auto& p = q.tx.front();
+		socket.send_to(boost::asio::buffer(p.data), p.endpoint, 0, ec);
+		q.tx.pop_front();
+	}
+	for (;;) {
+		ip::udp::endpoint endpoint;
+		const size_t n = socket.receive_from(boost::asio::buffer(buf), endpoint, 0, ec);
+		if (ec.value()) {
+			break;
+		}
+		schedule(NetworkImpairment::DOWNLINK, q.rx, buf.data(), n, false /* reliable */, endpoint);
+	}
+}
+
+// Moves the data between the host sockets and the delay queues
+void pump_sockets()
+{
+	for (sock_handle_t sd=0; sd<SOCKET_MAX; sd++) {
+		if (is_tcp_socket(sd) ? tcp_from(sd).is_open() : udp_from(sd).is_open()) {
+			if (is_tcp_socket(sd))
+				pump_tcp(sd, false);
+			else
+				pump_udp(sd, false);
+		}
+	}
+}
+
+sock_result_t receive_delayed(sock_handle_t sd, void* buffer, socklen_t len)
+{
+	pump_sockets();
+	auto& q = delayed_queues[sd];
+	const uint64_t now = hal_timer_micros(nullptr);
+	size_t n = 0;
+	while (n < len && !q.rx.empty() && q.rx.front().time <= now) {
+		const auto& p = q.rx.front();
+		const size_t chunk = std::min<size_t>(len - n, p.data.size() - q.rxOffset);
+		memcpy((uint8_t*)buffer + n, p.data.data() + q.rxOffset, chunk);
+		n += chunk;
+		q.rxOffset += chunk;
+		if (q.rxOffset == p.data.size()) {
+			q.rx.pop_front();
+			q.rxOffset = 0;
+		}
+	}
+	if (!n && q.rx.empty()) {
+		return q.rxError;
+	}
+	return n;
+}
+
+sock_result_t receivefrom_delayed(sock_handle_t sd, void* buffer, socklen_t bufLen, sockaddr_t* addr, socklen_t* addrsize)
+{
+	pump_sockets();
+	auto& q = delayed_queues[sd];
+	if (q.rx.empty() || q.rx.front().time > hal_timer_micros(nullptr)) {
+		return 0;
+	}
+	const auto& p = q.rx.front();
+	const size_t n = std::min<size_t>(bufLen, p.data.size());
+	memcpy(buffer, p.data.data(), n);
+	endpoint_to_sockaddr(p.endpoint, addr, addrsize);
+	q.rx.pop_front();
+	return n;
+}
+
 
 
 class TCPServer
@@ -186,7 +350,10 @@ public:
 		ip::tcp::socket& sock = tcp_from(handle);
 
 		acceptor.accept(sock, ec);
-		return !ec ? handle : socket_handle_invalid();
+		if (ec)
+			return socket_handle_invalid();
+		delayed_queues[handle] = DelayedQueue();
+		return handle;
 	}
 
 
@@ -262,6 +429,7 @@ int32_t socket_connect(sock_handle_t sd, const sockaddr_t *addr, long addrlen)
     ip::address_v4::bytes_type address = {{ dest[0], dest[1], dest[2], dest[3] }};
     ip::tcp::endpoint endpoint(boost::asio::ip::address_v4(address),port);
 
+    delayed_queues[sd] = DelayedQueue();
     handle.connect(endpoint, ec);
     bool open = handle.is_open();
     return ec.value();
@@ -277,6 +445,8 @@ sock_result_t socket_receive(sock_handle_t sd, void* buffer, socklen_t len, syst
     auto& handle = tcp_from(sd);
     if (!is_valid(handle))
         return -1;
+    if (networkImpairment.enabled())
+        return receive_delayed(sd, buffer, len);
     boost::asio::socket_base::bytes_readable command(true);
     handle.io_control(command);
     std::size_t available = command.get();
@@ -301,6 +471,11 @@ sock_result_t socket_send(sock_handle_t sd, const void* buffer, socklen_t len)
     auto& socket = tcp_from(sd);
     if (!is_valid(socket))
         return -1;
+    if (networkImpairment.enabled()) {
+        schedule(NetworkImpairment::UPLINK, delayed_queues[sd].tx, buffer, len, true /* reliable */);
+        pump_sockets();
+        return len;
+    }
     try
     {
         sock_result_t result = write(socket, boost::asio::buffer(buffer, len));
@@ -328,18 +503,14 @@ sock_result_t socket_receivefrom(sock_handle_t sock, void* buffer, socklen_t buf
 {
 	ip::udp::endpoint endpoint;
 	auto& socket = udp_from(sock);
+	if (networkImpairment.enabled()) {
+		if (!is_valid(socket))
+			return -1;
+		return receivefrom_delayed(sock, buffer, bufLen, addr, addrsize);
+	}
 
 	int count = socket.receive_from(boost::asio::buffer(buffer, bufLen), endpoint, 0, ec);
-	if (addr && addrsize && *addrsize>=6u) {
-		uint16_t port = endpoint.port();
-		addr->sa_data[0] = port >> 8;
-		addr->sa_data[1] = port & 0xFF;
-		uint32_t ip = endpoint.address().to_v4().to_ulong();
-		addr->sa_data[2] = (ip >> 24) & 0xFF;
-		addr->sa_data[3] = (ip >> 16) & 0xFF;
-		addr->sa_data[4] = (ip >> 8) & 0xFF;
-		addr->sa_data[5] = (ip >> 0) & 0xFF;
-	}
+	endpoint_to_sockaddr(endpoint, addr, addrsize);
 
 	sock_handle_t result = ec.value();
 
@@ -365,6 +536,13 @@ sock_result_t socket_sendto(sock_handle_t sd, const void* buffer, socklen_t len,
     ip::udp::endpoint endpoint(boost::asio::ip::address_v4(address),port);
 
 	auto& socket = udp_from(sd);
+	if (networkImpairment.enabled()) {
+		if (!is_valid(socket))
+			return -1;
+		schedule(NetworkImpairment::UPLINK, delayed_queues[sd].tx, buffer, len, false /* reliable */, endpoint);
+		pump_sockets();
+		return len;
+	}
 	int count = socket.send_to(boost::asio::buffer(buffer, len), endpoint, 0, ec);
 
 	sock_handle_t result = ec.value();
@@ -400,12 +578,16 @@ sock_result_t socket_close(sock_handle_t socket)
 	else if (socket>=SOCKET_COUNT)
     {
     		auto& s = udp_from(socket);
+    		if (networkImpairment.enabled() && s.is_open())
+    			pump_udp(socket, true /* flush */);
     		s.shutdown(boost::asio::ip::udp::socket::shutdown_both, ec);
     		udp_from(socket).close();
     }
     else
     {
     		auto& s = tcp_from(socket);
+    		if (networkImpairment.enabled() && s.is_open())
+    			pump_tcp(socket, true /* flush */);
 		s.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
     		s.close();
     }
@@ -473,6 +655,8 @@ sock_handle_t socket_create(uint8_t family, uint8_t type, uint8_t protocol, uint
         socket.non_blocking(true, ec);
     }
 
+    delayed_queues[handle] = DelayedQueue();
+
     sock_handle_t result = ec.value();
     return result ? result : handle;
 }
@@ -1,17 +1,47 @@
 #include "timer_hal.h"
+#include "virtual_time.h"
 #include "boost_posix_time_wrap.h"
 
 namespace {
 
 const auto start = boost::posix_time::microsec_clock::universal_time();
 
+bool virtualTime = false;
+uint64_t virtualMicros = 0;
+
+uint64_t now_micros()
+{
+    if (virtualTime) {
+        // Advance the clock on every read so that busy-waiting loops terminate
+        return ++virtualMicros;
+    }
+    const auto now = boost::posix_time::microsec_clock::universal_time();
+    return (now - start).total_microseconds();
+}
+
 } // namespace
 
+void virtual_time_enable(bool enable)
+{
+    if (enable && !virtualTime) {
+        virtualMicros = now_micros();
+    }
+    virtualTime = enable;
+}
+
+bool virtual_time_enabled()
+{
+    return virtualTime;
+}
+
+void virtual_time_advance(uint64_t micros)
+{
+    virtualMicros += micros;
+}
+
 system_tick_t HAL_Timer_Get_Micro_Seconds(void)
 {
-    auto now = boost::posix_time::microsec_clock::universal_time();
-    auto diff = now - start;
-    return diff.total_microseconds();
+    return now_micros();
 }
 
 system_tick_t HAL_Timer_Get_Milli_Seconds(void)
@@ -21,6 +51,10 @@ system_tick_t HAL_Timer_Get_Milli_Seconds(void)
 
 uint64_t hal_timer_millis(void* reserved)
 {
-    const auto now = boost::posix_time::microsec_clock::universal_time();
-    return (now - start).total_milliseconds();
+    return now_micros() / 1000;
+}
+
+uint64_t hal_timer_micros(void* reserved)
+{
+    return now_micros();
 }
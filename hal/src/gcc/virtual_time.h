@@ -0,0 +1,38 @@
+/**
+  Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation, either
+  version 3 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Enables or disables the virtual clock.
+ *
+ * While the virtual clock is enabled, the timer HAL no longer follows the host clock: the delay
+ * functions advance the clock instead of sleeping, and every read of the clock advances it by
+ * one microsecond. Timeouts and network delays then take no wall-clock time and don't depend
+ * on the load of the host.
+ */
+void virtual_time_enable(bool enable);
+
+bool virtual_time_enabled();
+
+/**
+ * Advances the virtual clock by the specified number of microseconds.
+ */
+void virtual_time_advance(uint64_t micros);
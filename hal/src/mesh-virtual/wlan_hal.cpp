@@ -302,6 +302,11 @@ int wlan_scan(wlan_scan_result_t callback, void* cookie)
     return -1;
 }
 
+int wlan_scan_stream(wlan_scan_stream_callback_t callback, void* cookie, void* reserved)
+{
+    return -1;
+}
+
 int wlan_get_credentials(wlan_scan_result_t callback, void* callback_data)
 {
 	return -1;
@@ -19,6 +19,8 @@
 #include "nrfx_saadc.h"
 #include "adc_hal.h"
 #include "pinmap_impl.h"
+#include "system_error.h"
+#include "ppi_timer.h"
 
 static volatile bool m_adc_initiated = false;
 
@@ -29,9 +31,62 @@ static const nrfx_saadc_config_t saadc_config =
     .interrupt_priority = NRFX_SAADC_CONFIG_IRQ_PRIORITY
 };
 
+/*
+ * Continuous sampling: compare events of the shared PPI timer trigger the SAADC sample task, and
+ * the SAADC scans the configured channels into one half of the user buffer while the other half
+ * is being processed.
+ */
+#define ADC_CONTINUOUS_TIMER_FREQUENCY  16000000
+// Acquisition time plus conversion time of one sample
+#define ADC_SAMPLE_TIME_US              12
+// Maximum number of samples in one EasyDMA transfer
+#define ADC_MAX_DMA_SAMPLES             0x7fff
+
+static struct {
+    hal_adc_continuous_callback_t callback;
+    void* context;
+    volatile bool active;
+} m_adc_continuous = {};
+
 static void analog_in_event_handler(nrfx_saadc_evt_t const *p_event)
 {
-    (void) p_event;
+    if (p_event->type == NRFX_SAADC_EVT_DONE && m_adc_continuous.active)
+    {
+        // Queue the buffer again: it will be filled after the other half of the buffer
+        nrfx_saadc_buffer_convert(p_event->data.done.p_buffer, p_event->data.done.size);
+
+        if (m_adc_continuous.callback)
+        {
+            m_adc_continuous.callback(p_event->data.done.p_buffer, p_event->data.done.size,
+                    m_adc_continuous.context);
+        }
+    }
+}
+
+static bool adc_input(uint16_t pin, nrf_saadc_input_t* input)
+{
+    Hal_Pin_Info *PIN_MAP = HAL_Pin_Map();
+
+    if (PIN_MAP[pin].pin_func != PF_NONE && PIN_MAP[pin].pin_func != PF_DIO)
+    {
+        return false;
+    }
+
+    switch (PIN_MAP[pin].adc_channel)
+    {
+        case 0: *input = NRF_SAADC_INPUT_AIN0; break;
+        case 1: *input = NRF_SAADC_INPUT_AIN1; break;
+        case 2: *input = NRF_SAADC_INPUT_AIN2; break;
+        case 3: *input = NRF_SAADC_INPUT_AIN3; break;
+        case 4: *input = NRF_SAADC_INPUT_AIN4; break;
+        case 5: *input = NRF_SAADC_INPUT_AIN5; break;
+        case 6: *input = NRF_SAADC_INPUT_AIN6; break;
+        case 7: *input = NRF_SAADC_INPUT_AIN7; break;
+        default:
+            return false;
+    }
+
+    return true;
 }
 
 void HAL_ADC_Set_Sample_Time(uint8_t ADC_SampleTime)
@@ -57,21 +112,12 @@ int32_t HAL_ADC_Read(uint16_t pin)
     nrf_saadc_input_t nrf_adc_channel;
     Hal_Pin_Info *PIN_MAP = HAL_Pin_Map();
 
-    switch (PIN_MAP[pin].adc_channel)
+    if (m_adc_continuous.active)
     {
-        case 0: nrf_adc_channel = NRF_SAADC_INPUT_AIN0; break;
-        case 1: nrf_adc_channel = NRF_SAADC_INPUT_AIN1; break;
-        case 2: nrf_adc_channel = NRF_SAADC_INPUT_AIN2; break;
-        case 3: nrf_adc_channel = NRF_SAADC_INPUT_AIN3; break;
-        case 4: nrf_adc_channel = NRF_SAADC_INPUT_AIN4; break;
-        case 5: nrf_adc_channel = NRF_SAADC_INPUT_AIN5; break;
-        case 6: nrf_adc_channel = NRF_SAADC_INPUT_AIN6; break;
-        case 7: nrf_adc_channel = NRF_SAADC_INPUT_AIN7; break;
-        default:
-            return 0;
+        return 0;
     }
 
-    if (PIN_MAP[pin].pin_func != PF_NONE && PIN_MAP[pin].pin_func != PF_DIO)
+    if (!adc_input(pin, &nrf_adc_channel))
     {
         return 0;
     }
@@ -125,3 +171,134 @@ void HAL_ADC_DMA_Init()
     uint32_t err_code = nrfx_saadc_init(&saadc_config, analog_in_event_handler);
     SPARK_ASSERT(err_code == NRF_SUCCESS);
 }
+
+int HAL_ADC_Start_Continuous(const hal_adc_continuous_config* config, void* reserved)
+{
+    if (!config || !config->pins || config->pin_count == 0 || config->pin_count > NRF_SAADC_CHANNEL_COUNT ||
+            !config->buffer || config->oversample > 8 || config->sample_rate == 0)
+    {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Each half of the buffer holds a whole number of scans
+    const size_t half_size = config->buffer_size / 2;
+    if (half_size == 0 || half_size % config->pin_count != 0 || half_size > ADC_MAX_DMA_SAMPLES ||
+            config->buffer_size % 2 != 0)
+    {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+
+    // A scan has to complete before the next one is triggered
+    const uint32_t scan_time_us = config->pin_count * ADC_SAMPLE_TIME_US * (1 << config->oversample);
+    if ((uint64_t)scan_time_us * config->sample_rate >= 1000000)
+    {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+
+    nrf_saadc_input_t inputs[NRF_SAADC_CHANNEL_COUNT];
+    for (uint8_t i = 0; i < config->pin_count; i++)
+    {
+        if (config->pins[i] >= TOTAL_PINS || !adc_input(config->pins[i], &inputs[i]))
+        {
+            return SYSTEM_ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    if (m_adc_continuous.active)
+    {
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
+
+    if (!ppi_timer_acquire())
+    {
+        return SYSTEM_ERROR_BUSY;
+    }
+
+    // Oversampling is a global setting of the SAADC, so the driver needs to be reinitialized
+    if (m_adc_initiated)
+    {
+        nrfx_saadc_uninit();
+    }
+    m_adc_initiated = true;
+
+    nrfx_saadc_config_t saadc_continuous_config = saadc_config;
+    saadc_continuous_config.oversample = (nrf_saadc_oversample_t)config->oversample;
+    if (nrfx_saadc_init(&saadc_continuous_config, analog_in_event_handler) != NRFX_SUCCESS)
+    {
+        m_adc_initiated = false;
+        ppi_timer_release();
+        return SYSTEM_ERROR_INTERNAL;
+    }
+
+    m_adc_continuous.callback = config->callback;
+    m_adc_continuous.context = config->context;
+    m_adc_continuous.active = true;
+
+    for (uint8_t i = 0; i < config->pin_count; i++)
+    {
+        nrf_saadc_channel_config_t channel_config = {
+            .resistor_p = NRF_SAADC_RESISTOR_DISABLED,
+            .resistor_n = NRF_SAADC_RESISTOR_DISABLED,
+            .gain       = NRF_SAADC_GAIN1_4,
+            .reference  = NRF_SAADC_REFERENCE_VDD4,
+            .acq_time   = NRF_SAADC_ACQTIME_10US,
+            .mode       = NRF_SAADC_MODE_SINGLE_ENDED,
+            // In scan mode oversampling works only with burst mode enabled on every channel
+            .burst      = config->oversample ? NRF_SAADC_BURST_ENABLED : NRF_SAADC_BURST_DISABLED,
+            .pin_p      = inputs[i],
+            .pin_n      = NRF_SAADC_INPUT_DISABLED
+        };
+        if (nrfx_saadc_channel_init(i, &channel_config) != NRFX_SUCCESS)
+        {
+            HAL_ADC_Stop_Continuous(nullptr);
+            return SYSTEM_ERROR_INTERNAL;
+        }
+    }
+
+    // Double buffering: the second half is filled when the first one is done
+    if (nrfx_saadc_buffer_convert(config->buffer, half_size) != NRFX_SUCCESS ||
+            nrfx_saadc_buffer_convert(config->buffer + half_size, half_size) != NRFX_SUCCESS)
+    {
+        HAL_ADC_Stop_Continuous(nullptr);
+        return SYSTEM_ERROR_INTERNAL;
+    }
+
+    nrf_timer_task_trigger(PPI_TIMER, NRF_TIMER_TASK_STOP);
+    nrf_timer_task_trigger(PPI_TIMER, NRF_TIMER_TASK_CLEAR);
+    nrf_timer_mode_set(PPI_TIMER, NRF_TIMER_MODE_TIMER);
+    nrf_timer_bit_width_set(PPI_TIMER, NRF_TIMER_BIT_WIDTH_32);
+    nrf_timer_frequency_set(PPI_TIMER, NRF_TIMER_FREQ_16MHz);
+    nrf_timer_cc_write(PPI_TIMER, NRF_TIMER_CC_CHANNEL0,
+            ADC_CONTINUOUS_TIMER_FREQUENCY / config->sample_rate);
+    nrf_timer_shorts_enable(PPI_TIMER, NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK);
+
+    nrf_ppi_channel_endpoint_setup(PPI_TIMER_CHANNEL,
+            nrf_timer_event_address_get(PPI_TIMER, NRF_TIMER_EVENT_COMPARE0),
+            nrfx_saadc_sample_task_get());
+    nrf_ppi_channel_enable(PPI_TIMER_CHANNEL);
+
+    nrf_timer_task_trigger(PPI_TIMER, NRF_TIMER_TASK_START);
+
+    return SYSTEM_ERROR_NONE;
+}
+
+int HAL_ADC_Stop_Continuous(void* reserved)
+{
+    if (!m_adc_continuous.active)
+    {
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
+
+    ppi_timer_release();
+
+    m_adc_continuous.active = false;
+    m_adc_continuous.callback = nullptr;
+    m_adc_continuous.context = nullptr;
+
+    // Aborts the ongoing conversion and uninitializes the channels. The driver is initialized
+    // again with the default configuration on the next call to HAL_ADC_Read()
+    nrfx_saadc_uninit();
+    m_adc_initiated = false;
+
+    return SYSTEM_ERROR_NONE;
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "logging.h"
+LOG_SOURCE_CATEGORY("hal.ble")
+
+#include "ble_gatt_cache.h"
+
+#if HAL_PLATFORM_BLE && HAL_PLATFORM_FILESYSTEM
+
+#include "file_util.h"
+#include "filesystem.h"
+#include "scope_guard.h"
+#include "check.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace particle { namespace ble {
+
+namespace {
+
+const char* const CACHE_DIR = "/sys/ble_gattc";
+
+const uint32_t CACHE_FILE_MAGIC = 0x43544147; // "GATC"
+const uint16_t CACHE_FILE_VERSION = 1;
+
+struct __attribute__((packed)) CacheFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t serviceSize; // Size of the records, in case the HAL structures change
+    uint8_t characteristicSize;
+    uint16_t serviceCount;
+    uint16_t characteristicCount;
+    uint16_t hashHandle;
+    uint16_t serviceChangedHandle;
+    uint8_t hash[BLE_GATT_DATABASE_HASH_LEN];
+    // Followed by the services and the characteristics
+};
+
+// "/sys/ble_gattc/" followed by the address in hex and its type
+const size_t MAX_PATH_LEN = 15 + BLE_SIG_ADDR_LEN * 2 + 3;
+
+void cacheFilePath(const hal_ble_addr_t& address, char* path, size_t size) {
+    // The address is stored least significant byte first
+    const uint8_t* a = address.addr;
+    snprintf(path, size, "%s/%02x%02x%02x%02x%02x%02x_%d", CACHE_DIR, a[5], a[4], a[3], a[2], a[1], a[0],
+            (int)address.addr_type);
+}
+
+inline lfs_t* lfs(filesystem_t* fs) {
+    return &fs->instance;
+}
+
+} // unnamed
+
+const size_t GattCache::MAX_SERVICE_COUNT;
+const size_t GattCache::MAX_CHARACTERISTIC_COUNT;
+
+int GattCache::load(const hal_ble_addr_t& address, Database* db) {
+    const auto fs = filesystem_get_instance(nullptr);
+    CHECK_TRUE(fs, SYSTEM_ERROR_FILE);
+    const fs::FsLock lock(fs);
+    CHECK(filesystem_mount(fs));
+    char path[MAX_PATH_LEN + 1] = {};
+    cacheFilePath(address, path, sizeof(path));
+    lfs_file_t file = {};
+    int r = lfs_file_open(lfs(fs), &file, path, LFS_O_RDONLY);
+    if (r != LFS_ERR_OK) {
+        return (r == LFS_ERR_NOENT) ? SYSTEM_ERROR_NOT_FOUND : SYSTEM_ERROR_FILE;
+    }
+    SCOPE_GUARD({
+        lfs_file_close(lfs(fs), &file);
+    });
+    CacheFileHeader h = {};
+    r = lfs_file_read(lfs(fs), &file, &h, sizeof(h));
+    if (r != (lfs_ssize_t)sizeof(h) || h.magic != CACHE_FILE_MAGIC || h.version != CACHE_FILE_VERSION ||
+            h.serviceSize != sizeof(hal_ble_svc_t) || h.characteristicSize != sizeof(hal_ble_char_t) ||
+            h.serviceCount > MAX_SERVICE_COUNT || h.characteristicCount > MAX_CHARACTERISTIC_COUNT) {
+        LOG(WARN, "Invalid GATT cache file: %s", path);
+        return SYSTEM_ERROR_BAD_DATA;
+    }
+    CHECK_TRUE(db->services.resize(h.serviceCount), SYSTEM_ERROR_NO_MEMORY);
+    CHECK_TRUE(db->characteristics.resize(h.characteristicCount), SYSTEM_ERROR_NO_MEMORY);
+    const lfs_ssize_t svcSize = h.serviceCount * sizeof(hal_ble_svc_t);
+    const lfs_ssize_t charSize = h.characteristicCount * sizeof(hal_ble_char_t);
+    if (lfs_file_read(lfs(fs), &file, db->services.data(), svcSize) != svcSize ||
+            lfs_file_read(lfs(fs), &file, db->characteristics.data(), charSize) != charSize) {
+        return SYSTEM_ERROR_BAD_DATA;
+    }
+    db->hashHandle = h.hashHandle;
+    db->serviceChangedHandle = h.serviceChangedHandle;
+    memcpy(db->hash, h.hash, sizeof(db->hash));
+    return 0;
+}
+
+int GattCache::save(const hal_ble_addr_t& address, const Database& db) {
+    CHECK_TRUE(db.services.size() <= (int)MAX_SERVICE_COUNT, SYSTEM_ERROR_TOO_LARGE);
+    CHECK_TRUE(db.characteristics.size() <= (int)MAX_CHARACTERISTIC_COUNT, SYSTEM_ERROR_TOO_LARGE);
+    const auto fs = filesystem_get_instance(nullptr);
+    CHECK_TRUE(fs, SYSTEM_ERROR_FILE);
+    const fs::FsLock lock(fs);
+    CHECK(filesystem_mount(fs));
+    char path[MAX_PATH_LEN + 1] = {};
+    cacheFilePath(address, path, sizeof(path));
+    lfs_file_t file = {};
+    CHECK(openFile(&file, path, LFS_O_WRONLY | LFS_O_TRUNC));
+    CacheFileHeader h = {};
+    h.magic = CACHE_FILE_MAGIC;
+    h.version = CACHE_FILE_VERSION;
+    h.serviceSize = sizeof(hal_ble_svc_t);
+    h.characteristicSize = sizeof(hal_ble_char_t);
+    h.serviceCount = db.services.size();
+    h.characteristicCount = db.characteristics.size();
+    h.hashHandle = db.hashHandle;
+    h.serviceChangedHandle = db.serviceChangedHandle;
+    memcpy(h.hash, db.hash, sizeof(h.hash));
+    const lfs_ssize_t svcSize = h.serviceCount * sizeof(hal_ble_svc_t);
+    const lfs_ssize_t charSize = h.characteristicCount * sizeof(hal_ble_char_t);
+    bool ok = lfs_file_write(lfs(fs), &file, &h, sizeof(h)) == (lfs_ssize_t)sizeof(h) &&
+            lfs_file_write(lfs(fs), &file, db.services.data(), svcSize) == svcSize &&
+            lfs_file_write(lfs(fs), &file, db.characteristics.data(), charSize) == charSize;
+    ok = (lfs_file_close(lfs(fs), &file) == LFS_ERR_OK) && ok;
+    if (!ok) {
+        LOG(ERROR, "Unable to write %s", path);
+        lfs_remove(lfs(fs), path);
+        return SYSTEM_ERROR_FILE;
+    }
+    return 0;
+}
+
+int GattCache::remove(const hal_ble_addr_t& address) {
+    const auto fs = filesystem_get_instance(nullptr);
+    CHECK_TRUE(fs, SYSTEM_ERROR_FILE);
+    const fs::FsLock lock(fs);
+    CHECK(filesystem_mount(fs));
+    char path[MAX_PATH_LEN + 1] = {};
+    cacheFilePath(address, path, sizeof(path));
+    const int r = lfs_remove(lfs(fs), path);
+    CHECK_TRUE(r == LFS_ERR_OK || r == LFS_ERR_NOENT, SYSTEM_ERROR_FILE);
+    return 0;
+}
+
+} } // particle::ble
+
+#endif // HAL_PLATFORM_BLE && HAL_PLATFORM_FILESYSTEM
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "hal_platform.h"
+
+#if HAL_PLATFORM_BLE && HAL_PLATFORM_FILESYSTEM
+
+#include "ble_hal.h"
+#include "spark_wiring_vector.h"
+
+/* Length of the value of the Database Hash characteristic. */
+#define BLE_GATT_DATABASE_HASH_LEN                  16
+
+namespace particle { namespace ble {
+
+/**
+ * Persistent cache of the services and characteristics discovered on remote GATT servers.
+ *
+ * The cached attribute table of a peer is stored in /sys/ble_gattc, in a file named after the
+ * peer address. Since the handles are only stable for as long as the peer's database doesn't
+ * change, a table is only cached if the peer exposes the Database Hash characteristic, whose
+ * value is compared with the cached one on every connection, or the Service Changed
+ * characteristic, whose indication invalidates the cached table.
+ */
+class GattCache {
+public:
+    static const size_t MAX_SERVICE_COUNT = 16;
+    static const size_t MAX_CHARACTERISTIC_COUNT = 64;
+
+    struct Database {
+        spark::Vector<hal_ble_svc_t> services;
+        spark::Vector<hal_ble_char_t> characteristics;
+        hal_ble_attr_handle_t hashHandle;                   /**< Value handle of the Database Hash characteristic. */
+        hal_ble_attr_handle_t serviceChangedHandle;         /**< Value handle of the Service Changed characteristic. */
+        uint8_t hash[BLE_GATT_DATABASE_HASH_LEN];
+    };
+
+    /**
+     * Load the cached attribute table of a peer.
+     *
+     * @return `SYSTEM_ERROR_NOT_FOUND` if the peer's table is not cached.
+     */
+    static int load(const hal_ble_addr_t& address, Database* db);
+    static int save(const hal_ble_addr_t& address, const Database& db);
+    static int remove(const hal_ble_addr_t& address);
+};
+
+} } // particle::ble
+
+#endif // HAL_PLATFORM_BLE && HAL_PLATFORM_FILESYSTEM
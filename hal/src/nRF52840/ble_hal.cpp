@@ -43,6 +43,7 @@ LOG_SOURCE_CATEGORY("hal.ble");
 #include <mutex>
 
 #include "gpio_hal.h"
+#include "timer_hal.h"
 #include "device_code.h"
 #include "radio_common.h"
 #include "nrf_system_error.h"
@@ -54,6 +55,7 @@ LOG_SOURCE_CATEGORY("hal.ble");
 #include "check_nrf.h"
 #include "check.h"
 #include "scope_guard.h"
+#include "ble_gatt_cache.h"
 
 using namespace particle;
 #include "intrusive_list.h"
@@ -90,6 +92,11 @@ const size_t BLE_EVT_DATA_POOL_SIZE = 2048;
 const uint32_t BLE_OPERATION_TIMEOUT_MS = 30000;
 // Delay for GATT Client to send the ATT MTU exchanging request.
 const uint32_t BLE_ATT_MTU_EXCHANGE_DELAY_MS = 800;
+// Number of notifications that can be queued in the SoftDevice per connection.
+const uint8_t BLE_HVN_TX_QUEUE_SIZE = 8;
+// States of an operation of a batched read until it completes.
+const int BLE_READ_STATE_PENDING = 1;
+const int BLE_READ_STATE_IN_FLIGHT = 2;
 
 static const uint8_t BleAdvEvtTypeMap[] = {
     BLE_GAP_ADV_TYPE_CONNECTABLE_SCANNABLE_UNDIRECTED,
@@ -158,6 +165,16 @@ bool addressEqual(const hal_ble_addr_t& srcAddr, const hal_ble_addr_t& destAddr)
     return (srcAddr.addr_type == destAddr.addr_type && !memcmp(srcAddr.addr, destAddr.addr, BLE_SIG_ADDR_LEN));
 }
 
+bool uuidEqual(const hal_ble_uuid_t& srcUuid, const hal_ble_uuid_t& destUuid) {
+    if (srcUuid.type != destUuid.type) {
+        return false;
+    }
+    if (srcUuid.type == BLE_UUID_TYPE_16BIT) {
+        return srcUuid.uuid16 == destUuid.uuid16;
+    }
+    return !memcmp(srcUuid.uuid128, destUuid.uuid128, BLE_SIG_UUID_128BIT_LEN);
+}
+
 hal_ble_addr_t chipDefaultAddress() {
     uint32_t addrMsb = NRF_FICR->DEVICEADDR[1];
     uint32_t addrLsb = NRF_FICR->DEVICEADDR[0];
@@ -335,7 +352,8 @@ public:
               isScanning_(false),
               scanSemaphore_(nullptr),
               scanResultCallback_(nullptr),
-              context_(nullptr) {
+              context_(nullptr),
+              reports_() {
         scanParams_.version = BLE_API_VERSION;
         scanParams_.size = sizeof(hal_ble_scan_params_t);
         scanParams_.active = true;
@@ -360,9 +378,15 @@ public:
     int processAdvReportEventFromThread(const ble_evt_t* event);
 
 private:
-    bool isCachedDevice(const hal_ble_addr_t& address) const;
-    int addCachedDevice(const hal_ble_addr_t& address);
-    void clearCachedDevice();
+    struct FilterEntry {
+        uint32_t hash;                                      /**< Hash of the reported device's address and, optionally, advertising data. 0 if unused. */
+        system_tick_t time;                                 /**< Time when the device was reported. */
+    };
+
+    uint32_t reportHash(const hal_ble_addr_t& address, const uint8_t* data, size_t len) const;
+    bool isDuplicateReport(uint32_t hash) const;
+    void addReport(uint32_t hash);
+    void clearReports();
     hal_ble_scan_result_evt_t* getPendingResult(const hal_ble_addr_t& address);
     int addPendingResult(const hal_ble_scan_result_evt_t& resultEvt);
     void removePendingResult(const hal_ble_addr_t& address);
@@ -380,7 +404,7 @@ private:
     ble_data_t bleScanData_;                                /**< BLE scanned data. */
     hal_ble_on_scan_result_cb_t scanResultCallback_;        /**< Callback function on scan result. */
     void* context_;                                         /**< Context of the scan result callback function. */
-    Vector<hal_ble_addr_t> cachedDevices_;
+    FilterEntry reports_[BLE_SCAN_FILTER_TABLE_SIZE];       /**< Hash table of reported devices, accessed from the ISR. */
     Vector<hal_ble_scan_result_evt_t> pendingResults_;
 };
 
@@ -416,6 +440,7 @@ public:
     int disconnect(hal_ble_conn_handle_t connHandle);
     int disconnectAll();
     int updateConnectionParams(hal_ble_conn_handle_t connHandle, const hal_ble_conn_params_t* params);
+    int setThroughput(hal_ble_conn_handle_t connHandle, uint32_t throughput);
     int getConnectionInfo(hal_ble_conn_handle_t connHandle, hal_ble_conn_info_t* info);
     bool valid(hal_ble_conn_handle_t connHandle);
     ssize_t getAttMtu(hal_ble_conn_handle_t connHandle);
@@ -435,6 +460,7 @@ private:
         hal_ble_conn_info_t info;
         BleLinkEventHandler handler; // It is used for central link only.
         bool isMtuExchanged;
+        uint32_t throughput; // Requested throughput of a central link, bytes per second.
     };
 
     int configureAttMtu(hal_ble_conn_handle_t connHandle, size_t effective);
@@ -444,6 +470,8 @@ private:
     int addConnection(const BleConnection& connection);
     void removeConnection(hal_ble_conn_handle_t connHandle);
     void initiateConnParamsUpdateIfNeeded(const BleConnection* connection);
+    void requestDataLengthAndPhyUpdate(hal_ble_conn_handle_t connHandle) const;
+    void scheduleCentralLinks();
     bool isConnParamsFeeded(const hal_ble_conn_params_t* params) const;
     static void onAttMtuExchangeTimerExpired(os_timer_t timer);
     static ble_gap_conn_params_t toPlatformConnParams(const hal_ble_conn_params_t* halConnParams);
@@ -469,6 +497,7 @@ private:
     static size_t desiredAttMtu_;
     Vector<BleConnection> connections_;
     Vector<BleLinkEventHandler> peripheralLinkEventHandlers_;   /**< It is used for peripheral link only. */
+    volatile uint16_t scheduledIntervals_[BLE_MAX_LINK_COUNT] = {}; /**< Connection intervals assigned to the central links, indexed by connection handle. */
 };
 
 size_t BleObject::ConnectionsManager::desiredAttMtu_ = BLE_MAX_ATT_MTU_SIZE;
@@ -479,7 +508,10 @@ public:
             : gattsInitialized_(false),
               isHvxing_(false),
               currHvxConnHandle_(BLE_INVALID_CONN_HANDLE),
-              hvxSemaphore_(nullptr) {
+              currHvxType_(0),
+              hvxSemaphore_(nullptr),
+              txCompleteCallback_(nullptr),
+              txCompleteContext_(nullptr) {
     }
     ~GattServer() = default;
     int init();
@@ -492,8 +524,11 @@ public:
     void removeSubscriberFromAllCharacteristics(hal_ble_conn_handle_t connHandle);
     ssize_t setValue(hal_ble_attr_handle_t attrHandle, const uint8_t* buf, size_t len);
     ssize_t notifyValue(hal_ble_attr_handle_t attrHandle, const uint8_t* buf, size_t len, bool ack);
+    ssize_t notifyValues(hal_ble_attr_handle_t attrHandle, const hal_ble_notify_value_t* values, size_t count);
+    void setTxCompleteCallback(hal_ble_on_tx_complete_cb_t callback, void* context);
     ssize_t getValue(hal_ble_attr_handle_t attrHandle, uint8_t* buf, size_t len);
     int processDataWrittenEventFromThread(ble_evt_t* event);
+    int processTxCompleteEventFromThread(const ble_evt_t* event);
 
 private:
     struct Subscriber {
@@ -523,7 +558,10 @@ private:
     bool gattsInitialized_;
     volatile bool isHvxing_;
     hal_ble_conn_handle_t currHvxConnHandle_;
+    volatile uint8_t currHvxType_;                  /**< Type of the current HVX operation: notification or indication. */
     os_semaphore_t hvxSemaphore_;                   /**< Semaphore to wait until the HVX operation completed. */
+    volatile hal_ble_on_tx_complete_cb_t txCompleteCallback_;   /**< Callback function on queued notifications sent. */
+    void* volatile txCompleteContext_;              /**< Context of the TX complete callback function. */
     Vector<hal_ble_attr_handle_t> services_;        /**< Added services. */
     Vector<BleCharacteristic> characteristics_;     /**< Added characteristic. */
 };
@@ -560,8 +598,10 @@ public:
     int discoverServices(hal_ble_conn_handle_t connHandle, const hal_ble_uuid_t* uuid, hal_ble_on_disc_service_cb_t callback, void* context);
     int discoverCharacteristics(hal_ble_conn_handle_t connHandle, const hal_ble_svc_t* service, hal_ble_on_disc_char_cb_t callback, void* context);
     int removeAllPublishersOfConnection(hal_ble_conn_handle_t connHandle);
+    void invalidatePeerDatabase(hal_ble_conn_handle_t connHandle, bool changed);
     ssize_t writeAttribute(hal_ble_conn_handle_t connHandle, hal_ble_attr_handle_t attrHandle, const uint8_t* buf, size_t len, bool response);
     ssize_t readAttribute(hal_ble_conn_handle_t connHandle, hal_ble_attr_handle_t attrHandle, uint8_t* buf, size_t len);
+    ssize_t readValues(hal_ble_gatt_read_t* reads, size_t count);
     int configureRemoteCCCD(const hal_ble_cccd_config_t* config);
     int processSvcDiscEventFromThread(const ble_evt_t* event);
     int processCharDiscEventFromThread(const ble_evt_t* event);
@@ -584,6 +624,15 @@ private:
         hal_ble_attr_handle_t valueHandle;
     };
 
+    struct PeerDatabase {
+        GattCache::Database db;
+        hal_ble_addr_t address;
+        Vector<hal_ble_attr_handle_t> discoveredServices;         /**< Services of which the characteristics have been collected. */
+        volatile bool valid;                                        /**< The cached table is valid for the current connection. */
+        volatile bool collecting;                                   /**< The table is being collected from a full discovery. */
+        volatile bool changed;                                      /**< The peer has indicated that its database has changed. */
+    };
+
     void resetDiscoveryState();
     bool readServiceUUID128IfNeeded() const;
     bool readCharacteristicUUID128IfNeeded() const;
@@ -592,6 +641,13 @@ private:
     int addPublisher(hal_ble_conn_handle_t connHandle, hal_ble_attr_handle_t valueHandle, hal_ble_on_char_evt_cb_t callback, void* context);
     int removePublisher(hal_ble_conn_handle_t connHandle, hal_ble_attr_handle_t valueHandle);
     int configRemoteCharCCCD(const hal_ble_cccd_config_t* config);
+    bool startBatchReads();
+    bool batchReadInFlight(hal_ble_conn_handle_t connHandle) const;
+    PeerDatabase* peerDatabase(hal_ble_conn_handle_t connHandle);
+    bool loadPeerDatabase(hal_ble_conn_handle_t connHandle);
+    void collectPeerServices(hal_ble_conn_handle_t connHandle);
+    void collectPeerCharacteristics(hal_ble_conn_handle_t connHandle, const hal_ble_svc_t& service);
+    void savePeerDatabase(hal_ble_conn_handle_t connHandle, PeerDatabase* peer);
     static void processGattClientEvents(const ble_evt_t* event, void* context);
 
     bool gattcInitialized_;
@@ -616,6 +672,9 @@ private:
     hal_ble_attr_handle_t readAttrHandle_;                          /**< Current handle of which attribute to be read. */
     uint8_t* readBuf_;                                              /**< Current buffer to be filled for the read data. */
     size_t readLen_;                                                /**< Length of read data. */
+    hal_ble_gatt_read_t* batchReads_ = nullptr;                     /**< Operations of the current batched read. */
+    size_t batchReadCount_ = 0;                                     /**< Number of operations of the current batched read. */
+    PeerDatabase peerDbs_[BLE_MAX_LINK_COUNT] = {};                 /**< Attribute tables of the peers, indexed by connection handle. */
     Vector<Publisher> publishers_;
 };
 
@@ -708,6 +767,10 @@ os_thread_return_t BleObject::BleEventDispatcher::processBleEventFromThread(void
                     BleObject::getInstance().gatts()->processDataWrittenEventFromThread(event);
                     break;
                 }
+                case BLE_GATTS_EVT_HVN_TX_COMPLETE: {
+                    BleObject::getInstance().gatts()->processTxCompleteEventFromThread(event);
+                    break;
+                }
                 case BLE_GATTC_EVT_HVX: {
                     BleObject::getInstance().gattc()->processDataNotifiedEventFromThread(event);
                 }
@@ -1319,7 +1382,7 @@ int BleObject::Observer::continueScanning() {
 int BleObject::Observer::startScanning(hal_ble_on_scan_result_cb_t callback, void* context) {
     CHECK_FALSE(isScanning_, SYSTEM_ERROR_INVALID_STATE);
     SCOPE_GUARD ({
-        clearCachedDevice();
+        clearReports();
         clearPendingResult();
     });
     ble_gap_scan_params_t bleGapScanParams = toPlatformScanParams();
@@ -1369,22 +1432,68 @@ ble_gap_scan_params_t BleObject::Observer::toPlatformScanParams() const {
     return params;
 }
 
-bool BleObject::Observer::isCachedDevice(const hal_ble_addr_t& address) const {
-    for (const auto& addr : cachedDevices_) {
-        if (addressEqual(addr, address)) {
-            return true;
+uint32_t BleObject::Observer::reportHash(const hal_ble_addr_t& address, const uint8_t* data, size_t len) const {
+    // FNV-1a
+    uint32_t hash = 0x811c9dc5;
+    const auto update = [&hash](uint8_t b) {
+        hash = (hash ^ b) * 0x01000193;
+    };
+    update(address.addr_type);
+    for (size_t i = 0; i < BLE_SIG_ADDR_LEN; i++) {
+        update(address.addr[i]);
+    }
+    if ((scanParams_.dup_filter_flags & BLE_SCAN_FILTER_FLAG_PAYLOAD) && data) {
+        for (size_t i = 0; i < len; i++) {
+            update(data[i]);
+        }
+    }
+    return hash ? hash : 1; // 0 denotes an unused entry
+}
+
+bool BleObject::Observer::isDuplicateReport(uint32_t hash) const {
+    const system_tick_t period = scanParams_.dup_filter_period * 10;
+    const system_tick_t now = HAL_Timer_Get_Milli_Seconds();
+    for (size_t i = 0; i < BLE_SCAN_FILTER_TABLE_SIZE; i++) {
+        const FilterEntry& entry = reports_[(hash + i) % BLE_SCAN_FILTER_TABLE_SIZE];
+        if (entry.hash == 0) {
+            return false;
+        }
+        if (entry.hash == hash) {
+            return period == 0 || now - entry.time < period;
         }
     }
     return false;
 }
 
-int BleObject::Observer::addCachedDevice(const hal_ble_addr_t& address) {
-    CHECK_TRUE(cachedDevices_.append(address), SYSTEM_ERROR_NO_MEMORY);
-    return SYSTEM_ERROR_NONE;
+void BleObject::Observer::addReport(uint32_t hash) {
+    // Use the entry with the same hash, an unused entry or the oldest one. The table is never
+    // shrunk during scanning, so entries can be replaced but not removed.
+    const system_tick_t now = HAL_Timer_Get_Milli_Seconds();
+    FilterEntry* oldest = nullptr;
+    FilterEntry* entry = nullptr;
+    for (size_t i = 0; i < BLE_SCAN_FILTER_TABLE_SIZE; i++) {
+        FilterEntry* e = &reports_[(hash + i) % BLE_SCAN_FILTER_TABLE_SIZE];
+        if (e->hash == 0 || e->hash == hash) {
+            entry = e;
+            break;
+        }
+        if (!oldest || now - e->time > now - oldest->time) {
+            oldest = e;
+        }
+    }
+    if (!entry) {
+        entry = oldest;
+    }
+    ATOMIC_BLOCK() {
+        entry->hash = hash;
+        entry->time = now;
+    }
 }
 
-void BleObject::Observer::clearCachedDevice() {
-    cachedDevices_.clear();
+void BleObject::Observer::clearReports() {
+    ATOMIC_BLOCK() {
+        memset(reports_, 0, sizeof(reports_));
+    }
 }
 
 hal_ble_scan_result_evt_t* BleObject::Observer::getPendingResult(const hal_ble_addr_t& address) {
@@ -1466,17 +1575,21 @@ int BleObject::Observer::processAdvReportEventFromThread(const ble_evt_t* event)
     }
     const ble_gap_evt_adv_report_t& advReport = event->evt.gap_evt.params.adv_report;
     hal_ble_addr_t newAddr = toHalAddress(advReport.peer_addr);
-    if (isCachedDevice(newAddr)) {
-        // This has been checked in the ISR. Check it here just for sure.
-        // Free the allocated RAM for the advertising data.
-        goto free;
+    uint32_t hash = 0;
+    if (!advReport.type.scan_response) {
+        hash = reportHash(newAddr, advReport.data.p_data, advReport.data.len);
+        if (isDuplicateReport(hash)) {
+            // This has been checked in the ISR. Check it here just for sure.
+            // Free the allocated RAM for the advertising data.
+            goto free;
+        }
     }
     if ((!scanParams_.active || !advReport.type.scannable) && !advReport.type.scan_response) {
         // No scan response data is expected.
         hal_ble_scan_result_evt_t result = {};
         constructObserverEvent(result, advReport);
         notifyScanResultEvent(result);
-        addCachedDevice(newAddr);
+        addReport(hash);
         goto continue_scanning;
     }
     if (!advReport.type.scan_response) {
@@ -1494,9 +1607,10 @@ int BleObject::Observer::processAdvReportEventFromThread(const ble_evt_t* event)
         if (!result) {
             goto free;
         }
+        hash = reportHash(newAddr, result->adv_data, result->adv_data_len);
         constructObserverEvent(*result, advReport);
         notifyScanResultEvent(*result);
-        addCachedDevice(newAddr);
+        addReport(hash);
         removePendingResult(newAddr);
     }
     goto continue_scanning;
@@ -1520,9 +1634,16 @@ void BleObject::Observer::processObserverEvents(const ble_evt_t* event, void* co
             }
             const ble_gap_evt_adv_report_t& report = event->evt.gap_evt.params.adv_report;
             hal_ble_addr_t newAddr = toHalAddress(report.peer_addr);
-            if (observer->isCachedDevice(newAddr)) {
-                observer->continueScanning();
-                break;
+            if (!report.type.scan_response) {
+                // Filter out weak and duplicate advertising packets here, so that they don't reach the event thread.
+                if (observer->scanParams_.rssi_threshold != 0 && report.rssi < observer->scanParams_.rssi_threshold) {
+                    observer->continueScanning();
+                    break;
+                }
+                if (observer->isDuplicateReport(observer->reportHash(newAddr, report.data.p_data, report.data.len))) {
+                    observer->continueScanning();
+                    break;
+                }
             }
             if (observer->scanParams_.active && report.type.scannable && !report.type.scan_response) {
                 // Advertising data packet, scan response data is expected.
@@ -1533,8 +1654,9 @@ void BleObject::Observer::processObserverEvents(const ble_evt_t* event, void* co
             }
             ble_evt_t* observerEvent = (ble_evt_t*)BleObject::getInstance().dispatcher()->allocEventData(sizeof(ble_evt_t));
             if (!observerEvent) {
-                LOG(ERROR, "Allocate memory for BLE event failed.");
-                observer->stopScanning();
+                // The event thread can't keep up with the incoming reports. Drop this one.
+                LOG_DEBUG(WARN, "Allocate memory for BLE event failed.");
+                observer->continueScanning();
                 break;
             }
             // Copy the SoftDevice event.
@@ -1543,9 +1665,9 @@ void BleObject::Observer::processObserverEvents(const ble_evt_t* event, void* co
             if (event->evt.gap_evt.params.adv_report.data.len > 0) {
                 advReport.data.p_data = (uint8_t*)BleObject::getInstance().dispatcher()->allocEventData(advReport.data.len);
                 if (!advReport.data.p_data) {
-                    LOG(ERROR, "Allocate memory for adv report data failed.");
+                    LOG_DEBUG(WARN, "Allocate memory for adv report data failed.");
                     BleObject::getInstance().dispatcher()->freeEventData(observerEvent);
-                    observer->stopScanning();
+                    observer->continueScanning();
                     break;
                 }
                 // Copy the advertising packet data payload.
@@ -1818,6 +1940,69 @@ int BleObject::ConnectionsManager::updateConnectionParams(hal_ble_conn_handle_t
     return SYSTEM_ERROR_NONE;
 }
 
+int BleObject::ConnectionsManager::setThroughput(hal_ble_conn_handle_t connHandle, uint32_t throughput) {
+    BleConnection* connection = fetchConnection(connHandle);
+    CHECK_TRUE(connection, SYSTEM_ERROR_NOT_FOUND);
+    CHECK_TRUE(connection->info.role == BLE_ROLE_CENTRAL, SYSTEM_ERROR_NOT_SUPPORTED);
+    if (throughput && !connection->throughput) {
+        // Longer packets and the 2M PHY make the connection events of the link shorter.
+        requestDataLengthAndPhyUpdate(connHandle);
+    }
+    connection->throughput = throughput;
+    if (!throughput && connHandle < BLE_MAX_LINK_COUNT) {
+        scheduledIntervals_[connHandle] = 0;
+    }
+    scheduleCentralLinks();
+    return SYSTEM_ERROR_NONE;
+}
+
+/*
+ * The connection events of the central links are scheduled back to back: the base interval is the
+ * shortest one in which every central link gets an event of BLE_CENTRAL_EVENT_LENGTH. A link is
+ * given the longest power-of-two multiple of the base interval that still carries its requested
+ * throughput, so that the anchor points of the links don't drift into each other.
+ */
+void BleObject::ConnectionsManager::scheduleCentralLinks() {
+    uint32_t count = 0;
+    for (const auto& connection : connections_) {
+        if (connection.info.role == BLE_ROLE_CENTRAL) {
+            count++;
+        }
+    }
+    const uint32_t base = std::max<uint32_t>(count * BLE_CENTRAL_EVENT_LENGTH, BLE_SIG_CP_MIN_CONN_INTERVAL_MIN);
+    for (auto& connection : connections_) {
+        if (connection.info.role != BLE_ROLE_CENTRAL || !connection.throughput) {
+            continue;
+        }
+        // Interval at which a single connection event carries the requested throughput.
+        const uint32_t needed = BLE_CENTRAL_EVENT_LENGTH * BLE_CENTRAL_EVENT_UNIT_PAYLOAD * (1000000 / BLE_UNIT_1_25_MS) /
+                connection.throughput;
+        uint32_t interval = base;
+        while (interval * 2 <= needed && interval * 2 <= BLE_CENTRAL_MAX_SCHEDULED_CONN_INTERVAL) {
+            interval *= 2;
+        }
+        const hal_ble_conn_handle_t connHandle = connection.info.conn_handle;
+        if (connHandle < BLE_MAX_LINK_COUNT) {
+            scheduledIntervals_[connHandle] = interval;
+        }
+        if (connection.info.conn_params.max_conn_interval == interval) {
+            continue;
+        }
+        ble_gap_conn_params_t bleGapConnParams = {};
+        bleGapConnParams.min_conn_interval = interval;
+        bleGapConnParams.max_conn_interval = interval;
+        bleGapConnParams.slave_latency = connection.info.conn_params.slave_latency;
+        // The supervision timeout must be longer than (1 + latency) * interval * 2.
+        const uint32_t minTimeout = (bleGapConnParams.slave_latency + 1) * interval / 4 + 1;
+        bleGapConnParams.conn_sup_timeout = std::max<uint32_t>(connection.info.conn_params.conn_sup_timeout, minTimeout);
+        LOG_DEBUG(TRACE, "Scheduling central link %d, interval: %d*1.25ms", connHandle, (int)interval);
+        int ret = sd_ble_gap_conn_param_update(connHandle, &bleGapConnParams);
+        if (ret != NRF_SUCCESS) {
+            LOG(ERROR, "sd_ble_gap_conn_param_update() failed: %u", (unsigned)ret);
+        }
+    }
+}
+
 int BleObject::ConnectionsManager::getConnectionInfo(hal_ble_conn_handle_t connHandle, hal_ble_conn_info_t* info) {
     const BleConnection* connection = fetchConnection(connHandle);
     CHECK_TRUE(connection, SYSTEM_ERROR_NOT_FOUND);
@@ -2034,6 +2219,8 @@ int BleObject::ConnectionsManager::processConnectedEventFromThread(const ble_evt
         // Update connection parameters if needed.
         connParamsUpdateAttempts_ = 0;
         initiateConnParamsUpdateIfNeeded(&connection);
+        // Request the maximum data length and the 2M PHY to speed up bulk transfers.
+        requestDataLengthAndPhyUpdate(connection.info.conn_handle);
         // Notify the connected event.
         hal_ble_link_evt_t linkEvent = {};
         linkEvent.type = BLE_EVT_CONNECTED;
@@ -2048,6 +2235,10 @@ int BleObject::ConnectionsManager::processConnectedEventFromThread(const ble_evt
             attMtuExchangeConnHandle_ = event->evt.gap_evt.conn_handle;
         }
     }
+    if (connection.info.role == BLE_ROLE_CENTRAL) {
+        // The links with a requested throughput share the radio time with the new link.
+        scheduleCentralLinks();
+    }
     // If the connection is initiated by Central.
     if (isConnecting_ && connection.info.role == BLE_ROLE_CENTRAL && addressEqual(connection.info.address, connectingAddr_)) {
         isConnecting_ = false;
@@ -2056,6 +2247,21 @@ int BleObject::ConnectionsManager::processConnectedEventFromThread(const ble_evt
     return SYSTEM_ERROR_NONE;
 }
 
+void BleObject::ConnectionsManager::requestDataLengthAndPhyUpdate(hal_ble_conn_handle_t connHandle) const {
+    // Let the SoftDevice choose the parameters based on NRF_SDH_BLE_GAP_DATA_LENGTH.
+    int ret = sd_ble_gap_data_length_update(connHandle, nullptr, nullptr);
+    if (ret != NRF_SUCCESS) {
+        LOG_DEBUG(TRACE, "sd_ble_gap_data_length_update() failed: %u", (unsigned)ret);
+    }
+    ble_gap_phys_t phys = {};
+    phys.tx_phys = BLE_GAP_PHY_2MBPS;
+    phys.rx_phys = BLE_GAP_PHY_2MBPS;
+    ret = sd_ble_gap_phy_update(connHandle, &phys);
+    if (ret != NRF_SUCCESS) {
+        LOG_DEBUG(TRACE, "sd_ble_gap_phy_update() failed: %u", (unsigned)ret);
+    }
+}
+
 int BleObject::ConnectionsManager::processDisconnectedEventFromThread(const ble_evt_t* event) {
     const ble_gap_evt_disconnected_t& disconnected = event->evt.gap_evt.params.disconnected;
     BleConnection* connection = fetchConnection(event->evt.gap_evt.conn_handle);
@@ -2086,6 +2292,8 @@ int BleObject::ConnectionsManager::processDisconnectedEventFromThread(const ble_
     BleObject::getInstance().gatts()->removeSubscriberFromAllCharacteristics(connection->info.conn_handle);
     // Remove the publishers on this connection.
     BleObject::getInstance().gattc()->removeAllPublishersOfConnection(connection->info.conn_handle);
+    // The cached GATT database of the peer has to be validated again on the next connection.
+    BleObject::getInstance().gattc()->invalidatePeerDatabase(connection->info.conn_handle, false);
     // If the disconnection is initiated by application.
     if (disconnectingHandle_ == connection->info.conn_handle) {
         os_semaphore_give(disconnectSemaphore_, false);
@@ -2097,7 +2305,15 @@ int BleObject::ConnectionsManager::processDisconnectedEventFromThread(const ble_
         linkEvent.params.disconnected.reason = disconnected.reason;
         notifyLinkEvent(linkEvent);
     }
-    removeConnection(connection->info.conn_handle);
+    const hal_ble_conn_handle_t connHandle = connection->info.conn_handle;
+    const bool central = (connection->info.role == BLE_ROLE_CENTRAL);
+    removeConnection(connHandle);
+    if (connHandle < BLE_MAX_LINK_COUNT) {
+        scheduledIntervals_[connHandle] = 0;
+    }
+    if (central) {
+        scheduleCentralLinks();
+    }
     return SYSTEM_ERROR_NONE;
 }
 
@@ -2192,7 +2408,15 @@ void BleObject::ConnectionsManager::processConnectionEvents(const ble_evt_t* eve
         }
         case BLE_GAP_EVT_CONN_PARAM_UPDATE_REQUEST: {
             LOG_DEBUG(TRACE, "BLE GAP event: connection parameter update request.");
-            int ret = sd_ble_gap_conn_param_update(event->evt.gap_evt.conn_handle, &event->evt.gap_evt.params.conn_param_update_request.conn_params);
+            const hal_ble_conn_handle_t connHandle = event->evt.gap_evt.conn_handle;
+            ble_gap_conn_params_t bleGapConnParams = event->evt.gap_evt.params.conn_param_update_request.conn_params;
+            // Keep the interval assigned by the scheduler, unless it's incompatible with the requested timeout.
+            const uint32_t interval = (connHandle < BLE_MAX_LINK_COUNT) ? connMgr->scheduledIntervals_[connHandle] : 0;
+            if (interval && (uint32_t)bleGapConnParams.conn_sup_timeout * 4 > (bleGapConnParams.slave_latency + 1) * interval) {
+                bleGapConnParams.min_conn_interval = interval;
+                bleGapConnParams.max_conn_interval = interval;
+            }
+            int ret = sd_ble_gap_conn_param_update(connHandle, &bleGapConnParams);
             if (ret != NRF_SUCCESS) {
                 LOG(ERROR, "sd_ble_gap_conn_param_update() failed: %u", (unsigned)ret);
             }
@@ -2434,16 +2658,33 @@ ssize_t BleObject::GattServer::notifyValue(hal_ble_attr_handle_t attrHandle, con
         hvxParams.offset = 0;
         hvxParams.p_data = buf;
         hvxParams.p_len = &hvxLen;
+        os_semaphore_take(hvxSemaphore_, 0, false); // Discard a completion of a previously queued notification
+        currHvxType_ = hvxParams.type;
+        currHvxConnHandle_ = subscriber.connHandle;
+        isHvxing_ = true;
         int ret = sd_ble_gatts_hvx(subscriber.connHandle, &hvxParams);
+        // Notifications are queued in the SoftDevice, so that several of them can be sent in a
+        // single connection event. Wait for a queued notification to be sent only if the queue is full.
+        while (ret == NRF_ERROR_RESOURCES && hvxParams.type == BLE_GATT_HVX_NOTIFICATION) {
+            if (os_semaphore_take(hvxSemaphore_, BLE_OPERATION_TIMEOUT_MS, false)) {
+                SPARK_ASSERT(false);
+                break;
+            }
+            isHvxing_ = true;
+            ret = sd_ble_gatts_hvx(subscriber.connHandle, &hvxParams);
+        }
         if (ret != NRF_SUCCESS) {
             LOG(ERROR, "sd_ble_gatts_hvx() failed: %u", (unsigned)ret);
+            isHvxing_ = false;
+            currHvxConnHandle_ = BLE_INVALID_CONN_HANDLE;
             continue;
         }
-        isHvxing_ = true;
-        currHvxConnHandle_ = subscriber.connHandle;
-        if (os_semaphore_take(hvxSemaphore_, BLE_OPERATION_TIMEOUT_MS, false)) {
-            SPARK_ASSERT(false);
-            break;
+        if (hvxParams.type == BLE_GATT_HVX_INDICATION) {
+            // Wait until the indication is confirmed.
+            if (os_semaphore_take(hvxSemaphore_, BLE_OPERATION_TIMEOUT_MS, false)) {
+                SPARK_ASSERT(false);
+                break;
+            }
         }
         isHvxing_ = false;
         currHvxConnHandle_ = BLE_INVALID_CONN_HANDLE;
@@ -2452,6 +2693,61 @@ ssize_t BleObject::GattServer::notifyValue(hal_ble_attr_handle_t attrHandle, con
     return std::min(len, (size_t)BLE_MAX_ATTR_VALUE_PACKET_SIZE);
 }
 
+ssize_t BleObject::GattServer::notifyValues(hal_ble_attr_handle_t attrHandle, const hal_ble_notify_value_t* values, size_t count) {
+    CHECK_TRUE(attrHandle, SYSTEM_ERROR_INVALID_ARGUMENT);
+    CHECK_TRUE(values, SYSTEM_ERROR_INVALID_ARGUMENT);
+    CHECK_TRUE(count, SYSTEM_ERROR_INVALID_ARGUMENT);
+    for (size_t i = 0; i < count; i++) {
+        CHECK_TRUE(values[i].data, SYSTEM_ERROR_INVALID_ARGUMENT);
+        CHECK_TRUE(values[i].len, SYSTEM_ERROR_INVALID_ARGUMENT);
+    }
+    BleCharacteristic* characteristic = findCharacteristic(attrHandle);
+    CHECK_TRUE(characteristic, SYSTEM_ERROR_NOT_FOUND);
+    CHECK_TRUE(characteristic->properties & BLE_SIG_CHAR_PROP_NOTIFY, SYSTEM_ERROR_NOT_SUPPORTED);
+    // NOTE: Only one peripheral link is supported, so a local characteristic has at most one subscriber.
+    size_t queued = 0;
+    for (; queued < count; queued++) {
+        bool full = false;
+        for (const auto& subscriber : characteristic->subscribers) {
+            if (subscriber.connHandle == BLE_INVALID_CONN_HANDLE || !(subscriber.config & BLE_SIG_CCCD_VAL_NOTIFICATION)) {
+                continue;
+            }
+            ble_gatts_hvx_params_t hvxParams = {};
+            uint16_t hvxLen = std::min(values[queued].len, (size_t)BLE_ATTR_VALUE_PACKET_SIZE(BleObject::getInstance().connMgr()->getAttMtu(subscriber.connHandle)));
+            hvxParams.type = BLE_GATT_HVX_NOTIFICATION;
+            hvxParams.handle = attrHandle;
+            hvxParams.offset = 0;
+            hvxParams.p_data = values[queued].data;
+            hvxParams.p_len = &hvxLen;
+            int ret = sd_ble_gatts_hvx(subscriber.connHandle, &hvxParams);
+            if (ret == NRF_ERROR_RESOURCES) {
+                full = true; // TX buffers are full
+                break;
+            }
+            if (ret != NRF_SUCCESS) {
+                LOG(ERROR, "sd_ble_gatts_hvx() failed: %u", (unsigned)ret);
+            }
+        }
+        if (full) {
+            break;
+        }
+    }
+    return queued;
+}
+
+void BleObject::GattServer::setTxCompleteCallback(hal_ble_on_tx_complete_cb_t callback, void* context) {
+    txCompleteContext_ = context;
+    txCompleteCallback_ = callback;
+}
+
+int BleObject::GattServer::processTxCompleteEventFromThread(const ble_evt_t* event) {
+    const auto callback = txCompleteCallback_;
+    if (callback) {
+        callback(event->evt.gatts_evt.conn_handle, event->evt.gatts_evt.params.hvn_tx_complete.count, txCompleteContext_);
+    }
+    return SYSTEM_ERROR_NONE;
+}
+
 ssize_t BleObject::GattServer::getValue(hal_ble_attr_handle_t attrHandle, uint8_t* buf, size_t len) {
     CHECK_TRUE(attrHandle, SYSTEM_ERROR_INVALID_ARGUMENT);
     CHECK_TRUE(buf, SYSTEM_ERROR_INVALID_ARGUMENT);
@@ -2596,15 +2892,27 @@ void BleObject::GattServer::processGattServerEvents(const ble_evt_t* event, void
         }
         case BLE_GATTS_EVT_HVN_TX_COMPLETE: {
             LOG_DEBUG(TRACE, "BLE GATT Server event: notification sent.");
-            if (gatts->isHvxing_ && gatts->currHvxConnHandle_ == event->evt.gatts_evt.conn_handle) {
+            if (gatts->isHvxing_ && gatts->currHvxType_ == BLE_GATT_HVX_NOTIFICATION &&
+                    gatts->currHvxConnHandle_ == event->evt.gatts_evt.conn_handle) {
                 gatts->isHvxing_ = false;
                 os_semaphore_give(gatts->hvxSemaphore_, false);
             }
+            if (gatts->txCompleteCallback_) {
+                // Notify the application that there are free TX buffers.
+                ble_evt_t* txCompleteEvent = (ble_evt_t*)BleObject::getInstance().dispatcher()->allocEventData(sizeof(ble_evt_t));
+                if (!txCompleteEvent) {
+                    LOG(ERROR, "Allocate memory for TX complete event failed.");
+                    break;
+                }
+                memcpy(txCompleteEvent, event, sizeof(ble_evt_t));
+                BleObject::getInstance().dispatcher()->enqueue(&txCompleteEvent);
+            }
             break;
         }
         case BLE_GATTS_EVT_HVC: {
             LOG_DEBUG(TRACE, "BLE GATT Server event: indication confirmed.");
-            if (gatts->isHvxing_ && gatts->currHvxConnHandle_ == event->evt.gatts_evt.conn_handle) {
+            if (gatts->isHvxing_ && gatts->currHvxType_ == BLE_GATT_HVX_INDICATION &&
+                    gatts->currHvxConnHandle_ == event->evt.gatts_evt.conn_handle) {
                 gatts->isHvxing_ = false;
                 os_semaphore_give(gatts->hvxSemaphore_, false);
             }
@@ -2678,6 +2986,23 @@ bool BleObject::GattClient::discovering(hal_ble_conn_handle_t connHandle) const
 int BleObject::GattClient::discoverServices(hal_ble_conn_handle_t connHandle, const hal_ble_uuid_t* uuid, hal_ble_on_disc_service_cb_t callback, void* context) {
     CHECK_TRUE(BleObject::getInstance().connMgr()->valid(connHandle), SYSTEM_ERROR_NOT_FOUND);
     CHECK_FALSE(isDiscovering_, SYSTEM_ERROR_INVALID_STATE);
+    if (loadPeerDatabase(connHandle)) {
+        const PeerDatabase* peer = peerDatabase(connHandle);
+        Vector<hal_ble_svc_t> services;
+        for (const auto& service : peer->db.services) {
+            if (!uuid || uuidEqual(service.uuid, *uuid)) {
+                CHECK_TRUE(services.append(service), SYSTEM_ERROR_NO_MEMORY);
+            }
+        }
+        if (callback) {
+            hal_ble_svc_discovered_evt_t svcDiscEvent = {};
+            svcDiscEvent.conn_handle = connHandle;
+            svcDiscEvent.count = services.size();
+            svcDiscEvent.services = services.data();
+            callback(&svcDiscEvent, context);
+        }
+        return SYSTEM_ERROR_NONE;
+    }
     SCOPE_GUARD ({
         resetDiscoveryState();
     });
@@ -2700,12 +3025,32 @@ int BleObject::GattClient::discoverServices(hal_ble_conn_handle_t connHandle, co
         SPARK_ASSERT(false);
         return SYSTEM_ERROR_TIMEOUT;
     }
+    if (discoverAll_) {
+        collectPeerServices(connHandle);
+    }
     return SYSTEM_ERROR_NONE;
 }
 
 int BleObject::GattClient::discoverCharacteristics(hal_ble_conn_handle_t connHandle, const hal_ble_svc_t* service, hal_ble_on_disc_char_cb_t callback, void* context) {
     CHECK_TRUE(BleObject::getInstance().connMgr()->valid(connHandle), SYSTEM_ERROR_NOT_FOUND);
     CHECK_FALSE(isDiscovering_, SYSTEM_ERROR_INVALID_STATE);
+    const PeerDatabase* peer = peerDatabase(connHandle);
+    if (peer && peer->valid) {
+        Vector<hal_ble_char_t> characteristics;
+        for (const auto& characteristic : peer->db.characteristics) {
+            if (characteristic.charHandles.decl_handle >= service->start_handle && characteristic.charHandles.decl_handle <= service->end_handle) {
+                CHECK_TRUE(characteristics.append(characteristic), SYSTEM_ERROR_NO_MEMORY);
+            }
+        }
+        if (callback) {
+            hal_ble_char_discovered_evt_t charDiscEvent = {};
+            charDiscEvent.conn_handle = connHandle;
+            charDiscEvent.count = characteristics.size();
+            charDiscEvent.characteristics = characteristics.data();
+            callback(&charDiscEvent, context);
+        }
+        return SYSTEM_ERROR_NONE;
+    }
     SCOPE_GUARD ({
         resetDiscoveryState();
     });
@@ -2724,6 +3069,7 @@ int BleObject::GattClient::discoverCharacteristics(hal_ble_conn_handle_t connHan
         SPARK_ASSERT(false);
         return SYSTEM_ERROR_TIMEOUT;
     }
+    collectPeerCharacteristics(connHandle, currDiscSvc_);
     return SYSTEM_ERROR_NONE;
 }
 
@@ -2782,6 +3128,214 @@ ssize_t BleObject::GattClient::readAttribute(hal_ble_conn_handle_t connHandle, h
     return readLen_;
 }
 
+ssize_t BleObject::GattClient::readValues(hal_ble_gatt_read_t* reads, size_t count) {
+    CHECK_TRUE(reads, SYSTEM_ERROR_INVALID_ARGUMENT);
+    CHECK_TRUE(!isReading_ && !batchReads_, SYSTEM_ERROR_BUSY);
+    for (size_t i = 0; i < count; i++) {
+        reads[i].result = (reads[i].buf && reads[i].len) ? BLE_READ_STATE_PENDING : SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    SCOPE_GUARD ({
+        batchReads_ = nullptr;
+        batchReadCount_ = 0;
+    });
+    batchReads_ = reads;
+    batchReadCount_ = count;
+    // The semaphore is given whenever a read completes, the next read on that link is then started.
+    while (startBatchReads()) {
+        if (os_semaphore_take(readSemaphore_, BLE_OPERATION_TIMEOUT_MS, false)) {
+            break;
+        }
+    }
+    ssize_t completed = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (reads[i].result > 0) {
+            reads[i].result = SYSTEM_ERROR_TIMEOUT;
+        } else if (reads[i].result == 0) {
+            completed++;
+        }
+    }
+    return completed;
+}
+
+bool BleObject::GattClient::startBatchReads() {
+    bool inFlight = false;
+    for (size_t i = 0; i < batchReadCount_; i++) {
+        hal_ble_gatt_read_t& read = batchReads_[i];
+        if (read.result == BLE_READ_STATE_IN_FLIGHT) {
+            inFlight = true;
+            continue;
+        }
+        // Only one read request can be outstanding on a link.
+        if (read.result != BLE_READ_STATE_PENDING || batchReadInFlight(read.conn_handle)) {
+            continue;
+        }
+        if (!BleObject::getInstance().connMgr()->valid(read.conn_handle)) {
+            read.result = SYSTEM_ERROR_NOT_FOUND;
+            continue;
+        }
+        read.len = std::min(read.len, (size_t)BLE_ATTR_VALUE_PACKET_SIZE(BleObject::getInstance().connMgr()->getAttMtu(read.conn_handle)));
+        read.result = BLE_READ_STATE_IN_FLIGHT;
+        int ret = sd_ble_gattc_read(read.conn_handle, read.value_handle, 0);
+        if (ret != NRF_SUCCESS) {
+            read.result = nrf_system_error(ret);
+            continue;
+        }
+        inFlight = true;
+    }
+    return inFlight;
+}
+
+bool BleObject::GattClient::batchReadInFlight(hal_ble_conn_handle_t connHandle) const {
+    for (size_t i = 0; i < batchReadCount_; i++) {
+        if (batchReads_[i].conn_handle == connHandle && batchReads_[i].result == BLE_READ_STATE_IN_FLIGHT) {
+            return true;
+        }
+    }
+    return false;
+}
+
+BleObject::GattClient::PeerDatabase* BleObject::GattClient::peerDatabase(hal_ble_conn_handle_t connHandle) {
+    if (connHandle >= BLE_MAX_LINK_COUNT) {
+        return nullptr;
+    }
+    return &peerDbs_[connHandle];
+}
+
+/*
+ * Loads the cached attribute table of the peer on the first discovery after connecting to it.
+ * Returns true if the discovery can be served from the cache.
+ */
+bool BleObject::GattClient::loadPeerDatabase(hal_ble_conn_handle_t connHandle) {
+    PeerDatabase* peer = peerDatabase(connHandle);
+    if (!peer) {
+        return false;
+    }
+    hal_ble_conn_info_t info = {};
+    if (BleObject::getInstance().connMgr()->getConnectionInfo(connHandle, &info) != SYSTEM_ERROR_NONE) {
+        return false;
+    }
+    if (peer->valid && addressEqual(peer->address, info.address)) {
+        return true;
+    }
+    if (peer->changed) {
+        GattCache::remove(peer->address);
+    }
+    peer->valid = false;
+    peer->collecting = false;
+    peer->changed = false;
+    peer->address = info.address;
+    peer->db.services.clear();
+    peer->db.characteristics.clear();
+    peer->discoveredServices.clear();
+    if (GattCache::load(info.address, &peer->db) != SYSTEM_ERROR_NONE) {
+        return false;
+    }
+    if (peer->db.hashHandle != BLE_INVALID_ATTR_HANDLE) {
+        uint8_t hash[BLE_GATT_DATABASE_HASH_LEN] = {};
+        if (readAttribute(connHandle, peer->db.hashHandle, hash, sizeof(hash)) != (ssize_t)sizeof(hash) || memcmp(hash, peer->db.hash, sizeof(hash))) {
+            LOG(TRACE, "GATT database of the peer has changed.");
+            GattCache::remove(info.address);
+            peer->db.services.clear();
+            peer->db.characteristics.clear();
+            return false;
+        }
+    }
+    LOG_DEBUG(TRACE, "Using the cached GATT database of the peer.");
+    peer->valid = true;
+    return true;
+}
+
+void BleObject::GattClient::collectPeerServices(hal_ble_conn_handle_t connHandle) {
+    PeerDatabase* peer = peerDatabase(connHandle);
+    if (!peer || peer->valid || discServices_.isEmpty() || discServices_.size() > (int)GattCache::MAX_SERVICE_COUNT) {
+        return;
+    }
+    peer->db.characteristics.clear();
+    peer->discoveredServices.clear();
+    peer->db.services = discServices_;
+    peer->collecting = true;
+}
+
+void BleObject::GattClient::collectPeerCharacteristics(hal_ble_conn_handle_t connHandle, const hal_ble_svc_t& service) {
+    PeerDatabase* peer = peerDatabase(connHandle);
+    if (!peer || !peer->collecting || !BleObject::getInstance().connMgr()->valid(connHandle)) {
+        return;
+    }
+    bool known = false;
+    for (const auto& svc : peer->db.services) {
+        if (svc.start_handle == service.start_handle && svc.end_handle == service.end_handle) {
+            known = true;
+            break;
+        }
+    }
+    if (!known || peer->discoveredServices.contains(service.start_handle)) {
+        return;
+    }
+    if (peer->db.characteristics.size() + discCharacteristics_.size() > (int)GattCache::MAX_CHARACTERISTIC_COUNT ||
+            !peer->db.characteristics.append(discCharacteristics_) || !peer->discoveredServices.append(service.start_handle)) {
+        peer->collecting = false;
+        return;
+    }
+    if (peer->discoveredServices.size() == peer->db.services.size()) {
+        savePeerDatabase(connHandle, peer);
+    }
+}
+
+void BleObject::GattClient::savePeerDatabase(hal_ble_conn_handle_t connHandle, PeerDatabase* peer) {
+    peer->collecting = false;
+    GattCache::Database& db = peer->db;
+    db.hashHandle = BLE_INVALID_ATTR_HANDLE;
+    db.serviceChangedHandle = BLE_INVALID_ATTR_HANDLE;
+    memset(db.hash, 0, sizeof(db.hash));
+    hal_ble_attr_handle_t serviceChangedCccd = BLE_INVALID_ATTR_HANDLE;
+    for (const auto& characteristic : db.characteristics) {
+        if (characteristic.uuid.type != BLE_UUID_TYPE_16BIT) {
+            continue;
+        }
+        if (characteristic.uuid.uuid16 == BLE_SIG_UUID_DATABASE_HASH_CHAR) {
+            db.hashHandle = characteristic.charHandles.value_handle;
+        } else if (characteristic.uuid.uuid16 == BLE_SIG_UUID_SERVICE_CHANGED_CHAR) {
+            db.serviceChangedHandle = characteristic.charHandles.value_handle;
+            serviceChangedCccd = characteristic.charHandles.cccd_handle;
+        }
+    }
+    if (db.hashHandle != BLE_INVALID_ATTR_HANDLE) {
+        if (readAttribute(connHandle, db.hashHandle, db.hash, sizeof(db.hash)) != (ssize_t)sizeof(db.hash)) {
+            return;
+        }
+    } else if (db.serviceChangedHandle != BLE_INVALID_ATTR_HANDLE && serviceChangedCccd != BLE_INVALID_ATTR_HANDLE) {
+        // Changes of the database can only be detected through the Service Changed indication.
+        const uint8_t value[2] = { BLE_SIG_CCCD_VAL_INDICATION, 0x00 };
+        if (writeAttribute(connHandle, serviceChangedCccd, value, sizeof(value), true) != (ssize_t)sizeof(value)) {
+            return;
+        }
+    } else {
+        LOG_DEBUG(TRACE, "Changes of the peer's GATT database can't be detected, not caching it.");
+        return;
+    }
+    if (GattCache::save(peer->address, db) != SYSTEM_ERROR_NONE) {
+        LOG(ERROR, "Failed to cache the GATT database of the peer.");
+        return;
+    }
+    peer->valid = true;
+}
+
+/*
+ * This is called from the BLE event thread, so it doesn't touch the cached table itself. The
+ * file of a changed database is removed by the next discovery on that connection handle.
+ */
+void BleObject::GattClient::invalidatePeerDatabase(hal_ble_conn_handle_t connHandle, bool changed) {
+    PeerDatabase* peer = peerDatabase(connHandle);
+    if (!peer) {
+        return;
+    }
+    peer->valid = false;
+    peer->collecting = false;
+    if (changed) {
+        peer->changed = true;
+    }
+}
+
 void BleObject::GattClient::resetDiscoveryState() {
     discoverAll_ = false;
     isDiscovering_ = false;
@@ -3090,6 +3644,23 @@ int BleObject::GattClient::processDataReadEventFromThread(const ble_evt_t* event
             return SYSTEM_ERROR_INVALID_STATE;
         }
     }
+    // This event may be responding to a batched read.
+    for (size_t i = 0; batchReads_ && i < batchReadCount_; i++) {
+        hal_ble_gatt_read_t& read = batchReads_[i];
+        if (read.result != BLE_READ_STATE_IN_FLIGHT || read.conn_handle != event->evt.gattc_evt.conn_handle) {
+            continue;
+        }
+        if (event->evt.gattc_evt.gatt_status == BLE_GATT_STATUS_SUCCESS && read.value_handle == readRsp.handle) {
+            read.len = std::min(read.len, (size_t)readRsp.len);
+            memcpy(read.buf, readRsp.data, read.len);
+            read.result = SYSTEM_ERROR_NONE;
+        } else {
+            LOG(ERROR, "BLE read characteristic failed: %d, handle: %d.", event->evt.gattc_evt.gatt_status, event->evt.gattc_evt.error_handle);
+            read.result = SYSTEM_ERROR_PROTOCOL;
+        }
+        os_semaphore_give(readSemaphore_, false);
+        return SYSTEM_ERROR_NONE;
+    }
     // Otherwise, this event is responding to the read command.
     if (isReading_ && currReadConnHandle_ == event->evt.gattc_evt.conn_handle) {
         if (event->evt.gattc_evt.gatt_status == BLE_GATT_STATUS_SUCCESS) {
@@ -3114,6 +3685,11 @@ int BleObject::GattClient::processDataNotifiedEventFromThread(ble_evt_t* event)
             LOG(ERROR, "sd_ble_gattc_hv_confirm() failed: %u", (unsigned)ret);
             return nrf_system_error(ret);
         }
+        const PeerDatabase* peer = peerDatabase(event->evt.gattc_evt.conn_handle);
+        if (peer && peer->db.serviceChangedHandle != BLE_INVALID_ATTR_HANDLE && peer->db.serviceChangedHandle == hvx.handle) {
+            LOG(TRACE, "GATT database of the peer has changed.");
+            invalidatePeerDatabase(event->evt.gattc_evt.conn_handle, true);
+        }
     }
     hal_ble_char_evt_t charEvent = {};
     charEvent.conn_handle = event->evt.gattc_evt.conn_handle;
@@ -3222,6 +3798,14 @@ void BleObject::GattClient::processGattClientEvents(const ble_evt_t* event, void
                     gattc->isReading_ = false;
                     os_semaphore_give(gattc->readSemaphore_, false);
                 }
+                for (size_t i = 0; gattc->batchReads_ && i < gattc->batchReadCount_; i++) {
+                    hal_ble_gatt_read_t& read = gattc->batchReads_[i];
+                    if (read.result == BLE_READ_STATE_IN_FLIGHT && read.conn_handle == event->evt.gattc_evt.conn_handle) {
+                        read.result = SYSTEM_ERROR_NO_MEMORY;
+                        os_semaphore_give(gattc->readSemaphore_, false);
+                        break;
+                    }
+                }
                 break;
             }
             memcpy(readRspEvent, event, sizeof(ble_evt_t));
@@ -3292,6 +3876,12 @@ int BleObject::init() {
     uint32_t appRamStart = 0;
     int ret = nrf_sdh_ble_default_cfg_set(BLE_CONN_CFG_TAG, &appRamStart);
     CHECK_NRF_RETURN(ret, nrf_system_error(ret));
+    // Allow several notifications to be sent in a single connection event.
+    ble_cfg_t bleCfg = {};
+    bleCfg.conn_cfg.conn_cfg_tag = BLE_CONN_CFG_TAG;
+    bleCfg.conn_cfg.params.gatts_conn_cfg.hvn_tx_queue_size = BLE_HVN_TX_QUEUE_SIZE;
+    ret = sd_ble_cfg_set(BLE_CONN_CFG_GATTS, &bleCfg, appRamStart);
+    CHECK_NRF_RETURN(ret, nrf_system_error(ret));
     LOG_DEBUG(TRACE, "APP RAM start: 0x%08x", (unsigned)appRamStart);
     // Enable the stack
     uint32_t sdRamEnd = appRamStart;
@@ -3302,6 +3892,11 @@ int BleObject::init() {
     }
     SPARK_ASSERT(sdRamEnd < appRamStart);
     CHECK_NRF_RETURN(ret, nrf_system_error(ret));
+    // Extend connection events while there is data to be transferred.
+    ble_opt_t bleOpt = {};
+    bleOpt.common_opt.conn_evt_ext.enable = 1;
+    ret = sd_ble_opt_set(BLE_COMMON_OPT_CONN_EVT_EXT, &bleOpt);
+    CHECK_NRF_RETURN(ret, nrf_system_error(ret));
     /*
      * NOTE: Once the following initializations are successful, the pointers are associated with SoftDevice
      * event handler. Thus we cannot destroy these pointers, unless the whole BLE stack is disabled, which
@@ -3728,6 +4323,13 @@ int hal_ble_gap_update_connection_params(hal_ble_conn_handle_t conn_handle, cons
     return BleObject::getInstance().connMgr()->updateConnectionParams(conn_handle, conn_params);
 }
 
+int hal_ble_gap_set_link_throughput(hal_ble_conn_handle_t conn_handle, uint32_t throughput, void* reserved) {
+    BleLock lk;
+    LOG_DEBUG(TRACE, "hal_ble_gap_set_link_throughput().");
+    CHECK_TRUE(BleObject::getInstance().initialized(), SYSTEM_ERROR_INVALID_STATE);
+    return BleObject::getInstance().connMgr()->setThroughput(conn_handle, throughput);
+}
+
 int hal_ble_gap_get_connection_info(hal_ble_conn_handle_t conn_handle, hal_ble_conn_info_t* info, void* reserved) {
     BleLock lk;
     LOG_DEBUG(TRACE, "hal_ble_gap_get_connection_info().");
@@ -3780,6 +4382,21 @@ ssize_t hal_ble_gatt_server_notify_characteristic_value(hal_ble_attr_handle_t va
     return BleObject::getInstance().gatts()->notifyValue(value_handle, buf, len, false);
 }
 
+ssize_t hal_ble_gatt_server_notify_characteristic_values(hal_ble_attr_handle_t value_handle, const hal_ble_notify_value_t* values, size_t count, void* reserved) {
+    BleLock lk;
+    LOG_DEBUG(TRACE, "hal_ble_gatt_server_notify_characteristic_values().");
+    CHECK_TRUE(BleObject::getInstance().initialized(), SYSTEM_ERROR_INVALID_STATE);
+    return BleObject::getInstance().gatts()->notifyValues(value_handle, values, count);
+}
+
+int hal_ble_gatt_server_set_callback_on_tx_complete(hal_ble_on_tx_complete_cb_t callback, void* context, void* reserved) {
+    BleLock lk;
+    LOG_DEBUG(TRACE, "hal_ble_gatt_server_set_callback_on_tx_complete().");
+    CHECK_TRUE(BleObject::getInstance().initialized(), SYSTEM_ERROR_INVALID_STATE);
+    BleObject::getInstance().gatts()->setTxCompleteCallback(callback, context);
+    return SYSTEM_ERROR_NONE;
+}
+
 ssize_t hal_ble_gatt_server_indicate_characteristic_value(hal_ble_attr_handle_t value_handle, const uint8_t* buf, size_t len, void* reserved) {
     BleLock lk;
     LOG_DEBUG(TRACE, "hal_ble_gatt_server_indicate_characteristic_value().");
@@ -3864,6 +4481,13 @@ ssize_t hal_ble_gatt_client_read(hal_ble_conn_handle_t conn_handle, hal_ble_attr
     return BleObject::getInstance().gattc()->readAttribute(conn_handle, value_handle, buf, len);
 }
 
+ssize_t hal_ble_gatt_client_read_values(hal_ble_gatt_read_t* reads, size_t count, void* reserved) {
+    BleLock lk;
+    LOG_DEBUG(TRACE, "hal_ble_gatt_client_read_values().");
+    CHECK_TRUE(BleObject::getInstance().initialized(), SYSTEM_ERROR_INVALID_STATE);
+    return BleObject::getInstance().gattc()->readValues(reads, count);
+}
+
 
 #if HAL_PLATFORM_BLE_BETA_COMPAT
 
@@ -72,6 +72,9 @@
 #define BLE_DEFAULT_SCANNING_WINDOW                 BLE_MSEC_TO_UNITS(50, BLE_UNIT_0_625_MS)    /* The scan window: 50ms (in units of 0.625 ms). */
 #define BLE_DEFAULT_SCANNING_TIMEOUT                BLE_MSEC_TO_UNITS(5000, BLE_UNIT_10_MS)     /* The timeout: 5000ms (in units of 10 ms. 0 for scanning forever). */
 
+/* Number of entries in the table used to filter out duplicate advertising reports */
+#define BLE_SCAN_FILTER_TABLE_SIZE                  64
+
 /* Maximum length of advertising and scan response data */
 #define BLE_MAX_ADV_DATA_LEN                        BLE_GAP_ADV_SET_DATA_SIZE_MAX
 
@@ -86,11 +89,16 @@
 #define BLE_CONN_PARAMS_UPDATE_ATTEMPS              2
 
 /* Default BLE connection parameters */
-#define BLE_DEFAULT_MIN_CONN_INTERVAL               BLE_MSEC_TO_UNITS(30, BLE_UNIT_1_25_MS)     /* The minimal connection interval: 30ms (in units of 1.25ms). */
-#define BLE_DEFAULT_MAX_CONN_INTERVAL               BLE_MSEC_TO_UNITS(45, BLE_UNIT_1_25_MS)     /* The minimal connection interval: 45ms (in units of 1.25ms). */
+#define BLE_DEFAULT_MIN_CONN_INTERVAL               BLE_MSEC_TO_UNITS(15, BLE_UNIT_1_25_MS)     /* The minimal connection interval: 15ms (in units of 1.25ms). */
+#define BLE_DEFAULT_MAX_CONN_INTERVAL               BLE_MSEC_TO_UNITS(30, BLE_UNIT_1_25_MS)     /* The maximal connection interval: 30ms (in units of 1.25ms). */
 #define BLE_DEFAULT_SLAVE_LATENCY                   0                                           /* The slave latency. */
 #define BLE_DEFAULT_CONN_SUP_TIMEOUT                BLE_MSEC_TO_UNITS(5000, BLE_UNIT_10_MS)     /* The connection supervision timeout: 5s (in units of 10ms). */
 
+/* Scheduling of the links in the central role */
+#define BLE_CENTRAL_EVENT_LENGTH                    NRF_SDH_BLE_GAP_EVENT_LENGTH                /* Length of the connection event of each link (in units of 1.25ms). */
+#define BLE_CENTRAL_EVENT_UNIT_PAYLOAD              40                                          /* Conservative estimate of the data transferred in 1.25ms of a connection event, in bytes. */
+#define BLE_CENTRAL_MAX_SCHEDULED_CONN_INTERVAL     BLE_MSEC_TO_UNITS(400, BLE_UNIT_1_25_MS)    /* The longest interval assigned by the scheduler: 400ms (in units of 1.25ms). */
+
 // Maximum supported size of an ATT packet in bytes (ATT_MTU)
 #define BLE_MAX_ATT_MTU_SIZE                        NRF_SDH_BLE_GATT_MAX_MTU_SIZE
 
@@ -25,6 +25,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "can_hal.h"
+#include "system_error.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -192,6 +193,40 @@ HAL_CAN_Errors HAL_CAN_Error_Status(HAL_CAN_Channel channel)
     return CAN_NO_ERROR;
 }
 
+/*******************************************************************************
+   Name:           HAL_CAN_Add_Filter_Ext
+   Description:    Add a mask or list filter for received CAN messages
+
+   Parameters:
+       @param channel CAN Channel (CAN1, CAN2, etc)
+       @param filter Filter configuration
+       @return true if filter added, false if too many filters already
+
+*******************************************************************************/
+bool HAL_CAN_Add_Filter_Ext(HAL_CAN_Channel channel,
+                            const struct HAL_CAN_Filter *filter,
+                            void *reserved)
+{
+    return false;
+}
+
+/*******************************************************************************
+   Name:           HAL_CAN_Get_Stats
+   Description:    Get the receive overflow counters
+
+   Parameters:
+       @param channel CAN Channel (CAN1, CAN2, etc)
+       @param stats Where the counters will be written
+       @return 0 on success, or a negative result code
+
+*******************************************************************************/
+int HAL_CAN_Get_Stats(HAL_CAN_Channel channel,
+                      struct HAL_CAN_Stats *stats,
+                      void *reserved)
+{
+    return SYSTEM_ERROR_NOT_SUPPORTED;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -42,6 +42,8 @@
 #include "logging.h"
 #include "static_recursive_mutex.h"
 #include "service_debug.h"
+#include "system_error.h"
+#include <cstring>
 
 #if PLATFORM_ID == 6 || PLATFORM_ID == 8
 # include "wwd_rtos_interface.h"
@@ -197,6 +199,41 @@ os_result_t os_thread_delay_until(system_tick_t *previousWakeTime, system_tick_t
     return 0;
 }
 
+int os_thread_get_stats(os_thread_stats_t* stats, size_t count, uint32_t* total_time, void* reserved)
+{
+    if (!stats) {
+        return uxTaskGetNumberOfTasks();
+    }
+    // Reserve a few extra entries in case new threads get created in the meantime
+    const UBaseType_t taskCount = uxTaskGetNumberOfTasks() + 2;
+    const auto tasks = static_cast<TaskStatus_t*>(pvPortMalloc(taskCount * sizeof(TaskStatus_t)));
+    if (!tasks) {
+        return SYSTEM_ERROR_NO_MEMORY;
+    }
+    uint32_t totalTime = 0;
+    const UBaseType_t n = uxTaskGetSystemState(tasks, taskCount, &totalTime);
+    size_t i = 0;
+    for (; i < n && i < count; ++i) {
+        const TaskStatus_t& t = tasks[i];
+        os_thread_stats_t& s = stats[i];
+        if (s.size < sizeof(os_thread_stats_t)) {
+            vPortFree(tasks);
+            return SYSTEM_ERROR_INVALID_ARGUMENT;
+        }
+        s.priority = t.uxCurrentPriority;
+        s.thread = t.xHandle;
+        strncpy(s.name, t.pcTaskName, sizeof(s.name) - 1);
+        s.name[sizeof(s.name) - 1] = '\0';
+        s.cpu_time = t.ulRunTimeCounter;
+        s.stack_free_min = t.usStackHighWaterMark * sizeof(StackType_t);
+    }
+    vPortFree(tasks);
+    if (total_time) {
+        *total_time = totalTime;
+    }
+    return i;
+}
+
 class ThreadQueue
 {
     QueueHandle_t queue;
@@ -427,12 +464,40 @@ int os_mutex_recursive_unlock(os_mutex_recursive_t mutex)
     return xSemaphoreGiveRecursive(static_cast<SemaphoreHandle_t>(mutex))!=pdTRUE;
 }
 
+namespace {
+
+// Only accessed while the scheduler is suspended
+unsigned sSchedulerSuspendDepth = 0;
+uint32_t sSchedulerSuspendTime = 0;
+const void* sSchedulerSuspendCaller = nullptr;
+os_scheduler_stats_t sSchedulerStats = {};
+
+} // namespace
+
 void os_thread_scheduling(bool enabled, void* reserved)
 {
-    if (enabled)
+    if (enabled) {
+        if (sSchedulerSuspendDepth > 0 && --sSchedulerSuspendDepth == 0) {
+            const uint32_t t = ulGetRunTimeCounterValue() - sSchedulerSuspendTime;
+            ++sSchedulerStats.count;
+            sSchedulerStats.total_time += t;
+            if (t > sSchedulerStats.max_time) {
+                sSchedulerStats.max_time = t;
+                sSchedulerStats.max_caller = sSchedulerSuspendCaller;
+            }
+        }
         xTaskResumeAll();
-    else
+    } else {
+        const bool running = (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING);
         vTaskSuspendAll();
+        if (sSchedulerSuspendDepth > 0) {
+            ++sSchedulerSuspendDepth;
+        } else if (running) {
+            sSchedulerSuspendDepth = 1;
+            sSchedulerSuspendCaller = __builtin_return_address(0);
+            sSchedulerSuspendTime = ulGetRunTimeCounterValue();
+        }
+    }
 }
 
 os_scheduler_state_t os_scheduler_get_state(void* reserved)
@@ -440,6 +505,24 @@ os_scheduler_state_t os_scheduler_get_state(void* reserved)
     return (os_scheduler_state_t)xTaskGetSchedulerState();
 }
 
+int os_scheduler_get_stats(os_scheduler_stats_t* stats, bool reset, void* reserved)
+{
+    if (!stats || stats->size < sizeof(os_scheduler_stats_t)) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    // Not using os_thread_scheduling() to not account this call in the statistics
+    vTaskSuspendAll();
+    stats->count = sSchedulerStats.count;
+    stats->total_time = sSchedulerStats.total_time;
+    stats->max_time = sSchedulerStats.max_time;
+    stats->max_caller = sSchedulerStats.max_caller;
+    if (reset) {
+        sSchedulerStats = {};
+    }
+    xTaskResumeAll();
+    return 0;
+}
+
 int os_semaphore_create(os_semaphore_t* semaphore, unsigned max, unsigned initial)
 {
     *semaphore = xSemaphoreCreateCounting( ( max ), ( initial ) );
@@ -57,6 +57,8 @@
 #include "flash_common.h"
 #include <nrf_pwm.h>
 #include "concurrent_hal.h"
+#include "tickless_idle.h"
+#include "boot_timeline.h"
 
 #define BACKUP_REGISTER_NUM        10
 static int32_t backup_register[BACKUP_REGISTER_NUM] __attribute__((section(".backup_registers")));
@@ -99,6 +101,9 @@ extern void* malloc_heap_end();
 #if defined(MODULAR_FIRMWARE)
 void* module_user_pre_init();
 #endif
+#if HAL_PLATFORM_NCP_EARLY_POWER_ON
+int platform_ncp_early_power_on(void);
+#endif
 
 __attribute__((externally_visible)) void prvGetRegistersFromStack( uint32_t *pulFaultStackAddress ) {
     /* These are volatile to try and prevent the compiler/linker optimising them
@@ -208,6 +213,12 @@ void UsageFault_Handler(void) {
 
 void SysTickOverride(void) {
     HAL_SysTick_Handler();
+#if configUSE_TICKLESS_IDLE
+    // Catch up with the ticks suppressed while the IDLE thread was sleeping
+    for (uint32_t ticks = hal_tickless_idle_take_suppressed_ticks(); ticks > 0; --ticks) {
+        HAL_SysTick_Handler();
+    }
+#endif
 }
 
 void SysTickChain() {
@@ -296,6 +307,8 @@ void HAL_Core_Config(void) {
 
     hal_timer_init(NULL);
 
+    boot_timeline_mark(BOOT_STAGE_START, NULL);
+
     HAL_Core_Setup_override_interrupts();
 
     HAL_RNG_Configuration();
@@ -321,6 +334,11 @@ void HAL_Core_Config(void) {
     Load_SystemFlags();
 #endif
 
+#if HAL_PLATFORM_NCP_EARLY_POWER_ON
+    // Let the modem boot while the rest of the system is being initialized
+    platform_ncp_early_power_on();
+#endif
+
     // TODO: Use current LED theme
     LED_SetRGBColor(RGB_COLOR_WHITE);
     LED_On(LED_RGB);
@@ -329,6 +347,8 @@ void HAL_Core_Config(void) {
       FLASH_INTERNAL, EXTERNAL_FLASH_FAC_XIP_ADDRESS,
       FLASH_INTERNAL, USER_FIRMWARE_IMAGE_LOCATION, FIRMWARE_IMAGE_SIZE,
       FACTORY_RESET_MODULE_FUNCTION, MODULE_VERIFY_CRC|MODULE_VERIFY_FUNCTION|MODULE_VERIFY_DESTINATION_IS_START_ADDRESS); //true to verify the CRC during copy also
+
+    boot_timeline_mark(BOOT_STAGE_HAL_CONFIG, NULL);
 }
 
 void HAL_Core_Setup(void) {
@@ -358,8 +378,8 @@ bool HAL_Core_Validate_User_Module(void)
     if (FLASH_isUserModuleInfoValid(FLASH_INTERNAL, USER_FIRMWARE_IMAGE_LOCATION, USER_FIRMWARE_IMAGE_LOCATION))
     {
         //CRC check the user module and set to module_user_part_validated
-        valid = FLASH_VerifyCRC32(FLASH_INTERNAL, USER_FIRMWARE_IMAGE_LOCATION,
-                                  FLASH_ModuleLength(FLASH_INTERNAL, USER_FIRMWARE_IMAGE_LOCATION))
+        valid = verify_module_crc32(USER_FIRMWARE_IMAGE_LOCATION,
+                                    FLASH_ModuleLength(FLASH_INTERNAL, USER_FIRMWARE_IMAGE_LOCATION))
                 && HAL_Verify_User_Dependencies();
     }
     else if(FLASH_isUserModuleInfoValid(FLASH_INTERNAL, EXTERNAL_FLASH_FAC_XIP_ADDRESS, USER_FIRMWARE_IMAGE_LOCATION))
@@ -798,6 +818,8 @@ uint32_t HAL_Core_Read_Backup_Register(uint32_t BKP_DR) {
 }
 
 extern size_t pvPortLargestFreeBlock();
+extern size_t xPortGetFreeBlockCount();
+extern size_t malloc_user_heap_used();
 
 uint32_t HAL_Core_Runtime_Info(runtime_info_t* info, void* reserved)
 {
@@ -824,6 +846,14 @@ uint32_t HAL_Core_Runtime_Info(runtime_info_t* info, void* reserved)
     		info->largest_free_block_heap = pvPortLargestFreeBlock();
     }
 
+    if (offsetof(runtime_info_t, free_blocks_heap) + sizeof(info->free_blocks_heap) <= info->size) {
+        info->free_blocks_heap = xPortGetFreeBlockCount();
+    }
+
+    if (offsetof(runtime_info_t, user_heap) + sizeof(info->user_heap) <= info->size) {
+        info->user_heap = malloc_user_heap_used();
+    }
+
     return 0;
 }
 
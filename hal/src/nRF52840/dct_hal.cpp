@@ -22,6 +22,7 @@
 #include "service_debug.h"
 
 #include "filesystem.h"
+#include "boot_timeline.h"
 
 #include <algorithm>
 #include <mutex>
@@ -158,6 +159,10 @@ private:
         }
 
         SPARK_ASSERT(close());
+
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+        boot_timeline_mark(BOOT_STAGE_DCT_LOAD, nullptr);
+#endif
     }
 
     void deinit() {
@@ -19,6 +19,7 @@
 #include "eeprom_hal_impl.h"
 #include "filesystem.h"
 #include "static_recursive_mutex.h"
+#include "system_error.h"
 
 #include <algorithm>
 #include <mutex>
@@ -217,3 +218,15 @@ bool HAL_EEPROM_Has_Pending_Erase() {
 void HAL_EEPROM_Perform_Pending_Erase() {
 
 }
+
+int HAL_EEPROM_Set_Write_Back(uint32_t flush_delay, void* reserved) {
+    // Writes go to the filesystem, which has its own caching
+    return (flush_delay == 0) ? 0 : SYSTEM_ERROR_NOT_SUPPORTED;
+}
+
+int HAL_EEPROM_Flush(void* reserved) {
+    return 0;
+}
+
+void HAL_EEPROM_Process(void* reserved) {
+}
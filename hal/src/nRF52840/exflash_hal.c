@@ -32,6 +32,9 @@
 #include "flash_common.h"
 #include "nrf_nvic.h"
 #include "concurrent_hal.h"
+#include "delay_hal.h"
+#include "interrupts_hal.h"
+#include "trace.h"
 
 enum qspi_cmds_t {
     QSPI_STD_CMD_WRSR     = 0x01,
@@ -74,8 +77,18 @@ static void exflash_qspi_activate() {
     while (!nrf_qspi_event_check(NRF_QSPI, NRF_QSPI_EVENT_READY));
 }
 
+static bool exflash_can_sleep() {
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+    return os_scheduler_get_state(NULL) == OS_SCHEDULER_STATE_RUNNING && !HAL_IsISR() &&
+            !__get_PRIMASK() && !__get_BASEPRI();
+#else
+    return false;
+#endif // MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+}
+
 static nrfx_err_t exflash_qspi_wait_completion() {
     nrfx_err_t err = NRFX_ERROR_INTERNAL;
+    const bool can_sleep = exflash_can_sleep();
 
     // Certain operations like block erasure, may leave the flash
     // in a weird state where we can't talk to it for substantial periods of time
@@ -101,6 +114,10 @@ static nrfx_err_t exflash_qspi_wait_completion() {
         os_thread_scheduling(true, NULL);
 #endif // MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
 
+        if (err == NRFX_ERROR_BUSY && can_sleep) {
+            // Let other threads run while the flash is busy with a long operation such as erasure
+            HAL_Delay_Milliseconds(1);
+        }
     } while (err == NRFX_ERROR_BUSY);
 
     return err;
@@ -268,9 +285,11 @@ int hal_exflash_uninit(void)
 int hal_exflash_write(uintptr_t addr, const uint8_t* data_buf, size_t data_size)
 {
     hal_exflash_lock();
+    PARTICLE_TRACE(TRACE_EVENT_EXFLASH_WRITE_BEGIN, data_size);
     int ret = hal_flash_common_write(addr, data_buf, data_size,
                                      &perform_write, &hal_flash_common_dummy_read);
     exflash_qspi_wait_completion();
+    PARTICLE_TRACE(TRACE_EVENT_EXFLASH_WRITE_END, ret);
     hal_exflash_unlock();
     return ret;
 }
@@ -382,6 +401,123 @@ int hal_exflash_erase_block(uintptr_t start_addr, size_t num_blocks)
     return erase_common(start_addr, num_blocks, QSPI_ERASE_LEN_LEN_64KB);
 }
 
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+
+#define EXFLASH_ASYNC_QUEUE_SIZE        8
+#define EXFLASH_ASYNC_THREAD_STACK_SIZE 1536
+
+typedef enum {
+    EXFLASH_ASYNC_WRITE         = 0,
+    EXFLASH_ASYNC_ERASE_SECTOR  = 1,
+    EXFLASH_ASYNC_ERASE_BLOCK   = 2
+} exflash_async_op_t;
+
+typedef struct {
+    exflash_async_op_t op;
+    uintptr_t addr;
+    const uint8_t* data;
+    size_t size; // Data size or number of sectors/blocks
+    hal_exflash_async_callback_t callback;
+    void* context;
+} exflash_async_request_t;
+
+static os_queue_t s_async_queue = NULL;
+static os_thread_t s_async_thread = NULL;
+
+#endif // MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+
+static int exflash_async_perform(exflash_async_op_t op, uintptr_t addr, const uint8_t* data, size_t size) {
+    switch (op) {
+    case EXFLASH_ASYNC_WRITE:
+        return hal_exflash_write(addr, data, size);
+    case EXFLASH_ASYNC_ERASE_SECTOR:
+        return hal_exflash_erase_sector(addr, size);
+    case EXFLASH_ASYNC_ERASE_BLOCK:
+        return hal_exflash_erase_block(addr, size);
+    default:
+        return -1;
+    }
+}
+
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+
+static os_thread_return_t exflash_async_thread(void* param) {
+    (void)param;
+    for (;;) {
+        exflash_async_request_t req;
+        if (os_queue_take(s_async_queue, &req, CONCURRENT_WAIT_FOREVER, NULL)) {
+            continue;
+        }
+        const int ret = exflash_async_perform(req.op, req.addr, req.data, req.size);
+        if (req.callback) {
+            req.callback(ret, req.context);
+        }
+    }
+}
+
+static int exflash_async_init() {
+    int ret = 0;
+    hal_exflash_lock();
+    if (!s_async_thread) {
+        if (!s_async_queue && os_queue_create(&s_async_queue, sizeof(exflash_async_request_t), EXFLASH_ASYNC_QUEUE_SIZE, NULL)) {
+            s_async_queue = NULL;
+            ret = -1;
+        } else if (os_thread_create(&s_async_thread, "exflash", OS_THREAD_PRIORITY_DEFAULT, exflash_async_thread, NULL,
+                EXFLASH_ASYNC_THREAD_STACK_SIZE)) {
+            s_async_thread = NULL;
+            ret = -1;
+        }
+    }
+    hal_exflash_unlock();
+    return ret;
+}
+
+#endif // MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+
+static int exflash_async_submit(exflash_async_op_t op, uintptr_t addr, const uint8_t* data, size_t size,
+        hal_exflash_async_callback_t callback, void* context) {
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+    if (exflash_can_sleep()) {
+        if (exflash_async_init()) {
+            return -1;
+        }
+        const exflash_async_request_t req = {
+            .op = op,
+            .addr = addr,
+            .data = data,
+            .size = size,
+            .callback = callback,
+            .context = context
+        };
+        // Block while the queue is full
+        return os_queue_put(s_async_queue, &req, CONCURRENT_WAIT_FOREVER, NULL) ? -1 : 0;
+    }
+#endif // MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+    const int ret = exflash_async_perform(op, addr, data, size);
+    if (callback) {
+        callback(ret, context);
+    }
+    return 0;
+}
+
+int hal_exflash_write_async(uintptr_t addr, const uint8_t* data_buf, size_t data_size,
+        hal_exflash_async_callback_t callback, void* context)
+{
+    return exflash_async_submit(EXFLASH_ASYNC_WRITE, addr, data_buf, data_size, callback, context);
+}
+
+int hal_exflash_erase_sector_async(uintptr_t addr, size_t num_sectors, hal_exflash_async_callback_t callback,
+        void* context)
+{
+    return exflash_async_submit(EXFLASH_ASYNC_ERASE_SECTOR, addr, NULL, num_sectors, callback, context);
+}
+
+int hal_exflash_erase_block_async(uintptr_t addr, size_t num_blocks, hal_exflash_async_callback_t callback,
+        void* context)
+{
+    return exflash_async_submit(EXFLASH_ASYNC_ERASE_BLOCK, addr, NULL, num_blocks, callback, context);
+}
+
 int hal_exflash_copy_sector(uintptr_t src_addr, uintptr_t dest_addr, size_t data_size)
 {
     hal_exflash_lock();
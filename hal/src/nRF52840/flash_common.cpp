@@ -65,8 +65,8 @@ int hal_flash_common_dummy_read(uintptr_t addr, uint8_t* buf, size_t size) {
     return 0;
 }
 
-static int write_unaligned_word(uintptr_t addr, const uint8_t* data, size_t size,
-                                hal_flash_common_write_cb write_func, hal_flash_common_read_cb read_func)
+RAMFUNC static int write_unaligned_word(uintptr_t addr, const uint8_t* data, size_t size,
+                                        hal_flash_common_write_cb write_func, hal_flash_common_read_cb read_func)
 {
     if (size > 0) {
         uint32_t tmp __attribute__((aligned(4)));
@@ -92,8 +92,8 @@ static int write_unaligned_word(uintptr_t addr, const uint8_t* data, size_t size
     return 0;
 }
 
-int hal_flash_common_write(uintptr_t addr, const uint8_t* data_buf, size_t data_size,
-                           hal_flash_common_write_cb write_func, hal_flash_common_read_cb read_func)
+RAMFUNC int hal_flash_common_write(uintptr_t addr, const uint8_t* data_buf, size_t data_size,
+                                   hal_flash_common_write_cb write_func, hal_flash_common_read_cb read_func)
 {
 
     /* Fist we need to align the destination address */
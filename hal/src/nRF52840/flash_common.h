@@ -20,6 +20,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "ramfunc.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,9 +35,12 @@ extern "C" {
 typedef int (*hal_flash_common_write_cb)(uintptr_t addr, const uint8_t* data, size_t size);
 typedef int (*hal_flash_common_read_cb)(uintptr_t addr, uint8_t* data, size_t size);
 
-int hal_flash_common_write(uintptr_t addr, const uint8_t* data_buf, size_t data_size,
-                           hal_flash_common_write_cb write_func,
-                           hal_flash_common_read_cb read_func);
+/* Runs from RAM, so that the interrupt handlers and other RAM functions are not stalled by the
+ * write loop while the flash is busy
+ */
+RAMFUNC int hal_flash_common_write(uintptr_t addr, const uint8_t* data_buf, size_t data_size,
+                                   hal_flash_common_write_cb write_func,
+                                   hal_flash_common_read_cb read_func);
 
 
 /* This function can be used for unaligned writes to retrive the data from the flash
@@ -22,6 +22,7 @@
 #include "flash_hal.h"
 #include "flash_acquire.h"
 #include "flash_common.h"
+#include "trace.h"
 
 #ifdef SOFTDEVICE_PRESENT
 #include "nrf_fstorage_sd.h"
@@ -41,6 +42,14 @@ static volatile fs_op_state_t       fs_op_state = FS_OP_STATE_IDLE;
 
 static void fstorage_evt_handler(nrf_fstorage_evt_t* p_evt);
 
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+// Checked by the module validation cache (see ota_module.cpp)
+__attribute__((section(".retained_system"))) static volatile uint32_t s_write_generation;
+#define BUMP_WRITE_GENERATION() (++s_write_generation)
+#else
+#define BUMP_WRITE_GENERATION() ((void)0)
+#endif
+
 nrf_fstorage_t m_fs = {
     .evt_handler = fstorage_evt_handler,
     .start_addr  = 0x1000,
@@ -60,7 +69,7 @@ static void fstorage_evt_handler(nrf_fstorage_evt_t* p_evt)
     }
 }
 
-static int fstorage_perform_write(uintptr_t addr, const uint8_t* buf, size_t sz)
+RAMFUNC static int fstorage_perform_write(uintptr_t addr, const uint8_t* buf, size_t sz)
 {
     int ret = -1;
 
@@ -104,8 +113,11 @@ int hal_flash_write(uintptr_t addr, const uint8_t* data_buf, size_t data_size)
 {
     __flash_acquire();
 
+    BUMP_WRITE_GENERATION();
+    PARTICLE_TRACE(TRACE_EVENT_FLASH_WRITE_BEGIN, data_size);
     int ret = hal_flash_common_write(addr, data_buf, data_size,
                                      &fstorage_perform_write, &hal_flash_common_dummy_read);
+    PARTICLE_TRACE(TRACE_EVENT_FLASH_WRITE_END, ret);
 
     __flash_release();
 
@@ -127,6 +139,7 @@ int hal_flash_erase_sector(uintptr_t addr, size_t num_sectors)
         goto hal_flash_erase_sector_done;
     }
 
+    BUMP_WRITE_GENERATION();
     addr = (addr / INTERNAL_FLASH_PAGE_SIZE) * INTERNAL_FLASH_PAGE_SIZE; // Address must be aligned to a page boundary.
     fs_op_state = FS_OP_STATE_BUSY; //should before calling nrf_fstorage_erase
     ret_code = nrf_fstorage_erase(&m_fs, addr, num_sectors, (fs_op_state_t *)&fs_op_state);
@@ -149,6 +162,15 @@ hal_flash_erase_sector_done:
     return ret;
 }
 
+uint32_t hal_flash_write_generation(void)
+{
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+    return s_write_generation;
+#else
+    return 0;
+#endif
+}
+
 int hal_flash_read(uintptr_t addr, uint8_t* data_buf, size_t size)
 {
     __flash_acquire();
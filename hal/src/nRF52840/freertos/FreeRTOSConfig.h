@@ -119,23 +119,31 @@ extern void vApplicationTaskDeleteHook(void *pvTaskToDelete, volatile long* pxPe
 
 #define configUSE_PREEMPTION        1
 #define configUSE_IDLE_HOOK         1
-#define configUSE_TICK_HOOK         0
+#define configUSE_TICK_HOOK         1
 #define configCPU_CLOCK_HZ          ( SystemCoreClock )
 #define configTICK_RATE_HZ          ( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES        ( 10 )
 #define configMINIMAL_STACK_SIZE    ( ( unsigned short ) 128 )
 #define configTOTAL_HEAP_SIZE       ( ( size_t ) ( 75 * 1024 ) )
 #define configMAX_TASK_NAME_LEN     ( 16 )
-#define configUSE_TRACE_FACILITY    0
+#define configUSE_TRACE_FACILITY    1
 #define configUSE_16_BIT_TICKS      0
 #define configIDLE_SHOULD_YIELD     1
 #define configUSE_MUTEXES           1
 #define configUSE_RECURSIVE_MUTEXES  1
 #define configENABLE_BACKWARD_COMPATIBILITY 1
 #define configUSE_COUNTING_SEMAPHORES 1
+/* Per-thread CPU time in microseconds, derived from the DWT cycle counter (see rtos_hook.cpp) */
+#define configGENERATE_RUN_TIME_STATS 1
 #define configTICK_SOURCE FREERTOS_USE_SYSTICK
 //#define configTICK_SOURCE FREERTOS_USE_RTC
 
+/* Stop SysTick while the IDLE thread is running and wake up using RTC1 (see tickless_idle.cpp).
+Enabled with TICKLESS_IDLE=y */
+#ifndef configUSE_TICKLESS_IDLE
+#define configUSE_TICKLESS_IDLE 0
+#endif
+
 #define configAPPLICATION_ALLOCATED_HEAP ( 1 )
 #define configDYNAMIC_HEAP_SIZE     ( 1 )
 #define configUSE_MALLOC_FAILED_HOOK ( 1 )
@@ -226,6 +234,17 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
         #include <stdint.h>
         extern uint32_t SystemCoreClock;
     #endif
+
+    /* Runtime statistics clock */
+    extern void vConfigureTimerForRunTimeStats(void);
+    extern uint32_t ulGetRunTimeCounterValue(void);
+    #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() vConfigureTimerForRunTimeStats()
+    #define portGET_RUN_TIME_COUNTER_VALUE() ulGetRunTimeCounterValue()
+
+    #if configUSE_TICKLESS_IDLE
+        #include "tickless_idle.h"
+        #define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) hal_tickless_idle_sleep( xExpectedIdleTime )
+    #endif
 #endif /* !assembler */
 
 /** Implementation note:  Use this with caution and set this to 1 ONLY for debugging
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSM0710_MUXER_TX_SCHEDULER_H
+#define GSM0710_MUXER_TX_SCHEDULER_H
+
+#include "gsm0710muxer/muxer.h"
+#include "check.h"
+#include "system_error.h"
+#include "concurrent_hal.h"
+#include <mutex>
+#include <algorithm>
+
+namespace particle {
+
+namespace detail {
+const auto MUXER_TX_MAX_CHANNELS = 4;
+} // detail
+
+/**
+ * Arbitrates writes to the muxer channels in a weighted round-robin fashion.
+ *
+ * Every channel gets a number of frame credits per round, set by its weight. A channel that has
+ * used up its credits has to wait while any other channel with credits left is waiting to write.
+ * This bounds the time a write on one channel can be delayed by a burst of writes on another one
+ * to the transmission time of weight frames.
+ *
+ * Implements the subset of the muxer interface used by MuxerChannelStream, so it can be used
+ * in place of the muxer.
+ */
+template <typename MuxerT>
+class MuxerTxScheduler {
+public:
+    explicit MuxerTxScheduler(MuxerT* muxer);
+    ~MuxerTxScheduler();
+
+    int init();
+
+    void setWeight(uint8_t channel, unsigned weight);
+
+    int writeChannel(uint8_t channel, const uint8_t* data, size_t size);
+
+    void suspendChannel(uint8_t channel);
+    void resumeChannel(uint8_t channel);
+    size_t getMaxFrameSize() const;
+
+private:
+    struct Channel {
+        unsigned weight = 1;
+        unsigned credits = 1;
+        unsigned waiting = 0;
+        os_semaphore_t sem = nullptr;
+    };
+
+    bool canWrite(uint8_t channel) const;
+    void acquire(uint8_t channel);
+    void release(uint8_t channel);
+
+private:
+    MuxerT* muxer_;
+    Channel channels_[detail::MUXER_TX_MAX_CHANNELS];
+    std::mutex mutex_;
+    bool busy_ = false;
+};
+
+template <typename MuxerT>
+inline MuxerTxScheduler<MuxerT>::MuxerTxScheduler(MuxerT* muxer)
+        : muxer_(muxer) {
+}
+
+template <typename MuxerT>
+inline MuxerTxScheduler<MuxerT>::~MuxerTxScheduler() {
+    for (auto& ch: channels_) {
+        if (ch.sem) {
+            os_semaphore_destroy(ch.sem);
+            ch.sem = nullptr;
+        }
+    }
+}
+
+template <typename MuxerT>
+inline int MuxerTxScheduler<MuxerT>::init() {
+    for (auto& ch: channels_) {
+        if (!ch.sem) {
+            CHECK_TRUE(os_semaphore_create(&ch.sem, 1, 0) == 0, SYSTEM_ERROR_NO_MEMORY);
+        }
+    }
+    return 0;
+}
+
+template <typename MuxerT>
+inline void MuxerTxScheduler<MuxerT>::setWeight(uint8_t channel, unsigned weight) {
+    if (channel >= detail::MUXER_TX_MAX_CHANNELS || !weight) {
+        return;
+    }
+    std::lock_guard<std::mutex> lk(mutex_);
+    channels_[channel].weight = weight;
+    channels_[channel].credits = std::min(channels_[channel].credits, weight);
+}
+
+template <typename MuxerT>
+inline int MuxerTxScheduler<MuxerT>::writeChannel(uint8_t channel, const uint8_t* data, size_t size) {
+    if (channel >= detail::MUXER_TX_MAX_CHANNELS) {
+        return muxer_->writeChannel(channel, data, size);
+    }
+    acquire(channel);
+    const int r = muxer_->writeChannel(channel, data, size);
+    release(channel);
+    return r;
+}
+
+template <typename MuxerT>
+inline void MuxerTxScheduler<MuxerT>::suspendChannel(uint8_t channel) {
+    muxer_->suspendChannel(channel);
+}
+
+template <typename MuxerT>
+inline void MuxerTxScheduler<MuxerT>::resumeChannel(uint8_t channel) {
+    muxer_->resumeChannel(channel);
+}
+
+template <typename MuxerT>
+inline size_t MuxerTxScheduler<MuxerT>::getMaxFrameSize() const {
+    return muxer_->getMaxFrameSize();
+}
+
+template <typename MuxerT>
+inline bool MuxerTxScheduler<MuxerT>::canWrite(uint8_t channel) const {
+    if (busy_) {
+        return false;
+    }
+    if (channels_[channel].credits > 0) {
+        return true;
+    }
+    for (unsigned i = 0; i < detail::MUXER_TX_MAX_CHANNELS; i++) {
+        if (i != channel && channels_[i].waiting > 0 && channels_[i].credits > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename MuxerT>
+inline void MuxerTxScheduler<MuxerT>::acquire(uint8_t channel) {
+    auto& ch = channels_[channel];
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (!canWrite(channel)) {
+        ++ch.waiting;
+        do {
+            lk.unlock();
+            os_semaphore_take(ch.sem, CONCURRENT_WAIT_FOREVER, false);
+            lk.lock();
+        } while (!canWrite(channel));
+        --ch.waiting;
+    }
+    if (!ch.credits) {
+        // Everyone who was waiting has had their share, start a new round
+        for (auto& c: channels_) {
+            c.credits = c.weight;
+        }
+    }
+    --ch.credits;
+    busy_ = true;
+}
+
+template <typename MuxerT>
+inline void MuxerTxScheduler<MuxerT>::release(uint8_t channel) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    busy_ = false;
+    // Wake up the next waiting channel in round-robin order, preferring the ones with credits left
+    int next = -1;
+    for (unsigned i = 1; i <= detail::MUXER_TX_MAX_CHANNELS; i++) {
+        const unsigned idx = (channel + i) % detail::MUXER_TX_MAX_CHANNELS;
+        const auto& ch = channels_[idx];
+        if (ch.waiting > 0) {
+            if (ch.credits > 0) {
+                next = idx;
+                break;
+            }
+            if (next < 0) {
+                next = idx;
+            }
+        }
+    }
+    if (next >= 0) {
+        os_semaphore_give(channels_[next].sem, false);
+    }
+}
+
+} // particle
+
+#endif // GSM0710_MUXER_TX_SCHEDULER_H
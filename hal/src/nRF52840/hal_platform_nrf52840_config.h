@@ -93,3 +93,21 @@
 #define HAL_PLATFORM_RADIO_STACK (1)
 
 #define HAL_PLATFORM_BACKUP_RAM (1)
+
+#define HAL_PLATFORM_ADC_CONTINUOUS (1)
+
+#define HAL_PLATFORM_SPI_TRANSACTION_QUEUE (1)
+
+#define HAL_PLATFORM_SPI_SLAVE_RING (1)
+
+#define HAL_PLATFORM_I2C_TRANSACTION_QUEUE (1)
+
+#define HAL_PLATFORM_USB_CDC_HIGH_THROUGHPUT (1)
+
+#define HAL_PLATFORM_USB_VENDOR_BULK (1)
+
+#define HAL_PLATFORM_INTERRUPTS_CAPTURE (1)
+
+#define HAL_PLATFORM_PWM_SEQUENCE (1)
+
+#define HAL_PLATFORM_HEAP_ARENA (1)
@@ -93,6 +93,10 @@ typedef struct {
     void (*callback_on_receive)(int);
 
     HAL_I2C_Transmission_Config transfer_config;
+
+    hal_i2c_transaction*        transaction_head;
+    hal_i2c_transaction*        transaction_tail;
+    volatile bool               transaction_active;
 } nrf5x_i2c_info_t;
 
 static void twis0_handler(nrfx_twis_evt_t const * p_event);
@@ -168,9 +172,126 @@ static void twis1_handler(nrfx_twis_evt_t const * p_event) {
     twis_handler(HAL_I2C_INTERFACE2, p_event);
 }
 
+// Removes the transaction at the head of the queue and invokes its callback
+static void twi_transaction_complete(HAL_I2C_Interface i2c, int result) {
+    hal_i2c_transaction* transaction = m_i2c_map[i2c].transaction_head;
+    m_i2c_map[i2c].transaction_active = false;
+
+    m_i2c_map[i2c].transaction_head = transaction->next;
+    if (!m_i2c_map[i2c].transaction_head) {
+        m_i2c_map[i2c].transaction_tail = NULL;
+    }
+    transaction->next = NULL;
+
+    if (transaction->callback) {
+        transaction->callback(transaction, result);
+    }
+}
+
+// Should be called with interrupts disabled or from the TWIM interrupt handler
+static int twi_transaction_start(HAL_I2C_Interface i2c, hal_i2c_transaction* transaction) {
+    nrfx_twim_xfer_desc_t xfer = {};
+    uint32_t flags = 0;
+    switch (transaction->type) {
+        case HAL_I2C_TRANSACTION_WRITE: {
+            xfer = NRFX_TWIM_XFER_DESC_TX(transaction->address, (uint8_t*)transaction->tx_buffer, transaction->tx_length);
+            if (!(transaction->flags & HAL_I2C_TRANSMISSION_FLAG_STOP)) {
+                flags = NRFX_TWIM_FLAG_TX_NO_STOP;
+            }
+            break;
+        }
+        case HAL_I2C_TRANSACTION_READ: {
+            xfer = NRFX_TWIM_XFER_DESC_RX(transaction->address, transaction->rx_buffer, transaction->rx_length);
+            break;
+        }
+        default: {
+            // TWIM switches from writing to reading without CPU involvement
+            xfer = NRFX_TWIM_XFER_DESC_TXRX(transaction->address, (uint8_t*)transaction->tx_buffer, transaction->tx_length,
+                    transaction->rx_buffer, transaction->rx_length);
+            break;
+        }
+    }
+
+    m_i2c_map[i2c].transaction_active = true;
+    uint32_t err_code = nrfx_twim_xfer(m_i2c_map[i2c].master, &xfer, flags);
+    if (err_code == NRFX_SUCCESS) {
+        return SYSTEM_ERROR_NONE;
+    }
+    m_i2c_map[i2c].transaction_active = false;
+
+    // EasyDMA can't access buffers located in flash
+    return (err_code == NRFX_ERROR_INVALID_ADDR) ? SYSTEM_ERROR_INVALID_ARGUMENT : SYSTEM_ERROR_INTERNAL;
+}
+
+// Should be called with interrupts disabled or from the TWIM interrupt handler
+static void twi_transaction_next(HAL_I2C_Interface i2c) {
+    // Queued transactions wait for a blocking transfer to complete. The completion callback may
+    // queue another transaction and start it
+    while (!m_i2c_map[i2c].transaction_active && m_i2c_map[i2c].transfer_state != TRANSFER_STATE_BUSY &&
+            m_i2c_map[i2c].transaction_head) {
+        int ret = twi_transaction_start(i2c, m_i2c_map[i2c].transaction_head);
+        if (ret != SYSTEM_ERROR_NONE) {
+            twi_transaction_complete(i2c, ret);
+        }
+    }
+}
+
+static void twi_transaction_cancel_all(HAL_I2C_Interface i2c) {
+    int32_t state = HAL_disable_irq();
+    m_i2c_map[i2c].transaction_active = false;
+    while (m_i2c_map[i2c].transaction_head) {
+        twi_transaction_complete(i2c, SYSTEM_ERROR_CANCELLED);
+    }
+    HAL_enable_irq(state);
+}
+
+// Marks the interface as busy with a blocking transfer once all queued transactions are done
+static bool twi_begin_blocking_transfer(HAL_I2C_Interface i2c, system_tick_t timeout_ms) {
+    system_tick_t start = HAL_Timer_Get_Micro_Seconds();
+    for (;;) {
+        int32_t state = HAL_disable_irq();
+        if (!m_i2c_map[i2c].transaction_head) {
+            m_i2c_map[i2c].transfer_state = TRANSFER_STATE_BUSY;
+            HAL_enable_irq(state);
+            return true;
+        }
+        HAL_enable_irq(state);
+        if (HAL_Timer_Get_Micro_Seconds() - start > timeout_ms * 1000) {
+            return false;
+        }
+    }
+}
+
+static void twi_end_blocking_transfer(HAL_I2C_Interface i2c) {
+    int32_t state = HAL_disable_irq();
+    m_i2c_map[i2c].transfer_state = TRANSFER_STATE_IDLE;
+    twi_transaction_next(i2c);
+    HAL_enable_irq(state);
+}
+
 static void twim_handler(nrfx_twim_evt_t const * p_event, void * p_context) {
     uint32_t inst_num = (uint32_t)p_context;
 
+    if (m_i2c_map[inst_num].transaction_active) {
+        int result = SYSTEM_ERROR_NONE;
+        switch (p_event->type) {
+            case NRFX_TWIM_EVT_DONE:
+                break;
+            case NRFX_TWIM_EVT_ADDRESS_NACK:
+                result = SYSTEM_ERROR_NOT_FOUND;
+                break;
+            case NRFX_TWIM_EVT_DATA_NACK:
+                result = SYSTEM_ERROR_IO;
+                break;
+            default:
+                result = SYSTEM_ERROR_UNKNOWN;
+                break;
+        }
+        twi_transaction_complete((HAL_I2C_Interface)inst_num, result);
+        twi_transaction_next((HAL_I2C_Interface)inst_num);
+        return;
+    }
+
     switch (p_event->type) {
         case NRFX_TWIM_EVT_DONE: {
             // LOG_DEBUG(TRACE, "NRFX_TWIM_EVT_DONE");
@@ -200,6 +321,7 @@ static int twi_uninit(HAL_I2C_Interface i2c) {
 
     if (m_i2c_map[i2c].mode == I2C_MODE_MASTER) {
         nrfx_twim_uninit(m_i2c_map[i2c].master);
+        twi_transaction_cancel_all(i2c);
     } else {
         nrfx_twis_uninit(m_i2c_map[i2c].slave);
     }
@@ -385,7 +507,10 @@ int32_t HAL_I2C_Request_Data_Ex(HAL_I2C_Interface i2c, const HAL_I2C_Transmissio
         quantity = m_i2c_map[i2c].rx_buf_size;
     }
 
-    m_i2c_map[i2c].transfer_state = TRANSFER_STATE_BUSY;
+    if (!twi_begin_blocking_transfer(i2c, config->timeout_ms)) {
+        quantity = 0;
+        goto ret;
+    }
     err_code = nrfx_twim_rx(m_i2c_map[i2c].master, config->address, (uint8_t *)m_i2c_map[i2c].rx_buf, quantity);
     if (err_code) {
         // FIXME: There is a bug in nrfx_twim driver, if we call nrfx_twim_rx repeatedly and quickly,
@@ -409,7 +534,7 @@ int32_t HAL_I2C_Request_Data_Ex(HAL_I2C_Interface i2c, const HAL_I2C_Transmissio
     }
 
 ret:
-    m_i2c_map[i2c].transfer_state = TRANSFER_STATE_IDLE;
+    twi_end_blocking_transfer(i2c);
     m_i2c_map[i2c].rx_index_head = 0;
     m_i2c_map[i2c].rx_index_tail = quantity;
     HAL_I2C_Release(i2c, NULL);
@@ -435,7 +560,10 @@ uint8_t HAL_I2C_End_Transmission(HAL_I2C_Interface i2c, uint8_t stop, void* rese
         stop = m_i2c_map[i2c].transfer_config.flags & HAL_I2C_TRANSMISSION_FLAG_STOP;
     }
 
-    m_i2c_map[i2c].transfer_state = TRANSFER_STATE_BUSY;
+    if (!twi_begin_blocking_transfer(i2c, m_i2c_map[i2c].transfer_config.timeout_ms)) {
+        ret_code = 2;
+        goto ret;
+    }
     err_code = nrfx_twim_tx(m_i2c_map[i2c].master, m_i2c_map[i2c].address, (uint8_t *)m_i2c_map[i2c].tx_buf,
                                     m_i2c_map[i2c].tx_index_tail, !stop);
     if (err_code) {
@@ -454,7 +582,7 @@ uint8_t HAL_I2C_End_Transmission(HAL_I2C_Interface i2c, uint8_t stop, void* rese
     }
 
 ret:
-    m_i2c_map[i2c].transfer_state = TRANSFER_STATE_IDLE;
+    twi_end_blocking_transfer(i2c);
     m_i2c_map[i2c].tx_index_head = 0;
     m_i2c_map[i2c].tx_index_tail = 0;
     HAL_I2C_Release(i2c, NULL);
@@ -589,3 +717,32 @@ int32_t HAL_I2C_Release(HAL_I2C_Interface i2c, void* reserved)
     }
     return -1;
 }
+
+int hal_i2c_queue_transaction(HAL_I2C_Interface i2c, hal_i2c_transaction* transaction, void* reserved) {
+    if (i2c >= TOTAL_I2C || !transaction || transaction->type > HAL_I2C_TRANSACTION_WRITE_READ) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    const bool write = (transaction->type != HAL_I2C_TRANSACTION_READ);
+    const bool read = (transaction->type != HAL_I2C_TRANSACTION_WRITE);
+    if ((write && (!transaction->tx_buffer || transaction->tx_length == 0)) ||
+            (read && (!transaction->rx_buffer || transaction->rx_length == 0))) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    if (!m_i2c_map[i2c].enabled || m_i2c_map[i2c].mode != I2C_MODE_MASTER) {
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
+
+    int32_t state = HAL_disable_irq();
+    transaction->next = NULL;
+    if (m_i2c_map[i2c].transaction_tail) {
+        m_i2c_map[i2c].transaction_tail->next = transaction;
+    } else {
+        m_i2c_map[i2c].transaction_head = transaction;
+    }
+    m_i2c_map[i2c].transaction_tail = transaction;
+    // Otherwise the transaction is started when the ongoing transfer completes
+    twi_transaction_next(i2c);
+    HAL_enable_irq(state);
+
+    return SYSTEM_ERROR_NONE;
+}
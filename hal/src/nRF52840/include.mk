@@ -25,6 +25,24 @@ INCLUDE_DIRS += $(HAL_MODULE_PATH)/network/openthread
 INCLUDE_DIRS += $(HAL_MODULE_PATH)/network/lwip/wiznet
 INCLUDE_DIRS += $(HAL_MODULE_PATH)/network/ncp
 INCLUDE_DIRS += $(HAL_MODULE_PATH)/network/ncp/at_parser
+
+# lwIP memory profile (see lwipopts.h): low-mem, balanced or high-throughput
+LWIP_MEMORY_PROFILE ?= balanced
+ifeq ("$(LWIP_MEMORY_PROFILE)","low-mem")
+CFLAGS += -DLWIP_MEMORY_PROFILE=LWIP_MEMORY_PROFILE_LOW_MEM
+else ifeq ("$(LWIP_MEMORY_PROFILE)","balanced")
+CFLAGS += -DLWIP_MEMORY_PROFILE=LWIP_MEMORY_PROFILE_BALANCED
+else ifeq ("$(LWIP_MEMORY_PROFILE)","high-throughput")
+CFLAGS += -DLWIP_MEMORY_PROFILE=LWIP_MEMORY_PROFILE_HIGH_THROUGHPUT
+else
+$(error Unknown LWIP_MEMORY_PROFILE: $(LWIP_MEMORY_PROFILE))
+endif
+
+# Suppress the RTOS tick while idle (see tickless_idle.cpp)
+TICKLESS_IDLE ?= n
+ifeq ("$(TICKLESS_IDLE)","y")
+CFLAGS += -DconfigUSE_TICKLESS_IDLE=1
+endif
 endif
 
 HAL_LINK ?= $(findstring hal,$(MAKE_DEPENDENCIES))
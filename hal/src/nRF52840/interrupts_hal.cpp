@@ -23,6 +23,8 @@
 #include "nrf_nvic.h"
 #include "gpio_hal.h"
 #include "system_error.h"
+#include "ppi_timer.h"
+#include "ramfunc.h"
 
 // 8 high accuracy GPIOTE channels
 #define GPIOTE_CHANNEL_NUM              8
@@ -44,11 +46,16 @@ struct hal_interrupts_suspend_data_t {
 
 static hal_interrupts_suspend_data_t s_suspend_data = {};
 
+static struct {
+    uint16_t                pin;
+    uint8_t                 mode;
+} m_capture = {PIN_INVALID, 0};
+
 extern char link_interrupt_vectors_location;
 extern char link_ram_interrupt_vectors_location;
 extern char link_ram_interrupt_vectors_location_end;
 
-static void gpiote_interrupt_handler(nrfx_gpiote_pin_t nrf_pin, nrf_gpiote_polarity_t action) {
+RAMFUNC static void gpiote_interrupt_handler(nrfx_gpiote_pin_t nrf_pin, nrf_gpiote_polarity_t action) {
     uint8_t pin = NRF_PIN_LOOKUP_TABLE[nrf_pin];
     if (pin == PIN_INVALID) {
         // Ignore
@@ -103,6 +110,11 @@ static nrfx_gpiote_in_config_t get_gpiote_config(uint16_t pin, InterruptMode mod
 }
 
 int HAL_Interrupts_Attach(uint16_t pin, HAL_InterruptHandler handler, void* data, InterruptMode mode, HAL_InterruptExtraConfiguration* config) {
+    if (pin == m_capture.pin) {
+        // The GPIOTE channel is used for capturing edges
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
+
     Hal_Pin_Info* PIN_MAP = HAL_Pin_Map();
     uint8_t nrf_pin = NRF_GPIO_PIN_MAP(PIN_MAP[pin].gpio_port, PIN_MAP[pin].gpio_pin);
 
@@ -247,3 +259,95 @@ int HAL_Set_Direct_Interrupt_Handler(IRQn_Type irqn, HAL_Direct_Interrupt_Handle
 
     return 0;
 }
+
+int hal_interrupts_capture_start(uint16_t pin, const hal_interrupts_capture_config* config, void* reserved) {
+    if (pin >= TOTAL_PINS || !config || config->mode > HAL_INTERRUPTS_CAPTURE_MODE_PERIOD || config->edge > FALLING) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+
+    Hal_Pin_Info* PIN_MAP = HAL_Pin_Map();
+    if (m_capture.pin != PIN_INVALID || PIN_MAP[pin].exti_channel != EXTI_CHANNEL_NONE) {
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
+    if (!ppi_timer_acquire()) {
+        return SYSTEM_ERROR_BUSY;
+    }
+
+    // Only high accuracy channels generate an event that can be routed over PPI. No interrupt
+    // handler is needed
+    uint8_t nrf_pin = NRF_GPIO_PIN_MAP(PIN_MAP[pin].gpio_port, PIN_MAP[pin].gpio_pin);
+    nrfx_gpiote_in_config_t in_config = get_gpiote_config(pin, (InterruptMode)config->edge, true);
+    uint32_t err_code = nrfx_gpiote_in_init(nrf_pin, &in_config, NULL);
+    if (err_code != NRFX_SUCCESS) {
+        ppi_timer_release();
+        return (err_code == NRFX_ERROR_NO_MEM) ? SYSTEM_ERROR_NO_MEMORY : SYSTEM_ERROR_INVALID_STATE;
+    }
+
+    nrf_timer_task_trigger(PPI_TIMER, NRF_TIMER_TASK_STOP);
+    nrf_timer_task_trigger(PPI_TIMER, NRF_TIMER_TASK_CLEAR);
+    nrf_timer_bit_width_set(PPI_TIMER, NRF_TIMER_BIT_WIDTH_32);
+    nrf_timer_cc_write(PPI_TIMER, NRF_TIMER_CC_CHANNEL0, 0);
+
+    const uint32_t event = nrfx_gpiote_in_event_addr_get(nrf_pin);
+    if (config->mode == HAL_INTERRUPTS_CAPTURE_MODE_COUNT) {
+        // Every edge increments the counter
+        nrf_timer_mode_set(PPI_TIMER, NRF_TIMER_MODE_COUNTER);
+        nrf_ppi_channel_endpoint_setup(PPI_TIMER_CHANNEL, event,
+                nrf_timer_task_address_get(PPI_TIMER, NRF_TIMER_TASK_COUNT));
+    } else {
+        // Every edge latches the time since the previous edge into CC[0] and restarts the count. The
+        // first value is measured from the start of the capture
+        nrf_timer_mode_set(PPI_TIMER, NRF_TIMER_MODE_TIMER);
+        nrf_timer_frequency_set(PPI_TIMER, NRF_TIMER_FREQ_16MHz);
+        nrf_ppi_channel_and_fork_endpoint_setup(PPI_TIMER_CHANNEL, event,
+                nrf_timer_task_address_get(PPI_TIMER, nrf_timer_capture_task_get(NRF_TIMER_CC_CHANNEL0)),
+                nrf_timer_task_address_get(PPI_TIMER, NRF_TIMER_TASK_CLEAR));
+    }
+    nrf_ppi_channel_enable(PPI_TIMER_CHANNEL);
+
+    m_capture.pin = pin;
+    m_capture.mode = config->mode;
+
+    nrfx_gpiote_in_event_enable(nrf_pin, false);
+    nrf_timer_task_trigger(PPI_TIMER, NRF_TIMER_TASK_START);
+
+    return SYSTEM_ERROR_NONE;
+}
+
+int hal_interrupts_capture_read(uint16_t pin, hal_interrupts_capture_data* data, void* reserved) {
+    if (!data) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    if (pin == PIN_INVALID || pin != m_capture.pin) {
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
+
+    // Latch the current counter value into CC[1]
+    nrf_timer_task_trigger(PPI_TIMER, nrf_timer_capture_task_get(NRF_TIMER_CC_CHANNEL1));
+    const uint32_t current = nrf_timer_cc_read(PPI_TIMER, NRF_TIMER_CC_CHANNEL1);
+    if (m_capture.mode == HAL_INTERRUPTS_CAPTURE_MODE_COUNT) {
+        data->value = current;
+        data->elapsed = 0;
+    } else {
+        data->value = nrf_timer_cc_read(PPI_TIMER, NRF_TIMER_CC_CHANNEL0);
+        data->elapsed = current;
+    }
+
+    return SYSTEM_ERROR_NONE;
+}
+
+int hal_interrupts_capture_stop(uint16_t pin, void* reserved) {
+    if (pin == PIN_INVALID || pin != m_capture.pin) {
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
+
+    Hal_Pin_Info* PIN_MAP = HAL_Pin_Map();
+    uint8_t nrf_pin = NRF_GPIO_PIN_MAP(PIN_MAP[pin].gpio_port, PIN_MAP[pin].gpio_pin);
+    nrfx_gpiote_in_event_disable(nrf_pin);
+    nrfx_gpiote_in_uninit(nrf_pin);
+    ppi_timer_release();
+
+    m_capture.pin = PIN_INVALID;
+
+    return SYSTEM_ERROR_NONE;
+}
@@ -19,27 +19,76 @@
 #include "platform_config.h"
 #include "exflash_hal.h"
 #include "rgbled.h"
+#include "boot_timeline.h"
 #include <mutex>
+#include <cstring>
 
 using namespace particle::fs;
 
 #if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
 
 #include "static_recursive_mutex.h"
+#include "ota_module.h"
 
 namespace {
 
 static StaticRecursiveMutex s_lfs_mutex;
+static unsigned s_lfs_lock_depth = 0;
+
+/* Validating the filesystem on mount requires walking all metadata pairs (see filesystem_mount()),
+ * which takes longer as more files are created. The state of the filesystem is cached in retained
+ * memory, so that a warm reset can skip the validation if the filesystem was left consistent.
+ *
+ * Every program or erase operation increments the write generation. When the outermost filesystem
+ * lock is released, the operation that performed the writes has completed and the filesystem is
+ * consistent at that generation. If the generations don't match on the next boot, an operation
+ * has been interrupted by the reset and the filesystem needs to be validated
+ */
+const uint32_t MOUNT_CACHE_MAGIC = 0x4c465331;
+
+struct MountCache {
+    uint32_t magic;
+    uint32_t generation; /* Write generation */
+    uint32_t consistent_generation; /* Write generation at which the filesystem was last consistent */
+    lfs_block_t root[2]; /* Root directory pair */
+};
+
+__attribute__((section(".retained_system"))) MountCache s_mount_cache;
+
+bool mount_cache_valid(const lfs_t* lfs) {
+    return s_mount_cache.magic == MOUNT_CACHE_MAGIC &&
+            s_mount_cache.generation == s_mount_cache.consistent_generation &&
+            s_mount_cache.root[0] == lfs->root[0] && s_mount_cache.root[1] == lfs->root[1] &&
+            is_warm_reset();
+}
+
+void mount_cache_update(const lfs_t* lfs) {
+    s_mount_cache.consistent_generation = s_mount_cache.generation;
+    s_mount_cache.root[0] = lfs->root[0];
+    s_mount_cache.root[1] = lfs->root[1];
+    s_mount_cache.magic = MOUNT_CACHE_MAGIC;
+}
+
+void mount_cache_invalidate() {
+    s_mount_cache.magic = 0;
+}
 
 } /* anonymous */
 
 int filesystem_lock(filesystem_t* fs) {
     (void)fs;
-    return !s_lfs_mutex.lock();
+    if (!s_lfs_mutex.lock()) {
+        return 1;
+    }
+    ++s_lfs_lock_depth;
+    return 0;
 }
 
 int filesystem_unlock(filesystem_t* fs) {
     (void)fs;
+    if (--s_lfs_lock_depth == 0) {
+        s_mount_cache.consistent_generation = s_mount_cache.generation;
+    }
     return !s_lfs_mutex.unlock();
 }
 
@@ -58,12 +107,70 @@ __attribute__((weak)) int filesystem_unlock(filesystem_t* fs) {
 #endif /* MODULE_FUNCTION != MOD_FUNC_BOOTLOADER */
 
 
+static_assert(FILESYSTEM_LOOKAHEAD % 32 == 0, "FILESYSTEM_LOOKAHEAD must be a multiple of 32");
+
 namespace {
 
+#if FILESYSTEM_READ_AHEAD_SIZE > 0
+
+static_assert(FILESYSTEM_BLOCK_SIZE % FILESYSTEM_READ_AHEAD_SIZE == 0 &&
+        FILESYSTEM_READ_AHEAD_SIZE % FILESYSTEM_READ_SIZE == 0,
+        "FILESYSTEM_READ_AHEAD_SIZE must be a multiple of FILESYSTEM_READ_SIZE and a divisor of FILESYSTEM_BLOCK_SIZE");
+
+/* littlefs reads the metadata in FILESYSTEM_READ_SIZE chunks, so scanning a directory or a file
+ * results in many small QSPI transactions. This cache reads the flash in larger aligned chunks
+ * instead. It's only accessed by littlefs, so it's protected by the filesystem lock
+ */
+class ReadAheadCache {
+public:
+    ReadAheadCache()
+            : addr_(0),
+              valid_(false) {
+    }
+
+    int read(uintptr_t addr, uint8_t* data, size_t size) {
+        const uintptr_t chunkAddr = addr & ~(uintptr_t)(FILESYSTEM_READ_AHEAD_SIZE - 1);
+        if (addr + size > chunkAddr + FILESYSTEM_READ_AHEAD_SIZE) {
+            /* Large reads bypass the cache */
+            return hal_exflash_read(addr, data, size);
+        }
+        if (!valid_ || addr_ != chunkAddr) {
+            valid_ = false;
+            const int r = hal_exflash_read(chunkAddr, buf_, sizeof(buf_));
+            if (r) {
+                return r;
+            }
+            addr_ = chunkAddr;
+            valid_ = true;
+        }
+        memcpy(data, buf_ + (addr - chunkAddr), size);
+        return 0;
+    }
+
+    void invalidate(uintptr_t addr, size_t size) {
+        if (valid_ && addr < addr_ + FILESYSTEM_READ_AHEAD_SIZE && addr + size > addr_) {
+            valid_ = false;
+        }
+    }
+
+private:
+    uint8_t buf_[FILESYSTEM_READ_AHEAD_SIZE] __attribute__((aligned(4)));
+    uintptr_t addr_;
+    bool valid_;
+};
+
+ReadAheadCache s_readAheadCache;
+
+#endif /* FILESYSTEM_READ_AHEAD_SIZE > 0 */
+
 int fs_read(const struct lfs_config* c, lfs_block_t block,
             lfs_off_t off, void* buffer, lfs_size_t size)
 {
+#if FILESYSTEM_READ_AHEAD_SIZE > 0
+    int r = s_readAheadCache.read(block * c->block_size + off, (uint8_t*)buffer, size);
+#else
     int r = hal_exflash_read(block * c->block_size + off, (uint8_t*)buffer, size);
+#endif /* FILESYSTEM_READ_AHEAD_SIZE > 0 */
     if (r) {
         LOG_DEBUG(ERROR, "fs_read error %d", r);
     }
@@ -73,18 +180,37 @@ int fs_read(const struct lfs_config* c, lfs_block_t block,
 int fs_prog(const struct lfs_config* c, lfs_block_t block,
             lfs_off_t off, const void* buffer, lfs_size_t size)
 {
+#if FILESYSTEM_READ_AHEAD_SIZE > 0
+    s_readAheadCache.invalidate(block * c->block_size + off, size);
+#endif /* FILESYSTEM_READ_AHEAD_SIZE > 0 */
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+    ++s_mount_cache.generation;
+#endif /* MODULE_FUNCTION != MOD_FUNC_BOOTLOADER */
     int r = hal_exflash_write(block * c->block_size + off, (const uint8_t*)buffer, size);
     if (r) {
         LOG_DEBUG(ERROR, "fs_prog error %d", r);
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+        /* The operation may leave the filesystem inconsistent even if it completes */
+        mount_cache_invalidate();
+#endif /* MODULE_FUNCTION != MOD_FUNC_BOOTLOADER */
     }
     return r;
 }
 
 int fs_erase(const struct lfs_config* c, lfs_block_t block)
 {
+#if FILESYSTEM_READ_AHEAD_SIZE > 0
+    s_readAheadCache.invalidate(block * c->block_size, c->block_size);
+#endif /* FILESYSTEM_READ_AHEAD_SIZE > 0 */
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+    ++s_mount_cache.generation;
+#endif /* MODULE_FUNCTION != MOD_FUNC_BOOTLOADER */
     int r = hal_exflash_erase_sector(block * c->block_size, 1);
     if (r) {
         LOG_DEBUG(ERROR, "fs_erase error %d", r);
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+        mount_cache_invalidate();
+#endif /* MODULE_FUNCTION != MOD_FUNC_BOOTLOADER */
     }
     return r;
 }
@@ -265,6 +391,13 @@ int filesystem_mount(filesystem_t* fs) {
 #endif /* LFS_NO_MALLOC */
 
     ret = lfs_mount(&fs->instance, &fs->config);
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+    if (!ret && mount_cache_valid(&fs->instance)) {
+        /* The filesystem was consistent when the device was reset by the system firmware,
+         * skip the validation */
+        fs->instance.deorphaned = true;
+    } else
+#endif /* MODULE_FUNCTION != MOD_FUNC_BOOTLOADER */
     if (!ret) {
         /* IMPORTANT: manually calling deorphan here to validate the filesystem.
          * We've added another check to avoid inifite loop when traversing
@@ -301,6 +434,10 @@ int filesystem_mount(filesystem_t* fs) {
 
     if (!ret) {
         fs->state = true;
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+        mount_cache_update(&fs->instance);
+        boot_timeline_mark(BOOT_STAGE_FILESYSTEM_MOUNT, nullptr);
+#endif
     }
 
     SPARK_ASSERT(fs->state);
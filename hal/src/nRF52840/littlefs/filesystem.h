@@ -28,14 +28,34 @@ extern "C" {
 #include <lfs_util.h>
 #include <lfs.h>
 
-/* FIXME */
+/* Sizes of the read and program caches. littlefs always reads and programs the flash in
+ * multiples of these sizes */
+#ifndef FILESYSTEM_PROG_SIZE
 #define FILESYSTEM_PROG_SIZE    (256)
+#endif /* FILESYSTEM_PROG_SIZE */
+#ifndef FILESYSTEM_READ_SIZE
 #define FILESYSTEM_READ_SIZE    (256)
+#endif /* FILESYSTEM_READ_SIZE */
 
 #define FILESYSTEM_BLOCK_SIZE   (sFLASH_PAGESIZE)
 /* XXX: Using half of the external flash for now */
 #define FILESYSTEM_BLOCK_COUNT  (sFLASH_PAGECOUNT / 2)
-#define FILESYSTEM_LOOKAHEAD    (128)
+
+/* Size of the lookahead bitmap in blocks. By default, the bitmap covers the entire filesystem,
+ * so that the allocator doesn't need to rescan the filesystem every FILESYSTEM_LOOKAHEAD blocks */
+#ifndef FILESYSTEM_LOOKAHEAD
+#define FILESYSTEM_LOOKAHEAD    (FILESYSTEM_BLOCK_COUNT)
+#endif /* FILESYSTEM_LOOKAHEAD */
+
+/* Size of the read-ahead cache. Reads smaller than this size are served from a cache that is
+ * filled with a single multi-page read from the flash. Set to 0 to disable the cache */
+#ifndef FILESYSTEM_READ_AHEAD_SIZE
+#if MODULE_FUNCTION == MOD_FUNC_BOOTLOADER
+#define FILESYSTEM_READ_AHEAD_SIZE (0)
+#else
+#define FILESYSTEM_READ_AHEAD_SIZE (1024)
+#endif /* MODULE_FUNCTION == MOD_FUNC_BOOTLOADER */
+#endif /* FILESYSTEM_READ_AHEAD_SIZE */
 
 /* FIXME */
 typedef struct {
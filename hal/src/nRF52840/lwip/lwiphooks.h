@@ -42,6 +42,13 @@ int lwip_hook_ip6_forward_post_routing(struct pbuf* p, struct ip6_hdr* ip6hdr, s
 struct netif* lwip_hook_ip6_route(const ip6_addr_t* src, const ip6_addr_t* dst);
 #endif /* LWIP_IPV6 */
 
+/* TCP hooks */
+#if LWIP_TCP
+struct tcp_pcb;
+struct tcp_hdr;
+err_t lwip_hook_tcp_inpacket_pcb(struct tcp_pcb* pcb, struct tcp_hdr* hdr, u16_t optlen, u16_t opt1len, u8_t* opt2, struct pbuf* p);
+#endif /* LWIP_TCP */
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -95,7 +102,7 @@ struct netif* lwip_hook_ip6_route(const ip6_addr_t* src, const ip6_addr_t* dst);
  * ATTENTION: don't call any tcp api functions that might change tcp state (pcb
  * state or any pcb lists) from this callback!
  */
-// #define LWIP_HOOK_TCP_INPACKET_PCB(pcb, hdr, optlen, opt1len, opt2, p)
+#define LWIP_HOOK_TCP_INPACKET_PCB(pcb, hdr, optlen, opt1len, opt2, p) lwip_hook_tcp_inpacket_pcb(pcb, hdr, optlen, opt1len, opt2, p)
 
 /**
  * LWIP_HOOK_TCP_OUT_TCPOPT_LENGTH:
@@ -111,6 +111,76 @@ void sys_unlock_tcpip_core(void);
 #endif /* LWIP_TCPIP_CORE_LOCKING */
 #endif /* !NO_SYS */
 
+/*
+   ------------------------------------
+   ---------- Memory profiles ---------
+   ------------------------------------
+*/
+
+/**
+ * LWIP_MEMORY_PROFILE: selects the sizes of the lwIP pools and TCP buffers.
+ * The profile is set at build time with the LWIP_MEMORY_PROFILE make variable
+ * (see include.mk) and applies to the module that includes the networking stack.
+ *
+ * LWIP_MEMORY_PROFILE_LOW_MEM: fewer pbufs and TCP connections, for applications
+ *     that exchange small amounts of data.
+ * LWIP_MEMORY_PROFILE_BALANCED: default.
+ * LWIP_MEMORY_PROFILE_HIGH_THROUGHPUT: larger TCP windows and pbuf pools, for
+ *     applications that stream data.
+ *
+ * LWIP_PROFILE_TCP_WND_MSS and LWIP_PROFILE_TCP_SND_BUF_MSS apply to connections
+ * over Ethernet and Wi-Fi. Connections over the low bandwidth cellular and mesh
+ * interfaces are limited to the *_LOW_BW_MSS values instead, so that they don't hold
+ * on to pbufs that they can't make use of.
+ */
+#define LWIP_MEMORY_PROFILE_LOW_MEM          (0)
+#define LWIP_MEMORY_PROFILE_BALANCED         (1)
+#define LWIP_MEMORY_PROFILE_HIGH_THROUGHPUT  (2)
+
+#ifndef LWIP_MEMORY_PROFILE
+#define LWIP_MEMORY_PROFILE                  LWIP_MEMORY_PROFILE_BALANCED
+#endif
+
+#if LWIP_MEMORY_PROFILE == LWIP_MEMORY_PROFILE_LOW_MEM
+#define LWIP_PROFILE_MEM_SIZE                (6 * 1024)
+#define LWIP_PROFILE_MEMP_NUM_PBUF           8
+#define LWIP_PROFILE_MEMP_NUM_TCP_PCB        3
+#define LWIP_PROFILE_MEMP_NUM_TCP_SEG        8
+#define LWIP_PROFILE_PBUF_POOL_SIZE          8
+#define LWIP_PROFILE_TCP_WND_MSS             2
+#define LWIP_PROFILE_TCP_SND_BUF_MSS         2
+#define LWIP_PROFILE_TCP_WND_LOW_BW_MSS      2
+#define LWIP_PROFILE_TCP_SND_BUF_LOW_BW_MSS  2
+#define LWIP_PROFILE_TCP_SACK_OUT            0
+#define LWIP_PROFILE_WND_SCALE               0
+#elif LWIP_MEMORY_PROFILE == LWIP_MEMORY_PROFILE_BALANCED
+#define LWIP_PROFILE_MEM_SIZE                (10 * 1024)
+#define LWIP_PROFILE_MEMP_NUM_PBUF           16
+#define LWIP_PROFILE_MEMP_NUM_TCP_PCB        5
+#define LWIP_PROFILE_MEMP_NUM_TCP_SEG        16
+#define LWIP_PROFILE_PBUF_POOL_SIZE          16
+#define LWIP_PROFILE_TCP_WND_MSS             6
+#define LWIP_PROFILE_TCP_SND_BUF_MSS         2
+#define LWIP_PROFILE_TCP_WND_LOW_BW_MSS      4
+#define LWIP_PROFILE_TCP_SND_BUF_LOW_BW_MSS  2
+#define LWIP_PROFILE_TCP_SACK_OUT            1
+#define LWIP_PROFILE_WND_SCALE               1
+#elif LWIP_MEMORY_PROFILE == LWIP_MEMORY_PROFILE_HIGH_THROUGHPUT
+#define LWIP_PROFILE_MEM_SIZE                (16 * 1024)
+#define LWIP_PROFILE_MEMP_NUM_PBUF           24
+#define LWIP_PROFILE_MEMP_NUM_TCP_PCB        8
+#define LWIP_PROFILE_MEMP_NUM_TCP_SEG        32
+#define LWIP_PROFILE_PBUF_POOL_SIZE          32
+#define LWIP_PROFILE_TCP_WND_MSS             16
+#define LWIP_PROFILE_TCP_SND_BUF_MSS         6
+#define LWIP_PROFILE_TCP_WND_LOW_BW_MSS      8
+#define LWIP_PROFILE_TCP_SND_BUF_LOW_BW_MSS  4
+#define LWIP_PROFILE_TCP_SACK_OUT            1
+#define LWIP_PROFILE_WND_SCALE               1
+#else
+#error "Unknown LWIP_MEMORY_PROFILE"
+#endif
+
 /*
    ------------------------------------
    ---------- Memory options ----------
@@ -142,7 +212,7 @@ void sys_unlock_tcpip_core(void);
  * a lot of data that needs to be copied, this should be set high.
  */
 /* FIXME */
-#define MEM_SIZE                        (10 * 1024)
+#define MEM_SIZE                        LWIP_PROFILE_MEM_SIZE
 
 /**
  * MEMP_OVERFLOW_CHECK: memp overflow protection reserves a configurable
@@ -221,7 +291,7 @@ void sys_unlock_tcpip_core(void);
  * If the application sends a lot of data out of ROM (or other static memory),
  * this should be set high.
  */
-#define MEMP_NUM_PBUF                   16
+#define MEMP_NUM_PBUF                   LWIP_PROFILE_MEMP_NUM_PBUF
 
 /**
  * MEMP_NUM_RAW_PCB: Number of raw connection PCBs
@@ -240,7 +310,7 @@ void sys_unlock_tcpip_core(void);
  * MEMP_NUM_TCP_PCB: the number of simultaneously active TCP connections.
  * (requires the LWIP_TCP option)
  */
-#define MEMP_NUM_TCP_PCB                5
+#define MEMP_NUM_TCP_PCB                LWIP_PROFILE_MEMP_NUM_TCP_PCB
 
 /**
  * MEMP_NUM_TCP_PCB_LISTEN: the number of listening TCP connections.
@@ -252,7 +322,7 @@ void sys_unlock_tcpip_core(void);
  * MEMP_NUM_TCP_SEG: the number of simultaneously queued TCP segments.
  * (requires the LWIP_TCP option)
  */
-#define MEMP_NUM_TCP_SEG                16
+#define MEMP_NUM_TCP_SEG                LWIP_PROFILE_MEMP_NUM_TCP_SEG
 
 /**
  * MEMP_NUM_ALTCP_PCB: the number of simultaneously active altcp layer pcbs.
@@ -348,7 +418,7 @@ void sys_unlock_tcpip_core(void);
 /**
  * PBUF_POOL_SIZE: the number of buffers in the pbuf pool.
  */
-#define PBUF_POOL_SIZE                  16
+#define PBUF_POOL_SIZE                  LWIP_PROFILE_PBUF_POOL_SIZE
 
 /*
    ---------------------------------
@@ -774,7 +844,14 @@ void sys_unlock_tcpip_core(void);
  * with scaling applied. Maximum window value in the TCP header
  * will be TCP_WND >> TCP_RCV_SCALE
  */
-#define TCP_WND                         (4 * TCP_MSS)
+#define TCP_WND                         (LWIP_PROFILE_TCP_WND_MSS * TCP_MSS)
+
+/**
+ * TCP_WND_LOW_BW: The receive window of connections established over
+ * the cellular and mesh interfaces. Must not exceed TCP_WND.
+ * See lwip_hook_tcp_inpacket_pcb().
+ */
+#define TCP_WND_LOW_BW                  (LWIP_PROFILE_TCP_WND_LOW_BW_MSS * TCP_MSS)
 
 /**
  * TCP_MAXRTX: Maximum number of retransmissions of data segments.
@@ -795,7 +872,7 @@ void sys_unlock_tcpip_core(void);
 /**
  * LWIP_TCP_SACK_OUT==1: TCP will support sending selective acknowledgements (SACKs).
  */
-#define LWIP_TCP_SACK_OUT               0
+#define LWIP_TCP_SACK_OUT               LWIP_PROFILE_TCP_SACK_OUT
 
 /**
  * LWIP_TCP_MAX_SACK_NUM: The maximum number of SACK values to include in TCP segments.
@@ -833,7 +910,13 @@ void sys_unlock_tcpip_core(void);
  * TCP_SND_BUF: TCP sender buffer space (bytes).
  * To achieve good performance, this should be at least 2 * TCP_MSS.
  */
-#define TCP_SND_BUF                     (2 * TCP_MSS)
+#define TCP_SND_BUF                     (LWIP_PROFILE_TCP_SND_BUF_MSS * TCP_MSS)
+
+/**
+ * TCP_SND_BUF_LOW_BW: TCP sender buffer space of connections established over
+ * the cellular and mesh interfaces. Must not exceed TCP_SND_BUF.
+ */
+#define TCP_SND_BUF_LOW_BW              (LWIP_PROFILE_TCP_SND_BUF_LOW_BW_MSS * TCP_MSS)
 
 /**
  * TCP_SND_QUEUELEN: TCP sender buffer space (pbufs). This must be at least
@@ -966,7 +1049,7 @@ void sys_unlock_tcpip_core(void);
  * When LWIP_WND_SCALE is enabled but TCP_RCV_SCALE is 0, we can use a large
  * send window while having a small receive window only.
  */
-#define LWIP_WND_SCALE                  0
+#define LWIP_WND_SCALE                  LWIP_PROFILE_WND_SCALE
 #define TCP_RCV_SCALE                   0
 
 /**
@@ -974,7 +1057,7 @@ void sys_unlock_tcpip_core(void);
  * When this is > 0, every tcp pcb (including listen pcb) includes a number of
  * additional argument entries in an array (see tcp_ext_arg_alloc_id)
  */
-#define LWIP_TCP_PCB_NUM_EXT_ARGS       0
+#define LWIP_TCP_PCB_NUM_EXT_ARGS       1
 
 /** LWIP_ALTCP==1: enable the altcp API
  * altcp is an abstraction layer that prevents applications linking against the
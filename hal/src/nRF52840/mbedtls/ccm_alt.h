@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MBEDTLS_CCM_ALT_H
+#define MBEDTLS_CCM_ALT_H
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef MBEDTLS_CCM_ALT
+
+#include "mbedtls/cipher.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief CCM context structure
+ *
+ * CC310 performs a complete CCM operation (CBC-MAC and CTR encryption) in a single call, so
+ * the context only needs to keep the key. Only 128-bit AES keys are supported by the hardware.
+ */
+typedef struct
+{
+    uint8_t key[16]; ///< AES-128 key
+    uint8_t key_set; ///< Non-zero if the key has been set
+}
+mbedtls_ccm_context;
+
+/**
+ * @brief Initialize CCM context
+ *
+ * @param [in,out] ctx CCM context to be initialized
+ */
+void mbedtls_ccm_init(mbedtls_ccm_context *ctx);
+
+/**
+ * @brief Set CCM key
+ *
+ * @param [in,out] ctx CCM context
+ * @param [in] cipher Block cipher to use, must be MBEDTLS_CIPHER_ID_AES
+ * @param [in] key Encryption key
+ * @param [in] keybits Key size in bits, must be 128
+ */
+int mbedtls_ccm_setkey(mbedtls_ccm_context *ctx,
+                       mbedtls_cipher_id_t cipher,
+                       const unsigned char *key,
+                       unsigned int keybits);
+
+/**
+ * @brief Clear CCM context
+ *
+ * @param [in,out] ctx CCM context to be cleared
+ */
+void mbedtls_ccm_free(mbedtls_ccm_context *ctx);
+
+/**
+ * @brief CCM buffer encryption
+ *
+ * @param [in] ctx CCM context
+ * @param [in] length Length of the input data
+ * @param [in] iv Nonce
+ * @param [in] iv_len Length of the nonce (7 to 13 bytes)
+ * @param [in] add Additional data
+ * @param [in] add_len Length of the additional data
+ * @param [in] input Input data
+ * @param [out] output Output data, can be the same buffer as the input data
+ * @param [out] tag Authentication tag
+ * @param [in] tag_len Length of the authentication tag (4, 6, 8, 10, 12, 14 or 16 bytes)
+ */
+int mbedtls_ccm_encrypt_and_tag(mbedtls_ccm_context *ctx, size_t length,
+                                const unsigned char *iv, size_t iv_len,
+                                const unsigned char *add, size_t add_len,
+                                const unsigned char *input, unsigned char *output,
+                                unsigned char *tag, size_t tag_len);
+
+/**
+ * @brief CCM buffer authenticated decryption
+ *
+ * On authentication failure the output buffer is cleared and MBEDTLS_ERR_CCM_AUTH_FAILED
+ * is returned.
+ *
+ * @param [in] ctx CCM context
+ * @param [in] length Length of the input data
+ * @param [in] iv Nonce
+ * @param [in] iv_len Length of the nonce (7 to 13 bytes)
+ * @param [in] add Additional data
+ * @param [in] add_len Length of the additional data
+ * @param [in] input Input data
+ * @param [out] output Output data, can be the same buffer as the input data
+ * @param [in] tag Authentication tag
+ * @param [in] tag_len Length of the authentication tag (4, 6, 8, 10, 12, 14 or 16 bytes)
+ */
+int mbedtls_ccm_auth_decrypt(mbedtls_ccm_context *ctx, size_t length,
+                             const unsigned char *iv, size_t iv_len,
+                             const unsigned char *add, size_t add_len,
+                             const unsigned char *input, unsigned char *output,
+                             const unsigned char *tag, size_t tag_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MBEDTLS_CCM_ALT
+
+#endif // MBEDTLS_CCM_ALT_H
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mbedtls/ccm.h"
+
+#include <string.h>
+
+#ifdef MBEDTLS_CCM_ALT
+
+#include "cc310_mbedtls.h"
+#include "crys_aesccm.h"
+#include "crys_aesccm_error.h"
+
+#ifdef MBEDTLS_ERR_CCM_HW_ACCEL_FAILED
+#define CCM_CC310_ERROR MBEDTLS_ERR_CCM_HW_ACCEL_FAILED
+#else
+#define CCM_CC310_ERROR MBEDTLS_ERR_CCM_BAD_INPUT
+#endif
+
+static int ccm_check_params(const mbedtls_ccm_context * ctx, size_t length, size_t iv_len, size_t tag_len)
+{
+    if (!ctx->key_set)
+    {
+        return MBEDTLS_ERR_CCM_BAD_INPUT;
+    }
+
+    // Same restrictions as in the generic implementation
+    if ((tag_len < 4) || (tag_len > 16) || (tag_len % 2 != 0))
+    {
+        return MBEDTLS_ERR_CCM_BAD_INPUT;
+    }
+
+    if ((iv_len < 7) || (iv_len > 13))
+    {
+        return MBEDTLS_ERR_CCM_BAD_INPUT;
+    }
+
+    // Size of the length field is 15 - iv_len bytes
+    if ((iv_len > 11) && (length >> (8 * (15 - iv_len))) != 0)
+    {
+        return MBEDTLS_ERR_CCM_BAD_INPUT;
+    }
+
+    return 0;
+}
+
+static int ccm_crypt(mbedtls_ccm_context * ctx, SaSiAesEncryptMode_t mode, size_t length,
+                     const unsigned char * iv, size_t iv_len,
+                     const unsigned char * add, size_t add_len,
+                     const unsigned char * input, unsigned char * output,
+                     CRYS_AESCCM_Mac_Res_t mac, size_t tag_len)
+{
+    int ret = ccm_check_params(ctx, length, iv_len, tag_len);
+    if (ret != 0)
+    {
+        return ret;
+    }
+
+    CRYS_AESCCM_Key_t key = { 0 };
+    memcpy(key, ctx->key, sizeof(ctx->key));
+
+    uint8_t nonce[13];
+    memcpy(nonce, iv, iv_len);
+
+    // The whole record, including the additional data and tag, is processed in one operation
+    CRYSError_t result = CRYS_OK;
+    CC310_OPERATION(CRYS_AESCCM(mode,
+                                key,
+                                CRYS_AES_Key128BitSize,
+                                nonce,
+                                (uint8_t)iv_len,
+                                (uint8_t *)add,
+                                (uint32_t)add_len,
+                                (uint8_t *)input,
+                                (uint32_t)length,
+                                output,
+                                (uint8_t)tag_len,
+                                mac),
+                    result);
+
+    memset(key, 0, sizeof(key));
+
+    if (result == CRYS_OK)
+    {
+        return 0;
+    }
+
+    if ((mode == SASI_AES_DECRYPT) && (result == CRYS_AESCCM_CCM_MAC_INVALID_ERROR))
+    {
+        return MBEDTLS_ERR_CCM_AUTH_FAILED;
+    }
+
+    return CCM_CC310_ERROR;
+}
+
+void mbedtls_ccm_init(mbedtls_ccm_context * ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_ccm_setkey(mbedtls_ccm_context * ctx,
+                       mbedtls_cipher_id_t   cipher,
+                       const unsigned char * key,
+                       unsigned int          keybits)
+{
+    if ((cipher != MBEDTLS_CIPHER_ID_AES) || (keybits != 128))
+    {
+        return MBEDTLS_ERR_CCM_BAD_INPUT;
+    }
+
+    memcpy(ctx->key, key, sizeof(ctx->key));
+    ctx->key_set = 1;
+
+    return 0;
+}
+
+void mbedtls_ccm_free(mbedtls_ccm_context * ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_ccm_encrypt_and_tag(mbedtls_ccm_context * ctx, size_t length,
+                                const unsigned char * iv, size_t iv_len,
+                                const unsigned char * add, size_t add_len,
+                                const unsigned char * input, unsigned char * output,
+                                unsigned char * tag, size_t tag_len)
+{
+    CRYS_AESCCM_Mac_Res_t mac = { 0 };
+
+    int ret = ccm_crypt(ctx, SASI_AES_ENCRYPT, length, iv, iv_len, add, add_len, input, output, mac, tag_len);
+    if (ret == 0)
+    {
+        memcpy(tag, mac, tag_len);
+    }
+
+    return ret;
+}
+
+int mbedtls_ccm_auth_decrypt(mbedtls_ccm_context * ctx, size_t length,
+                             const unsigned char * iv, size_t iv_len,
+                             const unsigned char * add, size_t add_len,
+                             const unsigned char * input, unsigned char * output,
+                             const unsigned char * tag, size_t tag_len)
+{
+    CRYS_AESCCM_Mac_Res_t mac = { 0 };
+
+    if (tag_len <= sizeof(mac))
+    {
+        // CC310 verifies the tag passed in the MAC buffer
+        memcpy(mac, tag, tag_len);
+    }
+
+    int ret = ccm_crypt(ctx, SASI_AES_DECRYPT, length, iv, iv_len, add, add_len, input, output, mac, tag_len);
+    if (ret == MBEDTLS_ERR_CCM_AUTH_FAILED)
+    {
+        memset(output, 0, length);
+    }
+
+    return ret;
+}
+
+#endif /* MBEDTLS_CCM_ALT */
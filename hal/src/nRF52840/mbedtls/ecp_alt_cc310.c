@@ -105,6 +105,11 @@
 #include "crys_ecpki_kg.h"
 #include "crys_ecpki_domain.h"
 #include "ssi_bitops.h"
+#include "hal_irq_flag.h"
+
+#if defined(MBEDTLS_HMAC_DRBG_C)
+#include "mbedtls/hmac_drbg.h"
+#endif
 
 #if defined(MBEDTLS_PLATFORM_C)
 #include "mbedtls/platform.h"
@@ -749,6 +754,181 @@ cleanup:
     return ret;
 }
 
+/*
+ * Precomputed secp256r1 keypairs.
+ *
+ * Generating the ephemeral key dominates the ECDHE part of a handshake, so
+ * mbedtls_ecp_precompute_keypair() generates a few keypairs in advance. When
+ * a random private key is requested, mbedtls_ecp_gen_privkey() returns the
+ * private key of a precomputed keypair, and the subsequent multiplication of
+ * that key by the base point returns the precomputed public key. Each keypair
+ * is used only once.
+ */
+#define ECP_PRECOMPUTED_KEYPAIR_COUNT   2
+#define ECP_PRECOMPUTED_KEY_SIZE        32
+
+typedef struct
+{
+    unsigned char d[ECP_PRECOMPUTED_KEY_SIZE];
+    unsigned char x[ECP_PRECOMPUTED_KEY_SIZE];
+    unsigned char y[ECP_PRECOMPUTED_KEY_SIZE];
+} ecp_precomputed_keypair;
+
+static ecp_precomputed_keypair ecp_precomputed_keypairs[ECP_PRECOMPUTED_KEYPAIR_COUNT];
+static unsigned ecp_precomputed_keypair_count = 0;
+
+/* Keypair whose private key has been returned by mbedtls_ecp_gen_privkey() */
+static ecp_precomputed_keypair ecp_pending_keypair;
+static int ecp_pending_keypair_valid = 0;
+
+static int ecp_precomputed_keypair_usable( const mbedtls_ecp_group *grp,
+                                           int (*f_rng)(void *, unsigned char *, size_t) )
+{
+    if( grp->id != MBEDTLS_ECP_DP_SECP256R1 )
+        return( 0 );
+
+#if defined(MBEDTLS_HMAC_DRBG_C)
+    /* Deterministic ECDSA derives the key from the message being signed */
+    if( f_rng == mbedtls_hmac_drbg_random )
+        return( 0 );
+#endif
+
+    return( 1 );
+}
+
+/*
+ * Returns 1 if a precomputed private key has been stored in d, 0 if there
+ * are no precomputed keypairs, or a negative error code.
+ */
+static int ecp_take_precomputed_privkey( mbedtls_mpi *d )
+{
+    int ret;
+    int found = 0;
+    ecp_precomputed_keypair kp;
+
+    int irq = HAL_disable_irq();
+    if( ecp_precomputed_keypair_count > 0 )
+    {
+        --ecp_precomputed_keypair_count;
+        kp = ecp_precomputed_keypairs[ecp_precomputed_keypair_count];
+        mbedtls_platform_zeroize( &ecp_precomputed_keypairs[ecp_precomputed_keypair_count],
+                                  sizeof( ecp_precomputed_keypair ) );
+        ecp_pending_keypair = kp;
+        ecp_pending_keypair_valid = 1;
+        found = 1;
+    }
+    HAL_enable_irq( irq );
+
+    if( !found )
+        return( 0 );
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_binary( d, kp.d, sizeof( kp.d ) ) );
+    ret = 1;
+
+cleanup:
+    mbedtls_platform_zeroize( &kp, sizeof( kp ) );
+
+    return( ret );
+}
+
+/*
+ * Returns 1 if R = m * P has been taken from the pending precomputed keypair,
+ * 0 if the point needs to be computed, or a negative error code.
+ */
+static int ecp_take_precomputed_pubkey( const mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
+                                        const mbedtls_mpi *m, const mbedtls_ecp_point *P )
+{
+    int ret;
+    int found = 0;
+    unsigned char diff = 0;
+    unsigned char d[ECP_PRECOMPUTED_KEY_SIZE];
+    ecp_precomputed_keypair kp;
+    size_t i;
+
+    if( grp->id != MBEDTLS_ECP_DP_SECP256R1 || !ecp_pending_keypair_valid ||
+        mbedtls_ecp_point_cmp( P, &grp->G ) != 0 )
+        return( 0 );
+
+    if( mbedtls_mpi_write_binary( m, d, sizeof( d ) ) != 0 )
+        return( 0 );
+
+    int irq = HAL_disable_irq();
+    if( ecp_pending_keypair_valid )
+    {
+        /* Constant-time comparison of the private keys */
+        for( i = 0; i < sizeof( d ); i++ )
+            diff |= d[i] ^ ecp_pending_keypair.d[i];
+
+        if( diff == 0 )
+        {
+            kp = ecp_pending_keypair;
+            mbedtls_platform_zeroize( &ecp_pending_keypair, sizeof( ecp_pending_keypair ) );
+            ecp_pending_keypair_valid = 0;
+            found = 1;
+        }
+    }
+    HAL_enable_irq( irq );
+
+    mbedtls_platform_zeroize( d, sizeof( d ) );
+
+    if( !found )
+        return( 0 );
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_binary( &R->X, kp.x, sizeof( kp.x ) ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_binary( &R->Y, kp.y, sizeof( kp.y ) ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_lset( &R->Z, 1 ) );
+    ret = 1;
+
+cleanup:
+    mbedtls_platform_zeroize( &kp, sizeof( kp ) );
+
+    return( ret );
+}
+
+/*
+ * Generate one secp256r1 keypair in advance, unless enough keypairs have
+ * been generated already
+ */
+int mbedtls_ecp_precompute_keypair( void *reserved )
+{
+    int ret;
+    mbedtls_ecp_group grp;
+    mbedtls_mpi d;
+    mbedtls_ecp_point Q;
+    ecp_precomputed_keypair kp;
+
+    (void)reserved;
+
+    if( ecp_precomputed_keypair_count >= ECP_PRECOMPUTED_KEYPAIR_COUNT )
+        return( 0 );
+
+    mbedtls_ecp_group_init( &grp );
+    mbedtls_mpi_init( &d );
+    mbedtls_ecp_point_init( &Q );
+
+    MBEDTLS_MPI_CHK( mbedtls_ecp_group_load( &grp, MBEDTLS_ECP_DP_SECP256R1 ) );
+    MBEDTLS_MPI_CHK( ecp_gen_keypair_cryptocell( CRYS_ECPKI_DomainID_secp256r1, &grp.G, &d, &Q ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_write_binary( &d, kp.d, sizeof( kp.d ) ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_write_binary( &Q.X, kp.x, sizeof( kp.x ) ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_write_binary( &Q.Y, kp.y, sizeof( kp.y ) ) );
+
+    int irq = HAL_disable_irq();
+    if( ecp_precomputed_keypair_count < ECP_PRECOMPUTED_KEYPAIR_COUNT )
+    {
+        ecp_precomputed_keypairs[ecp_precomputed_keypair_count] = kp;
+        ++ecp_precomputed_keypair_count;
+    }
+    HAL_enable_irq( irq );
+
+cleanup:
+    mbedtls_platform_zeroize( &kp, sizeof( kp ) );
+    mbedtls_ecp_point_free( &Q );
+    mbedtls_mpi_free( &d );
+    mbedtls_ecp_group_free( &grp );
+
+    return( ret );
+}
+
 /*
  * List of supported curves and associated info
  */
@@ -2641,7 +2821,15 @@ int mbedtls_ecp_mul_restartable( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
         CRYS_ECPKI_DomainID_t cc_id = mbedtls_to_cryptocell_group_id( grp->id );
         if ( cc_id != CRYS_ECPKI_DomainIDLast )
         {
-            ret = ecp_mul_ws_cryptocell( cc_id, R, m, P );
+            ret = ecp_take_precomputed_pubkey( grp, R, m, P );
+            if ( ret == 0 )
+            {
+                ret = ecp_mul_ws_cryptocell( cc_id, R, m, P );
+            }
+            else if ( ret > 0 )
+            {
+                ret = 0;
+            }
         }
         else
         {
@@ -2975,6 +3163,13 @@ int mbedtls_ecp_gen_privkey( const mbedtls_ecp_group *grp,
         /* SEC1 3.2.1: Generate d such that 1 <= n < N */
         int count = 0;
 
+        if( ecp_precomputed_keypair_usable( grp, f_rng ) )
+        {
+            ret = ecp_take_precomputed_privkey( d );
+            if( ret != 0 )
+                return( ret > 0 ? 0 : ret );
+        }
+
         /*
          * Match the procedure given in RFC 6979 (deterministic ECDSA):
          * - use the same byte ordering;
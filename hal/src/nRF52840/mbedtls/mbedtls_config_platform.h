@@ -231,6 +231,7 @@
 #define MBEDTLS_ECP_ALT
 #define MBEDTLS_SHA256_ALT
 #define MBEDTLS_SHA1_ALT
+#define MBEDTLS_CCM_ALT
 
 //#define MBEDTLS_ARC4_ALT
 //#define MBEDTLS_BLOWFISH_ALT
@@ -1238,7 +1239,7 @@
  *
  * Comment this macro to disable support for server name indication in SSL
  */
-//#define MBEDTLS_SSL_SERVER_NAME_INDICATION
+#define MBEDTLS_SSL_SERVER_NAME_INDICATION
 
 /**
  * \def MBEDTLS_SSL_TRUNCATED_HMAC
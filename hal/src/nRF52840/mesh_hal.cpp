@@ -18,12 +18,69 @@
 #include "mesh_hal.h"
 
 #include "radio_common.h"
+#include "ot_api.h"
+#include "openthread/platform-nrf5.h"
+#include "spark_wiring_diagnostics.h"
 
 #include "check.h"
 
 using namespace particle;
+using namespace particle::net::ot;
+
+namespace {
+
+// Fraction of the time since boot the 802.15.4 radio has spent outside of the sleep state, in
+// parts per thousand. This is the main factor of the battery life of a Sleepy End Device
+class RadioDutyCycleDiagnosticData: public AbstractIntegerDiagnosticData {
+public:
+    RadioDutyCycleDiagnosticData() :
+            AbstractIntegerDiagnosticData(DIAG_ID_NETWORK_MESH_RADIO_DUTY_CYCLE,
+                    DIAG_NAME_NETWORK_MESH_RADIO_DUTY_CYCLE) {
+    }
+
+    int get(IntType& val) override {
+        ThreadLock lk;
+        const uint64_t uptime = nrf5AlarmGetCurrentTime();
+        if (!uptime) {
+            return SYSTEM_ERROR_NOT_SUPPORTED;
+        }
+        val = nrf5RadioGetAwakeTime() * 1000 / uptime;
+        return 0;
+    }
+};
+
+RadioDutyCycleDiagnosticData g_radioDutyCycleDiagData;
+
+} // unnamed
 
 int mesh_select_antenna(int antenna, void* reserved) {
 	CHECK(selectRadioAntenna((radio_antenna_type)antenna));
 	return 0;
 }
+
+int mesh_set_sleepy_config(const mesh_sleepy_config* conf, void* reserved) {
+    CHECK_TRUE(conf, SYSTEM_ERROR_INVALID_ARGUMENT);
+    const auto ot = ot_get_instance();
+    CHECK_TRUE(ot, SYSTEM_ERROR_INVALID_STATE);
+    CHECK(ot_set_sleepy_end_device(ot, conf->poll_period, conf->child_timeout));
+    return 0;
+}
+
+int mesh_get_sleepy_config(mesh_sleepy_config* conf, void* reserved) {
+    CHECK_TRUE(conf, SYSTEM_ERROR_INVALID_ARGUMENT);
+    const auto ot = ot_get_instance();
+    CHECK_TRUE(ot, SYSTEM_ERROR_INVALID_STATE);
+    uint32_t pollPeriod = 0;
+    uint32_t childTimeout = 0;
+    CHECK(ot_get_sleepy_end_device(ot, &pollPeriod, &childTimeout));
+    conf->poll_period = pollPeriod;
+    conf->child_timeout = childTimeout;
+    return 0;
+}
+
+int mesh_poll_parent(void* reserved) {
+    const auto ot = ot_get_instance();
+    CHECK_TRUE(ot, SYSTEM_ERROR_INVALID_STATE);
+    CHECK(ot_poll_parent(ot));
+    return 0;
+}
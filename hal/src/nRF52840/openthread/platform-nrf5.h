@@ -160,6 +160,14 @@ void nrf5RadioDeinit(void);
  */
 void nrf5RadioProcess(otInstance *aInstance);
 
+/**
+ * Function for retrieving the time the radio has spent outside of the sleep state.
+ *
+ * @returns Time in microseconds.
+ *
+ */
+uint64_t nrf5RadioGetAwakeTime(void);
+
 /**
  * Initialization of hardware crypto engine.
  *
@@ -78,6 +78,11 @@ enum
 
 static bool sDisabled;
 
+// Time the radio has spent outside of the sleep state, in microseconds
+static uint64_t sAwakeTime;
+static uint64_t sAwakeSince;
+static bool     sAwake;
+
 static otError      sReceiveError = OT_ERROR_NONE;
 static otRadioFrame sReceivedFrames[NRF_802154_RX_BUFFERS];
 static otRadioFrame sTransmitFrame;
@@ -229,6 +234,36 @@ void otPlatRadioSetShortAddress(otInstance *aInstance, uint16_t aShortAddress)
     nrf_802154_short_address_set(address);
 }
 
+static void radioAwake(void)
+{
+    if (!sAwake)
+    {
+        sAwakeSince = nrf5AlarmGetCurrentTime();
+        sAwake      = true;
+    }
+}
+
+static void radioAsleep(void)
+{
+    if (sAwake)
+    {
+        sAwakeTime += nrf5AlarmGetCurrentTime() - sAwakeSince;
+        sAwake = false;
+    }
+}
+
+uint64_t nrf5RadioGetAwakeTime(void)
+{
+    uint64_t time = sAwakeTime;
+
+    if (sAwake)
+    {
+        time += nrf5AlarmGetCurrentTime() - sAwakeSince;
+    }
+
+    return time;
+}
+
 void nrf5RadioInit(void)
 {
     dataInit();
@@ -238,6 +273,7 @@ void nrf5RadioInit(void)
 void nrf5RadioDeinit(void)
 {
     nrf_802154_sleep();
+    radioAsleep();
     nrf_802154_deinit();
     sPendingEvents = 0;
 }
@@ -318,6 +354,7 @@ otError otPlatRadioSleep(otInstance *aInstance)
 
     if (nrf_802154_sleep())
     {
+        radioAsleep();
         clearPendingEvents();
     }
     else
@@ -340,6 +377,11 @@ otError otPlatRadioReceive(otInstance *aInstance, uint8_t aChannel)
     result = nrf_802154_receive();
     clearPendingEvents();
 
+    if (result)
+    {
+        radioAwake();
+    }
+
     return result ? OT_ERROR_NONE : OT_ERROR_INVALID_STATE;
 }
 
@@ -350,6 +392,7 @@ otError otPlatRadioTransmit(otInstance *aInstance, otRadioFrame *aFrame)
     aFrame->mPsdu[-1] = aFrame->mLength;
 
     nrf_802154_channel_set(aFrame->mChannel);
+    radioAwake();
 
     if (aFrame->mInfo.mTxInfo.mCsmaCaEnabled)
     {
@@ -668,6 +711,7 @@ void nrf5RadioProcess(otInstance *aInstance)
     {
         if (nrf_802154_sleep())
         {
+            radioAsleep();
             resetPendingEvent(kPendingEventSleep);
         }
         else
@@ -44,14 +44,19 @@ void otPlatSettingsInit(otInstance* aInstance)
 }
 
 otError otPlatSettingsBeginChange(otInstance* aInstance) {
-    return OT_ERROR_NONE;
+    /* The changes are committed to the flash in one go in otPlatSettingsCommitChange() */
+    int r = s_settingsFile.beginTransaction();
+    return r == 0 ? OT_ERROR_NONE : OT_ERROR_FAILED;
 }
 
 otError otPlatSettingsCommitChange(otInstance* aInstance) {
-    return OT_ERROR_NONE;
+    int r = s_settingsFile.commitTransaction();
+    return r == 0 ? OT_ERROR_NONE : OT_ERROR_FAILED;
 }
 
 otError otPlatSettingsAbandonChange(otInstance* aInstance) {
+    /* The changes can't be rolled back, but the transaction still needs to be finished */
+    s_settingsFile.commitTransaction();
     return OT_ERROR_NOT_IMPLEMENTED;
 }
 
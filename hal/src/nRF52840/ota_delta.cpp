@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ota_delta.h"
+#include "exflash_hal.h"
+#include "flash_mal.h"
+#include "miniz.h"
+#include "system_error.h"
+#include "service_debug.h"
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <new>
+
+namespace {
+
+const size_t BUFFER_SIZE = 256;
+
+/**
+ * A source of image data.
+ */
+class ImageSource {
+public:
+    virtual ~ImageSource() = default;
+
+    /**
+     * Reads exactly `size` bytes.
+     */
+    virtual int read(void* data, size_t size) = 0;
+};
+
+/**
+ * Reads the image from the external flash.
+ */
+class FlashSource: public ImageSource {
+public:
+    FlashSource(uint32_t address, uint32_t length) :
+            address_(address),
+            end_(address + length) {
+    }
+
+    int read(void* data, size_t size) override {
+        if (size > end_ - address_) {
+            return SYSTEM_ERROR_NOT_ENOUGH_DATA;
+        }
+        if (hal_exflash_read(address_, (uint8_t*)data, size) != 0) {
+            return SYSTEM_ERROR_IO;
+        }
+        address_ += size;
+        return 0;
+    }
+
+    uint32_t available() const {
+        return end_ - address_;
+    }
+
+    uint32_t address() const {
+        return address_;
+    }
+
+private:
+    uint32_t address_;
+    uint32_t end_;
+};
+
+/**
+ * Decompresses a raw deflate stream read from another source.
+ */
+class InflateSource: public ImageSource {
+public:
+    explicit InflateSource(FlashSource& source) :
+            source_(source),
+            inPos_(0),
+            inSize_(0),
+            outNext_(0),
+            outPos_(0),
+            outSize_(0),
+            done_(false) {
+        tinfl_init(&inflator_);
+    }
+
+    int read(void* data, size_t size) override {
+        uint8_t* p = (uint8_t*)data;
+        while (size > 0) {
+            if (outSize_ > 0) {
+                const size_t n = std::min(size, outSize_);
+                memcpy(p, dict_ + outPos_, n);
+                outPos_ += n;
+                outSize_ -= n;
+                p += n;
+                size -= n;
+                continue;
+            }
+            if (done_) {
+                return SYSTEM_ERROR_NOT_ENOUGH_DATA;
+            }
+            const int ret = inflate();
+            if (ret != 0) {
+                return ret;
+            }
+        }
+        return 0;
+    }
+
+private:
+    FlashSource& source_;
+    tinfl_decompressor inflator_;
+    uint8_t in_[BUFFER_SIZE];
+    size_t inPos_;
+    size_t inSize_;
+    // The decompressor writes to the dictionary buffer, wrapping around at its end
+    uint8_t dict_[TINFL_LZ_DICT_SIZE];
+    size_t outNext_;
+    size_t outPos_;
+    size_t outSize_;
+    bool done_;
+
+    int inflate() {
+        if (inPos_ == inSize_ && source_.available() > 0) {
+            inSize_ = std::min(sizeof(in_), (size_t)source_.available());
+            inPos_ = 0;
+            const int ret = source_.read(in_, inSize_);
+            if (ret != 0) {
+                return ret;
+            }
+        }
+        size_t inLength = inSize_ - inPos_;
+        size_t outLength = sizeof(dict_) - outNext_;
+        const int flags = source_.available() > 0 ? TINFL_FLAG_HAS_MORE_INPUT : 0;
+        const tinfl_status status = tinfl_decompress(&inflator_, in_ + inPos_, &inLength, dict_, dict_ + outNext_,
+                &outLength, flags);
+        if (status < TINFL_STATUS_DONE) {
+            return SYSTEM_ERROR_BAD_DATA;
+        }
+        inPos_ += inLength;
+        outPos_ = outNext_;
+        outSize_ = outLength;
+        outNext_ = (outNext_ + outLength) & (sizeof(dict_) - 1);
+        if (status == TINFL_STATUS_DONE) {
+            done_ = true;
+        } else if (status == TINFL_STATUS_NEEDS_MORE_INPUT && inPos_ == inSize_ && !source_.available()) {
+            return SYSTEM_ERROR_NOT_ENOUGH_DATA;
+        }
+        return 0;
+    }
+};
+
+/**
+ * Writes the reconstructed module to the external flash.
+ */
+class TargetWriter {
+public:
+    TargetWriter(uint32_t address, uint32_t length) :
+            address_(address),
+            end_(address + length) {
+    }
+
+    int write(const uint8_t* data, size_t size) {
+        if (size > end_ - address_) {
+            return SYSTEM_ERROR_TOO_LARGE;
+        }
+        if (hal_exflash_write(address_, data, size) != 0) {
+            return SYSTEM_ERROR_IO;
+        }
+        address_ += size;
+        return 0;
+    }
+
+    uint32_t address() const {
+        return address_;
+    }
+
+private:
+    uint32_t address_;
+    uint32_t end_;
+};
+
+int validate_source(const ota_delta_header_t& header) {
+    const module_info_t* info = FLASH_ModuleInfo(FLASH_INTERNAL, header.source_address);
+    if (!info || (uint32_t)info->module_start_address != header.source_address) {
+        return SYSTEM_ERROR_NOT_FOUND;
+    }
+    const uint32_t length = (uint32_t)info->module_end_address - (uint32_t)info->module_start_address;
+    if (length != header.source_length ||
+            memcmp(info->module_end_address, header.source_crc, sizeof(header.source_crc)) != 0) {
+        // The delta was created for a different version of the module
+        return SYSTEM_ERROR_NOT_FOUND;
+    }
+    return 0;
+}
+
+/**
+ * Applies a delta image. The magic number of the image has already been read from the source.
+ */
+int apply_delta(ImageSource& delta, uint32_t target_address, uint32_t target_length) {
+    ota_delta_header_t header = {};
+    header.magic = OTA_DELTA_MAGIC;
+    int ret = delta.read((uint8_t*)&header + sizeof(header.magic), sizeof(header) - sizeof(header.magic));
+    if (ret != 0) {
+        return ret;
+    }
+    if (header.version != OTA_DELTA_VERSION) {
+        return SYSTEM_ERROR_BAD_DATA;
+    }
+    if (header.target_length > target_length) {
+        return SYSTEM_ERROR_TOO_LARGE;
+    }
+    ret = validate_source(header);
+    if (ret != 0) {
+        LOG(ERROR, "Delta update doesn't match the installed module at 0x%08x", (unsigned)header.source_address);
+        return ret;
+    }
+    if (!FLASH_EraseMemory(FLASH_SERIAL, target_address, header.target_length)) {
+        return SYSTEM_ERROR_IO;
+    }
+
+    const uint8_t* const source = (const uint8_t*)header.source_address;
+    // The installed module includes its CRC, which can be copied too
+    const uint32_t source_length = header.source_length + sizeof(header.source_crc);
+    TargetWriter target(target_address, header.target_length);
+    uint8_t buf[BUFFER_SIZE];
+    for (;;) {
+        uint8_t op = OTA_DELTA_OP_END;
+        ret = delta.read(&op, sizeof(op));
+        if (ret != 0) {
+            return ret;
+        }
+        if (op == OTA_DELTA_OP_END) {
+            break;
+        }
+        uint32_t length = 0;
+        ret = delta.read(&length, sizeof(length));
+        if (ret != 0) {
+            return ret;
+        }
+        if (op == OTA_DELTA_OP_COPY) {
+            uint32_t offset = 0;
+            ret = delta.read(&offset, sizeof(offset));
+            if (ret != 0) {
+                return ret;
+            }
+            if (offset > source_length || length > source_length - offset) {
+                return SYSTEM_ERROR_OUT_OF_RANGE;
+            }
+            // The QSPI peripheral can only transfer data from RAM
+            while (length > 0) {
+                const size_t n = std::min(length, (uint32_t)sizeof(buf));
+                memcpy(buf, source + offset, n);
+                ret = target.write(buf, n);
+                if (ret != 0) {
+                    return ret;
+                }
+                offset += n;
+                length -= n;
+            }
+        } else if (op == OTA_DELTA_OP_INSERT) {
+            while (length > 0) {
+                const size_t n = std::min(length, (uint32_t)sizeof(buf));
+                ret = delta.read(buf, n);
+                if (ret == 0) {
+                    ret = target.write(buf, n);
+                }
+                if (ret != 0) {
+                    return ret;
+                }
+                length -= n;
+            }
+        } else {
+            return SYSTEM_ERROR_BAD_DATA;
+        }
+    }
+    if (target.address() - target_address != header.target_length) {
+        return SYSTEM_ERROR_BAD_DATA;
+    }
+    return 0;
+}
+
+/**
+ * Copies a module to the target region. The first word of the module has already been read from the source.
+ */
+int copy_module(ImageSource& module, uint32_t first_word, uint32_t length, uint32_t target_address,
+        uint32_t target_length) {
+    if (length > target_length) {
+        return SYSTEM_ERROR_TOO_LARGE;
+    }
+    if (!FLASH_EraseMemory(FLASH_SERIAL, target_address, length)) {
+        return SYSTEM_ERROR_IO;
+    }
+    TargetWriter target(target_address, length);
+    int ret = target.write((const uint8_t*)&first_word, sizeof(first_word));
+    if (ret != 0) {
+        return ret;
+    }
+    length -= sizeof(first_word);
+    uint8_t buf[BUFFER_SIZE];
+    while (length > 0) {
+        const size_t n = std::min(length, (uint32_t)sizeof(buf));
+        ret = module.read(buf, n);
+        if (ret == 0) {
+            ret = target.write(buf, n);
+        }
+        if (ret != 0) {
+            return ret;
+        }
+        length -= n;
+    }
+    return 0;
+}
+
+/**
+ * Decompresses a compressed image. The magic number of the image has already been read from the source.
+ */
+int unpack_compressed(FlashSource& image, uint32_t target_address, uint32_t target_length) {
+    ota_compressed_header_t header = {};
+    header.magic = OTA_COMPRESSED_MAGIC;
+    int ret = image.read((uint8_t*)&header + sizeof(header.magic), sizeof(header) - sizeof(header.magic));
+    if (ret != 0) {
+        return ret;
+    }
+    if (header.version != OTA_COMPRESSED_VERSION || header.compressed_length > image.available() ||
+            header.original_length < sizeof(uint32_t)) {
+        return SYSTEM_ERROR_BAD_DATA;
+    }
+    FlashSource compressed(image.address(), header.compressed_length);
+    // The decompressor state and its dictionary are too large for the stack
+    std::unique_ptr<InflateSource> inflate(new(std::nothrow) InflateSource(compressed));
+    if (!inflate) {
+        return SYSTEM_ERROR_NO_MEMORY;
+    }
+    uint32_t magic = 0;
+    ret = inflate->read(&magic, sizeof(magic));
+    if (ret != 0) {
+        return ret;
+    }
+    if (magic == OTA_DELTA_MAGIC) {
+        return apply_delta(*inflate, target_address, target_length);
+    }
+    return copy_module(*inflate, magic, header.original_length, target_address, target_length);
+}
+
+} // namespace
+
+bool ota_delta_is_packed(uint32_t address) {
+    uint32_t magic = 0;
+    return hal_exflash_read(address, (uint8_t*)&magic, sizeof(magic)) == 0 &&
+            (magic == OTA_DELTA_MAGIC || magic == OTA_COMPRESSED_MAGIC);
+}
+
+int ota_delta_unpack(uint32_t image_address, uint32_t image_length, uint32_t target_address, uint32_t target_length) {
+    FlashSource image(image_address, image_length);
+    uint32_t magic = 0;
+    const int ret = image.read(&magic, sizeof(magic));
+    if (ret != 0) {
+        return ret;
+    }
+    switch (magic) {
+    case OTA_DELTA_MAGIC:
+        return apply_delta(image, target_address, target_length);
+    case OTA_COMPRESSED_MAGIC:
+        return unpack_compressed(image, target_address, target_length);
+    default:
+        return SYSTEM_ERROR_BAD_DATA;
+    }
+}
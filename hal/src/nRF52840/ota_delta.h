@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Delta and compressed update images.
+ *
+ * A delta image is stored at the start of the OTA region instead of a complete module. It describes
+ * how to reconstruct the new module from a module that is currently installed in the internal flash.
+ * The image consists of a header followed by a sequence of records, all fields are little endian:
+ *
+ * COPY:   [OTA_DELTA_OP_COPY:1][length:4][source offset:4]
+ *         copies `length` bytes of the installed module, starting at `source offset`.
+ * INSERT: [OTA_DELTA_OP_INSERT:1][length:4][data:length]
+ *         inserts `length` bytes of new data.
+ * END:    [OTA_DELTA_OP_END:1]
+ *
+ * A compressed image consists of a header followed by a raw deflate stream, which contains either
+ * a complete module or a delta image. The compressor must use a dictionary size of at most
+ * MINIZ_LZ_DICT_SIZE bytes (see miniz_config.h).
+ *
+ * The reconstructed module, including its trailing CRC, is validated like any other module.
+ */
+
+#define OTA_DELTA_MAGIC         (0x544c4450) // "PDLT"
+#define OTA_DELTA_VERSION       (1)
+#define OTA_COMPRESSED_MAGIC    (0x50495a50) // "PZIP"
+#define OTA_COMPRESSED_VERSION  (1)
+
+typedef enum ota_delta_op_t {
+    OTA_DELTA_OP_END = 0,
+    OTA_DELTA_OP_COPY = 1,
+    OTA_DELTA_OP_INSERT = 2
+} ota_delta_op_t;
+
+typedef struct __attribute__((packed)) ota_delta_header_t {
+    uint32_t magic;             /* OTA_DELTA_MAGIC */
+    uint16_t version;           /* OTA_DELTA_VERSION */
+    uint16_t flags;             /* reserved, should be 0 */
+    uint32_t source_address;    /* start address of the installed module */
+    uint32_t source_length;     /* length of the installed module, excluding the CRC */
+    uint8_t source_crc[4];      /* CRC of the installed module, as stored after the module */
+    uint32_t target_length;     /* length of the reconstructed module, including the CRC */
+} ota_delta_header_t;
+
+typedef struct __attribute__((packed)) ota_compressed_header_t {
+    uint32_t magic;             /* OTA_COMPRESSED_MAGIC */
+    uint16_t version;           /* OTA_COMPRESSED_VERSION */
+    uint16_t flags;             /* reserved, should be 0 */
+    uint32_t compressed_length; /* length of the deflate stream following the header */
+    uint32_t original_length;   /* length of the uncompressed data */
+} ota_compressed_header_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Checks if the external flash contains a delta or compressed image at the given address.
+ */
+bool ota_delta_is_packed(uint32_t address);
+
+/**
+ * Reconstructs a module from the delta or compressed image stored in the external flash.
+ *
+ * @param image_address Address of the image.
+ * @param image_length Maximum length of the image.
+ * @param target_address Address at which the reconstructed module is written. The region is erased first.
+ * @param target_length Maximum length of the reconstructed module.
+ * @return 0 on success, or a negative result code.
+ */
+int ota_delta_unpack(uint32_t image_address, uint32_t image_length, uint32_t target_address, uint32_t target_length);
+
+#ifdef __cplusplus
+}
+#endif
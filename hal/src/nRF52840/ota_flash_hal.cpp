@@ -43,10 +43,13 @@
 #include "deviceid_hal.h"
 #include <memory>
 #include "platform_radio_stack.h"
+#include "ota_delta.h"
 
 #define OTA_CHUNK_SIZE                 (512)
 #define BOOTLOADER_RANDOM_BACKOFF_MIN  (200)
 #define BOOTLOADER_RANDOM_BACKOFF_MAX  (1000)
+// Offset in the OTA region at which a module reconstructed from a delta or compressed image is stored
+#define OTA_DELTA_TARGET_OFFSET        ((EXTERNAL_FLASH_OTA_LENGTH / 2) & ~(sFLASH_PAGESIZE - 1))
 
 static hal_update_complete_t flash_bootloader(hal_module_t* mod, uint32_t moduleLength);
 
@@ -330,15 +333,48 @@ uint16_t HAL_OTA_ChunkSize()
     return OTA_CHUNK_SIZE;
 }
 
+// Offset of the module in the OTA region. Non-zero if the module was reconstructed from a delta
+// or compressed image
+static uint32_t ota_module_offset = 0;
+
+/**
+ * Gets the bounds of the module stored in the OTA region. If the region contains a delta or
+ * compressed image, the module is reconstructed first.
+ */
+static bool get_ota_module_bounds(module_bounds_t* bounds)
+{
+    if (!ota_module_offset && ota_delta_is_packed(EXTERNAL_FLASH_OTA_ADDRESS)) {
+        const int ret = ota_delta_unpack(EXTERNAL_FLASH_OTA_ADDRESS, OTA_DELTA_TARGET_OFFSET,
+                EXTERNAL_FLASH_OTA_ADDRESS + OTA_DELTA_TARGET_OFFSET, EXTERNAL_FLASH_OTA_LENGTH - OTA_DELTA_TARGET_OFFSET);
+        if (ret != 0) {
+            LOG(ERROR, "Unable to unpack update image: %d", ret);
+            return false;
+        }
+        ota_module_offset = OTA_DELTA_TARGET_OFFSET;
+    }
+    *bounds = module_ota;
+    bounds->start_address += ota_module_offset;
+    bounds->maximum_size -= ota_module_offset;
+    return true;
+}
+
 bool HAL_FLASH_Begin(uint32_t address, uint32_t length, void* reserved)
 {
+    ota_module_offset = 0;
     FLASH_Begin(address, length);
+    ota_module_crc_begin();
     return true;
 }
 
 int HAL_FLASH_Update(const uint8_t *pBuffer, uint32_t address, uint32_t length, void* reserved)
 {
-    return FLASH_Update(pBuffer, address, length);
+    const int ret = FLASH_Update(pBuffer, address, length);
+    if (ret == 0) {
+        ota_module_crc_update(address - HAL_OTA_FlashAddress(), pBuffer, length);
+    } else {
+        ota_module_crc_end();
+    }
+    return ret;
 }
 
 static hal_update_complete_t flash_bootloader(hal_module_t* mod, uint32_t moduleLength)
@@ -381,9 +417,10 @@ static hal_update_complete_t flash_bootloader(hal_module_t* mod, uint32_t module
 
 int HAL_FLASH_OTA_Validate(hal_module_t* mod, bool userDepsOptional, module_validation_flags_t flags, void* reserved)
 {
-    hal_module_t module;
+    hal_module_t module = {};
+    module_bounds_t bounds;
 
-    bool module_fetched = fetch_module(&module, &module_ota, userDepsOptional, flags);
+    bool module_fetched = get_ota_module_bounds(&bounds) && fetch_module(&module, &bounds, userDepsOptional, flags);
 
     if (mod) 
     {
@@ -416,7 +453,7 @@ hal_update_complete_t HAL_FLASH_End(hal_module_t* mod)
 				result = platform_radio_stack_update_module(&module);
 			}
 			else {
-				if (FLASH_AddToNextAvailableModulesSlot(FLASH_SERIAL, EXTERNAL_FLASH_OTA_ADDRESS,
+				if (FLASH_AddToNextAvailableModulesSlot(FLASH_SERIAL, EXTERNAL_FLASH_OTA_ADDRESS + ota_module_offset,
 					FLASH_INTERNAL, uint32_t(module.info->module_start_address),
 					(moduleLength + 4),//+4 to copy the CRC too
 					function,
@@ -443,6 +480,7 @@ hal_update_complete_t HAL_FLASH_End(hal_module_t* mod)
     {
         WARN("OTA module not applied");
     }
+    ota_module_crc_end();
     if (mod)
     {
         memcpy(mod, &module, sizeof(hal_module_t));
@@ -19,7 +19,11 @@
 #include <stdint.h>
 #include <string.h>
 #include "flash_mal.h"
+#include "flash_hal.h"
 #include "ota_module.h"
+#include "ota_flash_hal_impl.h"
+#include "core_hal.h"
+#include "hw_config.h"
 
 // NB: Modules in external flash are made to appears as if they are located in Internal flash by means of
 // XiP - the external flash is mapped to a region of addressable memory, and can be access transparently via
@@ -38,6 +42,191 @@ inline bool in_range(uint32_t test, uint32_t start, uint32_t end)
 }
 
 
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+
+namespace {
+
+// Results of the CRC checks of the modules in the internal flash. The cache is kept in retained
+// memory, so that a warm reset doesn't need to read all of the modules again
+const uint32_t MODULE_CACHE_MAGIC = 0x4d434331;
+const unsigned MODULE_CACHE_SIZE = 4;
+
+struct ModuleCacheEntry {
+    uint32_t address;
+    uint32_t length;
+    uint32_t crc; // CRC stored in the module
+    uint32_t generation; // Write generation of the internal flash at the time the module was checked
+};
+
+struct ModuleCache {
+    uint32_t magic;
+    ModuleCacheEntry entries[MODULE_CACHE_SIZE];
+};
+
+__attribute__((section(".retained_system"))) ModuleCache g_moduleCache;
+
+bool g_moduleCacheChecked = false;
+
+// CRC of the module being received into the OTA region, computed as the data is written
+struct OtaModuleCrc {
+    uint32_t offset; // Number of contiguous bytes written from the start of the region
+    uint32_t length; // Length of the module, or 0 if its module info hasn't been received yet
+    uint32_t crc; // CRC of the first min(offset, length) bytes
+    bool valid; // Set to false if the data hasn't been written sequentially
+};
+
+OtaModuleCrc g_otaModuleCrc = {};
+
+bool check_warm_reset()
+{
+    if (OTA_Flashed_GetStatus()) {
+        return false;
+    }
+    if (HAL_Core_System_Reset_FlagSet(WATCHDOG_RESET)) {
+        return true;
+    }
+    if (!HAL_Core_System_Reset_FlagSet(SOFTWARE_RESET)) {
+        return false;
+    }
+    // A bootloader-initiated reset doesn't store a reason. The bootloader applies updates after
+    // RESET_REASON_UPDATE and RESET_REASON_DFU_MODE resets
+    switch (HAL_Core_Read_Backup_Register(BKP_DR_02)) {
+    case RESET_REASON_USER:
+    case RESET_REASON_PANIC:
+        return true;
+    default:
+        return false;
+    }
+}
+
+ModuleCache* module_cache()
+{
+    if (!g_moduleCacheChecked) {
+        // The reset reason is cleared during the startup, so this check is done on first use, which is
+        // normally the validation of the user module in HAL_Core_Config()
+        if (g_moduleCache.magic != MODULE_CACHE_MAGIC || !is_warm_reset()) {
+            memset(&g_moduleCache, 0, sizeof(g_moduleCache));
+            g_moduleCache.magic = MODULE_CACHE_MAGIC;
+        }
+        g_moduleCacheChecked = true;
+    }
+    return &g_moduleCache;
+}
+
+} // namespace
+
+bool is_warm_reset()
+{
+    // The reset reason is cleared during the startup, so the result of the first check is kept
+    static int warm = -1;
+    if (warm < 0) {
+        warm = check_warm_reset();
+    }
+    return warm;
+}
+
+bool verify_module_crc32(uint32_t start_address, uint32_t length)
+{
+    const uint32_t crc = *(const uint32_t*)(start_address + length);
+    const uint32_t generation = hal_flash_write_generation();
+    ModuleCache* const cache = module_cache();
+    ModuleCacheEntry* entry = nullptr;
+    for (unsigned i = 0; i < MODULE_CACHE_SIZE; ++i) {
+        ModuleCacheEntry* const e = &cache->entries[i];
+        if (e->address == start_address) {
+            entry = e;
+            break;
+        }
+        if (!entry && !e->address) {
+            entry = e;
+        }
+    }
+    if (entry && entry->address == start_address && entry->length == length && entry->crc == crc &&
+            entry->generation == generation) {
+        return true;
+    }
+    const bool valid = FLASH_VerifyCRC32(FLASH_INTERNAL, start_address, length);
+    if (entry) {
+        if (valid) {
+            entry->address = start_address;
+            entry->length = length;
+            entry->crc = crc;
+            entry->generation = generation;
+        } else {
+            memset(entry, 0, sizeof(*entry));
+        }
+    }
+    return valid;
+}
+
+void ota_module_crc_begin()
+{
+    g_otaModuleCrc = {};
+    g_otaModuleCrc.valid = true;
+}
+
+void ota_module_crc_update(uint32_t offset, const uint8_t* data, uint32_t size)
+{
+    OtaModuleCrc* const c = &g_otaModuleCrc;
+    if (!c->valid) {
+        return;
+    }
+    if (offset != c->offset) {
+        // Fall back to reading the module back from the flash
+        c->valid = false;
+        return;
+    }
+    if (!c->length || c->offset < c->length) {
+        uint32_t n = size;
+        if (c->length && c->length - c->offset < n) {
+            n = c->length - c->offset;
+        }
+        c->crc = Compute_CRC32(data, n, &c->crc);
+    }
+    c->offset += size;
+    if (!c->length) {
+        const module_info_t* const info = locate_module(&module_ota);
+        const uint32_t info_end = (uint32_t)info + sizeof(module_info_t) - module_ota.start_address;
+        if (c->offset >= info_end) {
+            c->length = module_length(info);
+            if (c->length < c->offset || c->length > module_ota.maximum_size - 4) {
+                // The CRC has already been computed over more data than the module contains
+                c->valid = false;
+            }
+        }
+    }
+}
+
+void ota_module_crc_end()
+{
+    g_otaModuleCrc.valid = false;
+}
+
+bool verify_ota_module_crc32(uint32_t start_address, uint32_t length)
+{
+    const OtaModuleCrc* const c = &g_otaModuleCrc;
+    if (c->valid && start_address == module_ota.start_address && length == c->length &&
+            c->offset >= length + 4) {
+        const uint32_t crc = __builtin_bswap32(*(const uint32_t*)(start_address + length));
+        return c->crc == crc;
+    }
+    return FLASH_VerifyCRC32(FLASH_INTERNAL, start_address, length);
+}
+
+#else
+
+bool verify_module_crc32(uint32_t start_address, uint32_t length)
+{
+    return FLASH_VerifyCRC32(FLASH_INTERNAL, start_address, length);
+}
+
+bool verify_ota_module_crc32(uint32_t start_address, uint32_t length)
+{
+    return FLASH_VerifyCRC32(FLASH_INTERNAL, start_address, length);
+}
+
+#endif // MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+
 /**
  * Find the module_info at a given address. No validation is done so the data
  * pointed to should not be trusted.
@@ -48,6 +237,15 @@ const module_info_t* locate_module(const module_bounds_t* bounds) {
     return FLASH_ModuleInfo(FLASH_INTERNAL, bounds->start_address);
 }
 
+static bool verify_module_integrity(const module_bounds_t* bounds, uint32_t length)
+{
+    // Modules in the OTA region can be modified without going through the internal flash HAL
+    if (bounds->store == MODULE_STORE_MAIN) {
+        return verify_module_crc32(bounds->start_address, length);
+    }
+    return verify_ota_module_crc32(bounds->start_address, length);
+}
+
 /**
  * Fetches and validates the module info found at a given location.
  * @param target        Receives the module into
@@ -75,7 +273,7 @@ bool fetch_module(hal_module_t* target, const module_bounds_t* bounds, bool user
             target->suffix = (module_info_suffix_t*)(module_end-sizeof(module_info_suffix_t));
             if (validate_module_dependencies(bounds, userDepsOptional, target->validity_checked & MODULE_VALIDATION_DEPENDENCIES_FULL))
                 target->validity_result |= MODULE_VALIDATION_DEPENDENCIES | (target->validity_checked & MODULE_VALIDATION_DEPENDENCIES_FULL);
-            if ((target->validity_checked & MODULE_VALIDATION_INTEGRITY) && FLASH_VerifyCRC32(FLASH_INTERNAL, bounds->start_address, module_length(target->info)))
+            if ((target->validity_checked & MODULE_VALIDATION_INTEGRITY) && verify_module_integrity(bounds, module_length(target->info)))
                 target->validity_result |= MODULE_VALIDATION_INTEGRITY;
         }
         else
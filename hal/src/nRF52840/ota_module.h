@@ -35,6 +35,62 @@ const module_bounds_t* find_module_bounds(uint8_t module_function, uint8_t modul
 bool fetch_module(hal_module_t* target, const module_bounds_t* bounds, bool userDepsOptional, uint16_t check_flags);
 const module_info_t* locate_module(const module_bounds_t* bounds);
 
+/**
+ * Returns true if the last reset is known to have been performed by the system firmware without
+ * the bootloader modifying the flash in the meantime.
+ */
+bool is_warm_reset();
+
+/**
+ * Verifies the CRC of a module in the internal flash.
+ *
+ * The result is cached in retained memory. The cached result is used as long as the module's
+ * stored CRC and the write generation of the internal flash don't change, and the device is only
+ * reset by the system firmware.
+ *
+ * @param start_address Start address of the module.
+ * @param length Length of the module, not including the CRC.
+ * @return {@code true} if the CRC is valid.
+ */
+bool verify_module_crc32(uint32_t start_address, uint32_t length);
+
+/**
+ * Starts computing the CRC of a module as it is written to the OTA region.
+ *
+ * The CRC is only used if the module is written sequentially from the start of the region.
+ * Otherwise, the module is read back from the flash when it is validated.
+ */
+void ota_module_crc_begin();
+
+/**
+ * Updates the CRC of the module being written to the OTA region.
+ *
+ * This function must be called after the data has been written to the flash.
+ *
+ * @param offset Offset of the data in the OTA region.
+ * @param data Data.
+ * @param size Size of the data.
+ */
+void ota_module_crc_update(uint32_t offset, const uint8_t* data, uint32_t size);
+
+/**
+ * Stops using the CRC computed by `ota_module_crc_update()`.
+ */
+void ota_module_crc_end();
+
+/**
+ * Verifies the CRC of a module in the OTA region.
+ *
+ * If the module has been written sequentially since `ota_module_crc_begin()` was called, the CRC
+ * computed while the module was being written is compared with the module's stored CRC without
+ * reading the module back from the flash.
+ *
+ * @param start_address Start address of the module.
+ * @param length Length of the module, not including the CRC.
+ * @return {@code true} if the CRC is valid.
+ */
+bool verify_ota_module_crc32(uint32_t start_address, uint32_t length);
+
 inline uint8_t module_mcu_target(const module_info_t* info) {
 	return info->reserved;
 }
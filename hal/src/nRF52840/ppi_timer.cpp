@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ppi_timer.h"
+#include "interrupts_hal.h"
+
+namespace {
+
+volatile bool g_acquired = false;
+
+} // unnamed
+
+bool ppi_timer_acquire(void) {
+    const int32_t state = HAL_disable_irq();
+    const bool ok = !g_acquired;
+    g_acquired = true;
+    HAL_enable_irq(state);
+    return ok;
+}
+
+void ppi_timer_release(void) {
+    nrf_ppi_channel_disable(PPI_TIMER_CHANNEL);
+    nrf_ppi_channel_and_fork_endpoint_setup(PPI_TIMER_CHANNEL, 0, 0, 0);
+    nrf_timer_task_trigger(PPI_TIMER, NRF_TIMER_TASK_STOP);
+    nrf_timer_task_trigger(PPI_TIMER, NRF_TIMER_TASK_SHUTDOWN);
+    nrf_timer_shorts_disable(PPI_TIMER, ~0);
+    g_acquired = false;
+}
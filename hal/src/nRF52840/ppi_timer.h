@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "nrf_timer.h"
+#include "nrf_ppi.h"
+
+/*
+ * Hardware timer and PPI channel shared by the HAL features that connect a timer to other
+ * peripherals without CPU involvement (continuous ADC sampling, GPIO edge capture). Only one
+ * of these features can be active at a time.
+ */
+#define PPI_TIMER           NRF_TIMER4
+#define PPI_TIMER_CHANNEL   NRF_PPI_CHANNEL3
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Acquire the shared timer.
+ *
+ * @return `true` if the timer has been acquired, or `false` if it's used by another feature.
+ */
+bool ppi_timer_acquire(void);
+
+/**
+ * Stop the shared timer, disconnect the PPI channel and release them.
+ */
+void ppi_timer_release(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -21,6 +21,7 @@
 #include "pinmap_hal.h"
 #include "pinmap_impl.h"
 #include "gpio_hal.h"
+#include "system_error.h"
 
 #define NRF5X_PWM_COUNT                     4
 #define PWM_CHANNEL_NUM                     4
@@ -47,6 +48,15 @@ typedef struct NRF5x_PWM_Info {
 
     bool                                    enabled;
     nrf_pwm_values_individual_t             seq_value;
+
+#if HAL_PLATFORM_PWM_SEQUENCE
+    bool                                    sequence;        // instance is used by hal_pwm_sequence_start()
+    bool                                    sequence_single; // both sequence registers refer to the same buffer
+    uint8_t                                 sequence_step;   // number of values per step
+    uint8_t                                 sequence_pins[4];
+    hal_pwm_sequence_callback               sequence_callback;
+    void*                                   sequence_context;
+#endif // HAL_PLATFORM_PWM_SEQUENCE
 } NRF5x_PWM_Info;
 
 NRF5x_PWM_Info PWM_MAP[NRF5X_PWM_COUNT] = {
@@ -117,6 +127,103 @@ static bool get_pwm_clock_setting(uint32_t value, uint32_t frequency, uint8_t re
     return false;
 }
 
+#if HAL_PLATFORM_PWM_SEQUENCE
+
+static void pwm_sequence_event(uint8_t pwm_num, nrfx_pwm_evt_type_t event_type) {
+    NRF5x_PWM_Info* info = &PWM_MAP[pwm_num];
+    if (!info->sequence_callback) {
+        return;
+    }
+    switch (event_type) {
+        case NRFX_PWM_EVT_END_SEQ0:
+        case NRFX_PWM_EVT_END_SEQ1: {
+            int buffer = (event_type == NRFX_PWM_EVT_END_SEQ1 && !info->sequence_single) ? 1 : 0;
+            info->sequence_callback(HAL_PWM_SEQUENCE_EVENT_BUFFER_END, buffer, info->sequence_context);
+            break;
+        }
+        case NRFX_PWM_EVT_FINISHED: {
+            info->sequence_callback(HAL_PWM_SEQUENCE_EVENT_FINISHED, -1, info->sequence_context);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// nrfx doesn't pass the instance to the event handler
+template<uint8_t pwm_num>
+static void pwm_sequence_handler(nrfx_pwm_evt_type_t event_type) {
+    pwm_sequence_event(pwm_num, event_type);
+}
+
+static const nrfx_pwm_handler_t PWM_SEQUENCE_HANDLERS[NRF5X_PWM_COUNT] = {
+    pwm_sequence_handler<0>,
+    pwm_sequence_handler<1>,
+    pwm_sequence_handler<2>,
+    pwm_sequence_handler<3>
+};
+
+static uint8_t pwm_sequence_step(uint8_t load_mode) {
+    switch (load_mode) {
+        case HAL_PWM_SEQUENCE_LOAD_COMMON:
+            return 1;
+        case HAL_PWM_SEQUENCE_LOAD_GROUPED:
+            return 2;
+        case HAL_PWM_SEQUENCE_LOAD_INDIVIDUAL:
+        case HAL_PWM_SEQUENCE_LOAD_WAVEFORM:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+static bool pwm_sequence_has_pin(const NRF5x_PWM_Info* info, uint16_t pin) {
+    for (int i = 0; i < PWM_CHANNEL_NUM; i++) {
+        if (info->sequence_pins[i] == pin) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void pwm_sequence_release(uint8_t pwm_num) {
+    Hal_Pin_Info* PIN_MAP = HAL_Pin_Map();
+    NRF5x_PWM_Info* info = &PWM_MAP[pwm_num];
+
+    nrfx_pwm_stop(&info->pwm, true);
+    nrfx_pwm_uninit(&info->pwm);
+    info->enabled = false;
+    info->sequence = false;
+    info->sequence_callback = nullptr;
+    info->sequence_context = nullptr;
+
+    for (int i = 0; i < PWM_CHANNEL_NUM; i++) {
+        uint8_t pin = info->sequence_pins[i];
+        if (pin != PIN_INVALID) {
+            // don't call HAL_Set_Pin_Function, it may be the caller of this function
+            nrf_gpio_cfg_default(NRF_GPIO_PIN_MAP(PIN_MAP[pin].gpio_port, PIN_MAP[pin].gpio_pin));
+            PIN_MAP[pin].pin_func = PF_NONE;
+            info->sequence_pins[i] = PIN_INVALID;
+        }
+    }
+}
+
+static int pwm_sequence_instance(uint16_t pin) {
+    if (pin >= TOTAL_PINS) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    uint8_t pwm_num = HAL_Pin_Map()[pin].pwm_instance;
+    if (pwm_num == PWM_INSTANCE_NONE) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    if (!PWM_MAP[pwm_num].sequence || !pwm_sequence_has_pin(&PWM_MAP[pwm_num], pin)) {
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
+    return pwm_num;
+}
+
+#endif // HAL_PLATFORM_PWM_SEQUENCE
+
 int uninit_pwm_pin(uint16_t pin) {
     uint32_t         ret_code;
     pwm_setting_t    pwm_setting;
@@ -125,6 +232,16 @@ int uninit_pwm_pin(uint16_t pin) {
     uint8_t          pwm_num = PIN_MAP[pin].pwm_instance;
     uint8_t          pwm_channel = PIN_MAP[pin].pwm_channel;
 
+#if HAL_PLATFORM_PWM_SEQUENCE
+    if (PWM_MAP[pwm_num].sequence) {
+        // Resetting any of the pins stops the whole sequence
+        if (pwm_sequence_has_pin(&PWM_MAP[pwm_num], pin)) {
+            pwm_sequence_release(pwm_num);
+        }
+        return 0;
+    }
+#endif // HAL_PLATFORM_PWM_SEQUENCE
+
     PWM_MAP[pwm_num].pins[pwm_channel] = PIN_INVALID;
     PWM_MAP[pwm_num].values[pwm_channel] = 0;
 
@@ -329,6 +446,12 @@ void HAL_PWM_Write_With_Frequency_Ext(uint16_t pin, uint32_t value, uint32_t pwm
         return;
     }
 
+#if HAL_PLATFORM_PWM_SEQUENCE
+    if (PWM_MAP[PIN_MAP[pin].pwm_instance].sequence) {
+        return;
+    }
+#endif // HAL_PLATFORM_PWM_SEQUENCE
+
     if(init_pwm_pin(pin, value, pwm_frequency)) {
         return;
     }
@@ -404,3 +527,185 @@ void HAL_PWM_Set_Resolution(uint16_t pin, uint8_t resolution) {
     Hal_Pin_Info* pin_info = HAL_Pin_Map() + pin;
     pin_info->pwm_resolution = resolution;
 }
+
+#if HAL_PLATFORM_PWM_SEQUENCE
+
+int hal_pwm_sequence_start(const uint16_t* pins, size_t pin_count, const hal_pwm_sequence_config* config, void* reserved) {
+    if (!pins || pin_count == 0 || pin_count > PWM_CHANNEL_NUM || !config) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    const uint8_t step = pwm_sequence_step(config->load_mode);
+    if (step == 0 || config->prescaler > NRF_PWM_CLK_125kHz) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    if (config->load_mode == HAL_PWM_SEQUENCE_LOAD_WAVEFORM) {
+        // The fourth value of each step is the top value
+        if (pin_count > PWM_CHANNEL_NUM - 1) {
+            return SYSTEM_ERROR_INVALID_ARGUMENT;
+        }
+    } else if (config->top < 3 || config->top > HAL_PWM_SEQUENCE_MAX_TOP) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    const unsigned buffer_count = config->buffers[1] ? 2 : 1;
+    for (unsigned i = 0; i < buffer_count; i++) {
+        if (!config->buffers[i] || config->lengths[i] == 0 || config->lengths[i] > HAL_PWM_SEQUENCE_MAX_LENGTH ||
+                config->lengths[i] % step != 0 || !nrfx_is_in_ram(config->buffers[i])) {
+            return SYSTEM_ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    Hal_Pin_Info* PIN_MAP = HAL_Pin_Map();
+    if (pins[0] >= TOTAL_PINS) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    const uint8_t pwm_num = PIN_MAP[pins[0]].pwm_instance;
+    if (pwm_num == PWM_INSTANCE_NONE) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    for (size_t i = 0; i < pin_count; i++) {
+        if (pins[i] >= TOTAL_PINS || PIN_MAP[pins[i]].pwm_instance != pwm_num) {
+            return SYSTEM_ERROR_INVALID_ARGUMENT;
+        }
+        for (size_t j = 0; j < i; j++) {
+            if (pins[j] == pins[i]) {
+                return SYSTEM_ERROR_INVALID_ARGUMENT;
+            }
+        }
+    }
+
+    NRF5x_PWM_Info* info = &PWM_MAP[pwm_num];
+    if (info->sequence) {
+        return SYSTEM_ERROR_BUSY;
+    }
+    // The instance can be taken over only if it's not used by other pins
+    for (int i = 0; i < PWM_CHANNEL_NUM; i++) {
+        if (info->pins[i] == PIN_INVALID) {
+            continue;
+        }
+        bool found = false;
+        for (size_t j = 0; j < pin_count; j++) {
+            if (pins[j] == info->pins[i]) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            return SYSTEM_ERROR_BUSY;
+        }
+    }
+
+    if (info->enabled) {
+        nrfx_pwm_uninit(&info->pwm);
+        info->enabled = false;
+    }
+    for (int i = 0; i < PWM_CHANNEL_NUM; i++) {
+        info->pins[i] = PIN_INVALID;
+        info->values[i] = 0;
+        info->sequence_pins[i] = (i < (int)pin_count) ? pins[i] : PIN_INVALID;
+    }
+
+    // Value i of each step drives pins[i], regardless of the channel assigned to the pin for analogWrite()
+    nrfx_pwm_config_t const pwm_config = {
+        .output_pins = {
+            get_nrf_pin(info->sequence_pins[0]),
+            get_nrf_pin(info->sequence_pins[1]),
+            get_nrf_pin(info->sequence_pins[2]),
+            get_nrf_pin(info->sequence_pins[3])
+        },
+        .irq_priority = APP_IRQ_PRIORITY_LOWEST,
+        .base_clock   = (nrf_pwm_clk_t)config->prescaler,
+        .count_mode   = NRF_PWM_MODE_UP,
+        .top_value    = (config->load_mode == HAL_PWM_SEQUENCE_LOAD_WAVEFORM) ? (uint16_t)HAL_PWM_SEQUENCE_MAX_TOP : config->top,
+        .load_mode    = (nrf_pwm_dec_load_t)config->load_mode,
+        .step_mode    = NRF_PWM_STEP_AUTO
+    };
+
+    for (size_t i = 0; i < pin_count; i++) {
+        // GPIO output mode will cause glitches, configure GPIO to default mode
+        nrf_gpio_cfg_default(NRF_GPIO_PIN_MAP(PIN_MAP[pins[i]].gpio_port, PIN_MAP[pins[i]].gpio_pin));
+    }
+
+    info->sequence_callback = config->callback;
+    info->sequence_context = config->context;
+    info->sequence_single = (buffer_count == 1);
+    info->sequence_step = step;
+
+    ret_code_t ret_code = nrfx_pwm_init(&info->pwm, &pwm_config, config->callback ? PWM_SEQUENCE_HANDLERS[pwm_num] : NULL);
+    if (ret_code) {
+        info->sequence_callback = nullptr;
+        info->sequence_context = nullptr;
+        for (int i = 0; i < PWM_CHANNEL_NUM; i++) {
+            info->sequence_pins[i] = PIN_INVALID;
+        }
+        return SYSTEM_ERROR_INTERNAL;
+    }
+    info->enabled = true;
+    info->sequence = true;
+
+    for (size_t i = 0; i < pin_count; i++) {
+        HAL_Set_Pin_Function(pins[i], PF_PWM);
+    }
+
+    uint32_t flags = 0;
+    uint16_t playback_count = config->playback_count;
+    if (config->playback_count == 0) {
+        // Restart the playback in hardware, without an interrupt per loop
+        flags |= NRFX_PWM_FLAG_LOOP | NRFX_PWM_FLAG_NO_EVT_FINISHED;
+        playback_count = 1;
+    } else {
+        flags |= NRFX_PWM_FLAG_STOP;
+    }
+    if (config->flags & HAL_PWM_SEQUENCE_FLAG_NOTIFY_BUFFER_END) {
+        flags |= NRFX_PWM_FLAG_SIGNAL_END_SEQ0 | NRFX_PWM_FLAG_SIGNAL_END_SEQ1;
+    }
+
+    nrf_pwm_sequence_t seq[2] = {};
+    for (unsigned i = 0; i < buffer_count; i++) {
+        seq[i].values.p_raw = config->buffers[i];
+        seq[i].length = config->lengths[i];
+        seq[i].repeats = config->repeats;
+        seq[i].end_delay = 0;
+    }
+    if (buffer_count == 2) {
+        nrfx_pwm_complex_playback(&info->pwm, &seq[0], &seq[1], playback_count, flags);
+    } else {
+        nrfx_pwm_simple_playback(&info->pwm, &seq[0], playback_count, flags);
+    }
+
+    return SYSTEM_ERROR_NONE;
+}
+
+int hal_pwm_sequence_update(uint16_t pin, int buffer, const uint16_t* values, size_t length, void* reserved) {
+    const int pwm_num = pwm_sequence_instance(pin);
+    if (pwm_num < 0) {
+        return pwm_num;
+    }
+    NRF5x_PWM_Info* info = &PWM_MAP[pwm_num];
+    if (buffer < 0 || buffer > (info->sequence_single ? 0 : 1) || !values || length == 0 ||
+            length > HAL_PWM_SEQUENCE_MAX_LENGTH || length % info->sequence_step != 0 || !nrfx_is_in_ram(values)) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+
+    nrf_pwm_values_t seq_values;
+    seq_values.p_raw = values;
+    // With a single buffer, both sequence registers of the peripheral play the same buffer
+    for (uint8_t seq_id = 0; seq_id < 2; ++seq_id) {
+        if (info->sequence_single || seq_id == buffer) {
+            nrfx_pwm_sequence_values_update(&info->pwm, seq_id, seq_values);
+            nrfx_pwm_sequence_length_update(&info->pwm, seq_id, (uint16_t)length);
+        }
+    }
+
+    return SYSTEM_ERROR_NONE;
+}
+
+int hal_pwm_sequence_stop(uint16_t pin, void* reserved) {
+    const int pwm_num = pwm_sequence_instance(pin);
+    if (pwm_num < 0) {
+        return pwm_num;
+    }
+    pwm_sequence_release(pwm_num);
+    return SYSTEM_ERROR_NONE;
+}
+
+#endif // HAL_PLATFORM_PWM_SEQUENCE
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "module_info.h"
+
+/**
+ * Places a function in the `.fast` section, which is copied from flash to RAM by the startup
+ * code (see `Reset_Handler`). Code running from RAM is not halted while the NVMC is writing to
+ * or erasing the internal flash, and doesn't depend on the flash cache.
+ *
+ * The functions called from a RAM function still run from flash, so this is only useful for
+ * short routines that don't call into other modules. The bootloader doesn't have the `.fast`
+ * section, so the functions are left in flash there.
+ */
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+#define RAMFUNC __attribute__((section(".fast"), noinline, long_call))
+#else
+#define RAMFUNC
+#endif
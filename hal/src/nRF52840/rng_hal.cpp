@@ -17,19 +17,162 @@
 
 #include "rng_hal.h"
 
+#include "hal_irq_flag.h"
 #include "logging.h"
 
 #include "nrf_drv_rng.h"
 
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// The RNG peripheral produces a byte every few dozen microseconds when bias correction is
+// enabled, which is too slow for the code that requests random numbers in loops. Random
+// numbers are generated by a ChaCha20 based DRBG instead, which is seeded from the peripheral.
+// The DRBG is rekeyed after producing this many bytes; entropy buffered by the peripheral
+// driver is mixed into the new key if there's enough of it
+const size_t RNG_REKEY_INTERVAL = 1024;
+
+const size_t RNG_KEY_SIZE = 32;
+
+const size_t RNG_BLOCK_WORDS = 16;
+
+inline uint32_t rotl(uint32_t val, unsigned n) {
+    return (val << n) | (val >> (32 - n));
+}
+
+inline void quarterRound(uint32_t* x, unsigned a, unsigned b, unsigned c, unsigned d) {
+    x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 16);
+    x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 12);
+    x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 8);
+    x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 7);
+}
+
+// Computes a ChaCha20 block (RFC 8439) with an all-zero nonce
+void chachaBlock(const uint32_t* key, uint64_t counter, uint32_t* out) {
+    uint32_t in[RNG_BLOCK_WORDS] = { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574 };
+    memcpy(in + 4, key, RNG_KEY_SIZE);
+    in[12] = (uint32_t)counter;
+    in[13] = (uint32_t)(counter >> 32);
+    memcpy(out, in, sizeof(in));
+    for (unsigned i = 0; i < 10; ++i) {
+        quarterRound(out, 0, 4, 8, 12);
+        quarterRound(out, 1, 5, 9, 13);
+        quarterRound(out, 2, 6, 10, 14);
+        quarterRound(out, 3, 7, 11, 15);
+        quarterRound(out, 0, 5, 10, 15);
+        quarterRound(out, 1, 6, 11, 12);
+        quarterRound(out, 2, 7, 8, 13);
+        quarterRound(out, 3, 4, 9, 14);
+    }
+    for (unsigned i = 0; i < RNG_BLOCK_WORDS; ++i) {
+        out[i] += in[i];
+    }
+}
+
+void secureZero(void* data, size_t size) {
+    volatile uint8_t* p = (volatile uint8_t*)data;
+    while (size-- > 0) {
+        *p++ = 0;
+    }
+}
+
+class Drbg {
+public:
+    constexpr Drbg() :
+            key_(),
+            block_(),
+            counter_(0),
+            pos_(sizeof(block_)),
+            generated_(0),
+            seeded_(false) {
+    }
+
+    void seed() {
+        uint32_t entropy[RNG_KEY_SIZE / 4];
+        nrf_drv_rng_block_rand((uint8_t*)entropy, sizeof(entropy));
+        const int irq = HAL_disable_irq();
+        rekey(entropy);
+        seeded_ = true;
+        HAL_enable_irq(irq);
+        secureZero(entropy, sizeof(entropy));
+    }
+
+    void generate(uint8_t* data, size_t size) {
+        if (!seeded_) {
+            seed();
+        }
+        uint32_t entropy[RNG_KEY_SIZE / 4];
+        bool hasEntropy = false;
+        if (generated_ >= RNG_REKEY_INTERVAL) {
+            // Don't wait for the peripheral if it doesn't have enough data buffered
+            hasEntropy = (nrf_drv_rng_rand((uint8_t*)entropy, sizeof(entropy)) == NRF_SUCCESS);
+        }
+        const int irq = HAL_disable_irq();
+        if (generated_ >= RNG_REKEY_INTERVAL) {
+            rekey(hasEntropy ? entropy : nullptr);
+        }
+        generated_ += size;
+        while (size > 0) {
+            if (pos_ == sizeof(block_)) {
+                chachaBlock(key_, counter_++, block_);
+                pos_ = 0;
+            }
+            const size_t n = std::min(size, sizeof(block_) - pos_);
+            uint8_t* const block = (uint8_t*)block_ + pos_;
+            memcpy(data, block, n);
+            // Don't keep the output that has been returned already
+            secureZero(block, n);
+            pos_ += n;
+            data += n;
+            size -= n;
+        }
+        HAL_enable_irq(irq);
+        if (hasEntropy) {
+            secureZero(entropy, sizeof(entropy));
+        }
+    }
+
+private:
+    uint32_t key_[RNG_KEY_SIZE / 4];
+    uint32_t block_[RNG_BLOCK_WORDS];
+    uint64_t counter_;
+    size_t pos_;
+    size_t generated_;
+    volatile bool seeded_;
+
+    // Replaces the key with the output of the DRBG mixed with the fresh entropy, so that the
+    // previous outputs can't be recovered from the current state
+    void rekey(const uint32_t* entropy) {
+        uint32_t block[RNG_BLOCK_WORDS];
+        chachaBlock(key_, counter_++, block);
+        for (unsigned i = 0; i < RNG_KEY_SIZE / 4; ++i) {
+            key_[i] = block[i] ^ (entropy ? entropy[i] : 0);
+        }
+        secureZero(block, sizeof(block));
+        secureZero(block_, sizeof(block_));
+        counter_ = 0;
+        pos_ = sizeof(block_);
+        generated_ = 0;
+    }
+};
+
+Drbg g_drbg;
+
+} // unnamed
+
 void HAL_RNG_Configuration() {
     const auto ret = nrf_drv_rng_init(nullptr);
     if (ret != NRF_SUCCESS) {
         LOG(ERROR, "nrf_drv_rng_init() failed: %d", (int)ret);
+        return;
     }
+    g_drbg.seed();
 }
 
 uint32_t HAL_RNG_GetRandomNumber() {
     uint32_t val = 0;
-    nrf_drv_rng_block_rand((uint8_t*)&val, sizeof(val));
+    g_drbg.generate((uint8_t*)&val, sizeof(val));
     return val;
 }
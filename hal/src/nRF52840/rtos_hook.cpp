@@ -20,12 +20,20 @@
 #include "service_debug.h"
 #include "hal_event.h"
 #include "concurrent_hal.h"
+#include <nrf52840.h>
 #include <atomic>
 
 namespace {
 
 std::atomic_bool sRestoreIdleThreadPriority(false);
 
+// Runtime statistics clock. The 32-bit DWT cycle counter wraps around in about a minute at
+// 64 MHz, so it's converted to a microsecond counter that is updated on every context switch
+// and, to not miss a wraparound, on every tick
+uint32_t sRunTimeLastCycles = 0;
+uint32_t sRunTimeCycles = 0; // Cycles not yet accounted in sRunTimeMicros
+uint32_t sRunTimeMicros = 0;
+
 } // anonymous
 
 extern "C" {
@@ -112,6 +120,32 @@ void vApplicationTaskDeleteHook(void* pvTaskToDelete, volatile BaseType_t* pxPen
     *pxPendYield = pdTRUE;
 }
 
+void vConfigureTimerForRunTimeStats(void) {
+    // The cycle counter is also used by the OpenThread alarm and HAL_Delay_Microseconds(),
+    // so it's never reset here
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    sRunTimeLastCycles = DWT->CYCCNT;
+}
+
+uint32_t ulGetRunTimeCounterValue(void) {
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const uint32_t cycles = DWT->CYCCNT;
+    sRunTimeCycles += cycles - sRunTimeLastCycles;
+    sRunTimeLastCycles = cycles;
+    const uint32_t cyclesPerMicro = SystemCoreClock / 1000000;
+    sRunTimeMicros += sRunTimeCycles / cyclesPerMicro;
+    sRunTimeCycles %= cyclesPerMicro;
+    const uint32_t micros = sRunTimeMicros;
+    __set_PRIMASK(primask);
+    return micros;
+}
+
+void vApplicationTickHook(void) {
+    ulGetRunTimeCounterValue();
+}
+
 void vApplicationIdleHook(void) {
     if (sRestoreIdleThreadPriority.exchange(false)) {
         // Restore IDLE thread priority back to the default one
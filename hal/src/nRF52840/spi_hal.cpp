@@ -26,6 +26,7 @@
 #include "interrupts_hal.h"
 #include "concurrent_hal.h"
 #include "delay_hal.h"
+#include "system_error.h"
 
 
 
@@ -34,6 +35,9 @@
 #define DEFAULT_BIT_ORDER       MSBFIRST
 #define DEFAULT_SPI_CLOCK       SPI_CLOCK_DIV256
 
+// Maximum transfer length supported by EasyDMA
+#define SPI_MAX_TRANSFER_LENGTH 0xFFFF
+
 typedef struct {
     const nrfx_spim_t                   *master;
     const nrfx_spis_t                   *slave;
@@ -60,6 +64,22 @@ typedef struct {
     volatile bool                       transmitting;
     volatile uint16_t                   transfer_length;
 
+    hal_spi_transaction                 *transaction_head;
+    hal_spi_transaction                 *transaction_tail;
+    volatile bool                       transaction_active;
+    bool                                transaction_settings;
+
+    uint8_t                             *ring_buffer;
+    uint16_t                            ring_block_size;
+    uint16_t                            ring_block_count;
+    volatile uint16_t                   ring_read;      // Oldest block held by the application
+    volatile uint16_t                   ring_held;      // Number of blocks held by the application
+    volatile uint32_t                   ring_dropped;
+    hal_spi_slave_ring_callback_t       ring_callback;
+    void                                *ring_context;
+    volatile bool                       ring_armed;     // false if the scratch buffer is armed
+    volatile bool                       ring_active;
+
     os_mutex_recursive_t                mutex;
 } nrf5x_spi_info_t;
 
@@ -72,22 +92,73 @@ static nrf5x_spi_info_t m_spi_map[TOTAL_SPI] = {
     {&m_spim2, &m_spis2, APP_IRQ_PRIORITY_HIGH, PIN_INVALID, D2, D3, D4},  // TODO: Change pin number
 };
 
+static const nrf_spim_mode_t nrf_spim_mode[4] = {NRF_SPIM_MODE_0, NRF_SPIM_MODE_1, NRF_SPIM_MODE_2, NRF_SPIM_MODE_3};
+
+// Receives the transactions that don't fit in the slave ring
+static uint8_t m_spi_slave_scratch[4];
+
+static void spi_transaction_next(HAL_SPI_Interface spi);
+static void spi_transaction_complete(HAL_SPI_Interface spi, int result);
+
 static void spi_master_event_handler(nrfx_spim_evt_t const * p_event, void * p_context) {
     if (p_event->type == NRFX_SPIM_EVENT_DONE) {
         // LOG_DEBUG(TRACE, ">> spi: rx: %d, tx: %d", p_event->xfer_desc.tx_length, p_event->xfer_desc.rx_length);
-        int spi = (int)p_context;
-        m_spi_map[spi].transmitting = false;
+        HAL_SPI_Interface spi = (HAL_SPI_Interface)(int)p_context;
+        if (m_spi_map[spi].transaction_active) {
+            spi_transaction_complete(spi, SYSTEM_ERROR_NONE);
+        } else {
+            m_spi_map[spi].transmitting = false;
+
+            if (m_spi_map[spi].spi_dma_user_callback) {
+                (*m_spi_map[spi].spi_dma_user_callback)();
+            }
+        }
+        // Start the next queued transaction right away
+        spi_transaction_next(spi);
+    }
+}
 
-        if (m_spi_map[spi].spi_dma_user_callback) {
-            (*m_spi_map[spi].spi_dma_user_callback)();
+// Should be called with interrupts disabled or from the SPI interrupt handler
+static uint32_t spi_slave_ring_arm(int spi) {
+    nrf5x_spi_info_t* info = &m_spi_map[spi];
+    uint8_t* rx_buf = m_spi_slave_scratch;
+    uint32_t length = sizeof(m_spi_slave_scratch);
+    info->ring_armed = (info->ring_held < info->ring_block_count);
+    if (info->ring_armed) {
+        // The blocks are filled in order, the next free one follows the ones held by the application
+        const uint16_t block = (info->ring_read + info->ring_held) % info->ring_block_count;
+        rx_buf = info->ring_buffer + block * info->ring_block_size;
+        length = info->ring_block_size;
+    }
+    return nrfx_spis_buffers_set(info->slave, NULL, 0, rx_buf, length);
+}
+
+static void spi_slave_ring_transfer_done(int spi, uint32_t length) {
+    nrf5x_spi_info_t* info = &m_spi_map[spi];
+    const uint8_t* data = NULL;
+    if (length > 0) {
+        if (info->ring_armed) {
+            const uint16_t block = (info->ring_read + info->ring_held) % info->ring_block_count;
+            data = info->ring_buffer + block * info->ring_block_size;
+            ++info->ring_held;
+        } else {
+            ++info->ring_dropped;
         }
     }
+    // Arm the next block before notifying the application, the master may start the next
+    // transaction right away
+    SPARK_ASSERT(spi_slave_ring_arm(spi) == NRF_SUCCESS);
+    if (data && info->ring_callback) {
+        info->ring_callback(data, length, info->ring_context);
+    }
 }
 
 void spi_slave_event_handler(nrfx_spis_evt_t const * p_event, void * p_context) {
     int spi = (int) p_context;
 
-    if (p_event->evt_type == NRFX_SPIS_XFER_DONE) {
+    if (p_event->evt_type == NRFX_SPIS_XFER_DONE && m_spi_map[spi].ring_active) {
+        spi_slave_ring_transfer_done(spi, p_event->rx_amount);
+    } else if (p_event->evt_type == NRFX_SPIS_XFER_DONE) {
         m_spi_map[spi].transfer_length = p_event->rx_amount;
         m_spi_map[spi].transmitting = false;
 
@@ -154,11 +225,95 @@ static inline uint8_t get_nrf_pin_num(uint8_t pin) {
     return NRF_GPIO_PIN_MAP(PIN_MAP[pin].gpio_port, PIN_MAP[pin].gpio_pin);
 }
 
+static inline void spi_apply_settings(HAL_SPI_Interface spi, uint8_t clock, uint8_t bit_order, uint8_t data_mode) {
+    // The SPIM configuration registers can be changed between transfers without reinitializing the driver
+    NRF_SPIM_Type* reg = m_spi_map[spi].master->p_reg;
+    nrf_spim_frequency_set(reg, get_nrf_spi_frequency(spi, clock));
+    nrf_spim_configure(reg, nrf_spim_mode[data_mode & 0x03],
+            (bit_order == MSBFIRST) ? NRF_SPIM_BIT_ORDER_MSB_FIRST : NRF_SPIM_BIT_ORDER_LSB_FIRST);
+}
+
+// Should be called with interrupts disabled or from the SPI interrupt handler
+static int spi_transaction_start(HAL_SPI_Interface spi, hal_spi_transaction* transaction) {
+    spi_apply_settings(spi, transaction->clock_div, transaction->bit_order, transaction->data_mode);
+    m_spi_map[spi].transaction_settings = true;
+
+    const uint8_t cs_pin = get_nrf_pin_num(transaction->cs_pin);
+    if (cs_pin != NRFX_SPIM_PIN_NOT_USED) {
+        nrf_gpio_pin_clear(cs_pin);
+    }
+
+    m_spi_map[spi].transmitting = true;
+    m_spi_map[spi].transaction_active = true;
+    m_spi_map[spi].transfer_length = transaction->length;
+
+    nrfx_spim_xfer_desc_t const spim_xfer_desc = {
+        .p_tx_buffer = (const uint8_t *)transaction->tx_buffer,
+        .tx_length   = transaction->tx_buffer ? transaction->length : 0,
+        .p_rx_buffer = (uint8_t *)transaction->rx_buffer,
+        .rx_length   = transaction->rx_buffer ? transaction->length : 0,
+    };
+    uint32_t err_code = nrfx_spim_xfer(m_spi_map[spi].master, &spim_xfer_desc, 0);
+    if (err_code == NRFX_SUCCESS) {
+        return SYSTEM_ERROR_NONE;
+    }
+
+    if (cs_pin != NRFX_SPIM_PIN_NOT_USED) {
+        nrf_gpio_pin_set(cs_pin);
+    }
+    m_spi_map[spi].transaction_active = false;
+    m_spi_map[spi].transmitting = false;
+
+    // EasyDMA can't access buffers located in flash
+    return (err_code == NRFX_ERROR_INVALID_ADDR) ? SYSTEM_ERROR_INVALID_ARGUMENT : SYSTEM_ERROR_INTERNAL;
+}
+
+// Removes the transaction at the head of the queue and invokes its callback
+static void spi_transaction_complete(HAL_SPI_Interface spi, int result) {
+    hal_spi_transaction* transaction = m_spi_map[spi].transaction_head;
+    if (m_spi_map[spi].transaction_active) {
+        const uint8_t cs_pin = get_nrf_pin_num(transaction->cs_pin);
+        if (cs_pin != NRFX_SPIM_PIN_NOT_USED) {
+            nrf_gpio_pin_set(cs_pin);
+        }
+        m_spi_map[spi].transaction_active = false;
+        m_spi_map[spi].transmitting = false;
+    }
+
+    m_spi_map[spi].transaction_head = transaction->next;
+    if (!m_spi_map[spi].transaction_head) {
+        m_spi_map[spi].transaction_tail = NULL;
+    }
+    transaction->next = NULL;
+
+    if (transaction->callback) {
+        transaction->callback(transaction, result);
+    }
+}
+
+// Should be called with interrupts disabled or from the SPI interrupt handler
+static void spi_transaction_next(HAL_SPI_Interface spi) {
+    // The completion callback may queue another transaction and start it
+    while (!m_spi_map[spi].transmitting && m_spi_map[spi].transaction_head) {
+        int ret = spi_transaction_start(spi, m_spi_map[spi].transaction_head);
+        if (ret != SYSTEM_ERROR_NONE) {
+            spi_transaction_complete(spi, ret);
+        }
+    }
+}
+
+static void spi_transaction_cancel_all(HAL_SPI_Interface spi) {
+    int32_t state = HAL_disable_irq();
+    while (m_spi_map[spi].transaction_head) {
+        spi_transaction_complete(spi, SYSTEM_ERROR_CANCELLED);
+    }
+    HAL_enable_irq(state);
+}
+
 static void spi_init(HAL_SPI_Interface spi, SPI_Mode mode) {
     uint32_t err_code;
 
     if (mode == SPI_MODE_MASTER) {
-        static const nrf_spim_mode_t nrf_spim_mode[4] = {NRF_SPIM_MODE_0, NRF_SPIM_MODE_1, NRF_SPIM_MODE_2, NRF_SPIM_MODE_3};
         nrfx_spim_config_t spim_config = NRFX_SPIM_DEFAULT_CONFIG;
         spim_config.sck_pin      = get_nrf_pin_num(m_spi_map[spi].sck_pin);
         spim_config.mosi_pin     = get_nrf_pin_num(m_spi_map[spi].mosi_pin);
@@ -172,6 +327,7 @@ static void spi_init(HAL_SPI_Interface spi, SPI_Mode mode) {
 
         err_code = nrfx_spim_init(m_spi_map[spi].master, &spim_config, spi_master_event_handler, (void *)((int)spi));
         SPARK_ASSERT(err_code == NRF_SUCCESS);
+        m_spi_map[spi].transaction_settings = false;
 
         if (HAL_Pin_Is_Valid(m_spi_map[spi].ss_pin)) {
             hal_gpio_config_t conf = {
@@ -214,9 +370,12 @@ static void spi_init(HAL_SPI_Interface spi, SPI_Mode mode) {
 static void spi_uninit(HAL_SPI_Interface spi) {
     if (m_spi_map[spi].spi_mode == SPI_MODE_MASTER) {
         nrfx_spim_uninit(m_spi_map[spi].master);
+        m_spi_map[spi].transmitting = false;
+        spi_transaction_cancel_all(spi);
     } else {
         nrfx_spis_uninit(m_spi_map[spi].slave);
         HAL_Interrupts_Detach(m_spi_map[spi].ss_pin);
+        m_spi_map[spi].ring_active = false;
     }
 
     HAL_Set_Pin_Function(m_spi_map[spi].sck_pin, PF_NONE);
@@ -228,6 +387,13 @@ static uint32_t spi_tx_rx(HAL_SPI_Interface spi, uint8_t *tx_buf, uint8_t *rx_bu
     // LOG_DEBUG(TRACE, "spi send, size: %d", size);
 
     uint32_t err_code;
+
+    if (m_spi_map[spi].transaction_settings) {
+        // Restore the interface settings after queued transactions
+        spi_apply_settings(spi, m_spi_map[spi].clock, m_spi_map[spi].bit_order, m_spi_map[spi].data_mode);
+        m_spi_map[spi].transaction_settings = false;
+    }
+
     m_spi_map[spi].transmitting = true;
     m_spi_map[spi].transfer_length = size;
 
@@ -438,6 +604,10 @@ void HAL_SPI_DMA_Transfer(HAL_SPI_Interface spi, void* tx_buffer, void* rx_buffe
     if (m_spi_map[spi].spi_mode == SPI_MODE_MASTER) {
         SPARK_ASSERT(spi_tx_rx(spi, (uint8_t *)tx_buffer, (uint8_t *)rx_buffer, length) == length);
     } else {
+        if (m_spi_map[spi].ring_active) {
+            // The interface is receiving into the slave ring
+            return;
+        }
         // reset transfer length
         m_spi_map[spi].transfer_length = 0;
         m_spi_map[spi].slave_buf_length = length;
@@ -462,6 +632,7 @@ void HAL_SPI_DMA_Transfer_Cancel(HAL_SPI_Interface spi) {
         spi_transfer_cancel(spi);
         m_spi_map[spi].transmitting = false;
         m_spi_map[spi].spi_dma_user_callback = NULL;
+        spi_transaction_cancel_all(spi);
     } else {
         // Not supported by SPI Slave
     }
@@ -529,3 +700,96 @@ int32_t HAL_SPI_Release(HAL_SPI_Interface spi, void* reserved) {
     }
     return -1;
 }
+
+int hal_spi_queue_transaction(HAL_SPI_Interface spi, hal_spi_transaction* transaction, void* reserved) {
+    if (spi >= TOTAL_SPI || !transaction || transaction->length == 0 ||
+            transaction->length > SPI_MAX_TRANSFER_LENGTH || transaction->data_mode > SPI_MODE3) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    if (!m_spi_map[spi].enabled || m_spi_map[spi].spi_mode != SPI_MODE_MASTER) {
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
+
+    if (HAL_Pin_Is_Valid(transaction->cs_pin) && HAL_Get_Pin_Mode(transaction->cs_pin) != OUTPUT) {
+        HAL_Pin_Mode(transaction->cs_pin, OUTPUT);
+        HAL_GPIO_Write(transaction->cs_pin, 1);
+    }
+
+    int32_t state = HAL_disable_irq();
+    transaction->next = NULL;
+    if (m_spi_map[spi].transaction_tail) {
+        m_spi_map[spi].transaction_tail->next = transaction;
+    } else {
+        m_spi_map[spi].transaction_head = transaction;
+    }
+    m_spi_map[spi].transaction_tail = transaction;
+    // Otherwise the transaction is started when the ongoing transfer completes
+    spi_transaction_next(spi);
+    HAL_enable_irq(state);
+
+    return SYSTEM_ERROR_NONE;
+}
+
+int hal_spi_slave_ring_start(HAL_SPI_Interface spi, const hal_spi_slave_ring_config* config, void* reserved) {
+    if (spi >= TOTAL_SPI || !config || !config->buffer || config->block_size == 0 || config->block_count < 2) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    if (!m_spi_map[spi].enabled || m_spi_map[spi].spi_mode != SPI_MODE_SLAVE || m_spi_map[spi].ring_active ||
+            m_spi_map[spi].transmitting) {
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
+
+    int32_t state = HAL_disable_irq();
+    m_spi_map[spi].ring_buffer = config->buffer;
+    m_spi_map[spi].ring_block_size = config->block_size;
+    m_spi_map[spi].ring_block_count = config->block_count;
+    m_spi_map[spi].ring_read = 0;
+    m_spi_map[spi].ring_held = 0;
+    m_spi_map[spi].ring_dropped = 0;
+    m_spi_map[spi].ring_callback = config->callback;
+    m_spi_map[spi].ring_context = config->context;
+    uint32_t err_code = spi_slave_ring_arm(spi);
+    m_spi_map[spi].ring_active = (err_code == NRF_SUCCESS);
+    HAL_enable_irq(state);
+
+    if (err_code != NRF_SUCCESS) {
+        // EasyDMA can't access buffers located in flash
+        return (err_code == NRFX_ERROR_INVALID_ADDR) ? SYSTEM_ERROR_INVALID_ARGUMENT : SYSTEM_ERROR_INTERNAL;
+    }
+    return SYSTEM_ERROR_NONE;
+}
+
+int hal_spi_slave_ring_release(HAL_SPI_Interface spi, void* reserved) {
+    if (spi >= TOTAL_SPI) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    int ret = SYSTEM_ERROR_INVALID_STATE;
+    int32_t state = HAL_disable_irq();
+    if (m_spi_map[spi].ring_active && m_spi_map[spi].ring_held > 0) {
+        // The armed block doesn't move. If the scratch buffer is armed, the next block is armed
+        // when the current transaction ends
+        m_spi_map[spi].ring_read = (m_spi_map[spi].ring_read + 1) % m_spi_map[spi].ring_block_count;
+        --m_spi_map[spi].ring_held;
+        ret = SYSTEM_ERROR_NONE;
+    }
+    HAL_enable_irq(state);
+    return ret;
+}
+
+int hal_spi_slave_ring_stop(HAL_SPI_Interface spi, void* reserved) {
+    if (spi >= TOTAL_SPI) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    if (!m_spi_map[spi].ring_active) {
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
+    const uint32_t dropped = m_spi_map[spi].ring_dropped;
+    // SPIS can't abort a transaction, reinitialize the peripheral to make sure EasyDMA doesn't
+    // write to the ring buffer anymore
+    spi_uninit(spi);
+    m_spi_map[spi].slave_tx_buf = NULL;
+    m_spi_map[spi].slave_rx_buf = NULL;
+    m_spi_map[spi].slave_buf_length = 0;
+    spi_init(spi, m_spi_map[spi].spi_mode);
+    return (dropped > 0x7fffffff) ? 0x7fffffff : (int)dropped;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#if configUSE_TICKLESS_IDLE
+
+#include "tickless_idle.h"
+#include <nrf52840.h>
+#include <nrf_rtc.h>
+#include <nrf_sdh.h>
+#include <nrf_soc.h>
+#include <nrf_drv_clock.h>
+#include <app_util_platform.h>
+
+// The RTOS tick keeps being generated by SysTick while any thread is running. When the IDLE
+// thread is about to run for 2 or more ticks, SysTick is stopped and RTC1, which is clocked
+// by LFCLK and keeps running while the CPU is sleeping, is used to wake the CPU up in time for
+// the next scheduled thread. On wakeup, the tick count is advanced by the time actually spent
+// sleeping, including the part of the tick period that had elapsed before SysTick was stopped,
+// so that absolute timeouts (os_thread_delay_until()) don't drift.
+
+// Maximum number of ticks to sleep for at a time. HAL_SysTick_Handler() is called for the
+// suppressed ticks on wakeup, so this limits how much the LED animation can be delayed
+#ifndef TICKLESS_IDLE_MAX_TICKS
+#define TICKLESS_IDLE_MAX_TICKS 25
+#endif
+
+namespace {
+
+// Sleep time is accounted in fractions of a tick such that the RTC period is an integer number
+// of units. This way, no error is accumulated when converting between RTC counts and ticks
+const uint32_t RTC_FREQUENCY = 32768;
+const uint32_t UNITS_PER_TICK = RTC_FREQUENCY;
+const uint32_t UNITS_PER_RTC_COUNT = configTICK_RATE_HZ;
+
+// RTC compare value needs to be at least 2 counts ahead of the counter to generate an event
+const uint32_t MIN_RTC_COUNTS = 2;
+
+// Minimum length of the first tick period after wakeup, in CPU cycles. This gives enough time
+// to restore the reload value before SysTick wraps around for the first time
+const uint32_t MIN_SYSTICK_CYCLES = 64;
+
+bool sRtcStarted = false;
+volatile uint32_t sSuppressedTicks = 0;
+
+inline uint32_t rtcCountsSince(uint32_t start) {
+    return (nrf_rtc_counter_get(NRF_RTC1) - start) & RTC_COUNTER_COUNTER_Msk;
+}
+
+bool startRtc() {
+    if (sRtcStarted) {
+        return true;
+    }
+    // LFCLK is requested by the SoftDevice and the OpenThread alarm (RTC2)
+    if (!nrf_drv_clock_lfclk_is_running()) {
+        return false;
+    }
+    nrf_rtc_task_trigger(NRF_RTC1, NRF_RTC_TASK_STOP);
+    nrf_rtc_task_trigger(NRF_RTC1, NRF_RTC_TASK_CLEAR);
+    nrf_rtc_prescaler_set(NRF_RTC1, 0); // RTC_FREQUENCY
+    nrf_rtc_int_disable(NRF_RTC1, NRF_RTC_INT_TICK_MASK | NRF_RTC_INT_OVERFLOW_MASK |
+            NRF_RTC_INT_COMPARE0_MASK | NRF_RTC_INT_COMPARE1_MASK | NRF_RTC_INT_COMPARE2_MASK |
+            NRF_RTC_INT_COMPARE3_MASK);
+    nrf_rtc_event_clear(NRF_RTC1, NRF_RTC_EVENT_COMPARE_0);
+    NVIC_SetPriority(RTC1_IRQn, _PRIO_APP_LOWEST);
+    NVIC_ClearPendingIRQ(RTC1_IRQn);
+    NVIC_EnableIRQ(RTC1_IRQn);
+    nrf_rtc_task_trigger(NRF_RTC1, NRF_RTC_TASK_START);
+    sRtcStarted = true;
+    return true;
+}
+
+} // anonymous
+
+extern "C" {
+
+void RTC1_IRQHandler(void) {
+    // The interrupt is only needed to wake the CPU up
+    nrf_rtc_int_disable(NRF_RTC1, NRF_RTC_INT_COMPARE0_MASK);
+    nrf_rtc_event_clear(NRF_RTC1, NRF_RTC_EVENT_COMPARE_0);
+}
+
+void hal_tickless_idle_sleep(uint32_t expected_idle_ticks) {
+    // The sleep relies on sd_app_evt_wait(), which returns as soon as an application interrupt
+    // is pending, even with the interrupts disabled in NVIC
+    if (expected_idle_ticks < 2 || !nrf_sdh_is_enabled() || !startRtc()) {
+        return;
+    }
+    if (expected_idle_ticks > TICKLESS_IDLE_MAX_TICKS) {
+        expected_idle_ticks = TICKLESS_IDLE_MAX_TICKS;
+    }
+    // This disables all but SoftDevice interrupts. SysTick is a system exception and is not
+    // affected, which is why it's stopped before anything else is done
+    uint8_t nested = 0;
+    sd_nvic_critical_region_enter(&nested);
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    const uint32_t rtcStart = nrf_rtc_counter_get(NRF_RTC1);
+    const uint32_t reload = SysTick->LOAD + 1; // CPU cycles per tick
+    const uint32_t elapsedUnits = (uint64_t)(SysTick->LOAD - SysTick->VAL) * UNITS_PER_TICK / reload;
+    // Wake up one tick early and let SysTick generate the tick that unblocks the thread, like
+    // the generic Cortex-M port does
+    const uint32_t sleepUnits = (expected_idle_ticks - 1) * UNITS_PER_TICK - elapsedUnits;
+    const uint32_t sleepCounts = sleepUnits / UNITS_PER_RTC_COUNT;
+    if (sleepCounts < MIN_RTC_COUNTS || eTaskConfirmSleepModeStatus() == eAbortSleep) {
+        // Resume the current tick period where it was stopped
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        sd_nvic_critical_region_exit(nested);
+        return;
+    }
+    nrf_rtc_event_clear(NRF_RTC1, NRF_RTC_EVENT_COMPARE_0);
+    nrf_rtc_cc_set(NRF_RTC1, 0, (rtcStart + sleepCounts) & RTC_COUNTER_COUNTER_Msk);
+    nrf_rtc_int_enable(NRF_RTC1, NRF_RTC_INT_COMPARE0_MASK);
+    __DSB();
+    // Any interrupt, including the RTC1 compare one, terminates the sleep
+    sd_app_evt_wait();
+    const uint32_t sleptCounts = rtcCountsSince(rtcStart);
+    nrf_rtc_int_disable(NRF_RTC1, NRF_RTC_INT_COMPARE0_MASK);
+    // Compensate for the time spent sleeping
+    const uint64_t totalUnits = (uint64_t)sleptCounts * UNITS_PER_RTC_COUNT + elapsedUnits;
+    uint32_t ticks = totalUnits / UNITS_PER_TICK;
+    uint32_t remainingCycles = (uint64_t)(UNITS_PER_TICK - totalUnits % UNITS_PER_TICK) * reload / UNITS_PER_TICK;
+    if (ticks >= expected_idle_ticks) {
+        // Woken up late: the tick that unblocks the thread is due immediately
+        ticks = expected_idle_ticks - 1;
+        remainingCycles = MIN_SYSTICK_CYCLES;
+    } else if (remainingCycles < MIN_SYSTICK_CYCLES) {
+        remainingCycles = MIN_SYSTICK_CYCLES;
+    }
+    // The tick count is stepped before SysTick is restarted, so the SysTick handler always sees
+    // the updated counter of suppressed ticks
+    vTaskStepTick(ticks);
+    sSuppressedTicks += ticks;
+    // Make the first tick period after wakeup complete the partially elapsed one
+    SysTick->LOAD = remainingCycles - 1;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = reload - 1;
+    sd_nvic_critical_region_exit(nested);
+}
+
+uint32_t hal_tickless_idle_take_suppressed_ticks(void) {
+    const uint32_t ticks = sSuppressedTicks;
+    sSuppressedTicks = 0;
+    return ticks;
+}
+
+} // extern "C"
+
+#endif // configUSE_TICKLESS_IDLE
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Stops the RTOS tick and puts the CPU to sleep for up to `expected_idle_ticks` ticks.
+ *
+ * This function is called by the IDLE thread via `portSUPPRESS_TICKS_AND_SLEEP()` with the
+ * scheduler suspended.
+ */
+void hal_tickless_idle_sleep(uint32_t expected_idle_ticks);
+
+/**
+ * Returns the number of ticks suppressed since the last call to this function.
+ *
+ * This function is called from the SysTick handler.
+ */
+uint32_t hal_tickless_idle_take_suppressed_ticks(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
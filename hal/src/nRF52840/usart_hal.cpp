@@ -30,6 +30,7 @@
 #include "hal_irq_flag.h"
 #include "delay_hal.h"
 #include "interrupts_hal.h"
+#include "ramfunc.h"
 
 namespace {
 
@@ -51,10 +52,10 @@ class RxLock {
 public:
     RxLock(NRF_UARTE_Type* uarte)
             : uarte_(uarte) {
-        nrf_uarte_int_disable(uarte, NRF_UARTE_INT_ENDRX_MASK);
+        nrf_uarte_int_disable(uarte, NRF_UARTE_INT_ENDRX_MASK | NRF_UARTE_INT_RXSTARTED_MASK);
     }
     ~RxLock() {
-        nrf_uarte_int_enable(uarte_, NRF_UARTE_INT_ENDRX_MASK);
+        nrf_uarte_int_enable(uarte_, NRF_UARTE_INT_ENDRX_MASK | NRF_UARTE_INT_RXSTARTED_MASK);
     }
 
 private:
@@ -86,10 +87,21 @@ Usart* getInstance(HAL_USART_Serial serial);
 void uarte0InterruptHandler(void);
 void uarte1InterruptHandler(void);
 
-const uint8_t MAX_SCHEDULED_RECEIVALS = 1;
-const size_t RESERVED_RX_SIZE = 0;
+// The UARTE latches the RX buffer pointer when a reception starts, so the next buffer can be
+// scheduled while the current one is being filled, and the ENDRX_STARTRX short switches to it
+// without waiting for the interrupt handler
+const uint8_t MAX_SCHEDULED_RECEIVALS = 2;
 const size_t RX_THRESHOLD = 4;
 
+// The RX ring buffer needs a power of two size
+inline size_t floorPow2(size_t v) {
+    size_t p = 1;
+    while (p <= v / 2) {
+        p <<= 1;
+    }
+    return p;
+}
+
 class Usart {
 public:
     Usart(NRF_UARTE_Type* instance, void (*interruptHandler)(void),
@@ -106,6 +118,7 @@ public:
               rtsPin_(rts),
               transmitting_(false),
               receiving_(0),
+              rxNextFree_(false),
               rxConsumed_(0) {
     }
 
@@ -128,7 +141,7 @@ public:
         CHECK_TRUE(conf.tx_buffer, SYSTEM_ERROR_INVALID_ARGUMENT);
         CHECK_TRUE(conf.tx_buffer_size, SYSTEM_ERROR_INVALID_ARGUMENT);
 
-        rxBuffer_.init((uint8_t*)conf.rx_buffer, conf.rx_buffer_size);
+        CHECK(rxBuffer_.init((uint8_t*)conf.rx_buffer, floorPow2(conf.rx_buffer_size)));
         txBuffer_.init((uint8_t*)conf.tx_buffer, conf.tx_buffer_size);
 
         configured_ = true;
@@ -204,7 +217,9 @@ public:
 
         disableInterrupts();
 
-        nrf_uarte_int_enable(uarte_, NRF_UARTE_INT_ENDRX_MASK | NRF_UARTE_INT_ENDTX_MASK);
+        nrf_uarte_shorts_disable(uarte_, NRF_UARTE_SHORT_ENDRX_STARTRX);
+        nrf_uarte_int_enable(uarte_, NRF_UARTE_INT_ENDRX_MASK | NRF_UARTE_INT_RXSTARTED_MASK |
+                NRF_UARTE_INT_ENDTX_MASK);
 
         NRFX_IRQ_PRIORITY_SET(nrfx_get_irq_number((void *)uarte_), prio_);
         NRFX_IRQ_ENABLE(nrfx_get_irq_number((void *)uarte_));
@@ -256,6 +271,7 @@ public:
         config_ = {};
         transmitting_ = false;
         receiving_ = 0;
+        rxNextFree_ = false;
         rxBuffer_.reset();
         txBuffer_.reset();
 
@@ -265,16 +281,8 @@ public:
     ssize_t data() {
         CHECK_TRUE(isEnabled(), SYSTEM_ERROR_INVALID_STATE);
         RxLock lk(uarte_);
-        ssize_t d = rxBuffer_.data();
-        if (receiving_) {
-            const ssize_t toConsume = timerValue() - rxConsumed_;
-            if (toConsume > 0) {
-                rxBuffer_.acquireCommit(toConsume);
-                rxConsumed_ += toConsume;
-                d += toConsume;
-            }
-        }
-        return d;
+        commitReceived();
+        return rxBuffer_.data();
     }
 
     ssize_t space() {
@@ -288,14 +296,9 @@ public:
         const ssize_t maxRead = CHECK(data());
         const size_t readSize = std::min((size_t)maxRead, size);
         CHECK_TRUE(readSize > 0, SYSTEM_ERROR_NO_MEMORY);
-        ssize_t r;
-        {
-            RxLock lk(uarte_);
-            r = CHECK(rxBuffer_.get(buffer, readSize));
-        }
-        if (!receiving_) {
-            startReceiver();
-        }
+        RxLock lk(uarte_);
+        const ssize_t r = CHECK(rxBuffer_.get(buffer, readSize));
+        startReceiver();
         return r;
     }
 
@@ -352,21 +355,30 @@ public:
         }
     }
 
-    void interruptHandler() {
+    RAMFUNC void interruptHandler() {
+        // ENDRX of the previous buffer is always processed before RXSTARTED of the next one
         if (nrf_uarte_event_check(uarte_, NRF_UARTE_EVENT_ENDRX)) {
             nrf_uarte_event_clear(uarte_, NRF_UARTE_EVENT_ENDRX);
-            nrf_uarte_event_clear(uarte_, NRF_UARTE_EVENT_RXDRDY);
-
-            nrf_timer_task_trigger(timer_, NRF_TIMER_TASK_CLEAR);
-            rxConsumed_ = 0;
-
-            if (rxBuffer_.acquirePending() > 0) {
+            // The short has already started the next reception, if any; don't let it restart
+            // the same buffer before a new one is scheduled
+            nrf_uarte_shorts_disable(uarte_, NRF_UARTE_SHORT_ENDRX_STARTRX);
+            if (--receiving_ > 0) {
+                if (!nrf_uarte_event_check(uarte_, NRF_UARTE_EVENT_RXSTARTED)) {
+                    // The next buffer was scheduled too late for the short to start it
+                    nrf_uarte_task_trigger(uarte_, NRF_UARTE_TASK_STARTRX);
+                }
+                commitReceived();
+            } else {
+                // The buffer is full, commit it and resynchronize with the byte counter
                 rxBuffer_.acquireCommit(rxBuffer_.acquirePending());
+                rxConsumed_ = timerValue();
             }
-
-            --receiving_;
             startReceiver();
-            return;
+        }
+        if (nrf_uarte_event_check(uarte_, NRF_UARTE_EVENT_RXSTARTED)) {
+            nrf_uarte_event_clear(uarte_, NRF_UARTE_EVENT_RXSTARTED);
+            rxNextFree_ = true;
+            startReceiver();
         }
         if (nrf_uarte_event_check(uarte_, NRF_UARTE_EVENT_ENDTX)) {
             nrf_uarte_event_clear(uarte_, NRF_UARTE_EVENT_ENDTX);
@@ -398,64 +410,51 @@ private:
         }
     }
 
-    void startReceiver(bool flush = false) {
-        if (receiving_ >= MAX_SCHEDULED_RECEIVALS) {
+    void startReceiver() {
+        if (receiving_ >= MAX_SCHEDULED_RECEIVALS || (receiving_ > 0 && !rxNextFree_)) {
+            // The buffer pointer of the UARTE hasn't been latched yet
             return;
         }
 
-        // Updates current size
-        rxBuffer_.acquireBegin();
-
-        const size_t acquirable = rxBuffer_.acquirable();
-        const size_t acquirableWrapped = rxBuffer_.acquirableWrapped();
-        size_t rxSize = std::max(acquirable, acquirableWrapped);
-
+        // Use at most half of the buffer for a single reception, so that there's room to schedule
+        // the next one
+        const size_t rxSize = std::min(rxBuffer_.acquirable(), std::max(rxBuffer_.size() / 2, RX_THRESHOLD));
         if (rxSize < RX_THRESHOLD) {
             return;
         }
 
-        if (RESERVED_RX_SIZE) {
-            if (!flush) {
-                // We should always reserve RESERVED_RX_SIZE bytes in the rx buffer
-                if (rxSize == acquirable) {
-                    if (acquirableWrapped < RESERVED_RX_SIZE) {
-                        if (rxSize > RESERVED_RX_SIZE) {
-                            rxSize -= RESERVED_RX_SIZE;
-                        } else {
-                            return;
-                        }
-                    }
-                } else {
-                    if (rxSize > RESERVED_RX_SIZE) {
-                        rxSize -= RESERVED_RX_SIZE;
-                    } else {
-                        return;
-                    }
-                }
-            } else {
-                rxSize = std::min(RESERVED_RX_SIZE, rxSize);
-            }
-        }
-
-        if (rxSize > 0) {
-            ++receiving_;
-            auto ptr = rxBuffer_.acquire(rxSize);
+        auto ptr = rxBuffer_.acquire(rxSize);
 #ifdef DEBUG_BUILD
-            SPARK_ASSERT(ptr);
+        SPARK_ASSERT(ptr);
 #endif // DEBUG_BUILD
+        rxNextFree_ = false;
+        nrf_uarte_rx_buffer_set(uarte_, ptr, rxSize);
+        if (receiving_++ == 0) {
             nrf_uarte_event_clear(uarte_, NRF_UARTE_EVENT_RXDRDY);
             nrf_uarte_event_clear(uarte_, NRF_UARTE_EVENT_ENDRX);
             nrf_uarte_event_clear(uarte_, NRF_UARTE_EVENT_RXTO);
-            nrf_uarte_rx_buffer_set(uarte_, ptr, rxSize);
-            if (!flush) {
-                nrf_uarte_task_trigger(uarte_, NRF_UARTE_TASK_STARTRX);
-            } else {
-                nrf_uarte_task_trigger(uarte_, NRF_UARTE_TASK_FLUSHRX);
-            }
+            nrf_uarte_event_clear(uarte_, NRF_UARTE_EVENT_RXSTARTED);
+            nrf_uarte_task_trigger(uarte_, NRF_UARTE_TASK_STARTRX);
+        } else {
+            nrf_uarte_shorts_enable(uarte_, NRF_UARTE_SHORT_ENDRX_STARTRX);
+        }
+    }
+
+    /**
+     * Makes the data received so far available for reading. The timer counts the received bytes,
+     * and the scheduled receptions are consecutive in the ring buffer, so partially filled buffers
+     * can be committed without stopping the reception.
+     */
+    void commitReceived() {
+        const size_t received = std::min(timerValue() - rxConsumed_, rxBuffer_.acquirePending());
+        if (received > 0) {
+            rxBuffer_.acquireCommit(received);
+            rxConsumed_ += received;
         }
     }
 
     void stopReceiver() {
+        nrf_uarte_shorts_disable(uarte_, NRF_UARTE_SHORT_ENDRX_STARTRX);
         if (receiving_) {
             nrf_uarte_event_clear(uarte_, NRF_UARTE_EVENT_RXTO);
             nrf_uarte_event_clear(uarte_, NRF_UARTE_EVENT_ENDRX);
@@ -499,8 +498,9 @@ private:
     void enableTimer() {
         NRFX_IRQ_DISABLE(nrfx_get_irq_number((void*)timer_));
         nrf_timer_mode_set(timer_, NRF_TIMER_MODE_COUNTER);
-        nrf_timer_bit_width_set(timer_, NRF_TIMER_BIT_WIDTH_16);
+        nrf_timer_bit_width_set(timer_, NRF_TIMER_BIT_WIDTH_32);
         nrf_timer_task_trigger(timer_, NRF_TIMER_TASK_CLEAR);
+        rxConsumed_ = 0;
         nrf_timer_task_trigger(timer_, NRF_TIMER_TASK_START);
 
         nrf_ppi_channel_endpoint_setup(ppi_, (uint32_t)&uarte_->EVENTS_RXDRDY,
@@ -603,12 +603,13 @@ private:
 
     volatile bool transmitting_;
     volatile uint8_t receiving_;
+    volatile bool rxNextFree_;
     volatile size_t rxConsumed_;
 
     Config config_ = {};
 
     particle::services::RingBuffer<uint8_t> txBuffer_;
-    particle::services::RingBuffer<uint8_t> rxBuffer_;
+    particle::services::SpscRingBuffer<uint8_t> rxBuffer_;
 };
 
 constexpr const Usart::BaudrateMap Usart::baudrateMap_[];
@@ -642,7 +643,7 @@ void uarte1InterruptHandler(void) {
 
 } // anonymous
 
-extern "C" void UARTE1_IRQHandler(void) {
+extern "C" RAMFUNC void UARTE1_IRQHandler(void) {
     uarte1InterruptHandler();
 }
 
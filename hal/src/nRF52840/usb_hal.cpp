@@ -22,6 +22,7 @@
 #include "usb_hal_cdc.h"
 #include "usb_settings.h"
 #include <mutex>
+#include <cstddef>
 
 #ifdef USB_CDC_ENABLE
 
@@ -38,6 +39,11 @@ void HAL_USB_Detach() {
 }
 
 void HAL_USB_USART_Init(HAL_USB_USART_Serial serial, const HAL_USB_USART_Config* config) {
+    uint32_t flags = 0;
+    if (config && config->size >= offsetof(HAL_USB_USART_Config, flags) + sizeof(config->flags)) {
+        flags = config->flags;
+    }
+
     if ((config == NULL) ||
         (config && (config->rx_buffer == NULL   ||
                     config->rx_buffer_size == 0 ||
@@ -53,9 +59,9 @@ void HAL_USB_USART_Init(HAL_USB_USART_Serial serial, const HAL_USB_USART_Config*
 		if (p_rx_buffer == NULL) {
 			p_rx_buffer = (uint8_t *)malloc(USB_RX_BUFFER_SIZE);
 		}
-        usb_uart_init(p_rx_buffer, USB_RX_BUFFER_SIZE, p_tx_buffer, USB_TX_BUFFER_SIZE);
+        usb_uart_init(p_rx_buffer, USB_RX_BUFFER_SIZE, p_tx_buffer, USB_TX_BUFFER_SIZE, flags);
     } else {
-        usb_uart_init(config->rx_buffer, config->rx_buffer_size, config->tx_buffer, config->tx_buffer_size);
+        usb_uart_init(config->rx_buffer, config->rx_buffer_size, config->tx_buffer, config->tx_buffer_size, flags);
     }
 }
 
@@ -96,6 +102,10 @@ int32_t HAL_USB_USART_Send_Data(HAL_USB_USART_Serial serial, uint8_t data) {
     return usb_uart_send(&data, 1);
 }
 
+int32_t HAL_USB_USART_Send_Buffer(HAL_USB_USART_Serial serial, const uint8_t* data, size_t size, void* reserved) {
+    return usb_uart_send_buffer(data, size);
+}
+
 void HAL_USB_USART_Flush_Data(HAL_USB_USART_Serial serial) {
     usb_uart_flush_tx_data();
 }
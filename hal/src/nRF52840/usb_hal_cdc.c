@@ -29,6 +29,7 @@
 
 #include "app_error.h"
 #include "app_util.h"
+#include "app_util_platform.h"
 #include "app_usbd_core.h"
 #include "app_usbd.h"
 #include "app_usbd_string_desc.h"
@@ -80,6 +81,10 @@ typedef struct {
 
     volatile bool           com_opened;
     volatile bool           transmitting;
+    bool                    high_throughput;
+    volatile uint32_t       tx_fifo_size;       // Size of the ongoing transfer sent from the TX FIFO
+    volatile bool           tx_direct;          // The ongoing transfer is sent from the caller's buffer
+    volatile bool           tx_zlp_pending;     // The last transfer ended on a packet boundary
     volatile uint32_t       rx_data_size;
     volatile bool           rx_done;
 
@@ -97,6 +102,8 @@ static usb_instance_t m_usb_instance = {0};
 static char m_rx_buffer[READ_SIZE];
 #define SEND_SIZE       NRF_DRV_USBD_EPSIZE
 static char             m_tx_buffer[SEND_SIZE];
+// Buffers of at least this size are sent without copying them in the high-throughput mode
+#define DIRECT_SEND_MIN_SIZE    (NRF_DRV_USBD_EPSIZE * 4)
 
 static void cdc_acm_user_ev_handler(app_usbd_class_inst_t const * p_inst,
                                     app_usbd_cdc_acm_user_event_t event);
@@ -127,6 +134,56 @@ static void reset_rx_tx_state(void) {
     m_usb_instance.rx_done = false;
     m_usb_instance.rx_data_size = 0;
     m_usb_instance.transmitting = false;
+    m_usb_instance.tx_fifo_size = 0;
+    m_usb_instance.tx_direct = false;
+    m_usb_instance.tx_zlp_pending = false;
+}
+
+static void start_tx_transfer(const uint8_t* data, uint32_t size) {
+    // Without a terminating short packet the host doesn't complete its read until more data arrives
+    m_usb_instance.tx_zlp_pending = m_usb_instance.high_throughput && size > 0 && (size % NRF_DRV_USBD_EPSIZE) == 0;
+
+    m_usb_instance.transmitting = true;  // app_usbd_cdc_acm_write() cause interrupt before return!
+    uint32_t ret = app_usbd_cdc_acm_write(&m_app_cdc_acm, data, size);
+    if (ret != NRF_SUCCESS) {
+        m_usb_instance.tx_fifo_size = 0;
+        m_usb_instance.tx_direct = false;
+        m_usb_instance.tx_zlp_pending = false;
+        m_usb_instance.transmitting = false;
+        LOG_DEBUG(ERROR, "ERROR: send data FAILED!");
+    }
+}
+
+// Starts the next transfer from the TX FIFO, if there's any data to send
+static void send_tx_fifo(void) {
+    app_fifo_t* fifo = &m_usb_instance.tx_fifo;
+
+    if (m_usb_instance.high_throughput) {
+        // Send all the data up to the end of the FIFO memory in one transfer. The data stays in the
+        // FIFO until the transfer is completed
+        const uint32_t pos = fifo->read_pos & fifo->buf_size_mask;
+        const uint32_t size = MIN(FIFO_LENGTH(fifo), fifo->buf_size_mask + 1 - pos);
+        if (size > 0) {
+            m_usb_instance.tx_fifo_size = size;
+            start_tx_transfer(&fifo->p_buf[pos], size);
+        } else if (m_usb_instance.tx_zlp_pending) {
+            start_tx_transfer((const uint8_t*)m_tx_buffer, 0);
+        } else {
+            m_usb_instance.transmitting = false;
+        }
+        return;
+    }
+
+    uint8_t data = 0;
+    uint16_t size = 0;
+    while ((size < SEND_SIZE) && (app_fifo_get(fifo, &data) == NRF_SUCCESS)) {
+        m_tx_buffer[size++] = data;
+    }
+    if (size == 0) {
+        m_usb_instance.transmitting = false;
+    } else {
+        start_tx_transfer((const uint8_t*)m_tx_buffer, size);
+    }
 }
 
 static void set_usb_state(HAL_USB_State state) {
@@ -193,8 +250,17 @@ static void cdc_acm_user_ev_handler(app_usbd_class_inst_t const * p_inst,
             break;
         }
         case APP_USBD_CDC_ACM_USER_EVT_TX_DONE: {
-            uint8_t data = 0;
-            uint16_t size = 0;
+            if (m_usb_instance.tx_fifo_size > 0) {
+                // Release the sent data. The FIFO may have been flushed in the meantime
+                app_fifo_t* fifo = &m_usb_instance.tx_fifo;
+                if (FIFO_LENGTH(fifo) >= m_usb_instance.tx_fifo_size) {
+                    fifo->read_pos += m_usb_instance.tx_fifo_size;
+                } else {
+                    fifo->read_pos = fifo->write_pos;
+                }
+                m_usb_instance.tx_fifo_size = 0;
+            }
+            m_usb_instance.tx_direct = false;
 
             if (m_usb_instance.com_opened == false) {
                 m_usb_instance.transmitting = false;
@@ -203,20 +269,7 @@ static void cdc_acm_user_ev_handler(app_usbd_class_inst_t const * p_inst,
                 return;
             }
 
-            while ((size < SEND_SIZE) && (app_fifo_get(&m_usb_instance.tx_fifo, &data) == NRF_SUCCESS)) {
-                m_tx_buffer[size++] = data;
-            }
-
-            if (size == 0) {
-                m_usb_instance.transmitting = false;
-            } else {
-                m_usb_instance.transmitting = true;  // app_usbd_cdc_acm_write() cause interrupt before return!
-                uint32_t ret = app_usbd_cdc_acm_write(&m_app_cdc_acm, m_tx_buffer, size);
-                if (ret != NRF_SUCCESS) {
-                    m_usb_instance.transmitting = false;
-                    LOG_DEBUG(ERROR, "ERROR: send data FAILED!");
-                }
-            }
+            send_tx_fifo();
             break;
         }
         case APP_USBD_CDC_ACM_USER_EVT_RX_DONE: {
@@ -371,13 +424,15 @@ int usb_hal_init(void) {
     return 0;
 }
 
-int usb_uart_init(uint8_t *rx_buf, uint16_t rx_buf_size, uint8_t *tx_buf, uint16_t tx_buf_size) {
+int usb_uart_init(uint8_t *rx_buf, uint16_t rx_buf_size, uint8_t *tx_buf, uint16_t tx_buf_size, uint32_t flags) {
     uint32_t ret;
 
     if (m_usb_instance.mode == USB_MODE_CDC_UART) {
         return 0;
     }
 
+    m_usb_instance.high_throughput = (flags & HAL_USB_USART_CONFIG_FLAG_HIGH_THROUGHPUT);
+
     if (app_fifo_init(&m_usb_instance.rx_fifo, rx_buf, rx_buf_size)) {
         return  -1;
     }
@@ -412,9 +467,9 @@ int usb_uart_init(uint8_t *rx_buf, uint16_t rx_buf_size, uint8_t *tx_buf, uint16
     return 0;
 }
 
-int usb_uart_send(uint8_t data[], uint16_t size) {
+static bool can_send(void) {
     if (m_usb_instance.state != HAL_USB_STATE_CONFIGURED || !m_usb_instance.com_opened) {
-        return -1;
+        return false;
     }
 
 #ifdef SOFTDEVICE_PRESENT
@@ -422,37 +477,67 @@ int usb_uart_send(uint8_t data[], uint16_t size) {
 #else
     if ((__get_PRIMASK() & 1)) {
 #endif // SOFTDEVICE_PRESENT
-        return -1;
+        return false;
     }
 
-    for (int i = 0; i < size; i++) {
+    return true;
+}
+
+static int usb_uart_put_tx_data(const uint8_t* data, size_t size) {
+    app_fifo_t* fifo = &m_usb_instance.tx_fifo;
+    size_t offs = 0;
+    while (offs < size) {
         // wait until tx fifo is available
-        while (IS_FIFO_FULL(&m_usb_instance.tx_fifo));
-        SPARK_ASSERT(app_fifo_put(&m_usb_instance.tx_fifo, data[i]) == NRF_SUCCESS);
+        while (IS_FIFO_FULL(fifo));
+        uint32_t n = MIN(size - offs, fifo->buf_size_mask + 1 - FIFO_LENGTH(fifo));
+        SPARK_ASSERT(app_fifo_write(fifo, data + offs, &n) == NRF_SUCCESS);
+        offs += n;
+
+        // trigger first transmitting
+        if (!m_usb_instance.transmitting) {
+            send_tx_fifo();
+        }
     }
 
-    uint32_t ret;
-    uint16_t pre_send_size = 0;
-    uint8_t  pre_send_data = 0;
-
-    // trigger first transmitting
-    if (!m_usb_instance.transmitting) {
-        while ((pre_send_size < SEND_SIZE) &&
-               (app_fifo_get(&m_usb_instance.tx_fifo, &pre_send_data) == NRF_SUCCESS))
-        {
-            m_tx_buffer[pre_send_size++] = pre_send_data;
-        }
+    // NOTE: we only care and report about how many bytes were actually put into the transmit buffer
+    return size;
+}
 
-        m_usb_instance.transmitting = true; // app_usbd_cdc_acm_write() cause interrupt before return!
-        ret = app_usbd_cdc_acm_write(&m_app_cdc_acm, m_tx_buffer, pre_send_size);
-        if (ret != NRF_SUCCESS) {
-            m_usb_instance.transmitting = false;
-            pre_send_size = 0;
-            LOG_DEBUG(ERROR, "ERROR: send data FAILED!");
+int usb_uart_send(uint8_t data[], uint16_t size) {
+    if (!can_send()) {
+        return -1;
+    }
+
+    return usb_uart_put_tx_data(data, size);
+}
+
+int usb_uart_send_buffer(const uint8_t* data, size_t size) {
+    if (!can_send()) {
+        return -1;
+    }
+
+    if (!m_usb_instance.high_throughput || size < DIRECT_SEND_MIN_SIZE || !nrfx_is_in_ram(data)) {
+        return usb_uart_put_tx_data(data, size);
+    }
+
+    // Let the buffered data go first
+    while ((m_usb_instance.transmitting || FIFO_LENGTH(&m_usb_instance.tx_fifo) > 0) && m_usb_instance.com_opened) {
+        if (!m_usb_instance.transmitting) {
+            send_tx_fifo();
         }
     }
 
-    // NOTE: we only care and report about how many bytes were actually put into the transmit buffer
+    // Send the caller's buffer in one multi-packet transfer and wait until it's completed
+    m_usb_instance.tx_direct = true;
+    start_tx_transfer(data, size);
+    // The transfer is aborted by the driver if the device gets detached
+    while (m_usb_instance.transmitting && m_usb_instance.tx_direct && m_usb_instance.state == HAL_USB_STATE_CONFIGURED);
+
+    if (m_usb_instance.tx_direct) {
+        m_usb_instance.tx_direct = false;
+        return -1;
+    }
+
     return size;
 }
 
@@ -556,7 +641,14 @@ void usb_uart_flush_rx_data(void) {
 }
 
 void usb_uart_flush_tx_data(void) {
-    app_fifo_flush(&m_usb_instance.tx_fifo);
+    if (m_usb_instance.high_throughput) {
+        // Keep the data of the ongoing transfer, it's released when the transfer is completed
+        CRITICAL_REGION_ENTER();
+        m_usb_instance.tx_fifo.write_pos = m_usb_instance.tx_fifo.read_pos + m_usb_instance.tx_fifo_size;
+        CRITICAL_REGION_EXIT();
+    } else {
+        app_fifo_flush(&m_usb_instance.tx_fifo);
+    }
 }
 
 int usb_uart_available_tx_data(void) {
@@ -10,9 +10,10 @@ extern "C" {
 
 int usb_hal_init(void);
 bool usb_hal_is_enabled(void);
-int usb_uart_init(uint8_t *rx_buf, uint16_t rx_buf_size, uint8_t *tx_buf, uint16_t tx_buf_size);
+int usb_uart_init(uint8_t *rx_buf, uint16_t rx_buf_size, uint8_t *tx_buf, uint16_t tx_buf_size, uint32_t flags);
 HAL_USB_State usb_hal_get_state();
 int usb_uart_send(uint8_t data[], uint16_t size);
+int usb_uart_send_buffer(const uint8_t* data, size_t size);
 int usb_uart_available_data(void);
 
 void usb_uart_set_baudrate(uint32_t baudrate);
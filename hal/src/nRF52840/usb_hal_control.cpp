@@ -25,9 +25,13 @@ LOG_SOURCE_CATEGORY("hal.usb.control");
 #include "app_usbd_core.h"
 
 #include "usbd_wcid.h"
+#include "system_error.h"
 
 namespace {
 
+#define USBD_CONTROL_BULK_EPIN  NRF_DRV_USBD_EPIN3
+#define USBD_CONTROL_BULK_EPOUT NRF_DRV_USBD_EPOUT3
+
 /* Extended Compat ID OS Descriptor */
 static const uint8_t MSFT_EXTENDED_COMPAT_ID_DESCRIPTOR[] = {
     USB_WCID_EXT_COMPAT_ID_OS_DESCRIPTOR(
@@ -60,6 +64,8 @@ HAL_USB_Vendor_Request_Callback s_usb_vendor_request_callback = nullptr;
 void* s_usb_vendor_request_callback_ctx = nullptr;
 HAL_USB_Vendor_Request_State_Callback s_usb_vendor_request_state_callback = nullptr;
 void* s_usb_vendor_request_state_callback_ctx = nullptr;
+HAL_USB_Vendor_Bulk_Callback s_usb_vendor_bulk_callback = nullptr;
+void* s_usb_vendor_bulk_callback_ctx = nullptr;
 
 static ret_code_t usbd_control_event_handler(app_usbd_class_inst_t const* inst,
         app_usbd_complex_evt_t const* event);
@@ -77,13 +83,13 @@ typedef struct {
     uint8_t none;
 } usbd_control_ctx_t;
 
-#define USBD_CONTROL_CONFIG(iface) (iface)
+#define USBD_CONTROL_CONFIG(iface, epin, epout) ((iface, epin, epout))
 #define USBD_CONTROL_INSTANCE_SPECIFIC_DEC usbd_control_inst_t inst;
 #define USBD_CONTROL_DATA_SPECIFIC_DEC usbd_control_ctx_t ctx;
 
-APP_USBD_CLASS_NO_EP_TYPEDEF(
+APP_USBD_CLASS_TYPEDEF(
     usbd_control,
-    USBD_CONTROL_CONFIG(2),
+    USBD_CONTROL_CONFIG(0, USBD_CONTROL_BULK_EPIN, USBD_CONTROL_BULK_EPOUT),
     USBD_CONTROL_INSTANCE_SPECIFIC_DEC,
     USBD_CONTROL_DATA_SPECIFIC_DEC
 );
@@ -93,11 +99,11 @@ const app_usbd_class_methods_t usbd_control_class_methods = {
     .feed_descriptors = usbd_control_feed_descriptors,
 };
 
-APP_USBD_CLASS_INST_NO_EP_GLOBAL_DEF(
+APP_USBD_CLASS_INST_GLOBAL_DEF(
     usbd_control_instance,
     usbd_control,
     &usbd_control_class_methods,
-    USBD_CONTROL_CONFIG((2)),
+    USBD_CONTROL_CONFIG(2, USBD_CONTROL_BULK_EPIN, USBD_CONTROL_BULK_EPOUT),
     ()
 );
 
@@ -115,6 +121,7 @@ ret_code_t usbd_control_setup_handler(app_usbd_class_inst_t const* inst,
 ret_code_t usbd_control_in_data_handler(nrf_drv_usbd_ep_status_t status, void* ctx);
 ret_code_t usbd_control_out_data_handler(nrf_drv_usbd_ep_status_t status, void* ctx);
 ret_code_t usbd_control_reset();
+ret_code_t usbd_control_ep_transfer_handler(nrf_drv_usbd_ep_t ep, nrf_drv_usbd_ep_status_t status);
 
 ret_code_t usbd_control_event_handler(app_usbd_class_inst_t const* inst,
         app_usbd_complex_evt_t const* event) {
@@ -137,6 +144,8 @@ ret_code_t usbd_control_event_handler(app_usbd_class_inst_t const* inst,
             break;
         }
         case APP_USBD_EVT_DRV_EPTRANSFER: {
+            ret = usbd_control_ep_transfer_handler(event->drv_evt.data.eptransfer.ep,
+                    event->drv_evt.data.eptransfer.status);
             break;
         }
         case APP_USBD_EVT_INST_APPEND: {
@@ -158,6 +167,7 @@ bool usbd_control_feed_descriptors(app_usbd_class_descriptor_ctx_t* ctx,
         app_usbd_class_inst_t const* inst, uint8_t* buf, size_t max_size) {
 
     static app_usbd_class_iface_conf_t const* curIface = nullptr;
+    static uint8_t i = 0;
     curIface = app_usbd_class_iface_get(inst, 0);
 
     APP_USBD_CLASS_DESCRIPTOR_BEGIN(ctx, buf, max_size)
@@ -167,12 +177,23 @@ bool usbd_control_feed_descriptors(app_usbd_class_descriptor_ctx_t* ctx,
     APP_USBD_CLASS_DESCRIPTOR_WRITE(APP_USBD_DESCRIPTOR_INTERFACE); // bDescriptorType
     APP_USBD_CLASS_DESCRIPTOR_WRITE(app_usbd_class_iface_number_get(curIface)); // bInterfaceNumber
     APP_USBD_CLASS_DESCRIPTOR_WRITE(0x00); // bAlternateSetting
-    APP_USBD_CLASS_DESCRIPTOR_WRITE(0x00); // bNumEndpoints
+    APP_USBD_CLASS_DESCRIPTOR_WRITE(app_usbd_class_iface_ep_count_get(curIface)); // bNumEndpoints
     APP_USBD_CLASS_DESCRIPTOR_WRITE(0xff); // bInterfaceClass
     APP_USBD_CLASS_DESCRIPTOR_WRITE(0xff); // bInterfaceSubClass
     APP_USBD_CLASS_DESCRIPTOR_WRITE(0xff); // bInterfaceProtocol
     APP_USBD_CLASS_DESCRIPTOR_WRITE(USBD_CONTROL_STRING_IDX); // iInterface
 
+    /* Bulk IN and OUT endpoint descriptors */
+    for (i = 0; i < app_usbd_class_iface_ep_count_get(curIface); i++) {
+        APP_USBD_CLASS_DESCRIPTOR_WRITE(sizeof(app_usbd_descriptor_ep_t)); // bLength
+        APP_USBD_CLASS_DESCRIPTOR_WRITE(APP_USBD_DESCRIPTOR_ENDPOINT); // bDescriptorType
+        APP_USBD_CLASS_DESCRIPTOR_WRITE(app_usbd_class_ep_address_get(app_usbd_class_iface_ep_get(curIface, i))); // bEndpointAddress
+        APP_USBD_CLASS_DESCRIPTOR_WRITE(APP_USBD_DESCRIPTOR_EP_ATTR_TYPE_BULK); // bmAttributes
+        APP_USBD_CLASS_DESCRIPTOR_WRITE(LSB_16(NRF_DRV_USBD_EPSIZE)); // wMaxPacketSize
+        APP_USBD_CLASS_DESCRIPTOR_WRITE(MSB_16(NRF_DRV_USBD_EPSIZE));
+        APP_USBD_CLASS_DESCRIPTOR_WRITE(0x00); // bInterval
+    }
+
     APP_USBD_CLASS_DESCRIPTOR_END();
 }
 
@@ -340,6 +361,37 @@ ret_code_t usbd_control_reset() {
     return NRF_SUCCESS;
 }
 
+ret_code_t usbd_control_ep_transfer_handler(nrf_drv_usbd_ep_t ep, nrf_drv_usbd_ep_status_t status) {
+    if (!s_usb_vendor_bulk_callback || (ep != USBD_CONTROL_BULK_EPIN && ep != USBD_CONTROL_BULK_EPOUT)) {
+        return NRF_SUCCESS;
+    }
+    size_t size = 0;
+    if (ep == USBD_CONTROL_BULK_EPOUT && status == NRF_USBD_EP_OK) {
+        status = nrf_drv_usbd_ep_status_get(ep, &size);
+    }
+    if (status != NRF_USBD_EP_OK) {
+        s_usb_vendor_bulk_callback(HAL_USB_VENDOR_BULK_EVENT_ERROR, 0, s_usb_vendor_bulk_callback_ctx);
+    } else if (ep == USBD_CONTROL_BULK_EPOUT) {
+        s_usb_vendor_bulk_callback(HAL_USB_VENDOR_BULK_EVENT_RX_COMPLETED, size, s_usb_vendor_bulk_callback_ctx);
+    } else {
+        s_usb_vendor_bulk_callback(HAL_USB_VENDOR_BULK_EVENT_TX_COMPLETED, 0, s_usb_vendor_bulk_callback_ctx);
+    }
+    return NRF_SUCCESS;
+}
+
+int usbd_control_bulk_result(ret_code_t ret) {
+    switch (ret) {
+    case NRF_SUCCESS:
+        return SYSTEM_ERROR_NONE;
+    case NRF_ERROR_BUSY:
+        return SYSTEM_ERROR_BUSY;
+    case NRF_ERROR_INVALID_STATE:
+        return SYSTEM_ERROR_INVALID_STATE;
+    default:
+        return SYSTEM_ERROR_IO;
+    }
+}
+
 } // anonymous
 
 extern "C" int hal_usb_control_interface_init(void* reserved) {
@@ -355,3 +407,23 @@ void HAL_USB_Set_Vendor_Request_State_Callback(HAL_USB_Vendor_Request_State_Call
     s_usb_vendor_request_state_callback = cb;
     s_usb_vendor_request_state_callback_ctx = p;
 }
+
+void HAL_USB_Set_Vendor_Bulk_Callback(HAL_USB_Vendor_Bulk_Callback cb, void* p) {
+    s_usb_vendor_bulk_callback = cb;
+    s_usb_vendor_bulk_callback_ctx = p;
+}
+
+int HAL_USB_Vendor_Bulk_Receive(uint8_t* data, size_t size, void* reserved) {
+    NRF_DRV_USBD_TRANSFER_OUT(transfer, data, size);
+    return usbd_control_bulk_result(app_usbd_ep_transfer(USBD_CONTROL_BULK_EPOUT, &transfer));
+}
+
+int HAL_USB_Vendor_Bulk_Send(const uint8_t* data, size_t size, void* reserved) {
+    NRF_DRV_USBD_TRANSFER_IN(transfer, data, size);
+    return usbd_control_bulk_result(app_usbd_ep_transfer(USBD_CONTROL_BULK_EPIN, &transfer));
+}
+
+void HAL_USB_Vendor_Bulk_Cancel(void* reserved) {
+    app_usbd_ep_abort(USBD_CONTROL_BULK_EPIN);
+    app_usbd_ep_abort(USBD_CONTROL_BULK_EPOUT);
+}
@@ -50,6 +50,9 @@ const HAL_InterruptOverrideEntry hal_interrupt_overrides[] = {
     {SysTick_IRQn, SysTickOverride},
     {USART1_IRQn, HAL_USART1_Handler},
     {USART2_IRQn, HAL_USART2_Handler},
+    {DMA2_Stream7_IRQn, HAL_USART1_DMA_Tx_Handler},
+    {DMA1_Stream5_IRQn, HAL_USART2_DMA_Rx_Handler},
+    {DMA1_Stream6_IRQn, HAL_USART2_DMA_Tx_Handler},
     {BUTTON1_EXTI_IRQn, Mode_Button_EXTI_irq},
     {TIM7_IRQn, TIM7_override},
     {DMA2_Stream2_IRQn, DMA2_Stream2_irq_override},
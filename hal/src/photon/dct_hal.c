@@ -51,6 +51,15 @@ int dct_write_app_data(const void* data, uint32_t offset, uint32_t size) {
     return wiced_dct_write(data, DCT_APP_SECTION, offset, size);
 }
 
+int dct_begin_transaction() {
+    // WICED DCT writes are not batched
+    return 0;
+}
+
+int dct_commit_transaction() {
+    return 0;
+}
+
 wiced_result_t wiced_dct_lock(int write) {
     return (dct_lock(write) == 0) ? WICED_SUCCESS : WICED_ERROR;
 }
@@ -29,6 +29,11 @@
 # endif // SOFTAP_HTTP_MAXIMUM_CONNECTIONS
 
 # define SOFTAP_HTTP_MAXIMUM_URL_LENGTH 255
+
+// Response data is coalesced into chunks of this size rather than sent as one chunk per write
+# ifndef SOFTAP_HTTP_RESPONSE_BUFFER_SIZE
+#  define SOFTAP_HTTP_RESPONSE_BUFFER_SIZE (512)
+# endif // SOFTAP_HTTP_RESPONSE_BUFFER_SIZE
 #endif // SOFTAP_HTTP
 
 extern WLanSecurityType toSecurityType(wiced_security_t sec);
@@ -749,6 +754,38 @@ protected:
     }
 };
 
+/**
+ * Stores the access point credentials and connects to it in a single request,
+ * saving the setup client a round trip.
+ */
+class ConfigureConnectAPCommand : public ConfigureAPCommand {
+    wiced_semaphore_t* signal_complete_;
+    void (*softap_complete_)();
+public:
+    ConfigureConnectAPCommand(wiced_semaphore_t* signal_complete, void (*softap_complete)()) {
+        signal_complete_ = signal_complete;
+        softap_complete_ = softap_complete;
+    }
+
+protected:
+    int process() {
+        int result = ConfigureAPCommand::process();
+        if (!result) {
+            if (signal_complete_!=NULL)
+                wiced_rtos_set_semaphore(signal_complete_);
+            else
+                result = 1;
+        }
+        return result;
+    }
+
+    void produce_response(Writer& writer, int result) {
+        write_result_code(writer, result);
+        if (!result && softap_complete_)
+            softap_complete_();
+    }
+};
+
 class DeviceIDCommand : public JSONCommand {
 
     char device_id[25];
@@ -867,10 +904,12 @@ struct AllSoftAPCommands {
     ScanAPCommand scanAP;
     ConfigureAPCommand configureAP;
     ConnectAPCommand connectAP;
+    ConfigureConnectAPCommand configureConnectAP;
     PublicKeyCommand publicKey;
     SetValueCommand setValue;
     AllSoftAPCommands(wiced_semaphore_t* complete, void (*softap_complete)()) :
-        connectAP(complete, softap_complete) {}
+        connectAP(complete, softap_complete),
+        configureConnectAP(complete, softap_complete) {}
 };
 
 const int MAX_SSID_PREFIX_LEN = 25;
@@ -1134,6 +1173,51 @@ static void http_stream_writer(Writer& w, wiced_http_response_stream_t* stream)
     w.state = stream;
 }
 
+/**
+ * Collects the response data so that it's sent in as few chunks as possible.
+ * Each write to a chunked response stream otherwise produces a separate chunk, and
+ * the commands write their JSON responses a few characters at a time.
+ */
+struct HTTPResponseBuffer {
+    wiced_http_response_stream_t* stream;
+    size_t length;
+    uint8_t data[SOFTAP_HTTP_RESPONSE_BUFFER_SIZE];
+
+    explicit HTTPResponseBuffer(wiced_http_response_stream_t* s)
+        : stream(s),
+          length(0) {
+    }
+
+    void write(const uint8_t* buf, size_t count) {
+        if (length + count > sizeof(data)) {
+            flush();
+            if (count >= sizeof(data)) {
+                wiced_http_response_stream_write(stream, buf, count);
+                return;
+            }
+        }
+        memcpy(data + length, buf, count);
+        length += count;
+    }
+
+    void flush() {
+        if (length) {
+            wiced_http_response_stream_write(stream, data, length);
+            length = 0;
+        }
+    }
+};
+
+static void http_buffered_write(Writer* w, const uint8_t *buf, size_t count) {
+    HTTPResponseBuffer* buffer = (HTTPResponseBuffer*)w->state;
+    buffer->write(buf, count);
+}
+
+static void http_buffered_writer(Writer& w, HTTPResponseBuffer* buffer) {
+    w.callback = http_buffered_write;
+    w.state = buffer;
+}
+
 /**
  * Maps from the status code as an integer to the WICED HTTP server codes.
  */
@@ -1294,6 +1378,12 @@ struct HTTPRequest {
         return w;
     }
 
+    Writer writer(HTTPResponseBuffer* buffer) {
+        Writer w;
+        http_buffered_writer(w, buffer);
+        return w;
+    }
+
     bool empty() const {
         return (url == nullptr && stream == nullptr && buffer == nullptr && length == 0 && total_length == 0);
     }
@@ -1302,7 +1392,7 @@ struct HTTPRequest {
 class HTTPDispatcher {
     wiced_http_server_t server;
 
-    wiced_http_page_t page[10];
+    wiced_http_page_t page[11];
 
     static HTTPRequest* reqs;
 
@@ -1322,8 +1412,9 @@ public:
         setCommand(6, commands.connectAP);
         setCommand(7, commands.publicKey);
         setCommand(8, commands.setValue);
-        page[9].url_content.dynamic_data.generator = handle_app_renderer;
-        page[9].url_content.dynamic_data.arg = (void*)softap_get_application_page_handler();
+        setCommand(9, commands.configureConnectAP);
+        page[10].url_content.dynamic_data.generator = handle_app_renderer;
+        page[10].url_content.dynamic_data.arg = (void*)softap_get_application_page_handler();
     }
 
     void start() {
@@ -1388,11 +1479,13 @@ public:
             wiced_http_response_stream_enable_chunked_transfer(req->stream);
             stream->cross_host_requests_enabled = WICED_TRUE;
 
+            HTTPResponseBuffer buffer(req->stream);
             Reader r = req->reader();
-            Writer w = req->writer();
+            Writer w = req->writer(&buffer);
             if (isCmd) {
                 Command* cmd = (Command*)arg;
-                wiced_http_response_stream_write_header(req->stream, HTTP_200_TYPE, CHUNKED_CONTENT_LENGTH, HTTP_CACHE_DISABLED, MIME_TYPE_JSON, nullptr);
+                // Let the setup client reuse the connection for its next request
+                wiced_http_response_stream_write_header(req->stream, HTTP_200_TYPE, CHUNKED_CONTENT_LENGTH, HTTP_CACHE_DISABLED, MIME_TYPE_JSON, HTTP_HEADER_KEEP_ALIVE CRLF);
                 result = cmd->execute(r, w);
             } else {
                 PageProvider* p = (PageProvider*)arg;
@@ -1412,9 +1505,12 @@ public:
                     }
                 }
             }
+            buffer.flush();
             // We need to deactivate chunked transfer mode here
             // in order to signal to client that there'll be no more data: "0\r\n\r\n"
             wiced_http_response_stream_disable_chunked_transfer(req->stream);
+            // Send the response right away instead of waiting for the connection to close
+            wiced_http_response_stream_flush(req->stream);
             req->reset();
         }
         return result;
@@ -1465,6 +1561,8 @@ class SimpleProtocolDispatcher
                 cmd = &commands_.configureAP;
             else if (!strcmp("connect-ap", name))
                 cmd = &commands_.connectAP;
+            else if (!strcmp("configure-connect-ap", name))
+                cmd = &commands_.configureConnectAP;
             else if (!strcmp("public-key", name))
                 cmd = &commands_.publicKey;
             else if (!strcmp("set", name))
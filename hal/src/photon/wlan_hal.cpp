@@ -944,8 +944,10 @@ struct SnifferInfo
     int16_t rssi;
     wiced_semaphore_t complete;
     wlan_scan_result_t callback;
+    wlan_scan_stream_callback_t stream_callback;
     void* callback_data;
     int count;
+    bool stopped;
 };
 
 WLanSecurityType toSecurityType(wiced_security_t sec)
@@ -987,9 +989,9 @@ wiced_result_t sniffer( wiced_scan_handler_result_t* malloced_scan_result )
         if ( malloced_scan_result->status == WICED_SCAN_INCOMPLETE )
         {
             wiced_scan_result_t* record = &malloced_scan_result->ap_details;
-            info->count++;
-            if (!info->callback)
+            if (!info->callback && !info->stream_callback)
             {
+                info->count++;
                 if (record->SSID.length == info->ssid_len &&
                     !memcmp(record->SSID.value, info->ssid, info->ssid_len))
                 {
@@ -997,8 +999,9 @@ wiced_result_t sniffer( wiced_scan_handler_result_t* malloced_scan_result )
                     info->rssi = record->signal_strength;
                 }
             }
-            else
+            else if (!info->stopped)
             {
+                info->count++;
                 WiFiAccessPoint data;
                 memcpy(data.ssid, record->SSID.value, record->SSID.length);
                 memcpy(data.bssid, (uint8_t*)&record->BSSID, 6);
@@ -1009,7 +1012,15 @@ wiced_result_t sniffer( wiced_scan_handler_result_t* malloced_scan_result )
                 data.rssi = record->signal_strength;
                 data.channel = record->channel;
                 data.maxDataRate = record->max_data_rate;
-                info->callback(&data, info->callback_data);
+                if (info->callback)
+                {
+                    info->callback(&data, info->callback_data);
+                }
+                else if (info->stream_callback(&data, info->callback_data) != 0)
+                {
+                    // The scan can't be aborted, ignore the remaining results
+                    info->stopped = true;
+                }
             }
         }
         else
@@ -1568,6 +1579,16 @@ int wlan_scan(wlan_scan_result_t callback, void* cookie)
     return result < 0 ? result : info.count;
 }
 
+int wlan_scan_stream(wlan_scan_stream_callback_t callback, void* cookie, void* reserved)
+{
+    SnifferInfo info;
+    memset(&info, 0, sizeof(info));
+    info.stream_callback = callback;
+    info.callback_data = cookie;
+    int result = sniff_security(&info);
+    return result < 0 ? result : info.count;
+}
+
 /**
  * Lists all WLAN credentials currently stored on the device
  */
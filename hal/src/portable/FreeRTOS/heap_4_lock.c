@@ -140,6 +140,8 @@ static void prvHeapInit( void );
 
 size_t xPortGetHeapSize ( void );
 size_t xPortGetBlockSize ( void* ptr );
+void vPortSetBlockOwner ( void* ptr, int owner );
+int xPortGetBlockOwner ( void* ptr );
 
 /*-----------------------------------------------------------*/
 
@@ -161,6 +163,10 @@ application.  When the bit is free the block is still part of the free heap
 space. */
 static size_t xBlockAllocatedBit = 0;
 
+/* Gets set to the second top bit of an size_t type. This bit of the xBlockSize
+member of an allocated block stores the owner flag set with vPortSetBlockOwner(). */
+static size_t xBlockOwnerBit = 0;
+
 /*-----------------------------------------------------------*/
 
 #ifdef MODULAR_FIRMWARE
@@ -233,6 +239,38 @@ size_t pvPortLargestFreeBlock()
     return largest;
 }
 
+size_t xPortGetFreeBlockCount()
+{
+	size_t count = 0;
+	BlockLink_t *pxBlock;
+
+	if ( malloc_enabled == 0 )
+    {
+        return count;
+    }
+
+    __malloc_lock(NULL);
+    {
+        if( pxEnd == NULL )
+        {
+            prvHeapInit();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+		pxBlock = xStart.pxNextFreeBlock;
+		while( ( pxBlock->pxNextFreeBlock != NULL ) )
+		{
+			++count;
+			pxBlock = pxBlock->pxNextFreeBlock;
+		}
+    }
+    __malloc_unlock(NULL);
+    return count;
+}
+
 void *pvPortMalloc( size_t xWantedSize )
 {
 BlockLink_t *pxBlock, *pxPreviousBlock, *pxNewBlockLink;
@@ -260,7 +298,7 @@ void *pvReturn = NULL;
         set.  The top bit of the block size member of the BlockLink_t structure
         is used to determine who owns the block - the application or the
         kernel, so it must be free. */
-        if( ( xWantedSize & xBlockAllocatedBit ) == 0 )
+        if( ( xWantedSize & ( xBlockAllocatedBit | xBlockOwnerBit ) ) == 0 )
         {
             /* The wanted size is increased so it can contain a BlockLink_t
             structure in addition to the requested amount of bytes. */
@@ -414,7 +452,7 @@ BlockLink_t *pxLink;
             {
                 /* The block is being returned to the heap - it is no longer
                 allocated. */
-                pxLink->xBlockSize &= ~xBlockAllocatedBit;
+                pxLink->xBlockSize &= ~( xBlockAllocatedBit | xBlockOwnerBit );
 
                 __malloc_lock(NULL);
                 {
@@ -501,6 +539,7 @@ size_t xTotalHeapSize = xPortGetHeapSize();
 
     /* Work out the position of the top bit in a size_t variable. */
     xBlockAllocatedBit = ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * heapBITS_PER_BYTE ) - 1 );
+    xBlockOwnerBit = xBlockAllocatedBit >> 1;
 }
 /*-----------------------------------------------------------*/
 
@@ -579,5 +618,30 @@ size_t xPortGetBlockSize ( void* ptr )
     configASSERT( ((ptr > ucHeap) && (ptr < ucHeapEnd)) );
 
     BlockLink_t* b = (BlockLink_t*) (((uint8_t*)ptr) - xHeapStructSize);
-    return b->xBlockSize;
+    /* Usable size of the block, excluding the BlockLink_t structure */
+    return ( b->xBlockSize & ~( xBlockAllocatedBit | xBlockOwnerBit ) ) - xHeapStructSize;
+}
+
+void vPortSetBlockOwner ( void* ptr, int owner )
+{
+    configASSERT( ((ptr > ucHeap) && (ptr < ucHeapEnd)) );
+
+    BlockLink_t* b = (BlockLink_t*) (((uint8_t*)ptr) - xHeapStructSize);
+    configASSERT( ( b->xBlockSize & xBlockAllocatedBit ) != 0 );
+    if ( owner )
+    {
+        b->xBlockSize |= xBlockOwnerBit;
+    }
+    else
+    {
+        b->xBlockSize &= ~xBlockOwnerBit;
+    }
+}
+
+int xPortGetBlockOwner ( void* ptr )
+{
+    configASSERT( ((ptr > ucHeap) && (ptr < ucHeapEnd)) );
+
+    BlockLink_t* b = (BlockLink_t*) (((uint8_t*)ptr) - xHeapStructSize);
+    return ( b->xBlockSize & xBlockOwnerBit ) != 0;
 }
@@ -28,24 +28,119 @@
 
 #include "eeprom_hal.h"
 #include "eeprom_emulation_impl.h"
+#include "static_recursive_mutex.h"
+#include "interrupts_hal.h"
+#include "timer_hal.h"
+#include "system_error.h"
+#include "stm32f2xx.h"
 
 FlashEEPROM flashEEPROM;
 
+namespace {
+
+StaticRecursiveMutex eepromMutex;
+
+// Number of nested EEPROM locks. The brownout interrupt handler can only
+// access the EEPROM when it's not locked
+volatile unsigned eepromLockCount = 0;
+volatile bool powerFailure = false;
+
+uint32_t flushDelay = 0;
+system_tick_t dirtyTime = 0;
+
+class EepromLock {
+public:
+    EepromLock() {
+        eepromMutex.lock();
+        ++eepromLockCount;
+    }
+
+    ~EepromLock() {
+        for (;;) {
+            // The supply voltage dropped while the EEPROM was locked: write
+            // the pending changes before releasing the lock
+            const int state = HAL_disable_irq();
+            if (!powerFailure || !flashEEPROM.hasPendingWrite()) {
+                --eepromLockCount;
+                HAL_enable_irq(state);
+                break;
+            }
+            HAL_enable_irq(state);
+            flashEEPROM.flush();
+        }
+        eepromMutex.unlock();
+    }
+};
+
+// Configures the programmable voltage detector to generate an interrupt
+// when the supply voltage drops below 2.9V
+void initPowerFailureDetection() {
+    static bool initialized = false;
+    if (initialized) {
+        return;
+    }
+    initialized = true;
+
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_PWR, ENABLE);
+    PWR_PVDLevelConfig(PWR_PVDLevel_7);
+    PWR_PVDCmd(ENABLE);
+
+    // PVD output is connected to EXTI line 16 and goes high when the
+    // voltage drops below the threshold
+    EXTI_InitTypeDef EXTI_InitStructure = {};
+    EXTI_InitStructure.EXTI_Line = EXTI_Line16;
+    EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
+    EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Rising;
+    EXTI_InitStructure.EXTI_LineCmd = ENABLE;
+    EXTI_Init(&EXTI_InitStructure);
+
+    NVIC_InitTypeDef NVIC_InitStructure = {};
+    NVIC_InitStructure.NVIC_IRQChannel = PVD_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 7;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+}
+
+} // namespace
+
+// Photon and P1 use WICED's vector table which has a different name for
+// this handler
+extern "C" void PVD_irq(void)
+{
+    if (EXTI_GetITStatus(EXTI_Line16) != RESET) {
+        EXTI_ClearITPendingBit(EXTI_Line16);
+        powerFailure = true;
+        // Best effort: if the EEPROM is locked, the pending changes are
+        // written when the lock is released, see EepromLock
+        if (!eepromLockCount) {
+            flashEEPROM.flush();
+        }
+    }
+}
+
+extern "C" void PVD_IRQHandler(void)
+{
+    PVD_irq();
+}
+
 void HAL_EEPROM_Init(void)
 {
+  EepromLock lk;
   flashEEPROM.init();
 }
 
 uint8_t HAL_EEPROM_Read(uint32_t index)
 {
   uint8_t value = 0xFF;
+  EepromLock lk;
   flashEEPROM.get(index, value);
   return value;
 }
 
 void HAL_EEPROM_Write(uint32_t index, uint8_t data)
 {
-  flashEEPROM.put(index, data);
+  HAL_EEPROM_Put(index, &data, sizeof(data));
 }
 
 size_t HAL_EEPROM_Length()
@@ -55,25 +150,64 @@ size_t HAL_EEPROM_Length()
 
 void HAL_EEPROM_Get(uint32_t index, void *data, size_t length)
 {
+    EepromLock lk;
     flashEEPROM.get(index, data, length);
 }
 
 void HAL_EEPROM_Put(uint32_t index, const void *data, size_t length)
 {
+    EepromLock lk;
+    const bool pending = flashEEPROM.hasPendingWrite();
     flashEEPROM.put(index, data, length);
+    if (!pending && flashEEPROM.hasPendingWrite()) {
+        dirtyTime = HAL_Timer_Get_Milli_Seconds();
+    }
 }
 
 void HAL_EEPROM_Clear()
 {
+    EepromLock lk;
     flashEEPROM.clear();
 }
 
 bool HAL_EEPROM_Has_Pending_Erase()
 {
+    EepromLock lk;
     return flashEEPROM.hasPendingErase();
 }
 
 void HAL_EEPROM_Perform_Pending_Erase()
 {
+    EepromLock lk;
     flashEEPROM.performPendingErase();
 }
+
+int HAL_EEPROM_Set_Write_Back(uint32_t flush_delay, void* reserved)
+{
+    EepromLock lk;
+    if (!flashEEPROM.setWriteBack(flush_delay != 0)) {
+        return (flush_delay != 0) ? SYSTEM_ERROR_NO_MEMORY : SYSTEM_ERROR_IO;
+    }
+    flushDelay = flush_delay;
+    if (flushDelay) {
+        initPowerFailureDetection();
+    }
+    return 0;
+}
+
+int HAL_EEPROM_Flush(void* reserved)
+{
+    EepromLock lk;
+    return flashEEPROM.flush() ? 0 : SYSTEM_ERROR_IO;
+}
+
+void HAL_EEPROM_Process(void* reserved)
+{
+    if (!flushDelay || !flashEEPROM.hasPendingWrite()) {
+        return;
+    }
+    EepromLock lk;
+    if (flashEEPROM.hasPendingWrite() && HAL_Timer_Get_Milli_Seconds() - dirtyTime >= flushDelay) {
+        flashEEPROM.flush();
+    }
+}
@@ -29,6 +29,8 @@
 #include "gpio_hal.h"
 #include "stm32f2xx.h"
 #include "fixed_queue.h"
+#include "system_error.h"
+#include "spark_wiring_diagnostics.h"
 
 #include <cstring>
 
@@ -68,6 +70,8 @@ public:
         : hw(hw),
           enabled(false),
           nextFilter(hw.can_first_filter),
+          rxQueueOverflows(0),
+          rxFifoOverruns(0),
           rxQueue(rxQueueSize),
           txQueue(txQueueSize)
     {
@@ -82,28 +86,38 @@ public:
     uint8_t rxQueueSize();
 
     bool addFilter(uint32_t id, uint32_t mask, HAL_CAN_Filters type);
+    bool addFilter(const HAL_CAN_Filter &filter);
     void clearFilters();
 
+    void getStats(HAL_CAN_Stats &stats);
+
     bool isEnabled();
 
     HAL_CAN_Errors errorStatus();
 
     void txInterruptHandler();
     void rx0InterruptHandler();
+    void rx1InterruptHandler();
 
 protected:
     CanTxMsg messageHALtoSTM(const CANMessage &in);
     CANMessage messageSTMtoHAL(const CanRxMsg &in);
 
-    uint8_t pendingRxMessages();
+    uint8_t pendingRxMessages(uint8_t fifo);
     bool transmit(const CANMessage &message);
-    bool receive(CANMessage &message);
+    bool receive(uint8_t fifo, CANMessage &message);
+    void drainRxFifo(uint8_t fifo, uint32_t overrunFlag);
+    void initFilterBank(uint8_t bank, uint8_t mode, uint32_t id, uint32_t mask, uint8_t fifo);
+    void disableFilterBank(uint8_t bank);
 
 protected:
     const STM32_CAN_Info &hw;
     bool enabled;
     uint8_t nextFilter;
 
+    volatile uint32_t rxQueueOverflows;
+    volatile uint32_t rxFifoOverruns;
+
     FixedQueue<CANMessage> rxQueue;
     FixedQueue<CANMessage> txQueue;
 };
@@ -138,6 +152,10 @@ static const STM32_CAN_Info CAN_MAP[TOTAL_CAN] = {
 
 static CANDriver *drivers[TOTAL_CAN] = {};
 
+// Totals for all channels
+static particle::CounterDiagnosticData g_rxQueueOverflows(DIAG_ID_CAN_RX_QUEUE_OVERFLOWS, DIAG_NAME_CAN_RX_QUEUE_OVERFLOWS);
+static particle::CounterDiagnosticData g_rxFifoOverruns(DIAG_ID_CAN_RX_FIFO_OVERRUNS, DIAG_NAME_CAN_RX_FIFO_OVERRUNS);
+
 /* Extern variables ----------------------------------------------------------*/
 
 /* Private function prototypes -----------------------------------------------*/
@@ -351,6 +369,53 @@ HAL_CAN_Errors HAL_CAN_Error_Status(HAL_CAN_Channel channel)
     return drivers[channel]->errorStatus();
 }
 
+/*******************************************************************************
+   Name:           HAL_CAN_Add_Filter_Ext
+   Description:    Add a mask or list filter for received CAN messages
+
+   Parameters:
+       @param channel CAN Channel (CAN1, CAN2, etc)
+       @param filter Filter configuration
+       @return true if filter added, false if too many filters already
+
+*******************************************************************************/
+bool HAL_CAN_Add_Filter_Ext(HAL_CAN_Channel channel,
+                            const struct HAL_CAN_Filter *filter,
+                            void *reserved)
+{
+    if(!drivers[channel] || !filter)
+    {
+        return false;
+    }
+    return drivers[channel]->addFilter(*filter);
+}
+
+/*******************************************************************************
+   Name:           HAL_CAN_Get_Stats
+   Description:    Get the receive overflow counters
+
+   Parameters:
+       @param channel CAN Channel (CAN1, CAN2, etc)
+       @param stats Where the counters will be written
+       @return 0 on success, or a negative result code
+
+*******************************************************************************/
+int HAL_CAN_Get_Stats(HAL_CAN_Channel channel,
+                      struct HAL_CAN_Stats *stats,
+                      void *reserved)
+{
+    if(!stats)
+    {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    if(!drivers[channel])
+    {
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
+    drivers[channel]->getStats(*stats);
+    return SYSTEM_ERROR_NONE;
+}
+
 /*******************************************************************************
  * Global interrupt handlers
  *******************************************************************************/
@@ -390,6 +455,22 @@ void HAL_CAN2_RX0_Handler(void)
     drivers[CAN_D1_D2]->rx0InterruptHandler();
 }
 
+/*******************************************************************************
+* Function Name  : HAL_CAN2_RX1_Handler
+* Description    : This function handles CAN2 Rx1 global interrupt request.
+* Input          : None.
+* Output         : None.
+* Return         : None.
+*******************************************************************************/
+void HAL_CAN2_RX1_Handler(void)
+{
+    if(!drivers[CAN_D1_D2])
+    {
+        return;
+    }
+    drivers[CAN_D1_D2]->rx1InterruptHandler();
+}
+
 #endif
 
 #ifdef HAL_HAS_CAN_C4_C5
@@ -427,6 +508,22 @@ void HAL_CAN1_RX0_Handler(void)
     drivers[CAN_C4_C5]->rx0InterruptHandler();
 }
 
+/*******************************************************************************
+* Function Name  : HAL_CAN1_RX1_Handler
+* Description    : This function handles CAN1 Rx1 global interrupt request.
+* Input          : None.
+* Output         : None.
+* Return         : None.
+*******************************************************************************/
+void HAL_CAN1_RX1_Handler(void)
+{
+    if(!drivers[CAN_C4_C5])
+    {
+        return;
+    }
+    drivers[CAN_C4_C5]->rx1InterruptHandler();
+}
+
 #endif
 
 #ifdef __cplusplus
@@ -437,20 +534,24 @@ void HAL_CAN1_RX0_Handler(void)
  * Implementation of the CAN driver
  *******************************************************************************/
 
+// Interrupts of both receive FIFOs
+#define CAN_IT_RX (CAN_IT_FMP0 | CAN_IT_FOV0 | CAN_IT_FMP1 | CAN_IT_FOV1)
+
 // RAII helpers to disable CAN interrupts
-template <uint32_t Flag>
+template <uint32_t Flags>
 class DisableCANInterrupts
 {
 public:
     DisableCANInterrupts(CAN_TypeDef *peripheral)
         : peripheral(peripheral)
     {
-        CAN_ITConfig(peripheral, Flag, DISABLE);
+        // CAN_ITConfig() only accepts a single interrupt
+        peripheral->IER &= ~Flags;
     }
 
     ~DisableCANInterrupts()
     {
-        CAN_ITConfig(peripheral, Flag, ENABLE);
+        peripheral->IER |= Flags;
     }
 
 private:
@@ -458,7 +559,7 @@ private:
 };
 
 typedef DisableCANInterrupts<CAN_IT_TME> DisableTxInterrupts;
-typedef DisableCANInterrupts<CAN_IT_FMP0> DisableRxInterrupts;
+typedef DisableCANInterrupts<CAN_IT_RX> DisableRxInterrupts;
 
 void CANDriver::begin(uint32_t baud,
         uint32_t flags)
@@ -531,11 +632,19 @@ void CANDriver::begin(uint32_t baud,
     NVIC_InitStructure.NVIC_IRQChannelCmd                = ENABLE;
     NVIC_Init(&NVIC_InitStructure);
 
+    // Enable the CAN Rx FIFO 1 Interrupt
+    NVIC_InitStructure.NVIC_IRQChannel                   = hw.can_rx1_irqn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 7;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority        = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd                = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+
     // Enable CAN Receive and Transmit interrupts
     CAN_ClearITPendingBit(hw.can_peripheral, CAN_IT_TME);
     CAN_ITConfig(hw.can_peripheral, CAN_IT_TME, ENABLE);
-    CAN_ClearITPendingBit(hw.can_peripheral, CAN_IT_FMP0);
-    CAN_ITConfig(hw.can_peripheral, CAN_IT_FMP0, ENABLE);
+    CAN_ClearITPendingBit(hw.can_peripheral, CAN_IT_FOV0);
+    CAN_ClearITPendingBit(hw.can_peripheral, CAN_IT_FOV1);
+    hw.can_peripheral->IER |= CAN_IT_RX;
 }
 
 void CANDriver::end() {
@@ -546,7 +655,7 @@ void CANDriver::end() {
 
     // Disable CAN Receive and Transmit interrupts
     CAN_ITConfig(hw.can_peripheral, CAN_IT_TME, DISABLE);
-    CAN_ITConfig(hw.can_peripheral, CAN_IT_FMP0, DISABLE);
+    hw.can_peripheral->IER &= ~CAN_IT_RX;
 
     NVIC_InitTypeDef   NVIC_InitStructure;
 
@@ -560,6 +669,11 @@ void CANDriver::end() {
     NVIC_InitStructure.NVIC_IRQChannelCmd = DISABLE;
     NVIC_Init(&NVIC_InitStructure);
 
+    //Disable the CAN Rx FIFO 1 Interrupt
+    NVIC_InitStructure.NVIC_IRQChannel    = hw.can_rx1_irqn;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = DISABLE;
+    NVIC_Init(&NVIC_InitStructure);
+
     // Disable CAN Clock and CAN1 Clock
     RCC->APB1ENR &= ~(hw.can_clock_en | RCC_APB1Periph_CAN1);
 
@@ -696,37 +810,39 @@ bool CANDriver::transmit(const CANMessage &message)
 
 /*******************************************************************************
    Name:           CANDriver::receive
-   Description:    Get a CAN message from the receive FIFO
+   Description:    Get a CAN message from a receive FIFO
 
    Parameters:
+       @param fifo Receive FIFO (CAN_FIFO0 or CAN_FIFO1)
        @param message Where the CAN message will be written
        @return true if message received, false if no message are pending
 
 *******************************************************************************/
-bool CANDriver::receive(CANMessage &message)
+bool CANDriver::receive(uint8_t fifo, CANMessage &message)
 {
-    if(pendingRxMessages() == 0)
+    if(pendingRxMessages(fifo) == 0)
     {
         return false;
     }
 
     CanRxMsg stm_message;
-    CAN_Receive(hw.can_peripheral, CAN_FIFO0, &stm_message);
+    CAN_Receive(hw.can_peripheral, fifo, &stm_message);
     message = messageSTMtoHAL(stm_message);
     return true;
 }
 
 /*******************************************************************************
    Name:           CANDriver::pendingRxMessages
-   Description:    returns the number of messages available in the RX FIFO
+   Description:    returns the number of messages available in a RX FIFO
 
    Parameters:
+       @param fifo Receive FIFO (CAN_FIFO0 or CAN_FIFO1)
        @return number of pending messages
 
 *******************************************************************************/
-uint8_t CANDriver::pendingRxMessages()
+uint8_t CANDriver::pendingRxMessages(uint8_t fifo)
 {
-    return CAN_MessagePending(hw.can_peripheral, CAN_FIFO0);
+    return CAN_MessagePending(hw.can_peripheral, fifo);
 }
 
 /*******************************************************************************
@@ -754,6 +870,28 @@ uint8_t CANDriver::rxQueueSize()
 
 *******************************************************************************/
 bool CANDriver::addFilter(uint32_t id, uint32_t mask, HAL_CAN_Filters type)
+{
+    HAL_CAN_Filter filter = {};
+    filter.size = sizeof(filter);
+    filter.type = type;
+    filter.mode = CAN_FILTER_MODE_MASK;
+    filter.id = id;
+    filter.mask = mask;
+    return addFilter(filter);
+}
+
+/*******************************************************************************
+   Name:           CANDriver::addFilter
+   Description:    Add a mask or list filter for received CAN messages
+                   Filter banks alternate between the two receive FIFOs so
+                   that the hardware can hold up to 6 messages
+
+   Parameters:
+       @param filter Filter configuration
+       @return true if filter added, false if too many filters already
+
+*******************************************************************************/
+bool CANDriver::addFilter(const HAL_CAN_Filter &filter)
 {
     if(nextFilter > hw.can_last_filter)
     {
@@ -766,31 +904,87 @@ bool CANDriver::addFilter(uint32_t id, uint32_t mask, HAL_CAN_Filters type)
     const uint32_t extendedBit = 0x4;
     const uint32_t rtrBit = 0x2;
 
-    if(type == CAN_FILTER_STANDARD)
+    if(filter.type == CAN_FILTER_STANDARD)
     {
-        filterId = id << 21;
-        filterMask = (mask << 21) | extendedBit | rtrBit;
+        filterId = filter.id << 21;
+        if(filter.mode == CAN_FILTER_MODE_LIST)
+        {
+            // The mask register holds the second ID in the list mode
+            filterMask = filter.id2 << 21;
+        }
+        else
+        {
+            filterMask = (filter.mask << 21) | extendedBit | rtrBit;
+        }
     }
     else
     {
-        filterId = (id << 3) | extendedBit;
-        filterMask = (mask << 3) | extendedBit | rtrBit;
+        filterId = (filter.id << 3) | extendedBit;
+        if(filter.mode == CAN_FILTER_MODE_LIST)
+        {
+            filterMask = (filter.id2 << 3) | extendedBit;
+        }
+        else
+        {
+            filterMask = (filter.mask << 3) | extendedBit | rtrBit;
+        }
+    }
+
+    if(nextFilter == hw.can_first_filter)
+    {
+        // Remove the second bank of the accept-all configuration
+        disableFilterBank(hw.can_first_filter + 1);
     }
 
+    const uint8_t fifo = ((nextFilter - hw.can_first_filter) % 2) ? CAN_FilterFIFO1 : CAN_FilterFIFO0;
+    const uint8_t mode = (filter.mode == CAN_FILTER_MODE_LIST) ? CAN_FilterMode_IdList : CAN_FilterMode_IdMask;
+    initFilterBank(nextFilter, mode, filterId, filterMask, fifo);
+    nextFilter++;
+
+    return true;
+}
+
+/*******************************************************************************
+   Name:           CANDriver::initFilterBank
+   Description:    Configure and activate a 32-bit filter bank
+
+   Parameters:
+       @param bank Filter bank number
+       @param mode CAN_FilterMode_IdMask or CAN_FilterMode_IdList
+       @param id Value of the first filter register
+       @param mask Value of the second filter register
+       @param fifo Receive FIFO for the matching messages
+
+*******************************************************************************/
+void CANDriver::initFilterBank(uint8_t bank, uint8_t mode, uint32_t id, uint32_t mask, uint8_t fifo)
+{
     CAN_FilterInitTypeDef   CAN_FilterInitStructure = {};
-    CAN_FilterInitStructure.CAN_FilterNumber         = nextFilter;
-    CAN_FilterInitStructure.CAN_FilterMode           = CAN_FilterMode_IdMask;
+    CAN_FilterInitStructure.CAN_FilterNumber         = bank;
+    CAN_FilterInitStructure.CAN_FilterMode           = mode;
     CAN_FilterInitStructure.CAN_FilterScale          = CAN_FilterScale_32bit;
-    CAN_FilterInitStructure.CAN_FilterIdHigh         = filterId >> 16;
-    CAN_FilterInitStructure.CAN_FilterIdLow          = filterId & 0xFFFF;
-    CAN_FilterInitStructure.CAN_FilterMaskIdHigh     = filterMask >> 16;
-    CAN_FilterInitStructure.CAN_FilterMaskIdLow      = filterMask & 0xFFFF;
-    CAN_FilterInitStructure.CAN_FilterFIFOAssignment = CAN_FilterFIFO0;
+    CAN_FilterInitStructure.CAN_FilterIdHigh         = id >> 16;
+    CAN_FilterInitStructure.CAN_FilterIdLow          = id & 0xFFFF;
+    CAN_FilterInitStructure.CAN_FilterMaskIdHigh     = mask >> 16;
+    CAN_FilterInitStructure.CAN_FilterMaskIdLow      = mask & 0xFFFF;
+    CAN_FilterInitStructure.CAN_FilterFIFOAssignment = fifo;
     CAN_FilterInitStructure.CAN_FilterActivation     = ENABLE;
     CAN_FilterInit(&CAN_FilterInitStructure);
-    nextFilter++;
+}
 
-    return true;
+/*******************************************************************************
+   Name:           CANDriver::disableFilterBank
+   Description:    Deactivate a filter bank
+
+   Parameters:
+       @param bank Filter bank number
+
+*******************************************************************************/
+void CANDriver::disableFilterBank(uint8_t bank)
+{
+    // Filters are shared for CAN1 and CAN2 and configured on CAN1
+    CAN1->FMR |= FMR_FINIT;
+    CAN1->FA1R &= ~(1ul << bank);
+    CAN1->FMR &= ~FMR_FINIT;
 }
 
 /*******************************************************************************
@@ -815,18 +1009,25 @@ void CANDriver::clearFilters()
     }
     CAN1->FA1R &= ~mask;
 
-    // Allow all messages through
-    CAN_FilterInitTypeDef   CAN_FilterInitStructure = {};
-    CAN_FilterInitStructure.CAN_FilterNumber         = hw.can_first_filter;
-    CAN_FilterInitStructure.CAN_FilterMode           = CAN_FilterMode_IdMask;
-    CAN_FilterInitStructure.CAN_FilterScale          = CAN_FilterScale_32bit;
-    CAN_FilterInitStructure.CAN_FilterIdHigh         = 0x0000;
-    CAN_FilterInitStructure.CAN_FilterIdLow          = 0x0000;
-    CAN_FilterInitStructure.CAN_FilterMaskIdHigh     = 0x0000;
-    CAN_FilterInitStructure.CAN_FilterMaskIdLow      = 0x0000;
-    CAN_FilterInitStructure.CAN_FilterFIFOAssignment = CAN_FilterFIFO0;
-    CAN_FilterInitStructure.CAN_FilterActivation     = ENABLE;
-    CAN_FilterInit(&CAN_FilterInitStructure);
+    // Allow all messages through: standard IDs go to FIFO 0 and extended IDs
+    // to FIFO 1, so that both FIFOs are used
+    const uint32_t extendedBit = 0x4;
+    initFilterBank(hw.can_first_filter, CAN_FilterMode_IdMask, 0, extendedBit, CAN_FilterFIFO0);
+    initFilterBank(hw.can_first_filter + 1, CAN_FilterMode_IdMask, extendedBit, extendedBit, CAN_FilterFIFO1);
+}
+
+/*******************************************************************************
+   Name:           CANDriver::getStats
+   Description:    Get the receive overflow counters
+
+   Parameters:
+       @param stats Where the counters will be written
+
+*******************************************************************************/
+void CANDriver::getStats(HAL_CAN_Stats &stats)
+{
+    stats.rx_queue_overflows = rxQueueOverflows;
+    stats.rx_fifo_overruns = rxFifoOverruns;
 }
 
 
@@ -911,10 +1112,54 @@ void CANDriver::rx0InterruptHandler()
         return;
     }
 
-    // No need to clear CAN_IT_FMP0 flag since it can only be cleared by hardware
+    drainRxFifo(CAN_FIFO0, CAN_IT_FOV0);
+}
+
+/*******************************************************************************
+   Name:           CANDriver::rx1InterruptHandler
+   Description:    CAN FIFO1 RX interrupt
+                   Enqueues received messages
+
+   Parameters: None
+
+*******************************************************************************/
+void CANDriver::rx1InterruptHandler()
+{
+    if(!isEnabled())
+    {
+        return;
+    }
+
+    drainRxFifo(CAN_FIFO1, CAN_IT_FOV1);
+}
+
+/*******************************************************************************
+   Name:           CANDriver::drainRxFifo
+   Description:    Moves all pending messages of a receive FIFO to the queue
+
+   Parameters:
+       @param fifo Receive FIFO (CAN_FIFO0 or CAN_FIFO1)
+       @param overrunFlag Overrun interrupt of the FIFO
+
+*******************************************************************************/
+void CANDriver::drainRxFifo(uint8_t fifo, uint32_t overrunFlag)
+{
+    if(CAN_GetITStatus(hw.can_peripheral, overrunFlag) == SET)
+    {
+        CAN_ClearITPendingBit(hw.can_peripheral, overrunFlag);
+        ++rxFifoOverruns;
+        ++g_rxFifoOverruns;
+    }
+
+    // No need to clear CAN_IT_FMPx flag since it can only be cleared by hardware
 
     CANMessage message;
-    if(receive(message)) {
-        rxQueue.push(message);
+    while(receive(fifo, message))
+    {
+        if(!rxQueue.push(message))
+        {
+            ++rxQueueOverflows;
+            ++g_rxQueueOverflows;
+        }
     }
 }
@@ -43,6 +43,7 @@
 #include "atomic_flag_mutex.h"
 #include "static_recursive_mutex.h"
 #include "service_debug.h"
+#include "system_error.h"
 
 #if PLATFORM_ID == 6 || PLATFORM_ID == 8
 # include "wwd_rtos_interface.h"
@@ -197,6 +198,17 @@ os_result_t os_thread_delay_until(system_tick_t *previousWakeTime, system_tick_t
     return 0;
 }
 
+int os_thread_get_stats(os_thread_stats_t* stats, size_t count, uint32_t* total_time, void* reserved)
+{
+    // Runtime statistics are not enabled in the FreeRTOS configuration of this platform
+    return SYSTEM_ERROR_NOT_SUPPORTED;
+}
+
+int os_scheduler_get_stats(os_scheduler_stats_t* stats, bool reset, void* reserved)
+{
+    return SYSTEM_ERROR_NOT_SUPPORTED;
+}
+
 class ThreadQueue
 {
     QueueHandle_t queue;
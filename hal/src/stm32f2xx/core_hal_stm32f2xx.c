@@ -60,6 +60,7 @@
 #if PLATFORM_ID==PLATFORM_P1
 #include "wwd_management.h"
 #include "wlan_hal.h"
+#include "boot_timeline.h"
 #endif
 
 extern char link_heap_location, link_heap_location_end;
@@ -363,6 +364,8 @@ void HAL_Core_Config(void)
 
     HAL_Core_Config_systick_configuration();
 
+    boot_timeline_mark(BOOT_STAGE_START, NULL);
+
     HAL_RTC_Configuration();
 
     HAL_RNG_Configuration();
@@ -388,6 +391,8 @@ void HAL_Core_Config(void)
                                       FLASH_INTERNAL, USER_FIRMWARE_IMAGE_LOCATION, FIRMWARE_IMAGE_SIZE,
                                       FACTORY_RESET_MODULE_FUNCTION, MODULE_VERIFY_CRC|MODULE_VERIFY_FUNCTION|MODULE_VERIFY_DESTINATION_IS_START_ADDRESS); //true to verify the CRC during copy also
 #endif
+
+    boot_timeline_mark(BOOT_STAGE_HAL_CONFIG, NULL);
 }
 
 #if !defined(MODULAR_FIRMWARE) || !MODULAR_FIRMWARE
@@ -1124,6 +1129,8 @@ unsigned HAL_Core_System_Clock(HAL_SystemClock clock, void* reserved)
 }
 
 extern size_t pvPortLargestFreeBlock();
+extern size_t xPortGetFreeBlockCount();
+extern size_t malloc_user_heap_used();
 
 uint32_t HAL_Core_Runtime_Info(runtime_info_t* info, void* reserved)
 {
@@ -1150,6 +1157,14 @@ uint32_t HAL_Core_Runtime_Info(runtime_info_t* info, void* reserved)
     		info->largest_free_block_heap = pvPortLargestFreeBlock();
     }
 
+    if (offsetof(runtime_info_t, free_blocks_heap) + sizeof(info->free_blocks_heap) <= info->size) {
+        info->free_blocks_heap = xPortGetFreeBlockCount();
+    }
+
+    if (offsetof(runtime_info_t, user_heap) + sizeof(info->user_heap) <= info->size) {
+        info->user_heap = malloc_user_heap_used();
+    }
+
     return 0;
 }
 
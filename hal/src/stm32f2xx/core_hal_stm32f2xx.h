@@ -64,6 +64,11 @@ void HAL_USART2_Handler(void);
 void HAL_USART3_Handler(void);
 void HAL_USART4_Handler(void);
 void HAL_USART5_Handler(void);
+void HAL_USART1_DMA_Tx_Handler(void);
+void HAL_USART2_DMA_Rx_Handler(void);
+void HAL_USART2_DMA_Tx_Handler(void);
+void HAL_USART4_DMA_Tx_Handler(void);
+void HAL_USART5_DMA_Rx_Handler(void);
 void ADC_irq();
 void CAN1_TX_irq(void);
 void CAN1_RX0_irq(void);
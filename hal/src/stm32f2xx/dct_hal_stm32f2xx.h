@@ -8,6 +8,16 @@ extern "C" {
 int dct_lock(int write);
 int dct_unlock(int write);
 
+/**
+ * Starts a DCT transaction. Where supported by the platform, data written with dct_write_app_data()
+ * until the transaction is committed is written to flash with a single update. Transactions can be nested.
+ */
+int dct_begin_transaction();
+/**
+ * Commits the current DCT transaction.
+ */
+int dct_commit_transaction();
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
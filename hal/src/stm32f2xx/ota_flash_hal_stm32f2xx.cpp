@@ -490,16 +490,18 @@ uint16_t HAL_Set_Claim_Code(const char* code)
         return dct_write_app_data(code, DCT_CLAIM_CODE_OFFSET, DCT_CLAIM_CODE_SIZE);
     else // clear code
     {
-        char c = '\0';
-        dct_write_app_data(&c, DCT_CLAIM_CODE_OFFSET, 1);
-        // now flag as claimed
         uint8_t claimed = 0;
         dct_read_app_data_copy(DCT_DEVICE_CLAIMED_OFFSET, &claimed, sizeof(claimed));
+        // clear the code and flag as claimed with a single update
+        dct_begin_transaction();
+        char c = '\0';
+        dct_write_app_data(&c, DCT_CLAIM_CODE_OFFSET, 1);
         c = '1';
         if (claimed!=uint8_t(c))
         {
             dct_write_app_data(&c, DCT_DEVICE_CLAIMED_OFFSET, 1);
         }
+        dct_commit_transaction();
     }
     return 0;
 }
@@ -591,6 +593,8 @@ int HAL_Set_System_Config(hal_system_config_t config_item, const void* data, uns
     unsigned offset = 0;
     unsigned length = -1;
 
+    // the prefix length and the prefix are written with a single update
+    dct_begin_transaction();
     switch (config_item)
     {
     case SYSTEM_CONFIG_DEVICE_KEY:
@@ -620,6 +624,7 @@ int HAL_Set_System_Config(hal_system_config_t config_item, const void* data, uns
 
     if (length>=0)
         dct_write_app_data(data, offset, length>data_length ? data_length : length);
+    dct_commit_transaction();
 
     return length;
 }
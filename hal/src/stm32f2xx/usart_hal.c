@@ -47,6 +47,22 @@ typedef enum USART_Num_Def {
 #define USE_USART3_HARDWARE_FLOW_CONTROL_RTS_CTS 0  //Enabling this => 1 is not working at present
 
 /* Private variables ---------------------------------------------------------*/
+typedef struct STM32_USART_DMA_Info {
+	uint32_t dma_clock_en;
+
+	DMA_Stream_TypeDef* rx_stream;
+	uint32_t rx_channel;
+	int32_t rx_int_n;
+	uint32_t rx_it_ht;
+	uint32_t rx_it_tc;
+
+	DMA_Stream_TypeDef* tx_stream;
+	uint32_t tx_channel;
+	int32_t tx_int_n;
+	uint32_t tx_it_tc;
+	uint32_t tx_flags;
+} STM32_USART_DMA_Info;
+
 typedef struct STM32_USART_Info {
 	USART_TypeDef* usart_peripheral;
 
@@ -74,6 +90,12 @@ typedef struct STM32_USART_Info {
 	bool usart_transmitting;
 
 	uint32_t usart_config;
+
+	const STM32_USART_DMA_Info* usart_dma;
+	bool usart_rx_dma;
+	bool usart_tx_dma;
+	// Number of bytes from the TX ring buffer handed to the TX DMA stream
+	volatile uint16_t usart_tx_dma_length;
 } STM32_USART_Info;
 
 /*
@@ -97,6 +119,8 @@ STM32_USART_Info USART_MAP[TOTAL_USARTS] =
 		 * <rx_buffer pointer> used internally and does not appear below
 		 * <usart enabled> used internally and does not appear below
 		 * <usart transmitting> used internally and does not appear below
+		 * <usart config> used internally and does not appear below
+		 * <usart DMA state> used internally and does not appear below
 		 */
 		{ USART1, &RCC->APB2ENR, RCC_APB2Periph_USART1, USART1_IRQn, TX, RX, GPIO_PinSource9, GPIO_PinSource10, GPIO_AF_USART1 }, // USART 1
 		{ USART2, &RCC->APB1ENR, RCC_APB1Periph_USART2, USART2_IRQn, RGBG, RGBB, GPIO_PinSource2, GPIO_PinSource3, GPIO_AF_USART2, A7, RGBR } // USART 2
@@ -107,6 +131,41 @@ STM32_USART_Info USART_MAP[TOTAL_USARTS] =
 #endif
 };
 
+/*
+ * USART DMA mapping (RM0033, DMA request mapping)
+ *
+ * Data is moved to and from the Ring_Buffer by DMA where a stream is available. RX uses a circular
+ * transfer over the whole RX buffer, TX sends the contiguous part of the TX buffer in one transfer.
+ * Directions without a stream below keep using the per-byte USART interrupt.
+ */
+static const STM32_USART_DMA_Info USART_DMA_MAP[TOTAL_USARTS] =
+{
+		/*
+		 * DMA clock enable bit value (RCC_AHB1Periph_DMAx)
+		 * RX stream, channel, interrupt number, half-transfer and transfer-complete interrupts
+		 * TX stream, channel, interrupt number, transfer-complete interrupt, all stream flags
+		 */
+		// USART 1: both RX streams (DMA2 Stream2 and Stream5) are used by SPI1
+		{ RCC_AHB1Periph_DMA2, NULL, 0, 0, 0, 0,
+		  DMA2_Stream7, DMA_Channel_4, DMA2_Stream7_IRQn, DMA_IT_TCIF7,
+		  DMA_FLAG_FEIF7 | DMA_FLAG_DMEIF7 | DMA_FLAG_TEIF7 | DMA_FLAG_HTIF7 | DMA_FLAG_TCIF7 },
+		// USART 2
+		{ RCC_AHB1Periph_DMA1, DMA1_Stream5, DMA_Channel_4, DMA1_Stream5_IRQn, DMA_IT_HTIF5, DMA_IT_TCIF5,
+		  DMA1_Stream6, DMA_Channel_4, DMA1_Stream6_IRQn, DMA_IT_TCIF6,
+		  DMA_FLAG_FEIF6 | DMA_FLAG_DMEIF6 | DMA_FLAG_TEIF6 | DMA_FLAG_HTIF6 | DMA_FLAG_TCIF6 }
+#if PLATFORM_ID == 10 // Electron
+		// USART 3: owned by the cellular modem serial pipe
+		,{ 0 }
+		// UART 4: the RX stream (DMA1 Stream2) is used by SPI3
+		,{ RCC_AHB1Periph_DMA1, NULL, 0, 0, 0, 0,
+		   DMA1_Stream4, DMA_Channel_4, DMA1_Stream4_IRQn, DMA_IT_TCIF4,
+		   DMA_FLAG_FEIF4 | DMA_FLAG_DMEIF4 | DMA_FLAG_TEIF4 | DMA_FLAG_HTIF4 | DMA_FLAG_TCIF4 }
+		// UART 5: the TX stream (DMA1 Stream7) is used by SPI3
+		,{ RCC_AHB1Periph_DMA1, DMA1_Stream0, DMA_Channel_4, DMA1_Stream0_IRQn, DMA_IT_HTIF0, DMA_IT_TCIF0,
+		   NULL, 0, 0, 0, 0 }
+#endif
+};
+
 static USART_InitTypeDef USART_InitStructure;
 static STM32_USART_Info *usartMap[TOTAL_USARTS]; // pointer to USART_MAP[] containing USART peripheral register locations (etc)
 
@@ -131,6 +190,11 @@ static uint32_t HAL_USART_Calculate_Data_Bits_Mask(uint32_t config);
 static uint8_t HAL_USART_Validate_Config(uint32_t config);
 static void HAL_USART_Configure_Transmit_Receive(HAL_USART_Serial serial, uint8_t transmit, uint8_t receive);
 static void HAL_USART_Configure_Pin_Modes(HAL_USART_Serial serial, uint32_t config);
+static void HAL_USART_DMA_Config(HAL_USART_Serial serial);
+static void HAL_USART_DMA_Stop(HAL_USART_Serial serial);
+static void HAL_USART_DMA_Rx_Update(HAL_USART_Serial serial);
+static void HAL_USART_DMA_Tx_Start(HAL_USART_Serial serial);
+static void HAL_USART_DMA_Tx_Complete(HAL_USART_Serial serial);
 
 uint8_t HAL_USART_Calculate_Word_Length(uint32_t config, uint8_t noparity)
 {
@@ -249,6 +313,163 @@ void HAL_USART_Configure_Pin_Modes(HAL_USART_Serial serial, uint32_t config)
 	}
 }
 
+static inline bool HAL_USART_Half_Duplex_No_Echo(HAL_USART_Serial serial)
+{
+	return (usartMap[serial]->usart_config & (SERIAL_HALF_DUPLEX | SERIAL_HALF_DUPLEX_NO_ECHO)) == (SERIAL_HALF_DUPLEX | SERIAL_HALF_DUPLEX_NO_ECHO);
+}
+
+void HAL_USART_DMA_Config(HAL_USART_Serial serial)
+{
+	const STM32_USART_DMA_Info* dma = usartMap[serial]->usart_dma;
+
+	// Half-duplex without echo switches the transmitter on and off around each transmission,
+	// which is driven by the TXE/TC interrupts
+	usartMap[serial]->usart_rx_dma = dma->rx_stream != NULL;
+	usartMap[serial]->usart_tx_dma = dma->tx_stream != NULL && !HAL_USART_Half_Duplex_No_Echo(serial);
+	usartMap[serial]->usart_tx_dma_length = 0;
+
+	if (!usartMap[serial]->usart_rx_dma && !usartMap[serial]->usart_tx_dma) {
+		return;
+	}
+
+	RCC_AHB1PeriphClockCmd(dma->dma_clock_en, ENABLE);
+
+	DMA_InitTypeDef DMA_InitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	// Ring_Buffer stores 16-bit words, which also covers 9-bit data
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&usartMap[serial]->usart_peripheral->DR;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+	DMA_InitStructure.DMA_FIFOMode = DMA_FIFOMode_Disable;
+	DMA_InitStructure.DMA_FIFOThreshold = DMA_FIFOThreshold_Full;
+	DMA_InitStructure.DMA_MemoryBurst = DMA_MemoryBurst_Single;
+	DMA_InitStructure.DMA_PeripheralBurst = DMA_PeripheralBurst_Single;
+
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 7;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+
+	if (usartMap[serial]->usart_rx_dma) {
+		// The DMA restarts at the beginning of the buffer, so any unread data is dropped
+		usartMap[serial]->usart_rx_buffer->head = 0;
+		usartMap[serial]->usart_rx_buffer->tail = 0;
+
+		DMA_DeInit(dma->rx_stream);
+		DMA_InitStructure.DMA_Channel = dma->rx_channel;
+		DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)usartMap[serial]->usart_rx_buffer->buffer;
+		DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+		DMA_InitStructure.DMA_BufferSize = SERIAL_BUFFER_SIZE;
+		DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+		DMA_Init(dma->rx_stream, &DMA_InitStructure);
+		// Half and full buffer interrupts make sure the DMA can't lap the ring buffer head unnoticed
+		DMA_ITConfig(dma->rx_stream, DMA_IT_HT | DMA_IT_TC, ENABLE);
+
+		NVIC_InitStructure.NVIC_IRQChannel = dma->rx_int_n;
+		NVIC_Init(&NVIC_InitStructure);
+
+		DMA_Cmd(dma->rx_stream, ENABLE);
+		USART_DMACmd(usartMap[serial]->usart_peripheral, USART_DMAReq_Rx, ENABLE);
+	}
+
+	if (usartMap[serial]->usart_tx_dma) {
+		DMA_DeInit(dma->tx_stream);
+		DMA_InitStructure.DMA_Channel = dma->tx_channel;
+		DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)usartMap[serial]->usart_tx_buffer->buffer;
+		DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+		DMA_InitStructure.DMA_BufferSize = 1;
+		DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+		DMA_Init(dma->tx_stream, &DMA_InitStructure);
+		DMA_ITConfig(dma->tx_stream, DMA_IT_TC, ENABLE);
+
+		NVIC_InitStructure.NVIC_IRQChannel = dma->tx_int_n;
+		NVIC_Init(&NVIC_InitStructure);
+
+		USART_DMACmd(usartMap[serial]->usart_peripheral, USART_DMAReq_Tx, ENABLE);
+	}
+}
+
+void HAL_USART_DMA_Stop(HAL_USART_Serial serial)
+{
+	const STM32_USART_DMA_Info* dma = usartMap[serial]->usart_dma;
+	NVIC_InitTypeDef NVIC_InitStructure;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = DISABLE;
+
+	if (usartMap[serial]->usart_rx_dma) {
+		USART_DMACmd(usartMap[serial]->usart_peripheral, USART_DMAReq_Rx, DISABLE);
+		DMA_ITConfig(dma->rx_stream, DMA_IT_HT | DMA_IT_TC, DISABLE);
+		DMA_Cmd(dma->rx_stream, DISABLE);
+		NVIC_InitStructure.NVIC_IRQChannel = dma->rx_int_n;
+		NVIC_Init(&NVIC_InitStructure);
+		usartMap[serial]->usart_rx_dma = false;
+	}
+
+	if (usartMap[serial]->usart_tx_dma) {
+		USART_DMACmd(usartMap[serial]->usart_peripheral, USART_DMAReq_Tx, DISABLE);
+		DMA_ITConfig(dma->tx_stream, DMA_IT_TC, DISABLE);
+		DMA_Cmd(dma->tx_stream, DISABLE);
+		while (DMA_GetCmdStatus(dma->tx_stream) != DISABLE);
+		NVIC_InitStructure.NVIC_IRQChannel = dma->tx_int_n;
+		NVIC_Init(&NVIC_InitStructure);
+		if (usartMap[serial]->usart_tx_dma_length) {
+			// Keep whatever hasn't been sent yet in the buffer
+			Ring_Buffer* tx = usartMap[serial]->usart_tx_buffer;
+			tx->tail = (tx->tail + usartMap[serial]->usart_tx_dma_length - DMA_GetCurrDataCounter(dma->tx_stream)) % SERIAL_BUFFER_SIZE;
+			usartMap[serial]->usart_tx_dma_length = 0;
+		}
+		usartMap[serial]->usart_tx_dma = false;
+	}
+}
+
+// Moves the RX ring buffer head to the current DMA write position.
+// Must be called with the USART interrupts masked or from the USART/DMA interrupt handlers
+void HAL_USART_DMA_Rx_Update(HAL_USART_Serial serial)
+{
+	Ring_Buffer* rx = usartMap[serial]->usart_rx_buffer;
+	uint16_t head = (SERIAL_BUFFER_SIZE - DMA_GetCurrDataCounter(usartMap[serial]->usart_dma->rx_stream)) % SERIAL_BUFFER_SIZE;
+	unsigned received = (SERIAL_BUFFER_SIZE + head - rx->head) % SERIAL_BUFFER_SIZE;
+	unsigned used = (SERIAL_BUFFER_SIZE + rx->head - rx->tail) % SERIAL_BUFFER_SIZE;
+	if (used + received >= SERIAL_BUFFER_SIZE) {
+		// The DMA has overwritten the oldest unread data
+		rx->tail = (head + 1) % SERIAL_BUFFER_SIZE;
+	}
+	rx->head = head;
+}
+
+// Hands the contiguous part of the TX ring buffer to the DMA if it's idle.
+// Must be called with the USART interrupts masked or from the USART/DMA interrupt handlers
+void HAL_USART_DMA_Tx_Start(HAL_USART_Serial serial)
+{
+	Ring_Buffer* tx = usartMap[serial]->usart_tx_buffer;
+	uint16_t head = tx->head;
+	uint16_t tail = tx->tail;
+	if (usartMap[serial]->usart_tx_dma_length || head == tail) {
+		return;
+	}
+	uint16_t length = (head > tail ? head : SERIAL_BUFFER_SIZE) - tail;
+	const STM32_USART_DMA_Info* dma = usartMap[serial]->usart_dma;
+	DMA_ClearFlag(dma->tx_stream, dma->tx_flags);
+	DMA_MemoryTargetConfig(dma->tx_stream, (uint32_t)&tx->buffer[tail], DMA_Memory_0);
+	DMA_SetCurrDataCounter(dma->tx_stream, length);
+	usartMap[serial]->usart_tx_dma_length = length;
+	DMA_Cmd(dma->tx_stream, ENABLE);
+}
+
+void HAL_USART_DMA_Tx_Complete(HAL_USART_Serial serial)
+{
+	const STM32_USART_DMA_Info* dma = usartMap[serial]->usart_dma;
+	if (DMA_GetITStatus(dma->tx_stream, dma->tx_it_tc) != RESET) {
+		DMA_ClearITPendingBit(dma->tx_stream, dma->tx_it_tc);
+		Ring_Buffer* tx = usartMap[serial]->usart_tx_buffer;
+		tx->tail = (tx->tail + usartMap[serial]->usart_tx_dma_length) % SERIAL_BUFFER_SIZE;
+		usartMap[serial]->usart_tx_dma_length = 0;
+		HAL_USART_DMA_Tx_Start(serial);
+	}
+}
+
 void HAL_USART_Init(HAL_USART_Serial serial, Ring_Buffer *rx_buffer, Ring_Buffer *tx_buffer)
 {
 	if(serial == HAL_USART_SERIAL1)
@@ -276,12 +497,16 @@ void HAL_USART_Init(HAL_USART_Serial serial, Ring_Buffer *rx_buffer, Ring_Buffer
 
 	usartMap[serial]->usart_rx_buffer = rx_buffer;
 	usartMap[serial]->usart_tx_buffer = tx_buffer;
+	usartMap[serial]->usart_dma = &USART_DMA_MAP[usartMap[serial] - USART_MAP];
 
 	memset(usartMap[serial]->usart_rx_buffer, 0, sizeof(Ring_Buffer));
 	memset(usartMap[serial]->usart_tx_buffer, 0, sizeof(Ring_Buffer));
 
 	usartMap[serial]->usart_enabled = false;
 	usartMap[serial]->usart_transmitting = false;
+	usartMap[serial]->usart_rx_dma = false;
+	usartMap[serial]->usart_tx_dma = false;
+	usartMap[serial]->usart_tx_dma_length = 0;
 }
 
 void HAL_USART_Begin(HAL_USART_Serial serial, uint32_t baud)
@@ -297,6 +522,8 @@ void HAL_USART_BeginConfig(HAL_USART_Serial serial, uint32_t baud, uint32_t conf
 		return;
 	}
 
+	HAL_USART_DMA_Stop(serial);
+
 	USART_DeInit(usartMap[serial]->usart_peripheral);
 
 	usartMap[serial]->usart_enabled = false;
@@ -454,6 +681,8 @@ void HAL_USART_BeginConfig(HAL_USART_Serial serial, uint32_t baud, uint32_t conf
 
 	USART_ITConfig(usartMap[serial]->usart_peripheral, USART_IT_TC, DISABLE);
 
+	HAL_USART_DMA_Config(serial);
+
 	// Enable the USART
 	USART_Cmd(usartMap[serial]->usart_peripheral, ENABLE);
 
@@ -465,8 +694,19 @@ void HAL_USART_BeginConfig(HAL_USART_Serial serial, uint32_t baud, uint32_t conf
 	usartMap[serial]->usart_transmitting = false;
 
 	// Enable USART Receive and Transmit interrupts
-	USART_ITConfig(usartMap[serial]->usart_peripheral, USART_IT_TXE, ENABLE);
-	USART_ITConfig(usartMap[serial]->usart_peripheral, USART_IT_RXNE, ENABLE);
+	if (usartMap[serial]->usart_tx_dma) {
+		int32_t state = HAL_disable_irq();
+		HAL_USART_DMA_Tx_Start(serial);
+		HAL_enable_irq(state);
+	} else {
+		USART_ITConfig(usartMap[serial]->usart_peripheral, USART_IT_TXE, ENABLE);
+	}
+	if (usartMap[serial]->usart_rx_dma) {
+		// The line going idle flushes a partially filled half of the RX buffer
+		USART_ITConfig(usartMap[serial]->usart_peripheral, USART_IT_IDLE, ENABLE);
+	} else {
+		USART_ITConfig(usartMap[serial]->usart_peripheral, USART_IT_RXNE, ENABLE);
+	}
 }
 
 void HAL_USART_End(HAL_USART_Serial serial)
@@ -474,6 +714,8 @@ void HAL_USART_End(HAL_USART_Serial serial)
 	// Wait for transmission of outgoing data
 	while (usartMap[serial]->usart_tx_buffer->head != usartMap[serial]->usart_tx_buffer->tail);
 
+	HAL_USART_DMA_Stop(serial);
+
 	// Disable the USART
 	USART_Cmd(usartMap[serial]->usart_peripheral, DISABLE);
 
@@ -490,6 +732,7 @@ void HAL_USART_End(HAL_USART_Serial serial)
 	// Disable USART Receive and Transmit interrupts
 	USART_ITConfig(usartMap[serial]->usart_peripheral, USART_IT_RXNE, DISABLE);
 	USART_ITConfig(usartMap[serial]->usart_peripheral, USART_IT_TXE, DISABLE);
+	USART_ITConfig(usartMap[serial]->usart_peripheral, USART_IT_IDLE, DISABLE);
 
 	NVIC_InitTypeDef NVIC_InitStructure;
 
@@ -524,6 +767,27 @@ uint32_t HAL_USART_Write_NineBitData(HAL_USART_Serial serial, uint16_t data)
 {
 	// Remove any bits exceeding data bits configured
 	data &= HAL_USART_Calculate_Data_Bits_Mask(usartMap[serial]->usart_config);
+
+	if (usartMap[serial]->usart_tx_dma) {
+		Ring_Buffer* tx = usartMap[serial]->usart_tx_buffer;
+		unsigned i = (tx->head + 1) % SERIAL_BUFFER_SIZE;
+		// Same as below: wait for space, or drain the buffer when called with interrupts disabled.
+		// The DMA interrupt may not be serviced here, so poll for the end of the transfer instead
+		while (i == tx->tail || ((__get_PRIMASK() & 1) && tx->head != tx->tail)) {
+			int32_t state = HAL_disable_irq();
+			HAL_USART_DMA_Tx_Complete(serial);
+			HAL_USART_DMA_Tx_Start(serial);
+			HAL_enable_irq(state);
+		}
+		tx->buffer[tx->head] = data;
+		tx->head = i;
+		usartMap[serial]->usart_transmitting = true;
+		int32_t state = HAL_disable_irq();
+		HAL_USART_DMA_Tx_Start(serial);
+		HAL_enable_irq(state);
+		return 1;
+	}
+
 	// interrupts are off and data in queue;
 	if ((USART_GetITStatus(usartMap[serial]->usart_peripheral, USART_IT_TXE) == RESET)
 		&& usartMap[serial]->usart_tx_buffer->head != usartMap[serial]->usart_tx_buffer->tail) {
@@ -563,6 +827,11 @@ uint32_t HAL_USART_Write_NineBitData(HAL_USART_Serial serial, uint16_t data)
 
 int32_t HAL_USART_Available_Data(HAL_USART_Serial serial)
 {
+	if (usartMap[serial]->usart_rx_dma) {
+		int32_t state = HAL_disable_irq();
+		HAL_USART_DMA_Rx_Update(serial);
+		HAL_enable_irq(state);
+	}
 	return (unsigned int)(SERIAL_BUFFER_SIZE + usartMap[serial]->usart_rx_buffer->head - usartMap[serial]->usart_rx_buffer->tail) % SERIAL_BUFFER_SIZE;
 }
 
@@ -579,6 +848,20 @@ int32_t HAL_USART_Available_Data_For_Write(HAL_USART_Serial serial)
 
 int32_t HAL_USART_Read_Data(HAL_USART_Serial serial)
 {
+	if (usartMap[serial]->usart_rx_dma) {
+		Ring_Buffer* rx = usartMap[serial]->usart_rx_buffer;
+		int32_t c = -1;
+		int32_t state = HAL_disable_irq();
+		HAL_USART_DMA_Rx_Update(serial);
+		if (rx->head != rx->tail) {
+			c = rx->buffer[rx->tail];
+			rx->tail = (unsigned int)(rx->tail + 1) % SERIAL_BUFFER_SIZE;
+		}
+		HAL_enable_irq(state);
+		// Parity bits are not removed by the DMA
+		return c < 0 ? c : (int32_t)(c & HAL_USART_Calculate_Data_Bits_Mask(usartMap[serial]->usart_config));
+	}
+
 	// if the head isn't ahead of the tail, we don't have any characters
 	if (usartMap[serial]->usart_rx_buffer->head == usartMap[serial]->usart_rx_buffer->tail)
 	{
@@ -594,6 +877,18 @@ int32_t HAL_USART_Read_Data(HAL_USART_Serial serial)
 
 int32_t HAL_USART_Peek_Data(HAL_USART_Serial serial)
 {
+	if (usartMap[serial]->usart_rx_dma) {
+		Ring_Buffer* rx = usartMap[serial]->usart_rx_buffer;
+		int32_t c = -1;
+		int32_t state = HAL_disable_irq();
+		HAL_USART_DMA_Rx_Update(serial);
+		if (rx->head != rx->tail) {
+			c = rx->buffer[rx->tail];
+		}
+		HAL_enable_irq(state);
+		return c < 0 ? c : (int32_t)(c & HAL_USART_Calculate_Data_Bits_Mask(usartMap[serial]->usart_config));
+	}
+
 	if (usartMap[serial]->usart_rx_buffer->head == usartMap[serial]->usart_rx_buffer->tail)
 	{
 		return -1;
@@ -621,6 +916,9 @@ bool HAL_USART_Is_Enabled(HAL_USART_Serial serial)
 void HAL_USART_Half_Duplex(HAL_USART_Serial serial, bool Enable)
 {
 	if (HAL_USART_Is_Enabled(serial)) {
+		// Switching to or from half-duplex without echo also switches between DMA and interrupt-driven TX
+		HAL_USART_Flush_Data(serial);
+		HAL_USART_DMA_Stop(serial);
 		USART_Cmd(usartMap[serial]->usart_peripheral, DISABLE);
 	}
 
@@ -638,6 +936,8 @@ void HAL_USART_Half_Duplex(HAL_USART_Serial serial, bool Enable)
 
 
 	if (HAL_USART_Is_Enabled(serial)) {
+		HAL_USART_DMA_Config(serial);
+		USART_ITConfig(usartMap[serial]->usart_peripheral, USART_IT_TXE, usartMap[serial]->usart_tx_dma ? DISABLE : ENABLE);
 		USART_Cmd(usartMap[serial]->usart_peripheral, ENABLE);
 	}
 }
@@ -675,7 +975,14 @@ static void HAL_USART_Handler(HAL_USART_Serial serial)
 		store_char(c, usartMap[serial]->usart_rx_buffer);
 	}
 
-	uint8_t noecho = (usartMap[serial]->usart_config & (SERIAL_HALF_DUPLEX | SERIAL_HALF_DUPLEX_NO_ECHO)) == (SERIAL_HALF_DUPLEX | SERIAL_HALF_DUPLEX_NO_ECHO);
+	if(USART_GetITStatus(usartMap[serial]->usart_peripheral, USART_IT_IDLE) != RESET)
+	{
+		// Reading the data register after the status register clears the IDLE flag
+		(void)USART_ReceiveData(usartMap[serial]->usart_peripheral);
+		HAL_USART_DMA_Rx_Update(serial);
+	}
+
+	uint8_t noecho = HAL_USART_Half_Duplex_No_Echo(serial);
 
 	if(USART_GetITStatus(usartMap[serial]->usart_peripheral, USART_IT_TC) != RESET) {
 		if (noecho) {
@@ -706,7 +1013,7 @@ static void HAL_USART_Handler(HAL_USART_Serial serial)
 		}
 	}
 
-	if (USART_GetFlagStatus(usartMap[serial]->usart_peripheral, USART_FLAG_ORE) != RESET)
+	if (!usartMap[serial]->usart_rx_dma && USART_GetFlagStatus(usartMap[serial]->usart_peripheral, USART_FLAG_ORE) != RESET)
 	{
 		// If Overrun flag is still set, clear it
 		(void)USART_ReceiveData(usartMap[serial]->usart_peripheral);
@@ -714,6 +1021,18 @@ static void HAL_USART_Handler(HAL_USART_Serial serial)
 
 }
 
+static void HAL_USART_DMA_Rx_Handler(HAL_USART_Serial serial)
+{
+	const STM32_USART_DMA_Info* dma = usartMap[serial]->usart_dma;
+	if (DMA_GetITStatus(dma->rx_stream, dma->rx_it_ht) != RESET) {
+		DMA_ClearITPendingBit(dma->rx_stream, dma->rx_it_ht);
+	}
+	if (DMA_GetITStatus(dma->rx_stream, dma->rx_it_tc) != RESET) {
+		DMA_ClearITPendingBit(dma->rx_stream, dma->rx_it_tc);
+	}
+	HAL_USART_DMA_Rx_Update(serial);
+}
+
 // Serial1 interrupt handler
 /*******************************************************************************
  * Function Name  : HAL_USART1_Handler
@@ -740,6 +1059,24 @@ void HAL_USART2_Handler(void)
 	HAL_USART_Handler(HAL_USART_SERIAL2);
 }
 
+// Serial1 TX DMA interrupt handler (DMA2 Stream7)
+void HAL_USART1_DMA_Tx_Handler(void)
+{
+	HAL_USART_DMA_Tx_Complete(HAL_USART_SERIAL1);
+}
+
+// Serial2 RX DMA interrupt handler (DMA1 Stream5)
+void HAL_USART2_DMA_Rx_Handler(void)
+{
+	HAL_USART_DMA_Rx_Handler(HAL_USART_SERIAL2);
+}
+
+// Serial2 TX DMA interrupt handler (DMA1 Stream6)
+void HAL_USART2_DMA_Tx_Handler(void)
+{
+	HAL_USART_DMA_Tx_Complete(HAL_USART_SERIAL2);
+}
+
 #if PLATFORM_ID == 10 // Only Electron
 #if 0
 // Serial3 interrupt handler
@@ -781,4 +1118,16 @@ void HAL_USART5_Handler(void)
 {
 	HAL_USART_Handler(HAL_USART_SERIAL5);
 }
+
+// Serial4 TX DMA interrupt handler (DMA1 Stream4)
+void HAL_USART4_DMA_Tx_Handler(void)
+{
+	HAL_USART_DMA_Tx_Complete(HAL_USART_SERIAL4);
+}
+
+// Serial5 RX DMA interrupt handler (DMA1 Stream0)
+void HAL_USART5_DMA_Rx_Handler(void)
+{
+	HAL_USART_DMA_Rx_Handler(HAL_USART_SERIAL5);
+}
 #endif
@@ -83,3 +83,37 @@
 #define NFC_PIN2 28
 #define ANTSW1 29
 #define ANTSW2 30
+
+// nRF52840 GPIO of each pin, in the order of the pin map. Used to resolve the pins at compile time
+#define PLATFORM_NRF_PIN_MAP \
+    NRF_GPIO_PIN_MAP(0, 26), /* D0 / SDA */ \
+    NRF_GPIO_PIN_MAP(0, 27), /* D1 / SCL */ \
+    NRF_GPIO_PIN_MAP(1, 1), /* D2 */ \
+    NRF_GPIO_PIN_MAP(1, 2), /* D3 */ \
+    NRF_GPIO_PIN_MAP(1, 8), /* D4 */ \
+    NRF_GPIO_PIN_MAP(1, 10), /* D5 */ \
+    NRF_GPIO_PIN_MAP(1, 11), /* D6 */ \
+    NRF_GPIO_PIN_MAP(1, 12), /* D7 */ \
+    NRF_GPIO_PIN_MAP(1, 3), /* D8 */ \
+    NRF_GPIO_PIN_MAP(0, 6), /* D9 */ \
+    NRF_GPIO_PIN_MAP(0, 8), /* D10 */ \
+    NRF_GPIO_PIN_MAP(1, 14), /* D11 */ \
+    NRF_GPIO_PIN_MAP(1, 13), /* D12 */ \
+    NRF_GPIO_PIN_MAP(1, 15), /* D13 */ \
+    NRF_GPIO_PIN_MAP(0, 31), /* A5 */ \
+    NRF_GPIO_PIN_MAP(0, 30), /* A4 */ \
+    NRF_GPIO_PIN_MAP(0, 29), /* A3 */ \
+    NRF_GPIO_PIN_MAP(0, 28), /* A2 */ \
+    NRF_GPIO_PIN_MAP(0, 4), /* A1 */ \
+    NRF_GPIO_PIN_MAP(0, 3), /* A0 */ \
+    NRF_GPIO_PIN_MAP(0, 11), /* MODE BUTTON */ \
+    NRF_GPIO_PIN_MAP(0, 13), /* RGBR */ \
+    NRF_GPIO_PIN_MAP(0, 14), /* RGBG */ \
+    NRF_GPIO_PIN_MAP(0, 15), /* RGBB */ \
+    NRF_GPIO_PIN_MAP(0, 5), /* BATT */ \
+    NRF_GPIO_PIN_MAP(0, 12), /* PWR */ \
+    NRF_GPIO_PIN_MAP(1, 9), /* CHG */ \
+    NRF_GPIO_PIN_MAP(0, 9), /* NFC_PIN1 */ \
+    NRF_GPIO_PIN_MAP(0, 10), /* NFC_PIN2 */ \
+    NRF_GPIO_PIN_MAP(0, 24), /* ANTSW1 */ \
+    NRF_GPIO_PIN_MAP(0, 25), /* ANTSW2 */
@@ -6,7 +6,13 @@
 #include <malloc.h>
 
 #include "interrupts_hal.h"
+#include "ota_flash_hal.h"
 #include "service_debug.h"
+#include "hal_platform.h"
+
+#if HAL_PLATFORM_HEAP_ARENA
+#include "heap_arena.h"
+#endif
 
 extern "C" {
 
@@ -16,11 +22,118 @@ size_t xPortGetFreeHeapSize( void );
 size_t xPortGetMinimumEverFreeHeapSize( void );
 size_t xPortGetHeapSize( void );
 size_t xPortGetBlockSize( void* ptr );
+void vPortSetBlockOwner( void* ptr, int owner );
+int xPortGetBlockOwner( void* ptr );
 void __malloc_lock(struct _reent *ptr);
 void __malloc_unlock(struct _reent *ptr);
 
+extern const module_bounds_t module_user;
+
 } // extern "C"
 
+namespace {
+
+// Total size of the blocks allocated by the user module
+size_t g_userHeapUsed = 0;
+
+#if HAL_PLATFORM_HEAP_ARENA
+particle::HeapArena g_arena;
+#endif
+
+// Returns true if the allocation is made by the user module. The C library functions and the
+// dynalib stubs jump to the heap functions without creating a new stack frame, so the return
+// address points to the code that called malloc() or operator new
+inline bool is_user_caller(const void* addr) {
+#if defined(MODULAR_FIRMWARE) && MODULAR_FIRMWARE
+    const auto a = (uintptr_t)addr;
+    return a >= module_user.start_address && a < module_user.end_address;
+#else
+    (void)addr;
+    return false;
+#endif
+}
+
+#if HAL_PLATFORM_HEAP_ARENA
+
+bool init_arena() {
+    if (g_arena.isInitialized()) {
+        return true;
+    }
+    // The heap may not be available yet
+    void* const mem = pvPortMalloc(HAL_PLATFORM_HEAP_ARENA_SIZE);
+    if (!mem) {
+        return false;
+    }
+    if (!g_arena.init(mem, HAL_PLATFORM_HEAP_ARENA_SIZE)) {
+        vPortFree(mem);
+        return false;
+    }
+    return true;
+}
+
+#endif // HAL_PLATFORM_HEAP_ARENA
+
+// Should be called with the heap locked
+void* heap_alloc(size_t size, bool user) {
+    void* ptr = nullptr;
+#if HAL_PLATFORM_HEAP_ARENA
+    if (size <= particle::HeapArena::MAX_BLOCK_SIZE && init_arena()) {
+        ptr = g_arena.alloc(size, user);
+        if (ptr) {
+            if (user) {
+                g_userHeapUsed += g_arena.blockSize(ptr);
+            }
+            return ptr;
+        }
+    }
+#endif // HAL_PLATFORM_HEAP_ARENA
+    ptr = pvPortMalloc(size);
+    if (ptr && user) {
+        vPortSetBlockOwner(ptr, 1);
+        g_userHeapUsed += xPortGetBlockSize(ptr);
+    }
+    return ptr;
+}
+
+// Should be called with the heap locked
+void heap_free(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+#if HAL_PLATFORM_HEAP_ARENA
+    if (g_arena.contains(ptr)) {
+        if (g_arena.owner(ptr)) {
+            g_userHeapUsed -= g_arena.blockSize(ptr);
+        }
+        g_arena.free(ptr);
+        return;
+    }
+#endif // HAL_PLATFORM_HEAP_ARENA
+    if (xPortGetBlockOwner(ptr)) {
+        g_userHeapUsed -= xPortGetBlockSize(ptr);
+    }
+    vPortFree(ptr);
+}
+
+size_t heap_block_size(void* ptr) {
+#if HAL_PLATFORM_HEAP_ARENA
+    if (g_arena.contains(ptr)) {
+        return g_arena.blockSize(ptr);
+    }
+#endif // HAL_PLATFORM_HEAP_ARENA
+    if (!ptr) {
+        return 0;
+    }
+    return heap_block_size(ptr);
+}
+
+// Returns the total size of the blocks allocated by the user module
+extern "C" size_t malloc_user_heap_used() {
+    return g_userHeapUsed;
+}
+
+} // namespace
+
 static void panic_if_in_isr() {
     if (HAL_IsISR()) {
         PANIC(HeapError, "Heap usage from an ISR");
@@ -29,9 +142,11 @@ static void panic_if_in_isr() {
 }
 
 void* _malloc_r(struct _reent *r, size_t s) {
-    (void)r;
+    const bool user = is_user_caller(__builtin_return_address(0));
     panic_if_in_isr();
-    void* ptr = pvPortMalloc((size_t)s);
+    __malloc_lock(r);
+    void* ptr = heap_alloc((size_t)s, user);
+    __malloc_unlock(r);
     return ptr;
 }
 
@@ -44,7 +159,9 @@ void _free_r(struct _reent* r, void* ptr) {
         ptr = NULL;
     }
 #endif
-    vPortFree(ptr);
+    __malloc_lock(r);
+    heap_free(ptr);
+    __malloc_unlock(r);
 }
 
 void _cfree_r(struct _reent* r, void* ptr) {
@@ -52,30 +169,45 @@ void _cfree_r(struct _reent* r, void* ptr) {
 }
 
 void* _calloc_r(struct _reent* r, size_t n, size_t elem) {
-    void* ptr = _malloc_r(r, (size_t)(n * elem));
+    const bool user = is_user_caller(__builtin_return_address(0));
+    panic_if_in_isr();
+    const size_t size = n * elem;
+    if (elem && size / elem != n) {
+        return NULL;
+    }
+    __malloc_lock(r);
+    void* ptr = heap_alloc(size, user);
+    __malloc_unlock(r);
     if (ptr != NULL) {
-        memset(ptr, 0, (size_t)(elem * n));
+        memset(ptr, 0, size);
     }
     return ptr;
 }
 
 void* _realloc_r(struct _reent* r, void *ptr, size_t newsize) {
-    (void)r;
+    const bool user = is_user_caller(__builtin_return_address(0));
 
     panic_if_in_isr();
 
     if (newsize == 0) {
-        vPortFree(ptr);
+        _free_r(r, ptr);
         return NULL;
     }
 
-    void *p = pvPortMalloc(newsize);
-    if (p) {
-        if (ptr != NULL) {
-            memcpy(p, ptr, newsize);
-            vPortFree(ptr);
+    __malloc_lock(r);
+    void* p = NULL;
+    const size_t oldsize = ptr ? heap_block_size(ptr) : 0;
+    if (ptr && newsize <= oldsize) {
+        // The block is large enough already
+        p = ptr;
+    } else {
+        p = heap_alloc(newsize, user);
+        if (p && ptr) {
+            memcpy(p, ptr, oldsize);
+            heap_free(ptr);
         }
     }
+    __malloc_unlock(r);
     return p;
 }
 
@@ -87,6 +219,10 @@ struct mallinfo _mallinfo_r(struct _reent* r) {
 
     current_mallinfo.arena = xPortGetHeapSize();
     current_mallinfo.fordblks = xPortGetFreeHeapSize();
+#if HAL_PLATFORM_HEAP_ARENA
+    // Free blocks of the arena are available to small allocations
+    current_mallinfo.fordblks += g_arena.stats().freeBytes;
+#endif
     current_mallinfo.uordblks = current_mallinfo.arena - current_mallinfo.fordblks;
     current_mallinfo.usmblks = current_mallinfo.arena - xPortGetMinimumEverFreeHeapSize();
 
@@ -103,5 +239,13 @@ size_t _malloc_usable_size_r(struct _reent* r, void* ptr) {
 
     panic_if_in_isr();
 
-    return xPortGetBlockSize(ptr);
+    if (!ptr) {
+        return 0;
+    }
+    return heap_block_size(ptr);
+}
+
+// Returns the total size of the blocks allocated by the user module
+extern "C" size_t malloc_user_heap_used() {
+    return g_userHeapUsed;
 }
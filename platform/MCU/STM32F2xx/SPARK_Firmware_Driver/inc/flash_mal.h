@@ -116,6 +116,12 @@ extern "C" {
 #   error "FIRMWARE_IMAGE_SIZE too large to fit into internal flash"
 #endif
 
+/* Device supply voltage range, defines the internal flash erase and program parallelism:
+   VoltageRange_1 (1.8V - 2.1V): x8, VoltageRange_2 (2.1V - 2.7V): x16, VoltageRange_3 (2.7V - 3.6V): x32 */
+#ifndef INTERNAL_FLASH_VOLTAGE_RANGE
+#define INTERNAL_FLASH_VOLTAGE_RANGE VoltageRange_3
+#endif
+
 /* Bootloader Flash regions that needs to be protected: 0x08000000 - 0x08003FFF */
 #define BOOTLOADER_FLASH_PAGES      (OB_WRP_Sector_0)
 
@@ -123,6 +129,13 @@ void FLASH_WriteProtection_Enable(uint32_t FLASH_Sectors);
 void FLASH_WriteProtection_Disable(uint32_t FLASH_Sectors);
 uint32_t FLASH_PagesMask(uint32_t imageSize, uint32_t pageSize);
 
+/**
+ * Programs internal flash at the widest parallelism allowed by INTERNAL_FLASH_VOLTAGE_RANGE.
+ * The destination doesn't need to be aligned, unaligned head and tail bytes are programmed
+ * with narrower operations. The flash must be unlocked by the caller.
+ */
+FLASH_Status FLASH_ProgramInternal(uint32_t address, const void* data, uint32_t length);
+
 
 #include "flash_access.h"
 
@@ -39,37 +39,15 @@ public:
 
     static int write(const unsigned offset, const void* data, const unsigned size)
     {
-        const uint8_t* data_ptr = (const uint8_t*)data;
-        const uint8_t* end_ptr  = data_ptr+size;
-        unsigned destination = offset;
+        const int max_tries = 10;
+        int tries = 0;
         FLASH_Unlock();
         FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
 
-        while (data_ptr < end_ptr)
+        // Reprogramming already written data with the same value is harmless, so retry the whole range
+        while ((FLASH_COMPLETE != FLASH_ProgramInternal(offset, data, size)) && (tries++ < max_tries))
         {
-            FLASH_Status status;
-            const int max_tries = 10;
-            int tries = 0;
-
-            if ( !(destination & 0x03) && (end_ptr - data_ptr >= 4))  // have a whole word to write
-            {
-                while ((FLASH_COMPLETE != (status = FLASH_ProgramWord(destination, *(const uint32_t*)data_ptr))) && (tries++ < max_tries));
-                destination += 4;
-                data_ptr += 4;
-            }
-            else if ( !(destination & 0x01) && (end_ptr - data_ptr >= 2))  // have a half word to write
-            {
-                while ((FLASH_COMPLETE != (status = FLASH_ProgramHalfWord(destination, *(const uint16_t*)data_ptr))) && (tries++ < max_tries));
-                destination += 2;
-                data_ptr += 2;
-            }
-            else
-            {
-                while ((FLASH_COMPLETE != (status = FLASH_ProgramByte(destination, *data_ptr))) && (tries++ < max_tries));
-                destination++;
-                data_ptr++;
-            }
-
+            FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
         }
         FLASH_Lock();
         return (memcmp(dataAt(offset), data, size)) ? -1 : 0;
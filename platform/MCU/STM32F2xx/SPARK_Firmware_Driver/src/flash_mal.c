@@ -216,7 +216,7 @@ bool FLASH_EraseMemory(flash_device_t flashDeviceID, uint32_t startAddress, uint
         /* Erase the Internal Flash pages */
         for (eraseCounter = 0; (eraseCounter < numPages); eraseCounter++)
         {
-            FLASH_Status status = FLASH_EraseSector(flashSector + (8 * eraseCounter), VoltageRange_3);
+            FLASH_Status status = FLASH_EraseSector(flashSector + (8 * eraseCounter), INTERNAL_FLASH_VOLTAGE_RANGE);
 
             /* If erase operation fails, return Failure */
             if (status != FLASH_COMPLETE)
@@ -325,6 +325,13 @@ bool CopyFlashBlock(flash_device_t sourceDeviceID, uint32_t sourceAddress, flash
 
 	bool success = true;
 
+	if (sourceDeviceID == FLASH_INTERNAL && destinationDeviceID == FLASH_INTERNAL)
+	{
+		/* Internal to internal copy, program directly from the memory mapped source */
+		success = (FLASH_ProgramInternal(destinationAddress, (const void*)sourceAddress, (length + 3) & ~3) == FLASH_COMPLETE);
+		sourceAddress = endAddress;
+	}
+
 	/* Program source to destination */
 	while (sourceAddress < endAddress)
 	{
@@ -725,6 +732,78 @@ bool FLASH_VerifyCRC32(uint8_t flashDeviceID, uint32_t startAddress, uint32_t le
     return false;
 }
 
+static unsigned InternalFlashProgramWidth(void)
+{
+    switch (INTERNAL_FLASH_VOLTAGE_RANGE)
+    {
+    case VoltageRange_1:
+        return 1;
+    case VoltageRange_2:
+        return 2;
+    default:
+        // x64 parallelism requires an external Vpp, x32 is the widest we use
+        return 4;
+    }
+}
+
+FLASH_Status FLASH_ProgramInternal(uint32_t address, const void* data, uint32_t length)
+{
+    const uint8_t* src = (const uint8_t*)data;
+    const uint32_t endAddress = address + length;
+    const unsigned width = InternalFlashProgramWidth();
+    const uint32_t psize = (width == 4) ? FLASH_CR_PSIZE_1 : ((width == 2) ? FLASH_CR_PSIZE_0 : 0);
+
+    FLASH_Status status = FLASH_WaitForLastOperation();
+
+    while (status == FLASH_COMPLETE && address < endAddress)
+    {
+        if (!(address & (width - 1)) && (endAddress - address >= width))
+        {
+            /* Program the aligned run at full width, setting up the controller only once */
+            FLASH->CR = (FLASH->CR & ~(FLASH_CR_PSIZE_0 | FLASH_CR_PSIZE_1)) | psize | FLASH_CR_PG;
+            do
+            {
+                if (width == 4)
+                {
+                    uint32_t word;
+                    memcpy(&word, src, sizeof(word));
+                    *(__IO uint32_t*)address = word;
+                }
+                else if (width == 2)
+                {
+                    uint16_t halfWord;
+                    memcpy(&halfWord, src, sizeof(halfWord));
+                    *(__IO uint16_t*)address = halfWord;
+                }
+                else
+                {
+                    *(__IO uint8_t*)address = *src;
+                }
+                status = FLASH_WaitForLastOperation();
+                address += width;
+                src += width;
+            } while (status == FLASH_COMPLETE && (endAddress - address >= width));
+            FLASH->CR &= ~FLASH_CR_PG;
+        }
+        else if (width > 2 && !(address & 0x01) && (endAddress - address >= 2))
+        {
+            uint16_t halfWord;
+            memcpy(&halfWord, src, sizeof(halfWord));
+            status = FLASH_ProgramHalfWord(address, halfWord);
+            address += 2;
+            src += 2;
+        }
+        else
+        {
+            status = FLASH_ProgramByte(address, *src);
+            ++address;
+            ++src;
+        }
+    }
+
+    return status;
+}
+
 void FLASH_ClearFlags(void)
 {
     /* Clear All pending flags */
@@ -884,28 +963,12 @@ int FLASH_Update(const uint8_t *pBuffer, uint32_t address, uint32_t bufferSize)
 
     return !i;
 #else
-    uint32_t index = 0;
-
     /* Unlock the internal flash */
     FLASH_Unlock();
 
     FLASH_ClearFlags();
 
-    /* Data received are Word multiple */
-    for (index = 0; index < (bufferSize & 0xFFFC); index += 4)
-    {
-        FLASH_ProgramWord(address, *(uint32_t *)(pBuffer + index));
-        address += 4;
-    }
-
-    if (bufferSize & 0x3) /* Not an aligned data */
-    {
-        for (; index < bufferSize; index++)
-        {
-            FLASH_ProgramByte(address, pBuffer[index]);
-            ++address;
-        }
-    }
+    FLASH_ProgramInternal(address, pBuffer, bufferSize);
 
     /* Lock the internal flash */
     FLASH_Lock();
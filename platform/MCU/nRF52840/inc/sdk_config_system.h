@@ -62,6 +62,7 @@
 #define NRF_SDH_BLE_CENTRAL_LINK_COUNT 3
 #define NRF_SDH_BLE_TOTAL_LINK_COUNT (NRF_SDH_BLE_PERIPHERAL_LINK_COUNT + NRF_SDH_BLE_CENTRAL_LINK_COUNT)
 #define NRF_SDH_BLE_GAP_DATA_LENGTH 251 // Requested BLE GAP data length to be negotiated
+#define NRF_SDH_BLE_GAP_EVENT_LENGTH 6 // Connection event length reserved for each link, in 1.25 ms units
 #define NRF_SDH_BLE_GATT_MAX_MTU_SIZE 247 // Static maximum MTU size
 #define NRF_SDH_BLE_SERVICE_CHANGED 1 // Service changed
 
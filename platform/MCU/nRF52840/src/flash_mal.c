@@ -33,6 +33,11 @@
 #include "flash_hal.h"
 #include "exflash_hal.h"
 
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+#include "concurrent_hal.h"
+#include "delay_hal.h"
+#endif /* MODULE_FUNCTION != MOD_FUNC_BOOTLOADER */
+
 
 #define CEIL_DIV(A, B)        (((A) + (B) - 1) / (B))
 
@@ -153,6 +158,91 @@ int FLASH_CheckCopyMemory(flash_device_t sourceDeviceID, uint32_t sourceAddress,
     return FLASH_ACCESS_RESULT_OK;
 }
 
+static int read_memory(flash_device_t deviceID, uint32_t address, uint8_t* data, uint32_t length)
+{
+    if (deviceID == FLASH_SERIAL)
+    {
+        return hal_exflash_read(address, data, length);
+    }
+    return hal_flash_read(address, data, length);
+}
+
+/*
+ * Checks if a page of the internal flash already contains the data that would be programmed to it
+ * by copying the source range, the rest of the page being erased.
+ */
+static bool is_internal_page_unchanged(flash_device_t sourceDeviceID, uint32_t sourceAddress,
+                                       uint32_t sourceLength, uint32_t pageAddress, uint8_t* data_buf)
+{
+    const uint8_t* page = (const uint8_t*)pageAddress;
+    uint32_t offs = 0;
+
+    while (offs < sourceLength)
+    {
+        const uint32_t len = (sourceLength - offs) >= MAX_COPY_LENGTH ? MAX_COPY_LENGTH : (sourceLength - offs);
+        if (read_memory(sourceDeviceID, sourceAddress + offs, data_buf, len) || memcmp(page + offs, data_buf, len))
+        {
+            return false;
+        }
+        offs += len;
+    }
+    for (; offs < INTERNAL_FLASH_PAGE_SIZE; ++offs)
+    {
+        if (page[offs] != 0xff)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Copies data to the internal flash page by page, using a buffer of MAX_COPY_LENGTH bytes. The
+ * pages that already contain the data being copied are neither erased nor programmed, so that
+ * updating a module that has only partially changed, or reapplying the same module, takes less
+ * time and causes less flash wear.
+ */
+static int copy_to_internal_flash(flash_device_t sourceDeviceID, uint32_t sourceAddress, uint32_t endAddress,
+                                  uint32_t destinationAddress, uint16_t sector_num, uint8_t* data_buf)
+{
+    for (uint16_t i = 0; i < sector_num; ++i)
+    {
+        uint32_t page_len = endAddress - sourceAddress;
+        if (page_len > INTERNAL_FLASH_PAGE_SIZE)
+        {
+            page_len = INTERNAL_FLASH_PAGE_SIZE;
+        }
+
+        if (!is_internal_page_unchanged(sourceDeviceID, sourceAddress, page_len, destinationAddress, data_buf))
+        {
+            if (hal_flash_erase_sector(destinationAddress, 1))
+            {
+                return FLASH_ACCESS_RESULT_ERROR;
+            }
+
+            uint32_t offs = 0;
+            while (offs < page_len)
+            {
+                const uint32_t copy_len = (page_len - offs) >= MAX_COPY_LENGTH ? MAX_COPY_LENGTH : (page_len - offs);
+                if (read_memory(sourceDeviceID, sourceAddress + offs, data_buf, copy_len))
+                {
+                    return FLASH_ACCESS_RESULT_ERROR;
+                }
+                if (hal_flash_write(destinationAddress + offs, data_buf, copy_len))
+                {
+                    return FLASH_ACCESS_RESULT_ERROR;
+                }
+                offs += copy_len;
+            }
+        }
+
+        sourceAddress += page_len;
+        destinationAddress += INTERNAL_FLASH_PAGE_SIZE;
+    }
+
+    return FLASH_ACCESS_RESULT_OK;
+}
+
 int FLASH_CopyMemory(flash_device_t sourceDeviceID, uint32_t sourceAddress,
                      flash_device_t destinationDeviceID, uint32_t destinationAddress,
                      uint32_t length, uint8_t module_function, uint8_t flags)
@@ -176,11 +266,8 @@ int FLASH_CopyMemory(flash_device_t sourceDeviceID, uint32_t sourceAddress,
     }
     else if (destinationDeviceID == FLASH_INTERNAL)
     {
+        // The pages are erased as needed by copy_to_internal_flash()
         sector_num = CEIL_DIV(length, INTERNAL_FLASH_PAGE_SIZE);
-        if (hal_flash_erase_sector(destinationAddress, sector_num))
-        {
-            return FLASH_ACCESS_RESULT_ERROR;
-        }
     }
     else
     {
@@ -214,41 +301,26 @@ int FLASH_CopyMemory(flash_device_t sourceDeviceID, uint32_t sourceAddress,
         }
     }
 
+    if (destinationDeviceID == FLASH_INTERNAL)
+    {
+        return copy_to_internal_flash(sourceDeviceID, sourceAddress, endAddress, destinationAddress, sector_num, data_buf);
+    }
+
     /* Program source to destination */
     while (sourceAddress < endAddress)
     {
         copy_len = (endAddress - sourceAddress) >= MAX_COPY_LENGTH ? MAX_COPY_LENGTH : (endAddress - sourceAddress);
 
         // Read data from source memory address
-        if (sourceDeviceID == FLASH_SERIAL)
-        {
-            if (hal_exflash_read(sourceAddress, data_buf, copy_len))
-            {
-                return FLASH_ACCESS_RESULT_ERROR;
-            }
-        }
-        else
+        if (read_memory(sourceDeviceID, sourceAddress, data_buf, copy_len))
         {
-            if (hal_flash_read(sourceAddress, data_buf, copy_len))
-            {
-                return FLASH_ACCESS_RESULT_ERROR;
-            }
+            return FLASH_ACCESS_RESULT_ERROR;
         }
 
         // Program data to destination memory address
-        if (destinationDeviceID == FLASH_SERIAL)
-        {
-            if (hal_exflash_write(destinationAddress, data_buf, copy_len))
-            {
-                return FLASH_ACCESS_RESULT_ERROR;
-            }
-        }
-        else
+        if (hal_exflash_write(destinationAddress, data_buf, copy_len))
         {
-            if (hal_flash_write(destinationAddress, data_buf, copy_len))
-            {
-                return FLASH_ACCESS_RESULT_ERROR;
-            }
+            return FLASH_ACCESS_RESULT_ERROR;
         }
 
         sourceAddress += copy_len;
@@ -662,12 +734,122 @@ void FLASH_Restore(uint32_t FLASH_Address)
 #endif
 }
 
+#if defined(USE_SERIAL_FLASH) && MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+
+#define OTA_ERASE_BLOCK_SIZE    ((uint32_t)0x10000) /* 64KB */
+
+/* The OTA region is erased in the background, so that FLASH_Begin() doesn't stall the transfer
+ * for the several seconds that it takes to erase the entire region. FLASH_Update() only waits
+ * until the range it's about to write is erased.
+ */
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+    volatile uint32_t erased_end; /* High-water mark: [start, erased_end) is erased */
+    volatile uint32_t pending_end; /* End of the range that is being erased */
+    volatile bool active;
+    volatile unsigned generation;
+} ota_erase_state_t;
+
+static ota_erase_state_t s_ota_erase = {0};
+
+static void ota_erase_next(unsigned generation);
+
+static void ota_erase_done(int result, void* context)
+{
+    const unsigned generation = (unsigned)(uintptr_t)context;
+    bool next = false;
+    /* FLASH_Begin() may be restarting the erasure concurrently */
+    os_thread_scheduling(false, NULL);
+    if (generation == s_ota_erase.generation) {
+        if (!result) {
+            s_ota_erase.erased_end = s_ota_erase.pending_end;
+            next = true;
+        } else {
+            s_ota_erase.active = false;
+        }
+    }
+    os_thread_scheduling(true, NULL);
+    if (next) {
+        ota_erase_next(generation);
+    }
+}
+
+static void ota_erase_next(unsigned generation)
+{
+    const uint32_t addr = s_ota_erase.erased_end;
+    if (addr >= s_ota_erase.end) {
+        s_ota_erase.active = false;
+        return;
+    }
+    void* const context = (void*)(uintptr_t)generation;
+    int ret = 0;
+    /* A block erase is considerably faster than erasing its sectors one by one */
+    if (addr % OTA_ERASE_BLOCK_SIZE == 0 && s_ota_erase.end - addr >= OTA_ERASE_BLOCK_SIZE) {
+        s_ota_erase.pending_end = addr + OTA_ERASE_BLOCK_SIZE;
+        ret = hal_exflash_erase_block_async(addr, 1, ota_erase_done, context);
+    } else {
+        s_ota_erase.pending_end = addr + sFLASH_PAGESIZE;
+        ret = hal_exflash_erase_sector_async(addr, 1, ota_erase_done, context);
+    }
+    if (ret) {
+        s_ota_erase.active = false;
+    }
+}
+
+static bool ota_erase_begin(uint32_t address, uint32_t length)
+{
+    if (os_scheduler_get_state(NULL) != OS_SCHEDULER_STATE_RUNNING ||
+            !FLASH_CheckValidAddressRange(FLASH_SERIAL, address, length)) {
+        return false;
+    }
+    os_thread_scheduling(false, NULL);
+    const unsigned generation = ++s_ota_erase.generation;
+    s_ota_erase.start = address - address % sFLASH_PAGESIZE;
+    s_ota_erase.end = s_ota_erase.start + CEIL_DIV(address + length - s_ota_erase.start, sFLASH_PAGESIZE) * sFLASH_PAGESIZE;
+    s_ota_erase.erased_end = s_ota_erase.start;
+    s_ota_erase.pending_end = s_ota_erase.start;
+    s_ota_erase.active = true;
+    os_thread_scheduling(true, NULL);
+    ota_erase_next(generation);
+    return true;
+}
+
+static int ota_erase_wait(uint32_t address, uint32_t length)
+{
+    if (address < s_ota_erase.start || address >= s_ota_erase.end) {
+        return 0; /* Not part of the region being erased */
+    }
+    const uint32_t end = (address + length < s_ota_erase.end) ? address + length : s_ota_erase.end;
+    while (s_ota_erase.erased_end < end) {
+        if (!s_ota_erase.active) {
+            /* The background erasure has failed, erase the remaining part of the range synchronously */
+            const uint32_t from = s_ota_erase.erased_end;
+            const uint32_t sectors = CEIL_DIV(end - from, sFLASH_PAGESIZE);
+            if (hal_exflash_erase_sector(from, sectors) != 0) {
+                return -1;
+            }
+            s_ota_erase.erased_end = from + sectors * sFLASH_PAGESIZE;
+            break;
+        }
+        HAL_Delay_Milliseconds(1);
+    }
+    return 0;
+}
+
+#endif /* defined(USE_SERIAL_FLASH) && MODULE_FUNCTION != MOD_FUNC_BOOTLOADER */
+
 void FLASH_Begin(uint32_t FLASH_Address, uint32_t imageSize)
 {
     system_flags.OTA_FLASHED_Status_SysFlag = 0x0000;
     Save_SystemFlags();
 
 #ifdef USE_SERIAL_FLASH
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+    if (ota_erase_begin(FLASH_Address, imageSize)) {
+        return;
+    }
+#endif /* MODULE_FUNCTION != MOD_FUNC_BOOTLOADER */
     FLASH_EraseMemory(FLASH_SERIAL, FLASH_Address, imageSize);
 #else
     FLASH_EraseMemory(FLASH_INTERNAL, FLASH_Address, imageSize);
@@ -678,6 +860,11 @@ int FLASH_Update(const uint8_t *pBuffer, uint32_t address, uint32_t bufferSize)
 {
     int ret = -1;
 #ifdef USE_SERIAL_FLASH
+#if MODULE_FUNCTION != MOD_FUNC_BOOTLOADER
+    if (ota_erase_wait(address, bufferSize) != 0) {
+        return ret;
+    }
+#endif /* MODULE_FUNCTION != MOD_FUNC_BOOTLOADER */
     ret = hal_exflash_write(address, pBuffer, bufferSize);
 #else
     ret = hal_flash_write(address, pBuffer, bufferSize);
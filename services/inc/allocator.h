@@ -17,7 +17,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
 
 namespace particle {
 
@@ -56,4 +60,234 @@ public:
     }
 };
 
+/**
+ * Bump-pointer allocator serving memory from a fixed buffer.
+ *
+ * Allocation takes constant time and never uses the heap. Individual blocks are not reclaimed:
+ * the memory is released all at once with `reset()`, or down to a previously saved position
+ * with `rewind()`. The only exception is the most recently allocated block, which can be freed
+ * or resized in place.
+ *
+ * The allocator is meant for short-lived data, such as objects created and destroyed during a
+ * single iteration of the application loop. It is not thread-safe.
+ */
+class ArenaAllocator: public Allocator {
+public:
+    /**
+     * Alignment of the allocated blocks.
+     */
+    static const size_t ALIGNMENT = alignof(std::max_align_t);
+
+    /**
+     * Position in the arena.
+     *
+     * @see mark()
+     * @see rewind()
+     */
+    typedef size_t Marker;
+
+    /**
+     * Constructs an allocator.
+     *
+     * @param buf Buffer.
+     * @param size Size of the buffer.
+     */
+    ArenaAllocator(void* buf, size_t size) :
+            begin_(static_cast<uint8_t*>(buf)),
+            end_(begin_ + size),
+            top_(begin_),
+            last_(nullptr),
+            maxUsed_(0),
+            failures_(0) {
+        // Align the start of the buffer
+        const auto p = alignUp(reinterpret_cast<uintptr_t>(begin_));
+        begin_ = (p <= reinterpret_cast<uintptr_t>(end_)) ? reinterpret_cast<uint8_t*>(p) : end_;
+        top_ = begin_;
+    }
+
+    ArenaAllocator(const ArenaAllocator&) = delete;
+    ArenaAllocator& operator=(const ArenaAllocator&) = delete;
+
+    void* alloc(size_t size) override {
+        if (size > (size_t)(end_ - top_)) {
+            ++failures_;
+            return nullptr;
+        }
+        uint8_t* const p = top_;
+        setTop(p + size);
+        last_ = p;
+        return p;
+    }
+
+    void* realloc(void* ptr, size_t size) override {
+        if (!ptr) {
+            return alloc(size);
+        }
+        const auto p = static_cast<uint8_t*>(ptr);
+        if (p == last_ && size <= (size_t)(end_ - p)) {
+            // Resize the most recently allocated block in place
+            setTop(p + size);
+            return p;
+        }
+        void* const newPtr = alloc(size);
+        if (newPtr) {
+            // The size of the original block is not known, but the data following it belongs to
+            // the arena and can be safely copied
+            const size_t n = std::min<size_t>(size, static_cast<uint8_t*>(newPtr) - p);
+            memcpy(newPtr, p, n);
+        }
+        return newPtr;
+    }
+
+    void free(void* ptr) override {
+        if (ptr && ptr == last_) {
+            top_ = last_;
+            last_ = nullptr;
+        }
+    }
+
+    /**
+     * Releases all allocated memory.
+     */
+    void reset() {
+        top_ = begin_;
+        last_ = nullptr;
+    }
+
+    /**
+     * Returns the current position in the arena.
+     */
+    Marker mark() const {
+        return top_ - begin_;
+    }
+
+    /**
+     * Releases the memory allocated since a position was saved with `mark()`.
+     */
+    void rewind(Marker marker) {
+        if (marker < (size_t)(top_ - begin_)) {
+            top_ = begin_ + marker;
+            last_ = nullptr;
+        }
+    }
+
+    /**
+     * Returns the total size of the arena.
+     */
+    size_t size() const {
+        return end_ - begin_;
+    }
+
+    /**
+     * Returns the amount of memory allocated since the last reset.
+     */
+    size_t used() const {
+        return top_ - begin_;
+    }
+
+    /**
+     * Returns the amount of memory available for allocation.
+     */
+    size_t available() const {
+        return end_ - top_;
+    }
+
+    /**
+     * Returns the maximum amount of memory that has been allocated at the same time.
+     */
+    size_t maxUsed() const {
+        return maxUsed_;
+    }
+
+    /**
+     * Returns the number of allocations that failed due to insufficient memory.
+     */
+    size_t failures() const {
+        return failures_;
+    }
+
+private:
+    uint8_t* begin_;
+    uint8_t* end_;
+    uint8_t* top_;
+    uint8_t* last_; // Most recently allocated block
+    size_t maxUsed_;
+    size_t failures_;
+
+    void setTop(uint8_t* p) {
+        const auto t = alignUp(reinterpret_cast<uintptr_t>(p));
+        top_ = (t < reinterpret_cast<uintptr_t>(end_)) ? reinterpret_cast<uint8_t*>(t) : end_;
+        if ((size_t)(top_ - begin_) > maxUsed_) {
+            maxUsed_ = top_ - begin_;
+        }
+    }
+
+    static uintptr_t alignUp(uintptr_t p) {
+        return (p + ALIGNMENT - 1) & ~(uintptr_t)(ALIGNMENT - 1);
+    }
+};
+
+/**
+ * Arena allocator with a statically allocated buffer.
+ */
+template<size_t SizeT>
+class StaticArenaAllocator: public ArenaAllocator {
+public:
+    StaticArenaAllocator() :
+            ArenaAllocator(buf_, SizeT) {
+    }
+
+private:
+    alignas(std::max_align_t) uint8_t buf_[SizeT];
+};
+
+/**
+ * Scope guard that releases the memory allocated in an arena during its lifetime.
+ */
+class ArenaScope {
+public:
+    explicit ArenaScope(ArenaAllocator* arena) :
+            arena_(arena),
+            marker_(arena->mark()) {
+    }
+
+    ~ArenaScope() {
+        arena_->rewind(marker_);
+    }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    ArenaAllocator* arena_;
+    ArenaAllocator::Marker marker_;
+};
+
+/**
+ * Adapter for allocator instances with static storage duration, such as a global arena, that
+ * can be used as the allocator type of `spark::Vector`.
+ *
+ * Example:
+ * ```
+ * uint8_t g_buf[1024];
+ * particle::ArenaAllocator g_arena(g_buf, sizeof(g_buf));
+ *
+ * spark::Vector<int, particle::StaticAllocatorRef<particle::ArenaAllocator, g_arena>> v;
+ * ```
+ */
+template<typename AllocatorT, AllocatorT& allocator>
+struct StaticAllocatorRef {
+    static void* malloc(size_t size) {
+        return allocator.alloc(size);
+    }
+
+    static void* realloc(void* ptr, size_t size) {
+        return allocator.realloc(ptr, size);
+    }
+
+    static void free(void* ptr) {
+        allocator.free(ptr);
+    }
+};
+
 } // particle
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Asset image linked into the module (see build/assets.mk). The symbol is `nullptr` if the module
+ * has no assets.
+ */
+extern "C" const uint8_t particle_asset_image[] __attribute__((weak));
+
+namespace particle {
+
+/**
+ * Read-only image of packed assets.
+ *
+ * The image is generated by build/pack_assets.py from the files in the `ASSETS_DIR` directory and
+ * is linked into the module's read-only data, which resides in memory-mapped flash. Looking up an
+ * asset returns a pointer to its data in flash, so neither the index nor the data of the assets is
+ * ever copied to RAM.
+ *
+ * Image layout (all fields are little-endian, offsets are relative to the start of the image):
+ *
+ * - Header: magic number (4 bytes), format version (2 bytes), number of entries (2 bytes), size
+ *   of the image (4 bytes), reserved (4 bytes).
+ * - Entries sorted by name: offset of the name (4 bytes), offset of the data (4 bytes), size of
+ *   the data (4 bytes), reserved (4 bytes).
+ * - Null-terminated names of the assets.
+ * - Data of the assets. The data of every asset is aligned at an 8-byte boundary.
+ */
+class AssetImage {
+public:
+    static const uint32_t MAGIC = 0x54455341; // 'ASET'
+    static const uint16_t VERSION = 1;
+
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t count;
+        uint32_t size;
+        uint32_t reserved;
+    };
+
+    struct Entry {
+        uint32_t nameOffset;
+        uint32_t dataOffset;
+        uint32_t dataSize;
+        uint32_t reserved;
+    };
+
+    /**
+     * Constructs an image object.
+     *
+     * @param image Image data. If the data is not a valid image, the image is treated as empty.
+     */
+    explicit AssetImage(const void* image);
+
+    /**
+     * Finds an asset by name.
+     *
+     * @param name Asset name.
+     * @param[out] size Size of the asset data (can be `nullptr`).
+     * @return Pointer to the asset data, or `nullptr` if the asset is not found.
+     */
+    const uint8_t* find(const char* name, size_t* size = nullptr) const;
+
+    /**
+     * Returns the name of the asset with the specified index.
+     */
+    const char* name(size_t index) const;
+    /**
+     * Returns the data of the asset with the specified index.
+     *
+     * @param index Asset index.
+     * @param[out] size Size of the asset data (can be `nullptr`).
+     */
+    const uint8_t* data(size_t index, size_t* size = nullptr) const;
+
+    /**
+     * Returns the number of assets in the image.
+     */
+    size_t count() const;
+    /**
+     * Returns `true` if the image is valid.
+     */
+    bool isValid() const;
+
+    /**
+     * Returns the image linked into the calling module.
+     */
+    static AssetImage moduleImage();
+
+private:
+    const uint8_t* image_;
+    size_t count_;
+
+    const Entry& entry(size_t index) const;
+};
+
+inline AssetImage::AssetImage(const void* image) :
+        image_(nullptr),
+        count_(0) {
+    const auto h = static_cast<const Header*>(image);
+    if (h && h->magic == MAGIC && h->version == VERSION &&
+            h->size >= sizeof(Header) + h->count * sizeof(Entry)) {
+        image_ = static_cast<const uint8_t*>(image);
+        count_ = h->count;
+    }
+}
+
+inline const uint8_t* AssetImage::find(const char* name, size_t* size) const {
+    size_t first = 0;
+    size_t last = count_;
+    while (first < last) {
+        const size_t i = (first + last) / 2;
+        const int r = std::strcmp(name, this->name(i));
+        if (r == 0) {
+            return data(i, size);
+        }
+        if (r < 0) {
+            last = i;
+        } else {
+            first = i + 1;
+        }
+    }
+    return nullptr;
+}
+
+inline const char* AssetImage::name(size_t index) const {
+    return (const char*)image_ + entry(index).nameOffset;
+}
+
+inline const uint8_t* AssetImage::data(size_t index, size_t* size) const {
+    const Entry& e = entry(index);
+    if (size) {
+        *size = e.dataSize;
+    }
+    return image_ + e.dataOffset;
+}
+
+inline size_t AssetImage::count() const {
+    return count_;
+}
+
+inline bool AssetImage::isValid() const {
+    return image_ != nullptr;
+}
+
+inline AssetImage AssetImage::moduleImage() {
+    return AssetImage(particle_asset_image);
+}
+
+inline const AssetImage::Entry& AssetImage::entry(size_t index) const {
+    return reinterpret_cast<const Entry*>(image_ + sizeof(Header))[index];
+}
+
+} // namespace particle
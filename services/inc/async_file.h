@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "hal_platform.h"
+
+#if HAL_PLATFORM_FILESYSTEM
+
+#include "concurrent_hal.h"
+#include "intrusive_queue.h"
+
+#include <mutex>
+#include <cstddef>
+
+namespace particle {
+
+namespace fs {
+
+/**
+ * Callback invoked when an asynchronous file operation completes.
+ *
+ * @param result Number of bytes read or written, or a negative result code in case of an error.
+ * @param data User data.
+ */
+typedef void (*AsyncFileCallback)(int result, void* data);
+
+/**
+ * Executes filesystem operations in a dedicated thread, so that the calling threads don't have
+ * to wait for the flash.
+ *
+ * The requests are executed in the order they were submitted. Completion callbacks are invoked
+ * in the service thread and should not block.
+ *
+ * The data passed to `write()` and `append()` is copied, so the caller's buffer can be reused
+ * as soon as the function returns. Consecutive appends to the same file are collected in a
+ * write-behind buffer and written to the flash in a single operation.
+ *
+ * Small reads are served from a read-ahead buffer that is filled with the data following the
+ * last read. If the requested data is in the buffer and there are no pending requests, the read
+ * is completed, and the callback invoked, before `read()` returns.
+ */
+class AsyncFileService {
+public:
+    static const size_t WRITE_BEHIND_SIZE = 512;
+    static const size_t READ_AHEAD_SIZE = 512;
+
+    /**
+     * Read data from a file.
+     *
+     * @param path File path.
+     * @param offset Offset in the file.
+     * @param buf Destination buffer. The buffer must remain valid until the operation completes.
+     * @param size Number of bytes to read.
+     * @param callback Completion callback.
+     * @param data User data passed to the callback.
+     * @return 0 if the request has been submitted, or a negative result code in case of an error.
+     */
+    int read(const char* path, size_t offset, void* buf, size_t size, AsyncFileCallback callback, void* data);
+    /**
+     * Write data to a file at the specified offset. The file is created if it doesn't exist.
+     */
+    int write(const char* path, size_t offset, const void* buf, size_t size, AsyncFileCallback callback = nullptr,
+            void* data = nullptr);
+    /**
+     * Append data to a file. The file is created if it doesn't exist.
+     */
+    int append(const char* path, const void* buf, size_t size, AsyncFileCallback callback = nullptr, void* data = nullptr);
+    /**
+     * Remove a file.
+     */
+    int remove(const char* path, AsyncFileCallback callback = nullptr, void* data = nullptr);
+    /**
+     * Invoke the callback once all requests submitted so far have completed.
+     */
+    int sync(AsyncFileCallback callback, void* data = nullptr);
+
+    static AsyncFileService* instance();
+
+private:
+    enum class Op {
+        READ,
+        WRITE,
+        APPEND,
+        REMOVE,
+        SYNC
+    };
+
+    struct Request {
+        Op op;
+        char* path;
+        size_t offset;
+        char* buf;
+        size_t size;
+        size_t capacity;
+        AsyncFileCallback callback;
+        void* data;
+        // Appends collected in this request's write-behind buffer
+        IntrusiveQueue<Request> merged;
+        Request* next;
+    };
+
+    IntrusiveQueue<Request> queue_;
+    std::mutex mutex_;
+    os_thread_t thread_;
+    os_semaphore_t sem_;
+    bool busy_;
+
+    // Read-ahead buffer. Only accessed with the mutex locked
+    char* cachePath_;
+    size_t cacheOffset_;
+    size_t cacheSize_;
+    char cache_[READ_AHEAD_SIZE];
+
+    AsyncFileService();
+
+    int init();
+    int submit(Op op, const char* path, size_t offset, const void* buf, size_t size, AsyncFileCallback callback,
+            void* data);
+    bool readCached(const char* path, size_t offset, void* buf, size_t size);
+    void invalidateCache(const char* path);
+
+    void process(Request* req);
+    int readFile(Request* req);
+    int writeFile(Request* req);
+    void complete(Request* req, int result);
+
+    static void run(void* arg);
+    static void freeRequest(Request* req);
+};
+
+} // particle::fs
+
+} // particle
+
+#endif // HAL_PLATFORM_FILESYSTEM
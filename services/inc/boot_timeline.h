@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Boot timeline.
+ *
+ * The system records the time at which each startup stage is reached, in microseconds since the
+ * bootloader has handed control over to the system firmware. The timeline is kept in retained
+ * memory, so the timeline of the previous boot is still available after a reset, including a
+ * boot that didn't reach the application's `setup()`.
+ */
+
+/**
+ * Startup stages.
+ *
+ * The stages are not necessarily reached in this order.
+ */
+typedef enum boot_stage {
+    BOOT_STAGE_START = 0, ///< The system firmware got control from the bootloader.
+    BOOT_STAGE_HAL_CONFIG = 1, ///< `HAL_Core_Config()` completed.
+    BOOT_STAGE_FILESYSTEM_MOUNT = 2, ///< The filesystem is mounted.
+    BOOT_STAGE_DCT_LOAD = 3, ///< The DCT is loaded.
+    BOOT_STAGE_MODULE_INIT = 4, ///< The global constructors of the system modules have run.
+    BOOT_STAGE_NETWORK_INIT = 5, ///< The network interfaces are set up.
+    BOOT_STAGE_THREAD_START = 6, ///< The system and application threads are started.
+    BOOT_STAGE_SETUP = 7, ///< The application's `setup()` is called.
+    BOOT_STAGE_SETUP_DONE = 8, ///< The application's `setup()` returned.
+    BOOT_STAGE_COUNT = 9 ///< Number of stages.
+} boot_stage;
+
+/**
+ * Boot timeline.
+ */
+typedef struct boot_timeline {
+    uint32_t stages; ///< Bitmask of the recorded stages.
+    uint32_t time[BOOT_STAGE_COUNT]; ///< Time at which each stage was reached, in microseconds.
+} boot_timeline;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Records the time at which a startup stage is reached.
+ *
+ * Only the first time a stage is reached during a boot is recorded. Recording `BOOT_STAGE_START`
+ * moves the timeline to the one of the previous boot and starts a new timeline.
+ *
+ * @param stage Stage (see `boot_stage`).
+ * @param reserved Reserved argument. Must be set to `NULL`.
+ */
+void boot_timeline_mark(int stage, void* reserved);
+
+/**
+ * Gets the timeline of the current or previous boot.
+ *
+ * @param timeline Destination structure.
+ * @param previous If 0, the timeline of the current boot is returned. Otherwise, the timeline of
+ *        the previous boot is returned.
+ * @param reserved Reserved argument. Must be set to `NULL`.
+ * @return 0 on success, or `SYSTEM_ERROR_NOT_FOUND` if there's no timeline.
+ */
+int boot_timeline_get(boot_timeline* timeline, int previous, void* reserved);
+
+/**
+ * Returns the name of a startup stage.
+ */
+const char* boot_stage_name(int stage);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mpsc_queue.h"
+#include "system_tick_hal.h"
+#include "system_error.h"
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Macros implementing the body of a stackless coroutine.
+ *
+ * The body of `Coroutine::run()` must be enclosed in `CORO_BEGIN()` and `CORO_END()`. Every
+ * time the coroutine is resumed, `run()` is called again and jumps to the point where it was
+ * suspended, so local variables don't keep their values across the suspension points and
+ * the state of the coroutine needs to be stored in member variables. The suspension points
+ * can't be used in a nested `switch` statement, and there can be at most one of them per line.
+ */
+#define CORO_BEGIN() \
+        switch (this->coroLine_) { \
+        case 0:
+
+#define CORO_END() \
+        } \
+        this->coroFinish(0)
+
+// Resumes the coroutine in the next iteration of the scheduler
+#define CORO_YIELD() \
+        do { \
+            this->coroLine_ = __LINE__; \
+            this->coroYield(); \
+            return; \
+            case __LINE__:; \
+        } while (false)
+
+// Resumes the coroutine after the specified number of milliseconds
+#define CORO_SLEEP(_ms) \
+        do { \
+            this->coroLine_ = __LINE__; \
+            this->coroSleep(_ms); \
+            return; \
+            case __LINE__:; \
+        } while (false)
+
+// Resumes the coroutine once `Coroutine::wake()` is called
+#define CORO_SUSPEND() \
+        do { \
+            this->coroLine_ = __LINE__; \
+            this->coroSuspend(); \
+            return; \
+            case __LINE__:; \
+        } while (false)
+
+// Polls the condition in every iteration of the scheduler until it is true
+#define CORO_AWAIT(_cond) \
+        do { \
+            this->coroLine_ = __LINE__; \
+            case __LINE__: \
+            if (!(_cond)) { \
+                this->coroYield(); \
+                return; \
+            } \
+        } while (false)
+
+// Finishes the coroutine with the specified result code
+#define CORO_RETURN(_result) \
+        do { \
+            this->coroFinish(_result); \
+            return; \
+        } while (false)
+
+namespace particle {
+
+class CoroutineScheduler;
+
+/**
+ * Base class for stackless coroutines.
+ *
+ * A coroutine runs on the thread that calls `CoroutineScheduler::process()` and uses that
+ * thread's stack only while it is running, so any number of concurrent operations can share
+ * one stack. Example:
+ *
+ * ```
+ * class Blink: public Coroutine {
+ * protected:
+ *     void run() override {
+ *         CORO_BEGIN();
+ *         for (count_ = 0; count_ < 10; ++count_) {
+ *             toggleLed();
+ *             CORO_SLEEP(500);
+ *         }
+ *         CORO_END();
+ *     }
+ *
+ * private:
+ *     int count_;
+ * };
+ * ```
+ */
+class Coroutine: public MpscQueueNode {
+public:
+    Coroutine() :
+            nextRun_(nullptr),
+            sched_(nullptr),
+            coroLine_(0),
+            result_(0),
+            sleepTime_(0),
+            wakeTime_(0),
+            state_(IDLE),
+            woken_(false),
+            cancelled_(false) {
+    }
+
+    virtual ~Coroutine() = default;
+
+    /**
+     * Resumes the coroutine if it is suspended in `CORO_SUSPEND()`.
+     *
+     * If the coroutine is not suspended yet, its next `CORO_SUSPEND()` returns immediately.
+     * This method can be called from any thread or ISR.
+     */
+    void wake();
+
+    /**
+     * Requests the coroutine to be cancelled.
+     *
+     * The coroutine is finished with `SYSTEM_ERROR_CANCELLED` in the next iteration of the
+     * scheduler. This method can be called from any thread.
+     */
+    void cancel();
+
+    /**
+     * Returns `true` if the coroutine has been started and hasn't finished yet.
+     */
+    bool isActive() const {
+        return sched_ != nullptr;
+    }
+
+    /**
+     * Returns the result code of the finished coroutine.
+     */
+    int result() const {
+        return result_;
+    }
+
+protected:
+    /**
+     * Runs the coroutine until its next suspension point.
+     */
+    virtual void run() = 0;
+
+    /**
+     * Invoked by the scheduler when the coroutine has finished.
+     *
+     * The coroutine is no longer referenced by the scheduler at this point, so it can be
+     * destroyed or restarted.
+     */
+    virtual void finished() {
+    }
+
+    void coroYield() {
+        state_ = READY;
+    }
+
+    void coroSleep(system_tick_t ms) {
+        sleepTime_ = ms;
+        state_ = SLEEPING;
+    }
+
+    void coroSuspend() {
+        state_ = SUSPENDED;
+    }
+
+    void coroFinish(int result) {
+        result_ = result;
+        state_ = DONE;
+    }
+
+private:
+    enum State: uint8_t {
+        IDLE,
+        READY,
+        SLEEPING,
+        SUSPENDED,
+        DONE
+    };
+
+    Coroutine* nextRun_; // Next coroutine in the scheduler's list
+    CoroutineScheduler* volatile sched_;
+
+protected:
+    // Resumption point, maintained by the CORO_* macros
+    int coroLine_;
+
+private:
+    int result_;
+    system_tick_t sleepTime_;
+    system_tick_t wakeTime_;
+    State state_;
+    std::atomic<bool> woken_;
+    std::atomic<bool> cancelled_;
+
+    friend class CoroutineScheduler;
+};
+
+/**
+ * Runs coroutines on the thread that calls `process()`.
+ *
+ * The resolution of `CORO_SLEEP()` is that of the loop calling `process()`.
+ */
+class CoroutineScheduler {
+public:
+    // Callback invoked when a coroutine needs to be run, typically to wake up the thread
+    // running the scheduler. It may be called from an ISR
+    typedef void(*NotifyFunc)();
+
+    explicit CoroutineScheduler(NotifyFunc notify = nullptr) :
+            first_(nullptr),
+            last_(nullptr),
+            count_(0),
+            notify_(notify) {
+    }
+
+    CoroutineScheduler(const CoroutineScheduler&) = delete;
+    CoroutineScheduler& operator=(const CoroutineScheduler&) = delete;
+
+    /**
+     * Starts a coroutine.
+     *
+     * The coroutine is first run in the next iteration of the scheduler. This method can be
+     * called from any thread, but the coroutine must not be active.
+     *
+     * @return `SYSTEM_ERROR_NONE` on success, or `SYSTEM_ERROR_INVALID_STATE` if the coroutine
+     *         is already active.
+     */
+    int start(Coroutine* coro) {
+        if (coro->sched_) {
+            return SYSTEM_ERROR_INVALID_STATE;
+        }
+        coro->coroLine_ = 0;
+        coro->result_ = 0;
+        coro->state_ = Coroutine::READY;
+        coro->woken_ = false;
+        coro->cancelled_ = false;
+        coro->sched_ = this;
+        if (incoming_.push(coro)) {
+            notify();
+        }
+        return SYSTEM_ERROR_NONE;
+    }
+
+    /**
+     * Resumes the coroutines that are ready to run.
+     *
+     * This method must be called periodically from the thread running the scheduler.
+     *
+     * @return `true` if any coroutine has been resumed.
+     */
+    bool process(system_tick_t now) {
+        Coroutine* coro = nullptr;
+        while ((coro = incoming_.pop())) {
+            coro->nextRun_ = nullptr;
+            if (last_) {
+                last_->nextRun_ = coro;
+            } else {
+                first_ = coro;
+            }
+            last_ = coro;
+            ++count_;
+        }
+        bool resumed = false;
+        bool ready = false;
+        Coroutine* prev = nullptr;
+        coro = first_;
+        while (coro) {
+            const auto next = coro->nextRun_;
+            if (coro->cancelled_.exchange(false)) {
+                coro->coroFinish(SYSTEM_ERROR_CANCELLED);
+            } else if (isRunnable(coro, now)) {
+                coro->run();
+                resumed = true;
+                if (coro->state_ == Coroutine::SLEEPING) {
+                    coro->wakeTime_ = now + coro->sleepTime_;
+                }
+            }
+            if (coro->state_ == Coroutine::DONE) {
+                if (prev) {
+                    prev->nextRun_ = next;
+                } else {
+                    first_ = next;
+                }
+                if (last_ == coro) {
+                    last_ = prev;
+                }
+                --count_;
+                coro->sched_ = nullptr;
+                // The coroutine may be destroyed by the callback
+                coro->finished();
+            } else {
+                if (coro->state_ == Coroutine::READY) {
+                    ready = true;
+                }
+                prev = coro;
+            }
+            coro = next;
+        }
+        if (ready) {
+            // Don't let the thread wait for the next iteration
+            notify();
+        }
+        return resumed;
+    }
+
+    /**
+     * Returns the number of active coroutines, not counting the ones that have been started
+     * since the last call to `process()`.
+     */
+    unsigned count() const {
+        return count_;
+    }
+
+private:
+    MpscQueue<Coroutine> incoming_; // Started coroutines
+    Coroutine* first_;
+    Coroutine* last_;
+    unsigned count_;
+    NotifyFunc notify_;
+
+    void notify() {
+        if (notify_) {
+            notify_();
+        }
+    }
+
+    static bool isRunnable(Coroutine* coro, system_tick_t now) {
+        switch (coro->state_) {
+        case Coroutine::READY:
+            return true;
+        case Coroutine::SLEEPING:
+            return (int32_t)(now - coro->wakeTime_) >= 0;
+        case Coroutine::SUSPENDED:
+            return coro->woken_.exchange(false);
+        default:
+            return false;
+        }
+    }
+
+    friend class Coroutine;
+};
+
+inline void Coroutine::wake() {
+    woken_ = true;
+    const auto sched = sched_;
+    if (sched) {
+        sched->notify();
+    }
+}
+
+inline void Coroutine::cancel() {
+    cancelled_ = true;
+    const auto sched = sched_;
+    if (sched) {
+        sched->notify();
+    }
+}
+
+} // particle
@@ -19,6 +19,8 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 /**
  * Emulates rewritable storage using two flash blocks.
@@ -74,6 +76,13 @@
  *
  * After the write operation, the sector is validated. If it is not valid, the write is reattempted up to 3 times.
  * If the write continues to fail a failure code is returned.
+ *
+ * Transactions:
+ * Every write rewrites the whole alternate sector, so updating several fields one after another
+ * costs one erase per field. Writes made between begin() and commit() are instead collected in RAM
+ * and applied with a single sector rewrite when the transaction is committed. Since the new sector
+ * only becomes valid once it has been completely written, the fields are updated atomically: after a
+ * power failure either all or none of them are changed.
  */
 
 template <typename Store, unsigned sectorSize, unsigned DCD1, unsigned DCD2, uint32_t(*calculateCRC)(const void* data, size_t len)>
@@ -227,6 +236,23 @@ public:
     static const Sector Sector_Unknown = 255;
 
 protected:
+    /**
+     * Describes a write that is deferred until the current transaction is committed.
+     * The data being written follows the header in the patch buffer.
+     */
+    struct PatchHeader
+    {
+        Address offset;
+        Address length;
+    };
+
+    /**
+     * Deferred writes of the current transaction.
+     */
+    uint8_t* patches = nullptr;
+    size_t patchSize = 0;
+    unsigned transactionDepth = 0;
+
     /**
      * Retrieve the address of a given sector.
      */
@@ -410,9 +436,78 @@ protected:
 		return sector0;	// both are equally valid - could do a 50/50 random choice here
     }
 
+    /**
+     * Appends a deferred write to the patch buffer. Returns false if there is not enough memory.
+     */
+    bool addPatch(const Address offset, const void* data, size_t length)
+    {
+        const size_t size = patchSize+sizeof(PatchHeader)+length;
+        uint8_t* buf = static_cast<uint8_t*>(realloc(patches, size));
+        if (!buf)
+            return false;
+        PatchHeader patch = { offset, Address(length) };
+        memcpy(buf+patchSize, &patch, sizeof(patch));
+        memcpy(buf+patchSize+sizeof(patch), data, length);
+        patches = buf;
+        patchSize = size;
+        return true;
+    }
+
+    void discardPatches()
+    {
+        free(patches);
+        patches = nullptr;
+        patchSize = 0;
+    }
+
+    /**
+     * Applies the deferred writes to a chunk of logical data starting at the given offset.
+     * The writes are applied in the order in which they were made.
+     */
+    void applyPatches(const Address offset, uint8_t* data, size_t length)
+    {
+        size_t pos = 0;
+        while (pos<patchSize)
+        {
+            PatchHeader patch;
+            memcpy(&patch, patches+pos, sizeof(patch));
+            const uint8_t* patchData = patches+pos+sizeof(patch);
+            pos += sizeof(patch)+patch.length;
+            const Address start = (patch.offset>offset) ? patch.offset : offset;
+            const Address end = (patch.offset+patch.length<offset+length) ? patch.offset+patch.length : offset+length;
+            if (start<end)
+                memcpy(data+(start-offset), patchData+(start-patch.offset), end-start);
+        }
+    }
+
+    /**
+     * Writes all deferred writes to the alternate sector and invalidates the current one.
+     */
+    Result writePatches()
+    {
+        if (!patchSize)
+            return DCD_SUCCESS;
+        Sector current = currentValidSector();
+        Sector newSector = alternateSectorTo(current);
+        const uint8_t* existing = store.dataAt(addressOf(current));
+        Result error = this->_writePatchedSector(existing, newSector);
+        discardPatches();
+        if (error) return error;
+
+        Header header;
+        header.makeInvalid();
+        error = write(current, header);
+        return error;
+    }
+
 public:
     DCD() = default;
 
+    ~DCD()
+    {
+        discardPatches();
+    }
+
     bool isInitialized()
     {
         return isValid(Sector_1) || isValid(Sector_0);
@@ -473,6 +568,8 @@ public:
      */
     const uint8_t* read(const Address offset)
     {
+        // the returned pointer refers to flash, so make sure it contains the latest data
+        writePatches();
         Sector current = currentValidSector();
         const Header& header = sectorHeader(current);
         Address location = addressOf(current)+header.size()+offset;
@@ -496,6 +593,15 @@ public:
         if (!length)
             return DCD_SUCCESS;
 
+        if (transactionDepth) {
+            if (addPatch(offset, data, length))
+                return DCD_SUCCESS;
+            // not enough memory to defer the write - write out what has been collected so far
+            // and fall back to writing the data directly
+            Result error = writePatches();
+            if (error) return error;
+        }
+
         Sector current = currentValidSector();
         Sector newSector = alternateSectorTo(current);
         const uint8_t* existing = store.dataAt(addressOf(current));
@@ -508,6 +614,41 @@ public:
         return error;
     }
 
+    /**
+     * Start a transaction. Data written until the transaction is committed is collected in RAM and written
+     * to flash with a single sector rewrite. Transactions can be nested, in which case the data is written
+     * when the outermost transaction is committed.
+     *
+     * Reading data while a transaction is in progress writes the data collected so far, since the data is
+     * read directly from flash.
+     */
+    void begin()
+    {
+        ++transactionDepth;
+    }
+
+    /**
+     * Commit the current transaction.
+     * @return	The result of the write operation. DCD_SUCCESS means all data written in the transaction
+     * was written successfully.
+     */
+    Result commit()
+    {
+        if (!transactionDepth || --transactionDepth)
+            return DCD_SUCCESS;
+        return writePatches();
+    }
+
+    /**
+     * Abandon the current transaction, including any enclosing transactions. Data written since the
+     * transaction was started and not yet written to flash is discarded.
+     */
+    void rollback()
+    {
+        transactionDepth = 0;
+        discardPatches();
+    }
+
     /**
      * Perform a rewrite of a sector.
      *
@@ -523,7 +664,6 @@ public:
         if (error) return error;
 
         const Header& existingHeader = *(reinterpret_cast<const Header*>(existing));
-        	const Footer& existingFooter = *(reinterpret_cast<const Footer*>(existing+footerOffset));
 
 		Address destination = addressOf(newSector);
         Address writeOffset = sizeof(Header);
@@ -549,6 +689,53 @@ public:
             if (error) return error;
         }
 
+        return _sealSector(existing, newSector);
+    }
+
+    /**
+     * Perform a rewrite of a sector applying all deferred writes of the current transaction.
+     *
+     * @param existing	A pointer to the existing sector
+     * @param newSector	The new sector to write the data to
+     */
+    Result _writePatchedSector(const uint8_t* existing, Sector newSector)
+    {
+        Result error = erase(newSector);
+        if (error) return error;
+
+        const Address destination = addressOf(newSector)+sizeof(Header);
+        const uint8_t* source = existing+sizeof(Header);
+        uint8_t buf[64];
+        for (Address offset = 0; offset<Length; offset += sizeof(buf))
+        {
+            const size_t length = (Length-offset<sizeof(buf)) ? Length-offset : sizeof(buf);
+            memcpy(buf, source+offset, length);
+            applyPatches(offset, buf, length);
+            // the sector is erased, so there's no need to write unprogrammed bytes
+            size_t i = 0;
+            while (i<length && buf[i]==0xFF)
+                ++i;
+            if (i<length) {
+                error = store.write(destination+offset, buf, length);
+                if (error) return error;
+            }
+        }
+
+        return _sealSector(existing, newSector);
+    }
+
+    /**
+     * Write the footer, the CRC and the valid header to a sector once its data has been written.
+     *
+     * @param existing	A pointer to the existing sector, or nullptr
+     * @param newSector	The sector being written
+     */
+    Result _sealSector(const uint8_t* existing, Sector newSector)
+    {
+        const Footer& existingFooter = *(reinterpret_cast<const Footer*>(existing+footerOffset));
+        const Address destination = addressOf(newSector);
+        Result error;
+
         uint8_t counter = 0;
         if (existing && existingFooter.isValid()) {
             counter = uint8_t((existingFooter.counter() + 1) & 3);
@@ -556,7 +743,7 @@ public:
         error = _write_v2_footer(newSector, (existing && existingFooter.isValid()) ? &existingFooter : nullptr, counter);
         if (error) return error;
         typename Footer::crc_type crc = computeSectorCRC(newSector);
-        writeOffset = sectorSize-sizeof(typename Footer::crc_type);
+        const Address writeOffset = sectorSize-sizeof(typename Footer::crc_type);
         error = store.write(destination+writeOffset, &crc, sizeof(crc));
         if (error) return error;
 		Header header;
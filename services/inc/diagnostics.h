@@ -56,8 +56,58 @@
 #define DIAG_NAME_CLOUD_REPEATED_MESSAGES "coap:resend"
 #define DIAG_NAME_CLOUD_UNACKNOWLEDGED_MESSAGES "coap:unack"
 #define DIAG_NAME_CLOUD_RATE_LIMITED_EVENTS "pub:limit"
+#define DIAG_NAME_CLOUD_EVENT_TOKENS "pub:tokens"
+#define DIAG_NAME_CLOUD_DEFERRED_EVENTS "pub:defer"
+#define DIAG_NAME_CLOUD_RESUMED_SESSIONS "cloud:resume"
+#define DIAG_NAME_CLOUD_FULL_HANDSHAKES "cloud:fullhs"
+#define DIAG_NAME_NETWORK_LWIP_PBUF_POOL_MAX_USED "net:lwip:pbufmax"
+#define DIAG_NAME_NETWORK_LWIP_POOL_ERRORS "net:lwip:poolerr"
+#define DIAG_NAME_SYSTEM_THREAD_QUEUE_DEPTH "sys:thr:qdepth"
+#define DIAG_NAME_SYSTEM_THREAD_QUEUE_MAX_WAIT "sys:thr:qwait"
+#define DIAG_NAME_SYSTEM_THREAD_QUEUE_MAX_HIGH_WAIT "sys:thr:qhwait"
+#define DIAG_NAME_SYSTEM_ISR_TASK_QUEUE_MAX_SIZE "sys:isrq:max"
+#define DIAG_NAME_SYSTEM_ISR_TASK_QUEUE_DEFERRALS "sys:isrq:defer"
+#define DIAG_NAME_SYSTEM_CPU_USAGE "sys:cpu:usage"
+#define DIAG_NAME_SYSTEM_THREAD_CPU_USAGE "sys:thr:cpu"
+#define DIAG_NAME_SYSTEM_STACK_FREE_MIN "sys:stk:min"
 #define DIAG_NAME_SYSTEM_TOTAL_RAM "sys:tram"
 #define DIAG_NAME_SYSTEM_USED_RAM "sys:uram"
+#define DIAG_NAME_CLOUD_COAP_ROUND_TRIP_TIME "coap:rtt"
+#define DIAG_NAME_CLOUD_HANDSHAKE_TIME "cloud:hstime"
+#define DIAG_NAME_CLOUD_PUBLISH_TIME "pub:time"
+#define DIAG_NAME_NETWORK_NCP_AT_COMMAND_TIME "net:ncp:attime"
+#define DIAG_NAME_CAN_RX_QUEUE_OVERFLOWS "can:rxovf"
+#define DIAG_NAME_CAN_RX_FIFO_OVERRUNS "can:fifoovr"
+#define DIAG_NAME_CLOUD_BYTES_SENT "cloud:txbytes"
+#define DIAG_NAME_CLOUD_BYTES_RECEIVED "cloud:rxbytes"
+#define DIAG_NAME_SYSTEM_LARGEST_FREE_BLOCK "mem:maxblk"
+#define DIAG_NAME_SYSTEM_FREE_BLOCKS "mem:freeblk"
+#define DIAG_NAME_SYSTEM_USER_HEAP "mem:user"
+#define DIAG_NAME_SYSTEM_BOOT_TIME "sys:boottime"
+#define DIAG_NAME_SYSTEM_REPORT_CYCLE_TIME "sys:cycletime"
+#define DIAG_NAME_NETWORK_MESH_RADIO_DUTY_CYCLE "net:mesh:rduty"
+#define DIAG_NAME_CLOUD_EXPIRED_EVENTS "pub:expired"
+#define DIAG_NAME_CLOUD_EVENT_BYTES_SENT "cloud:txbytes:evt"
+#define DIAG_NAME_CLOUD_EVENT_BYTES_RECEIVED "cloud:rxbytes:evt"
+#define DIAG_NAME_CLOUD_FUNCTION_BYTES_SENT "cloud:txbytes:func"
+#define DIAG_NAME_CLOUD_FUNCTION_BYTES_RECEIVED "cloud:rxbytes:func"
+#define DIAG_NAME_CLOUD_VARIABLE_BYTES_SENT "cloud:txbytes:var"
+#define DIAG_NAME_CLOUD_VARIABLE_BYTES_RECEIVED "cloud:rxbytes:var"
+#define DIAG_NAME_CLOUD_DESCRIBE_BYTES_SENT "cloud:txbytes:desc"
+#define DIAG_NAME_CLOUD_DESCRIBE_BYTES_RECEIVED "cloud:rxbytes:desc"
+#define DIAG_NAME_CLOUD_PING_BYTES_SENT "cloud:txbytes:ping"
+#define DIAG_NAME_CLOUD_PING_BYTES_RECEIVED "cloud:rxbytes:ping"
+#define DIAG_NAME_CLOUD_OTA_BYTES_SENT "cloud:txbytes:ota"
+#define DIAG_NAME_CLOUD_OTA_BYTES_RECEIVED "cloud:rxbytes:ota"
+#define DIAG_NAME_CLOUD_HANDSHAKE_BYTES_SENT "cloud:txbytes:hs"
+#define DIAG_NAME_CLOUD_HANDSHAKE_BYTES_RECEIVED "cloud:rxbytes:hs"
+#define DIAG_NAME_CLOUD_OTHER_BYTES_SENT "cloud:txbytes:other"
+#define DIAG_NAME_CLOUD_OTHER_BYTES_RECEIVED "cloud:rxbytes:other"
+#define DIAG_NAME_SYSTEM_APPLICATION_LOOP_TIME "app:looptime"
+#define DIAG_NAME_SYSTEM_APPLICATION_LOOP_MAX_TIME "app:loopmax"
+#define DIAG_NAME_SYSTEM_APPLICATION_USER_TIME "app:usertime"
+#define DIAG_NAME_SYSTEM_IDLE_EVENTS_TIME "sys:idletime"
+#define DIAG_NAME_SYSTEM_APPLICATION_LOOP_OVERRUNS "app:overrun"
 
 #ifdef __cplusplus
 extern "C" {
@@ -93,6 +143,8 @@ typedef enum diag_id {
     DIAG_ID_NETWORK_CELLULAR_CELL_GLOBAL_IDENTITY_MOBILE_NETWORK_CODE = 41, // net:cell:cgi:mnc
     DIAG_ID_NETWORK_CELLULAR_CELL_GLOBAL_IDENTITY_LOCATION_AREA_CODE = 42, // net:cell:cgi:lac
     DIAG_ID_NETWORK_CELLULAR_CELL_GLOBAL_IDENTITY_CELL_ID = 43, // net:cell:cgi:ci
+    DIAG_ID_NETWORK_LWIP_PBUF_POOL_MAX_USED = 48, // net:lwip:pbufmax
+    DIAG_ID_NETWORK_LWIP_POOL_ERRORS = 49, // net:lwip:poolerr
     DIAG_ID_CLOUD_CONNECTION_STATUS = 10, // cloud:stat
     DIAG_ID_CLOUD_CONNECTION_ERROR_CODE = 13, // cloud:err
     DIAG_ID_CLOUD_DISCONNECTS = 14, // cloud:dconn
@@ -101,16 +153,76 @@ typedef enum diag_id {
     DIAG_ID_CLOUD_REPEATED_MESSAGES = 21, // coap:resend
     DIAG_ID_CLOUD_UNACKNOWLEDGED_MESSAGES = 22, // coap:unack
     DIAG_ID_CLOUD_RATE_LIMITED_EVENTS = 20, // pub:throttle
+    DIAG_ID_CLOUD_EVENT_TOKENS = 44, // pub:tokens
+    DIAG_ID_CLOUD_DEFERRED_EVENTS = 45, // pub:defer
+    DIAG_ID_CLOUD_RESUMED_SESSIONS = 46, // cloud:resume
+    DIAG_ID_CLOUD_FULL_HANDSHAKES = 47, // cloud:fullhs
+    DIAG_ID_SYSTEM_THREAD_QUEUE_DEPTH = 50, // sys:thr:qdepth
+    DIAG_ID_SYSTEM_THREAD_QUEUE_MAX_WAIT = 51, // sys:thr:qwait
+    DIAG_ID_SYSTEM_THREAD_QUEUE_MAX_HIGH_WAIT = 52, // sys:thr:qhwait
+    DIAG_ID_SYSTEM_ISR_TASK_QUEUE_MAX_SIZE = 53, // sys:isrq:max
+    DIAG_ID_SYSTEM_ISR_TASK_QUEUE_DEFERRALS = 54, // sys:isrq:defer
+    DIAG_ID_SYSTEM_CPU_USAGE = 55, // sys:cpu:usage
+    DIAG_ID_SYSTEM_THREAD_CPU_USAGE = 56, // sys:thr:cpu
+    DIAG_ID_SYSTEM_STACK_FREE_MIN = 57, // sys:stk:min
     DIAG_ID_SYSTEM_TOTAL_RAM = 25, // sys:tram
     DIAG_ID_SYSTEM_USED_RAM = 26, // sys:uram
+    DIAG_ID_CLOUD_COAP_ROUND_TRIP_TIME = 58, // coap:rtt
+    DIAG_ID_CLOUD_HANDSHAKE_TIME = 59, // cloud:hstime
+    DIAG_ID_CLOUD_PUBLISH_TIME = 60, // pub:time
+    DIAG_ID_NETWORK_NCP_AT_COMMAND_TIME = 61, // net:ncp:attime
+    DIAG_ID_CAN_RX_QUEUE_OVERFLOWS = 62, // can:rxovf
+    DIAG_ID_CAN_RX_FIFO_OVERRUNS = 63, // can:fifoovr
+    DIAG_ID_CLOUD_BYTES_SENT = 64, // cloud:txbytes
+    DIAG_ID_CLOUD_BYTES_RECEIVED = 65, // cloud:rxbytes
+    DIAG_ID_SYSTEM_LARGEST_FREE_BLOCK = 66, // mem:maxblk
+    DIAG_ID_SYSTEM_FREE_BLOCKS = 67, // mem:freeblk
+    DIAG_ID_SYSTEM_USER_HEAP = 68, // mem:user
+    DIAG_ID_SYSTEM_BOOT_TIME = 69, // sys:boottime
+    DIAG_ID_SYSTEM_REPORT_CYCLE_TIME = 70, // sys:cycletime
+    DIAG_ID_NETWORK_MESH_RADIO_DUTY_CYCLE = 71, // net:mesh:rduty
+    DIAG_ID_CLOUD_EXPIRED_EVENTS = 72, // pub:expired
+    DIAG_ID_CLOUD_EVENT_BYTES_SENT = 73, // cloud:txbytes:evt
+    DIAG_ID_CLOUD_EVENT_BYTES_RECEIVED = 74, // cloud:rxbytes:evt
+    DIAG_ID_CLOUD_FUNCTION_BYTES_SENT = 75, // cloud:txbytes:func
+    DIAG_ID_CLOUD_FUNCTION_BYTES_RECEIVED = 76, // cloud:rxbytes:func
+    DIAG_ID_CLOUD_VARIABLE_BYTES_SENT = 77, // cloud:txbytes:var
+    DIAG_ID_CLOUD_VARIABLE_BYTES_RECEIVED = 78, // cloud:rxbytes:var
+    DIAG_ID_CLOUD_DESCRIBE_BYTES_SENT = 79, // cloud:txbytes:desc
+    DIAG_ID_CLOUD_DESCRIBE_BYTES_RECEIVED = 80, // cloud:rxbytes:desc
+    DIAG_ID_CLOUD_PING_BYTES_SENT = 81, // cloud:txbytes:ping
+    DIAG_ID_CLOUD_PING_BYTES_RECEIVED = 82, // cloud:rxbytes:ping
+    DIAG_ID_CLOUD_OTA_BYTES_SENT = 83, // cloud:txbytes:ota
+    DIAG_ID_CLOUD_OTA_BYTES_RECEIVED = 84, // cloud:rxbytes:ota
+    DIAG_ID_CLOUD_HANDSHAKE_BYTES_SENT = 85, // cloud:txbytes:hs
+    DIAG_ID_CLOUD_HANDSHAKE_BYTES_RECEIVED = 86, // cloud:rxbytes:hs
+    DIAG_ID_CLOUD_OTHER_BYTES_SENT = 87, // cloud:txbytes:other
+    DIAG_ID_CLOUD_OTHER_BYTES_RECEIVED = 88, // cloud:rxbytes:other
+    DIAG_ID_SYSTEM_APPLICATION_LOOP_TIME = 89, // app:looptime
+    DIAG_ID_SYSTEM_APPLICATION_LOOP_MAX_TIME = 90, // app:loopmax
+    DIAG_ID_SYSTEM_APPLICATION_USER_TIME = 91, // app:usertime
+    DIAG_ID_SYSTEM_IDLE_EVENTS_TIME = 92, // sys:idletime
+    DIAG_ID_SYSTEM_APPLICATION_LOOP_OVERRUNS = 93, // app:overrun
     DIAG_ID_USER = 32768 // Base value for application-specific source IDs
 } diag_id;
 
 // Data types
 typedef enum diag_type {
-    DIAG_TYPE_INT = 1 // 32-bit integer
+    DIAG_TYPE_INT = 1, // 32-bit integer
+    DIAG_TYPE_HISTOGRAM = 2 // Histogram (diag_histogram)
 } diag_type;
 
+#define DIAG_HISTOGRAM_BUCKET_COUNT 20
+
+// Histogram of unsigned integer samples with logarithmic buckets: bucket 0 counts zero values,
+// bucket N counts values in the range [2^(N-1), 2^N), and the last bucket also counts all larger
+// values. The counters are cumulative and are allowed to wrap around, so the samples collected
+// between two reports can be obtained by subtracting the earlier counters from the later ones
+typedef struct diag_histogram {
+    uint32_t sum; // Sum of all samples
+    uint32_t buckets[DIAG_HISTOGRAM_BUCKET_COUNT]; // Number of samples in each bucket
+} diag_histogram;
+
 // Data source commands
 typedef enum diag_source_cmd {
     DIAG_SOURCE_CMD_GET = 1 // Get current data
@@ -21,6 +21,7 @@
  */
 
 #include <cstring>
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <limits>
@@ -89,6 +90,23 @@
  * not call performPendingErase() before the next page swap, the
  * alternate page will be erased just before the page swap.
  *
+ * A copy of the EEPROM contents is kept in RAM so that reads don't need
+ * to go through the list of records. Each value that differs from the
+ * one stored in Flash is marked as pending, and flush() writes records
+ * for all pending values using the same atomic algorithm as for a multi
+ * byte write. When a page swap is needed, the values are copied from
+ * RAM instead of the old page.
+ *
+ * By default, put() flushes the changes immediately. When write-back
+ * caching is enabled with setWriteBack(), put() only updates the RAM
+ * copy and the application (or the HAL) calls flush() when convenient,
+ * so that values that change frequently (counters for example) don't
+ * wear out the Flash and don't block the application on every change.
+ * Pending changes are lost in case of a reset.
+ *
+ * If there's not enough RAM for the copy, reads and writes go to Flash
+ * directly and write-back caching is not available.
+ *
  */
 
 template <typename Store, uintptr_t PageBase1, size_t PageSize1, uintptr_t PageBase2, size_t PageSize2>
@@ -179,20 +197,29 @@ public:
         {
             clear();
         }
+
+        initCache();
     }
 
     // Read the latest value of a byte of EEPROM in data or 0xFF if the
     // value was not programmed
     void get(Index index, Data &data)
     {
-        readRange(index, &data, sizeof(data));
+        get(index, &data, sizeof(data));
     }
 
     // Reads the latest valid values of a block of EEPROM into data.
     // Fills data with 0xFF for values that were not programmed
     void get(Index index, void *data, uint16_t length)
     {
-        readRange(index, (Data *)data, length);
+        if(cache)
+        {
+            readCache(index, (Data *)data, length);
+        }
+        else
+        {
+            readRange(index, (Data *)data, length);
+        }
     }
 
     // Writes a new value for a byte of EEPROM
@@ -200,7 +227,7 @@ public:
     // if the current page is full
     void put(Index index, Data data)
     {
-        writeRange(index, &data, sizeof(data));
+        put(index, &data, sizeof(data));
     }
 
     // Writes new values for a block of EEPROM
@@ -211,7 +238,82 @@ public:
     // if the current page is full
     void put(Index index, const void *data, uint16_t length)
     {
-        writeRange(index, (Data *)data, length);
+        if(cache)
+        {
+            writeCache(index, (const Data *)data, length);
+        }
+        else
+        {
+            writeRange(index, (const Data *)data, length);
+        }
+    }
+
+    // Writes all the pending changes to Flash. The changes are written
+    // atomically: either all of them will be read back or none will
+    // be, even if a reset occurs during the write
+    //
+    // Returns false if the changes couldn't be written. In that case
+    // the changes are discarded so that reads return the values stored
+    // in Flash
+    bool flush()
+    {
+        if(dirtyCount == 0)
+        {
+            return true;
+        }
+
+        Address writeAddressBegin;
+        Data unused;
+
+        // Make sure there are no previous invalid records before
+        // starting to write
+        bool success = readRangeAndFindEmpty(getActivePage(), &unused, 0, 0, writeAddressBegin);
+
+        success = success && writeDirtyRecords(writeAddressBegin);
+
+        // If any writes failed because the page was full or a marginal
+        // write error occured, do a page swap
+        if(!success)
+        {
+            success = swapPagesAndWriteCache();
+        }
+
+        if(!success)
+        {
+            readRange(0, cache.get(), capacity());
+        }
+
+        clearDirty();
+
+        return success;
+    }
+
+    // Enables or disables write-back caching
+    //
+    // Returns false if there's not enough memory for the RAM copy of
+    // the EEPROM, or if the pending changes couldn't be written when
+    // disabling the caching
+    bool setWriteBack(bool enabled)
+    {
+        if(!enabled)
+        {
+            writeBack = false;
+            return flush();
+        }
+
+        if(!cache)
+        {
+            return false;
+        }
+
+        writeBack = true;
+        return true;
+    }
+
+    // Check if some changes have not been written to Flash yet
+    bool hasPendingWrite() const
+    {
+        return dirtyCount > 0;
     }
 
     // Destroys all the data 💣
@@ -222,6 +324,12 @@ public:
         writePageStatus(LogicalPage::Page1, PageHeader::ACTIVE);
 
         updateActivePage();
+
+        if(cache)
+        {
+            std::memset(cache.get(), FLASH_ERASED, capacity());
+            clearDirty();
+        }
     }
 
     // Returns number of bytes that can be stored in EEPROM
@@ -737,6 +845,166 @@ public:
         return success;
     }
 
+    // Allocate the RAM copy of the EEPROM and fill it with the values
+    // stored in the active page
+    void initCache()
+    {
+        if(!cache)
+        {
+            cache.reset(new Data[capacity()]);
+            dirty.reset(new uint8_t[(capacity() + 7) / 8]);
+
+            // Use the Flash directly if memory is full
+            if(!cache || !dirty)
+            {
+                cache.reset();
+                dirty.reset();
+                writeBack = false;
+                return;
+            }
+        }
+
+        readRange(0, cache.get(), capacity());
+        clearDirty();
+    }
+
+    // Copy a range of values from the RAM copy of the EEPROM. Fills
+    // data with 0xFF for indexes that are out of range
+    void readCache(Index indexBegin, Data *data, uint16_t length)
+    {
+        std::memset(data, FLASH_ERASED, length);
+
+        if(indexBegin < capacity())
+        {
+            size_t count = std::min<size_t>(length, capacity() - indexBegin);
+            std::memcpy(data, cache.get() + indexBegin, count);
+        }
+    }
+
+    // Update a range of values in the RAM copy of the EEPROM and mark
+    // the changed ones as pending
+    void writeCache(Index indexBegin, const Data *data, uint16_t length)
+    {
+        // don't write anything if index is out of range
+        if((size_t)indexBegin + length > capacity())
+        {
+            return;
+        }
+
+        for(uint16_t i = 0; i < length; i++)
+        {
+            Index index = indexBegin + i;
+            if(cache[index] != data[i])
+            {
+                cache[index] = data[i];
+                markDirty(index);
+            }
+        }
+
+        if(!writeBack)
+        {
+            flush();
+        }
+    }
+
+    bool isDirty(Index index) const
+    {
+        return dirty[index / 8] & (1 << (index % 8));
+    }
+
+    void markDirty(Index index)
+    {
+        if(!isDirty(index))
+        {
+            dirty[index / 8] |= (1 << (index % 8));
+            dirtyCount++;
+        }
+    }
+
+    void clearDirty()
+    {
+        std::memset(dirty.get(), 0, (capacity() + 7) / 8);
+        dirtyCount = 0;
+    }
+
+    // Write records for all pending values backwards in Flash, the same
+    // way writeRangeChanged() does
+    bool writeDirtyRecords(Address writeAddressBegin)
+    {
+        bool success = true;
+
+        Address writeAddress = writeAddressBegin + dirtyCount * sizeof(Record);
+        Address endAddress = getPageEnd(getActivePage());
+
+        // There must be an empty record after the position where the
+        // last record will be written to act as a separator for the
+        // valid record detection algorithm to work well
+        if(writeAddress < endAddress)
+        {
+            Record separatorRecord;
+            store.read(writeAddress, &separatorRecord, sizeof(separatorRecord));
+
+            success = separatorRecord.empty();
+        }
+
+        for(size_t index = 0; index < capacity() && success; index++)
+        {
+            if(isDirty(index))
+            {
+                writeAddress -= sizeof(Record);
+                success = success && writeRecord(
+                        writeAddress, endAddress, Record(index, cache[index]));
+            }
+        }
+
+        return success;
+    }
+
+    // Page swap that writes the values from the RAM copy of the EEPROM
+    // to the alternate page instead of copying the records from the
+    // active page
+    bool swapPagesAndWriteCache()
+    {
+        LogicalPage sourcePage = getActivePage();
+        LogicalPage destinationPage = getAlternatePage();
+
+        // loop protects against marginal erase
+        for(int tries = 0; tries < 2; tries++)
+        {
+            bool success = true;
+            if(tries > 0 || !verifyPage(destinationPage))
+            {
+                erasePage(destinationPage);
+            }
+
+            Address writeAddress = getPageBegin(destinationPage);
+
+            // Write alternate page as destination for copy
+            success = success && writePageStatus(destinationPage, PageHeader::COPY);
+
+            writeAddress += sizeof(PageHeader);
+
+            // Write all values to destination directly
+            success = success && writeRangeDirect(writeAddress,
+                                                  getPageEnd(destinationPage),
+                                                  0,
+                                                  cache.get(),
+                                                  capacity());
+
+            // Mark new page as active
+            success = success && writePageStatus(destinationPage, PageHeader::ACTIVE);
+            success = success && writePageStatus(sourcePage, PageHeader::INACTIVE);
+
+            if(success)
+            {
+                updateActivePage();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     // Which page needs to be erased after a page swap.
     LogicalPage getPendingErasePage()
     {
@@ -756,4 +1024,11 @@ public:
 protected:
     LogicalPage activePage;
     LogicalPage alternatePage;
+
+    // RAM copy of the EEPROM and bitmap of the values that differ from
+    // the ones stored in Flash
+    std::unique_ptr<Data[]> cache;
+    std::unique_ptr<uint8_t[]> dirty;
+    size_t dirtyCount = 0;
+    bool writeBack = false;
 };
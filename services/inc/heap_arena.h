@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace particle {
+
+/**
+ * Arena serving small heap allocations from pages dedicated to a size class.
+ *
+ * The arena's memory is split into pages of equal size. A free page is assigned to a size class
+ * when that class runs out of free blocks, and is returned to the pool of free pages once all of
+ * its blocks are freed. Small, short-lived allocations thus don't leave holes between the larger
+ * blocks of the general-purpose heap, and the pages themselves never fragment.
+ *
+ * Allocating and freeing a block takes constant time. Every block has an owner bit which the
+ * caller can use to attribute allocations to a module.
+ *
+ * The arena is not thread-safe.
+ */
+class HeapArena {
+public:
+    /**
+     * Size of a page.
+     */
+    static const size_t PAGE_SIZE = 512;
+
+    /**
+     * Alignment of the blocks, and the size of the smallest size class.
+     */
+    static const size_t BLOCK_ALIGN = 16;
+
+    /**
+     * Size of the largest size class.
+     */
+    static const size_t MAX_BLOCK_SIZE = 128;
+
+    /**
+     * Number of size classes.
+     */
+    static const size_t CLASS_COUNT = 6;
+
+    struct Stats {
+        size_t pageCount; ///< Total number of pages.
+        size_t freePages; ///< Number of pages not assigned to any size class.
+        size_t usedBytes; ///< Total size of the allocated blocks.
+        size_t freeBytes; ///< Total size of the free blocks, including the free pages.
+        size_t failures; ///< Number of allocations that could not be served by the arena.
+    };
+
+    HeapArena() :
+            pages_(nullptr),
+            mem_(nullptr),
+            pageCount_(0),
+            freePages_(nullptr),
+            freePageCount_(0),
+            usedBytes_(0),
+            freeBlockBytes_(0),
+            failures_(0) {
+        for (size_t i = 0; i < CLASS_COUNT; ++i) {
+            partial_[i] = nullptr;
+        }
+    }
+
+    HeapArena(const HeapArena&) = delete;
+    HeapArena& operator=(const HeapArena&) = delete;
+
+    /**
+     * Initializes the arena.
+     *
+     * The page descriptors are stored in the same buffer, so slightly less than `size` bytes are
+     * available for the allocations.
+     *
+     * @param buf Buffer.
+     * @param size Size of the buffer.
+     * @return `true` on success, or `false` if the buffer is too small.
+     */
+    bool init(void* buf, size_t size) {
+        auto p = reinterpret_cast<uintptr_t>(buf);
+        const auto end = p + size;
+        p = alignUp(p, alignof(Page));
+        if (p >= end) {
+            return false;
+        }
+        size_t count = (end - p) / (sizeof(Page) + PAGE_SIZE);
+        // Account for the alignment of the first page
+        while (count > 0 && alignUp(p + count * sizeof(Page), BLOCK_ALIGN) + count * PAGE_SIZE > end) {
+            --count;
+        }
+        if (!count) {
+            return false;
+        }
+        pages_ = reinterpret_cast<Page*>(p);
+        mem_ = reinterpret_cast<uint8_t*>(alignUp(p + count * sizeof(Page), BLOCK_ALIGN));
+        pageCount_ = count;
+        freePages_ = nullptr;
+        for (size_t i = count; i > 0; --i) {
+            Page* const pg = &pages_[i - 1];
+            pg->freeList = nullptr;
+            pg->prev = nullptr;
+            pg->next = freePages_;
+            pg->ownerMask = 0;
+            pg->used = 0;
+            pg->sizeClass = NO_CLASS;
+            freePages_ = pg;
+        }
+        freePageCount_ = count;
+        for (size_t i = 0; i < CLASS_COUNT; ++i) {
+            partial_[i] = nullptr;
+        }
+        usedBytes_ = 0;
+        freeBlockBytes_ = 0;
+        failures_ = 0;
+        return true;
+    }
+
+    /**
+     * Allocates a block.
+     *
+     * @param size Block size.
+     * @param owner Owner bit of the block.
+     * @return Pointer to the block, or `nullptr` if the size is too large or the arena is
+     *         exhausted.
+     */
+    void* alloc(size_t size, bool owner = false) {
+        if (!pageCount_ || size > MAX_BLOCK_SIZE) {
+            return nullptr;
+        }
+        const unsigned cls = classIndex(size);
+        Page* pg = partial_[cls];
+        if (!pg) {
+            pg = freePages_;
+            if (!pg) {
+                ++failures_;
+                return nullptr;
+            }
+            freePages_ = pg->next;
+            --freePageCount_;
+            formatPage(pg, cls);
+            pushFront(&partial_[cls], pg);
+        }
+        FreeBlock* const block = pg->freeList;
+        pg->freeList = block->next;
+        ++pg->used;
+        if (!pg->freeList) {
+            // The page is full
+            unlink(&partial_[cls], pg);
+        }
+        const auto mask = blockMask(pg, block);
+        if (owner) {
+            pg->ownerMask |= mask;
+        } else {
+            pg->ownerMask &= ~mask;
+        }
+        usedBytes_ += classSize(cls);
+        freeBlockBytes_ -= classSize(cls);
+        return block;
+    }
+
+    /**
+     * Frees a block.
+     *
+     * @param ptr Pointer to a block allocated by this arena.
+     */
+    void free(void* ptr) {
+        Page* const pg = page(ptr);
+        const unsigned cls = pg->sizeClass;
+        const auto block = static_cast<FreeBlock*>(ptr);
+        pg->ownerMask &= ~blockMask(pg, block);
+        if (!pg->freeList) {
+            // The page was full
+            pushFront(&partial_[cls], pg);
+        }
+        block->next = pg->freeList;
+        pg->freeList = block;
+        usedBytes_ -= classSize(cls);
+        freeBlockBytes_ += classSize(cls);
+        if (--pg->used == 0) {
+            unlink(&partial_[cls], pg);
+            freeBlockBytes_ -= PAGE_SIZE / classSize(cls) * classSize(cls);
+            pg->sizeClass = NO_CLASS;
+            pg->prev = nullptr;
+            pg->next = freePages_;
+            freePages_ = pg;
+            ++freePageCount_;
+        }
+    }
+
+    /**
+     * Returns `true` if a block belongs to this arena.
+     */
+    bool contains(const void* ptr) const {
+        const auto p = static_cast<const uint8_t*>(ptr);
+        return p >= mem_ && p < mem_ + pageCount_ * PAGE_SIZE;
+    }
+
+    /**
+     * Returns the size of a block allocated by this arena.
+     */
+    size_t blockSize(const void* ptr) const {
+        return classSize(page(ptr)->sizeClass);
+    }
+
+    /**
+     * Returns the owner bit of a block allocated by this arena.
+     */
+    bool owner(const void* ptr) const {
+        const Page* const pg = page(ptr);
+        return pg->ownerMask & blockMask(pg, ptr);
+    }
+
+    /**
+     * Returns `true` if the arena has been initialized.
+     */
+    bool isInitialized() const {
+        return pageCount_;
+    }
+
+    /**
+     * Returns the arena statistics.
+     */
+    Stats stats() const {
+        Stats s = {};
+        s.pageCount = pageCount_;
+        s.freePages = freePageCount_;
+        s.usedBytes = usedBytes_;
+        s.freeBytes = freePageCount_ * PAGE_SIZE + freeBlockBytes_;
+        s.failures = failures_;
+        return s;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Page {
+        FreeBlock* freeList;
+        Page* prev;
+        Page* next;
+        uint32_t ownerMask;
+        uint16_t used;
+        uint8_t sizeClass;
+    };
+
+    static const uint8_t NO_CLASS = 0xff;
+    static_assert(PAGE_SIZE / BLOCK_ALIGN <= 32, "Owner mask is too small");
+    static_assert(sizeof(FreeBlock) <= BLOCK_ALIGN, "Block alignment is too small");
+
+    Page* pages_;
+    uint8_t* mem_;
+    size_t pageCount_;
+    Page* partial_[CLASS_COUNT]; // Pages of each class that have free blocks
+    Page* freePages_;
+    size_t freePageCount_;
+    size_t usedBytes_;
+    size_t freeBlockBytes_; // Total size of the free blocks in the pages assigned to a size class
+    size_t failures_;
+
+    Page* page(const void* ptr) const {
+        return &pages_[(static_cast<const uint8_t*>(ptr) - mem_) / PAGE_SIZE];
+    }
+
+    uint8_t* pageMem(const Page* pg) const {
+        return mem_ + (pg - pages_) * PAGE_SIZE;
+    }
+
+    uint32_t blockMask(const Page* pg, const void* ptr) const {
+        const size_t index = (static_cast<const uint8_t*>(ptr) - pageMem(pg)) / classSize(pg->sizeClass);
+        return (uint32_t)1 << index;
+    }
+
+    void formatPage(Page* pg, unsigned cls) {
+        const size_t size = classSize(cls);
+        uint8_t* const begin = pageMem(pg);
+        FreeBlock* list = nullptr;
+        // Blocks are handed out in address order
+        for (size_t n = PAGE_SIZE / size; n > 0; --n) {
+            const auto block = reinterpret_cast<FreeBlock*>(begin + (n - 1) * size);
+            block->next = list;
+            list = block;
+        }
+        pg->freeList = list;
+        freeBlockBytes_ += PAGE_SIZE / size * size;
+        pg->ownerMask = 0;
+        pg->used = 0;
+        pg->sizeClass = cls;
+    }
+
+    static void pushFront(Page** list, Page* pg) {
+        pg->prev = nullptr;
+        pg->next = *list;
+        if (*list) {
+            (*list)->prev = pg;
+        }
+        *list = pg;
+    }
+
+    static void unlink(Page** list, Page* pg) {
+        if (pg->prev) {
+            pg->prev->next = pg->next;
+        } else if (*list == pg) {
+            *list = pg->next;
+        } else {
+            return; // Not in the list
+        }
+        if (pg->next) {
+            pg->next->prev = pg->prev;
+        }
+        pg->prev = nullptr;
+        pg->next = nullptr;
+    }
+
+    static size_t classSize(unsigned cls) {
+        static const uint16_t CLASS_SIZES[CLASS_COUNT] = { 16, 32, 48, 64, 96, 128 };
+        return CLASS_SIZES[cls];
+    }
+
+    static unsigned classIndex(size_t size) {
+        // Index of the smallest class that fits the size, by multiples of the block alignment
+        static const uint8_t CLASS_INDEX[MAX_BLOCK_SIZE / BLOCK_ALIGN] = { 0, 1, 2, 3, 4, 4, 5, 5 };
+        return CLASS_INDEX[size ? (size - 1) / BLOCK_ALIGN : 0];
+    }
+
+    static uintptr_t alignUp(uintptr_t p, size_t align) {
+        return (p + align - 1) & ~(uintptr_t)(align - 1);
+    }
+};
+
+} // particle
@@ -73,7 +73,8 @@ void led_set_update_enabled(int enabled, void* reserved);
 int led_update_enabled(void* reserved);
 
 // Updates LED color according to a number of ticks passed since previous update. This function needs
-// to be called periodically.
+// to be called periodically. The LED color is only recomputed when the active status or the global
+// LED brightness changes, or when the pattern of the active status requires a different color.
 //
 // TODO: If `status` argument is not null, LED will be updated only if specified status has a highest
 // priority among other active statuses. This can be used to implement a status indication that
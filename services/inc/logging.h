@@ -116,6 +116,13 @@
     This parameter affects log_message() and some other functions along with their wrapper macros.
 
     LOG_DISABLE - disables logging entirely, turning all logging macros into no-op.
+
+    LOG_DEFERRED_FORMAT - makes LOG() and LOG_DEBUG() defer formatting of messages to the host (C++
+    code only). The format strings are placed into the .log_fmt section, which is not loaded to the
+    device, and every message is written to backend logger as a binary frame containing the ID of
+    its format string and the raw values of its arguments. Use build/decode_log.py to format the
+    messages received from the device. Format strings need to be string literals; messages
+    generated in this mode don't include attributes other than the timestamp. Default value is 0.
 */
 
 #include <string.h>
@@ -222,6 +229,37 @@ const char* log_level_name(int level, void *reserved);
 void log_set_callbacks(log_message_callback_type log_msg, log_write_callback_type log_write,
         log_enabled_callback_type log_enabled, void *reserved);
 
+// Sets the lowest level of the messages passed to the logger callbacks. Messages with a lower level
+// are discarded before they are formatted. log_set_callbacks() resets the threshold to LOG_LEVEL_ALL
+void log_set_level_threshold(int level, void *reserved);
+
+// Type tags of the arguments of a deferred log message. Every argument is encoded as a tag byte
+// followed by the argument's value in little-endian byte order. A string is encoded as a length
+// byte followed by the characters of the string
+typedef enum LogDeferredArgType {
+    LOG_DEFERRED_ARG_INT32 = 1, // int32_t
+    LOG_DEFERRED_ARG_INT64 = 2, // int64_t
+    LOG_DEFERRED_ARG_DOUBLE = 3, // double
+    LOG_DEFERRED_ARG_POINTER = 4, // uint32_t or uint64_t, depending on the pointer size
+    LOG_DEFERRED_ARG_STRING = 5 // uint8_t length, char[length]
+} LogDeferredArgType;
+
+// First byte of a frame generated by log_message_deferred(). Text output never contains this byte
+#define LOG_DEFERRED_FRAME_START 0x00
+
+// Writes deferred log message to backend logger. The message is encoded as follows:
+//
+// uint8_t start; // LOG_DEFERRED_FRAME_START
+// uint8_t size; // Size of the remaining frame data
+// uint8_t level; // Logging level
+// uint32_t time; // Timestamp in milliseconds
+// uint32_t fmt_id; // Module ID (bits 24-31) and offset of the format string in the .log_fmt section
+// uint8_t category_length;
+// char category[category_length];
+// uint8_t args[]; // Encoded arguments (see LogDeferredArgType)
+void log_message_deferred(int level, const char *category, uint32_t fmt_id, const void *args, size_t size,
+        void *reserved);
+
 extern void HAL_Delay_Microseconds(uint32_t delay);
 
 #ifdef __cplusplus
@@ -240,6 +278,14 @@ extern void HAL_Delay_Microseconds(uint32_t delay);
 #define LOG_INCLUDE_SOURCE_INFO 0
 #endif
 
+#ifndef LOG_DEFERRED_FORMAT
+#define LOG_DEFERRED_FORMAT 0
+#endif
+
+#ifndef LOG_DEFERRED_MAX_ARGS_SIZE
+#define LOG_DEFERRED_MAX_ARGS_SIZE 128
+#endif
+
 // Sets log message attribute
 #define LOG_ATTR_SET(_attr, _name, _val) \
         do { \
@@ -332,6 +378,123 @@ static const char* const _log_category = NULL;
         (_attr)._expr; /* attr.file = "logging.h"; */ \
         (_attr).has_##_expr ? 1 : 1; /* attr.has_file = "logging.h" ? 1 : 1; */
 
+#if LOG_DEFERRED_FORMAT && defined(__cplusplus)
+
+#include <type_traits>
+
+// Encoder of the arguments of a deferred log message
+class _LogDeferredArgs {
+public:
+    _LogDeferredArgs() :
+            size_(0),
+            full_(false) {
+    }
+
+    void put() {
+    }
+
+    template<typename T, typename... ArgsT>
+    void put(T arg, ArgsT... args) {
+        putArg(arg);
+        put(args...);
+    }
+
+    const char* data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    char data_[LOG_DEFERRED_MAX_ARGS_SIZE];
+    size_t size_;
+    bool full_; // Set if an argument didn't fit; the remaining arguments are discarded as well
+
+    template<typename T>
+    typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value) && sizeof(T) <= 4>::type
+    putArg(T arg) {
+        const int32_t val = static_cast<int32_t>(arg);
+        putValue(LOG_DEFERRED_ARG_INT32, &val, sizeof(val));
+    }
+
+    template<typename T>
+    typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value) && (sizeof(T) > 4)>::type
+    putArg(T arg) {
+        const int64_t val = static_cast<int64_t>(arg);
+        putValue(LOG_DEFERRED_ARG_INT64, &val, sizeof(val));
+    }
+
+    template<typename T>
+    typename std::enable_if<std::is_floating_point<T>::value>::type
+    putArg(T arg) {
+        const double val = arg;
+        putValue(LOG_DEFERRED_ARG_DOUBLE, &val, sizeof(val));
+    }
+
+    void putArg(const void* arg) {
+        putValue(LOG_DEFERRED_ARG_POINTER, &arg, sizeof(arg));
+    }
+
+    void putArg(const char* arg) {
+        size_t n = arg ? strlen(arg) : 0;
+        if (n > 0xff) {
+            n = 0xff;
+        }
+        if (full_) {
+            return;
+        }
+        if (n + 2 > sizeof(data_) - size_) {
+            full_ = true;
+            if (sizeof(data_) - size_ < 2) {
+                return;
+            }
+            n = sizeof(data_) - size_ - 2; // Truncate the string
+        }
+        data_[size_++] = LOG_DEFERRED_ARG_STRING;
+        data_[size_++] = n;
+        memcpy(data_ + size_, arg, n);
+        size_ += n;
+    }
+
+    void putValue(uint8_t type, const void* val, size_t n) {
+        if (full_ || n + 1 > sizeof(data_) - size_) {
+            full_ = true;
+            return;
+        }
+        data_[size_++] = type;
+        memcpy(data_ + size_, val, n); // Little endian
+        size_ += n;
+    }
+};
+
+#if defined(MODULE_FUNCTION) && defined(MODULE_INDEX)
+#define _LOG_DEFERRED_MODULE_ID ((MODULE_FUNCTION << 4) | MODULE_INDEX)
+#else
+#define _LOG_DEFERRED_MODULE_ID 0
+#endif
+
+// Places the format string into the .log_fmt section and expands to its ID
+#define _LOG_DEFERRED_FMT_ID(_fmt) \
+        __extension__({ \
+            static const char _log_fmt[] __attribute__((section(".log_fmt"), used)) = "" _fmt; \
+            ((uint32_t)_LOG_DEFERRED_MODULE_ID << 24) | ((uint32_t)(uintptr_t)_log_fmt & 0x00ffffff); \
+        })
+
+// Primary logging macros
+#define LOG_C(_level, _category, _fmt, ...) \
+        do { \
+            if (LOG_LEVEL_##_level >= LOG_COMPILE_TIME_LEVEL) { \
+                _LogDeferredArgs _args; \
+                _args.put(__VA_ARGS__); \
+                log_message_deferred(LOG_LEVEL_##_level, _category, _LOG_DEFERRED_FMT_ID(_fmt), _args.data(), \
+                        _args.size(), NULL); \
+            } \
+        } while (0)
+
+#else
+
 // Primary logging macros
 #define LOG_C(_level, _category, _fmt, ...) \
         do { \
@@ -341,6 +504,8 @@ static const char* const _log_category = NULL;
             } \
         } while (0)
 
+#endif // !(LOG_DEFERRED_FORMAT && defined(__cplusplus))
+
 #define LOG_ATTR_C(_level, _category, _attrs, _fmt, ...) \
         do { \
             if (LOG_LEVEL_##_level >= LOG_COMPILE_TIME_LEVEL) { \
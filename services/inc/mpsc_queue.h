@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+namespace particle {
+
+/**
+ * Link field of an item stored in `MpscQueue`.
+ *
+ * The structure is trivial so that it can be embedded into C-style structures that are
+ * zero-initialized with `memset()`.
+ */
+struct MpscQueueNode {
+    MpscQueueNode* next;
+};
+
+/**
+ * Intrusive lock-free multi-producer single-consumer queue.
+ *
+ * This is Dmitry Vyukov's intrusive MPSC node-based queue. Adding an item takes a single atomic
+ * exchange and never blocks, so `push()` can be called from any thread or ISR. `pop()` and
+ * `isEmpty()` must only be called from the consumer thread.
+ *
+ * `ItemT` must be derived from `MpscQueueNode`. An item must not be added to the queue again
+ * before it has been taken out of it.
+ */
+template<typename ItemT>
+class MpscQueue {
+public:
+    typedef ItemT ItemType;
+
+    MpscQueue() :
+            head_(&stub_),
+            tail_(&stub_),
+            stub_{nullptr} {
+    }
+
+    // The stub node is referenced by address
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    /**
+     * Adds an item to the back of the queue.
+     *
+     * @return `true` if the queue was empty. The caller is then responsible for notifying the
+     *         consumer thread, which is the only case where it may be waiting for an item.
+     */
+    bool push(ItemT* item) {
+        return pushNode(item);
+    }
+
+    /**
+     * Takes an item from the front of the queue.
+     *
+     * This method may return `nullptr` while the queue is not empty if a producer has been
+     * preempted in the middle of adding an item. Use `isEmpty()` to tell the two cases apart.
+     */
+    ItemT* pop() {
+        MpscQueueNode* tail = tail_;
+        MpscQueueNode* next = loadNext(tail);
+        if (tail == &stub_) {
+            if (!next) {
+                return nullptr;
+            }
+            tail_ = next;
+            tail = next;
+            next = loadNext(tail);
+        }
+        if (next) {
+            tail_ = next;
+            return static_cast<ItemT*>(tail);
+        }
+        if (tail != __atomic_load_n(&head_, __ATOMIC_ACQUIRE)) {
+            // A producer has replaced the head but hasn't linked its item yet
+            return nullptr;
+        }
+        // Put the stub back so that the last item can be taken out
+        pushNode(&stub_);
+        next = loadNext(tail);
+        if (next) {
+            tail_ = next;
+            return static_cast<ItemT*>(tail);
+        }
+        return nullptr;
+    }
+
+    /**
+     * Returns `true` if the queue is empty.
+     *
+     * An item that is being added concurrently may not be accounted for, but the producer adding
+     * it will get `true` from `push()` in that case.
+     */
+    bool isEmpty() const {
+        return tail_ == &stub_ && !loadNext(&stub_);
+    }
+
+private:
+    MpscQueueNode* head_; // Last added node, updated by the producers
+    MpscQueueNode* tail_; // Next node to take, only accessed by the consumer
+    MpscQueueNode stub_;
+
+    bool pushNode(MpscQueueNode* node) {
+        __atomic_store_n(&node->next, nullptr, __ATOMIC_RELAXED);
+        MpscQueueNode* const prev = __atomic_exchange_n(&head_, node, __ATOMIC_ACQ_REL);
+        __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+        return prev == &stub_;
+    }
+
+    static MpscQueueNode* loadNext(const MpscQueueNode* node) {
+        return __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+    }
+};
+
+} // particle
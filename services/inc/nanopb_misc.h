@@ -29,6 +29,24 @@ extern "C" {
 
 typedef struct lfs_file lfs_file_t;
 
+/**
+ * Output buffer that grows as the data is encoded into it.
+ *
+ * The encoded data is written at `offset` in the buffer. When the buffer needs to grow, its
+ * size is increased by at least a half of the current size, so that encoding a large message
+ * doesn't reallocate the buffer for every field.
+ */
+typedef struct pb_growable_buffer {
+    pb_byte_t* data; // Buffer data
+    size_t size; // Size of the allocated buffer
+    size_t offset; // Offset at which the encoded data is written
+    // Callback reallocating the buffer. On success, the callback updates the `data` and `size`
+    // fields and returns 0, otherwise it returns a negative result code
+    int (*realloc_fn)(struct pb_growable_buffer* buf, size_t size);
+    void* user_data; // User data
+    int error; // The result code of the last failed reallocation
+} pb_growable_buffer;
+
 pb_ostream_t* pb_ostream_init(void* reserved);
 bool pb_ostream_free(pb_ostream_t* stream, void* reserved);
 
@@ -38,6 +56,8 @@ bool pb_istream_free(pb_istream_t* stream, void* reserved);
 bool pb_ostream_from_buffer_ex(pb_ostream_t* stream, pb_byte_t *buf, size_t bufsize, void* reserved);
 bool pb_istream_from_buffer_ex(pb_istream_t* stream, const pb_byte_t *buf, size_t bufsize, void* reserved);
 
+bool pb_ostream_from_growable_buffer(pb_ostream_t* stream, pb_growable_buffer* buf, void* reserved);
+
 #if HAL_PLATFORM_FILESYSTEM
 bool pb_ostream_from_file(pb_ostream_t* stream, lfs_file_t* file, void* reserved);
 bool pb_istream_from_file(pb_istream_t* stream, lfs_file_t* file, void* reserved);
@@ -50,6 +70,7 @@ bool pb_istream_from_file(pb_istream_t* stream, lfs_file_t* file, void* reserved
 #pragma weak pb_istream_free
 #pragma weak pb_ostream_from_buffer_ex
 #pragma weak pb_istream_from_buffer_ex
+#pragma weak pb_ostream_from_growable_buffer
 #endif // SERVICES_NO_NANOPB_LIB
 
 #ifdef __cplusplus
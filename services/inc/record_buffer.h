@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "system_error.h"
+#include "check.h"
+
+#include <atomic>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+namespace particle {
+
+namespace services {
+
+/**
+ * Lock-free multi-producer/single-consumer buffer of variable-size records.
+ *
+ * Any number of threads or ISRs may call `acquire()` and `commit()` concurrently without locking.
+ * Records are passed to the consumer (`peek()`, `release()`) in the order in which they were
+ * acquired. A record that has been acquired but not yet committed holds back all the records
+ * following it. `init()` and `reset()` are not thread-safe.
+ *
+ * Every record is prefixed with a 4-byte header and is aligned at a 4-byte boundary. The size of
+ * the buffer must be a power of two.
+ */
+class MpscRecordBuffer {
+public:
+    MpscRecordBuffer();
+    MpscRecordBuffer(void* buffer, size_t size);
+
+    int init(void* buffer, size_t size);
+    void reset();
+
+    /**
+     * Reserves space for a record.
+     *
+     * @param size Record size.
+     * @return Pointer to the record data, or `nullptr` if there's not enough space in the buffer.
+     */
+    void* acquire(size_t size);
+    /**
+     * Makes a record available to the consumer.
+     *
+     * @param data Pointer returned by `acquire()`.
+     */
+    void commit(void* data);
+
+    /**
+     * Gets the oldest committed record.
+     *
+     * @param size Receives the record size.
+     * @return Pointer to the record data, or `nullptr` if no record is available.
+     */
+    const void* peek(size_t* size);
+    /**
+     * Frees the record returned by `peek()`.
+     */
+    void release();
+
+    bool empty() const;
+    size_t size() const;
+
+private:
+    // Header flags
+    enum Flag: uint32_t {
+        COMMITTED = 0x80000000,
+        PADDING = 0x40000000,
+        SIZE_MASK = 0x3fffffff
+    };
+
+    static const size_t HEADER_SIZE = sizeof(uint32_t);
+
+    char* buffer_;
+    size_t size_;
+    size_t mask_;
+
+    // The indices are free-running and only masked when accessing the buffer
+    std::atomic<size_t> head_; // Modified by the producers
+    std::atomic<size_t> tail_; // Modified by the consumer
+
+    uint32_t* header(size_t index) const;
+
+    static size_t recordSize(size_t dataSize);
+};
+
+inline MpscRecordBuffer::MpscRecordBuffer() :
+        buffer_(nullptr),
+        size_(0),
+        mask_(0),
+        head_(0),
+        tail_(0) {
+}
+
+inline MpscRecordBuffer::MpscRecordBuffer(void* buffer, size_t size) :
+        MpscRecordBuffer() {
+    init(buffer, size);
+}
+
+inline int MpscRecordBuffer::init(void* buffer, size_t size) {
+    CHECK_TRUE(buffer && ((uintptr_t)buffer % HEADER_SIZE) == 0, SYSTEM_ERROR_INVALID_ARGUMENT);
+    CHECK_TRUE(size >= HEADER_SIZE && (size & (size - 1)) == 0 && size <= SIZE_MASK, SYSTEM_ERROR_INVALID_ARGUMENT);
+    buffer_ = (char*)buffer;
+    size_ = size;
+    mask_ = size - 1;
+    reset();
+    return 0;
+}
+
+inline void MpscRecordBuffer::reset() {
+    // The consumer relies on the COMMITTED flag being cleared in every free header
+    memset(buffer_, 0, size_);
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_release);
+}
+
+inline void* MpscRecordBuffer::acquire(size_t size) {
+    const size_t recSize = recordSize(size);
+    if (size > SIZE_MASK || recSize > size_) {
+        return nullptr;
+    }
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t padSize = 0;
+    do {
+        // A record is never split at the end of the buffer; the remaining space is filled with padding
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t contiguous = size_ - (head & mask_);
+        padSize = (recSize > contiguous) ? contiguous : 0;
+        if (head + padSize + recSize - tail > size_) {
+            return nullptr;
+        }
+    } while (!head_.compare_exchange_weak(head, head + padSize + recSize, std::memory_order_acq_rel,
+            std::memory_order_relaxed));
+    if (padSize) {
+        __atomic_store_n(header(head), (uint32_t)(padSize - HEADER_SIZE) | PADDING | COMMITTED, __ATOMIC_RELEASE);
+        head += padSize;
+    }
+    uint32_t* const h = header(head);
+    __atomic_store_n(h, (uint32_t)size, __ATOMIC_RELAXED);
+    return h + 1;
+}
+
+inline void MpscRecordBuffer::commit(void* data) {
+    uint32_t* const h = (uint32_t*)data - 1;
+    __atomic_store_n(h, __atomic_load_n(h, __ATOMIC_RELAXED) | COMMITTED, __ATOMIC_RELEASE);
+}
+
+inline const void* MpscRecordBuffer::peek(size_t* size) {
+    for (;;) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        uint32_t* const h = header(tail);
+        const uint32_t val = __atomic_load_n(h, __ATOMIC_ACQUIRE);
+        if (!(val & COMMITTED)) {
+            return nullptr;
+        }
+        if (val & PADDING) {
+            release();
+            continue;
+        }
+        if (size) {
+            *size = val & SIZE_MASK;
+        }
+        return h + 1;
+    }
+}
+
+inline void MpscRecordBuffer::release() {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    uint32_t* const h = header(tail);
+    const size_t recSize = recordSize(*h & SIZE_MASK);
+    memset(h, 0, recSize);
+    tail_.store(tail + recSize, std::memory_order_release);
+}
+
+inline bool MpscRecordBuffer::empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_relaxed);
+}
+
+inline size_t MpscRecordBuffer::size() const {
+    return size_;
+}
+
+inline uint32_t* MpscRecordBuffer::header(size_t index) const {
+    return (uint32_t*)(buffer_ + (index & mask_));
+}
+
+inline size_t MpscRecordBuffer::recordSize(size_t dataSize) {
+    return (HEADER_SIZE + dataSize + HEADER_SIZE - 1) & ~(HEADER_SIZE - 1);
+}
+
+} // namespace services
+
+} // namespace particle
@@ -19,9 +19,21 @@
 #define SERVICES_RINGBUFFER_H
 
 #include <cstddef>
+#include <atomic>
+#include <algorithm>
 #include "system_error.h"
 #include "check.h"
 
+// Alignment of the indices of SpscRingBuffer. Cortex-M cores have no data cache, so there's no need
+// to waste RAM on padding; on the host the indices are kept in separate cache lines
+#ifndef SERVICES_RINGBUFFER_INDEX_ALIGNMENT
+#if defined(__arm__)
+#define SERVICES_RINGBUFFER_INDEX_ALIGNMENT (alignof(size_t))
+#else
+#define SERVICES_RINGBUFFER_INDEX_ALIGNMENT (64)
+#endif
+#endif
+
 namespace particle {
 namespace services {
 
@@ -361,6 +373,253 @@ inline void RingBuffer<T>::updateCurSize() {
     }
 }
 
+/**
+ * Lock-free single-producer/single-consumer ring buffer.
+ *
+ * One thread or ISR may call the producer methods (`put()`, `acquire()`, `acquireCommit()`, `space()`)
+ * while another thread or ISR calls the consumer methods (`get()`, `peek()`, `consume()`,
+ * `consumeCommit()`, `data()`) without any locking. `init()` and `reset()` are not thread-safe.
+ *
+ * The size of the buffer must be a power of two.
+ */
+template <typename T>
+class SpscRingBuffer {
+public:
+    SpscRingBuffer();
+    SpscRingBuffer(T* buffer, size_t size);
+
+    int init(T* buffer, size_t size);
+    void reset();
+
+    size_t size() const;
+
+    bool full() const;
+    bool empty() const;
+
+    size_t space() const;
+    size_t data() const;
+
+    ssize_t put(const T& v);
+    ssize_t put(const T* v, size_t size);
+
+    ssize_t get(T* v);
+    ssize_t get(T* v, size_t size);
+
+    ssize_t peek(T* v);
+    ssize_t peek(T* v, size_t size);
+
+    /**
+     * Zero-copy access for the producer. `acquire()` reserves a contiguous region of the free space
+     * following the regions that are already reserved; `acquireCommit()` makes the data written
+     * to the reserved regions available to the consumer, in the order in which they were reserved.
+     */
+    size_t acquirable() const;
+    size_t acquirePending() const;
+    T* acquire(size_t size);
+    void acquireCommit(size_t size, size_t cancel = 0);
+
+    /**
+     * Zero-copy access for the consumer.
+     */
+    size_t consumable() const;
+    T* consume(size_t size);
+    void consumeCommit(size_t size);
+
+private:
+    T* buffer_;
+    size_t size_;
+    size_t mask_;
+    size_t headPending_; // Modified by the producer
+
+    // The indices are free-running and only masked when accessing the buffer
+    alignas(SERVICES_RINGBUFFER_INDEX_ALIGNMENT) std::atomic<size_t> head_; // Modified by the producer
+    alignas(SERVICES_RINGBUFFER_INDEX_ALIGNMENT) std::atomic<size_t> tail_; // Modified by the consumer
+
+    void copyIn(size_t index, const T* v, size_t size);
+    void copyOut(size_t index, T* v, size_t size) const;
+};
+
+template <typename T>
+inline SpscRingBuffer<T>::SpscRingBuffer()
+        : buffer_(nullptr),
+          size_(0),
+          mask_(0),
+          headPending_(0),
+          head_(0),
+          tail_(0) {
+}
+
+template <typename T>
+inline SpscRingBuffer<T>::SpscRingBuffer(T* buffer, size_t size)
+        : SpscRingBuffer() {
+    init(buffer, size);
+}
+
+template <typename T>
+inline int SpscRingBuffer<T>::init(T* buffer, size_t size) {
+    CHECK_TRUE(buffer && size && (size & (size - 1)) == 0, SYSTEM_ERROR_INVALID_ARGUMENT);
+    buffer_ = buffer;
+    size_ = size;
+    mask_ = size - 1;
+    reset();
+    return 0;
+}
+
+template <typename T>
+inline void SpscRingBuffer<T>::reset() {
+    headPending_ = 0;
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_release);
+}
+
+template <typename T>
+inline size_t SpscRingBuffer<T>::size() const {
+    return size_;
+}
+
+template <typename T>
+inline bool SpscRingBuffer<T>::full() const {
+    return data() == size_;
+}
+
+template <typename T>
+inline bool SpscRingBuffer<T>::empty() const {
+    return data() == 0;
+}
+
+template <typename T>
+inline size_t SpscRingBuffer<T>::space() const {
+    return size_ - (head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_acquire)) - headPending_;
+}
+
+template <typename T>
+inline size_t SpscRingBuffer<T>::data() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed);
+}
+
+template <typename T>
+inline ssize_t SpscRingBuffer<T>::put(const T& v) {
+    return put(&v, 1);
+}
+
+template <typename T>
+inline ssize_t SpscRingBuffer<T>::put(const T* v, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    CHECK_TRUE(headPending_ == 0, SYSTEM_ERROR_INVALID_STATE);
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    CHECK_TRUE(size_ - (head - tail) >= size, SYSTEM_ERROR_TOO_LARGE);
+    if (v) {
+        copyIn(head, v, size);
+    }
+    head_.store(head + size, std::memory_order_release);
+    return size;
+}
+
+template <typename T>
+inline ssize_t SpscRingBuffer<T>::get(T* v) {
+    return get(v, 1);
+}
+
+template <typename T>
+inline ssize_t SpscRingBuffer<T>::get(T* v, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    CHECK_TRUE(head - tail >= size, SYSTEM_ERROR_TOO_LARGE);
+    if (v) {
+        copyOut(tail, v, size);
+    }
+    tail_.store(tail + size, std::memory_order_release);
+    return size;
+}
+
+template <typename T>
+inline ssize_t SpscRingBuffer<T>::peek(T* v) {
+    return peek(v, 1);
+}
+
+template <typename T>
+inline ssize_t SpscRingBuffer<T>::peek(T* v, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    CHECK_TRUE(v, SYSTEM_ERROR_INVALID_ARGUMENT);
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    CHECK_TRUE(head - tail >= size, SYSTEM_ERROR_TOO_LARGE);
+    copyOut(tail, v, size);
+    return size;
+}
+
+template <typename T>
+inline size_t SpscRingBuffer<T>::acquirable() const {
+    const size_t head = head_.load(std::memory_order_relaxed) + headPending_;
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    return std::min(size_ - (head - tail), size_ - (head & mask_));
+}
+
+template <typename T>
+inline size_t SpscRingBuffer<T>::acquirePending() const {
+    return headPending_;
+}
+
+template <typename T>
+inline T* SpscRingBuffer<T>::acquire(size_t size) {
+    if (acquirable() < size) {
+        return nullptr;
+    }
+    const size_t head = head_.load(std::memory_order_relaxed) + headPending_;
+    headPending_ += size;
+    return buffer_ + (head & mask_);
+}
+
+template <typename T>
+inline void SpscRingBuffer<T>::acquireCommit(size_t size, size_t cancel) {
+    headPending_ -= size + cancel;
+    head_.store(head_.load(std::memory_order_relaxed) + size, std::memory_order_release);
+}
+
+template <typename T>
+inline size_t SpscRingBuffer<T>::consumable() const {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    return std::min(head - tail, size_ - (tail & mask_));
+}
+
+template <typename T>
+inline T* SpscRingBuffer<T>::consume(size_t size) {
+    if (consumable() < size) {
+        return nullptr;
+    }
+    return buffer_ + (tail_.load(std::memory_order_relaxed) & mask_);
+}
+
+template <typename T>
+inline void SpscRingBuffer<T>::consumeCommit(size_t size) {
+    tail_.store(tail_.load(std::memory_order_relaxed) + size, std::memory_order_release);
+}
+
+template <typename T>
+inline void SpscRingBuffer<T>::copyIn(size_t index, const T* v, size_t size) {
+    index &= mask_;
+    const size_t n = std::min(size, size_ - index);
+    std::copy(v, v + n, buffer_ + index);
+    std::copy(v + n, v + size, buffer_);
+}
+
+template <typename T>
+inline void SpscRingBuffer<T>::copyOut(size_t index, T* v, size_t size) const {
+    index &= mask_;
+    const size_t n = std::min(size, size_ - index);
+    std::copy(buffer_ + index, buffer_ + index + n, v);
+    std::copy(buffer_, buffer_ + size - n, v + n);
+}
+
 } // services
 } // particle
 
@@ -110,6 +110,9 @@ DYNALIB_FN(55, services, pb_encode_varint, bool(pb_ostream_t*, pb_uint64_t))
 # define BASE_IDX 40
 #endif
 
+DYNALIB_FN(BASE_IDX + 0, services, log_message_deferred, void(int, const char*, uint32_t, const void*, size_t, void*))
+DYNALIB_FN(BASE_IDX + 1, services, log_set_level_threshold, void(int, void*))
+
 DYNALIB_END(services)
 
 #undef BASE_IDX
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+
+#include "allocator.h"
+#include "system_error.h"
+
+namespace particle {
+
+/**
+ * Allocator serving fixed-size blocks from a set of size classes.
+ *
+ * Every size class has its own region of memory and a free list, so allocating or freeing a block
+ * takes constant time regardless of the pool's occupancy. A request is served from the smallest
+ * class that fits it, or from a larger class if that class is exhausted.
+ *
+ * The allocator is not thread-safe.
+ */
+class SlabAllocator: public SimpleAllocator {
+public:
+    struct SizeClass {
+        uint16_t blockSize; ///< Block size.
+        uint16_t blockCount; ///< Number of blocks.
+    };
+
+    struct Stats {
+        size_t blockSize; ///< Block size.
+        size_t blockCount; ///< Number of blocks.
+        size_t used; ///< Number of allocated blocks.
+        size_t maxUsed; ///< Maximum number of blocks that have been allocated at the same time.
+    };
+
+    SlabAllocator() :
+            slabs_(nullptr),
+            slabCount_(0),
+            mem_(nullptr),
+            failures_(0) {
+    }
+
+    /**
+     * Constructs and initializes the allocator.
+     *
+     * @see init()
+     */
+    SlabAllocator(const SizeClass* classes, size_t count) :
+            SlabAllocator() {
+        init(classes, count);
+    }
+
+    ~SlabAllocator() {
+        destroy();
+    }
+
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    /**
+     * Initializes the allocator.
+     *
+     * @param classes Size classes sorted by block size in ascending order.
+     * @param count Number of size classes.
+     * @return 0 on success, or a negative result code.
+     */
+    int init(const SizeClass* classes, size_t count) {
+        destroy();
+        if (!classes || !count) {
+            return SYSTEM_ERROR_INVALID_ARGUMENT;
+        }
+        size_t memSize = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (!classes[i].blockSize || !classes[i].blockCount ||
+                    (i > 0 && classes[i].blockSize <= classes[i - 1].blockSize)) {
+                return SYSTEM_ERROR_INVALID_ARGUMENT;
+            }
+            memSize += alignedBlockSize(classes[i].blockSize) * classes[i].blockCount;
+        }
+        slabs_ = new(std::nothrow) Slab[count];
+        mem_ = new(std::nothrow) uint8_t[memSize];
+        if (!slabs_ || !mem_) {
+            destroy();
+            return SYSTEM_ERROR_NO_MEMORY;
+        }
+        slabCount_ = count;
+        uint8_t* p = mem_;
+        for (size_t i = 0; i < count; ++i) {
+            Slab& s = slabs_[i];
+            s.blockSize = alignedBlockSize(classes[i].blockSize);
+            s.blockCount = classes[i].blockCount;
+            s.used = 0;
+            s.maxUsed = 0;
+            s.begin = p;
+            s.freeList = nullptr;
+            p += s.blockSize * s.blockCount;
+            s.end = p;
+            // Build the free list so that blocks are handed out in address order
+            for (uint8_t* b = s.end; b != s.begin;) {
+                b -= s.blockSize;
+                const auto block = reinterpret_cast<FreeBlock*>(b);
+                block->next = s.freeList;
+                s.freeList = block;
+            }
+        }
+        return 0;
+    }
+
+    void* alloc(size_t size) override {
+        for (size_t i = 0; i < slabCount_; ++i) {
+            Slab& s = slabs_[i];
+            if (s.blockSize < size || !s.freeList) {
+                continue;
+            }
+            FreeBlock* const block = s.freeList;
+            s.freeList = block->next;
+            if (++s.used > s.maxUsed) {
+                s.maxUsed = s.used;
+            }
+            return block;
+        }
+        ++failures_;
+        return nullptr;
+    }
+
+    void free(void* ptr) override {
+        if (!ptr) {
+            return;
+        }
+        const auto p = static_cast<uint8_t*>(ptr);
+        for (size_t i = 0; i < slabCount_; ++i) {
+            Slab& s = slabs_[i];
+            if (p >= s.begin && p < s.end) {
+                const auto block = reinterpret_cast<FreeBlock*>(p);
+                block->next = s.freeList;
+                s.freeList = block;
+                --s.used;
+                return;
+            }
+        }
+    }
+
+    /**
+     * Returns the statistics of a size class.
+     *
+     * @param index Index of the size class.
+     * @param stats Statistics.
+     * @return 0 on success, or a negative result code.
+     */
+    int stats(size_t index, Stats* stats) const {
+        if (index >= slabCount_ || !stats) {
+            return SYSTEM_ERROR_INVALID_ARGUMENT;
+        }
+        const Slab& s = slabs_[index];
+        stats->blockSize = s.blockSize;
+        stats->blockCount = s.blockCount;
+        stats->used = s.used;
+        stats->maxUsed = s.maxUsed;
+        return 0;
+    }
+
+    /**
+     * Returns the number of size classes.
+     */
+    size_t classCount() const {
+        return slabCount_;
+    }
+
+    /**
+     * Returns the number of allocations that could not be served by any size class.
+     */
+    size_t failures() const {
+        return failures_;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Slab {
+        uint8_t* begin;
+        uint8_t* end;
+        FreeBlock* freeList;
+        uint16_t blockSize;
+        uint16_t blockCount;
+        uint16_t used;
+        uint16_t maxUsed;
+    };
+
+    Slab* slabs_;
+    size_t slabCount_;
+    uint8_t* mem_;
+    size_t failures_;
+
+    void destroy() {
+        delete[] slabs_;
+        slabs_ = nullptr;
+        slabCount_ = 0;
+        delete[] mem_;
+        mem_ = nullptr;
+        failures_ = 0;
+    }
+
+    static size_t alignedBlockSize(size_t size) {
+        const size_t align = alignof(std::max_align_t);
+        if (size < sizeof(FreeBlock)) {
+            size = sizeof(FreeBlock);
+        }
+        return (size + align - 1) & ~(align - 1);
+    }
+};
+
+} // particle
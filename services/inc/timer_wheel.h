@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace particle {
+
+class TimerWheel;
+
+/**
+ * Entry of a timer wheel.
+ *
+ * Classes scheduled on a timer wheel derive from this class.
+ */
+class TimerWheelEntry {
+public:
+    TimerWheelEntry() :
+            next_(nullptr),
+            pprev_(nullptr),
+            expiry_(0),
+            level_(0),
+            slot_(0) {
+    }
+
+    TimerWheelEntry(const TimerWheelEntry&) = delete;
+    TimerWheelEntry& operator=(const TimerWheelEntry&) = delete;
+
+    /**
+     * Returns `true` if the entry is scheduled, or has expired but hasn't been taken from the
+     * wheel yet.
+     */
+    bool isScheduled() const {
+        return pprev_;
+    }
+
+    /**
+     * Returns the expiration time of the entry.
+     */
+    uint32_t expiry() const {
+        return expiry_;
+    }
+
+private:
+    TimerWheelEntry* next_;
+    TimerWheelEntry** pprev_; // Points to the `next_` field of the previous entry, or to the list head
+    uint32_t expiry_;
+    uint8_t level_;
+    uint8_t slot_;
+
+    friend class TimerWheel;
+};
+
+/**
+ * Hierarchical timer wheel.
+ *
+ * The wheel has several levels of slots, each level covering a range of time that is
+ * `LEVEL_SIZE` times longer than the range of the previous level. Entries that expire in
+ * the near future are stored in the slots of the first level, one slot per tick. Entries
+ * that expire further in the future are stored in the coarser slots of the upper levels
+ * and are moved to the lower levels as the wheel advances.
+ *
+ * Adding and removing an entry takes constant time. Entries that expire beyond the range
+ * of the wheel are kept in the last level until they get within range.
+ *
+ * The time is measured in ticks, which are usually milliseconds. The wheel is not thread-safe.
+ */
+class TimerWheel {
+public:
+    /**
+     * Number of bits of the time covered by each level.
+     */
+    static const unsigned LEVEL_BITS = 6;
+
+    /**
+     * Number of slots in each level.
+     */
+    static const unsigned LEVEL_SIZE = 1 << LEVEL_BITS;
+
+    /**
+     * Number of levels.
+     */
+    static const unsigned LEVEL_COUNT = 4;
+
+    /**
+     * Number of ticks covered by the wheel.
+     */
+    static const uint32_t MAX_TIMEOUT = ((uint32_t)1 << (LEVEL_BITS * LEVEL_COUNT)) - 1;
+
+    /**
+     * Constructs a wheel.
+     *
+     * @param now Current time.
+     */
+    explicit TimerWheel(uint32_t now = 0) {
+        for (unsigned i = 0; i < LEVEL_COUNT; ++i) {
+            for (unsigned j = 0; j < LEVEL_SIZE; ++j) {
+                slots_[i][j] = nullptr;
+            }
+            occupied_[i] = 0;
+        }
+        ready_ = nullptr;
+        time_ = now;
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * Adds an entry to the wheel.
+     *
+     * If the entry is already scheduled, it is rescheduled. An entry whose expiration time has
+     * already passed expires on the next tick. The expiration time is relative to the time the
+     * wheel has been advanced to, so the wheel should be advanced before adding entries to it.
+     *
+     * @param entry Entry.
+     * @param expiry Expiration time.
+     */
+    void add(TimerWheelEntry* entry, uint32_t expiry) {
+        remove(entry);
+        entry->expiry_ = expiry;
+        insert(entry);
+    }
+
+    /**
+     * Removes an entry from the wheel.
+     *
+     * Does nothing if the entry is not scheduled.
+     *
+     * @param entry Entry.
+     */
+    void remove(TimerWheelEntry* entry) {
+        if (!entry->pprev_) {
+            return;
+        }
+        *entry->pprev_ = entry->next_;
+        if (entry->next_) {
+            entry->next_->pprev_ = entry->pprev_;
+        }
+        if (entry->level_ < LEVEL_COUNT && !slots_[entry->level_][entry->slot_]) {
+            occupied_[entry->level_] &= ~bit(entry->slot_);
+        }
+        entry->next_ = nullptr;
+        entry->pprev_ = nullptr;
+    }
+
+    /**
+     * Advances the wheel.
+     *
+     * The entries that have expired by the specified time can then be taken from the wheel via
+     * `takeExpired()`.
+     *
+     * @param now Current time.
+     */
+    void advance(uint32_t now) {
+        if (!hasPending()) {
+            time_ = now + 1;
+            return;
+        }
+        while ((int32_t)(now - time_) >= 0) {
+            const unsigned index = time_ & SLOT_MASK;
+            if (!index) {
+                cascade();
+            }
+            if (occupied_[0] & bit(index)) {
+                moveToReady(&slots_[0][index]);
+                occupied_[0] &= ~bit(index);
+            }
+            // Skip the empty slots up to the next occupied slot or the end of the first level
+            const uint64_t rest = occupied_[0] & ~((bit(index) << 1) - 1);
+            const uint32_t next = time_ - index + (rest ? (uint32_t)__builtin_ctzll(rest) : LEVEL_SIZE);
+            time_ = ((int32_t)(next - now) > 0) ? now + 1 : next;
+        }
+    }
+
+    /**
+     * Takes the next expired entry from the wheel.
+     *
+     * @return Expired entry, or `nullptr` if there are no more entries that have expired by the
+     *         time the wheel has been advanced to.
+     */
+    TimerWheelEntry* takeExpired() {
+        TimerWheelEntry* const entry = ready_;
+        if (entry) {
+            remove(entry);
+        }
+        return entry;
+    }
+
+    /**
+     * Advances the wheel and takes the next expired entry from it.
+     *
+     * This method needs to be called repeatedly until it returns `nullptr`.
+     *
+     * @param now Current time.
+     * @return Expired entry, or `nullptr` if there are no more entries that have expired by now.
+     */
+    TimerWheelEntry* expire(uint32_t now) {
+        advance(now);
+        return takeExpired();
+    }
+
+    /**
+     * Returns the time by which the wheel needs to be advanced next.
+     *
+     * The returned time is either the expiration time of the earliest entry, or an earlier
+     * time at which entries from an upper level need to be moved to the lower levels.
+     *
+     * @param[out] time Time.
+     * @return `true` if the wheel has any entries, or `false` otherwise.
+     */
+    bool nextTime(uint32_t* time) const {
+        if (ready_) {
+            *time = time_ - 1;
+            return true;
+        }
+        bool found = false;
+        uint32_t t = 0;
+        for (unsigned i = 0; i < LEVEL_COUNT; ++i) {
+            if (!occupied_[i]) {
+                continue;
+            }
+            const unsigned shift = i * LEVEL_BITS;
+            const unsigned current = (time_ >> shift) & SLOT_MASK;
+            uint32_t slotTime = 0;
+            if (!i) {
+                // An entry of the first level expires exactly at the time of its slot
+                slotTime = time_ + distance(occupied_[0], current);
+            } else {
+                // Entries of the upper levels are moved down when the wheel reaches their slot.
+                // The current slot is still pending if the wheel hasn't processed its first tick yet
+                const unsigned first = (time_ & (((uint32_t)1 << shift) - 1)) ? 1 : 0;
+                slotTime = ((time_ >> shift) + first + distance(occupied_[i], (current + first) & SLOT_MASK)) << shift;
+            }
+            if (!found || (int32_t)(slotTime - t) < 0) {
+                t = slotTime;
+                found = true;
+            }
+        }
+        if (found) {
+            *time = t;
+        }
+        return found;
+    }
+
+    /**
+     * Returns `true` if the wheel has no entries.
+     */
+    bool isEmpty() const {
+        return !ready_ && !hasPending();
+    }
+
+private:
+    static const unsigned SLOT_MASK = LEVEL_SIZE - 1;
+    static const uint8_t READY_LEVEL = LEVEL_COUNT;
+
+    static_assert(LEVEL_SIZE <= 64, "Slot bitmap is too small");
+
+    TimerWheelEntry* slots_[LEVEL_COUNT][LEVEL_SIZE];
+    uint64_t occupied_[LEVEL_COUNT]; // Bitmaps of the non-empty slots
+    TimerWheelEntry* ready_; // Expired entries
+    uint32_t time_; // Next tick to process
+
+    bool hasPending() const {
+        for (unsigned i = 0; i < LEVEL_COUNT; ++i) {
+            if (occupied_[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void insert(TimerWheelEntry* entry) {
+        int32_t delta = entry->expiry_ - time_;
+        if (delta < 0) {
+            delta = 0;
+        }
+        uint32_t t = entry->expiry_;
+        unsigned level = 0;
+        if ((uint32_t)delta > MAX_TIMEOUT) {
+            // Park the entry in the last slot within range, it is rescheduled once the wheel gets there
+            t = time_ + MAX_TIMEOUT;
+            level = LEVEL_COUNT - 1;
+        } else if (delta == 0) {
+            t = time_;
+        } else {
+            while (level < LEVEL_COUNT - 1 && (uint32_t)delta >= ((uint32_t)1 << ((level + 1) * LEVEL_BITS))) {
+                ++level;
+            }
+        }
+        const unsigned slot = (t >> (level * LEVEL_BITS)) & SLOT_MASK;
+        entry->level_ = level;
+        entry->slot_ = slot;
+        link(entry, &slots_[level][slot]);
+        occupied_[level] |= bit(slot);
+    }
+
+    void cascade() {
+        for (unsigned i = 1; i < LEVEL_COUNT; ++i) {
+            const unsigned index = (time_ >> (i * LEVEL_BITS)) & SLOT_MASK;
+            if (occupied_[i] & bit(index)) {
+                TimerWheelEntry* entry = slots_[i][index];
+                slots_[i][index] = nullptr;
+                occupied_[i] &= ~bit(index);
+                while (entry) {
+                    TimerWheelEntry* const next = entry->next_;
+                    entry->next_ = nullptr;
+                    entry->pprev_ = nullptr;
+                    insert(entry);
+                    entry = next;
+                }
+            }
+            if (index) {
+                break;
+            }
+        }
+    }
+
+    void moveToReady(TimerWheelEntry** slot) {
+        TimerWheelEntry* entry = *slot;
+        *slot = nullptr;
+        while (entry) {
+            TimerWheelEntry* const next = entry->next_;
+            entry->level_ = READY_LEVEL;
+            link(entry, &ready_);
+            entry = next;
+        }
+    }
+
+    static void link(TimerWheelEntry* entry, TimerWheelEntry** head) {
+        entry->next_ = *head;
+        if (*head) {
+            (*head)->pprev_ = &entry->next_;
+        }
+        entry->pprev_ = head;
+        *head = entry;
+    }
+
+    // Number of slots from `from` to the first occupied slot, wrapping around the level
+    static unsigned distance(uint64_t occupied, unsigned from) {
+        const uint64_t rotated = from ? ((occupied >> from) | (occupied << (LEVEL_SIZE - from))) : occupied;
+        return __builtin_ctzll(rotated);
+    }
+
+    static uint64_t bit(unsigned slot) {
+        return (uint64_t)1 << slot;
+    }
+};
+
+} // particle
@@ -19,12 +19,18 @@
 #define SERVICES_TLV_FILE_H
 
 #include "filesystem.h"
+#include "spark_wiring_vector.h"
 #include <stdio.h>
 
 namespace particle { namespace services { namespace settings {
 
 static constexpr uint32_t TLV_FILE_MAGICK = 0x714f11e5;
 static constexpr uint32_t TLV_HEADER_MAGICK = 0x4ead;
+static constexpr uint16_t TLV_HEADER_FLAG_DELETED = 0x0001;
+/* Deleted entries are removed from the file once they occupy at least this many bytes
+ * and at least a quarter of the file
+ */
+static constexpr size_t TLV_FILE_COMPACT_THRESHOLD = 512;
 
 class TlvFile {
 public:
@@ -47,6 +53,16 @@ public:
     int add(uint16_t key, const uint8_t* value, uint16_t length);
     int del(uint16_t key, int index = -1);
 
+    /* Removes deleted entries from the file */
+    int compact();
+
+    /* Defers committing the file to the flash until the matching call to commitTransaction().
+     * The changes made in the meantime are cached by the filesystem and committed at once.
+     * Transactions can be nested
+     */
+    int beginTransaction();
+    int commitTransaction();
+
 private:
     struct FileFooter {
         uint32_t reserved;  /* CRC32? */
@@ -61,10 +77,17 @@ private:
         uint16_t magick;
         uint16_t key;
         uint16_t length;
-        uint16_t reserved;
+        uint16_t flags;
     } __attribute__((__packed__));
     static_assert(sizeof(TlvHeader) == sizeof(uint32_t) * 2, "sizeof(TlvHeader) != 8");
 
+    /* Location of a live entry in the file */
+    struct IndexEntry {
+        uint32_t offset;
+        uint16_t key;
+        uint16_t length;
+    };
+
 private:
     lfs_t* lfs();
 
@@ -74,8 +97,13 @@ private:
 
     int mkdir(char* dir);
 
-    ssize_t find(uint16_t key, int index, uint16_t* dataSize);
+    int buildIndex();
+    int findEntry(uint16_t key, int index);
+    int insertEntry(const IndexEntry& entry);
+    int markDeleted(const IndexEntry& entry);
     int readFooter(FileFooter& footer);
+    int commitOrDefer();
+    bool needsCompaction() const;
 
     ssize_t seek(ssize_t offset, int whence = SEEK_SET);
     ssize_t read(uint8_t* buf, size_t length);
@@ -87,6 +115,14 @@ private:
     bool open_ = false;
     filesystem_t* fs_ = nullptr;
     lfs_file_t file_ = {};
+
+    /* Directory of live entries sorted by key and then by offset */
+    spark::Vector<IndexEntry> index_;
+    FileFooter footer_ = {};
+    size_t deletedSize_ = 0;
+    unsigned transactionDepth_ = 0;
+    /* The file has been modified since the transaction began */
+    bool dirty_ = false;
 };
 
 } } } /* namespace particle::services::settings */
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Hot-path tracing.
+ *
+ * Instrumented code records events into a static ring buffer. Every record contains a timestamp
+ * in CPU cycles, an event ID and an argument. Recording an event takes a few instructions and
+ * doesn't take any locks, so it can be done from threads and ISRs alike. When the buffer is full,
+ * the oldest records get overwritten.
+ *
+ * Tracing is disabled by default. Build with `PARTICLE_TRACE_ENABLED=1` to enable it.
+ */
+#ifndef PARTICLE_TRACE_ENABLED
+#define PARTICLE_TRACE_ENABLED 0
+#endif
+
+/**
+ * Number of records in the ring buffer. Must be a power of two.
+ */
+#ifndef PARTICLE_TRACE_BUFFER_SIZE
+#define PARTICLE_TRACE_BUFFER_SIZE 256
+#endif
+
+/**
+ * Trace events.
+ *
+ * The argument of a `_BEGIN` event is typically a size, and the argument of an `_END` event is
+ * the operation's result.
+ */
+typedef enum trace_event {
+    TRACE_EVENT_NONE = 0,
+    TRACE_EVENT_COAP_SEND = 1, ///< CoAP message is sent (argument: message ID).
+    TRACE_EVENT_DTLS_SEND_BEGIN = 2, ///< DTLS channel starts sending a message (argument: size).
+    TRACE_EVENT_DTLS_SEND_END = 3, ///< DTLS channel has sent a message (argument: result).
+    TRACE_EVENT_DTLS_RECEIVE_BEGIN = 4, ///< DTLS channel starts receiving a message.
+    TRACE_EVENT_DTLS_RECEIVE_END = 5, ///< DTLS channel has received a message (argument: result).
+    TRACE_EVENT_SOCK_SEND_BEGIN = 6, ///< Socket send operation starts (argument: size).
+    TRACE_EVENT_SOCK_SEND_END = 7, ///< Socket send operation ends (argument: result).
+    TRACE_EVENT_SOCK_RECV_BEGIN = 8, ///< Socket receive operation starts (argument: size).
+    TRACE_EVENT_SOCK_RECV_END = 9, ///< Socket receive operation ends (argument: result).
+    TRACE_EVENT_FLASH_WRITE_BEGIN = 10, ///< Internal flash write starts (argument: size).
+    TRACE_EVENT_FLASH_WRITE_END = 11, ///< Internal flash write ends (argument: result).
+    TRACE_EVENT_EXFLASH_WRITE_BEGIN = 12, ///< External flash write starts (argument: size).
+    TRACE_EVENT_EXFLASH_WRITE_END = 13, ///< External flash write ends (argument: result).
+    TRACE_EVENT_BOOT_STAGE_BEGIN = 14, ///< System initialization stage starts (argument: `trace_boot_stage`).
+    TRACE_EVENT_BOOT_STAGE_END = 15, ///< System initialization stage ends (argument: `trace_boot_stage`).
+    TRACE_EVENT_USER = 1000 ///< First event ID available to the application.
+} trace_event;
+
+/**
+ * System initialization stages.
+ */
+typedef enum trace_boot_stage {
+    TRACE_BOOT_STAGE_HAL = 1, ///< HAL and system module initialization.
+    TRACE_BOOT_STAGE_SETTINGS = 2, ///< Factory reset check, power management and diagnostics.
+    TRACE_BOOT_STAGE_RADIO = 3, ///< Radio antenna selection.
+    TRACE_BOOT_STAGE_BLE = 4, ///< BLE stack initialization.
+    TRACE_BOOT_STAGE_NETWORK_STACK = 5, ///< LwIP and OpenThread initialization.
+    TRACE_BOOT_STAGE_CONTROL = 6, ///< Control request channels initialization.
+    TRACE_BOOT_STAGE_USB = 7, ///< Safe mode check, USB and pending update check.
+    TRACE_BOOT_STAGE_NETWORK = 8, ///< Network interfaces setup.
+    TRACE_BOOT_STAGE_THREADS = 9, ///< System thread startup.
+    TRACE_BOOT_STAGE_SETUP = 10 ///< Application's setup().
+} trace_boot_stage;
+
+/**
+ * Trace record.
+ */
+typedef struct trace_record {
+    uint32_t timestamp; ///< Timestamp in CPU cycles. Wraps around.
+    uint16_t event; ///< Event ID (see `trace_event`).
+    uint16_t seq; ///< Sequence number of the record.
+    uint32_t arg; ///< Event argument.
+} trace_record;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Records an event.
+ *
+ * Use the `PARTICLE_TRACE()` macro rather than calling this function directly.
+ */
+void trace_event_record(uint16_t event, uint32_t arg);
+
+/**
+ * Copies the recorded events to a buffer, from the oldest to the newest one.
+ *
+ * Records that are overwritten while they are being copied are skipped.
+ *
+ * @param records Destination buffer.
+ * @param count Maximum number of records to copy.
+ * @return Number of copied records.
+ */
+size_t trace_get_records(trace_record* records, size_t count);
+
+/**
+ * Discards all recorded events.
+ */
+void trace_clear(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#if PARTICLE_TRACE_ENABLED
+#define PARTICLE_TRACE(_event, _arg) trace_event_record((_event), (uint32_t)(_arg))
+#else
+#define PARTICLE_TRACE(_event, _arg) do { } while (0)
+#endif
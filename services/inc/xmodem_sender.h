@@ -26,6 +26,12 @@ class Stream;
 class InputStream;
 
 // Class implementing the XMODEM-1K protocol
+//
+// The sender can optionally keep several packets in flight instead of waiting for each packet to
+// be acknowledged before sending the next one. The receiver acknowledges the packets in order,
+// so this works with any XMODEM receiver reading the data through a flow-controlled link, and
+// hides the round trip time of the acknowledgements. If a packet is rejected or an acknowledgement
+// times out, the sender falls back to stop-and-wait mode for the rest of the transfer
 class XmodemSender {
 public:
     enum Status {
@@ -36,7 +42,8 @@ public:
     XmodemSender();
     ~XmodemSender();
 
-    int init(Stream* dest, InputStream* src, size_t size);
+    // `windowSize` is the maximum number of unacknowledged packets
+    int init(Stream* dest, InputStream* src, size_t size, unsigned windowSize = 1);
     void destroy();
 
     // Returns one of the values defined by the `Status` enum or a negative value in case of an error.
@@ -49,7 +56,7 @@ private:
         NEW, // Uninitialized
         RECV_NCG, // Waiting for the receiver to initiate the transfer
         SEND_PACKET, // Sending a packet
-        RECV_PACKET_ACK, // Waiting for the packet acknowledgement
+        RECV_PACKET_ACK, // Waiting for a packet acknowledgement
         SEND_EOT, // Sending the "end of transmission" sequence
         RECV_EOT_ACK // Waiting for the "end of transmission" acknowledgement
     };
@@ -62,17 +69,24 @@ private:
     InputStream* srcStrm_; // Source stream
     Stream* destStrm_; // Destination stream
     size_t fileSize_; // File size
-    size_t fileOffs_; // Current offset in the file
+    size_t fileOffs_; // Number of bytes read from the source stream
 
-    size_t packetSize_; // Size of the current XMODEM packet
     size_t packetOffs_; // Number of transmitted bytes of the current packet
-    unsigned packetNum_; // Packet number
+    unsigned firstNum_; // Number of the oldest unacknowledged packet
+    unsigned nextNum_; // Number of the packet being sent
+    unsigned readNum_; // Number of the next packet to be read from the source stream
+    unsigned bufCount_; // Number of packet buffers
+    unsigned windowSize_; // Maximum number of unacknowledged packets
 
-    std::unique_ptr<char[]> buf_; // Packet buffer
+    std::unique_ptr<char[]> buf_; // Packet buffers
 
     int recvNcg();
     int sendPacket();
     int recvPacketAck();
+    int readPacket();
+    int packetAcked();
+    int resendPackets();
+    char* packetBuf(unsigned num) const;
     int sendEot();
     int recvEotAck();
 
@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hal_platform.h"
+
+#if HAL_PLATFORM_FILESYSTEM
+
+#include "async_file.h"
+
+#include "filesystem.h"
+#include "system_error.h"
+#include "check.h"
+#include "debug.h"
+
+#include <algorithm>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+
+namespace particle {
+
+namespace fs {
+
+namespace {
+
+const char* const THREAD_NAME = "fs";
+
+int lfsToSystemError(int error) {
+    switch (error) {
+    case LFS_ERR_NOENT:
+        return SYSTEM_ERROR_NOT_FOUND;
+    case LFS_ERR_NOMEM:
+        return SYSTEM_ERROR_NO_MEMORY;
+    case LFS_ERR_INVAL:
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    default:
+        return SYSTEM_ERROR_FILE;
+    }
+}
+
+} // unnamed
+
+AsyncFileService::AsyncFileService() :
+        thread_(OS_THREAD_INVALID_HANDLE),
+        sem_(nullptr),
+        busy_(false),
+        cachePath_(nullptr),
+        cacheOffset_(0),
+        cacheSize_(0) {
+}
+
+int AsyncFileService::read(const char* path, size_t offset, void* buf, size_t size, AsyncFileCallback callback,
+        void* data) {
+    CHECK_TRUE(path && (buf || !size), SYSTEM_ERROR_INVALID_ARGUMENT);
+    {
+        std::unique_lock<std::mutex> lk(mutex_);
+        // Serving the read from the cache while there are pending requests could reorder it
+        // with a preceding write
+        if (!busy_ && !queue_.front() && readCached(path, offset, buf, size)) {
+            lk.unlock();
+            if (callback) {
+                callback(size, data);
+            }
+            return 0;
+        }
+    }
+    return submit(Op::READ, path, offset, buf, size, callback, data);
+}
+
+int AsyncFileService::write(const char* path, size_t offset, const void* buf, size_t size, AsyncFileCallback callback,
+        void* data) {
+    CHECK_TRUE(path && (buf || !size), SYSTEM_ERROR_INVALID_ARGUMENT);
+    return submit(Op::WRITE, path, offset, buf, size, callback, data);
+}
+
+int AsyncFileService::append(const char* path, const void* buf, size_t size, AsyncFileCallback callback, void* data) {
+    CHECK_TRUE(path && (buf || !size), SYSTEM_ERROR_INVALID_ARGUMENT);
+    return submit(Op::APPEND, path, 0, buf, size, callback, data);
+}
+
+int AsyncFileService::remove(const char* path, AsyncFileCallback callback, void* data) {
+    CHECK_TRUE(path, SYSTEM_ERROR_INVALID_ARGUMENT);
+    return submit(Op::REMOVE, path, 0, nullptr, 0, callback, data);
+}
+
+int AsyncFileService::sync(AsyncFileCallback callback, void* data) {
+    return submit(Op::SYNC, nullptr, 0, nullptr, 0, callback, data);
+}
+
+AsyncFileService* AsyncFileService::instance() {
+    static AsyncFileService service;
+    return &service;
+}
+
+int AsyncFileService::init() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (thread_ != OS_THREAD_INVALID_HANDLE) {
+        return 0;
+    }
+    if (!sem_) {
+        CHECK_TRUE(os_semaphore_create(&sem_, 1, 0) == 0, SYSTEM_ERROR_NO_MEMORY);
+    }
+    CHECK_TRUE(os_thread_create(&thread_, THREAD_NAME, OS_THREAD_PRIORITY_DEFAULT, run, this,
+            OS_THREAD_STACK_SIZE_DEFAULT) == 0, SYSTEM_ERROR_NO_MEMORY);
+    return 0;
+}
+
+int AsyncFileService::submit(Op op, const char* path, size_t offset, const void* buf, size_t size,
+        AsyncFileCallback callback, void* data) {
+    CHECK(init());
+    const auto req = new(std::nothrow) Request();
+    CHECK_TRUE(req, SYSTEM_ERROR_NO_MEMORY);
+    req->op = op;
+    req->offset = offset;
+    req->size = size;
+    req->callback = callback;
+    req->data = data;
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (op == Op::APPEND) {
+        const auto last = queue_.back();
+        if (last && last->op == Op::APPEND && !strcmp(last->path, path) && last->capacity - last->size >= size) {
+            // Collect the data in the write-behind buffer of the pending request
+            memcpy(last->buf + last->size, buf, size);
+            last->size += size;
+            last->merged.pushBack(req);
+            return 0;
+        }
+    }
+    if (path) {
+        req->path = strdup(path);
+        if (!req->path) {
+            freeRequest(req);
+            return SYSTEM_ERROR_NO_MEMORY;
+        }
+    }
+    if (op == Op::READ) {
+        req->buf = (char*)buf;
+    } else if (op == Op::WRITE || op == Op::APPEND) {
+        req->capacity = (op == Op::APPEND) ? std::max(size, WRITE_BEHIND_SIZE) : size;
+        req->buf = (char*)malloc(req->capacity);
+        if (!req->buf && req->capacity) {
+            freeRequest(req);
+            return SYSTEM_ERROR_NO_MEMORY;
+        }
+        memcpy(req->buf, buf, size);
+    }
+    queue_.pushBack(req);
+    lk.unlock();
+    os_semaphore_give(sem_, false);
+    return 0;
+}
+
+bool AsyncFileService::readCached(const char* path, size_t offset, void* buf, size_t size) {
+    if (!cachePath_ || strcmp(cachePath_, path) != 0 || offset < cacheOffset_ ||
+            offset + size > cacheOffset_ + cacheSize_) {
+        return false;
+    }
+    memcpy(buf, cache_ + (offset - cacheOffset_), size);
+    return true;
+}
+
+void AsyncFileService::invalidateCache(const char* path) {
+    if (cachePath_ && (!path || !strcmp(cachePath_, path))) {
+        free(cachePath_);
+        cachePath_ = nullptr;
+        cacheSize_ = 0;
+    }
+}
+
+void AsyncFileService::process(Request* req) {
+    int r = 0;
+    switch (req->op) {
+    case Op::READ: {
+        r = readFile(req);
+        break;
+    }
+    case Op::WRITE:
+    case Op::APPEND: {
+        r = writeFile(req);
+        break;
+    }
+    case Op::REMOVE: {
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            invalidateCache(req->path);
+        }
+        const auto fs = filesystem_get_instance(nullptr);
+        FsLock lk(fs);
+        r = lfs_remove(&fs->instance, req->path);
+        if (r < 0) {
+            r = lfsToSystemError(r);
+        }
+        break;
+    }
+    case Op::SYNC:
+    default:
+        break;
+    }
+    complete(req, r);
+}
+
+int AsyncFileService::readFile(Request* req) {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (readCached(req->path, req->offset, req->buf, req->size)) {
+            return req->size;
+        }
+    }
+    const auto fs = filesystem_get_instance(nullptr);
+    char tmp[READ_AHEAD_SIZE];
+    int r = 0;
+    {
+        FsLock lk(fs);
+        lfs_file_t file = {};
+        r = lfs_file_open(&fs->instance, &file, req->path, LFS_O_RDONLY);
+        if (r < 0) {
+            return lfsToSystemError(r);
+        }
+        r = lfs_file_seek(&fs->instance, &file, req->offset, LFS_SEEK_SET);
+        if (r >= 0) {
+            if (req->size >= READ_AHEAD_SIZE) {
+                // Large reads go directly to the caller's buffer
+                r = lfs_file_read(&fs->instance, &file, req->buf, req->size);
+            } else {
+                r = lfs_file_read(&fs->instance, &file, tmp, sizeof(tmp));
+            }
+        }
+        lfs_file_close(&fs->instance, &file);
+    }
+    if (r < 0) {
+        return lfsToSystemError(r);
+    }
+    if (req->size >= READ_AHEAD_SIZE) {
+        return r;
+    }
+    std::lock_guard<std::mutex> lk(mutex_);
+    invalidateCache(nullptr);
+    cachePath_ = strdup(req->path);
+    if (cachePath_) {
+        memcpy(cache_, tmp, r);
+        cacheOffset_ = req->offset;
+        cacheSize_ = r;
+    }
+    r = std::min((size_t)r, req->size);
+    memcpy(req->buf, tmp, r);
+    return r;
+}
+
+int AsyncFileService::writeFile(Request* req) {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        invalidateCache(req->path);
+    }
+    const auto fs = filesystem_get_instance(nullptr);
+    FsLock lk(fs);
+    lfs_file_t file = {};
+    int flags = LFS_O_WRONLY | LFS_O_CREAT;
+    if (req->op == Op::APPEND) {
+        flags |= LFS_O_APPEND;
+    }
+    int r = lfs_file_open(&fs->instance, &file, req->path, flags);
+    if (r < 0) {
+        return lfsToSystemError(r);
+    }
+    if (req->op == Op::WRITE) {
+        r = lfs_file_seek(&fs->instance, &file, req->offset, LFS_SEEK_SET);
+    }
+    if (r >= 0) {
+        r = lfs_file_write(&fs->instance, &file, req->buf, req->size);
+    }
+    const int closeResult = lfs_file_close(&fs->instance, &file);
+    if (r >= 0 && closeResult < 0) {
+        r = closeResult;
+    }
+    if (r < 0) {
+        return lfsToSystemError(r);
+    }
+    return r;
+}
+
+void AsyncFileService::complete(Request* req, int result) {
+    int ownResult = result;
+    for (auto m = req->merged.front(); m; m = m->next) {
+        if (ownResult >= 0) {
+            ownResult -= m->size;
+        }
+    }
+    if (req->callback) {
+        req->callback(ownResult, req->data);
+    }
+    while (const auto m = req->merged.popFront()) {
+        if (m->callback) {
+            m->callback((result < 0) ? result : (int)m->size, m->data);
+        }
+        freeRequest(m);
+    }
+}
+
+void AsyncFileService::run(void* arg) {
+    const auto self = static_cast<AsyncFileService*>(arg);
+    {
+        const auto fs = filesystem_get_instance(nullptr);
+        FsLock lk(fs);
+        SPARK_ASSERT(filesystem_mount(fs) == 0);
+    }
+    for (;;) {
+        Request* req = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(self->mutex_);
+            req = self->queue_.popFront();
+            self->busy_ = (req != nullptr);
+        }
+        if (!req) {
+            os_semaphore_take(self->sem_, CONCURRENT_WAIT_FOREVER, false);
+            continue;
+        }
+        self->process(req);
+        freeRequest(req);
+    }
+}
+
+void AsyncFileService::freeRequest(Request* req) {
+    if (req->op == Op::WRITE || req->op == Op::APPEND) {
+        free(req->buf);
+    }
+    free(req->path);
+    delete req;
+}
+
+} // particle::fs
+
+} // particle
+
+#endif // HAL_PLATFORM_FILESYSTEM
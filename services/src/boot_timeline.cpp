@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "boot_timeline.h"
+
+#include "timer_hal.h"
+#include "system_error.h"
+
+#include <cstring>
+
+#if defined(__arm__)
+// The retained section is not initialized on startup
+#define BOOT_TIMELINE_RETAINED __attribute__((section(".retained_system")))
+#else
+#define BOOT_TIMELINE_RETAINED
+#endif
+
+namespace {
+
+// Marks a timeline that has been started. Retained memory contains garbage after a power cycle
+const uint32_t TIMELINE_MAGIC = 0x8e17b007;
+
+struct RetainedTimeline {
+    uint32_t magic;
+    boot_timeline timeline;
+};
+
+BOOT_TIMELINE_RETAINED RetainedTimeline g_current;
+BOOT_TIMELINE_RETAINED RetainedTimeline g_previous;
+
+const char* const STAGE_NAMES[BOOT_STAGE_COUNT] = {
+    "start",
+    "hal_config",
+    "fs_mount",
+    "dct_load",
+    "module_init",
+    "network_init",
+    "thread_start",
+    "setup",
+    "setup_done"
+};
+
+void startTimeline() {
+    memset(&g_current.timeline, 0, sizeof(g_current.timeline));
+    g_current.magic = TIMELINE_MAGIC;
+}
+
+} // unnamed
+
+void boot_timeline_mark(int stage, void* reserved) {
+    if (stage < 0 || stage >= BOOT_STAGE_COUNT) {
+        return;
+    }
+    const uint32_t time = HAL_Timer_Get_Micro_Seconds();
+    if (stage == BOOT_STAGE_START) {
+        if (g_current.magic == TIMELINE_MAGIC) {
+            g_previous = g_current;
+        } else {
+            g_previous.magic = 0;
+        }
+        startTimeline();
+    } else if (g_current.magic != TIMELINE_MAGIC) {
+        // The platform doesn't record the start of the boot
+        startTimeline();
+    }
+    const uint32_t mask = (uint32_t)1 << stage;
+    if (!(g_current.timeline.stages & mask)) {
+        g_current.timeline.time[stage] = time;
+        g_current.timeline.stages |= mask;
+    }
+}
+
+int boot_timeline_get(boot_timeline* timeline, int previous, void* reserved) {
+    const RetainedTimeline& t = previous ? g_previous : g_current;
+    if (t.magic != TIMELINE_MAGIC) {
+        return SYSTEM_ERROR_NOT_FOUND;
+    }
+    *timeline = t.timeline;
+    return 0;
+}
+
+const char* boot_stage_name(int stage) {
+    if (stage < 0 || stage >= BOOT_STAGE_COUNT) {
+        return nullptr;
+    }
+    return STAGE_NAMES[stage];
+}
@@ -107,6 +107,7 @@ private:
 class LEDService {
 public:
     LEDService() :
+            state_{},
             color_{ 0 },
             pattern_(LED_PATTERN_INVALID),
             period_(0),
@@ -155,33 +156,31 @@ public:
     }
 
     void update(system_tick_t ticks) {
-        uint32_t color = 0;
-        uint16_t period = 0;
-        uint8_t pattern = LED_PATTERN_INVALID;
-        uint8_t flags = 0;
+        State state = {};
         bool enabled = false;
         bool reset = false;
-        // TODO: Add some flag to avoid locking if the queue has not changed since last update
         LED_SERVICE_WITH_LOCK(lock_) {
             LEDStatusData* s = queue_.front();
             if (s) {
                 // Copy status parameters
-                pattern = s->pattern;
-                if (pattern == LED_PATTERN_CUSTOM) { // Custom pattern
+                state.pattern = s->pattern;
+                if (state.pattern == LED_PATTERN_CUSTOM) { // Custom pattern
                     s->callback(ticks, s->data);
                 } else { // Predefined pattern
-                    period = s->period;
+                    state.period = s->period;
                 }
-                color = s->color;
-                flags = s->flags;
+                state.color = s->color;
+                state.flags = s->flags;
+                state.brightness = led_rgb_brightness;
                 enabled = !disabled_;
                 reset = reset_;
                 reset_ = false;
             }
         }
-        if (pattern_ != pattern || period_ != period) {
-            pattern_ = pattern;
-            period_ = period;
+        const uint16_t prevTicks = ticks_;
+        if (pattern_ != state.pattern || period_ != state.period) {
+            pattern_ = state.pattern;
+            period_ = state.period;
             ticks_ = 0; // Restart pattern "animation"
         } else if (period_ > 0) {
             ticks_ += ticks;
@@ -189,19 +188,25 @@ public:
                 ticks_ %= period_;
             }
         }
-        if (enabled) {
-            Color c = { 0 }; // Black
-            if (!(flags & LED_STATUS_FLAG_OFF)) {
-                scaleColor(color, led_rgb_brightness, &c); // Use global LED brightness
-                if (period_ > 0) {
-                    updatePatternColor(pattern_, ticks_, period_, &c);
-                }
-            }
-            if (reset || color_.r != c.r || color_.g != c.g || color_.b != c.b) {
-                setLedColor(c);
-                color_ = c;
+        if (!enabled) {
+            return;
+        }
+        if (!reset && state == state_ && !patternChanged(prevTicks)) {
+            // Nothing affecting the LED color has changed since the last update
+            return;
+        }
+        state_ = state;
+        Color c = { 0 }; // Black
+        if (!(state.flags & LED_STATUS_FLAG_OFF)) {
+            scaleColor(state.color, state.brightness, &c); // Use global LED brightness
+            if (period_ > 0) {
+                updatePatternColor(pattern_, ticks_, period_, &c);
             }
         }
+        if (reset || color_.r != c.r || color_.g != c.g || color_.b != c.b) {
+            setLedColor(c);
+            color_ = c;
+        }
     }
 
 private:
@@ -209,8 +214,23 @@ private:
         uint16_t r, g, b; // Scaled color components
     };
 
+    // Parameters of the active status the LED color was last computed from
+    struct State {
+        uint32_t color;
+        uint16_t period;
+        uint8_t pattern;
+        uint8_t flags;
+        uint8_t brightness;
+
+        bool operator==(const State& s) const {
+            return color == s.color && period == s.period && pattern == s.pattern && flags == s.flags &&
+                    brightness == s.brightness;
+        }
+    };
+
     StatusQueue queue_; // Status queue
 
+    State state_; // Cached status parameters
     Color color_; // Current LED color
     uint8_t pattern_; // Current pattern type
     uint16_t period_; // Current pattern period in milliseconds
@@ -221,6 +241,22 @@ private:
 
     LED_SERVICE_DECLARE_LOCK(lock_); // Platform-specific lock
 
+    // Returns true if the current pattern changes the LED color between the specified and current
+    // position within the pattern period
+    bool patternChanged(uint16_t prevTicks) const {
+        switch (pattern_) {
+        case LED_PATTERN_BLINK: {
+            // The LED is only switched at the beginning and in the middle of the period
+            const uint16_t half = period_ / 2;
+            return (prevTicks < half) != (ticks_ < half) || ticks_ < prevTicks;
+        }
+        case LED_PATTERN_FADE:
+            return period_ > 0 && ticks_ != prevTicks;
+        default:
+            return false; // Solid color
+        }
+    }
+
     // Updates color according to specified pattern and timing
     static void updatePatternColor(uint8_t pattern, uint16_t ticks, uint16_t period, Color* color) {
         switch (pattern) {
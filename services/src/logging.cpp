@@ -67,18 +67,30 @@ namespace {
 volatile log_message_callback_type log_msg_callback = 0;
 volatile log_write_callback_type log_write_callback = 0;
 volatile log_enabled_callback_type log_enabled_callback = 0;
+volatile int log_level_threshold = LOG_LEVEL_ALL;
+
+// Returns the callback, or null if the messages of the specified level are discarded
+template<typename T>
+inline T callback_for_level(const volatile T& callback, int level) {
+    return (level >= log_level_threshold) ? callback : nullptr;
+}
 
 } // namespace
 
 void log_set_callbacks(log_message_callback_type log_msg, log_write_callback_type log_write,
         log_enabled_callback_type log_enabled, void *reserved) {
+    log_level_threshold = LOG_LEVEL_ALL;
     log_msg_callback = log_msg;
     log_write_callback = log_write;
     log_enabled_callback = log_enabled;
 }
 
+void log_set_level_threshold(int level, void *reserved) {
+    log_level_threshold = level;
+}
+
 void log_message_v(int level, const char *category, LogAttributes *attr, void *reserved, const char *fmt, va_list args) {
-    const log_message_callback_type msg_callback = log_msg_callback;
+    const log_message_callback_type msg_callback = callback_for_level(log_msg_callback, level);
     if (!msg_callback && (!log_compat_callback || level < log_compat_level)) {
         return;
     }
@@ -130,7 +142,7 @@ void log_write(int level, const char *category, const char *data, size_t size, v
     if (!size) {
         return;
     }
-    const log_write_callback_type write_callback = log_write_callback;
+    const log_write_callback_type write_callback = callback_for_level(log_write_callback, level);
     if (write_callback) {
         write_callback(data, size, level, category, 0);
     } else if (log_compat_callback && level >= log_compat_level) {
@@ -154,7 +166,7 @@ void log_write(int level, const char *category, const char *data, size_t size, v
 }
 
 void log_printf_v(int level, const char *category, void *reserved, const char *fmt, va_list args) {
-    const log_write_callback_type write_callback = log_write_callback;
+    const log_write_callback_type write_callback = callback_for_level(log_write_callback, level);
     if (!write_callback && (!log_compat_callback || level < log_compat_level)) {
         return;
     }
@@ -179,7 +191,7 @@ void log_printf(int level, const char *category, void *reserved, const char *fmt
 }
 
 void log_dump(int level, const char *category, const void *data, size_t size, int flags, void *reserved) {
-    const log_write_callback_type write_callback = log_write_callback;
+    const log_write_callback_type write_callback = callback_for_level(log_write_callback, level);
     if (!size || (!write_callback && (!log_compat_callback || level < log_compat_level))) {
         return;
     }
@@ -210,8 +222,45 @@ void log_dump(int level, const char *category, const void *data, size_t size, in
     }
 }
 
+void log_message_deferred(int level, const char *category, uint32_t fmt_id, const void *args, size_t size,
+        void *reserved) {
+    const log_write_callback_type write_callback = callback_for_level(log_write_callback, level);
+    if (!write_callback) {
+        return;
+    }
+    const uint32_t time = HAL_Timer_Get_Milli_Seconds();
+    uint8_t buf[0xff + 2];
+    size_t offs = 0;
+    buf[offs++] = LOG_DEFERRED_FRAME_START;
+    ++offs; // Frame size
+    buf[offs++] = level;
+    for (unsigned i = 0; i < 4; ++i) {
+        buf[offs++] = (time >> (i * 8)) & 0xff;
+    }
+    for (unsigned i = 0; i < 4; ++i) {
+        buf[offs++] = (fmt_id >> (i * 8)) & 0xff;
+    }
+    // The frame size is limited to 255 bytes; truncate the category name and arguments if necessary
+    const size_t catLen = category ? std::min(strlen(category), sizeof(buf) - offs - 1) : 0;
+    buf[offs++] = catLen;
+    if (catLen) {
+        memcpy(buf + offs, category, catLen);
+        offs += catLen;
+    }
+    size = std::min(size, sizeof(buf) - offs);
+    if (size) {
+        memcpy(buf + offs, args, size);
+        offs += size;
+    }
+    buf[1] = offs - 2;
+    write_callback((const char*)buf, offs, level, category, 0);
+}
+
 int log_enabled(int level, const char *category, void *reserved) {
     const log_enabled_callback_type enabled_callback = log_enabled_callback;
+    if (enabled_callback && level < log_level_threshold) {
+        return 0;
+    }
     if (enabled_callback) {
         return enabled_callback(level, category, 0);
     }
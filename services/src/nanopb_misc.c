@@ -18,6 +18,29 @@
 #include "nanopb_misc.h"
 
 #include <stdlib.h>
+#include <stdint.h>
+
+// The size of a growable buffer is a multiple of this value
+#define GROWABLE_BUFFER_CHUNK_SIZE 128
+
+static bool write_growable_buffer_callback(pb_ostream_t* strm, const uint8_t* data, size_t size) {
+    pb_growable_buffer* const buf = (pb_growable_buffer*)strm->state;
+    const size_t offs = buf->offset + strm->bytes_written;
+    if (offs + size > buf->size) {
+        size_t new_size = buf->size + buf->size / 2;
+        if (new_size < offs + size) {
+            new_size = offs + size;
+        }
+        new_size = (new_size + GROWABLE_BUFFER_CHUNK_SIZE - 1) / GROWABLE_BUFFER_CHUNK_SIZE * GROWABLE_BUFFER_CHUNK_SIZE;
+        const int ret = buf->realloc_fn(buf, new_size);
+        if (ret < 0) {
+            buf->error = ret;
+            return false;
+        }
+    }
+    memcpy(buf->data + offs, data, size);
+    return true;
+}
 
 #if HAL_PLATFORM_FILESYSTEM
 #include "filesystem.h"
@@ -94,6 +117,18 @@ bool pb_istream_from_buffer_ex(pb_istream_t* stream, const pb_byte_t *buf, size_
     return false;
 }
 
+bool pb_ostream_from_growable_buffer(pb_ostream_t* stream, pb_growable_buffer* buf, void* reserved) {
+    if (!stream || !buf || !buf->realloc_fn) {
+        return false;
+    }
+    memset(stream, 0, sizeof(pb_ostream_t));
+    stream->callback = write_growable_buffer_callback;
+    stream->state = buf;
+    stream->max_size = SIZE_MAX;
+    buf->error = 0;
+    return true;
+}
+
 #if HAL_PLATFORM_FILESYSTEM
 
 bool pb_ostream_from_file(pb_ostream_t* stream, lfs_file_t* file, void* reserved) {
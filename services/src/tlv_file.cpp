@@ -67,6 +67,11 @@ int TlvFile::init() {
         ret = open();
     }
 
+    if (!ret && needsCompaction()) {
+        /* Not critical */
+        compact();
+    }
+
     return ret;
 }
 
@@ -78,6 +83,8 @@ int TlvFile::purge() {
     FsLock lk(fs_);
 
     close();
+    transactionDepth_ = 0;
+    dirty_ = false;
 
     return lfs_remove(lfs(), path_);
 }
@@ -119,17 +126,18 @@ ssize_t TlvFile::get(uint16_t key, uint8_t* value, uint16_t length, int index) {
         return SYSTEM_ERROR_INVALID_ARGUMENT;
     }
 
-    uint16_t dataSize;
+    const int i = findEntry(key, index);
+    if (i < 0) {
+        return i;
+    }
+
     ssize_t ret = SYSTEM_ERROR_NOT_FOUND;
-    ssize_t pos = find(key, index, &dataSize);
-    if (pos >= 0) {
-        /* Found it */
-        const size_t toRead = std::min(length, dataSize);
-        if (toRead) {
-            ret = seek(pos + sizeof(TlvHeader));
-            if (ret >= 0) {
-                ret = read(value, toRead);
-            }
+    const IndexEntry& entry = index_[i];
+    const size_t toRead = std::min(length, entry.length);
+    if (toRead) {
+        ret = seek(entry.offset + sizeof(TlvHeader));
+        if (ret >= 0) {
+            ret = read(value, toRead);
         }
     }
 
@@ -143,13 +151,17 @@ int TlvFile::set(uint16_t key, const uint8_t* value, uint16_t length, int index)
         return SYSTEM_ERROR_INVALID_STATE;
     }
 
+    /* Commit the removal of the previous entry along with the new one */
+    beginTransaction();
+
     /* Delete previous entry */
     int ret = del(key, index);
-    if (!(ret == 0 || ret == SYSTEM_ERROR_NOT_FOUND)) {
-        return ret;
+    if (ret == 0 || ret == SYSTEM_ERROR_NOT_FOUND) {
+        ret = add(key, value, length);
     }
 
-    return add(key, value, length);
+    const int r = commitTransaction();
+    return ret ? ret : r;
 }
 
 int TlvFile::add(uint16_t key, const uint8_t* value, uint16_t length) {
@@ -159,18 +171,13 @@ int TlvFile::add(uint16_t key, const uint8_t* value, uint16_t length) {
         return SYSTEM_ERROR_INVALID_STATE;
     }
 
-    FileFooter footer;
-    int ret = readFooter(footer);
-    if (ret < 0) {
-        return ret;
-    }
-    ssize_t pos = footer.size;
-
-    if (pos < 0) {
-        return pos;
+    /* Make sure the new entry can be indexed before modifying the file */
+    if (!index_.reserve(index_.size() + 1)) {
+        return SYSTEM_ERROR_NO_MEMORY;
     }
 
-    ret = seek(pos);
+    const size_t pos = footer_.size;
+    int ret = seek(pos);
     if (ret < 0) {
         return ret;
     }
@@ -191,6 +198,7 @@ int TlvFile::add(uint16_t key, const uint8_t* value, uint16_t length) {
         return ret;
     }
     /* Write file footer */
+    FileFooter footer = footer_;
     footer.magick = TLV_FILE_MAGICK;
     footer.size += sizeof(header) + length;
     ret = write((const uint8_t*)&footer, sizeof(footer));
@@ -198,7 +206,13 @@ int TlvFile::add(uint16_t key, const uint8_t* value, uint16_t length) {
         return ret;
     }
 
-    return sync();
+    footer_ = footer;
+    ret = insertEntry({ (uint32_t)pos, key, length });
+    if (ret < 0) {
+        return ret;
+    }
+
+    return commitOrDefer();
 }
 
 int TlvFile::del(uint16_t key, int index) {
@@ -208,84 +222,195 @@ int TlvFile::del(uint16_t key, int index) {
         return SYSTEM_ERROR_INVALID_STATE;
     }
 
-    int ret = 0;
+    int i = findEntry(key, index);
+    if (i < 0) {
+        return i;
+    }
 
-    for (;;) {
-        uint16_t dataSize = 0;
-        ssize_t pos = find(key, index, &dataSize);
-        if (pos < 0) {
-            return pos;
+    int count = 1;
+    if (index < 0) {
+        /* Delete all entries with this key */
+        while (i > 0 && index_[i - 1].key == key) {
+            --i;
+            ++count;
         }
+    }
 
-        /* FIXME: this will only work on LittleFS. Provide a different implementation later
-         * when filesystem API is finalized and TlvFile implementation is refactored not to use
-         * LittleFS API.
-         */
-        const ssize_t fileSize = size();
+    /* Entries are only marked as deleted here. The space they occupy is reclaimed once enough
+     * deleted entries have accumulated in the file
+     */
+    for (int j = i; j < i + count; ++j) {
+        const int ret = markDeleted(index_[j]);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+    index_.removeAt(i, count);
 
-        FileFooter footer;
-        ret = readFooter(footer);
+    int ret = commitOrDefer();
+    if (ret) {
+        return ret;
+    }
 
-        while (ret == 0) {
-            lfs_file_t f;
-            ret = lfs_file_open(lfs(), &f, path_, LFS_O_RDONLY);
-            if (ret) {
-                break;
-            }
+    /* The file is compacted once the transaction is committed */
+    if (!transactionDepth_ && needsCompaction()) {
+        ret = compact();
+    }
 
-            size_t wpos = pos;
-            size_t rpos = wpos + sizeof(TlvHeader) + dataSize;
+    return ret;
+}
 
-            ret = seek(wpos);
-            if (ret < 0) {
-                break;
-            }
+int TlvFile::beginTransaction() {
+    FsLock lk(fs_);
 
-            ret = lfs_file_seek(lfs(), &f, rpos, LFS_SEEK_SET);
-            if (ret < 0) {
-                break;
-            }
+    if (!open_) {
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
 
-            for (; rpos < footer.size && ret > 0; ++wpos, ++rpos) {
-                uint8_t tmp;
-                ret = lfs_file_read(lfs(), &f, &tmp, sizeof(tmp));
-                if (ret < 0) {
-                    break;
-                }
+    ++transactionDepth_;
+
+    return 0;
+}
+
+int TlvFile::commitTransaction() {
+    FsLock lk(fs_);
+
+    if (!transactionDepth_) {
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
+
+    if (--transactionDepth_ || !dirty_) {
+        return 0;
+    }
+
+    dirty_ = false;
+
+    int ret = sync();
+    if (ret) {
+        return ret;
+    }
+
+    if (needsCompaction()) {
+        ret = compact();
+    }
+
+    return ret;
+}
+
+int TlvFile::compact() {
+    FsLock lk(fs_);
+
+    if (!open_) {
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
+
+    if (!deletedSize_) {
+        return 0;
+    }
+
+    /* FIXME: this will only work on LittleFS. The live entries are moved towards the beginning
+     * of the file in place, while the original contents of the file are read via another handle
+     */
+    lfs_file_t f;
+    int ret = lfs_file_open(lfs(), &f, path_, LFS_O_RDONLY);
+    if (ret) {
+        return ret;
+    }
+
+    size_t rpos = 0;
+    size_t wpos = 0;
+    while (rpos + sizeof(TlvHeader) <= footer_.size) {
+        TlvHeader header;
+        ret = lfs_file_seek(lfs(), &f, rpos, LFS_SEEK_SET);
+        if (ret < 0) {
+            break;
+        }
+        ret = lfs_file_read(lfs(), &f, &header, sizeof(header));
+        if (ret < (int)sizeof(header)) {
+            ret = SYSTEM_ERROR_BAD_DATA;
+            break;
+        }
+
+        if (header.magick != TLV_HEADER_MAGICK) {
+            /* Skip garbage */
+            rpos += sizeof(uint16_t);
+            continue;
+        }
 
-                ret = write(&tmp, sizeof(tmp));
+        const size_t entrySize = sizeof(TlvHeader) + header.length;
+        if (rpos + entrySize > footer_.size) {
+            /* Truncated entry */
+            break;
+        }
+
+        if (!(header.flags & TLV_HEADER_FLAG_DELETED)) {
+            if (rpos != wpos) {
+                ret = seek(wpos);
                 if (ret < 0) {
                     break;
                 }
-            }
-
-            if (ret > 0) {
-                /* Write footer */
-                footer.size -= sizeof(TlvHeader) + dataSize;
-                ret = write((const uint8_t*)&footer, sizeof(footer));
+                ret = write((const uint8_t*)&header, sizeof(header));
                 if (ret < 0) {
                     break;
                 }
-                /* Truncate */
-                ret = lfs_file_truncate(lfs(), &file_, fileSize - (sizeof(TlvHeader) + dataSize));
+                for (size_t n = header.length; n > 0;) {
+                    uint8_t buf[64];
+                    const size_t chunkSize = std::min(n, sizeof(buf));
+                    ret = lfs_file_read(lfs(), &f, buf, chunkSize);
+                    if (ret < (int)chunkSize) {
+                        if (ret >= 0) {
+                            ret = SYSTEM_ERROR_BAD_DATA;
+                        }
+                        break;
+                    }
+                    ret = write(buf, chunkSize);
+                    if (ret < 0) {
+                        break;
+                    }
+                    n -= chunkSize;
+                }
                 if (ret < 0) {
                     break;
                 }
-                ret = sync();
             }
-
-            lfs_file_close(lfs(), &f);
-
-            break;
+            wpos += entrySize;
         }
+        rpos += entrySize;
+    }
 
+    lfs_file_close(lfs(), &f);
 
-        if (ret || index >= 0) {
-            break;
-        }
+    if (ret < 0) {
+        /* Reopen the file to make the index consistent with its contents */
+        close();
+        open();
+        return ret;
     }
 
-    return ret;
+    /* Write footer */
+    FileFooter footer = footer_;
+    footer.size = wpos;
+    ret = seek(wpos);
+    if (ret < 0) {
+        return ret;
+    }
+    ret = write((const uint8_t*)&footer, sizeof(footer));
+    if (ret < 0) {
+        return ret;
+    }
+    /* Truncate */
+    ret = lfs_file_truncate(lfs(), &file_, wpos + sizeof(footer));
+    if (ret < 0) {
+        return ret;
+    }
+    ret = sync();
+    if (ret) {
+        return ret;
+    }
+
+    /* Offsets of the entries have changed */
+    footer_ = footer;
+    return buildIndex();
 }
 
 lfs_t* TlvFile::lfs() {
@@ -310,6 +435,10 @@ int TlvFile::open() {
     FileFooter footer = {};
 
     if (!validate()) {
+        r = readFooter(footer_);
+        if (!r) {
+            r = buildIndex();
+        }
         goto open_done;
     }
 
@@ -332,6 +461,10 @@ int TlvFile::open() {
         goto open_done;
     }
 
+    footer_ = footer;
+    index_.clear();
+    deletedSize_ = 0;
+
     r = sync();
 
 open_done:
@@ -346,7 +479,7 @@ int TlvFile::validate() {
     FileFooter footer = {};
     int ret = readFooter(footer);
     if (!ret) {
-        if (footer.magick != TLV_FILE_MAGICK) {
+        if (footer.magick != TLV_FILE_MAGICK || footer.size + sizeof(footer) > (size_t)size()) {
             ret = SYSTEM_ERROR_BAD_DATA;
         }
     }
@@ -364,6 +497,8 @@ int TlvFile::close() {
     /* Close */
 
     open_ = false;
+    index_.clear();
+    deletedSize_ = 0;
 
     return lfs_file_close(lfs(), &file_);
 }
@@ -441,55 +576,115 @@ int TlvFile::readFooter(FileFooter& footer) {
     return SYSTEM_ERROR_BAD_DATA;
 }
 
-ssize_t TlvFile::find(uint16_t key, int index, uint16_t* dataSize) {
-    FileFooter footer;
-    int r = readFooter(footer);
-    if (r) {
-        return r;
+int TlvFile::commitOrDefer() {
+    if (transactionDepth_) {
+        dirty_ = true;
+        return 0;
     }
 
-    ssize_t candidatePos = -1;
-    int candidateIdx = -1;
-    uint16_t candidateSize = 0;
+    return sync();
+}
+
+bool TlvFile::needsCompaction() const {
+    return deletedSize_ >= TLV_FILE_COMPACT_THRESHOLD && deletedSize_ * 4 >= footer_.size;
+}
+
+int TlvFile::buildIndex() {
+    index_.clear();
+    deletedSize_ = 0;
 
     TlvHeader header;
-    for (ssize_t pos = 0; pos >= 0 && (pos + sizeof(TlvHeader)) <= footer.size;) {
-        r = seek(pos);
+    for (size_t pos = 0; (pos + sizeof(TlvHeader)) <= footer_.size;) {
+        ssize_t r = seek(pos);
         if (r < 0) {
             return r;
         }
 
-        ssize_t rd = read((uint8_t*)&header, sizeof(header));
-        if (rd < (ssize_t)sizeof(TlvHeader)) {
+        r = read((uint8_t*)&header, sizeof(header));
+        if (r < (ssize_t)sizeof(TlvHeader)) {
             return SYSTEM_ERROR_BAD_DATA;
         }
 
         if (header.magick != TLV_HEADER_MAGICK) {
             /* Attempt to recover */
             pos += sizeof(uint16_t);
+            deletedSize_ += sizeof(uint16_t);
             continue;
         }
 
-        if (header.key == key) {
-            candidatePos = pos;
-            ++candidateIdx;
-            candidateSize = header.length;
-            if (index >= 0 && candidateIdx >= index) {
-                break;
+        const size_t entrySize = sizeof(TlvHeader) + header.length;
+        if (pos + entrySize > footer_.size) {
+            /* Truncated entry */
+            deletedSize_ += footer_.size - pos;
+            break;
+        }
+
+        if (header.flags & TLV_HEADER_FLAG_DELETED) {
+            deletedSize_ += entrySize;
+        } else {
+            r = insertEntry({ (uint32_t)pos, header.key, header.length });
+            if (r < 0) {
+                return r;
             }
         }
 
-        pos += sizeof(TlvHeader) + header.length;
+        pos += entrySize;
     }
 
-    if ((index >= 0 && candidateIdx == index) || (index < 0 && candidateIdx >= 0)) {
-        if (dataSize) {
-            *dataSize = candidateSize;
-        }
-        return candidatePos;
+    return 0;
+}
+
+int TlvFile::findEntry(uint16_t key, int index) {
+    const auto first = std::lower_bound(index_.begin(), index_.end(), key, [](const IndexEntry& e, uint16_t key) {
+        return e.key < key;
+    });
+    const auto last = std::upper_bound(first, index_.end(), key, [](uint16_t key, const IndexEntry& e) {
+        return key < e.key;
+    });
+    const int count = last - first;
+    if (count == 0 || index >= count) {
+        return SYSTEM_ERROR_NOT_FOUND;
+    }
+
+    /* Negative index refers to the most recently added entry */
+    const auto it = (index < 0) ? last - 1 : first + index;
+    return it - index_.begin();
+}
+
+int TlvFile::insertEntry(const IndexEntry& entry) {
+    /* Entries with the same key are kept in the order in which they appear in the file */
+    const auto it = std::upper_bound(index_.begin(), index_.end(), entry.key, [](uint16_t key, const IndexEntry& e) {
+        return key < e.key;
+    });
+    if (!index_.insert(it - index_.begin(), entry)) {
+        return SYSTEM_ERROR_NO_MEMORY;
     }
 
-    return SYSTEM_ERROR_NOT_FOUND;
+    return 0;
+}
+
+int TlvFile::markDeleted(const IndexEntry& entry) {
+    TlvHeader header = {};
+    header.magick = TLV_HEADER_MAGICK;
+    header.key = entry.key;
+    header.length = entry.length;
+    header.flags = TLV_HEADER_FLAG_DELETED;
+
+    const size_t entrySize = sizeof(TlvHeader) + entry.length;
+
+    ssize_t r = seek(entry.offset);
+    if (r < 0) {
+        return r;
+    }
+
+    r = write((const uint8_t*)&header, sizeof(header));
+    if (r < 0) {
+        return r;
+    }
+
+    deletedSize_ += entrySize;
+
+    return 0;
 }
 
 #endif /* HAL_PLATFORM_FILESYSTEM == 1 */
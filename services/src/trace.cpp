@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trace.h"
+
+#if PARTICLE_TRACE_ENABLED
+
+#include <atomic>
+
+#if !defined(__ARM_ARCH_7M__) && !defined(__ARM_ARCH_7EM__)
+#include <chrono>
+#endif
+
+namespace {
+
+static_assert((PARTICLE_TRACE_BUFFER_SIZE & (PARTICLE_TRACE_BUFFER_SIZE - 1)) == 0 &&
+        PARTICLE_TRACE_BUFFER_SIZE <= 0x8000, "PARTICLE_TRACE_BUFFER_SIZE must be a power of two");
+
+const uint32_t BUFFER_MASK = PARTICLE_TRACE_BUFFER_SIZE - 1;
+
+// Sequence number of a record that is being written
+const uint16_t SEQ_PENDING_OFFSET = 0x8000;
+
+volatile trace_record g_records[PARTICLE_TRACE_BUFFER_SIZE] = {};
+std::atomic<uint32_t> g_head(0); // Index of the next record
+std::atomic<uint32_t> g_tail(0); // Index of the oldest record that is not discarded
+
+inline uint32_t timestamp() {
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+    // DWT->CYCCNT. The cycle counter is enabled by the HAL
+    return *(volatile const uint32_t*)0xe0001004;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+} // unnamed
+
+void trace_event_record(uint16_t event, uint32_t arg) {
+    const uint32_t index = g_head.fetch_add(1, std::memory_order_relaxed);
+    volatile trace_record& r = g_records[index & BUFFER_MASK];
+    // Readers skip the record until its sequence number is updated
+    r.seq = index + SEQ_PENDING_OFFSET;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    r.timestamp = timestamp();
+    r.event = event;
+    r.arg = arg;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    r.seq = index;
+}
+
+size_t trace_get_records(trace_record* records, size_t count) {
+    const uint32_t head = g_head.load(std::memory_order_relaxed);
+    uint32_t index = g_tail.load(std::memory_order_relaxed);
+    if (head - index > PARTICLE_TRACE_BUFFER_SIZE) {
+        index = head - PARTICLE_TRACE_BUFFER_SIZE;
+    }
+    size_t n = 0;
+    for (; index != head && n < count; ++index) {
+        const volatile trace_record& r = g_records[index & BUFFER_MASK];
+        const uint16_t seq = r.seq;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        trace_record& dest = records[n];
+        dest.timestamp = r.timestamp;
+        dest.event = r.event;
+        dest.arg = r.arg;
+        dest.seq = seq;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        if (seq != (uint16_t)index || r.seq != seq) {
+            continue; // The record is being written or has been overwritten
+        }
+        ++n;
+    }
+    return n;
+}
+
+void trace_clear(void) {
+    g_tail.store(g_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+#else // !PARTICLE_TRACE_ENABLED
+
+void trace_event_record(uint16_t event, uint32_t arg) {
+}
+
+size_t trace_get_records(trace_record* records, size_t count) {
+    return 0;
+}
+
+void trace_clear(void) {
+}
+
+#endif // !PARTICLE_TRACE_ENABLED
@@ -20,6 +20,7 @@
 #include "timer_hal.h"
 
 #include "stream.h"
+#include "stream_util.h"
 #include "check.h"
 
 #include <algorithm>
@@ -59,6 +60,7 @@ const size_t BUFFER_SIZE = 1024 + sizeof(PacketHeader) + sizeof(PacketCrc);
 const unsigned NCG_TIMEOUT = 30000;
 const unsigned ACK_TIMEOUT = 10000;
 const unsigned SEND_TIMEOUT = 10000;
+const unsigned DRAIN_TIMEOUT = 1000;
 
 // Maximum number of retries before aborting the transfer
 const unsigned MAX_PACKET_RETRY_COUNT = 2;
@@ -85,6 +87,12 @@ uint16_t calcCrc16(const char* data, size_t size) {
     return crc;
 }
 
+// Returns the size of a packet stored in a buffer
+size_t packetSize(const char* buf) {
+    const size_t dataSize = (buf[0] == Ctrl::STX) ? 1024 : 128;
+    return dataSize + sizeof(PacketHeader) + sizeof(PacketCrc);
+}
+
 } // particle::
 
 XmodemSender::XmodemSender() :
@@ -95,18 +103,22 @@ XmodemSender::~XmodemSender() {
     destroy();
 }
 
-int XmodemSender::init(Stream* dest, InputStream* src, size_t size) {
-    buf_.reset(new(std::nothrow) char[BUFFER_SIZE]);
+int XmodemSender::init(Stream* dest, InputStream* src, size_t size, unsigned windowSize) {
+    CHECK_TRUE(windowSize > 0, SYSTEM_ERROR_INVALID_ARGUMENT);
+    buf_.reset(new(std::nothrow) char[BUFFER_SIZE * windowSize]);
     CHECK_TRUE(buf_, SYSTEM_ERROR_NO_MEMORY);
     srcStrm_ = src;
     destStrm_ = dest;
     fileSize_ = size;
     fileOffs_ = 0;
-    packetSize_ = 0;
     packetOffs_ = 0;
     retryCount_ = 0;
     canCount_ = 0;
-    packetNum_ = 1;
+    firstNum_ = 1;
+    nextNum_ = 1;
+    readNum_ = 1;
+    bufCount_ = windowSize;
+    windowSize_ = windowSize;
     setState(State::RECV_NCG);
     LOG_DEBUG(TRACE, "Waiting for NCGbyte (0x%02x)", (unsigned char)Ctrl::C);
     return 0;
@@ -167,44 +179,50 @@ int XmodemSender::recvNcg() {
 
 int XmodemSender::sendPacket() {
     CHECK(checkTimeout(SEND_TIMEOUT));
-    CHECK(readCtrl()); // Process CAN control bytes
-    if (packetSize_ == 0) {
-        PacketHeader h = {};
-        size_t chunkSize = fileSize_ - fileOffs_;
-        // Avoid sending more than 128 padding bytes in a 1K packet
-        if (chunkSize > 896) {
-            packetSize_ = 1024;
-            h.start = Ctrl::STX;
+    if (packetOffs_ == 0) {
+        if (firstNum_ == nextNum_) {
+            CHECK(readCtrl()); // Process CAN control bytes
         } else {
-            packetSize_ = 128;
-            h.start = Ctrl::SOH;
+            // Process the responses to the packets that are in flight
+            for (;;) {
+                char c = 0;
+                const size_t n = CHECK(readCtrl(&c));
+                if (n == 0) {
+                    break;
+                }
+                if (c == Ctrl::ACK) {
+                    CHECK(packetAcked());
+                } else if (c == Ctrl::NAK) {
+                    LOG_DEBUG(TRACE, "Received NAK");
+                    CHECK(resendPackets());
+                } else {
+                    LOG(ERROR, "Unexpected control byte: 0x%02x", (unsigned char)c);
+                    return SYSTEM_ERROR_PROTOCOL;
+                }
+                if (state_ != State::SEND_PACKET || firstNum_ == nextNum_) {
+                    return Status::RUNNING;
+                }
+            }
         }
-        if (chunkSize > packetSize_) {
-            chunkSize = packetSize_;
+        if (nextNum_ == readNum_) {
+            CHECK(readPacket());
         }
-        h.num = packetNum_ & 0xff;
-        h.numComp = ~h.num;
-        // Packet header
-        memcpy(buf_.get(), &h, sizeof(PacketHeader));
-        // TODO: Non-blocking reading of the source stream and graceful termination of the transfer
-        // in case of source stream errors are not supported
-        CHECK(srcStrm_->readAll(buf_.get() + sizeof(PacketHeader), chunkSize)); // Packet data
-        // Padding bytes
-        memset(buf_.get() + sizeof(PacketHeader) + chunkSize, 0, packetSize_ - chunkSize);
-        // Packet checksum
-        const uint16_t crc = calcCrc16(buf_.get() + sizeof(PacketHeader), packetSize_);
-        PacketCrc c = {};
-        c.msb = crc >> 8;
-        c.lsb = crc & 0xff;
-        memcpy(buf_.get() + sizeof(PacketHeader) + packetSize_, &c, sizeof(PacketCrc));
-        packetSize_ += sizeof(PacketHeader) + sizeof(PacketCrc);
-        LOG_DEBUG(TRACE, "Sending packet; number: %u, size: %u", packetNum_, (unsigned)packetSize_);
+        LOG_DEBUG(TRACE, "Sending packet; number: %u, size: %u", nextNum_,
+                (unsigned)packetSize(packetBuf(nextNum_)));
     }
-    packetOffs_ += CHECK(destStrm_->write(buf_.get() + packetOffs_, packetSize_ - packetOffs_));
-    if (packetOffs_ == packetSize_) {
+    const auto buf = packetBuf(nextNum_);
+    const size_t size = packetSize(buf);
+    packetOffs_ += CHECK(destStrm_->write(buf + packetOffs_, size - packetOffs_));
+    if (packetOffs_ == size) {
         CHECK(destStrm_->flush());
-        LOG_DEBUG(TRACE, "Waiting for ACK");
-        setState(State::RECV_PACKET_ACK);
+        packetOffs_ = 0;
+        ++nextNum_;
+        if (nextNum_ - firstNum_ >= windowSize_ || (nextNum_ == readNum_ && fileOffs_ == fileSize_)) {
+            LOG_DEBUG(TRACE, "Waiting for ACK");
+            setState(State::RECV_PACKET_ACK);
+        } else {
+            setState(State::SEND_PACKET);
+        }
     }
     return Status::RUNNING;
 }
@@ -214,33 +232,94 @@ int XmodemSender::recvPacketAck() {
     const size_t n = CHECK(readCtrl(&c));
     if (c == Ctrl::NAK || checkTimeout(ACK_TIMEOUT) != 0) {
         LOG_DEBUG(TRACE, "%s", (c == Ctrl::NAK) ? "Received NAK" : "ACK timeout");
-        if (++retryCount_ > MAX_PACKET_RETRY_COUNT) {
-            LOG(ERROR, "Maximum number of retransmissions exceeded");
-            return SYSTEM_ERROR_LIMIT_EXCEEDED;
-        }
-        LOG_DEBUG(TRACE, "Resending packet");
-        packetOffs_ = 0;
-        setState(State::SEND_PACKET);
+        CHECK(resendPackets());
     } else if (n > 0) {
         if (c != Ctrl::ACK) {
             LOG(ERROR, "Unexpected control byte: 0x%02x", (unsigned char)c);
             return SYSTEM_ERROR_PROTOCOL;
         }
-        LOG_DEBUG(TRACE, "Received ACK");
-        retryCount_ = 0;
-        fileOffs_ += std::min(fileSize_ - fileOffs_, packetSize_ - sizeof(PacketHeader) - sizeof(PacketCrc));
-        if (fileOffs_ < fileSize_) {
+        CHECK(packetAcked());
+    }
+    return Status::RUNNING;
+}
+
+int XmodemSender::readPacket() {
+    const auto buf = packetBuf(readNum_);
+    PacketHeader h = {};
+    size_t chunkSize = fileSize_ - fileOffs_;
+    size_t dataSize = 0;
+    // Avoid sending more than 128 padding bytes in a 1K packet
+    if (chunkSize > 896) {
+        dataSize = 1024;
+        h.start = Ctrl::STX;
+    } else {
+        dataSize = 128;
+        h.start = Ctrl::SOH;
+    }
+    if (chunkSize > dataSize) {
+        chunkSize = dataSize;
+    }
+    h.num = readNum_ & 0xff;
+    h.numComp = ~h.num;
+    // Packet header
+    memcpy(buf, &h, sizeof(PacketHeader));
+    // TODO: Non-blocking reading of the source stream and graceful termination of the transfer
+    // in case of source stream errors are not supported
+    CHECK(srcStrm_->readAll(buf + sizeof(PacketHeader), chunkSize)); // Packet data
+    // Padding bytes
+    memset(buf + sizeof(PacketHeader) + chunkSize, 0, dataSize - chunkSize);
+    // Packet checksum
+    const uint16_t crc = calcCrc16(buf + sizeof(PacketHeader), dataSize);
+    PacketCrc c = {};
+    c.msb = crc >> 8;
+    c.lsb = crc & 0xff;
+    memcpy(buf + sizeof(PacketHeader) + dataSize, &c, sizeof(PacketCrc));
+    fileOffs_ += chunkSize;
+    ++readNum_;
+    return 0;
+}
+
+int XmodemSender::packetAcked() {
+    LOG_DEBUG(TRACE, "Received ACK");
+    retryCount_ = 0;
+    ++firstNum_;
+    if (firstNum_ == readNum_ && fileOffs_ == fileSize_) {
+        // Send "end of transmission" sequence
+        setState(State::SEND_EOT);
+    } else if (state_ == State::RECV_PACKET_ACK) {
+        if (nextNum_ - firstNum_ < windowSize_ && (nextNum_ != readNum_ || fileOffs_ < fileSize_)) {
             // Send next packet
-            packetSize_ = 0;
-            packetOffs_ = 0;
-            ++packetNum_;
             setState(State::SEND_PACKET);
         } else {
-            // Send "end of transmission" sequence
-            setState(State::SEND_EOT);
+            // Wait for the next ACK
+            setState(State::RECV_PACKET_ACK);
         }
     }
-    return Status::RUNNING;
+    return 0;
+}
+
+int XmodemSender::resendPackets() {
+    if (++retryCount_ > MAX_PACKET_RETRY_COUNT) {
+        LOG(ERROR, "Maximum number of retransmissions exceeded");
+        return SYSTEM_ERROR_LIMIT_EXCEEDED;
+    }
+    if (windowSize_ > 1) {
+        LOG(WARN, "Falling back to stop-and-wait mode");
+        windowSize_ = 1;
+        if (nextNum_ - firstNum_ > 1) {
+            // Discard the responses to the packets that are still in flight
+            CHECK(skipAll(destStrm_, DRAIN_TIMEOUT));
+        }
+    }
+    LOG_DEBUG(TRACE, "Resending packet; number: %u", firstNum_);
+    nextNum_ = firstNum_;
+    packetOffs_ = 0;
+    setState(State::SEND_PACKET);
+    return 0;
+}
+
+char* XmodemSender::packetBuf(unsigned num) const {
+    return buf_.get() + ((num - 1) % bufCount_) * BUFFER_SIZE;
 }
 
 int XmodemSender::sendEot() {
@@ -290,7 +369,7 @@ int XmodemSender::readCtrl(char* c) {
             n = 0;
         } else {
             canCount_ = 0;
-            if (cc == Ctrl::C && state_ != State::RECV_NCG && packetNum_ == 1) {
+            if (cc == Ctrl::C && state_ != State::RECV_NCG && firstNum_ == 1) {
                 // Ignore superfluous NCGbyte's received while we're sending the first packet
                 n = 0;
             } else if (c) {
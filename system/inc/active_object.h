@@ -20,6 +20,9 @@
 #pragma once
 
 #include <cstddef>
+#include <atomic>
+
+#include "mpsc_queue.h"
 
 #if PLATFORM_THREADING
 
@@ -30,6 +33,7 @@
 
 #include "channel.h"
 #include "concurrent_hal.h"
+#include "timer_hal.h"
 
 /**
  * Configuratino data for an active object.
@@ -59,11 +63,15 @@ struct ActiveObjectConfiguration
 
     /**
      * How long to wait to put items in the queue before giving up.
+     *
+     * Not used by `ActiveObjectQueue`, which never blocks the caller.
      */
     unsigned put_wait;
 
     /**
      * The message capacity of the queue.
+     *
+     * Not used by `ActiveObjectQueue`, which is not limited in size.
      */
     uint16_t queue_size;
 
@@ -84,16 +92,34 @@ public:
     }
 };
 
+/**
+ * Priority of a message passed to an active object.
+ */
+enum class ActiveObjectPriority
+{
+    NORMAL,
+    /**
+     * High priority messages are processed before any normal priority messages that are
+     * waiting in the queue.
+     */
+    HIGH
+};
+
 /**
  * A message passed to an active object.
  */
-class Message
+class Message : public particle::MpscQueueNode
 {
 
 public:
-    Message() {}
+    Message() : queued_at(0) {}
     virtual void operator()()=0;
     virtual ~Message() {}
+
+    /**
+     * Time at which the message was queued.
+     */
+    system_tick_t queued_at;
 };
 
 /**
@@ -276,6 +302,11 @@ protected:
     virtual bool take(Item& item)=0;
     virtual bool put(Item& item)=0;
 
+    virtual bool put(Item& item, ActiveObjectPriority priority)
+    {
+        return put(item);
+    }
+
     /**
      * Static thread entrypoint to run this active object loop.
      * @param obj
@@ -302,19 +333,39 @@ public:
         _thread = os_thread_current(nullptr);
     }
 
+    os_thread_t thread() const {
+        return _thread;
+    }
+
     bool isStarted() {
         return started;
     }
 
-    template<typename R> void invoke_async(const std::function<R(void)>& work)
+    /**
+     * Wakes up the thread if it's waiting for a message, so that the background task is run
+     * without waiting for the take timeout to expire. This method can be called from an ISR.
+     */
+    virtual void wakeup()
+    {
+    }
+
+    /**
+     * Queues a function to be called on the thread of this active object.
+     *
+     * @return `true` if the function has been queued, or `false` if it has been dropped.
+     */
+    template<typename R> bool invoke_async(const std::function<R(void)>& work,
+            ActiveObjectPriority priority = ActiveObjectPriority::NORMAL)
     {
         auto task = new AsyncTask<R>(work);
         if (task)
         {
 			Item message = task;
-			if (!put(message))
-				delete task;
+			if (put(message, priority))
+				return true;
+			delete task;
         }
+        return false;
 	}
 
     template<typename R> SystemPromise<R>* invoke_future(const std::function<R(void)>& work)
@@ -369,30 +420,143 @@ public:
 
 };
 
+/**
+ * Queue statistics of an active object.
+ */
+struct ActiveObjectQueueStats
+{
+    /**
+     * Number of messages waiting in the queue.
+     */
+    unsigned depth;
+
+    /**
+     * Maximum time in milliseconds a normal priority message has waited in the queue.
+     */
+    system_tick_t max_wait;
+
+    /**
+     * Maximum time in milliseconds a high priority message has waited in the queue.
+     */
+    system_tick_t max_high_wait;
+};
+
+/**
+ * An active object with two queues. Messages in the high priority queue are processed first,
+ * so their queueing latency is bounded by the running time of a single message.
+ *
+ * Messages are linked into lock-free intrusive queues, so posting a message never blocks and
+ * doesn't copy it. The thread waits on a semaphore that is only signaled when a message is
+ * posted to an empty queue.
+ */
 class ActiveObjectQueue : public ActiveObjectBase
 {
-    os_queue_t  queue;
+    particle::MpscQueue<Message> queue;
+    particle::MpscQueue<Message> high_queue;
+    os_semaphore_t wakeup_sem;
+
+    std::atomic<unsigned> depth;
+    system_tick_t max_wait;
+    system_tick_t max_high_wait;
+
+    void taken(Item item, system_tick_t& max)
+    {
+        const system_tick_t wait = HAL_Timer_Get_Milli_Seconds() - item->queued_at;
+        if (wait > max)
+        {
+            max = wait;
+        }
+        --depth;
+    }
+
+    Item pop()
+    {
+        Item item = high_queue.pop();
+        if (item)
+        {
+            taken(item, max_high_wait);
+            return item;
+        }
+        item = queue.pop();
+        if (item)
+        {
+            taken(item, max_wait);
+        }
+        return item;
+    }
 
 protected:
 
     virtual bool take(Item& result)
     {
-        return !os_queue_take(queue, &result, configuration.take_wait, nullptr);
+        result = pop();
+        if (result)
+        {
+            return true;
+        }
+        if (!high_queue.isEmpty() || !queue.isEmpty() || !wakeup_sem)
+        {
+            // A producer has been preempted in the middle of posting a message
+            os_thread_yield();
+        }
+        else
+        {
+            os_semaphore_take(wakeup_sem, configuration.take_wait, false);
+        }
+        result = pop();
+        return result != nullptr;
     }
 
     virtual bool put(Item& item)
     {
-    		return !os_queue_put(queue, &item, configuration.put_wait, nullptr);
+        return put(item, ActiveObjectPriority::NORMAL);
+    }
+
+    virtual bool put(Item& item, ActiveObjectPriority priority)
+    {
+        item->queued_at = HAL_Timer_Get_Milli_Seconds();
+        ++depth;
+        auto& q = (priority == ActiveObjectPriority::HIGH) ? high_queue : queue;
+        if (q.push(item))
+        {
+            // The thread may be waiting only if the queue was empty
+            wakeup();
+        }
+        return true;
     }
 
     void createQueue()
     {
-        os_queue_create(&queue, sizeof(Item), configuration.queue_size, nullptr);
+        if (os_semaphore_create(&wakeup_sem, 1, 0))
+        {
+            wakeup_sem = nullptr;
+        }
     }
 
 public:
 
-    ActiveObjectQueue(const ActiveObjectConfiguration& config) : ActiveObjectBase(config), queue(NULL) {}
+    ActiveObjectQueue(const ActiveObjectConfiguration& config) :
+            ActiveObjectBase(config),
+            wakeup_sem(nullptr),
+            depth(0),
+            max_wait(0),
+            max_high_wait(0) {
+    }
+
+    void wakeup() override
+    {
+        if (wakeup_sem)
+        {
+            os_semaphore_give(wakeup_sem, false);
+        }
+    }
+
+    void stats(ActiveObjectQueueStats* stats) const
+    {
+        stats->depth = depth;
+        stats->max_wait = max_wait;
+        stats->max_high_wait = max_high_wait;
+    }
 
     void start()
     {
@@ -452,26 +616,50 @@ public:
 /**
  * This class implements a queue of asynchronous calls that can be scheduled from an ISR and then
  * invoked from an event loop running in a regular thread.
+ *
+ * Tasks are linked into a lock-free intrusive queue, so scheduling a task doesn't disable
+ * interrupts.
  */
 class ISRTaskQueue {
 public:
     struct Task;
     typedef void(*TaskFunc)(Task*);
 
-    struct Task {
+    struct Task: particle::MpscQueueNode {
         TaskFunc func;
-        Task* next; // Next element in the queue
     };
 
-    ISRTaskQueue() :
-            firstTask_(nullptr),
-            lastTask_(nullptr) {
+    // Callback invoked when a task is added to the empty queue, typically to wake up the thread
+    // running the queue
+    typedef void(*NotifyFunc)();
+
+    explicit ISRTaskQueue(NotifyFunc notify = nullptr) :
+            size_(0),
+            maxSize_(0),
+            notify_(notify) {
     }
 
     void enqueue(Task* task);
     bool process();
 
+    // This method must only be called from the thread running the queue
+    bool isEmpty() const {
+        return queue_.isEmpty();
+    }
+
+    // Returns the number of tasks waiting in the queue
+    size_t size() const {
+        return size_;
+    }
+
+    // Returns the maximum number of tasks that have been waiting in the queue at the same time
+    size_t maxSize() const {
+        return maxSize_;
+    }
+
 private:
-    Task* volatile firstTask_;
-    Task* lastTask_;
+    particle::MpscQueue<Task> queue_;
+    std::atomic<size_t> size_;
+    std::atomic<size_t> maxSize_;
+    NotifyFunc notify_;
 };
@@ -170,14 +170,45 @@ typedef enum
   ALL_DEVICES
 } Spark_Subscription_Scope_TypeDef;
 
+/**
+ * Subscription flags.
+ *
+ * The matching flags are sent to the cloud with the subscription, so that the events that don't
+ * match are not sent to the device.
+ */
+typedef enum spark_subscribe_flag {
+    SPARK_SUBSCRIBE_FLAG_BINARY = 0x01, ///< The handler is a `BinaryEventHandler` that receives the size and content format of the event data
+    SPARK_SUBSCRIBE_FLAG_EXACT_NAME = 0x02, ///< The event name must be equal to the subscribed name, not just start with it
+    SPARK_SUBSCRIBE_FLAG_DATA_PREFIX = 0x04, ///< The event data must start with `data_filter`
+    SPARK_SUBSCRIBE_FLAG_DATA_CONTAINS = 0x08 ///< The event data must contain `data_filter`
+} spark_subscribe_flag;
+
+// Additional parameters for spark_subscribe()
+typedef struct {
+    size_t size;
+    uint32_t flags; // A combination of flags defined by the `spark_subscribe_flag` enum
+    const char* data_filter; // At most 31 characters
+} spark_subscribe_data;
+
+/**
+ * User function handler.
+ *
+ * For a function registered with the `CLOUD_FUNCTION_FLAG_ASYNC` flag, `reserved` is a completion
+ * handle that needs to be passed to `spark_function_complete()` once the function call completes.
+ * The return value of an asynchronous handler is ignored.
+ */
 typedef int (*cloud_function_t)(void* data, const char* param, void* reserved);
 
+typedef enum cloud_function_flag {
+    CLOUD_FUNCTION_FLAG_ASYNC = 0x01 ///< The function completes asynchronously via `spark_function_complete()`
+} cloud_function_flag;
+
 typedef int (user_function_int_str_t)(String paramString);
 typedef user_function_int_str_t* p_user_function_int_str_t;
 
 struct  cloud_function_descriptor {
     uint16_t size;
-    uint16_t padding;
+    uint16_t flags; // A combination of flags defined by the `cloud_function_flag` enum
     const char *funcKey;
     cloud_function_t fn;
     void* data;
@@ -217,6 +248,20 @@ typedef struct spark_variable_t
  * 		update	A function used to case a variable value to be computed. If defined, this is called when the variable's value is retrieved.
  */
 bool spark_variable(const char *varKey, const void *userVar, Spark_Data_TypeDef userVarType, spark_variable_t* extra);
+/**
+ * @brief Make a registered variable observable.
+ *
+ * The cloud can observe an observable variable instead of polling it. A notification with the new
+ * value is sent when the value has changed by at least `threshold`, but not more often than every
+ * `interval` milliseconds. Any change of a string variable triggers a notification.
+ *
+ * @param varKey	The name of a registered variable.
+ * @param interval	Minimum interval between notifications in milliseconds. If 0, the variable is not observable.
+ * @param threshold	Minimum change of a numeric value that triggers a notification.
+ * @param reserved	Reserved argument. Should be set to `NULL`.
+ * @return 0 on success, or a negative result code in case of an error.
+ */
+int spark_variable_observe(const char* varKey, system_tick_t interval, double threshold, void* reserved);
 
 /**
  * @param funcKey   The name of the function to register. When NULL, pFunc is taken to be a
@@ -225,12 +270,27 @@ bool spark_variable(const char *varKey, const void *userVar, Spark_Data_TypeDef
  * @param reserved  For future expansion, set to NULL.
  */
 bool spark_function(const char *funcKey, p_user_function_int_str_t pFunc, void* reserved);
+/**
+ * @brief Complete a call to an asynchronous user function.
+ *
+ * This function can be called from any thread, but only once for every function call.
+ *
+ * @param completion	The completion handle passed to the function handler.
+ * @param result	The result of the function call.
+ * @param reserved	Reserved argument. Should be set to `NULL`.
+ * @return 0 on success, or a negative result code in case of an error.
+ */
+int spark_function_complete(void* completion, int result, void* reserved);
 
 // Additional parameters for spark_send_event()
 typedef struct {
     size_t size;
     completion_callback handler_callback;
     void* handler_data;
+    size_t data_size; // Size of the event data. If 0, the data is a null-terminated string
+    int content_type; // ContentType::Enum
+    int priority; // EventPriority::Enum
+    system_tick_t timeout; // Time in milliseconds after which a deferred event is dropped. If 0, the event has no deadline
 } spark_send_event_data;
 
 /**
@@ -257,6 +317,60 @@ typedef struct {
  */
 int spark_publish_vitals(system_tick_t period_s, void *reserved);
 bool spark_send_event(const char* name, const char* data, int ttl, uint32_t flags, void* reserved);
+/**
+ * Publish several events in a single message.
+ *
+ * All events of the batch share the same TTL and flags. The `PUBLISH_EVENT_FLAG_ASYNC` flag is
+ * not supported, as the event data is not copied by this function.
+ *
+ * @param events Events to publish.
+ * @param count Number of events.
+ * @param ttl Time to live.
+ * @param flags Publish flags.
+ * @param reserved Optional `spark_send_event_data` with a completion handler invoked once for the whole batch.
+ */
+bool spark_send_events(const EventBatchEntry* events, size_t count, int ttl, uint32_t flags, void* reserved);
+/**
+ * Add an event to the persistent publish queue.
+ *
+ * Queued events are stored in the filesystem and published in batches while the device is
+ * connected to the cloud, so they survive periods without connectivity as well as resets. New
+ * events are buffered in RAM and written to the filesystem in groups; call
+ * `spark_publish_queue_flush()` before entering a sleep mode that doesn't retain RAM.
+ *
+ * @param name Event name.
+ * @param data Event data (can be `NULL`).
+ * @param ttl Time to live.
+ * @param flags Publish flags. The `PUBLISH_EVENT_FLAG_ASYNC` flag is ignored.
+ * @param reserved Reserved argument. Should be set to `NULL`.
+ * @return 0 on success, or a negative result code in case of an error.
+ */
+int spark_publish_queue_push(const char* name, const char* data, int ttl, uint32_t flags, void* reserved);
+/**
+ * Write the buffered events of the persistent publish queue to the filesystem.
+ *
+ * @param reserved Reserved argument. Should be set to `NULL`.
+ * @return 0 on success, or a negative result code in case of an error.
+ */
+int spark_publish_queue_flush(void* reserved);
+/**
+ * Publish an event from an interrupt handler.
+ *
+ * The event is copied into one of a fixed number of preallocated records and published by the
+ * system thread. Events that are waiting to be published at the same time and have the same TTL
+ * and flags are sent in a single message. This function never blocks and can be called from any
+ * thread or ISR.
+ *
+ * @param name Event name.
+ * @param data Event data (can be `NULL`). Limited to 64 characters unless the system is built with
+ *        a different `SYSTEM_ISR_PUBLISH_MAX_DATA_SIZE`.
+ * @param ttl Time to live.
+ * @param flags Publish flags. The `PUBLISH_EVENT_FLAG_ASYNC` flag is implied.
+ * @param reserved Reserved argument. Should be set to `NULL`.
+ * @return 0 if the event has been queued, `SYSTEM_ERROR_LIMIT_EXCEEDED` if all records are in use,
+ *         or another negative result code in case of an error.
+ */
+int spark_publish_from_isr(const char* name, const char* data, int ttl, uint32_t flags, void* reserved);
 bool spark_subscribe(const char *eventName, EventHandler handler, void* handler_data,
         Spark_Subscription_Scope_TypeDef scope, const char* deviceID, void* reserved);
 void spark_unsubscribe(void *reserved);
@@ -38,6 +38,7 @@
 #include "system_led_signal.h"
 #include "system_setup.h"
 #include "system_power.h"
+#include "system_tls.h"
 #endif
 
 DYNALIB_BEGIN(system)
@@ -109,9 +110,22 @@ DYNALIB_FN(BASE_IDX + 17, system, system_power_management_set_config, int(const
 
 DYNALIB_FN(BASE_IDX1 + 0, system, system_sleep_ext, int(const hal_sleep_config_t*, hal_wakeup_source_base_t**, void*))
 
+#if HAL_USE_SOCKET_HAL_POSIX
+DYNALIB_FN(BASE_IDX1 + 1, system, system_tls_open, int(int, const system_tls_config*, void*))
+DYNALIB_FN(BASE_IDX1 + 2, system, system_tls_write, int(int, const void*, size_t, void*))
+DYNALIB_FN(BASE_IDX1 + 3, system, system_tls_read, int(int, void*, size_t, void*))
+DYNALIB_FN(BASE_IDX1 + 4, system, system_tls_close, int(int, void*))
+#define BASE_IDX2 (BASE_IDX1 + 5)
+#else
+#define BASE_IDX2 (BASE_IDX1 + 1)
+#endif // HAL_USE_SOCKET_HAL_POSIX
+
+DYNALIB_FN(BASE_IDX2 + 0, system, system_set_loop_overrun_threshold, int(uint32_t, void*))
+
 DYNALIB_END(system)
 
 #undef BASE_IDX
 #undef BASE_IDX1
+#undef BASE_IDX2
 
 #endif	/* SYSTEM_DYNALIB_H */
@@ -51,6 +51,12 @@ DYNALIB_FN(13, system_cloud, spark_sync_time_last, system_tick_t(time_t*, void*)
 DYNALIB_FN(14, system_cloud, spark_set_connection_property, int(unsigned, unsigned, particle::protocol::connection_properties_t*, void*))
 DYNALIB_FN(15, system_cloud, spark_set_random_seed_from_cloud_handler, int(void (*handler)(unsigned int), void*))
 DYNALIB_FN(16, system_cloud, spark_publish_vitals, int(system_tick_t, void*))
+DYNALIB_FN(17, system_cloud, spark_send_events, bool(const EventBatchEntry*, size_t, int, uint32_t, void*))
+DYNALIB_FN(18, system_cloud, spark_publish_queue_push, int(const char*, const char*, int, uint32_t, void*))
+DYNALIB_FN(19, system_cloud, spark_publish_queue_flush, int(void*))
+DYNALIB_FN(20, system_cloud, spark_variable_observe, int(const char*, system_tick_t, double, void*))
+DYNALIB_FN(21, system_cloud, spark_function_complete, int(void*, int, void*))
+DYNALIB_FN(22, system_cloud, spark_publish_from_isr, int(const char*, const char*, int, uint32_t, void*))
 
 DYNALIB_END(system_cloud)
 
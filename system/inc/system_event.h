@@ -61,6 +61,7 @@ enum SystemEvents {
     battery_state = 1<<16,
     power_source = 1<<17,
 	out_of_memory = 1<<18,			// heap request was not satisfied
+    loop_overrun = 1<<19,           // an iteration of the application loop took longer than the configured threshold. parameter is the duration in ms.
 
     all_events = 0xFFFFFFFFFFFFFFFF
 };
@@ -102,7 +103,13 @@ enum SystemEventsParam {
  * Flags altering the behavior of the `system_notify_event()` function.
  */
 enum SystemNotifyEventFlag {
-    NOTIFY_SYNCHRONOUSLY = 0x01
+    NOTIFY_SYNCHRONOUSLY = 0x01,
+    /**
+     * If a notification about the same event is still waiting to be delivered to the application,
+     * update its parameters instead of queueing another notification. Use it for status events
+     * where only the latest state matters. Ignored for notifications with a completion callback.
+     */
+    NOTIFY_COALESCE = 0x02
 };
 
 /**
@@ -123,6 +130,14 @@ void system_unsubscribe_event(system_event_t events, system_event_handler_t* han
 
 void system_notify_time_changed(uint32_t data, void* reserved, void* reserved1);
 
+/**
+ * Sets the duration of an application loop iteration above which the `loop_overrun` event is generated.
+ * The duration includes the background processing run in the application thread.
+ * @param millis    Threshold in milliseconds, or 0 to disable the event.
+ * @param reserved  Set to NULL.
+ */
+int system_set_loop_overrun_threshold(uint32_t millis, void* reserved);
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,7 +36,14 @@ enum class SystemSleepMode: uint8_t {
 
 enum class SystemSleepFlag: uint32_t {
     NONE = HAL_SLEEP_FLAG_NONE,
-    WAIT_CLOUD = HAL_SLEEP_FLAG_WAIT_CLOUD
+    WAIT_CLOUD = HAL_SLEEP_FLAG_WAIT_CLOUD,
+    /**
+     * The device wakes up periodically to publish a few events. The cellular modem stays registered
+     * and the cloud session is kept across the sleep, the pending events are sent and acknowledged
+     * before the device goes to sleep, and no ping is sent after waking up. Ignored in the
+     * hibernate mode.
+     */
+    REPORT_CYCLE = HAL_SLEEP_FLAG_REPORT_CYCLE
 };
 
 class SystemSleepConfigurationHelper {
@@ -47,7 +54,7 @@ public:
 
     bool cloudDisconnectRequested() const {
 #if HAL_PLATFORM_CELLULAR
-        if (wakeupByNetworkInterface(NETWORK_INTERFACE_CELLULAR)) {
+        if (keepNetworkInterface(NETWORK_INTERFACE_CELLULAR)) {
             return false;
         }
 #endif // HAL_PLATFORM_CELLULAR
@@ -85,6 +92,23 @@ public:
         return false;
     }
 
+    // Returns true if the interface should stay connected while the device is sleeping
+    bool keepNetworkInterface(network_interface_index index) const {
+        if (wakeupByNetworkInterface(index)) {
+            return true;
+        }
+#if HAL_PLATFORM_CELLULAR
+        if (index == NETWORK_INTERFACE_CELLULAR && reportCycle()) {
+            return true;
+        }
+#endif // HAL_PLATFORM_CELLULAR
+        return false;
+    }
+
+    bool reportCycle() const {
+        return sleepFlags().isSet(SystemSleepFlag::REPORT_CYCLE) && sleepMode() != SystemSleepMode::HIBERNATE;
+    }
+
     particle::EnumFlags<SystemSleepFlag> sleepFlags() const {
         return particle::EnumFlags<SystemSleepFlag>::fromUnderlying(config_->flags);
     }
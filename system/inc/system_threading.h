@@ -20,8 +20,14 @@
 #define	SYSTEM_THREADING_H
 
 #include "active_object.h"
+#include "coroutine.h"
 extern ISRTaskQueue SystemISRTaskQueue;
 
+/**
+ * Coroutines run by the system loop
+ */
+extern particle::CoroutineScheduler SystemCoroutineScheduler;
+
 #if PLATFORM_THREADING
 
 #include "concurrent_hal.h"
@@ -80,13 +86,15 @@ FFL(F const &func)
         return result; \
     }
 
-#define _THREAD_CONTEXT_ASYNC(thread, fn) \
+#define _THREAD_CONTEXT_ASYNC_PRIORITY(thread, priority, fn) \
     if (thread.isStarted() && !thread.isCurrentThread()) { \
         auto lambda = [=]() { (fn); }; \
-        thread.invoke_async(FFL(lambda)); \
+        thread.invoke_async(FFL(lambda), priority); \
         return; \
     }
 
+#define _THREAD_CONTEXT_ASYNC(thread, fn) _THREAD_CONTEXT_ASYNC_PRIORITY(thread, ActiveObjectPriority::NORMAL, fn)
+
 #define SYSTEM_THREAD_CONTEXT_SYNC(fn) \
     if (SystemThread.isStarted() && !SystemThread.isCurrentThread()) { \
         auto callable = FFL([=]() { return (fn); }); \
@@ -98,12 +106,16 @@ FFL(F const &func)
 
 #else
 
+#define _THREAD_CONTEXT_ASYNC_PRIORITY(thread, priority, fn)
 #define _THREAD_CONTEXT_ASYNC(thread, fn)
 #define _THREAD_CONTEXT_ASYNC_RESULT(thread, fn, result)
 #define SYSTEM_THREAD_CONTEXT_SYNC(fn) 
 #endif
 
 #define SYSTEM_THREAD_CONTEXT_ASYNC(fn) _THREAD_CONTEXT_ASYNC(SystemThread, fn)
+// Same as SYSTEM_THREAD_CONTEXT_ASYNC() but the call is queued ahead of normal priority calls.
+// Use it for short, latency-sensitive calls such as replies to the cloud
+#define SYSTEM_THREAD_CONTEXT_ASYNC_HIGH_PRIORITY(fn) _THREAD_CONTEXT_ASYNC_PRIORITY(SystemThread, ActiveObjectPriority::HIGH, fn)
 #define SYSTEM_THREAD_CONTEXT_ASYNC_RESULT(fn, result) _THREAD_CONTEXT_ASYNC_RESULT(SystemThread, fn, result)
 #define APPLICATION_THREAD_CONTEXT_ASYNC(fn) _THREAD_CONTEXT_ASYNC(ApplicationThread, fn)
 #define APPLICATION_THREAD_CONTEXT_ASYNC_RESULT(fn, result) _THREAD_CONTEXT_ASYNC_RESULT(ApplicationThread, fn, result)
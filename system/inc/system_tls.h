@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "hal_platform.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * TLS client sessions running on top of sockets created with the POSIX socket HAL.
+ *
+ * The sessions use the mbedTLS instance of the system firmware, including its hardware
+ * acceleration, so that applications don't need to link their own TLS stack. Sessions negotiated
+ * with a server are cached by the system and resumed on subsequent connections to the same host.
+ */
+
+/**
+ * Maximum number of concurrently open TLS sessions.
+ */
+#define SYSTEM_TLS_MAX_SESSIONS (2)
+
+/**
+ * Number of sessions kept in the session cache.
+ */
+#define SYSTEM_TLS_SESSION_CACHE_SIZE (2)
+
+/**
+ * Maximum length of a host name.
+ */
+#define SYSTEM_TLS_MAX_HOST_NAME_LENGTH (63)
+
+/**
+ * TLS session flags.
+ */
+typedef enum system_tls_flag {
+    /**
+     * Don't verify the server certificate.
+     *
+     * This flag needs to be set if no CA certificate is provided.
+     */
+    SYSTEM_TLS_FLAG_INSECURE = 0x01,
+    /**
+     * Don't resume a cached session and don't cache the negotiated session.
+     */
+    SYSTEM_TLS_FLAG_NO_SESSION_CACHE = 0x02
+} system_tls_flag;
+
+/**
+ * TLS session options.
+ */
+typedef struct system_tls_config {
+    uint16_t size; ///< Size of this structure.
+    uint16_t flags; ///< Flags (a combination of the `system_tls_flag` values).
+    const char* host; ///< Server host name. Used for certificate verification, SNI and as a key in
+                      ///< the session cache.
+    const uint8_t* ca_cert; ///< CA certificate chain in DER format.
+    size_t ca_cert_size; ///< Size of the CA certificate chain.
+} system_tls_config;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Perform a TLS handshake over a connected socket.
+ *
+ * The socket needs to remain open for as long as the TLS session is used. Socket options, such as
+ * the receive timeout, affect the TLS session functions in the same way as they affect the socket
+ * functions.
+ *
+ * @param sock Socket descriptor.
+ * @param conf Session options.
+ * @param reserved Reserved argument. Should be set to `NULL`.
+ * @return Session handle or a negative result code in case of an error.
+ */
+int system_tls_open(int sock, const system_tls_config* conf, void* reserved);
+
+/**
+ * Send application data.
+ *
+ * @param handle Session handle.
+ * @param data Data to send.
+ * @param size Size of the data.
+ * @param reserved Reserved argument. Should be set to `NULL`.
+ * @return Number of bytes sent or a negative result code in case of an error.
+ */
+int system_tls_write(int handle, const void* data, size_t size, void* reserved);
+
+/**
+ * Receive application data.
+ *
+ * @param handle Session handle.
+ * @param data Buffer for the received data.
+ * @param size Size of the buffer.
+ * @param reserved Reserved argument. Should be set to `NULL`.
+ * @return Number of bytes received, 0 if the server has closed the session, or a negative result
+ *         code in case of an error.
+ */
+int system_tls_read(int handle, void* data, size_t size, void* reserved);
+
+/**
+ * Close a TLS session.
+ *
+ * The server is notified that the session is being closed. The socket is not closed by this
+ * function.
+ *
+ * @param handle Session handle.
+ * @param reserved Reserved argument. Should be set to `NULL`.
+ * @return 0 on success, or a negative result code in case of an error.
+ */
+int system_tls_close(int handle, void* reserved);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
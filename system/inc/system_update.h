@@ -27,16 +27,27 @@ void set_start_ymodem_flasher_serial_speed(uint32_t speed);
 bool system_firmwareUpdate(Stream* stream, void* reserved=NULL);
 
 
+/**
+ * Flags controlling a file transfer.
+ */
+enum system_file_transfer_flag_t {
+    /**
+     * Use the YMODEM-g streaming variant of the protocol. The packets are not acknowledged
+     * individually, which speeds up transfers over reliable links such as USB serial.
+     */
+    SYSTEM_FILE_TRANSFER_FLAG_STREAMING = 0x01
+};
+
 struct system_file_transfer_t {
     system_file_transfer_t()
             : size{sizeof(*this)},
-              padding{0},
+              flags{0},
               stream{nullptr},
               descriptor{} {
     }
 
     uint16_t size;
-    uint16_t padding;   // reuse if possible
+    uint16_t flags;     // see system_file_transfer_flag_t
     Stream* stream;
     FileTransfer::Descriptor descriptor;
 };
@@ -146,6 +157,28 @@ typedef enum
 	 */
     SYSTEM_FLAG_OTA_UPDATE_FORCED,
 
+    /**
+     * When 1, periodic vitals only contain the diagnostic data that changed since the last
+     * vitals acknowledged by the cloud. A complete set is still sent at the start of every
+     * session.
+     */
+    SYSTEM_FLAG_PUBLISH_VITALS_DELTA,
+
+    /**
+     * When 1, the BLE stack and the BLE control request channel are initialized once the
+     * application's setup() has started, or when the device enters listening mode, rather than
+     * before setup() is called. Must be set during startup, e.g. using the STARTUP() macro.
+     */
+    SYSTEM_FLAG_DEFERRED_INIT,
+
+    /**
+     * When 1, the application keeps running while an OTA update is being received, including in
+     * the non-threaded mode, where the application loop is otherwise suspended until the update
+     * completes. The update is applied on the next reset, which the application can defer with
+     * `System.disableReset()` until it is ready.
+     */
+    SYSTEM_FLAG_OTA_BACKGROUND,
+
     SYSTEM_FLAG_MAX
 
 } system_flag_t;
@@ -154,16 +187,38 @@ typedef enum
 void system_shutdown_if_needed();
 void system_pending_shutdown();
 
+/**
+ * Returns true if an update is in progress and the application loop needs to be suspended until
+ * it completes (see `SYSTEM_FLAG_OTA_BACKGROUND`).
+ */
+bool system_update_blocks_application();
+
 int system_set_flag(system_flag_t flag, uint8_t value, void* reserved);
 int system_get_flag(system_flag_t flag, uint8_t* value,void* reserved);
 int system_refresh_flag(system_flag_t flag);
 
+/**
+ * Flags for `system_format_diag_data()`.
+ */
+typedef enum
+{
+    /**
+     * Format the data in the binary format used for vitals.
+     */
+    SYSTEM_FORMAT_DIAG_FLAG_BINARY = 0x01,
+    /**
+     * Format only the data sources whose values changed since the last binary document, using a
+     * compact varint encoding. Implies SYSTEM_FORMAT_DIAG_FLAG_BINARY.
+     */
+    SYSTEM_FORMAT_DIAG_FLAG_DELTA = 0x02
+} system_format_diag_flag_t;
+
 /**
  * Formats the diagnostic data using an appender function.
  *
  * @param id Array of data source IDs. This argument can be set to NULL to format all registered data sources.
  * @param count Number of data source IDs in the array.
- * @param flags Formatting flags.
+ * @param flags Formatting flags (see `system_format_diag_flag_t`).
  * @param append Appender function.
  * @param append_data Opaque data passed to the appender function.
  * @param reserved Reserved argument (should be set to NULL).
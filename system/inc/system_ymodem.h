@@ -64,6 +64,7 @@ public:
         NAK = (0x15),   /* negative acknowledge */
         CA = (0x18),    /* two of these in succession aborts transfer */
         CRC16 = (0x43), /* 'C' == 0x43, request 16-bit CRC */
+        STREAMING = (0x47), /* 'G' == 0x47, request YMODEM-g streaming mode */
 
         ABORT1 = (0x41), /* 'A' == 0x41, abort by user */
         ABORT2 = (0x61)  /* 'a' == 0x61, abort by user */
@@ -75,7 +76,13 @@ public:
         char file_size[FILE_SIZE_LENGTH];
     };
 
-    YModem(Stream& stream_) : stream(stream_)
+    /**
+     * @param stream_ Stream to receive the file from.
+     * @param streaming_ Use the YMODEM-g variant of the protocol. The sender transmits the packets
+     *        back to back without waiting for them to be acknowledged, and the transfer is aborted
+     *        if an error is detected. This mode requires a reliable, flow-controlled link.
+     */
+    YModem(Stream& stream_, bool streaming_ = false) : stream(stream_), streaming(streaming_)
     {
     }
 
@@ -96,6 +103,15 @@ public:
 private:
     uint8_t packet_data[YModem::PACKET_1K_SIZE + YModem::PACKET_OVERHEAD];
     int32_t session_done, file_done, packets_received, errors, session_begin;
+    bool streaming;
+
+    /**
+     * @brief  Request the sender to start transmitting the packets
+     */
+    void send_start_request()
+    {
+        send_byte(streaming ? STREAMING : CRC16);
+    }
 
     /**
      * @brief  Receive byte from sender
@@ -19,7 +19,6 @@
 
 #include "active_object.h"
 
-#include "spark_wiring_interrupts.h"
 #include "debug.h"
 
 #if PLATFORM_THREADING
@@ -90,31 +89,21 @@ void ActiveObjectBase::run_active_object(void* data)
 #endif // PLATFORM_THREADING
 
 void ISRTaskQueue::enqueue(Task* task) {
-    ATOMIC_BLOCK() {
-        // Add task object to the queue
-        if (lastTask_) {
-            lastTask_->next = task;
-        } else { // The queue is empty
-            firstTask_ = task;
-        }
-        task->next = nullptr;
-        lastTask_ = task;
+    const size_t size = ++size_;
+    size_t maxSize = maxSize_.load(std::memory_order_relaxed);
+    while (size > maxSize && !maxSize_.compare_exchange_weak(maxSize, size, std::memory_order_relaxed)) {
+    }
+    if (queue_.push(task) && notify_) {
+        notify_();
     }
 }
 
 bool ISRTaskQueue::process() {
-    Task* task = nullptr;
-    if (!firstTask_) {
+    Task* const task = queue_.pop();
+    if (!task) {
         return false;
     }
-    ATOMIC_BLOCK() {
-        // Take task object from the queue
-        task = firstTask_;
-        firstTask_ = task->next;
-        if (!firstTask_) {
-            lastTask_ = nullptr;
-        }
-    }
+    --size_;
     // Invoke task function
     task->func(task);
     return true;
@@ -105,7 +105,7 @@ struct __attribute__((packed)) HandshakeHeader {
 };
 
 // Device setup protocol version
-const unsigned PROTOCOL_VERSION = 0x02;
+const unsigned PROTOCOL_VERSION = 0x03;
 
 // UUID of the control request service
 const uint8_t CTRL_SERVICE_UUID[] = { 0xfc, 0x36, 0x6f, 0x54, 0x30, 0x80, 0xf4, 0x94, 0xa8, 0x48, 0x4e, 0x5c, 0x01, 0x00, 0xa9, 0x6f };
@@ -152,6 +152,34 @@ const char* const JPAKE_CLIENT_ID = "client";
 // Server identity string
 const char* const JPAKE_SERVER_ID = "server";
 
+// First byte of a session resumption request. J-PAKE's round 1 message never starts with a zero
+// byte, since it begins with the length of an EC point
+const uint8_t RESUME_REQUEST_TAG = 0x00;
+
+// Status codes sent in a session resumption reply
+enum ResumeStatus {
+    RESUME_ACCEPTED = 0x00,
+    RESUME_REJECTED = 0x01 // The client should proceed with a J-PAKE handshake
+};
+
+// Size of a session ticket ID in bytes
+const size_t SESSION_TICKET_ID_SIZE = 8;
+
+// Size of the client and server nonces used for session resumption
+const size_t SESSION_NONCE_SIZE = 16;
+
+// Size of a session resumption request: tag, ticket ID, client nonce
+const size_t RESUME_REQUEST_SIZE = 1 + SESSION_TICKET_ID_SIZE + SESSION_NONCE_SIZE;
+
+// Size of an accepted session resumption reply: status, server nonce, confirmation MAC
+const size_t RESUME_REPLY_SIZE = 1 + SESSION_NONCE_SIZE + 32;
+
+// Maximum number of cached sessions
+const size_t SESSION_CACHE_SIZE = 2;
+
+// Period of time in milliseconds during which a session can be resumed
+const system_tick_t SESSION_TICKET_LIFETIME = 60 * 60 * 1000;
+
 // Size of the cipher's key in bytes
 const size_t AES_CCM_KEY_SIZE = 16;
 
@@ -300,6 +328,82 @@ private:
 
 } // particle::system::
 
+// Secrets of recently established sessions. A session is identified by a ticket ID which is
+// derived from the session's shared secret, so that both parties can calculate it without
+// exchanging any additional data. A ticket can only be used once: a resumed session replaces
+// the cached secret with a newly derived one
+class BleControlRequestChannel::SessionCache {
+public:
+    SessionCache() :
+            entries_() {
+    }
+
+    ~SessionCache() {
+        memset(entries_, 0, sizeof(entries_));
+    }
+
+    int add(const char* secret) {
+        // Replace an unused or the oldest entry
+        Entry* entry = &entries_[0];
+        const auto now = HAL_Timer_Get_Milli_Seconds();
+        for (size_t i = 0; i < SESSION_CACHE_SIZE; ++i) {
+            Entry* e = &entries_[i];
+            if (!e->valid || now - e->time >= SESSION_TICKET_LIFETIME) {
+                entry = e;
+                break;
+            }
+            if (e->time < entry->time) {
+                entry = e;
+            }
+        }
+        CHECK(ticketId(secret, entry->ticketId));
+        memcpy(entry->secret, secret, JPAKE_SHARED_SECRET_SIZE);
+        entry->time = now;
+        entry->valid = true;
+        return 0;
+    }
+
+    bool take(const char* ticketId, char* secret) {
+        const auto now = HAL_Timer_Get_Milli_Seconds();
+        for (size_t i = 0; i < SESSION_CACHE_SIZE; ++i) {
+            Entry* e = &entries_[i];
+            if (!e->valid) {
+                continue;
+            }
+            if (now - e->time >= SESSION_TICKET_LIFETIME) {
+                memset(e, 0, sizeof(Entry));
+                continue;
+            }
+            if (memcmp(e->ticketId, ticketId, SESSION_TICKET_ID_SIZE) == 0) {
+                memcpy(secret, e->secret, JPAKE_SHARED_SECRET_SIZE);
+                memset(e, 0, sizeof(Entry));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static int ticketId(const char* secret, char* id) {
+        char mac[HmacSha256::SIZE] = {};
+        HmacSha256 hmac;
+        CHECK(hmac.init(secret, JPAKE_SHARED_SECRET_SIZE));
+        CHECK(hmac.update("TICKET"));
+        CHECK(hmac.finish(mac));
+        memcpy(id, mac, SESSION_TICKET_ID_SIZE);
+        return 0;
+    }
+
+private:
+    struct Entry {
+        char ticketId[SESSION_TICKET_ID_SIZE];
+        char secret[JPAKE_SHARED_SECRET_SIZE];
+        system_tick_t time;
+        bool valid;
+    };
+
+    Entry entries_[SESSION_CACHE_SIZE];
+};
+
 class BleControlRequestChannel::HandshakeHandler {
 public:
     enum Result {
@@ -403,9 +507,10 @@ private:
 
 class BleControlRequestChannel::JpakeHandler: public HandshakeHandler {
 public:
-    explicit JpakeHandler(BleControlRequestChannel* channel) :
+    JpakeHandler(BleControlRequestChannel* channel, SessionCache* sessions) :
             HandshakeHandler(channel),
             ctx_(),
+            sessions_(sessions),
             state_(State::NEW) {
     }
 
@@ -413,6 +518,7 @@ public:
         mbedtls_ecjpake_free(&ctx_);
         memset(secret_, 0, sizeof(secret_));
         memset(confirmKey_, 0, sizeof(confirmKey_));
+        memset(serverNonce_, 0, sizeof(serverNonce_));
     }
 
     int init(const char* key, size_t keySize) {
@@ -446,6 +552,12 @@ public:
         case State::WRITE_CONFIRM:
             ret = writeConfirm();
             break;
+        case State::WRITE_RESUME_ACCEPTED:
+            ret = writeResumeAccepted();
+            break;
+        case State::WRITE_RESUME_REJECTED:
+            ret = writeResumeRejected();
+            break;
         case State::DONE:
             return Result::DONE;
         default:
@@ -473,6 +585,8 @@ private:
         WRITE_ROUND2,
         READ_CONFIRM,
         WRITE_CONFIRM,
+        WRITE_RESUME_ACCEPTED,
+        WRITE_RESUME_REJECTED,
         DONE,
         FAILED
     };
@@ -481,6 +595,8 @@ private:
     mbedtls_ecjpake_context ctx_;
     char secret_[JPAKE_SHARED_SECRET_SIZE];
     char confirmKey_[Sha256::SIZE];
+    char serverNonce_[SESSION_NONCE_SIZE];
+    SessionCache* sessions_;
     State state_;
 
     int readRound1() {
@@ -490,6 +606,9 @@ private:
         if (ret != Result::DONE) {
             return ret;
         }
+        if (size == RESUME_REQUEST_SIZE && (uint8_t)data[0] == RESUME_REQUEST_TAG) {
+            return readResumeRequest(data);
+        }
         CHECK_MBEDTLS(mbedtls_ecjpake_read_round_one(&ctx_, (const uint8_t*)data, size));
         CHECK(hash_.update(data, size));
         state_ = State::WRITE_ROUND1;
@@ -595,9 +714,70 @@ private:
         CHECK(hmac.update(buf->data, buf->size));
         CHECK(hmac.finish(buf->data));
         writePacket();
+        CHECK(cacheSession());
         state_ = State::DONE;
         return Result::DONE;
     }
+
+    // The shared secret of a resumed session is calculated as HMAC-SHA256(S, "RESUME" || Nc || Ns),
+    // where S is the secret of the cached session, and Nc and Ns are the client and server nonces
+    int readResumeRequest(const char* data) {
+        const char* const ticketId = data + 1;
+        const char* const clientNonce = ticketId + SESSION_TICKET_ID_SIZE;
+        char secret[JPAKE_SHARED_SECRET_SIZE] = {};
+        SCOPE_GUARD({
+            memset(secret, 0, sizeof(secret));
+        });
+        if (!sessions_ || !sessions_->take(ticketId, secret)) {
+            LOG(TRACE, "Unknown session ticket");
+            state_ = State::WRITE_RESUME_REJECTED;
+            return Result::RUNNING;
+        }
+        // Derive the shared secret of the resumed session
+        CHECK_MBEDTLS(mbedtls_default_rng(nullptr, (unsigned char*)serverNonce_, sizeof(serverNonce_)));
+        HmacSha256 hmac;
+        CHECK(hmac.init(secret, sizeof(secret)));
+        CHECK(hmac.update("RESUME"));
+        CHECK(hmac.update(clientNonce, SESSION_NONCE_SIZE));
+        CHECK(hmac.update(serverNonce_, sizeof(serverNonce_)));
+        CHECK(hmac.finish(secret_));
+        static_assert(HmacSha256::SIZE == JPAKE_SHARED_SECRET_SIZE, "");
+        state_ = State::WRITE_RESUME_ACCEPTED;
+        return Result::RUNNING;
+    }
+
+    int writeResumeAccepted() {
+        Buffer* buf = nullptr;
+        CHECK(initPacket(&buf, RESUME_REPLY_SIZE));
+        buf->data[0] = RESUME_ACCEPTED;
+        memcpy(buf->data + 1, serverNonce_, sizeof(serverNonce_));
+        // Prove that the server knows the resumed session's secret
+        HmacSha256 hmac;
+        CHECK(hmac.init(secret_, sizeof(secret_)));
+        CHECK(hmac.update("KC_R_S"));
+        CHECK(hmac.update(buf->data + 1, SESSION_NONCE_SIZE));
+        CHECK(hmac.finish(buf->data + 1 + SESSION_NONCE_SIZE));
+        writePacket();
+        CHECK(cacheSession());
+        state_ = State::DONE;
+        return Result::DONE;
+    }
+
+    int writeResumeRejected() {
+        Buffer* buf = nullptr;
+        CHECK(initPacket(&buf, 1));
+        buf->data[0] = RESUME_REJECTED;
+        writePacket();
+        state_ = State::READ_ROUND1; // Wait for the J-PAKE's round 1 message
+        return Result::RUNNING;
+    }
+
+    int cacheSession() {
+        if (sessions_) {
+            CHECK(sessions_->add(secret_));
+        }
+        return 0;
+    }
 };
 
 class BleControlRequestChannel::AesCcmCipher {
@@ -705,6 +885,13 @@ int BleControlRequestChannel::init() {
     if (ret != 0) {
         goto error;
     }
+#if BLE_CHANNEL_SECURITY_ENABLED && BLE_CHANNEL_SESSION_RESUMPTION_ENABLED
+    sessions_.reset(new(std::nothrow) SessionCache);
+    if (!sessions_) {
+        ret = SYSTEM_ERROR_NO_MEMORY;
+        goto error;
+    }
+#endif
     // TODO: Initialize this allocator when a BLE connection is accepted
     ret = pool_.init(BUFFER_POOL_SIZE);
     if (ret != 0) {
@@ -946,42 +1133,45 @@ int BleControlRequestChannel::sendPacket() {
     if (!writable_) {
         return 0; // Can't send now
     }
-    // Prepare a BLE packet
+    // Send as many packets as there's data available: the BLE stack queues notifications, so that
+    // several of them can be sent in a single connection event
     SPARK_ASSERT(packetBuf_);
     const size_t maxSize = maxPacketSize_;
-    Buffer* buf = nullptr;
-    while (packetSize_ < maxSize && (buf = outBufs_.front())) {
-        const size_t n = std::min(maxSize - packetSize_, buf->size);
-        memcpy(packetBuf_.get() + packetSize_, buf->data, n);
-        buf->data += n;
-        buf->size -= n;
-        if (buf->size == 0) {
-            outBufs_.popFront();
-            freeBuffer(buf);
+    for (;;) {
+        // Prepare a BLE packet
+        Buffer* buf = nullptr;
+        while (packetSize_ < maxSize && (buf = outBufs_.front())) {
+            const size_t n = std::min(maxSize - packetSize_, buf->size);
+            memcpy(packetBuf_.get() + packetSize_, buf->data, n);
+            buf->data += n;
+            buf->size -= n;
+            if (buf->size == 0) {
+                outBufs_.popFront();
+                freeBuffer(buf);
+            }
+            packetSize_ += n;
         }
-        packetSize_ += n;
-    }
-    if (packetSize_ == 0) {
-        if (packetCount_ == 0) {
-            // Invoke completion handlers
-            while (Request* req = pendingReps_.popFront()) {
-                req->handler(SYSTEM_ERROR_NONE, req->handlerData);
-                req->handler = nullptr;
-                freeRequest(req);
+        if (packetSize_ == 0) {
+            if (packetCount_ == 0) {
+                // Invoke completion handlers
+                while (Request* req = pendingReps_.popFront()) {
+                    req->handler(SYSTEM_ERROR_NONE, req->handlerData);
+                    req->handler = nullptr;
+                    freeRequest(req);
+                }
             }
+            return 0; // Nothing to send
         }
-        return 0; // Nothing to send
-    }
-    // Send packet
-    const int ret = hal_ble_gatt_server_notify_characteristic_value(sendCharHandle_, (const uint8_t*)packetBuf_.get(), packetSize_, nullptr);
-    if (ret != (int)packetSize_) {
-        LOG(ERROR, "hal_ble_gatt_server_notify_characteristic_value() failed: %d", ret);
-        return ret;
+        // Send packet
+        const int ret = hal_ble_gatt_server_notify_characteristic_value(sendCharHandle_, (const uint8_t*)packetBuf_.get(), packetSize_, nullptr);
+        if (ret != (int)packetSize_) {
+            LOG(ERROR, "hal_ble_gatt_server_notify_characteristic_value() failed: %d", ret);
+            return ret;
+        }
+        DEBUG("Sent BLE packet");
+        DEBUG_DUMP(packetBuf_.get(), packetSize_);
+        packetSize_ = 0;
     }
-    DEBUG("Sent BLE packet");
-    DEBUG_DUMP(packetBuf_.get(), packetSize_);
-    packetSize_ = 0;
-    return 0;
 }
 
 bool BleControlRequestChannel::readAll(char* data, size_t size) {
@@ -1186,7 +1376,7 @@ int BleControlRequestChannel::initJpake() {
         LOG_DEBUG(ERROR, "Invalid size of the device secret data");
         return SYSTEM_ERROR_INTERNAL;
     }
-    jpake_.reset(new(std::nothrow) JpakeHandler(this));
+    jpake_.reset(new(std::nothrow) JpakeHandler(this, sessions_.get()));
     if (!jpake_) {
         return SYSTEM_ERROR_NO_MEMORY;
     }
@@ -39,6 +39,11 @@
 #define BLE_CHANNEL_SECURITY_ENABLED 1
 #endif
 
+// Set this macro to 0 to disable resumption of recently established sessions
+#ifndef BLE_CHANNEL_SESSION_RESUMPTION_ENABLED
+#define BLE_CHANNEL_SESSION_RESUMPTION_ENABLED 1
+#endif
+
 // Set this macro to 1 to enable additional logging
 #ifndef BLE_CHANNEL_DEBUG_ENABLED
 #define BLE_CHANNEL_DEBUG_ENABLED 0
@@ -67,6 +72,7 @@ public:
 private:
     class HandshakeHandler;
     class JpakeHandler;
+    class SessionCache;
     class AesCcmCipher;
 
     struct Buffer: LinkedBuffer<> {
@@ -109,6 +115,7 @@ private:
 #if BLE_CHANNEL_SECURITY_ENABLED
     std::unique_ptr<AesCcmCipher> aesCcm_; // AES cipher
     std::unique_ptr<JpakeHandler> jpake_; // J-PAKE handshake handler
+    std::unique_ptr<SessionCache> sessions_; // Secrets of recently established sessions
 #endif
     AtomicAllocedPool pool_; // Pool allocator
 
@@ -107,7 +107,7 @@ int getActiveSim(ctrl_request* req) {
     CHECK(cellMgr->getActiveSim(&sim));
     PB(GetActiveSimReply) pbRep = {};
     pbRep.sim_type = (PB(SimType))sim;
-    CHECK(encodeReplyMessage(req, PB(GetActiveSimReply_fields), &pbRep));
+    CHECK(ENCODE_FIXED_SIZE_REPLY(req, PB(GetActiveSimReply), &pbRep));
     return 0;
 }
 
@@ -46,7 +46,7 @@ int getConnectionStatus(ctrl_request* req) {
     }
     PB(GetConnectionStatusReply) pbRep = {};
     pbRep.status = (PB(ConnectionStatus))stat;
-    ret = encodeReplyMessage(req, PB_FIELDS(GetConnectionStatusReply), &pbRep);
+    ret = ENCODE_FIXED_SIZE_REPLY(req, PB(GetConnectionStatusReply), &pbRep);
     if (ret != 0) {
         return ret;
     }
@@ -34,114 +34,144 @@ namespace particle {
 namespace control {
 namespace common {
 
-int appendReplySubmessage(ctrl_request* req, size_t offset, const pb_field_t* field, const pb_field_t* fields, const void* src) {
-    size_t sz = 0;
-    CHECK_TRUE(pb_get_encoded_size(&sz, fields, src), SYSTEM_ERROR_UNKNOWN);
-
-    // Check whether the message fits into the current reply buffer
-    // Worst case scenario, reserve 16 additional bytes
-    size_t sizeRequired = offset + sz + sizeof(uint64_t) * 2;
-    if (sizeRequired > req->reply_size) {
-        // Attempt to realloc
-        CHECK(system_ctrl_alloc_reply_data(req, sizeRequired, nullptr));
-    }
+namespace {
 
-    // Allocate ostream
-    auto stream = pb_ostream_init(nullptr);
-    if (stream == nullptr) {
-        return SYSTEM_ERROR_NO_MEMORY;
-    }
+int reallocReplyBuffer(pb_growable_buffer* buf, size_t size) {
+    const auto req = static_cast<ctrl_request*>(buf->user_data);
+    CHECK(system_ctrl_alloc_reply_data(req, size, nullptr));
+    buf->data = (pb_byte_t*)req->reply_data;
+    buf->size = req->reply_size;
+    return 0;
+}
 
-    SCOPE_GUARD({
-        pb_ostream_free(stream, nullptr);
-    });
+void initReplyBuffer(pb_growable_buffer* buf, ctrl_request* req, size_t offset) {
+    buf->data = (pb_byte_t*)req->reply_data;
+    buf->size = req->reply_size;
+    buf->offset = offset;
+    buf->realloc_fn = reallocReplyBuffer;
+    buf->user_data = req;
+    buf->error = 0;
+}
 
-    CHECK_TRUE(pb_ostream_from_buffer_ex(stream, (pb_byte_t*)req->reply_data + offset,
-            req->reply_size - offset, nullptr), SYSTEM_ERROR_UNKNOWN);
+// Returns the result code of a failed encoding operation
+inline int encodeError(const pb_growable_buffer& buf) {
+    // Report the allocation error, if any, rather than a generic encoding error
+    return (buf.error < 0) ? buf.error : SYSTEM_ERROR_UNKNOWN;
+}
 
-    // Encode tag
-    CHECK_TRUE(pb_encode_tag_for_field(stream, field), SYSTEM_ERROR_UNKNOWN);
-    // Encode submessage
-    CHECK_TRUE(pb_encode_submessage(stream, fields, src), SYSTEM_ERROR_UNKNOWN);
+} // unnamed
 
-    // Is this safe?
-    const size_t written = stream->bytes_written;
-    return written;
+ReplyEncoder::ReplyEncoder(ctrl_request* req) :
+        req_(req),
+        buf_(),
+        strm_(nullptr),
+        done_(false) {
 }
 
-int encodeReplyMessage(ctrl_request* req, const pb_field_t* fields, const void* src) {
-    pb_ostream_t* stream = nullptr;
-    size_t sz = 0;
-    int ret = SYSTEM_ERROR_UNKNOWN;
-
-    // Calculate size
-    bool res = pb_get_encoded_size(&sz, fields, src);
-    if (!res) {
-        goto cleanup;
+ReplyEncoder::~ReplyEncoder() {
+    if (strm_) {
+        pb_ostream_free(strm_, nullptr);
+        if (!done_) {
+            system_ctrl_alloc_reply_data(req_, 0, nullptr);
+        }
     }
+}
 
-    // Allocate reply data
-    ret = system_ctrl_alloc_reply_data(req, sz, nullptr);
-    if (ret != SYSTEM_ERROR_NONE) {
-        goto cleanup;
+int ReplyEncoder::init() {
+    if (strm_) {
+        return SYSTEM_ERROR_INVALID_STATE;
     }
-    ret = SYSTEM_ERROR_UNKNOWN;
-
-    // Allocate ostream
-    stream = pb_ostream_init(nullptr);
-    if (stream == nullptr) {
-        ret = SYSTEM_ERROR_NO_MEMORY;
-        goto cleanup;
-    }
-
-    res = pb_ostream_from_buffer_ex(stream, (pb_byte_t*)req->reply_data, req->reply_size, nullptr);
-    if (!res) {
-        goto cleanup;
+    strm_ = pb_ostream_init(nullptr);
+    CHECK_TRUE(strm_, SYSTEM_ERROR_NO_MEMORY);
+    initReplyBuffer(&buf_, req_, 0 /* offset */);
+    if (!pb_ostream_from_growable_buffer(strm_, &buf_, nullptr)) {
+        pb_ostream_free(strm_, nullptr);
+        strm_ = nullptr;
+        return SYSTEM_ERROR_UNKNOWN;
     }
+    return 0;
+}
 
-    res = pb_encode(stream, fields, src);
-    if (res) {
-        ret = SYSTEM_ERROR_NONE;
+int ReplyEncoder::encode(const pb_field_t* fields, const void* src) {
+    CHECK_TRUE(strm_ && !done_, SYSTEM_ERROR_INVALID_STATE);
+    if (!pb_encode(strm_, fields, src)) {
+        return encodeError(buf_);
     }
+    return 0;
+}
 
-cleanup:
-    if (stream != nullptr) {
-        pb_ostream_free(stream, nullptr);
-    }
-    if (ret != SYSTEM_ERROR_NONE) {
-        system_ctrl_alloc_reply_data(req, 0, nullptr);
+int ReplyEncoder::encodeSubmessage(const pb_field_t* field, const pb_field_t* fields, const void* src) {
+    CHECK_TRUE(strm_ && !done_, SYSTEM_ERROR_INVALID_STATE);
+    if (!pb_encode_tag_for_field(strm_, field) || !pb_encode_submessage(strm_, fields, src)) {
+        return encodeError(buf_);
     }
-    return ret;
+    return 0;
 }
 
-int decodeRequestMessage(ctrl_request* req, const pb_field_t* fields, void* dst) {
-    pb_istream_t* stream = nullptr;
-    int ret = SYSTEM_ERROR_UNKNOWN;
-    bool res = false;
+int ReplyEncoder::finish() {
+    CHECK_TRUE(strm_ && !done_, SYSTEM_ERROR_INVALID_STATE);
+    CHECK(system_ctrl_alloc_reply_data(req_, strm_->bytes_written, nullptr));
+    done_ = true;
+    return 0;
+}
 
-    stream = pb_istream_init(nullptr);
+int appendReplySubmessage(ctrl_request* req, size_t offset, const pb_field_t* field, const pb_field_t* fields, const void* src) {
+    // Allocate ostream
+    auto stream = pb_ostream_init(nullptr);
     if (stream == nullptr) {
-        ret = SYSTEM_ERROR_NO_MEMORY;
-        goto cleanup;
+        return SYSTEM_ERROR_NO_MEMORY;
     }
 
-    res = pb_istream_from_buffer_ex(stream, (const pb_byte_t*)req->request_data, req->request_size, nullptr);
-    if (!res) {
-        goto cleanup;
-    }
+    SCOPE_GUARD({
+        pb_ostream_free(stream, nullptr);
+    });
 
-    res = pb_decode_noinit(stream, fields, dst);
-    if (res) {
-        ret = SYSTEM_ERROR_NONE;
-    } else {
-        ret = SYSTEM_ERROR_BAD_DATA;
-    }
+    // Encode directly into the reply buffer, growing it as necessary
+    pb_growable_buffer buf = {};
+    initReplyBuffer(&buf, req, offset);
+    CHECK_TRUE(pb_ostream_from_growable_buffer(stream, &buf, nullptr), SYSTEM_ERROR_UNKNOWN);
 
-cleanup:
-    if (stream != nullptr) {
-        pb_istream_free(stream, nullptr);
+    // Encode tag and submessage
+    if (!pb_encode_tag_for_field(stream, field) || !pb_encode_submessage(stream, fields, src)) {
+        return encodeError(buf);
     }
-    return ret;
+
+    return stream->bytes_written;
+}
+
+int encodeReplyMessage(ctrl_request* req, const pb_field_t* fields, const void* src) {
+    // Encode the message in a single pass. Calculating its size with pb_get_encoded_size() first
+    // would invoke the encoding callbacks of the message twice
+    ReplyEncoder enc(req);
+    CHECK(enc.init());
+    CHECK(enc.encode(fields, src));
+    CHECK(enc.finish());
+    return 0;
+}
+
+int encodeReplyMessage(ctrl_request* req, const pb_field_t* fields, const void* src, size_t maxSize) {
+    // The maximum size of the message is known, so it can be encoded straight into a buffer of
+    // that size without growing it
+    CHECK(system_ctrl_alloc_reply_data(req, maxSize, nullptr));
+    NAMED_SCOPE_GUARD(freeGuard, {
+        system_ctrl_alloc_reply_data(req, 0, nullptr);
+    });
+    size_t size = 0;
+    if (maxSize > 0) {
+        auto stream = pb_ostream_init(nullptr);
+        CHECK_TRUE(stream, SYSTEM_ERROR_NO_MEMORY);
+        SCOPE_GUARD({
+            pb_ostream_free(stream, nullptr);
+        });
+        CHECK_TRUE(pb_ostream_from_buffer_ex(stream, (pb_byte_t*)req->reply_data, maxSize, nullptr), SYSTEM_ERROR_UNKNOWN);
+        CHECK_TRUE(pb_encode(stream, fields, src), SYSTEM_ERROR_UNKNOWN);
+        size = stream->bytes_written;
+    }
+    if (size < maxSize) {
+        CHECK(system_ctrl_alloc_reply_data(req, size, nullptr));
+    }
+    freeGuard.dismiss();
+    return 0;
 }
 
 int protoIpFromHal(particle_ctrl_IPAddress* ip, const HAL_IPAddress* sip) {
@@ -29,13 +29,83 @@
 #include <pb_decode.h>
 #include <stdlib.h>
 
+#include "nanopb_misc.h"
+
 #include "proto/common.pb.h"
 
+/**
+ * Encodes a reply message whose maximum encoded size is known at compile time.
+ *
+ * The message type must have a `<type>_size` macro generated by nanopb, i.e. it must not contain
+ * callback fields or other fields of an unbounded size. The reply buffer is allocated once, and
+ * the message is encoded in a single pass.
+ */
+#define ENCODE_FIXED_SIZE_REPLY(_req, _type, _src) \
+        ENCODE_FIXED_SIZE_REPLY_(_req, _type, _src)
+
+// Expands the type name before pasting, so that it can be passed via a macro such as PB()
+#define ENCODE_FIXED_SIZE_REPLY_(_req, _type, _src) \
+        ::particle::control::common::encodeReplyMessage(_req, _type##_fields, _src, _type##_size)
+
 namespace particle {
 namespace control {
 namespace common {
 
+/**
+ * Output stream encoding data directly into the reply buffer of a request.
+ *
+ * The reply buffer grows in chunks as the data is written, so the size of the reply doesn't need
+ * to be calculated in an extra encoding pass, and a handler can encode the elements of a repeated
+ * field one by one as they become available instead of collecting them in a container first:
+ *
+ * ```
+ * ReplyEncoder enc(req);
+ * CHECK(enc.init());
+ * for (...) {
+ *     CHECK(enc.encodeSubmessage(&PB(SomeReply_fields)[0], PB(SomeReply_Item_fields), &pbItem));
+ * }
+ * CHECK(enc.finish());
+ * ```
+ *
+ * The reply data is freed if the encoder is destroyed without calling `finish()`.
+ */
+class ReplyEncoder {
+public:
+    explicit ReplyEncoder(ctrl_request* req);
+    ~ReplyEncoder();
+
+    int init();
+
+    // Encodes a message
+    int encode(const pb_field_t* fields, const void* src);
+    // Encodes a submessage field, such as an element of a repeated field of the reply message
+    int encodeSubmessage(const pb_field_t* field, const pb_field_t* fields, const void* src);
+    // Truncates the reply buffer to the size of the encoded data
+    int finish();
+
+    pb_ostream_t* stream() const {
+        return strm_;
+    }
+
+    size_t size() const {
+        return strm_ ? strm_->bytes_written : 0;
+    }
+
+    // This class is non-copyable
+    ReplyEncoder(const ReplyEncoder&) = delete;
+    ReplyEncoder& operator=(const ReplyEncoder&) = delete;
+
+private:
+    ctrl_request* req_;
+    pb_growable_buffer buf_;
+    pb_ostream_t* strm_;
+    bool done_;
+};
+
 int encodeReplyMessage(ctrl_request* req, const pb_field_t* fields, const void* src);
+// Encodes a reply message into a buffer of a fixed size. Use ENCODE_FIXED_SIZE_REPLY() instead
+// of calling this function directly
+int encodeReplyMessage(ctrl_request* req, const pb_field_t* fields, const void* src, size_t maxSize);
 int decodeRequestMessage(ctrl_request* req, const pb_field_t* fields, void* dst);
 int appendReplySubmessage(ctrl_request* req, size_t offset, const pb_field_t* field,
         const pb_field_t* fields, const void* src);
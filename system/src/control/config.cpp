@@ -70,7 +70,7 @@ int getDeviceId(ctrl_request* req) {
     PB(GetDeviceIdReply) pbRep = {};
     static_assert(sizeof(pbRep.id) >= sizeof(id) * 2, "");
     bytes2hexbuf_lower_case(id, sizeof(id), pbRep.id);
-    const int ret = encodeReplyMessage(req, PB_FIELDS(GetDeviceIdReply), &pbRep);
+    const int ret = ENCODE_FIXED_SIZE_REPLY(req, PB(GetDeviceIdReply), &pbRep);
     if (ret != 0) {
         return ret;
     }
@@ -84,7 +84,7 @@ int getSerialNumber(ctrl_request* req) {
     if (ret < 0) {
         return ret;
     }
-    ret = encodeReplyMessage(req, PB_FIELDS(GetSerialNumberReply), &pbRep);
+    ret = ENCODE_FIXED_SIZE_REPLY(req, PB(GetSerialNumberReply), &pbRep);
     if (ret != 0) {
         return ret;
     }
@@ -126,7 +126,7 @@ int getNcpFirmwareVersion(ctrl_request* req) {
 int getSystemCapabilities(ctrl_request* req) {
     PB(GetSystemCapabilitiesReply) pbRep = {};
     pbRep.flags |= PB(SystemCapabilityFlag_COMPRESSED_OTA);
-    CHECK(encodeReplyMessage(req, PB(GetSystemCapabilitiesReply_fields), &pbRep));
+    CHECK(ENCODE_FIXED_SIZE_REPLY(req, PB(GetSystemCapabilitiesReply), &pbRep));
     return 0;
 }
 
@@ -142,7 +142,7 @@ int handleSetClaimCodeRequest(ctrl_request* req) {
 int handleIsClaimedRequest(ctrl_request* req) {
     particle_ctrl_IsClaimedReply pbRep = {};
     pbRep.claimed = HAL_IsDeviceClaimed(nullptr);
-    const int ret = encodeReplyMessage(req, particle_ctrl_IsClaimedReply_fields, &pbRep);
+    const int ret = ENCODE_FIXED_SIZE_REPLY(req, PB(IsClaimedReply), &pbRep);
     return ret;
 }
 
@@ -160,7 +160,7 @@ int getDeviceMode(ctrl_request* req) {
     const bool listening = network_listening(0, 0, nullptr);
     PB(GetDeviceModeReply) pbRep = {};
     pbRep.mode = listening ? PB(DeviceMode_LISTENING_MODE) : PB(DeviceMode_NORMAL_MODE);
-    const int ret = encodeReplyMessage(req, PB(GetDeviceModeReply_fields), &pbRep);
+    const int ret = ENCODE_FIXED_SIZE_REPLY(req, PB(GetDeviceModeReply), &pbRep);
     if (ret != 0) {
         return ret;
     }
@@ -195,7 +195,7 @@ int isDeviceSetupDone(ctrl_request* req) {
     }
     PB(IsDeviceSetupDoneReply) pbRep = {};
     pbRep.done = (val == 0x01) ? true : false;
-    ret = encodeReplyMessage(req, PB(IsDeviceSetupDoneReply_fields), &pbRep);
+    ret = ENCODE_FIXED_SIZE_REPLY(req, PB(IsDeviceSetupDoneReply), &pbRep);
     if (ret != 0) {
         return ret;
     }
@@ -243,7 +243,7 @@ int getFeature(ctrl_request* req) {
     default:
         return SYSTEM_ERROR_NOT_SUPPORTED;
     }
-    CHECK(encodeReplyMessage(req, PB(GetFeatureReply_fields), &pbRep));
+    CHECK(ENCODE_FIXED_SIZE_REPLY(req, PB(GetFeatureReply), &pbRep));
     return 0;
 }
 
@@ -365,7 +365,7 @@ int handleGetServerProtocolRequest(ctrl_request* req) {
     } else {
         pbRep.protocol = particle_ctrl_ServerProtocolType_TCP_PROTOCOL;
     }
-    const int ret = encodeReplyMessage(req, particle_ctrl_GetServerProtocolReply_fields, &pbRep);
+    const int ret = ENCODE_FIXED_SIZE_REPLY(req, PB(GetServerProtocolReply), &pbRep);
     return ret;
 }
 
@@ -306,7 +306,7 @@ int startFirmwareUpdateRequest(ctrl_request* req) {
     g_update = std::move(update);
     PB(StartFirmwareUpdateReply) pbRep = {};
     pbRep.chunk_size = g_update->descr.chunk_size;
-    ret = encodeReplyMessage(req, PB(StartFirmwareUpdateReply_fields), &pbRep);
+    ret = ENCODE_FIXED_SIZE_REPLY(req, PB(StartFirmwareUpdateReply), &pbRep);
     if (ret != 0) {
         cancelFirmwareUpdate();
         return ret;
@@ -579,7 +579,7 @@ int getSectionDataSizeRequest(ctrl_request* req) {
     }
     particle_ctrl_GetSectionDataSizeReply pbRep = {};
     pbRep.size = size;
-    ret = encodeReplyMessage(req, particle_ctrl_GetSectionDataSizeReply_fields, &pbRep);
+    ret = ENCODE_FIXED_SIZE_REPLY(req, PB(GetSectionDataSizeReply), &pbRep);
     if (ret != 0) {
         return ret;
     }
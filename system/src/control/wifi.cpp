@@ -55,7 +55,7 @@ int handleGetAntennaRequest(ctrl_request* req) {
             reply.antenna = particle_ctrl_WiFiAntenna_AUTO;
         break;
     }
-    return encodeReplyMessage(req, particle_ctrl_WiFiGetAntennaReply_fields, &reply);
+    return ENCODE_FIXED_SIZE_REPLY(req, particle_ctrl_WiFiGetAntennaReply, &reply);
 }
 
 int handleSetAntennaRequest(ctrl_request* req) {
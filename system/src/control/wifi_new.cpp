@@ -29,8 +29,6 @@
 #include "scope_guard.h"
 #include "check.h"
 
-#include "spark_wiring_vector.h"
-
 #include "wifi_new.pb.h"
 
 #define PB(_name) particle_ctrl_wifi_##_name
@@ -44,7 +42,6 @@ namespace wifi {
 namespace {
 
 using namespace particle::control::common;
-using spark::Vector;
 
 template<typename T>
 void bssidToPb(const MacAddress& bssid, T* pbBssid) {
@@ -126,33 +123,21 @@ int joinKnownNetwork(ctrl_request* req) {
 int getKnownNetworks(ctrl_request* req) {
     const auto wifiMgr = wifiNetworkManager();
     CHECK_TRUE(wifiMgr, SYSTEM_ERROR_UNKNOWN);
-    // Enumerate configured networks
-    Vector<WifiNetworkConfig> networks;
+    // Encode each configured network as it's enumerated. The reply message consists only of
+    // the repeated `networks` field
+    ReplyEncoder enc(req);
+    CHECK(enc.init());
     CHECK(wifiMgr->getNetworkConfig([](WifiNetworkConfig conf, void* data) -> int {
-        const auto networks = (Vector<WifiNetworkConfig>*)data;
-        CHECK_TRUE(networks->append(std::move(conf)), SYSTEM_ERROR_NO_MEMORY);
+        const auto enc = (ReplyEncoder*)data;
+        PB(GetKnownNetworksReply_Network) pbConf = {};
+        EncodedString eSsid(&pbConf.ssid, conf.ssid(), strlen(conf.ssid()));
+        pbConf.security = (PB(Security))conf.security();
+        pbConf.credentials_type = (PB(CredentialsType))conf.credentials().type();
+        CHECK(enc->encodeSubmessage(&PB(GetKnownNetworksReply_fields)[0], PB(GetKnownNetworksReply_Network_fields),
+                &pbConf));
         return 0;
-    }, &networks));
-    // Encode a reply
-    PB(GetKnownNetworksReply) pbRep = {};
-    pbRep.networks.arg = &networks;
-    pbRep.networks.funcs.encode = [](pb_ostream_t* strm, const pb_field_t* field, void* const* arg) {
-        const auto networks = (const Vector<WifiNetworkConfig>*)*arg;
-        for (const WifiNetworkConfig& conf: *networks) {
-            PB(GetKnownNetworksReply_Network) pbConf = {};
-            EncodedString eSsid(&pbConf.ssid, conf.ssid(), strlen(conf.ssid()));
-            pbConf.security = (PB(Security))conf.security();
-            pbConf.credentials_type = (PB(CredentialsType))conf.credentials().type();
-            if (!pb_encode_tag_for_field(strm, field)) {
-                return false;
-            }
-            if (!pb_encode_submessage(strm, PB(GetKnownNetworksReply_Network_fields), &pbConf)) {
-                return false;
-            }
-        }
-        return true;
-    };
-    CHECK(encodeReplyMessage(req, PB(GetKnownNetworksReply_fields), &pbRep));
+    }, &enc));
+    CHECK(enc.finish());
     return 0;
 }
 
@@ -196,35 +181,23 @@ int scanNetworks(ctrl_request* req) {
     const auto ncpClient = wifiMgr->ncpClient();
     CHECK_TRUE(ncpClient, SYSTEM_ERROR_UNKNOWN);
     CHECK(ncpClient->on());
-    // Scan for networks
-    Vector<WifiScanResult> networks;
-    CHECK(ncpClient->scan([](WifiScanResult network, void* data) -> int {
-        const auto networks = (Vector<WifiScanResult>*)data;
-        CHECK_TRUE(networks->append(std::move(network)), SYSTEM_ERROR_NO_MEMORY);
+    // Scan for networks and encode each network as soon as it's discovered. The reply message
+    // consists only of the repeated `networks` field
+    ReplyEncoder enc(req);
+    CHECK(enc.init());
+    CHECK(wifiMgr->scan([](WifiScanResult network, void* data) -> int {
+        const auto enc = (ReplyEncoder*)data;
+        PB(ScanNetworksReply_Network) pbNetwork = {};
+        EncodedString eSsid(&pbNetwork.ssid, network.ssid(), strlen(network.ssid()));
+        bssidToPb(network.bssid(), &pbNetwork.bssid);
+        pbNetwork.security = (PB(Security))network.security();
+        pbNetwork.channel = network.channel();
+        pbNetwork.rssi = network.rssi();
+        CHECK(enc->encodeSubmessage(&PB(ScanNetworksReply_fields)[0], PB(ScanNetworksReply_Network_fields),
+                &pbNetwork));
         return 0;
-    }, &networks));
-    // Encode a reply
-    PB(ScanNetworksReply) pbRep = {};
-    pbRep.networks.arg = &networks;
-    pbRep.networks.funcs.encode = [](pb_ostream_t* strm, const pb_field_t* field, void* const* arg) {
-        const auto networks = (const Vector<WifiScanResult>*)*arg;
-        for (const WifiScanResult& network: *networks) {
-            PB(ScanNetworksReply_Network) pbNetwork = {};
-            EncodedString eSsid(&pbNetwork.ssid, network.ssid(), strlen(network.ssid()));
-            bssidToPb(network.bssid(), &pbNetwork.bssid);
-            pbNetwork.security = (PB(Security))network.security();
-            pbNetwork.channel = network.channel();
-            pbNetwork.rssi = network.rssi();
-            if (!pb_encode_tag_for_field(strm, field)) {
-                return false;
-            }
-            if (!pb_encode_submessage(strm, PB(ScanNetworksReply_Network_fields), &pbNetwork)) {
-                return false;
-            }
-        }
-        return true;
-    };
-    CHECK(encodeReplyMessage(req, PB(ScanNetworksReply_fields), &pbRep));
+    }, &enc));
+    CHECK(enc.finish());
     return 0;
 }
 
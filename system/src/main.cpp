@@ -40,6 +40,10 @@
 #include "system_user.h"
 #include "system_update.h"
 #include "system_commands.h"
+#include "system_deferred_init.h"
+#include "system_loop_stats.h"
+#include "trace.h"
+#include "boot_timeline.h"
 #include "core_hal.h"
 #include "delay_hal.h"
 #include "syshealth_hal.h"
@@ -459,6 +463,9 @@ bool semi_automatic_connecting(bool threaded) {
 
 void app_loop(bool threaded)
 {
+    const auto loopStats = particle::system::LoopStats::instance();
+    loopStats->loopStarted();
+
     DECLARE_SYS_HEALTH(ENTERED_WLAN_Loop);
     if (!threaded)
         Spark_Idle();
@@ -467,7 +474,7 @@ void app_loop(bool threaded)
     do {
     if(threaded || SPARK_WLAN_SLEEP || !spark_cloud_flag_auto_connect() || spark_cloud_flag_connected() || SPARK_WIRING_APPLICATION || (system_mode()!=AUTOMATIC))
     {
-        if(threaded || !SPARK_FLASH_UPDATE)
+        if(threaded || !system_update_blocks_application())
         {
                 if (semi_automatic_connecting(threaded)) {
                     break;
@@ -483,8 +490,14 @@ void app_loop(bool threaded)
             {
                 //Execute user application setup only once
                 DECLARE_SYS_HEALTH(ENTERED_Setup);
-                if (system_mode()!=SAFE_MODE)
-                 setup();
+                system::notifyApplicationSetup();
+                if (system_mode()!=SAFE_MODE) {
+                    boot_timeline_mark(BOOT_STAGE_SETUP, nullptr);
+                    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_BEGIN, TRACE_BOOT_STAGE_SETUP);
+                    setup();
+                    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_END, TRACE_BOOT_STAGE_SETUP);
+                    boot_timeline_mark(BOOT_STAGE_SETUP_DONE, nullptr);
+                }
                 SPARK_WIRING_APPLICATION = 1;
 #if !(defined(MODULAR_FIRMWARE) && MODULAR_FIRMWARE)
                 _post_loop();
@@ -497,7 +510,9 @@ void app_loop(bool threaded)
             //Execute user application loop
             DECLARE_SYS_HEALTH(ENTERED_Loop);
             if (system_mode()!=SAFE_MODE) {
+                loopStats->userLoopStarted();
                 loop();
+                loopStats->userLoopFinished();
                 DECLARE_SYS_HEALTH(RAN_Loop);
 #if !(defined(MODULAR_FIRMWARE) && MODULAR_FIRMWARE)
                 _post_loop();
@@ -506,6 +521,7 @@ void app_loop(bool threaded)
         }
     }
     } while(false);
+    loopStats->loopFinished();
 #if PLATFORM_ID == 3 && SUSPEND_APPLICATION_THREAD_LOOP_COUNT
     // Suspend thread execution for some minimum time on every Nth loop iteration in order to workaround
     // 100% CPU usage on the virtual device platform
@@ -617,6 +633,24 @@ public:
     }
 };
 
+// Time it took to get from the bootloader to the application's setup(), in milliseconds
+class BootTimeDiagnosticData: public AbstractIntegerDiagnosticData {
+public:
+    BootTimeDiagnosticData() :
+            AbstractIntegerDiagnosticData(DIAG_ID_SYSTEM_BOOT_TIME, DIAG_NAME_SYSTEM_BOOT_TIME) {
+    }
+
+    virtual int get(IntType& val) override {
+        boot_timeline t = {};
+        CHECK(boot_timeline_get(&t, 0 /* previous */, nullptr));
+        if (!(t.stages & (1 << BOOT_STAGE_SETUP))) {
+            return SYSTEM_ERROR_NOT_FOUND;
+        }
+        val = (t.time[BOOT_STAGE_SETUP] - t.time[BOOT_STAGE_START]) / 1000;
+        return 0; // OK
+    }
+};
+
 class RunTimeInfoDiagnosticData: public AbstractIntegerDiagnosticData {
 public:
     typedef IntType(*func_t)(const runtime_info_t&);
@@ -686,6 +720,8 @@ HALEventHandler g_halEventHandler;
 
 UptimeDiagnosticData g_uptimeDiagData;
 
+BootTimeDiagnosticData g_bootTimeDiagData;
+
 RunTimeInfoDiagnosticData g_totalRamDiagData(DIAG_ID_SYSTEM_TOTAL_RAM, DIAG_NAME_SYSTEM_TOTAL_RAM,
     [](const runtime_info_t& info) -> RunTimeInfoDiagnosticData::IntType {
         return info.total_init_heap;
@@ -698,6 +734,27 @@ RunTimeInfoDiagnosticData g_usedRamDiagData(DIAG_ID_SYSTEM_USED_RAM, DIAG_NAME_S
     }
 );
 
+// Heap fragmentation: a large amount of free memory split into many small blocks can't serve
+// large allocations
+RunTimeInfoDiagnosticData g_largestFreeBlockDiagData(DIAG_ID_SYSTEM_LARGEST_FREE_BLOCK,
+    DIAG_NAME_SYSTEM_LARGEST_FREE_BLOCK,
+    [](const runtime_info_t& info) -> RunTimeInfoDiagnosticData::IntType {
+        return info.largest_free_block_heap;
+    }
+);
+
+RunTimeInfoDiagnosticData g_freeBlocksDiagData(DIAG_ID_SYSTEM_FREE_BLOCKS, DIAG_NAME_SYSTEM_FREE_BLOCKS,
+    [](const runtime_info_t& info) -> RunTimeInfoDiagnosticData::IntType {
+        return info.free_blocks_heap;
+    }
+);
+
+RunTimeInfoDiagnosticData g_userHeapDiagData(DIAG_ID_SYSTEM_USER_HEAP, DIAG_NAME_SYSTEM_USER_HEAP,
+    [](const runtime_info_t& info) -> RunTimeInfoDiagnosticData::IntType {
+        return info.user_heap;
+    }
+);
+
 } // namespace
 
 /*******************************************************************************
@@ -709,14 +766,18 @@ RunTimeInfoDiagnosticData g_usedRamDiagData(DIAG_ID_SYSTEM_USED_RAM, DIAG_NAME_S
  *******************************************************************************/
 void app_setup_and_loop(void)
 {
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_BEGIN, TRACE_BOOT_STAGE_HAL);
     system_part2_post_init();
+    boot_timeline_mark(BOOT_STAGE_MODULE_INIT, nullptr);
     HAL_Core_Init();
     main_thread_current(NULL);
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_END, TRACE_BOOT_STAGE_HAL);
     // We have running firmware, otherwise we wouldn't have gotten here
     DECLARE_SYS_HEALTH(ENTERED_Main);
 
     LED_SIGNAL_START(NETWORK_OFF, BACKGROUND);
 
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_BEGIN, TRACE_BOOT_STAGE_SETTINGS);
     // Reset all persistent settings to factory defaults if necessary
     resetSettingsToFactoryDefaultsIfNeeded();
 
@@ -724,6 +785,7 @@ void app_setup_and_loop(void)
 
     // Start the diagnostics service
     diag_command(DIAG_SERVICE_CMD_START, nullptr, nullptr);
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_END, TRACE_BOOT_STAGE_SETTINGS);
 
     DEBUG("Hello from Particle!");
     String s = spark_deviceID();
@@ -742,14 +804,18 @@ void app_setup_and_loop(void)
     }
 
 #if HAL_PLATFORM_RADIO_STACK
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_BEGIN, TRACE_BOOT_STAGE_RADIO);
     initRadioAntenna();
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_END, TRACE_BOOT_STAGE_RADIO);
 #endif
 
-#if HAL_PLATFORM_BLE
-    // FIXME: Move BLE and Thread initialization to an appropriate place
-    SPARK_ASSERT(hal_ble_stack_init(nullptr) == SYSTEM_ERROR_NONE);
-#endif // HAL_PLATFORM_BLE
+    // Initialize the BLE stack and control request channels, unless the application asked for
+    // their initialization to be deferred until its setup() has started
+    if (!system::isSubsystemInitDeferred() || system_mode() == SAFE_MODE) {
+        system::initDeferredSubsystems();
+    }
 
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_BEGIN, TRACE_BOOT_STAGE_NETWORK_STACK);
 #if HAL_PLATFORM_LWIP
     if_init();
 #endif /* HAL_PLATFORM_LWIP */
@@ -757,11 +823,9 @@ void app_setup_and_loop(void)
 #if HAL_PLATFORM_OPENTHREAD
     system::threadInit();
 #endif /* HAL_PLATFORM_OPENTHREAD */
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_END, TRACE_BOOT_STAGE_NETWORK_STACK);
 
-#if SYSTEM_CONTROL_ENABLED
-    system::SystemControl::instance()->init();
-#endif // SYSTEM_CONTROL_ENABLED
-
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_BEGIN, TRACE_BOOT_STAGE_USB);
     manage_safe_mode();
 
 #if defined(USB_CDC_ENABLE) || defined(USB_HID_ENABLE)
@@ -786,9 +850,15 @@ void app_setup_and_loop(void)
         HAL_Core_System_Reset_Ex(RESET_REASON_UPDATE, 0, nullptr);
     }
 
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_END, TRACE_BOOT_STAGE_USB);
+
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_BEGIN, TRACE_BOOT_STAGE_NETWORK);
     Network_Setup(threaded);    // todo - why does this come before system thread initialization?
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_END, TRACE_BOOT_STAGE_NETWORK);
+    boot_timeline_mark(BOOT_STAGE_NETWORK_INIT, nullptr);
 
 #if PLATFORM_THREADING
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_BEGIN, TRACE_BOOT_STAGE_THREADS);
     if (threaded)
     {
         SystemThread.start();
@@ -799,6 +869,8 @@ void app_setup_and_loop(void)
         SystemThread.setCurrentThread();
         ApplicationThread.setCurrentThread();
     }
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_END, TRACE_BOOT_STAGE_THREADS);
+    boot_timeline_mark(BOOT_STAGE_THREAD_START, nullptr);
 #endif
     if(!threaded) {
         /* Main loop */
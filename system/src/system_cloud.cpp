@@ -26,6 +26,7 @@
  */
 
 #include <cstdarg>
+#include <cstddef>
 
 #include "logging.h"
 #include "protocol_defs.h"
@@ -34,6 +35,9 @@
 #include "system_cloud.h"
 #include "system_cloud_internal.h"
 #include "system_publish_vitals.h"
+#include "system_publish_queue.h"
+#include "system_isr_publish.h"
+#include "system_keepalive.h"
 #include "system_task.h"
 #include "system_threading.h"
 #include "system_update.h"
@@ -106,10 +110,29 @@ bool spark_subscribe(const char *eventName, EventHandler handler, void* handler_
 {
     SYSTEM_THREAD_CONTEXT_SYNC(spark_subscribe(eventName, handler, handler_data, scope, deviceID, reserved));
     auto event_scope = convert(scope);
-    bool success = spark_protocol_add_event_handler(sp, eventName, handler, event_scope, deviceID, handler_data);
+    bool success = false;
+    bool filtered = false;
+    auto d = static_cast<const spark_subscribe_data*>(reserved);
+    if (d && d->flags) {
+        spark_protocol_event_filter filter = { sizeof(spark_protocol_event_filter) };
+        filter.flags = d->flags;
+        if (d->size >= offsetof(spark_subscribe_data, data_filter) + sizeof(d->data_filter)) {
+            filter.data_filter = d->data_filter;
+        }
+        success = spark_protocol_add_filtered_event_handler(sp, eventName, handler, event_scope, deviceID,
+                handler_data, &filter, nullptr);
+        filtered = (d->flags & ~SPARK_SUBSCRIBE_FLAG_BINARY);
+    } else {
+        success = spark_protocol_add_event_handler(sp, eventName, handler, event_scope, deviceID, handler_data);
+    }
     if (success && spark_cloud_flag_connected())
     {
-        register_event(eventName, event_scope, deviceID);
+        if (filtered) {
+            // The subscription messages sent by the protocol include the matching criteria
+            spark_protocol_send_subscriptions(sp, nullptr);
+        } else {
+            register_event(eventName, event_scope, deviceID);
+        }
     }
     return success;
 }
@@ -166,15 +189,62 @@ bool spark_send_event(const char* name, const char* data, int ttl, uint32_t flag
 
     spark_protocol_send_event_data d = { sizeof(spark_protocol_send_event_data) };
     if (reserved) {
-        // Forward completion callback to the protocol implementation
+        // Forward completion callback and event options to the protocol implementation
         auto r = static_cast<const spark_send_event_data*>(reserved);
         d.handler_callback = r->handler_callback;
         d.handler_data = r->handler_data;
+        if (r->size >= offsetof(spark_send_event_data, content_type) + sizeof(r->content_type)) {
+            d.data_size = r->data_size;
+            d.content_type = r->content_type;
+        }
+        if (r->size >= offsetof(spark_send_event_data, timeout) + sizeof(r->timeout)) {
+            d.priority = r->priority;
+            d.timeout = r->timeout;
+        }
     }
 
     return spark_protocol_send_event(sp, name, data, ttl, convert(flags), &d);
 }
 
+bool spark_send_events(const EventBatchEntry* events, size_t count, int ttl, uint32_t flags, void* reserved)
+{
+    SYSTEM_THREAD_CONTEXT_SYNC(spark_send_events(events, count, ttl, flags, reserved));
+
+    spark_protocol_send_event_data d = { sizeof(spark_protocol_send_event_data) };
+    if (reserved) {
+        auto r = static_cast<const spark_send_event_data*>(reserved);
+        d.handler_callback = r->handler_callback;
+        d.handler_data = r->handler_data;
+    }
+
+    return spark_protocol_send_events(sp, events, count, ttl, convert(flags & ~PUBLISH_EVENT_FLAG_ASYNC), &d);
+}
+
+int spark_publish_queue_push(const char* name, const char* data, int ttl, uint32_t flags, void* reserved)
+{
+#if HAL_PLATFORM_FILESYSTEM
+    SYSTEM_THREAD_CONTEXT_SYNC(spark_publish_queue_push(name, data, ttl, flags, reserved));
+    return particle::system::PublishQueue::instance()->push(name, data, ttl, flags);
+#else
+    return SYSTEM_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+int spark_publish_queue_flush(void* reserved)
+{
+#if HAL_PLATFORM_FILESYSTEM
+    SYSTEM_THREAD_CONTEXT_SYNC(spark_publish_queue_flush(reserved));
+    return particle::system::PublishQueue::instance()->flush();
+#else
+    return SYSTEM_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+int spark_publish_from_isr(const char* name, const char* data, int ttl, uint32_t flags, void* reserved)
+{
+    return particle::system::IsrPublishQueue::instance()->push(name, data, ttl, flags);
+}
+
 bool spark_variable(const char *varKey, const void *userVar, Spark_Data_TypeDef userVarType, spark_variable_t* extra)
 {
     SYSTEM_THREAD_CONTEXT_SYNC(spark_variable(varKey, userVar, userVarType, extra));
@@ -187,6 +257,31 @@ bool spark_variable(const char *varKey, const void *userVar, Spark_Data_TypeDef
     return item!=NULL;
 }
 
+int spark_function_complete(void* completion, int result, void* reserved)
+{
+    if (!completion) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    complete_user_function(completion, result);
+    return 0;
+}
+
+int spark_variable_observe(const char* varKey, system_tick_t interval, double threshold, void* reserved)
+{
+    SYSTEM_THREAD_CONTEXT_SYNC(spark_variable_observe(varKey, interval, threshold, reserved));
+
+    if (!varKey || threshold < 0) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    User_Var_Lookup_Table_t* item = find_var_by_key(varKey);
+    if (!item) {
+        return SYSTEM_ERROR_NOT_FOUND;
+    }
+    item->observeInterval = interval;
+    item->observeThreshold = threshold;
+    return 0;
+}
+
 /**
  * This is the original released signature for firmware version 0 and needs to remain like this.
  * (The original returned void - we can safely change to bool.)
@@ -244,6 +339,19 @@ String spark_deviceID(void)
 int spark_set_connection_property(unsigned property_id, unsigned data, particle::protocol::connection_properties_t* conn_prop, void* reserved)
 {
     SYSTEM_THREAD_CONTEXT_SYNC(spark_set_connection_property(property_id, data, conn_prop, reserved));
+#if HAL_PLATFORM_CLOUD_UDP
+    if (property_id == particle::protocol::Connection::ADAPTIVE_PING)
+    {
+        // The system substitutes the lifetime learned for the current network
+        return particle::system::AdaptiveKeepAlive::instance()->enable(data != particle::protocol::ADAPTIVE_PING_DISABLED);
+    }
+    if (property_id == particle::protocol::Connection::PING && conn_prop &&
+            conn_prop->keepalive_source == particle::protocol::KeepAliveSource::USER)
+    {
+        // The protocol layer disables the adaptive mode as well
+        particle::system::AdaptiveKeepAlive::instance()->enable(false);
+    }
+#endif // HAL_PLATFORM_CLOUD_UDP
     return spark_protocol_set_connection_property(sp, property_id, data, conn_prop, reserved);
 }
 
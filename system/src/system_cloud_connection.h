@@ -38,6 +38,7 @@ int system_cloud_disconnect(int flags);
 int system_cloud_send(const uint8_t* buf, size_t buflen, int flags);
 int system_cloud_recv(uint8_t* buf, size_t buflen, int flags);
 int system_cloud_is_connected(void* reserved);
+int system_cloud_connection_established(void* reserved);
 int system_internet_test(void* reserved);
 int system_multicast_announce_presence(void* reserved);
 int system_cloud_set_inet_family_keepalive(int af, unsigned int value, int flags);
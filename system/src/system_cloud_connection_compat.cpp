@@ -327,6 +327,11 @@ int system_multicast_announce_presence(void* reserved)
     return 0;
 }
 
+int system_cloud_connection_established(void* reserved)
+{
+    return 0;
+}
+
 int system_cloud_is_connected(void* reserved)
 {
     bool closed = socket_active_status(s_state.socket) == SOCKET_STATUS_INACTIVE;
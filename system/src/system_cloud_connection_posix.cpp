@@ -41,12 +41,37 @@ struct SystemCloudState {
     int socket = -1;
     struct addrinfo* addr = nullptr;
     struct addrinfo* next = nullptr;
+    /* Address family of the current connection attempt */
+    int family = AF_UNSPEC;
+    /* Address family of the last connection that was established successfully */
+    int establishedFamily = AF_UNSPEC;
 };
 
 SystemCloudState s_state;
 
 const unsigned CLOUD_SOCKET_HALF_CLOSED_WAIT_TIMEOUT = 5000;
 
+/* Moves the addresses of the given family to the front of the list, keeping their relative order */
+struct addrinfo* prefer_address_family(struct addrinfo* info, int family)
+{
+    struct addrinfo* preferred = nullptr;
+    struct addrinfo** preferredTail = &preferred;
+    struct addrinfo* other = nullptr;
+    struct addrinfo** otherTail = &other;
+    for (struct addrinfo* a = info; a != nullptr; a = a->ai_next) {
+        if (a->ai_family == family) {
+            *preferredTail = a;
+            preferredTail = &a->ai_next;
+        } else {
+            *otherTail = a;
+            otherTail = &a->ai_next;
+        }
+    }
+    *otherTail = nullptr;
+    *preferredTail = other;
+    return preferred;
+}
+
 } /* anonymous */
 
 int system_cloud_connect(int protocol, const ServerAddress* address, sockaddr* saddrCache)
@@ -128,6 +153,12 @@ int system_cloud_connect(int protocol, const ServerAddress* address, sockaddr* s
         }
     }
 
+    if (type == CLOUD_SERVER_ADDRESS_TYPE_NEW_ADDRINFO && info && s_state.establishedFamily != AF_UNSPEC) {
+        /* Try the address family that worked last time first: an attempt over a family that has
+         * no end-to-end connectivity only fails after the handshake times out */
+        info = prefer_address_family(info, s_state.establishedFamily);
+    }
+
     int r = SYSTEM_ERROR_NETWORK;
 
     if (info == nullptr) {
@@ -233,6 +264,7 @@ int system_cloud_connect(int protocol, const ServerAddress* address, sockaddr* s
         }
 
         s_state.socket = s;
+        s_state.family = a->ai_family;
         if (saddrCache) {
             memcpy(saddrCache, a->ai_addr, a->ai_addrlen);
         }
@@ -311,6 +343,12 @@ int system_cloud_recv(uint8_t* buf, size_t buflen, int flags)
     return recvd;
 }
 
+int system_cloud_connection_established(void* reserved)
+{
+    s_state.establishedFamily = s_state.family;
+    return 0;
+}
+
 int system_internet_test(void* reserved)
 {
     return SYSTEM_ERROR_NOT_SUPPORTED;
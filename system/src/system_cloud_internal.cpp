@@ -48,11 +48,13 @@
 #include "system_event.h"
 #include "system_cloud_connection.h"
 #include "system_network_internal.h"
+#include "system_time_sources.h"
 #include "str_util.h"
 #include "scope_guard.h"
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stddef.h>
 
 using particle::CloudDiagnostics;
 using particle::publishEvent;
@@ -95,6 +97,13 @@ ProtocolFacade* system_cloud_protocol_instance(void)
 static append_list<User_Var_Lookup_Table_t> vars(5);
 static append_list<User_Func_Lookup_Table_t> funcs(5);
 
+// Checksums of the registered variables and functions, updated as they are registered
+static uint32_t vars_checksum = 0;
+static uint32_t funcs_checksum = 0;
+
+static uint32_t var_checksum(const User_Var_Lookup_Table_t& var);
+static uint32_t func_checksum(const User_Func_Lookup_Table_t& func);
+
 User_Var_Lookup_Table_t* find_var_by_key(const char* varKey)
 {
     for (int i = vars.size(); i-->0; )
@@ -146,9 +155,17 @@ User_Var_Lookup_Table_t* find_var_by_key_or_add(const char* varKey, const void*
 
     if (!result) {
     	result = add_if_sufficient_describe(vars, varKey, "variable", item);
+    	if (result) {
+    		vars_checksum += var_checksum(*result);
+    	}
     }
     else {
+    	// Re-registering a variable keeps it observable
+    	item.observeInterval = result->observeInterval;
+    	item.observeThreshold = result->observeThreshold;
+    	vars_checksum -= var_checksum(*result);
     	*result = item;
+    	vars_checksum += var_checksum(*result);
     }
     return result;
 }
@@ -170,14 +187,20 @@ User_Func_Lookup_Table_t* find_func_by_key_or_add(const char* funcKey, const clo
 	User_Func_Lookup_Table_t item = {0};
 	item.pUserFunc = desc->fn;
 	item.pUserFuncData = desc->data;
+	item.flags = desc->flags;
     memcpy(item.userFuncKey, desc->funcKey, USER_FUNC_KEY_LENGTH);
 
     User_Func_Lookup_Table_t* result = find_func_by_key(funcKey);
     if (result) {
+    	funcs_checksum -= func_checksum(*result);
     	*result = item;
+    	funcs_checksum += func_checksum(*result);
     }
     else {
     	result = add_if_sufficient_describe(funcs, funcKey, "function", item);
+    	if (result) {
+    		funcs_checksum += func_checksum(*result);
+    	}
     }
     return result;
 }
@@ -206,32 +229,39 @@ uint32_t string_crc(const char* s)
 }
 
 /**
- * Computes the checksum of the registered functions.
+ * Computes the checksum of a function.
  * The function name is used to compute the checksum.
  */
-uint32_t compute_functions_checksum()
+static uint32_t func_checksum(const User_Func_Lookup_Table_t& func)
 {
-	uint32_t checksum = 0;
-	for (int i = funcs.size(); i-->0; )
-    {
-		checksum += string_crc(funcs[i].userFuncKey);
-    }
-	return checksum;
+	return string_crc(func.userFuncKey);
 }
 
 /**
- * Computes the checksum of the registered variables.
+ * Computes the checksum of a variable.
  * The checksum is derived from the variable name and type.
  */
+static uint32_t var_checksum(const User_Var_Lookup_Table_t& var)
+{
+	return string_crc(var.userVarKey) + crc(var.userVarType);
+}
+
+/**
+ * Returns the checksum of the registered functions.
+ * This is the sum of the checksums of the individual functions, so it doesn't depend on the order
+ * of registration and is maintained as the functions are registered.
+ */
+uint32_t compute_functions_checksum()
+{
+	return funcs_checksum;
+}
+
+/**
+ * Returns the checksum of the registered variables.
+ */
 uint32_t compute_variables_checksum()
 {
-	uint32_t checksum = 0;
-	for (int i = vars.size(); i-->0; )
-	{
-		checksum += string_crc(vars[i].userVarKey);
-		checksum += crc(vars[i].userVarType);
-	}
-	return checksum;
+	return vars_checksum;
 }
 
 /**
@@ -245,18 +275,28 @@ uint32_t compute_describe_app_checksum()
 	return crc(chk, sizeof(chk));
 }
 
+/**
+ * Computes the checksum of the system modules. The modules can only change across a reset, so
+ * the checksum is computed once.
+ */
 uint32_t compute_describe_system_checksum()
 {
+    static uint32_t checksum = 0;
+    static bool checksum_valid = false;
+    if (checksum_valid) {
+        return checksum;
+    }
     hal_system_info_t info;
     memset(&info, 0, sizeof(info));
     info.size = sizeof(info);
     HAL_System_Info(&info, true, NULL);
-	uint32_t checksum = info.platform_id;
+	checksum = info.platform_id;
 	for (int i=0; i<info.module_count; i++)
 	{
 		checksum += crc(info.modules[i].suffix->sha);
 	}
 	HAL_System_Info(&info, false, NULL);
+    checksum_valid = true;
     return checksum;
 }
 
@@ -278,10 +318,20 @@ bool spark_function_internal(const cloud_function_descriptor* desc, void* reserv
 }
 
 
+bool is_binary_handler(uint16_t handlerInfoSize, FilteringEventHandler* handlerInfo) {
+    return handlerInfoSize >= offsetof(FilteringEventHandler, flags) + sizeof(handlerInfo->flags) &&
+            (handlerInfo->flags & EVENT_HANDLER_FLAG_BINARY);
+}
+
 void invokeEventHandlerInternal(uint16_t handlerInfoSize, FilteringEventHandler* handlerInfo,
-                const char* event_name, const char* data, void* reserved)
+                const char* event_name, const char* data, size_t data_size, int content_type)
 {
-    if(handlerInfo->handler_data)
+    if (is_binary_handler(handlerInfoSize, handlerInfo))
+    {
+        BinaryEventHandler handler = (BinaryEventHandler) handlerInfo->handler;
+        handler(handlerInfo->handler_data, event_name, data, data_size, content_type);
+    }
+    else if(handlerInfo->handler_data)
     {
         EventHandlerWithData handler = (EventHandlerWithData) handlerInfo->handler;
         handler(handlerInfo->handler_data, event_name, data);
@@ -293,9 +343,9 @@ void invokeEventHandlerInternal(uint16_t handlerInfoSize, FilteringEventHandler*
 }
 
 void invokeEventHandlerString(uint16_t handlerInfoSize, FilteringEventHandler* handlerInfo,
-                const String& name, const String& data, void* reserved)
+                const String& name, const String& data, int content_type)
 {
-    invokeEventHandlerInternal(handlerInfoSize, handlerInfo, name.c_str(), data.c_str(), reserved);
+    invokeEventHandlerInternal(handlerInfoSize, handlerInfo, name.c_str(), data.c_str(), data.length(), content_type);
 }
 
 void SystemEvents(const char* name, const char* data);
@@ -308,16 +358,25 @@ bool is_system_handler(uint16_t handlerInfoSize, FilteringEventHandler* handlerI
 void invokeEventHandler(uint16_t handlerInfoSize, FilteringEventHandler* handlerInfo,
                 const char* event_name, const char* event_data, void* reserved)
 {
+    size_t data_size = event_data ? strlen(event_data) : 0;
+    int content_type = ContentType::TEXT;
+    const auto info = static_cast<const ReceivedEventInfo*>(reserved);
+    if (info && info->size >= offsetof(ReceivedEventInfo, content_type) + sizeof(info->content_type))
+    {
+        data_size = info->data_size;
+        content_type = info->content_type;
+    }
     if (is_system_handler(handlerInfoSize, handlerInfo) || system_thread_get_state(NULL)==spark::feature::DISABLED)
     {
-        invokeEventHandlerInternal(handlerInfoSize, handlerInfo, event_name, event_data, reserved);
+        invokeEventHandlerInternal(handlerInfoSize, handlerInfo, event_name, event_data, data_size, content_type);
     }
     else
     {
-        // copy the buffers to dynamically allocated storage.
+        // copy the buffers to dynamically allocated storage. The data is copied by size, since
+        // binary data may contain null characters
         String name(event_name);
-        String data(event_data);
-        APPLICATION_THREAD_CONTEXT_ASYNC(invokeEventHandlerString(handlerInfoSize, handlerInfo, name, data, reserved));
+        String data(event_data ? event_data : "", data_size);
+        APPLICATION_THREAD_CONTEXT_ASYNC(invokeEventHandlerString(handlerInfoSize, handlerInfo, name, data, content_type));
     }
 }
 
@@ -341,6 +400,17 @@ const char* getUserVariableKey(int variable_index)
     return vars[variable_index].userVarKey;
 }
 
+bool getUserVariableObserveOptions(const char* varKey, uint32_t* interval, double* threshold)
+{
+    const auto item = find_var_by_key(varKey);
+    if (!item || !item->observeInterval) {
+        return false;
+    }
+    *interval = item->observeInterval;
+    *threshold = item->observeThreshold;
+    return true;
+}
+
 SparkReturnType::Enum wrapVarTypeInEnum(const char *varKey)
 {
     switch (userVarType(varKey))
@@ -521,6 +591,10 @@ uint32_t compute_cloud_state_checksum(SparkAppStateSelector::Enum stateSelector,
 
 void system_set_time(time_t time, unsigned param, void*)
 {
+    if (!particle::system::timeSynced(time, param)) {
+        // The time was obtained from the RTC itself
+        return;
+    }
     HAL_RTC_Set_UnixTime(time);
     system_notify_event(time_changed, time_changed_sync);
 }
@@ -637,7 +711,7 @@ size_t variableDataSize(const void* data, Spark_Data_TypeDef type) {
 
 void getUserVarResult(int error, int type, void* data, size_t size, SparkDescriptor::GetVariableCallback callback,
         void* context) {
-    SYSTEM_THREAD_CONTEXT_ASYNC(getUserVarResult(error, type, data, size, callback, context));
+    SYSTEM_THREAD_CONTEXT_ASYNC_HIGH_PRIORITY(getUserVarResult(error, type, data, size, callback, context));
     callback(error, type, data, size, context);
 }
 
@@ -685,13 +759,40 @@ void getUserVar(const char* varKey, SparkDescriptor::GetVariableCallback callbac
     }
 }
 
+// Completion handle of an asynchronous user function call
+struct User_Func_Completion
+{
+    SparkDescriptor::FunctionResultCallback callback;
+};
+
+void complete_user_function(void* completion, int result)
+{
+    // run the cloud return on the system thread
+    SYSTEM_THREAD_CONTEXT_ASYNC_HIGH_PRIORITY(complete_user_function(completion, result));
+    const auto c = static_cast<User_Func_Completion*>(completion);
+    c->callback((const void*)long(result), SparkReturnType::INT);
+    delete c;
+}
+
 void userFuncScheduleImpl(User_Func_Lookup_Table_t* item, const char* paramString, bool freeParamString, SparkDescriptor::FunctionResultCallback callback)
 {
-    int result = item->pUserFunc(item->pUserFuncData, paramString, NULL);
+    int result = SYSTEM_ERROR_NO_MEMORY;
+    if (item->flags & CLOUD_FUNCTION_FLAG_ASYNC) {
+        // the handler returns immediately and completes the call via spark_function_complete()
+        const auto completion = new(std::nothrow) User_Func_Completion{callback};
+        if (completion) {
+            item->pUserFunc(item->pUserFuncData, paramString, completion);
+            if (freeParamString)
+                delete paramString;
+            return;
+        }
+    } else {
+        result = item->pUserFunc(item->pUserFuncData, paramString, NULL);
+    }
     if (freeParamString)
         delete paramString;
     // run the cloud return on the system thread again
-    SYSTEM_THREAD_CONTEXT_ASYNC(callback((const void*)long(result), SparkReturnType::INT));
+    SYSTEM_THREAD_CONTEXT_ASYNC_HIGH_PRIORITY(callback((const void*)long(result), SparkReturnType::INT));
     callback((const void*)long(result), SparkReturnType::INT);
 }
 
@@ -924,6 +1025,7 @@ void Spark_Protocol_Init(void)
         descriptor.get_variable_key = getUserVariableKey;
         descriptor.variable_type = wrapVarTypeInEnum;
         descriptor.get_variable_async = getUserVar;
+        descriptor.get_variable_observe_options = getUserVariableObserveOptions;
         descriptor.was_ota_upgrade_successful = HAL_OTA_Flashed_GetStatus;
         descriptor.ota_upgrade_status_sent = HAL_OTA_Flashed_ResetStatus;
         descriptor.append_system_info = system_module_info;
@@ -969,6 +1071,7 @@ void Spark_Protocol_Init(void)
         uint8_t id[id_length];
         HAL_device_ID(id, id_length);
         spark_protocol_init(sp, (const char*) id, keys, callbacks, descriptor);
+        particle::system::registerTimeSources(sp);
 
         Particle.subscribe("spark", SystemEvents, MY_DEVICES);
         Particle.subscribe("particle", SystemEvents, MY_DEVICES);
@@ -1012,6 +1115,8 @@ int Spark_Handshake(bool presence_announce)
 {
     cloud_socket_aborted = false; // Clear cancellation flag for socket operations
     LOG(INFO,"Starting handshake: presense_announce=%d", presence_announce);
+    // Get the time from the network before the session is established, if possible
+    const bool localTimeSynced = (spark_protocol_sync_time_local(sp, nullptr) == 0);
     int err = spark_protocol_handshake(sp);
     if (!err)
     {
@@ -1067,7 +1172,9 @@ int Spark_Handshake(bool presence_announce)
         LOG(INFO,"Send subscriptions");
         spark_protocol_send_subscriptions(sp);
         // important this comes at the end since it requires a response from the cloud.
-        spark_protocol_send_time_request(sp);
+        if (!localTimeSynced) {
+            spark_protocol_send_time_request(sp);
+        }
         Spark_Process_Events();
     }
     if (err==particle::protocol::SESSION_RESUMED)
@@ -1078,7 +1185,7 @@ int Spark_Handshake(bool presence_announce)
         publishSafeModeEventIfNeeded();
         Send_Firmware_Update_Flags();
 
-        if (!HAL_RTC_Time_Is_Valid(nullptr) && spark_sync_time_last(nullptr, nullptr) == 0) {
+        if (!localTimeSynced && !HAL_RTC_Time_Is_Valid(nullptr) && spark_sync_time_last(nullptr, nullptr) == 0) {
             spark_protocol_send_time_request(sp);
             Spark_Process_Events();
         }
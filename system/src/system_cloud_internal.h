@@ -54,6 +54,9 @@ struct User_Var_Lookup_Table_t
 
     const void* (*update)(const char* name, Spark_Data_TypeDef varType, const void* var, void* reserved);
     int (*copy)(const void* var, void** data, size_t* size);
+
+    system_tick_t observeInterval; // 0 if the variable is not observable
+    double observeThreshold;
 };
 
 
@@ -62,11 +65,14 @@ struct User_Func_Lookup_Table_t
     void* pUserFuncData;
     cloud_function_t pUserFunc;
     char userFuncKey[USER_FUNC_KEY_LENGTH+1];
+    uint16_t flags;
 };
 
 
+User_Var_Lookup_Table_t* find_var_by_key(const char* varKey);
 User_Var_Lookup_Table_t* find_var_by_key_or_add(const char* varKey, const void* userVarData, Spark_Data_TypeDef userVarType, spark_variable_t* extra);
 User_Func_Lookup_Table_t* find_func_by_key_or_add(const char* funcKey, const cloud_function_descriptor* desc);
+void complete_user_function(void* completion, int result);
 
 extern ProtocolFacade* sp;
 
@@ -127,7 +133,7 @@ private:
     // the networking service thread
     AtomicEnumDiagnosticData<Status> status_;
     AtomicEnumDiagnosticData<cloud_disconnect_reason> disconnReason_;
-    SimpleIntegerDiagnosticData disconnCount_;
+    CounterDiagnosticData disconnCount_;
     SimpleIntegerDiagnosticData connCount_;
     SimpleIntegerDiagnosticData lastError_;
 };
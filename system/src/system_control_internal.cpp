@@ -28,6 +28,10 @@
 #include "debug.h"
 #include "delay_hal.h"
 #include "hal_platform.h"
+#include "system_thread_stats.h"
+#include "trace.h"
+#include "boot_timeline.h"
+#include "spark_wiring_json.h"
 
 #include "control/network.h"
 #include "control/wifi.h"
@@ -76,6 +80,106 @@ int formatReplyData(ctrl_request* req, ReplyFormatterCallback callback, void* da
     }
 }
 
+class AppenderJSONWriter: public spark::JSONWriter {
+public:
+    explicit AppenderJSONWriter(Appender* appender) :
+            appender_(appender) {
+    }
+
+protected:
+    void write(const char* data, size_t size) override {
+        appender_->append((const uint8_t*)data, size);
+    }
+
+private:
+    Appender* appender_;
+};
+
+#if PLATFORM_THREADING
+
+int formatThreadStats(Appender* appender, void* data) {
+    ThreadStats stats;
+    const int ret = getThreadStats(&stats);
+    if (ret < 0) {
+        return ret;
+    }
+    AppenderJSONWriter json(appender);
+    json.beginObject();
+    json.name("total").value((unsigned)stats.totalTime);
+    json.name("threads").beginArray();
+    for (size_t i = 0; i < stats.count; ++i) {
+        const os_thread_stats_t& t = stats.threads[i];
+        json.beginObject();
+        json.name("name").value(t.name);
+        json.name("prio").value((unsigned)t.priority);
+        json.name("cpu").value((unsigned)t.cpu_time);
+        json.name("stack").value((unsigned)t.stack_free_min);
+        json.endObject();
+    }
+    json.endArray();
+    // Periods during which context switching was disabled, since the previous request
+    os_scheduler_stats_t sched = {};
+    sched.size = sizeof(sched);
+    if (os_scheduler_get_stats(&sched, true /* reset */, nullptr) == 0) {
+        json.name("sched").beginObject();
+        json.name("count").value((unsigned)sched.count);
+        json.name("total").value((unsigned)sched.total_time);
+        json.name("max").value((unsigned)sched.max_time);
+        json.name("caller").value((unsigned)(uintptr_t)sched.max_caller);
+        json.endObject();
+    }
+    json.endObject();
+    return 0;
+}
+
+#endif // PLATFORM_THREADING
+
+void writeBootTimeline(spark::JSONWriter& json, const boot_timeline& t) {
+    json.beginObject();
+    for (int i = 0; i < BOOT_STAGE_COUNT; ++i) {
+        if (t.stages & (1 << i)) {
+            json.name(boot_stage_name(i)).value((unsigned)t.time[i]);
+        }
+    }
+    json.endObject();
+}
+
+// Replies with the timelines of the current and previous boot. Times are in microseconds
+int formatBootTimeline(Appender* appender, void* data) {
+    AppenderJSONWriter json(appender);
+    json.beginObject();
+    boot_timeline t = {};
+    if (boot_timeline_get(&t, 0 /* previous */, nullptr) == 0) {
+        json.name("current");
+        writeBootTimeline(json, t);
+    }
+    if (boot_timeline_get(&t, 1 /* previous */, nullptr) == 0) {
+        json.name("previous");
+        writeBootTimeline(json, t);
+    }
+    json.endObject();
+    return 0;
+}
+
+// Replies with an array of trace_record structures. If bit 0 of the first byte of the request
+// data is set, the trace buffer is cleared after reading it
+int getTraceData(ctrl_request* req) {
+#if PARTICLE_TRACE_ENABLED
+    const int ret = system_ctrl_alloc_reply_data(req, PARTICLE_TRACE_BUFFER_SIZE * sizeof(trace_record), nullptr);
+    if (ret != 0) {
+        return ret;
+    }
+    const size_t count = trace_get_records((trace_record*)req->reply_data, PARTICLE_TRACE_BUFFER_SIZE);
+    req->reply_size = count * sizeof(trace_record);
+    if (req->request_size > 0 && (req->request_data[0] & 0x01)) {
+        trace_clear();
+    }
+    return 0;
+#else
+    return SYSTEM_ERROR_NOT_SUPPORTED;
+#endif
+}
+
 SystemControl g_systemControl;
 
 } // particle::system::
@@ -213,6 +317,22 @@ void SystemControl::processRequest(ctrl_request* req, ControlRequestChannel* /*
         }
         break;
     }
+    case CTRL_REQUEST_GET_THREAD_STATS: {
+#if PLATFORM_THREADING
+        setResult(req, formatReplyData(req, formatThreadStats));
+#else
+        setResult(req, SYSTEM_ERROR_NOT_SUPPORTED);
+#endif
+        break;
+    }
+    case CTRL_REQUEST_GET_TRACE_DATA: {
+        setResult(req, getTraceData(req));
+        break;
+    }
+    case CTRL_REQUEST_GET_BOOT_TIMELINE: {
+        setResult(req, formatReplyData(req, formatBootTimeline));
+        break;
+    }
 #if Wiring_WiFi == 1 && !HAL_PLATFORM_NCP
     /* wifi requests */
     case CTRL_REQUEST_WIFI_GET_ANTENNA: {
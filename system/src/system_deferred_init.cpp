@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "system_deferred_init.h"
+
+#include "system_update.h"
+#include "system_control_internal.h"
+#include "system_error.h"
+#include "hal_platform.h"
+#include "trace.h"
+#include "debug.h"
+
+#if HAL_PLATFORM_BLE
+#include "ble_hal.h"
+#endif
+
+#include <atomic>
+
+namespace particle {
+
+namespace system {
+
+namespace {
+
+std::atomic<bool> g_initialized(false);
+std::atomic<bool> g_setupStarted(false);
+
+} // unnamed
+
+bool isSubsystemInitDeferred() {
+    uint8_t deferred = 0;
+    return system_get_flag(SYSTEM_FLAG_DEFERRED_INIT, &deferred, nullptr) == 0 && deferred;
+}
+
+void initDeferredSubsystems() {
+    if (g_initialized.load(std::memory_order_acquire)) {
+        return;
+    }
+#if HAL_PLATFORM_BLE
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_BEGIN, TRACE_BOOT_STAGE_BLE);
+    SPARK_ASSERT(hal_ble_stack_init(nullptr) == SYSTEM_ERROR_NONE);
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_END, TRACE_BOOT_STAGE_BLE);
+#endif // HAL_PLATFORM_BLE
+#if SYSTEM_CONTROL_ENABLED
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_BEGIN, TRACE_BOOT_STAGE_CONTROL);
+    SystemControl::instance()->init();
+    PARTICLE_TRACE(TRACE_EVENT_BOOT_STAGE_END, TRACE_BOOT_STAGE_CONTROL);
+#endif // SYSTEM_CONTROL_ENABLED
+    g_initialized.store(true, std::memory_order_release);
+}
+
+bool deferredSubsystemsInitialized() {
+    return g_initialized.load(std::memory_order_acquire);
+}
+
+void notifyApplicationSetup() {
+    g_setupStarted.store(true, std::memory_order_release);
+}
+
+void processDeferredInit() {
+    if (!g_initialized.load(std::memory_order_relaxed) && g_setupStarted.load(std::memory_order_acquire)) {
+        initDeferredSubsystems();
+    }
+}
+
+} // particle::system
+
+} // particle
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+namespace particle {
+
+namespace system {
+
+/**
+ * Returns `true` if initialization of the BLE stack and control request channels is deferred
+ * until the application's `setup()` has started (see `SYSTEM_FLAG_DEFERRED_INIT`).
+ */
+bool isSubsystemInitDeferred();
+
+/**
+ * Initializes the subsystems whose initialization can be deferred. Does nothing if they are
+ * already initialized.
+ *
+ * This function must be called from the system thread.
+ */
+void initDeferredSubsystems();
+
+/**
+ * Returns `true` if the subsystems whose initialization can be deferred are initialized.
+ */
+bool deferredSubsystemsInitialized();
+
+/**
+ * Notifies the system that the application's `setup()` is about to be called.
+ */
+void notifyApplicationSetup();
+
+/**
+ * Initializes the deferred subsystems once the application's `setup()` has started. This
+ * function is called periodically from the system loop.
+ */
+void processDeferredInit();
+
+} // particle::system
+
+} // particle
@@ -21,6 +21,9 @@
 #include "system_threading.h"
 #include "interrupts_hal.h"
 #include "system_task.h"
+#include "spark_wiring_interrupts.h"
+#include "system_loop_stats.h"
+#include "system_error.h"
 #include <stdint.h>
 #include <vector>
 
@@ -60,8 +63,33 @@ struct SystemEventSubscription {
 // for now a simple implementation
 std::vector<SystemEventSubscription> subscriptions;
 
-void system_notify_event_impl(system_event_t event, uint32_t data, void* pointer, void (*fn)(void* data), void* fndata) {
+// Events that have at least one subscriber
+system_event_t subscribedEvents = 0;
+
+// Notification about an event that is waiting to be delivered to the application
+struct CoalescedEvent {
+    system_event_t event;
+    uint32_t data;
+    void* pointer;
+    bool pending;
+};
+
+const size_t MAX_COALESCED_EVENTS = 4;
+
+CoalescedEvent coalescedEvents[MAX_COALESCED_EVENTS] = {};
+
+void updateSubscribedEvents() {
+    system_event_t events = 0;
     for (const SystemEventSubscription& subscription : subscriptions) {
+        events |= subscription.events;
+    }
+    subscribedEvents = events;
+}
+
+void system_notify_event_impl(system_event_t event, uint32_t data, void* pointer, void (*fn)(void* data), void* fndata) {
+    // A handler may subscribe or unsubscribe while the notification is being dispatched
+    for (size_t i = 0; i < subscriptions.size(); ++i) {
+        const SystemEventSubscription subscription = subscriptions[i];
         subscription.notify(event, data, pointer);
     }
     if (fn) {
@@ -75,6 +103,55 @@ void system_notify_event_async(system_event_t event, uint32_t data, void* pointe
     system_notify_event_impl(event, data, pointer, fn, fndata);
 }
 
+void system_notify_coalesced_event(size_t index) {
+    CoalescedEvent e = {};
+    ATOMIC_BLOCK() {
+        e = coalescedEvents[index];
+        coalescedEvents[index].pending = false;
+    }
+    system_notify_event_impl(e.event, e.data, e.pointer, nullptr, nullptr);
+}
+
+void system_notify_event_coalesced(system_event_t event, uint32_t data, void* pointer) {
+    int index = -1;
+    ATOMIC_BLOCK() {
+        for (size_t i = 0; i < MAX_COALESCED_EVENTS; ++i) {
+            CoalescedEvent& e = coalescedEvents[i];
+            if (e.pending && e.event == event) {
+                // Replace the parameters of the notification that is already queued
+                e.data = data;
+                e.pointer = pointer;
+                return;
+            }
+            if (!e.pending && index < 0) {
+                index = i;
+            }
+        }
+        if (index >= 0) {
+            coalescedEvents[index] = { event, data, pointer, true };
+        }
+    }
+    if (index < 0) {
+        // Too many events are pending
+        system_notify_event_async(event, data, pointer, nullptr, nullptr);
+        return;
+    }
+#if PLATFORM_THREADING
+    if (ApplicationThread.isStarted() && !ApplicationThread.isCurrentThread()) {
+        auto lambda = [index]() {
+            system_notify_coalesced_event(index);
+        };
+        if (!ApplicationThread.invoke_async(FFL(lambda))) {
+            ATOMIC_BLOCK() {
+                coalescedEvents[index].pending = false;
+            }
+        }
+        return;
+    }
+#endif // PLATFORM_THREADING
+    system_notify_coalesced_event(index);
+}
+
 class SystemEventTask : public ISRTaskQueue::Task {
     system_event_t event_;
     uint32_t data_;
@@ -123,6 +200,7 @@ int system_subscribe_event(system_event_t events, system_event_handler_t* handle
 {
     size_t count = subscriptions.size();
     subscriptions.push_back(SystemEventSubscription(events, handler));
+    updateSubscribedEvents();
     return subscriptions.size()==count+1 ? 0 : -1;
 }
 
@@ -133,12 +211,26 @@ int system_subscribe_event(system_event_t events, system_event_handler_t* handle
  */
 void system_unsubscribe_event(system_event_t events, system_event_handler_t* handler, void* reserved)
 {
+    for (auto it = subscriptions.begin(); it != subscriptions.end();) {
+        if (it->matchesHandler(handler)) {
+            it->events &= ~events;
+        }
+        if (!it->events) {
+            it = subscriptions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    updateSubscribedEvents();
 }
 
 void system_notify_event(system_event_t event, uint32_t data, void* pointer, void (*fn)(void* data), void* fndata,
         unsigned flags) {
     // TODO: Add an API that would allow user applications to control which event handlers can be
     // executed synchronously, possibly in the context of an ISR
+    if (!fn && !(event & subscribedEvents)) {
+        return; // Nobody is interested in this event
+    }
     if (flags & NOTIFY_SYNCHRONOUSLY) {
         system_notify_event_impl(event, data, pointer, fn, fndata);
     } else if (HAL_IsISR()) {
@@ -147,6 +239,8 @@ void system_notify_event(system_event_t event, uint32_t data, void* pointer, voi
             auto task = new (space) SystemEventTask(event, data, pointer, fn, fndata);
             SystemISRTaskQueue.enqueue(task);
         };
+    } else if ((flags & NOTIFY_COALESCE) && !fn) {
+        system_notify_event_coalesced(event, data, pointer);
     } else {
         system_notify_event_async(event, data, pointer, fn, fndata);
     }
@@ -155,3 +249,8 @@ void system_notify_event(system_event_t event, uint32_t data, void* pointer, voi
 void system_notify_time_changed(uint32_t data, void* reserved, void* reserved1) {
     system_notify_event(time_changed, data);
 }
+
+int system_set_loop_overrun_threshold(uint32_t millis, void* reserved) {
+    particle::system::LoopStats::instance()->overrunThreshold(millis);
+    return SYSTEM_ERROR_NONE;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "system_isr_publish.h"
+
+#include "system_cloud.h"
+#include "system_threading.h"
+#include "system_error.h"
+#include "events.h"
+
+#include <cstring>
+
+namespace particle {
+
+namespace system {
+
+IsrPublishQueue IsrPublishQueue::instance_;
+
+IsrPublishQueue::IsrPublishQueue() :
+        events_(),
+        task_(),
+        taskPending_(false) {
+    task_.func = [](ISRTaskQueue::Task*) {
+        instance_.process();
+    };
+}
+
+int IsrPublishQueue::push(const char* name, const char* data, int ttl, uint32_t flags) {
+    if (!name) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    const size_t nameLen = strnlen(name, sizeof(Event::name));
+    const size_t dataLen = data ? strnlen(data, sizeof(Event::data)) : 0;
+    if (nameLen == 0) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    if (nameLen >= sizeof(Event::name) || dataLen >= sizeof(Event::data)) {
+        return SYSTEM_ERROR_TOO_LARGE;
+    }
+    const auto event = alloc();
+    if (!event) {
+        return SYSTEM_ERROR_LIMIT_EXCEEDED;
+    }
+    memcpy(event->name, name, nameLen + 1);
+    if (dataLen) {
+        memcpy(event->data, data, dataLen);
+    }
+    event->data[dataLen] = '\0';
+    event->ttl = ttl;
+    event->flags = flags & ~PUBLISH_EVENT_FLAG_ASYNC;
+    queue_.push(event);
+    schedule();
+    return 0;
+}
+
+IsrPublishQueue* IsrPublishQueue::instance() {
+    return &instance_;
+}
+
+IsrPublishQueue::Event* IsrPublishQueue::alloc() {
+    for (auto& event: events_) {
+        if (!event.used.load(std::memory_order_relaxed) && !event.used.exchange(true, std::memory_order_acquire)) {
+            return &event;
+        }
+    }
+    return nullptr;
+}
+
+void IsrPublishQueue::free(Event* event) {
+    event->used.store(false, std::memory_order_release);
+}
+
+void IsrPublishQueue::schedule() {
+    // The task object can only be in the system queue once
+    if (!taskPending_.exchange(true)) {
+        SystemISRTaskQueue.enqueue(&task_);
+    }
+}
+
+void IsrPublishQueue::process() {
+    taskPending_ = false;
+    Event* batch[MAX_BATCH_SIZE] = {};
+    size_t count = 0;
+    while (const auto event = queue_.pop()) {
+        if (count > 0 && (count == MAX_BATCH_SIZE || event->ttl != batch[0]->ttl || event->flags != batch[0]->flags)) {
+            publish(batch, count);
+            count = 0;
+        }
+        batch[count++] = event;
+    }
+    if (count > 0) {
+        publish(batch, count);
+    }
+    if (!queue_.isEmpty()) {
+        // A producer has been preempted while adding an event, try again in the next iteration
+        // of the system loop
+        schedule();
+    }
+}
+
+void IsrPublishQueue::publish(Event** events, size_t count) {
+    if (count == 1) {
+        const auto e = events[0];
+        spark_send_event(e->name, e->data[0] ? e->data : nullptr, e->ttl, e->flags, nullptr);
+    } else {
+        EventBatchEntry entries[MAX_BATCH_SIZE];
+        for (size_t i = 0; i < count; ++i) {
+            entries[i].name = events[i]->name;
+            entries[i].data = events[i]->data[0] ? events[i]->data : nullptr;
+        }
+        spark_send_events(entries, count, events[0]->ttl, events[0]->flags, nullptr);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        free(events[i]);
+    }
+}
+
+} // namespace system
+
+} // namespace particle
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "active_object.h"
+#include "mpsc_queue.h"
+#include "protocol_defs.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Number of events that can wait to be published at the same time
+#ifndef SYSTEM_ISR_PUBLISH_QUEUE_SIZE
+#define SYSTEM_ISR_PUBLISH_QUEUE_SIZE 4
+#endif
+
+// Maximum size of the event data
+#ifndef SYSTEM_ISR_PUBLISH_MAX_DATA_SIZE
+#define SYSTEM_ISR_PUBLISH_MAX_DATA_SIZE 64
+#endif
+
+namespace particle {
+
+namespace system {
+
+/**
+ * Queue of events published from interrupt handlers.
+ *
+ * Events are stored in a static pool of fixed-size records, so adding an event doesn't allocate
+ * memory. A record is claimed with an atomic exchange and added to a lock-free queue, which is
+ * drained by a task run in the system thread via `SystemISRTaskQueue`.
+ */
+class IsrPublishQueue {
+public:
+    /**
+     * Adds an event to the queue. Can be called from any thread or ISR.
+     */
+    int push(const char* name, const char* data, int ttl, uint32_t flags);
+
+    static IsrPublishQueue* instance();
+
+private:
+    struct Event: MpscQueueNode {
+        char name[protocol::MAX_EVENT_NAME_LENGTH + 1];
+        char data[SYSTEM_ISR_PUBLISH_MAX_DATA_SIZE + 1];
+        int ttl;
+        uint32_t flags;
+        std::atomic<bool> used;
+    };
+
+    // Maximum number of events sent in a single message
+    static const size_t MAX_BATCH_SIZE = 4;
+
+    Event events_[SYSTEM_ISR_PUBLISH_QUEUE_SIZE];
+    MpscQueue<Event> queue_;
+    ISRTaskQueue::Task task_;
+    std::atomic<bool> taskPending_;
+
+    // Constructed statically, as the instance can't be safely initialized on first use in an ISR
+    static IsrPublishQueue instance_;
+
+    IsrPublishQueue();
+
+    Event* alloc();
+    void schedule();
+    void process();
+    void publish(Event** events, size_t count);
+
+    static void free(Event* event);
+};
+
+} // namespace system
+
+} // namespace particle
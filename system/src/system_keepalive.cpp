@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "logging.h"
+LOG_SOURCE_CATEGORY("system.keepalive")
+
+#include "system_keepalive.h"
+
+#if HAL_PLATFORM_CLOUD_UDP
+
+#include "system_cloud_internal.h"
+#include "spark_protocol_functions.h"
+#include "protocol_defs.h"
+#include "timer_hal.h"
+#include "system_error.h"
+
+#if HAL_PLATFORM_CELLULAR
+#include "cellular_hal.h"
+#elif HAL_PLATFORM_WIFI
+#include "wlan_hal.h"
+#endif
+
+#if HAL_PLATFORM_FILESYSTEM
+#include "file_util.h"
+#include "filesystem.h"
+#endif
+
+#include <cstring>
+
+namespace particle {
+
+namespace system {
+
+namespace {
+
+#if HAL_PLATFORM_FILESYSTEM
+const char* const RECORDS_FILE = "/sys/keepalive.bin";
+#endif
+
+// Interval at which the learned lifetime is fetched from the protocol layer
+const system_tick_t UPDATE_INTERVAL = 60000;
+
+uint32_t fnv1a(uint32_t h, const void* data, size_t size) {
+    const auto p = (const uint8_t*)data;
+    for (size_t i = 0; i < size; ++i) {
+        h = (h ^ p[i]) * 16777619;
+    }
+    return h;
+}
+
+// Returns a hash of the identity of the current network, or 0 if it's not known
+uint32_t currentNetwork() {
+    uint32_t h = 2166136261;
+#if HAL_PLATFORM_CELLULAR
+    CellularGlobalIdentity cgi = {};
+    cgi.size = sizeof(cgi);
+    cgi.version = CGI_VERSION_LATEST;
+    if (cellular_global_identity(&cgi, nullptr) != SYSTEM_ERROR_NONE) {
+        return 0;
+    }
+    h = fnv1a(h, "C", 1);
+    h = fnv1a(h, &cgi.mobile_country_code, sizeof(cgi.mobile_country_code));
+    h = fnv1a(h, &cgi.mobile_network_code, sizeof(cgi.mobile_network_code));
+#elif HAL_PLATFORM_WIFI
+    WLanConfig conf = {};
+    conf.size = sizeof(conf);
+    if (wlan_fetch_ipconfig(&conf) != 0 || !conf.uaSSID[0]) {
+        return 0;
+    }
+    h = fnv1a(h, "W", 1);
+    h = fnv1a(h, conf.uaSSID, strnlen((const char*)conf.uaSSID, sizeof(conf.uaSSID)));
+#endif
+    return h ? h : 1;
+}
+
+#if HAL_PLATFORM_FILESYSTEM
+
+inline lfs_t* lfs() {
+    return &filesystem_get_instance(nullptr)->instance;
+}
+
+#endif // HAL_PLATFORM_FILESYSTEM
+
+} // unnamed
+
+AdaptiveKeepAlive::AdaptiveKeepAlive() :
+        records_(),
+        count_(0),
+        network_(0),
+        updateTime_(0),
+        enabled_(false),
+        active_(false),
+        loaded_(false) {
+}
+
+int AdaptiveKeepAlive::enable(bool enabled) {
+    if (enabled_ == enabled) {
+        return 0;
+    }
+    enabled_ = enabled;
+    if (!enabled) {
+        update();
+        active_ = false;
+        protocol::connection_properties_t conn_prop = {};
+        conn_prop.size = sizeof(conn_prop);
+        return spark_protocol_set_connection_property(sp, protocol::Connection::ADAPTIVE_PING,
+                protocol::ADAPTIVE_PING_DISABLED, &conn_prop, nullptr);
+    }
+    if (spark_cloud_flag_connected()) {
+        apply();
+    }
+    return 0;
+}
+
+void AdaptiveKeepAlive::connected() {
+    if (enabled_) {
+        apply();
+    }
+}
+
+void AdaptiveKeepAlive::disconnecting() {
+    if (active_) {
+        // Catch the result of the ping that has caused the disconnection, if any
+        update();
+    }
+}
+
+void AdaptiveKeepAlive::process() {
+    if (active_ && HAL_Timer_Get_Milli_Seconds() - updateTime_ >= UPDATE_INTERVAL) {
+        update();
+    }
+}
+
+void AdaptiveKeepAlive::apply() {
+    load();
+    network_ = currentNetwork();
+    uint32_t bounds = 0;
+    const auto r = find(network_);
+    if (r) {
+        bounds = r->bounds;
+    }
+    protocol::connection_properties_t conn_prop = {};
+    conn_prop.size = sizeof(conn_prop);
+    const int ret = spark_protocol_set_connection_property(sp, protocol::Connection::ADAPTIVE_PING,
+            bounds, &conn_prop, nullptr);
+    if (ret != 0) {
+        LOG(ERROR, "Unable to enable adaptive keepalive: %d", ret);
+        return;
+    }
+    LOG(TRACE, "Adaptive keepalive enabled, network: %08x, bounds: %u..%u s", (unsigned)network_,
+            (unsigned)(bounds & 0xffff), (unsigned)(bounds >> 16));
+    active_ = true;
+    updateTime_ = HAL_Timer_Get_Milli_Seconds();
+}
+
+void AdaptiveKeepAlive::update() {
+    updateTime_ = HAL_Timer_Get_Milli_Seconds();
+    if (!network_) {
+        return; // Don't remember anything about an unknown network
+    }
+    protocol_status status = {};
+    status.size = sizeof(status);
+    if (spark_protocol_get_status(sp, &status, nullptr) != 0 || !status.keepalive_bounds) {
+        return;
+    }
+    auto r = find(network_);
+    if (r && r == records_ && r->bounds == status.keepalive_bounds) {
+        return;
+    }
+    if (r) {
+        // Move the record to the front
+        const size_t n = r - records_;
+        memmove(records_ + 1, records_, n * sizeof(Record));
+    } else {
+        // Evict the least recently used record if necessary
+        if (count_ < MAX_RECORDS) {
+            ++count_;
+        }
+        memmove(records_ + 1, records_, (count_ - 1) * sizeof(Record));
+    }
+    records_[0].network = network_;
+    records_[0].bounds = status.keepalive_bounds;
+    LOG(TRACE, "NAT binding lifetime: %u..%u s", (unsigned)(status.keepalive_bounds & 0xffff),
+            (unsigned)(status.keepalive_bounds >> 16));
+    save();
+}
+
+AdaptiveKeepAlive::Record* AdaptiveKeepAlive::find(uint32_t network) {
+    if (!network) {
+        return nullptr;
+    }
+    for (unsigned i = 0; i < count_; ++i) {
+        if (records_[i].network == network) {
+            return &records_[i];
+        }
+    }
+    return nullptr;
+}
+
+void AdaptiveKeepAlive::load() {
+    if (loaded_) {
+        return;
+    }
+    loaded_ = true;
+#if HAL_PLATFORM_FILESYSTEM
+    const auto fs = filesystem_get_instance(nullptr);
+    if (!fs) {
+        return;
+    }
+    const fs::FsLock lock(fs);
+    if (filesystem_mount(fs) != 0) {
+        return;
+    }
+    lfs_file_t file = {};
+    if (lfs_file_open(lfs(), &file, RECORDS_FILE, LFS_O_RDONLY) != LFS_ERR_OK) {
+        return;
+    }
+    const lfs_ssize_t n = lfs_file_read(lfs(), &file, records_, sizeof(records_));
+    lfs_file_close(lfs(), &file);
+    count_ = (n > 0) ? n / sizeof(Record) : 0;
+#endif // HAL_PLATFORM_FILESYSTEM
+}
+
+void AdaptiveKeepAlive::save() {
+#if HAL_PLATFORM_FILESYSTEM
+    const auto fs = filesystem_get_instance(nullptr);
+    if (!fs) {
+        return;
+    }
+    const fs::FsLock lock(fs);
+    if (filesystem_mount(fs) != 0) {
+        return;
+    }
+    lfs_file_t file = {};
+    if (openFile(&file, RECORDS_FILE, LFS_O_WRONLY | LFS_O_TRUNC) != 0) {
+        LOG(ERROR, "Unable to open %s", RECORDS_FILE);
+        return;
+    }
+    const size_t size = count_ * sizeof(Record);
+    const lfs_ssize_t n = lfs_file_write(lfs(), &file, records_, size);
+    if (lfs_file_close(lfs(), &file) != LFS_ERR_OK || n != (lfs_ssize_t)size) {
+        LOG(ERROR, "Unable to write %s", RECORDS_FILE);
+    }
+#endif // HAL_PLATFORM_FILESYSTEM
+}
+
+AdaptiveKeepAlive* AdaptiveKeepAlive::instance() {
+    static AdaptiveKeepAlive keepAlive;
+    return &keepAlive;
+}
+
+} // namespace system
+
+} // namespace particle
+
+#endif // HAL_PLATFORM_CLOUD_UDP
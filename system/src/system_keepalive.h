@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "hal_platform.h"
+
+#if HAL_PLATFORM_CLOUD_UDP
+
+#include "system_tick_hal.h"
+
+#include <cstdint>
+
+namespace particle {
+
+namespace system {
+
+/**
+ * Keeps track of the NAT binding lifetimes learned by the protocol layer in the adaptive
+ * keepalive mode.
+ *
+ * The lifetimes are stored per network: the MCC/MNC of the cellular operator or the SSID of
+ * the Wi-Fi network. When the device connects to the cloud, the lifetime learned for the
+ * current network is handed back to the protocol layer, so the learning continues where it
+ * left off. On platforms with a filesystem, the lifetimes are persisted in /sys/keepalive.bin.
+ *
+ * All methods must be called in the context of the system thread.
+ */
+class AdaptiveKeepAlive {
+public:
+    /**
+     * Enables or disables the adaptive keepalive mode.
+     */
+    int enable(bool enabled);
+
+    bool isEnabled() const {
+        return enabled_;
+    }
+
+    /**
+     * Invoked when the device has connected to the cloud.
+     */
+    void connected();
+    /**
+     * Invoked before the device disconnects from the cloud.
+     */
+    void disconnecting();
+    /**
+     * Runs the background processing. This method is called periodically by the system loop.
+     */
+    void process();
+
+    static AdaptiveKeepAlive* instance();
+
+private:
+    struct Record {
+        uint32_t network; // Hash of the network identity
+        uint32_t bounds; // See `protocol_status::keepalive_bounds`
+    };
+
+    // Maximum number of networks to remember
+    static const unsigned MAX_RECORDS = 8;
+
+    Record records_[MAX_RECORDS]; // Most recently used network first
+    unsigned count_;
+    uint32_t network_; // Current network
+    system_tick_t updateTime_;
+    bool enabled_;
+    bool active_;
+    bool loaded_;
+
+    AdaptiveKeepAlive();
+
+    void update();
+    void apply();
+    Record* find(uint32_t network);
+    void load();
+    void save();
+};
+
+} // namespace system
+
+} // namespace particle
+
+#endif // HAL_PLATFORM_CLOUD_UDP
@@ -31,6 +31,7 @@ LOG_SOURCE_CATEGORY("system.listen")
 #include "system_network.h"
 #include "delay_hal.h"
 #include "system_control_internal.h"
+#include "system_deferred_init.h"
 #include "check.h"
 #include "system_event.h"
 #include "scope_guard.h"
@@ -78,6 +79,8 @@ int ListeningModeHandler::enter(unsigned int timeout) {
     timestampStarted_ = timestampUpdate_ = HAL_Timer_Get_Milli_Seconds();
 
 #if HAL_PLATFORM_BLE
+    // The BLE stack may not have been initialized yet if the initialization is deferred
+    initDeferredSubsystems();
     bleHandler_.enter();
 #endif /* HAL_PLATFORM_BLE */
 
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "system_loop_stats.h"
+
+#include "system_task.h"
+#include "system_event.h"
+#include "system_threading.h"
+#include "timer_hal.h"
+
+namespace particle {
+
+namespace system {
+
+TimeCounterDiagnosticData::TimeCounterDiagnosticData(DiagnosticDataId id, const char* name) :
+        AbstractIntegerDiagnosticData(id, name),
+        millis_(0),
+        micros_(0) {
+}
+
+void TimeCounterDiagnosticData::add(uint32_t micros) {
+    const auto lock = AtomicConcurrency::lock();
+    micros += micros_;
+    millis_ += micros / 1000;
+    micros_ = micros % 1000;
+    AtomicConcurrency::unlock(lock);
+}
+
+int TimeCounterDiagnosticData::get(IntType& val) {
+    const auto lock = AtomicConcurrency::lock();
+    val = millis_;
+    AtomicConcurrency::unlock(lock);
+    return SYSTEM_ERROR_NONE;
+}
+
+LoopStats LoopStats::instance_;
+
+LoopStats::LoopStats() :
+        loops_(DIAG_ID_SYSTEM_APPLICATION_LOOPS, DIAG_NAME_SYSTEM_APPLICATION_LOOPS),
+        loopTime_(DIAG_ID_SYSTEM_APPLICATION_LOOP_TIME, DIAG_NAME_SYSTEM_APPLICATION_LOOP_TIME),
+        loopMaxTime_(DIAG_ID_SYSTEM_APPLICATION_LOOP_MAX_TIME, DIAG_NAME_SYSTEM_APPLICATION_LOOP_MAX_TIME),
+        userTime_(DIAG_ID_SYSTEM_APPLICATION_USER_TIME, DIAG_NAME_SYSTEM_APPLICATION_USER_TIME),
+        idleTime_(DIAG_ID_SYSTEM_IDLE_EVENTS_TIME, DIAG_NAME_SYSTEM_IDLE_EVENTS_TIME),
+        overruns_(DIAG_ID_SYSTEM_APPLICATION_LOOP_OVERRUNS, DIAG_NAME_SYSTEM_APPLICATION_LOOP_OVERRUNS),
+        overrunThreshold_(0),
+        loopStart_(0),
+        userLoopStart_(0),
+        userLoopIdleStart_(0),
+        appIdleTime_(0),
+        userLoopRan_(false) {
+}
+
+void LoopStats::loopStarted() {
+    loopStart_ = HAL_Timer_Get_Micro_Seconds();
+    userLoopRan_ = false;
+}
+
+void LoopStats::loopFinished() {
+    if (!userLoopRan_) {
+        // The application is not running yet, or is blocked by the system
+        return;
+    }
+    const uint32_t t = HAL_Timer_Get_Micro_Seconds() - loopStart_;
+    ++loops_;
+    loopTime_.add(t);
+    if (t > (uint32_t)loopMaxTime_) {
+        loopMaxTime_ = t;
+    }
+    const uint32_t threshold = overrunThreshold_.load(std::memory_order_relaxed);
+    if (threshold && t / 1000 >= threshold) {
+        ++overruns_;
+        system_notify_event(loop_overrun, t / 1000);
+    }
+}
+
+void LoopStats::userLoopStarted() {
+    userLoopStart_ = HAL_Timer_Get_Micro_Seconds();
+    userLoopIdleStart_ = appIdleTime_;
+}
+
+void LoopStats::userLoopFinished() {
+    const uint32_t t = HAL_Timer_Get_Micro_Seconds() - userLoopStart_;
+    // Background processing run by the user code, e.g. via delay() or Particle.process(), is not
+    // counted as the user's time
+    const uint32_t idle = appIdleTime_ - userLoopIdleStart_;
+    userTime_.add((t > idle) ? t - idle : 0);
+    userLoopRan_ = true;
+}
+
+void LoopStats::idleEventsFinished(uint32_t micros) {
+    idleTime_.add(micros);
+    if (APPLICATION_THREAD_CURRENT()) {
+        appIdleTime_ += micros;
+    }
+}
+
+LoopStats* LoopStats::instance() {
+    return &instance_;
+}
+
+} // namespace system
+
+} // namespace particle
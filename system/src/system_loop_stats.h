@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "spark_wiring_diagnostics.h"
+#include "spark_wiring_interrupts.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace particle {
+
+namespace system {
+
+// Cumulative time in milliseconds, accumulated with microsecond resolution. Can be updated from
+// any thread
+class TimeCounterDiagnosticData: public AbstractIntegerDiagnosticData, private AtomicConcurrency {
+public:
+    TimeCounterDiagnosticData(DiagnosticDataId id, const char* name);
+
+    void add(uint32_t micros);
+
+private:
+    uint32_t millis_;
+    uint32_t micros_; // Remainder that doesn't make up a full millisecond yet
+
+    virtual int get(IntType& val) override; // AbstractIntegerDiagnosticData
+};
+
+/**
+ * Timing statistics of the application loop.
+ *
+ * The duration of every iteration of the application loop is added to a histogram (`app:looptime`,
+ * in microseconds), from which percentiles such as p99 can be estimated, and the longest iteration
+ * is tracked separately (`app:loopmax`). The time spent in the user `loop()` and in the system's
+ * background processing (`Spark_Idle_Events()`) is accumulated separately, so it can be told which
+ * of the two is starving the device. If an iteration takes longer than a configurable threshold,
+ * the `loop_overrun` system event is generated.
+ */
+class LoopStats {
+public:
+    /**
+     * Called by the application loop before an iteration.
+     */
+    void loopStarted();
+
+    /**
+     * Called by the application loop after an iteration.
+     */
+    void loopFinished();
+
+    /**
+     * Called before the user `loop()` is invoked.
+     */
+    void userLoopStarted();
+
+    /**
+     * Called after the user `loop()` returns.
+     */
+    void userLoopFinished();
+
+    /**
+     * Called when an invocation of `Spark_Idle_Events()` completes. Can be called from any thread.
+     *
+     * @param micros Duration of the invocation in microseconds.
+     */
+    void idleEventsFinished(uint32_t micros);
+
+    /**
+     * Sets the iteration time in milliseconds above which the `loop_overrun` event is generated.
+     *
+     * @param millis Threshold, or 0 to disable the event.
+     */
+    void overrunThreshold(uint32_t millis) {
+        overrunThreshold_ = millis;
+    }
+
+    static LoopStats* instance();
+
+private:
+    CounterDiagnosticData loops_;
+    SimpleHistogramDiagnosticData loopTime_;
+    SimpleIntegerDiagnosticData loopMaxTime_;
+    TimeCounterDiagnosticData userTime_;
+    TimeCounterDiagnosticData idleTime_;
+    CounterDiagnosticData overruns_;
+
+    std::atomic<uint32_t> overrunThreshold_;
+    uint32_t loopStart_; // Time when the current iteration started, in microseconds
+    uint32_t userLoopStart_; // Time when the user loop() was invoked
+    uint32_t userLoopIdleStart_; // Value of appIdleTime_ when the user loop() was invoked
+    uint32_t appIdleTime_; // Time spent in Spark_Idle_Events() in the application thread
+    bool userLoopRan_; // The user loop() was invoked during the current iteration
+
+    // Constructed statically, as diagnostic sources need to be registered before the diagnostic
+    // service is started
+    static LoopStats instance_;
+
+    LoopStats();
+};
+
+} // namespace system
+
+} // namespace particle
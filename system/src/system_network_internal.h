@@ -190,7 +190,7 @@ private:
     // the networking service thread
     AtomicEnumDiagnosticData<Status> status_;
     AtomicEnumDiagnosticData<network_disconnect_reason> disconnReason_;
-    AtomicIntegerDiagnosticData disconnCount_;
+    CounterDiagnosticData disconnCount_;
     SimpleIntegerDiagnosticData connCount_;
     SimpleIntegerDiagnosticData lastError_;
 };
@@ -536,7 +536,7 @@ public:
                 ARM_WLAN_WD(CONNECT_TO_ADDRESS_MAX);    // reset the network if it doesn't connect within the timeout
                 const auto diag = NetworkDiagnostics::instance();
                 diag->status(NetworkDiagnostics::CONNECTING);
-                system_notify_event(network_status, network_status_connecting);
+                system_notify_event(network_status, network_status_connecting, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
                 diag->connectionAttempt();
                 const int ret = connect_finalize();
                 if (ret != 0) {
@@ -572,13 +572,13 @@ public:
                 }
                 diag->status(NetworkDiagnostics::DISCONNECTING);
                 // "Disconnecting" event is generated only for a successfully established connection
-                system_notify_event(network_status, network_status_disconnecting);
+                system_notify_event(network_status, network_status_disconnecting, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
             }
             disconnect_now();
             config_clear();
             if (was_connected || was_connecting) {
                 diag->status(NetworkDiagnostics::DISCONNECTED);
-                system_notify_event(network_status, network_status_disconnected);
+                system_notify_event(network_status, network_status_disconnected, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
             }
             LED_SIGNAL_STOP(NETWORK_CONNECTED);
             LED_SIGNAL_STOP(NETWORK_DHCP);
@@ -603,7 +603,7 @@ public:
         {
             const auto diag = NetworkDiagnostics::instance();
             diag->status(NetworkDiagnostics::TURNING_ON);
-            system_notify_event(network_status, network_status_powering_on);
+            system_notify_event(network_status, network_status_powering_on, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
             config_clear();
             const int ret = on_now();
             if (ret != 0) {
@@ -614,7 +614,7 @@ public:
             SPARK_WLAN_SLEEP = 0;
             LED_SIGNAL_START(NETWORK_ON, BACKGROUND);
             diag->status(NetworkDiagnostics::DISCONNECTED);
-            system_notify_event(network_status, network_status_on);
+            system_notify_event(network_status, network_status_on, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
         }
     }
 
@@ -627,7 +627,7 @@ public:
 
             const auto diag = NetworkDiagnostics::instance();
             diag->status(NetworkDiagnostics::TURNING_OFF);
-            system_notify_event(network_status, network_status_powering_off);
+            system_notify_event(network_status, network_status_powering_off, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
             off_now();
 
             SPARK_WLAN_SLEEP = 1;
@@ -641,7 +641,7 @@ public:
             WLAN_SERIAL_CONFIG_DONE = 1;
             LED_SIGNAL_START(NETWORK_OFF, BACKGROUND);
             diag->status(NetworkDiagnostics::TURNED_OFF);
-            system_notify_event(network_status, network_status_off);
+            system_notify_event(network_status, network_status_off, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
         }
     }
 
@@ -679,11 +679,11 @@ public:
                 diag->disconnectionReason(NETWORK_DISCONNECT_REASON_ERROR);
                 diag->disconnectedUnexpectedly();
                 // "Disconnecting" event is generated only for a successfully established connection
-                system_notify_event(network_status, network_status_disconnecting);
+                system_notify_event(network_status, network_status_disconnecting, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
             }
             diag->status(NetworkDiagnostics::DISCONNECTED);
             // "Connecting" event should be always followed by either "connected" or "disconnected" event
-            system_notify_event(network_status, network_status_disconnected);
+            system_notify_event(network_status, network_status_disconnected, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
         }
         // Do not enable WLAN watchdog if WiFi.disconnect() has been called or smart config is active
         if (!WLAN_DISCONNECT && !WLAN_SMART_CONFIG_ACTIVE) {
@@ -721,7 +721,7 @@ public:
             LED_SIGNAL_START(NETWORK_CONNECTED, BACKGROUND);
             LED_SIGNAL_STOP(NETWORK_CONNECTING);
             diag->status(NetworkDiagnostics::CONNECTED);
-            system_notify_event(network_status, network_status_connected);
+            system_notify_event(network_status, network_status_connected, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
         }
         else
         {
@@ -735,7 +735,7 @@ public:
             }
             diag->status(NetworkDiagnostics::DISCONNECTED);
             // "Connecting" event should be always followed by either "connected" or "disconnected" event
-            system_notify_event(network_status, network_status_disconnected);
+            system_notify_event(network_status, network_status_disconnected, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
         }
     }
 
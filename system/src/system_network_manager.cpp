@@ -519,23 +519,23 @@ void NetworkManager::transition(State state) {
         case State::DISABLED: {
             LED_SIGNAL_START(NETWORK_OFF, BACKGROUND);
             // FIXME:
-            system_notify_event(network_status, network_status_powering_off);
-            system_notify_event(network_status, network_status_off);
+            system_notify_event(network_status, network_status_powering_off, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
+            system_notify_event(network_status, network_status_off, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
             break;
         }
         case State::IFACE_DOWN: {
             LED_SIGNAL_START(NETWORK_ON, BACKGROUND);
             if (state_ == State::IFACE_REQUEST_DOWN) {
-                system_notify_event(network_status, network_status_disconnected);
+                system_notify_event(network_status, network_status_disconnected, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
             } else if (state_ == State::DISABLED) {
                 // FIXME:
-                system_notify_event(network_status, network_status_powering_on);
-                system_notify_event(network_status, network_status_on);
+                system_notify_event(network_status, network_status_powering_on, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
+                system_notify_event(network_status, network_status_on, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
             }
             break;
         }
         case State::IFACE_REQUEST_DOWN: {
-            system_notify_event(network_status, network_status_disconnecting);
+            system_notify_event(network_status, network_status_disconnecting, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
             break;
         }
         case State::IFACE_REQUEST_UP: {
@@ -544,7 +544,7 @@ void NetworkManager::transition(State state) {
         }
         case State::IFACE_UP: {
             LED_SIGNAL_START(NETWORK_CONNECTING, BACKGROUND);
-            system_notify_event(network_status, network_status_connecting);
+            system_notify_event(network_status, network_status_connecting, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
             break;
         }
         case State::IFACE_LINK_UP: {
@@ -554,7 +554,7 @@ void NetworkManager::transition(State state) {
         case State::IP_CONFIGURED: {
             LED_SIGNAL_START(NETWORK_CONNECTED, BACKGROUND);
             if (state_ != State::IP_CONFIGURED) {
-                system_notify_event(network_status, network_status_connected);
+                system_notify_event(network_status, network_status_connected, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
             }
             break;
         }
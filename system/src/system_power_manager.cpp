@@ -39,9 +39,15 @@ constexpr system_tick_t DEFAULT_FAULT_WINDOW = 1000;
 constexpr uint32_t DEFAULT_FAULT_COUNT_THRESHOLD = HAL_PLATFORM_PMIC_BQ24195_FAULT_COUNT_THRESHOLD;
 constexpr system_tick_t DEFAULT_FAULT_SUPPRESSION_PERIOD = 60000;
 
-constexpr system_tick_t DEFAULT_QUEUE_WAIT = 1000;
 constexpr system_tick_t DEFAULT_WATCHDOG_TIMEOUT = 60000;
 
+// Minimum interval between PMIC updates when the interrupts keep coming in. The interval doubles
+// with every update until it reaches the maximum, which still allows detecting a faulty battery
+// (see handlePossibleFault()), and it's reset once the updates stop for a while
+constexpr system_tick_t MIN_UPDATE_INTERVAL = 10;
+constexpr system_tick_t MAX_UPDATE_INTERVAL = DEFAULT_FAULT_WINDOW / (DEFAULT_FAULT_COUNT_THRESHOLD * 2);
+constexpr system_tick_t UPDATE_BACKOFF_RESET_PERIOD = 1000;
+
 constexpr hal_power_config defaultPowerConfig = {
   .flags = 0,
   .version = 0,
@@ -318,7 +324,9 @@ void PowerManager::loop(void* arg) {
 
   Event ev;
   while (true) {
-    int r = os_queue_take(self->queue_, &ev, DEFAULT_QUEUE_WAIT, nullptr);
+    // The thread is only woken up by the PMIC interrupts, the USB state changes and the timed
+    // checks that are pending, if any
+    int r = os_queue_take(self->queue_, &ev, self->waitTimeout(), nullptr);
     if (!r) {
       if (ev == Event::ReloadConfig) {
         self->loadConfig();
@@ -327,7 +335,7 @@ void PowerManager::loop(void* arg) {
         self->update_ = true;
       }
     }
-    while (self->update_) {
+    if (self->update_ && self->updateAllowed()) {
       self->handleUpdate();
     }
     self->handlePossibleFaultLoop();
@@ -490,6 +498,43 @@ void PowerManager::handlePossibleFaultLoop() {
   }
 }
 
+bool PowerManager::updateAllowed() {
+  const system_tick_t now = millis();
+  const system_tick_t elapsed = now - lastUpdateTime_;
+  if (elapsed < updateInterval_) {
+    return false;
+  }
+  if (elapsed >= UPDATE_BACKOFF_RESET_PERIOD) {
+    updateInterval_ = 0;
+  } else {
+    updateInterval_ = std::min(std::max(updateInterval_ * 2, MIN_UPDATE_INTERVAL), MAX_UPDATE_INTERVAL);
+  }
+  lastUpdateTime_ = now;
+  return true;
+}
+
+system_tick_t PowerManager::waitTimeout() const {
+  const system_tick_t now = millis();
+  system_tick_t timeout = CONCURRENT_WAIT_FOREVER;
+  const auto wakeUpAt = [now, &timeout](system_tick_t t) {
+    const system_tick_t left = ((int32_t)(t - now) > 0) ? t - now : 0;
+    timeout = std::min(timeout, left);
+  };
+  if (update_) {
+    // Pending update delayed by the backoff
+    wakeUpAt(lastUpdateTime_ + updateInterval_);
+  }
+  if (faultSecondaryCounter_ == 1) {
+    // See handlePossibleFaultLoop()
+    wakeUpAt(possibleFaultTimestamp_ + DEFAULT_FAULT_WINDOW + 1);
+  }
+  if (g_batteryState == BATTERY_STATE_DISCONNECTED) {
+    // See checkWatchdog()
+    wakeUpAt(chargingDisabledTimestamp_ + DEFAULT_WATCHDOG_TIMEOUT);
+  }
+  return timeout;
+}
+
 void PowerManager::checkWatchdog() {
   if (g_batteryState == BATTERY_STATE_DISCONNECTED &&
       ((millis() - chargingDisabledTimestamp_) >= DEFAULT_WATCHDOG_TIMEOUT)) {
@@ -48,6 +48,8 @@ private:
   void handlePossibleFaultLoop();
   void logStat(uint8_t stat, uint8_t fault);
   void checkWatchdog();
+  bool updateAllowed();
+  system_tick_t waitTimeout() const;
 #if HAL_PLATFORM_POWER_MANAGEMENT_OPTIONAL
   bool detect();
 #endif // HAL_PLATFORM_POWER_MANAGEMENT_OPTIONAL
@@ -73,6 +75,8 @@ private:
   system_tick_t possibleFaultTimestamp_ = 0;
   bool lowBatEnabled_ = true;
   system_tick_t chargingDisabledTimestamp_ = 0;
+  system_tick_t lastUpdateTime_ = 0;
+  system_tick_t updateInterval_ = 0;
 #if HAL_PLATFORM_POWER_MANAGEMENT_OPTIONAL
   bool detect_ = false;
 #endif // HAL_PLATFORM_POWER_MANAGEMENT_OPTIONAL
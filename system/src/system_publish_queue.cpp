@@ -0,0 +1,471 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "logging.h"
+LOG_SOURCE_CATEGORY("system.pubq")
+
+#include "system_publish_queue.h"
+
+#if HAL_PLATFORM_FILESYSTEM
+
+#include "system_cloud.h"
+#include "protocol_defs.h"
+#include "file_util.h"
+#include "filesystem.h"
+#include "timer_hal.h"
+#include "check.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <new>
+
+namespace particle {
+
+namespace system {
+
+namespace {
+
+const char* const QUEUE_DIR = "/sys/pubq";
+const char* const READ_POS_FILE = "/sys/pubq/cursor";
+
+// Events are written to the filesystem once this many events have been buffered
+const unsigned COMMIT_EVENT_COUNT = 16;
+// ... or once the oldest buffered event has been waiting for this long
+const system_tick_t COMMIT_INTERVAL = 10000;
+const size_t WRITE_BUFFER_SIZE = 1024;
+
+// A new segment is started once the current one reaches this size
+const size_t SEGMENT_SIZE = 16 * 1024;
+// The oldest segment is discarded when this limit is reached
+const unsigned MAX_SEGMENT_COUNT = 16;
+
+// Maximum size of the events in a batch, including their headers. This is also the maximum size
+// of a single event
+const size_t BATCH_BUFFER_SIZE = 600;
+const unsigned MAX_BATCH_EVENT_COUNT = 16;
+
+// Minimum interval between two batches
+const system_tick_t SEND_INTERVAL = 1000;
+// Interval between retries after a batch couldn't be sent
+const system_tick_t RETRY_INTERVAL = 5000;
+// Maximum time to wait for a batch to be acknowledged
+const system_tick_t SEND_TIMEOUT = 60000;
+
+struct __attribute__((packed)) RecordHeader {
+    uint16_t size; // Size of the record including the header
+    uint8_t flags; // Publish flags
+    uint8_t nameSize; // Length of the event name
+    int32_t ttl; // Time to live
+    // Followed by the null-terminated event name and data
+};
+
+// Parses the records of the next batch. All events of a batch share the TTL and flags
+size_t parseBatch(char* buf, size_t size, EventBatchEntry* events, size_t* batchSize, int* ttl, uint32_t* flags) {
+    size_t offs = 0;
+    size_t count = 0;
+    while (count < MAX_BATCH_EVENT_COUNT && size - offs >= sizeof(RecordHeader)) {
+        RecordHeader h = {};
+        memcpy(&h, buf + offs, sizeof(h));
+        if (h.size > size - offs || h.size < sizeof(RecordHeader) + h.nameSize + 2 ||
+                buf[offs + sizeof(RecordHeader) + h.nameSize] != '\0' || buf[offs + h.size - 1] != '\0') {
+            break; // Incomplete or invalid record
+        }
+        if (count == 0) {
+            *ttl = h.ttl;
+            *flags = h.flags;
+        } else if (h.ttl != *ttl || h.flags != *flags) {
+            break;
+        }
+        events[count].name = buf + offs + sizeof(RecordHeader);
+        events[count].data = events[count].name + h.nameSize + 1;
+        ++count;
+        offs += h.size;
+    }
+    *batchSize = offs;
+    return count;
+}
+
+inline lfs_t* lfs() {
+    return &filesystem_get_instance(nullptr)->instance;
+}
+
+} // unnamed
+
+PublishQueue::PublishQueue() :
+        writeSize_(0),
+        writeCount_(0),
+        writeTime_(0),
+        batchSize_(0),
+        batchCount_(0),
+        batchTime_(0),
+        batchId_(0),
+        batchFromRam_(false),
+        sending_(false),
+        readPos_(),
+        writePos_(),
+        nextSendTime_(0),
+        initResult_(0),
+        inited_(false) {
+}
+
+int PublishQueue::push(const char* name, const char* data, int ttl, uint32_t flags) {
+    CHECK(init());
+    CHECK_TRUE(name, SYSTEM_ERROR_INVALID_ARGUMENT);
+    if (!data) {
+        data = "";
+    }
+    const size_t nameSize = strlen(name);
+    const size_t dataSize = strlen(data);
+    flags &= ~PUBLISH_EVENT_FLAG_ASYNC;
+    CHECK_TRUE(nameSize > 0 && nameSize <= protocol::MAX_EVENT_NAME_LENGTH && dataSize <= protocol::MAX_EVENT_DATA_LENGTH &&
+            flags <= 0xff, SYSTEM_ERROR_INVALID_ARGUMENT);
+    const size_t recSize = sizeof(RecordHeader) + nameSize + dataSize + 2;
+    CHECK_TRUE(recSize <= BATCH_BUFFER_SIZE, SYSTEM_ERROR_TOO_LARGE);
+    if (!writeBuf_) {
+        writeBuf_.reset(new(std::nothrow) char[WRITE_BUFFER_SIZE]);
+        CHECK_TRUE(writeBuf_, SYSTEM_ERROR_NO_MEMORY);
+    }
+    if (writeSize_ + recSize > WRITE_BUFFER_SIZE) {
+        CHECK(commit());
+    }
+    RecordHeader h = {};
+    h.size = recSize;
+    h.flags = flags;
+    h.nameSize = nameSize;
+    h.ttl = ttl;
+    char* p = writeBuf_.get() + writeSize_;
+    memcpy(p, &h, sizeof(h));
+    p += sizeof(h);
+    memcpy(p, name, nameSize + 1);
+    p += nameSize + 1;
+    memcpy(p, data, dataSize + 1);
+    writeSize_ += recSize;
+    if (writeCount_++ == 0) {
+        writeTime_ = HAL_Timer_Get_Milli_Seconds();
+    }
+    if (writeCount_ >= COMMIT_EVENT_COUNT) {
+        // The event is buffered, so the error is not reported to the caller
+        const int r = commit();
+        if (r < 0) {
+            LOG(ERROR, "Unable to store events: %d", r);
+        }
+    }
+    return 0;
+}
+
+int PublishQueue::flush() {
+    CHECK(init());
+    CHECK(commit());
+    return 0;
+}
+
+void PublishQueue::process() {
+    if (init() < 0) {
+        return;
+    }
+    const auto now = HAL_Timer_Get_Milli_Seconds();
+    if (writeCount_ && now - writeTime_ >= COMMIT_INTERVAL) {
+        const int r = commit();
+        if (r < 0) {
+            LOG(ERROR, "Unable to store events: %d", r);
+            writeTime_ = now; // Retry later
+        }
+    }
+    if (sending_) {
+        if (now - batchTime_ < SEND_TIMEOUT) {
+            return;
+        }
+        LOG(WARN, "Batch was not acknowledged");
+        sending_ = false;
+    }
+    if ((!writeSize_ && !hasStoredEvents()) || !spark_cloud_flag_connected() || (int)(now - nextSendTime_) < 0) {
+        return;
+    }
+    const int r = send();
+    if (r < 0) {
+        LOG(ERROR, "Unable to send events: %d", r);
+        nextSendTime_ = now + RETRY_INTERVAL;
+    }
+}
+
+PublishQueue* PublishQueue::instance() {
+    static PublishQueue queue;
+    return &queue;
+}
+
+int PublishQueue::init() {
+    if (inited_) {
+        return initResult_;
+    }
+    inited_ = true;
+    initResult_ = SYSTEM_ERROR_FILE;
+    const auto fs = filesystem_get_instance(nullptr);
+    CHECK_TRUE(fs, SYSTEM_ERROR_FILE);
+    const fs::FsLock lock(fs);
+    CHECK(filesystem_mount(fs));
+    int r = lfs_mkdir(lfs(), QUEUE_DIR);
+    CHECK_TRUE(r == LFS_ERR_OK || r == LFS_ERR_EXIST, SYSTEM_ERROR_FILE);
+    // Find the oldest and newest segments
+    lfs_dir_t dir = {};
+    r = lfs_dir_open(lfs(), &dir, QUEUE_DIR);
+    CHECK_TRUE(r == LFS_ERR_OK, SYSTEM_ERROR_FILE);
+    bool found = false;
+    lfs_info info = {};
+    while (lfs_dir_read(lfs(), &dir, &info) == 1) {
+        if (info.type != LFS_TYPE_REG) {
+            continue;
+        }
+        char* end = nullptr;
+        const uint32_t segment = strtoul(info.name, &end, 16);
+        if (strlen(info.name) != 8 || *end != '\0') {
+            continue; // Not a segment file
+        }
+        if (!found || segment < readPos_.segment) {
+            readPos_.segment = segment;
+        }
+        if (!found || segment > writePos_.segment) {
+            writePos_.segment = segment;
+            writePos_.offset = info.size;
+        }
+        found = true;
+    }
+    lfs_dir_close(lfs(), &dir);
+    if (found) {
+        // Restore the position of the next event to send
+        lfs_file_t file = {};
+        if (lfs_file_open(lfs(), &file, READ_POS_FILE, LFS_O_RDONLY) == LFS_ERR_OK) {
+            Position pos = {};
+            if (lfs_file_read(lfs(), &file, &pos, sizeof(pos)) == sizeof(pos) && pos.segment >= readPos_.segment) {
+                readPos_ = pos;
+            }
+            lfs_file_close(lfs(), &file);
+        }
+        if (readPos_.segment > writePos_.segment || (readPos_.segment == writePos_.segment &&
+                readPos_.offset > writePos_.offset)) {
+            readPos_ = writePos_;
+        }
+        if (writePos_.offset >= SEGMENT_SIZE) {
+            ++writePos_.segment;
+            writePos_.offset = 0;
+        }
+        LOG(INFO, "Stored segments: %u..%u", (unsigned)readPos_.segment, (unsigned)writePos_.segment);
+    }
+    initResult_ = 0;
+    return 0;
+}
+
+int PublishQueue::commit() {
+    if (!writeSize_) {
+        return 0;
+    }
+    const auto fs = filesystem_get_instance(nullptr);
+    CHECK_TRUE(fs, SYSTEM_ERROR_FILE);
+    const fs::FsLock lock(fs);
+    char path[32] = {};
+    formatSegmentPath(path, sizeof(path), writePos_.segment);
+    lfs_file_t file = {};
+    CHECK(openFile(&file, path, LFS_O_WRONLY | LFS_O_APPEND));
+    // Closing the file commits all buffered events at once
+    const lfs_ssize_t n = lfs_file_write(lfs(), &file, writeBuf_.get(), writeSize_);
+    const int r = lfs_file_close(lfs(), &file);
+    if (n != (lfs_ssize_t)writeSize_ || r != LFS_ERR_OK) {
+        // The segment may end with an incomplete record now, so the events are kept in RAM and
+        // will be written to a new segment
+        LOG(ERROR, "Unable to write segment %s", path);
+        if (writePos_.offset > 0) {
+            ++writePos_.segment;
+            writePos_.offset = 0;
+        }
+        return SYSTEM_ERROR_FILE;
+    }
+    LOG_DEBUG(TRACE, "Stored %u events", writeCount_);
+    if (sending_ && batchFromRam_) {
+        // The batch that is being sent is now stored at the read position
+        batchFromRam_ = false;
+    }
+    writePos_.offset += writeSize_;
+    writeSize_ = 0;
+    writeCount_ = 0;
+    if (writePos_.offset >= SEGMENT_SIZE) {
+        ++writePos_.segment;
+        writePos_.offset = 0;
+        if (writePos_.segment - readPos_.segment >= MAX_SEGMENT_COUNT) {
+            CHECK(dropOldestSegment());
+        }
+    }
+    return 0;
+}
+
+int PublishQueue::send() {
+    if (!batchBuf_) {
+        batchBuf_.reset(new(std::nothrow) char[BATCH_BUFFER_SIZE]);
+        CHECK_TRUE(batchBuf_, SYSTEM_ERROR_NO_MEMORY);
+    }
+    size_t size = 0;
+    batchFromRam_ = !hasStoredEvents();
+    if (batchFromRam_) {
+        // Send the buffered events directly, there's no need to store them
+        size = std::min(writeSize_, BATCH_BUFFER_SIZE);
+        memcpy(batchBuf_.get(), writeBuf_.get(), size);
+    } else {
+        size = CHECK(loadBatch());
+    }
+    if (!size) {
+        return 0;
+    }
+    EventBatchEntry events[MAX_BATCH_EVENT_COUNT] = {};
+    int ttl = 0;
+    uint32_t flags = 0;
+    batchCount_ = parseBatch(batchBuf_.get(), size, events, &batchSize_, &ttl, &flags);
+    if (!batchCount_) {
+        // Skip the rest of the segment
+        CHECK_FALSE(batchFromRam_, SYSTEM_ERROR_INTERNAL);
+        LOG(ERROR, "Segment %u is corrupted", (unsigned)readPos_.segment);
+        if (readPos_.segment == writePos_.segment) {
+            ++writePos_.segment;
+            writePos_.offset = 0;
+        }
+        readPos_.offset = SEGMENT_SIZE;
+        CHECK(advance(0));
+        return SYSTEM_ERROR_BAD_DATA;
+    }
+    spark_send_event_data d = { sizeof(spark_send_event_data) };
+    d.handler_callback = sendCompleteCallback;
+    d.handler_data = (void*)(uintptr_t)++batchId_;
+    sending_ = true;
+    batchTime_ = HAL_Timer_Get_Milli_Seconds();
+    if (!spark_send_events(events, batchCount_, ttl, flags, &d)) {
+        // The completion handler may or may not have been invoked at this point
+        sending_ = false;
+        return SYSTEM_ERROR_IO;
+    }
+    return 0;
+}
+
+void PublishQueue::sendComplete(unsigned id, int error) {
+    if (!sending_ || id != batchId_) {
+        return; // Timed out
+    }
+    sending_ = false;
+    const auto now = HAL_Timer_Get_Milli_Seconds();
+    if (error) {
+        LOG(WARN, "Batch was not delivered: %d", error);
+        nextSendTime_ = now + RETRY_INTERVAL;
+        return;
+    }
+    LOG_DEBUG(TRACE, "Sent %u events", batchCount_);
+    if (batchFromRam_) {
+        memmove(writeBuf_.get(), writeBuf_.get() + batchSize_, writeSize_ - batchSize_);
+        writeSize_ -= batchSize_;
+        writeCount_ -= batchCount_;
+    } else {
+        const int r = advance(batchSize_);
+        if (r < 0) {
+            LOG(ERROR, "Unable to update read position: %d", r);
+        }
+    }
+    nextSendTime_ = now + SEND_INTERVAL;
+}
+
+int PublishQueue::loadBatch() {
+    const auto fs = filesystem_get_instance(nullptr);
+    CHECK_TRUE(fs, SYSTEM_ERROR_FILE);
+    const fs::FsLock lock(fs);
+    while (hasStoredEvents()) {
+        char path[32] = {};
+        formatSegmentPath(path, sizeof(path), readPos_.segment);
+        lfs_file_t file = {};
+        lfs_ssize_t n = 0;
+        int r = lfs_file_open(lfs(), &file, path, LFS_O_RDONLY);
+        if (r == LFS_ERR_OK) {
+            r = lfs_file_seek(lfs(), &file, readPos_.offset, LFS_SEEK_SET);
+            if (r >= 0) {
+                n = lfs_file_read(lfs(), &file, batchBuf_.get(), BATCH_BUFFER_SIZE);
+            }
+            lfs_file_close(lfs(), &file);
+            CHECK_TRUE(r >= 0 && n >= 0, SYSTEM_ERROR_FILE);
+        } else {
+            CHECK_TRUE(r == LFS_ERR_NOENT, SYSTEM_ERROR_FILE);
+        }
+        if (n > 0) {
+            return n;
+        }
+        // The segment has been fully sent
+        CHECK_TRUE(readPos_.segment != writePos_.segment, SYSTEM_ERROR_INTERNAL);
+        readPos_.offset = SEGMENT_SIZE;
+        CHECK(advance(0));
+    }
+    return 0;
+}
+
+int PublishQueue::advance(size_t size) {
+    const auto fs = filesystem_get_instance(nullptr);
+    CHECK_TRUE(fs, SYSTEM_ERROR_FILE);
+    const fs::FsLock lock(fs);
+    readPos_.offset += size;
+    // Remove the segments that have been fully sent. The current segment is never removed
+    while (readPos_.segment != writePos_.segment && readPos_.offset >= SEGMENT_SIZE) {
+        char path[32] = {};
+        formatSegmentPath(path, sizeof(path), readPos_.segment);
+        const int r = lfs_remove(lfs(), path);
+        CHECK_TRUE(r == LFS_ERR_OK || r == LFS_ERR_NOENT, SYSTEM_ERROR_FILE);
+        ++readPos_.segment;
+        readPos_.offset = 0;
+    }
+    CHECK(saveReadPos());
+    return 0;
+}
+
+int PublishQueue::dropOldestSegment() {
+    LOG(WARN, "Queue is full, discarding segment %u", (unsigned)readPos_.segment);
+    if (sending_ && !batchFromRam_) {
+        // Events of the batch that is being sent are discarded as well
+        batchSize_ = 0;
+    }
+    readPos_.offset = SEGMENT_SIZE;
+    CHECK(advance(0));
+    return 0;
+}
+
+int PublishQueue::saveReadPos() {
+    lfs_file_t file = {};
+    CHECK(openFile(&file, READ_POS_FILE, LFS_O_WRONLY | LFS_O_TRUNC));
+    const lfs_ssize_t n = lfs_file_write(lfs(), &file, &readPos_, sizeof(readPos_));
+    const int r = lfs_file_close(lfs(), &file);
+    CHECK_TRUE(n == sizeof(readPos_) && r == LFS_ERR_OK, SYSTEM_ERROR_FILE);
+    return 0;
+}
+
+bool PublishQueue::hasStoredEvents() const {
+    return readPos_.segment != writePos_.segment || readPos_.offset < writePos_.offset;
+}
+
+void PublishQueue::formatSegmentPath(char* buf, size_t size, uint32_t segment) {
+    snprintf(buf, size, "%s/%08x", QUEUE_DIR, (unsigned)segment);
+}
+
+void PublishQueue::sendCompleteCallback(int error, const void* data, void* callbackData, void* reserved) {
+    instance()->sendComplete((uintptr_t)callbackData, error);
+}
+
+} // namespace system
+
+} // namespace particle
+
+#endif // HAL_PLATFORM_FILESYSTEM
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "hal_platform.h"
+
+#if HAL_PLATFORM_FILESYSTEM
+
+#include "system_tick_hal.h"
+
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace particle {
+
+namespace system {
+
+/**
+ * Persistent store-and-forward queue of events.
+ *
+ * Events are appended to log-structured segment files in /sys/pubq. New events are collected in
+ * a RAM buffer and written to the current segment in a single append once enough events have
+ * been collected or the oldest buffered event has been waiting for too long (group commit). While
+ * the device is connected to the cloud, stored events are sent in batches via `spark_send_events()`.
+ * The position of the next event to send is persisted separately, so sending an event doesn't
+ * rewrite the segment it's stored in. Segments that have been fully sent are removed.
+ *
+ * All methods must be called in the context of the system thread.
+ */
+class PublishQueue {
+public:
+    /**
+     * Adds an event to the queue.
+     *
+     * @param name Event name.
+     * @param data Event data (can be `nullptr`).
+     * @param ttl Time to live.
+     * @param flags Publish flags (`PUBLISH_EVENT_FLAG_*`).
+     */
+    int push(const char* name, const char* data, int ttl, uint32_t flags);
+    /**
+     * Writes all buffered events to the filesystem.
+     */
+    int flush();
+    /**
+     * Runs the queue. This method is called periodically by the system loop.
+     */
+    void process();
+
+    static PublishQueue* instance();
+
+private:
+    struct Position {
+        uint32_t segment;
+        uint32_t offset;
+    };
+
+    // Buffered events
+    std::unique_ptr<char[]> writeBuf_;
+    size_t writeSize_;
+    unsigned writeCount_;
+    system_tick_t writeTime_;
+
+    // Batch that is being sent
+    std::unique_ptr<char[]> batchBuf_;
+    size_t batchSize_;
+    unsigned batchCount_;
+    system_tick_t batchTime_;
+    unsigned batchId_;
+    bool batchFromRam_;
+    bool sending_;
+
+    Position readPos_; // Next event to send
+    Position writePos_; // End of the current segment
+    system_tick_t nextSendTime_;
+    int initResult_;
+    bool inited_;
+
+    PublishQueue();
+
+    int init();
+    int commit();
+    int send();
+    void sendComplete(unsigned id, int error);
+    int loadBatch();
+    int advance(size_t size);
+    int dropOldestSegment();
+    int saveReadPos();
+    bool hasStoredEvents() const;
+
+    static void formatSegmentPath(char* buf, size_t size, uint32_t segment);
+    static void sendCompleteCallback(int error, const void* data, void* callbackData, void* reserved);
+};
+
+} // namespace system
+
+} // namespace particle
+
+#endif // HAL_PLATFORM_FILESYSTEM
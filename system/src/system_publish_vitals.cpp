@@ -6,6 +6,7 @@
 #include "logging.h"
 #include "system_cloud.h"
 #include "system_threading.h"
+#include "system_update.h"
 
 namespace
 {
@@ -27,9 +28,17 @@ inline int postDescription()
 
     if (spark_cloud_flag_connected())
     {
+        int desc_flags = particle::protocol::DESCRIBE_METRICS;
+        uint8_t delta = 0;
+        if (system_get_flag(SYSTEM_FLAG_PUBLISH_VITALS_DELTA, &delta, nullptr) == 0 && delta)
+        {
+            // The protocol falls back to a complete set if the cloud hasn't acknowledged the
+            // previous vitals
+            desc_flags |= particle::protocol::DESCRIBE_METRICS_DELTA;
+        }
+
         // Transmit CoAP message via communication layer
-        error = spark_protocol_post_description(spark_protocol_instance(),
-                                                particle::protocol::DESCRIBE_METRICS, nullptr);
+        error = spark_protocol_post_description(spark_protocol_instance(), desc_flags, nullptr);
 
         // Convert `protocol` error to `system` error
         error = spark_protocol_to_system_error(error);
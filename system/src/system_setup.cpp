@@ -336,6 +336,18 @@ template<typename Config> void SystemSetupConsole<Config>::handle(char c)
         serial.println("Waiting for the binary file to be sent ... (press 'a' to abort)");
         system_firmwareUpdate(&serial);
     }
+    else if ('g' == c)
+    {
+        serial.println("Waiting for the binary file to be sent using YMODEM-g ... (press 'a' to abort)");
+        system_file_transfer_t tx;
+        tx.flags = SYSTEM_FILE_TRANSFER_FLAG_STREAMING;
+        tx.descriptor.store = FileTransfer::Store::FIRMWARE;
+        tx.stream = &serial;
+#if PLATFORM_ID>2
+        set_ymodem_serial_flash_update_handler(Ymodem_Serial_Flash_Update);
+#endif
+        system_fileTransfer(&tx);
+    }
     else if ('x' == c)
     {
         exit();
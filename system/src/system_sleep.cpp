@@ -29,11 +29,60 @@
 #include "spark_wiring_system.h"
 #include "led_service.h"
 #include "system_task.h"
+#include "spark_wiring_diagnostics.h"
+#include "timer_hal.h"
+#if HAL_PLATFORM_FILESYSTEM
+#include "system_publish_queue.h"
+#endif // HAL_PLATFORM_FILESYSTEM
 #if HAL_PLATFORM_CELLULAR
 #include "cellular_hal.h"
 #endif // HAL_PLATFORM_CELLULAR
+#if HAL_PLATFORM_MESH
+#include "mesh_hal.h"
+#endif // HAL_PLATFORM_MESH
 #include "check.h"
 
+namespace {
+
+using namespace particle;
+
+// Time in milliseconds the device spends awake between two report cycles. There's no way to measure
+// the energy consumption directly, but the awake time is what it mostly depends on
+SimpleHistogramDiagnosticData g_reportCycleTime(DIAG_ID_SYSTEM_REPORT_CYCLE_TIME, DIAG_NAME_SYSTEM_REPORT_CYCLE_TIME);
+
+// Time when the device woke up after a report cycle, or 0 if it didn't
+system_tick_t g_reportCycleWakeTime = 0;
+
+void system_sleep_report_cycle_prepare() {
+    if (g_reportCycleWakeTime) {
+        g_reportCycleTime.add(HAL_Timer_Get_Milli_Seconds() - g_reportCycleWakeTime);
+        g_reportCycleWakeTime = 0;
+    }
+#if HAL_PLATFORM_FILESYSTEM
+    // Send the queued events right away rather than waiting for the next run of the system loop
+    auto queue = particle::system::PublishQueue::instance();
+    queue->flush();
+    queue->process();
+#endif // HAL_PLATFORM_FILESYSTEM
+}
+
+#if HAL_PLATFORM_MESH
+
+// A Sleepy End Device stays attached to its parent while sleeping. The parent buffers the frames
+// for it until the next data poll, so the device doesn't need to reattach when it wakes up
+bool system_sleep_mesh_keep_attached(const SystemSleepConfigurationHelper& config) {
+    if (config.sleepMode() == SystemSleepMode::HIBERNATE) {
+        return false;
+    }
+    mesh_sleepy_config conf = {};
+    conf.size = sizeof(conf);
+    return mesh_get_sleepy_config(&conf, nullptr) == 0 && conf.poll_period > 0;
+}
+
+#endif // HAL_PLATFORM_MESH
+
+} // namespace
+
 static bool system_sleep_network_suspend(network_interface_index index) {
     bool resume = false;
     // Disconnect from network
@@ -64,6 +113,11 @@ int system_sleep_ext(const hal_sleep_config_t* config, hal_wakeup_source_base_t*
 
     SystemSleepConfigurationHelper configHelper(config);
 
+    const bool reportCycle = configHelper.reportCycle();
+    if (reportCycle) {
+        system_sleep_report_cycle_prepare();
+    }
+
     bool cloudResume = false;
     // Disconnect from cloud is necessary.
     // Make sure all confirmable UDP messages are sent and acknowledged before sleeping
@@ -74,18 +128,22 @@ int system_sleep_ext(const hal_sleep_config_t* config, hal_wakeup_source_base_t*
         cloudResume = spark_cloud_flag_auto_connect();
         // Clear the auto connect status
         spark_cloud_flag_disconnect();
+    } else if (reportCycle && spark_cloud_flag_connected()) {
+        // The session is kept across the sleep, only wait for the pending messages to be acknowledged
+        Spark_Sleep();
     }
 
     // Network disconnect.
     // FIXME: if_get_list() can be potentially used, instead of using pre-processor.
 #if HAL_PLATFORM_CELLULAR
     bool cellularResume = false;
-    if (!configHelper.wakeupByNetworkInterface(NETWORK_INTERFACE_CELLULAR)) {
+    if (!configHelper.keepNetworkInterface(NETWORK_INTERFACE_CELLULAR)) {
         if (system_sleep_network_suspend(NETWORK_INTERFACE_CELLULAR)) {
             cellularResume = true;
         }
     } else {
-        // Pause the modem Serial, while leaving the modem keeps running.
+        // Pause the modem Serial, while leaving the modem keeps running. In a report cycle, the modem
+        // stays registered, and can use PSM or eDRX if it's configured to do so
         cellular_pause(nullptr);
     }
 #endif // HAL_PLATFORM_CELLULAR
@@ -101,7 +159,8 @@ int system_sleep_ext(const hal_sleep_config_t* config, hal_wakeup_source_base_t*
 
 #if HAL_PLATFORM_MESH
     bool meshResume = false;
-    if (!configHelper.wakeupByNetworkInterface(NETWORK_INTERFACE_MESH)) {
+    const bool meshKeepAttached = system_sleep_mesh_keep_attached(configHelper);
+    if (!configHelper.wakeupByNetworkInterface(NETWORK_INTERFACE_MESH) && !meshKeepAttached) {
         if (system_sleep_network_suspend(NETWORK_INTERFACE_MESH)) {
             meshResume = true;
         }
@@ -130,6 +189,13 @@ int system_sleep_ext(const hal_sleep_config_t* config, hal_wakeup_source_base_t*
 
     system_power_management_sleep(false);
 
+    if (reportCycle) {
+        g_reportCycleWakeTime = HAL_Timer_Get_Milli_Seconds();
+        if (!g_reportCycleWakeTime) {
+            g_reportCycleWakeTime = 1;
+        }
+    }
+
     // Start RGB signaling.
     led_set_update_enabled(1, nullptr); // Enable background LED updates
 
@@ -155,6 +221,9 @@ int system_sleep_ext(const hal_sleep_config_t* config, hal_wakeup_source_base_t*
         // FIXME: we need to bring Mesh interface back up because we've turned it off
         // despite SLEEP_NETWORK_STANDBY
         system_sleep_network_resume(NETWORK_INTERFACE_MESH);
+    } else if (meshKeepAttached) {
+        // Fetch the frames the parent has buffered while the device was sleeping
+        mesh_poll_parent(nullptr);
     }
 #endif // HAL_PLATFORM_MESH
 
@@ -32,6 +32,7 @@
 #include "core_hal.h"
 #include "system_tick_hal.h"
 #include "watchdog_hal.h"
+#include "eeprom_hal.h"
 #include "wlan_hal.h"
 #include "delay_hal.h"
 #include "timer_hal.h"
@@ -39,7 +40,8 @@
 #include "service_debug.h"
 #include "cellular_hal.h"
 #include "system_power.h"
-#include "simple_pool_allocator.h"
+#include "slab_allocator.h"
+#include "spark_wiring_diagnostics.h"
 
 #include "spark_wiring_network.h"
 #include "spark_wiring_constants.h"
@@ -48,10 +50,15 @@
 #include "spark_wiring_interrupts.h"
 #include "spark_wiring_led.h"
 #include "system_commands.h"
+#include "system_publish_queue.h"
+#include "system_keepalive.h"
+#include "mbedtls_util.h"
 
 #if HAL_PLATFORM_BLE
 #include "ble_hal.h"
 #include "system_control_internal.h"
+#include "system_deferred_init.h"
+#include "system_loop_stats.h"
 
 using namespace particle;
 
@@ -60,6 +67,7 @@ using namespace particle;
 using spark::Network;
 using particle::LEDStatus;
 using particle::CloudDiagnostics;
+using particle::SlabAllocator;
 
 volatile system_tick_t spark_loop_total_millis = 0;
 
@@ -81,7 +89,55 @@ static struct SetThreadCurrentFunctionPointers {
     }
 } s_SetThreadCurrentFunctionPointersInitializer;
 
-ISRTaskQueue SystemISRTaskQueue;
+namespace {
+
+// Runs the ISR tasks and coroutines as soon as possible instead of waiting for the next iteration of
+// the system loop
+void wake_system_thread() {
+#if PLATFORM_THREADING
+    if (SystemThread.isStarted()) {
+        SystemThread.wakeup();
+    }
+#endif
+}
+
+} // namespace
+
+ISRTaskQueue SystemISRTaskQueue(wake_system_thread);
+
+particle::CoroutineScheduler SystemCoroutineScheduler(wake_system_thread);
+
+// Maximum number of ISR tasks and maximum time in milliseconds spent running them per iteration of
+// the system loop. The remaining tasks are run in the next iteration
+#ifndef SYSTEM_ISR_TASK_QUEUE_BATCH_SIZE
+#define SYSTEM_ISR_TASK_QUEUE_BATCH_SIZE 8
+#endif
+
+#ifndef SYSTEM_ISR_TASK_QUEUE_BATCH_TIME
+#define SYSTEM_ISR_TASK_QUEUE_BATCH_TIME 10
+#endif
+
+namespace {
+
+class IsrTaskQueueMaxSizeDiagnosticData: public particle::AbstractIntegerDiagnosticData {
+public:
+    IsrTaskQueueMaxSizeDiagnosticData() :
+            AbstractIntegerDiagnosticData(DIAG_ID_SYSTEM_ISR_TASK_QUEUE_MAX_SIZE, DIAG_NAME_SYSTEM_ISR_TASK_QUEUE_MAX_SIZE) {
+    }
+
+    virtual int get(IntType& val) override {
+        val = SystemISRTaskQueue.maxSize();
+        return 0;
+    }
+};
+
+IsrTaskQueueMaxSizeDiagnosticData g_isrTaskQueueMaxSizeDiagData;
+
+// Number of loop iterations that left ISR tasks in the queue because the batch limits were reached
+particle::CounterDiagnosticData g_isrTaskQueueDeferralsDiagData(DIAG_ID_SYSTEM_ISR_TASK_QUEUE_DEFERRALS,
+        DIAG_NAME_SYSTEM_ISR_TASK_QUEUE_DEFERRALS);
+
+} // namespace
 
 void Network_Setup(bool threaded)
 {
@@ -279,7 +335,7 @@ void establish_cloud_connection()
         INFO("Cloud: connecting");
         const auto diag = CloudDiagnostics::instance();
         diag->status(CloudDiagnostics::CONNECTING);
-        system_notify_event(cloud_status, cloud_status_connecting);
+        system_notify_event(cloud_status, cloud_status_connecting, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
         diag->connectionAttempt();
         int connect_result = spark_cloud_socket_connect();
         if (connect_result >= 0)
@@ -299,7 +355,7 @@ void establish_cloud_connection()
 
             diag->status(CloudDiagnostics::DISCONNECTED);
             // "Connecting" event should be followed by either "connected" or "disconnected" event
-            system_notify_event(cloud_status, cloud_status_disconnected);
+            system_notify_event(cloud_status, cloud_status_disconnected, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
 
             // if the user put the networkin listening mode via the button,
             // the cloud connect may have been cancelled.
@@ -351,8 +407,12 @@ void handle_cloud_connection(bool force_events)
                     SPARK_CLOUD_CONNECTED = 1;
                     SPARK_CLOUD_HANDSHAKE_NOTIFY_DONE = 0;
                     cloud_failed_connection_attempts = 0;
+                    system_cloud_connection_established(nullptr);
+#if HAL_PLATFORM_CLOUD_UDP
+                    particle::system::AdaptiveKeepAlive::instance()->connected();
+#endif
                     CloudDiagnostics::instance()->status(CloudDiagnostics::CONNECTED);
-                    system_notify_event(cloud_status, cloud_status_connected);
+                    system_notify_event(cloud_status, cloud_status_connected, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
                     if (system_mode() == SAFE_MODE) {
 /* FIXME: there should be macro that checks for NetworkManager availability */
                         // Connected to the cloud while in safe mode
@@ -424,7 +484,18 @@ void manage_cloud_connection(bool force_events)
 
 static void process_isr_task_queue()
 {
-    SystemISRTaskQueue.process();
+    const system_tick_t start = HAL_Timer_Get_Milli_Seconds();
+    for (unsigned i = 0; i < SYSTEM_ISR_TASK_QUEUE_BATCH_SIZE; ++i) {
+        if (!SystemISRTaskQueue.process()) {
+            return;
+        }
+        if (HAL_Timer_Get_Milli_Seconds() - start >= SYSTEM_ISR_TASK_QUEUE_BATCH_TIME) {
+            break;
+        }
+    }
+    if (!SystemISRTaskQueue.isEmpty()) {
+        ++g_isrTaskQueueDeferralsDiagData;
+    }
 }
 
 #if HAL_PLATFORM_SETUP_BUTTON_UX
@@ -433,6 +504,8 @@ extern void system_handle_button_clicks(bool isIsr);
 
 void Spark_Idle_Events(bool force_events/*=false*/)
 {
+    const uint32_t start = HAL_Timer_Get_Micro_Seconds();
+
     HAL_Notify_WDT();
 
     ON_EVENT_DELTA();
@@ -440,6 +513,8 @@ void Spark_Idle_Events(bool force_events/*=false*/)
 
     process_isr_task_queue();
 
+    SystemCoroutineScheduler.process(HAL_Timer_Get_Milli_Seconds());
+
     if (!SYSTEM_POWEROFF) {
 
 #if HAL_PLATFORM_SETUP_BUTTON_UX
@@ -455,20 +530,37 @@ void Spark_Idle_Events(bool force_events/*=false*/)
 
         manage_cloud_connection(force_events);
 
+        HAL_EEPROM_Process(nullptr);
+
+        // Generate ephemeral keys for the next handshake while the cloud connection is not
+        // being negotiated
+        if (!SPARK_CLOUD_SOCKETED || SPARK_CLOUD_CONNECTED) {
+            mbedtls_ecp_precompute_keypair(nullptr);
+        }
+
+#if HAL_PLATFORM_CLOUD_UDP
+        particle::system::AdaptiveKeepAlive::instance()->process();
+#endif
 // FIXME: there should be a separate feature macro
 #if HAL_PLATFORM_FILESYSTEM
         particle::system::fetchAndExecuteCommand(millis());
+        particle::system::PublishQueue::instance()->process();
 #endif // HAL_PLATFORM_FILESYSTEM
     }
     else
     {
         system_pending_shutdown();
     }
+    system::processDeferredInit();
 #if HAL_PLATFORM_BLE
     // TODO: Process BLE channel events in a separate thread
-    system::SystemControl::instance()->run();
+    if (system::deferredSubsystemsInitialized()) {
+        system::SystemControl::instance()->run();
+    }
 #endif
     system_shutdown_if_needed();
+
+    particle::system::LoopStats::instance()->idleEventsFinished(HAL_Timer_Get_Micro_Seconds() - start);
 }
 
 /*
@@ -525,7 +617,7 @@ void system_delay_pump(unsigned long ms, bool force_no_background_loop=false)
                 //Run once if the above condition passes
                 spark_process();
             }
-            while (!threading && SPARK_FLASH_UPDATE); //loop during OTA update
+            while (!threading && system_update_blocks_application()); //loop during OTA update
         }
     }
 }
@@ -559,6 +651,9 @@ void cloud_disconnect(bool closeSocket, bool graceful, cloud_disconnect_reason r
     if (SPARK_CLOUD_SOCKETED || SPARK_CLOUD_CONNECTED)
     {
         INFO("Cloud: disconnecting");
+#if HAL_PLATFORM_CLOUD_UDP
+        particle::system::AdaptiveKeepAlive::instance()->disconnecting();
+#endif
         const auto diag = CloudDiagnostics::instance();
         if (SPARK_CLOUD_CONNECTED)
         {
@@ -571,7 +666,7 @@ void cloud_disconnect(bool closeSocket, bool graceful, cloud_disconnect_reason r
             }
             diag->status(CloudDiagnostics::DISCONNECTING);
             // "Disconnecting" event is generated only for a successfully established connection (including handshake)
-            system_notify_event(cloud_status, cloud_status_disconnecting);
+            system_notify_event(cloud_status, cloud_status_disconnecting, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
         }
 
         if (closeSocket)
@@ -589,7 +684,7 @@ void cloud_disconnect(bool closeSocket, bool graceful, cloud_disconnect_reason r
 
         INFO("Cloud: disconnected");
         diag->status(CloudDiagnostics::DISCONNECTED);
-        system_notify_event(cloud_status, cloud_status_disconnected);
+        system_notify_event(cloud_status, cloud_status_disconnected, nullptr, nullptr, nullptr, NOTIFY_COALESCE);
     }
     Spark_Error_Count = 0;  // this is also used for CFOD/WiFi reset, and blocks the LED when set.
 }
@@ -633,22 +728,30 @@ void cancel_connection()
 
 namespace {
 
-// Memory pool for small and short-lived allocations
-SimpleAllocedPool g_memPool(512);
+// Memory pool for small and short-lived allocations: ISR tasks, system events and buffers of
+// the control requests. Allocations are served in constant time, which keeps the interrupts
+// disabled for as short as possible
+const SlabAllocator::SizeClass MEM_POOL_SIZE_CLASSES[] = {
+    { 32, 8 },
+    { 64, 8 },
+    { 128, 4 }
+};
+
+SlabAllocator g_memPool(MEM_POOL_SIZE_CLASSES, sizeof(MEM_POOL_SIZE_CLASSES) / sizeof(MEM_POOL_SIZE_CLASSES[0]));
 
 } // namespace
 
 void* system_pool_alloc(size_t size, void* reserved) {
     void *ptr = nullptr;
     ATOMIC_BLOCK() {
-        ptr = g_memPool.allocate(size);
+        ptr = g_memPool.alloc(size);
     }
     return ptr;
 }
 
 void system_pool_free(void* ptr, void* reserved) {
     ATOMIC_BLOCK() {
-        g_memPool.deallocate(ptr);
+        g_memPool.free(ptr);
     }
 }
 
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "concurrent_hal.h"
+
+#if PLATFORM_THREADING
+
+#include <memory>
+
+namespace particle {
+
+namespace system {
+
+/**
+ * Runtime statistics of all threads.
+ */
+struct ThreadStats {
+    std::unique_ptr<os_thread_stats_t[]> threads; ///< Thread statistics.
+    size_t count; ///< Number of threads.
+    uint32_t totalTime; ///< Total CPU time in microseconds.
+
+    ThreadStats() :
+            count(0),
+            totalTime(0) {
+    }
+};
+
+/**
+ * Gets the runtime statistics of all threads.
+ *
+ * @param stats Statistics.
+ * @return 0 on success, or a negative result code.
+ */
+int getThreadStats(ThreadStats* stats);
+
+} // namespace system
+
+} // namespace particle
+
+#endif // PLATFORM_THREADING
@@ -1,7 +1,11 @@
 #include "system_threading.h"
 #include "system_task.h"
+#include "system_thread_stats.h"
+#include "system_error.h"
+#include "spark_wiring_diagnostics.h"
 #include <time.h>
 #include <string.h>
+#include <new>
 
 #if PLATFORM_THREADING
 
@@ -22,6 +26,160 @@ ActiveObjectThreadQueue SystemThread(ActiveObjectConfiguration(system_thread_idl
 			50, /* queue size */
 			THREAD_STACK_SIZE /* stack size */));
 
+namespace {
+
+using namespace particle;
+
+class SystemThreadQueueDiagnosticData: public AbstractIntegerDiagnosticData {
+public:
+    enum Field {
+        DEPTH,
+        MAX_WAIT,
+        MAX_HIGH_WAIT
+    };
+
+    SystemThreadQueueDiagnosticData(uint16_t id, const char* name, Field field) :
+            AbstractIntegerDiagnosticData(id, name),
+            field_(field) {
+    }
+
+    virtual int get(IntType& val) override {
+        ActiveObjectQueueStats stats = {};
+        SystemThread.stats(&stats);
+        switch (field_) {
+        case DEPTH:
+            val = stats.depth;
+            break;
+        case MAX_WAIT:
+            val = stats.max_wait;
+            break;
+        case MAX_HIGH_WAIT:
+            val = stats.max_high_wait;
+            break;
+        }
+        return 0;
+    }
+
+private:
+    Field field_;
+};
+
+SystemThreadQueueDiagnosticData g_queueDepthDiagData(DIAG_ID_SYSTEM_THREAD_QUEUE_DEPTH,
+        DIAG_NAME_SYSTEM_THREAD_QUEUE_DEPTH, SystemThreadQueueDiagnosticData::DEPTH);
+SystemThreadQueueDiagnosticData g_queueMaxWaitDiagData(DIAG_ID_SYSTEM_THREAD_QUEUE_MAX_WAIT,
+        DIAG_NAME_SYSTEM_THREAD_QUEUE_MAX_WAIT, SystemThreadQueueDiagnosticData::MAX_WAIT);
+SystemThreadQueueDiagnosticData g_queueMaxHighWaitDiagData(DIAG_ID_SYSTEM_THREAD_QUEUE_MAX_HIGH_WAIT,
+        DIAG_NAME_SYSTEM_THREAD_QUEUE_MAX_HIGH_WAIT, SystemThreadQueueDiagnosticData::MAX_HIGH_WAIT);
+
+// Percentage of CPU time used by all threads but IDLE, or by the system thread, since the
+// previous query. The RTOS counters wrap around, so only their deltas are meaningful
+class CpuUsageDiagnosticData: public AbstractIntegerDiagnosticData {
+public:
+    enum Source {
+        ALL_THREADS,
+        SYSTEM_THREAD
+    };
+
+    CpuUsageDiagnosticData(uint16_t id, const char* name, Source source) :
+            AbstractIntegerDiagnosticData(id, name),
+            source_(source),
+            lastTotalTime_(0),
+            lastThreadTime_(0) {
+    }
+
+    virtual int get(IntType& val) override {
+        system::ThreadStats stats;
+        const int ret = system::getThreadStats(&stats);
+        if (ret < 0) {
+            return ret;
+        }
+        uint32_t threadTime = 0;
+        for (size_t i = 0; i < stats.count; ++i) {
+            const os_thread_stats_t& t = stats.threads[i];
+            if (source_ == SYSTEM_THREAD) {
+                if (t.thread == SystemThread.thread()) {
+                    threadTime = t.cpu_time;
+                    break;
+                }
+            } else if (strcmp(t.name, "IDLE") != 0) {
+                threadTime += t.cpu_time;
+            }
+        }
+        const uint32_t totalDelta = stats.totalTime - lastTotalTime_;
+        const uint32_t threadDelta = threadTime - lastThreadTime_;
+        lastTotalTime_ = stats.totalTime;
+        lastThreadTime_ = threadTime;
+        val = totalDelta ? (uint64_t)threadDelta * 100 / totalDelta : 0;
+        return 0;
+    }
+
+private:
+    Source source_;
+    uint32_t lastTotalTime_;
+    uint32_t lastThreadTime_;
+};
+
+// Smallest stack high-water mark among all threads, in bytes
+class StackFreeMinDiagnosticData: public AbstractIntegerDiagnosticData {
+public:
+    StackFreeMinDiagnosticData() :
+            AbstractIntegerDiagnosticData(DIAG_ID_SYSTEM_STACK_FREE_MIN, DIAG_NAME_SYSTEM_STACK_FREE_MIN) {
+    }
+
+    virtual int get(IntType& val) override {
+        system::ThreadStats stats;
+        const int ret = system::getThreadStats(&stats);
+        if (ret < 0) {
+            return ret;
+        }
+        if (!stats.count) {
+            return SYSTEM_ERROR_NOT_FOUND;
+        }
+        uint32_t freeMin = stats.threads[0].stack_free_min;
+        for (size_t i = 1; i < stats.count; ++i) {
+            if (stats.threads[i].stack_free_min < freeMin) {
+                freeMin = stats.threads[i].stack_free_min;
+            }
+        }
+        val = freeMin;
+        return 0;
+    }
+};
+
+CpuUsageDiagnosticData g_cpuUsageDiagData(DIAG_ID_SYSTEM_CPU_USAGE, DIAG_NAME_SYSTEM_CPU_USAGE,
+        CpuUsageDiagnosticData::ALL_THREADS);
+CpuUsageDiagnosticData g_systemThreadCpuUsageDiagData(DIAG_ID_SYSTEM_THREAD_CPU_USAGE,
+        DIAG_NAME_SYSTEM_THREAD_CPU_USAGE, CpuUsageDiagnosticData::SYSTEM_THREAD);
+StackFreeMinDiagnosticData g_stackFreeMinDiagData;
+
+} // namespace
+
+int particle::system::getThreadStats(ThreadStats* stats)
+{
+    // The number of threads can change between the calls, in which case the statistics of
+    // the threads that didn't fit are skipped
+    const int count = os_thread_get_stats(nullptr, 0, nullptr, nullptr);
+    if (count < 0) {
+        return count;
+    }
+    std::unique_ptr<os_thread_stats_t[]> threads(new(std::nothrow) os_thread_stats_t[count]);
+    if (!threads) {
+        return SYSTEM_ERROR_NO_MEMORY;
+    }
+    for (int i = 0; i < count; ++i) {
+        threads[i].size = sizeof(os_thread_stats_t);
+    }
+    uint32_t totalTime = 0;
+    const int n = os_thread_get_stats(threads.get(), count, &totalTime, nullptr);
+    if (n < 0) {
+        return n;
+    }
+    stats->threads = std::move(threads);
+    stats->count = n;
+    stats->totalTime = totalTime;
+    return 0;
+}
+
 /**
  * Implementation to support gthread's concurrency primitives.
  */
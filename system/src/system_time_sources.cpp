@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "logging.h"
+LOG_SOURCE_CATEGORY("system.time")
+
+#include "system_time_sources.h"
+
+#include "system_network.h"
+#include "rtc_hal.h"
+#include "hal_platform.h"
+#include "system_error.h"
+#include "check.h"
+
+#if HAL_PLATFORM_CELLULAR
+#include "cellular_hal.h"
+#endif
+
+#if HAL_PLATFORM_WIFI && HAL_USE_SOCKET_HAL_POSIX
+#include "socket_hal.h"
+#include "netdb_hal.h"
+#include "scope_guard.h"
+#endif
+
+namespace particle {
+
+namespace system {
+
+namespace {
+
+// Maximum time the RTC is trusted for after it was set from another source
+const time_t RTC_MAX_AGE = 24 * 60 * 60;
+
+time_t g_lastSyncTime = 0; // Time of the last synchronization with a source other than the RTC
+unsigned g_rtcSource = 0; // 1-based index of the RTC source
+
+#if HAL_PLATFORM_CELLULAR
+
+int cellularTimeSource(time_t* time, void* data) {
+    CHECK(cellular_network_time(time, nullptr));
+    return 0;
+}
+
+#endif // HAL_PLATFORM_CELLULAR
+
+#if HAL_PLATFORM_WIFI && HAL_USE_SOCKET_HAL_POSIX
+
+const char* const SNTP_SERVER = "pool.ntp.org";
+const char* const SNTP_PORT = "123";
+const unsigned SNTP_TIMEOUT = 2000;
+const size_t SNTP_PACKET_SIZE = 48;
+const uint32_t NTP_UNIX_EPOCH_OFFSET = 2208988800UL; // Seconds from 1900-01-01 to 1970-01-01
+
+int sntpTimeSource(time_t* time, void* data) {
+    CHECK_TRUE(network_ready(NETWORK_INTERFACE_WIFI_STA, NETWORK_READY_TYPE_ANY, nullptr), SYSTEM_ERROR_INVALID_STATE);
+    struct addrinfo hints = {};
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+    struct addrinfo* info = nullptr;
+    CHECK_TRUE(netdb_getaddrinfo(SNTP_SERVER, SNTP_PORT, &hints, &info) == 0 && info, SYSTEM_ERROR_NETWORK);
+    SCOPE_GUARD({
+        netdb_freeaddrinfo(info);
+    });
+    const int s = sock_socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    CHECK_TRUE(s >= 0, SYSTEM_ERROR_NETWORK);
+    SCOPE_GUARD({
+        sock_close(s);
+    });
+    struct timeval tv = {};
+    tv.tv_sec = SNTP_TIMEOUT / 1000;
+    tv.tv_usec = (SNTP_TIMEOUT % 1000) * 1000;
+    CHECK_TRUE(sock_setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == 0, SYSTEM_ERROR_NETWORK);
+    uint8_t buf[SNTP_PACKET_SIZE] = {};
+    buf[0] = 0x23; // LI = 0, VN = 4, Mode = 3 (client)
+    ssize_t n = sock_sendto(s, buf, sizeof(buf), 0, info->ai_addr, info->ai_addrlen);
+    CHECK_TRUE(n == (ssize_t)sizeof(buf), SYSTEM_ERROR_NETWORK);
+    n = sock_recvfrom(s, buf, sizeof(buf), 0, nullptr, nullptr);
+    CHECK_TRUE(n >= 0, SYSTEM_ERROR_TIMEOUT);
+    // Expect a server reply (mode 4) from a synchronized server (stratum 1-15)
+    CHECK_TRUE(n == (ssize_t)sizeof(buf) && (buf[0] & 0x07) == 4 && buf[1] >= 1 && buf[1] <= 15, SYSTEM_ERROR_BAD_DATA);
+    // Seconds part of the transmit timestamp
+    const uint32_t secs = ((uint32_t)buf[40] << 24) | ((uint32_t)buf[41] << 16) | ((uint32_t)buf[42] << 8) | buf[43];
+    CHECK_TRUE(secs > NTP_UNIX_EPOCH_OFFSET, SYSTEM_ERROR_BAD_DATA);
+    *time = secs - NTP_UNIX_EPOCH_OFFSET;
+    return 0;
+}
+
+#endif // HAL_PLATFORM_WIFI && HAL_USE_SOCKET_HAL_POSIX
+
+int rtcTimeSource(time_t* time, void* data) {
+    CHECK_TRUE(HAL_RTC_Time_Is_Valid(nullptr) && g_lastSyncTime, SYSTEM_ERROR_INVALID_STATE);
+    const time_t t = HAL_RTC_Get_UnixTime();
+    CHECK_TRUE(t >= g_lastSyncTime && t - g_lastSyncTime < RTC_MAX_AGE, SYSTEM_ERROR_INVALID_STATE);
+    *time = t;
+    return 0;
+}
+
+} // unnamed
+
+int registerTimeSources(ProtocolFacade* protocol) {
+    unsigned count = 0;
+#if HAL_PLATFORM_CELLULAR
+    CHECK(spark_protocol_add_time_source(protocol, cellularTimeSource, nullptr, nullptr));
+    ++count;
+#endif
+#if HAL_PLATFORM_WIFI && HAL_USE_SOCKET_HAL_POSIX
+    CHECK(spark_protocol_add_time_source(protocol, sntpTimeSource, nullptr, nullptr));
+    ++count;
+#endif
+    CHECK(spark_protocol_add_time_source(protocol, rtcTimeSource, nullptr, nullptr));
+    g_rtcSource = ++count;
+    return 0;
+}
+
+bool timeSynced(time_t time, unsigned source) {
+    if (source && source == g_rtcSource) {
+        return false;
+    }
+    g_lastSyncTime = time;
+    return true;
+}
+
+} // namespace system
+
+} // namespace particle
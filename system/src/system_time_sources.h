@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "spark_protocol_functions.h"
+
+#include <ctime>
+
+namespace particle {
+
+namespace system {
+
+/**
+ * Registers the local time sources of the platform with the protocol layer, in order of
+ * preference: the network time of the cellular modem (NITZ), SNTP over Wi-Fi, and the RTC if it
+ * was synchronized recently, e.g. before the device went to sleep. The cloud is only asked for
+ * the time if none of them can provide it.
+ */
+int registerTimeSources(ProtocolFacade* protocol);
+
+/**
+ * Invoked when the system time has been set by the protocol layer.
+ *
+ * @param time Current time.
+ * @param source `param` argument of the `set_time` callback.
+ * @return `false` if the time was obtained from the RTC and doesn't need to be set.
+ */
+bool timeSynced(time_t time, unsigned source);
+
+} // namespace system
+
+} // namespace particle
@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "logging.h"
+LOG_SOURCE_CATEGORY("system.tls")
+
+#include "system_tls.h"
+
+#if HAL_USE_SOCKET_HAL_POSIX
+
+#include "socket_hal.h"
+#include "mbedtls_util.h"
+#include "spark_wiring_thread.h"
+#include "system_error.h"
+#include "check.h"
+
+#include "mbedtls/ssl.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/net_sockets.h"
+
+#include <memory>
+#include <mutex>
+#include <cstring>
+#include <cerrno>
+#include <new>
+#include <strings.h>
+
+#define CHECK_MBEDTLS(_expr) \
+        do { \
+            const int _ret = _expr; \
+            if (_ret != 0) { \
+                LOG_DEBUG(ERROR, #_expr " failed: -0x%04x", -_ret); \
+                return mbedtlsError(_ret); \
+            } \
+        } while (false)
+
+namespace {
+
+int mbedtlsError(int ret) {
+    switch (ret) {
+    case 0:
+        return SYSTEM_ERROR_NONE;
+    case MBEDTLS_ERR_SSL_WANT_READ:
+    case MBEDTLS_ERR_SSL_WANT_WRITE:
+        return SYSTEM_ERROR_WOULD_BLOCK;
+    case MBEDTLS_ERR_SSL_TIMEOUT:
+        return SYSTEM_ERROR_TIMEOUT;
+    case MBEDTLS_ERR_SSL_ALLOC_FAILED:
+    case MBEDTLS_ERR_X509_ALLOC_FAILED:
+        return SYSTEM_ERROR_NO_MEMORY;
+    case MBEDTLS_ERR_X509_CERT_VERIFY_FAILED:
+        return SYSTEM_ERROR_NOT_ALLOWED;
+    case MBEDTLS_ERR_X509_INVALID_FORMAT:
+    case MBEDTLS_ERR_X509_UNKNOWN_VERSION:
+        return SYSTEM_ERROR_BAD_DATA;
+    case MBEDTLS_ERR_NET_SEND_FAILED:
+    case MBEDTLS_ERR_NET_RECV_FAILED:
+    case MBEDTLS_ERR_NET_CONN_RESET:
+        return SYSTEM_ERROR_NETWORK;
+    default:
+        return SYSTEM_ERROR_PROTOCOL;
+    }
+}
+
+// Sessions negotiated with servers, indexed by host name
+class SessionCache {
+public:
+    SessionCache() :
+            next_(0) {
+        for (auto& e: entries_) {
+            e.host[0] = '\0';
+            mbedtls_ssl_session_init(&e.session);
+        }
+    }
+
+    bool restore(const char* host, mbedtls_ssl_context* ssl) {
+        const std::lock_guard<Mutex> lock(mutex_);
+        const auto e = find(host);
+        if (!e) {
+            return false;
+        }
+        return mbedtls_ssl_set_session(ssl, &e->session) == 0;
+    }
+
+    void save(const char* host, const mbedtls_ssl_context* ssl) {
+        const std::lock_guard<Mutex> lock(mutex_);
+        auto e = find(host);
+        if (!e) {
+            e = &entries_[next_];
+            next_ = (next_ + 1) % SYSTEM_TLS_SESSION_CACHE_SIZE;
+            strncpy(e->host, host, sizeof(e->host) - 1);
+            e->host[sizeof(e->host) - 1] = '\0';
+        }
+        mbedtls_ssl_session_free(&e->session);
+        if (mbedtls_ssl_get_session(ssl, &e->session) != 0) {
+            mbedtls_ssl_session_free(&e->session);
+            e->host[0] = '\0';
+        }
+    }
+
+    void remove(const char* host) {
+        const std::lock_guard<Mutex> lock(mutex_);
+        const auto e = find(host);
+        if (e) {
+            mbedtls_ssl_session_free(&e->session);
+            e->host[0] = '\0';
+        }
+    }
+
+private:
+    struct Entry {
+        char host[SYSTEM_TLS_MAX_HOST_NAME_LENGTH + 1];
+        mbedtls_ssl_session session;
+    };
+
+    Entry entries_[SYSTEM_TLS_SESSION_CACHE_SIZE];
+    unsigned next_;
+    Mutex mutex_;
+
+    Entry* find(const char* host) {
+        for (auto& e: entries_) {
+            if (e.host[0] != '\0' && strcasecmp(e.host, host) == 0) {
+                return &e;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class TlsSession {
+public:
+    TlsSession() :
+            sock_(-1),
+            flags_(0) {
+        host_[0] = '\0';
+        mbedtls_ssl_init(&ssl_);
+        mbedtls_ssl_config_init(&conf_);
+        mbedtls_x509_crt_init(&caCert_);
+    }
+
+    ~TlsSession() {
+        mbedtls_ssl_free(&ssl_);
+        mbedtls_ssl_config_free(&conf_);
+        mbedtls_x509_crt_free(&caCert_);
+    }
+
+    int init(int sock, const system_tls_config* conf) {
+        sock_ = sock;
+        flags_ = conf->flags;
+        if (conf->host) {
+            CHECK_TRUE(strlen(conf->host) <= SYSTEM_TLS_MAX_HOST_NAME_LENGTH, SYSTEM_ERROR_INVALID_ARGUMENT);
+            strcpy(host_, conf->host);
+        }
+        if (conf->ca_cert && conf->ca_cert_size > 0) {
+            CHECK_MBEDTLS(mbedtls_x509_crt_parse_der(&caCert_, conf->ca_cert, conf->ca_cert_size));
+        } else {
+            CHECK_TRUE(flags_ & SYSTEM_TLS_FLAG_INSECURE, SYSTEM_ERROR_INVALID_ARGUMENT);
+        }
+        CHECK_MBEDTLS(mbedtls_ssl_config_defaults(&conf_, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                MBEDTLS_SSL_PRESET_DEFAULT));
+        mbedtls_ssl_conf_rng(&conf_, mbedtls_default_rng, nullptr);
+        mbedtls_ssl_conf_min_version(&conf_, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+        if (flags_ & SYSTEM_TLS_FLAG_INSECURE) {
+            mbedtls_ssl_conf_authmode(&conf_, MBEDTLS_SSL_VERIFY_NONE);
+        } else {
+            mbedtls_ssl_conf_authmode(&conf_, MBEDTLS_SSL_VERIFY_REQUIRED);
+            mbedtls_ssl_conf_ca_chain(&conf_, &caCert_, nullptr);
+        }
+        CHECK_MBEDTLS(mbedtls_ssl_setup(&ssl_, &conf_));
+        if (host_[0] != '\0') {
+            CHECK_MBEDTLS(mbedtls_ssl_set_hostname(&ssl_, host_));
+        }
+        mbedtls_ssl_set_bio(&ssl_, this, send, recv, nullptr);
+        return 0;
+    }
+
+    int handshake(SessionCache* cache) {
+        const bool useCache = host_[0] != '\0' && !(flags_ & SYSTEM_TLS_FLAG_NO_SESSION_CACHE);
+        if (useCache && cache->restore(host_, &ssl_)) {
+            LOG(TRACE, "Resuming session with %s", host_);
+        }
+        int ret = 0;
+        do {
+            ret = mbedtls_ssl_handshake(&ssl_);
+        } while (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+        if (ret != 0) {
+            LOG(ERROR, "Handshake failed: -0x%04x", -ret);
+            if (useCache) {
+                // Don't try to resume the session again
+                cache->remove(host_);
+            }
+            return mbedtlsError(ret);
+        }
+        if (useCache) {
+            cache->save(host_, &ssl_);
+        }
+        return 0;
+    }
+
+    int write(const void* data, size_t size) {
+        const int ret = mbedtls_ssl_write(&ssl_, (const unsigned char*)data, size);
+        if (ret < 0) {
+            return mbedtlsError(ret);
+        }
+        return ret;
+    }
+
+    int read(void* data, size_t size) {
+        const int ret = mbedtls_ssl_read(&ssl_, (unsigned char*)data, size);
+        if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+            return 0;
+        }
+        if (ret < 0) {
+            return mbedtlsError(ret);
+        }
+        return ret;
+    }
+
+    int close() {
+        const int ret = mbedtls_ssl_close_notify(&ssl_);
+        if (ret != 0) {
+            return mbedtlsError(ret);
+        }
+        return 0;
+    }
+
+private:
+    mbedtls_ssl_context ssl_;
+    mbedtls_ssl_config conf_;
+    mbedtls_x509_crt caCert_;
+    char host_[SYSTEM_TLS_MAX_HOST_NAME_LENGTH + 1];
+    int sock_;
+    unsigned flags_;
+
+    static int send(void* ctx, const unsigned char* data, size_t size) {
+        const auto self = (TlsSession*)ctx;
+        const int ret = sock_send(self->sock_, data, size, 0);
+        if (ret < 0) {
+            if (errno == EWOULDBLOCK || errno == EAGAIN) {
+                return MBEDTLS_ERR_SSL_WANT_WRITE;
+            }
+            return MBEDTLS_ERR_NET_SEND_FAILED;
+        }
+        return ret;
+    }
+
+    static int recv(void* ctx, unsigned char* data, size_t size) {
+        const auto self = (TlsSession*)ctx;
+        const int ret = sock_recv(self->sock_, data, size, 0);
+        if (ret < 0) {
+            if (errno == EWOULDBLOCK || errno == EAGAIN) {
+                // The socket's receive timeout has expired
+                return MBEDTLS_ERR_SSL_TIMEOUT;
+            }
+            if (errno == ECONNRESET) {
+                return MBEDTLS_ERR_NET_CONN_RESET;
+            }
+            return MBEDTLS_ERR_NET_RECV_FAILED;
+        }
+        return ret;
+    }
+};
+
+SessionCache g_sessionCache;
+
+std::unique_ptr<TlsSession> g_sessions[SYSTEM_TLS_MAX_SESSIONS];
+Mutex g_sessionsMutex;
+
+TlsSession* getSession(int handle) {
+    if (handle < 0 || handle >= SYSTEM_TLS_MAX_SESSIONS) {
+        return nullptr;
+    }
+    const std::lock_guard<Mutex> lock(g_sessionsMutex);
+    return g_sessions[handle].get();
+}
+
+} // unnamed
+
+int system_tls_open(int sock, const system_tls_config* conf, void* reserved) {
+    CHECK_TRUE(conf, SYSTEM_ERROR_INVALID_ARGUMENT);
+    std::unique_ptr<TlsSession> session(new(std::nothrow) TlsSession());
+    CHECK_TRUE(session, SYSTEM_ERROR_NO_MEMORY);
+    CHECK(session->init(sock, conf));
+    int handle = -1;
+    TlsSession* s = session.get();
+    {
+        const std::lock_guard<Mutex> lock(g_sessionsMutex);
+        for (int i = 0; i < SYSTEM_TLS_MAX_SESSIONS; ++i) {
+            if (!g_sessions[i]) {
+                g_sessions[i] = std::move(session);
+                handle = i;
+                break;
+            }
+        }
+    }
+    CHECK_TRUE(handle >= 0, SYSTEM_ERROR_LIMIT_EXCEEDED);
+    const int ret = s->handshake(&g_sessionCache);
+    if (ret < 0) {
+        const std::lock_guard<Mutex> lock(g_sessionsMutex);
+        g_sessions[handle].reset();
+        return ret;
+    }
+    return handle;
+}
+
+int system_tls_write(int handle, const void* data, size_t size, void* reserved) {
+    const auto session = getSession(handle);
+    CHECK_TRUE(session, SYSTEM_ERROR_INVALID_ARGUMENT);
+    return session->write(data, size);
+}
+
+int system_tls_read(int handle, void* data, size_t size, void* reserved) {
+    const auto session = getSession(handle);
+    CHECK_TRUE(session, SYSTEM_ERROR_INVALID_ARGUMENT);
+    return session->read(data, size);
+}
+
+int system_tls_close(int handle, void* reserved) {
+    std::unique_ptr<TlsSession> session;
+    if (handle >= 0 && handle < SYSTEM_TLS_MAX_SESSIONS) {
+        const std::lock_guard<Mutex> lock(g_sessionsMutex);
+        session = std::move(g_sessions[handle]);
+    }
+    CHECK_TRUE(session, SYSTEM_ERROR_INVALID_ARGUMENT);
+    return session->close();
+}
+
+#endif // HAL_USE_SOCKET_HAL_POSIX
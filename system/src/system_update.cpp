@@ -18,6 +18,7 @@
  */
 
 #include <stddef.h>
+#include <algorithm>
 #include "spark_wiring_cloud.h"
 #include "spark_wiring_system.h"
 #include "spark_wiring_stream.h"
@@ -28,6 +29,7 @@
 #include "ota_flash_hal.h"
 #include "core_hal.h"
 #include "delay_hal.h"
+#include "eeprom_hal.h"
 #include "system_event.h"
 #include "system_update.h"
 #include "system_cloud_internal.h"
@@ -43,6 +45,7 @@
 #include "system_network_internal.h"
 #include "bytes2hexbuf.h"
 #include "system_threading.h"
+#include "spark_wiring_vector.h"
 #if HAL_PLATFORM_DCT
 #include "dct.h"
 #endif // HAL_PLATFORM_DCT
@@ -74,7 +77,10 @@ static_assert(SYSTEM_FLAG_PUBLISH_RESET_INFO == 6, "system flag value");
 static_assert(SYSTEM_FLAG_RESET_NETWORK_ON_CLOUD_ERRORS == 7, "system flag value");
 static_assert(SYSTEM_FLAG_PM_DETECTION == 8, "system flag value");
 static_assert(SYSTEM_FLAG_OTA_UPDATE_FORCED == 9, "system flag value");
-static_assert(SYSTEM_FLAG_MAX == 10, "system flag max value");
+static_assert(SYSTEM_FLAG_PUBLISH_VITALS_DELTA == 10, "system flag value");
+static_assert(SYSTEM_FLAG_DEFERRED_INIT == 11, "system flag value");
+static_assert(SYSTEM_FLAG_OTA_BACKGROUND == 12, "system flag value");
+static_assert(SYSTEM_FLAG_MAX == 13, "system flag max value");
 
 volatile uint8_t systemFlags[SYSTEM_FLAG_MAX] = {
     0, 1, // OTA updates pending/enabled
@@ -85,6 +91,9 @@ volatile uint8_t systemFlags[SYSTEM_FLAG_MAX] = {
     1,    // SYSTEM_FLAG_RESET_NETWORK_ON_CLOUD_ERRORS
     0,    // UNUSED (SYSTEM_FLAG_PM_DETECTION)
 	0,	  // SYSTEM_FLAG_OTA_UPDATE_FORCED
+    0,    // SYSTEM_FLAG_PUBLISH_VITALS_DELTA
+    0,    // SYSTEM_FLAG_DEFERRED_INIT
+    0,    // SYSTEM_FLAG_OTA_BACKGROUND
 };
 
 const uint16_t SAFE_MODE_LISTEN = 0x5A1B;
@@ -231,7 +240,7 @@ bool system_fileTransfer(system_file_transfer_t* tx, void* reserved)
 
     if (NULL != Ymodem_Serial_Flash_Update_Handler)
     {
-        status = Ymodem_Serial_Flash_Update_Handler(serialObj, tx->descriptor, NULL);
+        status = Ymodem_Serial_Flash_Update_Handler(serialObj, tx->descriptor, tx);
         SPARK_FLASH_UPDATE = 0;
         TimingFlashUpdateTimeout = 0;
 
@@ -321,6 +330,11 @@ int Spark_Prepare_For_Firmware_Update(FileTransfer::Descriptor& file, uint32_t f
     return result;
 }
 
+bool system_update_blocks_application()
+{
+    return SPARK_FLASH_UPDATE && !systemFlags[SYSTEM_FLAG_OTA_BACKGROUND];
+}
+
 void system_pending_shutdown()
 {
     uint8_t was_set = false;
@@ -341,6 +355,9 @@ void system_shutdown_if_enabled(void* data=nullptr)
     // shutdown if user initiated poweroff or system reset is allowed
     if (canShutdown())
     {
+        // Don't lose the events that have not been written to the filesystem yet
+        spark_publish_queue_flush(nullptr);
+        HAL_EEPROM_Flush(nullptr);
         if (SYSTEM_POWEROFF) {              // shutdown network module too.
             system_sleep(SLEEP_MODE_SOFTPOWEROFF, 0, 0, NULL);
         }
@@ -438,6 +455,10 @@ protected:
 		return fn(data, (const uint8_t*)&value, sizeof(value));
 	}
 
+    inline bool writeBytes(const uint8_t* buf, size_t size) {
+        return fn(data, buf, size);
+    }
+
 public:
 
     AppendBase(appender_fn fn, void* data) {
@@ -470,6 +491,32 @@ public:
     		return writeDirect(value);
     }
 
+    /**
+     * Writes an unsigned integer as a base 128 varint: 7 bits per byte, least significant group
+     * first, the high bit is set in all bytes but the last one.
+     */
+    bool write_varint(uint32_t value) {
+        uint8_t buf[5];
+        size_t n = 0;
+        do {
+            uint8_t b = value & 0x7f;
+            value >>= 7;
+            if (value) {
+                b |= 0x80;
+            }
+            buf[n++] = b;
+        } while (value);
+        return writeBytes(buf, n);
+    }
+
+    /**
+     * Writes a signed integer as a zigzag-encoded varint, so that small negative values are
+     * also encoded in few bytes.
+     */
+    bool write_varint(int32_t value) {
+        return write_varint((uint32_t(value) << 1) ^ uint32_t(value >> 31));
+    }
+
 };
 
 
@@ -515,6 +562,11 @@ public:
         return write(itoa(value, buf, 10));
     }
 
+    bool write_unsigned(unsigned value) {
+        char buf[11];
+        return write(utoa(value, buf, 10));
+    }
+
     inline bool write(char c) {
     		return super::write(c);
     }
@@ -752,6 +804,14 @@ protected:
 	        }
 	        break;
 	    }
+	    case DIAG_TYPE_HISTOGRAM: {
+	        diag_histogram hist = {};
+	        const int ret = AbstractHistogramDiagnosticData::get(src, hist);
+	        if ((ret == 0 && !fmt.formatSourceHistogram(src, hist)) || (ret != 0 && !fmt.formatSourceError(src, ret))) {
+	            return SYSTEM_ERROR_TOO_LARGE;
+	        }
+	        break;
+	    }
 	    default:
 	        return SYSTEM_ERROR_NOT_SUPPORTED;
 	    }
@@ -827,21 +887,106 @@ public:
 	inline bool formatSourceInt(const diag_source* src, AbstractIntegerDiagnosticData::IntType val) {
 		return json.write_value(src->name, val);
 	}
+
+	bool formatSourceHistogram(const diag_source* src, const diag_histogram& hist) {
+		// Trailing empty buckets are omitted
+		size_t n = AbstractHistogramDiagnosticData::BUCKET_COUNT;
+		while (n > 0 && !hist.buckets[n - 1]) {
+			--n;
+		}
+		bool ok = json.write_attribute(src->name) &&
+				json.write('{') &&
+				json.write_attribute("sum") &&
+				json.write_unsigned(hist.sum) &&
+				json.write(',') &&
+				json.write_attribute("b") &&
+				json.write('[');
+		for (size_t i = 0; ok && i < n; ++i) {
+			ok = (!i || json.write(',')) && json.write_unsigned(hist.buckets[i]);
+		}
+		return ok && json.write(']') && json.write('}') && json.next();
+	}
 };
 
 
+/**
+ * Values of the diagnostic sources as of the last binary document. Used to skip unchanged
+ * sources in delta documents.
+ */
+class DiagnosticsBaseline {
+public:
+	/**
+	 * Stores the value of a source and returns true if it differs from the stored one, or if the
+	 * source wasn't seen before.
+	 */
+	bool update(uint16_t id, int32_t value, bool error) {
+		auto it = std::lower_bound(entries_.begin(), entries_.end(), id, [](const Entry& e, uint16_t id) {
+			return e.id < id;
+		});
+		if (it != entries_.end() && it->id == id) {
+			if (it->value == value && it->error == error) {
+				return false;
+			}
+			it->value = value;
+			it->error = error;
+			return true;
+		}
+		// Failing to allocate the entry only means that the source will be sent every time
+		entries_.insert(it - entries_.begin(), Entry{ id, error, value });
+		return true;
+	}
+
+private:
+	struct Entry {
+		uint16_t id;
+		bool error;
+		int32_t value;
+	};
+
+	spark::Vector<Entry> entries_;
+};
+
+DiagnosticsBaseline g_diagBaseline;
+
+/**
+ * The full binary format is a header of two uint16 values, the sizes of the id and value fields,
+ * followed by one (id, value) pair per integer source. Errors are sent with the top bit of the id
+ * set. Histograms can't be represented in this format and are omitted.
+ *
+ * The delta format has no header and only contains the sources that changed since the last
+ * binary document. Each entry starts with a varint of (id << 2 | kind):
+ * - kind 0: an integer value, followed by a zigzag-encoded varint;
+ * - kind 1: an error, followed by the error code as a zigzag-encoded varint;
+ * - kind 2: a histogram, followed by varints of the sum of the samples, the number of buckets
+ *   (trailing empty buckets are omitted) and the counter of each bucket.
+ * Typical integer sources take 2-3 bytes instead of 6.
+ */
 class BinaryDiagnosticsFormatter : public AbstractDiagnosticsFormatter<BinaryDiagnosticsFormatter> {
 
 	AppendData& data;
+	const bool delta;
 
 	using value = AbstractIntegerDiagnosticData::IntType;
 	using id = typeof(diag_source::id);
 
+	enum Kind {
+		KIND_INT = 0,
+		KIND_ERROR = 1,
+		KIND_HISTOGRAM = 2
+	};
+
+	inline bool writeTag(const diag_source* src, Kind kind) {
+		return data.write_varint(uint32_t(src->id) << 2 | kind);
+	}
+
 public:
-	BinaryDiagnosticsFormatter(AppendData& appender_) : data(appender_) {}
+	BinaryDiagnosticsFormatter(AppendData& appender_, bool delta_) : data(appender_), delta(delta_) {}
 
 
 	inline bool openDocument() {
+		if (delta) {
+			return true;
+		}
 		return data.write(uint16_t(sizeof(id))) && data.write(uint16_t(sizeof(value)));
 	}
 
@@ -854,17 +999,46 @@ public:
 	 */
 	bool formatSourceError(const diag_source* src, int error) {
 		static_assert(sizeof(src->id)==2, "expected diagnostic id to be 16-bits");
+		if (!g_diagBaseline.update(src->id, error, true) && delta) {
+			return true;
+		}
+		if (delta) {
+			return writeTag(src, KIND_ERROR) && data.write_varint(int32_t(error));
+		}
 		return data.write(decltype(src->id)(src->id | 1<<15)) && data.write(int32_t(error));
 	}
 
 	inline bool isSourceOk(const diag_source* src) {
-	    return true;
+	    return delta || src->type == DIAG_TYPE_INT;
 	}
 
 	inline bool formatSourceInt(const diag_source* src, AbstractIntegerDiagnosticData::IntType val) {
+		static_assert(sizeof(val)==4, "expected diagnostic value to be 32-bits");
+		if (!g_diagBaseline.update(src->id, val, false) && delta) {
+			return true;
+		}
+		if (delta) {
+			return writeTag(src, KIND_INT) && data.write_varint(int32_t(val));
+		}
 		return data.write(src->id) && data.write(val);
 	}
 
+	bool formatSourceHistogram(const diag_source* src, const diag_histogram& hist) {
+		// A histogram changes whenever a sample is added, which is tracked by its sample count
+		if (!g_diagBaseline.update(src->id, AbstractHistogramDiagnosticData::count(hist), false)) {
+			return true;
+		}
+		uint32_t n = AbstractHistogramDiagnosticData::BUCKET_COUNT;
+		while (n > 0 && !hist.buckets[n - 1]) {
+			--n;
+		}
+		bool ok = writeTag(src, KIND_HISTOGRAM) && data.write_varint(hist.sum) && data.write_varint(n);
+		for (uint32_t i = 0; ok && i < n; ++i) {
+			ok = data.write_varint(hist.buckets[i]);
+		}
+		return ok;
+	}
+
 };
 
 
@@ -874,9 +1048,9 @@ public:
 
 int system_format_diag_data(const uint16_t* id, size_t count, unsigned flags, appender_fn append, void* append_data,
         void* reserved) {
-	if (flags & 1) {
+	if (flags & (SYSTEM_FORMAT_DIAG_FLAG_BINARY | SYSTEM_FORMAT_DIAG_FLAG_DELTA)) {
 		AppendData data(append, append_data);
-		BinaryDiagnosticsFormatter fmt(data);
+		BinaryDiagnosticsFormatter fmt(data, flags & SYSTEM_FORMAT_DIAG_FLAG_DELTA);
 	    return fmt.format(id, count, flags);
 	}
 	else {
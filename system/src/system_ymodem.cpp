@@ -66,6 +66,33 @@ static void Serial_PrintCharArray(Stream *serialObj, char *s)
     serialObj->print(s);
 }
 
+/**
+ * @brief  Calculate a 16-bit checksum using the CRC-CCITT (XMODEM) algorithm
+ * @param  data
+ * @param  size
+ * @retval checksum
+ */
+static uint16_t calc_crc16(const uint8_t* data, uint32_t size)
+{
+    uint16_t crc = 0;
+    for (uint32_t i = 0; i < size; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t j = 0; j < 8; j++)
+        {
+            if (crc & 0x8000)
+            {
+                crc = (crc << 1) ^ 0x1021;
+            }
+            else
+            {
+                crc <<= 1;
+            }
+        }
+    }
+    return crc;
+}
+
 /**
  * @brief  Receive byte from sender
  * @param  c: Character
@@ -147,6 +174,11 @@ int32_t YModem::receive_packet(uint8_t *data, int32_t& length, uint32_t timeout)
     {
         return -1;
     }
+    const uint16_t crc = ((uint16_t)data[packet_size + PACKET_HEADER] << 8) | data[packet_size + PACKET_HEADER + 1];
+    if (crc != calc_crc16(data + PACKET_HEADER, packet_size))
+    {
+        return -1;
+    }
     length = packet_size;
     return 0;
 }
@@ -185,12 +217,21 @@ int32_t YModem::handle_packet(uint8_t* packet_data, int32_t packet_length,
         /* End of transmission */
     case 0:
         send_byte(ACK);
+        /* Request the header of the next file in the batch */
+        send_start_request();
         file_done = 1;
         return 1;
     }
 
     if ((packet_data[PACKET_SEQNO_INDEX] & 0xff) != (packets_received & 0xff))
     {
+        if (streaming)
+        {
+            /* A lost packet can't be retransmitted in the streaming mode */
+            send_byte(CA);
+            send_byte(CA);
+            return 0;
+        }
         send_byte(NAK);
     }
     else
@@ -210,7 +251,7 @@ int32_t YModem::handle_packet(uint8_t* packet_data, int32_t packet_length,
                 }
                 tx.chunk_address = tx.file_address;
                 send_byte(ACK);
-                send_byte(CRC16);
+                send_start_request();
             } /* Filename packet is empty, end session */
             else
             {
@@ -224,6 +265,13 @@ int32_t YModem::handle_packet(uint8_t* packet_data, int32_t packet_length,
         } /* Data packet */
         else
         {
+            /* Acknowledge the packet before writing it to flash, so that the sender transmits
+             * the next packet while the chunk is being saved. The received packet has been
+             * verified already, and if saving it fails the session is cancelled instead */
+            if (!streaming)
+            {
+                send_byte(ACK);
+            }
             tx.chunk_size = packet_length;
             if (Spark_Save_Firmware_Chunk(tx, packet_data + PACKET_HEADER, NULL))
             {
@@ -233,7 +281,6 @@ int32_t YModem::handle_packet(uint8_t* packet_data, int32_t packet_length,
                 return -2;
             }
             tx.chunk_address += tx.chunk_size;
-            send_byte(ACK);
         }
         packets_received++;
         session_begin = 1;
@@ -274,10 +321,17 @@ int32_t YModem::receive_file(FileTransfer::Descriptor& tx, YModem::file_desc_t&
                 break;
 
             default:
+                if (streaming && session_begin)
+                {
+                    /* Errors are not recoverable once the sender has started streaming */
+                    send_byte(CA);
+                    send_byte(CA);
+                    return 0;
+                }
                 if (session_begin >= 0)
                 {
                     errors++;
-                    send_byte(CRC16);
+                    send_start_request();
                 }
                 if (errors > MAX_ERRORS)
                 {
@@ -295,13 +349,17 @@ int32_t YModem::receive_file(FileTransfer::Descriptor& tx, YModem::file_desc_t&
 /**
  * @brief  Flash update via serial port using ymodem protocol
  * @param  serialObj (Possible values : &Serial, &Serial1 or &Serial2)
+ * @param  file Transfer descriptor
+ * @param  reserved Transfer options (system_file_transfer_t), or NULL
  * @retval true on success
  */
 bool Ymodem_Serial_Flash_Update(Stream *serialObj, FileTransfer::Descriptor& file, void* reserved)
 {
     bool result = false;
     YModem::file_desc_t desc;
-    YModem* ymodem = new YModem(*serialObj);
+    const auto options = static_cast<const system_file_transfer_t*>(reserved);
+    const bool streaming = options && (options->flags & SYSTEM_FILE_TRANSFER_FLAG_STREAMING);
+    YModem* ymodem = new YModem(*serialObj, streaming);
     int32_t size = ymodem->receive_file(file, desc);
     if (size > 0)
     {
@@ -49,7 +49,9 @@ enum ServiceRequestType {
     CHECK = 2,
     SEND = 3,
     RECV = 4,
-    RESET = 5
+    RESET = 5,
+    SEND_BULK = 6,
+    RECV_BULK = 7
 };
 
 // Encoder for the service reply data
@@ -192,12 +194,18 @@ particle::UsbControlRequestChannel::UsbControlRequestChannel(ControlRequestHandl
         ControlRequestChannel(handler),
         activeReqs_(nullptr),
         curReq_(nullptr),
+#if HAL_PLATFORM_USB_VENDOR_BULK
+        bulkReq_(nullptr),
+#endif
         activeReqCount_(0),
         lastReqId_(USB_REQUEST_INVALID_ID) {
     // Set HAL callbacks
     ATOMIC_BLOCK() {
         HAL_USB_Set_Vendor_Request_Callback(halVendorRequestCallback, this);
         HAL_USB_Set_Vendor_Request_State_Callback(halVendorRequestStateCallback, this);
+#if HAL_PLATFORM_USB_VENDOR_BULK
+        HAL_USB_Set_Vendor_Bulk_Callback(halVendorBulkCallback, this);
+#endif
     }
 }
 
@@ -205,6 +213,10 @@ particle::UsbControlRequestChannel::~UsbControlRequestChannel() {
     ATOMIC_BLOCK() {
         HAL_USB_Set_Vendor_Request_Callback(nullptr, nullptr);
         HAL_USB_Set_Vendor_Request_State_Callback(nullptr, nullptr);
+#if HAL_PLATFORM_USB_VENDOR_BULK
+        HAL_USB_Set_Vendor_Bulk_Callback(nullptr, nullptr);
+        HAL_USB_Vendor_Bulk_Cancel(nullptr);
+#endif
     }
 }
 
@@ -271,6 +283,12 @@ bool particle::UsbControlRequestChannel::processServiceRequest(HAL_USB_SetupRequ
         return processRecvRequest(halReq);
     case ServiceRequestType::RESET:
         return processResetRequest(halReq);
+#if HAL_PLATFORM_USB_VENDOR_BULK
+    case ServiceRequestType::SEND_BULK:
+        return processSendBulkRequest(halReq);
+    case ServiceRequestType::RECV_BULK:
+        return processRecvBulkRequest(halReq);
+#endif
     default:
         return false; // Unknown request type
     }
@@ -399,6 +417,11 @@ bool particle::UsbControlRequestChannel::processSendRequest(HAL_USB_SetupRequest
             req->offset + size > req->request_size) { // Unexpected size
         return false;
     }
+#if HAL_PLATFORM_USB_VENDOR_BULK
+    if (req == bulkReq_) {
+        return false; // The payload data is being received via the bulk endpoint
+    }
+#endif
     if (size <= MIN_WLENGTH) {
         // Use the internal buffer provided by the HAL
         if (!halReq->data) {
@@ -436,6 +459,11 @@ bool particle::UsbControlRequestChannel::processRecvRequest(HAL_USB_SetupRequest
             size == 0 || req->offset + size > req->reply_size) { // Unexpected size
         return false;
     }
+#if HAL_PLATFORM_USB_VENDOR_BULK
+    if (req == bulkReq_) {
+        return false; // The reply data is being sent via the bulk endpoint
+    }
+#endif
     if (size <= MIN_WLENGTH) {
         // Use the internal buffer provided by the HAL
         if (!halReq->data) {
@@ -481,6 +509,114 @@ bool particle::UsbControlRequestChannel::processResetRequest(HAL_USB_SetupReques
     return ServiceReply().status(ServiceReply::OK).encode(halReq);
 }
 
+#if HAL_PLATFORM_USB_VENDOR_BULK
+
+// Note: This method is called from an ISR
+bool particle::UsbControlRequestChannel::processSendBulkRequest(HAL_USB_SetupRequest* halReq) {
+    if (halReq->wLength != 0 || bulkReq_) {
+        return false; // Unexpected data stage, or the bulk endpoints are busy
+    }
+    const uint16_t id = halReq->wIndex; // Request ID
+    Request* req = activeReqs_;
+    for (; req; req = req->next) {
+        if (req->id == id) {
+            break;
+        }
+    }
+    if (!req || // Request not found
+            req->state != RequestState::RECV_PAYLOAD || // Invalid request state
+            req->offset >= req->request_size) { // No payload data left to receive
+        return false;
+    }
+    // Receive the rest of the payload data via the bulk OUT endpoint
+    if (HAL_USB_Vendor_Bulk_Receive((uint8_t*)req->request_data + req->offset, req->request_size - req->offset,
+            nullptr) != 0) {
+        return false;
+    }
+    bulkReq_ = req;
+    return true;
+}
+
+// Note: This method is called from an ISR
+bool particle::UsbControlRequestChannel::processRecvBulkRequest(HAL_USB_SetupRequest* halReq) {
+    if (halReq->wLength != 0 || bulkReq_) {
+        return false; // Unexpected data stage, or the bulk endpoints are busy
+    }
+    const uint16_t id = halReq->wIndex; // Request ID
+    Request* req = activeReqs_;
+    for (; req; req = req->next) {
+        if (req->id == id) {
+            break;
+        }
+    }
+    if (!req || // Request not found
+            req->state != RequestState::DONE || // Invalid request state
+            req->offset >= req->reply_size) { // No reply data left to send
+        return false;
+    }
+    // Send the rest of the reply data via the bulk IN endpoint. The data is sent straight from
+    // the reply buffer, so there's no need in a round trip per chunk of data as with RECV requests
+    if (HAL_USB_Vendor_Bulk_Send((const uint8_t*)req->reply_data + req->offset, req->reply_size - req->offset,
+            nullptr) != 0) {
+        return false;
+    }
+    bulkReq_ = req;
+    return true;
+}
+
+// Note: This method is called from an ISR
+void particle::UsbControlRequestChannel::processBulkEvent(HAL_USB_Vendor_Bulk_Event event, size_t size) {
+    const auto req = bulkReq_;
+    if (!req) {
+        return; // The request has been cancelled
+    }
+    bulkReq_ = nullptr;
+    switch (event) {
+    case HAL_USB_VENDOR_BULK_EVENT_RX_COMPLETED: {
+        if (req->state != RequestState::RECV_PAYLOAD) {
+            break;
+        }
+        if (req->offset + size != req->request_size) {
+            // The host has sent a short transfer. Keep the request in the current state so
+            // that the host can retry sending the payload data
+            break;
+        }
+        // Invoke the request handler
+        req->task.func = invokeRequestHandler;
+        SystemISRTaskQueue.enqueue(&req->task);
+        req->offset = 0;
+        req->state = RequestState::PENDING;
+        break;
+    }
+    case HAL_USB_VENDOR_BULK_EVENT_TX_COMPLETED: {
+        if (req->state != RequestState::DONE) {
+            break;
+        }
+        req->offset = req->reply_size;
+        if (curReq_ == req) {
+            curReq_ = nullptr;
+        }
+        // Set a result code that will be passed to the request completion handler
+        req->result = SYSTEM_ERROR_NONE;
+        finishActiveRequest(req);
+        break;
+    }
+    default:
+        // The host can retry the transfer with another SEND_BULK or RECV_BULK request
+        break;
+    }
+}
+
+// Note: This method is called from an ISR
+void particle::UsbControlRequestChannel::cancelBulkTransfer(Request* req) {
+    if (bulkReq_ == req) {
+        bulkReq_ = nullptr;
+        HAL_USB_Vendor_Bulk_Cancel(nullptr);
+    }
+}
+
+#endif // HAL_PLATFORM_USB_VENDOR_BULK
+
 // Note: This method is called from an ISR
 bool particle::UsbControlRequestChannel::processVendorRequest(HAL_USB_SetupRequest* req) {
     // In case of a "raw" USB vendor request, the `bRequest` field should be set to the ASCII code
@@ -530,6 +666,10 @@ bool particle::UsbControlRequestChannel::processVendorRequest(HAL_USB_SetupReque
 
 // Note: This method is called from an ISR
 void particle::UsbControlRequestChannel::finishActiveRequest(Request* req) {
+#if HAL_PLATFORM_USB_VENDOR_BULK
+    // Make sure the USB stack no longer references the request data
+    cancelBulkTransfer(req);
+#endif
     // Update list of active requests
     if (req->next) {
         req->next->prev = req->prev;
@@ -685,4 +825,14 @@ uint8_t particle::UsbControlRequestChannel::halVendorRequestStateCallback(HAL_US
     return 0;
 }
 
+#if HAL_PLATFORM_USB_VENDOR_BULK
+
+// Note: This method is called from an ISR
+void particle::UsbControlRequestChannel::halVendorBulkCallback(HAL_USB_Vendor_Bulk_Event event, size_t size, void* data) {
+    const auto channel = static_cast<UsbControlRequestChannel*>(data);
+    channel->processBulkEvent(event, size);
+}
+
+#endif // HAL_PLATFORM_USB_VENDOR_BULK
+
 #endif // defined(USB_VENDOR_REQUEST_ENABLE)
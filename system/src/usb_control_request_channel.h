@@ -39,7 +39,14 @@ const size_t USB_REQUEST_MAX_POOLED_BUFFER_SIZE = 64;
 // Invalid request ID
 const uint16_t USB_REQUEST_INVALID_ID = 0;
 
-// Class implementing the asynchronous USB request protocol
+// Class implementing the asynchronous USB request protocol.
+//
+// On platforms with HAL_PLATFORM_USB_VENDOR_BULK, the payload and reply data of a request can
+// also be transferred via the bulk endpoints of the control interface, which is considerably
+// faster for large payloads than a series of control transfers. The host issues a SEND_BULK or
+// RECV_BULK service request without a data stage and then writes or reads the remaining payload
+// or reply data in a single bulk transfer. A stalled SEND_BULK or RECV_BULK request means that
+// the bulk endpoints are not available, and the host should fall back to SEND or RECV.
 class UsbControlRequestChannel: public ControlRequestChannel {
 public:
     explicit UsbControlRequestChannel(ControlRequestHandler* handler);
@@ -88,6 +95,9 @@ private:
 
     Request* activeReqs_; // List of active requests
     Request* curReq_; // A request currently being processed by the USB subsystem
+#if HAL_PLATFORM_USB_VENDOR_BULK
+    Request* bulkReq_; // A request whose data is being transferred via the bulk endpoints
+#endif
     uint16_t activeReqCount_; // Number of active requests
     uint16_t lastReqId_; // Last request ID
 
@@ -97,6 +107,12 @@ private:
     bool processSendRequest(HAL_USB_SetupRequest* halReq);
     bool processRecvRequest(HAL_USB_SetupRequest* halReq);
     bool processResetRequest(HAL_USB_SetupRequest* halReq);
+#if HAL_PLATFORM_USB_VENDOR_BULK
+    bool processSendBulkRequest(HAL_USB_SetupRequest* halReq);
+    bool processRecvBulkRequest(HAL_USB_SetupRequest* halReq);
+    void processBulkEvent(HAL_USB_Vendor_Bulk_Event event, size_t size);
+    void cancelBulkTransfer(Request* req);
+#endif
     bool processVendorRequest(HAL_USB_SetupRequest* halReq);
 
     void finishActiveRequest(Request* req);
@@ -108,6 +124,9 @@ private:
 
     static uint8_t halVendorRequestCallback(HAL_USB_SetupRequest* halReq, void* data);
     static uint8_t halVendorRequestStateCallback(HAL_USB_VendorRequestState state, void* data);
+#if HAL_PLATFORM_USB_VENDOR_BULK
+    static void halVendorBulkCallback(HAL_USB_Vendor_Bulk_Event event, size_t size, void* data);
+#endif
 };
 
 } // namespace particle
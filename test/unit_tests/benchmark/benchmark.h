@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+
+namespace particle { namespace test {
+
+/**
+ * Runs a function a fixed number of times and reports the time per call.
+ *
+ * The measurement is repeated several times and the fastest run is reported, which makes the
+ * results less sensitive to the scheduling noise of the host.
+ */
+class Benchmark {
+public:
+    static const unsigned DEFAULT_ITERATIONS = 100000;
+    static const unsigned DEFAULT_RUNS = 5;
+
+    explicit Benchmark(const char* name, unsigned iterations = DEFAULT_ITERATIONS, unsigned runs = DEFAULT_RUNS) :
+            name_(name),
+            iterations_(iterations),
+            runs_(runs) {
+    }
+
+    template<typename F>
+    double run(F fn) const {
+        double best = 0;
+        for (unsigned r = 0; r < runs_; ++r) {
+            const auto start = std::chrono::steady_clock::now();
+            for (unsigned i = 0; i < iterations_; ++i) {
+                fn(i);
+            }
+            const auto end = std::chrono::steady_clock::now();
+            const double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations_;
+            if (r == 0 || ns < best) {
+                best = ns;
+            }
+        }
+        std::printf("%-40s %12.1f ns/op\n", name_, best);
+        std::fflush(stdout);
+        return best;
+    }
+
+private:
+    const char* name_;
+    unsigned iterations_;
+    unsigned runs_;
+};
+
+/**
+ * Prevents the compiler from optimizing out a computation whose result is not used otherwise.
+ */
+template<typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} } // particle::test
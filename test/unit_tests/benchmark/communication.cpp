@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define CATCH_CONFIG_MAIN
+
+#include "benchmark.h"
+
+#include "coap.h"
+#include "messages.h"
+#include "subscriptions.h"
+#include "forward_message_channel.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstring>
+
+using namespace particle::protocol;
+using particle::test::Benchmark;
+using particle::test::doNotOptimize;
+
+namespace {
+
+unsigned handlerCalls = 0;
+
+void eventHandler(const char* name, const char* data) {
+    ++handlerCalls;
+}
+
+} // namespace
+
+TEST_CASE("Messages::event() encode") {
+    uint8_t buf[128];
+    Benchmark("Messages::event()").run([&](unsigned i) {
+        const size_t n = Messages::event(buf, i, "sensor/temperature", "21.5", 60, EventType::PUBLIC, true);
+        doNotOptimize(n);
+    });
+    const size_t n = Messages::event(buf, 0, "sensor/temperature", "21.5", 60, EventType::PUBLIC, true);
+    CoAPMessageView msg;
+    REQUIRE(msg.parse(buf, n));
+    REQUIRE(msg.payload_size() == 4);
+}
+
+TEST_CASE("CoAP message decode") {
+    uint8_t buf[128];
+    const size_t size = Messages::event(buf, 0x1234, "sensor/temperature", "21.5", 60, EventType::PUBLIC, true);
+    Benchmark("CoAPMessageView::parse()").run([&](unsigned) {
+        CoAPMessageView msg;
+        msg.parse(buf, size);
+        size_t optSize = 0;
+        auto it = msg.options();
+        while (it.next()) {
+            optSize += it.size();
+        }
+        doNotOptimize(optSize);
+        doNotOptimize(msg.payload());
+    });
+    Benchmark("CoAP::type(), code(), id()").run([&](unsigned) {
+        const auto type = CoAP::type(buf);
+        const auto code = CoAP::code(buf);
+        const auto id = CoAP::message_id(buf);
+        doNotOptimize(type);
+        doNotOptimize(code);
+        doNotOptimize(id);
+    });
+    CoAPMessageView msg;
+    REQUIRE(msg.parse(buf, size));
+    REQUIRE(msg.id() == 0x1234);
+}
+
+TEST_CASE("Subscriptions dispatch") {
+    Subscriptions subscriptions;
+    ForwardMessageChannel channel;
+    const char* const filters[] = { "", "temp", "humidity", "sensor/pressure", "sensor/temp", "alarm" };
+    static_assert(sizeof(filters) / sizeof(filters[0]) <= MAX_SUBSCRIPTIONS, "Too many subscriptions");
+    for (const auto filter: filters) {
+        REQUIRE(subscriptions.add_event_handler(filter, eventHandler, nullptr, SubscriptionScope::FIREHOSE,
+                nullptr) == NO_ERROR);
+    }
+    uint8_t event[128];
+    const size_t size = Messages::event(event, 0, "sensor/temperature", "21.5", 60, EventType::PUBLIC, false);
+    uint8_t buf[128];
+    handlerCalls = 0;
+    Benchmark("Subscriptions::handle_event()").run([&](unsigned) {
+        // The message is modified in place by the dispatcher
+        memcpy(buf, event, size);
+        Message message(buf, sizeof(buf) - 1, size);
+        subscriptions.handle_event(message, nullptr, channel);
+    });
+    // "" and "sensor/temp" match the event
+    REQUIRE(handlerCalls == 2 * Benchmark::DEFAULT_ITERATIONS * Benchmark::DEFAULT_RUNS);
+}
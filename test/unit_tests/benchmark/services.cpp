@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "benchmark.h"
+
+#include "ringbuffer.h"
+#include "simple_pool_allocator.h"
+
+#include <catch2/catch.hpp>
+
+using namespace particle;
+using particle::test::Benchmark;
+using particle::test::doNotOptimize;
+
+TEST_CASE("RingBuffer put/get") {
+    uint8_t storage[512];
+    services::RingBuffer<uint8_t> rb(storage, sizeof(storage));
+    Benchmark("RingBuffer::put(), get() 1 byte").run([&](unsigned i) {
+        uint8_t c = i;
+        rb.put(c);
+        rb.get(&c);
+        doNotOptimize(c);
+    });
+    uint8_t data[64] = {};
+    Benchmark("RingBuffer::put(), get() 64 bytes").run([&](unsigned) {
+        rb.put(data, sizeof(data));
+        rb.get(data, sizeof(data));
+        doNotOptimize(data);
+    });
+    REQUIRE(rb.data() == 0);
+}
+
+TEST_CASE("SimpleBasePool alloc/free") {
+    alignas(uintptr_t) static uint8_t storage[4096];
+    SimpleStaticPool pool(storage, sizeof(storage));
+    // Fragment the pool so that allocations go through the free list
+    void* blocks[16] = {};
+    for (unsigned i = 0; i < 16; ++i) {
+        blocks[i] = pool.alloc(32 + i * 8);
+        REQUIRE(blocks[i]);
+    }
+    for (unsigned i = 0; i < 16; i += 2) {
+        pool.free(blocks[i]);
+    }
+    Benchmark("SimpleBasePool::alloc(), free()").run([&](unsigned i) {
+        void* p = pool.alloc(32 + (i % 8) * 8);
+        doNotOptimize(p);
+        pool.free(p);
+    });
+    for (unsigned i = 1; i < 16; i += 2) {
+        pool.free(blocks[i]);
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "benchmark.h"
+
+#include "spark_wiring_json.h"
+#include "spark_wiring_logging.h"
+#include "spark_wiring_string.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstring>
+
+using namespace spark;
+using particle::test::Benchmark;
+using particle::test::doNotOptimize;
+
+TEST_CASE("JSONValue::parse()") {
+    const char json[] = "{\"id\":\"e00fce68\",\"ok\":true,\"temp\":21.5,\"tags\":[\"a\",\"b\",\"c\"],"
+            "\"nested\":{\"level\":3,\"name\":\"kitchen\"}}";
+    char buf[sizeof(json)];
+    Benchmark("JSONValue::parse()").run([&](unsigned) {
+        // The JSON data is modified in place by the parser
+        memcpy(buf, json, sizeof(json));
+        const auto v = JSONValue::parse(buf, sizeof(json) - 1);
+        doNotOptimize(v.isValid());
+    });
+    memcpy(buf, json, sizeof(json));
+    const auto v = JSONValue::parse(buf, sizeof(json) - 1);
+    REQUIRE(v.isObject());
+}
+
+TEST_CASE("LogFilter::level()") {
+    const detail::LogFilter filter(LOG_LEVEL_WARN, {
+        { "app", LOG_LEVEL_INFO },
+        { "app.network", LOG_LEVEL_TRACE },
+        { "comm", LOG_LEVEL_ERROR },
+        { "comm.protocol", LOG_LEVEL_INFO },
+        { "system", LOG_LEVEL_ALL },
+        { "hal.ble", LOG_LEVEL_NONE }
+    });
+    Benchmark("LogFilter::level() matching category").run([&](unsigned) {
+        doNotOptimize(filter.level("app.network.tcp"));
+    });
+    Benchmark("LogFilter::level() default category").run([&](unsigned) {
+        doNotOptimize(filter.level("wiring.i2c"));
+    });
+    REQUIRE(filter.level("app.network.tcp") == LOG_LEVEL_TRACE);
+    REQUIRE(filter.level("wiring.i2c") == LOG_LEVEL_WARN);
+}
+
+TEST_CASE("String concatenation") {
+    Benchmark("String += const char*", 10000).run([&](unsigned) {
+        String s;
+        for (int i = 0; i < 16; ++i) {
+            s += "abcd";
+        }
+        doNotOptimize(s.length());
+    });
+    Benchmark("String + int", 10000).run([&](unsigned i) {
+        const String s = String("value=") + (int)i + ", unit=" + "C";
+        doNotOptimize(s.length());
+    });
+    String s;
+    for (int i = 0; i < 16; ++i) {
+        s += "abcd";
+    }
+    REQUIRE(s.length() == 64);
+}
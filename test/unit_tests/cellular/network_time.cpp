@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "network/ncp/cellular/cellular_network_time.h"
+
+#include "catch2/catch.hpp"
+
+using namespace particle;
+
+TEST_CASE("parseNetworkTime()", "[cellular]") {
+    time_t t = 0;
+    SECTION("parses the time in UTC") {
+        CHECK(parseNetworkTime("20/03/15,10:20:30+00", &t));
+        CHECK(t == 1584267630); // 2020-03-15 10:20:30 UTC
+    }
+    SECTION("converts the local time to UTC") {
+        CHECK(parseNetworkTime("20/03/15,12:20:30+08", &t)); // UTC+2
+        CHECK(t == 1584267630);
+        CHECK(parseNetworkTime("20/03/15,06:05:30-17", &t)); // UTC-4:15
+        CHECK(t == 1584267630);
+        CHECK(parseNetworkTime("21/01/01,00:30:00+04", &t)); // Crosses a year boundary
+        CHECK(t == 1609457400); // 2020-12-31 23:30:00 UTC
+    }
+    SECTION("handles leap days") {
+        CHECK(parseNetworkTime("24/02/29,00:00:00+00", &t));
+        CHECK(t == 1709164800);
+        CHECK(parseNetworkTime("24/03/01,00:00:00+00", &t));
+        CHECK(t == 1709251200);
+    }
+    SECTION("rejects the default time of the modem") {
+        CHECK_FALSE(parseNetworkTime("80/01/06,00:00:41+00", &t));
+        CHECK_FALSE(parseNetworkTime("04/01/01,00:00:00+00", &t));
+    }
+    SECTION("rejects malformed strings") {
+        CHECK_FALSE(parseNetworkTime("", &t));
+        CHECK_FALSE(parseNetworkTime("20/03/15,10:20:30", &t));
+        CHECK_FALSE(parseNetworkTime("20/13/15,10:20:30+00", &t));
+        CHECK_FALSE(parseNetworkTime("20/03/15,24:20:30+00", &t));
+        CHECK_FALSE(parseNetworkTime("20/03/15,10:20:30+00x", &t));
+        CHECK_FALSE(parseNetworkTime("20/03/15 10:20:30+00", &t));
+    }
+}
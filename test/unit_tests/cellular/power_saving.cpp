@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "network/ncp/cellular/cellular_power_saving.h"
+
+#include "catch2/catch.hpp"
+
+using namespace particle;
+
+TEST_CASE("encodePeriodicTau()", "[cellular]") {
+    SECTION("uses the smallest unit that can represent the value") {
+        CHECK(encodePeriodicTau(0) == 0x60); // 0 * 2s
+        CHECK(encodePeriodicTau(10) == 0x65); // 5 * 2s
+        CHECK(encodePeriodicTau(900) == 0x9e); // 30 * 30s
+        CHECK(encodePeriodicTau(30 * 60) == 0xbe); // 30 * 1min
+        CHECK(encodePeriodicTau(4 * 3600) == 0x18); // 24 * 10min
+        CHECK(encodePeriodicTau(24 * 3600) == 0x38); // 24 * 1h
+        CHECK(encodePeriodicTau(100 * 3600) == 0x4a); // 10 * 10h
+    }
+    SECTION("rounds to the nearest value") {
+        CHECK(encodePeriodicTau(61) == 0x7f); // 31 * 2s
+        CHECK(encodePeriodicTau(63) == 0x82); // 2 * 30s
+        CHECK(encodePeriodicTau(1000) == 0xa0 + 17); // 17 * 1min
+    }
+    SECTION("saturates at the maximum value") {
+        CHECK(encodePeriodicTau(0xffffffff) == 0xdf); // 31 * 320h
+    }
+}
+
+TEST_CASE("decodePeriodicTau()", "[cellular]") {
+    uint32_t sec = 0;
+    CHECK(decodePeriodicTau(0x9e, &sec));
+    CHECK(sec == 900);
+    CHECK(decodePeriodicTau(0x18, &sec));
+    CHECK(sec == 4 * 3600);
+    CHECK(decodePeriodicTau(0xdf, &sec));
+    CHECK(sec == 31 * 1152000);
+    CHECK_FALSE(decodePeriodicTau(0xe0, &sec)); // Deactivated
+}
+
+TEST_CASE("encodeActiveTime()", "[cellular]") {
+    CHECK(encodeActiveTime(0) == 0x00);
+    CHECK(encodeActiveTime(10) == 0x05); // 5 * 2s
+    CHECK(encodeActiveTime(120) == 0x22); // 2 * 1min
+    CHECK(encodeActiveTime(3600) == 0x4a); // 10 * 6min
+    CHECK(encodeActiveTime(0xffffffff) == 0x5f); // 31 * 6min
+}
+
+TEST_CASE("decodeActiveTime()", "[cellular]") {
+    uint32_t sec = 0;
+    CHECK(decodeActiveTime(0x05, &sec));
+    CHECK(sec == 10);
+    CHECK(decodeActiveTime(0x22, &sec));
+    CHECK(sec == 120);
+    CHECK(decodeActiveTime(0x4a, &sec));
+    CHECK(sec == 3600);
+    CHECK(decodeActiveTime(0x62, &sec)); // Unknown units are interpreted as minutes
+    CHECK(sec == 120);
+    CHECK_FALSE(decodeActiveTime(0xe0, &sec)); // Deactivated
+}
+
+TEST_CASE("encodeEdrxCycle()", "[cellular]") {
+    CHECK(encodeEdrxCycle(0) == 0);
+    CHECK(encodeEdrxCycle(5120) == 0);
+    CHECK(encodeEdrxCycle(20000) == 2);
+    CHECK(encodeEdrxCycle(81920) == 5);
+    CHECK(encodeEdrxCycle(300000) == 10);
+    CHECK(encodeEdrxCycle(0xffffffff) == 15);
+    for (uint8_t i = 0; i < 16; ++i) {
+        CHECK(encodeEdrxCycle(decodeEdrxCycle(i)) == i);
+    }
+}
+
+TEST_CASE("formatTimerBits()", "[cellular]") {
+    char buf[9] = {};
+    formatTimerBits(0x9e, 8, buf);
+    CHECK(std::string(buf) == "10011110");
+    formatTimerBits(0x02, 4, buf);
+    CHECK(std::string(buf) == "0010");
+}
+
+TEST_CASE("parseTimerBits()", "[cellular]") {
+    uint8_t val = 0;
+    CHECK(parseTimerBits("10011110", 8, &val));
+    CHECK(val == 0x9e);
+    CHECK(parseTimerBits("0010", 4, &val));
+    CHECK(val == 0x02);
+    CHECK_FALSE(parseTimerBits("0012", 4, &val));
+    CHECK_FALSE(parseTimerBits("00100", 4, &val));
+    CHECK_FALSE(parseTimerBits("001", 4, &val));
+}
+
+TEST_CASE("parseCeregTimers()", "[cellular]") {
+    uint8_t activeTime = 0, tau = 0;
+    SECTION("parses a response") {
+        CHECK(parseCeregTimers("+CEREG: 4,1,\"A1B2\",\"01A2B3C4\",7,,,\"00000101\",\"00011000\"", &activeTime, &tau));
+        CHECK(activeTime == 0x05);
+        CHECK(tau == 0x18);
+    }
+    SECTION("parses a URC") {
+        CHECK(parseCeregTimers("+CEREG: 1,\"A1B2\",\"01A2B3C4\",7,,,\"00100010\",\"10011110\"", &activeTime, &tau));
+        CHECK(activeTime == 0x22);
+        CHECK(tau == 0x9e);
+    }
+    SECTION("ignores lines without the timers") {
+        CHECK_FALSE(parseCeregTimers("+CEREG: 2,1,\"A1B2\",\"01011010\",7", &activeTime, &tau));
+        CHECK_FALSE(parseCeregTimers("+CEREG: 1", &activeTime, &tau));
+        CHECK_FALSE(parseCeregTimers("+CEREG: 4,1,\"A1B2\",\"01A2B3C4\",7,,,,", &activeTime, &tau));
+    }
+}
@@ -26,13 +26,17 @@
 
 #include "mock/mock_types.h"
 #include "system_publish_vitals.h"
+#include "system_update.h"
 
 bool spark_cloud_flag_connected_called;
 int spark_cloud_flag_connected_result;
 
 bool spark_protocol_post_description_called;
+int spark_protocol_post_description_flags;
 int spark_protocol_post_description_result;
 
+uint8_t system_flag_publish_vitals_delta;
+
 ISRTaskQueue SystemISRTaskQueue;
 
 void ISRTaskQueue::enqueue(ISRTaskQueue::Task*)
@@ -51,9 +55,10 @@ extern "C"
         return nullptr;
     }
 
-    int spark_protocol_post_description(ProtocolFacade*, int, void*)
+    int spark_protocol_post_description(ProtocolFacade*, int desc_flags, void*)
     {
         spark_protocol_post_description_called = true;
+        spark_protocol_post_description_flags = desc_flags;
         return spark_protocol_post_description_result;
     }
 
@@ -63,6 +68,16 @@ extern "C"
     }
 }
 
+int system_get_flag(system_flag_t flag, uint8_t* value, void*)
+{
+    if (flag != SYSTEM_FLAG_PUBLISH_VITALS_DELTA)
+    {
+        return -1;
+    }
+    *value = system_flag_publish_vitals_delta;
+    return 0;
+}
+
 // ASSUMPTION!!! - Period "getter" method works correctly - without being testing.
 
 TEST_CASE("Construction", "[VitalsPublisher::VitalsPublisher]")
@@ -377,4 +392,47 @@ TEST_CASE("Publishing vitals", "[VitalsPublisher::publish]")
             }
         }
     }
+
+    SECTION("Delta encoding")
+    {
+        extern int spark_cloud_flag_connected_result;
+        extern int spark_protocol_post_description_flags;
+        extern int spark_protocol_post_description_result;
+        extern uint8_t system_flag_publish_vitals_delta;
+
+        GIVEN("A cloud connected VitalsPublisher")
+        {
+            spark_cloud_flag_connected_result = true;
+            spark_protocol_post_description_flags = 0;
+            spark_protocol_post_description_result = SYSTEM_ERROR_NONE;
+
+            particle::system::VitalsPublisher<particle::mock_type::Timer> vp;
+
+            WHEN("SYSTEM_FLAG_PUBLISH_VITALS_DELTA is not set")
+            {
+                system_flag_publish_vitals_delta = 0;
+                vp.publish();
+
+                THEN("A complete set of metrics is requested")
+                {
+                    CHECK(particle::protocol::DESCRIBE_METRICS ==
+                          spark_protocol_post_description_flags);
+                }
+            }
+
+            WHEN("SYSTEM_FLAG_PUBLISH_VITALS_DELTA is set")
+            {
+                system_flag_publish_vitals_delta = 1;
+                vp.publish();
+
+                THEN("Delta-encoded metrics are requested")
+                {
+                    CHECK((particle::protocol::DESCRIBE_METRICS |
+                           particle::protocol::DESCRIBE_METRICS_DELTA) ==
+                          spark_protocol_post_description_flags);
+                }
+                system_flag_publish_vitals_delta = 0;
+            }
+        }
+    }
 }
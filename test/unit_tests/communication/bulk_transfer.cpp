@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bulk_transfer.h"
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace particle::protocol;
+using particle::CompletionHandler;
+
+namespace {
+
+const token_t TOKEN = 0x42;
+
+// Records the sent messages and assigns them consecutive message IDs
+class BulkChannel: public MessageChannel {
+public:
+	std::vector<std::string> sent;
+	message_id_t next_id = 1;
+
+	bool is_unreliable() override { return false; }
+	ProtocolError establish(uint32_t& flags, uint32_t app_state_crc) override { return NO_ERROR; }
+	ProtocolError create(Message& msg, size_t size) override
+	{
+		msg.set_buffer(buf, sizeof(buf));
+		return NO_ERROR;
+	}
+	ProtocolError response(Message& original, Message& response, size_t required) override { return NO_ERROR; }
+	ProtocolError notify_established() override { return NO_ERROR; }
+	void notify_client_messages_processed() override {}
+	ProtocolError receive(Message& msg) override { return NO_ERROR; }
+	ProtocolError command(Command cmd, void* arg) override { return NO_ERROR; }
+
+	ProtocolError send(Message& msg) override
+	{
+		msg.buf()[2] = next_id >> 8;
+		msg.buf()[3] = next_id & 0xff;
+		++next_id;
+		msg.decode_id();
+		sent.push_back(std::string((const char*)msg.buf(), msg.length()));
+		return NO_ERROR;
+	}
+
+	// Offset of a sent segment, or -1 if the message is not a segment
+	long segment_offset(size_t index) const
+	{
+		const std::string& m = sent.at(index);
+		if (m.size() < 12 || (uint8_t)m[1] != CoAPCode::POST || m[6] != 'B' || (uint8_t)m[0] >> 4 != 0x05) {
+			return -1;
+		}
+		return ((long)(uint8_t)m[8] << 24) | ((uint8_t)m[9] << 16) | ((uint8_t)m[10] << 8) | (uint8_t)m[11];
+	}
+
+private:
+	uint8_t buf[64];
+};
+
+int result = 1;
+
+void transfer_complete(int error, const void* data, void* callback_data, void* reserved)
+{
+	result = error;
+}
+
+int read_data(size_t offset, uint8_t* buf, size_t size, void* data)
+{
+	for (size_t i = 0; i < size; ++i) {
+		buf[i] = (offset + i) & 0xff;
+	}
+	return size;
+}
+
+// Piggybacked response to the request opening the transfer
+std::vector<uint8_t> open_response(message_id_t id, CoAPCode::Enum code, uint8_t window, uint16_t segment_size)
+{
+	return { 0x60, (uint8_t)code, (uint8_t)(id >> 8), (uint8_t)(id & 0xff), 0xff, window,
+			(uint8_t)(segment_size >> 8), (uint8_t)(segment_size & 0xff) };
+}
+
+// Progress report sent by the server
+std::vector<uint8_t> ack(uint32_t offset)
+{
+	return { 0x51, CoAPCode::POST, 0x12, 0x34, TOKEN, 0xb1, 'b', 0xff,
+			(uint8_t)(offset >> 24), (uint8_t)(offset >> 16), (uint8_t)(offset >> 8), (uint8_t)offset };
+}
+
+void receive_ack(BulkTransfer& transfer, BulkChannel& channel, uint32_t offset, system_tick_t millis)
+{
+	auto data = ack(offset);
+	Message message(data.data(), data.size(), data.size());
+	REQUIRE(transfer.handle_ack(message, channel, millis) == NO_ERROR);
+}
+
+bool receive_reply(BulkTransfer& transfer, const std::vector<uint8_t>& data, system_tick_t millis)
+{
+	CoAPMessageView msg;
+	msg.parse(data.data(), data.size());
+	return transfer.handle_reply(msg, millis);
+}
+
+} // namespace
+
+SCENARIO("sending data with a bulk transfer")
+{
+	GIVEN("a transfer of 100 bytes")
+	{
+		result = 1;
+		BulkChannel channel;
+		BulkTransfer transfer;
+		REQUIRE(transfer.begin(channel, TOKEN, "log", 100, read_data, nullptr,
+				CompletionHandler(transfer_complete, nullptr), 0) == NO_ERROR);
+		REQUIRE(transfer.is_active());
+		REQUIRE(channel.sent.size() == 1);
+		const std::string& open = channel.sent[0];
+		REQUIRE((uint8_t)open[0] == 0x41); // CON, token of 1 byte
+		REQUIRE(open[6] == 'B');
+		REQUIRE(open.substr(8) == std::string("\x01\x00\x00\x00\x64log", 8));
+
+		WHEN("the server doesn't support bulk transfers")
+		{
+			REQUIRE(receive_reply(transfer, open_response(1, CoAPCode::NOT_FOUND, 0, 0), 10));
+			THEN("the transfer fails")
+			{
+				REQUIRE_FALSE(transfer.is_active());
+				REQUIRE(result == SYSTEM_ERROR_NOT_SUPPORTED);
+			}
+		}
+
+		WHEN("the server accepts 2 segments of 20 bytes in flight")
+		{
+			REQUIRE_FALSE(receive_reply(transfer, open_response(2, CoAPCode::CREATED, 2, 20), 10));
+			REQUIRE(receive_reply(transfer, open_response(1, CoAPCode::CREATED, 2, 20), 10));
+			for (int i = 0; i < 3; ++i) {
+				REQUIRE(transfer.process(channel, 20) == NO_ERROR);
+			}
+			THEN("only the window is sent before an acknowledgement")
+			{
+				REQUIRE(channel.sent.size() == 3);
+				REQUIRE(channel.segment_offset(1) == 0);
+				REQUIRE(channel.segment_offset(2) == 20);
+				REQUIRE(channel.sent[2].size() == 12 + 20);
+				REQUIRE((uint8_t)channel.sent[2][12] == 20);
+			}
+
+			AND_WHEN("the server acknowledges the data")
+			{
+				receive_ack(transfer, channel, 20, 30);
+				REQUIRE(transfer.acknowledged() == 20);
+				REQUIRE(transfer.process(channel, 30) == NO_ERROR);
+				REQUIRE(channel.sent.size() == 4);
+				REQUIRE(channel.segment_offset(3) == 40);
+				receive_ack(transfer, channel, 60, 40);
+				REQUIRE(transfer.process(channel, 40) == NO_ERROR);
+				receive_ack(transfer, channel, 100, 50);
+				THEN("the transfer completes")
+				{
+					REQUIRE(channel.segment_offset(4) == 60);
+					REQUIRE(channel.segment_offset(5) == 80);
+					REQUIRE_FALSE(transfer.is_active());
+					REQUIRE(result == 0);
+				}
+			}
+
+			AND_WHEN("the server doesn't acknowledge the data in time")
+			{
+				receive_ack(transfer, channel, 20, 30);
+				REQUIRE(transfer.process(channel, 30 + BulkTransfer::ACK_TIMEOUT) == NO_ERROR);
+				THEN("the unacknowledged segments are sent again")
+				{
+					REQUIRE(channel.sent.size() == 5);
+					REQUIRE(channel.segment_offset(3) == 20);
+					REQUIRE(channel.segment_offset(4) == 40);
+				}
+			}
+
+			AND_WHEN("the server never acknowledges the data")
+			{
+				system_tick_t t = 20;
+				for (unsigned i = 0; i <= BulkTransfer::MAX_RETRIES; ++i) {
+					t += BulkTransfer::ACK_TIMEOUT;
+					REQUIRE(transfer.process(channel, t) == NO_ERROR);
+				}
+				THEN("the transfer is cancelled")
+				{
+					REQUIRE_FALSE(transfer.is_active());
+					REQUIRE(result == SYSTEM_ERROR_TIMEOUT);
+					const std::string& last = channel.sent.back();
+					REQUIRE((uint8_t)last[1] == CoAPCode::DELETE);
+				}
+			}
+		}
+
+		WHEN("the server doesn't respond")
+		{
+			REQUIRE(transfer.process(channel, BulkTransfer::OPEN_TIMEOUT) == NO_ERROR);
+			THEN("the transfer fails")
+			{
+				REQUIRE_FALSE(transfer.is_active());
+				REQUIRE(result == SYSTEM_ERROR_TIMEOUT);
+			}
+		}
+
+		WHEN("another transfer is started")
+		{
+			int other = 1;
+			auto cb = [](int error, const void*, void* data, void*) { *(int*)data = error; };
+			REQUIRE(transfer.begin(channel, TOKEN + 1, "other", 10, read_data, nullptr,
+					CompletionHandler(cb, &other), 0) != NO_ERROR);
+			THEN("it is rejected")
+			{
+				REQUIRE(other == SYSTEM_ERROR_BUSY);
+				REQUIRE(transfer.is_active());
+			}
+		}
+	}
+}
@@ -0,0 +1,253 @@
+/**
+ ******************************************************************************
+  Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation, either
+  version 3 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************
+ */
+
+#include "chunked_transfer.h"
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace particle::protocol;
+
+namespace {
+
+const uint32_t FILE_ADDRESS = 0x1000;
+const uint16_t CHUNK_SIZE = 4;
+const char FILE_DATA[] = "0123456789abcd"; // 4 chunks, the last chunk is 2 bytes
+
+struct Write
+{
+	uint32_t address;
+	std::string data;
+};
+
+class TestCallbacks : public ChunkedTransfer::Callbacks
+{
+public:
+	std::vector<Write> writes;
+	bool fail_writes = false;
+	bool finished = false;
+
+	int prepare_for_firmware_update(FileTransfer::Descriptor& data, uint32_t flags, void*) override
+	{
+		return 0;
+	}
+
+	int save_firmware_chunk(FileTransfer::Descriptor& descriptor, const unsigned char* chunk, void*) override
+	{
+		if (fail_writes)
+		{
+			return -1;
+		}
+		writes.push_back({ descriptor.chunk_address, std::string((const char*)chunk, descriptor.chunk_size) });
+		return 0;
+	}
+
+	int finish_firmware_update(FileTransfer::Descriptor& data, uint32_t flags, void*) override
+	{
+		if (flags == UpdateFlag::SUCCESS)
+		{
+			finished = true;
+		}
+		return 0;
+	}
+
+	uint32_t calculate_crc(const unsigned char *buf, uint32_t buflen) override
+	{
+		uint32_t crc = 0;
+		for (uint32_t i = 0; i < buflen; ++i)
+		{
+			crc += buf[i];
+		}
+		return crc;
+	}
+
+	system_tick_t millis() override
+	{
+		return 0;
+	}
+};
+
+class TestChannel : public MessageChannel
+{
+	uint8_t buffer[PROTOCOL_BUFFER_SIZE];
+
+public:
+	std::vector<std::vector<uint8_t>> sent;
+
+	ProtocolError receive(Message& message) override { return NO_ERROR; }
+
+	ProtocolError send(Message& msg) override
+	{
+		sent.push_back(std::vector<uint8_t>(msg.buf(), msg.buf() + msg.length()));
+		return NO_ERROR;
+	}
+
+	ProtocolError command(Command cmd, void* arg) override { return NO_ERROR; }
+
+	bool is_unreliable() override { return true; }
+
+	ProtocolError establish(uint32_t& flags, uint32_t app_state_crc) override { return NO_ERROR; }
+
+	ProtocolError create(Message& message, size_t minimum_size) override
+	{
+		message = Message(buffer, sizeof(buffer));
+		return NO_ERROR;
+	}
+
+	ProtocolError response(Message& original, Message& response, size_t required) override
+	{
+		return create(response, required);
+	}
+
+	ProtocolError notify_established() override { return NO_ERROR; }
+
+	void notify_client_messages_processed() override {}
+};
+
+class Transfer
+{
+	// The chunk bitmap is stored at the end of the buffer of the received messages
+	uint8_t queue[PROTOCOL_BUFFER_SIZE];
+
+public:
+	TestCallbacks callbacks;
+	TestChannel channel;
+	ChunkedTransfer transfer;
+
+	Transfer()
+	{
+		transfer.init(&callbacks);
+		transfer.reset();
+	}
+
+	void begin()
+	{
+		const uint8_t begin[] = { 0x41, 0x02, 0x00, 0x01, 0x01, 0xb1, 'u', 0xff,
+				0x01, // fast OTA
+				CHUNK_SIZE >> 8, CHUNK_SIZE & 0xff,
+				0x00, 0x00, 0x00, sizeof(FILE_DATA) - 1,
+				FileTransfer::Store::FIRMWARE,
+				0x00, 0x00, FILE_ADDRESS >> 8, FILE_ADDRESS & 0xff };
+		memcpy(queue, begin, sizeof(begin));
+		Message msg(queue, sizeof(queue), sizeof(begin));
+		REQUIRE(transfer.handle_update_begin(0x01, msg, channel) == NO_ERROR);
+	}
+
+	void chunk(chunk_index_t index)
+	{
+		const size_t offset = index * CHUNK_SIZE;
+		const size_t size = std::min(size_t(CHUNK_SIZE), sizeof(FILE_DATA) - 1 - offset);
+		const uint32_t crc = callbacks.calculate_crc((const uint8_t*)FILE_DATA + offset, size);
+		const uint8_t header[] = { 0x51, 0x02, 0x00, 0x02, 0x01, 0xb1, 'c',
+				0x44, uint8_t(crc >> 24), uint8_t(crc >> 16), uint8_t(crc >> 8), uint8_t(crc),
+				0x02, uint8_t(index >> 8), uint8_t(index), 0xff };
+		memcpy(queue, header, sizeof(header));
+		memcpy(queue + sizeof(header), FILE_DATA + offset, size);
+		Message msg(queue, sizeof(queue), sizeof(header) + size);
+		REQUIRE(transfer.handle_chunk(0x01, msg, channel) == NO_ERROR);
+	}
+
+	void done()
+	{
+		const uint8_t done[] = { 0x41, 0x03, 0x00, 0x03, 0x01, 0xb1, 'u' };
+		memcpy(queue, done, sizeof(done));
+		Message msg(queue, sizeof(queue), sizeof(done));
+		REQUIRE(transfer.handle_update_done(0x01, msg, channel) == NO_ERROR);
+	}
+};
+
+} // namespace
+
+SCENARIO("buffering firmware chunks before writing them to storage")
+{
+	GIVEN("a fast OTA transfer")
+	{
+		Transfer t;
+		t.begin();
+
+		WHEN("all chunks are received in order")
+		{
+			for (chunk_index_t i = 0; i < 4; ++i)
+			{
+				t.chunk(i);
+			}
+			THEN("the chunks are not written until the update is done")
+			{
+				REQUIRE(t.callbacks.writes.empty());
+				t.done();
+				REQUIRE(t.callbacks.writes.size() == 1);
+				REQUIRE(t.callbacks.writes[0].address == FILE_ADDRESS);
+				REQUIRE(t.callbacks.writes[0].data == FILE_DATA);
+				REQUIRE(t.callbacks.finished);
+			}
+		}
+
+		WHEN("the chunks are received out of order")
+		{
+			t.chunk(0);
+			t.chunk(1);
+			t.chunk(3);
+			t.chunk(2);
+			t.done();
+			THEN("each run of consecutive chunks is written separately")
+			{
+				REQUIRE(t.callbacks.writes.size() == 3);
+				REQUIRE(t.callbacks.writes[0].address == FILE_ADDRESS);
+				REQUIRE(t.callbacks.writes[0].data == "01234567");
+				REQUIRE(t.callbacks.writes[1].address == FILE_ADDRESS + 12);
+				REQUIRE(t.callbacks.writes[1].data == "cd");
+				REQUIRE(t.callbacks.writes[2].address == FILE_ADDRESS + 8);
+				REQUIRE(t.callbacks.writes[2].data == "89ab");
+				REQUIRE(t.callbacks.finished);
+			}
+		}
+
+		WHEN("the channel becomes idle")
+		{
+			t.chunk(0);
+			t.chunk(1);
+			REQUIRE(t.transfer.idle(t.channel) == NO_ERROR);
+			THEN("the buffered chunks are written")
+			{
+				REQUIRE(t.callbacks.writes.size() == 1);
+				REQUIRE(t.callbacks.writes[0].data == "01234567");
+			}
+		}
+
+		WHEN("the buffered chunks cannot be written")
+		{
+			t.callbacks.fail_writes = true;
+			for (chunk_index_t i = 0; i < 4; ++i)
+			{
+				t.chunk(i);
+			}
+			t.done();
+			THEN("the chunks are requested again")
+			{
+				REQUIRE_FALSE(t.callbacks.finished);
+				const std::vector<uint8_t>& missed = t.channel.sent.back();
+				const std::vector<uint8_t> expected = { 0x40, 0x01, 0x00, 0x00, 0xb1, 'c', 0xff,
+						0x00, 0x00, 0x00, 0x01, 0x00, 0x02, 0x00, 0x03 };
+				REQUIRE(missed == expected);
+			}
+		}
+	}
+}
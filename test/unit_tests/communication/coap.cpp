@@ -89,3 +89,101 @@ SCENARIO("CoAP::path is retrieved from a CoAP message")
 	}
 }
 
+
+SCENARIO("CoAP::find_option finds an option in a CoAP message")
+{
+	// CON GET, one-byte token, Uri-Path "d", Uri-Query "\x02", Block2 num=2 szx=6
+	const uint8_t msg[] = { 0x41, 0x01, 0x12, 0x34, 0xaa, 0xb1, 'd', 0x41, 0x02, 0x81, 0x26, 0xff, 'x' };
+	size_t len = 0;
+	const uint8_t* opt = CoAP::find_option(msg, sizeof(msg), CoAPOption::URI_PATH, &len);
+	REQUIRE(opt == msg + 6);
+	REQUIRE(len == 1);
+	opt = CoAP::find_option(msg, sizeof(msg), CoAPOption::URI_QUERY, &len);
+	REQUIRE(opt == msg + 8);
+	REQUIRE(len == 1);
+	opt = CoAP::find_option(msg, sizeof(msg), CoAPOption::BLOCK2, &len);
+	REQUIRE(opt == msg + 10);
+	REQUIRE(len == 1);
+	REQUIRE(CoAP::find_option(msg, sizeof(msg), CoAPOption::OBSERVE, &len) == nullptr);
+	REQUIRE(CoAP::find_option(msg, sizeof(msg), CoAPOption::BLOCK1, &len) == nullptr);
+	// Truncated option value
+	REQUIRE(CoAP::find_option(msg, 9, CoAPOption::BLOCK2, &len) == nullptr);
+	REQUIRE(CoAP::find_option(msg, 10, CoAPOption::BLOCK2, &len) == nullptr);
+}
+
+SCENARIO("CoAPMessageView parses a CoAP message")
+{
+	// CON GET, one-byte token, Uri-Path "d", Uri-Query "\x02", Block2 num=2 szx=6, payload "x"
+	const uint8_t msg[] = { 0x41, 0x01, 0x12, 0x34, 0xaa, 0xb1, 'd', 0x41, 0x02, 0x81, 0x26, 0xff, 'x' };
+	CoAPMessageView view;
+	REQUIRE(view.parse(msg, sizeof(msg)));
+	REQUIRE(view.is_valid());
+	REQUIRE(view.type() == CoAPType::CON);
+	REQUIRE(view.code() == CoAPCode::GET);
+	REQUIRE(view.id() == 0x1234);
+	REQUIRE(view.token_size() == 1);
+	REQUIRE(view.token()[0] == 0xaa);
+	REQUIRE(view.payload() == msg + 12);
+	REQUIRE(view.payload_size() == 1);
+	size_t len = 0;
+	REQUIRE(view.first_option(&len) == msg + 6);
+	REQUIRE(len == 1);
+	REQUIRE(view.find_option(CoAPOption::BLOCK2, &len) == msg + 10);
+	REQUIRE(view.find_option(CoAPOption::OBSERVE, &len) == nullptr);
+	auto it = view.options();
+	REQUIRE(it.next());
+	REQUIRE(it.number() == CoAPOption::URI_PATH);
+	REQUIRE(it.next());
+	REQUIRE(it.number() == CoAPOption::URI_QUERY);
+	REQUIRE(it.next());
+	REQUIRE(it.number() == CoAPOption::BLOCK2);
+	REQUIRE(it.data() == msg + 10);
+	REQUIRE(it.size() == 1);
+	REQUIRE_FALSE(it.next());
+	// Truncated option value
+	REQUIRE_FALSE(view.parse(msg, 10));
+	REQUIRE_FALSE(view.is_valid());
+	// Header only
+	REQUIRE_FALSE(view.parse(msg, 3));
+}
+
+SCENARIO("CoAP block options are encoded and decoded")
+{
+	uint8_t buf[CoAP::MAX_BLOCK_OPTION_SIZE];
+	CoAPBlock block = {};
+	GIVEN("the first block of 16 bytes without more blocks")
+	{
+		// A zero value is encoded as an empty option
+		REQUIRE(CoAP::block_option(buf, CoAPOption::NONE, CoAPOption::BLOCK2, block) == 2);
+		REQUIRE(buf[0] == 0xd0);
+		REQUIRE(buf[1] == 23 - 13);
+		CoAPBlock b = { 1, 1, true };
+		REQUIRE(CoAP::decode_block(buf + 2, 0, &b));
+		REQUIRE(b.num == 0);
+		REQUIRE(b.szx == 0);
+		REQUIRE_FALSE(b.more);
+		REQUIRE(b.size() == 16);
+	}
+	GIVEN("a block with a large number")
+	{
+		block.num = 0x12345;
+		block.szx = 5;
+		block.more = true;
+		REQUIRE(CoAP::block_option(buf, CoAPOption::URI_QUERY, CoAPOption::BLOCK2, block) == 4);
+		REQUIRE(buf[0] == 0x83);
+		CoAPBlock b = {};
+		REQUIRE(CoAP::decode_block(buf + 1, 3, &b));
+		REQUIRE(b.num == 0x12345);
+		REQUIRE(b.szx == 5);
+		REQUIRE(b.more);
+		REQUIRE(b.size() == 512);
+		REQUIRE(b.offset() == 0x12345 * 512);
+	}
+	GIVEN("an invalid block option")
+	{
+		const uint8_t reserved[] = { 0x07 };
+		REQUIRE_FALSE(CoAP::decode_block(reserved, sizeof(reserved), &block));
+		const uint8_t too_long[] = { 0x00, 0x00, 0x00, 0x01 };
+		REQUIRE_FALSE(CoAP::decode_block(too_long, sizeof(too_long), &block));
+	}
+}
@@ -18,6 +18,7 @@
  */
 
 #include <climits>
+#include <vector>
 
 #include "coap_channel.h"
 #include "forward_message_channel.h"
@@ -617,6 +618,153 @@ SCENARIO("retransmit delay is exponential with randomness")
 
 
 
+SCENARIO("the acknowledgement timeout is derived from the measured round-trip time")
+{
+	GIVEN("a round-trip estimator")
+	{
+		RoundTripEstimator rtt;
+		THEN("the default acknowledgement timeout is used initially")
+		{
+			REQUIRE(rtt.smoothed_rtt()==0);
+			REQUIRE(rtt.ack_timeout()==system_tick_t(CoAPMessage::ACK_TIMEOUT));
+		}
+
+		WHEN("a round-trip time is measured")
+		{
+			rtt.sample(400);
+			THEN("the timeout is the round-trip time plus 4 times its variance")
+			{
+				REQUIRE(rtt.smoothed_rtt()==400);
+				REQUIRE(rtt.ack_timeout()==400 + 4*200);
+			}
+			AND_WHEN("further round-trip times are measured")
+			{
+				rtt.sample(800);
+				THEN("the estimate is smoothed")
+				{
+					REQUIRE(rtt.smoothed_rtt()==450);
+					REQUIRE(rtt.ack_timeout()==450 + 4*250);
+				}
+			}
+		}
+
+		WHEN("the round-trip time is very short")
+		{
+			rtt.sample(10);
+			THEN("the timeout is not less than the minimum")
+			{
+				REQUIRE(rtt.ack_timeout()==RoundTripEstimator::MIN_ACK_TIMEOUT);
+			}
+		}
+
+		WHEN("the round-trip time is very long")
+		{
+			rtt.sample(20000);
+			THEN("the timeout is not greater than the maximum")
+			{
+				REQUIRE(rtt.ack_timeout()==RoundTripEstimator::MAX_ACK_TIMEOUT);
+			}
+		}
+	}
+
+	GIVEN("a message store and a confirmable message")
+	{
+		CoAPMessageStore store;
+		ForwardMessageChannel channel;
+		uint8_t buf[10] = { 0x40, 0, 0x12, 0x34 };
+		Message m(buf, sizeof(buf), 4);
+		m.decode_id();
+		REQUIRE(store.send(m, 1000)==NO_ERROR);
+
+		WHEN("the message is acknowledged without being retransmitted")
+		{
+			m.set_length(Messages::empty_ack(m.buf(), 0x12, 0x34));
+			store.receive(m, channel, 1500);
+			THEN("the round-trip time is measured")
+			{
+				REQUIRE(store.round_trip().smoothed_rtt()==500);
+				REQUIRE(store.round_trip().ack_timeout()==500 + 4*250);
+			}
+		}
+
+		WHEN("the message is acknowledged after being retransmitted")
+		{
+			REQUIRE(store.from_id(0x1234)->prepare_retransmit(5000));
+			m.set_length(Messages::empty_ack(m.buf(), 0x12, 0x34));
+			store.receive(m, channel, 5500);
+			THEN("the round-trip time is not measured")
+			{
+				REQUIRE(store.round_trip().smoothed_rtt()==0);
+				REQUIRE(store.from_id(0x1234)==nullptr);
+			}
+		}
+	}
+	REQUIRE(CoAPMessage::messages()==0);
+}
+
+SCENARIO("no more than NSTART confirmable messages are in flight at the same time")
+{
+	struct CountingChannel : ForwardMessageChannel
+	{
+		std::vector<message_id_t> sent;
+
+		ProtocolError send(Message& msg) override
+		{
+			sent.push_back(msg.get_id());
+			return NO_ERROR;
+		}
+	};
+
+	GIVEN("a message store with NSTART of 2")
+	{
+		CoAPMessageStore store;
+		store.set_nstart(2);
+		CountingChannel channel;
+		uint8_t buf[3][4] = { { 0x40, 0, 0, 1 }, { 0x40, 0, 0, 2 }, { 0x40, 0, 0, 3 } };
+		for (auto& b: buf)
+		{
+			Message m(b, sizeof(b), sizeof(b));
+			m.decode_id();
+			REQUIRE(store.send(m, 0)==NO_ERROR);
+		}
+
+		THEN("the messages beyond the window are queued")
+		{
+			REQUIRE(store.in_flight()==2);
+			REQUIRE(!store.is_queued(1));
+			REQUIRE(!store.is_queued(2));
+			REQUIRE(store.is_queued(3));
+		}
+
+		WHEN("the store is processed before an acknowledgement is received")
+		{
+			store.process(1, channel);
+			THEN("the queued message is not sent")
+			{
+				REQUIRE(channel.sent.empty());
+				REQUIRE(store.is_queued(3));
+			}
+		}
+
+		WHEN("a message in flight is acknowledged")
+		{
+			uint8_t ack[4];
+			Message m(ack, sizeof(ack), Messages::empty_ack(ack, 0, 1));
+			store.receive(m, channel, 100);
+			store.process(100, channel);
+			THEN("the queued message is sent")
+			{
+				REQUIRE(channel.sent.size()==1);
+				REQUIRE(channel.sent[0]==3);
+				REQUIRE(!store.is_queued(3));
+				REQUIRE(store.in_flight()==2);
+			}
+		}
+		store.clear();
+	}
+	REQUIRE(CoAPMessage::messages()==0);
+}
+
 SCENARIO("a repeated confirmable CoAP message is passed only once to the application and the acknowledgement is retained and returned until MAX_TRANSMIT_SPAN time has elapsed")
 {
 	GIVEN("a Confirmable message is received multiple times")
@@ -18,6 +18,7 @@
  */
 
 #include "messages.h"
+#include "message_channel.h"
 
 #include <catch2/catch.hpp>
 
@@ -290,3 +291,118 @@ SCENARIO("confirmable messages")
 	}
 
 }
+
+SCENARIO("encoding a batch of events")
+{
+	GIVEN("two events")
+	{
+		const EventBatchEntry events[] = { { "a", "12" }, { "bc", nullptr } };
+		uint8_t buf[64];
+
+		WHEN("the events are encoded with the default TTL")
+		{
+			size_t len = Messages::events(buf, sizeof(buf), 0x1234, events, 2, 60, EventType::PRIVATE, true);
+			THEN("the events are encoded into the payload with the batch query option")
+			{
+				const uint8_t expected[] = { 0x40, 0x02, 0x12, 0x34, 0xb1, 'E', 0x41, 'b', 0xff,
+						1, 'a', 0, 2, '1', '2', 2, 'b', 'c', 0, 0 };
+				REQUIRE(len == sizeof(expected));
+				REQUIRE(memcmp(buf, expected, len) == 0);
+			}
+		}
+
+		WHEN("the events are encoded with a custom TTL")
+		{
+			size_t len = Messages::events(buf, sizeof(buf), 0, events, 2, 3600, EventType::PUBLIC, false);
+			THEN("the Max-Age option precedes the batch query option")
+			{
+				const uint8_t expected[] = { 0x50, 0x02, 0, 0, 0xb1, 'e', 0x33, 0x00, 0x0e, 0x10, 0x11, 'b', 0xff };
+				REQUIRE(len == sizeof(expected) + 11);
+				REQUIRE(memcmp(buf, expected, sizeof(expected)) == 0);
+			}
+		}
+
+		WHEN("the buffer is too small")
+		{
+			size_t len = Messages::events(buf, 16, 0, events, 2, 60, EventType::PUBLIC, true);
+			THEN("no message is encoded")
+			{
+				REQUIRE(len == 0);
+			}
+		}
+	}
+}
+
+SCENARIO("encoding the content format of an event")
+{
+	uint8_t buf[64];
+
+	WHEN("the data is text")
+	{
+		uint8_t expected[64];
+		const size_t expected_len = Messages::event_header(expected, 0, "a", true, 60, EventType::PRIVATE, false);
+		const size_t len = Messages::event_header(buf, 0, "a", true, 60, EventType::PRIVATE, false, ContentType::TEXT);
+		THEN("no Content-Format option is added")
+		{
+			REQUIRE(len == expected_len);
+			REQUIRE(memcmp(buf, expected, len) == 0);
+		}
+	}
+
+	WHEN("the content format fits in one byte")
+	{
+		const size_t len = Messages::event_header(buf, 0, "a", true, 120, EventType::PRIVATE, false, ContentType::BINARY);
+		THEN("the Content-Format option precedes the Max-Age option")
+		{
+			const uint8_t expected[] = { 0x50, 0x02, 0x00, 0x00, 0xb1, 'E', 0x01, 'a', 0x11, 42, 0x23, 0x00, 0x00, 120, 0xff };
+			REQUIRE(len == sizeof(expected));
+			REQUIRE(memcmp(buf, expected, len) == 0);
+		}
+	}
+
+	WHEN("the content format needs two bytes")
+	{
+		const size_t len = Messages::event_header(buf, 0, "a", false, 60, EventType::PRIVATE, false, 0x1234);
+		THEN("the option value is encoded in network byte order")
+		{
+			const uint8_t expected[] = { 0x50, 0x02, 0x00, 0x00, 0xb1, 'E', 0x01, 'a', 0x12, 0x12, 0x34 };
+			REQUIRE(len == sizeof(expected));
+			REQUIRE(memcmp(buf, expected, len) == 0);
+		}
+	}
+}
+
+SCENARIO("encoding an event with its data in a separate segment")
+{
+	GIVEN("an event with data")
+	{
+		uint8_t expected[64];
+		const size_t expected_len = Messages::event(expected, 0x1234, "abc", "data", 60, EventType::PRIVATE, true);
+
+		WHEN("the event header is encoded and the data is appended as a segment")
+		{
+			uint8_t buf[64];
+			Message msg(buf, sizeof(buf), Messages::event_header(buf, 0x1234, "abc", true, 60, EventType::PRIVATE, true));
+			const MessageSegment segment = { (const uint8_t*)"data", 4 };
+			REQUIRE(msg.append(&segment, 1));
+			THEN("the message is the same as the complete event message")
+			{
+				REQUIRE(msg.length() == expected_len);
+				REQUIRE(memcmp(buf, expected, expected_len) == 0);
+			}
+		}
+
+		WHEN("the segment doesn't fit into the message buffer")
+		{
+			uint8_t buf[64];
+			const size_t len = Messages::event_header(buf, 0x1234, "abc", true, 60, EventType::PRIVATE, true);
+			Message msg(buf, len + 3, len);
+			const MessageSegment segment = { (const uint8_t*)"data", 4 };
+			THEN("the segment is not appended")
+			{
+				REQUIRE_FALSE(msg.append(&segment, 1));
+				REQUIRE(msg.length() == len);
+			}
+		}
+	}
+}
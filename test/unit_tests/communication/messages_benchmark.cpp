@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "messages.h"
+#include "coap_message_prefix.h"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <iostream>
+
+using namespace particle::protocol;
+
+namespace {
+
+const unsigned ITERATIONS = 1000000;
+
+template<typename F>
+double measureNs(F fn) {
+	uint8_t buf[64];
+	const auto start = std::chrono::steady_clock::now();
+	size_t total = 0;
+	for (unsigned i = 0; i < ITERATIONS; ++i) {
+		total += fn(buf, (message_id_t)i);
+	}
+	const auto end = std::chrono::steady_clock::now();
+	REQUIRE(total > 0);
+	return std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+}
+
+void report(const char* name, double ns) {
+	std::cout << name << ": " << ns << " ns/message" << std::endl;
+}
+
+} // namespace
+
+SCENARIO("CoAP message prefixes are encoded at compile time")
+{
+	uint8_t buf[16] = {};
+	typedef CoAPMessagePrefix<CoAPType::CON, CoAPCode::EMPTY, 0, false> Ping;
+	REQUIRE(Ping::encode(buf, 0x1234) == 4);
+	REQUIRE(memcmp(buf, "\x40\x00\x12\x34", 4) == 0);
+	typedef CoAPMessagePrefix<CoAPType::NON, CoAPCode::CHANGED, 1, true> FunctionReturn;
+	REQUIRE(FunctionReturn::encode(buf, 0x1234, 0xaa) == 6);
+	REQUIRE(memcmp(buf, "\x51\x44\x12\x34\xaa\xff", 6) == 0);
+	typedef CoAPMessagePrefix<CoAPType::CON, CoAPCode::GET, 1, false, 't'> TimeRequest;
+	REQUIRE(TimeRequest::encode(buf, 0x1234, 0xaa) == 7);
+	REQUIRE(memcmp(buf, "\x41\x01\x12\x34\xaa\xb1t", 7) == 0);
+	typedef CoAPMessagePrefix<CoAPType::CON, CoAPCode::POST, 0, true, 'a', 'b'> Post;
+	REQUIRE(Post::encode(buf, 0x1234) == 8);
+	REQUIRE(memcmp(buf, "\x40\x02\x12\x34\xb2" "ab\xff", 8) == 0);
+}
+
+SCENARIO("Benchmark of the CoAP message encoders", "[.benchmark]")
+{
+	report("ping", measureNs([](uint8_t* buf, message_id_t id) {
+		return Messages::ping(buf, id);
+	}));
+	report("function_return", measureNs([](uint8_t* buf, message_id_t id) {
+		return Messages::function_return(buf, id, 0x12, 1234, true);
+	}));
+	report("time_request", measureNs([](uint8_t* buf, message_id_t id) {
+		return Messages::time_request(buf, id, 0x12);
+	}));
+	report("update_done", measureNs([](uint8_t* buf, message_id_t id) {
+		return Messages::update_done(buf, id, false);
+	}));
+	report("event", measureNs([](uint8_t* buf, message_id_t id) {
+		return Messages::event(buf, id, "test/event", "data", 60, EventType::PUBLIC, true);
+	}));
+}
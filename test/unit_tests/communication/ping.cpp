@@ -160,3 +160,155 @@ SCENARIO("ping requests and responses are managed")
 	}
 
 }
+
+namespace {
+
+// Runs pings until the NAT binding lifetime is learned. Returns the number of failed pings
+int learn_binding_lifetime(Pinger& pinger, system_tick_t lifetime, int max_pings = 100)
+{
+	int failed = 0;
+	for (int i = 0; i < max_pings && !pinger.is_adaptive_settled(); ++i)
+	{
+		const system_tick_t idle = pinger.interval() + 1;
+		REQUIRE(pinger.process(idle, []{return NO_ERROR;})==NO_ERROR);
+		REQUIRE(pinger.is_expecting_ping_ack());
+		if (idle < lifetime)
+		{
+			pinger.message_received();
+		}
+		else
+		{
+			REQUIRE(pinger.process(10001, []{return NO_ERROR;})==PING_TIMEOUT);
+			pinger.reset();
+			++failed;
+		}
+	}
+	return failed;
+}
+
+} // namespace
+
+SCENARIO("the ping interval is adapted to the NAT binding lifetime")
+{
+	Pinger pinger;
+	pinger.init(30000, 10000);
+
+	GIVEN("nothing is known about the network")
+	{
+		pinger.set_adaptive(true);
+		THEN("the first ping is sent after the minimum interval")
+		{
+			REQUIRE(pinger.interval()==(system_tick_t)Pinger::ADAPTIVE_MIN_INTERVAL);
+		}
+
+		THEN("the interval converges just inside the binding lifetime")
+		{
+			learn_binding_lifetime(pinger, 100000);
+			REQUIRE(pinger.is_adaptive_settled());
+			REQUIRE(pinger.interval() < 100000);
+			REQUIRE(pinger.interval() >= 100000 - 12500);
+		}
+
+		THEN("the interval grows up to the maximum if the binding doesn't expire")
+		{
+			REQUIRE(learn_binding_lifetime(pinger, 0xffffffff)==0);
+			REQUIRE(pinger.interval()==(system_tick_t)Pinger::ADAPTIVE_MAX_INTERVAL);
+		}
+	}
+
+	GIVEN("the lifetime has been learned before")
+	{
+		pinger.set_adaptive(true);
+		learn_binding_lifetime(pinger, 100000);
+		const uint32_t bounds = pinger.adaptive_bounds();
+		REQUIRE((bounds & 0xffff) >= 87);
+		REQUIRE((bounds >> 16) >= 100);
+
+		THEN("the learned bounds are restored without probing")
+		{
+			Pinger pinger2;
+			pinger2.init(30000, 10000);
+			pinger2.set_adaptive(true, bounds);
+			REQUIRE(pinger2.is_adaptive_settled());
+			REQUIRE(learn_binding_lifetime(pinger2, 100000, 5)==0);
+			REQUIRE(pinger2.interval()/1000==(bounds & 0xffff));
+		}
+
+		THEN("a shorter lifetime is learned once the pings start timing out")
+		{
+			REQUIRE(pinger.process(pinger.interval() + 1, []{return NO_ERROR;})==NO_ERROR);
+			REQUIRE(pinger.process(10001, []{return NO_ERROR;})==PING_TIMEOUT);
+			pinger.reset();
+			REQUIRE(!pinger.is_adaptive_settled());
+			learn_binding_lifetime(pinger, 40000);
+			REQUIRE(pinger.is_adaptive_settled());
+			REQUIRE(pinger.interval() < 40000);
+			REQUIRE(pinger.interval() >= 40000 - 5000);
+		}
+
+		THEN("setting the interval by the USER disables the adaptive mode")
+		{
+			pinger.set_interval(60000, KeepAliveSource::USER);
+			REQUIRE(!pinger.is_adaptive());
+			REQUIRE(pinger.interval()==60000);
+		}
+	}
+}
+
+SCENARIO("outbound traffic defers the pings")
+{
+	Pinger pinger;
+	pinger.init(15000, 10000);
+
+	GIVEN("a message has been sent recently")
+	{
+		THEN("no ping is sent while the device keeps sending messages")
+		{
+			REQUIRE(pinger.process(15001, 5000, []{return IO_ERROR;})==NO_ERROR);
+			REQUIRE(!pinger.is_expecting_ping_ack());
+			REQUIRE(pinger.process(59999, 14999, []{return IO_ERROR;})==NO_ERROR);
+			REQUIRE(!pinger.is_expecting_ping_ack());
+		}
+
+		THEN("a ping is sent once the channel has been idle for the ping interval")
+		{
+			bool callback_called = false;
+			REQUIRE(pinger.process(20000, 15001, [&]()->ProtocolError{callback_called = true; return NO_ERROR;})==NO_ERROR);
+			REQUIRE(pinger.is_expecting_ping_ack());
+			REQUIRE(callback_called);
+		}
+
+		THEN("a ping is sent if nothing has been received for too long")
+		{
+			bool callback_called = false;
+			REQUIRE(pinger.process(15000 * Pinger::LIVENESS_FACTOR + 1, 1000, [&]()->ProtocolError{callback_called = true; return NO_ERROR;})==NO_ERROR);
+			REQUIRE(pinger.is_expecting_ping_ack());
+			REQUIRE(callback_called);
+		}
+	}
+
+	GIVEN("a ping has been sent")
+	{
+		REQUIRE(pinger.process(15001, 15001, []{return NO_ERROR;})==NO_ERROR);
+
+		THEN("outbound traffic doesn't prevent the ping from timing out")
+		{
+			REQUIRE(pinger.process(10001, 0, []{return NO_ERROR;})==PING_TIMEOUT);
+		}
+	}
+
+	GIVEN("the adaptive mode is enabled")
+	{
+		pinger.set_adaptive(true, (120 << 16) | 100);
+
+		THEN("a ping forced by the lack of inbound traffic doesn't affect the learned bounds")
+		{
+			const uint32_t bounds = pinger.adaptive_bounds();
+			REQUIRE(pinger.process(pinger.interval() * Pinger::LIVENESS_FACTOR + 1, 1000, []{return NO_ERROR;})==NO_ERROR);
+			REQUIRE(pinger.is_expecting_ping_ack());
+			REQUIRE(pinger.process(10001, 0, []{return NO_ERROR;})==PING_TIMEOUT);
+			pinger.reset();
+			REQUIRE(pinger.adaptive_bounds()==bounds);
+		}
+	}
+}
@@ -21,7 +21,164 @@
 
 #include <catch2/catch.hpp>
 
+#include <map>
+#include <string>
+#include <vector>
+
 using namespace particle::protocol;
+using particle::CompletionHandler;
+
+namespace {
+
+// Records the names of the sent events
+class EventChannel: public MessageChannel {
+public:
+	std::vector<std::string> sent;
+
+	bool is_unreliable() override { return false; }
+	ProtocolError establish(uint32_t& flags, uint32_t app_state_crc) override { return NO_ERROR; }
+	ProtocolError create(Message& msg, size_t size) override
+	{
+		msg.set_buffer(buf, sizeof(buf));
+		return NO_ERROR;
+	}
+	ProtocolError response(Message& original, Message& response, size_t required) override { return NO_ERROR; }
+	ProtocolError notify_established() override { return NO_ERROR; }
+	void notify_client_messages_processed() override {}
+	ProtocolError receive(Message& msg) override { return NO_ERROR; }
+	ProtocolError command(Command cmd, void* arg) override { return NO_ERROR; }
+
+	ProtocolError send(Message& msg) override
+	{
+		// Header, Uri-Path option with the event type, Uri-Path option with the event name
+		const uint8_t* p = msg.buf();
+		sent.push_back(std::string((const char*)p + 7, p[6] & 0x0f));
+		return NO_ERROR;
+	}
+
+private:
+	uint8_t buf[128];
+};
+
+std::map<std::string, int> results;
+
+void event_complete(int error, const void* data, void* callback_data, void* reserved)
+{
+	results[(const char*)callback_data] = error;
+}
+
+ProtocolError send(Publisher& publisher, EventChannel& channel, const char* name, int priority, system_tick_t time,
+		system_tick_t timeout = 0)
+{
+	return publisher.send_event(channel, name, "data", 4, ContentType::TEXT, 60, EventType::PRIVATE,
+			EventType::NO_ACK, time, CompletionHandler(event_complete, (void*)name), priority, timeout);
+}
+
+} // namespace
+
+SCENARIO("scheduling deferred events")
+{
+	GIVEN("a publisher allowing one application event per second")
+	{
+		results.clear();
+		Publisher publisher(nullptr);
+		publisher.set_rate_limit(1, 1000);
+		EventChannel channel;
+		REQUIRE(send(publisher, channel, "first", EventPriority::NORMAL, 0) == NO_ERROR);
+
+		WHEN("events of different priorities are deferred")
+		{
+			REQUIRE(send(publisher, channel, "bg", EventPriority::BACKGROUND, 0) == NO_ERROR);
+			REQUIRE(send(publisher, channel, "normal", EventPriority::NORMAL, 0) == NO_ERROR);
+			REQUIRE(send(publisher, channel, "crit", EventPriority::CRITICAL, 0) == NO_ERROR);
+			REQUIRE(publisher.deferred_events() == 3);
+			for (system_tick_t t = 1000; t <= 3000; t += 1000) {
+				REQUIRE(publisher.process(channel, t) == NO_ERROR);
+			}
+			THEN("they are sent in the order of their priority")
+			{
+				REQUIRE(channel.sent == std::vector<std::string>({ "first", "crit", "normal", "bg" }));
+				REQUIRE(publisher.deferred_events() == 0);
+				REQUIRE(results["bg"] == 0);
+			}
+		}
+
+		WHEN("events of the same priority have different deadlines")
+		{
+			REQUIRE(send(publisher, channel, "none", EventPriority::NORMAL, 0) == NO_ERROR);
+			REQUIRE(send(publisher, channel, "late", EventPriority::NORMAL, 0, 10000) == NO_ERROR);
+			REQUIRE(send(publisher, channel, "early", EventPriority::NORMAL, 0, 5000) == NO_ERROR);
+			for (system_tick_t t = 1000; t <= 3000; t += 1000) {
+				REQUIRE(publisher.process(channel, t) == NO_ERROR);
+			}
+			THEN("the events with an earlier deadline are sent first")
+			{
+				REQUIRE(channel.sent == std::vector<std::string>({ "first", "early", "late", "none" }));
+			}
+		}
+
+		WHEN("the deadlines of deferred events pass")
+		{
+			REQUIRE(send(publisher, channel, "bg", EventPriority::BACKGROUND, 0, 500) == NO_ERROR);
+			REQUIRE(send(publisher, channel, "normal", EventPriority::NORMAL, 0, 500) == NO_ERROR);
+			REQUIRE(send(publisher, channel, "crit", EventPriority::CRITICAL, 0, 500) == NO_ERROR);
+			REQUIRE(publisher.process(channel, 1000) == NO_ERROR);
+			THEN("only the critical event is sent")
+			{
+				REQUIRE(channel.sent == std::vector<std::string>({ "first", "crit" }));
+				REQUIRE(publisher.deferred_events() == 0);
+				REQUIRE(results["bg"] == SYSTEM_ERROR_TIMEOUT);
+				REQUIRE(results["normal"] == SYSTEM_ERROR_TIMEOUT);
+				REQUIRE(results["crit"] == 0);
+			}
+		}
+
+		WHEN("the deferral queue is full")
+		{
+			const char* names[] = { "bg1", "bg2", "bg3", "bg4" };
+			for (const char* name: names) {
+				REQUIRE(send(publisher, channel, name, EventPriority::BACKGROUND, 0) == NO_ERROR);
+			}
+			REQUIRE(publisher.deferred_events() == PROTOCOL_DEFERRED_EVENT_COUNT);
+			THEN("an event of the same priority is rejected")
+			{
+				REQUIRE(send(publisher, channel, "bg5", EventPriority::BACKGROUND, 0) == BANDWIDTH_EXCEEDED);
+				REQUIRE(results["bg5"] == SYSTEM_ERROR_LIMIT_EXCEEDED);
+			}
+			THEN("an event of a higher priority displaces the most recent lower priority event")
+			{
+				REQUIRE(send(publisher, channel, "crit", EventPriority::CRITICAL, 0) == NO_ERROR);
+				REQUIRE(publisher.deferred_events() == PROTOCOL_DEFERRED_EVENT_COUNT);
+				REQUIRE(results["bg4"] == SYSTEM_ERROR_LIMIT_EXCEEDED);
+				REQUIRE(publisher.process(channel, 1000) == NO_ERROR);
+				REQUIRE(channel.sent == std::vector<std::string>({ "first", "crit" }));
+			}
+		}
+
+		WHEN("a token is available and an event of a higher priority than the deferred ones is sent")
+		{
+			REQUIRE(send(publisher, channel, "bg", EventPriority::BACKGROUND, 0) == NO_ERROR);
+			REQUIRE(send(publisher, channel, "crit", EventPriority::CRITICAL, 1000) == NO_ERROR);
+			THEN("the event is sent immediately")
+			{
+				REQUIRE(channel.sent == std::vector<std::string>({ "first", "crit" }));
+				REQUIRE(publisher.deferred_events() == 1);
+			}
+		}
+
+		WHEN("a token is available and an event of the same priority as a deferred one is sent")
+		{
+			REQUIRE(send(publisher, channel, "normal1", EventPriority::NORMAL, 0) == NO_ERROR);
+			REQUIRE(send(publisher, channel, "normal2", EventPriority::NORMAL, 1000) == NO_ERROR);
+			THEN("the event doesn't overtake the deferred one")
+			{
+				REQUIRE(channel.sent == std::vector<std::string>({ "first" }));
+				REQUIRE(publisher.process(channel, 1000) == NO_ERROR);
+				REQUIRE(channel.sent == std::vector<std::string>({ "first", "normal1" }));
+			}
+		}
+	}
+}
 
 SCENARIO("publisher")
 {
@@ -37,46 +194,46 @@ SCENARIO("publisher")
 			REQUIRE(publisher.is_rate_limited(false, 1400)==false);
 			REQUIRE(publisher.is_rate_limited(false, 1600)==false);
 
-			const system_tick_t next_app_event = 5000;  // 1000ms + 4s
-			THEN("application events until 4 seconds have elapsed are rate limited")
+			const system_tick_t next_app_event = 2000;  // 1000ms + 1s
+			THEN("application events until a token is refilled are rate limited")
 			{
 				for (system_tick_t i=1600; i<next_app_event; i+=100) {
 					REQUIRE(publisher.is_rate_limited(false, i)==true);
 				}
 			}
 
-			THEN("an application event after 4 seconds have elapsed is not rate limited")
+			THEN("an application event after 1 second has elapsed is not rate limited")
 			{
 				REQUIRE(publisher.is_rate_limited(false, next_app_event)==false);
+				REQUIRE(publisher.is_rate_limited(false, next_app_event)==true);
+			}
+
+			THEN("the burst allowance is fully restored after 4 seconds")
+			{
+				for (int i=0; i<4; i++) {
+					REQUIRE(publisher.is_rate_limited(false, 5000)==false);
+				}
+				REQUIRE(publisher.is_rate_limited(false, 5000)==true);
 			}
 		}
 
-		WHEN("255 system events are sent in less than a minute")
+		WHEN("255 system events are sent in less than a 257 milliseconds")
 		{
 			for (int i=0; i<255; i++) {
 				INFO("The counter is " << i);
 				REQUIRE(publisher.is_rate_limited(true, i)==false);
 			}
 
-			THEN("all system events until the next minute begins are rate limited")
+			THEN("system events are rate limited until a token is refilled")
 			{
-				for (int i=1000; i<60*1000; i+=1000) {
-					INFO("The counter is " << i);
-					REQUIRE(publisher.is_rate_limited(true, i)==true);
-				}
+				REQUIRE(publisher.is_rate_limited(true, 255)==true);
+				REQUIRE(publisher.is_rate_limited(true, 256)==true);
 
-				// it's only approximately 1 minute, the cutoff is 64k milliseconds
-				for (int i=60000; i<65536; i+=8) {
-					INFO("The counter is " << i);
-					REQUIRE(publisher.is_rate_limited(true, i)==true);
-				}
-
-				AND_THEN("system events in the next minute are not rate limited")
+				AND_THEN("a system event is allowed for every refilled token")
 				{
-					for (int i=65536; i<65536+255; i++) {
-						INFO("The counter is " << i);
-						REQUIRE(publisher.is_rate_limited(true, i)==false);
-					}
+					REQUIRE(publisher.is_rate_limited(true, 257)==false);
+					REQUIRE(publisher.is_rate_limited(true, 257)==true);
+					REQUIRE(publisher.is_rate_limited(true, 514)==false);
 				}
 			}
 
@@ -89,5 +246,53 @@ SCENARIO("publisher")
 				REQUIRE(publisher.is_rate_limited(false, 1000)==true);
 			}
 		}
+
+		WHEN("the application event rate limit is changed")
+		{
+			publisher.set_rate_limit(2, 500);
+
+			THEN("the new burst size and refill interval are applied")
+			{
+				REQUIRE(publisher.is_rate_limited(false, 1000)==false);
+				REQUIRE(publisher.is_rate_limited(false, 1000)==false);
+				REQUIRE(publisher.is_rate_limited(false, 1499)==true);
+				REQUIRE(publisher.is_rate_limited(false, 1500)==false);
+			}
+		}
+	}
+}
+
+SCENARIO("token bucket")
+{
+	GIVEN("a bucket with 3 tokens refilled every 100 milliseconds")
+	{
+		TokenBucket bucket(3, 100);
+
+		WHEN("the tokens are taken close to the millis() overflow")
+		{
+			const system_tick_t t = system_tick_t(-50);
+			REQUIRE(bucket.take(t));
+			REQUIRE(bucket.take(t));
+			REQUIRE(bucket.take(t));
+			REQUIRE_FALSE(bucket.take(t + 99));
+
+			THEN("the tokens are refilled after the overflow")
+			{
+				REQUIRE(bucket.take(t + 100));
+				REQUIRE_FALSE(bucket.available(t + 150));
+				REQUIRE(bucket.available(t + 200));
+			}
+		}
+
+		WHEN("the bucket is idle for a long time")
+		{
+			REQUIRE(bucket.take(0));
+			REQUIRE(bucket.available(100000));
+
+			THEN("the number of tokens doesn't exceed its capacity")
+			{
+				REQUIRE(bucket.tokens() == 3);
+			}
+		}
 	}
 }
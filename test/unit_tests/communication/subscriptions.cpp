@@ -0,0 +1,403 @@
+/**
+ ******************************************************************************
+  Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation, either
+  version 3 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************
+ */
+
+#include "messages.h"
+#include "subscriptions.h"
+#include "forward_message_channel.h"
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace particle::protocol;
+
+namespace {
+
+std::vector<std::string> calls;
+
+void handler_a(const char* name, const char* data) {
+	calls.push_back(std::string("a:") + name);
+}
+
+void handler_b(const char* name, const char* data) {
+	calls.push_back(std::string("b:") + name);
+}
+
+void handler_c(const char* name, const char* data) {
+	calls.push_back(std::string("c:") + name);
+}
+
+// Encodes a non-confirmable event message with the given name
+size_t event_message(uint8_t* buf, const char* name) {
+	return Messages::event(buf, 0, name, "data", 60, EventType::PUBLIC, false);
+}
+
+} // namespace
+
+SCENARIO("dispatching events to subscription handlers")
+{
+	GIVEN("handlers subscribed to overlapping filters")
+	{
+		calls.clear();
+		Subscriptions subscriptions;
+		ForwardMessageChannel channel;
+		REQUIRE(subscriptions.add_event_handler("temp", handler_a, nullptr, SubscriptionScope::FIREHOSE, nullptr) == NO_ERROR);
+		REQUIRE(subscriptions.add_event_handler("", handler_b, nullptr, SubscriptionScope::FIREHOSE, nullptr) == NO_ERROR);
+		REQUIRE(subscriptions.add_event_handler("temp/kitchen", handler_c, nullptr, SubscriptionScope::FIREHOSE, nullptr) == NO_ERROR);
+
+		uint8_t buf[128];
+
+		WHEN("an event matching all filters is received")
+		{
+			Message message(buf, sizeof(buf) - 1, event_message(buf, "temp/kitchen/1"));
+			REQUIRE(subscriptions.handle_event(message, nullptr, channel) == NO_ERROR);
+			THEN("all handlers are invoked in the order of their registration")
+			{
+				REQUIRE(calls == std::vector<std::string>({ "a:temp/kitchen/1", "b:temp/kitchen/1", "c:temp/kitchen/1" }));
+			}
+		}
+
+		WHEN("an event matching some of the filters is received")
+		{
+			Message message(buf, sizeof(buf) - 1, event_message(buf, "temp/garage"));
+			REQUIRE(subscriptions.handle_event(message, nullptr, channel) == NO_ERROR);
+			THEN("only the matching handlers are invoked")
+			{
+				REQUIRE(calls == std::vector<std::string>({ "a:temp/garage", "b:temp/garage" }));
+			}
+		}
+
+		WHEN("a handler is removed")
+		{
+			subscriptions.remove_event_handlers("temp");
+			Message message(buf, sizeof(buf) - 1, event_message(buf, "temp/kitchen"));
+			REQUIRE(subscriptions.handle_event(message, nullptr, channel) == NO_ERROR);
+			THEN("the remaining handlers are still matched")
+			{
+				REQUIRE(calls == std::vector<std::string>({ "b:temp/kitchen", "c:temp/kitchen" }));
+			}
+		}
+	}
+}
+
+namespace {
+
+struct BinaryCall {
+	std::string name;
+	std::string data;
+	int content_type;
+};
+
+std::vector<BinaryCall> binary_calls;
+
+void binary_handler(void* handler_data, const char* name, const char* data, size_t data_size, int content_type) {
+	binary_calls.push_back({ name, std::string(data, data_size), content_type });
+}
+
+std::vector<ReceivedEventInfo> infos;
+
+void call_event_handler(uint16_t size, FilteringEventHandler* handler, const char* event, const char* data,
+		void* reserved) {
+	infos.push_back(*static_cast<const ReceivedEventInfo*>(reserved));
+}
+
+// Encodes a non-confirmable event message with binary data
+size_t binary_event_message(uint8_t* buf, const char* name, const std::string& data, int content_type, int ttl) {
+	const size_t len = Messages::event_header(buf, 0, name, true, ttl, EventType::PRIVATE, false, content_type);
+	memcpy(buf + len, data.data(), data.size());
+	return len + data.size();
+}
+
+} // namespace
+
+SCENARIO("dispatching events with binary data")
+{
+	GIVEN("a binary and a string handler")
+	{
+		calls.clear();
+		binary_calls.clear();
+		infos.clear();
+		Subscriptions subscriptions;
+		ForwardMessageChannel channel;
+		REQUIRE(subscriptions.add_event_handler("bin", (EventHandler)binary_handler, nullptr, SubscriptionScope::FIREHOSE, nullptr,
+				EVENT_HANDLER_FLAG_BINARY) == NO_ERROR);
+		REQUIRE(subscriptions.add_event_handler("bin", handler_a, nullptr, SubscriptionScope::FIREHOSE, nullptr) == NO_ERROR);
+
+		uint8_t buf[128];
+		const std::string data("\x01\x00\xff\x00z", 5);
+
+		WHEN("an event with a content format and a TTL is received")
+		{
+			Message message(buf, sizeof(buf) - 1, binary_event_message(buf, "bin/x", data, ContentType::BINARY, 3600));
+			REQUIRE(subscriptions.handle_event(message, nullptr, channel) == NO_ERROR);
+			THEN("the binary handler receives all of the data and its content format")
+			{
+				REQUIRE(binary_calls.size() == 1);
+				REQUIRE(binary_calls[0].name == "bin/x");
+				REQUIRE(binary_calls[0].data == data);
+				REQUIRE(binary_calls[0].content_type == ContentType::BINARY);
+				REQUIRE(calls == std::vector<std::string>({ "a:bin/x" }));
+			}
+		}
+
+		WHEN("an event with a two-byte content format is received")
+		{
+			Message message(buf, sizeof(buf) - 1, binary_event_message(buf, "bin", data, 0x1234, 60));
+			REQUIRE(subscriptions.handle_event(message, nullptr, channel) == NO_ERROR);
+			THEN("the content format is decoded")
+			{
+				REQUIRE(binary_calls.size() == 1);
+				REQUIRE(binary_calls[0].data == data);
+				REQUIRE(binary_calls[0].content_type == 0x1234);
+			}
+		}
+
+		WHEN("an event without a content format is received")
+		{
+			Message message(buf, sizeof(buf) - 1, event_message(buf, "bin"));
+			REQUIRE(subscriptions.handle_event(message, nullptr, channel) == NO_ERROR);
+			THEN("the data is reported as text")
+			{
+				REQUIRE(binary_calls.size() == 1);
+				REQUIRE(binary_calls[0].data == "data");
+				REQUIRE(binary_calls[0].content_type == ContentType::TEXT);
+			}
+		}
+
+		WHEN("the handlers are invoked via a callback")
+		{
+			Message message(buf, sizeof(buf) - 1, binary_event_message(buf, "bin", data, ContentType::CBOR, 60));
+			REQUIRE(subscriptions.handle_event(message, call_event_handler, channel) == NO_ERROR);
+			THEN("the callback receives the size and content format of the data")
+			{
+				REQUIRE(infos.size() == 2);
+				for (const auto& info: infos) {
+					REQUIRE(info.size == sizeof(ReceivedEventInfo));
+					REQUIRE(info.data_size == data.size());
+					REQUIRE(info.content_type == ContentType::CBOR);
+				}
+			}
+		}
+	}
+}
+
+namespace {
+
+// Encodes a non-confirmable event message with the given name and data
+size_t event_message(uint8_t* buf, const char* name, const char* data) {
+	return Messages::event(buf, 0, name, data, 60, EventType::PUBLIC, false);
+}
+
+FilteringEventHandler filtered_handler(const char* filter, uint8_t flags, const char* data_filter) {
+	FilteringEventHandler h = {};
+	strcpy(h.filter, filter);
+	h.scope = SubscriptionScope::FIREHOSE;
+	h.flags = flags;
+	if (data_filter) {
+		strcpy(h.data_filter, data_filter);
+	}
+	return h;
+}
+
+} // namespace
+
+SCENARIO("dispatching events to filtered subscription handlers")
+{
+	GIVEN("handlers with matching criteria")
+	{
+		calls.clear();
+		Subscriptions subscriptions;
+		ForwardMessageChannel channel;
+		REQUIRE(subscriptions.add_event_handler("door", handler_a, nullptr, SubscriptionScope::FIREHOSE, nullptr,
+				EVENT_HANDLER_FLAG_EXACT_NAME) == NO_ERROR);
+		REQUIRE(subscriptions.add_event_handler("door", handler_b, nullptr, SubscriptionScope::FIREHOSE, nullptr,
+				EVENT_HANDLER_FLAG_DATA_PREFIX, "open") == NO_ERROR);
+		REQUIRE(subscriptions.add_event_handler("door", handler_c, nullptr, SubscriptionScope::FIREHOSE, nullptr,
+				EVENT_HANDLER_FLAG_DATA_CONTAINS, "front") == NO_ERROR);
+
+		uint8_t buf[128];
+
+		WHEN("an event with the exact name is received")
+		{
+			Message message(buf, sizeof(buf) - 1, event_message(buf, "door", "closed"));
+			REQUIRE(subscriptions.handle_event(message, nullptr, channel) == NO_ERROR);
+			THEN("only the handler whose data criterion is not satisfied is skipped")
+			{
+				REQUIRE(calls == std::vector<std::string>({ "a:door" }));
+			}
+		}
+
+		WHEN("an event whose name starts with the filter is received")
+		{
+			Message message(buf, sizeof(buf) - 1, event_message(buf, "door/back", "opened front"));
+			REQUIRE(subscriptions.handle_event(message, nullptr, channel) == NO_ERROR);
+			THEN("the exact name handler is not invoked")
+			{
+				REQUIRE(calls == std::vector<std::string>({ "b:door/back", "c:door/back" }));
+			}
+		}
+
+		WHEN("the data only contains the prefix of one of the handlers")
+		{
+			Message message(buf, sizeof(buf) - 1, event_message(buf, "doors", "is open"));
+			REQUIRE(subscriptions.handle_event(message, nullptr, channel) == NO_ERROR);
+			THEN("no handler is invoked")
+			{
+				REQUIRE(calls.empty());
+			}
+		}
+
+		WHEN("the same handler is added with different criteria")
+		{
+			REQUIRE(subscriptions.add_event_handler("door", handler_b, nullptr, SubscriptionScope::FIREHOSE, nullptr,
+					EVENT_HANDLER_FLAG_DATA_PREFIX, "close") == NO_ERROR);
+			Message message(buf, sizeof(buf) - 1, event_message(buf, "door/1", "closed"));
+			REQUIRE(subscriptions.handle_event(message, nullptr, channel) == NO_ERROR);
+			THEN("it is registered as a separate subscription")
+			{
+				REQUIRE(calls == std::vector<std::string>({ "b:door/1" }));
+			}
+		}
+	}
+}
+
+SCENARIO("encoding the matching criteria of a subscription")
+{
+	uint8_t buf[128];
+
+	GIVEN("a handler without matching criteria")
+	{
+		const auto h = filtered_handler("temp", 0, nullptr);
+		THEN("the message is the same as a plain subscription")
+		{
+			uint8_t expected[128];
+			const size_t len = subscription(expected, 0, "temp", SubscriptionScope::FIREHOSE);
+			REQUIRE(subscription(buf, 0, h) == len);
+			REQUIRE(!memcmp(buf, expected, len));
+		}
+	}
+
+	GIVEN("a handler matching the exact name and a data prefix")
+	{
+		auto h = filtered_handler("temp", EVENT_HANDLER_FLAG_EXACT_NAME | EVENT_HANDLER_FLAG_DATA_PREFIX, "hot");
+		h.scope = SubscriptionScope::MY_DEVICES;
+		THEN("the criteria are encoded as Uri-Query options")
+		{
+			const size_t len = subscription(buf, 0x1234, h);
+			const std::string msg((const char*)buf, len);
+			REQUIRE(msg == std::string("\x40\x01\x12\x34\xb1" "e" "\x04" "temp" "\x41" "u" "\x01" "x" "\x06" "dp=hot", 22));
+		}
+	}
+
+	GIVEN("a device-scoped handler with a long data substring")
+	{
+		auto h = filtered_handler("temp", EVENT_HANDLER_FLAG_DATA_CONTAINS, "abcdefghijkl");
+		h.scope = SubscriptionScope::MY_DEVICES;
+		strcpy(h.device_id, "0123456789ab");
+		THEN("the option length is extended and the device ID is sent as the payload")
+		{
+			const size_t len = subscription(buf, 0, h);
+			const std::string msg((const char*)buf, len);
+			REQUIRE(msg == std::string("\x40\x01\x00\x00\xb1" "e" "\x04" "temp" "\x4d\x02" "dc=abcdefghijkl" "\xff" "0123456789ab", 41));
+		}
+	}
+}
+
+namespace {
+
+int crc_calls = 0;
+
+// Simple order-dependent hash standing in for the CRC callback
+uint32_t counting_crc(const unsigned char* buf, uint32_t len) {
+	++crc_calls;
+	uint32_t h = 2166136261u;
+	for (uint32_t i = 0; i < len; ++i) {
+		h = (h ^ buf[i]) * 16777619u;
+	}
+	return h;
+}
+
+} // namespace
+
+SCENARIO("computing the subscriptions checksum")
+{
+	GIVEN("a set of subscription handlers")
+	{
+		crc_calls = 0;
+		Subscriptions subscriptions;
+		REQUIRE(subscriptions.add_event_handler("temp", handler_a, nullptr, SubscriptionScope::FIREHOSE, nullptr) == NO_ERROR);
+		const uint32_t checksum = subscriptions.compute_subscriptions_checksum(counting_crc);
+		const int calls = crc_calls;
+		REQUIRE(calls > 0);
+
+		WHEN("the handlers don't change")
+		{
+			THEN("the checksum is not recomputed")
+			{
+				REQUIRE(subscriptions.compute_subscriptions_checksum(counting_crc) == checksum);
+				REQUIRE(crc_calls == calls);
+			}
+		}
+
+		WHEN("a handler is added")
+		{
+			REQUIRE(subscriptions.add_event_handler("humidity", handler_b, nullptr, SubscriptionScope::FIREHOSE, nullptr) == NO_ERROR);
+			THEN("the checksum changes")
+			{
+				REQUIRE(subscriptions.compute_subscriptions_checksum(counting_crc) != checksum);
+			}
+		}
+
+		WHEN("an existing handler is added again")
+		{
+			REQUIRE(subscriptions.add_event_handler("temp", handler_a, nullptr, SubscriptionScope::FIREHOSE, nullptr) == NO_ERROR);
+			THEN("the checksum is unchanged")
+			{
+				REQUIRE(subscriptions.compute_subscriptions_checksum(counting_crc) == checksum);
+			}
+		}
+
+		WHEN("a handler with matching criteria is added")
+		{
+			REQUIRE(subscriptions.add_event_handler("humidity", handler_b, nullptr, SubscriptionScope::FIREHOSE, nullptr,
+					EVENT_HANDLER_FLAG_DATA_PREFIX, "high") == NO_ERROR);
+			const uint32_t prefix_checksum = subscriptions.compute_subscriptions_checksum(counting_crc);
+			subscriptions.remove_event_handlers("humidity");
+			REQUIRE(subscriptions.add_event_handler("humidity", handler_b, nullptr, SubscriptionScope::FIREHOSE, nullptr) == NO_ERROR);
+			const uint32_t plain_checksum = subscriptions.compute_subscriptions_checksum(counting_crc);
+			THEN("the checksum depends on the criteria")
+			{
+				REQUIRE(plain_checksum != checksum);
+				REQUIRE(prefix_checksum != plain_checksum);
+			}
+		}
+
+		WHEN("a handler is added and removed")
+		{
+			REQUIRE(subscriptions.add_event_handler("humidity", handler_b, nullptr, SubscriptionScope::FIREHOSE, nullptr) == NO_ERROR);
+			REQUIRE(subscriptions.compute_subscriptions_checksum(counting_crc) != checksum);
+			subscriptions.remove_event_handlers("humidity");
+			THEN("the checksum is the same as before")
+			{
+				REQUIRE(subscriptions.compute_subscriptions_checksum(counting_crc) == checksum);
+			}
+		}
+	}
+}
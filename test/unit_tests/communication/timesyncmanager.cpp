@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "timesyncmanager.h"
+
+#include <catch2/catch.hpp>
+
+#include <vector>
+
+using namespace particle::protocol;
+
+namespace {
+
+struct TimeSource {
+    int result;
+    time_t time;
+    unsigned calls;
+};
+
+int timeSource(time_t* time, void* data) {
+    const auto src = static_cast<TimeSource*>(data);
+    ++src->calls;
+    if (src->result < 0) {
+        return src->result;
+    }
+    *time = src->time;
+    return 0;
+}
+
+struct SetTime {
+    std::vector<std::pair<time_t, unsigned>> calls;
+
+    void operator()(time_t tm, unsigned param, void*) {
+        calls.push_back(std::make_pair(tm, param));
+    }
+};
+
+} // namespace
+
+TEST_CASE("TimeSyncManager local time sources")
+{
+    TimeSyncManager mgr;
+    TimeSource src1 = { SYSTEM_ERROR_NOT_FOUND, 0, 0 };
+    TimeSource src2 = { 0, 1600000000, 0 };
+    SetTime setTime;
+
+    SECTION("fails without sources")
+    {
+        CHECK_FALSE(mgr.sync_local(1000, std::ref(setTime)));
+        CHECK(setTime.calls.empty());
+    }
+
+    SECTION("uses the first source that provides the time")
+    {
+        REQUIRE(mgr.add_source(timeSource, &src1) == 0);
+        REQUIRE(mgr.add_source(timeSource, &src2) == 0);
+        CHECK(mgr.sync_local(1000, std::ref(setTime)));
+        CHECK(src1.calls == 1);
+        CHECK(src2.calls == 1);
+        REQUIRE(setTime.calls.size() == 1);
+        CHECK(setTime.calls[0].first == 1600000000);
+        CHECK(setTime.calls[0].second == 2); // 1-based index of the source
+        time_t tm = 0;
+        CHECK(mgr.last_sync(tm) == 1000);
+        CHECK(tm == 1600000000);
+        CHECK_FALSE(mgr.is_request_pending());
+
+        src1 = { 0, 1600000100, 0 };
+        src2.calls = 0;
+        CHECK(mgr.sync_local(2000, std::ref(setTime)));
+        CHECK(src2.calls == 0);
+        REQUIRE(setTime.calls.size() == 2);
+        CHECK(setTime.calls[1].first == 1600000100);
+        CHECK(setTime.calls[1].second == 1);
+    }
+
+    SECTION("ignores invalid times")
+    {
+        src2.time = 0;
+        REQUIRE(mgr.add_source(timeSource, &src2) == 0);
+        CHECK_FALSE(mgr.sync_local(1000, std::ref(setTime)));
+        CHECK(setTime.calls.empty());
+        time_t tm = 0;
+        CHECK(mgr.last_sync(tm) == 0);
+    }
+
+    SECTION("limits the number of sources")
+    {
+        for (unsigned i = 0; i < TimeSyncManager::MAX_TIME_SOURCES; ++i) {
+            REQUIRE(mgr.add_source(timeSource, &src1) == 0);
+        }
+        CHECK(mgr.add_source(timeSource, &src2) == SYSTEM_ERROR_TOO_LARGE);
+        CHECK(mgr.add_source(nullptr, nullptr) == SYSTEM_ERROR_INVALID_ARGUMENT);
+    }
+}
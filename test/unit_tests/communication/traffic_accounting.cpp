@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "traffic_accounting.h"
+#include "communication_diagnostic.h"
+#include "messages.h"
+
+#include <catch2/catch.hpp>
+
+using namespace particle::protocol;
+
+namespace {
+
+unsigned sent(TrafficClass::Enum cls) {
+	return *g_cloudBytesSentByClass[cls];
+}
+
+unsigned received(TrafficClass::Enum cls) {
+	return *g_cloudBytesReceivedByClass[cls];
+}
+
+} // namespace
+
+SCENARIO("TrafficAccounting attributes bytes to message classes")
+{
+	TrafficAccounting traffic;
+	uint8_t buf[128];
+
+	GIVEN("requests sent by the device")
+	{
+		const unsigned events = sent(TrafficClass::EVENT);
+		const unsigned pings = sent(TrafficClass::PING);
+		const unsigned ota = sent(TrafficClass::OTA);
+		const unsigned describe = sent(TrafficClass::DESCRIBE);
+
+		size_t n = Messages::event(buf, 0x1234, "test", "data", 60, EventType::PUBLIC, true);
+		traffic.sent(buf, n, n + 29);
+		n = Messages::ping(buf, 0x1235);
+		traffic.sent(buf, n, n + 29);
+		n = Messages::update_done(buf, 0x1236, true);
+		traffic.sent(buf, n, n + 29);
+		n = Messages::describe_post_header(buf, sizeof(buf), 0x1237, 0);
+		traffic.sent(buf, n, n + 29);
+
+		THEN("the bytes are attributed to the class of the request, including the record overhead")
+		{
+			CHECK(sent(TrafficClass::EVENT) - events == Messages::event(buf, 0x1234, "test", "data", 60, EventType::PUBLIC, true) + 29);
+			CHECK(sent(TrafficClass::PING) - pings == 4 + 29);
+			CHECK(sent(TrafficClass::OTA) - ota > 0);
+			CHECK(sent(TrafficClass::DESCRIBE) - describe > 0);
+		}
+
+		WHEN("the acknowledgements are received")
+		{
+			const unsigned received_events = received(TrafficClass::EVENT);
+			const unsigned received_pings = received(TrafficClass::PING);
+			n = Messages::empty_ack(buf, 0x12, 0x34);
+			traffic.received(buf, n, n + 29);
+			n = Messages::empty_ack(buf, 0x12, 0x35);
+			traffic.received(buf, n, n + 29);
+
+			THEN("they are attributed to the class of the acknowledged request")
+			{
+				CHECK(received(TrafficClass::EVENT) - received_events == 4 + 29);
+				CHECK(received(TrafficClass::PING) - received_pings == 4 + 29);
+			}
+		}
+	}
+
+	GIVEN("a function call received from the cloud")
+	{
+		const unsigned received_functions = received(TrafficClass::FUNCTION);
+		const unsigned sent_functions = sent(TrafficClass::FUNCTION);
+		// CON POST /f/fn with token 0x77
+		const uint8_t call[] = { 0x41, 0x02, 0x00, 0x07, 0x77, 0xb1, 'f', 0x02, 'f', 'n' };
+		traffic.received(call, sizeof(call), sizeof(call) + 29);
+
+		WHEN("the function result is sent in a separate response")
+		{
+			const size_t n = Messages::function_return(buf, 0x4321, 0x77, 1, true);
+			traffic.sent(buf, n, n + 29);
+
+			THEN("the request and the response are attributed to functions")
+			{
+				CHECK(received(TrafficClass::FUNCTION) - received_functions == sizeof(call) + 29);
+				CHECK(sent(TrafficClass::FUNCTION) - sent_functions == n + 29);
+			}
+		}
+	}
+
+	GIVEN("a handshake and an unparseable record")
+	{
+		const unsigned handshake = sent(TrafficClass::HANDSHAKE);
+		const unsigned other = received(TrafficClass::OTHER);
+		traffic.handshake(1000, 2000);
+		traffic.received(buf, 0, 45);
+
+		THEN("the bytes are attributed to the handshake and to other traffic respectively")
+		{
+			CHECK(sent(TrafficClass::HANDSHAKE) - handshake == 1000);
+			CHECK(received(TrafficClass::OTHER) - other == 45);
+		}
+	}
+}
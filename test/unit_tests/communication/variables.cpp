@@ -0,0 +1,449 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "variables.h"
+#include "protocol.h"
+
+#include <catch2/catch.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+using namespace particle;
+using namespace particle::protocol;
+
+namespace {
+
+// Message channel that records sent messages
+class TestChannel: public MessageChannel {
+public:
+    TestChannel() :
+            buf_() {
+    }
+
+    bool is_unreliable() override {
+        return false;
+    }
+
+    ProtocolError send(Message& msg) override {
+        if (msg.has_id() && msg.length() >= 4) {
+            msg.buf()[2] = msg.get_id() >> 8;
+            msg.buf()[3] = msg.get_id() & 0xff;
+        }
+        sent_.push_back(std::string((const char*)msg.buf(), msg.length()));
+        return ProtocolError::NO_ERROR;
+    }
+
+    ProtocolError receive(Message& msg) override {
+        return ProtocolError::NO_ERROR;
+    }
+
+    ProtocolError create(Message& msg, size_t size) override {
+        msg.set_buffer(buf_, sizeof(buf_));
+        return ProtocolError::NO_ERROR;
+    }
+
+    ProtocolError establish(uint32_t& flags, uint32_t app_state_crc) override {
+        return ProtocolError::NO_ERROR;
+    }
+
+    ProtocolError response(Message& original, Message& response, size_t required) override {
+        return ProtocolError::NO_ERROR;
+    }
+
+    ProtocolError command(Command cmd, void* arg) override {
+        return ProtocolError::NO_ERROR;
+    }
+
+    ProtocolError notify_established() override {
+        return ProtocolError::NO_ERROR;
+    }
+
+    void notify_client_messages_processed() override {
+    }
+
+    const std::vector<std::string>& sent() const {
+        return sent_;
+    }
+
+private:
+    uint8_t buf_[256];
+    std::vector<std::string> sent_;
+};
+
+class TestProtocol: public Protocol {
+public:
+    explicit TestProtocol(MessageChannel& channel) :
+            Protocol(channel) {
+    }
+
+    size_t build_hello(Message& message, uint8_t flags) override {
+        return 0;
+    }
+
+    int command(ProtocolCommands::Enum command, uint32_t data) override {
+        return 0;
+    }
+
+    void init(const char* id, const SparkKeys& keys, const SparkCallbacks& callbacks,
+            const SparkDescriptor& descriptor) override {
+        Protocol::init(callbacks, descriptor);
+    }
+
+    int get_status(protocol_status* status) const override {
+        status->flags = 0;
+        return 0;
+    }
+};
+
+struct Variable {
+    const char* name;
+    SparkReturnType::Enum type;
+    const void* value;
+};
+
+bool boolValue = true;
+int intValue = 0x01020304;
+std::string stringValue = "abc";
+
+const Variable VARIABLES[] = {
+    { "b", SparkReturnType::BOOLEAN, &boolValue },
+    { "i", SparkReturnType::INT, &intValue },
+    { "str", SparkReturnType::STRING, nullptr }
+};
+
+const Variable* findVariable(const char* name) {
+    for (const auto& v: VARIABLES) {
+        if (strcmp(v.name, name) == 0) {
+            return &v;
+        }
+    }
+    return nullptr;
+}
+
+const void* variableValue(const Variable& v) {
+    return (v.type == SparkReturnType::STRING) ? stringValue.c_str() : v.value;
+}
+
+int numVariables() {
+    return sizeof(VARIABLES) / sizeof(VARIABLES[0]);
+}
+
+const char* getVariableKey(int index) {
+    return VARIABLES[index].name;
+}
+
+SparkReturnType::Enum variableType(const char* name) {
+    const auto v = findVariable(name);
+    return v ? v->type : SparkReturnType::INT;
+}
+
+const void* getVariable(const char* name) {
+    const auto v = findVariable(name);
+    return v ? variableValue(*v) : nullptr;
+}
+
+bool getVariableObserveOptions(const char* name, uint32_t* interval, double* threshold) {
+    if (strcmp(name, "i") == 0) {
+        *interval = 5000;
+        *threshold = 10;
+        return true;
+    }
+    if (strcmp(name, "str") == 0) {
+        *interval = 1000;
+        *threshold = 0;
+        return true;
+    }
+    return false;
+}
+
+// Callbacks of the variable requests that are completed asynchronously
+bool deferCallbacks = false;
+std::vector<std::function<void()>> deferredCallbacks;
+
+void getVariableAsync(const char* name, SparkDescriptor::GetVariableCallback callback, void* context) {
+    if (deferCallbacks) {
+        const std::string n(name);
+        deferredCallbacks.push_back([=]() {
+            deferCallbacks = false;
+            getVariableAsync(n.c_str(), callback, context);
+            deferCallbacks = true;
+        });
+        return;
+    }
+    const auto v = findVariable(name);
+    if (!v) {
+        callback(ProtocolError::NOT_FOUND, 0, nullptr, 0, context);
+        return;
+    }
+    size_t size = 0;
+    switch (v->type) {
+    case SparkReturnType::BOOLEAN:
+        size = sizeof(bool);
+        break;
+    case SparkReturnType::INT:
+        size = sizeof(int);
+        break;
+    default:
+        size = stringValue.size();
+        break;
+    }
+    void* data = malloc(size);
+    memcpy(data, variableValue(*v), size);
+    callback(ProtocolError::NO_ERROR, v->type, data, size, context);
+}
+
+std::string entry(const std::string& name, int type, const std::string& value) {
+    std::string s;
+    s += (char)name.size();
+    s += name;
+    s += (char)type;
+    s += (char)(value.size() >> 8);
+    s += (char)(value.size() & 0xff);
+    s += value;
+    return s;
+}
+
+// Returns the value of the Observe option of a response message, or -1 if there's no such option
+int observeSeq(const std::string& msg) {
+    const size_t pos = 4 + (msg[0] & 0x0f);
+    if (pos >= msg.size() || (uint8_t)msg[pos] != 0x63) { // Option 6 of length 3
+        return -1;
+    }
+    return ((uint8_t)msg[pos + 1] << 16) | ((uint8_t)msg[pos + 2] << 8) | (uint8_t)msg[pos + 3];
+}
+
+// Returns true if the message is an ACK of the request message
+bool isAck(const std::string& msg) {
+    return msg.size() >= 4 && (((uint8_t)msg[0] >> 4) & 0x03) == CoAPType::ACK &&
+            (uint8_t)msg[2] == 0x12 && (uint8_t)msg[3] == 0x34;
+}
+
+// Returns the payload of a response message
+std::string payload(const std::string& msg) {
+    const auto pos = msg.find('\xff');
+    return (pos == std::string::npos) ? std::string() : msg.substr(pos + 1);
+}
+
+class VariablesTest {
+public:
+    explicit VariablesTest(bool async = true) :
+            protocol_(channel_),
+            vars_(&protocol_) {
+        SparkCallbacks callbacks = {};
+        callbacks.size = sizeof(callbacks);
+        SparkDescriptor descriptor = {};
+        descriptor.size = sizeof(descriptor);
+        descriptor.num_variables = numVariables;
+        descriptor.get_variable_key = getVariableKey;
+        descriptor.variable_type = variableType;
+        descriptor.get_variable = getVariable;
+        descriptor.get_variable_observe_options = getVariableObserveOptions;
+        if (async) {
+            descriptor.get_variable_async = getVariableAsync;
+        }
+        protocol_.init(nullptr, SparkKeys(), callbacks, descriptor);
+    }
+
+    // Sends a GET request with the specified path segments and query options
+    VariablesTest& request(const std::vector<std::string>& path, const std::vector<std::string>& query = {},
+            size_t capacity = 256) {
+        std::string s("\x41\x01\x12\x34T", 5); // CON GET, message ID 0x1234, token 'T'
+        unsigned opt = 0;
+        for (const auto& p: path) {
+            s += (char)(((CoAPOption::URI_PATH - opt) << 4) | p.size());
+            s += p;
+            opt = CoAPOption::URI_PATH;
+        }
+        for (const auto& q: query) {
+            s += (char)(((CoAPOption::URI_QUERY - opt) << 4) | q.size());
+            s += q;
+            opt = CoAPOption::URI_QUERY;
+        }
+        REQUIRE(s.size() <= capacity);
+        req_.assign(capacity, '\0');
+        memcpy(&req_[0], s.data(), s.size());
+        Message msg((uint8_t*)&req_[0], capacity, s.size());
+        REQUIRE(vars_.handle_request(msg, 'T', 0x1234) == ProtocolError::NO_ERROR);
+        return *this;
+    }
+
+    VariablesTest& process(system_tick_t millis) {
+        REQUIRE(vars_.process(millis) == ProtocolError::NO_ERROR);
+        return *this;
+    }
+
+    void reset() {
+        vars_.reset();
+    }
+
+    const std::vector<std::string>& sent() const {
+        return channel_.sent();
+    }
+
+private:
+    TestChannel channel_;
+    TestProtocol protocol_;
+    std::string req_;
+    Variables vars_;
+};
+
+} // namespace
+
+TEST_CASE("Variables") {
+    const std::string intData("\x01\x02\x03\x04", 4); // Big-endian
+    SECTION("a single variable can be requested") {
+        VariablesTest t;
+        t.request({ "v", "i" });
+        REQUIRE(t.sent().size() == 1); // The response is sent in the ACK
+        CHECK(isAck(t.sent()[0]));
+        CHECK((uint8_t)t.sent()[0][1] == CoAPCode::CONTENT);
+        CHECK(t.sent()[0][4] == 'T');
+        CHECK(payload(t.sent()[0]) == intData);
+    }
+    SECTION("a variable that is read asynchronously is sent in a separate response") {
+        VariablesTest t;
+        deferCallbacks = true;
+        t.request({ "v", "i" });
+        REQUIRE(t.sent().size() == 1); // Empty ACK
+        CHECK(isAck(t.sent()[0]));
+        CHECK((uint8_t)t.sent()[0][1] == CoAPCode::EMPTY);
+        REQUIRE(deferredCallbacks.size() == 1);
+        deferredCallbacks[0]();
+        REQUIRE(t.sent().size() == 2);
+        CHECK_FALSE(isAck(t.sent()[1]));
+        CHECK((uint8_t)t.sent()[1][1] == CoAPCode::CONTENT);
+        CHECK(payload(t.sent()[1]) == intData);
+        deferCallbacks = false;
+        deferredCallbacks.clear();
+    }
+    SECTION("an error is sent in the ACK if the variable is not found") {
+        VariablesTest t;
+        t.request({ "v", "unknown" });
+        REQUIRE(t.sent().size() == 1);
+        CHECK(isAck(t.sent()[0]));
+        CHECK((uint8_t)t.sent()[0][1] == CoAPCode::NOT_FOUND);
+    }
+    SECTION("a single variable can be requested via the compatibility callback") {
+        VariablesTest t(false /* async */);
+        t.request({ "v", "str" });
+        REQUIRE(t.sent().size() == 1);
+        CHECK(isAck(t.sent()[0]));
+        CHECK(payload(t.sent()[0]) == "abc");
+    }
+    SECTION("all variables can be requested in one request") {
+        VariablesTest t;
+        t.request({ "v" });
+        REQUIRE(t.sent().size() == 1);
+        CHECK(isAck(t.sent()[0]));
+        CHECK((uint8_t)t.sent()[0][1] == CoAPCode::CONTENT);
+        CHECK(payload(t.sent()[0]) == entry("b", SparkReturnType::BOOLEAN, "\x01") +
+                entry("i", SparkReturnType::INT, intData) + entry("str", SparkReturnType::STRING, "abc"));
+    }
+    SECTION("a set of variables can be requested in one request") {
+        VariablesTest t;
+        t.request({ "v" }, { "str", "unknown", "b" });
+        REQUIRE(t.sent().size() == 1);
+        CHECK(payload(t.sent()[0]) == entry("str", SparkReturnType::STRING, "abc") + entry("unknown", 0, "") +
+                entry("b", SparkReturnType::BOOLEAN, "\x01"));
+    }
+    SECTION("a bulk request can be handled via the compatibility callback") {
+        VariablesTest t(false /* async */);
+        t.request({ "v" }, { "i", "str" });
+        REQUIRE(t.sent().size() == 1);
+        CHECK(isAck(t.sent()[0]));
+        CHECK(payload(t.sent()[0]) == entry("i", SparkReturnType::INT, intData) +
+                entry("str", SparkReturnType::STRING, "abc"));
+    }
+    SECTION("a bulk request fails if the response doesn't fit in one message") {
+        stringValue = std::string(100, 'x');
+        VariablesTest t;
+        t.request({ "v" }, {}, 64 /* capacity */);
+        REQUIRE(t.sent().size() == 1);
+        CHECK((uint8_t)t.sent()[0][1] == CoAPCode::REQUEST_ENTITY_TOO_LARGE);
+        CHECK(payload(t.sent()[0]).empty());
+        stringValue = "abc";
+    }
+    SECTION("an observable variable can be observed") {
+        VariablesTest t;
+        t.request({ "v", "i" }, { "o=1" });
+        REQUIRE(t.sent().size() == 1); // Empty ACK
+        t.process(0);
+        REQUIRE(t.sent().size() == 2); // Initial notification
+        CHECK((uint8_t)t.sent()[1][1] == CoAPCode::CONTENT);
+        CHECK(t.sent()[1][4] == 'T');
+        CHECK(observeSeq(t.sent()[1]) == 1);
+        CHECK(payload(t.sent()[1]) == intData);
+        // The value hasn't changed
+        t.process(10000);
+        CHECK(t.sent().size() == 2);
+        // The change is below the threshold
+        intValue += 5;
+        t.process(20000);
+        CHECK(t.sent().size() == 2);
+        // The minimum interval hasn't passed yet
+        intValue += 5;
+        t.process(21000);
+        CHECK(t.sent().size() == 2);
+        t.process(25000);
+        REQUIRE(t.sent().size() == 3);
+        CHECK(observeSeq(t.sent()[2]) == 2);
+        CHECK(payload(t.sent()[2]) == std::string("\x01\x02\x03\x0e", 4));
+        // Cancel the observation
+        intValue += 100;
+        t.request({ "v", "i" }, { "o=0" });
+        REQUIRE(t.sent().size() == 4); // Regular response
+        CHECK(isAck(t.sent()[3]));
+        CHECK(observeSeq(t.sent()[3]) == -1);
+        t.process(40000);
+        CHECK(t.sent().size() == 4);
+        intValue = 0x01020304;
+    }
+    SECTION("any change of a string variable triggers a notification") {
+        VariablesTest t(false /* async */);
+        t.request({ "v", "str" }, { "o=1" });
+        t.process(0);
+        REQUIRE(t.sent().size() == 2);
+        CHECK(payload(t.sent()[1]) == "abc");
+        t.process(1000);
+        CHECK(t.sent().size() == 2);
+        stringValue = "abd";
+        t.process(2000);
+        REQUIRE(t.sent().size() == 3);
+        CHECK(observeSeq(t.sent()[2]) == 2);
+        CHECK(payload(t.sent()[2]) == "abd");
+        stringValue = "abc";
+    }
+    SECTION("a variable that is not observable is read as usual") {
+        VariablesTest t;
+        t.request({ "v", "b" }, { "o=1" });
+        REQUIRE(t.sent().size() == 1);
+        CHECK(observeSeq(t.sent()[0]) == -1);
+        CHECK(payload(t.sent()[0]) == "\x01");
+        t.process(10000);
+        CHECK(t.sent().size() == 1);
+    }
+    SECTION("observations are cancelled when the session is reset") {
+        VariablesTest t;
+        t.request({ "v", "i" }, { "o=1" });
+        t.reset();
+        t.process(0);
+        CHECK(t.sent().size() == 1);
+    }
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "allocator.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstring>
+
+using namespace particle;
+
+namespace {
+
+const size_t ALIGNMENT = ArenaAllocator::ALIGNMENT;
+
+alignas(std::max_align_t) uint8_t g_buf[256];
+
+size_t aligned(size_t size) {
+    return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+} // unnamed
+
+TEST_CASE("ArenaAllocator") {
+    ArenaAllocator a(g_buf, sizeof(g_buf));
+
+    SECTION("allocates aligned blocks until the buffer is exhausted") {
+        CHECK(a.size() == sizeof(g_buf));
+        CHECK(a.used() == 0);
+        void* p1 = a.alloc(1);
+        void* p2 = a.alloc(3);
+        REQUIRE(p1 == g_buf);
+        REQUIRE(p2 == g_buf + ALIGNMENT);
+        CHECK(a.used() == 2 * ALIGNMENT);
+        CHECK(a.available() == sizeof(g_buf) - 2 * ALIGNMENT);
+        CHECK(a.alloc(a.available() + 1) == nullptr);
+        CHECK(a.failures() == 1);
+        CHECK(a.alloc(a.available()) != nullptr);
+        CHECK(a.available() == 0);
+        CHECK(a.alloc(1) == nullptr);
+        CHECK(a.maxUsed() == sizeof(g_buf));
+    }
+    SECTION("aligns the start of an unaligned buffer") {
+        ArenaAllocator a2(g_buf + 1, sizeof(g_buf) - 1);
+        CHECK(a2.size() == sizeof(g_buf) - ALIGNMENT);
+        CHECK((uintptr_t)a2.alloc(1) % ALIGNMENT == 0);
+    }
+    SECTION("releases all memory on reset") {
+        void* p1 = a.alloc(100);
+        a.alloc(100);
+        a.reset();
+        CHECK(a.used() == 0);
+        CHECK(a.maxUsed() == 2 * aligned(100));
+        CHECK(a.alloc(10) == p1);
+    }
+    SECTION("frees and resizes the most recent block in place") {
+        void* p1 = a.alloc(10);
+        void* p2 = a.alloc(10);
+        a.free(p1); // Not the most recent block
+        CHECK(a.used() == 2 * ALIGNMENT);
+        CHECK(a.realloc(p2, 100) == p2);
+        CHECK(a.used() == ALIGNMENT + aligned(100));
+        CHECK(a.realloc(p2, 1) == p2);
+        CHECK(a.used() == 2 * ALIGNMENT);
+        a.free(p2);
+        CHECK(a.used() == ALIGNMENT);
+    }
+    SECTION("copies the data of a block that can't be resized in place") {
+        auto p1 = (char*)a.alloc(8);
+        std::memcpy(p1, "abcdefg", 8);
+        a.alloc(8);
+        auto p2 = (char*)a.realloc(p1, 32);
+        REQUIRE(p2 != nullptr);
+        CHECK(p2 != p1);
+        CHECK(std::strcmp(p2, "abcdefg") == 0);
+        CHECK(a.realloc(nullptr, 8) != nullptr);
+    }
+    SECTION("rewinds to a saved position") {
+        a.alloc(10);
+        const auto m = a.mark();
+        {
+            ArenaScope scope(&a);
+            a.alloc(50);
+            a.alloc(50);
+            CHECK(a.used() == ALIGNMENT + 2 * aligned(50));
+        }
+        CHECK(a.used() == m);
+        a.alloc(10);
+        a.rewind(m);
+        CHECK(a.used() == ALIGNMENT);
+    }
+}
+
+TEST_CASE("StaticArenaAllocator") {
+    StaticArenaAllocator<128> a;
+    CHECK(a.size() == 128);
+    CHECK(a.alloc(128) != nullptr);
+    CHECK(a.alloc(1) == nullptr);
+}
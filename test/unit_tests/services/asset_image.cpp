@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "asset_image.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <utility>
+
+using namespace particle;
+
+namespace {
+
+// Builds an image in the same way as build/pack_assets.py
+std::string packAssets(std::vector<std::pair<std::string, std::string>> assets) {
+    std::sort(assets.begin(), assets.end());
+    const size_t namesOffs = sizeof(AssetImage::Header) + assets.size() * sizeof(AssetImage::Entry);
+    std::string names;
+    for (const auto& a: assets) {
+        names += a.first;
+        names += '\0';
+    }
+    size_t dataOffs = (namesOffs + names.size() + 7) & ~7;
+    std::string entries;
+    std::string data(dataOffs - namesOffs - names.size(), '\0');
+    size_t nameOffs = namesOffs;
+    for (const auto& a: assets) {
+        const AssetImage::Entry e = { (uint32_t)nameOffs, (uint32_t)dataOffs, (uint32_t)a.second.size(), 0 };
+        entries.append((const char*)&e, sizeof(e));
+        data += a.second;
+        nameOffs += a.first.size() + 1;
+        dataOffs += a.second.size();
+        const size_t pad = ((dataOffs + 7) & ~7) - dataOffs;
+        data.append(pad, '\0');
+        dataOffs += pad;
+    }
+    const AssetImage::Header h = { AssetImage::MAGIC, AssetImage::VERSION, (uint16_t)assets.size(),
+            (uint32_t)dataOffs, 0 };
+    return std::string((const char*)&h, sizeof(h)) + entries + names + data;
+}
+
+} // unnamed
+
+TEST_CASE("AssetImage") {
+    SECTION("assets can be found by name") {
+        const std::string img = packAssets({ { "b.txt", "bbb" }, { "a/c.bin", "0123456789" }, { "a.txt", "a" } });
+        const AssetImage image(img.data());
+        REQUIRE(image.isValid());
+        REQUIRE(image.count() == 3);
+        CHECK(std::string(image.name(0)) == "a.txt");
+        CHECK(std::string(image.name(1)) == "a/c.bin");
+        CHECK(std::string(image.name(2)) == "b.txt");
+        size_t size = 0;
+        const uint8_t* d = image.find("a/c.bin", &size);
+        REQUIRE(d);
+        CHECK(std::string((const char*)d, size) == "0123456789");
+        // the data points into the image itself
+        CHECK((const char*)d >= img.data());
+        CHECK((const char*)d + size <= img.data() + img.size());
+        CHECK(((d - (const uint8_t*)img.data()) % 8) == 0);
+        d = image.find("b.txt", &size);
+        REQUIRE(d);
+        CHECK(std::string((const char*)d, size) == "bbb");
+        d = image.find("a.txt", &size);
+        REQUIRE(d);
+        CHECK(std::string((const char*)d, size) == "a");
+        CHECK(image.find("c.txt") == nullptr);
+        CHECK(image.find("a") == nullptr);
+        CHECK(image.find("") == nullptr);
+    }
+    SECTION("an image can be empty") {
+        const std::string img = packAssets({});
+        const AssetImage image(img.data());
+        CHECK(image.isValid());
+        CHECK(image.count() == 0);
+        CHECK(image.find("a.txt") == nullptr);
+    }
+    SECTION("invalid images are treated as empty") {
+        std::string img = packAssets({ { "a.txt", "a" } });
+        img[0] = 'X';
+        const AssetImage image(img.data());
+        CHECK_FALSE(image.isValid());
+        CHECK(image.count() == 0);
+        CHECK(image.find("a.txt") == nullptr);
+        CHECK_FALSE(AssetImage(nullptr).isValid());
+    }
+    SECTION("module image is empty if the module has no assets") {
+        const AssetImage image = AssetImage::moduleImage();
+        CHECK_FALSE(image.isValid());
+        CHECK(image.count() == 0);
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "boot_timeline.h"
+#include "timer_hal.h"
+#include "system_error.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstring>
+
+namespace {
+
+system_tick_t g_micros = 0;
+
+} // namespace
+
+extern "C" system_tick_t HAL_Timer_Get_Micro_Seconds() {
+    return g_micros;
+}
+
+TEST_CASE("boot_timeline") {
+    boot_timeline t = {};
+
+    SECTION("records the time at which each stage is reached") {
+        g_micros = 10;
+        boot_timeline_mark(BOOT_STAGE_START, nullptr);
+        g_micros = 1500;
+        boot_timeline_mark(BOOT_STAGE_MODULE_INIT, nullptr);
+        g_micros = 20000;
+        boot_timeline_mark(BOOT_STAGE_SETUP, nullptr);
+        REQUIRE(boot_timeline_get(&t, 0, nullptr) == 0);
+        CHECK(t.stages == ((1 << BOOT_STAGE_START) | (1 << BOOT_STAGE_MODULE_INIT) | (1 << BOOT_STAGE_SETUP)));
+        CHECK(t.time[BOOT_STAGE_START] == 10);
+        CHECK(t.time[BOOT_STAGE_MODULE_INIT] == 1500);
+        CHECK(t.time[BOOT_STAGE_SETUP] == 20000);
+    }
+    SECTION("records only the first time a stage is reached") {
+        g_micros = 0;
+        boot_timeline_mark(BOOT_STAGE_START, nullptr);
+        g_micros = 100;
+        boot_timeline_mark(BOOT_STAGE_FILESYSTEM_MOUNT, nullptr);
+        g_micros = 200;
+        boot_timeline_mark(BOOT_STAGE_FILESYSTEM_MOUNT, nullptr);
+        REQUIRE(boot_timeline_get(&t, 0, nullptr) == 0);
+        CHECK(t.time[BOOT_STAGE_FILESYSTEM_MOUNT] == 100);
+    }
+    SECTION("keeps the timeline of the previous boot") {
+        g_micros = 0;
+        boot_timeline_mark(BOOT_STAGE_START, nullptr);
+        g_micros = 300;
+        boot_timeline_mark(BOOT_STAGE_DCT_LOAD, nullptr);
+        g_micros = 5;
+        boot_timeline_mark(BOOT_STAGE_START, nullptr);
+        REQUIRE(boot_timeline_get(&t, 1, nullptr) == 0);
+        CHECK(t.stages == ((1 << BOOT_STAGE_START) | (1 << BOOT_STAGE_DCT_LOAD)));
+        CHECK(t.time[BOOT_STAGE_DCT_LOAD] == 300);
+        REQUIRE(boot_timeline_get(&t, 0, nullptr) == 0);
+        CHECK(t.stages == (1 << BOOT_STAGE_START));
+        CHECK(t.time[BOOT_STAGE_START] == 5);
+    }
+    SECTION("ignores invalid stages") {
+        g_micros = 0;
+        boot_timeline_mark(BOOT_STAGE_START, nullptr);
+        boot_timeline_mark(BOOT_STAGE_COUNT, nullptr);
+        boot_timeline_mark(-1, nullptr);
+        REQUIRE(boot_timeline_get(&t, 0, nullptr) == 0);
+        CHECK(t.stages == (1 << BOOT_STAGE_START));
+    }
+    SECTION("returns the names of the stages") {
+        CHECK(strcmp(boot_stage_name(BOOT_STAGE_START), "start") == 0);
+        CHECK(strcmp(boot_stage_name(BOOT_STAGE_SETUP_DONE), "setup_done") == 0);
+        CHECK(boot_stage_name(BOOT_STAGE_COUNT) == nullptr);
+    }
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "coroutine.h"
+
+#include <catch2/catch.hpp>
+
+#include <string>
+
+using namespace particle;
+
+namespace {
+
+class Steps: public Coroutine {
+public:
+    std::string log;
+    bool flag = false;
+    int finishedCount = 0;
+
+protected:
+    void run() override {
+        CORO_BEGIN();
+        log += "a";
+        CORO_YIELD();
+        log += "b";
+        CORO_SLEEP(100);
+        log += "c";
+        CORO_AWAIT(flag);
+        log += "d";
+        CORO_SUSPEND();
+        log += "e";
+        CORO_END();
+    }
+
+    void finished() override {
+        ++finishedCount;
+    }
+};
+
+class Counter: public Coroutine {
+public:
+    int limit = 0;
+    int count = 0;
+
+protected:
+    void run() override {
+        CORO_BEGIN();
+        for (count = 0; count < limit; ++count) {
+            CORO_YIELD();
+        }
+        if (limit > 2) {
+            CORO_RETURN(SYSTEM_ERROR_LIMIT_EXCEEDED);
+        }
+        CORO_END();
+    }
+};
+
+int g_notifyCount = 0;
+
+void notify() {
+    ++g_notifyCount;
+}
+
+} // unnamed
+
+TEST_CASE("CoroutineScheduler") {
+    g_notifyCount = 0;
+    CoroutineScheduler sched(notify);
+
+    SECTION("resumes a coroutine at its suspension points") {
+        Steps s;
+        REQUIRE(sched.start(&s) == 0);
+        CHECK(s.isActive());
+        CHECK(g_notifyCount == 1);
+        CHECK(sched.start(&s) == SYSTEM_ERROR_INVALID_STATE);
+        CHECK(sched.process(0));
+        CHECK(s.log == "a");
+        CHECK(sched.count() == 1);
+        CHECK(sched.process(10));
+        CHECK(s.log == "ab");
+        // Sleeping for 100ms since t=10
+        CHECK_FALSE(sched.process(109));
+        CHECK(sched.process(110));
+        CHECK(s.log == "abc");
+        CHECK(sched.process(111));
+        CHECK(s.log == "abc");
+        s.flag = true;
+        CHECK(sched.process(112));
+        CHECK(s.log == "abcd");
+        CHECK_FALSE(sched.process(113));
+        CHECK_FALSE(sched.process(114));
+        s.wake();
+        CHECK(sched.process(115));
+        CHECK(s.log == "abcde");
+        CHECK_FALSE(s.isActive());
+        CHECK(s.finishedCount == 1);
+        CHECK(s.result() == 0);
+        CHECK(sched.count() == 0);
+        CHECK_FALSE(sched.process(116));
+    }
+
+    SECTION("doesn't suspend a coroutine that has been woken up before") {
+        Steps s;
+        s.flag = true;
+        sched.start(&s);
+        sched.process(0);
+        sched.process(0);
+        sched.process(100);
+        CHECK(s.log == "abcd");
+        s.wake();
+        sched.process(101);
+        CHECK(s.log == "abcde");
+    }
+
+    SECTION("runs several coroutines concurrently") {
+        Counter c1, c2, c3;
+        c1.limit = 1;
+        c2.limit = 2;
+        c3.limit = 3;
+        sched.start(&c1);
+        sched.start(&c2);
+        sched.start(&c3);
+        int n = 0;
+        while (sched.process(0)) {
+            ++n;
+        }
+        CHECK(n == 4);
+        CHECK(c1.result() == 0);
+        CHECK(c2.result() == 0);
+        CHECK(c3.result() == SYSTEM_ERROR_LIMIT_EXCEEDED);
+        CHECK(sched.count() == 0);
+        // A finished coroutine can be started again
+        c1.limit = 0;
+        REQUIRE(sched.start(&c1) == 0);
+        CHECK(sched.process(0));
+        CHECK_FALSE(c1.isActive());
+    }
+
+    SECTION("notifies the thread while a coroutine is ready to run") {
+        Counter c;
+        c.limit = 2;
+        sched.start(&c);
+        CHECK(g_notifyCount == 1);
+        sched.process(0);
+        CHECK(g_notifyCount == 2);
+        sched.process(0);
+        CHECK(g_notifyCount == 3);
+        sched.process(0);
+        CHECK(g_notifyCount == 3);
+    }
+
+    SECTION("cancels a coroutine") {
+        Steps s;
+        sched.start(&s);
+        sched.process(0);
+        s.cancel();
+        CHECK_FALSE(sched.process(1));
+        CHECK(s.log == "a");
+        CHECK_FALSE(s.isActive());
+        CHECK(s.result() == SYSTEM_ERROR_CANCELLED);
+        CHECK(s.finishedCount == 1);
+    }
+}
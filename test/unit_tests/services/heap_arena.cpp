@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "heap_arena.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <iterator>
+#include <set>
+#include <vector>
+
+using namespace particle;
+
+namespace {
+
+const size_t PAGE_SIZE = HeapArena::PAGE_SIZE;
+const size_t MAX_BLOCK_SIZE = HeapArena::MAX_BLOCK_SIZE;
+
+alignas(16) uint8_t g_buf[4 * 1024];
+
+} // unnamed
+
+TEST_CASE("HeapArena") {
+    HeapArena a;
+
+    SECTION("rejects a buffer that is too small for a page") {
+        CHECK_FALSE(a.isInitialized());
+        CHECK(a.alloc(1) == nullptr);
+        CHECK_FALSE(a.init(g_buf, PAGE_SIZE));
+        CHECK_FALSE(a.isInitialized());
+        REQUIRE(a.init(g_buf, sizeof(g_buf)));
+        CHECK(a.isInitialized());
+        CHECK(a.stats().pageCount > 0);
+        CHECK(a.stats().pageCount < sizeof(g_buf) / PAGE_SIZE);
+    }
+    SECTION("rounds requests up to the nearest size class") {
+        REQUIRE(a.init(g_buf, sizeof(g_buf)));
+        const size_t sizes[][2] = { { 0, 16 }, { 1, 16 }, { 16, 16 }, { 17, 32 }, { 33, 48 }, { 49, 64 },
+                { 65, 96 }, { 96, 96 }, { 97, 128 }, { 128, 128 } };
+        for (const auto& s: sizes) {
+            void* p = a.alloc(s[0]);
+            REQUIRE(p != nullptr);
+            CHECK(a.contains(p));
+            CHECK(a.blockSize(p) == s[1]);
+            CHECK((uintptr_t)p % HeapArena::BLOCK_ALIGN == 0);
+        }
+        CHECK(a.alloc(MAX_BLOCK_SIZE + 1) == nullptr);
+        // Too large requests are not counted as failures
+        CHECK(a.stats().failures == 0);
+    }
+    SECTION("returns empty pages to the pool") {
+        REQUIRE(a.init(g_buf, sizeof(g_buf)));
+        const auto s0 = a.stats();
+        CHECK(s0.freePages == s0.pageCount);
+        CHECK(s0.usedBytes == 0);
+        CHECK(s0.freeBytes == s0.pageCount * PAGE_SIZE);
+        void* p1 = a.alloc(10);
+        void* p2 = a.alloc(10);
+        void* p3 = a.alloc(100);
+        CHECK(a.stats().freePages == s0.pageCount - 2);
+        CHECK(a.stats().usedBytes == 16 + 16 + 128);
+        CHECK(a.stats().freeBytes == s0.freeBytes - 16 - 16 - 128);
+        a.free(p1);
+        CHECK(a.stats().freePages == s0.pageCount - 2);
+        a.free(p2);
+        CHECK(a.stats().freePages == s0.pageCount - 1);
+        a.free(p3);
+        CHECK(a.stats().freePages == s0.pageCount);
+        CHECK(a.stats().usedBytes == 0);
+        CHECK(a.stats().freeBytes == s0.freeBytes);
+    }
+    SECTION("reuses freed blocks and pages") {
+        REQUIRE(a.init(g_buf, sizeof(g_buf)));
+        std::set<void*> blocks;
+        // Fill the arena with the smallest blocks
+        for (;;) {
+            void* p = a.alloc(16);
+            if (!p) {
+                break;
+            }
+            std::memset(p, 0xaa, 16);
+            CHECK(blocks.insert(p).second);
+        }
+        CHECK(blocks.size() == a.stats().pageCount * (PAGE_SIZE / 16));
+        CHECK(a.stats().freePages == 0);
+        CHECK(a.stats().freeBytes == 0);
+        CHECK(a.stats().failures == 1);
+        CHECK(a.alloc(128) == nullptr);
+        // Free a page worth of blocks and allocate larger blocks instead
+        std::vector<void*> freed(blocks.begin(), std::next(blocks.begin(), PAGE_SIZE / 16));
+        for (void* p: freed) {
+            a.free(p);
+            blocks.erase(p);
+        }
+        CHECK(a.stats().freePages == 1);
+        for (size_t i = 0; i < PAGE_SIZE / 128; ++i) {
+            void* p = a.alloc(128);
+            REQUIRE(p != nullptr);
+            CHECK(a.blockSize(p) == 128);
+        }
+        CHECK(a.alloc(128) == nullptr);
+        for (void* p: blocks) {
+            CHECK(*(uint8_t*)p == 0xaa);
+        }
+    }
+    SECTION("tracks the owner of every block") {
+        REQUIRE(a.init(g_buf, sizeof(g_buf)));
+        void* p1 = a.alloc(32, true);
+        void* p2 = a.alloc(32, false);
+        void* p3 = a.alloc(32, true);
+        CHECK(a.owner(p1));
+        CHECK_FALSE(a.owner(p2));
+        CHECK(a.owner(p3));
+        a.free(p1);
+        void* p4 = a.alloc(32, false);
+        CHECK(p4 == p1);
+        CHECK_FALSE(a.owner(p4));
+        CHECK(a.owner(p3));
+    }
+    SECTION("doesn't contain foreign pointers") {
+        REQUIRE(a.init(g_buf, sizeof(g_buf)));
+        int x = 0;
+        CHECK_FALSE(a.contains(&x));
+        CHECK_FALSE(a.contains(g_buf + sizeof(g_buf)));
+    }
+}
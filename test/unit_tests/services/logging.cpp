@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Logging is disabled for all unit tests by default
+#undef LOG_DISABLE
+#define LOG_DEFERRED_FORMAT 1
+#define LOG_DEFERRED_MAX_ARGS_SIZE 32
+
+#include "logging.h"
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+struct DeferredMessage {
+    int level;
+    std::string category;
+    uint32_t fmtId;
+    std::string args;
+};
+
+std::vector<DeferredMessage> g_messages;
+
+template<typename T>
+std::string arg(uint8_t type, T val) {
+    std::string s(1, (char)type);
+    s.append((const char*)&val, sizeof(val));
+    return s;
+}
+
+std::string arg(const char* str) {
+    std::string s(1, (char)LOG_DEFERRED_ARG_STRING);
+    s += (char)strlen(str);
+    s += str;
+    return s;
+}
+
+} // unnamed
+
+void log_message_deferred(int level, const char* category, uint32_t fmt_id, const void* args, size_t size,
+        void* reserved) {
+    g_messages.push_back({ level, category ? category : "", fmt_id, std::string((const char*)args, size) });
+}
+
+TEST_CASE("LOG_DEFERRED_FORMAT") {
+    g_messages.clear();
+
+    SECTION("arguments are encoded according to their types") {
+        const char str[] = "abc";
+        const void* const ptr = &g_messages;
+        LOG_C(WARN, "test", "%d %u %lld %c %.2f %s %p", -1, 2u, -3ll, 'x', 1.5f, str, ptr);
+        REQUIRE(g_messages.size() == 1);
+        const auto& m = g_messages.front();
+        CHECK(m.level == LOG_LEVEL_WARN);
+        CHECK(m.category == "test");
+        CHECK((m.fmtId >> 24) == 0);
+        const std::string expected = arg(LOG_DEFERRED_ARG_INT32, (int32_t)-1) +
+                arg(LOG_DEFERRED_ARG_INT32, (int32_t)2) +
+                arg(LOG_DEFERRED_ARG_INT64, (int64_t)-3) +
+                arg(LOG_DEFERRED_ARG_INT32, (int32_t)'x') +
+                arg(LOG_DEFERRED_ARG_DOUBLE, 1.5) +
+                arg(str) +
+                arg(LOG_DEFERRED_ARG_POINTER, ptr);
+        // The arguments following the character don't fit in the buffer
+        CHECK(m.args == expected.substr(0, 24));
+    }
+    SECTION("every format string has its own ID") {
+        for (int i = 0; i < 2; ++i) {
+            LOG_C(INFO, nullptr, "first");
+            LOG_C(INFO, nullptr, "second %d", i);
+        }
+        REQUIRE(g_messages.size() == 4);
+        CHECK(g_messages[0].fmtId == g_messages[2].fmtId);
+        CHECK(g_messages[1].fmtId == g_messages[3].fmtId);
+        CHECK(g_messages[0].fmtId != g_messages[1].fmtId);
+        CHECK(g_messages[0].args.empty());
+        CHECK(g_messages[1].args == arg(LOG_DEFERRED_ARG_INT32, (int32_t)0));
+    }
+    SECTION("arguments that don't fit are discarded and strings are truncated") {
+        LOG_C(INFO, nullptr, "%s %d", "0123456789012345678901234567890123456789", 1);
+        REQUIRE(g_messages.size() == 1);
+        const auto& a = g_messages.front().args;
+        REQUIRE(a.size() == LOG_DEFERRED_MAX_ARGS_SIZE);
+        CHECK(a[0] == LOG_DEFERRED_ARG_STRING);
+        CHECK(a[1] == LOG_DEFERRED_MAX_ARGS_SIZE - 2);
+        CHECK(a.substr(2) == std::string("0123456789012345678901234567890123456789").substr(0, LOG_DEFERRED_MAX_ARGS_SIZE - 2));
+    }
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mpsc_queue.h"
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace particle;
+
+namespace {
+
+struct Item: MpscQueueNode {
+    unsigned producer = 0;
+    unsigned seq = 0;
+};
+
+} // unnamed
+
+TEST_CASE("MpscQueue") {
+    SECTION("is empty by default") {
+        MpscQueue<Item> q;
+        CHECK(q.isEmpty());
+        CHECK(q.pop() == nullptr);
+    }
+
+    SECTION("returns items in FIFO order") {
+        MpscQueue<Item> q;
+        Item items[4];
+        CHECK(q.push(&items[0]));
+        CHECK_FALSE(q.push(&items[1]));
+        CHECK_FALSE(q.push(&items[2]));
+        CHECK_FALSE(q.isEmpty());
+        CHECK(q.pop() == &items[0]);
+        CHECK(q.pop() == &items[1]);
+        CHECK_FALSE(q.push(&items[3]));
+        CHECK(q.pop() == &items[2]);
+        CHECK(q.pop() == &items[3]);
+        CHECK(q.pop() == nullptr);
+        CHECK(q.isEmpty());
+    }
+
+    SECTION("reports when the queue was empty") {
+        MpscQueue<Item> q;
+        Item a, b;
+        CHECK(q.push(&a));
+        CHECK(q.pop() == &a);
+        // The last item is taken out by putting the stub node back
+        CHECK(q.isEmpty());
+        CHECK(q.push(&b));
+        CHECK(q.pop() == &b);
+        // Items can be added again once they have been taken out
+        CHECK(q.push(&a));
+        CHECK_FALSE(q.push(&b));
+        CHECK(q.pop() == &a);
+        CHECK(q.pop() == &b);
+        CHECK(q.pop() == nullptr);
+    }
+
+    SECTION("supports concurrent producers") {
+        const unsigned PRODUCERS = 4;
+        const unsigned ITEMS = 20000;
+        MpscQueue<Item> q;
+        std::vector<Item> items(PRODUCERS * ITEMS);
+        std::atomic<unsigned> notified(0);
+        std::vector<std::thread> threads;
+        for (unsigned p = 0; p < PRODUCERS; ++p) {
+            threads.emplace_back([&, p]() {
+                for (unsigned i = 0; i < ITEMS; ++i) {
+                    Item& item = items[p * ITEMS + i];
+                    item.producer = p;
+                    item.seq = i;
+                    if (q.push(&item)) {
+                        ++notified;
+                    }
+                }
+            });
+        }
+        std::vector<unsigned> next(PRODUCERS, 0);
+        unsigned taken = 0;
+        bool ordered = true;
+        while (taken < PRODUCERS * ITEMS) {
+            const auto item = q.pop();
+            if (!item) {
+                std::this_thread::yield();
+                continue;
+            }
+            // Items of the same producer are taken in the order they were added
+            if (item->seq != next[item->producer]++) {
+                ordered = false;
+            }
+            ++taken;
+        }
+        for (auto& t: threads) {
+            t.join();
+        }
+        CHECK(ordered);
+        CHECK(q.pop() == nullptr);
+        CHECK(q.isEmpty());
+        CHECK(notified > 0);
+    }
+}
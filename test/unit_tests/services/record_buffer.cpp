@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "record_buffer.h"
+
+#include <catch2/catch.hpp>
+
+#include <thread>
+#include <vector>
+
+using namespace particle::services;
+
+namespace {
+
+struct Record {
+    uint32_t producer;
+    uint32_t seq;
+};
+
+bool put(MpscRecordBuffer* buf, const void* data, size_t size) {
+    void* const p = buf->acquire(size);
+    if (!p) {
+        return false;
+    }
+    memcpy(p, data, size);
+    buf->commit(p);
+    return true;
+}
+
+std::string get(MpscRecordBuffer* buf) {
+    size_t size = 0;
+    const void* const p = buf->peek(&size);
+    if (!p) {
+        return std::string();
+    }
+    std::string s((const char*)p, size);
+    buf->release();
+    return s;
+}
+
+} // unnamed
+
+TEST_CASE("MpscRecordBuffer") {
+    alignas(uint32_t) char mem[32] = {};
+    MpscRecordBuffer buf;
+
+    SECTION("size of the buffer must be a power of two") {
+        CHECK(buf.init(mem, 24) == SYSTEM_ERROR_INVALID_ARGUMENT);
+        CHECK(buf.init(mem, 0) == SYSTEM_ERROR_INVALID_ARGUMENT);
+        CHECK(buf.init(mem + 1, 16) == SYSTEM_ERROR_INVALID_ARGUMENT);
+        CHECK(buf.init(mem, sizeof(mem)) == 0);
+        CHECK(buf.size() == sizeof(mem));
+        CHECK(buf.empty());
+    }
+    SECTION("records are retrieved in the order in which they were acquired") {
+        REQUIRE(buf.init(mem, sizeof(mem)) == 0);
+        void* const a = buf.acquire(3);
+        void* const b = buf.acquire(5);
+        REQUIRE(a);
+        REQUIRE(b);
+        memcpy(b, "world", 5);
+        buf.commit(b);
+        // The first record is not committed yet
+        CHECK(buf.peek(nullptr) == nullptr);
+        memcpy(a, "foo", 3);
+        buf.commit(a);
+        CHECK(get(&buf) == "foo");
+        CHECK(get(&buf) == "world");
+        CHECK(buf.peek(nullptr) == nullptr);
+        CHECK(buf.empty());
+    }
+    SECTION("records that don't fit in the buffer are rejected") {
+        REQUIRE(buf.init(mem, sizeof(mem)) == 0);
+        CHECK(buf.acquire(sizeof(mem)) == nullptr);
+        CHECK(put(&buf, "0123456789abcdef", 16)); // 20 bytes
+        CHECK_FALSE(put(&buf, "0123456789", 10)); // 16 bytes
+        CHECK(put(&buf, "01234567", 8)); // 12 bytes
+        CHECK(buf.acquire(0) == nullptr);
+        CHECK(get(&buf) == "0123456789abcdef");
+        CHECK(get(&buf) == "01234567");
+    }
+    SECTION("a record is never split at the end of the buffer") {
+        REQUIRE(buf.init(mem, sizeof(mem)) == 0);
+        for (int i = 0; i < 10; ++i) {
+            CHECK(put(&buf, "abcdefghijklm", 13)); // 20 bytes, followed by 12 bytes of padding
+            CHECK(get(&buf) == "abcdefghijklm");
+        }
+        // The next record would start at offset 20, so a record of the size of the buffer doesn't fit
+        CHECK_FALSE(put(&buf, "0123456789abcdefghijklmnopq", 27));
+        CHECK(buf.empty());
+        CHECK(put(&buf, "0123456789ab", 12)); // 16 bytes, preceded by 12 bytes of padding
+        CHECK(get(&buf) == "0123456789ab");
+        CHECK(put(&buf, "0123456789ab", 12)); // Ends exactly at the end of the buffer
+        CHECK(get(&buf) == "0123456789ab");
+        CHECK(put(&buf, "0123456789abcdefghijklmnopq", 27)); // 32 bytes
+        CHECK(get(&buf) == "0123456789abcdefghijklmnopq");
+        CHECK(buf.empty());
+    }
+    SECTION("concurrent producers") {
+        const unsigned PRODUCER_COUNT = 4;
+        const unsigned RECORD_COUNT = 100000;
+        std::unique_ptr<uint32_t[]> mem2(new uint32_t[64]);
+        REQUIRE(buf.init(mem2.get(), 256) == 0);
+        std::vector<std::thread> producers;
+        for (unsigned i = 0; i < PRODUCER_COUNT; ++i) {
+            producers.emplace_back([&buf, i]() {
+                for (unsigned j = 0; j < RECORD_COUNT; ++j) {
+                    const Record r = { i, j };
+                    // Vary the record size to exercise the padding
+                    const size_t size = sizeof(r) + (j % 5);
+                    void* p = nullptr;
+                    while (!(p = buf.acquire(size))) {
+                        std::this_thread::yield();
+                    }
+                    memcpy(p, &r, sizeof(r));
+                    buf.commit(p);
+                }
+            });
+        }
+        std::vector<uint32_t> next(PRODUCER_COUNT, 0);
+        size_t errors = 0;
+        for (unsigned n = 0; n < PRODUCER_COUNT * RECORD_COUNT;) {
+            size_t size = 0;
+            const void* const p = buf.peek(&size);
+            if (!p) {
+                std::this_thread::yield();
+                continue;
+            }
+            Record r = {};
+            memcpy(&r, p, sizeof(r));
+            if (r.producer >= PRODUCER_COUNT || r.seq != next[r.producer]++ || size != sizeof(r) + (r.seq % 5)) {
+                ++errors;
+            }
+            buf.release();
+            ++n;
+        }
+        for (auto& t: producers) {
+            t.join();
+        }
+        CHECK(errors == 0);
+        CHECK(buf.empty());
+    }
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ringbuffer.h"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+using namespace particle::services;
+
+namespace {
+
+const size_t BENCHMARK_BUFFER_SIZE = 1024;
+const size_t BENCHMARK_ITEM_COUNT = 1000000;
+
+template<typename PutFn, typename GetFn>
+double measureThroughput(PutFn put, GetFn get) {
+    const auto start = std::chrono::steady_clock::now();
+    std::thread producer([&put]() {
+        for (size_t i = 0; i < BENCHMARK_ITEM_COUNT; ++i) {
+            const uint32_t v = i;
+            while (put(v) != 1) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    size_t errors = 0;
+    for (size_t i = 0; i < BENCHMARK_ITEM_COUNT; ++i) {
+        uint32_t v = 0;
+        while (get(&v) != 1) {
+            std::this_thread::yield();
+        }
+        if (v != (uint32_t)i) {
+            ++errors;
+        }
+    }
+    producer.join();
+    CHECK(errors == 0);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return BENCHMARK_ITEM_COUNT / elapsed.count();
+}
+
+} // unnamed
+
+TEST_CASE("SpscRingBuffer") {
+    uint8_t buf[8] = {};
+    SpscRingBuffer<uint8_t> rb;
+
+    SECTION("size of the buffer must be a power of two") {
+        CHECK(rb.init(buf, 6) == SYSTEM_ERROR_INVALID_ARGUMENT);
+        CHECK(rb.init(buf, 0) == SYSTEM_ERROR_INVALID_ARGUMENT);
+        CHECK(rb.init(buf, sizeof(buf)) == 0);
+        CHECK(rb.size() == sizeof(buf));
+        CHECK(rb.empty());
+        CHECK(rb.space() == sizeof(buf));
+    }
+    SECTION("stores and retrieves data across the end of the buffer") {
+        REQUIRE(rb.init(buf, sizeof(buf)) == 0);
+        const uint8_t data[] = { 1, 2, 3, 4, 5, 6 };
+        uint8_t out[6] = {};
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE(rb.put(data, sizeof(data)) == (ssize_t)sizeof(data));
+            CHECK(rb.data() == sizeof(data));
+            CHECK(rb.space() == sizeof(buf) - sizeof(data));
+            REQUIRE(rb.peek(out, 2) == 2);
+            CHECK(out[0] == 1);
+            CHECK(out[1] == 2);
+            REQUIRE(rb.get(out, sizeof(out)) == (ssize_t)sizeof(out));
+            CHECK(memcmp(out, data, sizeof(data)) == 0);
+            CHECK(rb.empty());
+        }
+    }
+    SECTION("fails to store more data than there is space for") {
+        REQUIRE(rb.init(buf, sizeof(buf)) == 0);
+        const uint8_t data[9] = {};
+        CHECK(rb.put(data, sizeof(data)) == SYSTEM_ERROR_TOO_LARGE);
+        CHECK(rb.put(data, sizeof(buf)) == (ssize_t)sizeof(buf));
+        CHECK(rb.full());
+        CHECK(rb.put(data[0]) == SYSTEM_ERROR_TOO_LARGE);
+        uint8_t v = 0;
+        CHECK(rb.get(&v) == 1);
+        CHECK(rb.put(data[0]) == 1);
+    }
+    SECTION("fails to retrieve more data than is available") {
+        REQUIRE(rb.init(buf, sizeof(buf)) == 0);
+        uint8_t v = 0;
+        CHECK(rb.get(&v) == SYSTEM_ERROR_TOO_LARGE);
+        CHECK(rb.peek(&v) == SYSTEM_ERROR_TOO_LARGE);
+    }
+    SECTION("provides contiguous regions for zero-copy access") {
+        REQUIRE(rb.init(buf, sizeof(buf)) == 0);
+        const uint8_t data[6] = {};
+        REQUIRE(rb.put(data, sizeof(data)) == (ssize_t)sizeof(data));
+        REQUIRE(rb.get(nullptr, 4) == 4);
+        // Only the free space up to the end of the buffer is contiguous
+        CHECK(rb.acquirable() == 2);
+        uint8_t* p = rb.acquire(2);
+        CHECK(p == buf + 6);
+        // Further regions can be reserved before the first one is committed
+        CHECK(rb.acquirable() == 4);
+        uint8_t* p2 = rb.acquire(3);
+        CHECK(p2 == buf);
+        CHECK(rb.acquirePending() == 5);
+        CHECK(rb.put(data[0]) == SYSTEM_ERROR_INVALID_STATE);
+        p[0] = 7;
+        p[1] = 8;
+        p2[0] = 9;
+        rb.acquireCommit(3, 2);
+        CHECK(rb.acquirePending() == 0);
+        CHECK(rb.data() == 5);
+        CHECK(rb.consumable() == 4);
+        p = rb.consume(4);
+        CHECK(p == buf + 4);
+        CHECK(p[2] == 7);
+        CHECK(p[3] == 8);
+        rb.consumeCommit(4);
+        CHECK(rb.consumable() == 1);
+        CHECK(*rb.consume(1) == 9);
+        rb.consumeCommit(1);
+        CHECK(rb.empty());
+    }
+}
+
+TEST_CASE("RingBuffer throughput", "[.][benchmark]") {
+    static uint32_t buf[BENCHMARK_BUFFER_SIZE];
+
+    SECTION("RingBuffer guarded by a mutex") {
+        RingBuffer<uint32_t> rb(buf, BENCHMARK_BUFFER_SIZE);
+        std::mutex mutex;
+        const double rate = measureThroughput([&](uint32_t v) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return rb.put(v);
+        }, [&](uint32_t* v) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return rb.get(v);
+        });
+        WARN("RingBuffer: " << (uint64_t)rate << " items/s");
+    }
+    SECTION("SpscRingBuffer") {
+        SpscRingBuffer<uint32_t> rb(buf, BENCHMARK_BUFFER_SIZE);
+        const double rate = measureThroughput([&](uint32_t v) {
+            return rb.put(v);
+        }, [&](uint32_t* v) {
+            return rb.get(v);
+        });
+        WARN("SpscRingBuffer: " << (uint64_t)rate << " items/s");
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "slab_allocator.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <set>
+
+using namespace particle;
+
+namespace {
+
+const SlabAllocator::SizeClass SIZE_CLASSES[] = {
+    { 16, 4 },
+    { 64, 2 }
+};
+
+const size_t SIZE_CLASS_COUNT = sizeof(SIZE_CLASSES) / sizeof(SIZE_CLASSES[0]);
+
+SlabAllocator::Stats stats(const SlabAllocator& a, size_t index) {
+    SlabAllocator::Stats s = {};
+    REQUIRE(a.stats(index, &s) == 0);
+    return s;
+}
+
+} // unnamed
+
+TEST_CASE("SlabAllocator") {
+    SlabAllocator a;
+
+    SECTION("size classes must be sorted by block size") {
+        const SlabAllocator::SizeClass classes[] = { { 64, 1 }, { 16, 1 } };
+        CHECK(a.init(classes, 2) == SYSTEM_ERROR_INVALID_ARGUMENT);
+        CHECK(a.init(SIZE_CLASSES, 0) == SYSTEM_ERROR_INVALID_ARGUMENT);
+        CHECK(a.alloc(1) == nullptr);
+        CHECK(a.init(SIZE_CLASSES, SIZE_CLASS_COUNT) == 0);
+        CHECK(a.classCount() == SIZE_CLASS_COUNT);
+    }
+    SECTION("serves requests from the smallest class that fits") {
+        REQUIRE(a.init(SIZE_CLASSES, SIZE_CLASS_COUNT) == 0);
+        void* p1 = a.alloc(10);
+        REQUIRE(p1 != nullptr);
+        CHECK(stats(a, 0).used == 1);
+        CHECK(stats(a, 1).used == 0);
+        void* p2 = a.alloc(17);
+        REQUIRE(p2 != nullptr);
+        CHECK(stats(a, 1).used == 1);
+        // Blocks can be used in their entirety
+        memset(p1, 0xaa, stats(a, 0).blockSize);
+        memset(p2, 0x55, stats(a, 1).blockSize);
+        a.free(p1);
+        a.free(p2);
+        CHECK(stats(a, 0).used == 0);
+        CHECK(stats(a, 1).used == 0);
+        CHECK(stats(a, 0).maxUsed == 1);
+        CHECK(a.failures() == 0);
+    }
+    SECTION("falls back to a larger class when a class is exhausted") {
+        REQUIRE(a.init(SIZE_CLASSES, SIZE_CLASS_COUNT) == 0);
+        std::set<void*> blocks;
+        for (int i = 0; i < 6; ++i) {
+            void* p = a.alloc(8);
+            REQUIRE(p != nullptr);
+            blocks.insert(p);
+        }
+        CHECK(blocks.size() == 6);
+        CHECK(stats(a, 0).used == 4);
+        CHECK(stats(a, 1).used == 2);
+        CHECK(a.alloc(8) == nullptr);
+        CHECK(a.alloc(65) == nullptr);
+        CHECK(a.failures() == 2);
+        // Freed blocks return to their own class
+        for (void* p: blocks) {
+            a.free(p);
+        }
+        CHECK(stats(a, 0).used == 0);
+        CHECK(stats(a, 1).used == 0);
+        CHECK(stats(a, 0).maxUsed == 4);
+        CHECK(stats(a, 1).maxUsed == 2);
+        CHECK(a.alloc(64) != nullptr);
+    }
+    SECTION("reuses the most recently freed block") {
+        REQUIRE(a.init(SIZE_CLASSES, SIZE_CLASS_COUNT) == 0);
+        void* p1 = a.alloc(1);
+        void* p2 = a.alloc(1);
+        CHECK(p1 != p2);
+        a.free(p1);
+        CHECK(a.alloc(1) == p1);
+        a.free(nullptr);
+        CHECK(stats(a, 0).used == 2);
+    }
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "timer_wheel.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+using namespace particle;
+
+namespace {
+
+struct Entry: TimerWheelEntry {
+    unsigned id = 0;
+};
+
+// Advances the wheel tick by tick and returns the time at which each entry expired
+std::map<unsigned, uint32_t> run(TimerWheel& w, uint32_t from, uint32_t to) {
+    std::map<unsigned, uint32_t> fired;
+    for (uint32_t t = from; t != to + 1; ++t) {
+        TimerWheelEntry* e = nullptr;
+        while ((e = w.expire(t))) {
+            fired[static_cast<Entry*>(e)->id] = t;
+        }
+    }
+    return fired;
+}
+
+// Advances the wheel to the times returned by nextTime(), like a thread sleeping in between would
+std::map<unsigned, uint32_t> runSleeping(TimerWheel& w, uint32_t now, unsigned maxWakeups) {
+    std::map<unsigned, uint32_t> fired;
+    uint32_t t = 0;
+    while (maxWakeups-- > 0 && w.nextTime(&t)) {
+        if ((int32_t)(t - now) > 0) {
+            now = t;
+        }
+        TimerWheelEntry* e = nullptr;
+        while ((e = w.expire(now))) {
+            fired[static_cast<Entry*>(e)->id] = now;
+        }
+    }
+    return fired;
+}
+
+} // unnamed
+
+TEST_CASE("TimerWheel") {
+    TimerWheel w(1000);
+    w.advance(1000);
+
+    SECTION("an empty wheel has no next time") {
+        uint32_t t = 0;
+        CHECK(w.isEmpty());
+        CHECK_FALSE(w.nextTime(&t));
+        CHECK(w.expire(2000) == nullptr);
+    }
+
+    SECTION("entries expire exactly at their expiration time") {
+        const uint32_t timeouts[] = { 1, 2, 63, 64, 65, 100, 4095, 4096, 4097, 10000, 262143, 262144, 300000 };
+        std::vector<Entry> entries(sizeof(timeouts) / sizeof(timeouts[0]));
+        for (size_t i = 0; i < entries.size(); ++i) {
+            entries[i].id = i;
+            w.add(&entries[i], 1000 + timeouts[i]);
+            CHECK(entries[i].isScheduled());
+        }
+        const auto fired = run(w, 1001, 1000 + 300000);
+        REQUIRE(fired.size() == entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            CHECK(fired.at(i) == 1000 + timeouts[i]);
+            CHECK_FALSE(entries[i].isScheduled());
+        }
+        CHECK(w.isEmpty());
+    }
+
+    SECTION("a removed entry doesn't expire") {
+        Entry e1, e2, e3;
+        e1.id = 1;
+        e2.id = 2;
+        e3.id = 3;
+        w.add(&e1, 1010);
+        w.add(&e2, 1010);
+        w.add(&e3, 6000);
+        w.remove(&e2);
+        w.remove(&e3);
+        CHECK_FALSE(e2.isScheduled());
+        w.remove(&e2); // No-op
+        const auto fired = run(w, 1001, 7000);
+        CHECK(fired.size() == 1);
+        CHECK(fired.count(1) == 1);
+        CHECK(w.isEmpty());
+    }
+
+    SECTION("an expired entry can be removed before it's taken from the wheel") {
+        Entry e1, e2;
+        e1.id = 1;
+        e2.id = 2;
+        w.add(&e1, 1005);
+        w.add(&e2, 1005);
+        w.advance(1005);
+        CHECK(e1.isScheduled());
+        w.remove(&e1);
+        auto e = w.takeExpired();
+        CHECK(e == &e2);
+        CHECK(w.takeExpired() == nullptr);
+    }
+
+    SECTION("adding a scheduled entry reschedules it") {
+        Entry e;
+        e.id = 1;
+        w.add(&e, 5000);
+        w.add(&e, 1050);
+        const auto fired = run(w, 1001, 6000);
+        CHECK(fired.at(1) == 1050);
+    }
+
+    SECTION("an entry in the past expires on the next tick") {
+        Entry e;
+        e.id = 1;
+        w.add(&e, 900);
+        const auto fired = run(w, 1001, 1001);
+        CHECK(fired.at(1) == 1001);
+    }
+
+    SECTION("entries beyond the range of the wheel expire on time") {
+        Entry e;
+        e.id = 1;
+        const uint32_t expiry = 1000 + TimerWheel::MAX_TIMEOUT + 12345;
+        w.add(&e, expiry);
+        const auto fired = runSleeping(w, 1000, 1000);
+        CHECK(fired.at(1) == expiry);
+    }
+
+    SECTION("the next time never goes past the earliest expiration time") {
+        std::srand(1);
+        std::vector<Entry> entries(200);
+        std::map<unsigned, uint32_t> expiry;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            entries[i].id = i;
+            const uint32_t t = 1000 + 1 + std::rand() % 500000;
+            w.add(&entries[i], t);
+            expiry[i] = t;
+        }
+        const auto fired = runSleeping(w, 1000, 100000);
+        REQUIRE(fired.size() == entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            CHECK(fired.at(i) == expiry.at(i));
+        }
+    }
+
+    SECTION("the wheel skips idle time") {
+        Entry e;
+        e.id = 1;
+        // Advancing an empty wheel over a long period of time doesn't leave it behind
+        const uint32_t now = 1000 + 0x7fffffffu;
+        w.advance(now);
+        w.add(&e, now + 10);
+        uint32_t t = 0;
+        REQUIRE(w.nextTime(&t));
+        CHECK(t == now + 10);
+    }
+
+    SECTION("time wraps around") {
+        TimerWheel w2(0xfffffff0);
+        w2.advance(0xfffffff0);
+        Entry e1, e2;
+        e1.id = 1;
+        e2.id = 2;
+        w2.add(&e1, 0xfffffffa);
+        w2.add(&e2, 0x00000100);
+        const auto fired = run(w2, 0xfffffff1, 0x00000200);
+        CHECK(fired.at(1) == 0xfffffffa);
+        CHECK(fired.at(2) == 0x00000100);
+    }
+}
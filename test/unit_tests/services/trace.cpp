@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trace.h"
+
+#include <catch2/catch.hpp>
+
+TEST_CASE("trace") {
+    trace_clear();
+    trace_record records[PARTICLE_TRACE_BUFFER_SIZE * 2] = {};
+
+    SECTION("returns the recorded events in order") {
+        PARTICLE_TRACE(TRACE_EVENT_SOCK_SEND_BEGIN, 100);
+        PARTICLE_TRACE(TRACE_EVENT_SOCK_SEND_END, -1);
+        REQUIRE(trace_get_records(records, 8) == 2);
+        CHECK(records[0].event == TRACE_EVENT_SOCK_SEND_BEGIN);
+        CHECK(records[0].arg == 100);
+        CHECK(records[1].event == TRACE_EVENT_SOCK_SEND_END);
+        CHECK(records[1].arg == (uint32_t)-1);
+        CHECK((uint16_t)(records[1].seq - records[0].seq) == 1);
+        CHECK(records[1].timestamp - records[0].timestamp < 0x80000000u);
+    }
+    SECTION("copies no more records than requested") {
+        PARTICLE_TRACE(TRACE_EVENT_USER, 1);
+        PARTICLE_TRACE(TRACE_EVENT_USER, 2);
+        REQUIRE(trace_get_records(records, 1) == 1);
+        CHECK(records[0].arg == 1);
+    }
+    SECTION("overwrites the oldest records when the buffer is full") {
+        for (unsigned i = 0; i < PARTICLE_TRACE_BUFFER_SIZE + 3; ++i) {
+            PARTICLE_TRACE(TRACE_EVENT_USER, i);
+        }
+        REQUIRE(trace_get_records(records, PARTICLE_TRACE_BUFFER_SIZE * 2) == PARTICLE_TRACE_BUFFER_SIZE);
+        for (unsigned i = 0; i < PARTICLE_TRACE_BUFFER_SIZE; ++i) {
+            CHECK(records[i].arg == i + 3);
+        }
+    }
+    SECTION("discards the recorded events") {
+        PARTICLE_TRACE(TRACE_EVENT_USER, 1);
+        trace_clear();
+        CHECK(trace_get_records(records, 8) == 0);
+        PARTICLE_TRACE(TRACE_EVENT_USER, 2);
+        REQUIRE(trace_get_records(records, 8) == 1);
+        CHECK(records[0].arg == 2);
+    }
+}
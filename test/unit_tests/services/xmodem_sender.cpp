@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "xmodem_sender.h"
+#include "stream.h"
+#include "logging.h"
+#include "system_error.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <set>
+#include <string>
+
+using namespace particle;
+
+extern "C" system_tick_t HAL_Timer_Get_Milli_Seconds() {
+    return 0;
+}
+
+extern "C" void log_message(int level, const char* category, LogAttributes* attr, void* reserved, const char* fmt, ...) {
+}
+
+namespace {
+
+const char ACK = 0x06;
+const char NAK = 0x15;
+const char EOT = 0x04;
+
+class SourceStream: public InputStream {
+public:
+    explicit SourceStream(const std::string& data) :
+            data_(data),
+            offs_(0) {
+    }
+
+    int read(char* data, size_t size) override {
+        size = std::min(size, data_.size() - offs_);
+        memcpy(data, data_.data() + offs_, size);
+        offs_ += size;
+        return size;
+    }
+
+    int peek(char* data, size_t size) override {
+        size = std::min(size, data_.size() - offs_);
+        memcpy(data, data_.data() + offs_, size);
+        return size;
+    }
+
+    int skip(size_t size) override {
+        size = std::min(size, data_.size() - offs_);
+        offs_ += size;
+        return size;
+    }
+
+    int availForRead() override {
+        return data_.size() - offs_;
+    }
+
+    int waitEvent(unsigned flags, unsigned timeout) override {
+        return InputStream::READABLE;
+    }
+
+private:
+    std::string data_;
+    size_t offs_;
+};
+
+// XMODEM-CRC receiver that responds to each packet after a few calls to the stream
+class Receiver: public Stream {
+public:
+    std::string data;
+    std::set<unsigned> nakPackets; // Packets to be rejected once
+    unsigned lag = 0; // Number of calls after which a response becomes readable
+    unsigned packetCount = 0;
+    unsigned maxInFlight = 0;
+    bool eot = false;
+
+    Receiver() :
+            expected_(1),
+            responded_(0) {
+        resp_.push_back({ 'C', 0, false });
+    }
+
+    int read(char* data, size_t size) override {
+        tick();
+        if (size == 0 || ready_.empty()) {
+            return 0;
+        }
+        *data = ready_.front();
+        ready_.pop_front();
+        return 1;
+    }
+
+    int peek(char* data, size_t size) override {
+        if (size == 0 || ready_.empty()) {
+            return 0;
+        }
+        *data = ready_.front();
+        return 1;
+    }
+
+    int skip(size_t size) override {
+        size = std::min(size, ready_.size());
+        ready_.erase(ready_.begin(), ready_.begin() + size);
+        return size;
+    }
+
+    int availForRead() override {
+        tick();
+        return ready_.size();
+    }
+
+    int write(const char* data, size_t size) override {
+        // Write the data in small chunks
+        size = std::min<size_t>(size, 100);
+        buf_.append(data, size);
+        parse();
+        return size;
+    }
+
+    int flush() override {
+        return 0;
+    }
+
+    int availForWrite() override {
+        return 100;
+    }
+
+    int waitEvent(unsigned flags, unsigned timeout) override {
+        tick();
+        return ready_.empty() ? (int)SYSTEM_ERROR_TIMEOUT : (int)InputStream::READABLE;
+    }
+
+private:
+    struct Response {
+        char c;
+        unsigned delay;
+        bool packet;
+    };
+
+    std::deque<Response> resp_;
+    std::deque<char> ready_;
+    std::string buf_;
+    unsigned expected_;
+    unsigned responded_; // Number of packets that have been responded to or ignored
+
+    void respond(char c, bool packet = true) {
+        resp_.push_back({ c, lag, packet });
+    }
+
+    void tick() {
+        while (!resp_.empty() && resp_.front().delay == 0) {
+            ready_.push_back(resp_.front().c);
+            if (resp_.front().packet) {
+                ++responded_;
+            }
+            resp_.pop_front();
+        }
+        if (!resp_.empty()) {
+            --resp_.front().delay;
+        }
+    }
+
+    void parse() {
+        while (!buf_.empty()) {
+            if (buf_[0] == EOT) {
+                buf_.erase(0, 1);
+                eot = true;
+                respond(ACK, false);
+                continue;
+            }
+            const size_t dataSize = (buf_[0] == 0x02) ? 1024 : 128;
+            if (buf_.size() < dataSize + 5) {
+                break;
+            }
+            const unsigned num = (uint8_t)buf_[1];
+            std::string d = buf_.substr(3, dataSize);
+            buf_.erase(0, dataSize + 5);
+            ++packetCount;
+            maxInFlight = std::max(maxInFlight, packetCount - responded_);
+            if (num != (expected_ & 0xff)) {
+                // Ignore the packets received out of sequence
+                ++responded_;
+                continue;
+            }
+            if (nakPackets.erase(expected_)) {
+                respond(NAK);
+                continue;
+            }
+            data += d;
+            ++expected_;
+            respond(ACK);
+        }
+    }
+};
+
+int runSender(XmodemSender& sender) {
+    for (;;) {
+        const int r = sender.run();
+        if (r != XmodemSender::RUNNING) {
+            return r;
+        }
+    }
+}
+
+std::string makeData(size_t size) {
+    std::string s;
+    for (size_t i = 0; i < size; ++i) {
+        s += (char)(i * 7 + i / 251);
+    }
+    return s;
+}
+
+} // unnamed
+
+TEST_CASE("XmodemSender") {
+    Receiver recv;
+    const auto data = makeData(4 * 1024 + 100);
+    SourceStream src(data);
+    XmodemSender sender;
+
+    SECTION("sends packets one at a time by default") {
+        recv.lag = 3;
+        REQUIRE(sender.init(&recv, &src, data.size()) == 0);
+        CHECK(runSender(sender) == XmodemSender::DONE);
+        CHECK(recv.eot);
+        // 4 1K packets and one 128-byte packet
+        CHECK(recv.packetCount == 5);
+        CHECK(recv.maxInFlight == 1);
+        REQUIRE(recv.data.size() == 4 * 1024 + 128);
+        CHECK(recv.data.substr(0, data.size()) == data);
+    }
+
+    SECTION("keeps several packets in flight") {
+        recv.lag = 3;
+        REQUIRE(sender.init(&recv, &src, data.size(), 3) == 0);
+        CHECK(runSender(sender) == XmodemSender::DONE);
+        CHECK(recv.eot);
+        CHECK(recv.packetCount == 5);
+        CHECK(recv.maxInFlight > 1);
+        CHECK(recv.maxInFlight <= 3);
+        CHECK(recv.data.substr(0, data.size()) == data);
+    }
+
+    SECTION("falls back to stop-and-wait mode when a packet is rejected") {
+        recv.lag = 3;
+        recv.nakPackets = { 2 };
+        REQUIRE(sender.init(&recv, &src, data.size(), 4) == 0);
+        CHECK(runSender(sender) == XmodemSender::DONE);
+        CHECK(recv.eot);
+        CHECK(recv.nakPackets.empty());
+        CHECK(recv.data.size() == 4 * 1024 + 128);
+        CHECK(recv.data.substr(0, data.size()) == data);
+    }
+
+    SECTION("fails when a packet is rejected too many times") {
+        recv.nakPackets = { 1 };
+        REQUIRE(sender.init(&recv, &src, data.size(), 2) == 0);
+        // The receiver rejects packet 1 only once, keep rejecting it
+        int r = 0;
+        for (;;) {
+            r = sender.run();
+            if (r != XmodemSender::RUNNING) {
+                break;
+            }
+            if (recv.nakPackets.empty() && recv.data.empty()) {
+                recv.nakPackets = { 1 };
+            }
+        }
+        CHECK(r == SYSTEM_ERROR_LIMIT_EXCEEDED);
+    }
+
+    SECTION("rejects an empty window") {
+        CHECK(sender.init(&recv, &src, data.size(), 0) == SYSTEM_ERROR_INVALID_ARGUMENT);
+    }
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spark_wiring_accumulator.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstring>
+
+using namespace particle;
+
+namespace {
+
+typedef FixedPointSQ<16, 8> Value; // Q15.8, stored in int32_t
+
+} // unnamed
+
+TEST_CASE("Accumulator") {
+    SECTION("is empty after construction") {
+        Accumulator<Value> a;
+        CHECK(a.count() == 0);
+        CHECK(a.mean().value() == 0);
+    }
+
+    SECTION("computes the statistics of the samples") {
+        Accumulator<Value> a;
+        a.add(Value(2.0f));
+        a.add(Value(-1.5f));
+        a.add(Value(4.0f));
+        a.add(Value(1.0f));
+        CHECK(a.count() == 4);
+        CHECK(a.min().toFloat() == -1.5f);
+        CHECK(a.max().toFloat() == 4.0f);
+        CHECK(a.last().toFloat() == 1.0f);
+        CHECK(a.mean().toFloat() == 1.375f);
+    }
+
+    SECTION("counts the samples in histogram buckets") {
+        Accumulator<Value, 4> a(Value(0.0f), Value(100.0f));
+        a.add(Value(-10.0f)); // Below the range
+        a.add(Value(10.0f));
+        a.add(Value(30.0f));
+        a.add(Value(60.0f));
+        a.add(Value(99.0f));
+        a.add(Value(150.0f)); // Above the range
+        CHECK(a.bucket(0) == 2);
+        CHECK(a.bucket(1) == 1);
+        CHECK(a.bucket(2) == 1);
+        CHECK(a.bucket(3) == 2);
+        CHECK(a.bucket(4) == 0);
+    }
+
+    SECTION("discards the samples on reset") {
+        Accumulator<Value, 2> a(Value(0.0f), Value(10.0f));
+        a.add(Value(3.0f));
+        a.reset();
+        CHECK(a.count() == 0);
+        CHECK(a.bucket(0) == 0);
+        a.add(Value(7.0f));
+        CHECK(a.min().toFloat() == 7.0f);
+        CHECK(a.max().toFloat() == 7.0f);
+    }
+
+    SECTION("encodes the statistics") {
+        Accumulator<FixedPointUQ<8, 8>, 2> a(FixedPointUQ<8, 8>(0.0f), FixedPointUQ<8, 8>(2.0f));
+        a.add(FixedPointUQ<8, 8>(0.5f));
+        a.add(FixedPointUQ<8, 8>(1.5f));
+        uint8_t buf[32] = {};
+        REQUIRE(a.encodedSize() == 19);
+        CHECK(a.encode(buf, 18) == 0);
+        REQUIRE(a.encode(buf, sizeof(buf)) == 19);
+        const uint8_t expected[] = {
+            0x02, 0x08, 0x02, // Value size, fraction bits, bucket count
+            0x02, 0x00, 0x00, 0x00, // Count
+            0x80, 0x00, // Min
+            0x80, 0x01, // Max
+            0x00, 0x01, // Mean
+            0x80, 0x01, // Last
+            0x01, 0x00, 0x01, 0x00 // Buckets
+        };
+        CHECK(memcmp(buf, expected, sizeof(expected)) == 0);
+    }
+}
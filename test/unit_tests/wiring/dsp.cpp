@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spark_wiring_dsp.h"
+
+#include <catch2/catch.hpp>
+
+#include <cmath>
+
+using namespace particle;
+using namespace particle::dsp;
+
+namespace {
+
+typedef FixedPointSQ<16, 16> Q16; // Stored in int32_t
+
+} // unnamed
+
+TEST_CASE("dsp::dot()") {
+    SECTION("computes the dot product of Q15 vectors") {
+        const Q15 a[] = { 0.5f, -0.25f, 0.125f, 0.5f, 0.75f };
+        const Q15 b[] = { 0.5f, 0.5f, -0.5f, 0.25f, 0.5f };
+        CHECK(dot(a, b, 5).toFloat() == Approx(0.5625f).margin(1e-4));
+        CHECK(dot(a, b, 1).toFloat() == Approx(0.25f).margin(1e-4));
+        CHECK(dot(a, b, 0).value() == 0);
+    }
+
+    SECTION("saturates the result") {
+        const Q15 a[] = { -1.0f, -1.0f };
+        CHECK(dot(a, a, 2).value() == 32767);
+    }
+
+    SECTION("supports other storage types") {
+        const Q16 a[] = { 2.0f, 3.0f };
+        const Q16 b[] = { 1.5f, -1.0f };
+        CHECK(dot(a, b, 2).toFloat() == 0.0f);
+    }
+}
+
+TEST_CASE("dsp::add()") {
+    const Q15 a[] = { 0.5f, 0.75f, -0.75f };
+    const Q15 b[] = { 0.25f, 0.5f, -0.5f };
+    Q15 out[3];
+    add(a, b, out, 3);
+    CHECK(out[0].toFloat() == 0.75f);
+    CHECK(out[1].value() == 32767);
+    CHECK(out[2].value() == -32768);
+}
+
+TEST_CASE("dsp::rms()") {
+    const Q15 x[] = { 0.5f, -0.5f, 0.5f, -0.5f };
+    CHECK(rms(x, 4).toFloat() == Approx(0.5f).margin(1e-4));
+    const Q16 y[] = { 3.0f, -4.0f };
+    CHECK(rms(y, 2).toFloat() == Approx(std::sqrt(12.5f)).margin(1e-4));
+}
+
+TEST_CASE("dsp::FirFilter") {
+    SECTION("computes a moving average") {
+        const Q15 coeffs[] = { 0.25f, 0.25f, 0.25f, 0.25f };
+        FirFilter<Q15, 4> fir(coeffs);
+        const Q15 in[] = { 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, -0.5f };
+        Q15 out[6];
+        fir.process(in, out, 3);
+        fir.process(in + 3, out + 3, 3); // The delay line is kept between blocks
+        CHECK(out[0].toFloat() == 0.125f);
+        CHECK(out[1].toFloat() == 0.25f);
+        CHECK(out[2].toFloat() == 0.375f);
+        CHECK(out[3].toFloat() == 0.5f);
+        CHECK(out[4].toFloat() == 0.5f);
+        CHECK(out[5].toFloat() == 0.25f);
+    }
+
+    SECTION("applies the first coefficient to the most recent sample") {
+        const Q15 coeffs[] = { 0.5f, 0.0f, 0.0f };
+        FirFilter<Q15, 3> fir(coeffs);
+        Q15 x[] = { 0.5f, -0.5f, 0.25f };
+        fir.process(x, x, 3);
+        CHECK(x[0].toFloat() == 0.25f);
+        CHECK(x[1].toFloat() == -0.25f);
+        CHECK(x[2].toFloat() == 0.125f);
+    }
+}
+
+TEST_CASE("dsp::Decimator") {
+    const Q15 coeffs[] = { 0.5f, 0.5f };
+    Decimator<Q15, 2, 2> dec(coeffs);
+    const Q15 in[] = { 0.5f, 0.25f, -0.5f, -0.25f, 0.5f };
+    Q15 out[3];
+    CHECK(dec.process(in, 3, out) == 1);
+    CHECK(out[0].toFloat() == 0.375f);
+    CHECK(dec.process(in + 3, 2, out + 1) == 1);
+    CHECK(out[1].toFloat() == -0.375f);
+}
+
+TEST_CASE("dsp::Fft") {
+    const size_t N = 16;
+    Fft<N> fft;
+
+    SECTION("transforms a constant signal") {
+        Complex<Q15> x[N];
+        for (auto& c: x) {
+            c.re = Q15(0.5f);
+            c.im = Q15(0.0f);
+        }
+        fft.transform(x);
+        CHECK(x[0].re.toFloat() == Approx(0.5f).margin(1e-3));
+        for (size_t i = 1; i < N; ++i) {
+            CHECK(std::abs(x[i].re.toFloat()) < 1e-3);
+            CHECK(std::abs(x[i].im.toFloat()) < 1e-3);
+        }
+    }
+
+    SECTION("finds the frequency of a sine wave") {
+        Complex<Q15> x[N];
+        for (size_t i = 0; i < N; ++i) {
+            x[i].re = Q15((float)(0.5 * std::cos(2 * M_PI * 3 * i / N)));
+            x[i].im = Q15(0.0f);
+        }
+        fft.transform(x);
+        for (size_t i = 0; i < N; ++i) {
+            const float expected = (i == 3 || i == N - 3) ? 0.25f : 0.0f;
+            CHECK(x[i].re.toFloat() == Approx(expected).margin(2e-3));
+            CHECK(x[i].im.toFloat() == Approx(0.0f).margin(2e-3));
+        }
+    }
+}
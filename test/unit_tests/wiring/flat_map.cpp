@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spark_wiring_flat_map.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstdlib>
+#include <map>
+#include <string>
+
+using namespace particle;
+
+namespace {
+
+// Maps all keys onto a few slots to exercise the collision handling
+struct BadHash {
+    size_t operator()(int key) const {
+        return key % 3;
+    }
+};
+
+} // unnamed
+
+TEST_CASE("FlatMap") {
+    SECTION("stores and replaces values") {
+        FlatMap<int, std::string, 4> m;
+        CHECK(m.isEmpty());
+        CHECK(m.capacity() == 4);
+        REQUIRE(m.set(1, "a"));
+        REQUIRE(m.set(2, "b"));
+        REQUIRE(m.set(1, "c"));
+        CHECK(m.size() == 2);
+        CHECK(m.get(1) == "c");
+        CHECK(m.get(2) == "b");
+        CHECK(m.get(3, "none") == "none");
+        CHECK(m.has(2));
+        CHECK_FALSE(m.has(3));
+        CHECK(m.find(3) == nullptr);
+        *m.find(2) = "d";
+        CHECK(m.get(2) == "d");
+    }
+
+    SECTION("fails to add to a full map") {
+        FlatMap<int, int, 3> m = { { 1, 1 }, { 2, 2 }, { 3, 3 } };
+        CHECK(m.isFull());
+        CHECK_FALSE(m.set(4, 4));
+        // Replacing a value still works
+        CHECK(m.set(3, 30));
+        CHECK(m.get(3) == 30);
+        CHECK_FALSE(m.has(4));
+        REQUIRE(m.remove(2));
+        REQUIRE(m.set(4, 4));
+        CHECK(m.get(4) == 4);
+    }
+
+    SECTION("iterates over all entries") {
+        FlatMap<int, int, 8> m = { { 1, 10 }, { 5, 50 }, { 7, 70 } };
+        int keys = 0;
+        int values = 0;
+        for (const auto& e: m) {
+            keys += e.first;
+            values += e.second;
+        }
+        CHECK(keys == 13);
+        CHECK(values == 130);
+        for (auto& e: m) {
+            e.second = 0;
+        }
+        CHECK(m.get(5, -1) == 0);
+        const FlatMap<int, int, 8> empty;
+        CHECK(empty.begin() == empty.end());
+    }
+
+    SECTION("keeps colliding entries reachable when removing") {
+        FlatMap<int, int, 6, BadHash> m;
+        for (int i = 0; i < 6; ++i) {
+            REQUIRE(m.set(i, i * 10));
+        }
+        REQUIRE(m.remove(0));
+        REQUIRE(m.remove(4));
+        CHECK_FALSE(m.remove(4));
+        for (int i: { 1, 2, 3, 5 }) {
+            CHECK(m.get(i, -1) == i * 10);
+        }
+        CHECK_FALSE(m.has(0));
+        CHECK_FALSE(m.has(4));
+        CHECK(m.size() == 4);
+    }
+
+    SECTION("matches std::map under random operations") {
+        std::srand(1);
+        FlatMap<int, int, 16, BadHash> m;
+        std::map<int, int> ref;
+        for (int n = 0; n < 5000; ++n) {
+            const int key = std::rand() % 24;
+            if (std::rand() % 2) {
+                const bool ok = m.set(key, n);
+                if (ref.count(key) || ref.size() < 16) {
+                    REQUIRE(ok);
+                    ref[key] = n;
+                } else {
+                    REQUIRE_FALSE(ok);
+                }
+            } else {
+                REQUIRE(m.remove(key) == (ref.erase(key) == 1));
+            }
+            REQUIRE(m.size() == (int)ref.size());
+            for (const auto& e: ref) {
+                REQUIRE(m.get(e.first, -1) == e.second);
+            }
+        }
+    }
+
+    SECTION("can be copied") {
+        FlatMap<int, std::string, 4> m = { { 1, "a" }, { 2, "b" } };
+        auto m2 = m;
+        m.clear();
+        CHECK(m.isEmpty());
+        CHECK(m2.size() == 2);
+        CHECK(m2.get(2) == "b");
+        m = m2;
+        CHECK(m.get(1) == "a");
+    }
+}
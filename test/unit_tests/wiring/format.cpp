@@ -0,0 +1,175 @@
+#include "spark_wiring_format.h"
+
+#include "catch2/catch.hpp"
+
+#include <string>
+#include <cstdio>
+#include <cstdarg>
+#include <cfloat>
+#include <cmath>
+#include <climits>
+#include <random>
+#include <vector>
+
+namespace {
+
+void appendOutput(const char* data, size_t size, void* ctx) {
+    static_cast<std::string*>(ctx)->append(data, size);
+}
+
+std::string format(const char* fmt, ...) {
+    std::string s;
+    va_list args;
+    va_start(args, fmt);
+    const size_t n = particle::vformatTo(appendOutput, &s, fmt, args);
+    va_end(args);
+    REQUIRE(n == s.size());
+    return s;
+}
+
+std::string expected(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    char buf[512];
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    return buf;
+}
+
+#define CHECK_FORMAT(...) \
+        CHECK(format(__VA_ARGS__) == expected(__VA_ARGS__))
+
+} // namespace
+
+TEST_CASE("formatTo()") {
+    SECTION("literal text and percent signs") {
+        CHECK_FORMAT("");
+        CHECK_FORMAT("abc");
+        CHECK_FORMAT("100%%");
+        CHECK_FORMAT("%%%d%%", 1);
+    }
+
+    SECTION("signed integers") {
+        const long long values[] = { 0, 1, -1, 9, 10, 99, 100, 12345, -12345, INT_MAX, INT_MIN,
+                4294967295ll, 4294967296ll, LLONG_MAX, LLONG_MIN };
+        for (long long v: values) {
+            CHECK_FORMAT("%lld", v);
+            CHECK_FORMAT("%+lld", v);
+            CHECK_FORMAT("% lld", v);
+            CHECK_FORMAT("%25lld|%-25lld|%025lld", v, v, v);
+            CHECK_FORMAT("%.0lld|%.8lld|%12.8lld|%-+12.8lld", v, v, v, v);
+        }
+        CHECK_FORMAT("%d %i %hd %hhd %ld %jd %zd %td", -1, 2, (short)-3, (signed char)-4, -5L,
+                (intmax_t)-6, (ssize_t)-7, (ptrdiff_t)-8);
+        CHECK_FORMAT("%hhd %hd", 300, 70000);
+    }
+
+    SECTION("unsigned integers") {
+        const unsigned long long values[] = { 0, 1, 7, 8, 15, 16, 255, 65535, 4294967295ull,
+                4294967296ull, ULLONG_MAX };
+        for (unsigned long long v: values) {
+            CHECK_FORMAT("%llu|%llx|%llX|%llo", v, v, v, v);
+            CHECK_FORMAT("%#llx|%#llX|%#llo", v, v, v);
+            CHECK_FORMAT("%#20llx|%#-20llx|%#020llx|%#.10llo", v, v, v, v);
+            CHECK_FORMAT("%.0llu|%.0llx|%#.0llo|%#.0llx", v, v, v, v);
+        }
+        CHECK_FORMAT("%u %hu %hhu %lu %zu", 1u, (unsigned short)2, (unsigned char)3, 4ul, (size_t)5);
+    }
+
+    SECTION("characters and strings") {
+        CHECK_FORMAT("%c%c%c", 'a', 'b', 'c');
+        CHECK_FORMAT("%5c|%-5c|", 'x', 'y');
+        CHECK_FORMAT("%s", "");
+        CHECK_FORMAT("%s|%10s|%-10s|%.2s|%10.2s", "abc", "abc", "abc", "abc", "abc");
+        const std::string longStr(300, 'z');
+        CHECK_FORMAT("<%s>", longStr.c_str());
+        CHECK_FORMAT("%400s", "abc");
+        CHECK(format("%s", (const char*)nullptr) == "(null)");
+    }
+
+    SECTION("width and precision arguments") {
+        CHECK_FORMAT("%*d|%-*d|%*d", 6, 42, 6, 42, -6, 42);
+        CHECK_FORMAT("%.*d|%.*d", 4, 42, -1, 42);
+        CHECK_FORMAT("%*.*f", 12, 3, 3.14159);
+    }
+
+    SECTION("pointers") {
+        int x = 0;
+        CHECK_FORMAT("%p", (void*)&x);
+    }
+
+    SECTION("fixed point notation") {
+        const double values[] = { 0.0, -0.0, 1.0, -1.0, 0.5, 1.5, 2.5, 0.125, 0.375, 1.005, 2.675,
+                3.14159265358979, 123456.789, 1e-7, 5e-7, 1e-5, 0.1, 0.7, 9.9999999, 99.95, 999999.5,
+                4294967295.0, 4294967296.5, 1e15, 1e16 + 2, 1.8e19, 1e-300, DBL_MIN, 4.9406564584124654e-324 };
+        for (double v: values) {
+            CHECK_FORMAT("%f|%F|%.0f|%.1f|%.2f|%.3f", v, v, v, v, v, v);
+            CHECK_FORMAT("%.10f|%.15f|%.19f", v, v, v);
+            CHECK_FORMAT("%#.0f|%+f|% f|%20.4f|%-20.4f|%020.4f", v, v, v, v, v, v);
+        }
+    }
+
+    SECTION("exponential notation") {
+        const double values[] = { 0.0, -0.0, 1.0, -1.0, 0.5, 9.5, 9.9999999, 10.0, 0.125, 1.005,
+                123456.789, 1e-7, 1e-5, 0.1, 1e15, 1e16, 1.8e19, 1e20, 1e100, 1e-100, 1e300, 1e-300,
+                DBL_MAX, DBL_MIN, 4.9406564584124654e-324 };
+        for (double v: values) {
+            CHECK_FORMAT("%e|%E|%.0e|%.1e|%.2e|%.10e|%.18e", v, v, v, v, v, v, v);
+            CHECK_FORMAT("%#.0e|%+e|%20.4e|%-20.4e|%020.4e", v, v, v, v, v);
+        }
+    }
+
+    SECTION("general notation") {
+        const double values[] = { 0.0, -0.0, 1.0, 0.5, 100.0, 123456.0, 1234567.0, 0.0001, 0.00001,
+                0.000123456, 1.5e-5, 9.9999999, 99999.95, 1e15, 1e100, 1e-100, DBL_MAX,
+                4.9406564584124654e-324, 3.14159265358979 };
+        for (double v: values) {
+            CHECK_FORMAT("%g|%G|%.0g|%.1g|%.2g|%.10g|%.17g", v, v, v, v, v, v, v);
+            CHECK_FORMAT("%#g|%#.3g|%+g|%20g|%-20g|%020g", v, v, v, v, v, v);
+        }
+        CHECK_FORMAT("%g|%.3g", 999999.5, 999999.5);
+        // The alternative form keeps the trailing zeros even if the value is rounded up to the next
+        // power of 10 (glibc doesn't)
+        CHECK(format("%#g", 999999.5) == "1.00000e+06");
+    }
+
+    SECTION("special values") {
+        const double values[] = { INFINITY, -INFINITY, NAN };
+        for (double v: values) {
+            CHECK_FORMAT("%f|%F|%e|%E|%g|%G|%10f|%-10f|%010f|%+f", v, v, v, v, v, v, v, v, v, v);
+        }
+    }
+
+    SECTION("values formatted by the C library") {
+        CHECK_FORMAT("%f", 1e300);
+        CHECK_FORMAT("%.30f", 0.1);
+        CHECK_FORMAT("%.25e", 0.1);
+        CHECK_FORMAT("%a|%A|%.3a", 1.0, 0.5, 3.14159);
+        CHECK_FORMAT("%Lf", (long double)2.5);
+    }
+
+    SECTION("random doubles") {
+        std::mt19937_64 gen(1);
+        std::uniform_real_distribution<double> mantissa(1.0, 10.0);
+        std::uniform_int_distribution<int> exponent(-25, 25);
+        for (int i = 0; i < 2000; ++i) {
+            const double v = mantissa(gen) * std::pow(10.0, exponent(gen));
+            CHECK_FORMAT("%f|%.3f|%.12f|%e|%.3e|%.15e|%g|%.3g|%.15g", v, v, v, v, v, v, v, v, v);
+        }
+    }
+
+    SECTION("stores the number of characters produced") {
+        int n = 0;
+        format("abc%n", &n);
+        CHECK(n == 3);
+    }
+
+    SECTION("output is passed to the callback in chunks") {
+        std::string s(1000, 'a');
+        std::vector<size_t> sizes;
+        particle::formatTo([](const char* data, size_t size, void* ctx) {
+            static_cast<std::vector<size_t>*>(ctx)->push_back(size);
+        }, &sizes, "%s%d%s", s.c_str(), 1, "b");
+        CHECK(sizes.size() == 2);
+    }
+}
@@ -0,0 +1,228 @@
+#include "spark_wiring_mesh_codec.h"
+
+#include "system_error.h"
+
+#include "catch2/catch.hpp"
+
+#include <string>
+#include <vector>
+#include <utility>
+
+using namespace particle::mesh;
+
+namespace {
+
+typedef std::vector<std::pair<std::string, std::string>> Events;
+
+void appendEvent(const char* topic, const char* data, void* ctx) {
+    static_cast<Events*>(ctx)->emplace_back(topic, data);
+}
+
+Events parse(const std::string& msg, int* result = nullptr) {
+    Events events;
+    const int r = parseMessage(msg.data(), msg.size(), appendEvent, &events);
+    if (result) {
+        *result = r;
+    } else {
+        REQUIRE(r == 0);
+    }
+    return events;
+}
+
+Source source(uint8_t addr, uint16_t port) {
+    Source src = {};
+    src.addr[15] = addr;
+    src.port = port;
+    return src;
+}
+
+} // namespace
+
+TEST_CASE("MessageWriter") {
+    char buf[64];
+    MessageWriter w(buf, sizeof(buf));
+
+    SECTION("writes events one after another") {
+        CHECK(w.append("a", "1"));
+        CHECK(w.append("b", nullptr));
+        CHECK(w.count() == 2);
+        CHECK(std::string(w.data(), w.size()) == std::string("a\0" "1\0" "b\0" "\0", 7));
+        CHECK(parse(std::string(w.data(), w.size())) == Events({ { "a", "1" }, { "b", "" } }));
+    }
+
+    SECTION("replaces repeated topics with references") {
+        CHECK(w.append("temp", "1"));
+        CHECK(w.append("hum", "2"));
+        CHECK(w.append("temp", "3"));
+        CHECK(std::string(w.data(), w.size()) == std::string("temp\0" "1\0" "hum\0" "2\0" "\x01\x00" "3\0", 17));
+        CHECK(parse(std::string(w.data(), w.size())) == Events({ { "temp", "1" }, { "hum", "2" }, { "temp", "3" } }));
+    }
+
+    SECTION("fails when the buffer is full") {
+        const std::string data(50, 'x');
+        CHECK(w.append("a", data.c_str()));
+        CHECK_FALSE(w.append("bbbbbbbbbbbb", data.c_str()));
+        CHECK(w.count() == 1);
+        CHECK(w.size() == MessageWriter::eventSize("a", data.c_str()));
+        w.reset();
+        CHECK(w.count() == 0);
+        CHECK(w.size() == 0);
+        CHECK(w.append("bbbbbbbbbbbb", data.c_str()));
+    }
+}
+
+TEST_CASE("parseMessage()") {
+    int r = 0;
+
+    SECTION("rejects an empty message") {
+        parse(std::string(), &r);
+        CHECK(r == SYSTEM_ERROR_BAD_DATA);
+    }
+
+    SECTION("rejects an empty topic") {
+        parse(std::string("\0" "1\0", 3), &r);
+        CHECK(r == SYSTEM_ERROR_BAD_DATA);
+    }
+
+    SECTION("rejects unterminated data") {
+        const auto events = parse(std::string("a\0" "1\0" "b\0" "2", 7), &r);
+        CHECK(r == SYSTEM_ERROR_BAD_DATA);
+        CHECK(events == Events({ { "a", "1" } }));
+    }
+
+    SECTION("rejects forward and nested references") {
+        parse(std::string("\x01\x00" "1\0", 4), &r);
+        CHECK(r == SYSTEM_ERROR_BAD_DATA);
+        parse(std::string("a\0" "1\0" "\x01\x00" "2\0" "\x01\x01" "3\0", 12), &r);
+        CHECK(r == SYSTEM_ERROR_BAD_DATA);
+    }
+}
+
+TEST_CASE("MessageReassembler") {
+    MessageReassembler m(4);
+    const auto src = source(1, 1000);
+    const char* msg = nullptr;
+    size_t size = 0;
+
+    SECTION("reassembles fragments received out of order") {
+        CHECK(m.add(src, 1, 2, 3, "ij", 2, 0, &msg, &size) == 0);
+        CHECK(m.add(src, 1, 0, 3, "abcd", 4, 0, &msg, &size) == 0);
+        CHECK(m.add(src, 1, 0, 3, "abcd", 4, 0, &msg, &size) == 0); // Duplicate
+        CHECK(m.add(src, 1, 1, 3, "efgh", 4, 0, &msg, &size) == 1);
+        CHECK(std::string(msg, size) == "abcdefghij");
+    }
+
+    SECTION("keeps messages from different senders apart") {
+        const auto src2 = source(2, 1000);
+        CHECK(m.add(src, 1, 0, 2, "abcd", 4, 0, &msg, &size) == 0);
+        CHECK(m.add(src2, 1, 0, 2, "ABCD", 4, 0, &msg, &size) == 0);
+        CHECK(m.add(src2, 1, 1, 2, "E", 1, 0, &msg, &size) == 1);
+        CHECK(std::string(msg, size) == "ABCDE");
+        CHECK(m.add(src, 1, 1, 2, "e", 1, 0, &msg, &size) == 1);
+        CHECK(std::string(msg, size) == "abcde");
+    }
+
+    SECTION("discards incomplete messages after a timeout") {
+        CHECK(m.add(src, 1, 0, 2, "abcd", 4, 0, &msg, &size) == 0);
+        CHECK(m.add(src, 1, 1, 2, "e", 1, MessageReassembler::TIMEOUT, &msg, &size) == 0);
+        CHECK(m.add(src, 1, 0, 2, "ABCD", 4, MessageReassembler::TIMEOUT, &msg, &size) == 1);
+        CHECK(std::string(msg, size) == "ABCDe");
+    }
+
+    SECTION("evicts the oldest message when all slots are used") {
+        CHECK(m.add(src, 1, 0, 2, "abcd", 4, 0, &msg, &size) == 0);
+        CHECK(m.add(src, 2, 0, 2, "efgh", 4, 10, &msg, &size) == 0);
+        CHECK(m.add(src, 3, 0, 2, "ijkl", 4, 20, &msg, &size) == 0);
+        CHECK(m.add(src, 2, 1, 2, "y", 1, 30, &msg, &size) == 1);
+        CHECK(std::string(msg, size) == "efghy");
+        CHECK(m.add(src, 1, 1, 2, "x", 1, 30, &msg, &size) == 0); // Evicted
+        CHECK(m.add(src, 3, 1, 2, "z", 1, 30, &msg, &size) == 1);
+        CHECK(std::string(msg, size) == "ijklz");
+    }
+
+    SECTION("rejects malformed fragments") {
+        CHECK(m.add(src, 1, 0, 2, "abc", 3, 0, &msg, &size) == SYSTEM_ERROR_BAD_DATA);
+        CHECK(m.add(src, 1, 1, 2, "abcde", 5, 0, &msg, &size) == SYSTEM_ERROR_BAD_DATA);
+        CHECK(m.add(src, 1, 2, 2, "a", 1, 0, &msg, &size) == SYSTEM_ERROR_BAD_DATA);
+        CHECK(m.add(src, 1, 0, MessageReassembler::MAX_FRAGMENT_COUNT + 1, "abcd", 4, 0, &msg, &size) ==
+                SYSTEM_ERROR_BAD_DATA);
+    }
+}
+
+TEST_CASE("CoAP event requests") {
+    char buf[64];
+
+    SECTION("can be parsed back") {
+        const int n = writeCoapEventRequest(buf, sizeof(buf), 0x1234);
+        REQUIRE(n == 7);
+        MessageWriter w(buf + n, sizeof(buf) - n);
+        REQUIRE(w.append("topic", "data"));
+        CoapMessage msg = {};
+        REQUIRE(isCoapMessage(buf, n + w.size()));
+        REQUIRE(parseCoapMessage(buf, n + w.size(), &msg) == 0);
+        CHECK(msg.type == particle::protocol::CoAPType::CON);
+        CHECK(msg.code == particle::protocol::CoAPCode::POST);
+        CHECK(msg.id == 0x1234);
+        REQUIRE(msg.payload == buf + n);
+        CHECK(parse(std::string(msg.payload, msg.payloadSize)) == Events({ { "topic", "data" } }));
+    }
+
+    SECTION("are acknowledged with an empty ACK") {
+        REQUIRE(writeCoapAck(buf, sizeof(buf), 0xabcd) == 4);
+        CoapMessage msg = {};
+        REQUIRE(parseCoapMessage(buf, 4, &msg) == 0);
+        CHECK(msg.type == particle::protocol::CoAPType::ACK);
+        CHECK(msg.code == particle::protocol::CoAPCode::EMPTY);
+        CHECK(msg.id == 0xabcd);
+        CHECK(msg.payload == nullptr);
+    }
+
+    SECTION("are not confused with mesh publish datagrams") {
+        CHECK_FALSE(isCoapMessage("\x00" "a", 2));
+        CHECK_FALSE(isCoapMessage("\x01\x00" "a", 3));
+    }
+
+    SECTION("with a token and extended options can be parsed") {
+        // CON, token of 2 bytes, option with a 1-byte extended delta and length, payload
+        const std::string s("\x42\x02\x00\x01" "ab" "\xdd\x00\x01" "0123456789abcd" "\xff" "x", 25);
+        CoapMessage msg = {};
+        REQUIRE(parseCoapMessage(s.data(), s.size(), &msg) == 0);
+        CHECK(std::string(msg.payload, msg.payloadSize) == "x");
+    }
+
+    SECTION("that are malformed are rejected") {
+        CoapMessage msg = {};
+        CHECK(parseCoapMessage("\x40\x02\x00", 3, &msg) == SYSTEM_ERROR_BAD_DATA);
+        CHECK(parseCoapMessage("\x40\x02\x00\x01\xff", 5, &msg) == SYSTEM_ERROR_BAD_DATA);
+        CHECK(parseCoapMessage("\x40\x02\x00\x01\xb5" "E", 6, &msg) == SYSTEM_ERROR_BAD_DATA);
+        CHECK(parseCoapMessage("\x49\x02\x00\x01", 4, &msg) == SYSTEM_ERROR_BAD_DATA);
+    }
+}
+
+TEST_CASE("coapRetransmitTimeout()") {
+    for (unsigned i = 0; i <= COAP_MAX_RETRANSMIT; ++i) {
+        const system_tick_t t = coapRetransmitTimeout(i);
+        CHECK(t >= COAP_ACK_TIMEOUT << i);
+        CHECK(t < (COAP_ACK_TIMEOUT << i) * 3 / 2);
+    }
+}
+
+TEST_CASE("DuplicateFilter") {
+    DuplicateFilter f;
+    const auto src = source(1, 1000);
+    const auto src2 = source(2, 1000);
+
+    CHECK_FALSE(f.check(src, 1, 0));
+    CHECK(f.check(src, 1, 100));
+    CHECK_FALSE(f.check(src2, 1, 100));
+    CHECK_FALSE(f.check(src, 2, 100));
+    // Message IDs are forgotten after a while
+    CHECK_FALSE(f.check(src, 1, DuplicateFilter::LIFETIME));
+    // The oldest messages are forgotten when the filter is full
+    for (uint16_t id = 10; id < 17; ++id) {
+        CHECK_FALSE(f.check(src, id, DuplicateFilter::LIFETIME + id));
+    }
+    CHECK(f.check(src, 10, DuplicateFilter::LIFETIME + 20));
+    CHECK(f.check(src, 16, DuplicateFilter::LIFETIME + 20));
+    CHECK_FALSE(f.check(src2, 1, DuplicateFilter::LIFETIME + 20));
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spark_wiring_small_vector.h"
+
+#include <catch2/catch.hpp>
+
+#include <memory>
+#include <string>
+
+using namespace particle;
+
+namespace {
+
+struct CountingAllocator {
+    static int allocs;
+    static int frees;
+
+    static void* malloc(size_t size) {
+        ++allocs;
+        return ::malloc(size);
+    }
+
+    static void free(void* ptr) {
+        if (ptr) {
+            ++frees;
+        }
+        ::free(ptr);
+    }
+};
+
+int CountingAllocator::allocs = 0;
+int CountingAllocator::frees = 0;
+
+template<typename VectorT>
+std::string join(const VectorT& v) {
+    std::string s;
+    for (const auto& x: v) {
+        if (!s.empty()) {
+            s += ',';
+        }
+        s += std::to_string(x);
+    }
+    return s;
+}
+
+} // unnamed
+
+TEST_CASE("SmallVector") {
+    CountingAllocator::allocs = 0;
+    CountingAllocator::frees = 0;
+
+    SECTION("doesn't allocate while the elements fit inline") {
+        {
+            SmallVector<int, 4, CountingAllocator> v;
+            CHECK(v.isEmpty());
+            CHECK(v.capacity() == 4);
+            CHECK(v.isInline());
+            REQUIRE(v.append(1));
+            REQUIRE(v.append(2));
+            REQUIRE(v.prepend(0));
+            REQUIRE(v.insert(3, 3));
+            CHECK(join(v) == "0,1,2,3");
+            CHECK(v.isInline());
+        }
+        CHECK(CountingAllocator::allocs == 0);
+    }
+
+    SECTION("moves to the heap when it outgrows the inline storage") {
+        {
+            SmallVector<int, 2, CountingAllocator> v = { 1, 2 };
+            REQUIRE(v.append(3));
+            CHECK_FALSE(v.isInline());
+            CHECK(v.capacity() == 4);
+            REQUIRE(v.append(4));
+            CHECK(CountingAllocator::allocs == 1);
+            REQUIRE(v.append(5));
+            CHECK(v.capacity() == 8);
+            CHECK(CountingAllocator::allocs == 2);
+            CHECK(join(v) == "1,2,3,4,5");
+            v.removeAt(1, 3);
+            CHECK(join(v) == "1,5");
+            REQUIRE(v.trimToSize());
+            CHECK(v.isInline());
+            CHECK(v.capacity() == 2);
+            CHECK(join(v) == "1,5");
+        }
+        CHECK(CountingAllocator::allocs == CountingAllocator::frees);
+    }
+
+    SECTION("supports non-trivially copyable types") {
+        SmallVector<std::shared_ptr<int>, 2> v;
+        auto p = std::make_shared<int>(1);
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(v.append(p));
+        }
+        CHECK(p.use_count() == 6);
+        v.removeAt(0, 2);
+        CHECK(p.use_count() == 4);
+        auto v2 = v;
+        CHECK(p.use_count() == 7);
+        auto v3 = std::move(v2);
+        CHECK(p.use_count() == 7);
+        CHECK(v2.isEmpty());
+        v.clear();
+        v3.clear();
+        CHECK(p.use_count() == 1);
+    }
+
+    SECTION("can be moved and copied") {
+        SmallVector<int, 2, CountingAllocator> inl = { 1, 2 };
+        SmallVector<int, 2, CountingAllocator> heap = { 1, 2, 3 };
+        const int allocs = CountingAllocator::allocs;
+        SmallVector<int, 2, CountingAllocator> v1(std::move(inl));
+        SmallVector<int, 2, CountingAllocator> v2(std::move(heap));
+        // The heap block is taken over
+        CHECK(CountingAllocator::allocs == allocs);
+        CHECK(join(v1) == "1,2");
+        CHECK(join(v2) == "1,2,3");
+        CHECK(inl.isEmpty());
+        CHECK(heap.isEmpty());
+        CHECK(heap.isInline());
+        v1 = v2;
+        CHECK(v1 == v2);
+        v2 = SmallVector<int, 2, CountingAllocator>({ 7 });
+        CHECK(join(v2) == "7");
+        CHECK(v1 != v2);
+    }
+
+    SECTION("implements the Vector interface") {
+        SmallVector<int, 8> v(3, 5);
+        CHECK(join(v) == "5,5,5");
+        v.fill(1);
+        const int values[] = { 2, 3 };
+        REQUIRE(v.append(values, 2));
+        REQUIRE(v.insert(1, 2, 9));
+        CHECK(join(v) == "1,9,9,1,1,2,3");
+        CHECK(v.indexOf(9) == 1);
+        CHECK(v.lastIndexOf(1) == 4);
+        CHECK(v.contains(3));
+        CHECK(v.removeAll(1) == 3);
+        CHECK(join(v) == "9,9,2,3");
+        CHECK(v.removeOne(9));
+        CHECK(v.takeFirst() == 9);
+        CHECK(v.takeLast() == 3);
+        CHECK(join(v) == "2");
+        REQUIRE(v.resize(3));
+        CHECK(join(v) == "2,0,0");
+        REQUIRE(v.resize(1));
+        CHECK(v.first() == 2);
+        CHECK(v.last() == 2);
+    }
+}
+
+TEST_CASE("StaticVector") {
+    StaticVector<int, 3> v;
+    REQUIRE(v.append(1));
+    REQUIRE(v.append(2));
+    REQUIRE(v.append(3));
+    CHECK_FALSE(v.append(4));
+    CHECK_FALSE(v.insert(0, 0));
+    CHECK_FALSE(v.reserve(4));
+    CHECK_FALSE(v.resize(4));
+    CHECK(join(v) == "1,2,3");
+    CHECK(v.capacity() == 3);
+    v.removeAt(0);
+    REQUIRE(v.prepend(0));
+    CHECK(join(v) == "0,2,3");
+}
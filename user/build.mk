@@ -50,6 +50,8 @@ ifeq ($(APPLAYOUT),extended)
 MODULE_LIBSV2 += $(wildcard $(APPROOT)/lib/*)
 SOURCE_PATH := $(APPROOT)/
 USRSRC = src
+# read-only assets are packed from the "assets" dir
+ASSETS_DIR ?= $(wildcard $(APPROOT)/assets)
 endif
 
 USRSRC_SLASH = $(and $(USRSRC),$(USRSRC)/)
@@ -72,6 +74,8 @@ endif
 
 INCLUDE_DIRS += $(MODULE_PATH)/libraries
 
+include $(COMMON_BUILD)/assets.mk
+
 CFLAGS += -DSPARK_PLATFORM_NET=$(PLATFORM_NET)
 
 BUILTINS_EXCLUDE = malloc free realloc
@@ -61,6 +61,7 @@
 #include "spark_wiring_client.h"
 #include "spark_wiring_startup.h"
 #include "spark_wiring_timer.h"
+#include "spark_wiring_timer_service.h"
 #include "spark_wiring_tcpclient.h"
 #include "spark_wiring_tcpserver.h"
 #include "spark_wiring_udp.h"
@@ -72,8 +73,10 @@
 #include "spark_wiring_thread.h"
 #include "spark_wiring_logging.h"
 #include "spark_wiring_json.h"
+#include "spark_wiring_cbor.h"
 #include "spark_wiring_vector.h"
 #include "spark_wiring_async.h"
+#include "spark_wiring_thread_pool.h"
 #include "spark_wiring_error.h"
 #include "spark_wiring_led.h"
 #include "spark_wiring_diagnostics.h"
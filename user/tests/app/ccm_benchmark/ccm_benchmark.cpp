@@ -0,0 +1,78 @@
+/*
+ * Measures the throughput of AES-128-CCM-8, the record protection used by the DTLS channel.
+ *
+ * Build once as is and once with MBEDTLS_CCM_ALT disabled in the platform mbedTLS config to
+ * compare the CC310 implementation with the generic one. mbedTLS is not exported to the user
+ * module, so the application needs to be built monolithically (MODULAR=n).
+ */
+
+#include "application.h"
+#include "mbedtls/ccm.h"
+
+SYSTEM_MODE(MANUAL);
+
+namespace {
+
+const size_t RECORD_SIZES[] = { 16, 64, 256, 512, 1024 };
+const unsigned ITERATIONS = 500;
+const size_t TAG_SIZE = 8;
+const size_t NONCE_SIZE = 12;
+const size_t AAD_SIZE = 13;
+
+uint8_t g_data[1024];
+uint8_t g_tag[TAG_SIZE];
+
+void benchmark(mbedtls_ccm_context* ctx, size_t size) {
+    uint8_t nonce[NONCE_SIZE] = {};
+    uint8_t aad[AAD_SIZE] = {};
+    uint32_t encTime = 0;
+    uint32_t decTime = 0;
+    for (unsigned i = 0; i < ITERATIONS; ++i) {
+        memcpy(nonce, &i, sizeof(i));
+        uint32_t t = micros();
+        if (mbedtls_ccm_encrypt_and_tag(ctx, size, nonce, sizeof(nonce), aad, sizeof(aad), g_data, g_data,
+                g_tag, sizeof(g_tag)) != 0) {
+            Serial.println("Encryption failed");
+            return;
+        }
+        encTime += micros() - t;
+        t = micros();
+        if (mbedtls_ccm_auth_decrypt(ctx, size, nonce, sizeof(nonce), aad, sizeof(aad), g_data, g_data,
+                g_tag, sizeof(g_tag)) != 0) {
+            Serial.println("Decryption failed");
+            return;
+        }
+        decTime += micros() - t;
+    }
+    Serial.printlnf("%4u bytes: encrypt %lu us/record, %lu bytes/s; decrypt %lu us/record, %lu bytes/s",
+            (unsigned)size,
+            (unsigned long)(encTime / ITERATIONS), (unsigned long)((uint64_t)size * ITERATIONS * 1000000 / encTime),
+            (unsigned long)(decTime / ITERATIONS), (unsigned long)((uint64_t)size * ITERATIONS * 1000000 / decTime));
+}
+
+} // namespace
+
+void setup() {
+    Serial.begin();
+    waitUntil(Serial.isConnected);
+
+    const uint8_t key[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+            0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    mbedtls_ccm_context ctx;
+    mbedtls_ccm_init(&ctx);
+    if (mbedtls_ccm_setkey(&ctx, MBEDTLS_CIPHER_ID_AES, key, sizeof(key) * 8) != 0) {
+        Serial.println("Unable to set key");
+        return;
+    }
+    for (size_t i = 0; i < sizeof(g_data); ++i) {
+        g_data[i] = (uint8_t)i;
+    }
+    for (size_t size: RECORD_SIZES) {
+        benchmark(&ctx, size);
+    }
+    mbedtls_ccm_free(&ctx);
+    Serial.println("Done");
+}
+
+void loop() {
+}
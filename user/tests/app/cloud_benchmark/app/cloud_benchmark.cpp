@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Device side of the cloud latency benchmark. See README.md for how to run it with the host driver.
+ */
+
+#include "application.h"
+#include "appender.h"
+
+#include <algorithm>
+
+SYSTEM_MODE(AUTOMATIC);
+SYSTEM_THREAD(ENABLED);
+STARTUP(System.enableFeature(FEATURE_RETAINED_MEMORY));
+
+namespace {
+
+const size_t MAX_PUBLISH_ITERATIONS = 100;
+const size_t MAX_PUBLISH_SIZE = 622;
+const uint32_t OTA_MAGIC = 0x0ba7e57a;
+
+const uint16_t DIAG_IDS[] = {
+    DIAG_ID_CLOUD_BYTES_SENT,
+    DIAG_ID_CLOUD_BYTES_RECEIVED,
+    DIAG_ID_CLOUD_REPEATED_MESSAGES,
+    DIAG_ID_CLOUD_UNACKNOWLEDGED_MESSAGES
+};
+
+struct OtaStats {
+    uint32_t magic;
+    uint32_t duration; // Time between the firmware_update_begin and firmware_update_complete events
+    uint32_t chunks; // Number of firmware_update_progress events
+};
+
+retained OtaStats g_otaStats;
+
+uint32_t g_otaStart = 0;
+uint32_t g_otaChunks = 0;
+uint32_t g_otaDuration = 0; // Reported after the device has rebooted into the new firmware
+uint32_t g_otaReportedChunks = 0;
+
+char g_publishData[MAX_PUBLISH_SIZE + 1] = {};
+uint32_t g_publishTimes[MAX_PUBLISH_ITERATIONS] = {};
+String g_publishStats = "{}";
+
+int g_benchVar = 0;
+char g_benchStats[MAX_PUBLISH_SIZE + 1] = {};
+
+const char* transportName() {
+#if Wiring_Cellular
+    return "cellular";
+#elif Wiring_WiFi
+    return "wifi";
+#elif Wiring_Mesh
+    return "mesh";
+#else
+    return "unknown";
+#endif
+}
+
+// Nearest-rank percentile of a sorted array
+uint32_t percentile(const uint32_t* sorted, size_t count, unsigned p) {
+    if (!count) {
+        return 0;
+    }
+    const size_t rank = (count * p + 99) / 100;
+    return sorted[rank ? rank - 1 : 0];
+}
+
+// Performs `count` blocking publishes of `size` bytes each and stores the ACK latency statistics
+int benchPublish(size_t count, size_t size) {
+    count = std::min(count, MAX_PUBLISH_ITERATIONS);
+    size = std::min(size, MAX_PUBLISH_SIZE);
+    memset(g_publishData, 'x', size);
+    g_publishData[size] = '\0';
+    size_t done = 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t t = millis();
+        const bool ok = Particle.publish("bench", g_publishData, PRIVATE | WITH_ACK);
+        if (ok) {
+            g_publishTimes[done++] = millis() - t;
+        } else {
+            ++failed;
+        }
+    }
+    std::sort(g_publishTimes, g_publishTimes + done);
+    g_publishStats = String::format("{\"count\":%u,\"failed\":%u,\"size\":%u,\"min\":%lu,\"p50\":%lu,"
+            "\"p90\":%lu,\"p99\":%lu,\"max\":%lu}", (unsigned)done, (unsigned)failed, (unsigned)size,
+            (unsigned long)percentile(g_publishTimes, done, 0), (unsigned long)percentile(g_publishTimes, done, 50),
+            (unsigned long)percentile(g_publishTimes, done, 90), (unsigned long)percentile(g_publishTimes, done, 99),
+            (unsigned long)(done ? g_publishTimes[done - 1] : 0));
+    return done;
+}
+
+// Supported commands:
+//   echo - returns immediately, used to measure the function call round trip
+//   publish:<count>:<size> - runs the publish benchmark, the results are reported via "benchstats"
+//   var:<value> - sets the value of "benchvar"
+int benchCommand(String cmd) {
+    if (cmd == "echo") {
+        return 0;
+    }
+    unsigned count = 0;
+    unsigned size = 0;
+    if (sscanf(cmd.c_str(), "publish:%u:%u", &count, &size) == 2) {
+        return benchPublish(count, size);
+    }
+    int value = 0;
+    if (sscanf(cmd.c_str(), "var:%d", &value) == 1) {
+        g_benchVar = value;
+        return 0;
+    }
+    return SYSTEM_ERROR_INVALID_ARGUMENT;
+}
+
+void updateStats() {
+    char diag[160] = {};
+    BufferAppender appender((uint8_t*)diag, sizeof(diag) - 1);
+    if (system_format_diag_data(DIAG_IDS, sizeof(DIAG_IDS) / sizeof(DIAG_IDS[0]), 0, append_instance, &appender,
+            nullptr) != 0 || appender.overflowed()) {
+        strcpy(diag, "{}");
+    }
+    String stats = String::format("{\"transport\":\"%s\",\"platform\":%d,\"version\":\"%s\",\"diag\":%s,"
+            "\"publish\":%s,\"ota\":{\"duration\":%lu,\"chunks\":%lu}}", transportName(), PLATFORM_ID,
+            System.version().c_str(), diag, g_publishStats.c_str(), (unsigned long)g_otaDuration,
+            (unsigned long)g_otaReportedChunks);
+    // The variable is read by the system thread
+    SINGLE_THREADED_BLOCK() {
+        strlcpy(g_benchStats, stats.c_str(), sizeof(g_benchStats));
+    }
+}
+
+void firmwareUpdateHandler(system_event_t event, int param) {
+    switch (param) {
+    case firmware_update_begin:
+        g_otaStart = millis();
+        g_otaChunks = 0;
+        break;
+    case firmware_update_progress:
+        ++g_otaChunks;
+        break;
+    case firmware_update_complete:
+        g_otaStats.magic = OTA_MAGIC;
+        g_otaStats.duration = millis() - g_otaStart;
+        g_otaStats.chunks = g_otaChunks;
+        break;
+    default:
+        break;
+    }
+}
+
+} // namespace
+
+void setup() {
+    if (g_otaStats.magic == OTA_MAGIC) {
+        g_otaDuration = g_otaStats.duration;
+        g_otaReportedChunks = g_otaStats.chunks;
+        g_otaStats.magic = 0;
+    }
+    updateStats();
+    Particle.function("bench", benchCommand);
+    Particle.variable("benchvar", g_benchVar);
+    Particle.variable("benchstats", g_benchStats);
+    System.on(firmware_update, firmwareUpdateHandler);
+}
+
+void loop() {
+    static uint32_t lastUpdate = 0;
+    if (millis() - lastUpdate >= 1000) {
+        updateStats();
+        lastUpdate = millis();
+    }
+}
@@ -0,0 +1,193 @@
+#!/usr/bin/env node
+'use strict';
+
+const Particle = require('particle-api-js');
+const minimist = require('minimist');
+const fs = require('fs');
+
+const USAGE = `Usage: node main.js --device <id> --token <token> [options]
+
+Options:
+  --iterations <n>    Number of iterations per benchmark (default: 20)
+  --size <n>          Size of the event data in bytes (default: 64)
+  --ota <file>        Firmware binary for the OTA benchmark. This should be the benchmark
+                      application itself, so that the device reports the results after reboot
+  --ota-timeout <s>   Time to wait for the device to come back online (default: 300)
+`;
+
+const api = new Particle();
+
+function delay(ms) {
+  return new Promise(resolve => setTimeout(resolve, ms));
+}
+
+function now() {
+  const [s, ns] = process.hrtime();
+  return s * 1000 + ns / 1e6;
+}
+
+// Nearest-rank percentiles, same as on the device
+function summarize(samples) {
+  const sorted = samples.slice().sort((a, b) => a - b);
+  const pct = p => {
+    if (!sorted.length) {
+      return 0;
+    }
+    const rank = Math.ceil(sorted.length * p / 100);
+    return sorted[Math.max(rank - 1, 0)];
+  };
+  const round = v => Math.round(v * 10) / 10;
+  return {
+    count: sorted.length,
+    min: round(pct(0)),
+    p50: round(pct(50)),
+    p90: round(pct(90)),
+    p99: round(pct(99)),
+    max: round(sorted.length ? sorted[sorted.length - 1] : 0)
+  };
+}
+
+class Benchmark {
+  constructor(opts) {
+    this._device = opts.device;
+    this._auth = opts.token;
+  }
+
+  async call(arg) {
+    const resp = await api.callFunction({ deviceId: this._device, name: 'bench', argument: arg, auth: this._auth });
+    return resp.body.return_value;
+  }
+
+  async variable(name) {
+    const resp = await api.getVariable({ deviceId: this._device, name: name, auth: this._auth });
+    return resp.body.result;
+  }
+
+  async stats() {
+    return JSON.parse(await this.variable('benchstats'));
+  }
+
+  // Runs a benchmark phase and adds the number of bytes sent and received by the device
+  async measureTraffic(fn) {
+    // The device updates the stats once a second
+    const before = await this.stats();
+    const result = await fn();
+    await delay(1500);
+    const after = await this.stats();
+    const diag = (stats, name) => stats.diag[name] || 0;
+    result.bytes = {
+      sent: diag(after, 'cloud:txbytes') - diag(before, 'cloud:txbytes'),
+      received: diag(after, 'cloud:rxbytes') - diag(before, 'cloud:rxbytes')
+    };
+    result.resent = diag(after, 'coap:resend') - diag(before, 'coap:resend');
+    return { result, stats: after };
+  }
+
+  async functionCall(iterations) {
+    return this.measureTraffic(async () => {
+      const samples = [];
+      for (let i = 0; i < iterations; ++i) {
+        const t = now();
+        await this.call('echo');
+        samples.push(now() - t);
+      }
+      return { latency: summarize(samples) };
+    });
+  }
+
+  async variableRead(iterations) {
+    return this.measureTraffic(async () => {
+      const samples = [];
+      for (let i = 0; i < iterations; ++i) {
+        await this.call(`var:${i}`);
+        const t = now();
+        const value = await this.variable('benchvar');
+        samples.push(now() - t);
+        if (value !== i) {
+          throw new Error(`Unexpected variable value: ${value}`);
+        }
+      }
+      return { latency: summarize(samples) };
+    });
+  }
+
+  // Publish latencies are measured on the device, from the call to Particle.publish() until the
+  // cloud acknowledges the event
+  async publish(iterations, size) {
+    const r = await this.measureTraffic(async () => {
+      const done = await this.call(`publish:${iterations}:${size}`);
+      if (done < 0) {
+        throw new Error(`Publish benchmark failed: ${done}`);
+      }
+      return {};
+    });
+    const p = r.stats.publish;
+    r.result.latency = { count: p.count, min: p.min, p50: p.p50, p90: p.p90, p99: p.p99, max: p.max };
+    r.result.failed = p.failed;
+    r.result.size = p.size;
+    return r;
+  }
+
+  async ota(file, timeout) {
+    const size = fs.statSync(file).size;
+    const t = now();
+    await api.flashDevice({ deviceId: this._device, files: { file: file }, auth: this._auth });
+    // Wait until the device is back online with the benchmark application
+    const deadline = Date.now() + timeout * 1000;
+    let stats = null;
+    await delay(5000);
+    while (Date.now() < deadline) {
+      try {
+        stats = await this.stats();
+        if (stats.ota.duration) {
+          break;
+        }
+      } catch (e) {
+        // The device is still updating or rebooting
+      }
+      await delay(1000);
+    }
+    if (!stats || !stats.ota.duration) {
+      throw new Error('Device did not report the OTA results');
+    }
+    const total = now() - t;
+    return {
+      size: size,
+      // Transfer time as seen by the device
+      duration: stats.ota.duration,
+      chunks: stats.ota.chunks,
+      throughput: Math.round(size * 1000 / stats.ota.duration),
+      // Time until the device was back online, including flashing and reboot
+      total: Math.round(total)
+    };
+  }
+}
+
+async function main() {
+  const args = minimist(process.argv.slice(2));
+  if (!args.device || !args.token) {
+    process.stderr.write(USAGE);
+    process.exit(1);
+  }
+  const iterations = args.iterations || 20;
+  const size = args.size || 64;
+  const bench = new Benchmark(args);
+  const report = {};
+
+  let r = await bench.functionCall(iterations);
+  report.function_call = r.result;
+  report.transport = r.stats.transport;
+  report.platform = r.stats.platform;
+  report.version = r.stats.version;
+  report.variable_read = (await bench.variableRead(iterations)).result;
+  report.publish = (await bench.publish(iterations, size)).result;
+  if (args.ota) {
+    report.ota = await bench.ota(args.ota, args['ota-timeout'] || 300);
+  }
+  process.stdout.write(JSON.stringify(report, null, 2) + '\n');
+}
+
+main().catch(err => {
+  process.stderr.write(`${err.stack || err}\n`);
+  process.exit(1);
+});
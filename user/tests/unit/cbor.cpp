@@ -0,0 +1,230 @@
+#include "catch.hpp"
+#include "spark_wiring_cbor.h"
+
+#include <string>
+#include <cmath>
+
+namespace {
+
+using namespace spark;
+
+class StringPrint: public Print {
+public:
+    size_t write(uint8_t c) override {
+        s += (char)c;
+        return 1;
+    }
+
+    std::string s;
+};
+
+std::string encode(void (*f)(CBORWriter&)) {
+    char buf[256];
+    CBORBufferWriter w(buf, sizeof(buf));
+    f(w);
+    REQUIRE(w.dataSize() <= sizeof(buf));
+    return std::string(buf, w.dataSize());
+}
+
+std::string bytes(std::initializer_list<uint8_t> b) {
+    return std::string(b.begin(), b.end());
+}
+
+} // namespace
+
+TEST_CASE("CBORWriter") {
+    SECTION("integers use the shortest encoding") {
+        CHECK(encode([](CBORWriter& w) { w.value(0); }) == bytes({ 0x00 }));
+        CHECK(encode([](CBORWriter& w) { w.value(23); }) == bytes({ 0x17 }));
+        CHECK(encode([](CBORWriter& w) { w.value(24); }) == bytes({ 0x18, 0x18 }));
+        CHECK(encode([](CBORWriter& w) { w.value(1000); }) == bytes({ 0x19, 0x03, 0xe8 }));
+        CHECK(encode([](CBORWriter& w) { w.value(1000000); }) == bytes({ 0x1a, 0x00, 0x0f, 0x42, 0x40 }));
+        CHECK(encode([](CBORWriter& w) { w.value(1000000000000ull); }) ==
+                bytes({ 0x1b, 0x00, 0x00, 0x00, 0xe8, 0xd4, 0xa5, 0x10, 0x00 }));
+        CHECK(encode([](CBORWriter& w) { w.value(-1); }) == bytes({ 0x20 }));
+        CHECK(encode([](CBORWriter& w) { w.value(-100); }) == bytes({ 0x38, 0x63 }));
+        CHECK(encode([](CBORWriter& w) { w.value(-1000); }) == bytes({ 0x39, 0x03, 0xe7 }));
+    }
+    SECTION("simple values") {
+        CHECK(encode([](CBORWriter& w) { w.value(false); }) == bytes({ 0xf4 }));
+        CHECK(encode([](CBORWriter& w) { w.value(true); }) == bytes({ 0xf5 }));
+        CHECK(encode([](CBORWriter& w) { w.nullValue(); }) == bytes({ 0xf6 }));
+    }
+    SECTION("floating point values") {
+        CHECK(encode([](CBORWriter& w) { w.value(1.5f); }) == bytes({ 0xfa, 0x3f, 0xc0, 0x00, 0x00 }));
+        // Doubles that can be represented exactly in single precision are encoded as floats
+        CHECK(encode([](CBORWriter& w) { w.value(1.5); }) == bytes({ 0xfa, 0x3f, 0xc0, 0x00, 0x00 }));
+        CHECK(encode([](CBORWriter& w) { w.value(1.1); }) ==
+                bytes({ 0xfb, 0x3f, 0xf1, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a }));
+    }
+    SECTION("strings") {
+        CHECK(encode([](CBORWriter& w) { w.value(""); }) == bytes({ 0x60 }));
+        CHECK(encode([](CBORWriter& w) { w.value("IETF"); }) == bytes({ 0x64, 'I', 'E', 'T', 'F' }));
+        CHECK(encode([](CBORWriter& w) { w.value(String("abc")); }) == bytes({ 0x63, 'a', 'b', 'c' }));
+        CHECK(encode([](CBORWriter& w) { w.bytesValue("\x01\x02", 2); }) == bytes({ 0x42, 0x01, 0x02 }));
+    }
+    SECTION("arrays and objects") {
+        CHECK(encode([](CBORWriter& w) {
+            w.beginObject().name("a").value(1).name("b").beginArray().value(2).value(3).endArray().endObject();
+        }) == bytes({ 0xbf, 0x61, 'a', 0x01, 0x61, 'b', 0x9f, 0x02, 0x03, 0xff, 0xff }));
+    }
+    SECTION("buffer writer reports the full size of the data") {
+        char buf[4] = {};
+        CBORBufferWriter w(buf, 2);
+        w.value("abc");
+        CHECK(w.dataSize() == 4);
+        CHECK(std::string(buf, 2) == bytes({ 0x63, 'a' }));
+        CHECK(buf[2] == 0);
+    }
+    SECTION("stream writer") {
+        StringPrint p;
+        CBORStreamWriter w(p);
+        w.beginArray().value(1).value(true).endArray();
+        CHECK(p.s == bytes({ 0x9f, 0x01, 0xf5, 0xff }));
+    }
+}
+
+TEST_CASE("CBORReader") {
+    SECTION("round trip") {
+        char buf[128];
+        CBORBufferWriter w(buf, sizeof(buf));
+        w.beginObject();
+        w.name("int").value(-1000);
+        w.name("big").value(1000000000000ull);
+        w.name("float").value(0.25f);
+        w.name("double").value(1.1);
+        w.name("str").value("text");
+        w.name("bin").bytesValue("\x00\xff", 2);
+        w.name("arr").beginArray().value(true).nullValue().endArray();
+        w.endObject();
+        REQUIRE(w.dataSize() <= sizeof(buf));
+
+        CBORReader r(buf, w.dataSize());
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_OBJECT);
+        CHECK(r.isIndefinite());
+        CHECK(r.depth() == 1);
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_STRING);
+        CHECK(std::string(r.data(), r.size()) == "int");
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_INT);
+        CHECK(r.toInt() == -1000);
+        REQUIRE(r.next());
+        REQUIRE(r.next());
+        CHECK(r.toInt() == 1000000000000ll);
+        REQUIRE(r.next());
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_FLOAT);
+        CHECK(r.toDouble() == 0.25);
+        REQUIRE(r.next());
+        REQUIRE(r.next());
+        CHECK(r.toDouble() == 1.1);
+        REQUIRE(r.next());
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_STRING);
+        CHECK(std::string(r.data(), r.size()) == "text");
+        REQUIRE(r.next());
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_BYTES);
+        CHECK(std::string(r.data(), r.size()) == bytes({ 0x00, 0xff }));
+        REQUIRE(r.next());
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_ARRAY);
+        CHECK(r.depth() == 2);
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_BOOL);
+        CHECK(r.toBool());
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_NULL);
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_END);
+        CHECK(r.depth() == 1);
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_END);
+        CHECK(r.depth() == 0);
+        CHECK_FALSE(r.next());
+        CHECK_FALSE(r.hasError());
+    }
+    SECTION("definite-length containers") {
+        // {"a": [1, 2], "b": half(-2.0)}
+        const std::string d = bytes({ 0xa2, 0x61, 'a', 0x82, 0x01, 0x02, 0x61, 'b', 0xf9, 0xc0, 0x00 });
+        CBORReader r(d.data(), d.size());
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_OBJECT);
+        CHECK_FALSE(r.isIndefinite());
+        CHECK(r.size() == 2);
+        REQUIRE(r.next());
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_ARRAY);
+        CHECK(r.size() == 2);
+        REQUIRE(r.next());
+        CHECK(r.toInt() == 1);
+        REQUIRE(r.next());
+        CHECK(r.toInt() == 2);
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_END);
+        REQUIRE(r.next());
+        CHECK(std::string(r.data(), r.size()) == "b");
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_FLOAT);
+        CHECK(r.toDouble() == -2.0);
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_END);
+        CHECK_FALSE(r.next());
+        CHECK_FALSE(r.hasError());
+    }
+    SECTION("tags are skipped") {
+        // 1(1363896240)
+        const std::string d = bytes({ 0xc1, 0x1a, 0x51, 0x4b, 0x67, 0xb0 });
+        CBORReader r(d.data(), d.size());
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_INT);
+        CHECK(r.toInt() == 1363896240);
+    }
+    SECTION("skipping containers") {
+        const std::string d = bytes({ 0x82, 0x9f, 0x01, 0xa1, 0x01, 0x02, 0xff, 0x03 });
+        CBORReader r(d.data(), d.size());
+        REQUIRE(r.next());
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_ARRAY);
+        REQUIRE(r.skip());
+        REQUIRE(r.next());
+        CHECK(r.toInt() == 3);
+        REQUIRE(r.next());
+        CHECK(r.type() == CBOR_TYPE_END);
+        CHECK_FALSE(r.next());
+        CHECK_FALSE(r.hasError());
+    }
+    SECTION("malformed data") {
+        const std::string truncated = bytes({ 0x82, 0x01 });
+        CBORReader r1(truncated.data(), truncated.size());
+        REQUIRE(r1.next());
+        REQUIRE(r1.next());
+        CHECK_FALSE(r1.next());
+        CHECK(r1.hasError());
+
+        const std::string longString = bytes({ 0x65, 'a', 'b' });
+        CBORReader r2(longString.data(), longString.size());
+        CHECK_FALSE(r2.next());
+        CHECK(r2.hasError());
+
+        const std::string unexpectedBreak = bytes({ 0x81, 0xff });
+        CBORReader r3(unexpectedBreak.data(), unexpectedBreak.size());
+        REQUIRE(r3.next());
+        CHECK_FALSE(r3.next());
+        CHECK(r3.hasError());
+
+        std::string deep(CBORReader::MAX_DEPTH + 1, (char)0x9f);
+        CBORReader r4(deep.data(), deep.size());
+        for (unsigned i = 0; i < CBORReader::MAX_DEPTH; ++i) {
+            REQUIRE(r4.next());
+        }
+        CHECK_FALSE(r4.next());
+        CHECK(r4.hasError());
+
+        CBORReader r5(nullptr, 0);
+        CHECK_FALSE(r5.next());
+        CHECK_FALSE(r5.hasError());
+    }
+}
@@ -443,3 +443,95 @@ SCENARIO_METHOD(TestDCD, "secondary (invalid_v2) sector is selected as valid if
     // Validate data
     assertMemoryEqual(read(0), temp, sizeof(temp));
 }
+
+SCENARIO("DCD transaction writes all data with a single sector rewrite", "[dcd]")
+{
+    TestDCD dcd;
+    REQUIRE_FALSE(dcd.write(23, "abcdef", 6));
+    dcd.store.resetEraseCount();
+
+    dcd.begin();
+    REQUIRE_FALSE(dcd.write(0, "1234", 4));
+    REQUIRE_FALSE(dcd.write(100, "batman", 6));
+    REQUIRE_FALSE(dcd.write(25, "XY", 2));
+    REQUIRE_FALSE(dcd.write(102, "TM", 2));
+    REQUIRE(dcd.store.getEraseCount() == 0);
+    REQUIRE_FALSE(dcd.commit());
+    REQUIRE(dcd.store.getEraseCount() == 1);
+
+    assertMemoryEqual(dcd.read(0), (const uint8_t*)"1234", 4);
+    assertMemoryEqual(dcd.read(23), (const uint8_t*)"abXYef", 6);
+    // later writes take precedence
+    assertMemoryEqual(dcd.read(100), (const uint8_t*)"baTMan", 6);
+    REQUIRE(*dcd.read(4) == 0xFF);
+    REQUIRE(dcd.store.getEraseCount() == 1);
+}
+
+SCENARIO("DCD nested transactions are written when the outermost transaction is committed", "[dcd]")
+{
+    TestDCD dcd;
+    REQUIRE_FALSE(dcd.write(23, "abcdef", 6));
+    dcd.store.resetEraseCount();
+
+    dcd.begin();
+    REQUIRE_FALSE(dcd.write(23, "batman", 6));
+    dcd.begin();
+    REQUIRE_FALSE(dcd.write(50, "robin", 5));
+    REQUIRE_FALSE(dcd.commit());
+    REQUIRE(dcd.store.getEraseCount() == 0);
+    REQUIRE_FALSE(dcd.commit());
+    REQUIRE(dcd.store.getEraseCount() == 1);
+
+    assertMemoryEqual(dcd.read(23), (const uint8_t*)"batman", 6);
+    assertMemoryEqual(dcd.read(50), (const uint8_t*)"robin", 5);
+}
+
+SCENARIO("DCD transaction can be rolled back", "[dcd]")
+{
+    TestDCD dcd;
+    REQUIRE_FALSE(dcd.write(23, "abcdef", 6));
+    dcd.store.resetEraseCount();
+
+    dcd.begin();
+    REQUIRE_FALSE(dcd.write(23, "batman", 6));
+    dcd.rollback();
+    REQUIRE_FALSE(dcd.commit());
+
+    REQUIRE(dcd.store.getEraseCount() == 0);
+    assertMemoryEqual(dcd.read(23), (const uint8_t*)"abcdef", 6);
+}
+
+SCENARIO("DCD read during a transaction returns the data written so far", "[dcd]")
+{
+    TestDCD dcd;
+    dcd.begin();
+    REQUIRE_FALSE(dcd.write(23, "batman", 6));
+    assertMemoryEqual(dcd.read(23), (const uint8_t*)"batman", 6);
+    REQUIRE_FALSE(dcd.write(23, "robin", 5));
+    REQUIRE_FALSE(dcd.commit());
+    assertMemoryEqual(dcd.read(23), (const uint8_t*)"robinn", 6);
+}
+
+SCENARIO("DCD transaction is atomic if partial failure", "[dcd]")
+{
+    for (int write_count=1; write_count<5; write_count++)
+    {
+        TestDCD dcd;
+        REQUIRE_FALSE(dcd.write(23, "batman", 6));
+        REQUIRE_FALSE(dcd.write(100, "robin", 5));
+
+        dcd.begin();
+        REQUIRE_FALSE(dcd.write(23, "7890-!", 6));
+        REQUIRE_FALSE(dcd.write(100, "joker", 5));
+
+        // mock a power failure after a certain number of writes
+        dcd.store.setWriteCount(write_count);
+        CAPTURE(write_count);
+        REQUIRE(dcd.commit());
+        dcd.store.setWriteCount(INT_MAX);
+
+        // none of the data has been written
+        assertMemoryEqual(dcd.read(23), (const uint8_t*)"batman", 6);
+        assertMemoryEqual(dcd.read(100), (const uint8_t*)"robin", 5);
+    }
+}
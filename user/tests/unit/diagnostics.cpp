@@ -404,6 +404,37 @@ void testPersistentEnumDiagnosticData(DiagService& diag) {
     }
 }
 
+template<template<typename ConcurrencyT> class DiagnosticDataT, typename ConcurrencyT>
+void testHistogramDiagnosticData(DiagService& diag) {
+    using DiagnosticData = DiagnosticDataT<ConcurrencyT>;
+
+    DiagnosticData d(1);
+    diag.start();
+
+    SECTION("add()") {
+        d.add(0);
+        d.add(1);
+        d.add(100);
+        d.add(100);
+        d.add(0xffffffff);
+        diag_histogram h = {};
+        CHECK(AbstractHistogramDiagnosticData::get(1, h) == 0);
+        CHECK(h.sum == 200);
+        CHECK(h.buckets[0] == 1);
+        CHECK(h.buckets[1] == 1);
+        CHECK(h.buckets[7] == 2);
+        CHECK(h.buckets[DIAG_HISTOGRAM_BUCKET_COUNT - 1] == 1);
+        CHECK(AbstractHistogramDiagnosticData::count(h) == 5);
+    }
+
+    SECTION("histogram()") {
+        d.add(3);
+        const diag_histogram h = d.histogram();
+        CHECK(h.sum == 3);
+        CHECK(h.buckets[2] == 1);
+    }
+}
+
 } // namespace
 
 TEST_CASE("Service API") {
@@ -610,6 +641,21 @@ TEST_CASE("Wiring API") {
         testIntegerDiagnosticData<IntegerDiagnosticData, AtomicConcurrency>(diag);
     }
 
+    SECTION("CounterDiagnosticData") {
+        using IntType = AbstractIntegerDiagnosticData::IntType;
+
+        CounterDiagnosticData d(1, nullptr, 10);
+        diag.start();
+
+        CHECK(d == 10);
+        CHECK(++d == 11);
+        CHECK(d++ == 11);
+        CHECK((d += 3) == 15);
+        IntType val = -1;
+        CHECK(AbstractIntegerDiagnosticData::get(1, val) == 0);
+        CHECK(val == 15);
+    }
+
     SECTION("PersistentIntegerDiagnosticData") {
         testPersistentIntegerDiagnosticData<PersistentIntegerDiagnosticData, NoConcurrency>(diag);
         // testPersistentIntegerDiagnosticData<PersistentIntegerDiagnosticData, AtomicConcurrency>(diag);
@@ -624,4 +670,58 @@ TEST_CASE("Wiring API") {
         testPersistentEnumDiagnosticData<PersistentEnumDiagnosticData, NoConcurrency>(diag);
         // testPersistentEnumDiagnosticData<PersistentEnumDiagnosticData, AtomicConcurrency>(diag);
     }
+
+    SECTION("HistogramDiagnosticData") {
+        testHistogramDiagnosticData<HistogramDiagnosticData, NoConcurrency>(diag);
+        testHistogramDiagnosticData<HistogramDiagnosticData, AtomicConcurrency>(diag);
+    }
+
+    SECTION("AbstractHistogramDiagnosticData") {
+        using H = AbstractHistogramDiagnosticData;
+
+        SECTION("bucketIndex()") {
+            CHECK(H::bucketIndex(0) == 0);
+            CHECK(H::bucketIndex(1) == 1);
+            CHECK(H::bucketIndex(2) == 2);
+            CHECK(H::bucketIndex(3) == 2);
+            CHECK(H::bucketIndex(4) == 3);
+            CHECK(H::bucketIndex(1000) == 10);
+            CHECK(H::bucketIndex(0x80000000) == H::BUCKET_COUNT - 1);
+        }
+
+        SECTION("bucketLowerBound()") {
+            CHECK(H::bucketLowerBound(0) == 0);
+            CHECK(H::bucketLowerBound(1) == 1);
+            CHECK(H::bucketLowerBound(10) == 512);
+        }
+
+        SECTION("percentile()") {
+            diag_histogram h = {};
+            CHECK(H::percentile(h, 50) == 0);
+            h.buckets[4] = 98; // 8..15
+            h.buckets[10] = 2; // 512..1023
+            CHECK(H::percentile(h, 0) == 15);
+            CHECK(H::percentile(h, 50) == 15);
+            CHECK(H::percentile(h, 98) == 15);
+            CHECK(H::percentile(h, 99) == 1023);
+            CHECK(H::percentile(h, 100) == 1023);
+            h.buckets[H::BUCKET_COUNT - 1] = 100;
+            CHECK(H::percentile(h, 99) == H::bucketLowerBound(H::BUCKET_COUNT - 1));
+        }
+
+        SECTION("merge()") {
+            diag_histogram h1 = {};
+            h1.sum = 10;
+            h1.buckets[1] = 1;
+            diag_histogram h2 = {};
+            h2.sum = 5;
+            h2.buckets[1] = 2;
+            h2.buckets[3] = 1;
+            H::merge(h1, h2);
+            CHECK(h1.sum == 15);
+            CHECK(h1.buckets[1] == 3);
+            CHECK(h1.buckets[3] == 1);
+            CHECK(H::count(h1) == 4);
+        }
+    }
 }
@@ -1338,3 +1338,102 @@ TEST_CASE("Page swap with data in multiple batches", "[eeprom]")
         REQUIRE(dataRead == data);
     }
 }
+
+TEST_CASE("Write-back cache", "[eeprom]")
+{
+    TestEEPROM eeprom;
+    EEPROMTester tester(eeprom);
+
+    eeprom.init();
+    eeprom.put(0, 0xAA);
+
+    REQUIRE(eeprom.setWriteBack(true) == true);
+
+    SECTION("put only updates the RAM copy")
+    {
+        eeprom.put(1, 0xBB);
+
+        tester.requireContents(PageBase1, PAGE_ACTIVE, {
+            Record(0, 0xAA)
+        });
+
+        THEN("get returns the put record")
+        {
+            uint8_t value;
+            eeprom.get(1, value);
+
+            REQUIRE(value == 0xBB);
+            REQUIRE(eeprom.hasPendingWrite() == true);
+        }
+    }
+
+    SECTION("flush writes only the latest value of each record")
+    {
+        for(int i = 0; i < 10; i++)
+        {
+            eeprom.put(0, (uint8_t)i);
+            eeprom.put(2, (uint8_t)(i + 10));
+        }
+
+        REQUIRE(eeprom.flush() == true);
+        REQUIRE(eeprom.hasPendingWrite() == false);
+
+        tester.requireContents(PageBase1, PAGE_ACTIVE, {
+            Record(0, 0xAA),
+            Record(2, 19),
+            Record(0, 9)
+        });
+    }
+
+    SECTION("Disabling write-back flushes the pending changes")
+    {
+        eeprom.put(1, 0xBB);
+
+        REQUIRE(eeprom.setWriteBack(false) == true);
+
+        tester.requireContents(PageBase1, PAGE_ACTIVE, {
+            Record(0, 0xAA),
+            Record(1, 0xBB)
+        });
+    }
+
+    SECTION("Pending changes are discarded if flush fails")
+    {
+        eeprom.put(0, 0xCC);
+
+        eeprom.store.discardWritesAfter(0, [&] {
+            REQUIRE(eeprom.flush() == false);
+        });
+
+        uint8_t value;
+        eeprom.get(0, value);
+
+        REQUIRE(value == 0xAA);
+        REQUIRE(eeprom.hasPendingWrite() == false);
+    }
+
+    SECTION("Page swap writes the values from RAM")
+    {
+        uint16_t writesToFillPage1 = PageSize1 / sizeof(TestEEPROM::Record) - 3;
+
+        for(uint32_t i = 0; i < writesToFillPage1; i++)
+        {
+            eeprom.put(1, (uint8_t)i);
+            eeprom.flush();
+        }
+
+        REQUIRE(eeprom.getActivePage() == Page1);
+
+        eeprom.put(1, 0xBB);
+        eeprom.put(3, 0xDD);
+        eeprom.flush();
+
+        REQUIRE(eeprom.getActivePage() == Page2);
+
+        tester.requireContents(PageBase2, PAGE_ACTIVE, {
+            Record(0, 0xAA),
+            Record(1, 0xBB),
+            Record(3, 0xDD)
+        });
+    }
+}
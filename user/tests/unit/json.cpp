@@ -1,5 +1,6 @@
 #include "spark_wiring_json.h"
 #include "spark_wiring_print.h"
+#include "allocator.h"
 
 #include "tools/stream.h"
 #include "tools/buffer.h"
@@ -362,6 +363,47 @@ TEST_CASE("Parsing JSON") {
     }
 }
 
+TEST_CASE("Parsing JSON with a custom allocator") {
+    particle::StaticArenaAllocator<1024> arena;
+
+    SECTION("all data is allocated by the allocator") {
+        const std::string json = "{\"a\":1,\"b\":[true,\"c\"]}";
+        {
+            const JSONValue v = JSONValue::parseCopy(json.data(), json.size(), &arena);
+            CHECK(arena.used() > json.size());
+            check(v).beginObject()
+                .name("a").number(1)
+                .name("b").beginArray()
+                    .boolean(true)
+                    .string("c")
+                .endArray()
+            .endObject();
+        }
+        arena.reset();
+        char data[] = "[1,2]";
+        {
+            const JSONValue v = JSONValue::parse(data, sizeof(data) - 1, &arena);
+            check(v).beginArray().number(1).number(2).endArray();
+            CHECK(arena.used() > 0);
+        }
+        // The JSON data wasn't copied
+        CHECK(arena.used() < 1024);
+    }
+
+    SECTION("primitive values are copied") {
+        char data[] = "123";
+        const JSONValue v = JSONValue::parse(data, sizeof(data) - 1, &arena);
+        check(v).number(123);
+    }
+
+    SECTION("fails gracefully when the allocator is exhausted") {
+        particle::StaticArenaAllocator<64> small;
+        const JSONValue v = JSONValue::parseCopy("[1,2,3,4,5,6,7,8]", 17, &small);
+        CHECK_FALSE(v.isValid());
+        CHECK(small.failures() > 0);
+    }
+}
+
 TEST_CASE("Writing JSON") {
     test::OutputStream data;
     JSONStreamWriter json(data);
@@ -1091,6 +1133,32 @@ TEST_CASE("JSONStreamWriter") {
     }
 }
 
+TEST_CASE("JSONBufferedStreamWriter") {
+    SECTION("writes buffered data to the stream") {
+        test::OutputStream strm;
+        char buf[8];
+        {
+            JSONBufferedStreamWriter w(strm, buf, sizeof(buf));
+            w.beginObject().name("a").value(1);
+            check(strm).isEmpty();
+            w.name("abcdefghijklmnopqrstuvwxyz").value("x\"y\n\x01").endObject();
+        }
+        check(strm).equals("{\"a\":1,\"abcdefghijklmnopqrstuvwxyz\":\"x\\\"y\\n\\u0001\"}");
+    }
+
+    SECTION("flush()") {
+        test::OutputStream strm;
+        char buf[16];
+        JSONBufferedStreamWriter w(strm, buf, sizeof(buf));
+        w.beginArray().value(true);
+        w.flush();
+        check(strm).equals("[true");
+        w.endArray();
+        w.flush();
+        check(strm).equals("[true]");
+    }
+}
+
 TEST_CASE("JSONBufferWriter") {
     SECTION("construction") {
         test::Buffer buf; // Empty buffer
@@ -1117,3 +1185,181 @@ TEST_CASE("JSONBufferWriter") {
         CHECK(buf.isPaddingValid());
     }
 }
+
+namespace {
+
+// Records parsing events in a compact textual form
+class TestHandler: public JSONHandler {
+public:
+    std::string events;
+    int stopAfter = -1; // Number of events after which parsing is stopped
+
+    bool beginArray() override {
+        return event("[");
+    }
+
+    bool endArray() override {
+        return event("]");
+    }
+
+    bool beginObject() override {
+        return event("{");
+    }
+
+    bool endObject() override {
+        return event("}");
+    }
+
+    bool name(const char *name, size_t size) override {
+        CHECK(strlen(name) == size);
+        return event("k:" + std::string(name, size));
+    }
+
+    bool value(bool val) override {
+        return event(val ? "true" : "false");
+    }
+
+    bool value(const char *val, size_t size) override {
+        CHECK(val[size] == '\0');
+        return event("s:" + std::string(val, size));
+    }
+
+    bool number(const char *val, size_t size) override {
+        CHECK(strlen(val) == size);
+        return event("n:" + std::string(val, size));
+    }
+
+    bool nullValue() override {
+        return event("null");
+    }
+
+private:
+    bool event(const std::string &e) {
+        if (!events.empty()) {
+            events += ' ';
+        }
+        events += e;
+        return stopAfter < 0 || --stopAfter > 0;
+    }
+};
+
+// Parses a document passing it to the parser in chunks of the specified size
+std::string parseStream(const std::string &json, size_t chunkSize = 0, size_t bufSize = 64) {
+    TestHandler h;
+    std::unique_ptr<char[]> buf(new char[bufSize]);
+    JSONStreamParser p(&h, buf.get(), bufSize);
+    if (!chunkSize) {
+        chunkSize = json.size();
+    }
+    for (size_t i = 0; i < json.size(); i += chunkSize) {
+        if (!p.parse(json.data() + i, std::min(chunkSize, json.size() - i))) {
+            CHECK(p.hasError());
+            return "error";
+        }
+    }
+    if (!p.finish()) {
+        CHECK(p.hasError());
+        return "error";
+    }
+    CHECK_FALSE(p.hasError());
+    return h.events;
+}
+
+} // namespace
+
+TEST_CASE("JSONStreamParser") {
+    SECTION("compound values") {
+        const std::string json = " { \"a\" : [1, -2.5e+3, true, false, null, \"x\"], \"b\": {}, \"c\": [], \"d\": [[{}]] } ";
+        const std::string expected = "{ k:a [ n:1 n:-2.5e+3 true false null s:x ] k:b { } k:c [ ] k:d [ [ { } ] ] }";
+        CHECK(parseStream(json) == expected);
+        // The result doesn't depend on how the document is split into chunks
+        for (size_t i = 1; i < 8; ++i) {
+            CATCH_CAPTURE(i);
+            CHECK(parseStream(json, i) == expected);
+        }
+    }
+
+    SECTION("primitive values") {
+        CHECK(parseStream("123") == "n:123");
+        CHECK(parseStream(" 0.5 ", 1) == "n:0.5");
+        CHECK(parseStream("true") == "true");
+        CHECK(parseStream("null") == "null");
+        CHECK(parseStream("\"abc\"") == "s:abc");
+        CHECK(parseStream("\"\"") == "s:");
+    }
+
+    SECTION("escaped characters") {
+        CHECK(parseStream("\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"") == "s:\"\\/\b\f\n\r\t");
+        CHECK(parseStream("[\"\\u0041\\u00e9\\u20AC\"]", 1) == "[ s:A\xc3\xa9\xe2\x82\xac ]");
+        // Surrogate pair
+        CHECK(parseStream("\"\\ud83d\\ude00\"", 1) == "s:\xf0\x9f\x98\x80");
+        // Unpaired surrogates are replaced with U+FFFD
+        CHECK(parseStream("\"\\ud83dx\\ud83d\"") == "s:\xef\xbf\xbdx\xef\xbf\xbd");
+        CHECK(parseStream("{\"\\u0061\":1}") == "{ k:a n:1 }");
+    }
+
+    SECTION("malformed documents") {
+        CHECK(parseStream("") == "error");
+        CHECK(parseStream("   ") == "error");
+        CHECK(parseStream("[1,2") == "error");
+        CHECK(parseStream("[1,2}") == "error");
+        CHECK(parseStream("{\"a\"}") == "error");
+        CHECK(parseStream("{\"a\":1,}") == "error");
+        CHECK(parseStream("{1:2}") == "error");
+        CHECK(parseStream("[1,]") == "error");
+        CHECK(parseStream("[1 2]") == "error");
+        CHECK(parseStream("[] []") == "error");
+        CHECK(parseStream("]") == "error");
+        CHECK(parseStream("[tru]") == "error");
+        CHECK(parseStream("[01]") == "error");
+        CHECK(parseStream("[1.]") == "error");
+        CHECK(parseStream("[-]") == "error");
+        CHECK(parseStream("[1e]") == "error");
+        CHECK(parseStream("\"abc") == "error");
+        CHECK(parseStream("\"a\nb\"") == "error");
+        CHECK(parseStream("\"\\x\"") == "error");
+        CHECK(parseStream("\"\\u00g0\"") == "error");
+    }
+
+    SECTION("strings that don't fit in the buffer are rejected") {
+        CHECK(parseStream("[\"abcdefg\"]", 0, 8) == "[ s:abcdefg ]");
+        CHECK(parseStream("[\"abcdefgh\"]", 0, 8) == "error");
+        CHECK(parseStream("[1234567]", 0, 8) == "[ n:1234567 ]");
+        CHECK(parseStream("[12345678]", 0, 8) == "error");
+    }
+
+    SECTION("nesting level is limited") {
+        const std::string ok = std::string(JSONStreamParser::MAX_DEPTH, '[') + std::string(JSONStreamParser::MAX_DEPTH, ']');
+        CHECK(parseStream(ok) != "error");
+        const std::string tooDeep = std::string(JSONStreamParser::MAX_DEPTH + 1, '[') +
+                std::string(JSONStreamParser::MAX_DEPTH + 1, ']');
+        CHECK(parseStream(tooDeep) == "error");
+    }
+
+    SECTION("handler can stop parsing") {
+        TestHandler h;
+        h.stopAfter = 2;
+        char buf[16];
+        JSONStreamParser p(&h, buf, sizeof(buf));
+        CHECK_FALSE(p.parse("[1,2,3]"));
+        CHECK(p.hasError());
+        CHECK(h.events == "[ n:1");
+        // Parser ignores any further data
+        CHECK_FALSE(p.parse("]"));
+        CHECK_FALSE(p.finish());
+    }
+
+    SECTION("parser can be reused after reset") {
+        TestHandler h;
+        char buf[16];
+        JSONStreamParser p(&h, buf, sizeof(buf));
+        CHECK_FALSE(p.parse("[}"));
+        p.reset();
+        CHECK_FALSE(p.hasError());
+        h.events.clear();
+        CHECK(p.parse("{\"a\":"));
+        CHECK(p.parse("7}"));
+        CHECK(p.finish());
+        CHECK(h.events == "{ k:a n:7 }");
+    }
+}
@@ -353,6 +353,27 @@ TEST_CASE("LEDStatus") {
         }
     }
 
+    SECTION("changing parameters of active status within pattern period") {
+        LEDStatus s(Color::WHITE, LED_PATTERN_BLINK, 1000);
+        s.setActive();
+        update();
+        CHECK(led.color() == Color::WHITE);
+        update(100);
+        s.setColor(Color::RED); // Change color while LED is on
+        update(100);
+        CHECK(led.color() == Color::RED);
+        LED_SetBrightness(0); // Change brightness while LED is on
+        update(100);
+        CHECK(led.color() == Color::BLACK);
+        LED_SetBrightness(255);
+        update(100);
+        CHECK(led.color() == Color::RED);
+        update(200); // Second half of the period
+        CHECK(led.color() == Color::BLACK);
+        update(500); // First half of the next period
+        CHECK(led.color() == Color::RED);
+    }
+
     SECTION("temporary disabling LED updates") {
         LEDStatus s(Color::WHITE);
         s.setActive();
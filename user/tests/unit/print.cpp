@@ -56,3 +56,20 @@ SCENARIO("Print.printf() with a a > 20 char string", "[print]")
     print.printf("abcdabcdabcdabcd %d xyzxyzxyzxyzxyzxyzxyzxyz", 100);
     REQUIRE(String("abcdabcdabcdabcd 100 xyzxyzxyzxyzxyzxyzxyzxyz") == print.result());
 }
+
+SCENARIO("Print.printf() with an output longer than the formatting buffer", "[print]")
+{
+    BufferPrint print;
+    const String s(String::format("%0100d", 1));
+    size_t n = print.printf("%s|%.3f|%x", s.c_str(), 2.5, 255);
+    REQUIRE(n == 109);
+    REQUIRE(print.result() == s + "|2.500|ff");
+}
+
+SCENARIO("Print.print() with a floating point number", "[print]")
+{
+    BufferPrint print;
+    REQUIRE(print.print(-1.999, 2) == 5);
+    REQUIRE(print.print(3.14159, 4) == 6);
+    REQUIRE(print.result() == "-2.003.1416");
+}
@@ -101,3 +101,67 @@ TEST_CASE("Substring with left and right after the end returns until the end of
 TEST_CASE("Substring with flipped left and right returns the correct substring") {
     REQUIRE(String("test123").substring(5, 3)==String("t1"));
 }
+
+TEST_CASE("Short strings can grow beyond the inline buffer") {
+    String s("abc");
+    for (int i = 0; i < 10; ++i) {
+        s += "0123456789";
+    }
+    REQUIRE(s.length() == 103);
+    REQUIRE(s.startsWith("abc0123456789"));
+    REQUIRE(s.endsWith("789"));
+    s = "x";
+    REQUIRE(s == "x");
+}
+
+TEST_CASE("Strings can be moved regardless of their length") {
+    String small("small");
+    String large("a string that is too long for the inline buffer");
+    String a(std::move(small));
+    String b(std::move(large));
+    REQUIRE(a == "small");
+    REQUIRE(b == "a string that is too long for the inline buffer");
+    String c("another string that is too long for the inline buffer");
+    c = std::move(a);
+    REQUIRE(c == "small");
+    a = std::move(b);
+    REQUIRE(a == "a string that is too long for the inline buffer");
+    String d;
+    d = String("temporary");
+    REQUIRE(d == "temporary");
+}
+
+TEST_CASE("String can be appended to itself") {
+    String s("0123456789");
+    s += s;
+    REQUIRE(s == "01234567890123456789");
+}
+
+TEST_CASE("StringBuilder concatenates operands of different types") {
+    String s = StringBuilder().append("temp=", 21, ", hum=", 45.5, ", ok=", 'y').toString();
+    REQUIRE(s == "temp=21, hum=45.500000, ok=y");
+    StringBuilder b;
+    b << String("a") << "b" << 1u << -1L << (unsigned char)2;
+    REQUIRE(b.length() == 6);
+    REQUIRE(b.toString() == "ab1-12");
+}
+
+TEST_CASE("StringBuilder is empty after the result is taken") {
+    StringBuilder b(64);
+    b.append("a string that is too long for the inline buffer");
+    REQUIRE(b.isValid());
+    String s = b.toString();
+    REQUIRE(s.length() == 47);
+    REQUIRE(b.length() == 0);
+    REQUIRE(b.isValid());
+    b.append("next");
+    REQUIRE(b.toString() == "next");
+}
+
+TEST_CASE("StringBuilder can be moved") {
+    StringBuilder a;
+    a.append("abc");
+    StringBuilder b(std::move(a));
+    b.append("def");
+    REQUIRE(b.toString() == "abcdef");
+}
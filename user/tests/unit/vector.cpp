@@ -1,4 +1,5 @@
 #include "spark_wiring_vector.h"
+#include "allocator.h"
 
 #include "tools/catch.h"
 #include "tools/alloc.h"
@@ -650,6 +651,9 @@ void testVector() {
     }
 }
 
+uint8_t g_arenaBuf[1024];
+particle::ArenaAllocator g_arena(g_arenaBuf, sizeof(g_arenaBuf));
+
 } // namespace
 
 TEST_CASE("Vector<int>") {
@@ -670,3 +674,19 @@ TEST_CASE("Vector<NonTrivialInt>") {
     test::DefaultAllocator::check();
     CHECK(NonTrivialInt::instanceCount() == 0);
 }
+
+TEST_CASE("Vector<int> with an arena allocator") {
+    g_arena.reset();
+
+    using Vector = spark::Vector<int, particle::StaticAllocatorRef<particle::ArenaAllocator, g_arena>>;
+    testVector<Vector>();
+
+    g_arena.reset();
+    Vector v;
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(v.append(i));
+    }
+    // The vector's buffer is the most recent allocation and is grown in place
+    CHECK(g_arena.used() <= 100 * sizeof(int) + particle::ArenaAllocator::ALIGNMENT);
+    CHECK(v.at(99) == 99);
+}
@@ -148,4 +148,13 @@ test(api_cellular_registration_timeout_set) {
     API_COMPILE(cellular_registration_timeout_set(60 * 60 * 1000, nullptr)); // 60 minutes
 }
 
+test(api_cellular_power_saving) {
+    API_COMPILE({ int r = Cellular.setPowerSaving(10s, 4h); (void)r; });
+    API_COMPILE({ int r = Cellular.setPowerSaving(10s, 4h, 20480ms); (void)r; });
+    API_COMPILE({ int r = Cellular.disablePowerSaving(); (void)r; });
+    cellular_power_saving_config conf = {};
+    conf.size = sizeof(conf);
+    API_COMPILE(cellular_power_saving_get(&conf, nullptr));
+}
+
 #endif
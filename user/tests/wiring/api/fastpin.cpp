@@ -12,3 +12,19 @@ test(api_fastpin) {
     (void)value++;
 }
 
+#if defined(STM32F2XX) || HAL_PLATFORM_NRF52840
+test(api_fastpin_port) {
+
+    uint32_t value = 0;
+    pin_port_t port;
+    uint32_t mask = 0;
+    API_COMPILE(port = pinPortFast(D0));
+    API_COMPILE(mask = pinMaskFast(D0) | pinMaskFast(D1));
+    API_COMPILE(portSetFast(port, mask));
+    API_COMPILE(portResetFast(port, mask));
+    API_COMPILE(portWriteFast(port, mask, value));
+    API_COMPILE(value = portReadFast(port, mask));
+    (void)value++;
+}
+#endif
+
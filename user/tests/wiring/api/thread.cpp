@@ -22,6 +22,20 @@ test(api_thread) {
     API_COMPILE(t.is_valid()); // Deprecated
     API_COMPILE(t.is_current()); // Deprecated
     API_COMPILE(t = Thread("test", thread_fn));
+    API_COMPILE({ size_t n = t.stackSize(); (void)n; });
+    API_COMPILE({ int n = t.stackFree(); (void)n; });
+}
+
+test(api_thread_stack_pool) {
+    particle::ThreadStackPool pool(1024);
+    particle::ThreadStackPool pool2(1024, 4, OS_THREAD_PRIORITY_DEFAULT + 1);
+    int x = 0;
+    API_COMPILE(Thread("test", [&]() { x++; }, pool));
+    API_COMPILE({ int n = pool.stackFree(); (void)n; });
+    API_COMPILE({ unsigned n = pool.threadCount(); (void)n; });
+    API_COMPILE({ unsigned n = pool.idleCount(); (void)n; });
+    API_COMPILE({ size_t n = particle::recommendedStackSize(1024, 256); (void)n; });
+    API_COMPILE({ int n = particle::threadStackFree(os_thread_current(nullptr)); (void)n; });
 }
 
 test(api_single_threaded_section) {
@@ -40,5 +54,24 @@ test(api_application_watchdog)
 	ApplicationWatchdog wd2(30000, System.reset, stack_size);
 }
 
+test(api_service_timer) {
+    int x = 0;
+    particle::TimerService service(OS_THREAD_PRIORITY_DEFAULT + 1, 2048);
+    particle::ServiceTimer t1(100, [&]() { x++; });
+    particle::ServiceTimer t2(100, [&]() { x++; }, true, particle::TimerDispatch::APPLICATION_THREAD, &service);
+    API_COMPILE(t1.start());
+    API_COMPILE(t1.stop());
+    API_COMPILE(t1.reset());
+    API_COMPILE(t1.changePeriod(200));
+    API_COMPILE(t1.changePeriod(std::chrono::milliseconds(200)));
+    API_COMPILE(t1.isActive());
+    API_COMPILE(t1.dispose());
+    API_COMPILE(service.setLateThreshold(5));
+    API_COMPILE(service.lateThreshold());
+    API_COMPILE(service.resetStats());
+    particle::TimerService::Stats stats = {};
+    API_COMPILE(stats = particle::TimerService::instance()->stats());
+    (void)stats;
+}
 
 #endif
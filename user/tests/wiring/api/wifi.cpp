@@ -132,6 +132,25 @@ test(api_wifi_scan_callback)
     (void)result_count;
 }
 
+int wifi_scan_stream_callback(WiFiAccessPoint* wap, void* data)
+{
+    int* count = (int*)data;
+    // Stop after the first 5 access points
+    return (++*count == 5) ? 1 : 0;
+}
+
+int wifi_scan_stream_handler(WiFiAccessPoint* wap, int* count)
+{
+    return (++*count == 5) ? 1 : 0;
+}
+
+test(api_wifi_scan_stream)
+{
+    int count = 0;
+    API_COMPILE(WiFi.scan(wifi_scan_stream_callback, &count));
+    API_COMPILE(WiFi.scan(wifi_scan_stream_handler, &count));
+}
+
 class FindStrongestSSID
 {
     char strongest_ssid[33];
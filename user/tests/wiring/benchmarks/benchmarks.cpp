@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "application.h"
+#include "unit-test/unit-test.h"
+
+namespace {
+
+const unsigned ITERATIONS = 1000;
+
+const pin_t IRQ_OUTPUT_PIN = D2;
+const pin_t IRQ_INPUT_PIN = D3;
+
+class Samples {
+public:
+    Samples() :
+            min_(UINT32_MAX),
+            max_(0),
+            sum_(0),
+            count_(0) {
+    }
+
+    void add(uint32_t value) {
+        if (value < min_) {
+            min_ = value;
+        }
+        if (value > max_) {
+            max_ = value;
+        }
+        sum_ += value;
+        ++count_;
+    }
+
+    uint32_t min() const {
+        return count_ ? min_ : 0;
+    }
+
+    uint32_t max() const {
+        return max_;
+    }
+
+    uint32_t avg() const {
+        return count_ ? sum_ / count_ : 0;
+    }
+
+    unsigned count() const {
+        return count_;
+    }
+
+private:
+    uint32_t min_;
+    uint32_t max_;
+    uint64_t sum_;
+    unsigned count_;
+};
+
+uint32_t ticksToNs(uint32_t ticks) {
+    return (uint64_t)ticks * 1000 / System.ticksPerMicrosecond();
+}
+
+void report(const char* name, const char* unit, const Samples& s) {
+    Serial.printlnf("{\"bench\":\"%s\",\"unit\":\"%s\",\"samples\":%u,\"min\":%lu,\"avg\":%lu,\"max\":%lu,"
+            "\"platform\":%d,\"version\":\"%s\"}", name, unit, s.count(), (unsigned long)s.min(),
+            (unsigned long)s.avg(), (unsigned long)s.max(), PLATFORM_ID, System.version().c_str());
+}
+
+// Reports durations measured in ticks in nanoseconds
+void reportTicks(const char* name, const Samples& ticks, uint32_t overhead = 0) {
+    const auto ns = [overhead](uint32_t t) {
+        return (unsigned long)ticksToNs(t > overhead ? t - overhead : 0);
+    };
+    Serial.printlnf("{\"bench\":\"%s\",\"unit\":\"ns\",\"samples\":%u,\"min\":%lu,\"avg\":%lu,\"max\":%lu,"
+            "\"platform\":%d,\"version\":\"%s\"}", name, ticks.count(), ns(ticks.min()), ns(ticks.avg()),
+            ns(ticks.max()), PLATFORM_ID, System.version().c_str());
+}
+
+// Cost of reading the cycle counter twice, subtracted from the measurements
+uint32_t measureOverhead() {
+    uint32_t overhead = UINT32_MAX;
+    for (unsigned i = 0; i < 100; ++i) {
+        const uint32_t t = System.ticks();
+        const uint32_t d = System.ticks() - t;
+        if (d < overhead) {
+            overhead = d;
+        }
+    }
+    return overhead;
+}
+
+volatile uint32_t g_irqTicks = 0;
+
+void irqHandler() {
+    g_irqTicks = System.ticks();
+}
+
+#if PLATFORM_THREADING
+
+struct PingPong {
+    os_semaphore_t ping;
+    os_semaphore_t pong;
+    volatile bool done;
+};
+
+void pongThread(void* arg) {
+    auto p = static_cast<PingPong*>(arg);
+    while (!p->done) {
+        if (os_semaphore_take(p->ping, 100, false) == 0) {
+            os_semaphore_give(p->pong, false);
+        }
+    }
+    os_thread_exit(nullptr);
+}
+
+#endif // PLATFORM_THREADING
+
+} // namespace
+
+test(BENCHMARK_01_gpio_interrupt_latency) {
+    pinMode(IRQ_OUTPUT_PIN, OUTPUT);
+    pinMode(IRQ_INPUT_PIN, INPUT_PULLDOWN);
+    digitalWrite(IRQ_OUTPUT_PIN, HIGH);
+    delay(1);
+    const bool high = digitalRead(IRQ_INPUT_PIN) == HIGH;
+    digitalWrite(IRQ_OUTPUT_PIN, LOW);
+    delay(1);
+    const bool low = digitalRead(IRQ_INPUT_PIN) == LOW;
+    if (!high || !low) {
+        Serial.printlnf("D%d is not connected to D%d", (int)IRQ_OUTPUT_PIN, (int)IRQ_INPUT_PIN);
+        pinMode(IRQ_OUTPUT_PIN, INPUT);
+        pinMode(IRQ_INPUT_PIN, INPUT);
+        skip();
+        return;
+    }
+
+    assertTrue(attachInterrupt(IRQ_INPUT_PIN, irqHandler, RISING));
+    const uint32_t overhead = measureOverhead();
+    Samples ticks;
+    for (unsigned i = 0; i < ITERATIONS; ++i) {
+        g_irqTicks = 0;
+        const uint32_t t = System.ticks();
+        pinSetFast(IRQ_OUTPUT_PIN);
+        const uint32_t start = millis();
+        while (!g_irqTicks && millis() - start < 10) {
+        }
+        pinResetFast(IRQ_OUTPUT_PIN);
+        if (g_irqTicks) {
+            ticks.add(g_irqTicks - t);
+        }
+        delayMicroseconds(50);
+    }
+    detachInterrupt(IRQ_INPUT_PIN);
+    pinMode(IRQ_OUTPUT_PIN, INPUT);
+    pinMode(IRQ_INPUT_PIN, INPUT);
+
+    assertEqual(ticks.count(), ITERATIONS);
+    reportTicks("gpio_irq_latency", ticks, overhead);
+}
+
+test(BENCHMARK_02_atomic_block) {
+    const uint32_t overhead = measureOverhead();
+    Samples ticks;
+    for (unsigned i = 0; i < ITERATIONS; ++i) {
+        const uint32_t t = System.ticks();
+        ATOMIC_BLOCK() {
+        }
+        ticks.add(System.ticks() - t);
+    }
+    reportTicks("atomic_block", ticks, overhead);
+}
+
+test(BENCHMARK_03_thread_yield) {
+    const uint32_t overhead = measureOverhead();
+    Samples ticks;
+    for (unsigned i = 0; i < ITERATIONS; ++i) {
+        const uint32_t t = System.ticks();
+        os_thread_yield();
+        ticks.add(System.ticks() - t);
+    }
+    reportTicks("thread_yield", ticks, overhead);
+}
+
+#if PLATFORM_THREADING
+
+test(BENCHMARK_04_context_switch) {
+    PingPong p = {};
+    assertEqual(os_semaphore_create(&p.ping, 1, 0), 0);
+    assertEqual(os_semaphore_create(&p.pong, 1, 0), 0);
+    os_thread_t thread = nullptr;
+    // Same priority as the application thread
+    assertEqual(os_thread_create(&thread, "bench", OS_THREAD_PRIORITY_DEFAULT, pongThread, &p, 1024), 0);
+
+    Samples ticks;
+    for (unsigned i = 0; i < ITERATIONS; ++i) {
+        const uint32_t t = System.ticks();
+        os_semaphore_give(p.ping, false);
+        if (os_semaphore_take(p.pong, 100, false) != 0) {
+            break;
+        }
+        // A round trip involves two context switches
+        ticks.add((System.ticks() - t) / 2);
+    }
+    p.done = true;
+    os_thread_join(thread);
+    os_thread_cleanup(thread);
+    os_semaphore_destroy(p.ping);
+    os_semaphore_destroy(p.pong);
+
+    assertEqual(ticks.count(), ITERATIONS);
+    reportTicks("context_switch", ticks);
+}
+
+test(BENCHMARK_05_mutex_lock_unlock) {
+    os_mutex_t mutex = nullptr;
+    assertEqual(os_mutex_create(&mutex), 0);
+    const uint32_t overhead = measureOverhead();
+    Samples ticks;
+    for (unsigned i = 0; i < ITERATIONS; ++i) {
+        const uint32_t t = System.ticks();
+        os_mutex_lock(mutex);
+        os_mutex_unlock(mutex);
+        ticks.add(System.ticks() - t);
+    }
+    os_mutex_destroy(mutex);
+    reportTicks("mutex_lock_unlock", ticks, overhead);
+}
+
+test(BENCHMARK_06_queue_put_take) {
+    const size_t QUEUE_SIZE = 16;
+    os_queue_t queue = nullptr;
+    assertEqual(os_queue_create(&queue, sizeof(uint32_t), QUEUE_SIZE, nullptr), 0);
+    const uint32_t overhead = measureOverhead();
+    Samples ticks;
+    for (unsigned i = 0; i < ITERATIONS / QUEUE_SIZE; ++i) {
+        // Time per item, for a queue that is filled and then drained
+        const uint32_t t = System.ticks();
+        for (uint32_t j = 0; j < QUEUE_SIZE; ++j) {
+            os_queue_put(queue, &j, 0, nullptr);
+        }
+        for (uint32_t j = 0; j < QUEUE_SIZE; ++j) {
+            uint32_t item = 0;
+            os_queue_take(queue, &item, 0, nullptr);
+        }
+        ticks.add((System.ticks() - t - overhead) / QUEUE_SIZE);
+    }
+    os_queue_destroy(queue, nullptr);
+    reportTicks("queue_put_take", ticks);
+}
+
+#endif // PLATFORM_THREADING
+
+test(BENCHMARK_07_stop_sleep_wakeup_latency) {
+    const system_tick_t SLEEP_DURATION = 100;
+    Samples ms;
+    for (unsigned i = 0; i < 5; ++i) {
+        SystemSleepConfiguration config;
+        config.mode(SystemSleepMode::STOP)
+              .duration(SLEEP_DURATION);
+        const system_tick_t t = millis();
+        const SystemSleepResult result = System.sleep(config);
+        const system_tick_t d = millis() - t;
+        assertEqual(result.error(), SYSTEM_ERROR_NONE);
+        // Time in excess of the requested sleep duration
+        ms.add(d > SLEEP_DURATION ? d - SLEEP_DURATION : 0);
+    }
+    // Give the host some time to reconnect to the USB serial
+    delay(3000);
+    report("stop_sleep_wakeup_latency", "ms", ms);
+}
@@ -148,6 +148,56 @@ test(CAN_06_D1_D2_DoesntReceiveFilteredExtendedMessage) {
     assertEqual(hasMessage, false);
 }
 
+test(CAN_13_D1_D2_ReceivesListedMessagesOnly) {
+    CANChannel can(CAN_D1_D2);
+    can.begin(500000, CAN_TEST_MODE);
+    // Accept only standard messages 0x100 and 0x200
+    can.addFilterList(0x100, 0x200);
+
+    const uint32_t ids[] = { 0x100, 0x101, 0x200 };
+    for (uint32_t id: ids) {
+        CANMessage tx;
+        tx.id = id;
+        tx.len = 1;
+        tx.data[0] = 10;
+        can.transmit(tx);
+    }
+    delay(1);
+    CANMessage rx1, rx2, rx3;
+    bool hasMessage1 = can.receive(rx1);
+    bool hasMessage2 = can.receive(rx2);
+    bool hasMessage3 = can.receive(rx3);
+    can.end();
+
+    assertEqual(hasMessage1, true);
+    assertEqual(rx1.id, 0x100);
+    assertEqual(hasMessage2, true);
+    assertEqual(rx2.id, 0x200);
+    assertEqual(hasMessage3, false);
+}
+
+test(CAN_14_D1_D2_ReceivesStandardAndExtendedMessagesFromBothFifos) {
+    CANChannel can(CAN_D1_D2);
+    can.begin(500000, CAN_TEST_MODE);
+    uint32_t overflows = can.rxQueueOverflows();
+
+    // Standard messages go to FIFO 0 and extended messages to FIFO 1
+    for (int i = 0; i < 4; i++) {
+        CANMessage tx;
+        tx.extended = (i % 2) != 0;
+        tx.id = 0x100 + i;
+        tx.len = 1;
+        tx.data[0] = i;
+        can.transmit(tx);
+    }
+    delay(2);
+    uint8_t count = can.available();
+    can.end();
+
+    assertEqual(count, 4);
+    assertEqual(can.rxQueueOverflows(), overflows);
+}
+
 #endif // HAL_HAS_CAN_D1_D2
 
 #ifdef HAL_HAS_CAN_C4_C5
@@ -112,6 +112,42 @@ inline int32_t pinReadFast(pin_t _pin)
 {
     return ((PIN_MAP[_pin].gpio_peripheral->IDR & PIN_MAP[_pin].gpio_pin) == 0 ? LOW : HIGH);
 }
+
+/* Port-wide access. A pin is resolved once to its port and bit mask with pinPortFast() and
+ * pinMaskFast(), masks of pins on the same port can be OR'ed together, and the port functions
+ * then update or read all the pins at once */
+typedef GPIO_TypeDef* pin_port_t;
+
+inline pin_port_t pinPortFast(pin_t _pin)
+{
+    return PIN_MAP[_pin].gpio_peripheral;
+}
+
+inline uint32_t pinMaskFast(pin_t _pin)
+{
+    return PIN_MAP[_pin].gpio_pin;
+}
+
+inline void portSetFast(pin_port_t port, uint32_t mask)
+{
+    port->BSRR = mask;
+}
+
+inline void portResetFast(pin_port_t port, uint32_t mask)
+{
+    port->BRR = mask;
+}
+
+/* Sets the pins in mask to the corresponding bits of value with a single register write */
+inline void portWriteFast(pin_port_t port, uint32_t mask, uint32_t value)
+{
+    port->BSRR = (value & mask) | ((~value & mask) << 16);
+}
+
+inline uint32_t portReadFast(pin_port_t port, uint32_t mask)
+{
+    return port->IDR & mask;
+}
 #elif defined(STM32F2XX)
 static Hal_Pin_Info* PIN_MAP = HAL_Pin_Map();
 
@@ -133,6 +169,43 @@ inline int32_t pinReadFast(pin_t _pin)
 {
 	return ((PIN_MAP[_pin].gpio_peripheral->IDR & PIN_MAP[_pin].gpio_pin) == 0 ? LOW : HIGH);
 }
+
+/* Port-wide access. A pin is resolved once to its port and bit mask with pinPortFast() and
+ * pinMaskFast(), masks of pins on the same port can be OR'ed together, and the port functions
+ * then update or read all the pins at once */
+typedef GPIO_TypeDef* pin_port_t;
+
+inline pin_port_t pinPortFast(pin_t _pin)
+{
+    return PIN_MAP[_pin].gpio_peripheral;
+}
+
+inline uint32_t pinMaskFast(pin_t _pin)
+{
+    return PIN_MAP[_pin].gpio_pin;
+}
+
+inline void portSetFast(pin_port_t port, uint32_t mask)
+{
+    port->BSRRL = mask;
+}
+
+inline void portResetFast(pin_port_t port, uint32_t mask)
+{
+    port->BSRRH = mask;
+}
+
+/* Sets the pins in mask to the corresponding bits of value with a single register write.
+ * BSRRL and BSRRH are the two halves of the 32-bit BSRR register */
+inline void portWriteFast(pin_port_t port, uint32_t mask, uint32_t value)
+{
+    *(__IO uint32_t*)&port->BSRRL = (value & mask) | ((~value & mask) << 16);
+}
+
+inline uint32_t portReadFast(pin_port_t port, uint32_t mask)
+{
+    return port->IDR & mask;
+}
 #elif HAL_PLATFORM_NRF52840
 
 #include "nrf_gpio.h"
@@ -164,6 +237,46 @@ inline int32_t pinReadFast(pin_t _pin)
     return nrf_gpio_pin_read(nrf_pin);
 }
 
+/* Port-wide access. A pin is resolved once to its port and bit mask with pinPortFast() and
+ * pinMaskFast(), masks of pins on the same port can be OR'ed together, and the port functions
+ * then update or read all the pins at once */
+typedef NRF_GPIO_Type* pin_port_t;
+
+inline pin_port_t pinPortFast(pin_t _pin)
+{
+    return (PIN_MAP[_pin].gpio_port == NRF_PORT_1) ? NRF_P1 : NRF_P0;
+}
+
+inline uint32_t pinMaskFast(pin_t _pin)
+{
+    return 1ul << PIN_MAP[_pin].gpio_pin;
+}
+
+inline void portSetFast(pin_port_t port, uint32_t mask)
+{
+    port->OUTSET = mask;
+}
+
+inline void portResetFast(pin_port_t port, uint32_t mask)
+{
+    port->OUTCLR = mask;
+}
+
+/* Sets the pins in mask to the corresponding bits of value. Unlike on STM32, the port has
+ * separate set and clear registers, so the pins that go high change first */
+inline void portWriteFast(pin_port_t port, uint32_t mask, uint32_t value)
+{
+    port->OUTSET = value & mask;
+    port->OUTCLR = ~value & mask;
+}
+
+inline uint32_t portReadFast(pin_port_t port, uint32_t mask)
+{
+    // Dummy read, see pinReadFast()
+    (void)port->IN;
+    return port->IN & mask;
+}
+
 #elif PLATFORM_ID==3 || PLATFORM_ID == 20
 
 // make them unresolved symbols so attempted use will result in a linker error
@@ -194,5 +307,77 @@ inline void digitalWriteFast(pin_t pin, uint8_t value)
 }
 #endif
 
+#if defined(__cplusplus) && HAL_PLATFORM_NRF52840 && defined(PLATFORM_NRF_PIN_MAP) && !USE_BIT_BAND
+
+namespace particle {
+
+namespace detail {
+
+constexpr uint8_t NRF_PIN_MAP[] = { PLATFORM_NRF_PIN_MAP };
+static_assert(sizeof(NRF_PIN_MAP) == TOTAL_PINS, "PLATFORM_NRF_PIN_MAP doesn't match the pin map");
+
+} // namespace detail
+
+/**
+ * Fast access to a pin that is known at compile time.
+ *
+ * The port register and bit mask of the pin are resolved by the compiler, so each operation
+ * compiles to a single register access. Example:
+ *
+ * ```
+ * pinMode(D7, OUTPUT);
+ * FastPin<D7>::write(HIGH);
+ * ```
+ *
+ * Like `pinSetFast()`, this doesn't validate the pin mode. The pin needs to be configured with
+ * `pinMode()` first, and it's not switched from PWM to GPIO.
+ */
+template<pin_t pin>
+class FastPin {
+public:
+    static_assert(pin < TOTAL_PINS, "Invalid pin");
+
+    static constexpr uint32_t NRF_PIN = detail::NRF_PIN_MAP[pin];
+    static constexpr uint32_t MASK = 1ul << (NRF_PIN & 0x1f);
+
+    static pin_port_t port() __attribute__((always_inline)) {
+        return (NRF_PIN >> 5) ? NRF_P1 : NRF_P0;
+    }
+
+    static void set() __attribute__((always_inline)) {
+        port()->OUTSET = MASK;
+    }
+
+    static void reset() __attribute__((always_inline)) {
+        port()->OUTCLR = MASK;
+    }
+
+    static void write(uint8_t value) __attribute__((always_inline)) {
+        if (value) {
+            set();
+        } else {
+            reset();
+        }
+    }
+
+    static void toggle() __attribute__((always_inline)) {
+        if (port()->OUT & MASK) {
+            reset();
+        } else {
+            set();
+        }
+    }
+
+    static int32_t read() __attribute__((always_inline)) {
+        // Dummy read, see pinReadFast()
+        (void)port()->IN;
+        return (port()->IN & MASK) != 0;
+    }
+};
+
+} // namespace particle
+
+#endif // defined(__cplusplus) && HAL_PLATFORM_NRF52840 && defined(PLATFORM_NRF_PIN_MAP) && !USE_BIT_BAND
+
 #endif	/* FAST_PIN_H */
 
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "spark_wiring_fixed_point.h"
+
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+namespace particle {
+
+namespace detail {
+
+template<typename T>
+inline size_t encodeLittleEndian(uint8_t* buf, T val) {
+    typedef typename std::make_unsigned<T>::type U;
+    const U v = static_cast<U>(val);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        buf[i] = (v >> (i * 8)) & 0xff;
+    }
+    return sizeof(T);
+}
+
+} // particle::detail
+
+/**
+ * Base class for the accumulators collected by an `Aggregator`.
+ */
+class AccumulatorBase {
+public:
+    virtual ~AccumulatorBase() = default;
+
+    /**
+     * Returns the number of samples added since the last reset.
+     */
+    virtual size_t count() const = 0;
+
+    /**
+     * Discards all samples.
+     */
+    virtual void reset() = 0;
+
+    /**
+     * Returns the size of the encoded statistics.
+     */
+    virtual size_t encodedSize() const = 0;
+
+    /**
+     * Encodes the statistics.
+     *
+     * @param buf Destination buffer.
+     * @param size Buffer size.
+     * @return Number of bytes written, or 0 if the buffer is too small.
+     */
+    virtual size_t encode(uint8_t* buf, size_t size) const = 0;
+};
+
+/**
+ * Fixed-memory accumulator of the minimum, maximum, mean, count and last value of a signal.
+ *
+ * The samples are fixed point numbers of type `T` (see `FixedPointQ`). Optionally, the accumulator
+ * keeps a histogram of `BUCKETS` equal-width buckets covering the range set in the constructor.
+ * Samples outside of the range are counted in the first or last bucket.
+ *
+ * Encoded statistics (all fields are little-endian):
+ *
+ * | Size           | Field                                         |
+ * |----------------|-----------------------------------------------|
+ * | 1              | Storage size of a value, in bytes             |
+ * | 1              | Number of fraction bits                       |
+ * | 1              | Number of histogram buckets                   |
+ * | 4              | Number of samples                             |
+ * | 4 * value size | Minimum, maximum, mean and last value         |
+ * | 2 * buckets    | Sample counts of the histogram buckets        |
+ *
+ * The accumulator isn't thread-safe.
+ */
+template<typename T, size_t BUCKETS = 0>
+class Accumulator: public AccumulatorBase {
+public:
+    typedef typename T::StorageT StorageT;
+
+    static_assert(BUCKETS <= 255, "Too many histogram buckets");
+
+    static const size_t ENCODED_SIZE = 7 + 4 * sizeof(StorageT) + 2 * BUCKETS;
+
+    /**
+     * Constructs an accumulator.
+     *
+     * @param low Lower bound of the histogram range.
+     * @param high Upper bound of the histogram range.
+     */
+    explicit Accumulator(T low = T(StorageT(0)), T high = T(StorageT(0))) :
+            low_(low.value()),
+            high_(high.value()) {
+        reset();
+    }
+
+    /**
+     * Adds a sample.
+     */
+    void add(T value) {
+        const StorageT v = value.value();
+        if (!count_ || v < min_) {
+            min_ = v;
+        }
+        if (!count_ || v > max_) {
+            max_ = v;
+        }
+        last_ = v;
+        sum_ += v;
+        if (count_ < std::numeric_limits<uint32_t>::max()) {
+            ++count_;
+        }
+        if (BUCKETS) {
+            auto& b = buckets_[bucketIndex(v)];
+            if (b < std::numeric_limits<uint16_t>::max()) {
+                ++b;
+            }
+        }
+    }
+
+    T min() const {
+        return T(min_);
+    }
+
+    T max() const {
+        return T(max_);
+    }
+
+    T last() const {
+        return T(last_);
+    }
+
+    T mean() const {
+        return T(count_ ? StorageT(sum_ / (int64_t)count_) : StorageT(0));
+    }
+
+    /**
+     * Returns the number of samples counted in a histogram bucket.
+     */
+    uint16_t bucket(size_t index) const {
+        return (index < BUCKETS) ? buckets_[index] : 0;
+    }
+
+    size_t count() const override {
+        return count_;
+    }
+
+    void reset() override {
+        count_ = 0;
+        sum_ = 0;
+        min_ = 0;
+        max_ = 0;
+        last_ = 0;
+        for (auto& b: buckets_) {
+            b = 0;
+        }
+    }
+
+    size_t encodedSize() const override {
+        return ENCODED_SIZE;
+    }
+
+    size_t encode(uint8_t* buf, size_t size) const override {
+        if (size < ENCODED_SIZE) {
+            return 0;
+        }
+        size_t n = 0;
+        buf[n++] = sizeof(StorageT);
+        buf[n++] = T::FRACTION_BITS;
+        buf[n++] = BUCKETS;
+        n += detail::encodeLittleEndian(buf + n, count_);
+        n += detail::encodeLittleEndian(buf + n, min_);
+        n += detail::encodeLittleEndian(buf + n, max_);
+        n += detail::encodeLittleEndian(buf + n, mean().value());
+        n += detail::encodeLittleEndian(buf + n, last_);
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            n += detail::encodeLittleEndian(buf + n, buckets_[i]);
+        }
+        return n;
+    }
+
+private:
+    int64_t sum_;
+    uint32_t count_;
+    StorageT min_;
+    StorageT max_;
+    StorageT last_;
+    StorageT low_;
+    StorageT high_;
+    uint16_t buckets_[BUCKETS ? BUCKETS : 1];
+
+    size_t bucketIndex(StorageT v) const {
+        if (v <= low_) {
+            return 0;
+        }
+        if (v >= high_) {
+            return BUCKETS - 1;
+        }
+        return (size_t)(((int64_t)v - low_) * BUCKETS / ((int64_t)high_ - low_));
+    }
+};
+
+template<typename T, size_t BUCKETS>
+const size_t Accumulator<T, BUCKETS>::ENCODED_SIZE;
+
+} // particle
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "spark_wiring_accumulator.h"
+#include "spark_wiring_cloud.h"
+#include "system_tick_hal.h"
+
+namespace particle {
+
+/**
+ * Aggregates samples over tumbling windows and publishes the statistics as binary events.
+ *
+ * The statistics of all accumulators that received samples during a window are encoded in a single
+ * event with the `ContentType::BINARY` content type. The event data starts with a header, followed
+ * by an entry for every accumulator:
+ *
+ * | Size | Field                                                              |
+ * |------|--------------------------------------------------------------------|
+ * | 1    | Format version (1)                                                 |
+ * | 4    | End of the window, as Unix time, or 0 if the time isn't valid      |
+ * | 4    | Window duration, in milliseconds                                   |
+ * | 1    | Number of entries                                                  |
+ * | 1    | Entry: index of the accumulator in the order it was added          |
+ * | ...  | Entry: encoded statistics of the accumulator (see `Accumulator`)   |
+ *
+ * `process()` needs to be called periodically, typically from `loop()`. The aggregator and its
+ * accumulators aren't thread-safe and should be used from a single thread.
+ */
+class Aggregator {
+public:
+    static const size_t MAX_ACCUMULATORS = 8;
+    static const uint8_t FORMAT_VERSION = 1;
+
+    /**
+     * Constructs an aggregator.
+     *
+     * @param eventName Event name. The string is not copied.
+     * @param window Window duration in milliseconds.
+     * @param flags Publish flags.
+     */
+    Aggregator(const char* eventName, system_tick_t window, PublishFlags flags = PRIVATE);
+
+    Aggregator(const Aggregator&) = delete;
+    Aggregator& operator=(const Aggregator&) = delete;
+
+    /**
+     * Adds an accumulator. The accumulator must outlive the aggregator.
+     *
+     * @return Index of the accumulator, or a negative result code in case of an error.
+     */
+    int add(AccumulatorBase* acc);
+
+    /**
+     * Sets the window duration.
+     *
+     * The current window is closed after the new duration since its start.
+     */
+    void window(system_tick_t ms);
+
+    system_tick_t window() const {
+        return window_;
+    }
+
+    /**
+     * Closes the current window if its duration has elapsed.
+     *
+     * @return 1 if the statistics were published, 0 if the window is still open or there were no
+     *         samples, or a negative result code in case of an error.
+     */
+    int process();
+
+    /**
+     * Closes the current window and publishes the collected statistics.
+     *
+     * The accumulators are reset even if the event couldn't be published.
+     *
+     * @return 1 if the statistics were published, 0 if there were no samples, or a negative result
+     *         code in case of an error.
+     */
+    int flush();
+
+    /**
+     * Encodes the statistics of the current window.
+     *
+     * @param buf Destination buffer.
+     * @param size Buffer size.
+     * @param windowEnd End of the window, as Unix time.
+     * @param windowDuration Window duration in milliseconds.
+     * @return Number of bytes written, 0 if there were no samples, or a negative result code in
+     *         case of an error.
+     */
+    int encode(uint8_t* buf, size_t size, uint32_t windowEnd, system_tick_t windowDuration) const;
+
+private:
+    AccumulatorBase* accs_[MAX_ACCUMULATORS];
+    const char* eventName_;
+    size_t accCount_;
+    system_tick_t window_;
+    system_tick_t windowStart_;
+    PublishFlags flags_;
+
+    void resetAll();
+};
+
+} // particle
@@ -148,6 +148,7 @@ typedef void (*BleOnDataReceivedCallback)(const uint8_t* data, size_t len, const
 typedef void (*BleOnScanResultCallback)(const BleScanResult* device, void* context);
 typedef void (*BleOnConnectedCallback)(const BlePeerDevice& peer, void* context);
 typedef void (*BleOnDisconnectedCallback)(const BlePeerDevice& peer, void* context);
+typedef void (*BleOnNotificationsSentCallback)(size_t count, const BlePeerDevice& peer, void* context);
 
 class BleAdvertisingParams : public hal_ble_adv_params_t {
 };
@@ -161,6 +162,19 @@ class BleScanParams : public hal_ble_scan_params_t {
 };
 static_assert(std::is_pod<BleScanParams>::value, "BleScanParams is not a POD struct");
 
+class BleNotifyValue : public hal_ble_notify_value_t {
+public:
+    BleNotifyValue() {
+        data = nullptr;
+        len = 0;
+    }
+
+    BleNotifyValue(const uint8_t* buf, size_t size) {
+        data = buf;
+        len = size;
+    }
+};
+
 class BleCharacteristicHandles : public hal_ble_char_handles_t {
 public:
     BleCharacteristicHandles& operator=(const hal_ble_char_handles_t& halHandles) {
@@ -400,6 +414,11 @@ public:
         return setValue(reinterpret_cast<const uint8_t*>(&val), sizeof(T), type);
     }
 
+    // Valid for local characteristic only. Queue several values for notification without waiting for them
+    // to be sent. Returns the number of values queued; the remaining values can be retried once the
+    // callback set via BleLocalDevice::onNotificationsSent() is invoked.
+    ssize_t notifyValues(const BleNotifyValue* values, size_t count) const;
+
     // Valid for peer characteristic only. Manually enable the characteristic notification or indication.
     int subscribe(bool enable) const;
 
@@ -483,6 +502,10 @@ public:
 
     int disconnect() const;
 
+    // Requests the throughput the peer Peripheral device needs, in bytes per second, so that the
+    // radio time is shared fairly among the connected Peripherals. 0 clears the request.
+    int setThroughput(size_t bytesPerSecond) const;
+
     bool connected() const;
 
     void bind(const BleAddress& address) const;
@@ -590,6 +613,8 @@ public:
     bool connected() const;
     void onConnected(BleOnConnectedCallback callback, void* context) const;
     void onDisconnected(BleOnDisconnectedCallback callback, void* context) const;
+    // Invoked when queued notifications have been sent and more values can be queued.
+    void onNotificationsSent(BleOnNotificationsSentCallback callback, void* context) const;
 
     static BleLocalDevice& getInstance();
 
@@ -48,8 +48,16 @@ public:
   bool transmit(const CANMessage &message);
 
   bool addFilter(uint32_t id, uint32_t mask, HAL_CAN_Filters type = CAN_FILTER_STANDARD);
+  bool addFilter(const HAL_CAN_Filter &filter);
+  // Accept exactly two IDs using a single hardware filter bank
+  bool addFilterList(uint32_t id, uint32_t id2, HAL_CAN_Filters type = CAN_FILTER_STANDARD);
   void clearFilters();
 
+  // Messages dropped because the receive queue was full
+  uint32_t rxQueueOverflows();
+  // Times a hardware receive FIFO overflowed before the messages could be read
+  uint32_t rxFifoOverruns();
+
   bool isEnabled();
 
   HAL_CAN_Errors errorStatus();
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPARK_WIRING_CBOR_H
+#define SPARK_WIRING_CBOR_H
+
+#include "spark_wiring_print.h"
+#include "spark_wiring_string.h"
+
+#include <cstring>
+#include <cstdint>
+
+namespace spark {
+
+enum CBORType {
+    CBOR_TYPE_INVALID,
+    CBOR_TYPE_NULL, // Null or undefined value
+    CBOR_TYPE_BOOL,
+    CBOR_TYPE_INT,
+    CBOR_TYPE_FLOAT,
+    CBOR_TYPE_STRING,
+    CBOR_TYPE_BYTES,
+    CBOR_TYPE_ARRAY,
+    CBOR_TYPE_OBJECT,
+    CBOR_TYPE_END // End of an array or object
+};
+
+// Abstract CBOR (RFC 7049) document writer. The writer has the same interface as JSONWriter:
+// arrays and objects are encoded as indefinite-length items, so their size doesn't need to be
+// known in advance. Floating point values are encoded in single precision if that doesn't lose
+// precision
+class CBORWriter {
+public:
+    virtual ~CBORWriter() = default;
+
+    CBORWriter& beginArray();
+    CBORWriter& endArray();
+    CBORWriter& beginObject();
+    CBORWriter& endObject();
+    CBORWriter& name(const char *name);
+    CBORWriter& name(const char *name, size_t size);
+    CBORWriter& name(const String &name);
+    CBORWriter& value(bool val);
+    CBORWriter& value(int val);
+    CBORWriter& value(unsigned val);
+    CBORWriter& value(long long val);
+    CBORWriter& value(unsigned long long val);
+    CBORWriter& value(float val);
+    CBORWriter& value(double val);
+    CBORWriter& value(const char *val);
+    CBORWriter& value(const char *val, size_t size);
+    CBORWriter& value(const String &val);
+    CBORWriter& bytesValue(const void *data, size_t size);
+    CBORWriter& nullValue();
+
+protected:
+    virtual void write(const char *data, size_t size) = 0;
+
+private:
+    void writeHead(uint8_t type, uint64_t val);
+    void write(uint8_t b);
+};
+
+class CBORStreamWriter: public CBORWriter {
+public:
+    explicit CBORStreamWriter(Print &stream);
+
+    Print* stream() const;
+
+protected:
+    virtual void write(const char *data, size_t size) override;
+
+private:
+    Print &strm_;
+};
+
+class CBORBufferWriter: public CBORWriter {
+public:
+    CBORBufferWriter(char *buf, size_t size);
+
+    char* buffer() const;
+    size_t bufferSize() const;
+
+    size_t dataSize() const; // Returned value can be greater than buffer size
+
+protected:
+    virtual void write(const char *data, size_t size) override;
+
+private:
+    char *buf_;
+    size_t bufSize_, n_;
+};
+
+// Pull parser for CBOR documents. The reader doesn't allocate memory: strings are returned as
+// pointers to the original data and are not null-terminated. The end of every array and object,
+// whether of definite or indefinite length, is reported as a CBOR_TYPE_END item. Tags are skipped.
+// Indefinite-length strings are not supported
+class CBORReader {
+public:
+    static const unsigned MAX_DEPTH = 16; // Maximum nesting level of arrays and objects
+
+    CBORReader(const char *data, size_t size);
+
+    bool next(); // Returns false at the end of the document or in case of an error
+    bool skip(); // Skips the current array or object
+
+    CBORType type() const;
+
+    bool toBool() const;
+    long long toInt() const;
+    double toDouble() const;
+
+    const char* data() const; // String data
+    size_t size() const; // Size of the string data, or number of elements of an array or object
+
+    bool isIndefinite() const; // Returns true if the current array or object has indefinite length
+    bool hasError() const;
+    size_t depth() const; // Number of arrays and objects that are currently open
+
+private:
+    static const uint64_t INDEFINITE = (uint64_t)-1;
+
+    const char *data_;
+    size_t size_, pos_;
+    uint64_t val_;
+    double float_;
+    const char *str_;
+    uint64_t remaining_[MAX_DEPTH]; // Number of items left in each open array or object
+    uint8_t depth_;
+    CBORType type_;
+    bool neg_;
+    bool indef_;
+    bool error_;
+
+    bool readArgument(uint8_t info, uint64_t *val);
+    bool readBytes(void *data, size_t size);
+    bool fail();
+};
+
+} // namespace spark
+
+// spark::CBORWriter
+inline spark::CBORWriter& spark::CBORWriter::name(const char *name) {
+    return this->name(name, strlen(name));
+}
+
+inline spark::CBORWriter& spark::CBORWriter::name(const char *name, size_t size) {
+    return value(name, size); // Names are encoded as text strings
+}
+
+inline spark::CBORWriter& spark::CBORWriter::name(const String &name) {
+    return this->name(name.c_str(), name.length());
+}
+
+inline spark::CBORWriter& spark::CBORWriter::value(const char *val) {
+    return value(val, strlen(val));
+}
+
+inline spark::CBORWriter& spark::CBORWriter::value(const String &val) {
+    return value(val.c_str(), val.length());
+}
+
+inline void spark::CBORWriter::write(uint8_t b) {
+    write((const char*)&b, 1);
+}
+
+// spark::CBORStreamWriter
+inline spark::CBORStreamWriter::CBORStreamWriter(Print &stream) :
+        strm_(stream) {
+}
+
+inline Print* spark::CBORStreamWriter::stream() const {
+    return &strm_;
+}
+
+inline void spark::CBORStreamWriter::write(const char *data, size_t size) {
+    strm_.write((const uint8_t*)data, size);
+}
+
+// spark::CBORBufferWriter
+inline spark::CBORBufferWriter::CBORBufferWriter(char *buf, size_t size) :
+        buf_(buf),
+        bufSize_(size),
+        n_(0) {
+}
+
+inline char* spark::CBORBufferWriter::buffer() const {
+    return buf_;
+}
+
+inline size_t spark::CBORBufferWriter::bufferSize() const {
+    return bufSize_;
+}
+
+inline size_t spark::CBORBufferWriter::dataSize() const {
+    return n_;
+}
+
+// spark::CBORReader
+inline spark::CBORType spark::CBORReader::type() const {
+    return type_;
+}
+
+inline const char* spark::CBORReader::data() const {
+    return str_;
+}
+
+inline bool spark::CBORReader::isIndefinite() const {
+    return indef_;
+}
+
+inline bool spark::CBORReader::hasError() const {
+    return error_;
+}
+
+inline size_t spark::CBORReader::depth() const {
+    return depth_;
+}
+
+#endif // SPARK_WIRING_CBOR_H
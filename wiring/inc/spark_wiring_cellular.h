@@ -164,6 +164,32 @@ public:
     }
 #endif // HAL_PLATFORM_MESH
 
+    /**
+     * Request the network to keep the modem registered while it's in Power Saving Mode (PSM).
+     *
+     * @param activeTime Time the modem stays reachable after the last activity (T3324).
+     * @param periodicTau Periodic tracking area update interval (T3412).
+     * @param edrxCycle eDRX cycle length, or 0 to disable eDRX.
+     * @return `SYSTEM_ERROR_NONE` or an error code.
+     */
+    int setPowerSaving(std::chrono::seconds activeTime, std::chrono::seconds periodicTau,
+            std::chrono::milliseconds edrxCycle = std::chrono::milliseconds(0)) {
+        cellular_power_saving_config conf = {};
+        conf.size = sizeof(conf);
+        conf.flags = CELLULAR_POWER_SAVING_FLAG_PSM;
+        conf.active_time = activeTime.count();
+        conf.periodic_tau = periodicTau.count();
+        if (edrxCycle.count() > 0) {
+            conf.flags |= CELLULAR_POWER_SAVING_FLAG_EDRX;
+            conf.edrx_cycle = edrxCycle.count();
+        }
+        return cellular_power_saving_set(&conf, nullptr);
+    }
+
+    int disablePowerSaving() {
+        return cellular_power_saving_set(nullptr, nullptr);
+    }
+
     void lock()
     {
         cellular_lock(nullptr);
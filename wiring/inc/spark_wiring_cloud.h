@@ -47,8 +47,16 @@
 #define PARTICLE_DEPRECATED_API_DEFAULT_SUBSCRIBE_SCOPE \
         PARTICLE_DEPRECATED_API("Beginning with 0.8.0 release, Particle.subscribe() will require event scope to be specified explicitly.");
 
+namespace particle {
+
+class ThreadPool;
+
+} // namespace particle
+
 typedef std::function<user_function_int_str_t> user_std_function_int_str_t;
+typedef std::function<void(String, particle::Promise<int>)> user_async_function_t;
 typedef std::function<void (const char*, const char*)> wiring_event_handler_t;
+typedef std::function<void (const char*, const char*, size_t, ContentType::Enum)> wiring_binary_event_handler_t;
 
 #ifndef __XSTRING
 #define	__STRING(x)	#x		/* stringify without expanding x */
@@ -70,6 +78,62 @@ struct is_string_literal {
     static constexpr bool value = std::is_array<T>::value && std::is_same<typename std::remove_extent<T>::type, char>::value;
 };
 
+/**
+ * Matching criteria of a subscription.
+ *
+ * The criteria are sent to the cloud along with the subscription, so that the events that don't
+ * match are not delivered to the device. The device checks them as well.
+ */
+class EventFilter {
+public:
+    EventFilter() :
+            flags_(0),
+            data_(nullptr) {
+    }
+
+    // Only match the events whose name is equal to the subscribed name, rather than starting with it
+    EventFilter& exactName(bool enabled = true) {
+        if (enabled) {
+            flags_ |= SPARK_SUBSCRIBE_FLAG_EXACT_NAME;
+        } else {
+            flags_ &= ~SPARK_SUBSCRIBE_FLAG_EXACT_NAME;
+        }
+        return *this;
+    }
+
+    // Only match the events whose data starts with the specified string (at most 31 characters)
+    EventFilter& dataPrefix(const char* prefix) {
+        return data(SPARK_SUBSCRIBE_FLAG_DATA_PREFIX, prefix);
+    }
+
+    // Only match the events whose data contains the specified string (at most 31 characters)
+    EventFilter& dataContains(const char* str) {
+        return data(SPARK_SUBSCRIBE_FLAG_DATA_CONTAINS, str);
+    }
+
+    uint32_t flags() const {
+        return flags_;
+    }
+
+    const char* data() const {
+        return data_;
+    }
+
+private:
+    uint32_t flags_;
+    const char* data_;
+
+    EventFilter& data(uint32_t flag, const char* str) {
+        // Only one data criterion is supported
+        flags_ &= ~(SPARK_SUBSCRIBE_FLAG_DATA_PREFIX | SPARK_SUBSCRIBE_FLAG_DATA_CONTAINS);
+        if (str) {
+            flags_ |= flag;
+        }
+        data_ = str;
+        return *this;
+    }
+};
+
 class CloudClass {
 public:
     template <typename T, typename... ArgsT>
@@ -182,6 +246,21 @@ public:
         return false;
     }
 
+    /**
+     * Make a registered variable observable.
+     *
+     * Instead of polling the variable, the cloud can then be notified when its value changes.
+     *
+     * @param name Variable name.
+     * @param minInterval Minimum interval between change notifications in milliseconds.
+     * @param threshold Minimum change of a numeric value that triggers a notification.
+     * @return 0 on success, or a negative result code in case of an error.
+     */
+    static int observeVariable(const char* name, system_tick_t minInterval, double threshold = 0)
+    {
+        return spark_variable_observe(name, minInterval, threshold, nullptr);
+    }
+
     template <typename T, class ... Types>
     static inline bool function(const T &name, Types ... args)
     {
@@ -215,6 +294,45 @@ public:
       return _function(funcKey, std::bind(func, instance, _1));
     }
 
+    /**
+     * Register a function handler that completes asynchronously.
+     *
+     * The handler returns immediately and sets the result of the function call via the promise
+     * object once it is available, so a long-running operation doesn't block the application or
+     * the cloud connection. If the promise fails, the function call returns the error code.
+     */
+    template <typename T>
+    static inline bool functionAsync(const T &name, user_async_function_t func)
+    {
+        static_assert(!is_string_literal<T>::value || sizeof(name) <= USER_FUNC_KEY_LENGTH + 1,
+            "\n\nIn Particle.functionAsync, name must be " __XSTRING(USER_FUNC_KEY_LENGTH) " characters or less\n\n");
+
+        return _functionAsync(name, std::move(func));
+    }
+
+    static bool _functionAsync(const char *funcKey, user_async_function_t func);
+
+#if PLATFORM_THREADING
+    /**
+     * Register a function handler that runs in a worker thread of a thread pool.
+     *
+     * Calls to the function don't wait for the previously received calls to complete: up to
+     * `pool.workerCount()` handlers run concurrently and the result of each call is sent to the cloud
+     * as soon as its handler returns. A call fails with `SYSTEM_ERROR_BUSY` if the queue of the pool
+     * is full. The pool must outlive the registration.
+     */
+    template <typename T>
+    static inline bool functionConcurrent(const T &name, user_std_function_int_str_t func, particle::ThreadPool& pool)
+    {
+        static_assert(!is_string_literal<T>::value || sizeof(name) <= USER_FUNC_KEY_LENGTH + 1,
+            "\n\nIn Particle.functionConcurrent, name must be " __XSTRING(USER_FUNC_KEY_LENGTH) " characters or less\n\n");
+
+        return _functionConcurrent(name, std::move(func), pool);
+    }
+
+    static bool _functionConcurrent(const char *funcKey, user_std_function_int_str_t func, particle::ThreadPool& pool);
+#endif // PLATFORM_THREADING
+
     inline particle::Future<bool> publish(const char *eventName, PublishFlags flags1, PublishFlags flags2 = PublishFlags())
     {
         return publish(eventName, NULL, flags1, flags2);
@@ -227,7 +345,105 @@ public:
 
     inline particle::Future<bool> publish(const char *eventName, const char *eventData, int ttl, PublishFlags flags1, PublishFlags flags2 = PublishFlags())
     {
-        return publish_event(eventName, eventData, ttl, flags1 | flags2);
+        return publish_event(eventName, eventData, 0, ContentType::TEXT, ttl, flags1 | flags2);
+    }
+
+    /**
+     * Publish an event with the given priority.
+     *
+     * The priority and timeout take effect if the event can't be sent immediately because of the
+     * rate limit. Deferred events are sent in the order of their priority, then their deadline, and
+     * an event of a higher priority can displace a lower priority event from a full queue. A
+     * deferred event that has been waiting for more than `timeout` milliseconds is dropped, unless
+     * its priority is `EventPriority::CRITICAL`. If `timeout` is 0, the event has no deadline.
+     */
+    inline particle::Future<bool> publish(const char *eventName, const char *eventData, int ttl, PublishFlags flags, EventPriority::Enum priority, system_tick_t timeout = 0)
+    {
+        return publish_event(eventName, eventData, 0, ContentType::TEXT, ttl, flags, priority, timeout);
+    }
+
+    /**
+     * Publish an event with binary data.
+     *
+     * The data doesn't need to be null-terminated and is sent as is, along with its content format.
+     * Its size is limited to `particle::protocol::MAX_EVENT_DATA_LENGTH` bytes.
+     */
+    inline particle::Future<bool> publish(const char *eventName, const void *data, size_t size, ContentType::Enum type, PublishFlags flags1, PublishFlags flags2 = PublishFlags())
+    {
+        return publish(eventName, data, size, type, DEFAULT_CLOUD_EVENT_TTL, flags1, flags2);
+    }
+
+    inline particle::Future<bool> publish(const char *eventName, const void *data, size_t size, ContentType::Enum type, int ttl, PublishFlags flags1, PublishFlags flags2 = PublishFlags())
+    {
+        return publish(eventName, data, size, type, ttl, flags1 | flags2, EventPriority::NORMAL);
+    }
+
+    inline particle::Future<bool> publish(const char *eventName, const void *data, size_t size, ContentType::Enum type, int ttl, PublishFlags flags, EventPriority::Enum priority, system_tick_t timeout = 0)
+    {
+        // A size of 0 would make the data be treated as a null-terminated string
+        return publish_event(eventName, size ? (const char*)data : nullptr, size, type, ttl, flags, priority, timeout);
+    }
+
+    /**
+     * Publish several events in a single message.
+     *
+     * All events of the batch share the same TTL and flags, and the returned future is
+     * completed once for the whole batch. The total size of the batch is limited by the
+     * size of a single protocol message.
+     */
+    inline particle::Future<bool> publishBatch(const EventBatchEntry* events, size_t count, PublishFlags flags1, PublishFlags flags2 = PublishFlags())
+    {
+        return publishBatch(events, count, DEFAULT_CLOUD_EVENT_TTL, flags1, flags2);
+    }
+
+    inline particle::Future<bool> publishBatch(const EventBatchEntry* events, size_t count, int ttl, PublishFlags flags1, PublishFlags flags2 = PublishFlags())
+    {
+        return publish_events(events, count, ttl, flags1 | flags2);
+    }
+
+    /**
+     * Add an event to the persistent publish queue.
+     *
+     * Unlike `publish()`, this method doesn't require a cloud connection: the event is stored in
+     * the filesystem and published by the system, together with other queued events, once the
+     * device is connected to the cloud. Supported only on platforms with a filesystem.
+     *
+     * @return 0 on success, or a negative result code in case of an error.
+     */
+    inline int publishQueued(const char* eventName, const char* eventData, PublishFlags flags1, PublishFlags flags2 = PublishFlags())
+    {
+        return publishQueued(eventName, eventData, DEFAULT_CLOUD_EVENT_TTL, flags1, flags2);
+    }
+
+    inline int publishQueued(const char* eventName, const char* eventData, int ttl, PublishFlags flags1, PublishFlags flags2 = PublishFlags())
+    {
+        return spark_publish_queue_push(eventName, eventData, ttl, (flags1 | flags2).value(), nullptr);
+    }
+
+    /**
+     * Publish an event from an interrupt handler.
+     *
+     * The event is copied and published asynchronously by the system. The event data is limited to
+     * 64 characters, and only a few events can be waiting to be published at the same time.
+     *
+     * @return 0 on success, or a negative result code in case of an error.
+     */
+    inline int publishFromISR(const char* eventName, const char* eventData, PublishFlags flags1, PublishFlags flags2 = PublishFlags())
+    {
+        return publishFromISR(eventName, eventData, DEFAULT_CLOUD_EVENT_TTL, flags1, flags2);
+    }
+
+    inline int publishFromISR(const char* eventName, const char* eventData, int ttl, PublishFlags flags1, PublishFlags flags2 = PublishFlags())
+    {
+        return spark_publish_from_isr(eventName, eventData, ttl, (flags1 | flags2).value(), nullptr);
+    }
+
+    /**
+     * Write the queued events that are buffered in RAM to the filesystem.
+     */
+    inline int flushPublishQueue()
+    {
+        return spark_publish_queue_flush(nullptr);
     }
 
     // Deprecated methods
@@ -280,6 +496,47 @@ public:
         return subscribe_wiring(eventName, handler, MY_DEVICES, deviceID);
     }
 
+    /**
+     * Subscribe to events with a handler that receives the size and content format of the event data.
+     *
+     * The data passed to the handler may contain null characters. It is still followed by a null
+     * terminator, which is not included in the size.
+     */
+    bool subscribe(const char *eventName, wiring_binary_event_handler_t handler, Spark_Subscription_Scope_TypeDef scope)
+    {
+        return subscribe_wiring(eventName, handler, scope);
+    }
+
+    bool subscribe(const char *eventName, wiring_binary_event_handler_t handler, const char *deviceID)
+    {
+        return subscribe_wiring(eventName, handler, MY_DEVICES, deviceID);
+    }
+
+    /**
+     * Subscribe to events that match additional criteria.
+     *
+     * @see EventFilter
+     */
+    bool subscribe(const char *eventName, wiring_event_handler_t handler, const EventFilter& filter, Spark_Subscription_Scope_TypeDef scope)
+    {
+        return subscribe_wiring(eventName, handler, scope, NULL, &filter);
+    }
+
+    bool subscribe(const char *eventName, wiring_event_handler_t handler, const EventFilter& filter, const char *deviceID)
+    {
+        return subscribe_wiring(eventName, handler, MY_DEVICES, deviceID, &filter);
+    }
+
+    bool subscribe(const char *eventName, wiring_binary_event_handler_t handler, const EventFilter& filter, Spark_Subscription_Scope_TypeDef scope)
+    {
+        return subscribe_wiring(eventName, handler, scope, NULL, &filter);
+    }
+
+    bool subscribe(const char *eventName, wiring_binary_event_handler_t handler, const EventFilter& filter, const char *deviceID)
+    {
+        return subscribe_wiring(eventName, handler, MY_DEVICES, deviceID, &filter);
+    }
+
     template <typename T>
     bool subscribe(const char *eventName, void (T::*handler)(const char *, const char *), T *instance, Spark_Subscription_Scope_TypeDef scope)
     {
@@ -365,31 +622,98 @@ public:
     }
 
     inline static void keepAlive(std::chrono::seconds s) { keepAlive(s.count()); }
+
+    /**
+     * Enables or disables the adaptive keepalive mode.
+     *
+     * In the adaptive mode, the system learns how long the NAT binding of the cloud connection
+     * survives without traffic on the current network, and sends keepalive pings just often
+     * enough to keep it open. The learned lifetime is remembered per network. Learning a longer
+     * lifetime involves pings that may time out, each costing a reconnection to the cloud.
+     *
+     * Setting the keepalive interval with `keepAlive()` disables the adaptive mode.
+     */
+    inline static void keepAliveAdaptive(bool enabled = true)
+    {
+        particle::protocol::connection_properties_t conn_prop = {0};
+        conn_prop.size = sizeof(conn_prop);
+        conn_prop.keepalive_source = particle::protocol::KeepAliveSource::USER;
+        spark_set_connection_property(particle::protocol::Connection::ADAPTIVE_PING,
+                enabled ? 0 : particle::protocol::ADAPTIVE_PING_DISABLED, &conn_prop, nullptr);
+    }
 #endif
 
+    /**
+     * Sets the rate limit for application events.
+     *
+     * Events exceeding the limit are deferred and sent as soon as the limit allows, as long as
+     * there's space in the deferral queue.
+     *
+     * @param burst Maximum number of events that can be published in a burst.
+     * @param interval Interval in milliseconds at which the burst allowance is replenished by one event.
+     */
+    inline static void setPublishRateLimit(uint16_t burst, uint16_t interval)
+    {
+        spark_set_connection_property(particle::protocol::Connection::EVENT_RATE_LIMIT,
+                                               ((unsigned)burst << 16) | interval, nullptr, nullptr);
+    }
+
 private:
 
-    static bool register_function(cloud_function_t fn, void* data, const char* funcKey);
+    static bool register_function(cloud_function_t fn, void* data, const char* funcKey, uint16_t flags = 0);
     static int call_raw_user_function(void* data, const char* param, void* reserved);
     static int call_std_user_function(void* data, const char* param, void* reserved);
+    static int call_async_user_function(void* data, const char* param, void* completion);
 
     static void call_wiring_event_handler(const void* param, const char *event_name, const char *data);
+    static void call_wiring_binary_event_handler(void* param, const char *event_name, const char *data, size_t size, int type);
 
-    static particle::Future<bool> publish_event(const char *eventName, const char *eventData, int ttl, PublishFlags flags);
+    // If `size` is 0, the event data is a null-terminated string
+    static particle::Future<bool> publish_event(const char *eventName, const char *eventData, size_t size, int type, int ttl,
+            PublishFlags flags, EventPriority::Enum priority = EventPriority::NORMAL, system_tick_t timeout = 0);
+    static particle::Future<bool> publish_events(const EventBatchEntry* events, size_t count, int ttl, PublishFlags flags);
 
     static ProtocolFacade* sp()
     {
         return spark_protocol_instance();
     }
 
-    bool subscribe_wiring(const char *eventName, wiring_event_handler_t handler, Spark_Subscription_Scope_TypeDef scope, const char *deviceID = NULL)
+    bool subscribe_wiring(const char *eventName, wiring_event_handler_t handler, Spark_Subscription_Scope_TypeDef scope, const char *deviceID = NULL,
+            const EventFilter* filter = NULL)
     {
         bool success = false;
         if (handler) // if the call-wrapper has wrapped a callable object
         {
             auto wrapper = new wiring_event_handler_t(handler);
             if (wrapper) {
-                success = spark_subscribe(eventName, (EventHandler)call_wiring_event_handler, wrapper, scope, deviceID, NULL);
+                if (filter && filter->flags()) {
+                    spark_subscribe_data d = { sizeof(spark_subscribe_data) };
+                    d.flags = filter->flags();
+                    d.data_filter = filter->data();
+                    success = spark_subscribe(eventName, (EventHandler)call_wiring_event_handler, wrapper, scope, deviceID, &d);
+                } else {
+                    success = spark_subscribe(eventName, (EventHandler)call_wiring_event_handler, wrapper, scope, deviceID, NULL);
+                }
+            }
+        }
+        return success;
+    }
+
+    bool subscribe_wiring(const char *eventName, wiring_binary_event_handler_t handler, Spark_Subscription_Scope_TypeDef scope, const char *deviceID = NULL,
+            const EventFilter* filter = NULL)
+    {
+        bool success = false;
+        if (handler)
+        {
+            auto wrapper = new wiring_binary_event_handler_t(handler);
+            if (wrapper) {
+                spark_subscribe_data d = { sizeof(spark_subscribe_data) };
+                d.flags = SPARK_SUBSCRIBE_FLAG_BINARY;
+                if (filter) {
+                    d.flags |= filter->flags();
+                    d.data_filter = filter->data();
+                }
+                success = spark_subscribe(eventName, (EventHandler)call_wiring_binary_event_handler, wrapper, scope, deviceID, &d);
             }
         }
         return success;
@@ -217,6 +217,43 @@ private:
     }
 };
 
+// Lock-free counter. Unlike the data sources parameterized with AtomicConcurrency, the counter
+// never disables interrupts: on ARMv7-M, std::atomic compiles to an LDREX/STREX loop, so the
+// counter can be incremented from any thread or ISR at the cost of a few instructions
+class CounterDiagnosticData: public AbstractIntegerDiagnosticData {
+public:
+    explicit CounterDiagnosticData(DiagnosticDataId id, const char* name = nullptr, IntType val = 0) :
+            AbstractIntegerDiagnosticData(id, name),
+            val_(val) {
+    }
+
+    IntType operator++() {
+        return (val_.fetch_add(1, std::memory_order_relaxed) + 1);
+    }
+
+    IntType operator++(int) {
+        return val_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    IntType operator+=(IntType val) {
+        return (val_.fetch_add(val, std::memory_order_relaxed) + val);
+    }
+
+    operator IntType() const {
+        return val_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<IntType> val_;
+
+    static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LONG_LOCK_FREE == 2, "32-bit atomics are not lock-free");
+
+    virtual int get(IntType& val) override { // AbstractIntegerDiagnosticData
+        val = val_.load(std::memory_order_relaxed);
+        return SYSTEM_ERROR_NONE;
+    }
+};
+
 template<typename StorageT, typename ConcurrencyT = NoConcurrency>
 class PersistentIntegerDiagnosticData:
         public AbstractIntegerDiagnosticData,
@@ -423,6 +460,69 @@ private:
     }
 };
 
+// Base abstract class for a data source containing a histogram
+class AbstractHistogramDiagnosticData: public AbstractDiagnosticData {
+public:
+    static const unsigned BUCKET_COUNT = DIAG_HISTOGRAM_BUCKET_COUNT;
+
+    static int get(DiagnosticDataId id, diag_histogram& hist);
+    static int get(const diag_source* src, diag_histogram& hist);
+
+    // Returns the index of the bucket that counts a given value
+    static unsigned bucketIndex(uint32_t val);
+    // Returns the smallest value counted by a given bucket
+    static uint32_t bucketLowerBound(unsigned index);
+    // Returns an estimate of the given percentile (0-100) of the samples, which is the upper bound
+    // of the bucket containing that percentile, or the lower bound if it's the last bucket
+    static uint32_t percentile(const diag_histogram& hist, unsigned p);
+    // Returns the total number of samples
+    static uint32_t count(const diag_histogram& hist);
+    // Adds the counters of one histogram to another
+    static void merge(diag_histogram& dest, const diag_histogram& src);
+
+protected:
+    explicit AbstractHistogramDiagnosticData(DiagnosticDataId id, const char* name = nullptr);
+
+    virtual int get(diag_histogram& hist) = 0;
+
+private:
+    virtual int get(void* data, size_t& size) override; // AbstractDiagnosticData
+};
+
+template<typename ConcurrencyT = NoConcurrency>
+class HistogramDiagnosticData:
+        public AbstractHistogramDiagnosticData,
+        private ConcurrencyT {
+public:
+    explicit HistogramDiagnosticData(DiagnosticDataId id, const char* name = nullptr) :
+            AbstractHistogramDiagnosticData(id, name),
+            hist_() {
+    }
+
+    void add(uint32_t val) {
+        const unsigned i = bucketIndex(val);
+        const auto lock = ConcurrencyT::lock();
+        ++hist_.buckets[i];
+        hist_.sum += val;
+        ConcurrencyT::unlock(lock);
+    }
+
+    diag_histogram histogram() const {
+        const auto lock = ConcurrencyT::lock();
+        const diag_histogram h = hist_;
+        ConcurrencyT::unlock(lock);
+        return h;
+    }
+
+private:
+    diag_histogram hist_;
+
+    virtual int get(diag_histogram& hist) override { // AbstractHistogramDiagnosticData
+        hist = histogram();
+        return SYSTEM_ERROR_NONE;
+    }
+};
+
 template<typename ValueT>
 class RetainedDiagnosticDataStorage {
 public:
@@ -474,6 +574,9 @@ using AtomicEnumDiagnosticData = EnumDiagnosticData<EnumT, AtomicConcurrency>;
 template<typename EnumT>
 using RetainedEnumDiagnosticDataStorage = RetainedDiagnosticDataStorage<EnumT>;
 
+typedef HistogramDiagnosticData<NoConcurrency> SimpleHistogramDiagnosticData;
+typedef HistogramDiagnosticData<AtomicConcurrency> AtomicHistogramDiagnosticData;
+
 inline AbstractDiagnosticData::AbstractDiagnosticData(DiagnosticDataId id, diag_type type) :
         AbstractDiagnosticData(id, nullptr, type) {
 }
@@ -552,4 +655,85 @@ inline int AbstractIntegerDiagnosticData::get(void* data, size_t& size) {
     return ret;
 }
 
+inline AbstractHistogramDiagnosticData::AbstractHistogramDiagnosticData(DiagnosticDataId id, const char* name) :
+        AbstractDiagnosticData(id, name, DIAG_TYPE_HISTOGRAM) {
+}
+
+inline int AbstractHistogramDiagnosticData::get(DiagnosticDataId id, diag_histogram& hist) {
+    const diag_source* src = nullptr;
+    const int ret = diag_get_source(id, &src, nullptr);
+    if (ret != SYSTEM_ERROR_NONE) {
+        return ret;
+    }
+    return get(src, hist);
+}
+
+inline int AbstractHistogramDiagnosticData::get(const diag_source* src, diag_histogram& hist) {
+    SPARK_ASSERT(src->type == DIAG_TYPE_HISTOGRAM);
+    size_t size = sizeof(diag_histogram);
+    return AbstractDiagnosticData::get(src, &hist, size);
+}
+
+inline unsigned AbstractHistogramDiagnosticData::bucketIndex(uint32_t val) {
+    if (!val) {
+        return 0;
+    }
+    const unsigned i = 32 - __builtin_clz(val);
+    return (i < BUCKET_COUNT) ? i : BUCKET_COUNT - 1;
+}
+
+inline uint32_t AbstractHistogramDiagnosticData::bucketLowerBound(unsigned index) {
+    return index ? (uint32_t)1 << (index - 1) : 0;
+}
+
+inline uint32_t AbstractHistogramDiagnosticData::percentile(const diag_histogram& hist, unsigned p) {
+    const uint32_t n = count(hist);
+    if (!n) {
+        return 0;
+    }
+    // Rank of the sample at the given percentile (1-based)
+    uint64_t rank = ((uint64_t)n * p + 99) / 100;
+    if (!rank) {
+        rank = 1;
+    }
+    uint64_t c = 0;
+    for (unsigned i = 0; i < BUCKET_COUNT - 1; ++i) {
+        c += hist.buckets[i];
+        if (c >= rank) {
+            return bucketLowerBound(i + 1) - 1;
+        }
+    }
+    return bucketLowerBound(BUCKET_COUNT - 1);
+}
+
+inline uint32_t AbstractHistogramDiagnosticData::count(const diag_histogram& hist) {
+    uint32_t n = 0;
+    for (unsigned i = 0; i < BUCKET_COUNT; ++i) {
+        n += hist.buckets[i];
+    }
+    return n;
+}
+
+inline void AbstractHistogramDiagnosticData::merge(diag_histogram& dest, const diag_histogram& src) {
+    dest.sum += src.sum;
+    for (unsigned i = 0; i < BUCKET_COUNT; ++i) {
+        dest.buckets[i] += src.buckets[i];
+    }
+}
+
+inline int AbstractHistogramDiagnosticData::get(void* data, size_t& size) {
+    if (!data) {
+        size = sizeof(diag_histogram);
+        return SYSTEM_ERROR_NONE;
+    }
+    if (size < sizeof(diag_histogram)) {
+        return SYSTEM_ERROR_TOO_LARGE;
+    }
+    const int ret = get(*(diag_histogram*)data);
+    if (ret == SYSTEM_ERROR_NONE) {
+        size = sizeof(diag_histogram);
+    }
+    return ret;
+}
+
 } // namespace particle
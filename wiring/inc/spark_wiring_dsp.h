@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "spark_wiring_fixed_point.h"
+
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Signal processing kernels for buffers of `FixedPointQ` values.
+ *
+ * Buffers of values with 16-bit storage are processed two samples at a time using the SIMD
+ * instructions of the Cortex-M4 DSP extension (SMLALD, QADD16, SHADD16, etc.) when the target
+ * supports them. Other targets and storage types use portable code that produces the same results.
+ */
+namespace particle { namespace dsp {
+
+/**
+ * Signed Q15 value in the range [-1, 1).
+ */
+typedef FixedPointSQ<1, 15> Q15;
+
+/**
+ * Complex number.
+ */
+template<typename T>
+struct Complex {
+    T re;
+    T im;
+};
+
+namespace detail {
+
+int64_t dot16(const int16_t* a, const int16_t* b, size_t n);
+void add16(const int16_t* a, const int16_t* b, int16_t* out, size_t n);
+void fft16(int16_t* data, size_t size, const int16_t* twiddles);
+void fftTwiddles16(int16_t* twiddles, size_t size);
+uint64_t isqrt(uint64_t v);
+
+template<typename S>
+inline S saturate(int64_t v) {
+    if (v > std::numeric_limits<S>::max()) {
+        return std::numeric_limits<S>::max();
+    }
+    if (v < std::numeric_limits<S>::min()) {
+        return std::numeric_limits<S>::min();
+    }
+    return static_cast<S>(v);
+}
+
+template<typename S>
+inline int64_t dotRaw(const S* a, const S* b, size_t n) {
+    int64_t acc = 0;
+    for (size_t i = 0; i < n; ++i) {
+        acc += (int64_t)a[i] * b[i];
+    }
+    return acc;
+}
+
+inline int64_t dotRaw(const int16_t* a, const int16_t* b, size_t n) {
+    return dot16(a, b, n);
+}
+
+template<typename S>
+inline void addRaw(const S* a, const S* b, S* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = saturate<S>((int64_t)a[i] + b[i]);
+    }
+}
+
+inline void addRaw(const int16_t* a, const int16_t* b, int16_t* out, size_t n) {
+    add16(a, b, out, n);
+}
+
+// FixedPointQ consists of a single member of its storage type, so a buffer of values can be
+// processed as a buffer of raw integers
+template<typename T>
+inline const typename T::StorageT* raw(const T* p) {
+    static_assert(sizeof(T) == sizeof(typename T::StorageT), "Unsupported value type");
+    return reinterpret_cast<const typename T::StorageT*>(p);
+}
+
+template<typename T>
+inline typename T::StorageT* raw(T* p) {
+    static_assert(sizeof(T) == sizeof(typename T::StorageT), "Unsupported value type");
+    return reinterpret_cast<typename T::StorageT*>(p);
+}
+
+} // particle::dsp::detail
+
+/**
+ * Computes the dot product of two vectors.
+ *
+ * The products are accumulated with 64-bit precision, and the result is saturated to the range
+ * of `T`.
+ */
+template<typename T>
+inline T dot(const T* a, const T* b, size_t n) {
+    typedef typename T::StorageT S;
+    return T(detail::saturate<S>(detail::dotRaw(detail::raw(a), detail::raw(b), n) >> T::FRACTION_BITS));
+}
+
+/**
+ * Computes the saturating sum of two vectors. `out` may be the same buffer as `a` or `b`.
+ */
+template<typename T>
+inline void add(const T* a, const T* b, T* out, size_t n) {
+    detail::addRaw(detail::raw(a), detail::raw(b), detail::raw(out), n);
+}
+
+/**
+ * Computes the root mean square of a vector.
+ */
+template<typename T>
+inline T rms(const T* x, size_t n) {
+    if (!n) {
+        return T(typename T::StorageT(0));
+    }
+    const auto r = detail::raw(x);
+    const uint64_t meanSquare = (uint64_t)detail::dotRaw(r, r, n) / n;
+    return T(detail::saturate<typename T::StorageT>(detail::isqrt(meanSquare)));
+}
+
+/**
+ * FIR filter with a fixed number of taps.
+ *
+ * The filter keeps its delay line between calls, so a continuous signal can be processed in
+ * blocks of any size, e.g. as the buffers of a DMA transfer complete.
+ */
+template<typename T, size_t TAPS>
+class FirFilter {
+public:
+    static_assert(TAPS > 0, "Invalid number of taps");
+
+    typedef typename T::StorageT StorageT;
+
+    /**
+     * Constructs a filter.
+     *
+     * @param coeffs Filter coefficients. `coeffs[0]` is applied to the most recent sample.
+     */
+    explicit FirFilter(const T (&coeffs)[TAPS]) :
+            pos_(0) {
+        // The delay line is stored in chronological order, so the coefficients are reversed
+        for (size_t i = 0; i < TAPS; ++i) {
+            coeffs_[i] = coeffs[TAPS - 1 - i].value();
+        }
+        reset();
+    }
+
+    /**
+     * Filters a block of samples. `out` may be the same buffer as `in`.
+     */
+    void process(const T* in, T* out, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            push(in[i]);
+            out[i] = output();
+        }
+    }
+
+    /**
+     * Clears the delay line.
+     */
+    void reset() {
+        for (auto& v: delay_) {
+            v = 0;
+        }
+        pos_ = 0;
+    }
+
+protected:
+    void push(T sample) {
+        // Every sample is stored twice, so that the last TAPS samples are always contiguous
+        delay_[pos_] = sample.value();
+        delay_[pos_ + TAPS] = sample.value();
+        if (++pos_ == TAPS) {
+            pos_ = 0;
+        }
+    }
+
+    T output() const {
+        const int64_t acc = detail::dotRaw(coeffs_, delay_ + pos_, TAPS);
+        return T(detail::saturate<StorageT>(acc >> T::FRACTION_BITS));
+    }
+
+private:
+    StorageT coeffs_[TAPS];
+    StorageT delay_[TAPS * 2];
+    size_t pos_;
+};
+
+/**
+ * Low-pass filters and downsamples a signal by an integer factor.
+ *
+ * Only the retained output samples are computed, so the cost per input sample is `TAPS / FACTOR`
+ * multiply-accumulate operations.
+ */
+template<typename T, size_t TAPS, size_t FACTOR>
+class Decimator: private FirFilter<T, TAPS> {
+public:
+    static_assert(FACTOR > 0, "Invalid decimation factor");
+
+    /**
+     * Constructs a decimator.
+     *
+     * @param coeffs Coefficients of the anti-aliasing filter.
+     */
+    explicit Decimator(const T (&coeffs)[TAPS]) :
+            FirFilter<T, TAPS>(coeffs),
+            phase_(0) {
+    }
+
+    /**
+     * Processes a block of samples.
+     *
+     * @param in Input samples.
+     * @param n Number of input samples.
+     * @param out Output buffer. The buffer needs to have room for `n / FACTOR + 1` samples, and may
+     *        be the same buffer as `in`.
+     * @return Number of output samples.
+     */
+    size_t process(const T* in, size_t n, T* out) {
+        size_t count = 0;
+        for (size_t i = 0; i < n; ++i) {
+            this->push(in[i]);
+            if (++phase_ == FACTOR) {
+                out[count++] = this->output();
+                phase_ = 0;
+            }
+        }
+        return count;
+    }
+
+    void reset() {
+        FirFilter<T, TAPS>::reset();
+        phase_ = 0;
+    }
+
+private:
+    size_t phase_;
+};
+
+/**
+ * In-place radix-2 FFT of complex Q15 values.
+ *
+ * Every stage scales its output by 1/2 to prevent overflow, so the result is the discrete Fourier
+ * transform divided by `SIZE`. The twiddle factors are computed once in the constructor.
+ */
+template<size_t SIZE>
+class Fft {
+public:
+    static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "FFT size must be a power of two");
+
+    Fft() {
+        detail::fftTwiddles16(twiddles_, SIZE);
+    }
+
+    /**
+     * Transforms a buffer of `SIZE` complex values.
+     */
+    void transform(Complex<Q15>* data) const {
+        static_assert(sizeof(Complex<Q15>) == 2 * sizeof(int16_t), "Unsupported value type");
+        detail::fft16(reinterpret_cast<int16_t*>(data), SIZE, twiddles_);
+    }
+
+private:
+    int16_t twiddles_[SIZE]; // Pairs of cos and -sin for the first half of the circle
+};
+
+} } // particle::dsp
@@ -166,6 +166,19 @@ struct EEPROMClass{
     {
         HAL_EEPROM_Perform_Pending_Erase();
     }
+
+    // Keep changes in RAM for up to flushDelay milliseconds before writing them to flash.
+    // 0 writes all changes immediately (default)
+    int setWriteBack(uint32_t flushDelay)
+    {
+        return HAL_EEPROM_Set_Write_Back(flushDelay, nullptr);
+    }
+
+    // Writes all pending changes to flash
+    int flush()
+    {
+        return HAL_EEPROM_Flush(nullptr);
+    }
 };
 
 #define EEPROM __fetch_global_EEPROM()
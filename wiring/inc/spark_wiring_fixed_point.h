@@ -50,6 +50,10 @@ public:
     using StorageT = typename std::conditional<std::is_same<T, void>::value, typename minimum_int_for_bits<S, M + N>::type, T>::type;
     using type = StorageT;
 
+    static const bool IS_SIGNED = S;
+    static const size_t INTEGER_BITS = M;
+    static const size_t FRACTION_BITS = N;
+
     constexpr FixedPointQ(StorageT v = 0) :
         value_(v) {}
     constexpr FixedPointQ(float v) :
@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace particle {
+
+/**
+ * Hash map with a fixed capacity that never allocates memory.
+ *
+ * The entries are stored inline in an open-addressing table with linear probing. Removing an
+ * entry shifts the following entries of the same probe sequence back, so the table doesn't
+ * accumulate deleted slots and lookups stay short as long as the map is not close to full.
+ *
+ * Adding an entry to a full map fails. The iteration order is unspecified.
+ */
+template<typename KeyT, typename ValueT, int N, typename HashT = std::hash<KeyT>, typename EqualT = std::equal_to<KeyT>>
+class FlatMap {
+public:
+    typedef KeyT KeyType;
+    typedef ValueT ValueType;
+    typedef std::pair<const KeyT, ValueT> Entry;
+
+    static_assert(N > 0, "Capacity must be positive");
+
+    template<typename MapT, typename EntryT>
+    class IteratorBase {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef EntryT value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef EntryT* pointer;
+        typedef EntryT& reference;
+
+        EntryT& operator*() const {
+            return map_->entry(index_);
+        }
+
+        EntryT* operator->() const {
+            return &map_->entry(index_);
+        }
+
+        IteratorBase& operator++() {
+            index_ = map_->nextUsed(index_ + 1);
+            return *this;
+        }
+
+        IteratorBase operator++(int) {
+            IteratorBase it(*this);
+            ++(*this);
+            return it;
+        }
+
+        bool operator==(const IteratorBase& it) const {
+            return index_ == it.index_;
+        }
+
+        bool operator!=(const IteratorBase& it) const {
+            return index_ != it.index_;
+        }
+
+    private:
+        MapT* map_;
+        int index_;
+
+        IteratorBase(MapT* map, int index) :
+                map_(map),
+                index_(index) {
+        }
+
+        friend class FlatMap;
+    };
+
+    typedef IteratorBase<FlatMap, Entry> Iterator;
+    typedef IteratorBase<const FlatMap, const Entry> ConstIterator;
+
+    FlatMap() :
+            used_(),
+            size_(0) {
+    }
+
+    FlatMap(std::initializer_list<std::pair<KeyT, ValueT>> entries) : FlatMap() {
+        for (const auto& e: entries) {
+            set(e.first, e.second);
+        }
+    }
+
+    FlatMap(const FlatMap& map) : FlatMap() {
+        copy(map);
+    }
+
+    ~FlatMap() {
+        clear();
+    }
+
+    /**
+     * Adds an entry or replaces the value of an existing entry.
+     *
+     * @return `false` if the map is full.
+     */
+    bool set(const KeyT& key, ValueT value) {
+        const int i = findIndex(key);
+        if (i >= 0) {
+            entry(i).second = std::move(value);
+            return true;
+        }
+        if (size_ >= N) {
+            return false;
+        }
+        int j = home(key);
+        while (used_[j]) {
+            j = next(j);
+        }
+        new(&slots_[j]) Entry(key, std::move(value));
+        used_[j] = true;
+        ++size_;
+        return true;
+    }
+
+    /**
+     * Returns a pointer to the value of an entry, or `nullptr` if the map doesn't have the key.
+     */
+    ValueT* find(const KeyT& key) {
+        const int i = findIndex(key);
+        return (i >= 0) ? &entry(i).second : nullptr;
+    }
+
+    const ValueT* find(const KeyT& key) const {
+        const int i = findIndex(key);
+        return (i >= 0) ? &entry(i).second : nullptr;
+    }
+
+    ValueT get(const KeyT& key) const {
+        return get(key, ValueT());
+    }
+
+    ValueT get(const KeyT& key, const ValueT& defaultValue) const {
+        const ValueT* v = find(key);
+        return v ? *v : defaultValue;
+    }
+
+    bool has(const KeyT& key) const {
+        return findIndex(key) >= 0;
+    }
+
+    /**
+     * Removes an entry.
+     *
+     * Removing an entry invalidates the iterators.
+     *
+     * @return `false` if the map doesn't have the key.
+     */
+    bool remove(const KeyT& key) {
+        int i = findIndex(key);
+        if (i < 0) {
+            return false;
+        }
+        destroy(i);
+        --size_;
+        // Shift back the entries that can't be reached anymore because of the new empty slot
+        for (int j = next(i); used_[j]; j = next(j)) {
+            const int h = home(entry(j).first);
+            const bool reachable = (i <= j) ? (h > i && h <= j) : (h > i || h <= j);
+            if (reachable) {
+                continue;
+            }
+            new(&slots_[i]) Entry(std::move(entry(j)));
+            used_[i] = true;
+            destroy(j);
+            i = j;
+        }
+        return true;
+    }
+
+    void clear() {
+        for (int i = 0; i < N; ++i) {
+            if (used_[i]) {
+                destroy(i);
+            }
+        }
+        size_ = 0;
+    }
+
+    int size() const {
+        return size_;
+    }
+
+    int capacity() const {
+        return N;
+    }
+
+    bool isEmpty() const {
+        return size_ == 0;
+    }
+
+    bool isFull() const {
+        return size_ == N;
+    }
+
+    Iterator begin() {
+        return Iterator(this, nextUsed(0));
+    }
+
+    ConstIterator begin() const {
+        return ConstIterator(this, nextUsed(0));
+    }
+
+    Iterator end() {
+        return Iterator(this, N);
+    }
+
+    ConstIterator end() const {
+        return ConstIterator(this, N);
+    }
+
+    FlatMap& operator=(const FlatMap& map) {
+        if (this != &map) {
+            clear();
+            copy(map);
+        }
+        return *this;
+    }
+
+private:
+    typename std::aligned_storage<sizeof(Entry), alignof(Entry)>::type slots_[N];
+    bool used_[N];
+    int size_;
+
+    Entry& entry(int i) {
+        return *reinterpret_cast<Entry*>(&slots_[i]);
+    }
+
+    const Entry& entry(int i) const {
+        return *reinterpret_cast<const Entry*>(&slots_[i]);
+    }
+
+    int findIndex(const KeyT& key) const {
+        int i = home(key);
+        for (int n = 0; n < N && used_[i]; ++n, i = next(i)) {
+            if (EqualT()(entry(i).first, key)) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    int nextUsed(int i) const {
+        while (i < N && !used_[i]) {
+            ++i;
+        }
+        return i;
+    }
+
+    void destroy(int i) {
+        entry(i).~Entry();
+        used_[i] = false;
+    }
+
+    void copy(const FlatMap& map) {
+        // Same capacity and hash, so the entries can keep their slots
+        for (int i = 0; i < N; ++i) {
+            if (map.used_[i]) {
+                new(&slots_[i]) Entry(map.entry(i));
+                used_[i] = true;
+            }
+        }
+        size_ = map.size_;
+    }
+
+    static int home(const KeyT& key) {
+        return (size_t)HashT()(key) % N;
+    }
+
+    static int next(int i) {
+        return (i + 1 < N) ? i + 1 : 0;
+    }
+};
+
+} // particle
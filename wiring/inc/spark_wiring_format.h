@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+
+namespace particle {
+
+/**
+ * Callback receiving the formatted output.
+ *
+ * @param data Output data. The data is not null-terminated.
+ * @param size Size of the data.
+ * @param ctx User context.
+ */
+typedef void (*FormatOutputCallback)(const char* data, size_t size, void* ctx);
+
+/**
+ * Formats a string in the `printf()` style and passes the output to a callback in chunks.
+ *
+ * Unlike `vsnprintf()`, this function doesn't need the output to fit into a buffer. Integers,
+ * strings and most floating point conversions are formatted without going through the C library.
+ * The output of the floating point conversions is correctly rounded and matches the C library.
+ * The `%a` conversion and values that can't be converted using 64-bit integer arithmetic are
+ * formatted with `snprintf()`.
+ *
+ * @param callback Output callback.
+ * @param ctx User context passed to the callback.
+ * @param fmt Format string.
+ * @param args Arguments.
+ * @return Number of characters produced.
+ */
+size_t vformatTo(FormatOutputCallback callback, void* ctx, const char* fmt, va_list args);
+
+/**
+ * Formats a string in the `printf()` style and passes the output to a callback in chunks.
+ *
+ * @see `vformatTo()`
+ */
+size_t formatTo(FormatOutputCallback callback, void* ctx, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+
+} // namespace particle
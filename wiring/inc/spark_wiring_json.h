@@ -25,13 +25,59 @@
 
 #include <cstring>
 #include <memory>
+#include <utility>
+
+namespace particle {
+
+class SimpleAllocator;
+
+} // namespace particle
 
 namespace spark {
 
 namespace detail {
 
 struct JSONData; // Parsed JSON data
-typedef std::shared_ptr<JSONData> JSONDataPtr;
+
+// Reference-counted pointer to the parsed JSON data. Unlike std::shared_ptr, it doesn't require a
+// separately allocated control block, so that all of the data can be allocated with a custom
+// allocator
+class JSONDataPtr {
+public:
+    JSONDataPtr() :
+            d_(nullptr) {
+    }
+
+    explicit JSONDataPtr(JSONData* d); // Takes ownership of the data
+    JSONDataPtr(const JSONDataPtr& ptr);
+
+    JSONDataPtr(JSONDataPtr&& ptr) :
+            d_(ptr.d_) {
+        ptr.d_ = nullptr;
+    }
+
+    ~JSONDataPtr();
+
+    JSONData* get() const {
+        return d_;
+    }
+
+    JSONData* operator->() const {
+        return d_;
+    }
+
+    explicit operator bool() const {
+        return d_;
+    }
+
+    JSONDataPtr& operator=(JSONDataPtr ptr) {
+        std::swap(d_, ptr.d_);
+        return *this;
+    }
+
+private:
+    JSONData* d_;
+};
 
 } // namespace spark::detail
 
@@ -74,13 +120,21 @@ public:
     static JSONValue parseCopy(const char *json, size_t size);
     static JSONValue parseCopy(const char *json);
 
+    // These methods allocate all memory needed for the parsed document, including a copy of the
+    // data if it's made, using the specified allocator, which needs to remain valid for as long
+    // as any of the values referring to the document exist
+    static JSONValue parse(char *json, size_t size, particle::SimpleAllocator* alloc);
+    static JSONValue parseCopy(const char *json, size_t size, particle::SimpleAllocator* alloc);
+
 private:
     detail::JSONDataPtr d_;
     const jsmntok_t *t_; // Token representing this value
 
     JSONValue(const jsmntok_t *token, detail::JSONDataPtr data);
 
-    static bool tokenize(const char *json, size_t size, jsmntok_t **tokens, size_t *count);
+    static JSONValue parse(char *json, size_t size, bool copy, particle::SimpleAllocator* alloc);
+    static bool tokenize(const char *json, size_t size, jsmntok_t **tokens, size_t *count,
+            particle::SimpleAllocator* alloc);
     static bool stringize(jsmntok_t *tokens, size_t count, char *json);
     static bool unescape(jsmntok_t *token, char *json);
 
@@ -213,6 +267,24 @@ private:
     Print &strm_;
 };
 
+// Stream writer that collects the output in a staging buffer and passes it to the stream in
+// larger chunks. The buffered data is written to the stream by flush() or when the writer is
+// destroyed
+class JSONBufferedStreamWriter: public JSONStreamWriter {
+public:
+    JSONBufferedStreamWriter(Print &stream, char *buf, size_t size);
+    ~JSONBufferedStreamWriter();
+
+    void flush();
+
+protected:
+    virtual void write(const char *data, size_t size) override;
+
+private:
+    char *buf_;
+    size_t bufSize_, n_;
+};
+
 class JSONBufferWriter: public JSONWriter {
 public:
     JSONBufferWriter(char *buf, size_t size);
@@ -231,6 +303,79 @@ private:
     size_t bufSize_, n_;
 };
 
+// Abstract handler of events generated by JSONStreamParser. Returning false from any of the handler
+// methods stops parsing
+class JSONHandler {
+public:
+    virtual ~JSONHandler() = default;
+
+    virtual bool beginArray();
+    virtual bool endArray();
+    virtual bool beginObject();
+    virtual bool endObject();
+    virtual bool name(const char *name, size_t size);
+    virtual bool value(bool val);
+    virtual bool value(const char *val, size_t size); // String value
+    virtual bool number(const char *val, size_t size); // Number value in its textual form
+    virtual bool nullValue();
+};
+
+// Incremental JSON parser. Unlike JSONValue::parse(), this parser doesn't allocate memory: the document
+// can be passed to the parser in chunks of arbitrary size, and parsed elements are reported to the handler
+// as soon as they are complete. Names, strings and numbers are passed to the handler as null-terminated
+// strings stored in the buffer provided by the caller; any such element that doesn't fit in the buffer
+// is treated as an error
+class JSONStreamParser {
+public:
+    static const unsigned MAX_DEPTH = 32; // Maximum nesting level of arrays and objects
+
+    JSONStreamParser(JSONHandler *handler, char *buf, size_t size);
+
+    bool parse(const char *data, size_t size);
+    bool parse(const char *str);
+    bool finish(); // Signals the end of the document
+    void reset();
+
+    bool hasError() const;
+
+private:
+    enum State {
+        VALUE, // Expecting a value
+        FIRST_ELEMENT, // Expecting first element of an array or end of the array
+        FIRST_NAME, // Expecting first property of an object or end of the object
+        NAME, // Expecting name of an object's property
+        COLON, // Expecting name separator
+        NEXT, // Expecting value separator or end of a compound value
+        STRING, // Parsing string
+        STRING_ESCAPE, // Parsing escaped character
+        STRING_UNICODE, // Parsing escaped Unicode character
+        LITERAL, // Parsing number or literal name
+        ERROR
+    };
+
+    JSONHandler *handler_;
+    char *buf_;
+    size_t bufSize_, n_;
+    uint32_t objects_; // Bit set of object nesting levels
+    uint32_t code_; // Escaped UTF-16 code unit
+    uint16_t highSurrogate_;
+    uint8_t digits_;
+    uint8_t depth_;
+    State state_;
+    bool name_;
+
+    bool process(char c);
+    bool beginValue(char c);
+    bool endCompound(bool object);
+    bool endString();
+    bool endLiteral();
+    bool appendCodeUnit();
+    bool appendCodePoint(uint32_t c);
+    bool appendHighSurrogate();
+    bool append(char c);
+    bool inObject() const;
+};
+
 bool operator==(const char *str1, const JSONString &str2);
 bool operator!=(const char *str1, const JSONString &str2);
 bool operator==(const String &str1, const JSONString &str2);
@@ -406,6 +551,18 @@ inline void spark::JSONStreamWriter::write(const char *data, size_t size) {
     strm_.write((const uint8_t*)data, size);
 }
 
+// spark::JSONBufferedStreamWriter
+inline spark::JSONBufferedStreamWriter::JSONBufferedStreamWriter(Print &stream, char *buf, size_t size) :
+        JSONStreamWriter(stream),
+        buf_(buf),
+        bufSize_(size),
+        n_(0) {
+}
+
+inline spark::JSONBufferedStreamWriter::~JSONBufferedStreamWriter() {
+    flush();
+}
+
 // spark::JSONBufferWriter
 inline spark::JSONBufferWriter::JSONBufferWriter(char *buf, size_t size) :
         buf_(buf),
@@ -425,6 +582,59 @@ inline size_t spark::JSONBufferWriter::dataSize() const {
     return n_;
 }
 
+// spark::JSONHandler
+inline bool spark::JSONHandler::beginArray() {
+    return true;
+}
+
+inline bool spark::JSONHandler::endArray() {
+    return true;
+}
+
+inline bool spark::JSONHandler::beginObject() {
+    return true;
+}
+
+inline bool spark::JSONHandler::endObject() {
+    return true;
+}
+
+inline bool spark::JSONHandler::name(const char *name, size_t size) {
+    return true;
+}
+
+inline bool spark::JSONHandler::value(bool val) {
+    return true;
+}
+
+inline bool spark::JSONHandler::value(const char *val, size_t size) {
+    return true;
+}
+
+inline bool spark::JSONHandler::number(const char *val, size_t size) {
+    return true;
+}
+
+inline bool spark::JSONHandler::nullValue() {
+    return true;
+}
+
+// spark::JSONStreamParser
+inline spark::JSONStreamParser::JSONStreamParser(JSONHandler *handler, char *buf, size_t size) :
+        handler_(handler),
+        buf_(buf),
+        bufSize_(size) {
+    reset();
+}
+
+inline bool spark::JSONStreamParser::parse(const char *str) {
+    return parse(str, strlen(str));
+}
+
+inline bool spark::JSONStreamParser::hasError() const {
+    return state_ == ERROR;
+}
+
 // spark::
 inline bool spark::operator==(const char *str1, const JSONString &str2) {
     return str2 == str1;
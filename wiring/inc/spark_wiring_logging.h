@@ -51,6 +51,9 @@ public:
 
     LogLevel level() const;
     LogLevel level(const char *category) const;
+    LogLevel minLevel() const;
+
+    bool enabled(LogLevel level, const char *category) const;
 
     // This class in non-copyable
     LogFilter(const LogFilter&) = delete;
@@ -62,6 +65,8 @@ private:
     Vector<String> cats_; // Category filter strings
     Vector<Node> nodes_; // Lookup table
     LogLevel level_; // Default level
+    LogLevel minLevel_; // Lowest level enabled for any category
+    LogLevel maxLevel_; // Level above which all categories are enabled
 
     static int nodeIndex(const Vector<Node> &nodes, const char *name, size_t size, bool &found);
 };
@@ -116,6 +121,10 @@ public:
         \param category Category name.
     */
     LogLevel level(const char *category) const;
+    /*!
+        \brief Returns the lowest logging level enabled for any category.
+    */
+    LogLevel minLevel() const;
     /*!
         \brief Returns level name.
         \param level Logging level.
@@ -462,6 +471,9 @@ public:
             const JSONValue &params) override;
 
     static DefaultLogHandlerFactory* instance();
+
+private:
+    static LogHandler* createSyslogHandler(LogLevel level, LogCategoryFilters filters, const JSONValue &params);
 };
 
 // NOTE: This is an experimental API and is subject to change
@@ -563,6 +575,40 @@ public:
 
 #endif // Wiring_LogConfig
 
+#if PLATFORM_THREADING
+
+    /*!
+        \brief Enables asynchronous logging.
+
+        In asynchronous mode, log messages are copied to a ring buffer and passed to the registered
+        handlers by a low-priority thread, so that the calling thread doesn't have to wait until the
+        handlers have formatted and written the messages. Messages that don't fit in the buffer are
+        dropped.
+
+        \param bufferSize Buffer size in bytes. Must be a power of two. The buffer is allocated when
+               asynchronous logging is enabled for the first time and is never freed.
+
+        \return 0 on success, or a negative result code.
+    */
+    int enableAsyncMode(size_t bufferSize = 4096);
+    /*!
+        \brief Disables asynchronous logging.
+
+        The messages that are still in the buffer are passed to the handlers before this method
+        returns.
+    */
+    void disableAsyncMode();
+    /*!
+        \brief Returns `true` if asynchronous logging is enabled.
+    */
+    bool isAsyncMode() const;
+    /*!
+        \brief Returns the number of messages dropped because the buffer was full.
+    */
+    unsigned droppedMessageCount() const;
+
+#endif // PLATFORM_THREADING
+
     /*!
         \brief Returns log manager's instance.
     */
@@ -586,7 +632,10 @@ private:
 #endif
 
 #if PLATFORM_THREADING
+    struct AsyncOutput;
+
     RecursiveMutex mutex_; // TODO: Use read-write lock?
+    AsyncOutput *async_; // Allocated on demand
 #endif
 
     // This class can be instantiated only via instance() method
@@ -597,6 +646,8 @@ private:
     void destroyFactoryHandlers();
 #endif
 
+    void handlersChanged();
+
     static void setSystemCallbacks();
     static void resetSystemCallbacks();
 
@@ -605,6 +656,11 @@ private:
     static void logWrite(const char *data, size_t size, int level, const char *category, void *reserved);
     static int logEnabled(int level, const char *category, void *reserved);
 
+    int minLevel(const char *category) const;
+#if PLATFORM_THREADING
+    AsyncOutput* asyncOutput() const;
+#endif
+
     bool isActive() const;
     void setActive(bool output_active);
 };
@@ -632,6 +688,22 @@ inline LogLevel spark::detail::LogFilter::level() const {
     return level_;
 }
 
+inline LogLevel spark::detail::LogFilter::minLevel() const {
+    return minLevel_;
+}
+
+inline bool spark::detail::LogFilter::enabled(LogLevel level, const char *category) const {
+    // The category filters only need to be looked up for the levels that are enabled for some
+    // categories but not for others
+    if (level < minLevel_) {
+        return false;
+    }
+    if (level >= maxLevel_) {
+        return true;
+    }
+    return level >= this->level(category);
+}
+
 // spark::LogCategoryFilter
 inline spark::LogCategoryFilter::LogCategoryFilter(String category, LogLevel level) :
         cat_(category),
@@ -673,18 +745,22 @@ inline LogLevel spark::LogHandler::level(const char *category) const {
     return filter_.level(category);
 }
 
+inline LogLevel spark::LogHandler::minLevel() const {
+    return filter_.minLevel();
+}
+
 inline const char* spark::LogHandler::levelName(LogLevel level) {
     return log_level_name(level, nullptr);
 }
 
 inline void spark::LogHandler::message(const char *msg, LogLevel level, const char *category, const LogAttributes &attr) {
-    if (level >= filter_.level(category)) {
+    if (filter_.enabled(level, category)) {
         logMessage(msg, level, category, attr);
     }
 }
 
 inline void spark::LogHandler::write(const char *data, size_t size, LogLevel level, const char *category) {
-    if (level >= filter_.level(category)) {
+    if (filter_.enabled(level, category)) {
         write(data, size);
     }
 }
@@ -28,6 +28,7 @@
 #include "spark_wiring_signal.h"
 #include "system_task.h"
 #include "events.h"
+#include "event_filter_index.h"
 #include "system_error.h"
 #include "check.h"
 #include "ifapi.h"
@@ -36,6 +37,7 @@
 #include "scope_guard.h"
 
 #include "spark_wiring_thread.h"
+#include "spark_wiring_mesh_codec.h"
 
 namespace spark {
 
@@ -81,7 +83,15 @@ public:
 
 class MeshPublish {
 public:
-    MeshPublish() : exit_(false) {
+    MeshPublish() :
+            batchWriter_(nullptr, 0),
+            batchWindow_(0),
+            batchTime_(0),
+            messageId_(0),
+            requestId_(0),
+            ackSemaphore_(nullptr),
+            ackPending_(false),
+            exit_(false) {
         // System thread gets blocked while connecting to cloud, while it's connecting to it
         // RX packet buffer pool may easily get exhausted, because nobody is reading the data
         // out of the socket. Create a separate thread here with a higher priority than application
@@ -92,16 +102,59 @@ public:
 
     int subscribe(const char* prefix, EventHandler handler);
 
+    /**
+     * Sends an event to a single node and waits until the node acknowledges it.
+     *
+     * Unlike `publish()`, the event is not flooded across the mesh. It's sent as a confirmable
+     * CoAP request over the Thread interface and retransmitted with an exponential backoff until
+     * it's acknowledged. The receiving node passes the event to the handlers registered with
+     * `subscribe()`. Only one such event is in flight at a time.
+     *
+     * This method blocks the calling thread and should not be called from an event handler when
+     * the system thread is disabled.
+     *
+     * @param addr Mesh-local address of the node.
+     * @param topic Event name.
+     * @param data Event data.
+     * @return 0 on success, `SYSTEM_ERROR_TIMEOUT` if the event was not acknowledged, or another
+     *         negative result code in case of an error.
+     */
+    int publishTo(const IPAddress& addr, const char* topic, const char* data = nullptr);
+
+    /**
+     * Sets the time for which published events are collected before they are sent.
+     *
+     * Events published within the batch window are sent in a single datagram. Setting the window
+     * to 0 disables batching, which is the default.
+     *
+     * @param ms Batch window in milliseconds.
+     * @return 0 on success, or a negative result code in case of an error.
+     */
+    int setBatchWindow(system_tick_t ms);
+
+    /**
+     * Sends the events collected in the current batch window.
+     *
+     * @return 0 on success, or a negative result code in case of an error.
+     */
+    int flush();
+
     // This shouldn't be public, but we use it in tests
     int uninitializeUdp();
 
     static const uint16_t PORT = 36969;
     static constexpr const char* MULTICAST_ADDR = "ff03::1:1001";
     static const uint16_t MAX_PACKET_LEN = 1232;
+    // Events that don't fit into a single datagram are sent in fragments
+    static const size_t MAX_FRAGMENT_LEN = MAX_PACKET_LEN - particle::mesh::FRAGMENT_HEADER_SIZE;
+    static const size_t MAX_MESSAGE_LEN = MAX_FRAGMENT_LEN * particle::mesh::MessageReassembler::MAX_FRAGMENT_COUNT;
 
 private:
     class Subscriptions {
-        FilteringEventHandler event_handlers[5];
+        static const size_t MAX_HANDLERS = 5;
+
+        FilteringEventHandler event_handlers[MAX_HANDLERS];
+        particle::EventFilterIndex<MAX_HANDLERS> filter_index;
 
     protected:
         /**
@@ -125,12 +178,31 @@ private:
     static int fetchMulticastAddress(IPAddress& mcastAddr);
     int initializeUdp();
     int poll();
+    int sendEvent(const char* topic, const char* data);
+    int sendMessage(const char* msg, size_t size);
+    int handlePacket(const char* buffer, size_t len);
+    int handleCoapMessage(const char* buffer, size_t len);
+    system_tick_t pollTimeout();
+
+    static void dispatchEvent(const char* topic, const char* data, void* ctx);
 
     std::unique_ptr<UDP> udp_;
     Subscriptions subscriptions_;
     std::unique_ptr<Thread> thread_;
     RecursiveMutex mutex_;
     std::unique_ptr<uint8_t[]> buffer_;
+    std::unique_ptr<char[]> batchBuffer_;
+    particle::mesh::MessageWriter batchWriter_;
+    std::unique_ptr<particle::mesh::MessageReassembler> reassembler_;
+    system_tick_t batchWindow_;
+    system_tick_t batchTime_;
+    uint16_t messageId_;
+    particle::mesh::DuplicateFilter duplicates_;
+    Mutex requestMutex_;
+    IPAddress requestAddr_;
+    uint16_t requestId_;
+    os_semaphore_t ackSemaphore_;
+    bool ackPending_;
     std::atomic_bool exit_;
 };
 
@@ -182,6 +254,46 @@ public:
 
     int selectAntenna(MeshAntennaType antenna);
 
+    /**
+     * Configures the device as a Sleepy End Device.
+     *
+     * A Sleepy End Device keeps its radio off between the data polls of its parent, and stays
+     * attached to the parent while the device is in the STOP or ULTRA_LOW_POWER sleep mode. The
+     * configuration is persistent.
+     *
+     * @param pollPeriod Period of the data polls in milliseconds.
+     * @param childTimeout Time in seconds after which the parent forgets this device if it hasn't
+     *        polled the parent. This should be longer than the device is expected to sleep.
+     * @return 0 on success, or a negative result code in case of an error.
+     */
+    int setSleepyEndDevice(system_tick_t pollPeriod, uint32_t childTimeout = 240) {
+        mesh_sleepy_config conf = {};
+        conf.size = sizeof(conf);
+        conf.poll_period = pollPeriod;
+        conf.child_timeout = childTimeout;
+        return mesh_set_sleepy_config(&conf, nullptr);
+    }
+
+    /**
+     * Configures the device as a router-eligible device that keeps its radio on.
+     *
+     * @return 0 on success, or a negative result code in case of an error.
+     */
+    int disableSleepyEndDevice() {
+        mesh_sleepy_config conf = {};
+        conf.size = sizeof(conf);
+        return mesh_set_sleepy_config(&conf, nullptr);
+    }
+
+    /**
+     * Returns `true` if the device is configured as a Sleepy End Device.
+     */
+    bool isSleepyEndDevice() {
+        mesh_sleepy_config conf = {};
+        conf.size = sizeof(conf);
+        return mesh_get_sleepy_config(&conf, nullptr) == 0 && conf.poll_period > 0;
+    }
+
     // There are multiple IPv6 addresses, here we are only reporting ML-EID (Mesh-Local EID)
     IPAddress localIP();
 };
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "system_tick_hal.h"
+#include "coap.h"
+
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace particle {
+
+/*
+ * Encoding of the mesh publish messages.
+ *
+ * Version 0 datagrams contain a single event:
+ *
+ *   0x00 <topic> '\0' [<data> '\0']
+ *
+ * Version 1 datagrams contain a message, or a fragment of a message if it doesn't fit into a
+ * single datagram:
+ *
+ *   0x01 <flags> [<message ID (2 bytes, big-endian)> <fragment index> <fragment count>] <payload>
+ *
+ * A message is a sequence of events:
+ *
+ *   <topic> '\0' <data> '\0' ...
+ *
+ * A topic that has already been used by an earlier event in the same message is replaced by
+ * 0x01 and the index of that event.
+ *
+ * Events sent to a single node are encoded as confirmable CoAP POST requests with an "E" URI path
+ * and the event as a message in the payload. The receiver acknowledges them with an empty ACK.
+ * The first byte of a CoAP message always has bit 6 set, which tells it apart from the above
+ * datagrams.
+ */
+namespace mesh {
+
+const uint8_t VERSION_SINGLE = 0;
+const uint8_t VERSION_MESSAGE = 1;
+
+const uint8_t FLAG_FRAGMENT = 0x01;
+
+const size_t MESSAGE_HEADER_SIZE = 2;
+const size_t FRAGMENT_HEADER_SIZE = MESSAGE_HEADER_SIZE + 4;
+
+const char TOPIC_REF = 0x01;
+
+/**
+ * Callback invoked for every event of a message.
+ */
+typedef void (*EventCallback)(const char* topic, const char* data, void* ctx);
+
+/**
+ * Parses a message.
+ *
+ * @return 0 on success, or `SYSTEM_ERROR_BAD_DATA` if the message is malformed. The callback may
+ *         have been invoked for some of the events of a malformed message.
+ */
+int parseMessage(const char* msg, size_t size, EventCallback callback, void* ctx);
+
+/**
+ * Writes events to a message buffer.
+ */
+class MessageWriter {
+public:
+    /**
+     * Maximum number of events in a message.
+     */
+    static const unsigned MAX_EVENT_COUNT = 255;
+
+    MessageWriter(char* buf, size_t size);
+
+    /**
+     * Appends an event.
+     *
+     * @return `true` on success, or `false` if the event doesn't fit into the buffer.
+     */
+    bool append(const char* topic, const char* data);
+
+    /**
+     * Returns the size of an event when it's the only event in a message.
+     */
+    static size_t eventSize(const char* topic, const char* data);
+
+    void reset();
+
+    const char* data() const {
+        return buf_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    unsigned count() const {
+        return count_;
+    }
+
+private:
+    static const unsigned MAX_TOPIC_REFS = 8;
+
+    struct TopicRef {
+        size_t offset;
+        uint8_t index;
+    };
+
+    TopicRef topics_[MAX_TOPIC_REFS];
+    char* buf_;
+    size_t capacity_;
+    size_t size_;
+    unsigned count_;
+    unsigned topicCount_;
+};
+
+/**
+ * Address of the sender of a fragmented or confirmable message.
+ */
+struct Source {
+    uint8_t addr[16];
+    uint16_t port;
+};
+
+/**
+ * Initial timeout for acknowledgement of a confirmable message (RFC 7252, 4.8).
+ */
+const system_tick_t COAP_ACK_TIMEOUT = 2000;
+
+/**
+ * Maximum number of retransmissions of a confirmable message.
+ */
+const unsigned COAP_MAX_RETRANSMIT = 4;
+
+/**
+ * Size of the header of a CoAP message sent without a token.
+ */
+const size_t COAP_HEADER_SIZE = 4;
+
+/**
+ * Parsed CoAP message.
+ */
+struct CoapMessage {
+    protocol::CoAPType::Enum type;
+    protocol::CoAPCode::Enum code;
+    uint16_t id;
+    const char* payload;
+    size_t payloadSize;
+};
+
+/**
+ * Returns `true` if a datagram contains a CoAP message.
+ */
+inline bool isCoapMessage(const char* buf, size_t size) {
+    return size > 0 && ((uint8_t)buf[0] >> 6) == 1;
+}
+
+/**
+ * Parses a CoAP message. Options are validated but otherwise ignored.
+ *
+ * @return 0 on success, or `SYSTEM_ERROR_BAD_DATA` if the message is malformed.
+ */
+int parseCoapMessage(const char* buf, size_t size, CoapMessage* msg);
+
+/**
+ * Writes the header and options of an event request.
+ *
+ * @return Number of bytes written, or `SYSTEM_ERROR_TOO_LARGE` if the buffer is too small. The
+ *         event itself is written after that as a message.
+ */
+int writeCoapEventRequest(char* buf, size_t size, uint16_t id);
+
+/**
+ * Writes an empty acknowledgement.
+ *
+ * @return Number of bytes written, or `SYSTEM_ERROR_TOO_LARGE` if the buffer is too small.
+ */
+int writeCoapAck(char* buf, size_t size, uint16_t id);
+
+/**
+ * Returns the time to wait for an acknowledgement before retransmitting a confirmable message.
+ *
+ * @param attempt Number of retransmissions done so far.
+ */
+system_tick_t coapRetransmitTimeout(unsigned attempt);
+
+/**
+ * Detects duplicate confirmable messages.
+ */
+class DuplicateFilter {
+public:
+    /**
+     * Time for which a message ID is remembered. This should be larger than the time a sender
+     * keeps retransmitting a message.
+     */
+    static const system_tick_t LIFETIME = 60000;
+
+    DuplicateFilter();
+
+    /**
+     * Checks if a message has been seen recently and remembers its ID.
+     *
+     * @return `true` if the message is a duplicate.
+     */
+    bool check(const Source& src, uint16_t id, system_tick_t now);
+
+private:
+    static const unsigned ENTRY_COUNT = 8;
+
+    struct Entry {
+        Source src;
+        system_tick_t time;
+        uint16_t id;
+        bool valid;
+    };
+
+    Entry entries_[ENTRY_COUNT];
+};
+
+/**
+ * Reassembles fragmented messages.
+ */
+class MessageReassembler {
+public:
+    /**
+     * Maximum number of fragments in a message.
+     */
+    static const unsigned MAX_FRAGMENT_COUNT = 8;
+
+    /**
+     * Time after which an incomplete message is discarded.
+     */
+    static const system_tick_t TIMEOUT = 5000;
+
+    /**
+     * Constructor.
+     *
+     * @param fragmentSize Payload size of all fragments but the last one.
+     */
+    explicit MessageReassembler(size_t fragmentSize);
+
+    /**
+     * Adds a fragment.
+     *
+     * @param src Sender address.
+     * @param id Message ID.
+     * @param index Fragment index.
+     * @param count Number of fragments.
+     * @param data Fragment payload.
+     * @param size Payload size.
+     * @param now Current time.
+     * @param[out] msg Reassembled message. The message is valid until the next call to this method.
+     * @param[out] msgSize Size of the message.
+     * @return 1 if the message is complete, 0 if more fragments are needed, or an error code.
+     */
+    int add(const Source& src, uint16_t id, unsigned index, unsigned count, const char* data, size_t size,
+            system_tick_t now, const char** msg, size_t* msgSize);
+
+private:
+    static const unsigned SLOT_COUNT = 2;
+
+    struct Slot {
+        std::unique_ptr<char[]> buf;
+        Source src;
+        system_tick_t time;
+        size_t size;
+        uint16_t id;
+        uint8_t count;
+        uint8_t received; // Bitmask of the received fragments
+    };
+
+    Slot slots_[SLOT_COUNT];
+    std::unique_ptr<char[]> done_; // Last complete message
+    size_t fragmentSize_;
+};
+
+} // namespace mesh
+
+} // namespace particle
@@ -0,0 +1,510 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "spark_wiring_vector.h"
+
+#include <initializer_list>
+#include <new>
+
+namespace particle {
+
+/**
+ * Allocator that never allocates.
+ */
+struct NoHeapAllocator {
+    static void* malloc(size_t /* size */) {
+        return nullptr;
+    }
+
+    static void free(void* /* ptr */) {
+    }
+};
+
+/**
+ * Vector with inline storage for a small number of elements.
+ *
+ * The first `N` elements are stored in the vector object itself, so a vector that never grows
+ * beyond `N` elements doesn't allocate any memory. Once the vector outgrows its inline storage,
+ * the elements are moved to a block allocated with `AllocatorT`, and the capacity of the block
+ * is doubled every time it needs to grow.
+ *
+ * The interface is compatible with `Vector`.
+ */
+template<typename T, int N, typename AllocatorT = spark::DefaultAllocator>
+class SmallVector {
+public:
+    typedef T ValueType;
+    typedef AllocatorT AllocatorType;
+
+    /**
+     * Number of elements stored inline.
+     */
+    static const int INLINE_CAPACITY = N;
+
+    static_assert(N > 0, "Inline capacity must be positive");
+
+    SmallVector() :
+            data_(inlineData()),
+            size_(0),
+            capacity_(N) {
+    }
+
+    explicit SmallVector(int n) : SmallVector() {
+        resize(n);
+    }
+
+    SmallVector(int n, const T& value) : SmallVector() {
+        append(n, value);
+    }
+
+    SmallVector(const T* values, int n) : SmallVector() {
+        append(values, n);
+    }
+
+    SmallVector(std::initializer_list<T> values) : SmallVector() {
+        if (reserve(values.size())) {
+            for (const T& v: values) {
+                new(data_ + size_) T(v);
+                ++size_;
+            }
+        }
+    }
+
+    SmallVector(const SmallVector& vector) : SmallVector() {
+        append(vector.data_, vector.size_);
+    }
+
+    SmallVector(SmallVector&& vector) : SmallVector() {
+        take(vector);
+    }
+
+    ~SmallVector() {
+        destruct(data_, data_ + size_);
+        freeData();
+    }
+
+    bool append(T value) {
+        return insert(size_, std::move(value));
+    }
+
+    bool append(int n, const T& value) {
+        return insert(size_, n, value);
+    }
+
+    bool append(const T* values, int n) {
+        return insert(size_, values, n);
+    }
+
+    bool append(const SmallVector& vector) {
+        return insert(size_, vector);
+    }
+
+    bool prepend(T value) {
+        return insert(0, std::move(value));
+    }
+
+    bool prepend(int n, const T& value) {
+        return insert(0, n, value);
+    }
+
+    bool prepend(const T* values, int n) {
+        return insert(0, values, n);
+    }
+
+    bool prepend(const SmallVector& vector) {
+        return insert(0, vector);
+    }
+
+    bool insert(int i, T value) {
+        if (!makeGap(i, 1)) {
+            return false;
+        }
+        new(data_ + i) T(std::move(value));
+        ++size_;
+        return true;
+    }
+
+    bool insert(int i, int n, const T& value) {
+        if (n <= 0) {
+            return true;
+        }
+        if (!makeGap(i, n)) {
+            return false;
+        }
+        for (T* p = data_ + i; p != data_ + i + n; ++p) {
+            new(p) T(value);
+        }
+        size_ += n;
+        return true;
+    }
+
+    bool insert(int i, const T* values, int n) {
+        if (n <= 0) {
+            return true;
+        }
+        if (!makeGap(i, n)) {
+            return false;
+        }
+        for (int j = 0; j < n; ++j) {
+            new(data_ + i + j) T(values[j]);
+        }
+        size_ += n;
+        return true;
+    }
+
+    bool insert(int i, const SmallVector& vector) {
+        return insert(i, vector.data_, vector.size_);
+    }
+
+    void removeAt(int i, int n = 1) {
+        if (n < 0 || i + n > size_) {
+            n = size_ - i;
+        }
+        T* const p = data_ + i;
+        destruct(p, p + n);
+        moveDown(p, p + n, data_ + size_);
+        size_ -= n;
+    }
+
+    bool removeOne(const T& value) {
+        const int i = indexOf(value);
+        if (i < 0) {
+            return false;
+        }
+        removeAt(i);
+        return true;
+    }
+
+    int removeAll(const T& value) {
+        int n = 0;
+        for (int i = 0; i < size_;) {
+            if (data_[i] == value) {
+                removeAt(i);
+                ++n;
+            } else {
+                ++i;
+            }
+        }
+        return n;
+    }
+
+    T takeFirst() {
+        return takeAt(0);
+    }
+
+    T takeLast() {
+        return takeAt(size_ - 1);
+    }
+
+    T takeAt(int i) {
+        T v(std::move(data_[i]));
+        removeAt(i);
+        return v;
+    }
+
+    T& first() {
+        return data_[0];
+    }
+
+    const T& first() const {
+        return data_[0];
+    }
+
+    T& last() {
+        return data_[size_ - 1];
+    }
+
+    const T& last() const {
+        return data_[size_ - 1];
+    }
+
+    T& at(int i) {
+        return data_[i];
+    }
+
+    const T& at(int i) const {
+        return data_[i];
+    }
+
+    int indexOf(const T& value, int i = 0) const {
+        for (; i < size_; ++i) {
+            if (data_[i] == value) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    int lastIndexOf(const T& value) const {
+        return lastIndexOf(value, size_ - 1);
+    }
+
+    int lastIndexOf(const T& value, int i) const {
+        for (; i >= 0; --i) {
+            if (data_[i] == value) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    bool contains(const T& value) const {
+        return indexOf(value) >= 0;
+    }
+
+    SmallVector& fill(const T& value) {
+        for (T* p = data_; p != data_ + size_; ++p) {
+            *p = value;
+        }
+        return *this;
+    }
+
+    bool resize(int n) {
+        if (n > size_) {
+            if (!reserve(n)) {
+                return false;
+            }
+            for (T* p = data_ + size_; p != data_ + n; ++p) {
+                new(p) T();
+            }
+            size_ = n;
+        } else if (n >= 0) {
+            destruct(data_ + n, data_ + size_);
+            size_ = n;
+        }
+        return true;
+    }
+
+    int size() const {
+        return size_;
+    }
+
+    bool isEmpty() const {
+        return size_ == 0;
+    }
+
+    bool reserve(int n) {
+        if (n > capacity_ && !realloc(n)) {
+            return false;
+        }
+        return true;
+    }
+
+    int capacity() const {
+        return capacity_;
+    }
+
+    /**
+     * Frees the allocated memory that is not used by the elements.
+     *
+     * The elements are moved back to the inline storage if they fit into it.
+     */
+    bool trimToSize() {
+        if (capacity_ > size_ && !isInline() && !realloc(size_)) {
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Returns `true` if the elements are stored inline.
+     */
+    bool isInline() const {
+        return data_ == inlineData();
+    }
+
+    void clear() {
+        destruct(data_, data_ + size_);
+        size_ = 0;
+    }
+
+    T* data() {
+        return data_;
+    }
+
+    const T* data() const {
+        return data_;
+    }
+
+    T* begin() {
+        return data_;
+    }
+
+    const T* begin() const {
+        return data_;
+    }
+
+    T* end() {
+        return data_ + size_;
+    }
+
+    const T* end() const {
+        return data_ + size_;
+    }
+
+    T& operator[](int i) {
+        return data_[i];
+    }
+
+    const T& operator[](int i) const {
+        return data_[i];
+    }
+
+    bool operator==(const SmallVector& vector) const {
+        if (size_ != vector.size_) {
+            return false;
+        }
+        for (int i = 0; i < size_; ++i) {
+            if (!(data_[i] == vector.data_[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool operator!=(const SmallVector& vector) const {
+        return !(*this == vector);
+    }
+
+    SmallVector& operator=(const SmallVector& vector) {
+        if (this != &vector) {
+            clear();
+            append(vector.data_, vector.size_);
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& vector) {
+        if (this != &vector) {
+            clear();
+            take(vector);
+        }
+        return *this;
+    }
+
+private:
+    T* data_;
+    int size_;
+    int capacity_;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type buf_[N];
+
+    T* inlineData() {
+        return reinterpret_cast<T*>(buf_);
+    }
+
+    const T* inlineData() const {
+        return reinterpret_cast<const T*>(buf_);
+    }
+
+    bool makeGap(int i, int n) {
+        if (size_ + n > capacity_) {
+            // Grow geometrically to avoid reallocating on every insertion
+            int c = capacity_ * 2;
+            if (c < size_ + n) {
+                c = size_ + n;
+            }
+            if (!realloc(c) && !realloc(size_ + n)) {
+                return false;
+            }
+        }
+        moveUp(data_ + i + n, data_ + i, data_ + size_);
+        return true;
+    }
+
+    bool realloc(int n) {
+        T* d = nullptr;
+        if (n <= N) {
+            if (isInline()) {
+                capacity_ = N;
+                return true;
+            }
+            d = inlineData();
+            n = N;
+        } else {
+            d = static_cast<T*>(AllocatorT::malloc(n * sizeof(T)));
+            if (!d) {
+                return false;
+            }
+        }
+        moveDown(d, data_, data_ + size_);
+        freeData();
+        data_ = d;
+        capacity_ = n;
+        return true;
+    }
+
+    void take(SmallVector& vector) {
+        if (vector.isInline()) {
+            // The inline capacity is the same, so there is always enough room
+            moveDown(data_, vector.data_, vector.data_ + vector.size_);
+        } else {
+            freeData();
+            data_ = vector.data_;
+            capacity_ = vector.capacity_;
+            vector.data_ = vector.inlineData();
+            vector.capacity_ = N;
+        }
+        size_ = vector.size_;
+        vector.size_ = 0;
+    }
+
+    void freeData() {
+        if (!isInline()) {
+            AllocatorT::free(data_);
+        }
+    }
+
+    // Moves elements to a lower address or to a different block
+    static void moveDown(T* dest, T* p, T* end) {
+        for (; p != end; ++p, ++dest) {
+            new(dest) T(std::move(*p));
+            p->~T();
+        }
+    }
+
+    // Moves elements to a higher address within the same block
+    static void moveUp(T* dest, T* p, T* end) {
+        if (dest == p) {
+            return;
+        }
+        dest += end - p;
+        while (end != p) {
+            --end;
+            --dest;
+            new(dest) T(std::move(*end));
+            end->~T();
+        }
+    }
+
+    static void destruct(T* p, T* end) {
+        for (; p != end; ++p) {
+            p->~T();
+        }
+    }
+};
+
+/**
+ * Vector with a fixed capacity that never allocates memory.
+ *
+ * Adding elements to a full vector fails.
+ */
+template<typename T, int N>
+using StaticVector = SmallVector<T, N, NoHeapAllocator>;
+
+} // particle
@@ -31,6 +31,7 @@
 #ifdef __cplusplus
 
 #include <stdarg.h>
+#include <string.h>
 #include "spark_wiring_print.h" // for HEX, DEC ... constants
 #include "spark_wiring_printable.h"
 
@@ -50,6 +51,7 @@ class __FlashStringHelper;
 // An inherited class for holding the result of a concatenation.  These
 // result objects are assumed to be writable by subsequent concatenations.
 class StringSumHelper;
+class StringBuilder;
 
 // The string class
 class String
@@ -200,10 +202,21 @@ public:
         static String format(const char* format, ...);
 
 protected:
+	// Strings of up to this length are stored in the String object itself.
+	// The inline buffer fills the object up to 32 bytes on 32-bit platforms
+	static const unsigned int INLINE_CAPACITY = 18;
+
+	enum Flag {
+		FLAG_INLINE_BUFFER = 0x01 // buffer points to inlineBuffer
+	};
+
+	// The first four fields keep their original layout: buffer always points
+	// to the string data, whether it's allocated on the heap or stored inline
 	char *buffer;	        // the actual char array
 	unsigned int capacity;  // the array length minus one (for the '\0')
 	unsigned int len;       // the String length (not counting the '\0')
-	unsigned char flags;    // unused, for future features
+	unsigned char flags;    // a combination of the Flag values
+	char inlineBuffer[INLINE_CAPACITY + 1]; // only accessed when FLAG_INLINE_BUFFER is set
 protected:
 	void init(void);
 	void invalidate(void);
@@ -219,6 +232,7 @@ protected:
 	#endif
 
         friend class StringPrintableHelper;
+        friend class StringBuilder;
 
 };
 
@@ -235,6 +249,96 @@ public:
 	StringSumHelper(unsigned long num) : String(num) {}
 };
 
+namespace particle {
+
+namespace detail {
+
+// A string operand of StringBuilder::append(). Numbers are converted to
+// text when the piece is constructed, so that the total length of all
+// operands is known before anything is appended
+class StringPiece
+{
+public:
+	StringPiece(const char *cstr) : data_(cstr ? cstr : ""), len_(cstr ? strlen(cstr) : 0) {}
+	StringPiece(const String &str) : data_(str.c_str() ? str.c_str() : ""), len_(str.length()) {}
+	StringPiece(char c) : data_(nullptr), len_(1) { buf_[0] = c; buf_[1] = 0; }
+	StringPiece(unsigned char num);
+	StringPiece(int num);
+	StringPiece(unsigned int num);
+	StringPiece(long num);
+	StringPiece(unsigned long num);
+	StringPiece(float num);
+	StringPiece(double num);
+
+	// Converted numbers are stored in the piece itself, which keeps the
+	// piece copyable
+	const char *data() const { return data_ ? data_ : buf_; }
+	unsigned int length() const { return len_; }
+
+private:
+	const char *data_;
+	unsigned int len_;
+	char buf_[34];
+};
+
+} // namespace detail
+
+} // namespace particle
+
+// Builds a string out of several operands with at most one reallocation per
+// append() call, unlike the a + b + c chains, which reallocate the buffer
+// once per operand:
+//
+//     String s = StringBuilder().append("temp=", temp, ", hum=", hum).toString();
+//
+// If memory allocation fails, the resulting string is invalid ("if (s)" is
+// false) and all subsequent appends are ignored until toString() is called.
+class StringBuilder
+{
+public:
+	explicit StringBuilder(unsigned int capacity = 0)
+	{
+		str_.reserve(capacity);
+	}
+
+	StringBuilder(StringBuilder &&builder) = default;
+	StringBuilder & operator = (StringBuilder &&builder) = default;
+
+	StringBuilder(const StringBuilder &) = delete;
+	StringBuilder & operator = (const StringBuilder &) = delete;
+
+	// Ensures that the buffer can hold a string of the given length without
+	// further reallocations
+	StringBuilder & reserve(unsigned int size)
+	{
+		if (str_.buffer && !str_.reserve(size)) str_.invalidate();
+		return *this;
+	}
+
+	template<typename... ArgsT>
+	StringBuilder & append(const ArgsT&... args)
+	{
+		const particle::detail::StringPiece pieces[] = { particle::detail::StringPiece(args)... };
+		return appendPieces(pieces, sizeof...(ArgsT));
+	}
+
+	StringBuilder & append() { return *this; }
+
+	template<typename T>
+	StringBuilder & operator << (const T &value) { return append(value); }
+
+	unsigned int length() const { return str_.length(); }
+	bool isValid() const { return str_.buffer; }
+
+	// Move the result out of the builder. The builder is left empty
+	String toString();
+
+private:
+	String str_;
+
+	StringBuilder & appendPieces(const particle::detail::StringPiece *pieces, unsigned int count);
+};
+
 #include <ostream>
 std::ostream& operator << ( std::ostream& os, const String& value );
 
@@ -604,6 +604,18 @@ public:
         return (hal_timer_millis(nullptr) / 1000);
     }
 
+    /**
+     * Sets the duration of an application loop iteration above which the `loop_overrun` system
+     * event is generated. Set to 0 to disable the event.
+     */
+    static int setLoopOverrunThreshold(system_tick_t ms) {
+        return system_set_loop_overrun_threshold(ms, nullptr);
+    }
+
+    static int setLoopOverrunThreshold(std::chrono::milliseconds ms) {
+        return setLoopOverrunThreshold(ms.count());
+    }
+
 #if HAL_PLATFORM_POWER_MANAGEMENT
     int setPowerConfiguration(const particle::SystemPowerConfiguration& conf) {
         return system_power_management_set_config(conf.config(), nullptr);
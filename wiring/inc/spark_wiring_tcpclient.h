@@ -33,6 +33,7 @@
 #include "socket_hal.h"
 
 #include <memory>
+#include <cstdint>
 
 #define TCPCLIENT_BUF_MAX_SIZE  128
 /* 30 seconds */
@@ -52,6 +53,18 @@ public:
     virtual size_t write(const uint8_t *buffer, size_t size);
     virtual size_t write(uint8_t, system_tick_t timeout);
     virtual size_t write(const uint8_t *buffer, size_t size, system_tick_t timeout);
+#if HAL_USE_SOCKET_HAL_POSIX && HAL_PLATFORM_FILESYSTEM
+    /**
+     * Sends the contents of a file from the filesystem without reading the whole file into RAM.
+     *
+     * @param path      Path to the file.
+     * @param offset    Offset in the file to start sending from.
+     * @param size      Maximum number of bytes to send. By default, the file is sent up to its end.
+     * @param timeout   Send timeout in milliseconds.
+     * @return Number of bytes sent.
+     */
+    size_t writeFile(const char* path, size_t offset = 0, size_t size = SIZE_MAX, system_tick_t timeout = SOCKET_WAIT_FOREVER);
+#endif // HAL_USE_SOCKET_HAL_POSIX && HAL_PLATFORM_FILESYSTEM
     virtual int available();
     virtual int read();
     virtual int read(uint8_t *buffer, size_t size);
@@ -64,6 +77,35 @@ public:
 
     virtual IPAddress remoteIP();
 
+    /**
+     * Sets the receive buffer used by this client.
+     *
+     * @param size      The size of the buffer. If 0, the default internal buffer of
+     *  TCPCLIENT_BUF_MAX_SIZE bytes is used.
+     * @param buffer    A pre-allocated buffer that should outlive the client. This is optional,
+     *  and if not specified the buffer is allocated dynamically.
+     * @return false if the buffer couldn't be allocated or is too small to hold the data
+     *  that has been received but not read yet.
+     */
+    bool setBuffer(size_t size, uint8_t* buffer = nullptr);
+
+    /**
+     * Provides access to the received data without copying it. The returned pointer is valid
+     * until any other method reading data from the client is called.
+     *
+     * @param data      Pointer to the received data that hasn't been read yet.
+     * @return Number of contiguous bytes available at `data`, or -1 if no data is available.
+     */
+    int peekData(const uint8_t** data);
+
+    /**
+     * Marks the data returned by {@link #peekData} as read.
+     *
+     * @param size      Number of bytes to consume.
+     * @return Number of bytes consumed.
+     */
+    size_t consume(size_t size);
+
     friend class TCPServer;
 
     using Print::write;
@@ -74,10 +116,13 @@ protected:
 private:
     struct Data {
         sock_handle_t sock;
-        uint8_t buffer[TCPCLIENT_BUF_MAX_SIZE];
-        uint16_t offset;
-        uint16_t total;
+        uint8_t* buffer;
+        size_t size;
+        size_t offset;
+        size_t total;
         IPAddress remoteIP;
+        std::unique_ptr<uint8_t[]> allocated;
+        uint8_t defaultBuffer[TCPCLIENT_BUF_MAX_SIZE];
 
         explicit Data(sock_handle_t sock);
         ~Data();
@@ -86,6 +131,7 @@ private:
     std::shared_ptr<Data> d_;
 
     inline int bufferCount();
+    int receive(uint8_t* buffer, size_t size);
 };
 
 #endif
@@ -27,6 +27,8 @@
 #if PLATFORM_THREADING
 
 #include "concurrent_hal.h"
+#include "spark_wiring_thread_stack.h"
+#include "system_error.h"
 #include <stddef.h>
 #include <mutex>
 #include <functional>
@@ -70,15 +72,19 @@ private:
         os_thread_t handle;
         os_thread_fn_t func;
         void* func_param;
+        size_t stack_size;
         volatile bool started;
         volatile bool exited;
+        bool pooled;
 
         Data() :
             handle(OS_THREAD_INVALID_HANDLE),
             func(nullptr),
             func_param(nullptr),
+            stack_size(0),
             started(false),
-            exited(false) {
+            exited(false),
+            pooled(false) {
         }
     };
 
@@ -100,6 +106,7 @@ public:
         }
         d_->func = function;
         d_->func_param = function_param;
+        d_->stack_size = stack_size;
         if (os_thread_create(&d_->handle, name, priority, &Thread::run, d_.get(), stack_size) != 0) {
             goto error;
         }
@@ -124,6 +131,7 @@ public:
         if (!d_->wrapper) {
             goto error;
         }
+        d_->stack_size = stack_size;
         if (os_thread_create(&d_->handle, name, priority, &Thread::run, d_.get(), stack_size) != 0) {
             goto error;
         }
@@ -137,6 +145,38 @@ public:
         d_.reset();
     }
 
+    /**
+     * Runs a function on a thread taken from a stack pool.
+     *
+     * A new thread with the pool's stack size and priority is created if the pool has no
+     * thread available. The name is only used in that case.
+     */
+    Thread(const char *name, wiring_thread_fn_t function, particle::ThreadStackPool& pool)
+        : d_(new(std::nothrow) Data)
+    {
+        if (!d_) {
+            goto error;
+        }
+        d_->wrapper.reset(new(std::nothrow) wiring_thread_fn_t(std::move(function)));
+        if (!d_->wrapper) {
+            goto error;
+        }
+        d_->stack_size = pool.stackSize();
+        d_->pooled = true;
+        if (pool.run(&Thread::run, d_.get(), &d_->handle) != 0) {
+            d_->pooled = false;
+            if (os_thread_create(&d_->handle, name, pool.priority(), &Thread::run, d_.get(), d_->stack_size) != 0) {
+                goto error;
+            }
+        }
+        while (!d_->started) {
+            HAL_Delay_Milliseconds(1);
+        }
+        return;
+    error:
+        d_.reset();
+    }
+
     Thread(Thread&& thread)
         : d_(std::move(thread.d_))
     {
@@ -160,19 +200,52 @@ public:
             join();
         }
 
-        os_thread_cleanup(d_->handle);
+        if (!d_->pooled) {
+            os_thread_cleanup(d_->handle);
+        }
 
         d_.reset();
     }
 
     bool join()
     {
-        return isValid() && os_thread_join(d_->handle)==0;
+        if (!isValid()) {
+            return false;
+        }
+        if (d_->pooled) {
+            // The thread is parked rather than terminated
+            while (!d_->exited) {
+                HAL_Delay_Milliseconds(1);
+            }
+            return true;
+        }
+        return os_thread_join(d_->handle)==0;
     }
 
     bool cancel()
     {
-        return isValid() && os_thread_exit(d_->handle)==0;
+        // A pooled thread can't be terminated
+        return isValid() && !d_->pooled && os_thread_exit(d_->handle)==0;
+    }
+
+    /**
+     * Returns the stack size of the thread.
+     */
+    size_t stackSize() const
+    {
+        return isValid() ? d_->stack_size : 0;
+    }
+
+    /**
+     * Returns the minimum amount of unused stack space of the thread, in bytes.
+     *
+     * Use `particle::recommendedStackSize()` to size the thread based on this value.
+     *
+     * @return Number of bytes, or a negative result code.
+     */
+    int stackFree() const
+    {
+        return isValid() ? particle::threadStackFree(d_->handle) : SYSTEM_ERROR_INVALID_STATE;
     }
 
     bool is_valid() // Deprecated
@@ -212,8 +285,11 @@ private:
         } else if (th->wrapper) {
             (*(th->wrapper))();
         }
+        const bool pooled = th->pooled;
         th->exited = true;
-        os_thread_exit(nullptr);
+        if (!pooled) {
+            os_thread_exit(nullptr);
+        }
     }
 };
 
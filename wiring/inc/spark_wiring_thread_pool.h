@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "spark_wiring_thread.h"
+
+#if PLATFORM_THREADING
+
+#include "spark_wiring_async.h"
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+namespace particle {
+
+/**
+ * A fixed number of worker threads running tasks from a shared queue.
+ *
+ * Tasks are run in the order they were submitted, by whichever worker becomes available first.
+ * Completion callbacks of the futures returned by `submit()` are invoked in the application thread.
+ */
+class ThreadPool {
+public:
+    typedef std::function<void()> Task;
+
+    static const size_t DEFAULT_QUEUE_SIZE = 8;
+
+    ThreadPool();
+    ~ThreadPool();
+
+    /**
+     * Starts the worker threads.
+     *
+     * @param workerCount Number of worker threads.
+     * @param queueSize Maximum number of tasks waiting to be run.
+     * @param priority Priority of the worker threads.
+     * @param stackSize Stack size of the worker threads.
+     * @return 0 on success, or a negative result code.
+     */
+    int init(unsigned workerCount, size_t queueSize = DEFAULT_QUEUE_SIZE,
+            os_thread_prio_t priority = OS_THREAD_PRIORITY_DEFAULT, size_t stackSize = OS_THREAD_STACK_SIZE_DEFAULT);
+
+    /**
+     * Waits for the queued tasks to complete and stops the worker threads.
+     */
+    void destroy();
+
+    /**
+     * Queues a task.
+     *
+     * @param task Task.
+     * @param timeout Maximum time in milliseconds to wait for space in the queue.
+     * @return 0 on success, or a negative result code.
+     */
+    int post(Task task, system_tick_t timeout = 0);
+
+    /**
+     * Queues a function and returns a future for its result.
+     *
+     * The future fails with `Error::BUSY` if the queue is full.
+     */
+    template<typename FnT, typename ResultT = typename std::result_of<FnT()>::type>
+    Future<ResultT> submit(FnT fn, system_tick_t timeout = 0) {
+        Promise<ResultT> p;
+        const int ret = post([p, fn]() mutable {
+            setResult(p, fn);
+        }, timeout);
+        if (ret < 0) {
+            return Future<ResultT>((Error::Type)ret);
+        }
+        return p.future();
+    }
+
+    /**
+     * Returns the number of worker threads.
+     */
+    unsigned workerCount() const {
+        return workerCount_;
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+private:
+    std::unique_ptr<Thread[]> workers_;
+    unsigned workerCount_;
+    os_queue_t queue_;
+
+    void run();
+
+    template<typename ResultT, typename FnT>
+    static void setResult(Promise<ResultT>& p, FnT& fn) {
+        p.setResult(fn());
+    }
+
+    template<typename FnT>
+    static void setResult(Promise<void>& p, FnT& fn) {
+        fn();
+        p.setResult();
+    }
+};
+
+} // namespace particle
+
+#endif // PLATFORM_THREADING
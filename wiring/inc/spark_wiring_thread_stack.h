@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#if PLATFORM_THREADING
+
+#include "concurrent_hal.h"
+
+#include <cstddef>
+
+namespace particle {
+
+/**
+ * Returns the minimum amount of unused stack space of a thread since it was started, in bytes.
+ *
+ * The stacks are filled with a known pattern when the threads are created, so this is the
+ * stack high-water mark measured by the RTOS.
+ *
+ * @return Number of bytes, or a negative result code. `SYSTEM_ERROR_NOT_SUPPORTED` is returned
+ *         if the platform doesn't collect thread statistics.
+ */
+int threadStackFree(os_thread_t thread);
+
+/**
+ * Returns a stack size for a thread, based on the measured stack usage.
+ *
+ * The result is the used stack space plus a 25% margin, but no less than 256 bytes, rounded up
+ * to a multiple of 64 bytes.
+ *
+ * @param stackSize Current stack size of the thread.
+ * @param stackFree Minimum amount of unused stack space, as returned by `threadStackFree()`.
+ */
+size_t recommendedStackSize(size_t stackSize, size_t stackFree);
+
+/**
+ * A pool of threads with a fixed stack size that are reused instead of being destroyed.
+ *
+ * Creating and destroying short-lived threads allocates and frees their stacks, which
+ * fragments the heap over time. A thread started from the pool runs on one of its parked
+ * threads, so once the pool has grown to the number of threads that run concurrently, no more
+ * stacks are allocated.
+ *
+ * All threads started from the pool must have finished before the pool is destroyed.
+ *
+ * @see Thread::Thread(const char*, wiring_thread_fn_t, ThreadStackPool&)
+ */
+class ThreadStackPool {
+public:
+    /**
+     * Constructor.
+     *
+     * @param stackSize Stack size of the pooled threads.
+     * @param maxThreads Maximum number of threads in the pool.
+     * @param priority Priority of the pooled threads.
+     */
+    explicit ThreadStackPool(size_t stackSize, unsigned maxThreads = 2,
+            os_thread_prio_t priority = OS_THREAD_PRIORITY_DEFAULT);
+    ~ThreadStackPool();
+
+    /**
+     * Runs a function on a parked thread, or on a new thread if none is parked.
+     *
+     * The thread is parked again once the function returns. The function must not terminate
+     * the thread.
+     *
+     * @param fn Function.
+     * @param arg Argument of the function.
+     * @param thread Receives the handle of the thread running the function. Can be `nullptr`.
+     * @return 0 on success, `SYSTEM_ERROR_BUSY` if all threads are busy and the pool can't grow,
+     *         or another negative result code.
+     */
+    int run(os_thread_fn_t fn, void* arg, os_thread_t* thread = nullptr);
+
+    /**
+     * Returns the minimum amount of unused stack space among the pooled threads.
+     *
+     * @see threadStackFree()
+     */
+    int stackFree() const;
+
+    size_t stackSize() const {
+        return stackSize_;
+    }
+
+    os_thread_prio_t priority() const {
+        return priority_;
+    }
+
+    /**
+     * Returns the number of threads in the pool.
+     */
+    unsigned threadCount() const;
+
+    /**
+     * Returns the number of parked threads.
+     */
+    unsigned idleCount() const;
+
+    ThreadStackPool(const ThreadStackPool&) = delete;
+    ThreadStackPool& operator=(const ThreadStackPool&) = delete;
+
+private:
+    struct Worker;
+
+    Worker* workers_; // All threads
+    Worker* idle_; // Parked threads
+    size_t stackSize_;
+    unsigned maxThreads_;
+    unsigned count_;
+    unsigned idleCount_;
+    os_mutex_t mutex_;
+    os_thread_prio_t priority_;
+
+    void park(Worker* w);
+
+    static os_thread_return_t workerMain(void* arg);
+};
+
+} // namespace particle
+
+#endif // PLATFORM_THREADING
@@ -21,6 +21,7 @@
 
 #include <chrono>
 #include <functional>
+#include <atomic>
 
 #if PLATFORM_ID!=3
 
@@ -34,7 +35,7 @@ public:
 
     typedef std::function<void(void)> timer_callback_fn;
 
-    Timer(unsigned period, timer_callback_fn callback_, bool one_shot=false) : running(false), handle(nullptr), callback(std::move(callback_)) {
+    Timer(unsigned period, timer_callback_fn callback_, bool one_shot=false) : handle(nullptr), callback(std::move(callback_)) {
         os_timer_create(&handle, period, invoke_timer, this, one_shot, nullptr);
     }
 
@@ -95,7 +96,7 @@ public:
             // Make sure the callback will not be called after this object is destroyed.
             // TODO: Consider assigning a higher priority to the timer thread
             os_timer_set_id(handle, nullptr);
-            while (running) {
+            while (dispatching().load() == handle) {
                 os_thread_yield();
             }
             os_timer_destroy(handle, nullptr);
@@ -115,25 +116,28 @@ public:
     }
 
 private:
-	volatile bool running;
     os_timer_t handle;
     timer_callback_fn callback;
 
+    // Timer being dispatched. All timers are dispatched from the same thread, so marking the
+    // timer before getting its ID lets dispose() wait for the callback without suspending
+    // the scheduler
+    static std::atomic<os_timer_t>& dispatching()
+    {
+        static std::atomic<os_timer_t> timer(nullptr);
+        return timer;
+    }
+
     static void invoke_timer(os_timer_t timer)
     {
-        Timer* t = nullptr;
-        SINGLE_THREADED_BLOCK() {
-            void* id = nullptr;
-            os_timer_get_id(timer, &id);
-            t = static_cast<Timer*>(id);
-            if (t) {
-                t->running = true;
-            }
-        }
+        dispatching().store(timer);
+        void* id = nullptr;
+        os_timer_get_id(timer, &id);
+        Timer* t = static_cast<Timer*>(id);
         if (t) {
             t->timeout();
-            t->running = false;
         }
+        dispatching().store(nullptr);
     }
 
 };
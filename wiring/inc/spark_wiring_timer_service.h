@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "hal_platform.h"
+
+#if PLATFORM_THREADING
+
+#include "concurrent_hal.h"
+#include "spark_wiring_thread.h"
+#include "timer_wheel.h"
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+namespace particle {
+
+class ServiceTimer;
+
+/**
+ * Context in which the callback of a `ServiceTimer` is invoked.
+ */
+enum class TimerDispatch {
+    SERVICE_THREAD, ///< Invoke the callback on the thread of the timer service.
+    APPLICATION_THREAD ///< Post the callback to the application queue.
+};
+
+/**
+ * Service running software timers on a dedicated thread.
+ *
+ * The timers are scheduled on a hierarchical timer wheel, so starting and stopping a timer takes
+ * constant time regardless of the number of timers. The service keeps track of how late the
+ * timer callbacks are invoked compared to their scheduled time.
+ *
+ * The service thread is started when the first timer is started.
+ */
+class TimerService {
+public:
+    static const os_thread_prio_t DEFAULT_PRIORITY = OS_THREAD_PRIORITY_DEFAULT;
+    static const size_t DEFAULT_STACK_SIZE = 1024;
+    static const system_tick_t DEFAULT_LATE_THRESHOLD = 10;
+
+    struct Stats {
+        unsigned dispatched; ///< Number of invoked callbacks.
+        unsigned late; ///< Number of callbacks invoked later than the lateness threshold.
+        unsigned missed; ///< Number of periodic callbacks skipped because the timer fell behind.
+        system_tick_t maxLateness; ///< Maximum delay of a callback, in milliseconds.
+    };
+
+    /**
+     * Constructs a service.
+     *
+     * @param priority Priority of the service thread.
+     * @param stackSize Stack size of the service thread.
+     */
+    explicit TimerService(os_thread_prio_t priority = DEFAULT_PRIORITY, size_t stackSize = DEFAULT_STACK_SIZE);
+
+    /**
+     * Destroys the service.
+     *
+     * All timers using the service need to be destroyed before the service.
+     */
+    ~TimerService();
+
+    TimerService(const TimerService&) = delete;
+    TimerService& operator=(const TimerService&) = delete;
+
+    /**
+     * Sets the delay after which a callback is counted as late.
+     *
+     * @param ms Delay in milliseconds.
+     */
+    void setLateThreshold(system_tick_t ms);
+
+    /**
+     * Returns the delay after which a callback is counted as late.
+     */
+    system_tick_t lateThreshold() const;
+
+    /**
+     * Returns the lateness statistics.
+     */
+    Stats stats() const;
+
+    /**
+     * Resets the lateness statistics.
+     */
+    void resetStats();
+
+    /**
+     * Returns the default service instance.
+     */
+    static TimerService* instance();
+
+private:
+    TimerWheel wheel_;
+    Stats stats_;
+    mutable Mutex mutex_;
+    os_thread_t thread_;
+    os_semaphore_t wakeup_;
+    ServiceTimer* pending_; // Timers with a callback posted to the application queue
+    ServiceTimer** pendingTail_;
+    size_t stackSize_;
+    system_tick_t lateThreshold_;
+    system_tick_t wakeTime_;
+    os_thread_prio_t priority_;
+    bool waiting_;
+    bool waitForever_;
+    bool appPosted_;
+    volatile bool exit_;
+
+    bool start(ServiceTimer* timer);
+    bool changePeriod(ServiceTimer* timer, system_tick_t period);
+    void stop(ServiceTimer* timer);
+    void dispose(ServiceTimer* timer);
+    bool isActive(const ServiceTimer* timer) const;
+
+    bool startThread();
+    void run();
+    void runPending();
+    void invoke(ServiceTimer* timer, system_tick_t expiry, std::unique_lock<Mutex>& lock);
+    bool addPending(ServiceTimer* timer);
+    void removePending(ServiceTimer* timer);
+
+    static os_thread_return_t threadFunc(void* arg);
+    static void dispatchApplication(void* arg);
+
+    friend class ServiceTimer;
+};
+
+/**
+ * Software timer run by a `TimerService`.
+ *
+ * The interface is compatible with `Timer`. Unlike `Timer`, the timer can't be controlled from an
+ * ISR.
+ *
+ * A periodic timer is rescheduled relative to its previous expiration time, so the callback
+ * duration doesn't introduce any drift. If the timer falls behind by more than a period, the
+ * missed callbacks are skipped.
+ */
+class ServiceTimer: private TimerWheelEntry {
+public:
+    typedef std::function<void(void)> timer_callback_fn;
+
+    /**
+     * Constructs a timer.
+     *
+     * @param period Period in milliseconds.
+     * @param callback Callback.
+     * @param one_shot If `true`, the timer stops after expiring once.
+     * @param dispatch Context in which the callback is invoked.
+     * @param service Timer service. If `nullptr`, the default service is used.
+     */
+    ServiceTimer(unsigned period, timer_callback_fn callback, bool one_shot = false,
+            TimerDispatch dispatch = TimerDispatch::SERVICE_THREAD, TimerService* service = nullptr) :
+            service_(service ? service : TimerService::instance()),
+            callback_(std::move(callback)),
+            nextPending_(nullptr),
+            pprevPending_(nullptr),
+            pendingExpiry_(0),
+            period_(period ? period : 1),
+            runner_(OS_THREAD_INVALID_HANDLE),
+            dispatch_(dispatch),
+            oneShot_(one_shot),
+            active_(false),
+            running_(false) {
+    }
+
+    template<typename T>
+    ServiceTimer(unsigned period, void (T::*handler)(), T& instance, bool one_shot = false,
+            TimerDispatch dispatch = TimerDispatch::SERVICE_THREAD, TimerService* service = nullptr) :
+            ServiceTimer(period, std::bind(handler, &instance), one_shot, dispatch, service) {
+    }
+
+    virtual ~ServiceTimer() {
+        dispose();
+    }
+
+    ServiceTimer(const ServiceTimer&) = delete;
+    ServiceTimer& operator=(const ServiceTimer&) = delete;
+
+    /**
+     * Starts or restarts the timer.
+     */
+    bool start() {
+        return service_->start(this);
+    }
+
+    /**
+     * Stops the timer.
+     *
+     * A callback that has already been posted to the application queue is cancelled.
+     */
+    bool stop() {
+        service_->stop(this);
+        return true;
+    }
+
+    /**
+     * Restarts the timer.
+     */
+    bool reset() {
+        return start();
+    }
+
+    /**
+     * Changes the period of the timer and restarts it.
+     *
+     * @param period Period in milliseconds.
+     */
+    bool changePeriod(unsigned period) {
+        return service_->changePeriod(this, period);
+    }
+
+    bool changePeriod(std::chrono::milliseconds ms) {
+        return changePeriod(ms.count());
+    }
+
+    /**
+     * Returns `true` if the timer is running.
+     */
+    bool isActive() const {
+        return service_->isActive(this);
+    }
+
+    /**
+     * Stops the timer and waits until its callback completes if it's being invoked.
+     */
+    void dispose() {
+        service_->dispose(this);
+    }
+
+    /**
+     * Subclasses can either provide a callback function, or override this method.
+     */
+    virtual void timeout() {
+        if (callback_) {
+            callback_();
+        }
+    }
+
+private:
+    TimerService* service_;
+    timer_callback_fn callback_;
+    ServiceTimer* nextPending_;
+    ServiceTimer** pprevPending_;
+    system_tick_t pendingExpiry_;
+    system_tick_t period_;
+    os_thread_t runner_; // Thread invoking the callback
+    TimerDispatch dispatch_;
+    bool oneShot_;
+    bool active_;
+    volatile bool running_;
+
+    friend class TimerService;
+};
+
+} // particle
+
+#endif // PLATFORM_THREADING
@@ -32,6 +32,33 @@
 #include "spark_wiring_stream.h"
 #include "socket_hal.h"
 
+/**
+ * A datagram sent with {@link UDP#sendPackets} or received with {@link UDP#receivePackets}.
+ */
+struct UDPPacket {
+    /**
+     * The packet data.
+     */
+    uint8_t* buffer;
+
+    /**
+     * The size of the packet data when sending, or the size of the buffer when receiving.
+     */
+    size_t size;
+
+    /**
+     * The number of bytes sent or received. If the buffer is not large enough
+     * for a received packet, the remainder that doesn't fit is discarded.
+     */
+    size_t length;
+
+    /**
+     * The destination address when sending, or the source address when receiving.
+     */
+    IPAddress remoteIP;
+    uint16_t remotePort;
+};
+
 class UDP : public Stream, public Printable {
 private:
     /**
@@ -153,6 +180,28 @@ public:
         return receivePacket((uint8_t*)buffer, buf_size, timeout);
     }
 
+    /**
+     * Sends multiple packets directly. Where supported by the platform, the packets are passed
+     * to the network stack in batches, which is cheaper than calling {@link #sendPacket} for
+     * each of them.
+     *
+     * @param packets       The packets to send
+     * @param count         The number of packets
+     * @return The number of packets sent, or a negative value on error.
+     */
+    int sendPackets(UDPPacket* packets, size_t count);
+
+    /**
+     * Retrieves multiple packets directly. Only the first packet is waited for, the remaining
+     * ones are retrieved only if they have already been received.
+     *
+     * @param packets       The packets to receive
+     * @param count         The number of packets
+     * @param timeout       The time to wait for the first packet
+     * @return The number of packets received, or a negative value on error.
+     */
+    int receivePackets(UDPPacket* packets, size_t count, system_tick_t timeout = 0);
+
     /**
      * Begin writing a packet to the given destination.
      * @param ip        The IP address of the destination peer.
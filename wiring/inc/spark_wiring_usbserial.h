@@ -52,6 +52,9 @@ public:
 	int peek();
 
 	virtual size_t write(uint8_t byte);
+#if HAL_PLATFORM_USB_CDC_HIGH_THROUGHPUT
+	virtual size_t write(const uint8_t* buffer, size_t size) override;
+#endif
 	virtual int read();
 	virtual int availableForWrite(void);
 	virtual int available();
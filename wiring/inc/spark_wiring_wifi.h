@@ -265,6 +265,21 @@ public:
         return scan((wlan_scan_result_t)handler, (void*)instance);
     }
 
+    /**
+     * Reports each access point to the callback as soon as it is discovered, without buffering
+     * the scan results. The callback can return a non-zero value to stop receiving results.
+     *
+     * @return Number of reported access points, or a negative result code.
+     */
+    int scan(wlan_scan_stream_callback_t callback, void* cookie) {
+        return wlan_scan_stream(callback, cookie, nullptr);
+    }
+
+    template <typename T>
+    int scan(int (*handler)(WiFiAccessPoint* ap, T* instance), T* instance) {
+        return scan((wlan_scan_stream_callback_t)handler, (void*)instance);
+    }
+
     int getCredentials(WiFiAccessPoint* results, size_t result_count);
 
     String hostname()
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "spark_wiring_logging.h"
+#include "spark_wiring_platform.h"
+
+// Software timers are not available on the virtual device
+#if PLATFORM_THREADING && PLATFORM_ID != 3
+#define Wiring_SyslogLogHandler 1
+#else
+#define Wiring_SyslogLogHandler 0
+#endif
+
+#if Wiring_SyslogLogHandler
+
+#include "spark_wiring_udp.h"
+#include "spark_wiring_timer.h"
+
+#include <memory>
+
+namespace spark {
+
+/**
+ * Log handler sending messages to a syslog server over UDP.
+ *
+ * The messages are formatted according to RFC 5424 and batched into datagrams of up to
+ * `datagramSize()` bytes, separated by newline characters. A datagram is sent when it's full or
+ * when the oldest message in it has been waiting for `flushInterval()` milliseconds. Datagrams
+ * that would exceed `maxRate()` are dropped, as are the messages generated while the network is
+ * not ready; the number of dropped messages is reported in the next sent datagram.
+ *
+ * The handler is meant to be used with `LogManager::enableAsyncMode()`, so that the messages
+ * are sent by the logging thread. A handler created via the log configuration requests enables
+ * the asynchronous mode automatically.
+ */
+class SyslogLogHandler: public LogHandler {
+public:
+    static const uint16_t DEFAULT_PORT = 514;
+    static const size_t DEFAULT_DATAGRAM_SIZE = 512;
+    static const unsigned DEFAULT_FLUSH_INTERVAL = 1000;
+    static const unsigned DEFAULT_MAX_RATE = 1024;
+    static const unsigned DEFAULT_FACILITY = 16; // local0
+
+    /**
+     * Constructor.
+     *
+     * @param host Server address.
+     * @param port Server port.
+     * @param level Default logging level.
+     * @param filters Category filters.
+     */
+    explicit SyslogLogHandler(IPAddress host, uint16_t port = DEFAULT_PORT, LogLevel level = LOG_LEVEL_INFO,
+            LogCategoryFilters filters = {});
+    /**
+     * Constructor.
+     *
+     * The host name is resolved when the first datagram is sent.
+     *
+     * @param host Server host name.
+     * @param port Server port.
+     * @param level Default logging level.
+     * @param filters Category filters.
+     */
+    explicit SyslogLogHandler(const char* host, uint16_t port = DEFAULT_PORT, LogLevel level = LOG_LEVEL_INFO,
+            LogCategoryFilters filters = {});
+    ~SyslogLogHandler();
+
+    /**
+     * Sets the maximum size of a datagram, in bytes.
+     *
+     * The size should not exceed the path MTU minus the size of the IP and UDP headers.
+     */
+    SyslogLogHandler& datagramSize(size_t size);
+    size_t datagramSize() const;
+
+    /**
+     * Sets the maximum time a message can wait before it is sent, in milliseconds.
+     */
+    SyslogLogHandler& flushInterval(unsigned ms);
+    unsigned flushInterval() const;
+
+    /**
+     * Sets the maximum average bandwidth used by the handler, in bytes per second.
+     *
+     * A value of 0 disables the limit.
+     */
+    SyslogLogHandler& maxRate(unsigned bytesPerSecond);
+    unsigned maxRate() const;
+
+    /**
+     * Sets the syslog facility code.
+     */
+    SyslogLogHandler& facility(unsigned facility);
+    unsigned facility() const;
+
+    /**
+     * Sets the application name reported in the messages.
+     */
+    SyslogLogHandler& appName(const char* name);
+    const char* appName() const;
+
+    /**
+     * Sends the buffered messages.
+     */
+    void flush();
+
+    /**
+     * Returns the number of messages dropped because of the bandwidth limit or a network error.
+     */
+    unsigned droppedMessageCount() const;
+
+protected:
+    // Reimplemented from `LogHandler`
+    virtual void logMessage(const char *msg, LogLevel level, const char *category, const LogAttributes &attr) override;
+
+private:
+    UDP udp_;
+    Timer timer_;
+    Mutex mutex_;
+    IPAddress addr_;
+    String host_;
+    String appName_;
+    String deviceId_;
+    std::unique_ptr<char[]> buf_;
+    size_t size_; // Size of the buffered data
+    size_t bufSize_;
+    unsigned count_; // Number of buffered messages
+    unsigned dropped_;
+    unsigned droppedReported_;
+    unsigned reported_; // Number of dropped messages reported in the buffered data
+    unsigned flushInterval_;
+    unsigned maxRate_;
+    unsigned facility_;
+    unsigned tokens_; // Bytes that can be sent without exceeding the rate
+    system_tick_t lastRefill_;
+    system_tick_t firstTime_; // Time when the oldest buffered message was added
+    os_thread_t volatile sendThread_;
+    uint16_t port_;
+    bool udpOpen_;
+    bool timerStarted_;
+
+    bool append(const char* msg, LogLevel level, const char* category);
+    int send();
+    bool consumeTokens(size_t size);
+    void timeout();
+};
+
+inline size_t SyslogLogHandler::datagramSize() const {
+    return bufSize_;
+}
+
+inline unsigned SyslogLogHandler::flushInterval() const {
+    return flushInterval_;
+}
+
+inline unsigned SyslogLogHandler::maxRate() const {
+    return maxRate_;
+}
+
+inline unsigned SyslogLogHandler::facility() const {
+    return facility_;
+}
+
+inline const char* SyslogLogHandler::appName() const {
+    return appName_.c_str();
+}
+
+} // namespace spark
+
+#endif // Wiring_SyslogLogHandler
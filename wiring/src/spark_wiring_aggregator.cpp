@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spark_wiring_aggregator.h"
+
+#include "spark_wiring_time.h"
+#include "spark_wiring_ticks.h"
+#include "system_error.h"
+#include "check.h"
+
+namespace particle {
+
+namespace {
+
+const size_t HEADER_SIZE = 10;
+
+} // unnamed
+
+const size_t Aggregator::MAX_ACCUMULATORS;
+const uint8_t Aggregator::FORMAT_VERSION;
+
+Aggregator::Aggregator(const char* eventName, system_tick_t window, PublishFlags flags) :
+        accs_(),
+        eventName_(eventName),
+        accCount_(0),
+        window_(window),
+        windowStart_(millis()),
+        flags_(flags) {
+}
+
+int Aggregator::add(AccumulatorBase* acc) {
+    CHECK_TRUE(acc, SYSTEM_ERROR_INVALID_ARGUMENT);
+    CHECK_TRUE(accCount_ < MAX_ACCUMULATORS, SYSTEM_ERROR_LIMIT_EXCEEDED);
+    accs_[accCount_] = acc;
+    return accCount_++;
+}
+
+void Aggregator::window(system_tick_t ms) {
+    window_ = ms;
+}
+
+int Aggregator::process() {
+    if (millis() - windowStart_ < window_) {
+        return 0;
+    }
+    return flush();
+}
+
+int Aggregator::flush() {
+    const system_tick_t now = millis();
+    const system_tick_t duration = now - windowStart_;
+    windowStart_ = now;
+    uint8_t buf[protocol::MAX_EVENT_DATA_LENGTH];
+    const int size = encode(buf, sizeof(buf), Time.isValid() ? Time.now() : 0, duration);
+    resetAll();
+    if (size <= 0) {
+        return size;
+    }
+    // The event data is serialized before publish() returns, so the buffer can be on the stack
+    const auto f = Particle.publish(eventName_, buf, size, ContentType::BINARY, flags_);
+    if (f.isDone() && f.isFailed()) {
+        return f.error().type();
+    }
+    return 1;
+}
+
+int Aggregator::encode(uint8_t* buf, size_t size, uint32_t windowEnd, system_tick_t windowDuration) const {
+    CHECK_TRUE(size >= HEADER_SIZE, SYSTEM_ERROR_TOO_LARGE);
+    size_t n = 0;
+    buf[n++] = FORMAT_VERSION;
+    n += detail::encodeLittleEndian(buf + n, windowEnd);
+    n += detail::encodeLittleEndian(buf + n, (uint32_t)windowDuration);
+    uint8_t& entryCount = buf[n++];
+    entryCount = 0;
+    for (size_t i = 0; i < accCount_; ++i) {
+        const auto acc = accs_[i];
+        if (!acc->count()) {
+            continue;
+        }
+        CHECK_TRUE(size - n >= acc->encodedSize() + 1, SYSTEM_ERROR_TOO_LARGE);
+        buf[n++] = i;
+        n += acc->encode(buf + n, size - n);
+        ++entryCount;
+    }
+    if (!entryCount) {
+        return 0;
+    }
+    return n;
+}
+
+void Aggregator::resetAll() {
+    for (size_t i = 0; i < accCount_; ++i) {
+        accs_[i]->reset();
+    }
+}
+
+} // particle
@@ -953,8 +953,10 @@ public:
     BleLocalDeviceImpl()
             : connectedCb_(nullptr),
               disconnectedCb_(nullptr),
+              notificationsSentCb_(nullptr),
               connectedContext_(nullptr),
-              disconnectedContext_(nullptr) {
+              disconnectedContext_(nullptr),
+              notificationsSentContext_(nullptr) {
     }
 
     ~BleLocalDeviceImpl() = default;
@@ -981,6 +983,13 @@ public:
         disconnectedContext_ = context;
     }
 
+    void onNotificationsSentCallback(BleOnNotificationsSentCallback callback, void* context) {
+        WiringBleLock lk;
+        notificationsSentCb_ = callback;
+        notificationsSentContext_ = context;
+        hal_ble_gatt_server_set_callback_on_tx_complete(callback ? onTxComplete : nullptr, this, nullptr);
+    }
+
     BlePeerDevice* findPeerDevice(BleConnectionHandle connHandle) {
         for (auto& peer : peers_) {
             if (peer.impl()->connHandle() == connHandle) {
@@ -1027,14 +1036,25 @@ public:
         }
     }
 
+    static void onTxComplete(hal_ble_conn_handle_t connHandle, size_t count, void* context) {
+        auto impl = static_cast<BleLocalDeviceImpl*>(context);
+        WiringBleLock lk;
+        BlePeerDevice* peer = impl->findPeerDevice(connHandle);
+        if (peer && impl->notificationsSentCb_) {
+            impl->notificationsSentCb_(count, *peer, impl->notificationsSentContext_);
+        }
+    }
+
 private:
     Vector<BleService> services_;
     Vector<BleCharacteristic> characteristics_;
     Vector<BlePeerDevice> peers_;
     BleOnConnectedCallback connectedCb_;
     BleOnDisconnectedCallback disconnectedCb_;
+    BleOnNotificationsSentCallback notificationsSentCb_;
     void* connectedContext_;
     void* disconnectedContext_;
+    void* notificationsSentContext_;
 };
 
 
@@ -1173,6 +1193,17 @@ ssize_t BleCharacteristic::setValue(const uint8_t* buf, size_t len, BleTxRxType
     return SYSTEM_ERROR_INVALID_STATE;
 }
 
+ssize_t BleCharacteristic::notifyValues(const BleNotifyValue* values, size_t count) const {
+    static_assert(sizeof(BleNotifyValue) == sizeof(hal_ble_notify_value_t), "BleNotifyValue must not add any data members");
+    if (values == nullptr || count == 0) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    if (!impl()->local() || !impl()->properties().isSet(BleCharacteristicProperty::NOTIFY)) {
+        return SYSTEM_ERROR_NOT_SUPPORTED;
+    }
+    return hal_ble_gatt_server_notify_characteristic_values(impl()->attrHandles().value_handle, values, count, nullptr);
+}
+
 ssize_t BleCharacteristic::setValue(const String& str, BleTxRxType type) {
     return setValue(reinterpret_cast<const uint8_t*>(str.c_str()), str.length(), type);
 }
@@ -1562,6 +1593,12 @@ int BlePeerDevice::disconnect() const {
     return SYSTEM_ERROR_NONE;
 }
 
+int BlePeerDevice::setThroughput(size_t bytesPerSecond) const {
+    WiringBleLock lk;
+    CHECK_TRUE(connected(), SYSTEM_ERROR_INVALID_STATE);
+    return hal_ble_gap_set_link_throughput(impl()->connHandle(), bytesPerSecond, nullptr);
+}
+
 bool BlePeerDevice::connected() const {
     return impl()->connHandle() != BLE_INVALID_CONN_HANDLE;
 }
@@ -1607,6 +1644,10 @@ void BleLocalDevice::onDisconnected(BleOnDisconnectedCallback callback, void* co
     impl()->onDisconnectedCallback(callback, context);
 }
 
+void BleLocalDevice::onNotificationsSent(BleOnNotificationsSentCallback callback, void* context) const {
+    impl()->onNotificationsSentCallback(callback, context);
+}
+
 int BleLocalDevice::begin() const {
     WiringBleLock lk;
     return SYSTEM_ERROR_NONE;
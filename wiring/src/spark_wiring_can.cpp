@@ -66,11 +66,47 @@ bool CANChannel::addFilter(uint32_t id, uint32_t mask, HAL_CAN_Filters type)
     return HAL_CAN_Add_Filter(_channel, id, mask, type, NULL);
 }
 
+bool CANChannel::addFilter(const HAL_CAN_Filter &filter)
+{
+    return HAL_CAN_Add_Filter_Ext(_channel, &filter, NULL);
+}
+
+bool CANChannel::addFilterList(uint32_t id, uint32_t id2, HAL_CAN_Filters type)
+{
+    HAL_CAN_Filter filter = {};
+    filter.size = sizeof(filter);
+    filter.type = type;
+    filter.mode = CAN_FILTER_MODE_LIST;
+    filter.id = id;
+    filter.id2 = id2;
+    return HAL_CAN_Add_Filter_Ext(_channel, &filter, NULL);
+}
+
 void CANChannel::clearFilters()
 {
     HAL_CAN_Clear_Filters(_channel, NULL);
 }
 
+uint32_t CANChannel::rxQueueOverflows()
+{
+    HAL_CAN_Stats stats = {};
+    stats.size = sizeof(stats);
+    if (HAL_CAN_Get_Stats(_channel, &stats, NULL) != 0) {
+        return 0;
+    }
+    return stats.rx_queue_overflows;
+}
+
+uint32_t CANChannel::rxFifoOverruns()
+{
+    HAL_CAN_Stats stats = {};
+    stats.size = sizeof(stats);
+    if (HAL_CAN_Get_Stats(_channel, &stats, NULL) != 0) {
+        return 0;
+    }
+    return stats.rx_fifo_overruns;
+}
+
 bool CANChannel::isEnabled() {
     return HAL_CAN_Is_Enabled(_channel);
 }
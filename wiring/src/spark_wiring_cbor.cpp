@@ -0,0 +1,455 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spark_wiring_cbor.h"
+
+#include <algorithm>
+
+#include <cmath>
+
+namespace {
+
+// Major types
+const uint8_t TYPE_UINT = 0;
+const uint8_t TYPE_NEG_INT = 1;
+const uint8_t TYPE_BYTES = 2;
+const uint8_t TYPE_STRING = 3;
+const uint8_t TYPE_ARRAY = 4;
+const uint8_t TYPE_MAP = 5;
+const uint8_t TYPE_TAG = 6;
+const uint8_t TYPE_SIMPLE = 7;
+
+// Additional information
+const uint8_t INFO_UINT8 = 24;
+const uint8_t INFO_UINT16 = 25;
+const uint8_t INFO_UINT32 = 26;
+const uint8_t INFO_UINT64 = 27;
+const uint8_t INFO_INDEFINITE = 31;
+
+// Simple values
+const uint8_t SIMPLE_FALSE = 20;
+const uint8_t SIMPLE_TRUE = 21;
+const uint8_t SIMPLE_NULL = 22;
+const uint8_t SIMPLE_UNDEFINED = 23;
+const uint8_t SIMPLE_HALF = 25;
+const uint8_t SIMPLE_FLOAT = 26;
+const uint8_t SIMPLE_DOUBLE = 27;
+
+const uint8_t BREAK = 0xff;
+
+inline uint8_t initialByte(uint8_t type, uint8_t info) {
+    return (type << 5) | info;
+}
+
+// Writes an unsigned integer in network byte order
+inline void storeBigEndian(uint64_t val, uint8_t *buf, size_t size) {
+    for (size_t i = size; i > 0; --i) {
+        buf[i - 1] = val & 0xff;
+        val >>= 8;
+    }
+}
+
+inline uint64_t loadBigEndian(const uint8_t *buf, size_t size) {
+    uint64_t val = 0;
+    for (size_t i = 0; i < size; ++i) {
+        val = (val << 8) | buf[i];
+    }
+    return val;
+}
+
+double halfToDouble(uint16_t half) {
+    const int exp = (half >> 10) & 0x1f;
+    const int mant = half & 0x3ff;
+    double val = 0;
+    if (exp == 0) {
+        val = std::ldexp(mant, -24);
+    } else if (exp != 31) {
+        val = std::ldexp(mant + 1024, exp - 25);
+    } else {
+        val = (mant == 0) ? INFINITY : NAN;
+    }
+    return (half & 0x8000) ? -val : val;
+}
+
+} // namespace
+
+// spark::CBORWriter
+spark::CBORWriter& spark::CBORWriter::beginArray() {
+    write(initialByte(TYPE_ARRAY, INFO_INDEFINITE));
+    return *this;
+}
+
+spark::CBORWriter& spark::CBORWriter::endArray() {
+    write(BREAK);
+    return *this;
+}
+
+spark::CBORWriter& spark::CBORWriter::beginObject() {
+    write(initialByte(TYPE_MAP, INFO_INDEFINITE));
+    return *this;
+}
+
+spark::CBORWriter& spark::CBORWriter::endObject() {
+    write(BREAK);
+    return *this;
+}
+
+spark::CBORWriter& spark::CBORWriter::value(bool val) {
+    write(initialByte(TYPE_SIMPLE, val ? SIMPLE_TRUE : SIMPLE_FALSE));
+    return *this;
+}
+
+spark::CBORWriter& spark::CBORWriter::value(int val) {
+    return value((long long)val);
+}
+
+spark::CBORWriter& spark::CBORWriter::value(unsigned val) {
+    return value((unsigned long long)val);
+}
+
+spark::CBORWriter& spark::CBORWriter::value(long long val) {
+    if (val < 0) {
+        writeHead(TYPE_NEG_INT, -1 - val); // Negative integers are encoded as -1 - n
+    } else {
+        writeHead(TYPE_UINT, val);
+    }
+    return *this;
+}
+
+spark::CBORWriter& spark::CBORWriter::value(unsigned long long val) {
+    writeHead(TYPE_UINT, val);
+    return *this;
+}
+
+spark::CBORWriter& spark::CBORWriter::value(float val) {
+    uint32_t bits = 0;
+    memcpy(&bits, &val, sizeof(bits));
+    uint8_t buf[5];
+    buf[0] = initialByte(TYPE_SIMPLE, SIMPLE_FLOAT);
+    storeBigEndian(bits, buf + 1, sizeof(bits));
+    write((const char*)buf, sizeof(buf));
+    return *this;
+}
+
+spark::CBORWriter& spark::CBORWriter::value(double val) {
+    if ((double)(float)val == val || std::isnan(val)) {
+        return value((float)val);
+    }
+    uint64_t bits = 0;
+    memcpy(&bits, &val, sizeof(bits));
+    uint8_t buf[9];
+    buf[0] = initialByte(TYPE_SIMPLE, SIMPLE_DOUBLE);
+    storeBigEndian(bits, buf + 1, sizeof(bits));
+    write((const char*)buf, sizeof(buf));
+    return *this;
+}
+
+spark::CBORWriter& spark::CBORWriter::value(const char *val, size_t size) {
+    writeHead(TYPE_STRING, size);
+    write(val, size);
+    return *this;
+}
+
+spark::CBORWriter& spark::CBORWriter::bytesValue(const void *data, size_t size) {
+    writeHead(TYPE_BYTES, size);
+    write((const char*)data, size);
+    return *this;
+}
+
+spark::CBORWriter& spark::CBORWriter::nullValue() {
+    write(initialByte(TYPE_SIMPLE, SIMPLE_NULL));
+    return *this;
+}
+
+void spark::CBORWriter::writeHead(uint8_t type, uint64_t val) {
+    uint8_t buf[9];
+    size_t n = 0;
+    if (val < INFO_UINT8) {
+        buf[0] = initialByte(type, val);
+    } else if (val <= 0xff) {
+        buf[0] = initialByte(type, INFO_UINT8);
+        n = 1;
+    } else if (val <= 0xffff) {
+        buf[0] = initialByte(type, INFO_UINT16);
+        n = 2;
+    } else if (val <= 0xffffffff) {
+        buf[0] = initialByte(type, INFO_UINT32);
+        n = 4;
+    } else {
+        buf[0] = initialByte(type, INFO_UINT64);
+        n = 8;
+    }
+    storeBigEndian(val, buf + 1, n);
+    write((const char*)buf, n + 1);
+}
+
+// spark::CBORBufferWriter
+void spark::CBORBufferWriter::write(const char *data, size_t size) {
+    if (n_ < bufSize_) {
+        memcpy(buf_ + n_, data, std::min(size, bufSize_ - n_));
+    }
+    n_ += size;
+}
+
+// spark::CBORReader
+spark::CBORReader::CBORReader(const char *data, size_t size) :
+        data_(data),
+        size_(size),
+        pos_(0),
+        val_(0),
+        float_(0),
+        str_(nullptr),
+        depth_(0),
+        type_(CBOR_TYPE_INVALID),
+        neg_(false),
+        indef_(false),
+        error_(false) {
+}
+
+bool spark::CBORReader::next() {
+    if (error_) {
+        return false;
+    }
+    val_ = 0;
+    float_ = 0;
+    str_ = nullptr;
+    neg_ = false;
+    indef_ = false;
+    if (depth_ > 0 && remaining_[depth_ - 1] == 0) {
+        // End of a definite-length array or object
+        --depth_;
+        type_ = CBOR_TYPE_END;
+        return true;
+    }
+    uint8_t b = 0;
+    if (!readBytes(&b, 1)) {
+        if (depth_ > 0) {
+            return fail(); // Unexpected end of data
+        }
+        type_ = CBOR_TYPE_INVALID;
+        return false;
+    }
+    if (b == BREAK) {
+        if (depth_ == 0 || remaining_[depth_ - 1] != INDEFINITE) {
+            return fail();
+        }
+        --depth_;
+        type_ = CBOR_TYPE_END;
+        return true;
+    }
+    if (depth_ > 0 && remaining_[depth_ - 1] != INDEFINITE) {
+        --remaining_[depth_ - 1];
+    }
+    uint8_t type = b >> 5;
+    uint8_t info = b & 0x1f;
+    while (type == TYPE_TAG) {
+        uint64_t tag = 0;
+        if (!readArgument(info, &tag) || !readBytes(&b, 1) || b == BREAK) {
+            return fail();
+        }
+        type = b >> 5;
+        info = b & 0x1f;
+    }
+    switch (type) {
+    case TYPE_UINT:
+    case TYPE_NEG_INT: {
+        if (!readArgument(info, &val_)) {
+            return fail();
+        }
+        neg_ = (type == TYPE_NEG_INT);
+        type_ = CBOR_TYPE_INT;
+        break;
+    }
+    case TYPE_BYTES:
+    case TYPE_STRING: {
+        if (info == INFO_INDEFINITE || !readArgument(info, &val_) || val_ > size_ - pos_) {
+            return fail();
+        }
+        str_ = data_ + pos_;
+        pos_ += val_;
+        type_ = (type == TYPE_STRING) ? CBOR_TYPE_STRING : CBOR_TYPE_BYTES;
+        break;
+    }
+    case TYPE_ARRAY:
+    case TYPE_MAP: {
+        if (depth_ == MAX_DEPTH) {
+            return fail();
+        }
+        uint64_t count = INDEFINITE;
+        if (info == INFO_INDEFINITE) {
+            indef_ = true;
+        } else {
+            if (!readArgument(info, &val_)) {
+                return fail();
+            }
+            count = val_;
+            if (type == TYPE_MAP) {
+                if (count > (INDEFINITE - 1) / 2) {
+                    return fail();
+                }
+                count *= 2; // Number of names and values
+            }
+        }
+        remaining_[depth_++] = count;
+        type_ = (type == TYPE_ARRAY) ? CBOR_TYPE_ARRAY : CBOR_TYPE_OBJECT;
+        break;
+    }
+    default: { // TYPE_SIMPLE
+        switch (info) {
+        case SIMPLE_FALSE:
+        case SIMPLE_TRUE:
+            val_ = (info == SIMPLE_TRUE);
+            type_ = CBOR_TYPE_BOOL;
+            break;
+        case SIMPLE_NULL:
+        case SIMPLE_UNDEFINED:
+            type_ = CBOR_TYPE_NULL;
+            break;
+        case SIMPLE_HALF: {
+            uint8_t buf[2];
+            if (!readBytes(buf, sizeof(buf))) {
+                return fail();
+            }
+            float_ = halfToDouble(loadBigEndian(buf, sizeof(buf)));
+            type_ = CBOR_TYPE_FLOAT;
+            break;
+        }
+        case SIMPLE_FLOAT: {
+            uint8_t buf[4];
+            if (!readBytes(buf, sizeof(buf))) {
+                return fail();
+            }
+            const uint32_t bits = loadBigEndian(buf, sizeof(buf));
+            float f = 0;
+            memcpy(&f, &bits, sizeof(f));
+            float_ = f;
+            type_ = CBOR_TYPE_FLOAT;
+            break;
+        }
+        case SIMPLE_DOUBLE: {
+            uint8_t buf[8];
+            if (!readBytes(buf, sizeof(buf))) {
+                return fail();
+            }
+            const uint64_t bits = loadBigEndian(buf, sizeof(buf));
+            memcpy(&float_, &bits, sizeof(float_));
+            type_ = CBOR_TYPE_FLOAT;
+            break;
+        }
+        default:
+            return fail(); // Unsupported simple value
+        }
+        break;
+    }
+    }
+    return true;
+}
+
+bool spark::CBORReader::skip() {
+    if (type_ != CBOR_TYPE_ARRAY && type_ != CBOR_TYPE_OBJECT) {
+        return !error_;
+    }
+    const size_t d = depth_;
+    while (next()) {
+        if (type_ == CBOR_TYPE_END && depth_ == d - 1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool spark::CBORReader::toBool() const {
+    switch (type_) {
+    case CBOR_TYPE_BOOL:
+    case CBOR_TYPE_INT:
+        return val_ != 0;
+    case CBOR_TYPE_FLOAT:
+        return float_ != 0;
+    default:
+        return false;
+    }
+}
+
+long long spark::CBORReader::toInt() const {
+    switch (type_) {
+    case CBOR_TYPE_BOOL:
+        return val_;
+    case CBOR_TYPE_INT:
+        return neg_ ? -1 - (long long)val_ : (long long)val_;
+    case CBOR_TYPE_FLOAT:
+        return (long long)float_;
+    default:
+        return 0;
+    }
+}
+
+double spark::CBORReader::toDouble() const {
+    switch (type_) {
+    case CBOR_TYPE_BOOL:
+        return val_;
+    case CBOR_TYPE_INT:
+        return neg_ ? -1.0 - (double)val_ : (double)val_;
+    case CBOR_TYPE_FLOAT:
+        return float_;
+    default:
+        return 0;
+    }
+}
+
+size_t spark::CBORReader::size() const {
+    switch (type_) {
+    case CBOR_TYPE_STRING:
+    case CBOR_TYPE_BYTES:
+    case CBOR_TYPE_ARRAY:
+    case CBOR_TYPE_OBJECT:
+        return val_;
+    default:
+        return 0;
+    }
+}
+
+bool spark::CBORReader::readArgument(uint8_t info, uint64_t *val) {
+    if (info < INFO_UINT8) {
+        *val = info;
+        return true;
+    }
+    if (info > INFO_UINT64) {
+        return false;
+    }
+    const size_t n = 1 << (info - INFO_UINT8);
+    uint8_t buf[8];
+    if (!readBytes(buf, n)) {
+        return false;
+    }
+    *val = loadBigEndian(buf, n);
+    return true;
+}
+
+bool spark::CBORReader::readBytes(void *data, size_t size) {
+    if (size > size_ - pos_) {
+        return false;
+    }
+    memcpy(data, data_ + pos_, size);
+    pos_ += size;
+    return true;
+}
+
+bool spark::CBORReader::fail() {
+    error_ = true;
+    type_ = CBOR_TYPE_INVALID;
+    return false;
+}
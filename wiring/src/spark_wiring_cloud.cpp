@@ -2,6 +2,7 @@
 
 #include <functional>
 #include "system_cloud.h"
+#include "spark_wiring_thread_pool.h"
 
 namespace {
 
@@ -16,6 +17,28 @@ void publishCompletionCallback(int error, const void* data, void* callbackData,
     }
 }
 
+#if PLATFORM_THREADING
+
+struct ConcurrentFunction {
+    user_std_function_int_str_t fn;
+    ThreadPool* pool;
+};
+
+int callConcurrentUserFunction(void* data, const char* param, void* completion) {
+    const auto f = (ConcurrentFunction*)data;
+    // The argument string is only valid until this function returns
+    String arg(param);
+    const int ret = f->pool->post([f, arg, completion]() {
+        spark_function_complete(completion, f->fn(arg), nullptr);
+    });
+    if (ret < 0) {
+        spark_function_complete(completion, ret, nullptr);
+    }
+    return 0;
+}
+
+#endif // PLATFORM_THREADING
+
 } // namespace
 
 int CloudClass::call_raw_user_function(void* data, const char* param, void* reserved)
@@ -31,27 +54,91 @@ int CloudClass::call_std_user_function(void* data, const char* param, void* rese
     return (*fn)(String(param));
 }
 
+int CloudClass::call_async_user_function(void* data, const char* param, void* completion)
+{
+    user_async_function_t* fn = (user_async_function_t*)(data);
+    Promise<int> p;
+    p.future().onSuccess([completion](int result) {
+        spark_function_complete(completion, result, nullptr);
+    }).onError([completion](Error error) {
+        spark_function_complete(completion, error.type(), nullptr);
+    });
+    (*fn)(String(param), std::move(p));
+    return 0;
+}
+
 void CloudClass::call_wiring_event_handler(const void* handler_data, const char *event_name, const char *data)
 {
     wiring_event_handler_t* fn = (wiring_event_handler_t*)(handler_data);
     (*fn)(event_name, data);
 }
 
-bool CloudClass::register_function(cloud_function_t fn, void* data, const char* funcKey)
+void CloudClass::call_wiring_binary_event_handler(void* handler_data, const char *event_name, const char *data, size_t size, int type)
+{
+    wiring_binary_event_handler_t* fn = (wiring_binary_event_handler_t*)(handler_data);
+    (*fn)(event_name, data, size, (ContentType::Enum)type);
+}
+
+bool CloudClass::register_function(cloud_function_t fn, void* data, const char* funcKey, uint16_t flags)
 {
     cloud_function_descriptor desc = {};
     desc.size = sizeof(desc);
+    desc.flags = flags;
     desc.fn = fn;
     desc.data = (void*)data;
     desc.funcKey = funcKey;
     return spark_function(NULL, (user_function_int_str_t*)&desc, NULL);
 }
 
-Future<bool> CloudClass::publish_event(const char *eventName, const char *eventData, int ttl, PublishFlags flags) {
+bool CloudClass::_functionAsync(const char *funcKey, user_async_function_t func)
+{
+    if (!func) {
+        return false;
+    }
+    auto wrapper = new(std::nothrow) user_async_function_t(std::move(func));
+    if (!wrapper) {
+        return false;
+    }
+    if (!register_function(call_async_user_function, wrapper, funcKey, CLOUD_FUNCTION_FLAG_ASYNC)) {
+        delete wrapper;
+        return false;
+    }
+    return true;
+}
+
+#if PLATFORM_THREADING
+
+bool CloudClass::_functionConcurrent(const char *funcKey, user_std_function_int_str_t func, ThreadPool& pool)
+{
+    if (!func) {
+        return false;
+    }
+    auto wrapper = new(std::nothrow) ConcurrentFunction{std::move(func), &pool};
+    if (!wrapper) {
+        return false;
+    }
+    if (!register_function(callConcurrentUserFunction, wrapper, funcKey, CLOUD_FUNCTION_FLAG_ASYNC)) {
+        delete wrapper;
+        return false;
+    }
+    return true;
+}
+
+#endif // PLATFORM_THREADING
+
+Future<bool> CloudClass::publish_event(const char *eventName, const char *eventData, size_t size, int type, int ttl,
+        PublishFlags flags, EventPriority::Enum priority, system_tick_t timeout) {
     if (!connected()) {
         return Future<bool>(Error::INVALID_STATE);
     }
+    if (!eventData && size) {
+        return Future<bool>(Error::INVALID_ARGUMENT);
+    }
     spark_send_event_data d = { sizeof(spark_send_event_data) };
+    d.data_size = size;
+    d.content_type = type;
+    d.priority = priority;
+    d.timeout = timeout;
 
     // Completion handler
     Promise<bool> p;
@@ -67,6 +154,27 @@ Future<bool> CloudClass::publish_event(const char *eventName, const char *eventD
     return p.future();
 }
 
+Future<bool> CloudClass::publish_events(const EventBatchEntry* events, size_t count, int ttl, PublishFlags flags) {
+    if (!connected()) {
+        return Future<bool>(Error::INVALID_STATE);
+    }
+    if (!events || !count) {
+        return Future<bool>(Error::INVALID_ARGUMENT);
+    }
+    spark_send_event_data d = { sizeof(spark_send_event_data) };
+
+    Promise<bool> p;
+    d.handler_callback = publishCompletionCallback;
+    d.handler_data = p.dataPtr();
+
+    if (!spark_send_events(events, count, ttl, flags.value(), &d) && !p.isDone()) {
+        p.setError(Error::UNKNOWN);
+        p.fromDataPtr(d.handler_data); // Free wrapper object
+    }
+
+    return p.future();
+}
+
 int CloudClass::publishVitals(system_tick_t period_s_) {
     return spark_publish_vitals(period_s_, nullptr);
 }
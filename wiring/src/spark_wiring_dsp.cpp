@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spark_wiring_dsp.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace particle { namespace dsp { namespace detail {
+
+namespace {
+
+#if defined(__ARM_FEATURE_DSP)
+
+// Two 16-bit values packed into a word: the first one in the low halfword
+inline uint32_t load2(const int16_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v)); // Cortex-M4 supports unaligned word access
+    return v;
+}
+
+inline void store2(int16_t* p, uint32_t v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+inline int64_t smlald(uint32_t a, uint32_t b, int64_t acc) {
+    asm ("smlald %Q0, %R0, %1, %2" : "+r" (acc) : "r" (a), "r" (b));
+    return acc;
+}
+
+inline uint32_t qadd16(uint32_t a, uint32_t b) {
+    uint32_t r;
+    asm ("qadd16 %0, %1, %2" : "=r" (r) : "r" (a), "r" (b));
+    return r;
+}
+
+inline uint32_t shadd16(uint32_t a, uint32_t b) {
+    uint32_t r;
+    asm ("shadd16 %0, %1, %2" : "=r" (r) : "r" (a), "r" (b));
+    return r;
+}
+
+inline uint32_t shsub16(uint32_t a, uint32_t b) {
+    uint32_t r;
+    asm ("shsub16 %0, %1, %2" : "=r" (r) : "r" (a), "r" (b));
+    return r;
+}
+
+inline int32_t smusd(uint32_t a, uint32_t b) {
+    int32_t r;
+    asm ("smusd %0, %1, %2" : "=r" (r) : "r" (a), "r" (b));
+    return r;
+}
+
+inline int32_t smuadx(uint32_t a, uint32_t b) {
+    int32_t r;
+    asm ("smuadx %0, %1, %2" : "=r" (r) : "r" (a), "r" (b));
+    return r;
+}
+
+inline int32_t ssat16(int32_t v) {
+    int32_t r;
+    asm ("ssat %0, #16, %1" : "=r" (r) : "r" (v));
+    return r;
+}
+
+#endif // defined(__ARM_FEATURE_DSP)
+
+inline int16_t sat16(int32_t v) {
+    return saturate<int16_t>(v);
+}
+
+void bitReverse(int16_t* data, size_t size) {
+    for (size_t i = 1, j = 0; i < size; ++i) {
+        size_t bit = size >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            int16_t t[2];
+            memcpy(t, data + 2 * i, sizeof(t));
+            memcpy(data + 2 * i, data + 2 * j, sizeof(t));
+            memcpy(data + 2 * j, t, sizeof(t));
+        }
+    }
+}
+
+} // unnamed
+
+int64_t dot16(const int16_t* a, const int16_t* b, size_t n) {
+    int64_t acc = 0;
+    size_t i = 0;
+#if defined(__ARM_FEATURE_DSP)
+    for (; i + 4 <= n; i += 4) {
+        acc = smlald(load2(a + i), load2(b + i), acc);
+        acc = smlald(load2(a + i + 2), load2(b + i + 2), acc);
+    }
+    for (; i + 2 <= n; i += 2) {
+        acc = smlald(load2(a + i), load2(b + i), acc);
+    }
+#endif
+    for (; i < n; ++i) {
+        acc += (int32_t)a[i] * b[i];
+    }
+    return acc;
+}
+
+void add16(const int16_t* a, const int16_t* b, int16_t* out, size_t n) {
+    size_t i = 0;
+#if defined(__ARM_FEATURE_DSP)
+    for (; i + 2 <= n; i += 2) {
+        store2(out + i, qadd16(load2(a + i), load2(b + i)));
+    }
+#endif
+    for (; i < n; ++i) {
+        out[i] = sat16((int32_t)a[i] + b[i]);
+    }
+}
+
+void fftTwiddles16(int16_t* twiddles, size_t size) {
+    const double pi = 3.14159265358979323846;
+    for (size_t i = 0; i < size / 2; ++i) {
+        const double angle = 2 * pi * i / size;
+        twiddles[2 * i] = sat16(std::lround(std::cos(angle) * 32768.0));
+        twiddles[2 * i + 1] = sat16(std::lround(-std::sin(angle) * 32768.0));
+    }
+}
+
+void fft16(int16_t* data, size_t size, const int16_t* twiddles) {
+    bitReverse(data, size);
+    for (size_t len = 2; len <= size; len <<= 1) {
+        const size_t half = len >> 1;
+        const size_t step = size / len;
+        for (size_t i = 0; i < size; i += len) {
+            for (size_t j = 0; j < half; ++j) {
+                int16_t* const u = data + 2 * (i + j);
+                int16_t* const v = data + 2 * (i + j + half);
+                const int16_t* const w = twiddles + 2 * j * step;
+#if defined(__ARM_FEATURE_DSP)
+                const uint32_t vw = load2(v);
+                const uint32_t ww = load2(w);
+                const int32_t re = ssat16(smusd(vw, ww) >> 15);
+                const int32_t im = ssat16(smuadx(vw, ww) >> 15);
+                const uint32_t t = ((uint32_t)re & 0xffff) | ((uint32_t)im << 16);
+                const uint32_t uw = load2(u);
+                store2(u, shadd16(uw, t));
+                store2(v, shsub16(uw, t));
+#else
+                const int16_t re = sat16(((int32_t)v[0] * w[0] - (int32_t)v[1] * w[1]) >> 15);
+                const int16_t im = sat16(((int32_t)v[0] * w[1] + (int32_t)v[1] * w[0]) >> 15);
+                const int16_t ur = u[0];
+                const int16_t ui = u[1];
+                u[0] = ((int32_t)ur + re) >> 1;
+                u[1] = ((int32_t)ui + im) >> 1;
+                v[0] = ((int32_t)ur - re) >> 1;
+                v[1] = ((int32_t)ui - im) >> 1;
+#endif
+            }
+        }
+    }
+}
+
+uint64_t isqrt(uint64_t v) {
+    uint64_t r = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return r;
+}
+
+} } } // particle::dsp::detail
@@ -0,0 +1,853 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spark_wiring_format.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+
+namespace particle {
+
+namespace {
+
+// Size of the buffer in which the output is collected before it's passed to the callback
+const size_t CHUNK_SIZE = 64;
+
+// Maximum number of significant digits that can be produced using 64-bit arithmetic
+const int MAX_DIGITS = 19;
+
+const char DIGIT_PAIRS[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+const uint64_t POW10[MAX_DIGITS + 1] = {
+    1ull,
+    10ull,
+    100ull,
+    1000ull,
+    10000ull,
+    100000ull,
+    1000000ull,
+    10000000ull,
+    100000000ull,
+    1000000000ull,
+    10000000000ull,
+    100000000000ull,
+    1000000000000ull,
+    10000000000000ull,
+    100000000000000ull,
+    1000000000000000ull,
+    10000000000000000ull,
+    100000000000000000ull,
+    1000000000000000000ull,
+    10000000000000000000ull
+};
+
+enum Flag {
+    FLAG_LEFT = 0x01, // '-'
+    FLAG_PLUS = 0x02, // '+'
+    FLAG_SPACE = 0x04, // ' '
+    FLAG_ALT = 0x08, // '#'
+    FLAG_ZERO = 0x10, // '0'
+    FLAG_UPPER = 0x20 // Uppercase conversion
+};
+
+enum Length {
+    LENGTH_NONE,
+    LENGTH_HH,
+    LENGTH_H,
+    LENGTH_L,
+    LENGTH_LL,
+    LENGTH_J,
+    LENGTH_Z,
+    LENGTH_T,
+    LENGTH_LONG_DOUBLE
+};
+
+struct Spec {
+    unsigned flags;
+    int width;
+    int precision; // -1 if not specified
+    Length length;
+    char conv;
+};
+
+class Output {
+public:
+    Output(FormatOutputCallback callback, void* ctx) :
+            callback_(callback),
+            ctx_(ctx),
+            pos_(0),
+            total_(0) {
+    }
+
+    void put(char c) {
+        if (pos_ == sizeof(buf_)) {
+            flush();
+        }
+        buf_[pos_++] = c;
+        ++total_;
+    }
+
+    void put(const char* data, size_t size) {
+        if (!size) {
+            return;
+        }
+        total_ += size;
+        if (size >= sizeof(buf_)) {
+            // Pass long strings to the callback directly
+            flush();
+            callback_(data, size, ctx_);
+            return;
+        }
+        if (size > sizeof(buf_) - pos_) {
+            flush();
+        }
+        memcpy(buf_ + pos_, data, size);
+        pos_ += size;
+    }
+
+    void fill(char c, size_t count) {
+        total_ += count;
+        while (count > 0) {
+            if (pos_ == sizeof(buf_)) {
+                flush();
+            }
+            size_t n = sizeof(buf_) - pos_;
+            if (n > count) {
+                n = count;
+            }
+            memset(buf_ + pos_, c, n);
+            pos_ += n;
+            count -= n;
+        }
+    }
+
+    void flush() {
+        if (pos_ > 0) {
+            callback_(buf_, pos_, ctx_);
+            pos_ = 0;
+        }
+    }
+
+    size_t total() const {
+        return total_;
+    }
+
+private:
+    char buf_[CHUNK_SIZE];
+    FormatOutputCallback callback_;
+    void* ctx_;
+    size_t pos_;
+    size_t total_;
+};
+
+struct Uint128 {
+    uint64_t hi;
+    uint64_t lo;
+};
+
+Uint128 mul64(uint64_t a, uint64_t b) {
+    const uint64_t a0 = (uint32_t)a;
+    const uint64_t a1 = a >> 32;
+    const uint64_t b0 = (uint32_t)b;
+    const uint64_t b1 = b >> 32;
+    const uint64_t p00 = a0 * b0;
+    const uint64_t p01 = a0 * b1;
+    const uint64_t p10 = a1 * b0;
+    const uint64_t p11 = a1 * b1;
+    const uint64_t mid = (p00 >> 32) + (uint32_t)p01 + (uint32_t)p10;
+    Uint128 r;
+    r.lo = (mid << 32) | (uint32_t)p00;
+    r.hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+    return r;
+}
+
+bool testBit(const Uint128& v, unsigned bit) {
+    return (bit < 64) ? ((v.lo >> bit) & 1) : ((v.hi >> (bit - 64)) & 1);
+}
+
+// Returns true if any of the bits below the given bit are set
+bool anyBitsBelow(const Uint128& v, unsigned bit) {
+    if (bit == 0) {
+        return false;
+    }
+    if (bit < 64) {
+        return v.lo & (((uint64_t)1 << bit) - 1);
+    }
+    if (bit == 64) {
+        return v.lo;
+    }
+    return v.lo || (v.hi & (((uint64_t)1 << (bit - 64)) - 1));
+}
+
+// Rounds q + r / d to the nearest integer, ties to even
+uint64_t roundQuotient(uint64_t q, uint64_t r, uint64_t d) {
+    const uint64_t rest = d - r;
+    if (r > rest || (r == rest && (q & 1))) {
+        ++q;
+    }
+    return q;
+}
+
+// Computes round(m * 2^e * 10^t), ties to even. Returns false if the result can't be computed
+// exactly using the available arithmetic
+bool roundScaled(uint64_t m, int e, int t, uint64_t* result) {
+    if (t > MAX_DIGITS || -t > MAX_DIGITS) {
+        return false;
+    }
+    if (t >= 0) {
+        const Uint128 n = mul64(m, POW10[t]);
+        if (e >= 0) {
+            if (n.hi || (e > 0 && (e >= 64 || (n.lo >> (64 - e))))) {
+                return false;
+            }
+            *result = n.lo << e;
+            return true;
+        }
+        const unsigned s = -e;
+        if (s >= 120) {
+            *result = 0; // n < 2^117, so the value is smaller than 0.5
+            return true;
+        }
+        uint64_t q = 0;
+        if (s >= 64) {
+            q = n.hi >> (s - 64);
+        } else {
+            if (n.hi >> s) {
+                return false;
+            }
+            q = (n.lo >> s) | (n.hi << (64 - s));
+        }
+        if (testBit(n, s - 1) && (anyBitsBelow(n, s - 1) || (q & 1))) {
+            if (q == UINT64_MAX) {
+                return false;
+            }
+            ++q;
+        }
+        *result = q;
+        return true;
+    }
+    const uint64_t d = POW10[-t];
+    if (e >= 0) {
+        if (e >= 64 || (e > 0 && (m >> (64 - e)))) {
+            return false;
+        }
+        const uint64_t n = m << e;
+        *result = roundQuotient(n / d, n % d, d);
+        return true;
+    }
+    const unsigned s = -e;
+    if (s >= 64 || (d >> (64 - s))) {
+        return false;
+    }
+    const uint64_t den = d << s;
+    *result = roundQuotient(m / den, m % den, den);
+    return true;
+}
+
+// Writes decimal digits of a value backwards from the end of a buffer
+char* formatDec(uint64_t val, char* end) {
+    // Use 64-bit divisions only while the value doesn't fit in 32 bits
+    while (val > UINT32_MAX) {
+        const uint64_t q = val / 100000000;
+        uint32_t r = (uint32_t)(val - q * 100000000);
+        for (int i = 0; i < 4; ++i) {
+            const uint32_t d = r % 100;
+            r /= 100;
+            end -= 2;
+            memcpy(end, DIGIT_PAIRS + d * 2, 2);
+        }
+        val = q;
+    }
+    uint32_t v = (uint32_t)val;
+    while (v >= 100) {
+        const uint32_t d = v % 100;
+        v /= 100;
+        end -= 2;
+        memcpy(end, DIGIT_PAIRS + d * 2, 2);
+    }
+    if (v >= 10) {
+        end -= 2;
+        memcpy(end, DIGIT_PAIRS + v * 2, 2);
+    } else {
+        *--end = '0' + v;
+    }
+    return end;
+}
+
+char* formatHex(uint64_t val, char* end, bool upper) {
+    const char* const digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    do {
+        *--end = digits[val & 0x0f];
+        val >>= 4;
+    } while (val);
+    return end;
+}
+
+char* formatOct(uint64_t val, char* end) {
+    do {
+        *--end = '0' + (val & 0x07);
+        val >>= 3;
+    } while (val);
+    return end;
+}
+
+// Writes a field consisting of a prefix (sign, "0x"), leading zeros and a body, padded to the
+// specified width
+void writeField(Output* out, const Spec& spec, const char* prefix, size_t prefixLen, size_t zeros,
+        const char* body, size_t bodyLen, bool zeroPad) {
+    const size_t len = prefixLen + zeros + bodyLen;
+    size_t pad = ((size_t)spec.width > len) ? spec.width - len : 0;
+    if (!(spec.flags & FLAG_LEFT) && !zeroPad) {
+        out->fill(' ', pad);
+        pad = 0;
+    }
+    out->put(prefix, prefixLen);
+    if (!(spec.flags & FLAG_LEFT)) {
+        zeros += pad;
+        pad = 0;
+    }
+    out->fill('0', zeros);
+    out->put(body, bodyLen);
+    out->fill(' ', pad);
+}
+
+size_t signPrefix(const Spec& spec, bool negative, char* prefix) {
+    if (negative) {
+        *prefix = '-';
+    } else if (spec.flags & FLAG_PLUS) {
+        *prefix = '+';
+    } else if (spec.flags & FLAG_SPACE) {
+        *prefix = ' ';
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+void formatInt(Output* out, const Spec& spec, uint64_t val, bool negative) {
+    char buf[24];
+    char* const end = buf + sizeof(buf);
+    char* p = end;
+    char prefix[2];
+    size_t prefixLen = 0;
+    switch (spec.conv) {
+    case 'x':
+    case 'X':
+    case 'p':
+        if (val || spec.precision != 0) {
+            p = formatHex(val, end, spec.flags & FLAG_UPPER);
+        }
+        if ((spec.flags & FLAG_ALT) && val) {
+            prefix[0] = '0';
+            prefix[1] = (spec.flags & FLAG_UPPER) ? 'X' : 'x';
+            prefixLen = 2;
+        }
+        break;
+    case 'o':
+        if (val || spec.precision != 0) {
+            p = formatOct(val, end);
+        }
+        if ((spec.flags & FLAG_ALT) && (p == end || *p != '0') && spec.precision <= end - p) {
+            *--p = '0';
+        }
+        break;
+    case 'u':
+        if (val || spec.precision != 0) {
+            p = formatDec(val, end);
+        }
+        break;
+    default: // 'd', 'i'
+        if (val || spec.precision != 0) {
+            p = formatDec(val, end);
+        }
+        prefixLen = signPrefix(spec, negative, prefix);
+        break;
+    }
+    const size_t len = end - p;
+    const size_t zeros = (spec.precision > 0 && (size_t)spec.precision > len) ? spec.precision - len : 0;
+    const bool zeroPad = (spec.flags & FLAG_ZERO) && spec.precision < 0;
+    writeField(out, spec, prefix, prefixLen, zeros, p, len, zeroPad);
+}
+
+void formatString(Output* out, const Spec& spec, const char* str) {
+    if (!str) {
+        str = "(null)";
+    }
+    size_t len = 0;
+    if (spec.precision >= 0) {
+        while (len < (size_t)spec.precision && str[len]) {
+            ++len;
+        }
+    } else {
+        len = strlen(str);
+    }
+    writeField(out, spec, nullptr, 0, 0, str, len, false);
+}
+
+// Formats a double using snprintf()
+void formatDoubleFallback(Output* out, const Spec& spec, double val) {
+    char fmt[16];
+    char* p = fmt;
+    *p++ = '%';
+    if (spec.flags & FLAG_LEFT) {
+        *p++ = '-';
+    }
+    if (spec.flags & FLAG_PLUS) {
+        *p++ = '+';
+    }
+    if (spec.flags & FLAG_SPACE) {
+        *p++ = ' ';
+    }
+    if (spec.flags & FLAG_ALT) {
+        *p++ = '#';
+    }
+    if (spec.flags & FLAG_ZERO) {
+        *p++ = '0';
+    }
+    *p++ = '*';
+    *p++ = '.';
+    *p++ = '*';
+    *p++ = spec.conv;
+    *p = '\0';
+    // A negative precision is taken as if it was omitted
+    const int n = snprintf(nullptr, 0, fmt, spec.width, spec.precision, val);
+    if (n <= 0) {
+        return;
+    }
+    char buf[n + 1];
+    snprintf(buf, sizeof(buf), fmt, spec.width, spec.precision, val);
+    out->put(buf, n);
+}
+
+// Produces the digits of a value rounded to the specified number of significant digits and
+// returns the decimal exponent of the first digit
+bool significantDigits(uint64_t m, int e, int digits, uint64_t* q, int* exp10) {
+    if (!m) {
+        *q = 0;
+        *exp10 = 0;
+        return true;
+    }
+    // Estimate the decimal exponent: floor(log10(2) * log2(val))
+    const int log2 = e + 63 - __builtin_clzll(m);
+    int k = (log2 * 78913) >> 18;
+    for (int i = 0; i < 3; ++i) {
+        if (!roundScaled(m, e, digits - 1 - k, q)) {
+            return false;
+        }
+        if (*q >= POW10[digits]) {
+            ++k; // The estimate was too low or the value was rounded up to the next power of 10
+        } else if (*q < POW10[digits - 1]) {
+            --k;
+        } else {
+            *exp10 = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+void formatDouble(Output* out, const Spec& spec, double val) {
+    uint64_t bits = 0;
+    memcpy(&bits, &val, sizeof(bits));
+    const bool negative = bits >> 63;
+    const int biasedExp = (bits >> 52) & 0x7ff;
+    uint64_t m = bits & (((uint64_t)1 << 52) - 1);
+    const bool upper = spec.flags & FLAG_UPPER;
+    char prefix[1];
+    if (biasedExp == 0x7ff) {
+        const char* const str = m ? (upper ? "NAN" : "nan") : (upper ? "INF" : "inf");
+        const size_t prefixLen = signPrefix(spec, negative && !m, prefix);
+        writeField(out, spec, prefix, prefixLen, 0, str, 3, false);
+        return;
+    }
+    int e = 0;
+    if (biasedExp) {
+        m |= (uint64_t)1 << 52;
+        e = biasedExp - 1075;
+    } else {
+        e = -1074;
+    }
+    char conv = spec.conv | 0x20; // Lowercase
+    int precision = (spec.precision >= 0) ? spec.precision : 6;
+    const bool alt = spec.flags & FLAG_ALT;
+    bool stripZeros = false;
+    uint64_t q = 0;
+    int k = 0;
+    if (conv == 'a' || precision > MAX_DIGITS) {
+        formatDoubleFallback(out, spec, val);
+        return;
+    }
+    if (conv == 'f') {
+        if (!roundScaled(m, e, precision, &q)) {
+            formatDoubleFallback(out, spec, val);
+            return;
+        }
+    } else {
+        if (conv == 'g') {
+            if (precision == 0) {
+                precision = 1;
+            }
+            if (!significantDigits(m, e, precision, &q, &k)) {
+                formatDoubleFallback(out, spec, val);
+                return;
+            }
+            if (k < precision && k >= -4) {
+                conv = 'f';
+                precision = precision - 1 - k;
+            } else {
+                conv = 'e';
+                precision -= 1;
+            }
+            stripZeros = !alt;
+        } else if (precision + 1 > MAX_DIGITS || !significantDigits(m, e, precision + 1, &q, &k)) {
+            formatDoubleFallback(out, spec, val);
+            return;
+        }
+    }
+    // Decimal digits of the rounded value, with the decimal point placed `precision` digits from
+    // the end for the 'f' conversion, or after the first digit for the 'e' conversion
+    char digits[MAX_DIGITS + 2];
+    char* const digitsEnd = digits + sizeof(digits);
+    const char* const d = formatDec(q, digitsEnd);
+    const size_t digitCount = digitsEnd - d;
+    size_t intLen = 1;
+    size_t leadingZeros = 0; // Zeros between the decimal point and the digits
+    size_t trailingZeros = 0; // Zeros after the digits
+    if (conv == 'f') {
+        if (digitCount > (size_t)precision) {
+            intLen = digitCount - precision;
+        } else {
+            intLen = 0;
+            leadingZeros = precision - digitCount;
+        }
+    } else if (!q) {
+        trailingZeros = precision; // The value is 0
+    }
+    size_t fracLen = digitCount - intLen;
+    if (stripZeros) {
+        while (fracLen > 0 && d[intLen + fracLen - 1] == '0') {
+            --fracLen;
+        }
+        if (!fracLen) {
+            leadingZeros = 0;
+        }
+        trailingZeros = 0;
+    }
+    char body[MAX_DIGITS * 2 + 16];
+    char* p = body;
+    if (intLen > 0) {
+        memcpy(p, d, intLen);
+        p += intLen;
+    } else {
+        *p++ = '0';
+    }
+    if (leadingZeros > 0 || fracLen > 0 || trailingZeros > 0 || alt) {
+        *p++ = '.';
+    }
+    memset(p, '0', leadingZeros);
+    p += leadingZeros;
+    memcpy(p, d + intLen, fracLen);
+    p += fracLen;
+    memset(p, '0', trailingZeros);
+    p += trailingZeros;
+    if (conv == 'e') {
+        *p++ = upper ? 'E' : 'e';
+        if (k < 0) {
+            *p++ = '-';
+            k = -k;
+        } else {
+            *p++ = '+';
+        }
+        if (k < 10) {
+            *p++ = '0';
+        }
+        char expBuf[4];
+        char* const expEnd = expBuf + sizeof(expBuf);
+        const char* exp = formatDec(k, expEnd);
+        memcpy(p, exp, expEnd - exp);
+        p += expEnd - exp;
+    }
+    const size_t prefixLen = signPrefix(spec, negative, prefix);
+    writeField(out, spec, prefix, prefixLen, 0, body, p - body, spec.flags & FLAG_ZERO);
+}
+
+void storeCount(const Spec& spec, va_list* args, size_t count) {
+    switch (spec.length) {
+    case LENGTH_HH:
+        *va_arg(*args, signed char*) = count;
+        break;
+    case LENGTH_H:
+        *va_arg(*args, short*) = count;
+        break;
+    case LENGTH_L:
+        *va_arg(*args, long*) = count;
+        break;
+    case LENGTH_LL:
+        *va_arg(*args, long long*) = count;
+        break;
+    case LENGTH_J:
+        *va_arg(*args, intmax_t*) = count;
+        break;
+    case LENGTH_Z:
+        *va_arg(*args, size_t*) = count;
+        break;
+    case LENGTH_T:
+        *va_arg(*args, ptrdiff_t*) = count;
+        break;
+    default:
+        *va_arg(*args, int*) = count;
+        break;
+    }
+}
+
+int64_t signedArg(const Spec& spec, va_list* args) {
+    switch (spec.length) {
+    case LENGTH_HH:
+        return (signed char)va_arg(*args, int);
+    case LENGTH_H:
+        return (short)va_arg(*args, int);
+    case LENGTH_L:
+        return va_arg(*args, long);
+    case LENGTH_LL:
+        return va_arg(*args, long long);
+    case LENGTH_J:
+        return va_arg(*args, intmax_t);
+    case LENGTH_Z:
+    case LENGTH_T:
+        return va_arg(*args, ptrdiff_t);
+    default:
+        return va_arg(*args, int);
+    }
+}
+
+uint64_t unsignedArg(const Spec& spec, va_list* args) {
+    switch (spec.length) {
+    case LENGTH_HH:
+        return (unsigned char)va_arg(*args, unsigned);
+    case LENGTH_H:
+        return (unsigned short)va_arg(*args, unsigned);
+    case LENGTH_L:
+        return va_arg(*args, unsigned long);
+    case LENGTH_LL:
+        return va_arg(*args, unsigned long long);
+    case LENGTH_J:
+        return va_arg(*args, uintmax_t);
+    case LENGTH_Z:
+    case LENGTH_T:
+        return va_arg(*args, size_t);
+    default:
+        return va_arg(*args, unsigned);
+    }
+}
+
+const char* parseSpec(const char* fmt, Spec* spec, va_list* args) {
+    spec->flags = 0;
+    spec->width = 0;
+    spec->precision = -1;
+    spec->length = LENGTH_NONE;
+    for (;; ++fmt) {
+        const char c = *fmt;
+        if (c == '-') {
+            spec->flags |= FLAG_LEFT;
+        } else if (c == '+') {
+            spec->flags |= FLAG_PLUS;
+        } else if (c == ' ') {
+            spec->flags |= FLAG_SPACE;
+        } else if (c == '#') {
+            spec->flags |= FLAG_ALT;
+        } else if (c == '0') {
+            spec->flags |= FLAG_ZERO;
+        } else {
+            break;
+        }
+    }
+    if (*fmt == '*') {
+        spec->width = va_arg(*args, int);
+        if (spec->width < 0) {
+            spec->flags |= FLAG_LEFT;
+            spec->width = (spec->width == INT_MIN) ? INT_MAX : -spec->width;
+        }
+        ++fmt;
+    } else {
+        while (*fmt >= '0' && *fmt <= '9') {
+            spec->width = spec->width * 10 + (*fmt++ - '0');
+        }
+    }
+    if (*fmt == '.') {
+        ++fmt;
+        spec->precision = 0;
+        if (*fmt == '*') {
+            spec->precision = va_arg(*args, int);
+            if (spec->precision < 0) {
+                spec->precision = -1;
+            }
+            ++fmt;
+        } else {
+            while (*fmt >= '0' && *fmt <= '9') {
+                spec->precision = spec->precision * 10 + (*fmt++ - '0');
+            }
+        }
+    }
+    switch (*fmt) {
+    case 'h':
+        if (*++fmt == 'h') {
+            spec->length = LENGTH_HH;
+            ++fmt;
+        } else {
+            spec->length = LENGTH_H;
+        }
+        break;
+    case 'l':
+        if (*++fmt == 'l') {
+            spec->length = LENGTH_LL;
+            ++fmt;
+        } else {
+            spec->length = LENGTH_L;
+        }
+        break;
+    case 'j':
+        spec->length = LENGTH_J;
+        ++fmt;
+        break;
+    case 'z':
+        spec->length = LENGTH_Z;
+        ++fmt;
+        break;
+    case 't':
+        spec->length = LENGTH_T;
+        ++fmt;
+        break;
+    case 'L':
+        spec->length = LENGTH_LONG_DOUBLE;
+        ++fmt;
+        break;
+    default:
+        break;
+    }
+    spec->conv = *fmt;
+    if (spec->conv >= 'A' && spec->conv <= 'Z') {
+        spec->flags |= FLAG_UPPER;
+    }
+    if (spec->flags & FLAG_LEFT) {
+        spec->flags &= ~FLAG_ZERO;
+    }
+    if (spec->flags & FLAG_PLUS) {
+        spec->flags &= ~FLAG_SPACE;
+    }
+    return fmt;
+}
+
+} // namespace
+
+size_t vformatTo(FormatOutputCallback callback, void* ctx, const char* fmt, va_list args) {
+    Output out(callback, ctx);
+    va_list ap;
+    va_copy(ap, args);
+    while (*fmt) {
+        // Copy the literal text up to the next conversion
+        const char* p = fmt;
+        while (*p && *p != '%') {
+            ++p;
+        }
+        if (p != fmt) {
+            out.put(fmt, p - fmt);
+            fmt = p;
+            continue;
+        }
+        Spec spec;
+        fmt = parseSpec(fmt + 1, &spec, &ap);
+        switch (spec.conv) {
+        case 'd':
+        case 'i': {
+            const int64_t val = signedArg(spec, &ap);
+            formatInt(&out, spec, (val < 0) ? -(uint64_t)val : val, val < 0);
+            break;
+        }
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            formatInt(&out, spec, unsignedArg(spec, &ap), false);
+            break;
+        case 'p':
+            spec.flags |= FLAG_ALT;
+            formatInt(&out, spec, (uintptr_t)va_arg(ap, void*), false);
+            break;
+        case 'c': {
+            const char c = (char)va_arg(ap, int);
+            writeField(&out, spec, nullptr, 0, 0, &c, 1, false);
+            break;
+        }
+        case 's':
+            formatString(&out, spec, va_arg(ap, const char*));
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A': {
+            const double val = (spec.length == LENGTH_LONG_DOUBLE) ? (double)va_arg(ap, long double) :
+                    va_arg(ap, double);
+            formatDouble(&out, spec, val);
+            break;
+        }
+        case 'n':
+            storeCount(spec, &ap, out.total());
+            break;
+        case '%':
+            out.put('%');
+            break;
+        case '\0':
+            // Incomplete conversion at the end of the format string
+            continue;
+        default:
+            // Unknown conversion, output it as is
+            out.put('%');
+            out.put(spec.conv);
+            break;
+        }
+        ++fmt;
+    }
+    va_end(ap);
+    out.flush();
+    return out.total();
+}
+
+size_t formatTo(FormatOutputCallback callback, void* ctx, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    const size_t n = vformatTo(callback, ctx, fmt, args);
+    va_end(args);
+    return n;
+}
+
+} // namespace particle
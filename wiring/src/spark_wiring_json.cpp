@@ -17,7 +17,12 @@
 
 #include "spark_wiring_json.h"
 
+#include "spark_wiring_format.h"
+#include "allocator.h"
+
 #include <algorithm>
+#include <atomic>
+#include <new>
 
 #include <cstdio>
 #include <cstdlib>
@@ -62,28 +67,135 @@ bool hexToInt(const char *s, size_t size, uint32_t *val) {
     return true;
 }
 
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool isLiteralChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '+' ||
+            c == '.';
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Checks if a string is a number as defined by RFC 7159
+bool isNumber(const char *s, size_t size) {
+    const char* const end = s + size;
+    if (s != end && *s == '-') {
+        ++s;
+    }
+    if (s == end) {
+        return false;
+    }
+    if (*s == '0') {
+        ++s;
+    } else if (isDigit(*s)) {
+        while (s != end && isDigit(*s)) {
+            ++s;
+        }
+    } else {
+        return false;
+    }
+    if (s != end && *s == '.') {
+        ++s;
+        if (s == end || !isDigit(*s)) {
+            return false;
+        }
+        while (s != end && isDigit(*s)) {
+            ++s;
+        }
+    }
+    if (s != end && (*s == 'e' || *s == 'E')) {
+        ++s;
+        if (s != end && (*s == '+' || *s == '-')) {
+            ++s;
+        }
+        if (s == end || !isDigit(*s)) {
+            return false;
+        }
+        while (s != end && isDigit(*s)) {
+            ++s;
+        }
+    }
+    return s == end;
+}
+
 } // namespace
 
 // spark::detail::JSONData
 struct spark::detail::JSONData {
     jsmntok_t *tokens;
     char *json;
+    particle::SimpleAllocator *alloc;
+    std::atomic<int> refCount;
     bool freeJson;
 
-    JSONData() :
+    explicit JSONData(particle::SimpleAllocator *alloc) :
             tokens(nullptr),
             json(nullptr),
+            alloc(alloc),
+            refCount(1),
             freeJson(false) {
     }
 
     ~JSONData() {
-        delete[] tokens;
+        free(tokens);
         if (freeJson) {
-            delete[] json;
+            free(json);
+        }
+    }
+
+    void* malloc(size_t size) {
+        return alloc ? alloc->alloc(size) : ::malloc(size);
+    }
+
+    void free(void *ptr) {
+        if (alloc) {
+            alloc->free(ptr);
+        } else {
+            ::free(ptr);
+        }
+    }
+
+    static JSONData* create(particle::SimpleAllocator *alloc) {
+        void* const p = alloc ? alloc->alloc(sizeof(JSONData)) : ::malloc(sizeof(JSONData));
+        if (!p) {
+            return nullptr;
+        }
+        return new(p) JSONData(alloc);
+    }
+
+    static void destroy(JSONData *d) {
+        particle::SimpleAllocator* const alloc = d->alloc;
+        d->~JSONData();
+        if (alloc) {
+            alloc->free(d);
+        } else {
+            ::free(d);
         }
     }
 };
 
+// spark::detail::JSONDataPtr
+spark::detail::JSONDataPtr::JSONDataPtr(JSONData* d) :
+        d_(d) {
+}
+
+spark::detail::JSONDataPtr::JSONDataPtr(const JSONDataPtr& ptr) :
+        d_(ptr.d_) {
+    if (d_) {
+        d_->refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+spark::detail::JSONDataPtr::~JSONDataPtr() {
+    if (d_ && d_->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        JSONData::destroy(d_);
+    }
+}
+
 // spark::JSONValue
 spark::JSONValue::JSONValue(const jsmntok_t *t, detail::JSONDataPtr d) :
         JSONValue() {
@@ -177,24 +289,40 @@ spark::JSONType spark::JSONValue::type() const {
 }
 
 spark::JSONValue spark::JSONValue::parse(char *json, size_t size) {
-    detail::JSONDataPtr d(new(std::nothrow) detail::JSONData);
+    return parse(json, size, false /* copy */, nullptr /* alloc */);
+}
+
+spark::JSONValue spark::JSONValue::parseCopy(const char *json, size_t size) {
+    return parse(const_cast<char*>(json), size, true /* copy */, nullptr /* alloc */);
+}
+
+spark::JSONValue spark::JSONValue::parse(char *json, size_t size, particle::SimpleAllocator* alloc) {
+    return parse(json, size, false /* copy */, alloc);
+}
+
+spark::JSONValue spark::JSONValue::parseCopy(const char *json, size_t size, particle::SimpleAllocator* alloc) {
+    return parse(const_cast<char*>(json), size, true /* copy */, alloc);
+}
+
+spark::JSONValue spark::JSONValue::parse(char *json, size_t size, bool copy, particle::SimpleAllocator* alloc) {
+    detail::JSONDataPtr d(detail::JSONData::create(alloc));
     if (!d) {
         return JSONValue();
     }
     size_t tokenCount = 0;
-    if (!tokenize(json, size, &d->tokens, &tokenCount)) {
+    if (!tokenize(json, size, &d->tokens, &tokenCount, alloc)) {
         return JSONValue();
     }
     const jsmntok_t *t = d->tokens; // Root token
-    if (t->type == JSMN_PRIMITIVE) {
-        // RFC 7159 allows JSON document to consist of a single primitive value, such as a number.
-        // In this case, original data is copied to a larger buffer to ensure room for term. null
-        // character (see stringize() method)
-        d->json = new(std::nothrow) char[size + 1];
+    // RFC 7159 allows JSON document to consist of a single primitive value, such as a number.
+    // In this case, original data is copied to a larger buffer to ensure room for term. null
+    // character (see stringize() method)
+    if (copy || t->type == JSMN_PRIMITIVE) {
+        d->json = (char*)d->malloc(size + 1);
         if (!d->json) {
             return JSONValue();
         }
-        memcpy(d->json, json, size);
+        memcpy(d->json, json, size); // TODO: Copy only token data
         d->freeJson = true; // Set ownership flag
     } else {
         d->json = json;
@@ -205,28 +333,8 @@ spark::JSONValue spark::JSONValue::parse(char *json, size_t size) {
     return JSONValue(t, d);
 }
 
-spark::JSONValue spark::JSONValue::parseCopy(const char *json, size_t size) {
-    detail::JSONDataPtr d(new(std::nothrow) detail::JSONData);
-    if (!d) {
-        return JSONValue();
-    }
-    size_t tokenCount = 0;
-    if (!tokenize(json, size, &d->tokens, &tokenCount)) {
-        return JSONValue();
-    }
-    d->json = new(std::nothrow) char[size + 1];
-    if (!d->json) {
-        return JSONValue();
-    }
-    memcpy(d->json, json, size); // TODO: Copy only token data
-    d->freeJson = true;
-    if (!stringize(d->tokens, tokenCount, d->json)) {
-        return JSONValue();
-    }
-    return JSONValue(d->tokens, d);
-}
-
-bool spark::JSONValue::tokenize(const char *json, size_t size, jsmntok_t **tokens, size_t *count) {
+bool spark::JSONValue::tokenize(const char *json, size_t size, jsmntok_t **tokens, size_t *count,
+        particle::SimpleAllocator* alloc) {
     jsmn_parser parser;
     parser.size = sizeof(jsmn_parser);
     jsmn_init(&parser, nullptr);
@@ -234,15 +342,21 @@ bool spark::JSONValue::tokenize(const char *json, size_t size, jsmntok_t **token
     if (n <= 0) {
         return false; // Parsing error
     }
-    std::unique_ptr<jsmntok_t[]> t(new(std::nothrow) jsmntok_t[n]);
+    const size_t tokensSize = n * sizeof(jsmntok_t);
+    const auto t = (jsmntok_t*)(alloc ? alloc->alloc(tokensSize) : ::malloc(tokensSize));
     if (!t) {
         return false;
     }
     jsmn_init(&parser, nullptr); // Reset parser
-    if (jsmn_parse(&parser, json, size, t.get(), n, nullptr) <= 0) {
+    if (jsmn_parse(&parser, json, size, t, n, nullptr) <= 0) {
+        if (alloc) {
+            alloc->free(t);
+        } else {
+            ::free(t);
+        }
         return false;
     }
-    *tokens = t.release();
+    *tokens = t;
     *count = n;
     return true;
 }
@@ -491,22 +605,12 @@ spark::JSONWriter& spark::JSONWriter::nullValue() {
 }
 
 void spark::JSONWriter::printf(const char *fmt, ...) {
-    char buf[16];
     va_list args;
     va_start(args, fmt);
-    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    particle::vformatTo([](const char* data, size_t size, void* ctx) {
+        static_cast<JSONWriter*>(ctx)->write(data, size);
+    }, this, fmt, args);
     va_end(args);
-    if ((size_t)n >= sizeof(buf)) {
-        char buf[n + 1]; // Use larger buffer
-        va_start(args, fmt);
-        n = vsnprintf(buf, sizeof(buf), fmt, args);
-        va_end(args);
-        if (n > 0) {
-            write(buf, n);
-        }
-    } else if (n > 0) {
-        write(buf, n);
-    }
 }
 
 void spark::JSONWriter::writeSeparator() {
@@ -529,33 +633,45 @@ void spark::JSONWriter::writeEscaped(const char *str, size_t size) {
     while (s != end) {
         const char c = *s;
         if (c == '"' || c == '\\' || (c >= 0 && c <= 0x1f)) {
-            write(str, s - str); // Write preceeding characters
-            write('\\');
+            if (s != str) {
+                write(str, s - str); // Write preceeding characters
+            }
+            // Write the escape sequence in one go
+            char esc[6] = { '\\' };
+            size_t n = 2;
             switch (c) {
             case '"':
             case '\\':
-                write(c);
+                esc[1] = c;
                 break;
             case 0x08: // Backspace
-                write('b');
+                esc[1] = 'b';
                 break;
             case 0x09: // Tab
-                write('t');
+                esc[1] = 't';
                 break;
             case 0x0a: // Line feed
-                write('n');
+                esc[1] = 'n';
                 break;
             case 0x0c: // Form feed
-                write('f');
+                esc[1] = 'f';
                 break;
             case 0x0d: // Carriage return
-                write('r');
+                esc[1] = 'r';
                 break;
-            default:
+            default: {
                 // All other control characters are written in hex, e.g. "\u001f"
-                printf("u%04x", (unsigned)c);
+                static const char hex[] = "0123456789abcdef";
+                esc[1] = 'u';
+                esc[2] = '0';
+                esc[3] = '0';
+                esc[4] = hex[(c >> 4) & 0x0f];
+                esc[5] = hex[c & 0x0f];
+                n = 6;
                 break;
             }
+            }
+            write(esc, n);
             str = s + 1;
         }
         ++s;
@@ -566,6 +682,27 @@ void spark::JSONWriter::writeEscaped(const char *str, size_t size) {
     write('"');
 }
 
+// spark::JSONBufferedStreamWriter
+void spark::JSONBufferedStreamWriter::flush() {
+    if (n_ > 0) {
+        JSONStreamWriter::write(buf_, n_);
+        n_ = 0;
+    }
+}
+
+void spark::JSONBufferedStreamWriter::write(const char *data, size_t size) {
+    if (n_ + size > bufSize_) {
+        flush();
+        if (size >= bufSize_) {
+            // Large chunks are passed to the stream directly
+            JSONStreamWriter::write(data, size);
+            return;
+        }
+    }
+    memcpy(buf_ + n_, data, size);
+    n_ += size;
+}
+
 // spark::JSONBufferWriter
 void spark::JSONBufferWriter::write(const char *data, size_t size) {
     if (n_ < bufSize_) {
@@ -581,3 +718,276 @@ void spark::JSONBufferWriter::printf(const char *fmt, ...) {
     va_end(args);
     n_ += n;
 }
+
+// spark::JSONStreamParser
+bool spark::JSONStreamParser::parse(const char *data, size_t size) {
+    if (state_ == ERROR) {
+        return false;
+    }
+    const char* const end = data + size;
+    while (data != end) {
+        if (!process(*data)) {
+            state_ = ERROR;
+            return false;
+        }
+        ++data;
+    }
+    return true;
+}
+
+bool spark::JSONStreamParser::finish() {
+    if (state_ == LITERAL && !depth_ && !endLiteral()) { // RFC 7159 allows a document to consist of a single primitive value
+        state_ = ERROR;
+    }
+    if (state_ != NEXT || depth_) {
+        state_ = ERROR;
+        return false;
+    }
+    return true;
+}
+
+void spark::JSONStreamParser::reset() {
+    n_ = 0;
+    objects_ = 0;
+    code_ = 0;
+    highSurrogate_ = 0;
+    digits_ = 0;
+    depth_ = 0;
+    state_ = VALUE;
+    name_ = false;
+}
+
+bool spark::JSONStreamParser::process(char c) {
+    switch (state_) {
+    case STRING: {
+        if (c == '\\') {
+            state_ = STRING_ESCAPE;
+            return true;
+        }
+        if (highSurrogate_ && !appendHighSurrogate()) {
+            return false;
+        }
+        if (c == '"') {
+            return endString();
+        }
+        if (c >= 0 && c <= 0x1f) {
+            return false; // Control characters must be escaped
+        }
+        return append(c);
+    }
+    case STRING_ESCAPE: {
+        state_ = STRING;
+        if (c == 'u') { // Arbitrary character, e.g. "\u001f"
+            state_ = STRING_UNICODE;
+            code_ = 0;
+            digits_ = 0;
+            return true;
+        }
+        if (highSurrogate_ && !appendHighSurrogate()) {
+            return false;
+        }
+        switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+            return append(c);
+        case 'b': // Backspace
+            return append(0x08);
+        case 't': // Tab
+            return append(0x09);
+        case 'n': // Line feed
+            return append(0x0a);
+        case 'f': // Form feed
+            return append(0x0c);
+        case 'r': // Carriage return
+            return append(0x0d);
+        default:
+            return false; // Invalid escaped sequence
+        }
+    }
+    case STRING_UNICODE: {
+        uint32_t n = 0;
+        if (!hexToInt(&c, 1, &n)) {
+            return false; // Invalid escaped sequence
+        }
+        code_ = (code_ << 4) | n;
+        if (++digits_ < 4) {
+            return true;
+        }
+        state_ = STRING;
+        return appendCodeUnit();
+    }
+    case LITERAL: {
+        if (isLiteralChar(c)) {
+            return append(c);
+        }
+        if (!endLiteral()) {
+            return false;
+        }
+        break; // Process the character following the literal
+    }
+    case ERROR:
+        return false;
+    default:
+        break;
+    }
+    if (isSpace(c)) {
+        return true;
+    }
+    switch (state_) {
+    case FIRST_ELEMENT:
+        if (c == ']') {
+            return endCompound(false);
+        }
+        return beginValue(c);
+    case VALUE:
+        return beginValue(c);
+    case FIRST_NAME:
+        if (c == '}') {
+            return endCompound(true);
+        }
+        // Fall through
+    case NAME:
+        if (c != '"') {
+            return false;
+        }
+        n_ = 0;
+        name_ = true;
+        state_ = STRING;
+        return true;
+    case COLON:
+        if (c != ':') {
+            return false;
+        }
+        state_ = VALUE;
+        return true;
+    case NEXT:
+        if (!depth_) {
+            return false; // Unexpected data after the end of the document
+        }
+        if (c == ',') {
+            state_ = inObject() ? NAME : VALUE;
+            return true;
+        }
+        if (c == ']' || c == '}') {
+            return endCompound(c == '}');
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+bool spark::JSONStreamParser::beginValue(char c) {
+    if (c == '[' || c == '{') {
+        if (depth_ == MAX_DEPTH) {
+            return false;
+        }
+        const bool object = (c == '{');
+        if (object) {
+            objects_ |= (uint32_t)1 << depth_;
+        } else {
+            objects_ &= ~((uint32_t)1 << depth_);
+        }
+        ++depth_;
+        state_ = object ? FIRST_NAME : FIRST_ELEMENT;
+        return object ? handler_->beginObject() : handler_->beginArray();
+    }
+    n_ = 0;
+    if (c == '"') {
+        name_ = false;
+        state_ = STRING;
+        return true;
+    }
+    if (isLiteralChar(c)) {
+        state_ = LITERAL;
+        return append(c);
+    }
+    return false;
+}
+
+bool spark::JSONStreamParser::endCompound(bool object) {
+    if (!depth_ || inObject() != object) {
+        return false;
+    }
+    --depth_;
+    state_ = NEXT;
+    return object ? handler_->endObject() : handler_->endArray();
+}
+
+bool spark::JSONStreamParser::endString() {
+    buf_[n_] = '\0';
+    if (name_) {
+        state_ = COLON;
+        return handler_->name(buf_, n_);
+    }
+    state_ = NEXT;
+    return handler_->value(buf_, n_);
+}
+
+bool spark::JSONStreamParser::endLiteral() {
+    buf_[n_] = '\0';
+    state_ = NEXT;
+    if (strcmp(buf_, "true") == 0) {
+        return handler_->value(true);
+    }
+    if (strcmp(buf_, "false") == 0) {
+        return handler_->value(false);
+    }
+    if (strcmp(buf_, "null") == 0) {
+        return handler_->nullValue();
+    }
+    if (!isNumber(buf_, n_)) {
+        return false;
+    }
+    return handler_->number(buf_, n_);
+}
+
+bool spark::JSONStreamParser::appendCodeUnit() {
+    if (code_ >= 0xdc00 && code_ <= 0xdfff && highSurrogate_) { // Low surrogate
+        const uint32_t c = 0x10000 + (((uint32_t)highSurrogate_ - 0xd800) << 10) + (code_ - 0xdc00);
+        highSurrogate_ = 0;
+        return appendCodePoint(c);
+    }
+    if (highSurrogate_ && !appendHighSurrogate()) {
+        return false;
+    }
+    if (code_ >= 0xd800 && code_ <= 0xdbff) { // High surrogate
+        highSurrogate_ = code_;
+        return true;
+    }
+    return appendCodePoint(code_);
+}
+
+bool spark::JSONStreamParser::appendCodePoint(uint32_t c) {
+    // Encode the character in UTF-8
+    if (c <= 0x7f) {
+        return append(c);
+    }
+    if (c <= 0x7ff) {
+        return append(0xc0 | (c >> 6)) && append(0x80 | (c & 0x3f));
+    }
+    if (c <= 0xffff) {
+        return append(0xe0 | (c >> 12)) && append(0x80 | ((c >> 6) & 0x3f)) && append(0x80 | (c & 0x3f));
+    }
+    return append(0xf0 | (c >> 18)) && append(0x80 | ((c >> 12) & 0x3f)) && append(0x80 | ((c >> 6) & 0x3f)) &&
+            append(0x80 | (c & 0x3f));
+}
+
+bool spark::JSONStreamParser::appendHighSurrogate() {
+    // High surrogate that is not followed by a low surrogate is replaced with U+FFFD
+    highSurrogate_ = 0;
+    return appendCodePoint(0xfffd);
+}
+
+bool spark::JSONStreamParser::append(char c) {
+    if (n_ + 1 >= bufSize_) {
+        return false; // Reserve space for the term. null
+    }
+    buf_[n_++] = c;
+    return true;
+}
+
+bool spark::JSONStreamParser::inObject() const {
+    return depth_ && (objects_ & ((uint32_t)1 << (depth_ - 1)));
+}
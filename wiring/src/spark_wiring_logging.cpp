@@ -21,6 +21,7 @@
 #include <cstring>
 
 #include "spark_wiring_logging.h"
+#include "syslog_log_handler.h"
 
 #include <algorithm>
 #include <cinttypes>
@@ -31,6 +32,14 @@
 #include "spark_wiring_usartserial.h"
 #include "spark_wiring_interrupts.h"
 
+#if PLATFORM_THREADING
+#include "record_buffer.h"
+#include "timer_hal.h"
+#include "check.h"
+
+#include <atomic>
+#endif
+
 // Uncomment to enable logging in interrupt handlers
 // #define LOG_FROM_ISR
 
@@ -387,11 +396,15 @@ struct spark::detail::LogFilter::Node {
 };
 
 spark::detail::LogFilter::LogFilter(LogLevel level) :
-        level_(level) {
+        level_(level),
+        minLevel_(level),
+        maxLevel_(level) {
 }
 
 spark::detail::LogFilter::LogFilter(LogLevel level, LogCategoryFilters filters) :
-        level_(LOG_LEVEL_NONE) { // Fallback level that will be used in case of construction errors
+        level_(LOG_LEVEL_NONE), // Fallback level that will be used in case of construction errors
+        minLevel_(LOG_LEVEL_NONE),
+        maxLevel_(LOG_LEVEL_NONE) {
     // Store category names
     Vector<String> cats;
     if (!cats.reserve(filters.size())) {
@@ -402,6 +415,8 @@ spark::detail::LogFilter::LogFilter(LogLevel level, LogCategoryFilters filters)
     }
     // Process category filters
     Vector<Node> nodes;
+    LogLevel minLevel = level;
+    LogLevel maxLevel = level;
     for (int i = 0; i < cats.size(); ++i) {
         const char *category = cats.at(i).c_str();
         if (!category) {
@@ -418,7 +433,10 @@ spark::detail::LogFilter::LogFilter(LogLevel level, LogCategoryFilters filters)
             }
             Node &node = pNodes->at(index);
             if (!*category) { // Check if it's last subcategory
-                node.level = filters.at(i).level_;
+                const LogLevel catLevel = filters.at(i).level_;
+                node.level = catLevel;
+                minLevel = std::min(minLevel, catLevel);
+                maxLevel = std::max(maxLevel, catLevel);
             }
             pNodes = &node.nodes;
         }
@@ -427,6 +445,8 @@ spark::detail::LogFilter::LogFilter(LogLevel level, LogCategoryFilters filters)
     swap(cats_, cats);
     swap(nodes_, nodes);
     level_ = level;
+    minLevel_ = minLevel;
+    maxLevel_ = maxLevel;
 }
 
 spark::detail::LogFilter::~LogFilter() {
@@ -434,7 +454,7 @@ spark::detail::LogFilter::~LogFilter() {
 
 LogLevel spark::detail::LogFilter::level(const char *category) const {
     LogLevel level = level_; // Default level
-    if (!nodes_.isEmpty() && category) {
+    if (minLevel_ != maxLevel_ && category) {
         const Vector<Node> *pNodes = &nodes_; // Root nodes
         const char *name = nullptr; // Subcategory name
         size_t size = 0; // Name length
@@ -547,7 +567,9 @@ void spark::JSONStreamLogHandler::logMessage(const char *msg, LogLevel level, co
         return; // Do not mix logging and serial console output
     }
 #endif
-    JSONStreamWriter json(*this->stream());
+    // Escaped strings and separators are written in small pieces, collect them in a buffer
+    char buf[64];
+    JSONBufferedStreamWriter json(*this->stream(), buf, sizeof(buf));
     json.beginObject();
     // Level
     const char *s = levelName(level);
@@ -588,6 +610,7 @@ void spark::JSONStreamLogHandler::logMessage(const char *msg, LogLevel level, co
         json.name("detail", 6).value(attr.details);
     }
     json.endObject();
+    json.flush();
     this->stream()->write((const uint8_t*)"\r\n", 2);
 }
 
@@ -607,9 +630,57 @@ LogHandler* spark::DefaultLogHandlerFactory::createHandler(const char *type, Log
         }
         return new(std::nothrow) StreamLogHandler(*stream, level, std::move(filters));
     }
+#if Wiring_SyslogLogHandler
+    else if (strcmp(type, "SyslogLogHandler") == 0) {
+        return createSyslogHandler(level, std::move(filters), params);
+    }
+#endif
     return nullptr; // Unknown handler type
 }
 
+#if Wiring_SyslogLogHandler
+
+LogHandler* spark::DefaultLogHandlerFactory::createSyslogHandler(LogLevel level, LogCategoryFilters filters,
+        const JSONValue &params) {
+    String host, appName;
+    int port = SyslogLogHandler::DEFAULT_PORT;
+    int size = SyslogLogHandler::DEFAULT_DATAGRAM_SIZE;
+    int interval = SyslogLogHandler::DEFAULT_FLUSH_INTERVAL;
+    int rate = SyslogLogHandler::DEFAULT_MAX_RATE;
+    int facility = SyslogLogHandler::DEFAULT_FACILITY;
+    JSONObjectIterator it(params);
+    while (it.next()) {
+        if (it.name() == "host") {
+            host = (const char*)it.value().toString();
+        } else if (it.name() == "port") {
+            port = it.value().toInt();
+        } else if (it.name() == "size") {
+            size = it.value().toInt();
+        } else if (it.name() == "interval") {
+            interval = it.value().toInt();
+        } else if (it.name() == "rate") {
+            rate = it.value().toInt();
+        } else if (it.name() == "facility") {
+            facility = it.value().toInt();
+        } else if (it.name() == "app") {
+            appName = (const char*)it.value().toString();
+        }
+    }
+    if (!host.length() || port <= 0 || size <= 0 || interval <= 0 || rate < 0 || facility < 0) {
+        return nullptr;
+    }
+    const auto h = new(std::nothrow) SyslogLogHandler(host.c_str(), port, level, std::move(filters));
+    if (!h) {
+        return nullptr;
+    }
+    h->datagramSize(size).flushInterval(interval).maxRate(rate).facility(facility).appName(appName.c_str());
+    // The handler is meant to send its datagrams from the logging thread
+    LogManager::instance()->enableAsyncMode();
+    return h;
+}
+
+#endif // Wiring_SyslogLogHandler
+
 spark::DefaultLogHandlerFactory* spark::DefaultLogHandlerFactory::instance() {
     static DefaultLogHandlerFactory factory;
     return &factory;
@@ -684,16 +755,242 @@ struct spark::LogManager::FactoryHandler {
 
 #endif // Wiring_LogConfig
 
+#if PLATFORM_THREADING
+
+/*
+    Asynchronous output.
+
+    The producers encode every log message into a record and store it in a lock-free ring buffer.
+    The output thread decodes the records and passes them to the log handlers. A record consists
+    of an AsyncRecord structure followed by the category name, the message text or written data,
+    and the value of the details attribute, each of which is null-terminated.
+*/
+struct spark::LogManager::AsyncOutput {
+    enum RecordType: uint8_t {
+        MESSAGE = 1, // log_message()
+        WRITE = 2 // log_write()
+    };
+
+    struct AsyncRecord {
+        uint8_t type; // Record type
+        uint8_t level; // Logging level
+        uint8_t categorySize; // Length of the category name, or NO_CATEGORY
+        uint8_t reserved;
+        uint16_t dataSize; // Length of the message text or size of the written data
+        uint16_t detailsSize; // Length of the details attribute
+        uint32_t flags; // Attribute flags
+        uint32_t time;
+        int line;
+        const char *file;
+        const char *function;
+        intptr_t code;
+    };
+
+    static const uint8_t NO_CATEGORY = 0xff;
+    static const size_t MAX_CATEGORY_SIZE = 0xfe;
+    static const size_t MAX_DATA_SIZE = 0xffff;
+
+    // The output thread is only supposed to run when no other threads have work to do
+    static const os_thread_prio_t THREAD_PRIORITY = OS_THREAD_PRIORITY_DEFAULT - 1;
+
+    std::unique_ptr<uint32_t[]> buffer;
+    particle::services::MpscRecordBuffer records;
+    Thread thread;
+    os_semaphore_t sem;
+    os_thread_t volatile threadHandle;
+    std::atomic<bool> enabled;
+    std::atomic<bool> notified; // Set if the output thread has been notified about new records
+    std::atomic<unsigned> dropped; // Number of dropped messages
+    unsigned droppedReported; // Number of dropped messages reported to the handlers
+    volatile bool stop;
+
+    AsyncOutput();
+    ~AsyncOutput();
+
+    int init(LogManager *mgr, size_t bufferSize);
+
+    void put(RecordType type, const char *data, size_t dataSize, int level, const char *category,
+            const LogAttributes *attr);
+    void process(LogManager *mgr);
+
+    void run(LogManager *mgr);
+};
+
+const size_t spark::LogManager::AsyncOutput::MAX_CATEGORY_SIZE;
+const size_t spark::LogManager::AsyncOutput::MAX_DATA_SIZE;
+
+spark::LogManager::AsyncOutput::AsyncOutput() :
+        sem(nullptr),
+        threadHandle(nullptr),
+        enabled(false),
+        notified(false),
+        dropped(0),
+        droppedReported(0),
+        stop(false) {
+}
+
+spark::LogManager::AsyncOutput::~AsyncOutput() {
+    if (thread.isValid()) {
+        stop = true;
+        os_semaphore_give(sem, false);
+        thread.dispose();
+    }
+    if (sem) {
+        os_semaphore_destroy(sem);
+    }
+}
+
+int spark::LogManager::AsyncOutput::init(LogManager *mgr, size_t bufferSize) {
+    CHECK_TRUE(bufferSize >= sizeof(uint32_t), SYSTEM_ERROR_INVALID_ARGUMENT);
+    buffer.reset(new(std::nothrow) uint32_t[bufferSize / sizeof(uint32_t)]);
+    CHECK_TRUE(buffer, SYSTEM_ERROR_NO_MEMORY);
+    CHECK(records.init(buffer.get(), bufferSize));
+    CHECK_TRUE(os_semaphore_create(&sem, 1, 0) == 0, SYSTEM_ERROR_NO_MEMORY);
+    thread = Thread("log", [this, mgr]() {
+        run(mgr);
+    }, THREAD_PRIORITY, OS_THREAD_STACK_SIZE_DEFAULT);
+    CHECK_TRUE(thread.isValid(), SYSTEM_ERROR_NO_MEMORY);
+    return 0;
+}
+
+void spark::LogManager::AsyncOutput::put(RecordType type, const char *data, size_t dataSize, int level,
+        const char *category, const LogAttributes *attr) {
+    if (os_thread_is_current(threadHandle)) {
+        return; // Prevent re-entry from the handlers
+    }
+    AsyncRecord r = {};
+    r.type = type;
+    r.level = level;
+    r.categorySize = category ? std::min(strlen(category), MAX_CATEGORY_SIZE) : NO_CATEGORY;
+    r.dataSize = std::min(dataSize, MAX_DATA_SIZE);
+    if (attr) {
+        // The file and function names are expected to be string literals
+        r.flags = attr->flags;
+        r.time = attr->time;
+        r.line = attr->line;
+        r.file = attr->file;
+        r.function = attr->function;
+        r.code = attr->code;
+        if (attr->has_details && attr->details) {
+            r.detailsSize = std::min(strlen(attr->details), MAX_DATA_SIZE);
+        }
+    }
+    const size_t categorySize = category ? r.categorySize : 0;
+    const size_t size = sizeof(AsyncRecord) + categorySize + r.dataSize + r.detailsSize + 3;
+    char *p = (char*)records.acquire(size);
+    if (!p) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    void* const rec = p;
+    memcpy(p, &r, sizeof(AsyncRecord));
+    p += sizeof(AsyncRecord);
+    if (categorySize) {
+        memcpy(p, category, categorySize);
+        p += categorySize;
+    }
+    *p++ = '\0';
+    if (r.dataSize) {
+        memcpy(p, data, r.dataSize);
+        p += r.dataSize;
+    }
+    *p++ = '\0';
+    if (r.detailsSize) {
+        memcpy(p, attr->details, r.detailsSize);
+        p += r.detailsSize;
+    }
+    *p = '\0';
+    records.commit(rec);
+    if (!notified.exchange(true)) {
+        os_semaphore_give(sem, false);
+    }
+}
+
+void spark::LogManager::AsyncOutput::process(LogManager *mgr) {
+    for (;;) {
+        LOG_WITH_LOCK(mgr->mutex_) {
+            // The lock is held only while a single record is being processed, so that logEnabled()
+            // doesn't have to wait for the output thread
+            const char *p = (const char*)records.peek(nullptr);
+            if (!p) {
+                const unsigned n = dropped.load(std::memory_order_relaxed);
+                if (n != droppedReported) {
+                    char msg[48];
+                    snprintf(msg, sizeof(msg), "%u log message(s) dropped", n - droppedReported);
+                    droppedReported = n;
+                    LogAttributes attr = {};
+                    attr.size = sizeof(LogAttributes);
+                    LOG_ATTR_SET(attr, time, HAL_Timer_Get_Milli_Seconds());
+                    mgr->setActive(true);
+                    for (LogHandler *handler: mgr->activeHandlers_) {
+                        handler->message(msg, LOG_LEVEL_WARN, nullptr, attr);
+                    }
+                    mgr->setActive(false);
+                }
+                return;
+            }
+            AsyncRecord r = {};
+            memcpy(&r, p, sizeof(AsyncRecord));
+            p += sizeof(AsyncRecord);
+            const char* const category = (r.categorySize != NO_CATEGORY) ? p : nullptr;
+            p += (category ? r.categorySize : 0) + 1;
+            const char* const data = p;
+            p += r.dataSize + 1;
+            mgr->setActive(true);
+            if (r.type == MESSAGE) {
+                LogAttributes attr = {};
+                attr.size = sizeof(LogAttributes);
+                attr.flags = r.flags;
+                attr.time = r.time;
+                attr.line = r.line;
+                attr.file = r.file;
+                attr.function = r.function;
+                attr.code = r.code;
+                if (attr.has_details) {
+                    attr.details = p;
+                }
+                for (LogHandler *handler: mgr->activeHandlers_) {
+                    handler->message(data, (LogLevel)r.level, category, attr);
+                }
+            } else {
+                for (LogHandler *handler: mgr->activeHandlers_) {
+                    handler->write(data, r.dataSize, (LogLevel)r.level, category);
+                }
+            }
+            mgr->setActive(false);
+            records.release();
+        }
+    }
+}
+
+void spark::LogManager::AsyncOutput::run(LogManager *mgr) {
+    threadHandle = os_thread_current(nullptr);
+    while (!stop) {
+        os_semaphore_take(sem, CONCURRENT_WAIT_FOREVER, false);
+        // Producers that commit a record after this point will notify the thread again
+        notified.store(false);
+        process(mgr);
+    }
+}
+
+#endif // PLATFORM_THREADING
+
 spark::LogManager::LogManager() {
 #if Wiring_LogConfig
     handlerFactory_ = DefaultLogHandlerFactory::instance();
     streamFactory_ = DefaultOutputStreamFactory::instance();
+#endif
+#if PLATFORM_THREADING
+    async_ = nullptr;
 #endif
     outputActive_ = false;
 }
 
 spark::LogManager::~LogManager() {
     resetSystemCallbacks();
+#if PLATFORM_THREADING
+    delete async_;
+#endif
 #if Wiring_LogConfig
     LOG_WITH_LOCK(mutex_) {
          destroyFactoryHandlers();
@@ -706,21 +1003,60 @@ bool spark::LogManager::addHandler(LogHandler *handler) {
         if (activeHandlers_.contains(handler) || !activeHandlers_.append(handler)) {
             return false;
         }
-        if (activeHandlers_.size() == 1) {
-            setSystemCallbacks();
-        }
+        handlersChanged();
     }
     return true;
 }
 
 void spark::LogManager::removeHandler(LogHandler *handler) {
     LOG_WITH_LOCK(mutex_) {
-        if (activeHandlers_.removeOne(handler) && activeHandlers_.isEmpty()) {
-            resetSystemCallbacks();
+        if (activeHandlers_.removeOne(handler)) {
+            handlersChanged();
         }
     }
 }
 
+#if PLATFORM_THREADING
+
+int spark::LogManager::enableAsyncMode(size_t bufferSize) {
+    LOG_WITH_LOCK(mutex_) {
+        if (!async_) {
+            std::unique_ptr<AsyncOutput> async(new(std::nothrow) AsyncOutput());
+            CHECK_TRUE(async, SYSTEM_ERROR_NO_MEMORY);
+            CHECK(async->init(this, bufferSize));
+            // Producers access the output without locking
+            __atomic_store_n(&async_, async.release(), __ATOMIC_RELEASE);
+        }
+        async_->enabled.store(true, std::memory_order_release);
+    }
+    return 0;
+}
+
+void spark::LogManager::disableAsyncMode() {
+    LOG_WITH_LOCK(mutex_) {
+        if (async_ && async_->enabled.load(std::memory_order_relaxed)) {
+            async_->enabled.store(false, std::memory_order_release);
+            async_->process(this);
+        }
+    }
+}
+
+bool spark::LogManager::isAsyncMode() const {
+    return asyncOutput();
+}
+
+unsigned spark::LogManager::droppedMessageCount() const {
+    const AsyncOutput* const async = __atomic_load_n(&async_, __ATOMIC_ACQUIRE);
+    return async ? async->dropped.load(std::memory_order_relaxed) : 0;
+}
+
+inline spark::LogManager::AsyncOutput* spark::LogManager::asyncOutput() const {
+    AsyncOutput* const async = __atomic_load_n(&async_, __ATOMIC_ACQUIRE);
+    return (async && async->enabled.load(std::memory_order_acquire)) ? async : nullptr;
+}
+
+#endif // PLATFORM_THREADING
+
 spark::LogManager* spark::LogManager::instance() {
     static LogManager mgr;
     return &mgr;
@@ -764,9 +1100,7 @@ bool spark::LogManager::addFactoryHandler(const char *id, const char *handlerTyp
             factoryHandlers_.takeLast(); // Revert factoryHandlers_.append()
             return false;
         }
-        if (activeHandlers_.size() == 1) {
-            setSystemCallbacks();
-        }
+        handlersChanged();
         handler.release(); // Release scope guard pointers
         stream.release();
     }
@@ -810,9 +1144,7 @@ void spark::LogManager::destroyFactoryHandler(const char *id) {
         const FactoryHandler &h = factoryHandlers_.at(i);
         if (h.id == id) {
             activeHandlers_.removeOne(h.handler);
-            if (activeHandlers_.isEmpty()) {
-                resetSystemCallbacks();
-            }
+            handlersChanged();
             handlerFactory_->destroyHandler(h.handler);
             if (h.stream) {
                 streamFactory_->destroyStream(h.stream);
@@ -826,9 +1158,7 @@ void spark::LogManager::destroyFactoryHandler(const char *id) {
 void spark::LogManager::destroyFactoryHandlers() {
     for (const FactoryHandler &h: factoryHandlers_) {
         activeHandlers_.removeOne(h.handler);
-        if (activeHandlers_.isEmpty()) {
-            resetSystemCallbacks();
-        }
+        handlersChanged();
         handlerFactory_->destroyHandler(h.handler);
         if (h.stream) {
             streamFactory_->destroyStream(h.stream);
@@ -839,6 +1169,26 @@ void spark::LogManager::destroyFactoryHandlers() {
 
 #endif // Wiring_LogConfig
 
+void spark::LogManager::handlersChanged() {
+    if (activeHandlers_.isEmpty()) {
+        resetSystemCallbacks();
+        return;
+    }
+    if (activeHandlers_.size() == 1) {
+        setSystemCallbacks();
+    }
+    // Let the system discard the messages that none of the handlers would accept before they
+    // get formatted
+    int minLevel = LOG_LEVEL_NONE;
+    for (LogHandler *handler: activeHandlers_) {
+        const int level = handler->minLevel();
+        if (level < minLevel) {
+            minLevel = level;
+        }
+    }
+    log_set_level_threshold(minLevel, nullptr);
+}
+
 void spark::LogManager::setSystemCallbacks() {
     log_set_callbacks(logMessage, logWrite, logEnabled, nullptr);
 }
@@ -854,6 +1204,13 @@ void spark::LogManager::logMessage(const char *msg, int level, const char *categ
     }
 #endif
     LogManager *that = instance();
+#if PLATFORM_THREADING
+    AsyncOutput* const async = that->asyncOutput();
+    if (async) {
+        async->put(AsyncOutput::MESSAGE, msg, strlen(msg), level, category, attr);
+        return;
+    }
+#endif
     LOG_WITH_LOCK(that->mutex_) {
         // prevent re-entry
         if (that->isActive()) {
@@ -874,6 +1231,13 @@ void spark::LogManager::logWrite(const char *data, size_t size, int level, const
     }
 #endif
     LogManager *that = instance();
+#if PLATFORM_THREADING
+    AsyncOutput* const async = that->asyncOutput();
+    if (async) {
+        async->put(AsyncOutput::WRITE, data, size, level, category, nullptr);
+        return;
+    }
+#endif
     LOG_WITH_LOCK(that->mutex_) {
         // prevent re-entry
         if (that->isActive()) {
@@ -895,17 +1259,35 @@ int spark::LogManager::logEnabled(int level, const char *category, void *reserve
 #endif
     LogManager *that = instance();
     int minLevel = LOG_LEVEL_NONE;
-    LOG_WITH_LOCK(that->mutex_) {
-        for (LogHandler *handler: that->activeHandlers_) {
-            const int level = handler->level(category);
-            if (level < minLevel) {
-                minLevel = level;
-            }
+#if PLATFORM_THREADING && !defined(LOG_FROM_ISR)
+    if (that->asyncOutput()) {
+        // Don't wait while the output thread is passing a message to the handlers. The handlers
+        // will filter the message once it's processed
+        if (!that->mutex_.trylock()) {
+            return 1;
         }
+        minLevel = that->minLevel(category);
+        that->mutex_.unlock();
+        return (level >= minLevel);
+    }
+#endif
+    LOG_WITH_LOCK(that->mutex_) {
+        minLevel = that->minLevel(category);
     }
     return (level >= minLevel);
 }
 
+int spark::LogManager::minLevel(const char *category) const {
+    int minLevel = LOG_LEVEL_NONE;
+    for (LogHandler *handler: activeHandlers_) {
+        const int level = handler->level(category);
+        if (level < minLevel) {
+            minLevel = level;
+        }
+    }
+    return minLevel;
+}
+
 inline bool spark::LogManager::isActive() const {
     return outputActive_;
 }
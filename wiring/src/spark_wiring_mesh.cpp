@@ -24,6 +24,9 @@
 
 #include <arpa/inet.h>
 #include "delay_hal.h"
+#include "spark_wiring_ticks.h"
+
+#include <algorithm>
 
 namespace spark {
 
@@ -81,6 +84,7 @@ int MeshPublish::Subscriptions::add_event_handler(const char *event_name, EventH
             memcpy(event_handlers[i].device_id, id, id_len);
             event_handlers[i].device_id[id_len] = 0;
             event_handlers[i].scope = scope;
+            filter_index.update(event_handlers);
             return SYSTEM_ERROR_NONE;
         }
     }
@@ -95,33 +99,14 @@ int MeshPublish::Subscriptions::add(const char* name, EventHandler handler)
 
 void MeshPublish::Subscriptions::send(const char* event_name, const char* data)
 {
-    const size_t event_name_length = strlen(event_name);
-    const int NUM_HANDLERS = sizeof(event_handlers) / sizeof(FilteringEventHandler);
-    for (int i = 0; i < NUM_HANDLERS; i++)
+    // handlers are invoked in the order of their registration
+    const auto matched = filter_index.match(event_handlers, event_name, strlen(event_name));
+    for (auto m = matched; m; m &= m - 1)
     {
-        if (NULL == event_handlers[i].handler)
-        {
-            break;
-        }
-        const size_t MAX_FILTER_LENGTH = sizeof(event_handlers[i].filter);
-        const size_t filter_length = strnlen(event_handlers[i].filter,
-                MAX_FILTER_LENGTH);
-
-        if (event_name_length < filter_length)
-        {
-            // does not match this filter, try the next event handler
-            continue;
-        }
-
-        const int cmp = memcmp(event_handlers[i].filter, event_name,
-                filter_length);
-        if (0 == cmp)
-        {
-            system_invoke_event_handler(sizeof(FilteringEventHandler),
-                                            &event_handlers[i], (const char*) event_name,
-                                            (const char*) data, nullptr);
-        }
-        // else continue the for loop to try the next handler
+        const unsigned i = __builtin_ctz(m);
+        system_invoke_event_handler(sizeof(FilteringEventHandler),
+                                        &event_handlers[i], (const char*) event_name,
+                                        (const char*) data, nullptr);
     }
 }
 
@@ -202,31 +187,167 @@ int MeshPublish::uninitializeUdp() {
 int MeshPublish::publish(const char* topic, const char* data) {
     // Topic should be defined
     CHECK_TRUE(topic && (strlen(topic) > 0), SYSTEM_ERROR_INVALID_ARGUMENT);
+    // This character is used to encode topic references in batched messages
+    CHECK_TRUE(topic[0] != particle::mesh::TOPIC_REF, SYSTEM_ERROR_INVALID_ARGUMENT);
+
+    const size_t size = particle::mesh::MessageWriter::eventSize(topic, data);
+    CHECK_TRUE(size <= MAX_MESSAGE_LEN, SYSTEM_ERROR_TOO_LARGE);
+
+    std::lock_guard<RecursiveMutex> lk(mutex_);
+    CHECK(initializeUdp());
+
+    if (batchWindow_ > 0 && size + particle::mesh::MESSAGE_HEADER_SIZE <= MAX_PACKET_LEN) {
+        if (!batchWriter_.count()) {
+            batchTime_ = millis();
+        }
+        if (batchWriter_.append(topic, data)) {
+            return SYSTEM_ERROR_NONE;
+        }
+        // The batch is full
+        CHECK(flush());
+        batchTime_ = millis();
+        CHECK_TRUE(batchWriter_.append(topic, data), SYSTEM_ERROR_INTERNAL);
+        return SYSTEM_ERROR_NONE;
+    }
+
+    // Send the pending events first to preserve the order of the events
+    CHECK(flush());
 
     // Including null-terminator
     const size_t topicLen = strlen(topic) + 1;
     const size_t dataLen = data ? strlen(data) + 1 : 0;
+    if (topicLen + dataLen + sizeof(uint8_t) <= MAX_PACKET_LEN) {
+        return sendEvent(topic, data);
+    }
 
-    // topic + data + version should fit within MAX_PACKET_LEN
-    CHECK_TRUE(topicLen + dataLen + sizeof(uint8_t) <= MAX_PACKET_LEN,
-            SYSTEM_ERROR_TOO_LARGE);
+    std::unique_ptr<char[]> msg(new (std::nothrow) char[size]);
+    CHECK_TRUE(msg, SYSTEM_ERROR_NO_MEMORY);
+    particle::mesh::MessageWriter writer(msg.get(), size);
+    writer.append(topic, data);
+    return sendMessage(writer.data(), writer.size());
+}
 
+int MeshPublish::publishTo(const IPAddress& addr, const char* topic, const char* data) {
+    using namespace particle::mesh;
+    CHECK_TRUE(addr, SYSTEM_ERROR_INVALID_ARGUMENT);
+    CHECK_TRUE(topic && (strlen(topic) > 0) && topic[0] != TOPIC_REF, SYSTEM_ERROR_INVALID_ARGUMENT);
+
+    const size_t size = MessageWriter::eventSize(topic, data) + COAP_HEADER_SIZE + 3;
+    CHECK_TRUE(size <= MAX_PACKET_LEN, SYSTEM_ERROR_TOO_LARGE);
+    std::unique_ptr<char[]> buf(new (std::nothrow) char[size]);
+    CHECK_TRUE(buf, SYSTEM_ERROR_NO_MEMORY);
+
+    // Confirmable requests are sent one at a time
+    std::lock_guard<Mutex> requestLock(requestMutex_);
+    {
+        std::lock_guard<RecursiveMutex> lk(mutex_);
+        CHECK(initializeUdp());
+        if (!ackSemaphore_) {
+            CHECK_TRUE(os_semaphore_create(&ackSemaphore_, 1, 0) == 0, SYSTEM_ERROR_NO_MEMORY);
+        }
+        // Drop an acknowledgement of an earlier request that arrived too late
+        os_semaphore_take(ackSemaphore_, 0, false);
+        requestAddr_ = addr;
+        requestId_ = ++messageId_;
+        ackPending_ = true;
+    }
+    SCOPE_GUARD({
+        std::lock_guard<RecursiveMutex> lk(mutex_);
+        ackPending_ = false;
+    });
+
+    const int n = CHECK(writeCoapEventRequest(buf.get(), size, requestId_));
+    MessageWriter writer(buf.get() + n, size - n);
+    writer.append(topic, data);
+
+    for (unsigned i = 0; i <= COAP_MAX_RETRANSMIT; ++i) {
+        {
+            std::lock_guard<RecursiveMutex> lk(mutex_);
+            CHECK(udp_->sendPacket(buf.get(), n + writer.size(), addr, PORT));
+        }
+        if (os_semaphore_take(ackSemaphore_, coapRetransmitTimeout(i), false) == 0) {
+            return SYSTEM_ERROR_NONE;
+        }
+    }
+    return SYSTEM_ERROR_TIMEOUT;
+}
+
+int MeshPublish::setBatchWindow(system_tick_t ms) {
     std::lock_guard<RecursiveMutex> lk(mutex_);
-    CHECK(initializeUdp());
+    CHECK(flush());
+    if (ms > 0 && !batchBuffer_) {
+        const size_t size = MAX_PACKET_LEN - particle::mesh::MESSAGE_HEADER_SIZE;
+        batchBuffer_.reset(new (std::nothrow) char[size]);
+        CHECK_TRUE(batchBuffer_, SYSTEM_ERROR_NO_MEMORY);
+        batchWriter_ = particle::mesh::MessageWriter(batchBuffer_.get(), size);
+    }
+    batchWindow_ = ms;
+    return SYSTEM_ERROR_NONE;
+}
+
+int MeshPublish::flush() {
+    std::lock_guard<RecursiveMutex> lk(mutex_);
+    if (!batchWriter_.count()) {
+        return SYSTEM_ERROR_NONE;
+    }
+    SCOPE_GUARD({
+        batchWriter_.reset();
+    });
+    CHECK_TRUE(udp_, SYSTEM_ERROR_INVALID_STATE);
+    if (batchWriter_.count() == 1) {
+        // A single event is sent in the legacy format. The first event of a message never
+        // refers to another topic
+        const char* topic = batchWriter_.data();
+        const char* data = topic + strlen(topic) + 1;
+        return sendEvent(topic, data);
+    }
+    return sendMessage(batchWriter_.data(), batchWriter_.size());
+}
+
+int MeshPublish::sendEvent(const char* topic, const char* data) {
     IPAddress mcastAddr;
     CHECK(fetchMulticastAddress(mcastAddr));
 
     CHECK(udp_->beginPacket(mcastAddr, PORT));
-    uint8_t version = 0;
+    uint8_t version = particle::mesh::VERSION_SINGLE;
     udp_->write(&version, 1);
-    udp_->write((const uint8_t*)topic, topicLen);
-    if (dataLen > 0) {
-        udp_->write((const uint8_t*)data, dataLen);
+    udp_->write((const uint8_t*)topic, strlen(topic) + 1);
+    if (data) {
+        udp_->write((const uint8_t*)data, strlen(data) + 1);
     }
     CHECK(udp_->endPacket());
     return SYSTEM_ERROR_NONE;
 }
 
+int MeshPublish::sendMessage(const char* msg, size_t size) {
+    using namespace particle::mesh;
+    IPAddress mcastAddr;
+    CHECK(fetchMulticastAddress(mcastAddr));
+
+    if (size + MESSAGE_HEADER_SIZE <= MAX_PACKET_LEN) {
+        CHECK(udp_->beginPacket(mcastAddr, PORT));
+        const uint8_t header[MESSAGE_HEADER_SIZE] = { VERSION_MESSAGE, 0 };
+        udp_->write(header, sizeof(header));
+        udp_->write((const uint8_t*)msg, size);
+        CHECK(udp_->endPacket());
+        return SYSTEM_ERROR_NONE;
+    }
+
+    const unsigned count = (size + MAX_FRAGMENT_LEN - 1) / MAX_FRAGMENT_LEN;
+    const uint16_t id = ++messageId_;
+    for (unsigned i = 0; i < count; ++i) {
+        const size_t offs = i * MAX_FRAGMENT_LEN;
+        const size_t n = std::min(size - offs, MAX_FRAGMENT_LEN);
+        CHECK(udp_->beginPacket(mcastAddr, PORT));
+        const uint8_t header[FRAGMENT_HEADER_SIZE] = { VERSION_MESSAGE, FLAG_FRAGMENT, (uint8_t)(id >> 8),
+                (uint8_t)id, (uint8_t)i, (uint8_t)count };
+        udp_->write(header, sizeof(header));
+        udp_->write((const uint8_t*)msg + offs, n);
+        CHECK(udp_->endPacket());
+    }
+    return SYSTEM_ERROR_NONE;
+}
+
 int MeshPublish::subscribe(const char* prefix, EventHandler handler) {
     std::lock_guard<RecursiveMutex> lk(mutex_);
     CHECK(initializeUdp());
@@ -234,6 +355,136 @@ int MeshPublish::subscribe(const char* prefix, EventHandler handler) {
     return SYSTEM_ERROR_NONE;
 }
 
+void MeshPublish::dispatchEvent(const char* topic, const char* data, void* ctx) {
+    const auto self = (MeshPublish*)ctx;
+    std::lock_guard<RecursiveMutex> lk(self->mutex_);
+    self->subscriptions_.send(topic, data);
+}
+
+system_tick_t MeshPublish::pollTimeout() {
+    std::lock_guard<RecursiveMutex> lk(mutex_);
+    if (!batchWriter_.count()) {
+        return 1000;
+    }
+    const system_tick_t elapsed = millis() - batchTime_;
+    return (elapsed < batchWindow_) ? batchWindow_ - elapsed : 0;
+}
+
+int MeshPublish::handleCoapMessage(const char* buffer, size_t len) {
+    using namespace particle::mesh;
+    CoapMessage msg = {};
+    CHECK(parseCoapMessage(buffer, len, &msg));
+    const IPAddress addr = udp_->remoteIP();
+    const uint16_t port = udp_->remotePort();
+
+    if (msg.type == particle::protocol::CoAPType::ACK) {
+        std::lock_guard<RecursiveMutex> lk(mutex_);
+        if (ackPending_ && msg.id == requestId_ && addr == requestAddr_) {
+            ackPending_ = false;
+            os_semaphore_give(ackSemaphore_, false);
+        }
+        return SYSTEM_ERROR_NONE;
+    }
+    CHECK_TRUE(msg.type == particle::protocol::CoAPType::CON && msg.code == particle::protocol::CoAPCode::POST,
+            SYSTEM_ERROR_NOT_SUPPORTED);
+
+    // Acknowledge the request before invoking the handlers, as well as any retransmissions of it
+    char ack[COAP_HEADER_SIZE] = {};
+    const int n = CHECK(writeCoapAck(ack, sizeof(ack), msg.id));
+    {
+        std::lock_guard<RecursiveMutex> lk(mutex_);
+        CHECK(udp_->sendPacket(ack, n, addr, port));
+    }
+    Source src = {};
+    memcpy(src.addr, addr.raw().ipv6, sizeof(src.addr));
+    src.port = port;
+    if (duplicates_.check(src, msg.id, millis())) {
+        return SYSTEM_ERROR_NONE;
+    }
+    CHECK_TRUE(msg.payload, SYSTEM_ERROR_BAD_DATA);
+    return parseMessage(msg.payload, msg.payloadSize, dispatchEvent, this);
+}
+
+int MeshPublish::handlePacket(const char* buffer, size_t len) {
+    using namespace particle::mesh;
+    CHECK_TRUE(len > 0, SYSTEM_ERROR_BAD_DATA);
+    if (isCoapMessage(buffer, len)) {
+        return handleCoapMessage(buffer, len);
+    }
+    const char version = *buffer++;
+    --len;
+
+    if (version == VERSION_MESSAGE) {
+        CHECK_TRUE(len >= MESSAGE_HEADER_SIZE - 1, SYSTEM_ERROR_BAD_DATA);
+        const uint8_t flags = *buffer++;
+        --len;
+        if (!(flags & FLAG_FRAGMENT)) {
+            return parseMessage(buffer, len, dispatchEvent, this);
+        }
+        CHECK_TRUE(len >= FRAGMENT_HEADER_SIZE - MESSAGE_HEADER_SIZE, SYSTEM_ERROR_BAD_DATA);
+        const auto h = (const uint8_t*)buffer;
+        const uint16_t id = ((uint16_t)h[0] << 8) | h[1];
+        const unsigned index = h[2];
+        const unsigned count = h[3];
+        buffer += FRAGMENT_HEADER_SIZE - MESSAGE_HEADER_SIZE;
+        len -= FRAGMENT_HEADER_SIZE - MESSAGE_HEADER_SIZE;
+        if (!reassembler_) {
+            reassembler_.reset(new (std::nothrow) MessageReassembler(MAX_FRAGMENT_LEN));
+            CHECK_TRUE(reassembler_, SYSTEM_ERROR_NO_MEMORY);
+        }
+        Source src = {};
+        memcpy(src.addr, udp_->remoteIP().raw().ipv6, sizeof(src.addr));
+        src.port = udp_->remotePort();
+        const char* msg = nullptr;
+        size_t msgSize = 0;
+        const int r = CHECK(reassembler_->add(src, id, index, count, buffer, len, millis(), &msg, &msgSize));
+        if (!r) {
+            return SYSTEM_ERROR_NONE; // More fragments are needed
+        }
+        return parseMessage(msg, msgSize, dispatchEvent, this);
+    }
+
+    // There should be a version and it should be "0"
+    CHECK_TRUE(version == VERSION_SINGLE, SYSTEM_ERROR_BAD_DATA);
+
+    // Topic should not be empty
+    const size_t topicLen = strnlen(buffer, len);
+    CHECK_TRUE(topicLen > 0, SYSTEM_ERROR_BAD_DATA);
+
+    const char* topic = buffer;
+
+    len -= topicLen;
+    buffer += topicLen;
+
+    // Topic should be terminated by '\0'
+    CHECK_TRUE(len > 0, SYSTEM_ERROR_BAD_DATA);
+    CHECK_TRUE(*buffer == 0, SYSTEM_ERROR_BAD_DATA);
+    // Skip it
+    --len;
+    buffer++;
+
+    size_t dataLen = 0;
+    const char* data = "";
+    if (len > 0) {
+        // There is data
+        dataLen = strnlen(buffer, len);
+        data = buffer;
+        // Data can be empty
+        len -= dataLen;
+        buffer += dataLen;
+        // Data should be terminated by '\0'
+        CHECK_TRUE(len > 0, SYSTEM_ERROR_BAD_DATA);
+        CHECK_TRUE(*buffer == 0, SYSTEM_ERROR_BAD_DATA);
+        // Skip it
+        --len;
+        buffer++;
+    }
+    CHECK_TRUE(len == 0, SYSTEM_ERROR_BAD_DATA);
+
+    dispatchEvent(topic, data, this);
+    return SYSTEM_ERROR_NONE;
+}
+
 /**
  * Pull data from the socket and handle as required.
  */
@@ -251,55 +502,19 @@ int MeshPublish::poll() {
                 return SYSTEM_ERROR_NO_MEMORY;
             }
         }
-        int len = u->receivePacket(buffer_.get(), MAX_PACKET_LEN, 1000);
+        const system_tick_t timeout = pollTimeout();
+        int len = (timeout > 0) ? u->receivePacket(buffer_.get(), MAX_PACKET_LEN, timeout) : 0;
         if (len > 0) {
             LOG(TRACE, "parse packet %d", len);
-            const char* buffer = (const char*)buffer_.get();
-
-            // There should be a version and it should be "0"
-            const char version = *buffer++;
-            CHECK_TRUE(version == 0, SYSTEM_ERROR_BAD_DATA);
-            len -= sizeof(version);
-
-            // Topic should not be empty
-            const size_t topicLen = strnlen(buffer, len);
-            CHECK_TRUE(topicLen > 0, SYSTEM_ERROR_BAD_DATA);
-
-            const char* topic = buffer;
-
-            len -= topicLen;
-            buffer += topicLen;
-
-            // Topic should be terminated by '\0'
-            CHECK_TRUE(len > 0, SYSTEM_ERROR_BAD_DATA);
-            CHECK_TRUE(*buffer == 0, SYSTEM_ERROR_BAD_DATA);
-            // Skip it
-            --len;
-            buffer++;
-
-            size_t dataLen = 0;
-            const char* data = "";
-            if (len > 0) {
-                // There is data
-                dataLen = strnlen(buffer, len);
-                data = buffer;
-                // Data can be empty
-                len -= dataLen;
-                buffer += dataLen;
-                // Data should be terminated by '\0'
-                CHECK_TRUE(len > 0, SYSTEM_ERROR_BAD_DATA);
-                CHECK_TRUE(*buffer == 0, SYSTEM_ERROR_BAD_DATA);
-                // Skip it
-                --len;
-                buffer++;
-            }
-            CHECK_TRUE(len == 0, SYSTEM_ERROR_BAD_DATA);
-
-            std::lock_guard<RecursiveMutex> lk(mutex_);
-            subscriptions_.send(topic, data);
+            result = handlePacket((const char*)buffer_.get(), len);
         } else {
             result = len;
         }
+        // Send the events collected in an expired batch window
+        std::lock_guard<RecursiveMutex> lk(mutex_);
+        if (batchWriter_.count() && millis() - batchTime_ >= batchWindow_) {
+            flush();
+        }
     } else {
         HAL_Delay_Milliseconds(100);
     }
@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spark_wiring_mesh_codec.h"
+
+#include "system_error.h"
+#include "check.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <new>
+
+namespace particle {
+
+namespace mesh {
+
+namespace {
+
+// Parses the topic of an event. References to other topics are not resolved
+int parseTopic(const char*& p, const char* end, const char** topic, int* ref) {
+    if (p < end && *p == TOPIC_REF) {
+        CHECK_TRUE(end - p >= 2, SYSTEM_ERROR_BAD_DATA);
+        *ref = (uint8_t)p[1];
+        *topic = nullptr;
+        p += 2;
+        return 0;
+    }
+    const size_t len = strnlen(p, end - p);
+    // Topic should not be empty and should be terminated by '\0'
+    CHECK_TRUE(len > 0 && len < (size_t)(end - p), SYSTEM_ERROR_BAD_DATA);
+    *topic = p;
+    *ref = -1;
+    p += len + 1;
+    return 0;
+}
+
+int parseData(const char*& p, const char* end, const char** data) {
+    const size_t len = strnlen(p, end - p);
+    // Data can be empty but should be terminated by '\0'
+    CHECK_TRUE(len < (size_t)(end - p), SYSTEM_ERROR_BAD_DATA);
+    *data = p;
+    p += len + 1;
+    return 0;
+}
+
+// Skips the extended delta or length of a CoAP option
+int skipOptionExt(const uint8_t*& p, const uint8_t* end, unsigned nibble) {
+    CHECK_TRUE(nibble != 15, SYSTEM_ERROR_BAD_DATA);
+    const size_t n = (nibble == 13) ? 1 : (nibble == 14) ? 2 : 0;
+    CHECK_TRUE((size_t)(end - p) >= n, SYSTEM_ERROR_BAD_DATA);
+    unsigned val = nibble;
+    if (n == 1) {
+        val = p[0] + 13;
+    } else if (n == 2) {
+        val = ((p[0] << 8) | p[1]) + 269;
+    }
+    p += n;
+    return val;
+}
+
+bool sameSource(const Source& a, const Source& b) {
+    return a.port == b.port && !memcmp(a.addr, b.addr, sizeof(a.addr));
+}
+
+// Finds the topic of the event with the given index
+const char* findTopic(const char* msg, size_t size, unsigned index) {
+    const char* p = msg;
+    const char* const end = msg + size;
+    for (unsigned i = 0;; ++i) {
+        const char* topic = nullptr;
+        const char* data = nullptr;
+        int ref = -1;
+        if (parseTopic(p, end, &topic, &ref) < 0 || parseData(p, end, &data) < 0) {
+            return nullptr;
+        }
+        if (i == index) {
+            return topic; // A reference can't refer to another reference
+        }
+    }
+}
+
+} // namespace
+
+int parseMessage(const char* msg, size_t size, EventCallback callback, void* ctx) {
+    const char* p = msg;
+    const char* const end = msg + size;
+    CHECK_TRUE(p < end, SYSTEM_ERROR_BAD_DATA);
+    for (unsigned i = 0; p < end; ++i) {
+        const char* topic = nullptr;
+        const char* data = nullptr;
+        int ref = -1;
+        CHECK(parseTopic(p, end, &topic, &ref));
+        CHECK(parseData(p, end, &data));
+        if (ref >= 0) {
+            CHECK_TRUE((unsigned)ref < i, SYSTEM_ERROR_BAD_DATA);
+            topic = findTopic(msg, size, ref);
+            CHECK_TRUE(topic, SYSTEM_ERROR_BAD_DATA);
+        }
+        callback(topic, data, ctx);
+    }
+    return 0;
+}
+
+MessageWriter::MessageWriter(char* buf, size_t size) :
+        buf_(buf),
+        capacity_(size),
+        size_(0),
+        count_(0),
+        topicCount_(0) {
+}
+
+bool MessageWriter::append(const char* topic, const char* data) {
+    if (count_ >= MAX_EVENT_COUNT) {
+        return false;
+    }
+    const TopicRef* ref = nullptr;
+    for (unsigned i = 0; i < topicCount_; ++i) {
+        if (!strcmp(buf_ + topics_[i].offset, topic)) {
+            ref = &topics_[i];
+            break;
+        }
+    }
+    const size_t topicSize = ref ? 2 : strlen(topic) + 1;
+    const size_t dataSize = (data ? strlen(data) : 0) + 1;
+    if (size_ + topicSize + dataSize > capacity_) {
+        return false;
+    }
+    char* p = buf_ + size_;
+    if (ref) {
+        p[0] = TOPIC_REF;
+        p[1] = ref->index;
+    } else {
+        memcpy(p, topic, topicSize);
+        if (topicCount_ < MAX_TOPIC_REFS) {
+            topics_[topicCount_].offset = size_;
+            topics_[topicCount_].index = count_;
+            ++topicCount_;
+        }
+    }
+    p += topicSize;
+    if (data) {
+        memcpy(p, data, dataSize);
+    } else {
+        *p = '\0';
+    }
+    size_ += topicSize + dataSize;
+    ++count_;
+    return true;
+}
+
+size_t MessageWriter::eventSize(const char* topic, const char* data) {
+    return strlen(topic) + 1 + (data ? strlen(data) : 0) + 1;
+}
+
+void MessageWriter::reset() {
+    size_ = 0;
+    count_ = 0;
+    topicCount_ = 0;
+}
+
+MessageReassembler::MessageReassembler(size_t fragmentSize) :
+        slots_(),
+        fragmentSize_(fragmentSize) {
+}
+
+int MessageReassembler::add(const Source& src, uint16_t id, unsigned index, unsigned count, const char* data,
+        size_t size, system_tick_t now, const char** msg, size_t* msgSize) {
+    CHECK_TRUE(count > 0 && count <= MAX_FRAGMENT_COUNT && index < count, SYSTEM_ERROR_BAD_DATA);
+    // All fragments but the last one have the same size
+    const bool last = (index == count - 1);
+    CHECK_TRUE(last ? (size > 0 && size <= fragmentSize_) : (size == fragmentSize_), SYSTEM_ERROR_BAD_DATA);
+    Slot* slot = nullptr;
+    Slot* freeSlot = nullptr;
+    for (unsigned i = 0; i < SLOT_COUNT; ++i) {
+        Slot& s = slots_[i];
+        if (s.buf && now - s.time >= TIMEOUT) {
+            s.buf.reset(); // Expired
+        }
+        if (!s.buf) {
+            if (!freeSlot || freeSlot->buf) {
+                freeSlot = &s;
+            }
+        } else if (s.id == id && sameSource(s.src, src)) {
+            slot = &s;
+        } else if (!freeSlot || (freeSlot->buf && now - s.time > now - freeSlot->time)) {
+            freeSlot = &s; // Evict the oldest message if there are no free slots
+        }
+    }
+    if (slot && slot->count != count) {
+        slot->buf.reset(); // Start over
+    }
+    if (!slot || !slot->buf) {
+        if (!slot) {
+            slot = freeSlot;
+        }
+        slot->buf.reset(new(std::nothrow) char[count * fragmentSize_]);
+        CHECK_TRUE(slot->buf, SYSTEM_ERROR_NO_MEMORY);
+        slot->src = src;
+        slot->id = id;
+        slot->count = count;
+        slot->received = 0;
+        slot->size = 0;
+        slot->time = now;
+    }
+    const uint8_t bit = 1 << index;
+    if (slot->received & bit) {
+        return 0; // Duplicate fragment
+    }
+    memcpy(slot->buf.get() + index * fragmentSize_, data, size);
+    slot->received |= bit;
+    if (last) {
+        slot->size = index * fragmentSize_ + size;
+    }
+    if (slot->received != (1 << count) - 1) {
+        return 0;
+    }
+    done_ = std::move(slot->buf);
+    *msg = done_.get();
+    *msgSize = slot->size;
+    return 1;
+}
+
+int parseCoapMessage(const char* buf, size_t size, CoapMessage* msg) {
+    CHECK_TRUE(size >= COAP_HEADER_SIZE && isCoapMessage(buf, size), SYSTEM_ERROR_BAD_DATA);
+    auto p = (const uint8_t*)buf;
+    const auto end = p + size;
+    const unsigned tokenSize = p[0] & 0x0f;
+    CHECK_TRUE(tokenSize <= 8 && tokenSize <= size - COAP_HEADER_SIZE, SYSTEM_ERROR_BAD_DATA);
+    msg->type = (protocol::CoAPType::Enum)((p[0] >> 4) & 0x03);
+    msg->code = (protocol::CoAPCode::Enum)p[1];
+    msg->id = ((uint16_t)p[2] << 8) | p[3];
+    msg->payload = nullptr;
+    msg->payloadSize = 0;
+    p += COAP_HEADER_SIZE + tokenSize;
+    while (p < end) {
+        if (*p == 0xff) {
+            // Payload marker should be followed by a non-empty payload
+            ++p;
+            CHECK_TRUE(p < end, SYSTEM_ERROR_BAD_DATA);
+            msg->payload = (const char*)p;
+            msg->payloadSize = end - p;
+            break;
+        }
+        const unsigned delta = *p >> 4;
+        const unsigned len = *p & 0x0f;
+        ++p;
+        CHECK(skipOptionExt(p, end, delta));
+        const size_t n = CHECK(skipOptionExt(p, end, len));
+        CHECK_TRUE(n <= (size_t)(end - p), SYSTEM_ERROR_BAD_DATA);
+        p += n;
+    }
+    return 0;
+}
+
+int writeCoapEventRequest(char* buf, size_t size, uint16_t id) {
+    CHECK_TRUE(size >= COAP_HEADER_SIZE + 3, SYSTEM_ERROR_TOO_LARGE);
+    buf[0] = 0x40 | (protocol::CoAPType::CON << 4);
+    buf[1] = protocol::CoAPCode::POST;
+    buf[2] = id >> 8;
+    buf[3] = id & 0xff;
+    buf[4] = (protocol::CoAPOption::URI_PATH << 4) | 1;
+    buf[5] = 'E';
+    buf[6] = 0xff; // Payload marker
+    return COAP_HEADER_SIZE + 3;
+}
+
+int writeCoapAck(char* buf, size_t size, uint16_t id) {
+    CHECK_TRUE(size >= COAP_HEADER_SIZE, SYSTEM_ERROR_TOO_LARGE);
+    buf[0] = 0x40 | (protocol::CoAPType::ACK << 4);
+    buf[1] = protocol::CoAPCode::EMPTY;
+    buf[2] = id >> 8;
+    buf[3] = id & 0xff;
+    return COAP_HEADER_SIZE;
+}
+
+system_tick_t coapRetransmitTimeout(unsigned attempt) {
+    // Same randomization as the cloud connection uses
+    system_tick_t timeout = COAP_ACK_TIMEOUT << attempt;
+    timeout += (timeout * (rand() % 256)) >> 9;
+    return timeout;
+}
+
+DuplicateFilter::DuplicateFilter() :
+        entries_() {
+}
+
+bool DuplicateFilter::check(const Source& src, uint16_t id, system_tick_t now) {
+    Entry* entry = nullptr;
+    for (unsigned i = 0; i < ENTRY_COUNT; ++i) {
+        Entry& e = entries_[i];
+        if (e.valid && now - e.time >= LIFETIME) {
+            e.valid = false;
+        }
+        if (!e.valid) {
+            if (!entry || entry->valid) {
+                entry = &e;
+            }
+        } else if (e.id == id && sameSource(e.src, src)) {
+            return true;
+        } else if (!entry || (entry->valid && now - e.time > now - entry->time)) {
+            entry = &e; // Forget the oldest message if there are no free entries
+        }
+    }
+    entry->src = src;
+    entry->id = id;
+    entry->time = now;
+    entry->valid = true;
+    return false;
+}
+
+} // namespace mesh
+
+} // namespace particle
@@ -30,6 +30,7 @@
 #include "spark_wiring_print.h"
 #include "spark_wiring_string.h"
 #include "spark_wiring_stream.h"
+#include "spark_wiring_format.h"
 
 // Public Methods //////////////////////////////////////////////////////////////
 
@@ -168,17 +169,20 @@ size_t Print::printNumber(unsigned long n, uint8_t base) {
 
 size_t Print::printFloat(double number, uint8_t digits)
 {
-  size_t n = 0;
-
   if (isnan(number)) return print("nan");
   if (isinf(number)) return print("inf");
   if (number > 4294967040.0) return print ("ovf");  // constant determined empirically
   if (number <-4294967040.0) return print ("ovf");  // constant determined empirically
 
+  // The output is collected in a buffer and written in as few chunks as possible
+  char buf[32];
+  size_t len = 0;
+  size_t n = 0;
+
   // Handle negative numbers
   if (number < 0.0)
   {
-     n += print('-');
+     buf[len++] = '-';
      number = -number;
   }
 
@@ -192,11 +196,18 @@ size_t Print::printFloat(double number, uint8_t digits)
   // Extract the integer part of the number and print it
   unsigned long int_part = (unsigned long)number;
   double remainder = number - (double)int_part;
-  n += print(int_part);
+  char int_buf[8 * sizeof(int_part)];
+  char* int_str = &int_buf[sizeof(int_buf)];
+  do {
+    *--int_str = '0' + int_part % 10;
+    int_part /= 10;
+  } while (int_part);
+  memcpy(buf + len, int_str, int_buf + sizeof(int_buf) - int_str);
+  len += int_buf + sizeof(int_buf) - int_str;
 
   // Print the decimal point, but only if there are digits beyond
   if (digits > 0) {
-    n += print(".");
+    buf[len++] = '.';
   }
 
   // Extract digits from the remainder one at a time
@@ -204,34 +215,43 @@ size_t Print::printFloat(double number, uint8_t digits)
   {
     remainder *= 10.0;
     int toPrint = int(remainder);
-    n += print(toPrint);
+    buf[len++] = '0' + toPrint;
     remainder -= toPrint;
+    if (len == sizeof(buf)) {
+      n += write((const uint8_t*)buf, len);
+      len = 0;
+    }
   }
 
+  if (len > 0) {
+    n += write((const uint8_t*)buf, len);
+  }
   return n;
 }
 
+namespace {
+
+struct PrintFormatContext {
+    Print* print;
+    size_t written;
+};
+
+void printFormatOutput(const char* data, size_t size, void* ctx) {
+    const auto c = static_cast<PrintFormatContext*>(ctx);
+    c->written += c->print->write((const uint8_t*)data, size);
+}
+
+} // namespace
+
 size_t Print::printf_impl(bool newline, const char* format, ...)
 {
-    const int bufsize = 20;
-    char test[bufsize];
+    // The output is passed to write() in chunks as it's being formatted
+    PrintFormatContext ctx = { this, 0 };
     va_list marker;
     va_start(marker, format);
-    size_t n = vsnprintf(test, bufsize, format, marker);
+    particle::vformatTo(printFormatOutput, &ctx, format, marker);
     va_end(marker);
-
-    if (n<bufsize)
-    {
-        n = print(test);
-    }
-    else
-    {
-        char bigger[n+1];
-        va_start(marker, format);
-        n = vsnprintf(bigger, n+1, format, marker);
-        va_end(marker);
-        n = print(bigger);
-    }
+    size_t n = ctx.written;
     if (newline)
         n += println();
     return n;
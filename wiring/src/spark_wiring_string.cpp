@@ -31,6 +31,7 @@
 #include <limits.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <utility>
 #include "string_convert.h"
 
 //These are very crude implementations - will refine later
@@ -170,7 +171,7 @@ String::String(double value, int decimalPlaces)
 }
 String::~String()
 {
-	free(buffer);
+	if (!(flags & FLAG_INLINE_BUFFER)) free(buffer);
 }
 
 /*********************************************/
@@ -187,9 +188,10 @@ inline void String::init(void)
 
 void String::invalidate(void)
 {
-	if (buffer) free(buffer);
+	if (buffer && !(flags & FLAG_INLINE_BUFFER)) free(buffer);
 	buffer = NULL;
 	capacity = len = 0;
+	flags &= ~FLAG_INLINE_BUFFER;
 }
 
 unsigned char String::reserve(unsigned int size)
@@ -204,6 +206,22 @@ unsigned char String::reserve(unsigned int size)
 
 unsigned char String::changeBuffer(unsigned int maxStrLen)
 {
+	if (flags & FLAG_INLINE_BUFFER) {
+		if (maxStrLen <= INLINE_CAPACITY) return 1;
+		char *newbuffer = (char *)malloc(maxStrLen + 1);
+		if (!newbuffer) return 0;
+		memcpy(newbuffer, buffer, len + 1);
+		buffer = newbuffer;
+		capacity = maxStrLen;
+		flags &= ~FLAG_INLINE_BUFFER;
+		return 1;
+	}
+	if (!buffer && maxStrLen <= INLINE_CAPACITY) {
+		buffer = inlineBuffer;
+		capacity = INLINE_CAPACITY;
+		flags |= FLAG_INLINE_BUFFER;
+		return 1;
+	}
 	char *newbuffer = (char *)realloc(buffer, maxStrLen + 1);
 	if (newbuffer) {
 		buffer = newbuffer;
@@ -242,13 +260,25 @@ void String::move(String &rhs)
 			len = rhs.len;
 			rhs.len = 0;
 			return;
-		} else {
+		} else if (!(flags & FLAG_INLINE_BUFFER)) {
 			free(buffer);
 		}
 	}
+	if (rhs.flags & FLAG_INLINE_BUFFER) {
+		// An inline buffer can't be taken over, and a string that doesn't
+		// fit in our own buffer is never stored inline
+		buffer = inlineBuffer;
+		capacity = INLINE_CAPACITY;
+		flags |= FLAG_INLINE_BUFFER;
+		memcpy(buffer, rhs.buffer, rhs.len + 1);
+		len = rhs.len;
+		rhs.len = 0;
+		return;
+	}
 	buffer = rhs.buffer;
 	capacity = rhs.capacity;
 	len = rhs.len;
+	flags &= ~FLAG_INLINE_BUFFER;
 	rhs.buffer = NULL;
 	rhs.capacity = 0;
 	rhs.len = 0;
@@ -310,7 +340,8 @@ unsigned char String::concat(const char *cstr, unsigned int length)
 	if (!cstr) return 0;
 	if (length == 0) return 1;
 	if (!reserve(newlen)) return 0;
-	strcpy(buffer + len, cstr);
+	memcpy(buffer + len, cstr, length);
+	buffer[newlen] = 0;
 	len = newlen;
 	return 1;
 }
@@ -831,6 +862,86 @@ String String::format(const char* fmt, ...)
     return result;
 }
 
+/*********************************************/
+/*  StringBuilder                            */
+/*********************************************/
+
+namespace particle {
+
+namespace detail {
+
+StringPiece::StringPiece(unsigned char num) : data_(nullptr)
+{
+	utoa(num, buf_, 10);
+	len_ = strlen(buf_);
+}
+
+StringPiece::StringPiece(int num) : data_(nullptr)
+{
+	itoa(num, buf_, 10);
+	len_ = strlen(buf_);
+}
+
+StringPiece::StringPiece(unsigned int num) : data_(nullptr)
+{
+	utoa(num, buf_, 10);
+	len_ = strlen(buf_);
+}
+
+StringPiece::StringPiece(long num) : data_(nullptr)
+{
+	ltoa(num, buf_, 10);
+	len_ = strlen(buf_);
+}
+
+StringPiece::StringPiece(unsigned long num) : data_(nullptr)
+{
+	ultoa(num, buf_, 10);
+	len_ = strlen(buf_);
+}
+
+StringPiece::StringPiece(float num) : data_(nullptr)
+{
+	dtoa(num, 6, buf_);
+	len_ = strlen(buf_);
+}
+
+StringPiece::StringPiece(double num) : data_(nullptr)
+{
+	dtoa(num, 6, buf_);
+	len_ = strlen(buf_);
+}
+
+} // namespace detail
+
+} // namespace particle
+
+StringBuilder & StringBuilder::appendPieces(const particle::detail::StringPiece *pieces, unsigned int count)
+{
+	if (!str_.buffer) return *this;
+	unsigned int newlen = str_.len;
+	for (unsigned int i = 0; i < count; ++i) {
+		newlen += pieces[i].length();
+	}
+	if (!str_.reserve(newlen)) {
+		str_.invalidate();
+		return *this;
+	}
+	for (unsigned int i = 0; i < count; ++i) {
+		memcpy(str_.buffer + str_.len, pieces[i].data(), pieces[i].length());
+		str_.len += pieces[i].length();
+	}
+	str_.buffer[str_.len] = 0;
+	return *this;
+}
+
+String StringBuilder::toString()
+{
+	String s(std::move(str_));
+	str_ = "";
+	return s;
+}
+
 std::ostream& operator << ( std::ostream& os, const String& value ) {
     os << '"' << value.c_str() << '"';
     return os;
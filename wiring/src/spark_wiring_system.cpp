@@ -1,6 +1,7 @@
 
 #include "core_hal.h"
 #include "rtc_hal.h"
+#include "eeprom_hal.h"
 #include "rgbled.h"
 #include "spark_wiring_wifi.h"
 #include "spark_wiring_cloud.h"
@@ -38,6 +39,8 @@ void SystemClass::reset(void)
 
 void SystemClass::reset(uint32_t data)
 {
+    // Don't lose the EEPROM changes that are kept in RAM
+    HAL_EEPROM_Flush(nullptr);
     HAL_Core_System_Reset_Ex(RESET_REASON_USER, data, nullptr);
 }
 
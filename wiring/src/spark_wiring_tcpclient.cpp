@@ -145,6 +145,20 @@ int TCPClient::bufferCount()
   return d_->total - d_->offset;
 }
 
+int TCPClient::receive(uint8_t* buffer, size_t size)
+{
+    int ret = 0;
+    if (Network.from(nif).ready() && isOpen(d_->sock))
+    {
+        ret = socket_receive(d_->sock, buffer, size, 0);
+        if (ret > 0)
+        {
+            DEBUG("recv(=%d)",ret);
+        }
+    }
+    return (ret > 0) ? ret : 0;
+}
+
 int TCPClient::available()
 {
     int avail = 0;
@@ -155,20 +169,19 @@ int TCPClient::available()
         flush_buffer();
     }
 
-    if(Network.from(nif).ready() && isOpen(d_->sock))
+    // Full but partially read => Move the unread data to the front
+    if (d_->offset && (d_->total == d_->size))
     {
-        // Have room
-        if ( d_->total < arraySize(d_->buffer))
-        {
-            int ret = socket_receive(d_->sock, d_->buffer + d_->total , arraySize(d_->buffer)-d_->total, 0);
-            if (ret > 0)
-            {
-                DEBUG("recv(=%d)",ret);
-                if (d_->total == 0) d_->offset = 0;
-                d_->total += ret;
-            }
-        } // Have Space
-    } // WiFi.ready() && isOpen(d_->sock)
+        memmove(d_->buffer, d_->buffer + d_->offset, d_->total - d_->offset);
+        d_->total -= d_->offset;
+        d_->offset = 0;
+    }
+
+    // Have room
+    if (d_->total < d_->size)
+    {
+        d_->total += receive(d_->buffer + d_->total, d_->size - d_->total);
+    }
     avail = bufferCount();
     return avail;
 }
@@ -181,6 +194,12 @@ int TCPClient::read()
 int TCPClient::read(uint8_t *buffer, size_t size)
 {
         int read = -1;
+        if (!bufferCount() && size >= d_->size)
+        {
+          // Nothing buffered and a large read => Receive directly into the caller's buffer
+          read = receive(buffer, size);
+          return read ? read : -1;
+        }
         if (bufferCount() || available())
         {
           read = (size > (size_t) bufferCount()) ? bufferCount() : size;
@@ -195,6 +214,58 @@ int TCPClient::peek()
   return  (bufferCount() || available()) ? d_->buffer[d_->offset] : -1;
 }
 
+int TCPClient::peekData(const uint8_t** data)
+{
+  if (!bufferCount() && !available())
+  {
+    return -1;
+  }
+  *data = d_->buffer + d_->offset;
+  return bufferCount();
+}
+
+size_t TCPClient::consume(size_t size)
+{
+  if (size > (size_t) bufferCount())
+  {
+    size = bufferCount();
+  }
+  d_->offset += size;
+  return size;
+}
+
+bool TCPClient::setBuffer(size_t size, uint8_t* buffer)
+{
+  std::unique_ptr<uint8_t[]> allocated;
+  if (!size)
+  {
+    buffer = d_->defaultBuffer;
+    size = sizeof(d_->defaultBuffer);
+  }
+  else if (!buffer)
+  {
+    allocated.reset(new (std::nothrow) uint8_t[size]);
+    if (!allocated)
+    {
+      return false;
+    }
+    buffer = allocated.get();
+  }
+  // Keep the data that hasn't been read yet
+  const size_t count = bufferCount();
+  if (count > size)
+  {
+    return false;
+  }
+  memmove(buffer, d_->buffer + d_->offset, count);
+  d_->buffer = buffer;
+  d_->size = size;
+  d_->offset = 0;
+  d_->total = count;
+  d_->allocated = std::move(allocated);
+  return true;
+}
+
 void TCPClient::flush_buffer()
 {
   d_->offset = 0;
@@ -251,6 +322,8 @@ IPAddress TCPClient::remoteIP()
 
 TCPClient::Data::Data(sock_handle_t sock)
         : sock(sock),
+          buffer(defaultBuffer),
+          size(sizeof(defaultBuffer)),
           offset(0),
           total(0) {
 }
@@ -40,6 +40,15 @@ static bool inline isOpen(sock_handle_t sd) {
     return socket_handle_valid(sd);
 }
 
+static int setSendTimeout(sock_handle_t sd, system_tick_t timeout) {
+    struct timeval tv = {};
+    if (timeout != SOCKET_WAIT_FOREVER) {
+        tv.tv_sec = timeout / 1000;
+        tv.tv_usec = (timeout % 1000) * 1000;
+    }
+    return sock_setsockopt(sd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
 TCPClient::TCPClient()
         : TCPClient(-1) {
 }
@@ -132,12 +141,7 @@ size_t TCPClient::write(uint8_t b, system_tick_t timeout) {
 
 size_t TCPClient::write(const uint8_t *buffer, size_t size, system_tick_t timeout) {
     clearWriteError();
-    struct timeval tv = {};
-    if (timeout != SOCKET_WAIT_FOREVER) {
-        tv.tv_sec = timeout / 1000;
-        tv.tv_usec = (timeout % 1000) * 1000;
-    }
-    int ret = sock_setsockopt(d_->sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    int ret = setSendTimeout(d_->sock, timeout);
     if (ret < 0) {
         setWriteError(errno);
         return 0;
@@ -152,10 +156,46 @@ size_t TCPClient::write(const uint8_t *buffer, size_t size, system_tick_t timeou
     return ret;
 }
 
+#if HAL_PLATFORM_FILESYSTEM
+size_t TCPClient::writeFile(const char* path, size_t offset, size_t size, system_tick_t timeout) {
+    clearWriteError();
+    int ret = setSendTimeout(d_->sock, timeout);
+    if (ret < 0) {
+        setWriteError(errno);
+        return 0;
+    }
+
+    off_t pos = offset;
+    ret = sock_sendfile(d_->sock, path, &pos, size, 0);
+    if (ret < 0) {
+        setWriteError(errno);
+        return 0;
+    }
+
+    return ret;
+}
+#endif // HAL_PLATFORM_FILESYSTEM
+
 int TCPClient::bufferCount() {
     return d_->total - d_->offset;
 }
 
+int TCPClient::receive(uint8_t* buffer, size_t size) {
+    if (!isOpen(d_->sock)) {
+        return 0;
+    }
+    int ret = sock_recv(d_->sock, buffer, size, MSG_DONTWAIT);
+    if (ret < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            LOG(ERROR, "recv error = %d", errno);
+            sock_close(d_->sock);
+            d_->sock = -1;
+        }
+        return 0;
+    }
+    return ret;
+}
+
 int TCPClient::available()
 {
     int avail = 0;
@@ -165,24 +205,17 @@ int TCPClient::available()
         flush_buffer();
     }
 
-    if (isOpen(d_->sock)) {
-        // Have room
-        if (d_->total < arraySize(d_->buffer)) {
-            int ret = sock_recv(d_->sock, d_->buffer + d_->total, arraySize(d_->buffer) - d_->total, MSG_DONTWAIT);
-            if (ret > 0) {
-                if (d_->total == 0) {
-                    d_->offset = 0;
-                }
-                d_->total += ret;
-            } else {
-                if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                    LOG(ERROR, "recv error = %d", errno);
-                    sock_close(d_->sock);
-                    d_->sock = -1;
-                }
-            }
-        } // Have Space
-    } // isOpen(d_->sock)
+    // Full but partially read => Move the unread data to the front
+    if (d_->offset && (d_->total == d_->size)) {
+        memmove(d_->buffer, d_->buffer + d_->offset, d_->total - d_->offset);
+        d_->total -= d_->offset;
+        d_->offset = 0;
+    }
+
+    // Have room
+    if (d_->total < d_->size) {
+        d_->total += receive(d_->buffer + d_->total, d_->size - d_->total);
+    }
     avail = bufferCount();
     return avail;
 }
@@ -193,6 +226,11 @@ int TCPClient::read() {
 
 int TCPClient::read(uint8_t *buffer, size_t size) {
     int read = -1;
+    if (!bufferCount() && size >= d_->size) {
+        // Nothing buffered and a large read => Receive directly into the caller's buffer
+        read = receive(buffer, size);
+        return read ? read : -1;
+    }
     if (bufferCount() || available()) {
         read = (size > (size_t) bufferCount()) ? bufferCount() : size;
         memcpy(buffer, &d_->buffer[d_->offset], read);
@@ -205,6 +243,48 @@ int TCPClient::peek() {
     return (bufferCount() || available()) ? d_->buffer[d_->offset] : -1;
 }
 
+int TCPClient::peekData(const uint8_t** data) {
+    if (!bufferCount() && !available()) {
+        return -1;
+    }
+    *data = d_->buffer + d_->offset;
+    return bufferCount();
+}
+
+size_t TCPClient::consume(size_t size) {
+    if (size > (size_t) bufferCount()) {
+        size = bufferCount();
+    }
+    d_->offset += size;
+    return size;
+}
+
+bool TCPClient::setBuffer(size_t size, uint8_t* buffer) {
+    std::unique_ptr<uint8_t[]> allocated;
+    if (!size) {
+        buffer = d_->defaultBuffer;
+        size = sizeof(d_->defaultBuffer);
+    } else if (!buffer) {
+        allocated.reset(new (std::nothrow) uint8_t[size]);
+        if (!allocated) {
+            return false;
+        }
+        buffer = allocated.get();
+    }
+    // Keep the data that hasn't been read yet
+    const size_t count = bufferCount();
+    if (count > size) {
+        return false;
+    }
+    memmove(buffer, d_->buffer + d_->offset, count);
+    d_->buffer = buffer;
+    d_->size = size;
+    d_->offset = 0;
+    d_->total = count;
+    d_->allocated = std::move(allocated);
+    return true;
+}
+
 void TCPClient::flush_buffer() {
     d_->offset = 0;
     d_->total = 0;
@@ -247,6 +327,8 @@ IPAddress TCPClient::remoteIP() {
 
 TCPClient::Data::Data(sock_handle_t sock)
         : sock(sock),
+          buffer(defaultBuffer),
+          size(sizeof(defaultBuffer)),
           offset(0),
           total(0) {
 }
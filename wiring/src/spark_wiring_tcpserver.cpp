@@ -32,9 +32,11 @@
 #include "spark_wiring_network.h"
 #include "spark_wiring_thread.h"
 
+#include <atomic>
+
 using namespace spark;
 
-static TCPClient* s_invalid_client = NULL;
+static std::atomic<TCPClient*> s_invalid_client(nullptr);
 
 class TCPServerClient : public TCPClient
 {
@@ -55,9 +57,12 @@ public:
 
 TCPServer::TCPServer(uint16_t port, network_interface_t nif) : _port(port), _nif(nif), _sock(socket_handle_invalid()), _client(socket_handle_invalid())
 {
-    SINGLE_THREADED_BLOCK() {
-        if (!s_invalid_client) {
-            s_invalid_client = new TCPClient(socket_handle_invalid());
+    if (!s_invalid_client.load()) {
+        // Servers can be created concurrently, only one of the clients is kept
+        const auto client = new TCPClient(socket_handle_invalid());
+        TCPClient* expected = nullptr;
+        if (!s_invalid_client.compare_exchange_strong(expected, client)) {
+            delete client;
         }
     }
 }
@@ -101,7 +106,7 @@ TCPClient TCPServer::available()
     if((!Network.from(_nif).ready()) || (_sock == SOCKET_INVALID))
     {
         stop();
-        _client = *s_invalid_client;
+        _client = *s_invalid_client.load();
         return _client;
     }
 
@@ -109,7 +114,7 @@ TCPClient TCPServer::available()
 
     if (!socket_handle_valid(sock))
     {
-        _client = *s_invalid_client;
+        _client = *s_invalid_client.load();
     }
     else
     {
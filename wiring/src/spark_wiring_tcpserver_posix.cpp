@@ -36,9 +36,11 @@
 #include "spark_wiring_thread.h"
 #include "spark_wiring_posix_common.h"
 
+#include <atomic>
+
 using namespace spark;
 
-static TCPClient* s_invalid_client = nullptr;
+static std::atomic<TCPClient*> s_invalid_client(nullptr);
 
 class TCPServerClient : public TCPClient {
 public:
@@ -61,9 +63,12 @@ TCPServer::TCPServer(uint16_t port, network_interface_t nif)
           _nif(nif),
           _sock(-1),
           _client(-1) {
-    SINGLE_THREADED_BLOCK() {
-        if (!s_invalid_client) {
-            s_invalid_client = new TCPClient(-1);
+    if (!s_invalid_client.load()) {
+        // Servers can be created concurrently, only one of the clients is kept
+        const auto client = new TCPClient(-1);
+        TCPClient* expected = nullptr;
+        if (!s_invalid_client.compare_exchange_strong(expected, client)) {
+            delete client;
         }
     }
 }
@@ -141,7 +146,7 @@ TCPClient TCPServer::available() {
     }
 
     if (_sock < 0) {
-        _client = *s_invalid_client;
+        _client = *s_invalid_client.load();
         return _client;
     }
 
@@ -149,7 +154,7 @@ TCPClient TCPServer::available() {
     socklen_t slen = sizeof(saddr);
     int s = sock_accept(_sock, (struct sockaddr*)&saddr, &slen);
     if (s < 0) {
-        _client = *s_invalid_client;
+        _client = *s_invalid_client.load();
         if (errno != EAGAIN && errno != EWOULDBLOCK) {
             stop();
         }
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2019 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spark_wiring_thread_pool.h"
+
+#if PLATFORM_THREADING
+
+#include "system_error.h"
+
+#include <new>
+
+namespace particle {
+
+ThreadPool::ThreadPool() :
+        workerCount_(0),
+        queue_(nullptr) {
+}
+
+ThreadPool::~ThreadPool() {
+    destroy();
+}
+
+int ThreadPool::init(unsigned workerCount, size_t queueSize, os_thread_prio_t priority, size_t stackSize) {
+    destroy();
+    if (!workerCount || !queueSize) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    // The queue holds pointers to heap-allocated tasks. A null pointer stops a worker thread
+    if (os_queue_create(&queue_, sizeof(Task*), queueSize, nullptr) != 0) {
+        queue_ = nullptr;
+        return SYSTEM_ERROR_NO_MEMORY;
+    }
+    workers_.reset(new(std::nothrow) Thread[workerCount]);
+    if (!workers_) {
+        destroy();
+        return SYSTEM_ERROR_NO_MEMORY;
+    }
+    for (unsigned i = 0; i < workerCount; ++i) {
+        workers_[i] = Thread("pool", [this]() {
+            run();
+        }, priority, stackSize);
+        if (!workers_[i].isValid()) {
+            destroy();
+            return SYSTEM_ERROR_NO_MEMORY;
+        }
+        ++workerCount_;
+    }
+    return 0;
+}
+
+void ThreadPool::destroy() {
+    if (!queue_) {
+        return;
+    }
+    // Every worker takes a single stop request after running all tasks queued before it
+    Task* const stop = nullptr;
+    for (unsigned i = 0; i < workerCount_; ++i) {
+        os_queue_put(queue_, &stop, CONCURRENT_WAIT_FOREVER, nullptr);
+    }
+    workers_.reset(); // Joins the worker threads
+    workerCount_ = 0;
+    Task* task = nullptr;
+    while (os_queue_take(queue_, &task, 0, nullptr) == 0) {
+        delete task;
+    }
+    os_queue_destroy(queue_, nullptr);
+    queue_ = nullptr;
+}
+
+int ThreadPool::post(Task task, system_tick_t timeout) {
+    if (!workerCount_) {
+        return SYSTEM_ERROR_INVALID_STATE;
+    }
+    Task* const t = new(std::nothrow) Task(std::move(task));
+    if (!t) {
+        return SYSTEM_ERROR_NO_MEMORY;
+    }
+    if (os_queue_put(queue_, &t, timeout, nullptr) != 0) {
+        delete t;
+        return SYSTEM_ERROR_BUSY;
+    }
+    return 0;
+}
+
+void ThreadPool::run() {
+    for (;;) {
+        Task* task = nullptr;
+        if (os_queue_take(queue_, &task, CONCURRENT_WAIT_FOREVER, nullptr) != 0) {
+            continue;
+        }
+        if (!task) {
+            break;
+        }
+        (*task)();
+        delete task;
+    }
+}
+
+} // namespace particle
+
+#endif // PLATFORM_THREADING
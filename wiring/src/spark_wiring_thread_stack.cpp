@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spark_wiring_thread_stack.h"
+
+#if PLATFORM_THREADING
+
+#include "delay_hal.h"
+#include "system_error.h"
+
+#include <memory>
+#include <new>
+
+namespace particle {
+
+namespace {
+
+const size_t MIN_STACK_MARGIN = 256;
+const size_t STACK_SIZE_ALIGNMENT = 64;
+
+} // unnamed
+
+struct ThreadStackPool::Worker {
+    Worker* next; // Next thread in the pool
+    Worker* nextIdle; // Next parked thread
+    ThreadStackPool* pool;
+    os_thread_t thread;
+    os_semaphore_t wakeup;
+    os_thread_fn_t fn;
+    void* arg;
+    bool exit;
+
+    Worker() :
+            next(nullptr),
+            nextIdle(nullptr),
+            pool(nullptr),
+            thread(OS_THREAD_INVALID_HANDLE),
+            wakeup(nullptr),
+            fn(nullptr),
+            arg(nullptr),
+            exit(false) {
+    }
+};
+
+int threadStackFree(os_thread_t thread) {
+    const int n = os_thread_get_stats(nullptr, 0, nullptr, nullptr);
+    if (n < 0) {
+        return n;
+    }
+    // Reserve a few extra entries in case new threads get created in the meantime
+    const size_t count = n + 2;
+    std::unique_ptr<os_thread_stats_t[]> stats(new(std::nothrow) os_thread_stats_t[count]);
+    if (!stats) {
+        return SYSTEM_ERROR_NO_MEMORY;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        stats[i].size = sizeof(os_thread_stats_t);
+    }
+    const int r = os_thread_get_stats(stats.get(), count, nullptr, nullptr);
+    if (r < 0) {
+        return r;
+    }
+    for (int i = 0; i < r; ++i) {
+        if (stats[i].thread == thread) {
+            return stats[i].stack_free_min;
+        }
+    }
+    return SYSTEM_ERROR_NOT_FOUND;
+}
+
+size_t recommendedStackSize(size_t stackSize, size_t stackFree) {
+    const size_t used = (stackFree < stackSize) ? stackSize - stackFree : 0;
+    size_t margin = used / 4;
+    if (margin < MIN_STACK_MARGIN) {
+        margin = MIN_STACK_MARGIN;
+    }
+    return (used + margin + STACK_SIZE_ALIGNMENT - 1) / STACK_SIZE_ALIGNMENT * STACK_SIZE_ALIGNMENT;
+}
+
+ThreadStackPool::ThreadStackPool(size_t stackSize, unsigned maxThreads, os_thread_prio_t priority) :
+        workers_(nullptr),
+        idle_(nullptr),
+        stackSize_(stackSize),
+        maxThreads_(maxThreads),
+        count_(0),
+        idleCount_(0),
+        mutex_(nullptr),
+        priority_(priority) {
+    if (os_mutex_create(&mutex_) != 0) {
+        mutex_ = nullptr;
+    }
+}
+
+ThreadStackPool::~ThreadStackPool() {
+    if (!mutex_) {
+        return;
+    }
+    // Wait for the busy threads to get parked
+    for (;;) {
+        os_mutex_lock(mutex_);
+        const bool idle = (idleCount_ == count_);
+        os_mutex_unlock(mutex_);
+        if (idle) {
+            break;
+        }
+        HAL_Delay_Milliseconds(1);
+    }
+    Worker* w = workers_;
+    while (w) {
+        Worker* const next = w->next;
+        w->exit = true;
+        os_semaphore_give(w->wakeup, false);
+        os_thread_join(w->thread);
+        os_thread_cleanup(w->thread);
+        os_semaphore_destroy(w->wakeup);
+        delete w;
+        w = next;
+    }
+    os_mutex_destroy(mutex_);
+}
+
+int ThreadStackPool::run(os_thread_fn_t fn, void* arg, os_thread_t* thread) {
+    if (!mutex_) {
+        return SYSTEM_ERROR_NO_MEMORY;
+    }
+    os_mutex_lock(mutex_);
+    Worker* w = idle_;
+    if (w) {
+        idle_ = w->nextIdle;
+        --idleCount_;
+    } else if (count_ < maxThreads_) {
+        w = new(std::nothrow) Worker();
+        if (w) {
+            w->pool = this;
+            if (os_semaphore_create(&w->wakeup, 1, 0) != 0) {
+                delete w;
+                w = nullptr;
+            } else if (os_thread_create(&w->thread, "pool", priority_, workerMain, w, stackSize_) != 0) {
+                os_semaphore_destroy(w->wakeup);
+                delete w;
+                w = nullptr;
+            } else {
+                w->next = workers_;
+                workers_ = w;
+                ++count_;
+            }
+        }
+        if (!w) {
+            os_mutex_unlock(mutex_);
+            return SYSTEM_ERROR_NO_MEMORY;
+        }
+    }
+    os_mutex_unlock(mutex_);
+    if (!w) {
+        return SYSTEM_ERROR_BUSY;
+    }
+    w->fn = fn;
+    w->arg = arg;
+    if (thread) {
+        *thread = w->thread;
+    }
+    os_semaphore_give(w->wakeup, false);
+    return 0;
+}
+
+int ThreadStackPool::stackFree() const {
+    if (!mutex_) {
+        return SYSTEM_ERROR_NOT_FOUND;
+    }
+    int result = SYSTEM_ERROR_NOT_FOUND;
+    os_mutex_lock(mutex_);
+    for (Worker* w = workers_; w; w = w->next) {
+        const int n = threadStackFree(w->thread);
+        if (n < 0) {
+            result = n;
+            break;
+        }
+        if (result < 0 || n < result) {
+            result = n;
+        }
+    }
+    os_mutex_unlock(mutex_);
+    return result;
+}
+
+unsigned ThreadStackPool::threadCount() const {
+    if (!mutex_) {
+        return 0;
+    }
+    os_mutex_lock(mutex_);
+    const unsigned n = count_;
+    os_mutex_unlock(mutex_);
+    return n;
+}
+
+unsigned ThreadStackPool::idleCount() const {
+    if (!mutex_) {
+        return 0;
+    }
+    os_mutex_lock(mutex_);
+    const unsigned n = idleCount_;
+    os_mutex_unlock(mutex_);
+    return n;
+}
+
+void ThreadStackPool::park(Worker* w) {
+    os_mutex_lock(mutex_);
+    w->fn = nullptr;
+    w->arg = nullptr;
+    w->nextIdle = idle_;
+    idle_ = w;
+    ++idleCount_;
+    os_mutex_unlock(mutex_);
+}
+
+os_thread_return_t ThreadStackPool::workerMain(void* arg) {
+    const auto w = static_cast<Worker*>(arg);
+    for (;;) {
+        os_semaphore_take(w->wakeup, CONCURRENT_WAIT_FOREVER, false);
+        if (w->exit) {
+            break;
+        }
+        if (w->fn) {
+            w->fn(w->arg);
+        }
+        w->pool->park(w);
+    }
+    os_thread_exit(nullptr);
+}
+
+} // namespace particle
+
+#endif // PLATFORM_THREADING
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "logging.h"
+LOG_SOURCE_CATEGORY("wiring.timer")
+
+#include "spark_wiring_timer_service.h"
+
+#if PLATFORM_THREADING
+
+#include "spark_wiring_ticks.h"
+#include "system_task.h"
+
+namespace particle {
+
+TimerService::TimerService(os_thread_prio_t priority, size_t stackSize) :
+        stats_(),
+        thread_(OS_THREAD_INVALID_HANDLE),
+        wakeup_(nullptr),
+        pending_(nullptr),
+        pendingTail_(&pending_),
+        stackSize_(stackSize),
+        lateThreshold_(DEFAULT_LATE_THRESHOLD),
+        wakeTime_(0),
+        priority_(priority),
+        waiting_(false),
+        waitForever_(false),
+        appPosted_(false),
+        exit_(false) {
+}
+
+TimerService::~TimerService() {
+    if (thread_ != OS_THREAD_INVALID_HANDLE) {
+        exit_ = true;
+        os_semaphore_give(wakeup_, false);
+        os_thread_join(thread_);
+        os_thread_cleanup(thread_);
+    }
+    if (wakeup_) {
+        os_semaphore_destroy(wakeup_);
+    }
+}
+
+void TimerService::setLateThreshold(system_tick_t ms) {
+    std::lock_guard<Mutex> lock(mutex_);
+    lateThreshold_ = ms;
+}
+
+system_tick_t TimerService::lateThreshold() const {
+    std::lock_guard<Mutex> lock(mutex_);
+    return lateThreshold_;
+}
+
+TimerService::Stats TimerService::stats() const {
+    std::lock_guard<Mutex> lock(mutex_);
+    return stats_;
+}
+
+void TimerService::resetStats() {
+    std::lock_guard<Mutex> lock(mutex_);
+    stats_ = Stats();
+}
+
+TimerService* TimerService::instance() {
+    static TimerService service;
+    return &service;
+}
+
+bool TimerService::start(ServiceTimer* timer) {
+    std::lock_guard<Mutex> lock(mutex_);
+    if (!startThread()) {
+        return false;
+    }
+    const system_tick_t now = millis();
+    wheel_.advance(now);
+    const system_tick_t expiry = now + timer->period_;
+    wheel_.add(timer, expiry);
+    timer->active_ = true;
+    // Wake the service thread up if the timer expires before the thread would wake up on its own
+    if (waiting_ && (waitForever_ || (int32_t)(expiry - wakeTime_) < 0)) {
+        waitForever_ = false;
+        wakeTime_ = expiry;
+        os_semaphore_give(wakeup_, false);
+    }
+    return true;
+}
+
+bool TimerService::changePeriod(ServiceTimer* timer, system_tick_t period) {
+    {
+        std::lock_guard<Mutex> lock(mutex_);
+        timer->period_ = period ? period : 1;
+    }
+    return start(timer);
+}
+
+void TimerService::stop(ServiceTimer* timer) {
+    std::lock_guard<Mutex> lock(mutex_);
+    wheel_.remove(timer);
+    removePending(timer);
+    timer->active_ = false;
+}
+
+void TimerService::dispose(ServiceTimer* timer) {
+    std::unique_lock<Mutex> lock(mutex_);
+    for (;;) {
+        wheel_.remove(timer);
+        removePending(timer);
+        timer->active_ = false;
+        // The callback may be disposing of its own timer
+        if (!timer->running_ || os_thread_is_current(timer->runner_)) {
+            break;
+        }
+        // The callback may restart the timer before it returns, so the timer is stopped again
+        lock.unlock();
+        os_thread_yield();
+        lock.lock();
+    }
+}
+
+bool TimerService::isActive(const ServiceTimer* timer) const {
+    std::lock_guard<Mutex> lock(mutex_);
+    return timer->active_;
+}
+
+bool TimerService::startThread() {
+    if (thread_ != OS_THREAD_INVALID_HANDLE) {
+        return true;
+    }
+    if (!wakeup_ && os_semaphore_create(&wakeup_, 1, 0) != 0) {
+        wakeup_ = nullptr;
+        return false;
+    }
+    if (os_thread_create(&thread_, "timers", priority_, threadFunc, this, stackSize_) != 0) {
+        thread_ = OS_THREAD_INVALID_HANDLE;
+        LOG(ERROR, "Unable to start timer service thread");
+        return false;
+    }
+    return true;
+}
+
+void TimerService::run() {
+    std::unique_lock<Mutex> lock(mutex_);
+    while (!exit_) {
+        const system_tick_t now = millis();
+        wheel_.advance(now);
+        const auto entry = wheel_.takeExpired();
+        if (entry) {
+            const auto timer = static_cast<ServiceTimer*>(entry);
+            const system_tick_t expiry = timer->expiry();
+            if (timer->oneShot_) {
+                timer->active_ = false;
+            } else {
+                system_tick_t next = expiry + timer->period_;
+                if ((int32_t)(next - now) <= 0) {
+                    // Skip the callbacks the timer has fallen behind on
+                    stats_.missed += (now - expiry) / timer->period_;
+                    next = now + timer->period_;
+                }
+                wheel_.add(timer, next);
+            }
+            if (timer->dispatch_ == TimerDispatch::APPLICATION_THREAD) {
+                timer->pendingExpiry_ = expiry;
+                if (addPending(timer) && !appPosted_) {
+                    appPosted_ = true;
+                    // The callback must not be invoked with the lock held
+                    lock.unlock();
+                    const bool ok = application_thread_invoke(dispatchApplication, this, nullptr) == 0;
+                    lock.lock();
+                    if (!ok) {
+                        LOG(ERROR, "Unable to post timer callback to the application queue");
+                        while (pending_) {
+                            removePending(pending_);
+                            ++stats_.missed;
+                        }
+                        appPosted_ = false;
+                    }
+                }
+            } else {
+                invoke(timer, expiry, lock);
+            }
+            continue;
+        }
+        system_tick_t next = 0;
+        system_tick_t timeout = CONCURRENT_WAIT_FOREVER;
+        waitForever_ = !wheel_.nextTime(&next);
+        if (!waitForever_) {
+            const int32_t d = next - now;
+            timeout = (d > 0) ? d : 0;
+            wakeTime_ = next;
+        }
+        waiting_ = true;
+        lock.unlock();
+        os_semaphore_take(wakeup_, timeout, false);
+        lock.lock();
+        waiting_ = false;
+    }
+}
+
+void TimerService::runPending() {
+    std::unique_lock<Mutex> lock(mutex_);
+    // Timers that expire in the meantime are added to the same list and don't need to be posted again
+    while (pending_) {
+        const auto timer = pending_;
+        removePending(timer);
+        invoke(timer, timer->pendingExpiry_, lock);
+    }
+    appPosted_ = false;
+}
+
+void TimerService::invoke(ServiceTimer* timer, system_tick_t expiry, std::unique_lock<Mutex>& lock) {
+    timer->running_ = true;
+    timer->runner_ = os_thread_current(nullptr);
+    const system_tick_t lateness = millis() - expiry;
+    lock.unlock();
+    timer->timeout();
+    lock.lock();
+    timer->running_ = false;
+    ++stats_.dispatched;
+    if (lateness > stats_.maxLateness) {
+        stats_.maxLateness = lateness;
+    }
+    if (lateness > lateThreshold_) {
+        ++stats_.late;
+        LOG_DEBUG(WARN, "Timer callback is late by %u ms", (unsigned)lateness);
+    }
+}
+
+bool TimerService::addPending(ServiceTimer* timer) {
+    if (timer->pprevPending_) {
+        // The previous callback hasn't been invoked yet
+        ++stats_.missed;
+        return false;
+    }
+    timer->nextPending_ = nullptr;
+    timer->pprevPending_ = pendingTail_;
+    *pendingTail_ = timer;
+    pendingTail_ = &timer->nextPending_;
+    return true;
+}
+
+void TimerService::removePending(ServiceTimer* timer) {
+    if (!timer->pprevPending_) {
+        return;
+    }
+    *timer->pprevPending_ = timer->nextPending_;
+    if (timer->nextPending_) {
+        timer->nextPending_->pprevPending_ = timer->pprevPending_;
+    } else {
+        pendingTail_ = timer->pprevPending_;
+    }
+    timer->nextPending_ = nullptr;
+    timer->pprevPending_ = nullptr;
+}
+
+os_thread_return_t TimerService::threadFunc(void* arg) {
+    const auto self = static_cast<TimerService*>(arg);
+    self->run();
+    os_thread_exit(nullptr);
+}
+
+void TimerService::dispatchApplication(void* arg) {
+    const auto self = static_cast<TimerService*>(arg);
+    self->runPending();
+}
+
+} // particle
+
+#endif // PLATFORM_THREADING
@@ -218,6 +218,41 @@ int UDP::receivePacket(uint8_t* buffer, size_t size, system_tick_t timeout)
     return ret;
 }
 
+int UDP::sendPackets(UDPPacket* packets, size_t count)
+{
+    // No batching support in the compat socket HAL
+    size_t sent = 0;
+    for (; sent < count; ++sent)
+    {
+        UDPPacket& p = packets[sent];
+        const int ret = sendPacket(p.buffer, p.size, p.remoteIP, p.remotePort);
+        if (ret < 0)
+        {
+            return sent ? sent : ret;
+        }
+        p.length = ret;
+    }
+    return sent;
+}
+
+int UDP::receivePackets(UDPPacket* packets, size_t count, system_tick_t timeout)
+{
+    size_t received = 0;
+    for (; received < count; ++received)
+    {
+        UDPPacket& p = packets[received];
+        const int ret = receivePacket(p.buffer, p.size, received ? 0 : timeout);
+        if (ret <= 0)
+        {
+            return (received || ret == 0) ? received : ret;
+        }
+        p.length = ret;
+        p.remoteIP = _remoteIP;
+        p.remotePort = _remotePort;
+    }
+    return received;
+}
+
 int UDP::read()
 {
   return available() ? _buffer[_offset++] : -1;
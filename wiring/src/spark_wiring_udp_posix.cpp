@@ -33,11 +33,15 @@
 #include <arpa/inet.h>
 #include "spark_wiring_constants.h"
 #include "spark_wiring_posix_common.h"
+#include <algorithm>
 
 using namespace spark;
 
 namespace {
 
+// Maximum number of packets passed to the socket HAL in one call
+const size_t UDP_PACKET_BATCH_SIZE = 8;
+
 inline bool isOpen(sock_handle_t sd) {
     return socket_handle_valid(sd);
 }
@@ -302,6 +306,103 @@ int UDP::receivePacket(uint8_t* buffer, size_t size, system_tick_t timeout) {
     return ret;
 }
 
+int UDP::sendPackets(UDPPacket* packets, size_t count) {
+    if (!isOpen(_sock) || !packets) {
+        return -1;
+    }
+    size_t sent = 0;
+    while (sent < count) {
+        // Pass the packets to the socket HAL in batches
+        sockaddr_storage addrs[UDP_PACKET_BATCH_SIZE] = {};
+        iovec iovs[UDP_PACKET_BATCH_SIZE] = {};
+        mmsghdr msgs[UDP_PACKET_BATCH_SIZE] = {};
+        const size_t n = std::min(count - sent, UDP_PACKET_BATCH_SIZE);
+        for (size_t i = 0; i < n; ++i) {
+            const UDPPacket& p = packets[sent + i];
+            detail::ipAddressPortToSockaddr(p.remoteIP, p.remotePort, (struct sockaddr*)&addrs[i]);
+            if (addrs[i].ss_family == AF_UNSPEC) {
+                return sent ? sent : -1;
+            }
+            iovs[i].iov_base = p.buffer;
+            iovs[i].iov_len = p.size;
+            msgs[i].msg_hdr.msg_name = &addrs[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        const int ret = sock_sendmmsg(_sock, msgs, n, 0);
+        if (ret < 0) {
+            return sent ? sent : ret;
+        }
+        for (int i = 0; i < ret; ++i) {
+            packets[sent + i].length = msgs[i].msg_len;
+        }
+        sent += ret;
+        if ((size_t)ret < n) {
+            break;
+        }
+    }
+    LOG_DEBUG(TRACE, "sent %u packets", (unsigned)sent);
+    return sent;
+}
+
+int UDP::receivePackets(UDPPacket* packets, size_t count, system_tick_t timeout) {
+    if (!isOpen(_sock) || !packets) {
+        return -1;
+    }
+    int flags = 0;
+    if (timeout == 0) {
+        flags = MSG_DONTWAIT;
+    } else {
+        struct timeval tv = {};
+        tv.tv_sec = timeout / 1000;
+        tv.tv_usec = (timeout % 1000) * 1000;
+        const int ret = sock_setsockopt(_sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        if (ret) {
+            return ret;
+        }
+    }
+    size_t received = 0;
+    while (received < count) {
+        sockaddr_storage addrs[UDP_PACKET_BATCH_SIZE] = {};
+        iovec iovs[UDP_PACKET_BATCH_SIZE] = {};
+        mmsghdr msgs[UDP_PACKET_BATCH_SIZE] = {};
+        const size_t n = std::min(count - received, UDP_PACKET_BATCH_SIZE);
+        for (size_t i = 0; i < n; ++i) {
+            const UDPPacket& p = packets[received + i];
+            iovs[i].iov_base = p.buffer;
+            iovs[i].iov_len = p.size;
+            msgs[i].msg_hdr.msg_name = &addrs[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        // Only the first packet is waited for
+        const int ret = sock_recvmmsg(_sock, msgs, n, received ? MSG_DONTWAIT : flags);
+        if (ret < 0) {
+            if (received || errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return ret;
+        }
+        for (int i = 0; i < ret; ++i) {
+            UDPPacket& p = packets[received + i];
+            p.length = msgs[i].msg_len;
+            detail::sockaddrToIpAddressPort((const struct sockaddr*)&addrs[i], p.remoteIP, &p.remotePort);
+        }
+        received += ret;
+        if (ret > 0) {
+            _remoteIP = packets[received - 1].remoteIP;
+            _remotePort = packets[received - 1].remotePort;
+        }
+        if ((size_t)ret < n) {
+            break;
+        }
+    }
+    LOG_DEBUG(TRACE, "received %u packets", (unsigned)received);
+    return received;
+}
+
 int UDP::read() {
     return available() ? _buffer[_offset++] : -1;
 }
@@ -86,6 +86,17 @@ size_t USBSerial::write(uint8_t byte)
   return 0;
 }
 
+#if HAL_PLATFORM_USB_CDC_HIGH_THROUGHPUT
+size_t USBSerial::write(const uint8_t* buffer, size_t size)
+{
+  if (!_blocking) {
+    // Large buffers may be sent without copying them, which blocks until the host reads the data
+    return Print::write(buffer, size);
+  }
+  return std::max(0, (int)HAL_USB_USART_Send_Buffer(_serial, buffer, size, nullptr));
+}
+#endif
+
 void USBSerial::flush()
 {
   HAL_USB_USART_Flush_Data(_serial);
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "syslog_log_handler.h"
+
+#if Wiring_SyslogLogHandler
+
+#include "spark_wiring_network.h"
+#include "spark_wiring_ticks.h"
+#include "system_cloud.h"
+#include "system_error.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace spark {
+
+namespace {
+
+// Maximum length of the MSGID field, see RFC 5424
+const size_t MAX_MSGID_SIZE = 32;
+
+unsigned syslogSeverity(LogLevel level) {
+    if (level >= LOG_LEVEL_PANIC) {
+        return 0; // Emergency
+    } else if (level >= LOG_LEVEL_ERROR) {
+        return 3; // Error
+    } else if (level >= LOG_LEVEL_WARN) {
+        return 4; // Warning
+    } else if (level >= LOG_LEVEL_INFO) {
+        return 6; // Informational
+    }
+    return 7; // Debug
+}
+
+} // unnamed
+
+const uint16_t SyslogLogHandler::DEFAULT_PORT;
+const size_t SyslogLogHandler::DEFAULT_DATAGRAM_SIZE;
+const unsigned SyslogLogHandler::DEFAULT_FLUSH_INTERVAL;
+const unsigned SyslogLogHandler::DEFAULT_MAX_RATE;
+const unsigned SyslogLogHandler::DEFAULT_FACILITY;
+
+SyslogLogHandler::SyslogLogHandler(IPAddress host, uint16_t port, LogLevel level, LogCategoryFilters filters) :
+        LogHandler(level, filters),
+        timer_(DEFAULT_FLUSH_INTERVAL, &SyslogLogHandler::timeout, *this),
+        addr_(host),
+        size_(0),
+        bufSize_(DEFAULT_DATAGRAM_SIZE),
+        count_(0),
+        dropped_(0),
+        droppedReported_(0),
+        reported_(0),
+        flushInterval_(DEFAULT_FLUSH_INTERVAL),
+        maxRate_(DEFAULT_MAX_RATE),
+        facility_(DEFAULT_FACILITY),
+        tokens_(std::max<size_t>(DEFAULT_MAX_RATE, DEFAULT_DATAGRAM_SIZE)),
+        lastRefill_(0),
+        firstTime_(0),
+        sendThread_(nullptr),
+        port_(port),
+        udpOpen_(false),
+        timerStarted_(false) {
+}
+
+SyslogLogHandler::SyslogLogHandler(const char* host, uint16_t port, LogLevel level, LogCategoryFilters filters) :
+        SyslogLogHandler(IPAddress(), port, level, filters) {
+    host_ = host;
+}
+
+SyslogLogHandler::~SyslogLogHandler() {
+    timer_.dispose();
+    udp_.stop();
+}
+
+SyslogLogHandler& SyslogLogHandler::datagramSize(size_t size) {
+    WITH_LOCK(mutex_) {
+        if (size != bufSize_) {
+            send();
+            buf_.reset();
+            bufSize_ = size;
+        }
+    }
+    return *this;
+}
+
+SyslogLogHandler& SyslogLogHandler::flushInterval(unsigned ms) {
+    flushInterval_ = ms;
+    if (timerStarted_) {
+        timer_.changePeriod(ms);
+    }
+    return *this;
+}
+
+SyslogLogHandler& SyslogLogHandler::maxRate(unsigned bytesPerSecond) {
+    WITH_LOCK(mutex_) {
+        maxRate_ = bytesPerSecond;
+        tokens_ = std::max<size_t>(maxRate_, bufSize_);
+        lastRefill_ = millis();
+    }
+    return *this;
+}
+
+SyslogLogHandler& SyslogLogHandler::facility(unsigned facility) {
+    facility_ = facility;
+    return *this;
+}
+
+SyslogLogHandler& SyslogLogHandler::appName(const char* name) {
+    WITH_LOCK(mutex_) {
+        appName_ = name;
+    }
+    return *this;
+}
+
+void SyslogLogHandler::flush() {
+    WITH_LOCK(mutex_) {
+        send();
+    }
+}
+
+unsigned SyslogLogHandler::droppedMessageCount() const {
+    return dropped_;
+}
+
+void SyslogLogHandler::logMessage(const char *msg, LogLevel level, const char *category, const LogAttributes &attr) {
+    if (os_thread_is_current(sendThread_)) {
+        return; // Ignore the messages generated by the network stack while a datagram is being sent
+    }
+    if (!timerStarted_) {
+        // Changing the period of a dormant timer also starts it
+        timerStarted_ = timer_.changePeriod(flushInterval_);
+    }
+    WITH_LOCK(mutex_) {
+        if (!buf_) {
+            buf_.reset(new(std::nothrow) char[bufSize_]);
+            if (!buf_) {
+                ++dropped_;
+                return;
+            }
+        }
+        if (!size_ && dropped_ != droppedReported_) {
+            char s[48];
+            const unsigned n = dropped_ - droppedReported_;
+            snprintf(s, sizeof(s), "%u log message(s) dropped", n);
+            if (append(s, LOG_LEVEL_WARN, nullptr)) {
+                --count_; // Not counted as a buffered message
+                reported_ = n;
+            }
+        }
+        if (!append(msg, level, category)) {
+            // Send the buffered messages and try again
+            send();
+            if (!append(msg, level, category)) {
+                ++dropped_;
+                return;
+            }
+        }
+        if (size_ + 1 >= bufSize_ || millis() - firstTime_ >= flushInterval_) {
+            send();
+        }
+    }
+}
+
+bool SyslogLogHandler::append(const char* msg, LogLevel level, const char* category) {
+    if (!size_) {
+        if (!deviceId_.length()) {
+            deviceId_ = spark_deviceID();
+        }
+        firstTime_ = millis();
+    }
+    char* const p = buf_.get() + size_;
+    const size_t avail = bufSize_ - size_;
+    const unsigned pri = facility_ * 8 + syslogSeverity(level);
+    // <PRI>VERSION TIMESTAMP HOSTNAME APP-NAME PROCID MSGID STRUCTURED-DATA MSG
+    const int n = snprintf(p, avail, "<%u>1 - %s %s - %.*s - %s\n", pri,
+            deviceId_.length() ? deviceId_.c_str() : "-", appName_.length() ? appName_.c_str() : "-",
+            (int)MAX_MSGID_SIZE, category ? category : "-", msg);
+    if (n < 0) {
+        return false;
+    }
+    if ((size_t)n >= avail) {
+        if (size_) {
+            return false;
+        }
+        // The message doesn't fit in an empty datagram, truncate it
+        if (avail > 0) {
+            p[avail - 1] = '\n';
+        }
+        size_ = avail;
+    } else {
+        size_ += n;
+    }
+    ++count_;
+    return true;
+}
+
+int SyslogLogHandler::send() {
+    if (!size_) {
+        return 0;
+    }
+    const size_t size = size_;
+    const unsigned count = count_;
+    const unsigned reported = reported_;
+    size_ = 0;
+    count_ = 0;
+    reported_ = 0;
+    if (!consumeTokens(size)) {
+        dropped_ += count;
+        return SYSTEM_ERROR_LIMIT_EXCEEDED;
+    }
+    sendThread_ = os_thread_current(nullptr);
+    int r = 0;
+    if (!addr_ && host_.length()) {
+        addr_ = Network.resolve(host_.c_str());
+    }
+    if (!addr_) {
+        r = SYSTEM_ERROR_NOT_FOUND;
+    } else if (!udpOpen_) {
+        udpOpen_ = udp_.begin(0);
+        if (!udpOpen_) {
+            r = SYSTEM_ERROR_NETWORK;
+        }
+    }
+    if (r == 0) {
+        r = udp_.sendPacket((const uint8_t*)buf_.get(), size, addr_, port_);
+        if (r < 0) {
+            // The network may have gone down, reopen the socket and resolve the server address again
+            udp_.stop();
+            udpOpen_ = false;
+            if (host_.length()) {
+                addr_ = IPAddress();
+            }
+        }
+    }
+    sendThread_ = nullptr;
+    if (r < 0) {
+        dropped_ += count;
+        return r;
+    }
+    droppedReported_ += reported;
+    return 0;
+}
+
+bool SyslogLogHandler::consumeTokens(size_t size) {
+    if (!maxRate_) {
+        return true;
+    }
+    const system_tick_t now = millis();
+    const uint64_t refill = (uint64_t)(now - lastRefill_) * maxRate_ / 1000;
+    if (refill > 0) {
+        tokens_ = std::min<uint64_t>(tokens_ + refill, std::max<size_t>(maxRate_, bufSize_));
+        lastRefill_ = now;
+    }
+    if (tokens_ < size) {
+        return false;
+    }
+    tokens_ -= size;
+    return true;
+}
+
+void SyslogLogHandler::timeout() {
+    // Sending a datagram from the timer thread may generate log messages. In synchronous mode,
+    // those would be passed to the handlers while this handler is locked
+    if (!LogManager::instance()->isAsyncMode()) {
+        return;
+    }
+    flush();
+}
+
+} // namespace spark
+
+#endif // Wiring_SyslogLogHandler